@@ -212,9 +212,52 @@ add_subdirectory(${DPCPP_ROOT}/cpu)
 add_subdirectory(${DPCPP_ROOT}/autocast)
 add_subdirectory(${DPCPP_ROOT}/aten)
 
+# ---[ ISA multi-versioned kernels
+# The kernel sources of aten/cpu/kernels are compiled once per ISA level of
+# CPUCapability (csrc/cpu/dispatch/DispatchStub.h), with the flags of that
+# level in place of the AVX_VERSION ones above, and the kernel of the running
+# CPU is selected at runtime. The levels the compiler can not build are left
+# out and fall back to the highest one below them. The sources are copied per
+# level, so they include by the csrc/ paths instead of the relative ones.
+include(CheckCXXCompilerFlag)
+check_cxx_compiler_flag("-mavx512bf16" COMPILER_SUPPORTS_AVX512_BF16)
+check_cxx_compiler_flag("-mamx-tile -mamx-bf16 -mamx-int8" COMPILER_SUPPORTS_AMX)
+
+set(DPCPP_ISA_KERNEL_SRCS)
+set(ISA_KERNEL_BASE_FLAGS "-UCPU_CAPABILITY_AVX2 -UCPU_AVX2 -UCPU_AVX512 -UAVX512_BF16 -mno-avx -mno-f16c")
+set(ISA_KERNEL_AVX512_FLAGS "-DCPU_CAPABILITY_AVX512 -mavx512f -mavx512bw -mavx512vl -mavx512dq -mfma -mf16c")
+set(ISA_KERNEL_LEVELS DEFAULT AVX2 AVX512)
+set(ISA_KERNEL_DEFAULT_FLAGS "")
+set(ISA_KERNEL_AVX2_FLAGS "-DCPU_CAPABILITY_AVX2 -mavx2 -mfma -mf16c")
+IF (C_AVX512_FOUND OR CXX_AVX512_FOUND)
+  IF (COMPILER_SUPPORTS_AVX512_BF16)
+    list(APPEND ISA_KERNEL_LEVELS AVX512_BF16)
+    set(ISA_KERNEL_AVX512_BF16_FLAGS "${ISA_KERNEL_AVX512_FLAGS} -DCPU_CAPABILITY_AVX512_BF16 -mavx512bf16 -mavx512vnni")
+    IF (COMPILER_SUPPORTS_AMX)
+      list(APPEND ISA_KERNEL_LEVELS AMX)
+      set(ISA_KERNEL_AMX_FLAGS "${ISA_KERNEL_AVX512_BF16_FLAGS} -DCPU_CAPABILITY_AMX -mamx-tile -mamx-bf16 -mamx-int8")
+    ENDIF()
+  ENDIF()
+ELSE()
+  list(REMOVE_ITEM ISA_KERNEL_LEVELS AVX512)
+ENDIF()
+
+FILE(GLOB _ISA_KERNEL_SRCS ${DPCPP_ROOT}/aten/cpu/kernels/*.cpp)
+foreach(_level ${ISA_KERNEL_LEVELS})
+  foreach(_src ${_ISA_KERNEL_SRCS})
+    get_filename_component(_name ${_src} NAME_WE)
+    set(_isa_src ${CMAKE_BINARY_DIR}/isa_kernels/${_name}.${_level}.cpp)
+    configure_file(${_src} ${_isa_src} COPYONLY)
+    set_source_files_properties(${_isa_src} PROPERTIES COMPILE_FLAGS
+      "${ISA_KERNEL_BASE_FLAGS} -DCPU_CAPABILITY=${_level} ${ISA_KERNEL_${_level}_FLAGS}")
+    list(APPEND DPCPP_ISA_KERNEL_SRCS ${_isa_src})
+  endforeach()
+  message(STATUS "Build the ISA kernels of ${_level}")
+endforeach()
+
 # Compile code with pybind11
 set(DPCPP_SRCS ${DPCPP_COMMON_SRCS} ${DPCPP_UTILS_SRCS} ${DPCPP_QUANTIZATION_SRCS} ${DPCPP_JIT_SRCS}
-    ${DPCPP_CPU_SRCS} ${DPCPP_AUTOCAST_SRCS} ${DPCPP_ATEN_SRCS})
+    ${DPCPP_CPU_SRCS} ${DPCPP_AUTOCAST_SRCS} ${DPCPP_ATEN_SRCS} ${DPCPP_ISA_KERNEL_SRCS})
 add_library(${PLUGIN_NAME} SHARED ${DPCPP_SRCS})
 
 link_directories(${PYTORCH_INSTALL_DIR}/lib)
@@ -14,4 +14,18 @@ from . import quantization
 from . import nn
 
 from .utils.verbose import verbose
-from .frontend import optimize, enable_onednn_fusion
+from .utils.op_trace import op_trace
+from .utils.parallel_trace import parallel_trace
+from .utils import benchmark
+from .utils import perf_regression
+from .utils.weight_sharing import share_weights
+from .utils.capture import capture, CapturedModule
+from .utils.activation_recompute import enable_activation_recompute
+from .utils.packed_weight_cache import set_packed_weight_cache_capacity, get_packed_weight_cache_stats, release_packed_weights
+from .utils.memory_stats import memory_stats, reset_peak_memory_stats, set_memory_budget
+from .utils.huge_pages import enable_huge_pages, is_huge_pages_enabled, is_huge_pages_available
+from .utils.packed_weight_serialization import enable_packed_weight_serialization, is_packed_weight_serialization_enabled
+from .utils.packed_weight_checkpoint import save_unpacked_state_dict
+from .utils.autocast_policy import set_autocast_policy, get_autocast_policy, calibrate_autocast_policy
+from .nn.utils._reorder_analysis import analyze_reorders, ReorderReport
+from .frontend import optimize, enable_onednn_fusion, enable_branch_parallel, enable_memory_planning, enable_conv_algorithm_selection, enable_sparse_linear, enable_weight_only_quantization, enable_dynamic_quantization
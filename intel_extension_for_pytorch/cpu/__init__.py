@@ -1,3 +1,3 @@
 from . import launch
 from . import runtime
-
+from . import autotune
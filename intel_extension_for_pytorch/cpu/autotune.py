@@ -0,0 +1,60 @@
+r"""
+Helpers for the ``--autotune`` mode of ``intel_extension_for_pytorch.cpu.launch``.
+
+The launcher runs the program once for each candidate ``ninstances`` x
+``ncore_per_instance`` split, with the environment variable
+``IPEX_AUTOTUNE_RECORD_FILE`` set for each instance. The program reports the
+latency of each iteration by :func:`record`, which is a no-op outside the
+autotune runs, so that the launcher can measure the steady-state throughput
+and the p99 latency of each split.
+
+::
+
+    >>> for x in inputs:
+    >>>     start = time.time()
+    >>>     y = model(x)
+    >>>     ipex.cpu.autotune.record(time.time() - start, batch_size=x.size(0))
+"""
+
+import os
+
+_RECORD_FILE_ENV = "IPEX_AUTOTUNE_RECORD_FILE"
+_record_file = None
+
+def is_autotune_run():
+    r"""
+    Returns:
+        bool: Whether the current process is one trial of the launcher
+        autotune. The program can use it to shorten its run.
+    """
+
+    return _RECORD_FILE_ENV in os.environ
+
+def record(latency, batch_size=1):
+    r"""
+    Report the latency of one iteration to the launcher autotune.
+
+    Args:
+        latency (float): The latency of the iteration in seconds.
+        batch_size (int): The number of samples processed by the iteration.
+            The default value is 1.
+    """
+
+    global _record_file
+    if not is_autotune_run():
+        return
+    if _record_file is None:
+        _record_file = open(os.environ[_RECORD_FILE_ENV], 'a', buffering=1)
+    _record_file.write("{} {}\n".format(latency, batch_size))
+
+def read_records(path):
+    # Returns the list of (latency, batch_size) recorded by one instance.
+    records = []
+    if not os.path.exists(path):
+        return records
+    with open(path) as f:
+        for line in f:
+            fields = line.split()
+            if len(fields) == 2:
+                records.append((float(fields[0]), int(fields[1])))
+    return records
@@ -6,12 +6,18 @@ import os
 from os.path import expanduser
 import re
 import glob
+import copy
+import shutil
+import tempfile
 import numpy as np
 from argparse import ArgumentParser, REMAINDER
 from argparse import RawTextHelpFormatter
 import logging
 import psutil
+import json
+import time
 from datetime import datetime
+from .autotune import read_records
 
 format_str = '%(asctime)s - %(name)s - %(levelname)s - %(message)s'
 logging.basicConfig(level=logging.INFO, format=format_str)
@@ -100,6 +106,9 @@ rank 0: *(IP: 192.168.10.10, and has a free port: 295000)*
 
 "--enable_tcmalloc" and "--enable_jemalloc" can be used to enable different memory allcator.
 
+"--enable_huge_pages" places the packed weights, the embedding tables and the activation arenas of IPEX on the
+transparent huge pages.
+
 """
 
 class CPUinfo():
@@ -129,6 +138,7 @@ class CPUinfo():
         self.socket_logical_cores = []   # socket_id is index
         self.physical_core_node_map = {}  # phyical core to numa node id
         self.logical_core_node_map = {}   # logical core to numa node id
+        self.physical_core_logical_cores = {}  # physical core to its logical cores (SMT siblings)
         self.sockets = int(max([line[2] for line in self.cpuinfo])) + 1
         for socket_id in range(self.sockets):
             cur_socket_physical_core = []
@@ -141,6 +151,7 @@ class CPUinfo():
                         self.physical_core_node_map[int(line[1])] = int(node_id)
                     cur_socket_logical_core.append(int(line[0]))
                     self.logical_core_node_map[int(line[0])] = int(node_id)
+                    self.physical_core_logical_cores.setdefault(int(line[1]), []).append(int(line[0]))
             self.socket_physical_cores.append(cur_socket_physical_core)
             self.socket_logical_cores.append(cur_socket_logical_core)
 
@@ -169,6 +180,19 @@ class CPUinfo():
     def get_all_logical_cores(self):
         return np.array(self.socket_logical_cores).flatten().tolist()
 
+    def get_physical_core_siblings(self, core_id):
+        '''
+        Get the logical cores (SMT siblings) sharing the physical core core_id, the first one is the primary thread.
+        '''
+        return self.physical_core_logical_cores[core_id]
+
+    def get_cpu_model(self):
+        with open("/proc/cpuinfo") as f:
+            for line in f:
+                if line.startswith("model name"):
+                    return line.split(":", 1)[1].strip()
+        return platform.processor()
+
     def numa_aware_check(self, core_list):
         '''
         Check whether all cores in core_list are in the same NUMA node. cross NUMA will reduce perforamnce.
@@ -270,6 +294,27 @@ class Launcher():
                            "{}/.local/lib/ so the LD_PRELOAD environment variable will not be set. This may drop the performance"
                            .format(expanduser("~")))
 
+    def set_huge_pages(self, enable_huge_pages=False):
+        '''
+        Place the large buffers of IPEX, e.g. the packed weights and the embedding tables, on the transparent huge
+        pages by IPEX_HUGE_PAGES, so that their accesses don't thrash the TLB. They are kept on the 4 KB pages if the
+        system disables the transparent huge pages.
+        '''
+        if not enable_huge_pages:
+            return
+        thp_path = "/sys/kernel/mm/transparent_hugepage/enabled"
+        try:
+            with open(thp_path) as f:
+                modes = f.read()
+        except OSError:
+            modes = "[never]"
+        if "[never]" in modes:
+            logger.warning("The transparent huge pages are disabled by {}, so IPEX_HUGE_PAGES will not be set"
+                           .format(thp_path))
+            return
+        self.set_env("IPEX_HUGE_PAGES", "1")
+        self.logger_env("IPEX_HUGE_PAGES")
+
     def logger_env(self, env_name=""):
         if env_name in os.environ:
             logger.info("{}={}".format(env_name, os.environ[env_name]))
@@ -312,7 +357,6 @@ class MultiInstanceLauncher(Launcher):
      Launcher for single instance and multi-instance
      """
     def launch(self, args):
-        processes = []
         cores = []
         set_kmp_affinity = True
         if args.core_list:  # user specify what cores will be used by params
@@ -362,12 +406,122 @@ class MultiInstanceLauncher(Launcher):
                 cores = self.cpuinfo.get_all_physical_cores()
                 args.ncore_per_instance = len(cores) // args.ninstances
 
+            if args.autotune:
+                if args.latency_mode or args.throughput_mode:
+                    print('--autotune is exclusive to --latency_mode and --throughput_mode. They won\'t take effect even they are set explicitly.')
+                    args.latency_mode = False
+                    args.throughput_mode = False
+                sockets = [args.socket_id] if args.socket_id != -1 else range(self.cpuinfo.socket_nums())
+                get_socket_cores = self.cpuinfo.get_socket_logical_cores if args.use_logical_core else self.cpuinfo.get_socket_physical_cores
+                socket_cores = [get_socket_cores(socket_id) for socket_id in sockets]
+                cores = [core for cores_of_socket in socket_cores for core in cores_of_socket]
+                args.ncore_per_instance = self.autotune(args, cores, len(socket_cores[0]), set_kmp_affinity)
+                args.ninstances = len(cores) // args.ncore_per_instance
+
         self.set_multi_thread_and_allocator(args.ncore_per_instance,
                                             args.disable_iomp,
                                             set_kmp_affinity,
                                             args.enable_tcmalloc,
                                             args.enable_jemalloc,
                                             args.use_default_allocator)
+        self.run_instances(args, cores)
+
+    def autotune_candidates(self, args, ncores_per_socket):
+        '''
+        Candidates of ncore_per_instance. Each candidate divides the cores of one socket, so that no instance crosses
+        the sockets.
+        '''
+        if args.autotune_candidates:
+            return [int(n) for n in args.autotune_candidates.split(",")]
+        return [n for n in range(1, ncores_per_socket + 1) if ncores_per_socket % n == 0]
+
+    def autotune_key(self, args):
+        model_key = args.autotune_key if args.autotune_key else " ".join([args.program] + args.program_args)
+        return "{}|{}|{}".format(model_key, self.cpuinfo.get_cpu_model(), args.autotune_target)
+
+    def autotune(self, args, cores, ncores_per_socket, set_kmp_affinity):
+        '''
+        Run the program once for each candidate split and return the ncore_per_instance with the best throughput or p99
+        latency. The result is saved in the cache file keyed by the model and the CPU model, and reused by later launches.
+        '''
+        cache_file = os.path.expanduser(args.autotune_cache)
+        key = self.autotune_key(args)
+        cache = {}
+        if os.path.exists(cache_file):
+            with open(cache_file) as f:
+                cache = json.load(f)
+        if key in cache and not args.autotune_refresh:
+            logger.info("Autotune: reuse ncore_per_instance={} of {} from {}".format(cache[key]["ncore_per_instance"], key, cache_file))
+            return cache[key]["ncore_per_instance"]
+
+        env_before_autotune = dict(os.environ)
+        results = []
+        for ncore_per_instance in self.autotune_candidates(args, ncores_per_socket):
+            ninstances = len(cores) // ncore_per_instance
+            if ninstances == 0:
+                continue
+            trial_args = copy.copy(args)
+            trial_args.ncore_per_instance = ncore_per_instance
+            trial_args.ninstances = ninstances
+            trial_args.log_path = ""
+            # The environment of the trials is independent with each other.
+            os.environ.clear()
+            os.environ.update(env_before_autotune)
+            self.set_multi_thread_and_allocator(ncore_per_instance,
+                                                args.disable_iomp,
+                                                set_kmp_affinity,
+                                                args.enable_tcmalloc,
+                                                args.enable_jemalloc,
+                                                args.use_default_allocator)
+            record_dir = tempfile.mkdtemp(prefix="ipex_autotune_")
+            record_files = [os.path.join(record_dir, "instance_{}.txt".format(i)) for i in range(ninstances)]
+            start = time.time()
+            self.run_instances(trial_args, cores, [{"IPEX_AUTOTUNE_RECORD_FILE": path} for path in record_files])
+            wall_time = time.time() - start
+            throughput, p99 = self.autotune_metrics([read_records(path) for path in record_files], ninstances, wall_time)
+            shutil.rmtree(record_dir, ignore_errors=True)
+            logger.info("Autotune: ninstances={} ncore_per_instance={} throughput={:.2f} samples/s p99={:.6f} s".format(ninstances, ncore_per_instance, throughput, p99))
+            results.append((ncore_per_instance, throughput, p99))
+        os.environ.clear()
+        os.environ.update(env_before_autotune)
+        if len(results) == 0:
+            logger.error("Autotune: no valid candidate of ncore_per_instance")
+            exit(-1)
+
+        if args.autotune_target == "latency":
+            best = min(results, key=lambda result: result[2])
+        else:
+            best = max(results, key=lambda result: result[1])
+        logger.info("Autotune: the best ncore_per_instance of {} is {}".format(key, best[0]))
+        cache[key] = {"ncore_per_instance": best[0], "throughput": best[1], "p99": best[2]}
+        cache_dir = os.path.dirname(cache_file)
+        if cache_dir and not os.path.exists(cache_dir):
+            os.makedirs(cache_dir)
+        with open(cache_file, "w") as f:
+            json.dump(cache, f, indent=2)
+        return best[0]
+
+    def autotune_metrics(self, instance_records, ninstances, wall_time):
+        '''
+        Throughput is the sum of the steady-state throughput of all instances, p99 is the 99th percentile latency of all
+        iterations. Fall back to the wall time of the whole run if the program doesn't record the iterations.
+        '''
+        latencies = [latency for records in instance_records for latency, _ in records]
+        if len(latencies) == 0:
+            return ninstances / wall_time, wall_time
+        throughput = 0.0
+        for records in instance_records:
+            busy_time = sum(latency for latency, _ in records)
+            if busy_time > 0:
+                throughput += sum(batch_size for _, batch_size in records) / busy_time
+        return throughput, float(np.percentile(latencies, 99))
+
+    def run_instances(self, args, cores, instance_envs=None):
+        '''
+        Launch args.ninstances instances of the program on cores and wait for them. instance_envs optionally gives the
+        additional environment variables of each instance.
+        '''
+        processes = []
         os.environ["LAUNCH_CMD"] = "#"
         for i in range(args.ninstances):
             cmd = []
@@ -410,7 +564,11 @@ class MultiInstanceLauncher(Launcher):
             if args.log_path:
                 cmd_s = "{} 2>&1 | tee {}".format(cmd_s, log_name)
             logger.info(cmd_s)
-            process = subprocess.Popen(cmd_s, env=os.environ, shell=True)
+            env = os.environ
+            if instance_envs is not None:
+                env = dict(os.environ)
+                env.update(instance_envs[i])
+            process = subprocess.Popen(cmd_s, env=env, shell=True)
             processes.append(process)
         os.environ["LAUNCH_CMD"] = os.environ["LAUNCH_CMD"][:-2]
         for process in processes:
@@ -593,6 +751,9 @@ def add_memory_allocator_params(parser):
                        help="Enable jemalloc allocator")
     group.add_argument("--use_default_allocator", action='store_true', default=False,
                        help="Use default memory allocator")
+    group.add_argument("--enable_huge_pages", action='store_true', default=False,
+                       help="Place the packed weights, the embedding tables and the activation arenas of IPEX "
+                            "on the transparent huge pages")
 
 def add_multi_instance_params(parser):
 
@@ -618,6 +779,20 @@ def add_multi_instance_params(parser):
                        help="The log file directory. Default path is '', which means disable logging to files.")
     group.add_argument("--log_file_prefix", metavar='\b', default="run", type=str,
                        help="log file prefix")
+    # autotune control
+    group.add_argument("--autotune", action='store_true', default=False,
+                       help="Run the program once for each candidate ncore_per_instance, and launch with the best one. "
+                            "The result is cached and reused by later launches of the same program on the same CPU model")
+    group.add_argument("--autotune_target", metavar='\b', default="throughput", type=str, choices=["throughput", "latency"],
+                       help="Choose the split with the best 'throughput' or the best p99 'latency'")
+    group.add_argument("--autotune_candidates", metavar='\b', default="", type=str,
+                       help="Candidates of ncore_per_instance as 'n,n,...', by default all the divisors of the cores per socket")
+    group.add_argument("--autotune_key", metavar='\b', default="", type=str,
+                       help="Model key of the autotune cache, by default the program and its arguments")
+    group.add_argument("--autotune_cache", metavar='\b', default="~/.cache/intel_extension_for_pytorch/launch_autotune.json", type=str,
+                       help="The autotune cache file")
+    group.add_argument("--autotune_refresh", action='store_true', default=False,
+                       help="Ignore the cached result and tune again")
 
 def add_kmp_iomp_params(parser):
 
@@ -718,6 +893,7 @@ def main():
     else:
         launcher = MultiInstanceLauncher()
 
+    launcher.set_huge_pages(args.enable_huge_pages)
     launcher.launch(args)
     for x in sorted(set(os.environ.keys()) - env_before):
         logger.debug('{0}={1}'.format(x, os.environ[x]))
@@ -1,4 +1,9 @@
-from .task import Task
-from .cpupool import pin, CPUPool, is_runtime_ext_enabled
+from .task import Task, wait_all, wait_any, TaskQueueFullError, TaskDroppedError
+from .cpupool import pin, CPUPool, create_cpu_pools, is_runtime_ext_enabled
 from .multi_stream import MultiStreamModule
-from .runtime_utils import get_core_list_of_node_id
+from .micro_batch import MicroBatchModule
+from .pipeline import PipelineModule
+from .input_pipeline import InputPipeline
+from .scheduler import ModelScheduler, ScheduledModel
+from .tracing import trace_tasks, request_scope
+from .runtime_utils import get_core_list_of_node_id, get_physical_core_siblings, set_op_min_work_per_thread, get_op_min_work_per_thread
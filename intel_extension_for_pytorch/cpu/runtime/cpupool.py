@@ -3,7 +3,7 @@ import functools
 import warnings
 import numpy as np
 import intel_extension_for_pytorch as ipex
-from .runtime_utils import get_core_list_of_node_id
+from .runtime_utils import get_core_list_of_node_id, get_numa_node_of_core_list, get_physical_core_siblings
 
 class CPUPool(object):
     r"""
@@ -13,13 +13,28 @@ class CPUPool(object):
         core_ids (list): A list of CPU cores' ids used for intra-op parallelism.
         node_id (int): A numa node id with all CPU cores on the numa node.
             ``node_id`` doesn't work if ``core_ids`` is set.
+        bind_memory (bool): A flag indicates whether the memory allocated by
+            the Tasks running on this CPUPool prefers the numa node of the
+            cores. The numa node is ``node_id`` or the node all ``core_ids``
+            belong to. The default value is True. Note: it has no effect if
+            ``core_ids`` spans several numa nodes.
+        memory_arena (bool): A flag indicates whether the Tasks created on this
+            CPUPool allocate their tensors from a caching memory arena. The
+            freed buffers are cached by size and reused by the next inference
+            of the same shape. The default value is False.
+        spin_time_us (int): Idle policy of the Tasks created on this CPUPool.
+            The idle Task and its OpenMP threads spin ``spin_time_us``
+            microseconds waiting for the next input before going to sleep,
+            which trades idle CPU cycles for the wakeup latency of
+            sub-millisecond inference. The default value is 0, which means
+            sleep immediately.
 
     Returns:
         intel_extension_for_pytorch.cpu.runtime.CPUPool: Generated
         intel_extension_for_pytorch.cpu.runtime.CPUPool object.
     """
 
-    def __init__(self, core_ids: list = None, node_id: int = None):
+    def __init__(self, core_ids: list = None, node_id: int = None, bind_memory: bool = True, memory_arena: bool = False, spin_time_us: int = 0):
         if core_ids is not None:
             if node_id is not None:
                 warnings.warn("Both of core_ids and node_id are inputed. core_ids will be used with priority.")
@@ -27,10 +42,91 @@ class CPUPool(object):
                 core_ids = list(core_ids)
             assert type(core_ids) is list, "Input of core_ids must be the type of list[Int]"
             self.core_ids = core_ids
+            self.numa_node_id = get_numa_node_of_core_list(self.core_ids) if bind_memory else -1
         else:
             assert node_id is not None, "Neither core_ids or node_id has been implemented"
             self.core_ids = get_core_list_of_node_id(node_id)
-        self.cpu_pool = ipex._C.CPUPool(self.core_ids)
+            self.numa_node_id = node_id if bind_memory else -1
+        self.cpu_pool = ipex._C.CPUPool(self.core_ids, self.numa_node_id)
+        if memory_arena:
+            self.cpu_pool.enable_memory_arena()
+        assert spin_time_us >= 0, "spin_time_us must be >= 0"
+        self.spin_time_us = spin_time_us
+        self.cpu_pool.set_spin_time_us(spin_time_us)
+
+    def memory_arena_stats(self):
+        r"""
+        Get the statistics of the memory arena.
+
+        Returns:
+            dict: ``allocated_bytes`` used by alive tensors, ``cached_bytes``
+            of the free buffers kept by the arena, and the number of
+            allocations served from the cache (``hits``) or not (``misses``).
+        """
+
+        return self.cpu_pool.memory_arena_stats()
+
+    def reset_memory_arena(self):
+        r"""
+        Release all the free buffers cached by the memory arena.
+        """
+
+        self.cpu_pool.reset_memory_arena()
+
+_CPU_POOL_PLACEMENT_POLICIES = ["physical_only", "pair_siblings", "siblings_for_helpers"]
+
+def create_cpu_pools(num_pools: int, node_id: int = None, policy: str = "physical_only", **kwargs):
+    r"""
+    Create CPUPools on disjoint physical cores, e.g. for the streams of
+    :class:`MultiStreamModule`, so that two streams never share the execution
+    units of one physical core. The physical cores are split evenly between
+    the CPUPools, and their SMT siblings are placed by ``policy``:
+
+    * ``physical_only``: each CPUPool only takes the primary thread of its
+      physical cores, the siblings stay idle. Recommended for the GEMM heavy
+      streams.
+    * ``pair_siblings``: each CPUPool takes all the siblings of its physical
+      cores, so that one stream runs on all the logical cores of its own
+      physical cores.
+    * ``siblings_for_helpers``: each CPUPool takes the primary thread of its
+      physical cores, and comes with a helper CPUPool made of the siblings of
+      the same physical cores, for the light-weight helper threads of the
+      stream, e.g. the data preprocessing.
+
+    Args:
+        num_pools (int): Number of CPUPools.
+        node_id (int): Only use the cores on this numa node. The default value
+            is None, which means all the numa nodes.
+        policy (str): Placement policy of the SMT siblings. The default value
+            is ``physical_only``.
+        kwargs: The other arguments of :class:`CPUPool`, e.g.
+            ``memory_arena``.
+
+    Returns:
+        list: ``num_pools`` CPUPool objects. With ``siblings_for_helpers``, a
+        list of ``(cpu_pool, helper_cpu_pool)`` tuples instead, where
+        ``helper_cpu_pool`` is None if the physical cores have no sibling.
+    """
+
+    assert policy in _CPU_POOL_PLACEMENT_POLICIES, \
+        "policy must be one of {}".format(_CPU_POOL_PLACEMENT_POLICIES)
+    core_siblings = get_physical_core_siblings(node_id)
+    assert 0 < num_pools <= len(core_siblings), \
+        "num_pools must be in [1, {}], the number of physical cores".format(len(core_siblings))
+    cpu_pools = []
+    for i in range(num_pools):
+        pool_siblings = core_siblings[i * len(core_siblings) // num_pools:(i + 1) * len(core_siblings) // num_pools]
+        primary_cores = [siblings[0] for siblings in pool_siblings]
+        helper_cores = [core for siblings in pool_siblings for core in siblings[1:]]
+        if policy == "physical_only":
+            cpu_pools.append(CPUPool(core_ids=primary_cores, **kwargs))
+        elif policy == "pair_siblings":
+            # Keep the siblings of one physical core adjacent in the core list.
+            cpu_pools.append(CPUPool(core_ids=[core for siblings in pool_siblings for core in siblings], **kwargs))
+        else:
+            helper_cpu_pool = CPUPool(core_ids=helper_cores, **kwargs) if helper_cores else None
+            cpu_pools.append((CPUPool(core_ids=primary_cores, **kwargs), helper_cpu_pool))
+    return cpu_pools
 
 class pin(object):
     r"""
@@ -0,0 +1,98 @@
+import collections
+
+from .cpupool import CPUPool
+from .multi_stream import _get_stream_core_lists
+from .task import Task
+
+class InputPipeline(object):
+    r"""
+    InputPipeline runs the input pipeline work of the inference, e.g. the
+    decoding, the preprocessing and the collation of the batches, on the
+    workers pinned to a dedicated CPUPool, so that it doesn't float onto the
+    cores of the ``TaskExecutor`` workers of the inference and thrash their
+    caches.
+
+    The cores of ``cpu_pool`` are split across ``num_workers`` workers the
+    same way as the streams of
+    :class:`~intel_extension_for_pytorch.cpu.runtime.MultiStreamModule`, and
+    each worker runs ``fn`` with the intra-op threads of its cores. ``fn`` is
+    a Python callable, which holds the GIL except inside the ops releasing
+    it, e.g. the ATen ops and most of the image decoders.
+
+    .. highlight:: python
+    .. code-block:: python
+
+        pipeline_pool, model_pool = ipex.cpu.runtime.create_cpu_pools(2, node_id=0)
+        pipeline = ipex.cpu.runtime.InputPipeline(preprocess, pipeline_pool, num_workers=2, prefetch=4)
+        model = ipex.cpu.runtime.MultiStreamModule(traced_model, num_streams=4, cpu_pool=model_pool)
+        for batch in pipeline.map(raw_batches):
+            y = model(batch)
+
+    Args:
+        fn (callable): The input pipeline work of one item, of which the
+            output is handed to the consumer as is.
+        cpu_pool (intel_extension_for_pytorch.cpu.runtime.CPUPool): The
+            cores reserved for the input pipeline, which are supposed not to
+            overlap the CPUPools of the inference.
+        num_workers (int): Number of the workers. The default value is 1.
+        prefetch (int): The max number of the items of :meth:`map` prepared
+            ahead of the consumer, 0 means ``num_workers``. The default value
+            is 0.
+
+    Returns:
+        intel_extension_for_pytorch.cpu.runtime.InputPipeline: Generated
+        intel_extension_for_pytorch.cpu.runtime.InputPipeline object.
+    """
+
+    def __init__(self, fn, cpu_pool: CPUPool, num_workers: int = 1, prefetch: int = 0):
+        assert type(cpu_pool) is CPUPool
+        assert callable(fn), "InputPipeline requires a callable"
+        assert 0 < num_workers <= len(cpu_pool.core_ids), "InputPipeline requires one core per worker at least"
+        assert prefetch >= 0
+        self.cpu_pool = cpu_pool
+        self.num_workers = num_workers
+        self.prefetch = prefetch if prefetch > 0 else num_workers
+        self.workers = [Task(fn, CPUPool(core_list))
+                        for core_list in _get_stream_core_lists(cpu_pool.core_ids, num_workers)]
+        self._next_worker = 0
+
+    def submit(self, *args, **kwargs):
+        r"""
+        Runs ``fn`` of the inputs on the next worker in turn.
+
+        Returns:
+            The future of the output of ``fn``, the same as
+            :meth:`Task.__call__`.
+        """
+
+        worker = self.workers[self._next_worker]
+        self._next_worker = (self._next_worker + 1) % self.num_workers
+        return worker(*args, **kwargs)
+
+    def map(self, iterable):
+        r"""
+        Yields the outputs of ``fn`` of the items of ``iterable`` in their
+        order, of which up to ``prefetch`` are prepared ahead by the workers
+        while the consumer runs, e.g. the inference of the previous batch.
+        The outputs are handed to the consumer without any copy.
+
+        Args:
+            iterable: The inputs of ``fn``, of which a tuple is unpacked into
+                several arguments.
+        """
+
+        pending = collections.deque()
+        for item in iterable:
+            if len(pending) == self.prefetch:
+                yield pending.popleft().get()
+            pending.append(self.submit(*item) if isinstance(item, tuple) else self.submit(item))
+        while pending:
+            yield pending.popleft().get()
+
+    def get_core_ids(self):
+        r"""
+        Returns:
+            list: The core ids of each worker.
+        """
+
+        return [worker.get_core_ids() for worker in self.workers]
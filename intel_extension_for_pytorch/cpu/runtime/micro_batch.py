@@ -0,0 +1,57 @@
+import torch
+import intel_extension_for_pytorch as ipex
+from .cpupool import CPUPool
+from .multi_stream import _get_stream_core_lists
+
+class MicroBatchModule(object):
+    r"""
+    MicroBatchModule supports online inference with dynamic micro-batching.
+
+    Each call submits one request and returns a future immediately. The
+    requests are collected into micro-batches in C++. A micro-batch is
+    dispatched to the least loaded stream once its batch size reaches
+    ``max_batch_size`` or once its oldest request has waited for
+    ``max_latency_ms``. The output of the micro-batch is split back to the
+    future of each request along the batch dim.
+
+    The cores inside ``cpu_pool`` are allocated to the streams in the same way
+    as :class:`MultiStreamModule`.
+
+    Args:
+        model (torch.jit.ScriptModule): The input model. The model takes one
+            Tensor with the batch dim as dim 0, and returns a Tensor or a
+            tuple/list of Tensors with the batch dim as dim 0.
+        num_streams (int): Number of instances.
+        cpu_pool (intel_extension_for_pytorch.cpu.runtime.CPUPool): An
+            intel_extension_for_pytorch.cpu.runtime.CPUPool object, contains
+            all CPU cores used to run the micro-batches.
+        max_batch_size (int): The maximum batch size of one micro-batch.
+        max_latency_ms (float): The maximum time in milliseconds a request
+            waits for the other requests before its micro-batch is dispatched.
+
+    Returns:
+        intel_extension_for_pytorch.cpu.runtime.MicroBatchModule: Generated
+        intel_extension_for_pytorch.cpu.runtime.MicroBatchModule object.
+    """
+
+    def __init__(self, model, num_streams: int, cpu_pool: CPUPool, max_batch_size: int, max_latency_ms: float):
+        assert type(cpu_pool) is CPUPool
+        assert isinstance(model, torch.jit.ScriptModule), "MicroBatchModule only supports torch.jit.ScriptModule"
+        ipex._C.init_runtime_ext()
+        self.num_streams = num_streams
+        self.max_batch_size = max_batch_size
+        self.max_latency_ms = max_latency_ms
+        stream_core_lists = _get_stream_core_lists(cpu_pool.core_ids, num_streams)
+        self._scheduler = ipex._C.MicroBatchScheduler(model._c, stream_core_lists, max_batch_size, int(max_latency_ms * 1000))
+
+    def __call__(self, input):
+        # async execution
+        return self._scheduler.submit(input)
+
+    def run_sync(self, input):
+        # sync execution
+        return self._scheduler.submit(input).get()
+
+    def stop(self):
+        # flush the pending requests and stop all the streams
+        self._scheduler.stop()
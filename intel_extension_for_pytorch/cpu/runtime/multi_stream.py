@@ -2,6 +2,24 @@ import torch
 import torch.nn as nn
 import intel_extension_for_pytorch as ipex
 from .cpupool import CPUPool
+from .task import _warmup
+
+def _get_stream_core_lists(core_list, num_streams):
+    # If the cores are not divisible by num_streams with remainder N, one extra
+    # core is allocated to the first N streams.
+    cores_per_stream = core_list.__len__() // num_streams
+    num_stream_allocated_extra_core = core_list.__len__() % num_streams
+    stream_core_lists = []
+    start_core_list_idx = 0
+    end_core_list_idx = 0
+    for j in range(num_streams):
+        if j < num_stream_allocated_extra_core:
+            end_core_list_idx += (cores_per_stream + 1)
+        else:
+            end_core_list_idx += cores_per_stream
+        stream_core_lists.append(core_list[start_core_list_idx:end_core_list_idx])
+        start_core_list_idx = end_core_list_idx
+    return stream_core_lists
 
 class MultiStreamModule(nn.Module):
     r"""
@@ -24,6 +42,11 @@ class MultiStreamModule(nn.Module):
             stream will be concatenated or not. The default value is True. Note:
             if the output of each stream can't be concatenated, set this flag to
             false to get the raw output (a list of each stream's output).
+        work_stealing (bool): A flag indicates whether the idle streams steal
+            the pending inputs queued on busy streams. The default value is
+            False. Note: the streams steal from each other only inside this
+            MultiStreamModule, so ``cpu_pool`` is supposed to contain the cores
+            of one numa node.
 
     Returns:
         intel_extension_for_pytorch.cpu.runtime.MultiStreamModule: Generated
@@ -32,24 +55,18 @@ class MultiStreamModule(nn.Module):
     :meta public:
     """
 
-    def __init__(self, model, num_streams: int, cpu_pool: CPUPool, concat_output: bool = True):
+    def __init__(self, model, num_streams: int, cpu_pool: CPUPool, concat_output: bool = True, work_stealing: bool = False):
         super(MultiStreamModule, self).__init__()
         assert type(cpu_pool) is CPUPool
         core_list = cpu_pool.core_ids
         self.num_streams = num_streams
         self.cores_per_instance = core_list.__len__() // self.num_streams
-        num_stream_allocated_extra_core = core_list.__len__() % self.num_streams
         self.tasks = []
-        start_core_list_idx = 0
-        end_core_list_idx = 0
-        for j in range(self.num_streams):
-            if j < num_stream_allocated_extra_core:
-                end_core_list_idx += (self.cores_per_instance + 1)
-            else:
-                end_core_list_idx += self.cores_per_instance
-            self.tasks.append(ipex.cpu.runtime.Task(model, ipex.cpu.runtime.CPUPool(core_list[start_core_list_idx:end_core_list_idx])))
-            start_core_list_idx = end_core_list_idx
+        self.executor_group = ipex._C.TaskExecutorGroup() if work_stealing else None
+        for stream_core_list in _get_stream_core_lists(core_list, self.num_streams):
+            self.tasks.append(ipex.cpu.runtime.Task(model, ipex.cpu.runtime.CPUPool(stream_core_list), self.executor_group))
         self.concat_output = concat_output
+        self.is_script_module = isinstance(model, torch.jit.ScriptModule)
 
     def forward(self, inputs):
         # Ensure each instance has input offload
@@ -63,20 +80,44 @@ class MultiStreamModule(nn.Module):
             batch_per_instance = 1
             used_num_streams = inputs.size(0)
             instance_need_extra_input = 0
-        results_raw_future = []
-        results_raw = []
-        start_idx = 0
-        end_idx = 0
+        split_sizes = []
         for j in range(used_num_streams):
             if j < instance_need_extra_input:
                 # tail case, when the input image size large than num_streams and not divisible
-                end_idx = end_idx + (batch_per_instance + 1)
+                split_sizes.append(batch_per_instance + 1)
             else:
                 # input image size divisible of num_streams or input image size less than num_streams
-                end_idx = end_idx + batch_per_instance
+                split_sizes.append(batch_per_instance)
+
+        if self.concat_output and self.is_script_module:
+            # Native path: each stream writes its output directly into its rows
+            # of one preallocated output, without a python torch.cat.
+            return ipex._C._multi_stream_forward([task._task for task in self.tasks], inputs, split_sizes)
+
+        results_raw_future = []
+        start_idx = 0
+        end_idx = 0
+        for j in range(used_num_streams):
+            end_idx = end_idx + split_sizes[j]
             results_raw_future.append(self.tasks[j](inputs[start_idx:end_idx]))
             start_idx = end_idx
 
-        for j in range(used_num_streams):
-            results_raw.append(results_raw_future[j].get())
+        results_raw = ipex._C.wait_all(results_raw_future)
         return torch.cat(results_raw) if self.concat_output else results_raw
+
+    def warmup(self, shapes, dtype=torch.float32, num_runs=None):
+        r"""
+        Warm up all the streams concurrently, see
+        :meth:`intel_extension_for_pytorch.cpu.runtime.Task.warmup`.
+
+        Args:
+            shapes (list): The input shapes of each stream to warm up, which
+                are the shapes of the slices of the batch each stream gets,
+                e.g. the batch size divided by ``num_streams``.
+            dtype (torch.dtype): The dtype of the inputs created from the
+                sizes. The default value is ``torch.float32``.
+            num_runs (int): Number of runs per shape. The default value is
+                None, which means the number of JIT profiled runs plus one.
+        """
+
+        _warmup(self.tasks, shapes, dtype, num_runs)
@@ -0,0 +1,73 @@
+import torch
+import intel_extension_for_pytorch as ipex
+from .cpupool import CPUPool
+
+class PipelineModule(object):
+    r"""
+    PipelineModule supports pipeline-parallel inference of a model split into
+    several stages.
+
+    Each stage runs on its own CPUPool, so that the weights of one stage stay
+    in the cache of its cores. The output of one stage is the input of the
+    next stage (a tuple output is unpacked into several inputs). The stages
+    are connected by bounded queues in C++, and consecutive requests, or the
+    micro-batches of one request, overlap on different stages.
+
+    Args:
+        stages (list): A list of torch.jit.ScriptModule, the stages of the
+            model in order.
+        cpu_pools (list): A list of
+            intel_extension_for_pytorch.cpu.runtime.CPUPool objects, one for
+            each stage.
+        max_queue_size (int): The maximum number of requests queued or
+            running in one stage. The producer of a full stage blocks until
+            the stage has a free slot. The default value is 2.
+
+    Returns:
+        intel_extension_for_pytorch.cpu.runtime.PipelineModule: Generated
+        intel_extension_for_pytorch.cpu.runtime.PipelineModule object.
+    """
+
+    def __init__(self, stages: list, cpu_pools: list, max_queue_size: int = 2):
+        assert len(stages) == len(cpu_pools), "PipelineModule requires one CPUPool for each stage"
+        for stage in stages:
+            assert isinstance(stage, torch.jit.ScriptModule), "PipelineModule only supports torch.jit.ScriptModule stages"
+        for cpu_pool in cpu_pools:
+            assert type(cpu_pool) is CPUPool
+        ipex._C.init_runtime_ext()
+        self.num_stages = len(stages)
+        self._scheduler = ipex._C.PipelineScheduler(
+            [stage._c for stage in stages],
+            [cpu_pool.cpu_pool for cpu_pool in cpu_pools],
+            max_queue_size)
+
+    def __call__(self, *inputs):
+        # async execution
+        return self._scheduler.submit(*inputs)
+
+    def run_sync(self, input, num_micro_batches: int = 1):
+        r"""
+        Split ``input`` along the batch dim into ``num_micro_batches``
+        micro-batches, stream them through the stages and concatenate the
+        outputs along the batch dim.
+
+        Args:
+            input (torch.Tensor): The input with the batch dim as dim 0.
+            num_micro_batches (int): The number of micro-batches. The default
+                value is 1.
+
+        Returns:
+            The output of the last stage.
+        """
+
+        if num_micro_batches == 1:
+            return self._scheduler.submit(input).get()
+        futures = [self._scheduler.submit(micro_batch) for micro_batch in torch.chunk(input, num_micro_batches)]
+        outputs = ipex._C.wait_all(futures)
+        if isinstance(outputs[0], torch.Tensor):
+            return torch.cat(outputs)
+        return type(outputs[0])(torch.cat(output) for output in zip(*outputs))
+
+    def stop(self):
+        # flush the pending requests and stop all the stages
+        self._scheduler.stop()
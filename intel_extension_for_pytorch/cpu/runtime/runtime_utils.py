@@ -1,3 +1,4 @@
+import functools
 import subprocess
 
 def get_num_nodes():
@@ -21,3 +22,79 @@ def get_core_list_of_node_id(node_id):
     assert node_id < num_of_nodes, "input node_id:{0} must less than system number of nodes:{1}".format(node_id, num_of_nodes)
     num_cores_per_node = get_num_cores_per_node()
     return list(range(num_cores_per_node * node_id, num_cores_per_node * (node_id + 1)))
+
+@functools.lru_cache(maxsize=None)
+def _get_cpu_info():
+    from ..launch import CPUinfo
+    return CPUinfo()
+
+def _get_logical_core_node_map():
+    return _get_cpu_info().logical_core_node_map
+
+def get_physical_core_siblings(node_id=None):
+    r"""
+    Helper function to get the SMT siblings of each physical core, with the
+    same topology as ``intel_extension_for_pytorch.cpu.launch`` uses.
+
+    Args:
+        node_id (int): Only return the physical cores on this numa node.
+            The default value is None, which means all the numa nodes.
+
+    Returns:
+        list: One list of logical cores' ids per physical core, the first one
+        of each list is the primary thread of the physical core.
+    """
+
+    cpu_info = _get_cpu_info()
+    physical_cores = cpu_info.get_all_physical_cores()
+    if node_id is not None:
+        physical_cores = [core for core in physical_cores if cpu_info.physical_core_node_map[core] == node_id]
+        assert len(physical_cores) > 0, "No physical core on numa node {}".format(node_id)
+    return [cpu_info.get_physical_core_siblings(core) for core in physical_cores]
+
+def get_numa_node_of_core_list(core_list):
+    r"""
+    Helper function to get the numa node id of the input CPU cores, with the
+    same topology as ``intel_extension_for_pytorch.cpu.launch`` uses.
+
+    Args:
+        core_list (list): List of CPU cores' ids.
+
+    Returns:
+        int: The numa node id if all the cores are on the same numa node,
+        otherwise -1.
+    """
+
+    logical_core_node_map = _get_logical_core_node_map()
+    numa_node_ids = set(logical_core_node_map.get(core, -1) for core in core_list)
+    if len(numa_node_ids) != 1:
+        return -1
+    return numa_node_ids.pop()
+
+def set_op_min_work_per_thread(op_name, min_work_per_thread):
+    r"""
+    Set the intra-op thread count policy of a small op. The op runs on
+    ``ceil(work / min_work_per_thread)`` OpenMP threads at most, where the
+    work is the number of elements it processes, so that a tiny op doesn't
+    pay the fork/join overhead of all the threads of its Task.
+
+    Args:
+        op_name (str): One of ``layer_norm``, ``softmax`` and
+            ``embedding_bag``.
+        min_work_per_thread (int): The minimum number of elements per thread.
+            The default value is 4096. A value <= 0 disables the policy, and
+            the op runs on all the threads.
+    """
+
+    import intel_extension_for_pytorch as ipex
+    ipex._C._set_op_min_work_per_thread(op_name, min_work_per_thread)
+
+def get_op_min_work_per_thread(op_name):
+    r"""
+    Returns:
+        int: The minimum number of elements per thread of ``op_name``, see
+        :func:`set_op_min_work_per_thread`.
+    """
+
+    import intel_extension_for_pytorch as ipex
+    return ipex._C._get_op_min_work_per_thread(op_name)
@@ -0,0 +1,263 @@
+import threading
+import time
+import torch
+import intel_extension_for_pytorch as ipex
+from .cpupool import CPUPool, create_cpu_pools
+from .task import _warmup
+
+# The weight of the latest measure in the moving average of the service time
+_SERVICE_TIME_ALPHA = 0.2
+
+class _ExecutorTask(object):
+    # The TaskModule of a model on a shared TaskExecutor, called by _warmup as
+    # a Task
+    def __init__(self, task_module):
+        self._task = task_module
+
+    def __call__(self, *args, **kwargs):
+        return self._task.run_async(*args, **kwargs)
+
+class ScheduledModel(object):
+    r"""
+    A model registered to a :class:`ModelScheduler`, returned by
+    :meth:`ModelScheduler.register`. Calling it submits one input and returns
+    its future, the same as the call of
+    :class:`~intel_extension_for_pytorch.cpu.runtime.Task`.
+
+    The input goes to the home executor of the model with the shortest queue.
+    With ``slo_ms``, an input expected to miss the SLO on its home executors
+    goes to the executor with the shortest queue instead, and runs in the high
+    priority lane if it is still expected to miss it.
+    """
+
+    def __init__(self, scheduler, model, weight, slo_ms, service_ms, home_executors):
+        self._scheduler = scheduler
+        self.model = model
+        self.weight = weight
+        self.slo_ms = slo_ms
+        self.service_ms = service_ms
+        self.home_executors = home_executors
+        self.is_script_module = isinstance(model, torch.jit.ScriptModule)
+        # The TaskModule of each executor which the model ran on, created once
+        # per executor
+        self._tasks = {}
+        self._lock = threading.Lock()
+        self._submitted = 0
+        self._spilled = 0
+        self._high_priority = 0
+        for index in home_executors:
+            self._get_task(index)
+
+    def _get_task(self, index):
+        task = self._tasks.get(index)
+        if task is None:
+            executor = self._scheduler._executors[index]
+            if self.is_script_module:
+                task = ipex._C.TaskModule(self.model._c, executor, True)
+            else:
+                task = ipex._C.TaskModule(self.model, executor)
+            self._tasks[index] = task
+        return task
+
+    def _observe(self, start):
+        # the latency of an input which found an empty queue, i.e. its service
+        # time
+        latency_ms = (time.perf_counter() - start) * 1000
+        with self._lock:
+            if self.service_ms is None:
+                self.service_ms = latency_ms
+            else:
+                self.service_ms += _SERVICE_TIME_ALPHA * (latency_ms - self.service_ms)
+
+    def __call__(self, *args, **kwargs):
+        scheduler = self._scheduler
+        queued = [executor.get_queued_tasks() for executor in scheduler._executors]
+        index = min(self.home_executors, key=lambda i: queued[i])
+        high_priority = False
+        if self.slo_ms is not None and self.service_ms is not None:
+            # The wait of the queued inputs of all the models is estimated by
+            # the mean service time of the models.
+            mean_service_ms = scheduler._mean_service_ms()
+            expected_ms = queued[index] * mean_service_ms + self.service_ms
+            if expected_ms > self.slo_ms:
+                spill_index = min(range(len(queued)), key=lambda i: queued[i])
+                if queued[spill_index] < queued[index]:
+                    index = spill_index
+                    expected_ms = queued[index] * mean_service_ms + self.service_ms
+                    self._spilled += 1
+                high_priority = expected_ms > self.slo_ms
+        task = self._get_task(index)
+        start = time.perf_counter()
+        if high_priority:
+            self._high_priority += 1
+            future = task.run_async_high_priority(*args, **kwargs)
+        else:
+            future = task.run_async(*args, **kwargs)
+        self._submitted += 1
+        if self.slo_ms is not None and queued[index] == 0:
+            future.add_done_callback(lambda: self._observe(start))
+        return future
+
+    def warmup(self, shapes, dtype=torch.float32, num_runs=None):
+        r"""
+        Run the example inputs of each shape on all the home executors of the
+        model, as :meth:`Task.warmup`, and take the time of the last runs as
+        the service time of the model, if it is not given to
+        :meth:`ModelScheduler.register`.
+        """
+
+        tasks = [_ExecutorTask(self._tasks[index]) for index in self.home_executors]
+        _warmup(tasks, shapes, dtype, num_runs)
+        if self.service_ms is None:
+            start = time.perf_counter()
+            _warmup(tasks, shapes, dtype, 1)
+            with self._lock:
+                self.service_ms = (time.perf_counter() - start) * 1000 / len(shapes)
+
+    def get_stats(self):
+        r"""
+        Returns:
+            dict: ``submitted`` inputs, the inputs ``spilled`` off the home
+            executors and run in the ``high_priority`` lane for the SLO, the
+            ``service_ms`` estimate and the ``home_executors``.
+        """
+
+        return {
+            "submitted": self._submitted,
+            "spilled": self._spilled,
+            "high_priority": self._high_priority,
+            "service_ms": self.service_ms,
+            "home_executors": list(self.home_executors),
+        }
+
+class ModelScheduler(object):
+    r"""
+    ModelScheduler serves many models on one set of ``TaskExecutor`` workers,
+    instead of the ``CPUPool`` pinned statically to the streams of each model,
+    of which the cores of the idle models are wasted while the inputs of the
+    busy ones queue.
+
+    It owns the executors, one per ``CPUPool``, and each model registered by
+    :meth:`register` submits its inputs to them. The executors of one numa
+    node are in one work stealing group, so that an idle executor runs the
+    queued inputs of the busy ones of any model.
+
+    Each model lands on its ``num_streams`` home executors, the ones of the
+    least registered weight, where its inputs run by default, so that its
+    packed weights, its OpContexts and the thread local primitive caches of
+    the workers stay warm on the cores of its home executors. An input leaves
+    them only for the SLO of the model, or when an idle executor steals it.
+
+    .. highlight:: python
+    .. code-block:: python
+
+        scheduler = ipex.cpu.runtime.ModelScheduler(num_executors=8, node_id=0)
+        ranker = scheduler.register(traced_ranker, weight=4, num_streams=4, slo_ms=10)
+        encoder = scheduler.register(traced_encoder, weight=1)
+        with torch.no_grad():
+            ranker.warmup([(16, 128)])
+            y = ranker(x).get()
+
+    Args:
+        num_executors (int): Number of the executors on disjoint physical cores,
+            created by :func:`create_cpu_pools` with ``policy``. It doesn't
+            work if ``cpu_pools`` is set.
+        node_id (int): Only use the cores on this numa node. The default value
+            is None, which means all the numa nodes.
+        cpu_pools (list): The CPUPools of the executors, which are supposed
+            not to overlap. The default value is None.
+        kwargs: The other arguments of :func:`create_cpu_pools`, e.g.
+            ``memory_arena``.
+
+    Returns:
+        intel_extension_for_pytorch.cpu.runtime.ModelScheduler: Generated
+        intel_extension_for_pytorch.cpu.runtime.ModelScheduler object.
+    """
+
+    def __init__(self, num_executors: int = None, node_id: int = None, cpu_pools: list = None, **kwargs):
+        if cpu_pools is None:
+            assert num_executors is not None, "Either num_executors or cpu_pools is required"
+            cpu_pools = create_cpu_pools(num_executors, node_id, **kwargs)
+        assert len(cpu_pools) > 0 and all(type(cpu_pool) is CPUPool for cpu_pool in cpu_pools)
+        self.cpu_pools = cpu_pools
+        # one work stealing group per numa node, -1 of the pools across nodes
+        self._groups = {}
+        self._executors = []
+        for cpu_pool in cpu_pools:
+            group = self._groups.setdefault(cpu_pool.numa_node_id, ipex._C.TaskExecutorGroup())
+            self._executors.append(ipex._C.TaskExecutor(cpu_pool.cpu_pool, group))
+        # the registered weight of the models of each executor
+        self._executor_weights = [0.0] * len(self._executors)
+        self._models = []
+
+    def register(self, model, weight: float = 1.0, num_streams: int = 1, slo_ms: float = None, service_ms: float = None):
+        r"""
+        Register a model onto the executors of the scheduler.
+
+        Args:
+            model (torch.jit.ScriptModule or torch.nn.Module): The model.
+            weight (float): The expected load of the model relative to the
+                other models, e.g. its requests per second times its service
+                time, which is spread evenly over its home executors. The
+                default value is 1.
+            num_streams (int): Number of the home executors of the model, the
+                ones of the least registered weight. The default value is 1.
+            slo_ms (float): The latency target of the inputs of the model in
+                milliseconds. The default value is None, which means no SLO.
+            service_ms (float): The time of one input of the model on an
+                executor in milliseconds, for the SLO. The default value is
+                None, which means measured by :meth:`ScheduledModel.warmup`
+                and by the inputs finding an empty queue.
+
+        Returns:
+            intel_extension_for_pytorch.cpu.runtime.ScheduledModel: The
+            callable submitting the inputs of the model.
+        """
+
+        assert weight > 0, "weight must be positive"
+        assert 0 < num_streams <= len(self._executors), \
+            "num_streams must be in [1, {}], the number of executors".format(len(self._executors))
+        assert slo_ms is None or slo_ms > 0, "slo_ms must be positive"
+        home_executors = sorted(range(len(self._executors)), key=lambda i: self._executor_weights[i])[:num_streams]
+        for index in home_executors:
+            self._executor_weights[index] += weight / num_streams
+        scheduled_model = ScheduledModel(self, model, weight, slo_ms, service_ms, home_executors)
+        self._models.append(scheduled_model)
+        return scheduled_model
+
+    def unregister(self, scheduled_model):
+        r"""
+        Remove a model from the scheduler. It waits for the submitted inputs of
+        the model.
+        """
+
+        self._models.remove(scheduled_model)
+        for index in scheduled_model.home_executors:
+            self._executor_weights[index] -= scheduled_model.weight / len(scheduled_model.home_executors)
+        scheduled_model._tasks.clear()
+
+    def _mean_service_ms(self):
+        service_ms = [m.service_ms for m in self._models if m.service_ms is not None]
+        return sum(service_ms) / len(service_ms) if service_ms else 0.0
+
+    def get_stats(self):
+        r"""
+        Returns:
+            list: The ``core_ids``, the ``queued_tasks`` and the registered
+            ``weight`` of each executor.
+        """
+
+        return [{
+            "core_ids": executor.get_cpu_core_list(),
+            "queued_tasks": executor.get_queued_tasks(),
+            "weight": weight,
+        } for executor, weight in zip(self._executors, self._executor_weights)]
+
+    def shutdown(self):
+        r"""
+        Stop the workers of all the executors. The models can't be called any
+        more.
+        """
+
+        for executor in self._executors:
+            executor.stop()
@@ -5,6 +5,40 @@ import numpy as np
 import intel_extension_for_pytorch as ipex
 from .cpupool import CPUPool
 
+# The ids of QueueFullPolicy in C++
+_queue_full_policies = {"reject": 0, "block": 1, "drop_oldest": 2}
+
+TaskQueueFullError = ipex._C.TaskQueueFullError
+TaskDroppedError = ipex._C.TaskDroppedError
+
+def _get_warmup_runs():
+    # The profiling executor optimizes (and compiles the LLGA partitions of)
+    # a graph in the first run after the profiled runs.
+    get_num_profiled_runs = getattr(torch._C, '_jit_get_num_profiled_runs', None)
+    return (get_num_profiled_runs() if get_num_profiled_runs is not None else 1) + 1
+
+def _make_warmup_inputs(shape, dtype):
+    # shape is a tensor, the sizes of one tensor, or a tuple of them for the
+    # modules with several inputs.
+    if isinstance(shape, torch.Tensor):
+        return (shape,)
+    if all(isinstance(size, int) for size in shape):
+        return (torch.rand(shape).to(dtype),)
+    inputs = ()
+    for input_shape in shape:
+        inputs += _make_warmup_inputs(input_shape, dtype)
+    return inputs
+
+def _warmup(tasks, shapes, dtype, num_runs):
+    if num_runs is None:
+        num_runs = _get_warmup_runs()
+    for shape in shapes:
+        inputs = _make_warmup_inputs(shape, dtype)
+        for _ in range(num_runs):
+            # One input per Task at a time keeps all the workers busy, so that
+            # the work stealing doesn't move the warmup to another worker.
+            ipex._C.wait_all([task(*inputs) for task in tasks])
+
 class Task(object):
     r"""
     An abstraction of computation based on PyTorch module and is scheduled
@@ -15,24 +49,149 @@ class Task(object):
         cpu_pool (intel_extension_for_pytorch.cpu.runtime.CPUPool): An
             intel_extension_for_pytorch.cpu.runtime.CPUPool object, contains
             all CPU cores used to run Task asynchronously.
+        executor_group (intel_extension_for_pytorch._C.TaskExecutorGroup):
+            An optional work stealing group. Tasks created with the same group
+            steal the pending inputs from each other when they are idle. The
+            default value is None, which disables work stealing.
 
     Returns:
         intel_extension_for_pytorch.cpu.runtime.Task: Generated
         intel_extension_for_pytorch.cpu.runtime.Task object.
     """
 
-    def __init__(self, module, cpu_pool: CPUPool):
+    def __init__(self, module, cpu_pool: CPUPool, executor_group=None):
         self.cpu_pool = cpu_pool
         assert type(self.cpu_pool) is CPUPool
+        # The C++ CPUPool carries the numa node id for memory binding.
         if isinstance(module, torch.jit.ScriptModule):
-            self._task = ipex._C.TaskModule(module._c, self.cpu_pool.core_ids, True)
+            self._task = ipex._C.TaskModule(module._c, self.cpu_pool.cpu_pool, True, executor_group)
         else:
-            self._task = ipex._C.TaskModule(module, self.cpu_pool.core_ids)
+            self._task = ipex._C.TaskModule(module, self.cpu_pool.cpu_pool, executor_group)
 
     def __call__(self, *args, **kwargs):
         # async execution
         return self._task.run_async(*args, **kwargs)
 
+    def run_high_priority(self, *args, **kwargs):
+        r"""
+        Async execution in the high priority lane. The queued high priority
+        inputs are executed before any queued input submitted by
+        :meth:`__call__`. The running input is not preempted.
+
+        Returns:
+            The future of the result, the same as :meth:`__call__`.
+        """
+
+        return self._task.run_async_high_priority(*args, **kwargs)
+
     def run_sync(self, *args, **kwargs):
         # sync execution
         return self._task.run_sync(*args, **kwargs)
+
+    def warmup(self, shapes, dtype=torch.float32, num_runs=None):
+        r"""
+        Run the Task with the example inputs of each shape ahead of the live
+        traffic, so that the first real inputs of these shapes don't pay for
+        the JIT profiling runs, the oneDNN primitive creation and the LLGA
+        partition compilation. The inputs run on the worker thread of the
+        Task, which owns these thread local caches. Call it in the same grad
+        mode as the inference, e.g. inside ``torch.no_grad()``.
+
+        Args:
+            shapes (list): The input shapes to warm up. Each item is the sizes
+                of the input, e.g. ``(1, 3, 224, 224)``, or an example input
+                tensor, e.g. for the integer inputs, or a tuple of them for the
+                module with several inputs.
+            dtype (torch.dtype): The dtype of the inputs created from the
+                sizes. The default value is ``torch.float32``.
+            num_runs (int): Number of runs per shape. The default value is
+                None, which means the number of JIT profiled runs plus one.
+        """
+
+        _warmup([self], shapes, dtype, num_runs)
+
+    def resize(self, cpu_pool: CPUPool):
+        r"""
+        Move the Task onto the cores of a new CPUPool without recreating it.
+        The module and the warmed up state are kept. The new cores take effect
+        at the next task boundary, the running input finishes on the old cores.
+
+        Args:
+            cpu_pool (intel_extension_for_pytorch.cpu.runtime.CPUPool): The
+                new CPUPool to run the Task.
+        """
+
+        assert type(cpu_pool) is CPUPool
+        self._task.resize(cpu_pool.cpu_pool)
+        self.cpu_pool = cpu_pool
+
+    def set_queue_limit(self, max_queued_tasks, policy="reject"):
+        r"""
+        Bound the number of inputs queued by :meth:`__call__` and not started
+        yet, so that a traffic burst is shed instead of growing the queue and
+        the latency of all inputs. The inputs of :meth:`run_high_priority`
+        are not bounded.
+
+        Args:
+            max_queued_tasks (int): The max number of queued inputs, 0 means
+                unbounded, which is the default.
+            policy (str): What happens to a new input when the queue is full.
+                ``"reject"``: raise ``TaskQueueFullError`` to the caller.
+                ``"block"``: block the caller until a queued input starts.
+                ``"drop_oldest"``: drop the oldest queued input to make room,
+                whose future raises ``TaskDroppedError``.
+                The default value is ``"reject"``.
+        """
+
+        assert policy in _queue_full_policies, \
+            "policy should be one of {}".format(list(_queue_full_policies.keys()))
+        assert max_queued_tasks >= 0
+        self._task.set_queue_limit(max_queued_tasks, _queue_full_policies[policy])
+
+    def get_queue_stats(self):
+        r"""
+        Returns:
+            dict: The queue-depth gauges and the admission counters of the
+            Task: ``queued_tasks``, ``high_priority_queued_tasks``,
+            ``peak_queued_tasks``, ``rejected_tasks``, ``dropped_tasks`` and
+            ``blocked_submissions``.
+        """
+
+        return self._task.get_queue_stats()
+
+    def get_core_ids(self):
+        r"""
+        Returns:
+            list: The core ids which the Task is pinned on, including the
+            pending core ids of :meth:`resize`.
+        """
+
+        return self._task.get_cpu_core_list()
+
+def wait_all(futures):
+    r"""
+    Block until all the futures returned by the async execution of
+    :class:`Task` are done. The GIL is released during the whole wait.
+
+    Args:
+        futures (list): A list of futures returned by the async execution.
+
+    Returns:
+        list: The results of the futures, in the same order of ``futures``.
+    """
+
+    return ipex._C.wait_all(list(futures))
+
+def wait_any(futures):
+    r"""
+    Block until any of the futures returned by the async execution of
+    :class:`Task` is done. The GIL is released during the whole wait.
+
+    Args:
+        futures (list): A list of futures returned by the async execution.
+
+    Returns:
+        int: The index of the first done future in ``futures``.
+    """
+
+    return ipex._C.wait_any(list(futures))
@@ -0,0 +1,110 @@
+import json
+import os
+import intel_extension_for_pytorch as ipex
+
+class request_scope(object):
+    r"""
+    Tag the inputs submitted by the current thread to the Tasks of the
+    runtime extension inside the scope with ``request_id``, which is reported
+    by :class:`trace_tasks`. The inputs submitted by a traced Task, e.g. the
+    next stage of :class:`PipelineModule`, inherit its request id.
+
+    Args:
+        request_id (int): The id of the request, must be >= 0.
+
+    Returns:
+        intel_extension_for_pytorch.cpu.runtime.request_scope: Generated
+        intel_extension_for_pytorch.cpu.runtime.request_scope object which can
+        be used as a `with` context.
+    """
+
+    def __init__(self, request_id: int):
+        assert request_id >= 0, "request_id must be >= 0"
+        self.request_id = request_id
+
+    def __enter__(self):
+        self.previous_request_id = ipex._C._get_current_request_id()
+        ipex._C._set_current_request_id(self.request_id)
+
+    def __exit__(self, *args):
+        ipex._C._set_current_request_id(self.previous_request_id)
+
+class trace_tasks(object):
+    r"""
+    Record how long each input submitted to the Tasks of the runtime extension
+    inside the scope waits in the queue and takes to execute, to tell whether
+    the tail latency comes from queueing or from compute.
+
+    The traced input also runs with the thread local state of the submitting
+    thread, so that the ops executed by the Task show up under the
+    ``ipex::run_task`` event in the trace of ``torch.profiler.profile`` or
+    ``torch.autograd.profiler.profile`` wrapping the submission.
+
+    Returns:
+        intel_extension_for_pytorch.cpu.runtime.trace_tasks: Generated
+        intel_extension_for_pytorch.cpu.runtime.trace_tasks object which can be
+        used as a `with` context.
+
+    Examples:
+
+        >>> with ipex.cpu.runtime.trace_tasks() as trace:
+        ...     with ipex.cpu.runtime.request_scope(0):
+        ...         y = task(x).get()
+        >>> trace.export_chrome_trace("trace.json")
+    """
+
+    def __enter__(self):
+        ipex._C._clear_task_traces()
+        ipex._C._set_task_tracing_enabled(True)
+        return self
+
+    def __exit__(self, *args):
+        ipex._C._set_task_tracing_enabled(False)
+
+    @property
+    def records(self):
+        r"""
+        list: One dict per finished input, with the ``request_id``, the
+        ``executor_id`` of the Task executing it, the ``submit_time_us``,
+        ``start_time_us`` and ``end_time_us`` timestamps, the
+        ``queue_time_us`` and the ``execution_time_us``. The inputs submitted
+        without :class:`request_scope` get a unique negative request id.
+        """
+
+        records = []
+        for request_id, executor_id, submit_time_us, start_time_us, end_time_us in ipex._C._get_task_traces():
+            records.append({
+                'request_id': request_id,
+                'executor_id': executor_id,
+                'submit_time_us': submit_time_us,
+                'start_time_us': start_time_us,
+                'end_time_us': end_time_us,
+                'queue_time_us': start_time_us - submit_time_us,
+                'execution_time_us': end_time_us - start_time_us})
+        return records
+
+    def export_chrome_trace(self, path):
+        r"""
+        Export the records in the Chrome trace format, which can be opened by
+        ``chrome://tracing`` or Perfetto. The execution of each Task is shown
+        on its own track, and the queue wait as the asynchronous events.
+
+        Args:
+            path (str): The output json file.
+        """
+
+        pid = os.getpid()
+        events = []
+        for executor_id in sorted(set(record['executor_id'] for record in self.records)):
+            events.append({'name': 'thread_name', 'ph': 'M', 'pid': pid, 'tid': executor_id,
+                           'args': {'name': 'TaskExecutor {}'.format(executor_id)}})
+        for index, record in enumerate(self.records):
+            name = 'request {}'.format(record['request_id'])
+            args = {'request_id': record['request_id']}
+            events.append({'name': name, 'cat': 'execution', 'ph': 'X', 'pid': pid, 'tid': record['executor_id'],
+                           'ts': record['start_time_us'], 'dur': record['execution_time_us'], 'args': args})
+            for phase, ts in (('b', record['submit_time_us']), ('e', record['start_time_us'])):
+                events.append({'name': name, 'cat': 'queue', 'ph': phase, 'id': index, 'pid': pid,
+                               'tid': record['executor_id'], 'ts': ts, 'args': args})
+        with open(path, 'w') as f:
+            json.dump({'traceEvents': events, 'displayTimeUnit': 'ms'}, f)
@@ -9,6 +9,11 @@
 #include "AdaptiveAveragePooling.h"
 
 #include "csrc/utils/library.h"
+#include "csrc/utils/op_trace.h"
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
 
 namespace torch_ipex {
 namespace cpu {
@@ -32,6 +37,10 @@ void cpu_adaptive_avg_pool(
   int64_t output_height = output_size[0];
   int64_t output_width = output_size[1];
 
+  std::vector<int64_t> ih0, ih1, iw0, iw1;
+  compute_adaptive_bins(output_height, input_height, ih0, ih1);
+  compute_adaptive_bins(output_width, input_width, iw0, iw1);
+
   // parallel on dim of N, C
   at::parallel_for(0, channels, 0, [&](int64_t begin, int64_t end) {
     for (int64_t c = begin; c < end; c++) {
@@ -39,19 +48,15 @@ void cpu_adaptive_avg_pool(
       scalar_t* output_ptr = output_data + c * output_height * output_width;
 
       for (int64_t oh = 0; oh < output_height; oh++) {
-        int64_t ih0 = start_index(oh, output_height, input_height);
-        int64_t ih1 = end_index(oh, output_height, input_height);
-        int64_t kh = ih1 - ih0;
+        int64_t kh = ih1[oh] - ih0[oh];
 
         for (int64_t ow = 0; ow < output_width; ow++) {
-          int64_t iw0 = start_index(ow, output_width, input_width);
-          int64_t iw1 = end_index(ow, output_width, input_width);
-          int64_t kw = iw1 - iw0;
+          int64_t kw = iw1[ow] - iw0[ow];
 
           // compute local average
           accscalar_t sum = 0;
-          for (int64_t ih = ih0; ih < ih1; ih++) {
-            for (int64_t iw = iw0; iw < iw1; iw++) {
+          for (int64_t ih = ih0[oh]; ih < ih1[oh]; ih++) {
+            for (int64_t iw = iw0[ow]; iw < iw1[ow]; iw++) {
               sum += accscalar_t(input_ptr[ih * input_width + iw]);
             }
           }
@@ -66,11 +71,84 @@ void cpu_adaptive_avg_pool(
   }
 }
 
+// sum += in, of a lane of size channels
 template <typename scalar_t>
-void cpu_adaptive_avg_pool_channels_last(
+inline void sum_lane(scalar_t* sum, const scalar_t* in, int64_t size) {
+  using Vec = at::vec::Vectorized<scalar_t>;
+  int64_t d = 0;
+  for (; d < size - (size % Vec::size()); d += Vec::size()) {
+    Vec sum_vec = Vec::loadu(sum + d) + Vec::loadu(in + d);
+    sum_vec.store(sum + d);
+  }
+  for (; d < size; d++) {
+    sum[d] += in[d];
+  }
+}
+
+inline void sum_lane(float* sum, const at::BFloat16* in, int64_t size) {
+  using bVec = at::vec::Vectorized<at::BFloat16>;
+  using fVec = at::vec::Vectorized<float>;
+  int64_t d = 0;
+  for (; d < size - (size % bVec::size()); d += bVec::size()) {
+    fVec data_fvec0, data_fvec1;
+    std::tie(data_fvec0, data_fvec1) =
+        convert_bfloat16_float(bVec::loadu(in + d));
+    fVec sum_fvec0 = fVec::loadu(sum + d) + data_fvec0;
+    fVec sum_fvec1 = fVec::loadu(sum + d + fVec::size()) + data_fvec1;
+    sum_fvec0.store(sum + d);
+    sum_fvec1.store(sum + d + fVec::size());
+  }
+  for (; d < size; d++) {
+    sum[d] += float(in[d]);
+  }
+}
+
+// out = sum / pool_size, of a lane of size channels
+template <typename scalar_t>
+inline void average_lane(
+    scalar_t* out,
+    const scalar_t* sum,
+    int64_t pool_size,
+    int64_t size) {
+  using Vec = at::vec::Vectorized<scalar_t>;
+  int64_t d = 0;
+  for (; d < size - (size % Vec::size()); d += Vec::size()) {
+    Vec out_vec = Vec::loadu(sum + d) / Vec(scalar_t(pool_size));
+    out_vec.store(out + d);
+  }
+  for (; d < size; d++) {
+    out[d] = sum[d] / pool_size;
+  }
+}
+
+inline void average_lane(
+    at::BFloat16* out,
+    const float* sum,
+    int64_t pool_size,
+    int64_t size) {
+  using bVec = at::vec::Vectorized<at::BFloat16>;
+  using fVec = at::vec::Vectorized<float>;
+  int64_t d = 0;
+  for (; d < size - (size % bVec::size()); d += bVec::size()) {
+    fVec out_fvec0 = fVec::loadu(sum + d) / fVec(float(pool_size));
+    fVec out_fvec1 =
+        fVec::loadu(sum + d + fVec::size()) / fVec(float(pool_size));
+    bVec out_bvec = convert_float_bfloat16(out_fvec0, out_fvec1);
+    out_bvec.store(out + d);
+  }
+  for (; d < size; d++) {
+    out[d] = at::BFloat16(sum[d] / pool_size);
+  }
+}
+
+// The global average pooling of channels last, i.e. of the output size 1x1,
+// as the mean of the pixels of every image, reduced along the contiguous
+// channels. The channels are split into blocks for the small batches, so
+// that all the threads have some work.
+template <typename scalar_t>
+void cpu_adaptive_avg_pool_global_channels_last(
     at::Tensor& output_,
-    const at::Tensor& input_,
-    at::IntArrayRef output_size) {
+    const at::Tensor& input_) {
   auto memory_format = at::MemoryFormat::ChannelsLast;
   auto input = input_.contiguous(memory_format);
   auto output = output_.contiguous(memory_format);
@@ -80,77 +158,37 @@ void cpu_adaptive_avg_pool_channels_last(
 
   int64_t nbatch = input.size(0);
   int64_t channels = input.size(1);
-  int64_t input_height = input.size(2);
-  int64_t input_width = input.size(3);
-  int64_t output_height = output_size[0];
-  int64_t output_width = output_size[1];
+  int64_t input_size = input.size(2) * input.size(3);
 
+  // use float as accumulation type for BFloat16
+  using accscalar_t = typename std::conditional<
+      std::is_same<scalar_t, at::BFloat16>::value,
+      float,
+      scalar_t>::type;
   using Vec = at::vec::Vectorized<scalar_t>;
-  // parallel on dim N, H, W
+  int64_t num_blocks = std::min(
+      at::divup(at::get_num_threads(), std::max<int64_t>(nbatch, 1)),
+      at::divup(channels, Vec::size()));
+  int64_t block_size = at::divup(channels, num_blocks);
+  block_size = at::divup(block_size, Vec::size()) * Vec::size();
+  num_blocks = at::divup(channels, block_size);
+
+  // parallel on dim of N, C blocks
   at::parallel_for(
-      0,
-      nbatch * output_height * output_width,
-      0,
-      [&](int64_t begin, int64_t end) {
-        int64_t n = 0;
-        int64_t oh = 0;
-        int64_t ow = 0;
-        at::native::data_index_init(
-            begin, n, nbatch, oh, output_height, ow, output_width);
-
+      0, nbatch * num_blocks, 0, [&](int64_t begin, int64_t end) {
+        std::vector<accscalar_t> sum_arr(block_size);
+        accscalar_t* sum = sum_arr.data();
         for (int64_t i = begin; i < end; i++) {
-          int64_t ih0 = start_index(oh, output_height, input_height);
-          int64_t ih1 = end_index(oh, output_height, input_height);
-          int64_t kh = ih1 - ih0;
-
-          int64_t iw0 = start_index(ow, output_width, input_width);
-          int64_t iw1 = end_index(ow, output_width, input_width);
-          int64_t kw = iw1 - iw0;
-
-          scalar_t* out = output_data + i * channels;
-          int64_t size = channels;
-
-          // Note: For oridinary usage scenario, each out lane should
-          //   fit in L1 cache; otherwise consider block dim C.
-          // Pass I: zero the out lane
-          int64_t d1 = 0;
-          for (; d1 < size - (size % Vec::size()); d1 += Vec::size()) {
-            Vec out_vec = Vec(scalar_t(0));
-            out_vec.store(out + d1);
-          }
-          for (; d1 < size; d1++) {
-            out[d1] = scalar_t(0);
-          }
-          // Pass II: compute local sum
-          for (int64_t ih = ih0; ih < ih1; ih++) {
-            for (int64_t iw = iw0; iw < iw1; iw++) {
-              scalar_t* in = input_data +
-                  n * input_height * input_width * channels +
-                  ih * input_width * channels + iw * channels;
-
-              int64_t d2 = 0;
-              for (; d2 < size - (size % Vec::size()); d2 += Vec::size()) {
-                Vec out_vec = Vec::loadu(out + d2) + Vec::loadu(in + d2);
-                out_vec.store(out + d2);
-              }
-              for (; d2 < size; d2++) {
-                out[d2] += in[d2];
-              }
-            }
-          }
-          // Pass III: compute local average
-          int64_t d3 = 0;
-          for (; d3 < size - (size % Vec::size()); d3 += Vec::size()) {
-            Vec out_vec = Vec::loadu(out + d3) / Vec(scalar_t(kh * kw));
-            out_vec.store(out + d3);
-          }
-          for (; d3 < size; d3++) {
-            out[d3] = out[d3] / kh / kw;
+          int64_t n = i / num_blocks;
+          int64_t c0 = i % num_blocks * block_size;
+          int64_t size = std::min(block_size, channels - c0);
+          const scalar_t* in = input_data + n * input_size * channels + c0;
+
+          std::fill_n(sum, size, accscalar_t(0));
+          for (int64_t j = 0; j < input_size; j++) {
+            sum_lane(sum, in + j * channels, size);
           }
-
-          // move on to next output index
-          at::native::data_index_step(
-              n, nbatch, oh, output_height, ow, output_width);
+          average_lane(output_data + n * channels + c0, sum, input_size, size);
         }
       });
 
@@ -159,17 +197,22 @@ void cpu_adaptive_avg_pool_channels_last(
   }
 }
 
-template <>
-void cpu_adaptive_avg_pool_channels_last<at::BFloat16>(
+template <typename scalar_t>
+void cpu_adaptive_avg_pool_channels_last(
     at::Tensor& output_,
     const at::Tensor& input_,
     at::IntArrayRef output_size) {
+  if (output_size[0] == 1 && output_size[1] == 1) {
+    cpu_adaptive_avg_pool_global_channels_last<scalar_t>(output_, input_);
+    return;
+  }
+
   auto memory_format = at::MemoryFormat::ChannelsLast;
   auto input = input_.contiguous(memory_format);
   auto output = output_.contiguous(memory_format);
 
-  auto input_data = input.data_ptr<at::BFloat16>();
-  auto output_data = output.data_ptr<at::BFloat16>();
+  auto input_data = input.data_ptr<scalar_t>();
+  auto output_data = output.data_ptr<scalar_t>();
 
   int64_t nbatch = input.size(0);
   int64_t channels = input.size(1);
@@ -178,8 +221,18 @@ void cpu_adaptive_avg_pool_channels_last<at::BFloat16>(
   int64_t output_height = output_size[0];
   int64_t output_width = output_size[1];
 
-  using bVec = at::vec::Vectorized<at::BFloat16>;
-  using fVec = at::vec::Vectorized<float>;
+  // the bins are reused by all the images
+  std::vector<int64_t> ih0, ih1, iw0, iw1;
+  compute_adaptive_bins(output_height, input_height, ih0, ih1);
+  compute_adaptive_bins(output_width, input_width, iw0, iw1);
+
+  // use float as accumulation type for BFloat16, of which the sum can't be
+  // kept in the output lane
+  using accscalar_t = typename std::conditional<
+      std::is_same<scalar_t, at::BFloat16>::value,
+      float,
+      scalar_t>::type;
+  constexpr bool is_acc = std::is_same<scalar_t, accscalar_t>::value;
   // parallel on dim N, H, W
   at::parallel_for(
       0,
@@ -192,70 +245,32 @@ void cpu_adaptive_avg_pool_channels_last<at::BFloat16>(
         at::native::data_index_init(
             begin, n, nbatch, oh, output_height, ow, output_width);
 
-        // temp buffer for sum, use float as accumulation type
-        // can't reuse output buffer to store sum since it is BFloat16
-        std::unique_ptr<float[]> sum_arr(new float[channels]);
-        float* sum = sum_arr.get();
+        std::vector<accscalar_t> sum_arr(is_acc ? 0 : channels);
 
         for (int64_t i = begin; i < end; i++) {
-          int64_t ih0 = start_index(oh, output_height, input_height);
-          int64_t ih1 = end_index(oh, output_height, input_height);
-          int64_t kh = ih1 - ih0;
-
-          int64_t iw0 = start_index(ow, output_width, input_width);
-          int64_t iw1 = end_index(ow, output_width, input_width);
-          int64_t kw = iw1 - iw0;
+          int64_t kh = ih1[oh] - ih0[oh];
+          int64_t kw = iw1[ow] - iw0[ow];
 
-          at::BFloat16* out = output_data + i * channels;
+          scalar_t* out = output_data + i * channels;
+          accscalar_t* sum = is_acc ? reinterpret_cast<accscalar_t*>(out)
+                                    : sum_arr.data();
           int64_t size = channels;
 
-          // Pass I: zero the out lane
-          int64_t d1 = 0;
-          for (; d1 < size - (size % fVec::size()); d1 += fVec::size()) {
-            fVec sum_fvec = fVec(float(0));
-            sum_fvec.store(sum + d1);
-          }
-          for (; d1 < size; d1++) {
-            sum[d1] = float(0);
-          }
+          // Note: For oridinary usage scenario, each out lane should
+          //   fit in L1 cache; otherwise consider block dim C.
+          // Pass I: zero the sum lane
+          std::fill_n(sum, size, accscalar_t(0));
           // Pass II: compute local sum
-          for (int64_t ih = ih0; ih < ih1; ih++) {
-            for (int64_t iw = iw0; iw < iw1; iw++) {
-              at::BFloat16* in = input_data +
+          for (int64_t ih = ih0[oh]; ih < ih1[oh]; ih++) {
+            for (int64_t iw = iw0[ow]; iw < iw1[ow]; iw++) {
+              scalar_t* in = input_data +
                   n * input_height * input_width * channels +
                   ih * input_width * channels + iw * channels;
-
-              int64_t d2 = 0;
-              for (; d2 < size - (size % bVec::size()); d2 += bVec::size()) {
-                bVec data_bvec = bVec::loadu(in + d2);
-                fVec data_fvec0, data_fvec1;
-                std::tie(data_fvec0, data_fvec1) =
-                    convert_bfloat16_float(data_bvec);
-
-                fVec sum_fvec0 = fVec::loadu(sum + d2) + data_fvec0;
-                fVec sum_fvec1 =
-                    fVec::loadu(sum + d2 + fVec::size()) + data_fvec1;
-                sum_fvec0.store(sum + d2);
-                sum_fvec1.store(sum + d2 + fVec::size());
-              }
-              for (; d2 < size; d2++) {
-                sum[d2] += float(in[d2]);
-              }
+              sum_lane(sum, in, size);
             }
           }
           // Pass III: compute local average
-          int64_t d3 = 0;
-          for (; d3 < size - (size % bVec::size()); d3 += bVec::size()) {
-            fVec out_fvec0 = fVec::loadu(sum + d3) / fVec(float(kh * kw));
-            fVec out_fvec1 =
-                fVec::loadu(sum + d3 + fVec::size()) / fVec(float(kh * kw));
-
-            bVec out_bvec = convert_float_bfloat16(out_fvec0, out_fvec1);
-            out_bvec.store(out + d3);
-          }
-          for (; d3 < size; d3++) {
-            out[d3] = at::BFloat16(sum[d3] / kh / kw);
-          }
+          average_lane(out, sum, kh * kw, size);
 
           // move on to next output index
           at::native::data_index_step(
@@ -559,10 +574,8 @@ at::Tensor& adaptive_avg_pool2d_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::adaptive_avg_pool2d_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::adaptive_avg_pool2d_out_cpu", std::vector<c10::IValue>({}));
-#endif
   adaptive_avg_pool2d_out_cpu_template(output, input, output_size);
   return output;
 }
@@ -573,10 +586,8 @@ at::Tensor adaptive_avg_pool2d_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::adaptive_avg_pool2d_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::adaptive_avg_pool2d_cpu", std::vector<c10::IValue>({}));
-#endif
   auto output = at::empty({0}, input.options());
   adaptive_avg_pool2d_out_cpu_template(output, input, output_size);
   return output;
@@ -621,11 +632,9 @@ at::Tensor& adaptive_avg_pool2d_backward_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::adaptive_avg_pool2d_backward_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::adaptive_avg_pool2d_backward_out_cpu",
       std::vector<c10::IValue>({}));
-#endif
   adaptive_avg_pool2d_backward_out_cpu_template(grad_input, grad_output, input);
   return grad_input;
 }
@@ -636,11 +645,9 @@ at::Tensor adaptive_avg_pool2d_backward_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::adaptive_avg_pool2d_backward_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::adaptive_avg_pool2d_backward_cpu",
       std::vector<c10::IValue>({}));
-#endif
   auto grad_input = at::empty({0}, input.options());
   adaptive_avg_pool2d_backward_out_cpu_template(grad_input, grad_output, input);
   return grad_input;
@@ -2,6 +2,8 @@
 
 #include <ATen/ATen.h>
 
+#include <vector>
+
 namespace torch_ipex {
 namespace cpu {
 
@@ -13,6 +15,22 @@ static inline int64_t end_index(int64_t a, int64_t b, int64_t c) {
   return (int64_t)std::ceil((float)((a + 1) * c) / b);
 }
 
+// The input range [starts[i], ends[i]) pooled into the output index i, of
+// all the output indices along a dim. The bins are computed once and reused
+// by all the batches and channels.
+static inline void compute_adaptive_bins(
+    int64_t output_size,
+    int64_t input_size,
+    std::vector<int64_t>& starts,
+    std::vector<int64_t>& ends) {
+  starts.resize(output_size);
+  ends.resize(output_size);
+  for (int64_t i = 0; i < output_size; i++) {
+    starts[i] = start_index(i, output_size, input_size);
+    ends[i] = end_index(i, output_size, input_size);
+  }
+}
+
 template <typename scalar_t, typename accscalar_t>
 void cpu_adaptive_avg_pool(
     at::Tensor& output_,
@@ -25,11 +43,10 @@ void cpu_adaptive_avg_pool_channels_last(
     const at::Tensor& input_,
     at::IntArrayRef output_size);
 
-template <>
-void cpu_adaptive_avg_pool_channels_last<at::BFloat16>(
+template <typename scalar_t>
+void cpu_adaptive_avg_pool_global_channels_last(
     at::Tensor& output_,
-    const at::Tensor& input_,
-    at::IntArrayRef output_size);
+    const at::Tensor& input_);
 
 template <typename scalar_t>
 void cpu_adaptive_avg_pool_backward(
@@ -11,6 +11,9 @@
 #include "AdaptiveMaxPooling.h"
 
 #include "csrc/utils/library.h"
+#include "csrc/utils/op_trace.h"
+
+#include <vector>
 
 namespace torch_ipex {
 namespace cpu {
@@ -37,6 +40,11 @@ void cpu_adaptive_max_pool(
   int64_t output_height = output_size[0];
   int64_t output_width = output_size[1];
 
+  // the bins are reused by all the images and channels
+  std::vector<int64_t> ih_starts, ih_ends, iw_starts, iw_ends;
+  compute_adaptive_bins(output_height, input_height, ih_starts, ih_ends);
+  compute_adaptive_bins(output_width, input_width, iw_starts, iw_ends);
+
   // parallel on dim of N, C
   at::parallel_for(0, channels, 0, [&](int64_t begin, int64_t end) {
     for (const auto c : c10::irange(begin, end)) {
@@ -45,12 +53,12 @@ void cpu_adaptive_max_pool(
       int64_t* indices_ptr = indices_data + c * output_height * output_width;
 
       for (const auto oh : c10::irange(output_height)) {
-        int64_t ih0 = start_index(oh, output_height, input_height);
-        int64_t ih1 = end_index(oh, output_height, input_height);
+        int64_t ih0 = ih_starts[oh];
+        int64_t ih1 = ih_ends[oh];
 
         for (const auto ow : c10::irange(output_width)) {
-          int64_t iw0 = start_index(ow, output_width, input_width);
-          int64_t iw1 = end_index(ow, output_width, input_width);
+          int64_t iw0 = iw_starts[ow];
+          int64_t iw1 = iw_ends[ow];
 
           // compute local max
           int64_t maxindex = ih0 * input_width + iw0;
@@ -109,6 +117,11 @@ void cpu_adaptive_max_pool_channels_last(
   int64_t output_height = output_size[0];
   int64_t output_width = output_size[1];
 
+  // the bins are reused by all the images and channels
+  std::vector<int64_t> ih_starts, ih_ends, iw_starts, iw_ends;
+  compute_adaptive_bins(output_height, input_height, ih_starts, ih_ends);
+  compute_adaptive_bins(output_width, input_width, iw_starts, iw_ends);
+
   using Vec = at::vec::Vectorized<scalar_t>;
   using integer_t = at::vec::int_same_size_t<scalar_t>;
   using iVec = at::vec::Vectorized<integer_t>;
@@ -137,11 +150,11 @@ void cpu_adaptive_max_pool_channels_last(
         std::unique_ptr<integer_t[]> index_buffer(new integer_t[len]);
 
         for (const auto i : c10::irange(begin, end)) {
-          int64_t ih0 = start_index(oh, output_height, input_height);
-          int64_t ih1 = end_index(oh, output_height, input_height);
+          int64_t ih0 = ih_starts[oh];
+          int64_t ih1 = ih_ends[oh];
 
-          int64_t iw0 = start_index(ow, output_width, input_width);
-          int64_t iw1 = end_index(ow, output_width, input_width);
+          int64_t iw0 = iw_starts[ow];
+          int64_t iw1 = iw_ends[ow];
 
           scalar_t* out = output_data + i * channels;
           int64_t* ind = indices_data + i * channels;
@@ -237,6 +250,11 @@ void cpu_adaptive_max_pool_channels_last<at::BFloat16>(
   int64_t output_height = output_size[0];
   int64_t output_width = output_size[1];
 
+  // the bins are reused by all the images and channels
+  std::vector<int64_t> ih_starts, ih_ends, iw_starts, iw_ends;
+  compute_adaptive_bins(output_height, input_height, ih_starts, ih_ends);
+  compute_adaptive_bins(output_width, input_width, iw_starts, iw_ends);
+
   using bVec = at::vec::Vectorized<at::BFloat16>;
   using fVec = at::vec::Vectorized<float>;
   using iVec = at::vec::Vectorized<int32_t>;
@@ -265,11 +283,11 @@ void cpu_adaptive_max_pool_channels_last<at::BFloat16>(
         float* max = max_arr.get();
 
         for (const auto i : c10::irange(begin, end)) {
-          int64_t ih0 = start_index(oh, output_height, input_height);
-          int64_t ih1 = end_index(oh, output_height, input_height);
+          int64_t ih0 = ih_starts[oh];
+          int64_t ih1 = ih_ends[oh];
 
-          int64_t iw0 = start_index(ow, output_width, input_width);
-          int64_t iw1 = end_index(ow, output_width, input_width);
+          int64_t iw0 = iw_starts[ow];
+          int64_t iw1 = iw_ends[ow];
 
           at::BFloat16* out = output_data + i * channels;
           int64_t* ind = indices_data + i * channels;
@@ -553,10 +571,8 @@ std::tuple<at::Tensor, at::Tensor> adaptive_max_pool2d_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::adaptive_max_pool2d_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::adaptive_max_pool2d_out_cpu", std::vector<c10::IValue>({}));
-#endif
 
   int ndim = input.ndimension();
   TORCH_CHECK(
@@ -624,11 +640,9 @@ at::Tensor adaptive_max_pool2d_backward_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::adaptive_max_pool2d_backward_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::adaptive_max_pool2d_backward_out_cpu",
       std::vector<c10::IValue>({}));
-#endif
 
   int64_t ndim = grad_output.ndimension();
   TORCH_CHECK(
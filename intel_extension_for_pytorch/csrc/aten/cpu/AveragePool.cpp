@@ -12,6 +12,7 @@
 #include "csrc/utils/library.h"
 
 #include "AveragePool.h"
+#include "csrc/utils/op_trace.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -689,10 +690,8 @@ at::Tensor avg_pool2d_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::avg_pool2d_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::avg_pool2d_out_cpu", std::vector<c10::IValue>({}));
-#endif
 
   // #20866, #22032: Guarantee this for the official C++ API?
   TORCH_CHECK(
@@ -785,10 +784,8 @@ at::Tensor avg_pool2d_backward_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::avg_pool2d_backward_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::avg_pool2d_backward_out_cpu", std::vector<c10::IValue>({}));
-#endif
 
   // #20866, #22032: Guarantee this for the official C++ API?
   TORCH_CHECK(
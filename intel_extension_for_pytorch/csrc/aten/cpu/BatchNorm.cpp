@@ -5,6 +5,7 @@
 
 #include "csrc/autocast/autocast_mode.h"
 #include "csrc/autocast/autocast_verbose.h"
+#include "csrc/utils/op_trace.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -176,9 +177,8 @@ at::Tensor IPEXBatchNormOp::forward(
     bool train,
     double momentum,
     double eps) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("IPEXBatchNormOp::forward", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION(
+      "IPEXBatchNormOp::forward", std::vector<c10::IValue>({}));
   ctx->saved_data["train"] = train;
   ctx->saved_data["eps"] = eps;
   ctx->saved_data["input_requires_grad"] = input.requires_grad();
@@ -204,9 +204,8 @@ at::Tensor IPEXBatchNormOp::forward(
 torch::autograd::variable_list IPEXBatchNormOp::backward(
     torch::autograd::AutogradContext* ctx,
     torch::autograd::variable_list grad_outputs) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("IPEXBatchNormOp::backward", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION(
+      "IPEXBatchNormOp::backward", std::vector<c10::IValue>({}));
   auto train = ctx->saved_data["train"].toBool();
   auto eps = ctx->saved_data["eps"].toDouble();
 
@@ -253,14 +252,15 @@ at::Tensor batch_norm(
     double momentum,
     double eps,
     bool cudnn_enabled) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("torch_ipex::batch_norm", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("torch_ipex::batch_norm", std::vector<c10::IValue>({}));
   // Only 2d bfloat16 training calling onednn path, and this path will be
-  // discarded after aten batchnorm optimized well.
+  // discarded after aten batchnorm optimized well. The channels last one goes
+  // to the native kernels, of which the stats are collected in a single read
+  // of the input.
   if (weight_opt.has_value() && weight_opt.value().defined() &&
       bias_opt.has_value() && bias_opt.value().defined() &&
       !torch::jit::tracer::isTracing() && input.ndimension() == 4 && train &&
+      !input.is_contiguous(at::MemoryFormat::ChannelsLast) &&
       input.scalar_type() == at::kBFloat16 &&
       weight_opt.value().scalar_type() == at::kFloat) {
     return IPEXBatchNormOp::apply(
@@ -292,10 +292,8 @@ at::Tensor frozen_batch_norm(
     const at::Tensor& bias,
     const at::Tensor& running_mean,
     const at::Tensor& running_var) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::frozen_batch_norm", std::vector<c10::IValue>({}));
-#endif
   return IPEXBatchNormOp::apply(
       input, weight, bias, running_mean, running_var, false, 0, 0);
 }
@@ -0,0 +1,735 @@
+#include "BiasDropoutAddLayerNorm.h"
+#include "Dropout.h"
+#include <ATen/Parallel.h>
+#include <c10/util/accumulate.h>
+#include <torch/extension.h>
+#include "csrc/autocast/autocast_mode.h"
+#include "csrc/autocast/autocast_verbose.h"
+#include "csrc/utils/utils.h"
+#include "utils/float_vec.h"
+#include "csrc/utils/op_trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+// the rows are processed by 2 float vectors, i.e. a bfloat16 one, at a time
+constexpr int64_t kVecSize = kFloatVecPairSize;
+
+// the dropout scale, i.e. 1 / (1 - p) of the kept elements and 0 of the
+// dropped ones, of the kVecSize elements of the bit mask from the element i
+inline void load_mask(
+    const uint8_t* mask,
+    int64_t i,
+    float scale,
+    fVec& a,
+    fVec& b) {
+  float buf[kVecSize];
+  for (int64_t j = 0; j < kVecSize; j++) {
+    buf[j] = dropout_mask_bit(mask, i + j) ? scale : 0.f;
+  }
+  load_fvec(buf, a, b);
+}
+
+// Welford's online mean and m2 of a row. Each lane of the vectors is updated
+// by one element per step, so that all the lanes have the same count, and
+// they are merged with the tail by Chan's formula at the end.
+struct WelfordRow {
+  fVec mean_a = fVec(0.f);
+  fVec mean_b = fVec(0.f);
+  fVec m2_a = fVec(0.f);
+  fVec m2_b = fVec(0.f);
+  int64_t count = 0;
+  float mean_tail = 0.f;
+  float m2_tail = 0.f;
+  int64_t count_tail = 0;
+
+  void update(const fVec& a, const fVec& b) {
+    count++;
+    fVec count_inv = fVec(1.f / count);
+    fVec delta_a = a - mean_a;
+    fVec delta_b = b - mean_b;
+    mean_a = mean_a + delta_a * count_inv;
+    mean_b = mean_b + delta_b * count_inv;
+    m2_a = m2_a + delta_a * (a - mean_a);
+    m2_b = m2_b + delta_b * (b - mean_b);
+  }
+
+  void update(float x) {
+    count_tail++;
+    float delta = x - mean_tail;
+    mean_tail += delta / count_tail;
+    m2_tail += delta * (x - mean_tail);
+  }
+
+  // the mean and the biased variance of the row
+  std::pair<float, float> finalize() const {
+    float lane_mean[kVecSize];
+    float lane_m2[kVecSize];
+    store_fvec(lane_mean, mean_a, mean_b);
+    store_fvec(lane_m2, m2_a, m2_b);
+    float mean = 0.f;
+    float m2 = 0.f;
+    int64_t n = 0;
+    auto merge = [&](float mean_i, float m2_i, int64_t n_i) {
+      if (n_i == 0) {
+        return;
+      }
+      int64_t total = n + n_i;
+      float delta = mean_i - mean;
+      mean += delta * n_i / total;
+      m2 += m2_i + delta * delta * (static_cast<float>(n) * n_i / total);
+      n = total;
+    };
+    for (int64_t j = 0; j < kVecSize; j++) {
+      merge(lane_mean[j], lane_m2[j], count);
+    }
+    merge(mean_tail, m2_tail, count_tail);
+    return std::make_pair(mean, n > 0 ? m2 / n : 0.f);
+  }
+};
+
+// sum = residual + dropout(input + bias) and output = layer_norm(sum) of the
+// M rows of N elements. The sum is kept in registers for the stats and only
+// read again, from the cache, by the normalization of its row, so it may be the
+// output itself when it is not saved for the backward.
+template <typename scalar_t>
+void bias_dropout_add_layer_norm_kernel(
+    const at::Tensor& input,
+    const at::Tensor& bias,
+    const at::Tensor& residual,
+    const at::Tensor& mask,
+    float scale,
+    const at::Tensor& gamma,
+    const at::Tensor& beta,
+    at::Tensor& sum,
+    at::Tensor& output,
+    at::Tensor& mean,
+    at::Tensor& rstd,
+    int64_t M,
+    int64_t N,
+    double eps) {
+  const scalar_t* input_data = input.data_ptr<scalar_t>();
+  const float* bias_data = bias.defined() ? bias.data_ptr<float>() : nullptr;
+  const scalar_t* residual_data = residual.data_ptr<scalar_t>();
+  const uint8_t* mask_data =
+      mask.defined() ? mask.data_ptr<uint8_t>() : nullptr;
+  const float* gamma_data = gamma.data_ptr<float>();
+  const float* beta_data = beta.data_ptr<float>();
+  scalar_t* sum_data = sum.data_ptr<scalar_t>();
+  scalar_t* output_data = output.data_ptr<scalar_t>();
+  float* mean_data = mean.data_ptr<float>();
+  float* rstd_data = rstd.data_ptr<float>();
+  const int64_t vec_end = N - (N % kVecSize);
+  int64_t grain_size =
+      std::max<int64_t>(1, at::internal::GRAIN_SIZE / std::max<int64_t>(N, 1));
+  at::parallel_for(0, M, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      const scalar_t* x = input_data + i * N;
+      const scalar_t* r = residual_data + i * N;
+      const int64_t row = i * N;
+      scalar_t* s = sum_data + i * N;
+      scalar_t* y = output_data + i * N;
+      WelfordRow stats;
+      int64_t d = 0;
+      for (; d < vec_end; d += kVecSize) {
+        fVec a, b, tmp_a, tmp_b;
+        load_fvec(x + d, a, b);
+        if (bias_data) {
+          load_fvec(bias_data + d, tmp_a, tmp_b);
+          a = a + tmp_a;
+          b = b + tmp_b;
+        }
+        if (mask_data) {
+          load_mask(mask_data, row + d, scale, tmp_a, tmp_b);
+          a = a * tmp_a;
+          b = b * tmp_b;
+        }
+        load_fvec(r + d, tmp_a, tmp_b);
+        a = a + tmp_a;
+        b = b + tmp_b;
+        store_fvec(s + d, a, b);
+        stats.update(a, b);
+      }
+      for (; d < N; d++) {
+        float h = float(x[d]) + (bias_data ? bias_data[d] : 0.f);
+        if (mask_data) {
+          h *= dropout_mask_bit(mask_data, row + d) ? scale : 0.f;
+        }
+        h += float(r[d]);
+        s[d] = scalar_t(h);
+        stats.update(h);
+      }
+      float mean_val, var_val;
+      std::tie(mean_val, var_val) = stats.finalize();
+      float rstd_val = 1.f / std::sqrt(var_val + float(eps));
+
+      fVec mean_vec = fVec(mean_val);
+      fVec rstd_vec = fVec(rstd_val);
+      for (d = 0; d < vec_end; d += kVecSize) {
+        fVec a, b, gamma_a, gamma_b, beta_a, beta_b;
+        load_fvec(s + d, a, b);
+        load_fvec(gamma_data + d, gamma_a, gamma_b);
+        load_fvec(beta_data + d, beta_a, beta_b);
+        a = (a - mean_vec) * rstd_vec * gamma_a + beta_a;
+        b = (b - mean_vec) * rstd_vec * gamma_b + beta_b;
+        store_fvec(y + d, a, b);
+      }
+      for (; d < N; d++) {
+        y[d] = scalar_t(
+            (float(s[d]) - mean_val) * rstd_val * gamma_data[d] +
+            beta_data[d]);
+      }
+      mean_data[i] = mean_val;
+      rstd_data[i] = rstd_val;
+    }
+  });
+}
+
+// The grads of the sum, i.e. of the residual, and of the input, and the float
+// grads of gamma, beta and bias, of which the rows are reduced by the
+// {max_threads, 3, N} buffer. Per row, the first pass collects the two sums of
+// the layer_norm backward and the second one gives the grad of the sum and
+// applies the dropout mask to it.
+template <typename scalar_t>
+void bias_dropout_add_layer_norm_backward_kernel(
+    const at::Tensor& grad_output,
+    const at::Tensor& sum,
+    const at::Tensor& mask,
+    float scale,
+    const at::Tensor& gamma,
+    const at::Tensor& mean,
+    const at::Tensor& rstd,
+    at::Tensor& grad_sum,
+    at::Tensor& grad_input,
+    at::Tensor& grad_gamma,
+    at::Tensor& grad_beta,
+    at::Tensor& grad_bias,
+    int64_t M,
+    int64_t N) {
+  const scalar_t* grad_output_data = grad_output.data_ptr<scalar_t>();
+  const scalar_t* sum_data = sum.data_ptr<scalar_t>();
+  const uint8_t* mask_data =
+      mask.defined() ? mask.data_ptr<uint8_t>() : nullptr;
+  const float* gamma_data = gamma.data_ptr<float>();
+  const float* mean_data = mean.data_ptr<float>();
+  const float* rstd_data = rstd.data_ptr<float>();
+  scalar_t* grad_sum_data = grad_sum.data_ptr<scalar_t>();
+  scalar_t* grad_input_data =
+      mask_data ? grad_input.data_ptr<scalar_t>() : nullptr;
+  const int64_t vec_end = N - (N % kVecSize);
+  int num_threads = at::get_num_threads();
+  std::vector<float> buffer(num_threads * 3 * N, 0.f);
+  int64_t grain_size =
+      std::max<int64_t>(1, at::internal::GRAIN_SIZE / std::max<int64_t>(N, 1));
+  at::parallel_for(0, M, grain_size, [&](int64_t begin, int64_t end) {
+    int tid = at::get_thread_num();
+    TORCH_CHECK(
+        tid < num_threads,
+        "expect thread id smaller than ",
+        num_threads,
+        ", got thread id ",
+        tid);
+    float* dgamma = buffer.data() + tid * 3 * N;
+    float* dbeta = dgamma + N;
+    float* dbias = dbeta + N;
+    for (int64_t i = begin; i < end; i++) {
+      const scalar_t* dy = grad_output_data + i * N;
+      const scalar_t* s = sum_data + i * N;
+      const int64_t row = i * N;
+      scalar_t* ds = grad_sum_data + i * N;
+      scalar_t* dx = grad_input_data ? grad_input_data + i * N : nullptr;
+      float mean_val = mean_data[i];
+      float rstd_val = rstd_data[i];
+      fVec mean_vec = fVec(mean_val);
+      fVec rstd_vec = fVec(rstd_val);
+
+      // sum(dy * gamma) and sum(dy * gamma * x_hat)
+      fVec g_vec = fVec(0.f);
+      fVec gx_vec = fVec(0.f);
+      float g_val = 0.f;
+      float gx_val = 0.f;
+      int64_t d = 0;
+      for (; d < vec_end; d += kVecSize) {
+        fVec dy_a, dy_b, x_a, x_b, gamma_a, gamma_b, acc_a, acc_b;
+        load_fvec(dy + d, dy_a, dy_b);
+        load_fvec(s + d, x_a, x_b);
+        load_fvec(gamma_data + d, gamma_a, gamma_b);
+        x_a = (x_a - mean_vec) * rstd_vec;
+        x_b = (x_b - mean_vec) * rstd_vec;
+        g_vec = g_vec + dy_a * gamma_a + dy_b * gamma_b;
+        gx_vec = gx_vec + dy_a * gamma_a * x_a + dy_b * gamma_b * x_b;
+        load_fvec(dgamma + d, acc_a, acc_b);
+        store_fvec(dgamma + d, acc_a + dy_a * x_a, acc_b + dy_b * x_b);
+        load_fvec(dbeta + d, acc_a, acc_b);
+        store_fvec(dbeta + d, acc_a + dy_a, acc_b + dy_b);
+      }
+      for (; d < N; d++) {
+        float dy_val = float(dy[d]);
+        float x_hat = (float(s[d]) - mean_val) * rstd_val;
+        g_val += dy_val * gamma_data[d];
+        gx_val += dy_val * gamma_data[d] * x_hat;
+        dgamma[d] += dy_val * x_hat;
+        dbeta[d] += dy_val;
+      }
+      float g_mean = (g_val + sum_fvec(g_vec)) / N;
+      float gx_mean = (gx_val + sum_fvec(gx_vec)) / N;
+
+      // ds = rstd * (dy * gamma - mean(dy * gamma) - x_hat * mean(dy * gamma
+      // * x_hat)), and dx = ds * mask * scale
+      fVec g_mean_vec = fVec(g_mean);
+      fVec gx_mean_vec = fVec(gx_mean);
+      for (d = 0; d < vec_end; d += kVecSize) {
+        fVec dy_a, dy_b, x_a, x_b, gamma_a, gamma_b, tmp_a, tmp_b;
+        load_fvec(dy + d, dy_a, dy_b);
+        load_fvec(s + d, x_a, x_b);
+        load_fvec(gamma_data + d, gamma_a, gamma_b);
+        x_a = (x_a - mean_vec) * rstd_vec;
+        x_b = (x_b - mean_vec) * rstd_vec;
+        fVec ds_a =
+            rstd_vec * (dy_a * gamma_a - g_mean_vec - x_a * gx_mean_vec);
+        fVec ds_b =
+            rstd_vec * (dy_b * gamma_b - g_mean_vec - x_b * gx_mean_vec);
+        store_fvec(ds + d, ds_a, ds_b);
+        if (mask_data) {
+          load_mask(mask_data, row + d, scale, tmp_a, tmp_b);
+          ds_a = ds_a * tmp_a;
+          ds_b = ds_b * tmp_b;
+          store_fvec(dx + d, ds_a, ds_b);
+        }
+        load_fvec(dbias + d, tmp_a, tmp_b);
+        store_fvec(dbias + d, tmp_a + ds_a, tmp_b + ds_b);
+      }
+      for (; d < N; d++) {
+        float x_hat = (float(s[d]) - mean_val) * rstd_val;
+        float ds_val = rstd_val *
+            (float(dy[d]) * gamma_data[d] - g_mean - x_hat * gx_mean);
+        ds[d] = scalar_t(ds_val);
+        if (mask_data) {
+          ds_val *= dropout_mask_bit(mask_data, row + d) ? scale : 0.f;
+          dx[d] = scalar_t(ds_val);
+        }
+        dbias[d] += ds_val;
+      }
+    }
+  });
+
+  float* grad_gamma_data = grad_gamma.data_ptr<float>();
+  float* grad_beta_data = grad_beta.data_ptr<float>();
+  float* grad_bias_data = grad_bias.data_ptr<float>();
+  at::parallel_for(0, N, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t d = begin; d < end; d++) {
+      float dgamma = 0.f;
+      float dbeta = 0.f;
+      float dbias = 0.f;
+      for (int tid = 0; tid < num_threads; tid++) {
+        const float* acc = buffer.data() + tid * 3 * N;
+        dgamma += acc[d];
+        dbeta += acc[N + d];
+        dbias += acc[2 * N + d];
+      }
+      grad_gamma_data[d] = dgamma;
+      grad_beta_data[d] = dbeta;
+      grad_bias_data[d] = dbias;
+    }
+  });
+}
+
+// the number of rows and the row size of the layer_norm
+std::pair<int64_t, int64_t> check_bias_dropout_add_layer_norm_inputs(
+    const at::Tensor& input,
+    const c10::optional<at::Tensor>& bias_opt,
+    const at::Tensor& residual,
+    at::IntArrayRef normalized_shape,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& ln_bias_opt) {
+  const int64_t normalized_ndim = normalized_shape.size();
+  TORCH_CHECK(
+      normalized_ndim >= 1 && input.dim() >= normalized_ndim &&
+          input.sizes().slice(input.dim() - normalized_ndim) ==
+              normalized_shape,
+      "bias_dropout_add_layer_norm: expected input with shape [*, ",
+      normalized_shape,
+      "], but got ",
+      input.sizes());
+  TORCH_CHECK(
+      residual.sizes() == input.sizes() &&
+          residual.scalar_type() == input.scalar_type(),
+      "bias_dropout_add_layer_norm: expected residual of the shape and the "
+      "dtype of input");
+  const int64_t N = c10::multiply_integers(normalized_shape);
+  TORCH_CHECK(
+      !bias_opt.has_value() || !bias_opt.value().defined() ||
+          bias_opt.value().numel() == N,
+      "bias_dropout_add_layer_norm: expected bias of ",
+      N,
+      " elements");
+  for (const auto& param : {weight_opt, ln_bias_opt}) {
+    TORCH_CHECK(
+        !param.has_value() || !param.value().defined() ||
+            param.value().sizes() == normalized_shape,
+        "bias_dropout_add_layer_norm: expected weight and ln_bias of shape ",
+        normalized_shape);
+  }
+  return std::make_pair(N == 0 ? 0 : input.numel() / N, N);
+}
+
+at::Tensor float_param(
+    const c10::optional<at::Tensor>& param,
+    int64_t N,
+    float value) {
+  if (param.has_value() && param.value().defined()) {
+    return param.value().to(at::kFloat).contiguous();
+  }
+  return at::full({N}, value, at::TensorOptions().dtype(at::kFloat));
+}
+
+at::Tensor dropout_mask(
+    const at::Tensor& input,
+    double p,
+    bool train,
+    float& scale) {
+  scale = 1.f;
+  if (!train || p == 0) {
+    return at::Tensor();
+  }
+  TORCH_CHECK(
+      p > 0 && p <= 1,
+      "bias_dropout_add_layer_norm: dropout probability has to be between 0 "
+      "and 1, but got ",
+      p);
+  scale = p < 1 ? 1.f / (1.f - float(p)) : 0.f;
+  return generate_dropout_mask(input.numel(), p, dropout_seed());
+}
+
+// the kernels of the float and the bfloat16 inputs, with float params
+#define BIAS_DROPOUT_ADD_LAYER_NORM_DISPATCH(TYPE, ...) \
+  [&] {                                                  \
+    if ((TYPE) == at::kBFloat16) {                       \
+      using scalar_t = at::BFloat16;                     \
+      __VA_ARGS__();                                     \
+    } else {                                             \
+      using scalar_t = float;                            \
+      __VA_ARGS__();                                     \
+    }                                                    \
+  }()
+
+bool is_fused_dtype(const at::Tensor& input) {
+  return input.scalar_type() == at::kFloat ||
+      input.scalar_type() == at::kBFloat16;
+}
+
+// the reference of the other dtypes
+at::Tensor bias_dropout_add_layer_norm_composite(
+    const at::Tensor& input,
+    const c10::optional<at::Tensor>& bias_opt,
+    const at::Tensor& residual,
+    double p,
+    bool train,
+    at::IntArrayRef normalized_shape,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& ln_bias_opt,
+    double eps) {
+  auto x = bias_opt.has_value() && bias_opt.value().defined()
+      ? input + bias_opt.value()
+      : input;
+  return at::layer_norm(
+      at::dropout(x, p, train) + residual,
+      normalized_shape,
+      weight_opt,
+      ln_bias_opt,
+      eps);
+}
+
+} // namespace
+
+at::Tensor IPEXBiasDropoutAddLayerNormOp::_forward(
+    const at::Tensor& input,
+    const c10::optional<at::Tensor>& bias_opt,
+    const at::Tensor& residual,
+    double p,
+    bool train,
+    at::IntArrayRef normalized_shape,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& ln_bias_opt,
+    double eps) {
+  IPEX_RECORD_FUNCTION(
+      "IPEXBiasDropoutAddLayerNormOp::_forward",
+      std::vector<c10::IValue>({}));
+  int64_t M, N;
+  std::tie(M, N) = check_bias_dropout_add_layer_norm_inputs(
+      input, bias_opt, residual, normalized_shape, weight_opt, ln_bias_opt);
+  auto input_ = input.contiguous();
+  auto residual_ = residual.contiguous();
+  auto bias = bias_opt.has_value() && bias_opt.value().defined()
+      ? bias_opt.value().to(at::kFloat).contiguous()
+      : at::Tensor();
+  float scale;
+  auto mask = dropout_mask(input_, p, train, scale);
+  auto output = at::empty_like(input_);
+  auto mean = at::empty({M}, input_.options().dtype(at::kFloat));
+  auto rstd = at::empty({M}, input_.options().dtype(at::kFloat));
+  BIAS_DROPOUT_ADD_LAYER_NORM_DISPATCH(input_.scalar_type(), [&] {
+    // the sum is normalized in place, as it is not saved
+    bias_dropout_add_layer_norm_kernel<scalar_t>(
+        input_,
+        bias,
+        residual_,
+        mask,
+        scale,
+        float_param(weight_opt, N, 1.f),
+        float_param(ln_bias_opt, N, 0.f),
+        output,
+        output,
+        mean,
+        rstd,
+        M,
+        N,
+        eps);
+  });
+  return output;
+}
+
+at::Tensor IPEXBiasDropoutAddLayerNormOp::forward(
+    torch::autograd::AutogradContext* ctx,
+    const at::Tensor& input,
+    const c10::optional<at::Tensor>& bias_opt,
+    const at::Tensor& residual,
+    double p,
+    bool train,
+    at::IntArrayRef normalized_shape,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& ln_bias_opt,
+    double eps) {
+  IPEX_RECORD_FUNCTION(
+      "IPEXBiasDropoutAddLayerNormOp::forward", std::vector<c10::IValue>({}));
+  int64_t M, N;
+  std::tie(M, N) = check_bias_dropout_add_layer_norm_inputs(
+      input, bias_opt, residual, normalized_shape, weight_opt, ln_bias_opt);
+  bool has_bias = bias_opt.has_value() && bias_opt.value().defined();
+  bool has_weight = weight_opt.has_value() && weight_opt.value().defined();
+  bool has_ln_bias = ln_bias_opt.has_value() && ln_bias_opt.value().defined();
+  ctx->saved_data["bias_dtype"] =
+      has_bias ? bias_opt.value().scalar_type() : at::kFloat;
+  ctx->saved_data["weight_dtype"] =
+      has_weight ? weight_opt.value().scalar_type() : at::kFloat;
+  ctx->saved_data["ln_bias_dtype"] =
+      has_ln_bias ? ln_bias_opt.value().scalar_type() : at::kFloat;
+  ctx->saved_data["normalized_shape"] = normalized_shape;
+  ctx->saved_data["bias_shape"] =
+      has_bias ? bias_opt.value().sizes() : normalized_shape;
+  ctx->saved_data["has_bias"] = has_bias;
+  ctx->saved_data["has_weight"] = has_weight;
+  ctx->saved_data["has_ln_bias"] = has_ln_bias;
+
+  auto input_ = input.contiguous();
+  auto residual_ = residual.contiguous();
+  auto bias =
+      has_bias ? bias_opt.value().to(at::kFloat).contiguous() : at::Tensor();
+  auto gamma = float_param(weight_opt, N, 1.f);
+  float scale;
+  auto mask = dropout_mask(input_, p, train, scale);
+  ctx->saved_data["scale"] = static_cast<double>(scale);
+  auto sum = at::empty_like(input_);
+  auto output = at::empty_like(input_);
+  auto mean = at::empty({M}, input_.options().dtype(at::kFloat));
+  auto rstd = at::empty({M}, input_.options().dtype(at::kFloat));
+  BIAS_DROPOUT_ADD_LAYER_NORM_DISPATCH(input_.scalar_type(), [&] {
+    bias_dropout_add_layer_norm_kernel<scalar_t>(
+        input_,
+        bias,
+        residual_,
+        mask,
+        scale,
+        gamma,
+        float_param(ln_bias_opt, N, 0.f),
+        sum,
+        output,
+        mean,
+        rstd,
+        M,
+        N,
+        eps);
+  });
+  // the normalized output is not saved, the backward recomputes it from sum
+  ctx->save_for_backward({sum, mask, gamma, mean, rstd});
+  return output;
+}
+
+torch::autograd::variable_list IPEXBiasDropoutAddLayerNormOp::backward(
+    torch::autograd::AutogradContext* ctx,
+    torch::autograd::variable_list grad_outputs) {
+  IPEX_RECORD_FUNCTION(
+      "IPEXBiasDropoutAddLayerNormOp::backward",
+      std::vector<c10::IValue>({}));
+  auto saved = ctx->get_saved_variables();
+  at::Tensor sum = saved[0];
+  at::Tensor mask = saved[1];
+  at::Tensor gamma = saved[2];
+  at::Tensor mean = saved[3];
+  at::Tensor rstd = saved[4];
+  float scale = static_cast<float>(ctx->saved_data["scale"].toDouble());
+  int64_t N = gamma.numel();
+  int64_t M = mean.numel();
+
+  auto grad_output = grad_outputs[0].to(sum.scalar_type()).contiguous();
+  auto grad_sum = at::empty_like(sum);
+  // without dropout, the grad of the input is the one of the residual
+  auto grad_input = mask.defined() ? at::empty_like(sum) : grad_sum;
+  auto float_options = gamma.options();
+  auto grad_gamma = at::empty({N}, float_options);
+  auto grad_beta = at::empty({N}, float_options);
+  auto grad_bias = at::empty({N}, float_options);
+  BIAS_DROPOUT_ADD_LAYER_NORM_DISPATCH(sum.scalar_type(), [&] {
+    bias_dropout_add_layer_norm_backward_kernel<scalar_t>(
+        grad_output,
+        sum,
+        mask,
+        scale,
+        gamma,
+        mean,
+        rstd,
+        grad_sum,
+        grad_input,
+        grad_gamma,
+        grad_beta,
+        grad_bias,
+        M,
+        N);
+  });
+
+  auto param_grad = [&](const at::Tensor& grad,
+                        const char* has_param,
+                        const char* dtype,
+                        const char* shape) {
+    if (!ctx->saved_data[has_param].toBool()) {
+      return at::Tensor();
+    }
+    return grad.to(ctx->saved_data[dtype].toScalarType())
+        .view(ctx->saved_data[shape].toIntVector());
+  };
+  return {
+      grad_input,
+      param_grad(grad_bias, "has_bias", "bias_dtype", "bias_shape"),
+      grad_sum,
+      at::Tensor(),
+      at::Tensor(),
+      at::Tensor(),
+      param_grad(
+          grad_gamma, "has_weight", "weight_dtype", "normalized_shape"),
+      param_grad(
+          grad_beta, "has_ln_bias", "ln_bias_dtype", "normalized_shape"),
+      at::Tensor()};
+}
+
+at::Tensor bias_dropout_add_layer_norm(
+    const at::Tensor& input,
+    const c10::optional<at::Tensor>& bias_opt,
+    const at::Tensor& residual,
+    double p,
+    bool train,
+    at::IntArrayRef normalized_shape,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& ln_bias_opt,
+    double eps) {
+  if (!is_fused_dtype(input)) {
+    return bias_dropout_add_layer_norm_composite(
+        input,
+        bias_opt,
+        residual,
+        p,
+        train,
+        normalized_shape,
+        weight_opt,
+        ln_bias_opt,
+        eps);
+  }
+  if (at::GradMode::is_enabled()) {
+    return IPEXBiasDropoutAddLayerNormOp::apply(
+        input,
+        bias_opt,
+        residual,
+        p,
+        train,
+        normalized_shape,
+        weight_opt,
+        ln_bias_opt,
+        eps);
+  }
+  return IPEXBiasDropoutAddLayerNormOp::_forward(
+      input,
+      bias_opt,
+      residual,
+      p,
+      train,
+      normalized_shape,
+      weight_opt,
+      ln_bias_opt,
+      eps);
+}
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "bias_dropout_add_layer_norm(Tensor input, Tensor? bias, Tensor "
+      "residual, float p, bool train, int[] normalized_shape, Tensor? weight, "
+      "Tensor? ln_bias, float eps) -> Tensor",
+      torch_ipex::cpu::bias_dropout_add_layer_norm);
+}
+
+} // namespace
+
+namespace torch_ipex {
+namespace autocast {
+
+at::Tensor bias_dropout_add_layer_norm(
+    const at::Tensor& input,
+    const c10::optional<at::Tensor>& bias_opt,
+    const at::Tensor& residual,
+    double p,
+    bool train,
+    at::IntArrayRef normalized_shape,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& ln_bias_opt,
+    double eps) {
+  c10::impl::ExcludeDispatchKeyGuard no_autocastCPU(DispatchKey::AutocastCPU);
+  static auto op =
+      torch::Dispatcher::singleton()
+          .findSchemaOrThrow("torch_ipex::bias_dropout_add_layer_norm", "")
+          .typed<decltype(bias_dropout_add_layer_norm)>();
+#if defined(ENABLE_AUTOCAST_VERBOSE)
+  verbose::OpNameGuard op_name("bias_dropout_add_layer_norm");
+#endif
+  auto target_type = get_autocast_dtype();
+
+  // the layer_norm params and stats are kept in float
+  return op.call(
+      cpu_cached_cast(target_type, input),
+      cpu_cached_cast(target_type, bias_opt),
+      cpu_cached_cast(target_type, residual),
+      p,
+      train,
+      normalized_shape,
+      weight_opt,
+      ln_bias_opt,
+      eps);
+}
+
+TORCH_LIBRARY_IMPL(torch_ipex, AutocastCPU, m) {
+  m.impl(
+      "bias_dropout_add_layer_norm",
+      torch_ipex::autocast::bias_dropout_add_layer_norm);
+}
+
+} // namespace autocast
+} // namespace torch_ipex
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+#include <torch/csrc/autograd/custom_function.h>
+
+namespace torch_ipex {
+namespace cpu {
+
+// layer_norm(residual + dropout(input + bias)) of the transformer blocks, e.g.
+// the output projections of the attention and of the FFN of BERT, in a single
+// read of the input and the residual. The stats of each row are collected by
+// Welford in the same pass as the bias, the dropout and the residual add, and
+// only the sum, the 1 bit per element dropout mask of generate_dropout_mask,
+// and the mean and rstd of the rows are saved for the backward, which gives
+// all the grads in two passes over each row.
+at::Tensor bias_dropout_add_layer_norm(
+    const at::Tensor& input,
+    const c10::optional<at::Tensor>& bias_opt,
+    const at::Tensor& residual,
+    double p,
+    bool train,
+    at::IntArrayRef normalized_shape,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& ln_bias_opt,
+    double eps);
+
+class IPEXBiasDropoutAddLayerNormOp
+    : public torch::autograd::Function<IPEXBiasDropoutAddLayerNormOp> {
+ public:
+  // forward function without autograd overhead, will go this way when only do
+  // forward
+  static at::Tensor _forward(
+      const at::Tensor& input,
+      const c10::optional<at::Tensor>& bias_opt,
+      const at::Tensor& residual,
+      double p,
+      bool train,
+      at::IntArrayRef normalized_shape,
+      const c10::optional<at::Tensor>& weight_opt,
+      const c10::optional<at::Tensor>& ln_bias_opt,
+      double eps);
+
+  static at::Tensor forward(
+      torch::autograd::AutogradContext* ctx,
+      const at::Tensor& input,
+      const c10::optional<at::Tensor>& bias_opt,
+      const at::Tensor& residual,
+      double p,
+      bool train,
+      at::IntArrayRef normalized_shape,
+      const c10::optional<at::Tensor>& weight_opt,
+      const c10::optional<at::Tensor>& ln_bias_opt,
+      double eps);
+
+  static torch::autograd::variable_list backward(
+      torch::autograd::AutogradContext* ctx,
+      torch::autograd::variable_list grad_outputs);
+};
+
+} // namespace cpu
+} // namespace torch_ipex
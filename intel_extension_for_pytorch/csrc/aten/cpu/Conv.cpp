@@ -1,9 +1,11 @@
 #include "Conv.h"
 #include <torch/extension.h>
+#include "ConvBackwardWeights.h"
 #include "WeightPack.h"
 #include "csrc/autocast/autocast_mode.h"
 #include "csrc/autocast/autocast_verbose.h"
 #include "csrc/cpu/ideep/IDeepConversions.h"
+#include "csrc/utils/op_trace.h"
 #include "csrc/utils/utils.h"
 
 namespace torch_ipex {
@@ -36,7 +38,8 @@ void convolution_kernel_output(
     at::IntArrayRef padding,
     at::IntArrayRef dilation,
     int64_t groups,
-    const ideep::attr_t& attr) {
+    const ideep::attr_t& attr,
+    ideep::algorithm aalgorithm) {
   // Convolution output kernel, assuming the output always has same format with
   // input, so this function will not change input and output's format, making
   // sure you has made pre-process for input and output to make them have same
@@ -75,7 +78,8 @@ void convolution_kernel_output(
         ideep::scale_t(),
         ideep::scale_t(),
         ideep::scale_t(),
-        attr);
+        attr,
+        aalgorithm);
   } else {
     ideep::convolution_forward::compute(
         mkldnn_input,
@@ -90,7 +94,8 @@ void convolution_kernel_output(
         ideep::scale_t(),
         ideep::scale_t(),
         ideep::scale_t(),
-        attr);
+        attr,
+        aalgorithm);
   }
 }
 
@@ -226,10 +231,9 @@ at::Tensor convolution_forward_impl(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::convolution_forward_impl\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::convolution_forward_impl", std::vector<c10::IValue>({}));
-#endif
+  IPEX_TRACE_OP_INPUTS(input, weight);
   TORCH_CHECK(
       weight.scalar_type() == input.scalar_type(),
       "the input and weight need have same data type");
@@ -295,11 +299,9 @@ void convolution_forward_inplace_impl(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::convolution_forward\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::convolution_forward_inplace_impl",
       std::vector<c10::IValue>({}));
-#endif
   TORCH_CHECK(
       weight.scalar_type() == input.scalar_type(),
       "the input and weight need have same data type");
@@ -436,8 +438,6 @@ std::tuple<at::Tensor, at::Tensor> convolution_backward_weights(
     bool bias_defined,
     bool weight_use_channels_last,
     bool weight_packed) {
-  const ideep::tensor mkldnn_grad_output = itensor_view_from_dense(grad_output);
-  const ideep::tensor mkldnn_input = itensor_view_from_dense(input);
   bool is_channels_last =
       grad_output.suggest_memory_format() == at::MemoryFormat::ChannelsLast;
 
@@ -449,6 +449,45 @@ std::tuple<at::Tensor, at::Tensor> convolution_backward_weights(
   for (auto& k : kernel_size) {
     real_weight_size.push_back(k);
   }
+
+  // the pointwise convolutions of few pixels and many channels, of which the
+  // weight gradient is a GEMM reduced over the pixels by the threads; the
+  // gradient of the packed weight is reordered from the plain one
+  if (is_conv1x1_backward_weights(
+          grad_output, input, padding, stride, kernel_size, groups)) {
+    IPEX_TRACE_OP_KERNEL("conv1x1_backward_weights");
+    // the plain weight of a 1x1 kernel is of the same layout in both memory
+    // formats
+    auto plain_grad_weight = at::empty(
+        real_weight_size,
+        grad_output.options().memory_format(
+            grad_output.suggest_memory_format()));
+    if (bias_defined) {
+      grad_bias = at::empty({grad_output.size(1)}, grad_output.options());
+    }
+    conv1x1_backward_weights_kernel_stub(
+        grad_output, input, plain_grad_weight, grad_bias);
+    if (!weight_packed) {
+      return std::make_tuple(plain_grad_weight, grad_bias);
+    }
+    mkldnn_grad_weight = get_conv_packed_weight(
+        grad_weight,
+        stride,
+        padding,
+        dilation,
+        real_weight_size,
+        groups,
+        weight_use_channels_last,
+        weight_packed,
+        weight_use_channels_last,
+        {},
+        ideep::attr_t());
+    mkldnn_grad_weight.feed_from(itensor_view_from_dense(plain_grad_weight));
+    return std::make_tuple(grad_weight, grad_bias);
+  }
+
+  const ideep::tensor mkldnn_grad_output = itensor_view_from_dense(grad_output);
+  const ideep::tensor mkldnn_input = itensor_view_from_dense(input);
   if (weight_packed) {
     // weight has be packed, mkldnn_grad_weight share buffer with
     // grad_weight;
@@ -531,10 +570,8 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> convolution_backward(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::convolution_backward\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::convolution_backward", std::vector<c10::IValue>({}));
-#endif
   TORCH_CHECK(
       weight.scalar_type() == input.scalar_type() &&
           weight.scalar_type() == grad_output_t.scalar_type(),
@@ -601,9 +638,8 @@ at::Tensor IPEXConvolutionOp::_forward(
     int64_t output_channel,
     bool weight_channels_last,
     bool weight_packed) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("IPEXConvolutionOp::_forward", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION(
+      "IPEXConvolutionOp::_forward", std::vector<c10::IValue>({}));
   return convolution_forward_impl(
       input,
       weight,
@@ -632,9 +668,8 @@ at::Tensor IPEXConvolutionOp::forward(
     int64_t output_channel,
     bool weight_channels_last,
     bool weight_packed) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("IPEXConvolutionOp::forward", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION(
+      "IPEXConvolutionOp::forward", std::vector<c10::IValue>({}));
   ctx->saved_data["stride"] = stride;
   ctx->saved_data["padding"] = padding;
   ctx->saved_data["dilation"] = dilation;
@@ -666,9 +701,8 @@ at::Tensor IPEXConvolutionOp::forward(
 torch::autograd::variable_list IPEXConvolutionOp::backward(
     torch::autograd::AutogradContext* ctx,
     torch::autograd::variable_list grad_outputs) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("IPEXConvolutionOp::backward", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION(
+      "IPEXConvolutionOp::backward", std::vector<c10::IValue>({}));
   auto stride = ctx->saved_data["stride"].toIntVector();
   auto padding = ctx->saved_data["padding"].toIntVector();
   auto dilation = ctx->saved_data["dilation"].toIntVector();
@@ -788,7 +822,7 @@ at::Tensor convolution_forward(
 #if defined(ENABLE_AUTOCAST_VERBOSE)
   verbose::OpNameGuard op_name("convolution_forward");
 #endif
-  auto target_type = get_autocast_dtype();
+  auto target_type = get_lower_precision_dtype("convolution_forward");
 
   // TODO: make check weight dtype should be float for training case.
   return op.call(
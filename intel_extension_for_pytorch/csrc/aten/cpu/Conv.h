@@ -17,7 +17,8 @@ void convolution_kernel_output(
     at::IntArrayRef padding,
     at::IntArrayRef dilation,
     int64_t groups,
-    const ideep::attr_t& attr);
+    const ideep::attr_t& attr,
+    ideep::algorithm aalgorithm = ideep::algorithm::convolution_direct);
 
 at::Tensor convolution_kernel(
     const at::Tensor& input,
@@ -86,6 +87,19 @@ void convolution_forward_inplace_impl(
     bool weight_prepacked,
     const ideep::attr_t& attr);
 
+std::tuple<at::Tensor, at::Tensor, at::Tensor> convolution_backward(
+    const at::Tensor& input,
+    const at::Tensor& grad_output_t,
+    const at::Tensor& weight,
+    at::IntArrayRef padding,
+    at::IntArrayRef stride,
+    at::IntArrayRef dilation,
+    at::IntArrayRef kernel_size,
+    int64_t groups,
+    std::array<bool, 3> output_mask,
+    bool weight_channels_last,
+    bool weight_packed);
+
 // IPEX customized convolution OP with n-D packed weight
 class IPEXConvolutionOp : public torch::autograd::Function<IPEXConvolutionOp> {
  public:
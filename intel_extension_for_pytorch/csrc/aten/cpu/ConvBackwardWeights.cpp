@@ -0,0 +1,62 @@
+#include "ConvBackwardWeights.h"
+
+#include "csrc/utils/fast_path_stats.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+IPEX_DEFINE_DISPATCH(conv1x1_backward_weights_kernel_stub);
+
+enum Conv1x1BackwardFallback {
+  kUnsupportedDtype,
+  kNotPointwise,
+  kNotChannelsLast,
+  kLargeSpatial,
+  kSmallChannels,
+};
+
+static fast_path::FastPathCounter conv1x1_backward_counter(
+    "conv1x1_backward_weights",
+    {"unsupported_dtype",
+     "not_pointwise",
+     "not_channels_last",
+     "large_spatial",
+     "small_channels"});
+
+bool is_conv1x1_backward_weights(
+    const at::Tensor& grad_output,
+    const at::Tensor& input,
+    at::IntArrayRef padding,
+    at::IntArrayRef stride,
+    at::IntArrayRef kernel_size,
+    int64_t groups) {
+  auto dtype = input.scalar_type();
+  if ((dtype != at::kFloat && dtype != at::kBFloat16) ||
+      grad_output.scalar_type() != dtype) {
+    return conv1x1_backward_counter.fallback(kUnsupportedDtype);
+  }
+  // kernel_size is the spatial dims of the weight, i.e. [kh, kw]
+  bool pointwise = input.dim() == 4 && grad_output.dim() == 4 &&
+      kernel_size.size() == 2 && groups == 1;
+  for (size_t d = 0; pointwise && d < kernel_size.size(); d++) {
+    pointwise = kernel_size[d] == 1 && stride[d] == 1 && padding[d] == 0;
+  }
+  if (!pointwise) {
+    return conv1x1_backward_counter.fallback(kNotPointwise);
+  }
+  if (!input.is_contiguous(at::MemoryFormat::ChannelsLast) ||
+      !grad_output.is_contiguous(at::MemoryFormat::ChannelsLast)) {
+    return conv1x1_backward_counter.fallback(kNotChannelsLast);
+  }
+  if (input.size(2) * input.size(3) > kConv1x1BackwardMaxSpatial) {
+    return conv1x1_backward_counter.fallback(kLargeSpatial);
+  }
+  if (input.size(1) < kConv1x1BackwardMinChannels ||
+      grad_output.size(1) < kConv1x1BackwardMinChannels) {
+    return conv1x1_backward_counter.fallback(kSmallChannels);
+  }
+  return conv1x1_backward_counter.hit();
+}
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+#include "csrc/cpu/dispatch/DispatchStub.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+// The largest spatial size, H x W, of the pointwise convolutions of which the
+// weight gradient runs on the GEMM of the threads of IPEX, e.g. of the 14x14
+// and the 7x7 stages of ResNet, where the reduction over the few pixels of
+// the large channels scales poorly in the oneDNN primitive
+constexpr int64_t kConv1x1BackwardMaxSpatial = 196;
+constexpr int64_t kConv1x1BackwardMinChannels = 64;
+
+// Whether the weight gradient of the 2d convolution runs on the pointwise
+// kernel: a 1x1 kernel of stride 1, no padding and 1 group, the float or
+// bfloat16 grad_output and input of the channels last format, the spatial
+// size at most kConv1x1BackwardMaxSpatial and the channels at least
+// kConv1x1BackwardMinChannels.
+bool is_conv1x1_backward_weights(
+    const at::Tensor& grad_output,
+    const at::Tensor& input,
+    at::IntArrayRef padding,
+    at::IntArrayRef stride,
+    at::IntArrayRef kernel_size,
+    int64_t groups);
+
+// grad_weight [OC, IC] = grad_output^T x input and grad_bias [OC], if
+// defined, the sum of grad_output over the pixels, of which the pixels are
+// split over the threads if the tiles of grad_weight are too few to occupy
+// them; the partial sums of the threads are reduced by a tree in float, the
+// last level of which writes grad_weight and grad_bias of the dtype of the
+// inputs
+using conv1x1_backward_weights_kernel_fn = void (*)(
+    const at::Tensor& grad_output,
+    const at::Tensor& input,
+    at::Tensor& grad_weight,
+    at::Tensor& grad_bias);
+IPEX_DECLARE_DISPATCH(
+    conv1x1_backward_weights_kernel_fn,
+    conv1x1_backward_weights_kernel_stub);
+
+} // namespace cpu
+} // namespace torch_ipex
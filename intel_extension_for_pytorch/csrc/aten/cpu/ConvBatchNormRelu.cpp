@@ -0,0 +1,645 @@
+#include "ConvBatchNormRelu.h"
+#include <ATen/Parallel.h>
+#include <torch/extension.h>
+#include "Conv.h"
+#include "csrc/autocast/autocast_mode.h"
+#include "csrc/autocast/autocast_verbose.h"
+#include "csrc/utils/op_trace.h"
+#include "csrc/utils/utils.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+// The layout of the conv output, of n_batch x n_channel x image_size
+// elements, in either the contiguous or the channels last memory format.
+struct ChannelLayout {
+  int64_t n_batch;
+  int64_t n_channel;
+  int64_t image_size;
+  bool channels_last;
+
+  explicit ChannelLayout(const at::Tensor& t)
+      : n_batch(t.size(0)),
+        n_channel(t.size(1)),
+        image_size(t.numel() / t.size(0) / t.size(1)),
+        channels_last(
+            t.suggest_memory_format() == at::MemoryFormat::ChannelsLast) {}
+
+  int64_t per_channel() const {
+    return n_batch * image_size;
+  }
+};
+
+// Reduces f(offset, c, sum0[c], sum1[c]) over the elements of each channel
+// in a single pass over the tensor of layout.
+template <typename F>
+void reduce_per_channel(
+    const ChannelLayout& layout,
+    std::vector<double>& sum0,
+    std::vector<double>& sum1,
+    const F& f) {
+  auto n_channel = layout.n_channel;
+  sum0.assign(n_channel, 0);
+  sum1.assign(n_channel, 0);
+  if (!layout.channels_last) {
+    // parallel dim reduce on 'channel'
+    at::parallel_for(0, n_channel, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t c = begin; c < end; c++) {
+        double acc0 = 0, acc1 = 0;
+        for (int64_t n = 0; n < layout.n_batch; n++) {
+          auto offset = (n * n_channel + c) * layout.image_size;
+          for (int64_t i = 0; i < layout.image_size; i++) {
+            f(offset + i, c, acc0, acc1);
+          }
+        }
+        sum0[c] = acc0;
+        sum1[c] = acc1;
+      }
+    });
+    return;
+  }
+  // {NHW, C} => {max_threads, C} => {C}, as the channels last batch norm
+  int num_threads = at::get_num_threads();
+  std::vector<double> buffer(num_threads * 2 * n_channel, 0);
+  at::parallel_for(
+      0, layout.per_channel(), 1, [&](int64_t begin, int64_t end) {
+        int tid = at::get_thread_num();
+        TORCH_CHECK(
+            tid < num_threads,
+            "expect thread id smaller than ",
+            num_threads,
+            ", got thread id ",
+            tid);
+        auto acc0 = buffer.data() + tid * 2 * n_channel;
+        auto acc1 = acc0 + n_channel;
+        for (int64_t i = begin; i < end; i++) {
+          for (int64_t c = 0; c < n_channel; c++) {
+            f(i * n_channel + c, c, acc0[c], acc1[c]);
+          }
+        }
+      });
+  for (int tid = 0; tid < num_threads; tid++) {
+    auto acc0 = buffer.data() + tid * 2 * n_channel;
+    auto acc1 = acc0 + n_channel;
+    for (int64_t c = 0; c < n_channel; c++) {
+      sum0[c] += acc0[c];
+      sum1[c] += acc1[c];
+    }
+  }
+}
+
+// Calls f(offset, c) for each element of the tensor of layout.
+template <typename F>
+void map_per_channel(const ChannelLayout& layout, const F& f) {
+  auto n_channel = layout.n_channel;
+  if (!layout.channels_last) {
+    at::parallel_for(
+        0, layout.n_batch * n_channel, 1, [&](int64_t begin, int64_t end) {
+          for (int64_t plane = begin; plane < end; plane++) {
+            auto c = plane % n_channel;
+            auto offset = plane * layout.image_size;
+            for (int64_t i = 0; i < layout.image_size; i++) {
+              f(offset + i, c);
+            }
+          }
+        });
+    return;
+  }
+  at::parallel_for(
+      0, layout.per_channel(), 1, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+          for (int64_t c = 0; c < n_channel; c++) {
+            f(i * n_channel + c, c);
+          }
+        }
+      });
+}
+
+// The per channel scale and shift of the normalization, output = relu(y *
+// alpha + beta).
+void collect_linear_and_constant_terms(
+    std::vector<float>& alpha,
+    std::vector<float>& beta,
+    const at::Tensor& bn_weight,
+    const at::Tensor& bn_bias,
+    const at::Tensor& mean,
+    const at::Tensor& invstd) {
+  auto n_channel = mean.numel();
+  auto weight_data = bn_weight.data_ptr<float>();
+  auto bias_data = bn_bias.data_ptr<float>();
+  auto mean_data = mean.data_ptr<float>();
+  auto invstd_data = invstd.data_ptr<float>();
+  alpha.resize(n_channel);
+  beta.resize(n_channel);
+  for (int64_t c = 0; c < n_channel; c++) {
+    alpha[c] = weight_data[c] * invstd_data[c];
+    beta[c] = bias_data[c] - mean_data[c] * alpha[c];
+  }
+}
+
+// Returns (mean, invstd, unbiased var) of the batch y.
+template <typename scalar_t>
+std::tuple<at::Tensor, at::Tensor, at::Tensor> collect_stats(
+    const at::Tensor& y,
+    double eps) {
+  ChannelLayout layout(y);
+  auto y_data = y.data_ptr<scalar_t>();
+  std::vector<double> sum, sum_square;
+  // the sum and the sum of squares in the same sweep of y
+  reduce_per_channel(
+      layout,
+      sum,
+      sum_square,
+      [&](int64_t offset, int64_t c, double& acc0, double& acc1) {
+        double v = static_cast<float>(y_data[offset]);
+        acc0 += v;
+        acc1 += v * v;
+      });
+  auto options = y.options().dtype(at::kFloat);
+  auto mean = at::empty({layout.n_channel}, options);
+  auto invstd = at::empty({layout.n_channel}, options);
+  auto var_unbiased = at::empty({layout.n_channel}, options);
+  auto n = static_cast<double>(layout.per_channel());
+  for (int64_t c = 0; c < layout.n_channel; c++) {
+    auto m = sum[c] / n;
+    auto var = std::max(sum_square[c] / n - m * m, 0.0);
+    mean.data_ptr<float>()[c] = m;
+    invstd.data_ptr<float>()[c] = 1.0 / std::sqrt(var + eps);
+    var_unbiased.data_ptr<float>()[c] = n > 1 ? var * n / (n - 1) : var;
+  }
+  return std::make_tuple(mean, invstd, var_unbiased);
+}
+
+template <typename scalar_t>
+at::Tensor normalize_relu(
+    const at::Tensor& y,
+    const std::vector<float>& alpha,
+    const std::vector<float>& beta) {
+  ChannelLayout layout(y);
+  auto output = at::empty_like(y, y.suggest_memory_format());
+  auto y_data = y.data_ptr<scalar_t>();
+  auto out_data = output.data_ptr<scalar_t>();
+  map_per_channel(layout, [&](int64_t offset, int64_t c) {
+    auto v = static_cast<float>(y_data[offset]) * alpha[c] + beta[c];
+    out_data[offset] = static_cast<scalar_t>(v > 0.f ? v : 0.f);
+  });
+  return output;
+}
+
+// Returns (grad_y, grad_weight, grad_bias) of the batch norm and the relu,
+// where the relu mask is where y * alpha + beta is positive.
+template <typename scalar_t>
+std::tuple<at::Tensor, at::Tensor, at::Tensor> bn_relu_backward(
+    const at::Tensor& grad_output,
+    const at::Tensor& y,
+    const at::Tensor& bn_weight,
+    const at::Tensor& bn_bias,
+    const at::Tensor& mean,
+    const at::Tensor& invstd,
+    bool train) {
+  ChannelLayout layout(y);
+  auto g = grad_output.contiguous(y.suggest_memory_format());
+  auto g_data = g.data_ptr<scalar_t>();
+  auto y_data = y.data_ptr<scalar_t>();
+  auto mean_data = mean.data_ptr<float>();
+  auto invstd_data = invstd.data_ptr<float>();
+  std::vector<float> alpha, beta;
+  collect_linear_and_constant_terms(
+      alpha, beta, bn_weight, bn_bias, mean, invstd);
+
+  // the first pass: the sums of the masked grad and of it times x_hat
+  std::vector<double> sum_dy, sum_dy_xhat;
+  reduce_per_channel(
+      layout,
+      sum_dy,
+      sum_dy_xhat,
+      [&](int64_t offset, int64_t c, double& acc0, double& acc1) {
+        auto v = static_cast<float>(y_data[offset]);
+        if (v * alpha[c] + beta[c] > 0.f) {
+          auto dy = static_cast<float>(g_data[offset]);
+          acc0 += dy;
+          acc1 += dy * (v - mean_data[c]) * invstd_data[c];
+        }
+      });
+
+  auto options = bn_weight.options().dtype(at::kFloat);
+  auto grad_weight = at::empty({layout.n_channel}, options);
+  auto grad_bias = at::empty({layout.n_channel}, options);
+  auto weight_data = bn_weight.data_ptr<float>();
+  // the per channel terms of the second pass,
+  // grad_y = (dy - dy_mean - x_hat * dy_xhat_mean) * weight * invstd
+  std::vector<float> dy_mean(layout.n_channel), dy_xhat_mean(layout.n_channel),
+      scale(layout.n_channel);
+  auto n = static_cast<double>(layout.per_channel());
+  for (int64_t c = 0; c < layout.n_channel; c++) {
+    grad_weight.data_ptr<float>()[c] = sum_dy_xhat[c];
+    grad_bias.data_ptr<float>()[c] = sum_dy[c];
+    // the batch stats are constants of the eval mode
+    dy_mean[c] = train ? sum_dy[c] / n : 0.f;
+    dy_xhat_mean[c] = train ? sum_dy_xhat[c] / n : 0.f;
+    scale[c] = weight_data[c] * invstd_data[c];
+  }
+
+  auto grad_y = at::empty_like(y, y.suggest_memory_format());
+  auto grad_y_data = grad_y.data_ptr<scalar_t>();
+  map_per_channel(layout, [&](int64_t offset, int64_t c) {
+    auto v = static_cast<float>(y_data[offset]);
+    float dx = 0.f;
+    if (v * alpha[c] + beta[c] > 0.f) {
+      auto x_hat = (v - mean_data[c]) * invstd_data[c];
+      dx = (static_cast<float>(g_data[offset]) - dy_mean[c] -
+            x_hat * dy_xhat_mean[c]) *
+          scale[c];
+    }
+    grad_y_data[offset] = static_cast<scalar_t>(dx);
+  });
+  return std::make_tuple(grad_y, grad_weight, grad_bias);
+}
+
+// Returns (output, conv output, mean, invstd) of the forward, updating the
+// running stats of the training.
+std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor> conv_bn_relu_impl(
+    const at::Tensor& input,
+    const at::Tensor& weight,
+    const c10::optional<at::Tensor>& bias_opt,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef dilation,
+    at::IntArrayRef kernel_size,
+    int64_t groups,
+    int64_t output_channel,
+    bool weight_channels_last,
+    bool weight_packed,
+    const at::Tensor& bn_weight,
+    const at::Tensor& bn_bias,
+    const at::Tensor& running_mean,
+    const at::Tensor& running_var,
+    bool train,
+    double momentum,
+    double eps) {
+  auto y = convolution_forward_impl(
+      input,
+      weight,
+      bias_opt,
+      stride,
+      padding,
+      dilation,
+      kernel_size,
+      groups,
+      output_channel,
+      weight_channels_last,
+      weight_packed,
+      ideep::attr_t());
+  y = y.contiguous(y.suggest_memory_format());
+  TORCH_CHECK(
+      y.scalar_type() == at::kFloat || y.scalar_type() == at::kBFloat16,
+      "conv_bn_relu only supports the float and bfloat16 input");
+
+  at::Tensor mean, invstd, output;
+  AT_DISPATCH_FLOATING_TYPES_AND(
+      at::ScalarType::BFloat16, y.scalar_type(), "conv_bn_relu", [&] {
+        if (train) {
+          at::Tensor var_unbiased;
+          std::tie(mean, invstd, var_unbiased) =
+              collect_stats<scalar_t>(y, eps);
+          at::NoGradGuard no_grad;
+          running_mean.mul_(1 - momentum).add_(mean, momentum);
+          running_var.mul_(1 - momentum).add_(var_unbiased, momentum);
+        } else {
+          mean = running_mean.to(at::kFloat).contiguous();
+          invstd = (running_var.to(at::kFloat) + eps).rsqrt();
+        }
+        std::vector<float> alpha, beta;
+        collect_linear_and_constant_terms(
+            alpha, beta, bn_weight, bn_bias, mean, invstd);
+        output = normalize_relu<scalar_t>(y, alpha, beta);
+      });
+  return std::make_tuple(output, y, mean, invstd);
+}
+
+at::Tensor float_param(const at::Tensor& t) {
+  return t.to(at::kFloat).contiguous();
+}
+
+} // namespace
+
+at::Tensor IPEXConvBatchNormReluOp::_forward(
+    const at::Tensor& input,
+    const at::Tensor& weight,
+    const c10::optional<at::Tensor>& bias_opt,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef dilation,
+    at::IntArrayRef kernel_size,
+    int64_t groups,
+    int64_t output_channel,
+    bool weight_channels_last,
+    bool weight_packed,
+    const at::Tensor& bn_weight,
+    const at::Tensor& bn_bias,
+    const at::Tensor& running_mean,
+    const at::Tensor& running_var,
+    bool train,
+    double momentum,
+    double eps) {
+  IPEX_RECORD_FUNCTION(
+      "IPEXConvBatchNormReluOp::_forward", std::vector<c10::IValue>({}));
+  return std::get<0>(conv_bn_relu_impl(
+      input,
+      weight,
+      bias_opt,
+      stride,
+      padding,
+      dilation,
+      kernel_size,
+      groups,
+      output_channel,
+      weight_channels_last,
+      weight_packed,
+      float_param(bn_weight),
+      float_param(bn_bias),
+      running_mean,
+      running_var,
+      train,
+      momentum,
+      eps));
+}
+
+at::Tensor IPEXConvBatchNormReluOp::forward(
+    torch::autograd::AutogradContext* ctx,
+    const at::Tensor& input,
+    const at::Tensor& weight,
+    const c10::optional<at::Tensor>& bias_opt,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef dilation,
+    at::IntArrayRef kernel_size,
+    int64_t groups,
+    int64_t output_channel,
+    bool weight_channels_last,
+    bool weight_packed,
+    const at::Tensor& bn_weight,
+    const at::Tensor& bn_bias,
+    const at::Tensor& running_mean,
+    const at::Tensor& running_var,
+    bool train,
+    double momentum,
+    double eps) {
+  IPEX_RECORD_FUNCTION(
+      "IPEXConvBatchNormReluOp::forward", std::vector<c10::IValue>({}));
+  ctx->saved_data["stride"] = stride;
+  ctx->saved_data["padding"] = padding;
+  ctx->saved_data["dilation"] = dilation;
+  ctx->saved_data["kernel_size"] = kernel_size;
+  ctx->saved_data["groups"] = groups;
+  ctx->saved_data["weight_channels_last"] = weight_channels_last;
+  ctx->saved_data["weight_packed"] = weight_packed;
+  ctx->saved_data["train"] = train;
+  ctx->saved_data["input_requires_grad"] = input.requires_grad();
+  ctx->saved_data["weight_requires_grad"] = weight.requires_grad();
+  ctx->saved_data["bias_requires_grad"] =
+      bias_opt.has_value() && bias_opt.value().requires_grad() ? true : false;
+  ctx->saved_data["bn_weight_dtype"] = bn_weight.scalar_type();
+  ctx->saved_data["bn_bias_dtype"] = bn_bias.scalar_type();
+
+  auto bn_weight_ = float_param(bn_weight);
+  auto bn_bias_ = float_param(bn_bias);
+  at::Tensor output, y, mean, invstd;
+  std::tie(output, y, mean, invstd) = conv_bn_relu_impl(
+      input,
+      weight,
+      bias_opt,
+      stride,
+      padding,
+      dilation,
+      kernel_size,
+      groups,
+      output_channel,
+      weight_channels_last,
+      weight_packed,
+      bn_weight_,
+      bn_bias_,
+      running_mean,
+      running_var,
+      train,
+      momentum,
+      eps);
+  // the relu output is not saved, its mask is recomputed from y
+  ctx->save_for_backward(
+      {input, weight, y, bn_weight_, bn_bias_, mean, invstd});
+  return output;
+}
+
+torch::autograd::variable_list IPEXConvBatchNormReluOp::backward(
+    torch::autograd::AutogradContext* ctx,
+    torch::autograd::variable_list grad_outputs) {
+  IPEX_RECORD_FUNCTION(
+      "IPEXConvBatchNormReluOp::backward", std::vector<c10::IValue>({}));
+  auto stride = ctx->saved_data["stride"].toIntVector();
+  auto padding = ctx->saved_data["padding"].toIntVector();
+  auto dilation = ctx->saved_data["dilation"].toIntVector();
+  auto kernel_size = ctx->saved_data["kernel_size"].toIntVector();
+  auto groups = ctx->saved_data["groups"].toInt();
+  auto weight_channels_last = ctx->saved_data["weight_channels_last"].toBool();
+  auto weight_packed = ctx->saved_data["weight_packed"].toBool();
+  auto train = ctx->saved_data["train"].toBool();
+  std::array<bool, 3> output_mask;
+  output_mask[0] = ctx->saved_data["input_requires_grad"].toBool();
+  output_mask[1] = ctx->saved_data["weight_requires_grad"].toBool();
+  output_mask[2] = ctx->saved_data["bias_requires_grad"].toBool();
+  auto saved = ctx->get_saved_variables();
+  at::Tensor input = saved[0];
+  at::Tensor weight = saved[1];
+  at::Tensor y = saved[2];
+  at::Tensor bn_weight = saved[3];
+  at::Tensor bn_bias = saved[4];
+  at::Tensor mean = saved[5];
+  at::Tensor invstd = saved[6];
+
+  at::Tensor grad_y, grad_bn_weight, grad_bn_bias;
+  AT_DISPATCH_FLOATING_TYPES_AND(
+      at::ScalarType::BFloat16, y.scalar_type(), "conv_bn_relu_backward", [&] {
+        std::tie(grad_y, grad_bn_weight, grad_bn_bias) =
+            bn_relu_backward<scalar_t>(
+                grad_outputs[0], y, bn_weight, bn_bias, mean, invstd, train);
+      });
+
+  at::Tensor grad_input, grad_weight, grad_bias;
+  std::tie(grad_input, grad_weight, grad_bias) = convolution_backward(
+      input,
+      grad_y,
+      weight,
+      padding,
+      stride,
+      dilation,
+      kernel_size,
+      groups,
+      output_mask,
+      weight_channels_last,
+      weight_packed);
+  return {
+      grad_input,
+      grad_weight,
+      grad_bias,
+      at::Tensor(),
+      at::Tensor(),
+      at::Tensor(),
+      at::Tensor(),
+      at::Tensor(),
+      at::Tensor(),
+      at::Tensor(),
+      at::Tensor(),
+      grad_bn_weight.to(ctx->saved_data["bn_weight_dtype"].toScalarType()),
+      grad_bn_bias.to(ctx->saved_data["bn_bias_dtype"].toScalarType()),
+      at::Tensor(),
+      at::Tensor(),
+      at::Tensor(),
+      at::Tensor(),
+      at::Tensor()};
+}
+
+at::Tensor conv_bn_relu_forward(
+    const at::Tensor& input,
+    const at::Tensor& weight,
+    const c10::optional<at::Tensor>& bias_opt,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef dilation,
+    at::IntArrayRef kernel_size,
+    int64_t groups,
+    int64_t output_channel,
+    bool weight_channels_last,
+    bool weight_packed,
+    const at::Tensor& bn_weight,
+    const at::Tensor& bn_bias,
+    const at::Tensor& running_mean,
+    const at::Tensor& running_var,
+    bool train,
+    double momentum,
+    double eps) {
+  if (at::GradMode::is_enabled()) {
+    return IPEXConvBatchNormReluOp::apply(
+        input,
+        weight,
+        bias_opt,
+        stride,
+        padding,
+        dilation,
+        kernel_size,
+        groups,
+        output_channel,
+        weight_channels_last,
+        weight_packed,
+        bn_weight,
+        bn_bias,
+        running_mean,
+        running_var,
+        train,
+        momentum,
+        eps);
+  }
+  return IPEXConvBatchNormReluOp::_forward(
+      input,
+      weight,
+      bias_opt,
+      stride,
+      padding,
+      dilation,
+      kernel_size,
+      groups,
+      output_channel,
+      weight_channels_last,
+      weight_packed,
+      bn_weight,
+      bn_bias,
+      running_mean,
+      running_var,
+      train,
+      momentum,
+      eps);
+}
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "conv_bn_relu_forward(Tensor input, Tensor weight, Tensor? bias_opt, "
+      "int[] stride, int[] padding, int[] dilation, int[] kernel_size, int "
+      "groups, int output_channel, bool weight_channels_last, bool "
+      "weight_packed, Tensor bn_weight, Tensor bn_bias, Tensor(a!) "
+      "running_mean, Tensor(b!) running_var, bool train, float momentum, "
+      "float eps) -> Tensor",
+      torch_ipex::cpu::conv_bn_relu_forward);
+}
+
+} // namespace
+
+namespace torch_ipex {
+namespace autocast {
+
+at::Tensor conv_bn_relu_forward(
+    const at::Tensor& input,
+    const at::Tensor& weight,
+    const c10::optional<at::Tensor>& bias_opt,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef dilation,
+    at::IntArrayRef kernel_size,
+    int64_t groups,
+    int64_t output_channel,
+    bool weight_channels_last,
+    bool weight_packed,
+    const at::Tensor& bn_weight,
+    const at::Tensor& bn_bias,
+    const at::Tensor& running_mean,
+    const at::Tensor& running_var,
+    bool train,
+    double momentum,
+    double eps) {
+  c10::impl::ExcludeDispatchKeyGuard no_autocastCPU(DispatchKey::AutocastCPU);
+  static auto op =
+      torch::Dispatcher::singleton()
+          .findSchemaOrThrow("torch_ipex::conv_bn_relu_forward", "")
+          .typed<decltype(conv_bn_relu_forward)>();
+#if defined(ENABLE_AUTOCAST_VERBOSE)
+  verbose::OpNameGuard op_name("conv_bn_relu_forward");
+#endif
+  auto target_type = get_autocast_dtype();
+
+  // the batch norm params and stats are kept in float
+  return op.call(
+      cpu_cached_cast(target_type, input),
+      cpu_cached_cast(target_type, weight),
+      cpu_cached_cast(target_type, bias_opt),
+      stride,
+      padding,
+      dilation,
+      kernel_size,
+      groups,
+      output_channel,
+      weight_channels_last,
+      weight_packed,
+      bn_weight,
+      bn_bias,
+      running_mean,
+      running_var,
+      train,
+      momentum,
+      eps);
+}
+
+TORCH_LIBRARY_IMPL(torch_ipex, AutocastCPU, m) {
+  m.impl("conv_bn_relu_forward", torch_ipex::autocast::conv_bn_relu_forward);
+}
+
+} // namespace autocast
+} // namespace torch_ipex
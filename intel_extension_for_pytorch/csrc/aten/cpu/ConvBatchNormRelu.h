@@ -0,0 +1,88 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+#include <torch/csrc/autograd/custom_function.h>
+
+#include "csrc/cpu/ideep/ideep.hpp"
+
+namespace torch_ipex {
+namespace cpu {
+
+// relu(batch_norm(convolution_forward(input))) of the 2d convolution, whose
+// batch stats are collected from the conv output in a single pass and
+// normalized together with the relu in another one. The backward applies the
+// relu mask, recomputed from the saved conv output, within the two passes of
+// the batch norm backward.
+at::Tensor conv_bn_relu_forward(
+    const at::Tensor& input,
+    const at::Tensor& weight,
+    const c10::optional<at::Tensor>& bias_opt,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef dilation,
+    at::IntArrayRef kernel_size,
+    int64_t groups,
+    int64_t output_channel,
+    bool weight_channels_last,
+    bool weight_packed,
+    const at::Tensor& bn_weight,
+    const at::Tensor& bn_bias,
+    const at::Tensor& running_mean,
+    const at::Tensor& running_var,
+    bool train,
+    double momentum,
+    double eps);
+
+class IPEXConvBatchNormReluOp
+    : public torch::autograd::Function<IPEXConvBatchNormReluOp> {
+ public:
+  // forward function without autograd overhead, will go this way when only do
+  // forward
+  static at::Tensor _forward(
+      const at::Tensor& input,
+      const at::Tensor& weight,
+      const c10::optional<at::Tensor>& bias_opt,
+      at::IntArrayRef stride,
+      at::IntArrayRef padding,
+      at::IntArrayRef dilation,
+      at::IntArrayRef kernel_size,
+      int64_t groups,
+      int64_t output_channel,
+      bool weight_channels_last,
+      bool weight_packed,
+      const at::Tensor& bn_weight,
+      const at::Tensor& bn_bias,
+      const at::Tensor& running_mean,
+      const at::Tensor& running_var,
+      bool train,
+      double momentum,
+      double eps);
+
+  static at::Tensor forward(
+      torch::autograd::AutogradContext* ctx,
+      const at::Tensor& input,
+      const at::Tensor& weight,
+      const c10::optional<at::Tensor>& bias_opt,
+      at::IntArrayRef stride,
+      at::IntArrayRef padding,
+      at::IntArrayRef dilation,
+      at::IntArrayRef kernel_size,
+      int64_t groups,
+      int64_t output_channel,
+      bool weight_channels_last,
+      bool weight_packed,
+      const at::Tensor& bn_weight,
+      const at::Tensor& bn_bias,
+      const at::Tensor& running_mean,
+      const at::Tensor& running_var,
+      bool train,
+      double momentum,
+      double eps);
+
+  static torch::autograd::variable_list backward(
+      torch::autograd::AutogradContext* ctx,
+      torch::autograd::variable_list grad_outputs);
+};
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -4,6 +4,7 @@
 #include "csrc/autocast/autocast_mode.h"
 #include "csrc/autocast/autocast_verbose.h"
 #include "csrc/cpu/ideep/IDeepConversions.h"
+#include "csrc/utils/op_trace.h"
 #include "csrc/utils/utils.h"
 
 namespace torch_ipex {
@@ -60,8 +61,10 @@ at::Tensor conv_transpose2d_kernel_impl(
       at::borrow_from_optional_tensor(bias_opt);
   const at::Tensor& bias = *bias_maybe_owned;
 
+  // of the 4-d deconv2d or 5-d deconv3d input
   bool is_channels_last =
-      input.suggest_memory_format() == at::MemoryFormat::ChannelsLast;
+      input.suggest_memory_format() == at::MemoryFormat::ChannelsLast ||
+      input.suggest_memory_format() == at::MemoryFormat::ChannelsLast3d;
 
   ideep::tensor y;
   if (is_channels_last) {
@@ -80,7 +83,8 @@ at::Tensor conv_transpose2d_kernel_impl(
         padding.vec(),
         padding.vec(),
         dilation.vec(),
-        groups);
+        groups,
+        attr);
   } else {
     ideep::convolution_transpose_forward::compute(
         x,
@@ -91,7 +95,8 @@ at::Tensor conv_transpose2d_kernel_impl(
         padding.vec(),
         padding.vec(),
         dilation.vec(),
-        groups);
+        groups,
+        attr);
   }
 
   if (!is_channels_last) {
@@ -100,7 +105,9 @@ at::Tensor conv_transpose2d_kernel_impl(
         optTypeMetaToScalarType(input.options().dtype_opt()),
         input.options().device_opt()));
   } else {
-    TORCH_INTERNAL_ASSERT(y.get_desc().is_nhwc());
+    // ideep checks no ndhwc, which is plain as well
+    TORCH_INTERNAL_ASSERT(
+        output.dim() == 4 ? y.get_desc().is_nhwc() : y.get_desc().is_plain());
     return output;
   }
 }
@@ -206,10 +213,8 @@ at::Tensor IPEXConvTransposeOp::_forward(
     bool weight_channels_last,
     bool weight_prepacked) {
   at::AutoNonVariableTypeMode g;
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "IPEXConvTransposeOp::_forward", std::vector<c10::IValue>({}));
-#endif
 
   static auto op = torch::Dispatcher::singleton()
                        .findSchemaOrThrow("torch_ipex::conv_transpose2d", "")
@@ -243,9 +248,8 @@ at::Tensor IPEXConvTransposeOp::forward(
     int64_t output_channel,
     bool weight_channels_last,
     bool weight_prepacked) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("IPEXConvTransposeOp::forward", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION(
+      "IPEXConvTransposeOp::forward", std::vector<c10::IValue>({}));
   ctx->saved_data["stride"] = stride;
   ctx->saved_data["padding"] = padding;
   ctx->saved_data["dilation"] = dilation;
@@ -459,10 +463,8 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> conv_transpose2d_backward(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::conv_transpose2d_backward\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::conv_transpose2d_backward", std::vector<c10::IValue>({}));
-#endif
   auto memory_format = input.suggest_memory_format();
   at::Tensor grad_output = grad_output_t.contiguous(memory_format);
 
@@ -503,10 +505,8 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> conv_transpose2d_backward(
 torch::autograd::variable_list IPEXConvTransposeOp::backward(
     torch::autograd::AutogradContext* ctx,
     torch::autograd::variable_list grad_outputs) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "IPEXConvTransposeOp::backward", std::vector<c10::IValue>({}));
-#endif
   auto stride = ctx->saved_data["stride"].toIntVector();
   auto padding = ctx->saved_data["padding"].toIntVector();
   auto output_padding = ctx->saved_data["output_padding"].toIntVector();
@@ -620,7 +620,7 @@ at::Tensor conv_transpose2d(
 #if defined(ENABLE_AUTOCAST_VERBOSE)
   verbose::OpNameGuard op_name("conv_transpose2d");
 #endif
-  auto target_type = get_autocast_dtype();
+  auto target_type = get_lower_precision_dtype("conv_transpose2d");
 
   // TODO: make check weight dtype should be float for training case.
   return op.call(
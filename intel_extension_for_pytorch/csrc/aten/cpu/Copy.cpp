@@ -21,7 +21,15 @@
 
 #include "Copy.h"
 
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <vector>
+
 #include "csrc/utils/library.h"
+#include "utils/stream_store.h"
+#include "csrc/utils/op_trace.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -378,69 +386,269 @@ static void copy_kernel(at::TensorIterator& iter, bool non_blocking) {
   }
 }
 
+// transpose operation of a 8*8 block of bytes
+template <>
+inline void transpose_kernel_8x8<uint8_t>(
+    const uint8_t* src,
+    int64_t ld_src,
+    uint8_t* dst,
+    int64_t ld_dst) {
+  // inputs:
+  //   a = {a0, a1, a2, a3, a4, a5, a6, a7}
+  //   b = {b0, b1, b2, b3, b4, b5, b6, b7}
+  //   c = {c0, c1, c2, c3, c4, c5, c6, c7}
+  //   d = {d0, d1, d2, d3, d4, d5, d6, d7}
+  //   e = {e0, e1, e2, e3, e4, e5, e6, e7}
+  //   f = {f0, f1, f2, f3, f4, f5, f6, f7}
+  //   g = {g0, g1, g2, g3, g4, g5, g6, g7}
+  //   h = {h0, h1, h2, h3, h4, h5, h6, h7}
+  __m128i a =
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&src[0 * ld_src]));
+  __m128i b =
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&src[1 * ld_src]));
+  __m128i c =
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&src[2 * ld_src]));
+  __m128i d =
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&src[3 * ld_src]));
+  __m128i e =
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&src[4 * ld_src]));
+  __m128i f =
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&src[5 * ld_src]));
+  __m128i g =
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&src[6 * ld_src]));
+  __m128i h =
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(&src[7 * ld_src]));
+
+  // interleave 8 bit:
+  //   t0 = {a0, b0, a1, b1, a2, b2, a3, b3, ..., a7, b7}
+  //   t1 = {c0, d0, c1, d1, c2, d2, c3, d3, ..., c7, d7}
+  //   t2 = {e0, f0, e1, f1, e2, f2, e3, f3, ..., e7, f7}
+  //   t3 = {g0, h0, g1, h1, g2, h2, g3, h3, ..., g7, h7}
+  __m128i t0 = _mm_unpacklo_epi8(a, b);
+  __m128i t1 = _mm_unpacklo_epi8(c, d);
+  __m128i t2 = _mm_unpacklo_epi8(e, f);
+  __m128i t3 = _mm_unpacklo_epi8(g, h);
+
+  // interleave 16 bit:
+  //   tt0 = {a0, b0, c0, d0, a1, b1, c1, d1, ..., a3, b3, c3, d3}
+  //   tt1 = {a4, b4, c4, d4, a5, b5, c5, d5, ..., a7, b7, c7, d7}
+  //   tt2 = {e0, f0, g0, h0, e1, f1, g1, h1, ..., e3, f3, g3, h3}
+  //   tt3 = {e4, f4, g4, h4, e5, f5, g5, h5, ..., e7, f7, g7, h7}
+  __m128i tt0 = _mm_unpacklo_epi16(t0, t1);
+  __m128i tt1 = _mm_unpackhi_epi16(t0, t1);
+  __m128i tt2 = _mm_unpacklo_epi16(t2, t3);
+  __m128i tt3 = _mm_unpackhi_epi16(t2, t3);
+
+  // interleave 32 bit, i.e. 2 rows of the output per register:
+  //   a = {a0, b0, c0, d0, e0, f0, g0, h0, a1, b1, c1, d1, e1, f1, g1, h1}
+  //   c = {a2, b2, c2, d2, e2, f2, g2, h2, a3, b3, c3, d3, e3, f3, g3, h3}
+  //   e = {a4, b4, c4, d4, e4, f4, g4, h4, a5, b5, c5, d5, e5, f5, g5, h5}
+  //   g = {a6, b6, c6, d6, e6, f6, g6, h6, a7, b7, c7, d7, e7, f7, g7, h7}
+  a = _mm_unpacklo_epi32(tt0, tt2);
+  c = _mm_unpackhi_epi32(tt0, tt2);
+  e = _mm_unpacklo_epi32(tt1, tt3);
+  g = _mm_unpackhi_epi32(tt1, tt3);
+
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(&dst[0 * ld_dst]), a);
+  _mm_storel_epi64(
+      reinterpret_cast<__m128i*>(&dst[1 * ld_dst]), _mm_unpackhi_epi64(a, a));
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(&dst[2 * ld_dst]), c);
+  _mm_storel_epi64(
+      reinterpret_cast<__m128i*>(&dst[3 * ld_dst]), _mm_unpackhi_epi64(c, c));
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(&dst[4 * ld_dst]), e);
+  _mm_storel_epi64(
+      reinterpret_cast<__m128i*>(&dst[5 * ld_dst]), _mm_unpackhi_epi64(e, e));
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(&dst[6 * ld_dst]), g);
+  _mm_storel_epi64(
+      reinterpret_cast<__m128i*>(&dst[7 * ld_dst]), _mm_unpackhi_epi64(g, g));
+}
+
+// dst[i][j] = src[j][i] of the m * n dst, by the 8*8 blocks and the scalar
+// remainder
+template <typename T>
+inline void transpose_block(
+    const T* src,
+    int64_t ld_src,
+    T* dst,
+    int64_t ld_dst,
+    int64_t m,
+    int64_t n) {
+  constexpr int64_t MICRO_SIZE = 8;
+  int64_t i = 0;
+  for (; i < m - (m % MICRO_SIZE); i += MICRO_SIZE) {
+    int64_t j = 0;
+    for (; j < n - (n % MICRO_SIZE); j += MICRO_SIZE) {
+      transpose_kernel_8x8<T>(
+          &src[j * ld_src + i], ld_src, &dst[i * ld_dst + j], ld_dst);
+    }
+    for (; j < n; j++) {
+      for (int64_t k = i; k < i + MICRO_SIZE; k++) {
+        dst[k * ld_dst + j] = src[j * ld_src + k];
+      }
+    }
+  }
+  for (; i < m; i++) {
+    for (int64_t j = 0; j < n; j++) {
+      dst[i * ld_dst + j] = src[j * ld_src + i];
+    }
+  }
+}
+
 template <typename scalar_t>
-void transpose_copy_kernel_impl(at::Tensor& self, const at::Tensor& src) {
-  scalar_t* self_data = self.data_ptr<scalar_t>();
-  scalar_t* src_data = src.data_ptr<scalar_t>();
-
-  int64_t M = src.size(0);
-  int64_t N = src.size(1);
-
-  constexpr int64_t BLOCK_SIZE = 8;
-  int64_t K = at::divup(M, BLOCK_SIZE);
-
-  // parallel on outer most dimension
-  // TODO: vectorize the remainder
-  int64_t grain_size = at::internal::GRAIN_SIZE / N / BLOCK_SIZE;
-  at::parallel_for(0, K, grain_size, [&](int64_t begin, int64_t end) {
-    int64_t rbegin = begin * BLOCK_SIZE;
-    int64_t rend = std::min(end * BLOCK_SIZE, M);
-
-    int64_t i = rbegin;
-    for (; i < rend - (rend % BLOCK_SIZE); i += BLOCK_SIZE) {
-      int64_t j = 0;
-      for (; j < N - (N % BLOCK_SIZE); j += BLOCK_SIZE) {
-        transpose_kernel_8x8<scalar_t>(
-            &src_data[j * M + i], M, &self_data[i * N + j], N);
+void permute_copy_kernel_impl(
+    at::Tensor& self,
+    const at::Tensor& src,
+    const PermuteCopyPlan& plan) {
+  scalar_t* self_data = static_cast<scalar_t*>(self.data_ptr());
+  const scalar_t* src_data = static_cast<const scalar_t*>(src.data_ptr());
+
+  // the copy is a transpose of the plane of the innermost dimension of src
+  // and the one of self, of the m * n blocks of the other dimensions
+  int64_t ndim = plan.sizes.size();
+  const auto& src_strides = plan.src_strides;
+  int64_t m_dim = std::find(src_strides.begin(), src_strides.end(), 1) -
+      src_strides.begin();
+  int64_t n_dim = ndim - 1;
+  int64_t M = plan.sizes[m_dim];
+  int64_t N = plan.sizes[n_dim];
+  int64_t ld_src = plan.src_strides[n_dim];
+  int64_t ld_self = plan.self_strides[m_dim];
+  std::vector<int64_t> outer_sizes, outer_self_strides, outer_src_strides;
+  for (int64_t d = 0; d < ndim; d++) {
+    if (d != m_dim && d != n_dim) {
+      outer_sizes.push_back(plan.sizes[d]);
+      outer_self_strides.push_back(plan.self_strides[d]);
+      outer_src_strides.push_back(plan.src_strides[d]);
+    }
+  }
+  int64_t outer_size = std::accumulate(
+      outer_sizes.begin(),
+      outer_sizes.end(),
+      (int64_t)1,
+      std::multiplies<int64_t>());
+
+  // the blocks of the plane of which the input and the output fit in L1
+  constexpr int64_t BLOCK_SIZE = 64;
+  int64_t m_blocks = at::divup(M, BLOCK_SIZE);
+  int64_t n_blocks = at::divup(N, BLOCK_SIZE);
+  int64_t plane_blocks = m_blocks * n_blocks;
+  // the output beyond half of the LLC is not read back from the cache by the
+  // next op anyway, of which the blocks are transposed into a buffer and
+  // written by the non-temporal stores
+  bool non_temporal =
+      use_stream_store(self.numel() * static_cast<int64_t>(sizeof(scalar_t)));
+
+  // parallel on the outer dimensions and on the blocks of the plane
+  int64_t grain_size =
+      std::max<int64_t>(1, at::internal::GRAIN_SIZE / BLOCK_SIZE / BLOCK_SIZE);
+  int64_t num_blocks = outer_size * plane_blocks;
+  at::parallel_for(0, num_blocks, grain_size, [&](int64_t begin, int64_t end) {
+    std::vector<scalar_t> buffer(non_temporal ? BLOCK_SIZE * BLOCK_SIZE : 0);
+    for (int64_t t = begin; t < end; t++) {
+      int64_t index = t / plane_blocks;
+      int64_t self_offset = 0;
+      int64_t src_offset = 0;
+      for (int64_t d = outer_sizes.size() - 1; d >= 0; d--) {
+        self_offset += (index % outer_sizes[d]) * outer_self_strides[d];
+        src_offset += (index % outer_sizes[d]) * outer_src_strides[d];
+        index /= outer_sizes[d];
       }
-      for (; j < N; j++) {
-        for (int64_t k = i; k < i + BLOCK_SIZE; k++) {
-          self_data[k * N + j] = src_data[j * M + k];
-        }
+      int64_t m0 = (t % plane_blocks) / n_blocks * BLOCK_SIZE;
+      int64_t n0 = (t % plane_blocks) % n_blocks * BLOCK_SIZE;
+      int64_t m = std::min(M - m0, BLOCK_SIZE);
+      int64_t n = std::min(N - n0, BLOCK_SIZE);
+      const scalar_t* src_ptr = src_data + src_offset + n0 * ld_src + m0;
+      scalar_t* self_ptr = self_data + self_offset + m0 * ld_self + n0;
+      if (!non_temporal) {
+        transpose_block<scalar_t>(src_ptr, ld_src, self_ptr, ld_self, m, n);
+        continue;
       }
-    }
-    for (; i < rend; i++) {
-      for (int64_t j = 0; j < N; j++) {
-        self_data[i * N + j] = src_data[j * M + i];
+      transpose_block<scalar_t>(
+          src_ptr, ld_src, buffer.data(), BLOCK_SIZE, m, n);
+      for (int64_t i = 0; i < m; i++) {
+        stream_copy(
+            reinterpret_cast<char*>(self_ptr + i * ld_self),
+            reinterpret_cast<const char*>(buffer.data() + i * BLOCK_SIZE),
+            n * sizeof(scalar_t));
       }
     }
+    if (non_temporal) {
+      // the streaming stores are weakly ordered, which are fenced before
+      // the output is read by the other threads
+      _mm_sfence();
+    }
   });
 }
 
-static void transpose_copy_kernel(at::Tensor& self, const at::Tensor& src) {
-  TORCH_CHECK(self.is_contiguous(), "self is not contiguous");
-  TORCH_CHECK(src.numel() > 0, "expect src number of elements > 0");
-  TORCH_CHECK(
-      src.dim() == 2 && self.dim() == 2,
-      "expect src and self dims to be 2, self dim: ",
-      src.dim(),
-      "; self dim: ",
-      self.dim());
-  TORCH_CHECK(src.stride(0) == 1, "src first dimension is not contiguous");
-  TORCH_CHECK(
-      src.stride(1) == src.size(0), "expect src.stride(1) == src.size(0)");
-  TORCH_CHECK(
-      src.scalar_type() == self.scalar_type(),
-      "expect same data type for src and self, src data type: ",
-      src.scalar_type(),
-      "; self data type: ",
-      self.scalar_type());
-
-  AT_DISPATCH_FLOATING_TYPES_AND(
-      at::ScalarType::BFloat16,
-      src.scalar_type(),
-      "transpose_copy_kernel",
-      [&] { transpose_copy_kernel_impl<scalar_t>(self, src); });
+static void permute_copy_kernel(
+    at::Tensor& self,
+    const at::Tensor& src,
+    const PermuteCopyPlan& plan) {
+  // the copy moves the bits only, of which the data type is the one of the
+  // size of the elements
+  switch (self.element_size()) {
+    case 1:
+      permute_copy_kernel_impl<uint8_t>(self, src, plan);
+      break;
+    case 2:
+      permute_copy_kernel_impl<at::BFloat16>(self, src, plan);
+      break;
+    case 4:
+      permute_copy_kernel_impl<float>(self, src, plan);
+      break;
+    default:
+      TORCH_INTERNAL_ASSERT(self.element_size() == 8);
+      permute_copy_kernel_impl<int64_t>(self, src, plan);
+  }
+}
+
+bool copy_permute_valid(
+    const at::Tensor& self,
+    const at::Tensor& src,
+    PermuteCopyPlan& plan) {
+  const int MIN_SZ = 60 * 60;
+  int64_t element_size = self.element_size();
+  if (!(self.numel() >= MIN_SZ && self.sizes().equals(src.sizes()) &&
+        self.scalar_type() == src.scalar_type() && !self.is_quantized() &&
+        self.is_neg() == src.is_neg() && self.is_conj() == src.is_conj() &&
+        (element_size == 1 || element_size == 2 || element_size == 4 ||
+         element_size == 8) &&
+        self.is_non_overlapping_and_dense() &&
+        src.is_non_overlapping_and_dense() &&
+        self.strides() != src.strides())) {
+    return false;
+  }
+
+  // the dimensions in the order of self, the outermost first, of which the
+  // ones of size 1 are skipped and the ones contiguous in both are coalesced
+  std::vector<int64_t> order;
+  for (int64_t d = 0; d < self.dim(); d++) {
+    if (self.size(d) != 1) {
+      order.push_back(d);
+    }
+  }
+  std::sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+    return self.stride(a) > self.stride(b);
+  });
+  plan.sizes.clear();
+  plan.self_strides.clear();
+  plan.src_strides.clear();
+  for (auto d : order) {
+    if (!plan.sizes.empty() &&
+        plan.self_strides.back() == self.stride(d) * self.size(d) &&
+        plan.src_strides.back() == src.stride(d) * self.size(d)) {
+      plan.sizes.back() *= self.size(d);
+      plan.self_strides.back() = self.stride(d);
+      plan.src_strides.back() = src.stride(d);
+    } else {
+      plan.sizes.push_back(self.size(d));
+      plan.self_strides.push_back(self.stride(d));
+      plan.src_strides.push_back(src.stride(d));
+    }
+  }
+  // the copies of the same innermost dimension are left to the
+  // TensorIterator, which copies the contiguous rows of them
+  return plan.src_strides.back() != 1;
 }
 
 bool copy_transpose_valid(const at::Tensor& self, const at::Tensor& src) {
@@ -510,6 +718,34 @@ void copy_same_type_transpose_(at::Tensor& self, const at::Tensor& src) {
       });
 }
 
+bool copy_stream_valid(const at::Tensor& self, const at::Tensor& src) {
+  return self.scalar_type() == src.scalar_type() &&
+      self.is_neg() == src.is_neg() && self.is_conj() == src.is_conj() &&
+      self.is_non_overlapping_and_dense() &&
+      self.sizes().equals(src.sizes()) &&
+      self.strides().equals(src.strides()) &&
+      at::get_overlap_status(self, src) == at::MemOverlapStatus::NO &&
+      use_stream_store(self.numel() * self.element_size());
+}
+
+// the copy between the same dense layouts of the tensors of the same type,
+// of which the output beyond half of the LLC is written by the non-temporal
+// stores instead of the cached stores of the TensorIterator
+void copy_same_type_stream_(at::Tensor& self, const at::Tensor& src) {
+  char* self_data = static_cast<char*>(self.data_ptr());
+  const char* src_data = static_cast<const char*>(src.data_ptr());
+  int64_t nbytes = self.numel() * self.element_size();
+  // the chunks of the threads are of the whole lines of the output
+  constexpr int64_t CHUNK_BYTES = 64 * 1024;
+  int64_t num_chunks = at::divup(nbytes, CHUNK_BYTES);
+  at::parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    int64_t offset = begin * CHUNK_BYTES;
+    int64_t size = std::min(end * CHUNK_BYTES, nbytes) - offset;
+    stream_copy(self_data + offset, src_data + offset, size);
+    _mm_sfence();
+  });
+}
+
 // Devices directly supported by this copy implementation. Other device types
 // (e.g. XLA) may be supported by overriding copy_ and _copy_from.
 bool is_supported_device(at::Device device) {
@@ -695,15 +931,20 @@ static at::Tensor& copy_impl(
   }
 
   // TODO: if we need to, we can also enable this path for quantized tensor
-  if (device_type == at::kCPU && copy_transpose_valid(self, src) &&
-      !self.is_quantized()) {
-    auto st = self.scalar_type();
-    if (st == at::ScalarType::Float || st == at::ScalarType::BFloat16) {
-      transpose_copy_kernel(self, src);
+  if (device_type == at::kCPU && !self.is_quantized()) {
+    PermuteCopyPlan plan;
+    if (copy_permute_valid(self, src, plan)) {
+      permute_copy_kernel(self, src, plan);
+      return self;
+    }
+    if (copy_transpose_valid(self, src)) {
+      copy_same_type_transpose_(self, src);
+      return self;
+    }
+    if (copy_stream_valid(self, src)) {
+      copy_same_type_stream_(self, src);
       return self;
     }
-    copy_same_type_transpose_(self, src);
-    return self;
   }
 
   if (!self.is_complex() && src.is_complex()) {
@@ -718,9 +959,7 @@ at::Tensor& copy_(at::Tensor& self, const at::Tensor& src, bool non_blocking) {
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::copy_\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("torch_ipex::copy_", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("torch_ipex::copy_", std::vector<c10::IValue>({}));
   auto maybe_outnames =
       at::namedinference::compute_broadcast_outnames(self, src);
   {
@@ -2,6 +2,8 @@
 
 #include <ATen/ATen.h>
 
+#include <vector>
+
 namespace torch_ipex {
 namespace cpu {
 
@@ -26,17 +28,48 @@ inline void transpose_kernel_8x8<at::BFloat16>(
     at::BFloat16* dst,
     int64_t ld_dst);
 
+template <>
+inline void transpose_kernel_8x8<uint8_t>(
+    const uint8_t* src,
+    int64_t ld_src,
+    uint8_t* dst,
+    int64_t ld_dst);
+
 static void copy_kernel(at::TensorIterator& iter, bool non_blocking);
 
+// The layout of the copy between two non-overlapping and dense tensors of
+// different dimension orders, e.g. of the NCHW <-> NHWC ones, of which the
+// dimensions are in the order of the strides of self.
+struct PermuteCopyPlan {
+  std::vector<int64_t> sizes;
+  std::vector<int64_t> self_strides;
+  std::vector<int64_t> src_strides;
+};
+
 template <typename scalar_t>
-void transpose_copy_kernel_impl(at::Tensor& self, const at::Tensor& src);
+void permute_copy_kernel_impl(
+    at::Tensor& self,
+    const at::Tensor& src,
+    const PermuteCopyPlan& plan);
 
-static void transpose_copy_kernel(at::Tensor& self, const at::Tensor& src);
+static void permute_copy_kernel(
+    at::Tensor& self,
+    const at::Tensor& src,
+    const PermuteCopyPlan& plan);
+
+bool copy_permute_valid(
+    const at::Tensor& self,
+    const at::Tensor& src,
+    PermuteCopyPlan& plan);
 
 bool copy_transpose_valid(const at::Tensor& self, const at::Tensor& src);
 
 void copy_same_type_transpose_(at::Tensor& self, const at::Tensor& src);
 
+bool copy_stream_valid(const at::Tensor& self, const at::Tensor& src);
+
+void copy_same_type_stream_(at::Tensor& self, const at::Tensor& src);
+
 bool is_supported_device(at::Device device);
 
 at::Tensor& quantized_copy_from_float_cpu_(
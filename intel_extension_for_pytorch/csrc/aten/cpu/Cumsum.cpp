@@ -7,6 +7,10 @@
 #include <ATen/native/TensorIterator.h>
 #include <immintrin.h>
 
+#include "csrc/cpu/isa/cpu_info.hpp"
+#include "csrc/utils/fast_path_stats.h"
+#include "csrc/utils/op_trace.h"
+
 namespace torch_ipex {
 
 using namespace at::vec;
@@ -94,8 +98,21 @@ static inline void cumsum_lastdim_kernel(
 
   int64_t T = at::get_num_threads();
 
-  // bytes per core for each chunk, set to 256KB (L2 cache reside)
-  constexpr int64_t CHUNK_SIZE_PER_CORE = 256 * 1024 / sizeof(scalar_t);
+  // the rows of all the threads, which are scanned one pass each in parallel
+  if (M >= T) {
+    int64_t grain_size = std::max(int64_t(1), at::internal::GRAIN_SIZE / N);
+    at::parallel_for(0, M, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t m = begin; m < end; m++) {
+        prefix_sum<scalar_t>(
+            self_data + m * N, result_data + m * N, scalar_t(0), N);
+      }
+    });
+    return;
+  }
+
+  // bytes per core for each chunk, of which the chunk stays in L2
+  const int64_t CHUNK_SIZE_PER_CORE =
+      cpu::cpu_tuning().cumsum_chunk_bytes / sizeof(scalar_t);
   int64_t CHUNK_SIZE = std::max(int64_t(1), CHUNK_SIZE_PER_CORE / M * T);
   int64_t K = divup(N, CHUNK_SIZE);
 
@@ -161,6 +178,114 @@ static inline void cumsum_lastdim_kernel(
   }
 }
 
+// result[o][n][i] = sum(self[o][0:n+1][i]) of the [outer, N, inner] view of
+// the contiguous self, vectorized over the inner dimensions
+template <typename scalar_t>
+static inline void cumsum_dim_kernel(
+    at::Tensor& result,
+    const at::Tensor& self,
+    int64_t dim) {
+  TORCH_CHECK(
+      self.scalar_type() == result.scalar_type(),
+      "cumsum_dim_kernel: expect same data type for self and result");
+
+  if (result.sizes() != self.sizes()) {
+    result.resize_as_(self);
+  }
+  if (self.numel() == 0) {
+    return;
+  }
+
+  int64_t N = self.size(dim);
+  int64_t inner = self.stride(dim);
+  int64_t outer = self.numel() / (N * inner);
+  const scalar_t* self_data = self.data_ptr<scalar_t>();
+  scalar_t* result_data = result.data_ptr<scalar_t>();
+
+  using Vec = Vectorized<scalar_t>;
+  auto add = [](Vec x, Vec y) { return x + y; };
+  // scans the rows [begin, end) of the outer index o, from the offset row
+  auto scan_rows = [&](int64_t o,
+                       int64_t begin,
+                       int64_t end,
+                       const scalar_t* offset) {
+    const scalar_t* self_ptr = self_data + o * N * inner;
+    scalar_t* result_ptr = result_data + o * N * inner;
+    for (int64_t n = begin; n < end; n++) {
+      const scalar_t* prev = n == begin ? offset : result_ptr + (n - 1) * inner;
+      at::vec::map2(
+          add, result_ptr + n * inner, prev, self_ptr + n * inner, inner);
+    }
+  };
+  std::vector<scalar_t> zeros(inner, scalar_t(0));
+
+  int64_t T = at::get_num_threads();
+  if (outer >= T || N * inner < at::internal::GRAIN_SIZE) {
+    // parallel on the outer dimensions, of which each is scanned one pass
+    int64_t grain_size =
+        std::max(int64_t(1), at::internal::GRAIN_SIZE / (N * inner));
+    at::parallel_for(0, outer, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t o = begin; o < end; o++) {
+        scan_rows(o, 0, N, zeros.data());
+      }
+    });
+    return;
+  }
+
+  // parallel on the chunks of the scanned dimension in two phases: the sums
+  // of the rows of each chunk first, then the scan of each chunk from the
+  // exclusive scan of the sums of the chunks before it
+  int64_t num_chunks = std::min(T, N);
+  int64_t chunk_size = divup(N, num_chunks);
+  std::vector<scalar_t> chunk_sums(num_chunks * inner);
+  std::vector<scalar_t> chunk_offsets(num_chunks * inner, scalar_t(0));
+  for (int64_t o = 0; o < outer; o++) {
+    const scalar_t* self_ptr = self_data + o * N * inner;
+    at::parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t c = begin; c < end; c++) {
+        scalar_t* sum_ptr = chunk_sums.data() + c * inner;
+        std::fill(sum_ptr, sum_ptr + inner, scalar_t(0));
+        int64_t n_end = std::min((c + 1) * chunk_size, N);
+        for (int64_t n = c * chunk_size; n < n_end; n++) {
+          at::vec::map2(add, sum_ptr, sum_ptr, self_ptr + n * inner, inner);
+        }
+      }
+    });
+
+    // the exclusive scan of the sums of the chunks, of which the offset of
+    // the first chunk is 0
+    for (int64_t c = 1; c < num_chunks; c++) {
+      at::vec::map2(
+          add,
+          chunk_offsets.data() + c * inner,
+          chunk_offsets.data() + (c - 1) * inner,
+          chunk_sums.data() + (c - 1) * inner,
+          inner);
+    }
+
+    at::parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t c = begin; c < end; c++) {
+        scan_rows(
+            o,
+            std::min(c * chunk_size, N),
+            std::min((c + 1) * chunk_size, N),
+            chunk_offsets.data() + c * inner);
+      }
+    });
+  }
+}
+
+enum CumsumFallback {
+  kNotContiguous,
+  kScalar,
+  kDtypeMismatch,
+  kUnsupportedDtype,
+};
+
+static fast_path::FastPathCounter cumsum_counter(
+    "cumsum",
+    {"not_contiguous", "scalar", "dtype_mismatch", "unsupported_dtype"});
+
 bool cumsum_fast_path(
     const at::Tensor& self,
     const at::Tensor& result,
@@ -169,21 +294,21 @@ bool cumsum_fast_path(
   // check contiguous
   bool is_contig = self.is_contiguous() && (result.is_contiguous());
   if (!is_contig)
-    return false;
+    return cumsum_counter.fallback(kNotContiguous);
   // check dim
-  auto wrap_dim = at::maybe_wrap_dim(dim, self.dim());
-  if (wrap_dim != self.dim() - 1)
-    return false;
+  if (self.dim() == 0)
+    return cumsum_counter.fallback(kScalar);
   // check dtype matched
   auto out_dtype = result.scalar_type();
   if (dtype.has_value() && out_dtype != dtype.value())
-    return false;
+    return cumsum_counter.fallback(kDtypeMismatch);
   // check dtype enabled
   bool is_dtype_enabled = out_dtype == at::ScalarType::Double ||
-      out_dtype == at::ScalarType::Float || out_dtype == at::ScalarType::Long;
+      out_dtype == at::ScalarType::Float || out_dtype == at::ScalarType::Long ||
+      out_dtype == at::ScalarType::Int;
   if (!is_dtype_enabled)
-    return false;
-  return true;
+    return cumsum_counter.fallback(kUnsupportedDtype);
+  return cumsum_counter.hit();
 }
 
 class NewCumSumOp : public torch::autograd::Function<NewCumSumOp> {
@@ -193,16 +318,24 @@ class NewCumSumOp : public torch::autograd::Function<NewCumSumOp> {
       const at::Tensor& self,
       int64_t dim,
       c10::optional<at::ScalarType> dtype) {
-#if defined(IPEX_PROFILE_OP)
-    RECORD_FUNCTION("IPEXCumSumOp::_forward", std::vector<c10::IValue>({}));
-#endif
+    IPEX_RECORD_FUNCTION(
+        "IPEXCumSumOp::_forward", std::vector<c10::IValue>({}));
     if (result.sizes() != self.sizes()) {
       at::native::resize_output(result, self.sizes());
     }
     if (cumsum_fast_path(result, self, dim, dtype)) {
-      AT_DISPATCH_FLOATING_TYPES_AND(
-          at::ScalarType::Long, self.scalar_type(), "cumsum_lastdim_cpu", [&] {
-            cumsum_lastdim_kernel<scalar_t>(result, self, dim);
+      auto wrap_dim = at::maybe_wrap_dim(dim, self.dim());
+      AT_DISPATCH_FLOATING_TYPES_AND2(
+          at::ScalarType::Long,
+          at::ScalarType::Int,
+          self.scalar_type(),
+          "cumsum_cpu",
+          [&] {
+            if (wrap_dim == self.dim() - 1) {
+              cumsum_lastdim_kernel<scalar_t>(result, self, wrap_dim);
+            } else {
+              cumsum_dim_kernel<scalar_t>(result, self, wrap_dim);
+            }
           });
       return result;
     }
@@ -215,9 +348,7 @@ class NewCumSumOp : public torch::autograd::Function<NewCumSumOp> {
       const at::Tensor& self,
       int64_t dim,
       c10::optional<at::ScalarType> dtype) {
-#if defined(IPEX_PROFILE_OP)
-    RECORD_FUNCTION("IPEXCumSumOp::forward", std::vector<c10::IValue>({}));
-#endif
+    IPEX_RECORD_FUNCTION("IPEXCumSumOp::forward", std::vector<c10::IValue>({}));
     at::AutoNonVariableTypeMode g;
     ctx->saved_data["dim"] = dim;
     auto ret = _forward(result, self, dim, dtype);
@@ -227,9 +358,8 @@ class NewCumSumOp : public torch::autograd::Function<NewCumSumOp> {
   static torch::autograd::tensor_list backward(
       torch::autograd::AutogradContext* ctx,
       torch::autograd::tensor_list grad_outputs) {
-#if defined(IPEX_PROFILE_OP)
-    RECORD_FUNCTION("IPEXCumSumOp::backward", std::vector<c10::IValue>({}));
-#endif
+    IPEX_RECORD_FUNCTION(
+        "IPEXCumSumOp::backward", std::vector<c10::IValue>({}));
     at::AutoNonVariableTypeMode g;
     int64_t dim = ctx->saved_data["dim"].toInt();
 
@@ -279,6 +409,92 @@ at::Tensor& cumsum_out(
   return result;
 }
 
+// dst = the inclusive scan of src of n elements, of the chunks of the threads
+// in two phases as the ones of cumsum_dim_kernel
+template <typename src_t, typename dst_t>
+static inline void parallel_prefix_sum(
+    const src_t* src,
+    dst_t* dst,
+    int64_t n) {
+  int64_t num_chunks = std::min(
+      int64_t(at::get_num_threads()), divup(n, at::internal::GRAIN_SIZE));
+  if (num_chunks <= 1) {
+    dst_t sum = dst_t(0);
+    for (int64_t i = 0; i < n; i++) {
+      sum += dst_t(src[i]);
+      dst[i] = sum;
+    }
+    return;
+  }
+
+  int64_t chunk_size = divup(n, num_chunks);
+  std::vector<dst_t> chunk_offsets(num_chunks + 1, dst_t(0));
+  at::parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      dst_t sum = dst_t(0);
+      int64_t i_end = std::min((c + 1) * chunk_size, n);
+      for (int64_t i = c * chunk_size; i < i_end; i++) {
+        sum += dst_t(src[i]);
+      }
+      chunk_offsets[c + 1] = sum;
+    }
+  });
+  for (int64_t c = 1; c <= num_chunks; c++) {
+    chunk_offsets[c] += chunk_offsets[c - 1];
+  }
+  at::parallel_for(0, num_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      int64_t i_begin = std::min(c * chunk_size, n);
+      int64_t i_end = std::min((c + 1) * chunk_size, n);
+      dst_t sum = chunk_offsets[c];
+      for (int64_t i = i_begin; i < i_end; i++) {
+        sum += dst_t(src[i]);
+        dst[i] = sum;
+      }
+    }
+  });
+}
+
+at::Tensor lengths_to_offsets(
+    const at::Tensor& lengths,
+    bool include_last_offset,
+    c10::optional<at::ScalarType> dtype) {
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::lengths_to_offsets", std::vector<c10::IValue>({}));
+  TORCH_CHECK(
+      lengths.dim() == 1,
+      "lengths_to_offsets: expect lengths to be 1-D, got ",
+      lengths.dim(),
+      "-D");
+  auto out_dtype = dtype.value_or(lengths.scalar_type());
+  TORCH_CHECK(
+      (lengths.scalar_type() == at::kInt ||
+       lengths.scalar_type() == at::kLong) &&
+          (out_dtype == at::kInt || out_dtype == at::kLong),
+      "lengths_to_offsets: expect int32 or int64 lengths and offsets");
+
+  // offsets[0] = 0 and offsets[i + 1] = sum(lengths[0:i + 1]), of which the
+  // last one is the total number of the indices
+  int64_t n = lengths.numel();
+  auto offsets = at::empty(
+      {include_last_offset ? n + 1 : n}, lengths.options().dtype(out_dtype));
+  if (offsets.numel() == 0) {
+    return offsets;
+  }
+  auto lengths_ = lengths.contiguous();
+  AT_DISPATCH_INDEX_TYPES(lengths_.scalar_type(), "lengths_to_offsets", [&] {
+    using src_t = index_t;
+    const src_t* lengths_data = lengths_.data_ptr<src_t>();
+    AT_DISPATCH_INDEX_TYPES(out_dtype, "lengths_to_offsets", [&] {
+      index_t* offsets_data = offsets.data_ptr<index_t>();
+      offsets_data[0] = index_t(0);
+      parallel_prefix_sum<src_t, index_t>(
+          lengths_data, offsets_data + 1, offsets.numel() - 1);
+    });
+  });
+  return offsets;
+}
+
 } // namespace torch_ipex
 
 namespace {
@@ -295,6 +511,10 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
       "cumsum.out(Tensor self, int dim, *, ScalarType? dtype=None, "
       "Tensor(a!) out) -> Tensor(a!)",
       torch_ipex::cumsum_out);
+  m.def(
+      "lengths_to_offsets(Tensor lengths, bool include_last_offset=True, *, "
+      "ScalarType? dtype=None) -> Tensor",
+      torch_ipex::lengths_to_offsets);
 }
 
 } // namespace
@@ -9,4 +9,12 @@ at::Tensor cumsum_impl(
     int64_t dim,
     c10::optional<at::ScalarType> dtype);
 
+// The offsets of the bags of the given lengths, i.e. the exclusive cumsum of
+// them with the total length appended if include_last_offset, of the dtype of
+// the lengths by default.
+at::Tensor lengths_to_offsets(
+    const at::Tensor& lengths,
+    bool include_last_offset,
+    c10::optional<at::ScalarType> dtype);
+
 } // namespace torch_ipex
@@ -0,0 +1,393 @@
+#include "DecodeAttention.h"
+#include <ATen/Parallel.h>
+#include <torch/extension.h>
+#include "utils/float_vec.h"
+#include "csrc/utils/op_trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+// dot(q, k) of the float query and a cached row of float or bfloat16
+template <typename cache_t>
+inline float row_dot(const float* q, const cache_t* k, int64_t D) {
+  fVec acc = fVec(0.f);
+  int64_t d = 0;
+  for (; d < D - (D % kFloatVecPairSize); d += kFloatVecPairSize) {
+    fVec q_fvec0, q_fvec1, k_fvec0, k_fvec1;
+    load_fvec(q + d, q_fvec0, q_fvec1);
+    load_fvec(k + d, k_fvec0, k_fvec1);
+    acc = acc + q_fvec0 * k_fvec0 + q_fvec1 * k_fvec1;
+  }
+  float sum = sum_fvec(acc);
+  for (; d < D; d++) {
+    sum += q[d] * float(k[d]);
+  }
+  return sum;
+}
+
+// the int8 row, of which the scale is applied by the caller
+inline float row_dot(const float* q, const int8_t* k, int64_t D) {
+  float sum = 0.f;
+  for (int64_t d = 0; d < D; d++) {
+    sum += q[d] * float(k[d]);
+  }
+  return sum;
+}
+
+// acc += a * v of a cached row of float or bfloat16
+template <typename cache_t>
+inline void row_axpy(float a, const cache_t* v, float* acc, int64_t D) {
+  fVec a_fvec = fVec(a);
+  int64_t d = 0;
+  for (; d < D - (D % kFloatVecPairSize); d += kFloatVecPairSize) {
+    fVec v_fvec0, v_fvec1, acc_fvec0, acc_fvec1;
+    load_fvec(v + d, v_fvec0, v_fvec1);
+    load_fvec(acc + d, acc_fvec0, acc_fvec1);
+    store_fvec(
+        acc + d, acc_fvec0 + a_fvec * v_fvec0, acc_fvec1 + a_fvec * v_fvec1);
+  }
+  for (; d < D; d++) {
+    acc[d] += a * float(v[d]);
+  }
+}
+
+inline void row_axpy(float a, const int8_t* v, float* acc, int64_t D) {
+  for (int64_t d = 0; d < D; d++) {
+    acc[d] += a * float(v[d]);
+  }
+}
+
+inline void row_scale(float* acc, float s, int64_t D) {
+  fVec s_fvec = fVec(s);
+  int64_t d = 0;
+  for (; d < D - (D % kFloatVecPairSize); d += kFloatVecPairSize) {
+    fVec acc_fvec0, acc_fvec1;
+    load_fvec(acc + d, acc_fvec0, acc_fvec1);
+    store_fvec(acc + d, acc_fvec0 * s_fvec, acc_fvec1 * s_fvec);
+  }
+  for (; d < D; d++) {
+    acc[d] *= s;
+  }
+}
+
+// write the row of the new token to the cache of float or bfloat16
+template <typename scalar_t, typename cache_t>
+inline void store_row(
+    const scalar_t* x,
+    cache_t* out,
+    float* scale,
+    int64_t D) {
+  for (int64_t d = 0; d < D; d++) {
+    out[d] = cache_t(float(x[d]));
+  }
+}
+
+// quantize the row of the new token to the int8 cache by the scale of its
+// absolute max
+template <typename scalar_t>
+inline void store_row(
+    const scalar_t* x,
+    int8_t* out,
+    float* scale,
+    int64_t D) {
+  float absmax = 0.f;
+  for (int64_t d = 0; d < D; d++) {
+    absmax = std::max(absmax, std::abs(float(x[d])));
+  }
+  float s = absmax / 127.f;
+  float inv_s = s > 0.f ? 1.f / s : 0.f;
+  for (int64_t d = 0; d < D; d++) {
+    float q = std::nearbyint(float(x[d]) * inv_s);
+    out[d] = static_cast<int8_t>(std::min(std::max(q, -127.f), 127.f));
+  }
+  *scale = s;
+}
+
+template <typename scalar_t, typename cache_t>
+void decode_attention_kernel(
+    const at::Tensor& query,
+    const at::Tensor& key,
+    const at::Tensor& value,
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    const at::Tensor& block_table,
+    const at::Tensor& seq_lens,
+    float scale,
+    at::Tensor& key_scale,
+    at::Tensor& value_scale,
+    at::Tensor& output) {
+  constexpr bool quantized = std::is_same<cache_t, int8_t>::value;
+  const int64_t B = query.size(0);
+  const int64_t H = query.size(1);
+  const int64_t D = query.size(2);
+  const int64_t block_size = key_cache.size(2);
+  const int64_t max_blocks = block_table.size(1);
+  const scalar_t* q_data = query.data_ptr<scalar_t>();
+  const scalar_t* k_data = key.data_ptr<scalar_t>();
+  const scalar_t* v_data = value.data_ptr<scalar_t>();
+  cache_t* k_cache = key_cache.data_ptr<cache_t>();
+  cache_t* v_cache = value_cache.data_ptr<cache_t>();
+  float* k_scale = quantized ? key_scale.data_ptr<float>() : nullptr;
+  float* v_scale = quantized ? value_scale.data_ptr<float>() : nullptr;
+  const int64_t* block_table_data = block_table.data_ptr<int64_t>();
+  const int64_t* seq_lens_data = seq_lens.data_ptr<int64_t>();
+  scalar_t* out_data = output.data_ptr<scalar_t>();
+
+  at::parallel_for(0, B * H, 1, [&](int64_t begin, int64_t end) {
+    std::vector<float> q(D);
+    std::vector<float> acc(D);
+    std::vector<float> scores(block_size);
+    for (int64_t i = begin; i < end; i++) {
+      int64_t b = i / H;
+      int64_t h = i % H;
+      int64_t pos = seq_lens_data[b];
+      const int64_t* blocks = block_table_data + b * max_blocks;
+
+      // the row of the token pos of the head h is
+      // (blocks[pos / block_size] * H + h) * block_size + pos % block_size
+      int64_t row =
+          (blocks[pos / block_size] * H + h) * block_size + pos % block_size;
+      store_row(
+          k_data + i * D,
+          k_cache + row * D,
+          quantized ? k_scale + row : nullptr,
+          D);
+      store_row(
+          v_data + i * D,
+          v_cache + row * D,
+          quantized ? v_scale + row : nullptr,
+          D);
+
+      for (int64_t d = 0; d < D; d++) {
+        q[d] = float(q_data[i * D + d]) * scale;
+      }
+      std::fill(acc.begin(), acc.end(), 0.f);
+      float max = -std::numeric_limits<float>::infinity();
+      float sum = 0.f;
+      const int64_t len = pos + 1;
+      // the scores of a block at a time, then the online softmax update of
+      // the running max, sum and output by the block
+      for (int64_t j = 0; j * block_size < len; j++) {
+        const int64_t n = std::min(block_size, len - j * block_size);
+        const int64_t base = (blocks[j] * H + h) * block_size;
+        float block_max = -std::numeric_limits<float>::infinity();
+        for (int64_t t = 0; t < n; t++) {
+          float s = row_dot(q.data(), k_cache + (base + t) * D, D);
+          if (quantized) {
+            s *= k_scale[base + t];
+          }
+          scores[t] = s;
+          block_max = std::max(block_max, s);
+        }
+        float new_max = std::max(max, block_max);
+        if (max != new_max) {
+          float correction = std::exp(max - new_max);
+          sum *= correction;
+          row_scale(acc.data(), correction, D);
+          max = new_max;
+        }
+        for (int64_t t = 0; t < n; t++) {
+          float p = std::exp(scores[t] - max);
+          sum += p;
+          row_axpy(
+              quantized ? p * v_scale[base + t] : p,
+              v_cache + (base + t) * D,
+              acc.data(),
+              D);
+        }
+      }
+      for (int64_t d = 0; d < D; d++) {
+        out_data[i * D + d] = scalar_t(acc[d] / sum);
+      }
+    }
+  });
+}
+
+template <typename scalar_t>
+void decode_attention_dispatch_cache(
+    const at::Tensor& query,
+    const at::Tensor& key,
+    const at::Tensor& value,
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    const at::Tensor& block_table,
+    const at::Tensor& seq_lens,
+    float scale,
+    at::Tensor& key_scale,
+    at::Tensor& value_scale,
+    at::Tensor& output) {
+  if (key_cache.scalar_type() == at::kFloat) {
+    decode_attention_kernel<scalar_t, float>(
+        query,
+        key,
+        value,
+        key_cache,
+        value_cache,
+        block_table,
+        seq_lens,
+        scale,
+        key_scale,
+        value_scale,
+        output);
+  } else if (key_cache.scalar_type() == at::kBFloat16) {
+    decode_attention_kernel<scalar_t, at::BFloat16>(
+        query,
+        key,
+        value,
+        key_cache,
+        value_cache,
+        block_table,
+        seq_lens,
+        scale,
+        key_scale,
+        value_scale,
+        output);
+  } else {
+    decode_attention_kernel<scalar_t, int8_t>(
+        query,
+        key,
+        value,
+        key_cache,
+        value_cache,
+        block_table,
+        seq_lens,
+        scale,
+        key_scale,
+        value_scale,
+        output);
+  }
+}
+
+} // namespace
+
+at::Tensor decode_attention(
+    const at::Tensor& query,
+    const at::Tensor& key,
+    const at::Tensor& value,
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    const at::Tensor& block_table,
+    const at::Tensor& seq_lens,
+    double scale,
+    at::Tensor& key_scale,
+    at::Tensor& value_scale) {
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::decode_attention", std::vector<c10::IValue>({}));
+  TORCH_CHECK(
+      query.dim() == 3 && key.sizes() == query.sizes() &&
+          value.sizes() == query.sizes(),
+      "decode_attention: expect the query, the key and the value of [B, H, D]");
+  TORCH_CHECK(
+      query.scalar_type() == at::kFloat ||
+          query.scalar_type() == at::kBFloat16,
+      "decode_attention: only support the float and the bfloat16 query");
+  TORCH_CHECK(
+      key.scalar_type() == query.scalar_type() &&
+          value.scalar_type() == query.scalar_type(),
+      "decode_attention: expect the key and the value of the dtype of query");
+  const int64_t B = query.size(0);
+  const int64_t H = query.size(1);
+  const int64_t D = query.size(2);
+  TORCH_CHECK(
+      key_cache.dim() == 4 && key_cache.size(1) == H &&
+          key_cache.size(3) == D && value_cache.sizes() == key_cache.sizes(),
+      "decode_attention: expect the caches of [num_blocks, H, block_size, D]");
+  TORCH_CHECK(
+      key_cache.is_contiguous() && value_cache.is_contiguous(),
+      "decode_attention: expect the contiguous caches");
+  auto cache_dtype = key_cache.scalar_type();
+  TORCH_CHECK(
+      value_cache.scalar_type() == cache_dtype &&
+          (cache_dtype == at::kFloat || cache_dtype == at::kBFloat16 ||
+           cache_dtype == at::kChar),
+      "decode_attention: expect the caches of float, bfloat16 or int8");
+  const int64_t num_blocks = key_cache.size(0);
+  const int64_t block_size = key_cache.size(2);
+  if (cache_dtype == at::kChar) {
+    TORCH_CHECK(
+        key_scale.sizes() == key_cache.sizes().slice(0, 3) &&
+            value_scale.sizes() == key_scale.sizes() &&
+            key_scale.scalar_type() == at::kFloat &&
+            value_scale.scalar_type() == at::kFloat &&
+            key_scale.is_contiguous() && value_scale.is_contiguous(),
+        "decode_attention: expect the float scales of the int8 caches of ",
+        "[num_blocks, H, block_size]");
+  }
+  TORCH_CHECK(
+      block_table.dim() == 2 && block_table.size(0) == B &&
+          seq_lens.dim() == 1 && seq_lens.size(0) == B,
+      "decode_attention: expect the block_table of [B, max_blocks_per_seq] ",
+      "and the seq_lens of [B]");
+  auto block_table_ = block_table.to(at::kLong).contiguous();
+  auto seq_lens_ = seq_lens.to(at::kLong).contiguous();
+  auto output = at::empty_like(query, at::MemoryFormat::Contiguous);
+  if (query.numel() == 0) {
+    return output;
+  }
+  // the new token is at seq_lens, in the blocks allocated to the sequence
+  TORCH_CHECK(
+      seq_lens_.min().item<int64_t>() >= 0 &&
+          seq_lens_.max().item<int64_t>() <
+              block_table_.size(1) * block_size,
+      "decode_attention: the sequences are out of their blocks");
+  TORCH_CHECK(
+      block_table_.min().item<int64_t>() >= 0 &&
+          block_table_.max().item<int64_t>() < num_blocks,
+      "decode_attention: the block_table is out of the caches");
+
+  auto query_ = query.contiguous();
+  auto key_ = key.contiguous();
+  auto value_ = value.contiguous();
+  if (query.scalar_type() == at::kBFloat16) {
+    decode_attention_dispatch_cache<at::BFloat16>(
+        query_,
+        key_,
+        value_,
+        key_cache,
+        value_cache,
+        block_table_,
+        seq_lens_,
+        static_cast<float>(scale),
+        key_scale,
+        value_scale,
+        output);
+  } else {
+    decode_attention_dispatch_cache<float>(
+        query_,
+        key_,
+        value_,
+        key_cache,
+        value_cache,
+        block_table_,
+        seq_lens_,
+        static_cast<float>(scale),
+        key_scale,
+        value_scale,
+        output);
+  }
+  return output;
+}
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "decode_attention(Tensor query, Tensor key, Tensor value, "
+      "Tensor(a!) key_cache, Tensor(b!) value_cache, Tensor block_table, "
+      "Tensor seq_lens, float scale, Tensor(c!) key_scale, "
+      "Tensor(d!) value_scale) -> Tensor",
+      torch_ipex::cpu::decode_attention);
+}
+
+} // namespace
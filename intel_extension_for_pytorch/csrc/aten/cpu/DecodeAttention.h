@@ -0,0 +1,36 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+namespace torch_ipex {
+namespace cpu {
+
+// The attention of a decode step of the autoregressive generation, of the
+// single query of each sequence over its paged KV cache. The key and the
+// value of the new token are appended in place to the cache at seq_lens, and
+// the query attends to the seq_lens + 1 cached tokens block by block by the
+// online softmax, so that a step reads the cache once and nothing of the
+// cache is reallocated or concatenated.
+//
+// query, key, value: [B, H, D] of the new token of each sequence
+// key_cache, value_cache: [num_blocks, H, block_size, D] of float, bfloat16
+//   or int8, shared by the sequences by block_table
+// block_table: [B, max_blocks_per_seq] of the blocks of each sequence
+// seq_lens: [B] of the tokens of each sequence in the cache before the step
+// key_scale, value_scale: [num_blocks, H, block_size] of the float scales of
+//   the int8 cache, quantized per token and head, unused otherwise
+// returns the [B, H, D] output of the dtype of query
+at::Tensor decode_attention(
+    const at::Tensor& query,
+    const at::Tensor& key,
+    const at::Tensor& value,
+    at::Tensor& key_cache,
+    at::Tensor& value_cache,
+    const at::Tensor& block_table,
+    const at::Tensor& seq_lens,
+    double scale,
+    at::Tensor& key_scale,
+    at::Tensor& value_scale);
+
+} // namespace cpu
+} // namespace torch_ipex
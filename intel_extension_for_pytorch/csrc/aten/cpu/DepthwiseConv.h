@@ -0,0 +1,43 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+#include "csrc/cpu/dispatch/DispatchStub.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+// the activations of the direct depthwise kernel
+enum class DepthwiseActivation { kNone, kRelu, kClamp, kSwish, kHardswish };
+
+struct DepthwiseConvParams {
+  int64_t kernel_h = 1;
+  int64_t kernel_w = 1;
+  int64_t stride_h = 1;
+  int64_t stride_w = 1;
+  int64_t pad_h = 0;
+  int64_t pad_w = 0;
+  int64_t dilation_h = 1;
+  int64_t dilation_w = 1;
+  DepthwiseActivation activation = DepthwiseActivation::kNone;
+  // the bounds of kClamp
+  float min = 0.f;
+  float max = 0.f;
+};
+
+// output = activation(depthwise_conv(input) + bias) of the output rows
+// [row_begin, row_begin + output.size(2)) of all the images of input, of the
+// float channels last input [N, C, H, W] and output [N, C, rows, OW], the
+// weight [kernel_h * kernel_w, C] and the bias [C], undefined if none. The
+// channels are vectorized, so that the taps of a pixel are contiguous loads.
+using depthwise_conv_kernel_fn = void (*)(
+    const at::Tensor& input,
+    const at::Tensor& weight,
+    const at::Tensor& bias,
+    at::Tensor& output,
+    int64_t row_begin,
+    const DepthwiseConvParams& params);
+IPEX_DECLARE_DISPATCH(depthwise_conv_kernel_fn, depthwise_conv_kernel_stub);
+
+} // namespace cpu
+} // namespace torch_ipex
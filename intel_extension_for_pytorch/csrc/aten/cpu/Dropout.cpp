@@ -0,0 +1,118 @@
+#include "Dropout.h"
+
+#include <ATen/CPUGeneratorImpl.h>
+#include <torch/extension.h>
+
+#include "csrc/utils/op_trace.h"
+#include "utils/philox.h"
+
+#include <mutex>
+
+namespace torch_ipex {
+namespace cpu {
+
+IPEX_DEFINE_DISPATCH(dropout_mask_kernel_stub);
+IPEX_DEFINE_DISPATCH(dropout_apply_kernel_stub);
+
+namespace {
+
+bool is_fused_dtype(const at::Tensor& input) {
+  return input.scalar_type() == at::kFloat ||
+      input.scalar_type() == at::kBFloat16;
+}
+
+// 1 / (1 - p) of the kept elements
+float dropout_scale(double p) {
+  return p < 1 ? 1.f / (1.f - static_cast<float>(p)) : 0.f;
+}
+
+} // namespace
+
+uint64_t dropout_seed() {
+  auto gen = at::get_generator_or_default<at::CPUGeneratorImpl>(
+      c10::nullopt, at::detail::getDefaultCPUGenerator());
+  std::lock_guard<std::mutex> lock(gen->mutex_);
+  return gen->random64();
+}
+
+at::Tensor generate_dropout_mask(int64_t numel, double p, uint64_t seed) {
+  const int64_t blocks =
+      (numel + philox::kBlockSize - 1) / philox::kBlockSize;
+  auto mask = at::empty({blocks * philox::kBlockSize / 8}, at::kByte);
+  dropout_mask_kernel_stub(
+      seed, philox::threshold_of(1 - p), numel, mask.data_ptr<uint8_t>());
+  return mask;
+}
+
+at::Tensor IPEXDropoutOp::_forward(
+    const at::Tensor& input,
+    double p,
+    bool train) {
+  IPEX_RECORD_FUNCTION("IPEXDropoutOp::_forward", std::vector<c10::IValue>({}));
+  auto input_ = input.contiguous();
+  auto mask = generate_dropout_mask(input_.numel(), p, dropout_seed());
+  auto output = at::empty_like(input_);
+  dropout_apply_kernel_stub(input_, mask, dropout_scale(p), output);
+  return output;
+}
+
+at::Tensor IPEXDropoutOp::forward(
+    torch::autograd::AutogradContext* ctx,
+    const at::Tensor& input,
+    double p,
+    bool train) {
+  IPEX_RECORD_FUNCTION("IPEXDropoutOp::forward", std::vector<c10::IValue>({}));
+  auto input_ = input.contiguous();
+  auto mask = generate_dropout_mask(input_.numel(), p, dropout_seed());
+  float scale = dropout_scale(p);
+  auto output = at::empty_like(input_);
+  dropout_apply_kernel_stub(input_, mask, scale, output);
+  // only the bits of the mask are saved, of 1 / 32 of the bytes of the float
+  // input
+  ctx->saved_data["scale"] = static_cast<double>(scale);
+  ctx->save_for_backward({mask});
+  return output;
+}
+
+torch::autograd::variable_list IPEXDropoutOp::backward(
+    torch::autograd::AutogradContext* ctx,
+    torch::autograd::variable_list grad_outputs) {
+  IPEX_RECORD_FUNCTION("IPEXDropoutOp::backward", std::vector<c10::IValue>({}));
+  auto saved = ctx->get_saved_variables();
+  at::Tensor mask = saved[0];
+  float scale = static_cast<float>(ctx->saved_data["scale"].toDouble());
+  auto grad_output = grad_outputs[0].contiguous();
+  auto grad_input = at::empty_like(grad_output);
+  dropout_apply_kernel_stub(grad_output, mask, scale, grad_input);
+  return {grad_input, at::Tensor(), at::Tensor()};
+}
+
+at::Tensor dropout(const at::Tensor& input, double p, bool train) {
+  TORCH_CHECK(
+      p >= 0 && p <= 1,
+      "dropout probability has to be between 0 and 1, but got ",
+      p);
+  if (!train || p == 0 || input.numel() == 0) {
+    return input;
+  }
+  if (!is_fused_dtype(input)) {
+    return at::dropout(input, p, train);
+  }
+  if (at::GradMode::is_enabled()) {
+    return IPEXDropoutOp::apply(input, p, train);
+  }
+  return IPEXDropoutOp::_forward(input, p, train);
+}
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "dropout(Tensor input, float p, bool train) -> Tensor",
+      torch_ipex::cpu::dropout);
+}
+
+} // namespace
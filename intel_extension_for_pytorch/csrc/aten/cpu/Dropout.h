@@ -0,0 +1,63 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+#include <torch/csrc/autograd/custom_function.h>
+
+#include "csrc/cpu/dispatch/DispatchStub.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+// The dropout of the training, of which the mask is kept of 1 bit per
+// element, instead of the float mask of the input dtype of aten::dropout, and
+// is generated by the counter-based Philox of the vectors of the kernel
+// instead of the scalar Mersenne Twister of the ATen generator. The seed of
+// each call is drawn from the default CPU generator, so that torch.manual_seed
+// reproduces the masks.
+at::Tensor dropout(const at::Tensor& input, double p, bool train);
+
+// The seed of the mask of a dropout, of the default CPU generator.
+uint64_t dropout_seed();
+
+// The uint8 mask of numel elements, of which the bit i % 8 of the byte i / 8
+// is whether the element i is kept, with the probability 1 - p. It is padded
+// to the blocks of the Philox.
+at::Tensor generate_dropout_mask(int64_t numel, double p, uint64_t seed);
+
+// Whether the element i of the mask of generate_dropout_mask is kept.
+inline bool dropout_mask_bit(const uint8_t* mask, int64_t i) {
+  return (mask[i >> 3] >> (i & 7)) & 1;
+}
+
+// The mask bits of the elements [0, numel) of the Philox of seed, of which an
+// element is kept if its output is below threshold
+using dropout_mask_kernel_fn =
+    void (*)(uint64_t, uint32_t, int64_t, uint8_t*);
+IPEX_DECLARE_DISPATCH(dropout_mask_kernel_fn, dropout_mask_kernel_stub);
+
+// dst = src * scale of the elements kept by the mask, and 0 of the others, of
+// the contiguous fp32/bf16 src and dst, i.e. the forward of the dropout and
+// its backward
+using dropout_apply_kernel_fn =
+    void (*)(const at::Tensor&, const at::Tensor&, float, at::Tensor&);
+IPEX_DECLARE_DISPATCH(dropout_apply_kernel_fn, dropout_apply_kernel_stub);
+
+class IPEXDropoutOp : public torch::autograd::Function<IPEXDropoutOp> {
+ public:
+  // forward function without autograd overhead, will go this way when only do
+  // forward
+  static at::Tensor _forward(const at::Tensor& input, double p, bool train);
+
+  static at::Tensor forward(
+      torch::autograd::AutogradContext* ctx,
+      const at::Tensor& input,
+      double p,
+      bool train);
+
+  static torch::autograd::variable_list backward(
+      torch::autograd::AutogradContext* ctx,
+      torch::autograd::variable_list grad_outputs);
+};
+
+} // namespace cpu
+} // namespace torch_ipex
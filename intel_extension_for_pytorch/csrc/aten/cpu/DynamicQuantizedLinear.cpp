@@ -0,0 +1,195 @@
+#include "DynamicQuantizedLinear.h"
+#include "PackedWeightSerialization.h"
+#include "WeightOnlyQuantizedLinear.h"
+
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/vec.h>
+#include <c10/util/Exception.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "csrc/cpu/ideep/IDeepConversions.h"
+#include "csrc/quantization/Observer.hpp"
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+using Vec = at::vec::Vectorized<float>;
+
+// q = clamp(round(x / scale) + zero_point, 0, 255)
+void quantize_u8_kernel(
+    const at::Tensor& input,
+    float scale,
+    int64_t zero_point,
+    at::Tensor& output) {
+  const float* input_data = input.data_ptr<float>();
+  uint8_t* output_data = output.data_ptr<uint8_t>();
+  const float inv_scale = 1.f / scale;
+  at::parallel_for(0, input.numel(), 2048, [&](int64_t begin, int64_t end) {
+    const Vec inv_scale_vec(inv_scale);
+    const Vec zero_point_vec(static_cast<float>(zero_point));
+    const Vec q_min_vec(0.f);
+    const Vec q_max_vec(255.f);
+    float values[Vec::size()];
+    int64_t d = begin;
+    for (; d < end - ((end - begin) % Vec::size()); d += Vec::size()) {
+      auto q_vec = (Vec::loadu(input_data + d) * inv_scale_vec).round() +
+          zero_point_vec;
+      at::vec::clamp(q_vec, q_min_vec, q_max_vec).store(values);
+      for (int64_t i = 0; i < Vec::size(); i++) {
+        output_data[d + i] = static_cast<uint8_t>(values[i]);
+      }
+    }
+    for (; d < end; d++) {
+      auto q = std::nearbyint(input_data[d] * inv_scale) + zero_point;
+      output_data[d] =
+          static_cast<uint8_t>(std::min(std::max(q, 0.f), 255.f));
+    }
+  });
+}
+
+// Returns the fp32 result of the linear and the post ops of attr, accumu is
+// the destination of the sum post op.
+at::Tensor dq_linear_impl(
+    const at::Tensor& self,
+    const ideep::tensor& weight_packed,
+    const at::Tensor& weight_compensation,
+    const at::Tensor& bias,
+    const at::Tensor& accumu,
+    const ideep::attr_t& attr) {
+  const int64_t K = weight_packed.get_dim(1);
+  TORCH_CHECK(
+      self.size(-1) == K,
+      "dq_linear: the input features don't match the weight");
+  auto input = self.reshape({-1, K}).to(at::kFloat).contiguous();
+  const int64_t M = input.size(0);
+
+  // the u8 quantization parameters of the input by its range
+  auto min_max = torch_ipex::int8::compute_min_max(input);
+  auto qparams = quant_utils::ChooseQuantizationParams(
+      /*min*/ min_max[0],
+      /*max*/ min_max[1],
+      /*q_min*/ 0,
+      /*q_max*/ 255,
+      /*preserve_sparsity=*/false);
+  auto input_u8 = at::empty({M, K}, input.options().dtype(at::kByte));
+  quantize_u8_kernel(input, qparams.scale, qparams.zero_point, input_u8);
+
+  // The output scales of the primitive dequantize the s32 output, i.e.
+  // output[m, n] = input_scale * weight_scales[n] * sum_k(q_input * q_weight)
+  ideep::tensor mkldnn_input(
+      {{M, K}, ideep::tensor::data_type::u8, ideep::format_tag::ab},
+      input_u8.data_ptr());
+  auto output = at::empty(
+      {M, weight_packed.get_dim(0)}, input.options().dtype(at::kFloat));
+  ideep::tensor mkldnn_output = itensor_view_from_dense(output);
+  ideep::inner_product_forward::compute(
+      mkldnn_input,
+      weight_packed,
+      mkldnn_output,
+      /*src_scales*/ {1.f / qparams.scale});
+
+  // subtract the zero point of the input times the weight row sums, and add
+  // the bias, in one pass over the output
+  auto shift = weight_compensation.mul(-qparams.scale * qparams.zero_point);
+  if (bias.defined()) {
+    shift.add_(bias.to(at::kFloat));
+  }
+  output.add_(shift);
+  return quantized_linear_post_ops(output, accumu, attr);
+}
+
+// The s8 format of the weight [N, K] preferred by the u8s8 inner product.
+ideep::tensor::desc packed_weight_desc(
+    int64_t N,
+    int64_t K,
+    int64_t batch_size) {
+  return ideep::inner_product_forward::expected_weights_desc(
+      {N, K},
+      {batch_size, K},
+      /* weight dtype */ ideep::tensor::data_type::s8,
+      /* src dtype */ ideep::tensor::data_type::u8);
+}
+
+void set_weight_scales(
+    ideep::tensor& weight_packed,
+    const at::Tensor& weight_scales) {
+  auto scales = weight_scales.to(at::kFloat).reciprocal().contiguous();
+  weight_packed.set_scale(ideep::scale_t(
+      scales.data_ptr<float>(), scales.data_ptr<float>() + scales.numel()));
+}
+
+} // namespace
+
+ideep::tensor pack_dynamic_quantized_linear_weight(
+    const at::Tensor& weight_int8,
+    const at::Tensor& weight_scales,
+    int64_t batch_size) {
+  TORCH_CHECK(
+      weight_int8.scalar_type() == at::kChar && weight_int8.dim() == 2 &&
+          weight_int8.is_contiguous(),
+      "dq_linear: the weight must be a contiguous 2-D int8 tensor");
+  const int64_t N = weight_int8.size(0);
+  const int64_t K = weight_int8.size(1);
+  ideep::tensor weight(
+      {{N, K}, ideep::tensor::data_type::s8, ideep::format_tag::ab},
+      weight_int8.data_ptr());
+  ideep::tensor weight_packed;
+  weight_packed.init(packed_weight_desc(N, K, batch_size));
+  weight_packed.feed_from(weight);
+  set_weight_scales(weight_packed, weight_scales);
+  return weight_packed;
+}
+
+ideep::tensor load_dynamic_quantized_linear_weight(
+    const at::Tensor& serialized_weight,
+    const at::Tensor& weight_scales,
+    int64_t out_features,
+    int64_t in_features,
+    int64_t batch_size) {
+  auto weight_packed = load_serialized_packed_weight(
+      serialized_weight,
+      packed_weight_desc(out_features, in_features, batch_size));
+  set_weight_scales(weight_packed, weight_scales);
+  return weight_packed;
+}
+
+at::Tensor dynamic_quantized_linear_compensation(
+    const at::Tensor& weight_int8,
+    const at::Tensor& weight_scales) {
+  return weight_int8.sum(1, /*keepdim*/ false, at::kFloat)
+      .mul_(weight_scales.to(at::kFloat))
+      .contiguous();
+}
+
+at::Tensor dq_linear_kernel(
+    const at::Tensor& self,
+    const ideep::tensor& weight_packed,
+    const at::Tensor& weight_compensation,
+    const at::Tensor& bias,
+    const ideep::attr_t& attr) {
+  auto output = dq_linear_impl(
+      self, weight_packed, weight_compensation, bias, at::Tensor(), attr);
+  auto output_size = self.sizes().vec();
+  output_size.back() = weight_packed.get_dim(0);
+  return output.to(self.scalar_type()).reshape(output_size);
+}
+
+void dq_linear_kernel_output(
+    const at::Tensor& self,
+    const ideep::tensor& weight_packed,
+    const at::Tensor& weight_compensation,
+    const at::Tensor& bias,
+    at::Tensor& output,
+    const ideep::attr_t& attr) {
+  auto result = dq_linear_impl(
+      self, weight_packed, weight_compensation, bias, output, attr);
+  output.copy_(result.reshape(output.sizes()));
+}
+
+} // namespace cpu
+} // namespace torch_ipex
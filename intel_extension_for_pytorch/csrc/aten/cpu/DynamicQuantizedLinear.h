@@ -0,0 +1,58 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+#include "csrc/cpu/ideep/ideep.hpp"
+
+namespace torch_ipex {
+namespace cpu {
+
+// Pack the per-channel int8 weight [out_features, in_features] of the dynamic
+// quantized linear to the s8 format of the u8s8 inner product of oneDNN for
+// the batch size. The scales of the packed weight are the reciprocals of
+// weight_scales, as ideep expects.
+ideep::tensor pack_dynamic_quantized_linear_weight(
+    const at::Tensor& weight_int8,
+    const at::Tensor& weight_scales,
+    int64_t batch_size);
+
+// Restore the packed s8 weight of the dynamic quantized linear saved by the
+// packed weight serialization in the format preferred for the batch size, and
+// set the reciprocals of its weight_scales, so that no weight is quantized.
+ideep::tensor load_dynamic_quantized_linear_weight(
+    const at::Tensor& serialized_weight,
+    const at::Tensor& weight_scales,
+    int64_t out_features,
+    int64_t in_features,
+    int64_t batch_size);
+
+// The compensation of the zero point of the u8 input, i.e. the sum of each int8
+// weight row multiplied by its scale, which is subtracted from the output.
+at::Tensor dynamic_quantized_linear_compensation(
+    const at::Tensor& weight_int8,
+    const at::Tensor& weight_scales);
+
+// Linear of which the fp32/bf16 input is quantized to u8 on each call with
+// the range of the input, and run by the u8s8 inner product of oneDNN with the
+// packed s8 weight, which dequantizes the s32 output to fp32 by its output
+// scales. It needs no calibration, since the input range is computed on the
+// fly. The post ops of attr (sum, relu and gelu) are applied to the output.
+at::Tensor dq_linear_kernel(
+    const at::Tensor& self,
+    const ideep::tensor& weight_packed,
+    const at::Tensor& weight_compensation,
+    const at::Tensor& bias,
+    const ideep::attr_t& attr);
+
+// The inplace version of dq_linear_kernel, the result is written into output,
+// e.g. Linear+Add fusion.
+void dq_linear_kernel_output(
+    const at::Tensor& self,
+    const ideep::tensor& weight_packed,
+    const at::Tensor& weight_compensation,
+    const at::Tensor& bias,
+    at::Tensor& output,
+    const ideep::attr_t& attr);
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,112 @@
+#include "Gemv.h"
+
+#include <ATen/Parallel.h>
+
+#include <cstring>
+
+#include "csrc/cpu/ideep/IDeepConversions.h"
+#include "csrc/utils/fast_path_stats.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+IPEX_DEFINE_DISPATCH(gemv_kernel_stub);
+
+enum GemvFallback {
+  kUnsupportedDtype,
+  kTooManyRows,
+  kNotPlainWeight,
+  kNotContiguous,
+  kUnsupportedPostOp,
+};
+
+static fast_path::FastPathCounter gemv_counter(
+    "gemv",
+    {"unsupported_dtype",
+     "too_many_rows",
+     "not_plain_weight",
+     "not_contiguous",
+     "unsupported_post_op"});
+
+ideep::tensor pack_gemv_weight(const ideep::tensor& packed_weight) {
+  const int64_t out_features = packed_weight.get_dim(0);
+  const int64_t in_features = packed_weight.get_dim(1);
+  const auto dtype = packed_weight.get_data_type();
+  ideep::tensor weight{ideep::tensor::desc(
+      {out_features, in_features}, dtype, ideep::format_tag::ab)};
+  const int64_t row_bytes =
+      out_features == 0 ? 0 : weight.get_size() / out_features;
+  auto plain = at::empty({out_features * row_bytes}, at::kByte);
+  packed_weight.to_public(plain.data_ptr(), dtype);
+  const char* src = static_cast<const char*>(plain.data_ptr());
+  char* dst = static_cast<char*>(weight.get_data_handle());
+  // the pages of the slice of each thread are first touched by the thread
+  at::parallel_for(
+      0,
+      out_features,
+      kGemvMinChannelsPerThread,
+      [&](int64_t begin, int64_t end) {
+        std::memcpy(
+            dst + begin * row_bytes,
+            src + begin * row_bytes,
+            (end - begin) * row_bytes);
+      });
+  return weight;
+}
+
+bool is_gemv(
+    const at::Tensor& input,
+    const ideep::tensor& weight,
+    const at::Tensor& output,
+    const ideep::attr_t& attr,
+    GemvParams& params) {
+  const auto dtype = input.scalar_type();
+  if ((dtype != at::kFloat && dtype != at::kBFloat16) ||
+      output.scalar_type() != dtype ||
+      weight.get_data_type() != get_mkldnn_dtype(dtype)) {
+    return gemv_counter.fallback(kUnsupportedDtype);
+  }
+  if (input.dim() != 2 || input.size(0) == 0 ||
+      input.size(0) > kGemvMaxRows) {
+    return gemv_counter.fallback(kTooManyRows);
+  }
+  const auto& desc = weight.get_desc();
+  if (desc.get_ndims() != 2 || !desc.is_default() ||
+      desc.get_dim(1) != input.size(1)) {
+    return gemv_counter.fallback(kNotPlainWeight);
+  }
+  if (!input.is_contiguous() || !output.is_contiguous() ||
+      output.dim() != 2 || output.size(0) != input.size(0) ||
+      output.size(1) != desc.get_dim(0)) {
+    return gemv_counter.fallback(kNotContiguous);
+  }
+  auto post_ops = attr.get_post_ops();
+  params = GemvParams();
+  if (post_ops.len() > 1) {
+    return gemv_counter.fallback(kUnsupportedPostOp);
+  }
+  if (post_ops.len() == 1) {
+    ideep::kind akind;
+    ideep::algorithm alg;
+    float scale = 1.0, alpha = 1.0, beta = 0.0;
+    std::tie(akind, scale, alpha, beta, alg) = attr.get_params(0);
+    if (akind == ideep::kind::sum) {
+      params.post_op = GemvPostOp::kSum;
+      params.sum_scale = scale;
+    } else if (akind != ideep::kind::eltwise || scale != 1.f) {
+      return gemv_counter.fallback(kUnsupportedPostOp);
+    } else if (alg == ideep::algorithm::eltwise_relu && alpha == 0.f) {
+      params.post_op = GemvPostOp::kRelu;
+    } else if (alg == ideep::algorithm::eltwise_gelu_erf) {
+      params.post_op = GemvPostOp::kGeluErf;
+    } else if (alg == ideep::algorithm::eltwise_gelu_tanh) {
+      params.post_op = GemvPostOp::kGeluTanh;
+    } else {
+      return gemv_counter.fallback(kUnsupportedPostOp);
+    }
+  }
+  return gemv_counter.hit();
+}
+
+} // namespace cpu
+} // namespace torch_ipex
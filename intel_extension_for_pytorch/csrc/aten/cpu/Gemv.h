@@ -0,0 +1,65 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+#include "csrc/cpu/dispatch/DispatchStub.h"
+#include "csrc/cpu/ideep/ideep.hpp"
+
+namespace torch_ipex {
+namespace cpu {
+
+// The most input rows of the GEMV, e.g. of the autoregressive decoding and
+// the single query recommendation, of which the linear is bound by reading
+// the weight, and each weight row is read once for all the rows
+constexpr int64_t kGemvMaxRows = 4;
+
+// The fewest output channels of a thread of the GEMV. The output channels
+// are split across the threads the same way by the GEMV and by
+// pack_gemv_weight, so that each thread reads the weight slice it touched
+// first, which is of the memory of its NUMA node.
+constexpr int64_t kGemvMinChannelsPerThread = 16;
+
+enum class GemvPostOp {
+  kNone,
+  kRelu,
+  kGeluErf,
+  kGeluTanh,
+  kSum,
+};
+
+struct GemvParams {
+  GemvPostOp post_op = GemvPostOp::kNone;
+  // output = linear + sum_scale * output of the sum post op
+  float sum_scale = 1.f;
+};
+
+// Returns the plain [out_features, in_features] copy of the packed linear
+// weight, of which the slices of the output channels of the threads of the
+// GEMV are first touched by those threads.
+ideep::tensor pack_gemv_weight(const ideep::tensor& packed_weight);
+
+// Whether output [M, N] = input [M, K] x weight^T + bias with the post ops
+// of attr runs on the GEMV: the fp32/bf16 input and output are contiguous,
+// M is at most kGemvMaxRows, the weight is the plain [N, K] of the same
+// dtype, e.g. of pack_gemv_weight, and attr is of a relu, a gelu or a sum
+// post op at most, which is returned in params.
+bool is_gemv(
+    const at::Tensor& input,
+    const ideep::tensor& weight,
+    const at::Tensor& output,
+    const ideep::attr_t& attr,
+    GemvParams& params);
+
+// output [M, N] = input [M, K] x weight [N, K]^T + bias with the post op of
+// params, of which bias is undefined or of fp32, split across the threads
+// over the output channels
+using gemv_kernel_fn = void (*)(
+    const at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&,
+    at::Tensor&,
+    const GemvParams&);
+IPEX_DECLARE_DISPATCH(gemv_kernel_fn, gemv_kernel_stub);
+
+} // namespace cpu
+} // namespace torch_ipex
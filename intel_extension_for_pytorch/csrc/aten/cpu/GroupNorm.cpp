@@ -0,0 +1,777 @@
+#include "GroupNorm.h"
+#include <ATen/NativeFunctions.h>
+#include <ATen/Parallel.h>
+#include <torch/extension.h>
+#include "csrc/utils/library.h"
+#include "utils/float_vec.h"
+#include "utils/vec_math.h"
+#include "csrc/utils/op_trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+// the {N, HxW, C} memory of the channels last input, of which the ambiguous
+// ones, e.g. of C == 1, are taken as contiguous
+inline bool is_channels_last(const at::Tensor& t) {
+  return !t.is_contiguous() &&
+      ((t.dim() == 4 && t.is_contiguous(at::MemoryFormat::ChannelsLast)) ||
+       (t.dim() == 5 && t.is_contiguous(at::MemoryFormat::ChannelsLast3d)));
+}
+
+// the grain size of the rows of the size
+inline int64_t grain_size_of(int64_t size) {
+  return std::max<int64_t>(
+      1, at::internal::GRAIN_SIZE / std::max<int64_t>(size, 1));
+}
+
+inline float silu_float(float x) {
+  return x / (1.f + std::exp(-x));
+}
+
+// the sum of x and the sum of x * x of a plane of the contiguous input
+template <typename scalar_t>
+std::pair<float, float> plane_sum_sumsq(const scalar_t* x, int64_t size) {
+  fVec sum_acc = fVec(0.f);
+  fVec sumsq_acc = fVec(0.f);
+  float sum = 0.f;
+  float sumsq = 0.f;
+  int64_t d = 0;
+  for (; d < size - (size % kFloatVecPairSize); d += kFloatVecPairSize) {
+    fVec x_fvec0, x_fvec1;
+    load_fvec(x + d, x_fvec0, x_fvec1);
+    sum_acc = sum_acc + x_fvec0 + x_fvec1;
+    sumsq_acc = sumsq_acc + x_fvec0 * x_fvec0 + x_fvec1 * x_fvec1;
+  }
+  for (; d < size; d++) {
+    float x_val = float(x[d]);
+    sum += x_val;
+    sumsq += x_val * x_val;
+  }
+  return std::make_pair(sum + sum_fvec(sum_acc), sumsq + sum_fvec(sumsq_acc));
+}
+
+// sum += x and sumsq += x * x of the channels of a row of the channels last
+// input
+template <typename scalar_t>
+void channels_sum_sumsq(
+    const scalar_t* x,
+    float* sum,
+    float* sumsq,
+    int64_t C) {
+  int64_t d = 0;
+  for (; d < C - (C % kFloatVecPairSize); d += kFloatVecPairSize) {
+    fVec x_fvec0, x_fvec1, sum_fvec0, sum_fvec1, sumsq_fvec0, sumsq_fvec1;
+    load_fvec(x + d, x_fvec0, x_fvec1);
+    load_fvec(sum + d, sum_fvec0, sum_fvec1);
+    load_fvec(sumsq + d, sumsq_fvec0, sumsq_fvec1);
+    store_fvec(sum + d, sum_fvec0 + x_fvec0, sum_fvec1 + x_fvec1);
+    store_fvec(
+        sumsq + d,
+        sumsq_fvec0 + x_fvec0 * x_fvec0,
+        sumsq_fvec1 + x_fvec1 * x_fvec1);
+  }
+  for (; d < C; d++) {
+    float x_val = float(x[d]);
+    sum[d] += x_val;
+    sumsq[d] += x_val * x_val;
+  }
+}
+
+// the sum of dy * x and the sum of dy of a plane of the contiguous input
+template <typename scalar_t>
+std::pair<float, float> plane_dot_sum(
+    const scalar_t* dy,
+    const scalar_t* x,
+    int64_t size) {
+  fVec ds_acc = fVec(0.f);
+  fVec db_acc = fVec(0.f);
+  float ds = 0.f;
+  float db = 0.f;
+  int64_t d = 0;
+  for (; d < size - (size % kFloatVecPairSize); d += kFloatVecPairSize) {
+    fVec dy_fvec0, dy_fvec1, x_fvec0, x_fvec1;
+    load_fvec(dy + d, dy_fvec0, dy_fvec1);
+    load_fvec(x + d, x_fvec0, x_fvec1);
+    ds_acc = ds_acc + dy_fvec0 * x_fvec0 + dy_fvec1 * x_fvec1;
+    db_acc = db_acc + dy_fvec0 + dy_fvec1;
+  }
+  for (; d < size; d++) {
+    float dy_val = float(dy[d]);
+    ds += dy_val * float(x[d]);
+    db += dy_val;
+  }
+  return std::make_pair(ds + sum_fvec(ds_acc), db + sum_fvec(db_acc));
+}
+
+// ds += dy * x and db += dy of the channels of a row of the channels last
+// input
+template <typename scalar_t>
+void channels_dot_sum(
+    const scalar_t* dy,
+    const scalar_t* x,
+    float* ds,
+    float* db,
+    int64_t C) {
+  int64_t d = 0;
+  for (; d < C - (C % kFloatVecPairSize); d += kFloatVecPairSize) {
+    fVec dy_fvec0, dy_fvec1, x_fvec0, x_fvec1;
+    fVec ds_fvec0, ds_fvec1, db_fvec0, db_fvec1;
+    load_fvec(dy + d, dy_fvec0, dy_fvec1);
+    load_fvec(x + d, x_fvec0, x_fvec1);
+    load_fvec(ds + d, ds_fvec0, ds_fvec1);
+    load_fvec(db + d, db_fvec0, db_fvec1);
+    store_fvec(
+        ds + d, ds_fvec0 + dy_fvec0 * x_fvec0, ds_fvec1 + dy_fvec1 * x_fvec1);
+    store_fvec(db + d, db_fvec0 + dy_fvec0, db_fvec1 + dy_fvec1);
+  }
+  for (; d < C; d++) {
+    float dy_val = float(dy[d]);
+    ds[d] += dy_val * float(x[d]);
+    db[d] += dy_val;
+  }
+}
+
+// y = x * scale + shift, and silu(y) if any, of a plane of the contiguous
+// input
+template <typename scalar_t>
+void plane_scale_shift(
+    const scalar_t* x,
+    float scale,
+    float shift,
+    bool silu,
+    int64_t size,
+    scalar_t* y) {
+  fVec scale_fvec = fVec(scale);
+  fVec shift_fvec = fVec(shift);
+  int64_t d = 0;
+  for (; d < size - (size % kFloatVecPairSize); d += kFloatVecPairSize) {
+    fVec x_fvec0, x_fvec1;
+    load_fvec(x + d, x_fvec0, x_fvec1);
+    fVec y_fvec0 = x_fvec0 * scale_fvec + shift_fvec;
+    fVec y_fvec1 = x_fvec1 * scale_fvec + shift_fvec;
+    if (silu) {
+      y_fvec0 = vec_math::silu<vec_math::accuracy_of<scalar_t>()>(y_fvec0);
+      y_fvec1 = vec_math::silu<vec_math::accuracy_of<scalar_t>()>(y_fvec1);
+    }
+    store_fvec(y + d, y_fvec0, y_fvec1);
+  }
+  for (; d < size; d++) {
+    float y_val = float(x[d]) * scale + shift;
+    y[d] = scalar_t(silu ? silu_float(y_val) : y_val);
+  }
+}
+
+// y = x * scale + shift, and silu(y) if any, of the channels of a row of the
+// channels last input
+template <typename scalar_t>
+void channels_scale_shift(
+    const scalar_t* x,
+    const float* scale,
+    const float* shift,
+    bool silu,
+    int64_t C,
+    scalar_t* y) {
+  int64_t d = 0;
+  for (; d < C - (C % kFloatVecPairSize); d += kFloatVecPairSize) {
+    fVec x_fvec0, x_fvec1, scale_fvec0, scale_fvec1, shift_fvec0, shift_fvec1;
+    load_fvec(x + d, x_fvec0, x_fvec1);
+    load_fvec(scale + d, scale_fvec0, scale_fvec1);
+    load_fvec(shift + d, shift_fvec0, shift_fvec1);
+    fVec y_fvec0 = x_fvec0 * scale_fvec0 + shift_fvec0;
+    fVec y_fvec1 = x_fvec1 * scale_fvec1 + shift_fvec1;
+    if (silu) {
+      y_fvec0 = vec_math::silu<vec_math::accuracy_of<scalar_t>()>(y_fvec0);
+      y_fvec1 = vec_math::silu<vec_math::accuracy_of<scalar_t>()>(y_fvec1);
+    }
+    store_fvec(y + d, y_fvec0, y_fvec1);
+  }
+  for (; d < C; d++) {
+    float y_val = float(x[d]) * scale[d] + shift[d];
+    y[d] = scalar_t(silu ? silu_float(y_val) : y_val);
+  }
+}
+
+// dx = a * dy + b * x + c of a plane of the contiguous input
+template <typename scalar_t>
+void plane_grad_input(
+    const scalar_t* dy,
+    const scalar_t* x,
+    float a,
+    float b,
+    float c,
+    int64_t size,
+    scalar_t* dx) {
+  fVec a_fvec = fVec(a);
+  fVec b_fvec = fVec(b);
+  fVec c_fvec = fVec(c);
+  int64_t d = 0;
+  for (; d < size - (size % kFloatVecPairSize); d += kFloatVecPairSize) {
+    fVec dy_fvec0, dy_fvec1, x_fvec0, x_fvec1;
+    load_fvec(dy + d, dy_fvec0, dy_fvec1);
+    load_fvec(x + d, x_fvec0, x_fvec1);
+    store_fvec(
+        dx + d,
+        a_fvec * dy_fvec0 + b_fvec * x_fvec0 + c_fvec,
+        a_fvec * dy_fvec1 + b_fvec * x_fvec1 + c_fvec);
+  }
+  for (; d < size; d++) {
+    dx[d] = scalar_t(a * float(dy[d]) + b * float(x[d]) + c);
+  }
+}
+
+// dx = a * dy + b * x + c of the channels of a row of the channels last input
+template <typename scalar_t>
+void channels_grad_input(
+    const scalar_t* dy,
+    const scalar_t* x,
+    const float* a,
+    const float* b,
+    const float* c,
+    int64_t C,
+    scalar_t* dx) {
+  int64_t d = 0;
+  for (; d < C - (C % kFloatVecPairSize); d += kFloatVecPairSize) {
+    fVec dy_fvec0, dy_fvec1, x_fvec0, x_fvec1;
+    fVec a_fvec0, a_fvec1, b_fvec0, b_fvec1, c_fvec0, c_fvec1;
+    load_fvec(dy + d, dy_fvec0, dy_fvec1);
+    load_fvec(x + d, x_fvec0, x_fvec1);
+    load_fvec(a + d, a_fvec0, a_fvec1);
+    load_fvec(b + d, b_fvec0, b_fvec1);
+    load_fvec(c + d, c_fvec0, c_fvec1);
+    store_fvec(
+        dx + d,
+        a_fvec0 * dy_fvec0 + b_fvec0 * x_fvec0 + c_fvec0,
+        a_fvec1 * dy_fvec1 + b_fvec1 * x_fvec1 + c_fvec1);
+  }
+  for (; d < C; d++) {
+    dx[d] = scalar_t(a[d] * float(dy[d]) + b[d] * float(x[d]) + c[d]);
+  }
+}
+
+// The {N, C} sums of the planes, of x and x * x in the forward, or of dy * x
+// and dy in the backward if dy is given. The planes of the contiguous input
+// are reduced in parallel, and the rows of the channels last one by the
+// partials of the threads of size {max_threads, 2, C} for each of N.
+template <typename scalar_t>
+void compute_plane_sums(
+    const scalar_t* x,
+    const scalar_t* dy,
+    int64_t N,
+    int64_t C,
+    int64_t HxW,
+    bool channels_last,
+    float* s1,
+    float* s2) {
+  if (!channels_last) {
+    int64_t grain_size = grain_size_of(HxW);
+    at::parallel_for(0, N * C, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        std::tie(s1[i], s2[i]) = dy
+            ? plane_dot_sum<scalar_t>(dy + i * HxW, x + i * HxW, HxW)
+            : plane_sum_sumsq<scalar_t>(x + i * HxW, HxW);
+      }
+    });
+    return;
+  }
+
+  int num_threads = at::get_num_threads();
+  std::vector<float> buffer(num_threads * 2 * C);
+  int64_t grain_size = grain_size_of(C);
+  for (int64_t n = 0; n < N; n++) {
+    std::fill(buffer.begin(), buffer.end(), 0.f);
+    at::parallel_for(0, HxW, grain_size, [&](int64_t begin, int64_t end) {
+      int tid = at::get_thread_num();
+      TORCH_CHECK(
+          tid < num_threads,
+          "expect thread id smaller than ",
+          num_threads,
+          ", got thread id ",
+          tid);
+      float* buffer1 = buffer.data() + tid * 2 * C;
+      float* buffer2 = buffer1 + C;
+      for (int64_t i = begin; i < end; i++) {
+        int64_t offset = (n * HxW + i) * C;
+        if (dy) {
+          channels_dot_sum<scalar_t>(
+              dy + offset, x + offset, buffer1, buffer2, C);
+        } else {
+          channels_sum_sumsq<scalar_t>(x + offset, buffer1, buffer2, C);
+        }
+      }
+    });
+    for (int64_t c = 0; c < C; c++) {
+      float sum1 = 0.f;
+      float sum2 = 0.f;
+      for (int t = 0; t < num_threads; t++) {
+        sum1 += buffer[t * 2 * C + c];
+        sum2 += buffer[t * 2 * C + C + c];
+      }
+      s1[n * C + c] = sum1;
+      s2[n * C + c] = sum2;
+    }
+  }
+}
+
+template <typename scalar_t>
+void group_norm_kernel(
+    const at::Tensor& X,
+    const float* gamma,
+    const float* beta,
+    int64_t N,
+    int64_t C,
+    int64_t HxW,
+    int64_t G,
+    double eps,
+    bool silu,
+    bool channels_last,
+    at::Tensor& Y,
+    float* mean,
+    float* rstd) {
+  const scalar_t* x_data = X.data_ptr<scalar_t>();
+  scalar_t* y_data = Y.data_ptr<scalar_t>();
+  const int64_t D = C / G;
+  std::vector<float> sum(N * C);
+  std::vector<float> sumsq(N * C);
+  compute_plane_sums<scalar_t>(
+      x_data, nullptr, N, C, HxW, channels_last, sum.data(), sumsq.data());
+
+  // the stats of the groups, and the scale and the shift of the planes, of
+  // which the plane n * C + g * D + d is of the group n * G + g
+  std::vector<float> scale(N * C);
+  std::vector<float> shift(N * C);
+  const double count = static_cast<double>(D * HxW);
+  for (int64_t i = 0; i < N * G; i++) {
+    double group_sum = 0;
+    double group_sumsq = 0;
+    for (int64_t d = 0; d < D; d++) {
+      group_sum += sum[i * D + d];
+      group_sumsq += sumsq[i * D + d];
+    }
+    double mean_val = group_sum / count;
+    double var_val = std::max(group_sumsq / count - mean_val * mean_val, 0.0);
+    mean[i] = static_cast<float>(mean_val);
+    rstd[i] = static_cast<float>(1.0 / std::sqrt(var_val + eps));
+    for (int64_t d = 0; d < D; d++) {
+      int64_t c = (i % G) * D + d;
+      float gamma_val = gamma ? gamma[c] : 1.f;
+      float beta_val = beta ? beta[c] : 0.f;
+      scale[i * D + d] = rstd[i] * gamma_val;
+      shift[i * D + d] = beta_val - mean[i] * scale[i * D + d];
+    }
+  }
+
+  if (channels_last) {
+    int64_t grain_size = grain_size_of(C);
+    at::parallel_for(0, N * HxW, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        int64_t n = i / HxW;
+        channels_scale_shift<scalar_t>(
+            x_data + i * C,
+            scale.data() + n * C,
+            shift.data() + n * C,
+            silu,
+            C,
+            y_data + i * C);
+      }
+    });
+  } else {
+    int64_t grain_size = grain_size_of(HxW);
+    at::parallel_for(0, N * C, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t i = begin; i < end; i++) {
+        plane_scale_shift<scalar_t>(
+            x_data + i * HxW, scale[i], shift[i], silu, HxW, y_data + i * HxW);
+      }
+    });
+  }
+}
+
+// dx = rstd * gamma * dy + c2 * x + c3 of each group, of
+//   c2 = (db_g * mean - ds_g) * rstd^3 / (D * HxW)
+//   c3 = -c2 * mean - db_g * rstd / (D * HxW)
+// in which ds_g and db_g are the sums of gamma * dy * x and gamma * dy of the
+// group, and dgamma = sum((ds - db * mean) * rstd) and dbeta = sum(db) of the
+// channels.
+template <typename scalar_t>
+void group_norm_backward_kernel(
+    const at::Tensor& dY,
+    const at::Tensor& X,
+    const float* mean,
+    const float* rstd,
+    const float* gamma,
+    int64_t N,
+    int64_t C,
+    int64_t HxW,
+    int64_t G,
+    bool channels_last,
+    at::Tensor& dX,
+    float* dgamma,
+    float* dbeta) {
+  const scalar_t* dy_data = dY.data_ptr<scalar_t>();
+  const scalar_t* x_data = X.data_ptr<scalar_t>();
+  const int64_t D = C / G;
+  std::vector<float> ds(N * C);
+  std::vector<float> db(N * C);
+  compute_plane_sums<scalar_t>(
+      x_data, dy_data, N, C, HxW, channels_last, ds.data(), db.data());
+
+  if (dX.defined()) {
+    scalar_t* dx_data = dX.data_ptr<scalar_t>();
+    std::vector<float> a(N * C);
+    std::vector<float> b(N * C);
+    std::vector<float> c(N * C);
+    const double s = 1.0 / static_cast<double>(D * HxW);
+    for (int64_t i = 0; i < N * G; i++) {
+      double ds_val = 0;
+      double db_val = 0;
+      for (int64_t d = 0; d < D; d++) {
+        float gamma_val = gamma ? gamma[(i % G) * D + d] : 1.f;
+        ds_val += ds[i * D + d] * gamma_val;
+        db_val += db[i * D + d] * gamma_val;
+      }
+      double rstd_val = rstd[i];
+      double c2 =
+          (db_val * mean[i] - ds_val) * rstd_val * rstd_val * rstd_val * s;
+      double c3 = -c2 * mean[i] - db_val * rstd_val * s;
+      for (int64_t d = 0; d < D; d++) {
+        float gamma_val = gamma ? gamma[(i % G) * D + d] : 1.f;
+        a[i * D + d] = rstd[i] * gamma_val;
+        b[i * D + d] = static_cast<float>(c2);
+        c[i * D + d] = static_cast<float>(c3);
+      }
+    }
+
+    if (channels_last) {
+      int64_t grain_size = grain_size_of(C);
+      at::parallel_for(0, N * HxW, grain_size, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+          int64_t n = i / HxW;
+          channels_grad_input<scalar_t>(
+              dy_data + i * C,
+              x_data + i * C,
+              a.data() + n * C,
+              b.data() + n * C,
+              c.data() + n * C,
+              C,
+              dx_data + i * C);
+        }
+      });
+    } else {
+      int64_t grain_size = grain_size_of(HxW);
+      at::parallel_for(0, N * C, grain_size, [&](int64_t begin, int64_t end) {
+        for (int64_t i = begin; i < end; i++) {
+          plane_grad_input<scalar_t>(
+              dy_data + i * HxW,
+              x_data + i * HxW,
+              a[i],
+              b[i],
+              c[i],
+              HxW,
+              dx_data + i * HxW);
+        }
+      });
+    }
+  }
+
+  for (int64_t ch = 0; ch < C; ch++) {
+    int64_t g = ch / D;
+    float dgamma_val = 0.f;
+    float dbeta_val = 0.f;
+    for (int64_t n = 0; n < N; n++) {
+      dgamma_val += (ds[n * C + ch] - db[n * C + ch] * mean[n * G + g]) *
+          rstd[n * G + g];
+      dbeta_val += db[n * C + ch];
+    }
+    if (dgamma) {
+      dgamma[ch] = dgamma_val;
+    }
+    if (dbeta) {
+      dbeta[ch] = dbeta_val;
+    }
+  }
+}
+
+bool can_use_group_norm_kernel(const at::Tensor& input) {
+  return input.dim() >= 2 &&
+      (input.scalar_type() == at::kFloat ||
+       input.scalar_type() == at::kBFloat16);
+}
+
+// (N, C, HxW) of the input
+std::tuple<int64_t, int64_t, int64_t> check_group_norm_inputs(
+    const at::Tensor& input,
+    int64_t num_groups,
+    const at::Tensor& weight,
+    const at::Tensor& bias) {
+  const int64_t N = input.size(0);
+  const int64_t C = input.size(1);
+  TORCH_CHECK(
+      num_groups > 0 && C % num_groups == 0,
+      "Expected number of channels in input to be divisible by ",
+      "num_groups, but got input of shape ",
+      input.sizes(),
+      " and "
+      "num_groups=",
+      num_groups);
+  TORCH_CHECK(
+      !weight.defined() || weight.numel() == C,
+      "Expected weight to be a vector of size equal to the number of ",
+      "channels in input, but got weight of shape ",
+      weight.sizes(),
+      " and input of shape ",
+      input.sizes());
+  TORCH_CHECK(
+      !bias.defined() || bias.numel() == C,
+      "Expected bias to be a vector of size equal to the number of ",
+      "channels in input, but got bias of shape ",
+      bias.sizes(),
+      " and input of shape ",
+      input.sizes());
+  const int64_t HxW = N * C == 0 ? 0 : input.numel() / (N * C);
+  return std::make_tuple(N, C, HxW);
+}
+
+// the output, in the format of the input, and the float mean and rstd of the
+// {N, num_groups} groups
+std::tuple<at::Tensor, at::Tensor, at::Tensor> group_norm_impl(
+    const at::Tensor& input,
+    int64_t num_groups,
+    const at::Tensor& weight,
+    const at::Tensor& bias,
+    double eps,
+    bool silu) {
+  int64_t N, C, HxW;
+  std::tie(N, C, HxW) =
+      check_group_norm_inputs(input, num_groups, weight, bias);
+  bool channels_last = is_channels_last(input);
+  auto X = channels_last ? input : input.contiguous();
+  auto gamma =
+      weight.defined() ? weight.to(at::kFloat).contiguous() : at::Tensor();
+  auto beta = bias.defined() ? bias.to(at::kFloat).contiguous() : at::Tensor();
+  auto Y = at::empty_like(X);
+  auto mean = at::empty({N, num_groups}, X.options().dtype(at::kFloat));
+  auto rstd = at::empty({N, num_groups}, X.options().dtype(at::kFloat));
+  if (X.numel() == 0) {
+    return std::make_tuple(Y, mean, rstd);
+  }
+  const float* gamma_data = gamma.defined() ? gamma.data_ptr<float>() : nullptr;
+  const float* beta_data = beta.defined() ? beta.data_ptr<float>() : nullptr;
+  if (X.scalar_type() == at::kBFloat16) {
+    group_norm_kernel<at::BFloat16>(
+        X,
+        gamma_data,
+        beta_data,
+        N,
+        C,
+        HxW,
+        num_groups,
+        eps,
+        silu,
+        channels_last,
+        Y,
+        mean.data_ptr<float>(),
+        rstd.data_ptr<float>());
+  } else {
+    group_norm_kernel<float>(
+        X,
+        gamma_data,
+        beta_data,
+        N,
+        C,
+        HxW,
+        num_groups,
+        eps,
+        silu,
+        channels_last,
+        Y,
+        mean.data_ptr<float>(),
+        rstd.data_ptr<float>());
+  }
+  return std::make_tuple(Y, mean, rstd);
+}
+
+} // namespace
+
+at::Tensor IPEXGroupNormOp::_forward(
+    const at::Tensor& input,
+    int64_t num_groups,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& bias_opt,
+    double eps) {
+  IPEX_RECORD_FUNCTION(
+      "IPEXGroupNormOp::_forward", std::vector<c10::IValue>({}));
+  auto weight = weight_opt.has_value() ? weight_opt.value() : at::Tensor();
+  auto bias = bias_opt.has_value() ? bias_opt.value() : at::Tensor();
+  return std::get<0>(
+      group_norm_impl(input, num_groups, weight, bias, eps, false));
+}
+
+at::Tensor IPEXGroupNormOp::forward(
+    torch::autograd::AutogradContext* ctx,
+    const at::Tensor& input,
+    int64_t num_groups,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& bias_opt,
+    double eps) {
+  IPEX_RECORD_FUNCTION(
+      "IPEXGroupNormOp::forward", std::vector<c10::IValue>({}));
+  auto weight = weight_opt.has_value() ? weight_opt.value() : at::Tensor();
+  auto bias = bias_opt.has_value() ? bias_opt.value() : at::Tensor();
+  at::Tensor output, mean, rstd;
+  std::tie(output, mean, rstd) =
+      group_norm_impl(input, num_groups, weight, bias, eps, false);
+  ctx->saved_data["num_groups"] = num_groups;
+  ctx->saved_data["input_requires_grad"] = input.requires_grad();
+  ctx->saved_data["has_weight"] = weight.defined();
+  ctx->saved_data["has_bias"] = bias.defined();
+  ctx->saved_data["weight_dtype"] =
+      weight.defined() ? weight.scalar_type() : input.scalar_type();
+  ctx->saved_data["bias_dtype"] =
+      bias.defined() ? bias.scalar_type() : input.scalar_type();
+  ctx->save_for_backward(
+      {is_channels_last(input) ? input : input.contiguous(),
+       weight,
+       mean,
+       rstd});
+  return output;
+}
+
+torch::autograd::variable_list IPEXGroupNormOp::backward(
+    torch::autograd::AutogradContext* ctx,
+    torch::autograd::variable_list grad_outputs) {
+  IPEX_RECORD_FUNCTION(
+      "IPEXGroupNormOp::backward", std::vector<c10::IValue>({}));
+  auto saved = ctx->get_saved_variables();
+  auto X = saved[0];
+  auto weight = saved[1];
+  auto mean = saved[2];
+  auto rstd = saved[3];
+  int64_t num_groups = ctx->saved_data["num_groups"].toInt();
+  bool has_weight = ctx->saved_data["has_weight"].toBool();
+  bool has_bias = ctx->saved_data["has_bias"].toBool();
+  const int64_t N = X.size(0);
+  const int64_t C = X.size(1);
+  const int64_t HxW = N * C == 0 ? 0 : X.numel() / (N * C);
+
+  // the grad is read in the format of the input
+  bool channels_last = is_channels_last(X);
+  auto dY = grad_outputs[0].to(X.scalar_type());
+  dY = dY.contiguous(
+      channels_last ? X.suggest_memory_format() : at::MemoryFormat::Contiguous);
+  auto gamma =
+      has_weight ? weight.to(at::kFloat).contiguous() : at::Tensor();
+  at::Tensor dX = ctx->saved_data["input_requires_grad"].toBool()
+      ? at::empty_like(X)
+      : at::Tensor();
+  auto dgamma = at::zeros({C}, X.options().dtype(at::kFloat));
+  auto dbeta = at::zeros({C}, X.options().dtype(at::kFloat));
+  if (X.numel() > 0) {
+    const float* gamma_data =
+        gamma.defined() ? gamma.data_ptr<float>() : nullptr;
+    if (X.scalar_type() == at::kBFloat16) {
+      group_norm_backward_kernel<at::BFloat16>(
+          dY,
+          X,
+          mean.data_ptr<float>(),
+          rstd.data_ptr<float>(),
+          gamma_data,
+          N,
+          C,
+          HxW,
+          num_groups,
+          channels_last,
+          dX,
+          dgamma.data_ptr<float>(),
+          dbeta.data_ptr<float>());
+    } else {
+      group_norm_backward_kernel<float>(
+          dY,
+          X,
+          mean.data_ptr<float>(),
+          rstd.data_ptr<float>(),
+          gamma_data,
+          N,
+          C,
+          HxW,
+          num_groups,
+          channels_last,
+          dX,
+          dgamma.data_ptr<float>(),
+          dbeta.data_ptr<float>());
+    }
+  }
+  return {
+      dX,
+      at::Tensor(),
+      has_weight
+          ? dgamma.to(ctx->saved_data["weight_dtype"].toScalarType())
+                .view(weight.sizes())
+          : at::Tensor(),
+      has_bias ? dbeta.to(ctx->saved_data["bias_dtype"].toScalarType())
+                 : at::Tensor(),
+      at::Tensor()};
+}
+
+at::Tensor group_norm(
+    const at::Tensor& input,
+    int64_t num_groups,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& bias_opt,
+    double eps,
+    bool cudnn_enabled) {
+  IPEX_RECORD_FUNCTION("torch_ipex::group_norm", std::vector<c10::IValue>({}));
+  if (!can_use_group_norm_kernel(input)) {
+    return at::native::group_norm(
+        input, num_groups, weight_opt, bias_opt, eps, cudnn_enabled);
+  }
+  if (at::GradMode::is_enabled()) {
+    return IPEXGroupNormOp::apply(
+        input, num_groups, weight_opt, bias_opt, eps);
+  }
+  return IPEXGroupNormOp::_forward(
+      input, num_groups, weight_opt, bias_opt, eps);
+}
+
+at::Tensor group_norm_silu(
+    const at::Tensor& input,
+    int64_t num_groups,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& bias_opt,
+    double eps) {
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::group_norm_silu", std::vector<c10::IValue>({}));
+  if (!can_use_group_norm_kernel(input)) {
+    return at::silu(at::native::group_norm(
+        input, num_groups, weight_opt, bias_opt, eps, false));
+  }
+  auto weight = weight_opt.has_value() ? weight_opt.value() : at::Tensor();
+  auto bias = bias_opt.has_value() ? bias_opt.value() : at::Tensor();
+  return std::get<0>(
+      group_norm_impl(input, num_groups, weight, bias, eps, true));
+}
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "group_norm_silu(Tensor input, int num_groups, Tensor? weight, "
+      "Tensor? bias, float eps) -> Tensor",
+      torch_ipex::cpu::group_norm_silu);
+}
+
+// replace aten::group_norm with ipex group_norm.
+IPEX_TORCH_LIBRARY_IMPL(aten, CPU, m) {
+  m.impl(
+      TORCH_SELECTIVE_NAME("aten::group_norm"),
+      TORCH_FN((&torch_ipex::cpu::group_norm)));
+}
+
+} // namespace
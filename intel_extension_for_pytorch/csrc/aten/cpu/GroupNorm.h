@@ -0,0 +1,55 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+#include <torch/csrc/autograd/custom_function.h>
+
+namespace torch_ipex {
+namespace cpu {
+
+// group_norm of the float and the bfloat16 inputs of the NC* and the channels
+// last formats, e.g. of the ResBlocks of the diffusion U-Nets and of the
+// detection heads. The channels last input is normalized in place of its
+// format instead of the contiguous copy of it.
+at::Tensor group_norm(
+    const at::Tensor& input,
+    int64_t num_groups,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& bias_opt,
+    double eps,
+    bool cudnn_enabled);
+
+// silu(group_norm(input)) of the ResBlocks of the U-Nets for inference, of
+// which the silu is applied while the output is stored.
+at::Tensor group_norm_silu(
+    const at::Tensor& input,
+    int64_t num_groups,
+    const c10::optional<at::Tensor>& weight_opt,
+    const c10::optional<at::Tensor>& bias_opt,
+    double eps);
+
+class IPEXGroupNormOp : public torch::autograd::Function<IPEXGroupNormOp> {
+ public:
+  // forward function without autograd overhead, will go this way when only do
+  // forward
+  static at::Tensor _forward(
+      const at::Tensor& input,
+      int64_t num_groups,
+      const c10::optional<at::Tensor>& weight_opt,
+      const c10::optional<at::Tensor>& bias_opt,
+      double eps);
+
+  static at::Tensor forward(
+      torch::autograd::AutogradContext* ctx,
+      const at::Tensor& input,
+      int64_t num_groups,
+      const c10::optional<at::Tensor>& weight_opt,
+      const c10::optional<at::Tensor>& bias_opt,
+      double eps);
+
+  static torch::autograd::variable_list backward(
+      torch::autograd::AutogradContext* ctx,
+      torch::autograd::variable_list grad_outputs);
+};
+
+} // namespace cpu
+} // namespace torch_ipex
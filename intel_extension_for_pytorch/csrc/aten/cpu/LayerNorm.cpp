@@ -1,7 +1,10 @@
 #include "LayerNorm.h"
+#include <ATen/cpu/vec/vec.h>
 #include <torch/extension.h>
 #include "csrc/cpu/ideep/IDeepConversions.h"
 #include "csrc/utils/library.h"
+#include "utils/op_thread_policy.h"
+#include "csrc/utils/op_trace.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -46,6 +49,7 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> layer_norm_impl(
   auto onednn_Y = itensor_view_from_dense(Y);
   auto onednn_mean = itensor_view_from_dense(mean);
   auto onednn_variance = itensor_view_from_dense(variance);
+  OpThreadGuard op_thread_guard(ThreadPolicyOp::LayerNorm, M * N);
   ideep::layer_normalization_forward::compute(
       src, scale, shift, onednn_Y, onednn_mean, onednn_variance, eps);
   return std::make_tuple(Y, mean, variance);
@@ -139,6 +143,148 @@ at::Tensor layer_norm_forward(
   return std::get<0>(layer_norm_impl(X, gamma, beta, M, N, eps));
 }
 
+static inline float sum_fvec(const at::vec::Vectorized<float>& v) {
+  std::array<float, at::vec::Vectorized<float>::size()> arr;
+  v.store(arr.data());
+  return std::accumulate(arr.cbegin(), arr.cend(), 0.f);
+}
+
+/**layer_norm kernel of a bfloat16 input with the float32 gamma and beta. The
+ * input is converted to float32 while loaded and the output to bfloat16 while
+ * stored, instead of the casts of the whole input and output around the
+ * float32 layer_norm.
+ *
+ * @return the bfloat16 output, and the float32 mean and rstd of each row
+ **/
+std::tuple<at::Tensor, at::Tensor, at::Tensor> mixed_layer_norm_kernel(
+    const at::Tensor& X,
+    const at::Tensor& gamma,
+    const at::Tensor& beta,
+    int64_t M,
+    int64_t N,
+    double eps) {
+  using bVec = at::vec::Vectorized<at::BFloat16>;
+  using fVec = at::vec::Vectorized<float>;
+  at::Tensor Y = at::empty_like(X);
+  at::Tensor mean = at::empty({M}, X.options().dtype(at::kFloat));
+  at::Tensor rstd = at::empty({M}, X.options().dtype(at::kFloat));
+  const at::BFloat16* X_data = X.data_ptr<at::BFloat16>();
+  const float* gamma_data = gamma.data_ptr<float>();
+  const float* beta_data = beta.data_ptr<float>();
+  at::BFloat16* Y_data = Y.data_ptr<at::BFloat16>();
+  float* mean_data = mean.data_ptr<float>();
+  float* rstd_data = rstd.data_ptr<float>();
+  const int64_t vec_end = N - (N % bVec::size());
+  int64_t grain_size =
+      std::max<int64_t>(1, at::internal::GRAIN_SIZE / std::max<int64_t>(N, 1));
+  at::parallel_for(0, M, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      const at::BFloat16* x = X_data + i * N;
+      at::BFloat16* y = Y_data + i * N;
+      // the row is read again from the cache by the next two loops
+      fVec sum_vec = fVec(0.f);
+      float sum_val = 0.f;
+      int64_t d = 0;
+      for (; d < vec_end; d += bVec::size()) {
+        fVec x_fvec, x_fvec2;
+        std::tie(x_fvec, x_fvec2) = convert_bfloat16_float(bVec::loadu(x + d));
+        sum_vec = sum_vec + x_fvec + x_fvec2;
+      }
+      for (; d < N; d++) {
+        sum_val += float(x[d]);
+      }
+      float mean_val = (sum_val + sum_fvec(sum_vec)) / N;
+
+      fVec var_vec = fVec(0.f);
+      float var_val = 0.f;
+      for (d = 0; d < vec_end; d += bVec::size()) {
+        fVec x_fvec, x_fvec2;
+        std::tie(x_fvec, x_fvec2) = convert_bfloat16_float(bVec::loadu(x + d));
+        x_fvec = x_fvec - fVec(mean_val);
+        x_fvec2 = x_fvec2 - fVec(mean_val);
+        var_vec = var_vec + x_fvec * x_fvec + x_fvec2 * x_fvec2;
+      }
+      for (; d < N; d++) {
+        float x_val = float(x[d]) - mean_val;
+        var_val += x_val * x_val;
+      }
+      float rstd_val =
+          1.f / std::sqrt((var_val + sum_fvec(var_vec)) / N + float(eps));
+
+      for (d = 0; d < vec_end; d += bVec::size()) {
+        fVec x_fvec, x_fvec2;
+        std::tie(x_fvec, x_fvec2) = convert_bfloat16_float(bVec::loadu(x + d));
+        fVec y_fvec = (x_fvec - fVec(mean_val)) * fVec(rstd_val) *
+                fVec::loadu(gamma_data + d) +
+            fVec::loadu(beta_data + d);
+        fVec y_fvec2 = (x_fvec2 - fVec(mean_val)) * fVec(rstd_val) *
+                fVec::loadu(gamma_data + d + fVec::size()) +
+            fVec::loadu(beta_data + d + fVec::size());
+        convert_float_bfloat16(y_fvec, y_fvec2).store(y + d);
+      }
+      for (; d < N; d++) {
+        y[d] = at::BFloat16(
+            (float(x[d]) - mean_val) * rstd_val * gamma_data[d] +
+            beta_data[d]);
+      }
+      mean_data[i] = mean_val;
+      rstd_data[i] = rstd_val;
+    }
+  });
+  return std::make_tuple(Y, mean, rstd);
+}
+
+at::Tensor MixedLayerNormOp::forward(
+    torch::autograd::AutogradContext* ctx,
+    const at::Tensor& input,
+    at::IntArrayRef normalized_shape,
+    const at::Tensor& weight,
+    const at::Tensor& bias,
+    double eps) {
+  IPEX_RECORD_FUNCTION(
+      "MixedLayerNormOp::forward", std::vector<c10::IValue>({}));
+  at::AutoNonVariableTypeMode g;
+  auto inputs =
+      _prepare_layer_norm_inputs(input, normalized_shape, weight, bias);
+  auto outputs = mixed_layer_norm_kernel(
+      std::get<0>(inputs),
+      std::get<1>(inputs),
+      std::get<2>(inputs),
+      std::get<3>(inputs),
+      std::get<4>(inputs),
+      eps);
+  ctx->saved_data["normalized_shape"] = normalized_shape;
+  // the bfloat16 input is saved rather than its float32 cast
+  ctx->save_for_backward(
+      {input, weight, bias, std::get<1>(outputs), std::get<2>(outputs)});
+  return std::get<0>(outputs);
+}
+
+torch::autograd::tensor_list MixedLayerNormOp::backward(
+    torch::autograd::AutogradContext* ctx,
+    torch::autograd::tensor_list grad_outputs) {
+  IPEX_RECORD_FUNCTION(
+      "MixedLayerNormOp::backward", std::vector<c10::IValue>({}));
+  auto saved = ctx->get_saved_variables();
+  auto normalized_shape = ctx->saved_data["normalized_shape"].toIntList().vec();
+  at::Tensor grad_input, grad_weight, grad_bias;
+  std::tie(grad_input, grad_weight, grad_bias) = at::native_layer_norm_backward(
+      grad_outputs[0].to(at::kFloat),
+      saved[0].to(at::kFloat),
+      normalized_shape,
+      saved[3],
+      saved[4],
+      saved[1],
+      saved[2],
+      {true, true, true});
+  return {
+      grad_input.to(at::kBFloat16),
+      at::Tensor(),
+      grad_weight,
+      grad_bias,
+      at::Tensor()};
+}
+
 /**
  * at::layer_norm performance drop due to
  * #PR https://github.com/pytorch/pytorch/pull/59987
@@ -165,9 +311,7 @@ at::Tensor layer_norm(
     const c10::optional<at::Tensor>& bias_opt,
     double eps,
     bool cudnn_enable) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("torch_ipex::layer_norm", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("torch_ipex::layer_norm", std::vector<c10::IValue>({}));
   // onednn path for inference.
   // TODO: enable training path ??
   if (weight_opt.has_value() && weight_opt.value().defined() &&
@@ -176,6 +320,16 @@ at::Tensor layer_norm(
     return layer_norm_forward(
         input, normalized_shape, weight_opt.value(), bias_opt.value(), eps);
   }
+  // the bfloat16 input of the float32 weight and bias is converted in the
+  // kernel in training as well
+  if (weight_opt.has_value() && weight_opt.value().defined() &&
+      bias_opt.has_value() && bias_opt.value().defined() &&
+      input.scalar_type() == at::kBFloat16 &&
+      weight_opt.value().scalar_type() == at::kFloat &&
+      bias_opt.value().scalar_type() == at::kFloat) {
+    return MixedLayerNormOp::apply(
+        input, normalized_shape, weight_opt.value(), bias_opt.value(), eps);
+  }
 
   c10::MaybeOwned<at::Tensor> weight_maybe_owned =
       at::borrow_from_optional_tensor(weight_opt);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <ATen/Tensor.h>
+#include <torch/csrc/autograd/custom_function.h>
 
 #include "csrc/cpu/ideep/ideep.hpp"
 
@@ -15,5 +16,22 @@ at::Tensor layer_norm(
     double eps,
     bool cudnn_enable);
 
+// layer_norm of a bfloat16 input with the float32 weight and bias, e.g. the
+// input of autocast from a bfloat16 op, in training
+class MixedLayerNormOp : public torch::autograd::Function<MixedLayerNormOp> {
+ public:
+  static at::Tensor forward(
+      torch::autograd::AutogradContext* ctx,
+      const at::Tensor& input,
+      at::IntArrayRef normalized_shape,
+      const at::Tensor& weight,
+      const at::Tensor& bias,
+      double eps);
+
+  static torch::autograd::tensor_list backward(
+      torch::autograd::AutogradContext* ctx,
+      torch::autograd::tensor_list grad_outputs);
+};
+
 } // namespace cpu
 } // namespace torch_ipex
@@ -1,17 +1,25 @@
 #include <torch/extension.h>
 
 #include "Eltwise.h"
+#include "Gemv.h"
 #include "Linear.h"
 #include "WeightPack.h"
 #include "csrc/autocast/autocast_mode.h"
 #include "csrc/autocast/autocast_verbose.h"
 #include "csrc/cpu/ideep/IDeepConversions.h"
+#include "csrc/utils/op_trace.h"
 #include "csrc/utils/utils.h"
 
 namespace torch_ipex {
 namespace cpu {
 
-enum EltwiseType { NotFused = 0, ReLU = 1, Sigmoid = 2 };
+enum EltwiseType {
+  NotFused = 0,
+  ReLU = 1,
+  Sigmoid = 2,
+  GeluErf = 3,
+  GeluTanh = 4
+};
 /**
  * Linear inplace version with oneDNN kernel.
  * Inplace version will be used when user provides output tensor. eg: Linear+Add
@@ -42,9 +50,18 @@ void linear_kernel_output(
         self_reshaped.size(0), mkldnn_weight.get_dim(0)};
     output = output.reshape(output_size_reshaped);
   }
-  ideep::tensor mkldnn_output = itensor_view_from_dense(output);
-
-  if (bias.defined()) {
+  GemvParams gemv_params;
+  if (is_gemv(self_reshaped, mkldnn_weight, output, attr, gemv_params)) {
+    // the few rows of the plain weight, e.g. of the decoding
+    IPEX_TRACE_OP_KERNEL("gemv");
+    auto weight = at::from_blob(
+        mkldnn_weight.get_data_handle(),
+        {mkldnn_weight.get_dim(0), mkldnn_weight.get_dim(1)},
+        self.options());
+    auto bias_ = bias.defined() ? bias.to(at::kFloat).contiguous() : bias;
+    gemv_kernel_stub(self_reshaped, weight, bias_, output, gemv_params);
+  } else if (bias.defined()) {
+    ideep::tensor mkldnn_output = itensor_view_from_dense(output);
     auto bias_ = self.is_contiguous() ? bias : bias.contiguous();
     const ideep::tensor mkldnn_bias = itensor_view_from_dense(bias_);
     ideep::inner_product_forward::compute(
@@ -57,6 +74,7 @@ void linear_kernel_output(
         ideep::scale_t(),
         attr);
   } else {
+    ideep::tensor mkldnn_output = itensor_view_from_dense(output);
     ideep::inner_product_forward::compute(
         mkldnn_input,
         mkldnn_weight,
@@ -99,6 +117,47 @@ at::Tensor linear_forward(
   return linear_kernel(self, mkldnn_weight, bias_, ideep::attr_t());
 }
 
+namespace {
+
+ideep::attr_t linear_eltwise_attr(const int64_t eltwise) {
+  if (eltwise == ReLU)
+    return ideep::attr_t::fuse_relu();
+  if (eltwise == Sigmoid)
+    return ideep::attr_t::fuse_sigmoid();
+  // the gelu post op of oneDNN is vectorized for the ISA of the machine, for
+  // both the erf and the tanh approximation
+  ideep::post_ops po;
+  po.append_eltwise(
+      1.f,
+      eltwise == GeluTanh ? ideep::algorithm::eltwise_gelu_tanh
+                          : ideep::algorithm::eltwise_gelu_erf,
+      0.f,
+      0.f);
+  return ideep::attr_t::attr_post_ops(po);
+}
+
+constexpr double kGeluTanhBeta = M_SQRT2 * M_2_SQRTPI * 0.5;
+constexpr double kGeluTanhKappa = 0.044715;
+
+// 0.5 * x * (1 + tanh(sqrt(2 / pi) * (x + 0.044715 * x^3)))
+at::Tensor gelu_tanh(const at::Tensor& x) {
+  auto inner = (x + x * x * x * kGeluTanhKappa) * kGeluTanhBeta;
+  return x * 0.5 * (inner.tanh() + 1);
+}
+
+at::Tensor gelu_tanh_backward(
+    const at::Tensor& grad_output,
+    const at::Tensor& x) {
+  auto x_sq = x * x;
+  auto tanh_inner = ((x + x_sq * x * kGeluTanhKappa) * kGeluTanhBeta).tanh();
+  auto left_derivative = (tanh_inner + 1) * 0.5;
+  auto right_derivative = x * 0.5 * (1 - tanh_inner * tanh_inner) *
+      kGeluTanhBeta * (x_sq * (3 * kGeluTanhKappa) + 1);
+  return grad_output * (left_derivative + right_derivative);
+}
+
+} // namespace
+
 at::Tensor linear_eltwise_forward(
     const at::Tensor& self,
     const at::Tensor& weight,
@@ -111,12 +170,8 @@ at::Tensor linear_eltwise_forward(
   const at::Tensor& bias_ = *bias_maybe_owned;
   const ideep::tensor mkldnn_weight =
       get_linear_packed_weight(weight, out_features, in_features);
-  auto attr = ideep::attr_t();
-  if (eltwise == ReLU)
-    attr = ideep::attr_t::fuse_relu();
-  else
-    attr = ideep::attr_t::fuse_sigmoid();
-  return linear_kernel(self, mkldnn_weight, bias_, attr);
+  return linear_kernel(
+      self, mkldnn_weight, bias_, linear_eltwise_attr(eltwise));
 }
 
 std::tuple<at::Tensor, at::Tensor, at::Tensor> linear_backward(
@@ -183,9 +238,8 @@ at::Tensor IPEXLinearOp::_forward(
     const c10::optional<at::Tensor>& bias,
     const int64_t eltwise) {
   at::AutoNonVariableTypeMode g;
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("IPEXLinearOp::_forward", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("IPEXLinearOp::_forward", std::vector<c10::IValue>({}));
+  IPEX_TRACE_OP_INPUTS(input, weight);
   if (eltwise == NotFused) {
     static auto op = torch::Dispatcher::singleton()
                          .findSchemaOrThrow("torch_ipex::ipex_linear", "")
@@ -208,9 +262,7 @@ at::Tensor IPEXLinearOp::forward(
     const int64_t in_features,
     const c10::optional<at::Tensor>& bias,
     const int64_t eltwise) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("IPEXLinearOp::forward", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("IPEXLinearOp::forward", std::vector<c10::IValue>({}));
   at::AutoNonVariableTypeMode g;
   ctx->saved_data["out_features"] = out_features;
   ctx->saved_data["in_features"] = in_features;
@@ -219,6 +271,14 @@ at::Tensor IPEXLinearOp::forward(
   ctx->saved_data["bias_requires_grad"] =
       bias.has_value() && bias.value().requires_grad() ? true : false;
   ctx->saved_data["eltwise"] = eltwise;
+  if (eltwise == GeluErf || eltwise == GeluTanh) {
+    // the grad of gelu is of its input, which the fused kernel does not keep,
+    // so that the linear and the gelu are computed apart for training
+    auto pre_gelu =
+        _forward(input, weight, out_features, in_features, bias, NotFused);
+    ctx->save_for_backward({input, weight, pre_gelu});
+    return eltwise == GeluErf ? at::gelu(pre_gelu) : gelu_tanh(pre_gelu);
+  }
   auto output =
       _forward(input, weight, out_features, in_features, bias, eltwise);
   if (eltwise == NotFused)
@@ -231,9 +291,7 @@ at::Tensor IPEXLinearOp::forward(
 torch::autograd::tensor_list IPEXLinearOp::backward(
     torch::autograd::AutogradContext* ctx,
     torch::autograd::tensor_list grad_outputs) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("IPEXLinearOp::backward", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("IPEXLinearOp::backward", std::vector<c10::IValue>({}));
   auto saved = ctx->get_saved_variables();
   at::Tensor input = saved[0];
   at::Tensor weight = saved[1];
@@ -249,9 +307,14 @@ torch::autograd::tensor_list IPEXLinearOp::backward(
     grad_output = grad_outputs[0];
   } else {
     at::Tensor output = saved[2];
-    grad_output = eltwise == ReLU
-        ? relu_use_dst_for_bwd(grad_outputs[0], output)
-        : sigmoid_use_dst_for_bwd(grad_outputs[0], output);
+    if (eltwise == ReLU)
+      grad_output = relu_use_dst_for_bwd(grad_outputs[0], output);
+    else if (eltwise == Sigmoid)
+      grad_output = sigmoid_use_dst_for_bwd(grad_outputs[0], output);
+    else if (eltwise == GeluErf)
+      grad_output = at::gelu_backward(grad_outputs[0], output);
+    else
+      grad_output = gelu_tanh_backward(grad_outputs[0], output);
   }
 
   at::Tensor grad_input, grad_weight, grad_bias;
@@ -288,7 +351,10 @@ at::Tensor ipex_linear_eltwise(
     const int64_t in_features,
     const c10::optional<at::Tensor>& bias,
     const int64_t eltwise) {
-  return IPEXLinearOp::apply(
+  if (at::GradMode::is_enabled())
+    return IPEXLinearOp::apply(
+        input, weight, out_features, in_features, bias, eltwise);
+  return IPEXLinearOp::_forward(
       input, weight, out_features, in_features, bias, eltwise);
 }
 
@@ -311,7 +377,7 @@ at::Tensor ipex_linear(
 #if defined(ENABLE_AUTOCAST_VERBOSE)
   verbose::OpNameGuard op_name("ipex_linear");
 #endif
-  auto target_type = get_autocast_dtype();
+  auto target_type = get_lower_precision_dtype("ipex_linear");
   TORCH_CHECK(
       weight.scalar_type() == at::kBFloat16 ||
           weight.scalar_type() == at::kFloat,
@@ -338,7 +404,7 @@ at::Tensor ipex_linear_eltwise(
 #if defined(ENABLE_AUTOCAST_VERBOSE)
   verbose::OpNameGuard op_name("ipex_linear_eltwise");
 #endif
-  auto target_type = get_autocast_dtype();
+  auto target_type = get_lower_precision_dtype("ipex_linear_eltwise");
   TORCH_CHECK(
       weight.scalar_type() == at::kBFloat16 ||
           weight.scalar_type() == at::kFloat,
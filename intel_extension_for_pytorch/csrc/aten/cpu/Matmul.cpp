@@ -1,5 +1,7 @@
 #include "Linear.h"
+#include "SmallGemm.h"
 #include "csrc/cpu/ideep/IDeepConversions.h"
+#include "csrc/utils/op_trace.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -23,8 +25,6 @@ at::Tensor bmm_impl(
   auto tensor1_ = tensor1.is_contiguous() ? tensor1 : tensor1.contiguous();
   auto tensor2_ = tensor2.is_contiguous() ? tensor2 : tensor2.contiguous();
   const int64_t dim = tensor1.dim();
-  const ideep::tensor mkldnn_input = itensor_view_from_dense(tensor1_);
-  const ideep::tensor mkldnn_tensor2 = itensor_view_from_dense(tensor2_);
 
   auto output = out;
   if (!out.defined()) {
@@ -35,6 +35,16 @@ at::Tensor bmm_impl(
     output_size[dim - 1] = tensor2.size(dim - 1);
     output = at::empty(output_size, tensor1.options());
   }
+  // the small matrices of a large batch, e.g. of the attention, of which the
+  // scale is fused into the store of the microkernels
+  if (postop_tensors.empty() && attr.get_post_ops().len() == 0 &&
+      is_batched_small_gemm(tensor1_, tensor2_, output)) {
+    IPEX_TRACE_OP_KERNEL("small_gemm");
+    batched_small_gemm_kernel_stub(tensor1_, tensor2_, output, dst_coeff);
+    return output;
+  }
+  const ideep::tensor mkldnn_input = itensor_view_from_dense(tensor1_);
+  const ideep::tensor mkldnn_tensor2 = itensor_view_from_dense(tensor2_);
   ideep::tensor mkldnn_output = itensor_view_from_dense(output);
   ideep::matmul_forward::compute(
       mkldnn_input,
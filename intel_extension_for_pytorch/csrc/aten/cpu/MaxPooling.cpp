@@ -11,6 +11,7 @@
 #include <ATen/record_function.h>
 
 #include "csrc/utils/library.h"
+#include "csrc/utils/op_trace.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -630,11 +631,9 @@ std::tuple<at::Tensor, at::Tensor> max_pool2d_with_indices_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::max_pool2d_with_indices_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::max_pool2d_with_indices_out_cpu",
       std::vector<c10::IValue>({}));
-#endif
 
   // #20866, #22032: Guarantee this for the official C++ API?
   TORCH_CHECK(
@@ -757,11 +756,9 @@ at::Tensor max_pool2d_with_indices_backward_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::max_pool2d_with_indices_backward_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::max_pool2d_with_indices_backward_out_cpu",
       std::vector<c10::IValue>({}));
-#endif
 
   // #20866, #22032: Guarantee this for the official C++ API?
   TORCH_CHECK(
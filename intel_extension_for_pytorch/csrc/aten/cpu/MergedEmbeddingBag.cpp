@@ -2,26 +2,69 @@
 #include <ATen/AccumulateType.h>
 #include <ATen/Tensor.h>
 #include <torch/extension.h>
+#include <algorithm>
+#include <cstring>
+#include <limits>
 #include "csrc/autocast/autocast_mode.h"
+#include "csrc/cpu/vec512/int4/vec/int4_vec_kernel.h"
+#include "utils/csr2csc.h"
+#include "utils/emb_prefetch.h"
+#include "csrc/utils/op_trace.h"
+#include "csrc/utils/parallel_trace.h"
 
 namespace torch_ipex {
 namespace cpu {
 
 using namespace at;
 
+// The rows of a table, read from the compact copy of its hot rows if the
+// table has a hot row cache, i.e. hot_slots is the slot of each row in hot or
+// -1 if the row is not cached.
+template <typename T>
+struct EmbRows {
+  T* weight;
+  T* hot;
+  const int32_t* hot_slots;
+  int64_t vector_size;
+  int64_t hot_stride;
+
+  inline T* row(int64_t idx) const {
+    if (hot_slots != nullptr) {
+      auto slot = hot_slots[idx];
+      if (slot >= 0) {
+        return &hot[slot * hot_stride];
+      }
+    }
+    return &weight[idx * vector_size];
+  }
+
+  inline void prefetch(
+      const int64_t* indices_data,
+      int64_t p,
+      int64_t prefetch_end,
+      int64_t prefetch_distance) const {
+    auto ahead = p + prefetch_distance;
+    if (ahead < prefetch_end) {
+      emb_prefetch_lines(row(indices_data[ahead]), vector_size * sizeof(T));
+    }
+  }
+};
+
 template <typename T>
 inline void emb_pooling_ker(
     T* out,
-    T* in,
+    const EmbRows<T>& rows,
     size_t pool_begin,
     size_t pool_end,
     size_t vector_size,
     int64_t* indices_data,
     int64_t* offsets_data,
-    int64_t pooling_mode) {
-  auto idx = indices_data[pool_begin];
-  auto weight_ptr = &in[idx * vector_size];
+    int64_t pooling_mode,
+    size_t prefetch_end,
+    int64_t prefetch_distance) {
+  auto weight_ptr = rows.row(indices_data[pool_begin]);
   if (pool_end - pool_begin == 1) {
+    rows.prefetch(indices_data, pool_begin, prefetch_end, prefetch_distance);
     move_ker(out, weight_ptr, vector_size);
   } else {
     using acc_t = acc_type<T, true>;
@@ -30,8 +73,8 @@ inline void emb_pooling_ker(
     acc_t temp_out[vector_size];
     zero_ker(temp_out, vector_size);
     for (auto p = pool_begin; p < pool_end; ++p) {
-      idx = indices_data[p];
-      weight_ptr = &in[idx * vector_size];
+      rows.prefetch(indices_data, p, prefetch_end, prefetch_distance);
+      weight_ptr = rows.row(indices_data[p]);
       add_ker(temp_out, weight_ptr, vector_size);
     }
     if (pooling_mode == MEAN) {
@@ -46,15 +89,71 @@ inline void emb_pooling_ker(
   }
 }
 
+// A row of a row-wise quantized table is the uint8 of its vector_size
+// elements, two 4-bit elements per byte with the low nibble first, followed
+// by the scale and bias of the row, in float for 8 bits and in half for 4
+// bits. It's the layout of quantized::embedding_bag_byte_prepack and
+// quantized::embedding_bag_4bit_prepack.
+inline int64_t rowwise_feature_size(int64_t row_bytes, int64_t bits) {
+  return bits == 4 ? (row_bytes - 2 * sizeof(at::Half)) * 2
+                   : row_bytes - 2 * sizeof(float);
+}
+
+template <int BITS>
+inline void rowwise_emb_pooling_ker(
+    float* out,
+    const uint8_t* in,
+    size_t pool_begin,
+    size_t pool_end,
+    int64_t vector_size,
+    int64_t row_bytes,
+    int64_t* indices_data,
+    int64_t pooling_mode,
+    size_t prefetch_end,
+    int64_t prefetch_distance) {
+  // dequantize into the float accumulation of the bag
+  float temp_out[vector_size];
+  zero_ker(temp_out, vector_size);
+  for (auto p = pool_begin; p < pool_end; ++p) {
+    emb_prefetch_row(
+        in, indices_data, p, prefetch_end, row_bytes, prefetch_distance);
+    const uint8_t* row = &in[indices_data[p] * row_bytes];
+    float scale, bias;
+    if (BITS == 8) {
+      std::memcpy(&scale, row + vector_size, sizeof(float));
+      std::memcpy(&bias, row + vector_size + sizeof(float), sizeof(float));
+#pragma omp simd
+      for (int64_t d = 0; d < vector_size; ++d) {
+        temp_out[d] += scale * row[d] + bias;
+      }
+    } else {
+      at::Half scale_bias[2];
+      std::memcpy(scale_bias, row + (vector_size + 1) / 2, sizeof(scale_bias));
+      scale = scale_bias[0];
+      bias = scale_bias[1];
+      dequant_add_u4_ker(temp_out, row, scale, bias, vector_size);
+    }
+  }
+  if (pooling_mode == MEAN && pool_end - pool_begin > 1) {
+    const float scale_factor = 1.0 / (pool_end - pool_begin);
+#pragma omp simd
+    for (int64_t d = 0; d < vector_size; ++d) {
+      temp_out[d] = scale_factor * temp_out[d];
+    }
+  }
+  move_ker(out, temp_out, vector_size);
+}
+
 void merged_embeddingbag_forward_cpu_kernel(
     const Tensor& indices,
     const Tensor& offsets,
     const std::vector<Tensor>& weights,
     const std::vector<int64_t> pooling_modes,
+    const std::vector<int64_t>& weight_bits,
+    const std::vector<Tensor>& hot_weights,
+    const std::vector<Tensor>& hot_slots,
     std::vector<Tensor>& outputs) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(__FUNCTION__, std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION(__FUNCTION__, std::vector<c10::IValue>({}));
   int64_t n_tables = weights.size();
   TORCH_CHECK(n_tables > 0);
   // offsets.numel = [T x B  + 1]
@@ -72,6 +171,19 @@ void merged_embeddingbag_forward_cpu_kernel(
     dtypes.emplace_back(w.scalar_type());
   }
 
+  // the hot row cache of each table, empty if the table has none
+  std::vector<void*> hot_ptr(n_tables, nullptr);
+  std::vector<const int32_t*> hot_slots_ptr(n_tables, nullptr);
+  std::vector<int64_t> hot_strides(n_tables, 0);
+  for (int t = 0; t < hot_slots.size(); ++t) {
+    if (hot_slots[t].numel() == 0) {
+      continue;
+    }
+    hot_ptr[t] = hot_weights[t].data_ptr();
+    hot_slots_ptr[t] = hot_slots[t].data_ptr<int32_t>();
+    hot_strides[t] = hot_weights[t].stride(0);
+  }
+
   std::vector<void*> outs_ptr;
   for (auto& o : outputs) {
     outs_ptr.emplace_back(o.data_ptr());
@@ -80,78 +192,363 @@ void merged_embeddingbag_forward_cpu_kernel(
   const auto indices_data = indices.data_ptr<int64_t>();
   const auto offsets_data = offsets.data_ptr<int64_t>();
 
-  int64_t n_offsets = offsets.numel() - 1;
-  parallel_for(0, n_offsets, 0, [&](int64_t offset_begin, int64_t offset_end) {
-    for (int n = offset_begin; n < offset_end; ++n) {
-      int table_id = 0;
-      int64_t temp_n = n;
-      while (temp_n >= B) {
-        temp_n -= B;
+  int64_t n_offsets = n_tables * B;
+  if (n_offsets == 0) {
+    return;
+  }
+
+  // The work of the bags before bag n, counting the feature_size elements
+  // of every pooled index and of the output row of every bag. It is the
+  // prefix sums of the pooling lengths of each table, weighted by the
+  // feature_size of the table.
+  std::vector<int64_t> feature_sizes(n_tables);
+  std::vector<int64_t> table_work_begin(n_tables + 1, 0);
+  for (int t = 0; t < n_tables; ++t) {
+    feature_sizes[t] = outputs[t].size(1);
+    auto table_indices = offsets_data[(t + 1) * B] - offsets_data[t * B];
+    table_work_begin[t + 1] =
+        table_work_begin[t] + (table_indices + B) * feature_sizes[t];
+  }
+  std::vector<int64_t> prefetch_distances(n_tables);
+  for (int t = 0; t < n_tables; ++t) {
+    prefetch_distances[t] =
+        emb_prefetch_distance(weights[t].size(1) * weights[t].element_size());
+  }
+  auto work_before = [&](int64_t n) {
+    if (n >= n_offsets) {
+      return table_work_begin[n_tables];
+    }
+    int64_t t = n / B;
+    auto table_offset = t * B;
+    return table_work_begin[t] +
+        (offsets_data[n] - offsets_data[table_offset] + n - table_offset) *
+        feature_sizes[t];
+  };
+  // the first bag of which the work before is at least work
+  auto find_bag = [&](int64_t work) {
+    int64_t lo = 0, hi = n_offsets;
+    while (lo < hi) {
+      auto mid = lo + (hi - lo) / 2;
+      if (work_before(mid) < work) {
+        lo = mid + 1;
+      } else {
+        hi = mid;
+      }
+    }
+    return lo;
+  };
+
+  // one chunk of balanced work per thread instead of the same number of
+  // bags, since the pooling factors of the tables may differ by orders of
+  // magnitude
+  int64_t total_work = table_work_begin[n_tables];
+  int64_t n_chunks = std::min<int64_t>(at::get_num_threads(), n_offsets);
+  parallel_trace::ParallelRegion region("merged_embeddingbag_forward");
+  parallel_for(0, n_chunks, 1, [&](int64_t chunk_begin, int64_t chunk_end) {
+    IPEX_PARALLEL_CHUNK(region);
+    auto offset_begin = find_bag(total_work * chunk_begin / n_chunks);
+    auto offset_end = chunk_end == n_chunks
+        ? n_offsets
+        : find_bag(total_work * chunk_end / n_chunks);
+    if (offset_begin >= offset_end) {
+      return;
+    }
+    int table_id = offset_begin / B;
+    int64_t table_end = (table_id + 1) * B;
+    for (int64_t n = offset_begin; n < offset_end; ++n) {
+      if (n == table_end) {
         table_id += 1;
+        table_end += B;
       }
+      int64_t temp_n = n - (table_end - B);
       const auto pool_begin = offsets_data[n];
       const auto pool_end = offsets_data[n + 1];
-      auto feature_size = weights[table_id].size(1);
-      if (dtypes[table_id] == ScalarType::BFloat16) {
+      auto feature_size = feature_sizes[table_id];
+      // prefetch the rows of the next bags of this thread in the same table
+      size_t prefetch_end = offsets_data[std::min(offset_end, table_end)];
+      auto prefetch_distance = prefetch_distances[table_id];
+      if (dtypes[table_id] == ScalarType::Byte) {
+        float* out_ptr = &(((float*)outs_ptr[table_id])[temp_n * feature_size]);
+        auto rowwise_ker = weight_bits[table_id] == 4
+            ? &rowwise_emb_pooling_ker<4>
+            : &rowwise_emb_pooling_ker<8>;
+        rowwise_ker(
+            out_ptr,
+            (uint8_t*)weights_ptr[table_id],
+            pool_begin,
+            pool_end,
+            feature_size,
+            weights[table_id].size(1),
+            indices_data,
+            pooling_modes[table_id],
+            prefetch_end,
+            prefetch_distance);
+      } else if (dtypes[table_id] == ScalarType::BFloat16) {
         BFloat16* out_ptr =
             &(((BFloat16*)outs_ptr[table_id])[temp_n * feature_size]);
         emb_pooling_ker<BFloat16>(
             out_ptr,
-            (BFloat16*)weights_ptr[table_id],
+            {(BFloat16*)weights_ptr[table_id],
+             (BFloat16*)hot_ptr[table_id],
+             hot_slots_ptr[table_id],
+             feature_size,
+             hot_strides[table_id]},
             pool_begin,
             pool_end,
             feature_size,
             indices_data,
             offsets_data,
-            pooling_modes[table_id]);
+            pooling_modes[table_id],
+            prefetch_end,
+            prefetch_distance);
       } else if (dtypes[table_id] == ScalarType::Float) {
         float* out_ptr = &(((float*)outs_ptr[table_id])[temp_n * feature_size]);
         emb_pooling_ker<float>(
             out_ptr,
-            (float*)weights_ptr[table_id],
+            {(float*)weights_ptr[table_id],
+             (float*)hot_ptr[table_id],
+             hot_slots_ptr[table_id],
+             feature_size,
+             hot_strides[table_id]},
             pool_begin,
             pool_end,
             feature_size,
             indices_data,
             offsets_data,
-            pooling_modes[table_id]);
+            pooling_modes[table_id],
+            prefetch_end,
+            prefetch_distance);
       } else {
         double* out_ptr =
             &(((double*)outs_ptr[table_id])[temp_n * feature_size]);
         emb_pooling_ker<double>(
             out_ptr,
-            (double*)weights_ptr[table_id],
+            {(double*)weights_ptr[table_id],
+             (double*)hot_ptr[table_id],
+             hot_slots_ptr[table_id],
+             feature_size,
+             hot_strides[table_id]},
             pool_begin,
             pool_end,
             feature_size,
             indices_data,
             offsets_data,
-            pooling_modes[table_id]);
+            pooling_modes[table_id],
+            prefetch_end,
+            prefetch_distance);
       }
     }
   });
   return;
 }
 
+// Gather the unique rows of the batch of each vocabulary, i.e. of the tables
+// of the same weight, into a compact buffer, so that a row repeated in the
+// batch is read from its table once. inverse maps the indices to the rows of
+// the buffers.
+void gather_unique_rows(
+    const Tensor& indices,
+    const Tensor& offsets,
+    const std::vector<Tensor>& weights,
+    Tensor& inverse,
+    std::vector<Tensor>& gathered) {
+  int64_t n_tables = weights.size();
+  int64_t B = (offsets.numel() - 1) / n_tables;
+  // the first table of the vocabulary of each table, and the first key of the
+  // vocabulary
+  std::vector<int64_t> vocabulary(n_tables);
+  std::vector<int64_t> keys_begin(n_tables);
+  int64_t max_keys = 0;
+  for (int t = 0; t < n_tables; ++t) {
+    vocabulary[t] = t;
+    for (int v = 0; v < t; ++v) {
+      if (vocabulary[v] == v &&
+          weights[v].data_ptr() == weights[t].data_ptr() &&
+          weights[v].sizes() == weights[t].sizes() &&
+          weights[v].dtype() == weights[t].dtype()) {
+        vocabulary[t] = v;
+        break;
+      }
+    }
+    if (vocabulary[t] == t) {
+      keys_begin[t] = max_keys;
+      max_keys += weights[t].size(0);
+    } else {
+      keys_begin[t] = keys_begin[vocabulary[t]];
+    }
+  }
+  TORCH_CHECK(
+      max_keys <= std::numeric_limits<int>::max(),
+      "merged_embeddingbag_forward_cpu only support dedup of the tables of at most ",
+      std::numeric_limits<int>::max(),
+      " rows in total");
+
+  auto unique_keys = sort_based_unique_keys(
+      indices, offsets, B, keys_begin, max_keys, inverse);
+  const int64_t* unique_keys_data = unique_keys.data_ptr<int64_t>();
+  int64_t n_unique = unique_keys.numel();
+
+  // the unique keys of each vocabulary are contiguous
+  std::vector<int64_t> unique_begin(n_tables);
+  gathered.resize(n_tables);
+  for (int t = 0; t < n_tables; ++t) {
+    if (vocabulary[t] != t) {
+      unique_begin[t] = unique_begin[vocabulary[t]];
+      gathered[t] = gathered[vocabulary[t]];
+      continue;
+    }
+    auto& w = weights[t];
+    int64_t begin = std::lower_bound(
+                        unique_keys_data,
+                        unique_keys_data + n_unique,
+                        keys_begin[t]) -
+        unique_keys_data;
+    int64_t end = std::lower_bound(
+                      unique_keys_data,
+                      unique_keys_data + n_unique,
+                      keys_begin[t] + w.size(0)) -
+        unique_keys_data;
+    unique_begin[t] = begin;
+    gathered[t] = empty({end - begin, w.size(1)}, w.options());
+    auto src = (const char*)w.data_ptr();
+    auto dst = (char*)gathered[t].data_ptr();
+    int64_t row_bytes = w.size(1) * w.element_size();
+    auto prefetch_distance = emb_prefetch_distance(row_bytes);
+    parallel_trace::ParallelRegion region(
+        "merged_embeddingbag_gather_unique_rows");
+    parallel_for(begin, end, 64, [&](int64_t u_begin, int64_t u_end) {
+      IPEX_PARALLEL_CHUNK(region);
+      for (int64_t u = u_begin; u < u_end; ++u) {
+        if (u + prefetch_distance < u_end) {
+          emb_prefetch_lines(
+              src +
+                  (unique_keys_data[u + prefetch_distance] - keys_begin[t]) *
+                      row_bytes,
+              row_bytes);
+        }
+        std::memcpy(
+            dst + (u - begin) * row_bytes,
+            src + (unique_keys_data[u] - keys_begin[t]) * row_bytes,
+            row_bytes);
+      }
+    });
+  }
+
+  // the ids of the unique keys to the rows of the buffers
+  int64_t* inverse_data = inverse.data_ptr<int64_t>();
+  const int64_t* offsets_data = offsets.data_ptr<int64_t>();
+  parallel_for(0, n_tables * B, 0, [&](int64_t n_begin, int64_t n_end) {
+    for (int64_t n = n_begin; n < n_end; ++n) {
+      auto table_unique_begin = unique_begin[n / B];
+      for (auto p = offsets_data[n]; p < offsets_data[n + 1]; ++p) {
+        inverse_data[p] -= table_unique_begin;
+      }
+    }
+  });
+}
+
 std::vector<Tensor> merged_embeddingbag_forward_cpu(
     const Tensor& indices,
     const Tensor& offsets,
     const std::vector<Tensor>& weights,
-    const std::vector<int64_t> pooling_modes) {
+    const std::vector<int64_t> pooling_modes,
+    c10::optional<at::IntArrayRef> weight_bits,
+    c10::optional<at::TensorList> hot_weights,
+    c10::optional<at::TensorList> hot_slots,
+    bool dedup) {
   int64_t n_tables = weights.size();
   int64_t bs = (offsets.numel() - 1) / n_tables;
+  TORCH_CHECK(
+      !weight_bits.has_value() || weight_bits->size() == n_tables,
+      "merged_embeddingbag_forward_cpu expects the weight_bits of each table");
 
   std::vector<Tensor> outputs;
-  for (auto& w : weights) {
+  std::vector<int64_t> bits(n_tables, 8);
+  for (int t = 0; t < n_tables; ++t) {
+    auto& w = weights[t];
     auto dtype = w.scalar_type();
     TORCH_CHECK(
-        kBFloat16 == dtype || kFloat == dtype || kDouble == dtype,
-        "merged_embeddingbag_forward_cpu only support weight dtype in bfloat16, float, double");
-    int64_t feature_size = w.size(1);
-    outputs.emplace_back(empty({bs, feature_size}, w.options()));
+        kBFloat16 == dtype || kFloat == dtype || kDouble == dtype ||
+            kByte == dtype,
+        "merged_embeddingbag_forward_cpu only support weight dtype in bfloat16, float, double or uint8 of the row-wise quantized tables");
+    if (kByte == dtype) {
+      // the pooled rows of a row-wise quantized table are dequantized to
+      // float
+      if (weight_bits.has_value()) {
+        bits[t] = (*weight_bits)[t];
+      }
+      TORCH_CHECK(
+          bits[t] == 8 || bits[t] == 4,
+          "merged_embeddingbag_forward_cpu only support the 8 and 4 bits row-wise quantized tables");
+      int64_t feature_size = rowwise_feature_size(w.size(1), bits[t]);
+      TORCH_CHECK(feature_size > 0);
+      outputs.emplace_back(
+          empty({bs, feature_size}, w.options().dtype(kFloat)));
+    } else {
+      int64_t feature_size = w.size(1);
+      outputs.emplace_back(empty({bs, feature_size}, w.options()));
+    }
+  }
+
+  std::vector<Tensor> hot_weights_;
+  std::vector<Tensor> hot_slots_;
+  TORCH_CHECK(
+      hot_weights.has_value() == hot_slots.has_value(),
+      "merged_embeddingbag_forward_cpu expects both the hot_weights and hot_slots of the hot row cache");
+  if (hot_slots.has_value()) {
+    TORCH_CHECK(
+        hot_weights->size() == n_tables && hot_slots->size() == n_tables,
+        "merged_embeddingbag_forward_cpu expects the hot row cache of each table");
+    for (int t = 0; t < n_tables; ++t) {
+      auto& slots = (*hot_slots)[t];
+      auto& hot = (*hot_weights)[t];
+      if (slots.numel() > 0) {
+        auto& w = weights[t];
+        TORCH_CHECK(
+            w.is_floating_point(),
+            "merged_embeddingbag_forward_cpu only support the hot row cache of the floating point tables");
+        TORCH_CHECK(
+            slots.scalar_type() == kInt && slots.is_contiguous() &&
+                slots.numel() == w.size(0),
+            "merged_embeddingbag_forward_cpu expects the int32 hot slot of each row");
+        TORCH_CHECK(
+            hot.scalar_type() == w.scalar_type() && hot.dim() == 2 &&
+                hot.size(1) == w.size(1) && hot.stride(1) == 1,
+            "merged_embeddingbag_forward_cpu expects the hot rows of the same dtype and feature size as the table");
+      }
+      hot_weights_.emplace_back(hot);
+      hot_slots_.emplace_back(slots);
+    }
+  }
+  if (dedup && bs > 0) {
+    // the gathered rows are as compact as the hot row cache
+    TORCH_CHECK(
+        !hot_slots.has_value(),
+        "merged_embeddingbag_forward_cpu does not support dedup with the hot row cache");
+    TORCH_CHECK(indices.is_contiguous() && offsets.is_contiguous());
+    Tensor inverse;
+    std::vector<Tensor> gathered;
+    gather_unique_rows(indices, offsets, weights, inverse, gathered);
+    merged_embeddingbag_forward_cpu_kernel(
+        inverse,
+        offsets,
+        gathered,
+        pooling_modes,
+        bits,
+        hot_weights_,
+        hot_slots_,
+        outputs);
+    return outputs;
   }
   merged_embeddingbag_forward_cpu_kernel(
-      indices, offsets, weights, pooling_modes, outputs);
+      indices,
+      offsets,
+      weights,
+      pooling_modes,
+      bits,
+      hot_weights_,
+      hot_slots_,
+      outputs);
 
   return outputs;
 }
@@ -166,7 +563,11 @@ std::vector<Tensor> merged_embeddingbag_forward(
     const Tensor& indices,
     const Tensor& offsets,
     const std::vector<Tensor>& weights,
-    const std::vector<int64_t> pooling_modes) {
+    const std::vector<int64_t> pooling_modes,
+    c10::optional<at::IntArrayRef> weight_bits,
+    c10::optional<at::TensorList> hot_weights,
+    c10::optional<at::TensorList> hot_slots,
+    bool dedup) {
   c10::impl::ExcludeDispatchKeyGuard no_autocastCPU(DispatchKey::AutocastCPU);
   static auto op =
       torch::Dispatcher::singleton()
@@ -174,9 +575,36 @@ std::vector<Tensor> merged_embeddingbag_forward(
           .typed<decltype(merged_embeddingbag_forward)>();
   bool cast_to_bfloat16 =
       !at::GradMode::is_enabled() && at::kBFloat16 == get_autocast_dtype();
-  auto casted_weights =
-      cast_to_bfloat16 ? cpu_cached_cast(at::kBFloat16, weights) : weights;
-  return op.call(indices, offsets, casted_weights, pooling_modes);
+  // the row-wise quantized tables are kept as they are
+  std::vector<Tensor> casted_weights;
+  for (auto& w : weights) {
+    casted_weights.emplace_back(
+        cast_to_bfloat16 && w.is_floating_point()
+            ? cpu_cached_cast(at::kBFloat16, w)
+            : w);
+  }
+  // the hot rows are cast with their tables
+  c10::optional<std::vector<Tensor>> casted_hot_weights;
+  if (hot_weights.has_value()) {
+    casted_hot_weights = std::vector<Tensor>();
+    for (auto& hot : *hot_weights) {
+      casted_hot_weights->emplace_back(
+          cast_to_bfloat16 && hot.is_floating_point()
+              ? cpu_cached_cast(at::kBFloat16, hot)
+              : hot);
+    }
+  }
+  return op.call(
+      indices,
+      offsets,
+      casted_weights,
+      pooling_modes,
+      weight_bits,
+      casted_hot_weights.has_value()
+          ? c10::optional<at::TensorList>(*casted_hot_weights)
+          : c10::nullopt,
+      hot_slots,
+      dedup);
 }
 
 } // namespace autocast
@@ -186,7 +614,7 @@ namespace {
 
 TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
   m.def(
-      "merged_embeddingbag_forward(Tensor indices, Tensor offsets, Tensor[] weight, int[] pooling_modes) -> Tensor[]");
+      "merged_embeddingbag_forward(Tensor indices, Tensor offsets, Tensor[] weight, int[] pooling_modes, int[]? weight_bits=None, Tensor[]? hot_weights=None, Tensor[]? hot_slots=None, bool dedup=False) -> Tensor[]");
   m.impl(
       "merged_embeddingbag_forward",
       c10::DispatchKey::CPU,
@@ -19,6 +19,72 @@ struct SGDArgs {
   float lr;
 };
 
+// The optimizer states below are of the accumulation type of each table,
+// i.e. float for the bfloat16 and float tables and double for the double
+// tables. The bfloat16 tables are updated in float with their bf16_trail as
+// SGD does.
+
+// Row-wise Adagrad keeps one momentum per row, the sum of the mean squared
+// grads of the row.
+struct RowwiseAdagradArgs {
+  RowwiseAdagradArgs(
+      const std::vector<Tensor>& bf16_trail_,
+      const std::vector<Tensor>& momentum_,
+      float weight_decay_,
+      float lr_,
+      float eps_)
+      : bf16_trail(bf16_trail_),
+        momentum(momentum_),
+        weight_decay(weight_decay_),
+        lr(lr_),
+        eps(eps_) {}
+
+  std::vector<Tensor> bf16_trail;
+  std::vector<Tensor> momentum;
+  float weight_decay;
+  float lr;
+  float eps;
+};
+
+// The lazy Adam of torch.optim.SparseAdam, which only updates the moments of
+// the rows in the batch, with the bias corrections of the global step.
+struct AdamArgs {
+  AdamArgs(
+      const std::vector<Tensor>& bf16_trail_,
+      const std::vector<Tensor>& exp_avg_,
+      const std::vector<Tensor>& exp_avg_sq_,
+      float beta1_,
+      float beta2_,
+      float eps_,
+      float weight_decay_,
+      float lr_,
+      int64_t step_)
+      : bf16_trail(bf16_trail_),
+        exp_avg(exp_avg_),
+        exp_avg_sq(exp_avg_sq_),
+        beta1(beta1_),
+        beta2(beta2_),
+        eps(eps_),
+        weight_decay(weight_decay_),
+        lr(lr_),
+        step(step_) {}
+
+  std::vector<Tensor> bf16_trail;
+  std::vector<Tensor> exp_avg;
+  std::vector<Tensor> exp_avg_sq;
+  float beta1;
+  float beta2;
+  float eps;
+  float weight_decay;
+  float lr;
+  int64_t step;
+};
+
+// LAMB of the same moments as Adam, with the trust ratio of each row.
+struct LambArgs : AdamArgs {
+  using AdamArgs::AdamArgs;
+};
+
 template <typename T, typename optimizer_args_t>
 class AccGradUpdate {};
 
@@ -36,5 +102,47 @@ class AccGradUpdate<T, SGDArgs> {
       const SGDArgs& args);
 };
 
+template <typename T>
+class AccGradUpdate<T, RowwiseAdagradArgs> {
+ public:
+  static void update(
+      T* weight,
+      T* grad,
+      const BatchedHyperCompressedSparseColumn& batched_csc,
+      int64_t uniq_index_id,
+      int64_t weight_offsets,
+      int vector_size,
+      int table_id,
+      const RowwiseAdagradArgs& args);
+};
+
+template <typename T>
+class AccGradUpdate<T, AdamArgs> {
+ public:
+  static void update(
+      T* weight,
+      T* grad,
+      const BatchedHyperCompressedSparseColumn& batched_csc,
+      int64_t uniq_index_id,
+      int64_t weight_offsets,
+      int vector_size,
+      int table_id,
+      const AdamArgs& args);
+};
+
+template <typename T>
+class AccGradUpdate<T, LambArgs> {
+ public:
+  static void update(
+      T* weight,
+      T* grad,
+      const BatchedHyperCompressedSparseColumn& batched_csc,
+      int64_t uniq_index_id,
+      int64_t weight_offsets,
+      int vector_size,
+      int table_id,
+      const LambArgs& args);
+};
+
 } // namespace cpu
 } // namespace torch_ipex
@@ -0,0 +1,664 @@
+#include <c10/core/CPUAllocator.h>
+#include <omp.h>
+#include <algorithm>
+#include <cmath>
+#include "MergedEmbeddingBag.h"
+#include "csrc/utils/op_trace.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+using namespace at;
+
+template <typename param_t, typename acc_t>
+inline void sgd_update(
+    param_t* param_ptr,
+    at::BFloat16* trail_ptr,
+    acc_t* grad_ptr,
+    float weight_decay,
+    float lr,
+    int size) {
+  using Vec = at::vec::Vectorized<param_t>;
+  int64_t d = 0;
+  for (; d < size - (size % Vec::size()); d += Vec::size()) {
+    Vec param_vec = Vec::loadu(param_ptr + d);
+    Vec grad_vec =
+        Vec::loadu(grad_ptr + d) + param_vec * Vec(param_t(weight_decay));
+
+    param_vec -= grad_vec * Vec(param_t(lr));
+    param_vec.store(param_ptr + d);
+  }
+  for (; d < size; d++) {
+    param_t grad_val = grad_ptr[d] + param_ptr[d] * weight_decay;
+    param_ptr[d] -= grad_val * lr;
+  }
+}
+
+template <>
+inline void sgd_update<at::BFloat16, float>(
+    at::BFloat16* param_ptr,
+    at::BFloat16* trail_ptr,
+    float* grad_ptr,
+    float weight_decay,
+    float lr,
+    int size) {
+  using bVec = at::vec::Vectorized<at::BFloat16>;
+  using fVec = at::vec::Vectorized<float>;
+  int64_t d = 0;
+  for (; d < size - (size % bVec::size()); d += bVec::size()) {
+    bVec param_bvec = bVec::loadu(param_ptr + d);
+    bVec trail_bvec = bVec::loadu(trail_ptr + d);
+    fVec param_fvec, param_fvec2;
+    std::tie(param_fvec, param_fvec2) =
+        torch_ipex::cpu::bf16::pack_bfloat16_float(param_bvec, trail_bvec);
+
+    fVec grad_fvec = fVec::loadu(grad_ptr + d);
+    fVec grad_fvec2 = fVec::loadu(grad_ptr + d + fVec::size());
+
+    grad_fvec = grad_fvec + param_fvec * fVec(weight_decay);
+    grad_fvec2 = grad_fvec2 + param_fvec2 * fVec(weight_decay);
+
+    param_fvec -= grad_fvec * fVec(lr);
+    param_fvec2 -= grad_fvec2 * fVec(lr);
+
+    std::tie(param_bvec, trail_bvec) =
+        torch_ipex::cpu::bf16::unpack_float_bfloat16(param_fvec, param_fvec2);
+    param_bvec.store(param_ptr + d);
+    trail_bvec.store(trail_ptr + d);
+  }
+  for (; d < size; d++) {
+    float param_val =
+        torch_ipex::cpu::bf16::pack_bfloat16_float(param_ptr[d], trail_ptr[d]);
+    float grad_val = grad_ptr[d] + param_val * weight_decay;
+    param_val -= grad_val * lr;
+    std::tie(param_ptr[d], trail_ptr[d]) =
+        torch_ipex::cpu::bf16::unpack_float_bfloat16(param_val);
+  }
+}
+
+// Accumulate the grads of the output rows of the uniq_index_id-th unique
+// index, i.e. the grad of its weight row.
+template <typename T, typename acc_t>
+inline void accumulate_row_grad(
+    acc_t* grad_acc_buffer,
+    T* grad,
+    const BatchedHyperCompressedSparseColumn& batched_csc,
+    int64_t uniq_index_id,
+    int vector_size) {
+  zero_ker(grad_acc_buffer, vector_size);
+  for (int r = batched_csc.segment_ptr[uniq_index_id];
+       r < batched_csc.segment_ptr[uniq_index_id + 1];
+       ++r) {
+    T* grad_ptr = &grad[batched_csc.output_row_indices[r] * vector_size];
+    if (batched_csc.weights && batched_csc.weights[r] != 1) {
+      madd_ker(grad_acc_buffer, grad_ptr, vector_size, batched_csc.weights[r]);
+    } else {
+      add_ker(grad_acc_buffer, grad_ptr, vector_size);
+    }
+  }
+}
+
+template <typename T>
+inline void AccGradUpdate<T, SGDArgs>::update(
+    T* weight,
+    T* grad,
+    const BatchedHyperCompressedSparseColumn& batched_csc,
+    int64_t uniq_index_id,
+    int64_t weight_offsets,
+    int vector_size,
+    int table_id,
+    const SGDArgs& args) {
+  // grad accumulate
+  using acc_t = acc_type<T, true>;
+  acc_t grad_acc_buffer[vector_size];
+  accumulate_row_grad(
+      grad_acc_buffer, grad, batched_csc, uniq_index_id, vector_size);
+  // sgd update
+  T* weight_ptr = &weight[weight_offsets];
+  BFloat16* bf16_trail_ptr = nullptr;
+  if (std::is_same<T, BFloat16>::value) {
+    bf16_trail_ptr =
+        args.bf16_trail[table_id].data_ptr<BFloat16>() + weight_offsets;
+  }
+  sgd_update<T, acc_t>(
+      weight_ptr,
+      bf16_trail_ptr,
+      grad_acc_buffer,
+      args.weight_decay,
+      args.lr,
+      vector_size);
+}
+
+// The weight row in its accumulation type, with the bf16_trail of a
+// bfloat16 table.
+template <typename T, typename acc_t>
+inline void load_weight_row(
+    acc_t* out,
+    const T* weight_ptr,
+    const BFloat16* trail_ptr,
+    int size) {
+  for (int d = 0; d < size; d++) {
+    out[d] = weight_ptr[d];
+  }
+}
+
+template <>
+inline void load_weight_row<BFloat16, float>(
+    float* out,
+    const BFloat16* weight_ptr,
+    const BFloat16* trail_ptr,
+    int size) {
+  for (int d = 0; d < size; d++) {
+    out[d] = torch_ipex::cpu::bf16::pack_bfloat16_float(
+        weight_ptr[d], trail_ptr[d]);
+  }
+}
+
+template <typename T, typename acc_t>
+inline void store_weight_row(
+    T* weight_ptr,
+    BFloat16* trail_ptr,
+    const acc_t* in,
+    int size) {
+  for (int d = 0; d < size; d++) {
+    weight_ptr[d] = in[d];
+  }
+}
+
+template <>
+inline void store_weight_row<BFloat16, float>(
+    BFloat16* weight_ptr,
+    BFloat16* trail_ptr,
+    const float* in,
+    int size) {
+  for (int d = 0; d < size; d++) {
+    std::tie(weight_ptr[d], trail_ptr[d]) =
+        torch_ipex::cpu::bf16::unpack_float_bfloat16(in[d]);
+  }
+}
+
+template <typename T>
+inline BFloat16* bf16_trail_row(
+    const std::vector<Tensor>& bf16_trail,
+    int table_id,
+    int64_t weight_offsets) {
+  if (std::is_same<T, BFloat16>::value) {
+    return bf16_trail[table_id].data_ptr<BFloat16>() + weight_offsets;
+  }
+  return nullptr;
+}
+
+template <typename T>
+inline void AccGradUpdate<T, RowwiseAdagradArgs>::update(
+    T* weight,
+    T* grad,
+    const BatchedHyperCompressedSparseColumn& batched_csc,
+    int64_t uniq_index_id,
+    int64_t weight_offsets,
+    int vector_size,
+    int table_id,
+    const RowwiseAdagradArgs& args) {
+  using acc_t = acc_type<T, true>;
+  acc_t grad_acc_buffer[vector_size];
+  accumulate_row_grad(
+      grad_acc_buffer, grad, batched_csc, uniq_index_id, vector_size);
+  T* weight_ptr = &weight[weight_offsets];
+  BFloat16* trail_ptr =
+      bf16_trail_row<T>(args.bf16_trail, table_id, weight_offsets);
+  acc_t param[vector_size];
+  load_weight_row(param, weight_ptr, trail_ptr, vector_size);
+
+  acc_t grad_sq_sum = 0;
+#pragma omp simd reduction(+ : grad_sq_sum)
+  for (int d = 0; d < vector_size; d++) {
+    grad_acc_buffer[d] += args.weight_decay * param[d];
+    grad_sq_sum += grad_acc_buffer[d] * grad_acc_buffer[d];
+  }
+  acc_t& momentum = args.momentum[table_id]
+                        .data_ptr<acc_t>()[weight_offsets / vector_size];
+  momentum += grad_sq_sum / vector_size;
+  acc_t multiplier = args.lr / (std::sqrt(momentum) + args.eps);
+#pragma omp simd
+  for (int d = 0; d < vector_size; d++) {
+    param[d] -= multiplier * grad_acc_buffer[d];
+  }
+  store_weight_row(weight_ptr, trail_ptr, param, vector_size);
+}
+
+// Update the moments of Adam or LAMB, and write to update the bias corrected
+// step of Adam.
+template <typename acc_t>
+inline void adam_moments_update(
+    acc_t* update,
+    acc_t* exp_avg,
+    acc_t* exp_avg_sq,
+    const acc_t* grad,
+    const AdamArgs& args,
+    int size) {
+  acc_t bias_correction1 = 1 - std::pow(acc_t(args.beta1), args.step);
+  acc_t bias_correction2 = 1 - std::pow(acc_t(args.beta2), args.step);
+#pragma omp simd
+  for (int d = 0; d < size; d++) {
+    exp_avg[d] = args.beta1 * exp_avg[d] + (1 - args.beta1) * grad[d];
+    exp_avg_sq[d] =
+        args.beta2 * exp_avg_sq[d] + (1 - args.beta2) * grad[d] * grad[d];
+    update[d] = (exp_avg[d] / bias_correction1) /
+        (std::sqrt(exp_avg_sq[d] / bias_correction2) + args.eps);
+  }
+}
+
+template <typename T>
+inline void AccGradUpdate<T, AdamArgs>::update(
+    T* weight,
+    T* grad,
+    const BatchedHyperCompressedSparseColumn& batched_csc,
+    int64_t uniq_index_id,
+    int64_t weight_offsets,
+    int vector_size,
+    int table_id,
+    const AdamArgs& args) {
+  using acc_t = acc_type<T, true>;
+  acc_t grad_acc_buffer[vector_size];
+  accumulate_row_grad(
+      grad_acc_buffer, grad, batched_csc, uniq_index_id, vector_size);
+  T* weight_ptr = &weight[weight_offsets];
+  BFloat16* trail_ptr =
+      bf16_trail_row<T>(args.bf16_trail, table_id, weight_offsets);
+  acc_t param[vector_size];
+  load_weight_row(param, weight_ptr, trail_ptr, vector_size);
+
+  // L2 weight decay as torch.optim.Adam
+#pragma omp simd
+  for (int d = 0; d < vector_size; d++) {
+    grad_acc_buffer[d] += args.weight_decay * param[d];
+  }
+  acc_t update[vector_size];
+  adam_moments_update(
+      update,
+      args.exp_avg[table_id].data_ptr<acc_t>() + weight_offsets,
+      args.exp_avg_sq[table_id].data_ptr<acc_t>() + weight_offsets,
+      grad_acc_buffer,
+      args,
+      vector_size);
+#pragma omp simd
+  for (int d = 0; d < vector_size; d++) {
+    param[d] -= args.lr * update[d];
+  }
+  store_weight_row(weight_ptr, trail_ptr, param, vector_size);
+}
+
+template <typename T>
+inline void AccGradUpdate<T, LambArgs>::update(
+    T* weight,
+    T* grad,
+    const BatchedHyperCompressedSparseColumn& batched_csc,
+    int64_t uniq_index_id,
+    int64_t weight_offsets,
+    int vector_size,
+    int table_id,
+    const LambArgs& args) {
+  using acc_t = acc_type<T, true>;
+  acc_t grad_acc_buffer[vector_size];
+  accumulate_row_grad(
+      grad_acc_buffer, grad, batched_csc, uniq_index_id, vector_size);
+  T* weight_ptr = &weight[weight_offsets];
+  BFloat16* trail_ptr =
+      bf16_trail_row<T>(args.bf16_trail, table_id, weight_offsets);
+  acc_t param[vector_size];
+  load_weight_row(param, weight_ptr, trail_ptr, vector_size);
+
+  acc_t update[vector_size];
+  adam_moments_update(
+      update,
+      args.exp_avg[table_id].data_ptr<acc_t>() + weight_offsets,
+      args.exp_avg_sq[table_id].data_ptr<acc_t>() + weight_offsets,
+      grad_acc_buffer,
+      args,
+      vector_size);
+  // decoupled weight decay, and the trust ratio of the row
+  acc_t param_norm = 0, update_norm = 0;
+#pragma omp simd reduction(+ : param_norm, update_norm)
+  for (int d = 0; d < vector_size; d++) {
+    update[d] += args.weight_decay * param[d];
+    param_norm += param[d] * param[d];
+    update_norm += update[d] * update[d];
+  }
+  param_norm = std::sqrt(param_norm);
+  update_norm = std::sqrt(update_norm);
+  acc_t trust_ratio =
+      (param_norm > 0 && update_norm > 0) ? param_norm / update_norm : 1;
+#pragma omp simd
+  for (int d = 0; d < vector_size; d++) {
+    param[d] -= args.lr * trust_ratio * update[d];
+  }
+  store_weight_row(weight_ptr, trail_ptr, param, vector_size);
+}
+
+template <typename optimizer_arg_t>
+void merged_embeddingbag_backward_cpu_kernel(
+    const std::vector<Tensor>& grads_y,
+    const Tensor& indices,
+    const Tensor& offsets,
+    const std::vector<Tensor>& weights,
+    const Tensor& indices_with_row_offset,
+    const Tensor& row_offsets,
+    std::vector<int64_t> pooling_modes,
+    const optimizer_arg_t& args) {
+  int64_t n_tables = weights.size();
+  int64_t bs = (offsets.numel() - 1) / n_tables;
+  int64_t* row_offset_data = row_offsets.data_ptr<int64_t>();
+  int64_t max_embeddings = row_offset_data[n_tables];
+  BatchedHyperCompressedSparseColumn batched_csc;
+  sort_based_batched_csr2csc_opt(
+      batched_csc,
+      bs,
+      offsets,
+      indices_with_row_offset,
+      pooling_modes,
+      max_embeddings);
+  IPEX_RECORD_FUNCTION(__FUNCTION__, std::vector<c10::IValue>({}));
+
+  // the last table of which the row offset is not after index
+  auto get_table_id = [&](int index) {
+    return std::upper_bound(
+               row_offset_data + 1, row_offset_data + n_tables, index) -
+        (row_offset_data + 1);
+  };
+
+  int uniq_indice = batched_csc.uniq_indices;
+
+  std::vector<void*> weights_ptr;
+  std::vector<int64_t> weights_max_offsets;
+  std::vector<void*> grads_ptr;
+  std::vector<ScalarType> dtypes;
+
+  for (int i = 0; i < n_tables; i++) {
+    weights_ptr.emplace_back(weights[i].data_ptr());
+    grads_ptr.emplace_back(grads_y[i].data_ptr());
+    dtypes.emplace_back(weights[i].scalar_type());
+    weights_max_offsets.emplace_back(weights[i].size(0) * weights[i].size(1));
+  }
+
+#pragma omp parallel for schedule(static, 1)
+  for (int c = 0; c < uniq_indice; ++c) {
+    int row_index = batched_csc.segment_indices[c];
+    int table_id = get_table_id(row_index);
+    int vector_size = weights[table_id].size(1);
+    int64_t weight_offsets =
+        (row_index - row_offset_data[table_id]) * vector_size;
+    TORCH_CHECK(
+        weight_offsets >= 0 && weight_offsets < weights_max_offsets[table_id]);
+    if (dtypes[table_id] == ScalarType::BFloat16) {
+      AccGradUpdate<BFloat16, optimizer_arg_t>::update(
+          (BFloat16*)weights_ptr[table_id],
+          (BFloat16*)grads_ptr[table_id],
+          batched_csc,
+          c,
+          weight_offsets,
+          vector_size,
+          table_id,
+          args);
+    } else if (dtypes[table_id] == ScalarType::Float) {
+      AccGradUpdate<float, optimizer_arg_t>::update(
+          (float*)weights_ptr[table_id],
+          (float*)grads_ptr[table_id],
+          batched_csc,
+          c,
+          weight_offsets,
+          vector_size,
+          table_id,
+          args);
+    } else {
+      AccGradUpdate<double, optimizer_arg_t>::update(
+          (double*)weights_ptr[table_id],
+          (double*)grads_ptr[table_id],
+          batched_csc,
+          c,
+          weight_offsets,
+          vector_size,
+          table_id,
+          args);
+    }
+  }
+
+  return;
+}
+
+// The grads of the outputs in the dtypes of the tables.
+std::vector<Tensor> contiguous_grads(
+    const std::vector<Tensor>& grads_y_,
+    const std::vector<Tensor>& weights) {
+  int64_t n_tables = weights.size();
+  TORCH_CHECK(n_tables == grads_y_.size());
+  auto grads_y = grads_y_;
+  for (auto i = 0; i < n_tables; i++) {
+    TORCH_CHECK(grads_y_[i].scalar_type() == weights[i].scalar_type());
+    grads_y[i] = grads_y_[i].contiguous();
+  }
+  return grads_y;
+}
+
+void merged_embeddingbag_backward_sgd_cpu(
+    const std::vector<Tensor>& grads_y_,
+    const Tensor& indices,
+    const Tensor& offsets,
+    const std::vector<Tensor>& weights,
+    const Tensor& indices_with_row_offset,
+    const Tensor& row_offsets,
+    std::vector<int64_t> pooling_modes,
+    const std::vector<Tensor>& bf16_trail,
+    double weight_decay,
+    double lr) {
+  auto grads_y = contiguous_grads(grads_y_, weights);
+  SGDArgs args = SGDArgs(bf16_trail, weight_decay, lr);
+  merged_embeddingbag_backward_cpu_kernel<SGDArgs>(
+      grads_y,
+      indices,
+      offsets,
+      weights,
+      indices_with_row_offset,
+      row_offsets,
+      pooling_modes,
+      args);
+
+  return;
+}
+
+// The optimizer states of the rows must be of the accumulation type of the
+// table.
+void check_optimizer_states(
+    const std::vector<Tensor>& weights,
+    const std::vector<Tensor>& states,
+    bool rowwise) {
+  TORCH_CHECK(weights.size() == states.size());
+  for (int i = 0; i < weights.size(); i++) {
+    auto acc_dtype =
+        weights[i].scalar_type() == kDouble ? kDouble : kFloat;
+    TORCH_CHECK(
+        states[i].scalar_type() == acc_dtype && states[i].is_contiguous(),
+        "merged_embeddingbag_backward expects the optimizer states in ",
+        acc_dtype,
+        " for the table of ",
+        weights[i].scalar_type());
+    TORCH_CHECK(
+        states[i].numel() ==
+        (rowwise ? weights[i].size(0) : weights[i].numel()));
+  }
+}
+
+void merged_embeddingbag_backward_rowwise_adagrad_cpu(
+    const std::vector<Tensor>& grads_y_,
+    const Tensor& indices,
+    const Tensor& offsets,
+    const std::vector<Tensor>& weights,
+    const Tensor& indices_with_row_offset,
+    const Tensor& row_offsets,
+    std::vector<int64_t> pooling_modes,
+    const std::vector<Tensor>& bf16_trail,
+    const std::vector<Tensor>& momentum,
+    double weight_decay,
+    double lr,
+    double eps) {
+  auto grads_y = contiguous_grads(grads_y_, weights);
+  check_optimizer_states(weights, momentum, true);
+  RowwiseAdagradArgs args =
+      RowwiseAdagradArgs(bf16_trail, momentum, weight_decay, lr, eps);
+  merged_embeddingbag_backward_cpu_kernel<RowwiseAdagradArgs>(
+      grads_y,
+      indices,
+      offsets,
+      weights,
+      indices_with_row_offset,
+      row_offsets,
+      pooling_modes,
+      args);
+}
+
+template <typename optimizer_arg_t>
+void merged_embeddingbag_backward_adam_cpu_impl(
+    const std::vector<Tensor>& grads_y_,
+    const Tensor& indices,
+    const Tensor& offsets,
+    const std::vector<Tensor>& weights,
+    const Tensor& indices_with_row_offset,
+    const Tensor& row_offsets,
+    std::vector<int64_t> pooling_modes,
+    const std::vector<Tensor>& bf16_trail,
+    const std::vector<Tensor>& exp_avg,
+    const std::vector<Tensor>& exp_avg_sq,
+    double beta1,
+    double beta2,
+    double eps,
+    double weight_decay,
+    double lr,
+    int64_t step) {
+  auto grads_y = contiguous_grads(grads_y_, weights);
+  check_optimizer_states(weights, exp_avg, false);
+  check_optimizer_states(weights, exp_avg_sq, false);
+  TORCH_CHECK(step > 0, "merged_embeddingbag_backward expects the step from 1");
+  optimizer_arg_t args = optimizer_arg_t(
+      bf16_trail,
+      exp_avg,
+      exp_avg_sq,
+      beta1,
+      beta2,
+      eps,
+      weight_decay,
+      lr,
+      step);
+  merged_embeddingbag_backward_cpu_kernel<optimizer_arg_t>(
+      grads_y,
+      indices,
+      offsets,
+      weights,
+      indices_with_row_offset,
+      row_offsets,
+      pooling_modes,
+      args);
+}
+
+void merged_embeddingbag_backward_adam_cpu(
+    const std::vector<Tensor>& grads_y,
+    const Tensor& indices,
+    const Tensor& offsets,
+    const std::vector<Tensor>& weights,
+    const Tensor& indices_with_row_offset,
+    const Tensor& row_offsets,
+    std::vector<int64_t> pooling_modes,
+    const std::vector<Tensor>& bf16_trail,
+    const std::vector<Tensor>& exp_avg,
+    const std::vector<Tensor>& exp_avg_sq,
+    double beta1,
+    double beta2,
+    double eps,
+    double weight_decay,
+    double lr,
+    int64_t step) {
+  merged_embeddingbag_backward_adam_cpu_impl<AdamArgs>(
+      grads_y,
+      indices,
+      offsets,
+      weights,
+      indices_with_row_offset,
+      row_offsets,
+      pooling_modes,
+      bf16_trail,
+      exp_avg,
+      exp_avg_sq,
+      beta1,
+      beta2,
+      eps,
+      weight_decay,
+      lr,
+      step);
+}
+
+void merged_embeddingbag_backward_lamb_cpu(
+    const std::vector<Tensor>& grads_y,
+    const Tensor& indices,
+    const Tensor& offsets,
+    const std::vector<Tensor>& weights,
+    const Tensor& indices_with_row_offset,
+    const Tensor& row_offsets,
+    std::vector<int64_t> pooling_modes,
+    const std::vector<Tensor>& bf16_trail,
+    const std::vector<Tensor>& exp_avg,
+    const std::vector<Tensor>& exp_avg_sq,
+    double beta1,
+    double beta2,
+    double eps,
+    double weight_decay,
+    double lr,
+    int64_t step) {
+  merged_embeddingbag_backward_adam_cpu_impl<LambArgs>(
+      grads_y,
+      indices,
+      offsets,
+      weights,
+      indices_with_row_offset,
+      row_offsets,
+      pooling_modes,
+      bf16_trail,
+      exp_avg,
+      exp_avg_sq,
+      beta1,
+      beta2,
+      eps,
+      weight_decay,
+      lr,
+      step);
+}
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "merged_embeddingbag_backward_sgd(Tensor[] grad, Tensor indices, Tensor offsets, Tensor[] weight, Tensor indices_with_row_offset,  Tensor row_offsets, int[] pooling_modes, Tensor[] bf16_trail, float weight_decay, float lr) -> ()");
+  m.impl(
+      "merged_embeddingbag_backward_sgd",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::merged_embeddingbag_backward_sgd_cpu);
+  m.def(
+      "merged_embeddingbag_backward_rowwise_adagrad(Tensor[] grad, Tensor indices, Tensor offsets, Tensor[] weight, Tensor indices_with_row_offset,  Tensor row_offsets, int[] pooling_modes, Tensor[] bf16_trail, Tensor[] momentum, float weight_decay, float lr, float eps) -> ()");
+  m.impl(
+      "merged_embeddingbag_backward_rowwise_adagrad",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::merged_embeddingbag_backward_rowwise_adagrad_cpu);
+  m.def(
+      "merged_embeddingbag_backward_adam(Tensor[] grad, Tensor indices, Tensor offsets, Tensor[] weight, Tensor indices_with_row_offset,  Tensor row_offsets, int[] pooling_modes, Tensor[] bf16_trail, Tensor[] exp_avg, Tensor[] exp_avg_sq, float beta1, float beta2, float eps, float weight_decay, float lr, int step) -> ()");
+  m.impl(
+      "merged_embeddingbag_backward_adam",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::merged_embeddingbag_backward_adam_cpu);
+  m.def(
+      "merged_embeddingbag_backward_lamb(Tensor[] grad, Tensor indices, Tensor offsets, Tensor[] weight, Tensor indices_with_row_offset,  Tensor row_offsets, int[] pooling_modes, Tensor[] bf16_trail, Tensor[] exp_avg, Tensor[] exp_avg_sq, float beta1, float beta2, float eps, float weight_decay, float lr, int step) -> ()");
+  m.impl(
+      "merged_embeddingbag_backward_lamb",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::merged_embeddingbag_backward_lamb_cpu);
+}
+
+} // namespace
@@ -0,0 +1,93 @@
+#include <sys/mman.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "MergedEmbeddingBag.h"
+#include "csrc/utils/op_trace.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+using namespace at;
+
+// Advise the kernel to read the pages of the rows pooled by the bags of
+// indices and offsets ahead, e.g. of the tables mapped from the files on
+// NVMe. The reads are only started here, so that they overlap with the
+// compute before the forward of these bags, e.g. the dense layers of the
+// previous batch. The rows of the hot row caches are skipped.
+void merged_embeddingbag_prefetch_cpu(
+    const Tensor& indices,
+    const Tensor& offsets,
+    const std::vector<Tensor>& weights,
+    c10::optional<at::TensorList> hot_slots) {
+  IPEX_RECORD_FUNCTION(__FUNCTION__, std::vector<c10::IValue>({}));
+  int64_t n_tables = weights.size();
+  TORCH_CHECK(n_tables > 0);
+  int64_t B = (offsets.numel() - 1) / n_tables;
+  TORCH_CHECK(indices.is_contiguous());
+  TORCH_CHECK(offsets.is_contiguous());
+  TORCH_CHECK(!hot_slots.has_value() || hot_slots->size() == n_tables);
+  const auto indices_data = indices.data_ptr<int64_t>();
+  const auto offsets_data = offsets.data_ptr<int64_t>();
+  const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+
+  parallel_for(0, n_tables, 1, [&](int64_t table_begin, int64_t table_end) {
+    std::vector<uintptr_t> pages;
+    for (int64_t t = table_begin; t < table_end; ++t) {
+      auto& w = weights[t];
+      TORCH_CHECK(w.is_contiguous());
+      const int32_t* slots = nullptr;
+      if (hot_slots.has_value() && (*hot_slots)[t].numel() > 0) {
+        slots = (*hot_slots)[t].data_ptr<int32_t>();
+      }
+      auto base = reinterpret_cast<uintptr_t>(w.data_ptr());
+      uintptr_t row_bytes = w.size(1) * w.element_size();
+
+      // the first and the last page of each row
+      pages.clear();
+      for (auto p = offsets_data[t * B]; p < offsets_data[(t + 1) * B]; ++p) {
+        auto idx = indices_data[p];
+        if (slots != nullptr && slots[idx] >= 0) {
+          continue;
+        }
+        auto row = base + idx * row_bytes;
+        pages.push_back(row / page_size);
+        pages.push_back((row + row_bytes - 1) / page_size);
+      }
+      std::sort(pages.begin(), pages.end());
+      pages.erase(std::unique(pages.begin(), pages.end()), pages.end());
+
+      // one advice for each run of the consecutive pages
+      size_t run_begin = 0;
+      for (size_t i = 1; i <= pages.size(); ++i) {
+        if (i < pages.size() && pages[i] == pages[i - 1] + 1) {
+          continue;
+        }
+        // the advice is best effort, e.g. it fails on the memory not mapped
+        // from a file, which is already resident
+        madvise(
+            reinterpret_cast<void*>(pages[run_begin] * page_size),
+            (i - run_begin) * page_size,
+            MADV_WILLNEED);
+        run_begin = i;
+      }
+    }
+  });
+}
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "merged_embeddingbag_prefetch(Tensor indices, Tensor offsets, Tensor[] weight, Tensor[]? hot_slots=None) -> ()");
+  m.impl(
+      "merged_embeddingbag_prefetch",
+      c10::DispatchKey::CPU,
+      torch_ipex::cpu::merged_embeddingbag_prefetch_cpu);
+}
+
+} // namespace
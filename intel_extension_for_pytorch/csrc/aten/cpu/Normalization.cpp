@@ -18,6 +18,7 @@
 #include <vector>
 
 #include "csrc/utils/library.h"
+#include "csrc/utils/op_trace.h"
 
 static const int MIOPEN_DIM_MAX = 5;
 
@@ -230,6 +231,33 @@ struct BatchNormCollectStatsImpl {
         mean,
         size);
   }
+
+  // kernel4: 'channels last' memory format, Welford update of the mean and
+  // the sum of the squared differences per channel by a row of the input,
+  // rcount is 1 / the number of the rows of them including this one
+  static inline void kernel4(
+      scalar_t* mean,
+      scalar_t* m2,
+      const scalar_t* in,
+      scalar_t rcount,
+      int64_t size) {
+    Vec rcount_vec = Vec(rcount);
+    int64_t d = 0;
+    for (; d < size - (size % Vec::size()); d += Vec::size()) {
+      Vec data_vec = Vec::loadu(in + d);
+      Vec mean_vec = Vec::loadu(mean + d);
+      Vec delta_vec = data_vec - mean_vec;
+      mean_vec = mean_vec + delta_vec * rcount_vec;
+      Vec m2_vec = Vec::loadu(m2 + d) + delta_vec * (data_vec - mean_vec);
+      mean_vec.store(mean + d);
+      m2_vec.store(m2 + d);
+    }
+    for (; d < size; d++) {
+      scalar_t delta = in[d] - mean[d];
+      mean[d] += delta * rcount;
+      m2[d] += delta * (in[d] - mean[d]);
+    }
+  }
 };
 
 template <typename param_t>
@@ -341,6 +369,38 @@ struct BatchNormCollectStatsImpl<at::BFloat16, param_t> {
       buffer[d] += (data_val - mean_val) * (data_val - mean_val);
     }
   }
+
+  static inline void kernel4(
+      float* mean,
+      float* m2,
+      const at::BFloat16* in,
+      float rcount,
+      int64_t size) {
+    fVec rcount_fvec = fVec(rcount);
+    int64_t d = 0;
+    for (; d < size - (size % bVec::size()); d += bVec::size()) {
+      bVec data_bvec = bVec::loadu(in + d);
+      fVec data_fvec[2];
+      std::tie(data_fvec[0], data_fvec[1]) = convert_bfloat16_float(data_bvec);
+      for (int64_t j = 0; j < 2; j++) {
+        float* mean_ptr = mean + d + j * fVec::size();
+        float* m2_ptr = m2 + d + j * fVec::size();
+        fVec mean_fvec = fVec::loadu(mean_ptr);
+        fVec delta_fvec = data_fvec[j] - mean_fvec;
+        mean_fvec = mean_fvec + delta_fvec * rcount_fvec;
+        fVec m2_fvec =
+            fVec::loadu(m2_ptr) + delta_fvec * (data_fvec[j] - mean_fvec);
+        mean_fvec.store(mean_ptr);
+        m2_fvec.store(m2_ptr);
+      }
+    }
+    for (; d < size; d++) {
+      float data_val = float(in[d]);
+      float delta = data_val - mean[d];
+      mean[d] += delta * rcount;
+      m2[d] += delta * (data_val - mean[d]);
+    }
+  }
 };
 
 template <typename scalar_t, typename param_t>
@@ -855,7 +915,6 @@ void batch_norm_cpu_collect_stats_channels_last_impl(
     at::Tensor& mean,
     at::Tensor& var_sum,
     const at::Tensor& input) {
-  using accscalar_t = at::acc_type<scalar_t, false>;
   int64_t n_channel = input.size(1);
   int64_t N = input.numel() / n_channel;
 
@@ -863,14 +922,18 @@ void batch_norm_cpu_collect_stats_channels_last_impl(
   param_t* mean_data = mean.data_ptr<param_t>();
   param_t* var_sum_data = var_sum.data_ptr<param_t>();
 
-  // Typical vertical reduce from shape of {NHW, C} to {C}.
+  // Typical vertical reduce from shape of {NHW, C} to {C}, of both of the
+  // mean and the variance in a single read of the input.
   // Apply two path parallel reduction:
-  // First path: allocate an immediate buffer of size {max_threads, C}, parallel
-  // along dim0,
-  //    {NHW, C} => {max_threads, C}
+  // First path: allocate an immediate buffer of size {2, max_threads, C},
+  // parallel along dim0, each thread keeps the Welford mean and sum of the
+  // squared differences of its rows,
+  //    {NHW, C} => {2, max_threads, C}
   //
-  // Second path: parallel along dim1 of the immediate buffer,
-  //    {max_threads, C} => {C}
+  // Second path: parallel along dim1 of the immediate buffer, the partials of
+  // the threads are merged pairwise by a tree, of which the merged counts stay
+  // balanced for the high numbers of threads,
+  //    {2, max_threads, C} => {C}
   //
   // Normal size of C should fit in L1, otherwise consider blocking on C.
   //
@@ -879,39 +942,11 @@ void batch_norm_cpu_collect_stats_channels_last_impl(
   using param2_t = param_acc_t<scalar_t>;
   int num_threads = at::get_num_threads();
   at::Tensor buffer =
-      at::empty({num_threads, n_channel}, param_options(input)).zero_();
-  param2_t* buffer_data = buffer.data_ptr<param2_t>();
-
-  // compute mean per input
-  at::parallel_for(0, N, 1, [&](int64_t begin, int64_t end) {
-    int tid = at::get_thread_num();
-    TORCH_CHECK(
-        tid < num_threads,
-        "expect thread id smaller than ",
-        num_threads,
-        ", got thread id ",
-        tid);
-    param2_t* buffer_ptr = buffer_data + tid * n_channel;
-    for (int64_t i = begin; i < end; i++) {
-      const scalar_t* x_ptr = input_data + i * n_channel;
-      BatchNormCollectStatsImpl<scalar_t, param_t>::kernel2(
-          buffer_ptr, x_ptr, n_channel);
-    }
-  });
-
-  at::parallel_for(0, n_channel, 1, [&](int64_t begin, int64_t end) {
-    for (int64_t c = begin; c < end; c++) {
-      accscalar_t sum = 0;
-      for (int64_t t = 0; t < num_threads; t++) {
-        sum += buffer_data[t * n_channel + c];
-      }
-      accscalar_t mean = sum / N;
-      mean_data[c] = param_t(mean);
-    }
-  });
+      at::empty({2, num_threads, n_channel}, param_options(input)).zero_();
+  param2_t* mean_buffer_data = buffer.data_ptr<param2_t>();
+  param2_t* m2_buffer_data = mean_buffer_data + num_threads * n_channel;
+  std::vector<int64_t> counts(num_threads, 0);
 
-  // compute variance per input, reuse the immediate buffer
-  buffer.zero_();
   at::parallel_for(0, N, 1, [&](int64_t begin, int64_t end) {
     int tid = at::get_thread_num();
     TORCH_CHECK(
@@ -920,21 +955,42 @@ void batch_norm_cpu_collect_stats_channels_last_impl(
         num_threads,
         ", got thread id ",
         tid);
-    param2_t* buffer_ptr = buffer_data + tid * n_channel;
+    param2_t* mean_ptr = mean_buffer_data + tid * n_channel;
+    param2_t* m2_ptr = m2_buffer_data + tid * n_channel;
+    int64_t& count = counts[tid];
     for (int64_t i = begin; i < end; i++) {
       const scalar_t* x_ptr = input_data + i * n_channel;
-      BatchNormCollectStatsImpl<scalar_t, param_t>::kernel3(
-          buffer_ptr, x_ptr, mean_data, n_channel);
+      count++;
+      BatchNormCollectStatsImpl<scalar_t, param_t>::kernel4(
+          mean_ptr, m2_ptr, x_ptr, param2_t(1) / param2_t(count), n_channel);
     }
   });
 
   at::parallel_for(0, n_channel, 1, [&](int64_t begin, int64_t end) {
+    std::vector<int64_t> n(num_threads);
     for (int64_t c = begin; c < end; c++) {
-      accscalar_t _var_sum = 0;
-      for (int64_t t = 0; t < num_threads; t++) {
-        _var_sum += buffer_data[t * n_channel + c];
+      std::copy(counts.begin(), counts.end(), n.begin());
+      for (int64_t stride = 1; stride < num_threads; stride *= 2) {
+        for (int64_t t = 0; t + stride < num_threads; t += 2 * stride) {
+          int64_t u = t + stride;
+          if (n[u] == 0) {
+            continue;
+          }
+          // merge the partial u into the partial t, by Chan et al.
+          param2_t& mean_t = mean_buffer_data[t * n_channel + c];
+          param2_t& m2_t = m2_buffer_data[t * n_channel + c];
+          param2_t mean_u = mean_buffer_data[u * n_channel + c];
+          param2_t m2_u = m2_buffer_data[u * n_channel + c];
+          int64_t total = n[t] + n[u];
+          param2_t delta = mean_u - mean_t;
+          param2_t ratio = param2_t(n[u]) / param2_t(total);
+          mean_t += delta * ratio;
+          m2_t += m2_u + delta * delta * param2_t(n[t]) * ratio;
+          n[t] = total;
+        }
       }
-      var_sum_data[c] = param_t(_var_sum);
+      mean_data[c] = param_t(mean_buffer_data[c]);
+      var_sum_data[c] = param_t(m2_buffer_data[c]);
     }
   });
 }
@@ -1944,10 +2000,8 @@ std::tuple<at::Tensor, at::Tensor> batch_norm_update_stats_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::batch_norm_update_stats_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::batch_norm_update_stats_cpu", std::vector<c10::IValue>({}));
-#endif
   // See [Note: hacky wrapper removal for optional tensor]
   c10::MaybeOwned<at::Tensor> running_mean_maybe_owned =
       at::borrow_from_optional_tensor(running_mean_opt);
@@ -1984,9 +2038,8 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> batch_norm_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::batch_norm_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("torch_ipex::batch_norm_cpu", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::batch_norm_cpu", std::vector<c10::IValue>({}));
   // See [Note: hacky wrapper removal for optional tensor]
   c10::MaybeOwned<at::Tensor> weight_maybe_owned =
       at::borrow_from_optional_tensor(weight_opt);
@@ -2087,10 +2140,8 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> batch_norm_backward_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::batch_norm_backward_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::batch_norm_backward_cpu", std::vector<c10::IValue>({}));
-#endif
   // See [Note: hacky wrapper removal for optional tensor]
   c10::MaybeOwned<at::Tensor> weight_maybe_owned =
       at::borrow_from_optional_tensor(weight_opt);
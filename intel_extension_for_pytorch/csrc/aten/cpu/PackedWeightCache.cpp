@@ -0,0 +1,162 @@
+#include "PackedWeightCache.h"
+
+#include "csrc/utils/memory_stats.h"
+
+#include <functional>
+#include <utility>
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+memory_stats::CacheAccount packed_weights_account(
+    "packed_weights",
+    4,
+    [](int64_t bytes) {
+      return PackedWeightCache::get_instance().evict(bytes);
+    });
+
+} // namespace
+
+size_t PackedWeightCache::KeyHash::operator()(const Key& key) const {
+  size_t hash = std::hash<c10::TensorImpl*>()(key.weight);
+  hash ^= std::hash<uint32_t>()(key.version) + 0x9e3779b9 + (hash << 6) +
+      (hash >> 2);
+  hash ^= std::hash<const void*>()(key.data) + 0x9e3779b9 + (hash << 6) +
+      (hash >> 2);
+  return hash;
+}
+
+PackedWeightCache& PackedWeightCache::get_instance() {
+  static PackedWeightCache packed_weight_cache;
+  return packed_weight_cache;
+}
+
+PackedWeightCache::Key PackedWeightCache::make_key(const at::Tensor& weight) {
+  auto weight_impl = weight.unsafeGetTensorImpl();
+  return Key{
+      weight_impl,
+      weight_impl->version_counter().current_version(),
+      weight_impl->has_storage() ? weight_impl->storage().data() : nullptr};
+}
+
+bool PackedWeightCache::find(
+    const at::Tensor& weight,
+    ideep::tensor& packed_weight) {
+  auto key = make_key(weight);
+  std::unique_lock<std::mutex> lock(this->cache_mutex);
+  auto it = this->entries.find(key);
+  if (it == this->entries.end()) {
+    this->stats.misses++;
+    return false;
+  }
+  if (it->second->weak_weight.expired()) {
+    // The TensorImpl address is reused by a new weight.
+    this->erase(it->second);
+    this->stats.invalidations++;
+    this->stats.misses++;
+    return false;
+  }
+  this->lru_entries.splice(
+      this->lru_entries.begin(), this->lru_entries, it->second);
+  packed_weight = it->second->packed_weight;
+  this->stats.hits++;
+  return true;
+}
+
+void PackedWeightCache::insert(
+    const at::Tensor& weight,
+    const ideep::tensor& packed_weight) {
+  auto key = make_key(weight);
+  std::unique_lock<std::mutex> lock(this->cache_mutex);
+  // Drop the stale entries of the older versions of weight and of the freed
+  // weights. Inserting happens only when a weight is packed, which is much
+  // more expensive than this scan.
+  for (auto it = this->lru_entries.begin(); it != this->lru_entries.end();) {
+    auto next = std::next(it);
+    if (it->key.weight == key.weight || it->weak_weight.expired()) {
+      this->erase(it);
+      this->stats.invalidations++;
+    }
+    it = next;
+  }
+  this->lru_entries.emplace_front(Entry{
+      key,
+      WeakRef(weight.getIntrusivePtr()),
+      packed_weight,
+      static_cast<int64_t>(packed_weight.get_size())});
+  this->entries.emplace(key, this->lru_entries.begin());
+  this->stats.cached_bytes += this->lru_entries.front().nbytes;
+  packed_weights_account.update(this->lru_entries.front().nbytes, 1);
+  this->evict_to_capacity();
+  lock.unlock();
+  memory_stats::enforce_memory_budget();
+}
+
+void PackedWeightCache::invalidate(const at::Tensor& weight) {
+  auto weight_impl = weight.unsafeGetTensorImpl();
+  std::unique_lock<std::mutex> lock(this->cache_mutex);
+  for (auto it = this->lru_entries.begin(); it != this->lru_entries.end();) {
+    auto next = std::next(it);
+    if (it->key.weight == weight_impl) {
+      this->erase(it);
+      this->stats.invalidations++;
+    }
+    it = next;
+  }
+}
+
+void PackedWeightCache::clear() {
+  std::unique_lock<std::mutex> lock(this->cache_mutex);
+  this->stats.invalidations += this->lru_entries.size();
+  packed_weights_account.update(
+      -this->stats.cached_bytes,
+      -static_cast<int64_t>(this->lru_entries.size()));
+  this->entries.clear();
+  this->lru_entries.clear();
+  this->stats.cached_bytes = 0;
+}
+
+void PackedWeightCache::set_capacity_bytes(int64_t capacity_bytes) {
+  std::unique_lock<std::mutex> lock(this->cache_mutex);
+  this->stats.capacity_bytes = capacity_bytes;
+  this->evict_to_capacity();
+}
+
+int64_t PackedWeightCache::evict(int64_t bytes) {
+  std::unique_lock<std::mutex> lock(this->cache_mutex);
+  int64_t evicted = 0;
+  while (evicted < bytes && !this->lru_entries.empty()) {
+    auto it = std::prev(this->lru_entries.end());
+    evicted += it->nbytes;
+    this->erase(it);
+    this->stats.evictions++;
+  }
+  return evicted;
+}
+
+PackedWeightCacheStats PackedWeightCache::get_stats() {
+  std::unique_lock<std::mutex> lock(this->cache_mutex);
+  PackedWeightCacheStats stats = this->stats;
+  stats.entries = this->lru_entries.size();
+  return stats;
+}
+
+void PackedWeightCache::erase(EntryList::iterator it) {
+  this->stats.cached_bytes -= it->nbytes;
+  packed_weights_account.update(-it->nbytes, -1);
+  this->entries.erase(it->key);
+  this->lru_entries.erase(it);
+}
+
+void PackedWeightCache::evict_to_capacity() {
+  while (this->stats.capacity_bytes >= 0 && !this->lru_entries.empty() &&
+         this->stats.cached_bytes > this->stats.capacity_bytes) {
+    this->erase(std::prev(this->lru_entries.end()));
+    this->stats.evictions++;
+  }
+}
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+#include <c10/core/UndefinedTensorImpl.h>
+#include <c10/util/intrusive_ptr.h>
+
+#include "csrc/cpu/ideep/ideep.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+namespace torch_ipex {
+namespace cpu {
+
+struct PackedWeightCacheStats {
+  // number of the cached packed weights
+  int64_t entries{0};
+  // bytes of the cached packed weights
+  int64_t cached_bytes{0};
+  // the memory budget, -1 means unlimited
+  int64_t capacity_bytes{-1};
+  // lookups served from the cache
+  int64_t hits{0};
+  // lookups which have to pack the weight
+  int64_t misses{0};
+  // entries evicted by the memory budget
+  int64_t evictions{0};
+  // entries dropped since their weight is freed, modified or invalidated
+  int64_t invalidations{0};
+};
+
+/*PackedWeightCache keeps the blocked (packed) ideep weights of the original
+ * weight tensors, e.g. of LSTM, shared by all threads. The key is the
+ * TensorImpl, its version counter and its storage pointer, so that an in-place
+ * update or a re-pointed storage of the weight never returns the stale packed
+ * weight, and the entry of a freed weight is never returned even if its
+ * TensorImpl address is reused. The entries are evicted in LRU order once the
+ * cached bytes exceed the memory budget, or by the memory budget of all the
+ * caches of memory_stats, of which the packed weights are the last to evict.*/
+class PackedWeightCache {
+ public:
+  static PackedWeightCache& get_instance();
+
+  // Returns true and sets packed_weight if weight has a valid packed weight.
+  bool find(const at::Tensor& weight, ideep::tensor& packed_weight);
+  void insert(const at::Tensor& weight, const ideep::tensor& packed_weight);
+  // Drop the packed weights of all versions of weight.
+  void invalidate(const at::Tensor& weight);
+  void clear();
+  // Set the memory budget in bytes, -1 means unlimited.
+  void set_capacity_bytes(int64_t capacity_bytes);
+  // Evict the LRU entries of at least bytes for the memory budget of all the
+  // caches, returns the bytes evicted.
+  int64_t evict(int64_t bytes);
+  PackedWeightCacheStats get_stats();
+
+ private:
+  using WeakRef =
+      c10::weak_intrusive_ptr<c10::TensorImpl, c10::UndefinedTensorImpl>;
+
+  struct Key {
+    c10::TensorImpl* weight;
+    uint32_t version;
+    const void* data;
+
+    bool operator==(const Key& other) const {
+      return this->weight == other.weight && this->version == other.version &&
+          this->data == other.data;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const;
+  };
+
+  struct Entry {
+    Key key;
+    WeakRef weak_weight;
+    ideep::tensor packed_weight;
+    int64_t nbytes;
+  };
+
+  using EntryList = std::list<Entry>;
+
+  PackedWeightCache() = default;
+  static Key make_key(const at::Tensor& weight);
+  // The following functions must be called with cache_mutex held.
+  void erase(EntryList::iterator it);
+  void evict_to_capacity();
+
+  // The most recently used entry is at the front.
+  EntryList lru_entries;
+  std::unordered_map<Key, EntryList::iterator, KeyHash> entries;
+  PackedWeightCacheStats stats;
+  std::mutex cache_mutex;
+
+  PackedWeightCache(const PackedWeightCache& packed_weight_cache) = delete;
+  PackedWeightCache& operator=(const PackedWeightCache& packed_weight_cache) =
+      delete;
+};
+
+} // namespace cpu
+} // namespace torch_ipex
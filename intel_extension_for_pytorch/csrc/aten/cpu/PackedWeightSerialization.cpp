@@ -0,0 +1,221 @@
+#include "PackedWeightSerialization.h"
+
+#include <c10/util/Exception.h>
+
+#include <atomic>
+#include <cstring>
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+// Layout of the serialized packed weight:
+// [header (int64_t x kHeaderSize) | dnnl_memory_desc_t | packed bytes |
+//  qparams (float x rows x cols, quantized weight only)]
+// The descriptor, the packed bytes and the qparams start at a multiple of
+// kAlignment. Format version 1 has no qparams and its header ends at
+// kQParamsOffsetField.
+constexpr int64_t kMagic = 0x5045574b43415049; // "IPACKWEP"
+constexpr int64_t kFormatVersion = 2;
+constexpr int64_t kMinFormatVersion = 1;
+constexpr int64_t kAlignment = 64;
+constexpr int64_t kDescSize = sizeof(dnnl_memory_desc_t);
+
+enum HeaderField : int64_t {
+  kMagicField = 0,
+  kFormatVersionField,
+  kDnnlVersionField,
+  kDescSizeField,
+  kDescOffsetField,
+  kDataOffsetField,
+  kDataSizeField,
+  kQParamsOffsetField,
+  kQParamsRowsField,
+  kQParamsColsField,
+  kHeaderSize,
+};
+
+std::atomic<bool> packed_weight_serialization_enabled{false};
+
+int64_t align(int64_t nbytes) {
+  return (nbytes + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+int64_t get_dnnl_version() {
+  auto version = dnnl_version();
+  return version->major * 10000 + version->minor * 100 + version->patch;
+}
+
+const int64_t* get_header(const at::Tensor& weight) {
+  return reinterpret_cast<const int64_t*>(weight.data_ptr<uint8_t>());
+}
+
+// The offset of the qparams, 0 if the packed weight has none.
+int64_t get_qparams_offset(const int64_t* header) {
+  return header[kFormatVersionField] >= 2 ? header[kQParamsOffsetField] : 0;
+}
+
+int64_t get_qparams_size(const int64_t* header) {
+  return get_qparams_offset(header) > 0
+      ? header[kQParamsRowsField] * header[kQParamsColsField] *
+          static_cast<int64_t>(sizeof(float))
+      : 0;
+}
+
+} // namespace
+
+void set_packed_weight_serialization_enabled(bool enabled) {
+  packed_weight_serialization_enabled.store(enabled);
+}
+
+bool is_packed_weight_serialization_enabled() {
+  return packed_weight_serialization_enabled.load();
+}
+
+at::Tensor serialize_packed_weight(
+    const ideep::tensor& packed_weight,
+    const at::Tensor& qparams) {
+  TORCH_CHECK(
+      !qparams.defined() ||
+          (qparams.scalar_type() == at::kFloat && qparams.dim() == 2),
+      "The qparams of the packed weight must be a 2-D float tensor");
+  auto desc = packed_weight.get_desc();
+  int64_t desc_offset = align(kHeaderSize * sizeof(int64_t));
+  int64_t data_offset = desc_offset + align(kDescSize);
+  int64_t data_size = desc.get_size();
+  int64_t qparams_offset =
+      qparams.defined() ? align(data_offset + data_size) : 0;
+  int64_t total_size = qparams.defined()
+      ? qparams_offset + qparams.numel() * static_cast<int64_t>(sizeof(float))
+      : data_offset + data_size;
+  auto serialized = at::zeros({total_size}, at::TensorOptions(at::kByte));
+  auto buffer = serialized.data_ptr<uint8_t>();
+  auto header = reinterpret_cast<int64_t*>(buffer);
+  header[kMagicField] = kMagic;
+  header[kFormatVersionField] = kFormatVersion;
+  header[kDnnlVersionField] = get_dnnl_version();
+  header[kDescSizeField] = kDescSize;
+  header[kDescOffsetField] = desc_offset;
+  header[kDataOffsetField] = data_offset;
+  header[kDataSizeField] = data_size;
+  header[kQParamsOffsetField] = qparams_offset;
+  std::memcpy(buffer + desc_offset, &desc.data, kDescSize);
+  std::memcpy(
+      buffer + data_offset, packed_weight.get_data_handle(), data_size);
+  if (qparams.defined()) {
+    header[kQParamsRowsField] = qparams.size(0);
+    header[kQParamsColsField] = qparams.size(1);
+    auto qparams_ = qparams.contiguous();
+    std::memcpy(
+        buffer + qparams_offset,
+        qparams_.data_ptr<float>(),
+        qparams_.numel() * sizeof(float));
+  }
+  return serialized;
+}
+
+at::Tensor serialize_weight(
+    const at::Tensor& weight,
+    const ideep::tensor& packed_weight,
+    const at::Tensor& qparams) {
+  // The op context may keep no packed weight, e.g. the weight-only quantized
+  // linear, which saves its quantized weight as is.
+  if (!is_packed_weight_serialization_enabled() || packed_weight.is_empty() ||
+      (weight.is_quantized() && !qparams.defined()) ||
+      is_serialized_packed_weight(weight)) {
+    return weight;
+  }
+  return serialize_packed_weight(packed_weight, qparams);
+}
+
+bool is_serialized_packed_weight(const at::Tensor& weight) {
+  if (!weight.defined() || weight.scalar_type() != at::kByte ||
+      weight.dim() != 1 || !weight.is_contiguous() ||
+      weight.numel() < kHeaderSize * static_cast<int64_t>(sizeof(int64_t))) {
+    return false;
+  }
+  auto header = get_header(weight);
+  if (header[kMagicField] != kMagic || header[kDataOffsetField] <= 0 ||
+      header[kDataSizeField] < 0) {
+    return false;
+  }
+  auto qparams_offset = get_qparams_offset(header);
+  if (qparams_offset > 0) {
+    return qparams_offset >=
+        header[kDataOffsetField] + header[kDataSizeField] &&
+        header[kQParamsRowsField] >= 0 && header[kQParamsColsField] >= 0 &&
+        qparams_offset + get_qparams_size(header) == weight.numel();
+  }
+  return header[kDataOffsetField] + header[kDataSizeField] == weight.numel();
+}
+
+ideep::tensor::desc get_serialized_packed_weight_desc(
+    const at::Tensor& weight) {
+  TORCH_CHECK(
+      is_serialized_packed_weight(weight),
+      "The weight is not a serialized packed weight");
+  auto header = get_header(weight);
+  TORCH_CHECK(
+      header[kFormatVersionField] >= kMinFormatVersion &&
+          header[kFormatVersionField] <= kFormatVersion &&
+          header[kDnnlVersionField] == get_dnnl_version() &&
+          header[kDescSizeField] == kDescSize,
+      "The packed weight is serialized by an incompatible version of "
+      "Intel Extension for PyTorch (oneDNN ",
+      header[kDnnlVersionField],
+      ", running oneDNN ",
+      get_dnnl_version(),
+      "). Please save the model again with the packed weight serialization "
+      "disabled.");
+  dnnl_memory_desc_t data;
+  std::memcpy(
+      &data,
+      weight.data_ptr<uint8_t>() + header[kDescOffsetField],
+      kDescSize);
+  return ideep::tensor::desc(data);
+}
+
+at::Tensor get_serialized_packed_weight_qparams(const at::Tensor& weight) {
+  TORCH_CHECK(
+      is_serialized_packed_weight(weight),
+      "The weight is not a serialized packed weight");
+  auto header = get_header(weight);
+  auto qparams_offset = get_qparams_offset(header);
+  if (qparams_offset == 0) {
+    return at::Tensor();
+  }
+  // the view keeps the bytes of weight alive
+  return at::from_blob(
+      weight.data_ptr<uint8_t>() + qparams_offset,
+      {header[kQParamsRowsField], header[kQParamsColsField]},
+      [weight](void*) {},
+      at::TensorOptions(at::kFloat));
+}
+
+ideep::tensor load_serialized_packed_weight(
+    const at::Tensor& weight,
+    const ideep::tensor::desc& expected_desc) {
+  auto desc = get_serialized_packed_weight_desc(weight);
+  auto header = get_header(weight);
+  TORCH_CHECK(
+      static_cast<int64_t>(desc.get_size()) == header[kDataSizeField],
+      "The serialized packed weight is corrupted");
+  ideep::tensor packed_weight;
+  packed_weight.init(
+      desc, weight.data_ptr<uint8_t>() + header[kDataOffsetField]);
+  if (desc == expected_desc) {
+    return packed_weight;
+  }
+  // Repack, e.g. oneDNN prefers another blocked format on this CPU.
+  TORCH_CHECK(
+      desc.get_dims() == expected_desc.get_dims() &&
+          desc.get_data_type() == expected_desc.get_data_type(),
+      "The serialized packed weight doesn't match the op");
+  ideep::tensor expected_packed_weight{expected_desc};
+  expected_packed_weight.feed_from(packed_weight);
+  return expected_packed_weight;
+}
+
+} // namespace cpu
+} // namespace torch_ipex
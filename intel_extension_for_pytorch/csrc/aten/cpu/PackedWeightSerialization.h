@@ -0,0 +1,54 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+#include "csrc/cpu/ideep/ideep.hpp"
+
+namespace torch_ipex {
+namespace cpu {
+
+// When enabled, the ConvolutionOpContext, LinearOpContext,
+// ConvTransposeOpContext and LstmOpContext save their packed weights instead of
+// the plain weights, so that loading the model doesn't reorder the weights
+// again. Disabled by default.
+void set_packed_weight_serialization_enabled(bool enabled);
+bool is_packed_weight_serialization_enabled();
+
+// Serialize the packed weight into a uint8 tensor, which holds a header, the
+// oneDNN memory descriptor and the packed bytes of the weight, followed by the
+// float qparams of a quantized packed weight if they are defined.
+at::Tensor serialize_packed_weight(
+    const ideep::tensor& packed_weight,
+    const at::Tensor& qparams = at::Tensor());
+
+// Returns the weight saved by the op context: weight itself if the packed
+// weight serialization is disabled or weight is serialized already, otherwise
+// the serialized packed_weight. A quantized weight is only serialized with its
+// qparams, e.g. the scales of the packed s8 weight of the dynamic quantized
+// linear, so that loading it needs no quantization.
+at::Tensor serialize_weight(
+    const at::Tensor& weight,
+    const ideep::tensor& packed_weight,
+    const at::Tensor& qparams = at::Tensor());
+
+// Returns true if weight is created by serialize_packed_weight.
+bool is_serialized_packed_weight(const at::Tensor& weight);
+
+// Returns the oneDNN memory descriptor of the serialized packed weight. It
+// throws if the weight is serialized by an incompatible oneDNN version.
+ideep::tensor::desc get_serialized_packed_weight_desc(const at::Tensor& weight);
+
+// Returns the qparams saved with the serialized packed weight, undefined if it
+// is not quantized. The returned float tensor views the bytes of weight.
+at::Tensor get_serialized_packed_weight_qparams(const at::Tensor& weight);
+
+// Restore the serialized packed weight in expected_desc. The bytes of weight
+// are used in place (no memory copy) if they are already in expected_desc,
+// otherwise, e.g. the weight is saved on a CPU with another ISA, they are
+// reordered into a new buffer.
+ideep::tensor load_serialized_packed_weight(
+    const at::Tensor& weight,
+    const ideep::tensor::desc& expected_desc);
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -42,7 +42,8 @@ at::Tensor pooling_impl(
     at::IntArrayRef padding,
     at::IntArrayRef dilation,
     bool ceil_mode,
-    ideep::algorithm algo) {
+    ideep::algorithm algo,
+    bool is_inference) {
   const int64_t dims = input.dim() - 2;
   auto kernel_size_vec =
       expand_param_if_needed(kernel_size, "kernel_size", dims);
@@ -55,12 +56,15 @@ at::Tensor pooling_impl(
   auto padding_vec_r = padding_vec;
   auto dilation_vec = expand_param_if_needed(dilation, "dilation", dims);
 
+  // A blocked (e.g. nChw16c) mkldnn tensor is pooled in its own layout and
+  // gives a mkldnn tensor back, so that it is never reordered to plain.
+  bool is_mkldnn = input.is_mkldnn();
   // TODO: the input will be actively converted to channels last format
   // after the 5-D tensor supports channels last format.
-  auto input_ = IS_CONTIGUOUS_ANY(input)
+  auto input_ = is_mkldnn || IS_CONTIGUOUS_ANY(input)
       ? input
       : input.contiguous(input.suggest_memory_format());
-  const ideep::tensor mkldnn_input = itensor_view_from_dense(input_);
+  const ideep::tensor mkldnn_input = itensor_from_tensor(input_);
   std::vector<int64_t> output_sizes;
 
   if (ceil_mode) {
@@ -107,13 +111,14 @@ at::Tensor pooling_impl(
         false /*ceil_mode */);
   }
 
-  bool is_channels_last =
+  bool is_channels_last = !is_mkldnn &&
       input_.suggest_memory_format() == at::MemoryFormat::ChannelsLast;
-  auto output = at::empty(
-      output_sizes,
-      input_.options().memory_format(input_.suggest_memory_format()));
+  at::Tensor output;
   ideep::tensor mkldnn_output;
   if (is_channels_last) {
+    output = at::empty(
+        output_sizes,
+        input_.options().memory_format(at::MemoryFormat::ChannelsLast));
     mkldnn_output = itensor_view_from_dense(output);
   }
 
@@ -121,8 +126,10 @@ at::Tensor pooling_impl(
   // for max_pool, prop_kind::forward will save indices as workspace for
   // backward use, for inference, don't need the indices, set aprop_kind to
   // prop_kind::forward_inference can reduce the memory use.
+  // The JIT ops have no backward, so is_inference always skips the indices.
   if (ideep::algorithm::pooling_max == algo &&
-      !(input.requires_grad() && at::GradMode::is_enabled())) {
+      (is_inference ||
+       !(input.requires_grad() && at::GradMode::is_enabled()))) {
     aprop_kind = ideep::prop_kind::forward_inference;
   }
 
@@ -140,6 +147,11 @@ at::Tensor pooling_impl(
 
   if (is_channels_last) {
     return output;
+  } else if (is_mkldnn) {
+    return new_with_itensor_mkldnn(
+        std::move(mkldnn_output),
+        optTypeMetaToScalarType(input.options().dtype_opt()),
+        input.options().device_opt());
   } else {
     return mkldnn_to_dense(new_with_itensor_mkldnn(
         std::move(mkldnn_output),
@@ -14,7 +14,8 @@ at::Tensor pooling_impl(
     at::IntArrayRef padding,
     at::IntArrayRef dilation,
     bool ceil_mode,
-    ideep::algorithm algo);
+    ideep::algorithm algo,
+    bool is_inference = false);
 
 } // namespace cpu
 } // namespace torch_ipex
@@ -0,0 +1,332 @@
+#include "RMSNorm.h"
+#include <ATen/Parallel.h>
+#include <torch/extension.h>
+#include "utils/float_vec.h"
+
+#if defined(CPU_AVX512)
+#include "csrc/cpu/vec512/add_layernorm.h"
+#include "csrc/utils/op_trace.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+// the number of rows and the row size
+std::pair<int64_t, int64_t> check_rms_norm_inputs(
+    const at::Tensor& input,
+    const at::Tensor& residual,
+    const at::Tensor& weight) {
+  TORCH_CHECK(input.dim() >= 1, "rms_norm: expected input of 1 dim at least");
+  const int64_t N = input.size(-1);
+  TORCH_CHECK(
+      !weight.defined() || weight.numel() == N,
+      "rms_norm: expected weight of ",
+      N,
+      " elements, but got ",
+      weight.sizes());
+  TORCH_CHECK(
+      !residual.defined() ||
+          (residual.sizes() == input.sizes() &&
+           residual.scalar_type() == input.scalar_type()),
+      "rms_norm: expected residual of the shape and the dtype of input");
+  return std::make_pair(N == 0 ? 0 : input.numel() / N, N);
+}
+
+// The output, the sum of input and residual, undefined without residual, and
+// the float rstd of the rows.
+std::tuple<at::Tensor, at::Tensor, at::Tensor> rms_norm_impl(
+    const at::Tensor& input,
+    const at::Tensor& residual,
+    const at::Tensor& weight,
+    double eps) {
+  int64_t M, N;
+  std::tie(M, N) = check_rms_norm_inputs(input, residual, weight);
+#if defined(CPU_AVX512)
+  if (input.scalar_type() == at::kFloat ||
+      input.scalar_type() == at::kBFloat16) {
+    using namespace torch_ipex::cpu::kernel::vec::vec512;
+    auto X = input.contiguous();
+    auto R = residual.defined() ? residual.contiguous() : at::Tensor();
+    auto Y = at::empty_like(X, at::MemoryFormat::Contiguous);
+    auto S = residual.defined()
+        ? at::empty_like(X, at::MemoryFormat::Contiguous)
+        : at::Tensor();
+    auto rstd = at::empty({M}, X.options().dtype(at::kFloat));
+    float* rstd_data = rstd.data_ptr<float>();
+    if (input.scalar_type() == at::kFloat) {
+      auto gamma =
+          weight.defined() ? weight.to(at::kFloat).contiguous() : at::Tensor();
+      RMSNormKernelImpl<float, float>(
+          X, R, gamma, M, N, eps, Y, S, rstd_data);
+    } else if (weight.defined() && weight.scalar_type() == at::kBFloat16) {
+      RMSNormKernelImpl<at::BFloat16, at::BFloat16>(
+          X, R, weight.contiguous(), M, N, eps, Y, S, rstd_data);
+    } else {
+      auto gamma =
+          weight.defined() ? weight.to(at::kFloat).contiguous() : at::Tensor();
+      RMSNormKernelImpl<at::BFloat16, float>(
+          X, R, gamma, M, N, eps, Y, S, rstd_data);
+    }
+    return std::make_tuple(Y, S, rstd);
+  }
+#endif
+  auto x = residual.defined() ? input + residual : input;
+  auto x_float = x.to(at::kFloat);
+  auto rstd = x_float.pow(2).mean(-1, true).add(eps).rsqrt();
+  auto y = x_float * rstd;
+  if (weight.defined()) {
+    y = y * weight.to(at::kFloat).reshape({N});
+  }
+  return std::make_tuple(
+      y.to(x.scalar_type()),
+      residual.defined() ? x : at::Tensor(),
+      rstd.reshape({M}));
+}
+
+// dx = rstd * dy * w - x * rstd^3 * mean(dy * w * x), plus the grad of the
+// sum if any, and the float grad of w, of which the rows are reduced by the
+// {max_threads, N} buffer.
+template <typename scalar_t>
+void rms_norm_backward_kernel(
+    const at::Tensor& grad_output,
+    const at::Tensor& grad_sum,
+    const at::Tensor& x,
+    const at::Tensor& gamma,
+    const at::Tensor& rstd,
+    at::Tensor& grad_input,
+    at::Tensor& grad_gamma,
+    int64_t M,
+    int64_t N) {
+  const scalar_t* dy_data = grad_output.data_ptr<scalar_t>();
+  const scalar_t* ds_data =
+      grad_sum.defined() ? grad_sum.data_ptr<scalar_t>() : nullptr;
+  const scalar_t* x_data = x.data_ptr<scalar_t>();
+  const float* gamma_data = gamma.data_ptr<float>();
+  const float* rstd_data = rstd.data_ptr<float>();
+  scalar_t* dx_data = grad_input.data_ptr<scalar_t>();
+  const int64_t vec_end = N - (N % kFloatVecPairSize);
+  int num_threads = at::get_num_threads();
+  std::vector<float> buffer(num_threads * N, 0.f);
+  int64_t grain_size =
+      std::max<int64_t>(1, at::internal::GRAIN_SIZE / std::max<int64_t>(N, 1));
+  at::parallel_for(0, M, grain_size, [&](int64_t begin, int64_t end) {
+    int tid = at::get_thread_num();
+    TORCH_CHECK(
+        tid < num_threads,
+        "expect thread id smaller than ",
+        num_threads,
+        ", got thread id ",
+        tid);
+    float* dgamma = buffer.data() + tid * N;
+    for (int64_t i = begin; i < end; i++) {
+      const scalar_t* dy = dy_data + i * N;
+      const scalar_t* ds = ds_data ? ds_data + i * N : nullptr;
+      const scalar_t* xr = x_data + i * N;
+      scalar_t* dx = dx_data + i * N;
+      float rstd_val = rstd_data[i];
+      fVec rstd_vec = fVec(rstd_val);
+
+      // sum(dy * w * x), and dw += dy * x * rstd
+      fVec dot_vec = fVec(0.f);
+      float dot_val = 0.f;
+      int64_t d = 0;
+      for (; d < vec_end; d += kFloatVecPairSize) {
+        fVec dy_a, dy_b, x_a, x_b, w_a, w_b, acc_a, acc_b;
+        load_fvec(dy + d, dy_a, dy_b);
+        load_fvec(xr + d, x_a, x_b);
+        load_fvec(gamma_data + d, w_a, w_b);
+        dot_vec = dot_vec + dy_a * w_a * x_a + dy_b * w_b * x_b;
+        load_fvec(dgamma + d, acc_a, acc_b);
+        store_fvec(
+            dgamma + d,
+            acc_a + dy_a * x_a * rstd_vec,
+            acc_b + dy_b * x_b * rstd_vec);
+      }
+      for (; d < N; d++) {
+        float dy_val = float(dy[d]);
+        float x_val = float(xr[d]);
+        dot_val += dy_val * gamma_data[d] * x_val;
+        dgamma[d] += dy_val * x_val * rstd_val;
+      }
+      float coef = (dot_val + sum_fvec(dot_vec)) * rstd_val * rstd_val *
+          rstd_val / static_cast<float>(N);
+
+      fVec coef_vec = fVec(coef);
+      for (d = 0; d < vec_end; d += kFloatVecPairSize) {
+        fVec dy_a, dy_b, x_a, x_b, w_a, w_b;
+        load_fvec(dy + d, dy_a, dy_b);
+        load_fvec(xr + d, x_a, x_b);
+        load_fvec(gamma_data + d, w_a, w_b);
+        fVec dx_a = rstd_vec * dy_a * w_a - x_a * coef_vec;
+        fVec dx_b = rstd_vec * dy_b * w_b - x_b * coef_vec;
+        if (ds) {
+          fVec ds_a, ds_b;
+          load_fvec(ds + d, ds_a, ds_b);
+          dx_a = dx_a + ds_a;
+          dx_b = dx_b + ds_b;
+        }
+        store_fvec(dx + d, dx_a, dx_b);
+      }
+      for (; d < N; d++) {
+        float dx_val =
+            rstd_val * float(dy[d]) * gamma_data[d] - float(xr[d]) * coef;
+        dx[d] = scalar_t(ds ? dx_val + float(ds[d]) : dx_val);
+      }
+    }
+  });
+
+  float* grad_gamma_data = grad_gamma.data_ptr<float>();
+  at::parallel_for(0, N, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t d = begin; d < end; d++) {
+      float acc = 0.f;
+      for (int tid = 0; tid < num_threads; tid++) {
+        acc += buffer[tid * N + d];
+      }
+      grad_gamma_data[d] = acc;
+    }
+  });
+}
+
+} // namespace
+
+torch::autograd::variable_list IPEXRMSNormOp::forward(
+    torch::autograd::AutogradContext* ctx,
+    const at::Tensor& input,
+    const at::Tensor& residual,
+    const c10::optional<at::Tensor>& weight_opt,
+    double eps) {
+  IPEX_RECORD_FUNCTION("IPEXRMSNormOp::forward", std::vector<c10::IValue>({}));
+  auto weight = weight_opt.has_value() ? weight_opt.value() : at::Tensor();
+  at::Tensor output, sum, rstd;
+  std::tie(output, sum, rstd) = rms_norm_impl(input, residual, weight, eps);
+  bool has_residual = residual.defined();
+  ctx->saved_data["has_residual"] = has_residual;
+  ctx->saved_data["has_weight"] = weight.defined();
+  ctx->saved_data["weight_dtype"] =
+      weight.defined() ? weight.scalar_type() : at::kFloat;
+  if (weight.defined()) {
+    ctx->saved_data["weight_shape"] = weight.sizes();
+  }
+  // the normalized output is not saved, only the input of the norm and rstd
+  ctx->save_for_backward({has_residual ? sum : input, weight, rstd});
+  if (has_residual) {
+    return {output, sum};
+  }
+  return {output};
+}
+
+torch::autograd::variable_list IPEXRMSNormOp::backward(
+    torch::autograd::AutogradContext* ctx,
+    torch::autograd::variable_list grad_outputs) {
+  IPEX_RECORD_FUNCTION("IPEXRMSNormOp::backward", std::vector<c10::IValue>({}));
+  auto saved = ctx->get_saved_variables();
+  auto x = saved[0].contiguous();
+  auto weight = saved[1];
+  auto rstd = saved[2];
+  int64_t N = x.size(-1);
+  int64_t M = rstd.numel();
+  auto gamma = weight.defined()
+      ? weight.to(at::kFloat).contiguous().view({N})
+      : at::ones({N}, x.options().dtype(at::kFloat));
+  auto grad_output = grad_outputs[0].defined()
+      ? grad_outputs[0].to(x.scalar_type()).contiguous()
+      : at::zeros_like(x);
+  at::Tensor grad_sum;
+  if (grad_outputs.size() > 1 && grad_outputs[1].defined()) {
+    grad_sum = grad_outputs[1].to(x.scalar_type()).contiguous();
+  }
+
+  at::Tensor grad_input, grad_gamma;
+  if (x.scalar_type() == at::kFloat || x.scalar_type() == at::kBFloat16) {
+    grad_input = at::empty_like(x);
+    grad_gamma = at::empty({N}, gamma.options());
+    if (x.scalar_type() == at::kBFloat16) {
+      rms_norm_backward_kernel<at::BFloat16>(
+          grad_output, grad_sum, x, gamma, rstd, grad_input, grad_gamma, M, N);
+    } else {
+      rms_norm_backward_kernel<float>(
+          grad_output, grad_sum, x, gamma, rstd, grad_input, grad_gamma, M, N);
+    }
+  } else {
+    // the reference of the other dtypes
+    auto r = rstd.view({M, 1}).to(x.scalar_type());
+    auto x_ = x.reshape({M, N});
+    auto gdy = grad_output.reshape({M, N}) * gamma.to(x.scalar_type());
+    grad_input = (r * gdy - x_ * r.pow(3) * (gdy * x_).mean(-1, true))
+                     .view(x.sizes());
+    if (grad_sum.defined()) {
+      grad_input = grad_input + grad_sum;
+    }
+    grad_gamma = (grad_output.reshape({M, N}) * x_ * r).sum(0).to(at::kFloat);
+  }
+
+  at::Tensor grad_weight;
+  if (ctx->saved_data["has_weight"].toBool()) {
+    grad_weight =
+        grad_gamma.to(ctx->saved_data["weight_dtype"].toScalarType())
+            .view(ctx->saved_data["weight_shape"].toIntVector());
+  }
+  // the grads of input and residual are the ones of their sum
+  return {
+      grad_input,
+      ctx->saved_data["has_residual"].toBool() ? grad_input : at::Tensor(),
+      grad_weight,
+      at::Tensor()};
+}
+
+at::Tensor rms_norm(
+    const at::Tensor& input,
+    const c10::optional<at::Tensor>& weight_opt,
+    double eps) {
+  IPEX_RECORD_FUNCTION("torch_ipex::rms_norm", std::vector<c10::IValue>({}));
+  if (at::GradMode::is_enabled()) {
+    return IPEXRMSNormOp::apply(input, at::Tensor(), weight_opt, eps)[0];
+  }
+  auto weight = weight_opt.has_value() ? weight_opt.value() : at::Tensor();
+  return std::get<0>(rms_norm_impl(input, at::Tensor(), weight, eps));
+}
+
+std::tuple<at::Tensor, at::Tensor> add_rms_norm(
+    const at::Tensor& input,
+    const at::Tensor& residual,
+    const c10::optional<at::Tensor>& weight_opt,
+    double eps) {
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::add_rms_norm", std::vector<c10::IValue>({}));
+  // the broadcast or type promoted residual add of the JIT graphs
+  if (residual.sizes() != input.sizes() ||
+      residual.scalar_type() != input.scalar_type()) {
+    auto sum = input + residual;
+    return std::make_tuple(rms_norm(sum, weight_opt, eps), sum);
+  }
+  if (at::GradMode::is_enabled()) {
+    auto outputs = IPEXRMSNormOp::apply(input, residual, weight_opt, eps);
+    return std::make_tuple(outputs[0], outputs[1]);
+  }
+  auto weight = weight_opt.has_value() ? weight_opt.value() : at::Tensor();
+  auto outputs = rms_norm_impl(input, residual, weight, eps);
+  return std::make_tuple(std::get<0>(outputs), std::get<1>(outputs));
+}
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "rms_norm(Tensor input, Tensor? weight, float eps) -> Tensor",
+      torch_ipex::cpu::rms_norm);
+  m.def(
+      "add_rms_norm(Tensor input, Tensor residual, Tensor? weight, float eps) "
+      "-> (Tensor, Tensor)",
+      torch_ipex::cpu::add_rms_norm);
+}
+
+} // namespace
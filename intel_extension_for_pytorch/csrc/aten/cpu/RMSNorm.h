@@ -0,0 +1,41 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+#include <torch/csrc/autograd/custom_function.h>
+
+namespace torch_ipex {
+namespace cpu {
+
+// input * rsqrt(mean(input^2, -1) + eps) * weight, the RMSNorm of the last dim
+// of e.g. LLaMA and T5, in a single read of the input with the float
+// accumulation of its bfloat16 rows.
+at::Tensor rms_norm(
+    const at::Tensor& input,
+    const c10::optional<at::Tensor>& weight_opt,
+    double eps);
+
+// (rms_norm(input + residual), input + residual) of the pre-norm transformer
+// blocks, of which the sum is the residual of the next block.
+std::tuple<at::Tensor, at::Tensor> add_rms_norm(
+    const at::Tensor& input,
+    const at::Tensor& residual,
+    const c10::optional<at::Tensor>& weight_opt,
+    double eps);
+
+class IPEXRMSNormOp : public torch::autograd::Function<IPEXRMSNormOp> {
+ public:
+  // returns {output} without residual, or {output, input + residual}
+  static torch::autograd::variable_list forward(
+      torch::autograd::AutogradContext* ctx,
+      const at::Tensor& input,
+      const at::Tensor& residual,
+      const c10::optional<at::Tensor>& weight_opt,
+      double eps);
+
+  static torch::autograd::variable_list backward(
+      torch::autograd::AutogradContext* ctx,
+      torch::autograd::variable_list grad_outputs);
+};
+
+} // namespace cpu
+} // namespace torch_ipex
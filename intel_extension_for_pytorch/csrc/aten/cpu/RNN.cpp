@@ -5,14 +5,20 @@
 #include <ATen/MatrixRef.h>
 #include <ATen/NativeFunctions.h>
 #include <ATen/TensorUtils.h>
+#include <ATen/native/quantized/cpu/quant_utils.h>
 #include <c10/util/Exception.h>
 #include <torch/extension.h>
 #include "WeightPack.h"
 #include "csrc/autocast/autocast_mode.h"
 #include "csrc/autocast/autocast_verbose.h"
 #include "csrc/cpu/ideep/IDeepConversions.h"
+#include "csrc/utils/memory_stats.h"
+#include "csrc/utils/op_trace.h"
 #include "csrc/utils/utils.h"
 
+#include <map>
+#include <mutex>
+
 namespace torch_ipex {
 namespace cpu {
 
@@ -192,6 +198,102 @@ std::tuple<at::Tensor, at::Tensor> pack_hidden<
   return std::make_tuple(hx, cx);
 }
 
+// The workspaces of the RNN training, which are released by the backward,
+// are kept for the next iterations instead of allocating and faulting in the
+// large buffers again. A cached buffer is reused by a workspace of at least
+// half its size, e.g. of a shorter sequence. The cached buffers are the first
+// to free by the memory budget, since they are only a cache of the allocator.
+int64_t evict_lstm_workspaces(int64_t bytes);
+
+memory_stats::CacheAccount lstm_workspaces_account(
+    "lstm_workspaces",
+    0,
+    evict_lstm_workspaces);
+
+class LstmWorkspacePool {
+ public:
+  static LstmWorkspacePool& get() {
+    // never destroyed, the workspaces may be released at exit
+    static auto pool = new LstmWorkspacePool();
+    return *pool;
+  }
+
+  at::Tensor allocate(size_t size, const at::TensorOptions& options) {
+    void* data = nullptr;
+    size_t capacity = size;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto it = buffers_.lower_bound(size);
+      if (it != buffers_.end() && it->first <= 2 * size) {
+        capacity = it->first;
+        data = it->second;
+        cached_bytes_ -= capacity;
+        buffers_.erase(it);
+        lstm_workspaces_account.update(-static_cast<int64_t>(capacity), -1);
+      }
+    }
+    if (data == nullptr) {
+      data = c10::alloc_cpu(capacity);
+    }
+    return at::from_blob(
+        data,
+        {static_cast<int64_t>(size)},
+        [capacity](void* ptr) { get().release(ptr, capacity); },
+        options.dtype(at::kByte));
+  }
+
+  // frees the cached buffers of at least bytes, returns the bytes freed
+  int64_t evict(int64_t bytes) {
+    std::vector<void*> evicted;
+    int64_t evicted_bytes = 0;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      // the largest first
+      while (evicted_bytes < bytes && !buffers_.empty()) {
+        auto it = std::prev(buffers_.end());
+        evicted_bytes += it->first;
+        evicted.push_back(it->second);
+        cached_bytes_ -= it->first;
+        lstm_workspaces_account.update(-static_cast<int64_t>(it->first), -1);
+        buffers_.erase(it);
+      }
+    }
+    for (auto data : evicted) {
+      c10::free_cpu(data);
+    }
+    return evicted_bytes;
+  }
+
+ private:
+  static constexpr size_t kMaxCachedBytes = size_t(1) << 30;
+
+  void release(void* data, size_t capacity) {
+    bool cached = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (cached_bytes_ + capacity <= kMaxCachedBytes) {
+        cached_bytes_ += capacity;
+        buffers_.emplace(capacity, data);
+        lstm_workspaces_account.update(static_cast<int64_t>(capacity), 1);
+        cached = true;
+      }
+    }
+    if (cached) {
+      memory_stats::enforce_memory_budget();
+    } else {
+      c10::free_cpu(data);
+    }
+  }
+
+  std::multimap<size_t, void*> buffers_;
+  size_t cached_bytes_ = 0;
+  std::mutex mutex_;
+};
+
+int64_t evict_lstm_workspaces(int64_t bytes) {
+  return LstmWorkspacePool::get().evict(bytes);
+}
+
 } // anonymous namespace
 
 std::vector<at::Tensor> lstm_kernel(
@@ -270,8 +372,8 @@ std::vector<at::Tensor> lstm_kernel(
     at::Tensor workspace = at::Tensor();
     auto pd = ideep::lstm_forward_training::prepare(
         x, hx, cx, w1_, w2_, b, y, hy, cy, reverse);
-    workspace = torch_ipex::cpu::empty_aten_tensor_from_desc(
-        pd.workspace_desc(), input.options().dtype(at::kByte));
+    workspace = LstmWorkspacePool::get().allocate(
+        pd.workspace_desc().get_size(), input.options());
     ideep::tensor mkldnn_workspace;
     mkldnn_workspace.init(
         pd.workspace_desc(), workspace.template data_ptr<uint8_t>());
@@ -293,6 +395,274 @@ std::vector<at::Tensor> lstm_kernel(
   return result;
 }
 
+// The GRU (linear-before-reset) and vanilla RNN counterpart of lstm_kernel.
+// There is no cell state, the returned cy is an empty tensor so that the
+// outputs are laid out as those of lstm_kernel.
+std::vector<at::Tensor> rnn_kernel(
+    const at::Tensor& input,
+    const at::Tensor& w0,
+    const at::Tensor& w1,
+    const at::Tensor& w2,
+    const at::Tensor& w3,
+    const at::Tensor& hx_,
+    bool reverse,
+    at::IntArrayRef batch_sizes,
+    int64_t mode,
+    int64_t hidden_size,
+    int64_t num_layers,
+    bool has_biases,
+    bool bidirectional,
+    bool batch_first,
+    bool train) {
+  RNNParams rnn(
+      input,
+      batch_sizes,
+      mode,
+      hidden_size,
+      num_layers,
+      bidirectional,
+      batch_first,
+      train);
+  auto output_size = _output_size</*is_single_direction*/ true>(rnn);
+  auto output = at::empty(output_size, input.options());
+  auto hy_ = at::empty(hx_.sizes(), hx_.options());
+
+  auto bias = has_biases
+      ? _shuffle_bias(w2, w3, rnn.mode)
+      : at::zeros({rnn.num_bias_gates * rnn.hidden_size}, w0.options());
+
+  // per layer input size
+  int64_t input_size = input.size(2);
+  auto x = torch_ipex::cpu::itensor_view_from_dense(
+      input,
+      rnn.src_layer_desc(input_size, get_mkldnn_dtype(input.scalar_type())));
+  auto hx = torch_ipex::cpu::itensor_view_from_dense(
+      hx_, rnn.src_iter_desc(get_mkldnn_dtype(hx_.scalar_type())));
+  auto b = torch_ipex::cpu::itensor_view_from_dense(
+      bias, rnn.bias_desc(get_mkldnn_dtype(bias.scalar_type())));
+  auto y = torch_ipex::cpu::itensor_view_from_dense(
+      output, rnn.dst_layer_desc(get_mkldnn_dtype(output.scalar_type())));
+  auto hy = torch_ipex::cpu::itensor_view_from_dense(
+      hy_, rnn.dst_iter_desc(get_mkldnn_dtype(hy_.scalar_type())));
+
+  std::vector<at::Tensor> result;
+  result.reserve(train ? 4 : 3);
+  result.push_back(output);
+  result.push_back(hy_);
+  result.push_back(at::empty({0}, hx_.options()));
+  if (train) {
+    // the weights are not packed in training, see get_lstm_packed_weight
+    auto weight_ih = _shuffle_weight(w0, rnn.mode);
+    auto weight_hh = _shuffle_weight(w1, rnn.mode);
+    auto w1_ = torch_ipex::cpu::itensor_view_from_dense(
+        weight_ih,
+        rnn.weights_layer_desc(
+            input_size, get_mkldnn_dtype(weight_ih.scalar_type())));
+    auto w2_ = torch_ipex::cpu::itensor_view_from_dense(
+        weight_hh,
+        rnn.weights_iter_desc(get_mkldnn_dtype(weight_hh.scalar_type())));
+    at::Tensor workspace;
+    ideep::tensor mkldnn_workspace;
+    if (rnn.mode == ideep::rnn_kind::GRU) {
+      auto pd = ideep::lbr_gru_forward_training::prepare(
+          x, hx, w1_, w2_, b, y, hy, reverse);
+      workspace = LstmWorkspacePool::get().allocate(
+          pd.workspace_desc().get_size(), input.options());
+      mkldnn_workspace.init(
+          pd.workspace_desc(), workspace.template data_ptr<uint8_t>());
+      ideep::lbr_gru_forward_training::compute(
+          pd, x, hx, w1_, w2_, b, mkldnn_workspace, y, hy, reverse);
+    } else {
+      auto pd = ideep::rnn_forward_training::prepare(
+          x, hx, w1_, w2_, b, y, hy, rnn.mode, reverse);
+      workspace = LstmWorkspacePool::get().allocate(
+          pd.workspace_desc().get_size(), input.options());
+      mkldnn_workspace.init(
+          pd.workspace_desc(), workspace.template data_ptr<uint8_t>());
+      ideep::rnn_forward_training::compute(
+          pd, x, hx, w1_, w2_, b, mkldnn_workspace, y, hy);
+    }
+    result.push_back(workspace);
+  } else {
+    ideep::tensor w1_, w2_;
+    std::tie(w1_, w2_) = torch_ipex::cpu::get_rnn_packed_weight(
+        w0,
+        w1,
+        rnn.mode,
+        input_size,
+        rnn.num_gates,
+        rnn.hidden_size,
+        {output_size.cbegin(), output_size.cend()},
+        x,
+        hx,
+        b,
+        reverse);
+    if (rnn.mode == ideep::rnn_kind::GRU) {
+      ideep::lbr_gru_forward_inference::compute(
+          x, hx, w1_, w2_, b, y, hy, reverse);
+    } else {
+      ideep::rnn_forward_inference::compute(
+          x, hx, w1_, w2_, b, y, hy, rnn.mode, reverse);
+    }
+  }
+  return result;
+}
+
+// The gradients of one GRU or vanilla RNN layer, laid out as those of
+// ipex_lstm_layer_backward. The gradients of the weights are of the PyTorch
+// gate order.
+std::vector<at::Tensor> rnn_layer_backward(
+    const at::Tensor& input,
+    const at::Tensor& weight0,
+    const at::Tensor& weight1,
+    const at::Tensor& weight2,
+    const at::Tensor& weight3,
+    const at::Tensor& hx_,
+    const at::Tensor& output,
+    const at::Tensor& hy_,
+    const at::Tensor& grad_output,
+    const at::Tensor& grad_hy,
+    bool reverse,
+    int64_t mode,
+    int64_t hidden_size,
+    int64_t num_layers,
+    bool has_biases,
+    bool train,
+    bool bidirectional,
+    at::IntArrayRef batch_sizes,
+    bool batch_first,
+    const at::Tensor& workspace) {
+  RNNParams rnn(
+      input,
+      batch_sizes,
+      mode,
+      hidden_size,
+      num_layers,
+      bidirectional,
+      batch_first,
+      train);
+
+  auto weight_ih = _shuffle_weight(weight0, rnn.mode);
+  auto weight_hh = _shuffle_weight(weight1, rnn.mode);
+  auto bias = has_biases
+      ? _shuffle_bias(weight2, weight3, rnn.mode)
+      : at::zeros({rnn.num_bias_gates * rnn.hidden_size}, weight_ih.options());
+
+  // per layer input size
+  int64_t input_size = input.size(2);
+  auto x = torch_ipex::cpu::itensor_view_from_dense(
+      input,
+      rnn.src_layer_desc(input_size, get_mkldnn_dtype(input.scalar_type())));
+  auto hx = torch_ipex::cpu::itensor_view_from_dense(
+      hx_, rnn.src_iter_desc(get_mkldnn_dtype(hx_.scalar_type())));
+  auto w1 = torch_ipex::cpu::itensor_view_from_dense(
+      weight_ih,
+      rnn.weights_layer_desc(
+          input_size, get_mkldnn_dtype(weight_ih.scalar_type())));
+  auto w2 = torch_ipex::cpu::itensor_view_from_dense(
+      weight_hh,
+      rnn.weights_iter_desc(get_mkldnn_dtype(weight_hh.scalar_type())));
+  auto b = torch_ipex::cpu::itensor_view_from_dense(
+      bias, rnn.bias_desc(get_mkldnn_dtype(bias.scalar_type())));
+  auto y = torch_ipex::cpu::itensor_view_from_dense(
+      output, rnn.dst_layer_desc(get_mkldnn_dtype(output.scalar_type())));
+  auto hy = torch_ipex::cpu::itensor_view_from_dense(
+      hy_, rnn.dst_iter_desc(get_mkldnn_dtype(hy_.scalar_type())));
+
+  // Create diff_* ATen tensor and corresponding ideep tensor as fp32
+  auto float_options = input.options().dtype(at::ScalarType::Float);
+  auto diff_x_ = at::empty(input.sizes(), float_options);
+  auto diff_hx_ = at::empty(hx_.sizes(), float_options);
+  auto diff_w1_ = at::empty(weight_ih.sizes(), float_options);
+  auto diff_w2_ = at::empty(weight_hh.sizes(), float_options);
+  auto diff_b_ = at::empty(bias.sizes(), float_options);
+  auto diff_x = torch_ipex::cpu::itensor_view_from_dense(
+      diff_x_, rnn.src_layer_desc(input_size, ideep::tensor::data_type::f32));
+  auto diff_hx = torch_ipex::cpu::itensor_view_from_dense(
+      diff_hx_, rnn.src_iter_desc(ideep::tensor::data_type::f32));
+  auto diff_w1 = torch_ipex::cpu::itensor_view_from_dense(
+      diff_w1_,
+      rnn.weights_layer_desc(input_size, ideep::tensor::data_type::f32));
+  auto diff_w2 = torch_ipex::cpu::itensor_view_from_dense(
+      diff_w2_, rnn.weights_iter_desc(ideep::tensor::data_type::f32));
+  auto diff_b = torch_ipex::cpu::itensor_view_from_dense(
+      diff_b_, rnn.bias_desc(ideep::tensor::data_type::f32));
+
+  // Convert grad_y, grad_hy to fp32 in non-fp32 backward
+  auto grad_y_ = grad_output.to(at::ScalarType::Float).contiguous();
+  auto grad_hy_ = grad_hy.to(at::ScalarType::Float).contiguous();
+  auto diff_y = torch_ipex::cpu::itensor_view_from_dense(
+      grad_y_, rnn.dst_layer_desc(ideep::tensor::data_type::f32));
+  auto diff_hy = torch_ipex::cpu::itensor_view_from_dense(
+      grad_hy_, rnn.dst_iter_desc(ideep::tensor::data_type::f32));
+
+  ideep::tensor mkldnn_workspace;
+  if (rnn.mode == ideep::rnn_kind::GRU) {
+    auto forward_hint = ideep::lbr_gru_forward_training::prepare(
+        x, hx, w1, w2, b, y, hy, reverse);
+    mkldnn_workspace.init(
+        forward_hint.workspace_desc(), workspace.template data_ptr<uint8_t>());
+    ideep::lbr_gru_backward::compute(
+        forward_hint,
+        x,
+        hx,
+        w1,
+        w2,
+        b,
+        y,
+        hy,
+        diff_y,
+        diff_hy,
+        mkldnn_workspace,
+        diff_x,
+        diff_hx,
+        diff_w1,
+        diff_w2,
+        diff_b,
+        reverse);
+  } else {
+    auto forward_hint = ideep::rnn_forward_training::prepare(
+        x, hx, w1, w2, b, y, hy, rnn.mode, reverse);
+    mkldnn_workspace.init(
+        forward_hint.workspace_desc(), workspace.template data_ptr<uint8_t>());
+    ideep::rnn_backward::compute(
+        forward_hint,
+        x,
+        hx,
+        w1,
+        w2,
+        b,
+        y,
+        hy,
+        diff_y,
+        diff_hy,
+        mkldnn_workspace,
+        diff_x,
+        diff_hx,
+        diff_w1,
+        diff_w2,
+        diff_b,
+        rnn.mode,
+        reverse);
+  }
+
+  auto diff_cx_ = at::empty({0}, float_options);
+  if (rnn.mode != ideep::rnn_kind::GRU) {
+    return {diff_x_, diff_w1_, diff_w2_, diff_b_, diff_b_, diff_hx_, diff_cx_};
+  }
+  // Shuffle the gates back to the PyTorch order (rt, zt, nt), the summed
+  // biases of rt and zt are of both bias_ih and bias_hh, see _shuffle_bias.
+  auto diff_w0 = _shuffle_weight(diff_w1_, rnn.mode);
+  auto diff_w1 = _shuffle_weight(diff_w2_, rnn.mode);
+  auto diff_b_ih = diff_b_, diff_b_hh = diff_b_;
+  if (has_biases) {
+    auto gates = diff_b_.chunk(4, /*output_channels*/ 0);
+    diff_b_ih = at::cat({gates[1], gates[0], gates[2]}, /*output_channels*/ 0);
+    diff_b_hh = at::cat({gates[1], gates[0], gates[3]}, /*output_channels*/ 0);
+  }
+  return {diff_x_, diff_w0, diff_w1, diff_b_ih, diff_b_hh, diff_hx_, diff_cx_};
+}
+
 std::vector<at::Tensor> ipex_lstm_layer_forward(
     const at::Tensor& input,
     const at::Tensor& w0,
@@ -313,6 +683,24 @@ std::vector<at::Tensor> ipex_lstm_layer_forward(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::cpu::ipex_lstm_layer_forward\n");
 #endif
+  if (static_cast<ideep::rnn_kind>(mode) != ideep::rnn_kind::LSTM) {
+    return rnn_kernel(
+        input,
+        w0,
+        w1,
+        w2,
+        w3,
+        hx_,
+        reverse,
+        batch_sizes,
+        mode,
+        hidden_size,
+        num_layers,
+        has_biases,
+        bidirectional,
+        batch_first,
+        train);
+  }
   return lstm_kernel(
       input,
       w0,
@@ -393,9 +781,7 @@ std::vector<at::Tensor> IPEXLSTMOp::forward(
     bool bidirectional,
     bool batch_first,
     bool train) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("IPEXLSTMOp::forward", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("IPEXLSTMOp::forward", std::vector<c10::IValue>({}));
 #if defined(IPEX_DISP_OP)
   printf("IPEXLSTMOp::forward\n");
 #endif
@@ -407,12 +793,25 @@ std::vector<at::Tensor> IPEXLSTMOp::forward(
   ctx->saved_data["train"] = train;
   ctx->saved_data["bidirectional"] = bidirectional;
   ctx->saved_data["batch_first"] = batch_first;
+  // The fp32 weights of the bf16 training are cast here rather than by the
+  // autocast, so that their gradients are accumulated in fp32 by
+  // ipex_lstm_layer_backward instead of being rounded to bf16. The cast
+  // weights are saved for the backward.
+  auto cast_weight = [&](const at::Tensor& weight) {
+    return !weight.defined() || weight.scalar_type() == input.scalar_type()
+        ? weight
+        : weight.to(input.scalar_type());
+  };
+  auto w0_ = cast_weight(w0);
+  auto w1_ = cast_weight(w1);
+  auto w2_ = cast_weight(w2);
+  auto w3_ = cast_weight(w3);
   auto outputs = _forward(
       input,
-      w0,
-      w1,
-      w2,
-      w3,
+      w0_,
+      w1_,
+      w2_,
+      w3_,
       hx_,
       cx_,
       reverse,
@@ -428,10 +827,10 @@ std::vector<at::Tensor> IPEXLSTMOp::forward(
   if (train) {
     ctx->save_for_backward(
         {input,
-         w0,
-         w1,
-         w2,
-         w3,
+         w0_,
+         w1_,
+         w2_,
+         w3_,
          hx_,
          cx_,
          outputs[0],
@@ -445,9 +844,7 @@ std::vector<at::Tensor> IPEXLSTMOp::forward(
 torch::autograd::tensor_list IPEXLSTMOp::backward(
     torch::autograd::AutogradContext* ctx,
     torch::autograd::tensor_list grad_outputs) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("IPEXLSTMOp::backward", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("IPEXLSTMOp::backward", std::vector<c10::IValue>({}));
 #if defined(IPEX_DISP_OP)
   printf("IPEXLSTMOp::backward\n");
 #endif
@@ -538,10 +935,8 @@ std::vector<at::Tensor> ipex_lstm_layer(
     bool bidirectional,
     bool batch_first,
     bool train) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::cpu::ipex_lstm_layer", std::vector<c10::IValue>({}));
-#endif
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::cpu::ipex_lstm_layer\n");
 #endif
@@ -610,6 +1005,29 @@ std::vector<at::Tensor> ipex_lstm_layer_backward(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::cpu::ipex_lstm_layer_backward\n");
 #endif
+  if (static_cast<ideep::rnn_kind>(mode) != ideep::rnn_kind::LSTM) {
+    return rnn_layer_backward(
+        input,
+        weight0,
+        weight1,
+        weight2,
+        weight3,
+        hx_,
+        output,
+        hy_,
+        grad_output,
+        grad_hy,
+        reverse,
+        mode,
+        hidden_size,
+        num_layers,
+        has_biases,
+        train,
+        bidirectional,
+        batch_sizes,
+        batch_first,
+        workspace);
+  }
   RNNParams rnn(
       input,
       batch_sizes,
@@ -799,7 +1217,8 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> mkldnn_rnn(
   input = input.contiguous();
 
   auto hx = hx_.contiguous();
-  auto cx = cx_.contiguous();
+  // no cell state of GRU and vanilla RNN
+  auto cx = cx_.defined() ? cx_.contiguous() : at::Tensor();
 
   at::MatrixRef<at::Tensor> weights{
       weight, static_cast<size_t>(weight_stride0)};
@@ -815,7 +1234,7 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> mkldnn_rnn(
       auto layer_weights = weights[index];
       TORCH_CHECK(layer_weights.size() == 2 || layer_weights.size() == 4);
       auto layer_hx = hx[index];
-      auto layer_cx = cx[index];
+      auto layer_cx = cx.defined() ? cx[index] : at::empty({0}, hx.options());
       auto reverse = (direction > 0);
       static auto op = torch::Dispatcher::singleton()
                            .findSchemaOrThrow("torch_ipex::ipex_lstm_layer", "")
@@ -901,6 +1320,288 @@ std::pair<at::Tensor, hidden_type> mkldnn_impl(
           std::get<1>(mkldnn_output), std::get<2>(mkldnn_output))};
 }
 
+namespace {
+
+// The u8 quantization parameters of the input and the hidden states of a
+// layer of the int8 LSTM, which share one range in oneDNN.
+quant_utils::TensorQuantizationParams lstm_data_qparams(
+    float min_value,
+    float max_value) {
+  // the hidden states are in (-1, 1)
+  return quant_utils::ChooseQuantizationParams(
+      /*min*/ std::min(min_value, -1.f),
+      /*max*/ std::max(max_value, 1.f),
+      /*q_min*/ 0,
+      /*q_max*/ 255,
+      /*preserve_sparsity=*/false);
+}
+
+at::Tensor quantize_lstm_data(
+    const at::Tensor& data,
+    const quant_utils::TensorQuantizationParams& qparams) {
+  return at::quantize_per_tensor(
+             data.contiguous(), qparams.scale, qparams.zero_point, at::kQUInt8)
+      .int_repr();
+}
+
+std::vector<at::Tensor> quantized_lstm_layer(
+    const at::Tensor& input,
+    at::ArrayRef<at::Tensor> layer_weights,
+    const at::Tensor& hx_,
+    const at::Tensor& cx_,
+    bool reverse,
+    int64_t hidden_size,
+    bool has_biases,
+    const quant_utils::TensorQuantizationParams& qparams,
+    const at::Tensor& weight_scale) {
+  RNNParams rnn(
+      input,
+      /*batch_sizes*/ {},
+      static_cast<int64_t>(ideep::rnn_kind::LSTM),
+      hidden_size,
+      /*num_layers*/ 1,
+      /*bidirectional*/ false,
+      /*batch_first*/ false,
+      /*train*/ false);
+  auto output = at::empty(
+      _output_size</*is_single_direction*/ true>(rnn),
+      input.options().dtype(at::kFloat));
+  auto hy_ = at::empty(cx_.sizes(), cx_.options());
+  auto cy_ = at::empty(cx_.sizes(), cx_.options());
+
+  auto weight_ih = _shuffle_weight(layer_weights[0], rnn.mode);
+  auto weight_hh = _shuffle_weight(layer_weights[1], rnn.mode);
+  auto bias = has_biases
+      ? _shuffle_bias(layer_weights[2], layer_weights[3], rnn.mode)
+      : at::zeros({rnn.num_bias_gates * rnn.hidden_size}, weight_ih.options());
+  auto hx_u8 = quantize_lstm_data(hx_, qparams);
+
+  using dtype = ideep::tensor::data_type;
+  int64_t input_size = input.size(2);
+  ideep::tensor x{rnn.src_layer_desc(input_size, dtype::u8), input.data_ptr()};
+  ideep::tensor hx{rnn.src_iter_desc(dtype::u8), hx_u8.data_ptr()};
+  auto cx = itensor_view_from_dense(cx_, rnn.src_iter_c_desc(dtype::f32));
+  auto w1 = itensor_view_from_dense(
+      weight_ih, rnn.weights_layer_desc(input_size, dtype::f32));
+  auto w2 = itensor_view_from_dense(
+      weight_hh, rnn.weights_iter_desc(dtype::f32));
+  auto b = itensor_view_from_dense(bias, rnn.bias_desc(dtype::f32));
+  auto y = itensor_view_from_dense(output, rnn.dst_layer_desc(dtype::f32));
+  auto hy = itensor_view_from_dense(hy_, rnn.dst_iter_desc(dtype::f32));
+  auto cy = itensor_view_from_dense(cy_, rnn.dst_iter_c_desc(dtype::f32));
+
+  // oneDNN multiplies the values by the scales to quantize them
+  auto scales = weight_scale.to(at::kFloat).reciprocal().contiguous();
+  ideep::scale_t weights_scales(
+      scales.data_ptr<float>(), scales.data_ptr<float>() + scales.numel());
+  ideep::lstm_forward_inference::compute(
+      x,
+      hx,
+      cx,
+      w1,
+      w2,
+      b,
+      y,
+      hy,
+      cy,
+      1.f / qparams.scale,
+      static_cast<float>(qparams.zero_point),
+      weights_scales,
+      reverse);
+  return {output, hy_, cy_};
+}
+
+} // anonymous namespace
+
+// int8 inference of a LSTM by the int8 LSTM primitive of oneDNN, of which the
+// input and the hidden states of each layer are quantized to u8 with one
+// range, i.e. the calibrated range of the input, or the range of the hidden
+// states of the previous layer, and the weights are quantized to s8 with the
+// scales of each gate and output channel, while the cell states are kept in
+// float as oneDNN requires.
+std::tuple<at::Tensor, at::Tensor, at::Tensor> quantized_lstm(
+    const at::Tensor& input_,
+    at::TensorList hx,
+    at::TensorList params,
+    bool has_biases,
+    int64_t num_layers,
+    bool bidirectional,
+    bool batch_first,
+    double input_min,
+    double input_max,
+    at::TensorList weight_scales) {
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::quantized_lstm", std::vector<c10::IValue>({}));
+#if defined(IPEX_DISP_OP)
+  printf("torch_ipex::cpu::quantized_lstm\n");
+#endif
+  TORCH_CHECK(
+      input_.scalar_type() == at::kFloat,
+      "quantized_lstm: expect a float input");
+  TORCH_CHECK(hx.size() == 2, "quantized_lstm: expect the hx and the cx");
+  auto input = batch_first ? input_.transpose(0, 1) : input_;
+  auto hx_ = hx[0].contiguous();
+  auto cx_ = hx[1].contiguous().to(at::kFloat);
+  int64_t hidden_size = hx_.size(2);
+
+  at::MatrixRef<at::Tensor> weights{
+      params, static_cast<size_t>(has_biases ? 4 : 2)};
+  auto num_directions = bidirectional ? 2 : 1;
+  TORCH_CHECK(
+      weight_scales.size() == num_layers * num_directions,
+      "quantized_lstm: expect the weight scales of each layer and direction");
+  auto layer_input = input;
+  auto qparams = lstm_data_qparams(input_min, input_max);
+  std::vector<at::Tensor> layer_output(num_directions);
+  std::vector<at::Tensor> layer_hy(num_layers * num_directions);
+  std::vector<at::Tensor> layer_cy(num_layers * num_directions);
+  for (int64_t layer = 0; layer < num_layers; layer++) {
+    auto layer_input_u8 = quantize_lstm_data(layer_input, qparams);
+    for (int64_t direction = 0; direction < num_directions; direction++) {
+      auto index = layer * num_directions + direction;
+      auto outputs = quantized_lstm_layer(
+          layer_input_u8,
+          weights[index],
+          hx_[index],
+          cx_[index],
+          /*reverse*/ direction > 0,
+          hidden_size,
+          has_biases,
+          qparams,
+          weight_scales[index]);
+      layer_output[direction] = outputs[0];
+      layer_hy[index] = outputs[1];
+      layer_cy[index] = outputs[2];
+    }
+    layer_input = num_directions == 1
+        ? layer_output[0]
+        : at::cat(layer_output, /*output_channels*/ -1);
+    // the input of the next layer is the hidden states of this layer
+    qparams = lstm_data_qparams(-1.f, 1.f);
+  }
+  auto output = layer_input;
+  if (batch_first) {
+    output = output.transpose(0, 1);
+  }
+  return std::make_tuple(
+      output, at::stack(layer_hy, 0), at::stack(layer_cy, 0));
+}
+
+// Inference of a LSTM on the packed sequences, i.e. the data and the
+// batch_sizes of a PackedSequence, of which the batch of each time step only
+// has the sequences not finished yet. The time steps are split into segments
+// of the same batch size, each of which is a contiguous [seq_length, batch]
+// tnc view of the data and runs one LSTM primitive on the first rows of the
+// running hidden states, so that no time step is padded. The sequences are
+// sorted by their lengths, so the rows of a finished sequence keep its last
+// hidden states. The reverse direction runs the segments from the last one,
+// where the rows of the sequences joining the batch start from hx.
+std::tuple<at::Tensor, at::Tensor, at::Tensor> ipex_lstm_packed(
+    const at::Tensor& data,
+    const at::Tensor& batch_sizes_,
+    at::TensorList hx,
+    at::TensorList params,
+    bool has_biases,
+    int64_t num_layers,
+    bool bidirectional) {
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::ipex_lstm_packed", std::vector<c10::IValue>({}));
+#if defined(IPEX_DISP_OP)
+  printf("torch_ipex::cpu::ipex_lstm_packed\n");
+#endif
+  TORCH_CHECK(hx.size() == 2, "ipex_lstm_packed: expect the hx and the cx");
+  TORCH_CHECK(
+      data.dim() == 2 && batch_sizes_.dim() == 1,
+      "ipex_lstm_packed: expect the 2-D data and the 1-D batch_sizes");
+  auto batch_sizes_long = batch_sizes_.to(at::kLong).contiguous();
+  int64_t* batch_sizes = batch_sizes_long.data_ptr<int64_t>();
+  int64_t seq_length = batch_sizes_long.numel();
+  TORCH_CHECK(
+      batch_sizes_long.sum().item<int64_t>() == data.size(0),
+      "ipex_lstm_packed: the batch_sizes don't match the data");
+
+  // the first time step and the length of each segment
+  std::vector<std::pair<int64_t, int64_t>> segments;
+  for (int64_t t = 0; t < seq_length; t++) {
+    if (t == 0 || batch_sizes[t] != batch_sizes[t - 1]) {
+      TORCH_CHECK(
+          t == 0 || batch_sizes[t] < batch_sizes[t - 1],
+          "ipex_lstm_packed: expect the sorted sequences");
+      segments.emplace_back(t, 0);
+    }
+    segments.back().second++;
+  }
+  std::vector<int64_t> offsets(seq_length + 1, 0);
+  for (int64_t t = 0; t < seq_length; t++) {
+    offsets[t + 1] = offsets[t] + batch_sizes[t];
+  }
+
+  auto hx_ = hx[0].contiguous();
+  auto cx_ = hx[1].contiguous();
+  int64_t hidden_size = hx_.size(2);
+  at::MatrixRef<at::Tensor> weights{
+      params, static_cast<size_t>(has_biases ? 4 : 2)};
+  auto num_directions = bidirectional ? 2 : 1;
+  auto layer_input = data.contiguous();
+  std::vector<at::Tensor> layer_hy(num_layers * num_directions);
+  std::vector<at::Tensor> layer_cy(num_layers * num_directions);
+  for (int64_t layer = 0; layer < num_layers; layer++) {
+    auto layer_output = at::empty(
+        {data.size(0), hidden_size * num_directions}, layer_input.options());
+    for (int64_t direction = 0; direction < num_directions; direction++) {
+      auto index = layer * num_directions + direction;
+      auto layer_weights = weights[index];
+      auto w2 = has_biases
+          ? layer_weights[2]
+          : at::zeros(layer_weights[0].sizes(), layer_weights[0].options());
+      auto w3 = has_biases
+          ? layer_weights[3]
+          : at::zeros(layer_weights[1].sizes(), layer_weights[1].options());
+      // the running hidden states of all the sequences
+      auto h = hx_[index].clone();
+      auto c = cx_[index].clone();
+      bool reverse = direction > 0;
+      for (size_t i = 0; i < segments.size(); i++) {
+        const auto& segment = segments[reverse ? segments.size() - 1 - i : i];
+        int64_t t0 = segment.first;
+        int64_t length = segment.second;
+        int64_t batch = batch_sizes[t0];
+        auto input = layer_input.narrow(0, offsets[t0], length * batch)
+                         .view({length, batch, layer_input.size(1)});
+        auto h_rows = h.narrow(0, 0, batch);
+        auto c_rows = c.narrow(0, 0, batch);
+        auto outputs = lstm_kernel(
+            input,
+            layer_weights[0],
+            layer_weights[1],
+            w2,
+            w3,
+            h_rows,
+            c_rows,
+            reverse,
+            /*batch_sizes*/ {},
+            static_cast<int64_t>(ideep::rnn_kind::LSTM),
+            hidden_size,
+            /*num_layers*/ 1,
+            has_biases,
+            /*bidirectional*/ false,
+            /*batch_first*/ false,
+            /*train*/ false);
+        layer_output.narrow(0, offsets[t0], length * batch)
+            .narrow(1, direction * hidden_size, hidden_size)
+            .copy_(outputs[0].view({length * batch, hidden_size}));
+        h_rows.copy_(outputs[1]);
+        c_rows.copy_(outputs[2]);
+      }
+      layer_hy[index] = h;
+      layer_cy[index] = c;
+    }
+    layer_input = layer_output;
+  }
+  return std::make_tuple(
+      layer_input, at::stack(layer_hy, 0), at::stack(layer_cy, 0));
+}
+
 } // namespace cpu
 } // namespace torch_ipex
 
@@ -915,9 +1616,7 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> ipex_lstm(
     bool train,
     bool bidirectional,
     bool batch_first) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("ipex_lstm", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("ipex_lstm", std::vector<c10::IValue>({}));
 #if defined(IPEX_DISP_OP)
   printf("ipex_lstm\n");
 #endif
@@ -937,6 +1636,40 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> ipex_lstm(
   auto cy = std::get<1>(result.second);
   return std::make_tuple(output, hy, cy);
 }
+
+std::tuple<at::Tensor, at::Tensor> ipex_rnn(
+    const at::Tensor& input,
+    const at::Tensor& hx,
+    std::vector<at::Tensor> params,
+    int64_t mode,
+    bool has_biases,
+    int64_t num_layers,
+    double dropout_p,
+    bool train,
+    bool bidirectional,
+    bool batch_first) {
+  IPEX_RECORD_FUNCTION("ipex_rnn", std::vector<c10::IValue>({}));
+#if defined(IPEX_DISP_OP)
+  printf("ipex_rnn\n");
+#endif
+  TORCH_CHECK(
+      mode == ideep::rnn_kind::RNN_RELU || mode == ideep::rnn_kind::RNN_TANH ||
+          mode == ideep::rnn_kind::GRU,
+      "ipex_rnn only supports GRU and vanilla RNN, got mode ",
+      mode);
+  auto result = cpu::mkldnn_impl(
+      input,
+      hx,
+      params,
+      has_biases,
+      static_cast<ideep::rnn_kind>(mode),
+      num_layers,
+      dropout_p,
+      train,
+      bidirectional,
+      batch_first);
+  return std::make_tuple(result.first, result.second);
+}
 } // namespace torch_ipex
 
 namespace {
@@ -947,6 +1680,23 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
       "bidirectional, bool batch_first) -> (Tensor, Tensor, Tensor)",
       torch_ipex::ipex_lstm);
   m.impl("ipex_lstm", c10::DispatchKey::CPU, torch_ipex::ipex_lstm);
+  m.def(
+      "ipex_rnn(Tensor input, Tensor hx, Tensor[] params, int mode, bool "
+      "has_biases, int num_layers, float dropout_p, bool train, bool "
+      "bidirectional, bool batch_first) -> (Tensor, Tensor)",
+      torch_ipex::ipex_rnn);
+  m.impl("ipex_rnn", c10::DispatchKey::CPU, torch_ipex::ipex_rnn);
+  m.def(
+      "quantized_lstm(Tensor input, Tensor[] hx, Tensor[] params, bool "
+      "has_biases, int num_layers, bool bidirectional, bool batch_first, "
+      "float input_min, float input_max, Tensor[] weight_scales) -> (Tensor, "
+      "Tensor, Tensor)",
+      torch_ipex::cpu::quantized_lstm);
+  m.def(
+      "ipex_lstm_packed(Tensor data, Tensor batch_sizes, Tensor[] hx, "
+      "Tensor[] params, bool has_biases, int num_layers, bool bidirectional) "
+      "-> (Tensor, Tensor, Tensor)",
+      torch_ipex::cpu::ipex_lstm_packed);
   m.def(
       "ipex_lstm_layer(Tensor input, Tensor weight0, Tensor weight1, Tensor "
       "weight2, Tensor weight3, Tensor hx_, Tensor cx_, bool reverse, int[] "
@@ -1008,6 +1758,10 @@ std::vector<at::Tensor> ipex_lstm_layer(
   auto target_type = get_autocast_dtype();
   // only have bf16 support now, keep fp32 for other target_type
   bool cast_to_bfloat16 = at::kBFloat16 == target_type;
+  // the weights of the training are cast by IPEXLSTMOp to keep the fp32
+  // weight gradients
+  bool cast_weights =
+      cast_to_bfloat16 && !(train && at::GradMode::is_enabled());
   auto casted_input =
       cast_to_bfloat16 ? cpu_cached_cast(at::kBFloat16, input) : input;
   auto casted_hx_ =
@@ -1015,13 +1769,13 @@ std::vector<at::Tensor> ipex_lstm_layer(
   auto casted_cx_ =
       cast_to_bfloat16 ? cpu_cached_cast(at::kBFloat16, cx_) : cx_;
   auto casted_weight0 =
-      cast_to_bfloat16 ? cpu_cached_cast(at::kBFloat16, weight0) : weight0;
+      cast_weights ? cpu_cached_cast(at::kBFloat16, weight0) : weight0;
   auto casted_weight1 =
-      cast_to_bfloat16 ? cpu_cached_cast(at::kBFloat16, weight1) : weight1;
+      cast_weights ? cpu_cached_cast(at::kBFloat16, weight1) : weight1;
   auto casted_weight2 =
-      cast_to_bfloat16 ? cpu_cached_cast(at::kBFloat16, weight2) : weight2;
+      cast_weights ? cpu_cached_cast(at::kBFloat16, weight2) : weight2;
   auto casted_weight3 =
-      cast_to_bfloat16 ? cpu_cached_cast(at::kBFloat16, weight3) : weight3;
+      cast_weights ? cpu_cached_cast(at::kBFloat16, weight3) : weight3;
   return op.call(
       casted_input,
       casted_weight0,
@@ -18,6 +18,20 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> ipex_lstm(
     bool bidirectional,
     bool batch_first);
 
+// GRU (linear-before-reset) and vanilla RNN of mode, i.e. ideep::rnn_kind
+// GRU, RNN_TANH or RNN_RELU, which share the layer kernels of ipex_lstm.
+std::tuple<at::Tensor, at::Tensor> ipex_rnn(
+    const at::Tensor& input,
+    const at::Tensor& hx,
+    std::vector<at::Tensor> params,
+    int64_t mode,
+    bool has_biases,
+    int64_t num_layers,
+    double dropout_p,
+    bool train,
+    bool bidirectional,
+    bool batch_first);
+
 namespace cpu {
 
 class IPEXLSTMOp : public torch::autograd::Function<IPEXLSTMOp> {
@@ -126,6 +140,27 @@ std::vector<at::Tensor> ipex_lstm_layer_forward(
     bool batch_first,
     bool train);
 
+std::tuple<at::Tensor, at::Tensor, at::Tensor> quantized_lstm(
+    const at::Tensor& input_,
+    at::TensorList hx,
+    at::TensorList params,
+    bool has_biases,
+    int64_t num_layers,
+    bool bidirectional,
+    bool batch_first,
+    double input_min,
+    double input_max,
+    at::TensorList weight_scales);
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor> ipex_lstm_packed(
+    const at::Tensor& data,
+    const at::Tensor& batch_sizes_,
+    at::TensorList hx,
+    at::TensorList params,
+    bool has_biases,
+    int64_t num_layers,
+    bool bidirectional);
+
 static std::tuple<at::Tensor, at::Tensor, at::Tensor> ipex_lstm(
     const at::Tensor& input,
     std::vector<at::Tensor> hx,
@@ -4,9 +4,14 @@
 #include <ATen/Parallel.h>
 #include <ATen/cpu/vec/vec.h>
 #include <torch/library.h>
+#include <algorithm>
+#include <numeric>
+#include <type_traits>
 #include "csrc/autocast/autocast_mode.h"
 #include "csrc/autocast/autocast_verbose.h"
 #include "csrc/utils/library.h"
+#include "csrc/utils/op_trace.h"
+#include "csrc/utils/parallel_trace.h"
 
 // use float as accumulation type for BFloat16
 template <typename scalar_t>
@@ -350,6 +355,124 @@ inline void roi_align_single_framework_channels_last_forward<
   } // for ph
 }
 
+// The cost of pooling one ROI, i.e. its number of sampling points, by which
+// the ROIs of different sizes are balanced across the threads.
+template <typename ACC_T>
+inline int64_t roi_align_cost(
+    const ACC_T* offset_rois,
+    const ACC_T& spatial_scale,
+    int pooled_height,
+    int pooled_width,
+    int sampling_ratio,
+    bool aligned) {
+  if (sampling_ratio > 0) {
+    return sampling_ratio * sampling_ratio * pooled_height * pooled_width;
+  }
+  ACC_T roi_width = (offset_rois[3] - offset_rois[1]) * spatial_scale;
+  ACC_T roi_height = (offset_rois[4] - offset_rois[2]) * spatial_scale;
+  if (!aligned) {
+    roi_width = std::max(roi_width, (ACC_T)1.);
+    roi_height = std::max(roi_height, (ACC_T)1.);
+  }
+  int64_t roi_bin_grid_h = ceil(roi_height / pooled_height);
+  int64_t roi_bin_grid_w = ceil(roi_width / pooled_width);
+  return std::max<int64_t>(roi_bin_grid_h * roi_bin_grid_w, 1) *
+      pooled_height * pooled_width;
+}
+
+template <typename T, typename ACC_T>
+inline void roi_align_single_roi_forward(
+    const T* input,
+    const ACC_T& spatial_scale,
+    int channels,
+    int height,
+    int width,
+    int pooled_height,
+    int pooled_width,
+    int sampling_ratio,
+    bool aligned,
+    const ACC_T* offset_rois,
+    T* output,
+    bool is_channels_last) {
+  int roi_batch_ind = offset_rois[0];
+
+  // Do not using rounding; this implementation detail is critical
+  ACC_T offset = aligned ? (ACC_T)0.5 : (ACC_T)0.0;
+  ACC_T roi_start_w = offset_rois[1] * spatial_scale - offset;
+  ACC_T roi_start_h = offset_rois[2] * spatial_scale - offset;
+  ACC_T roi_end_w = offset_rois[3] * spatial_scale - offset;
+  ACC_T roi_end_h = offset_rois[4] * spatial_scale - offset;
+
+  ACC_T roi_width = roi_end_w - roi_start_w;
+  ACC_T roi_height = roi_end_h - roi_start_h;
+  if (!aligned) {
+    // Force malformed ROIs to be 1x1
+    roi_width = std::max(roi_width, (ACC_T)1.);
+    roi_height = std::max(roi_height, (ACC_T)1.);
+  }
+
+  ACC_T bin_size_h =
+      static_cast<ACC_T>(roi_height) / static_cast<ACC_T>(pooled_height);
+  ACC_T bin_size_w =
+      static_cast<ACC_T>(roi_width) / static_cast<ACC_T>(pooled_width);
+
+  // We use roi_bin_grid to sample the grid and mimic integral
+  int roi_bin_grid_h = (sampling_ratio > 0)
+      ? sampling_ratio
+      : ceil(roi_height / pooled_height); // e.g., = 2
+  int roi_bin_grid_w =
+      (sampling_ratio > 0) ? sampling_ratio : ceil(roi_width / pooled_width);
+
+  // We do average (integral) pooling inside a bin
+  // When the grid is empty, output zeros.
+  const ACC_T count = std::max(roi_bin_grid_h * roi_bin_grid_w, 1); // e.g. = 4
+
+  // we want to precalculate indices and weights shared by all channels,
+  // this is the key point of optimization
+  std::vector<PreCalc<ACC_T>> pre_calc(
+      roi_bin_grid_h * roi_bin_grid_w * pooled_width * pooled_height);
+  pre_calc_for_bilinear_interpolate(
+      height,
+      width,
+      pooled_height,
+      pooled_width,
+      roi_start_h,
+      roi_start_w,
+      bin_size_h,
+      bin_size_w,
+      roi_bin_grid_h,
+      roi_bin_grid_w,
+      pre_calc);
+
+  if (is_channels_last) {
+    roi_align_single_framework_channels_last_forward<T, ACC_T>(
+        input + roi_batch_ind * height * width * channels,
+        count,
+        channels,
+        height,
+        width,
+        pooled_height,
+        pooled_width,
+        roi_bin_grid_h,
+        roi_bin_grid_w,
+        pre_calc,
+        output);
+  } else {
+    roi_align_single_framework_forward<T, ACC_T>(
+        input + roi_batch_ind * channels * height * width,
+        count,
+        channels,
+        height,
+        width,
+        pooled_height,
+        pooled_width,
+        roi_bin_grid_h,
+        roi_bin_grid_w,
+        pre_calc,
+        output);
+  }
+}
+
 template <typename T, typename ACC_T>
 void roi_align_forward_kernel_impl(
     int n_rois,
@@ -367,102 +490,127 @@ void roi_align_forward_kernel_impl(
     bool is_channels_last) {
   // (n, c, ph, pw) is an element in the pooled output
   // can be parallelized using omp
+  parallel_trace::ParallelRegion region("roi_align_forward");
   at::parallel_for(0, n_rois, 1, [&](int begin, int end) {
+    IPEX_PARALLEL_CHUNK(region);
     for (int n = begin; n < end; n++) {
-      const ACC_T* offset_rois = rois + n * 5;
-      int roi_batch_ind = offset_rois[0];
-
-      // Do not using rounding; this implementation detail is critical
-      ACC_T offset = aligned ? (ACC_T)0.5 : (ACC_T)0.0;
-      ACC_T roi_start_w = offset_rois[1] * spatial_scale - offset;
-      ACC_T roi_start_h = offset_rois[2] * spatial_scale - offset;
-      ACC_T roi_end_w = offset_rois[3] * spatial_scale - offset;
-      ACC_T roi_end_h = offset_rois[4] * spatial_scale - offset;
-
-      ACC_T roi_width = roi_end_w - roi_start_w;
-      ACC_T roi_height = roi_end_h - roi_start_h;
-      if (!aligned) {
-        // Force malformed ROIs to be 1x1
-        roi_width = std::max(roi_width, (ACC_T)1.);
-        roi_height = std::max(roi_height, (ACC_T)1.);
-      }
-
-      ACC_T bin_size_h =
-          static_cast<ACC_T>(roi_height) / static_cast<ACC_T>(pooled_height);
-      ACC_T bin_size_w =
-          static_cast<ACC_T>(roi_width) / static_cast<ACC_T>(pooled_width);
-
-      // We use roi_bin_grid to sample the grid and mimic integral
-      int roi_bin_grid_h = (sampling_ratio > 0)
-          ? sampling_ratio
-          : ceil(roi_height / pooled_height); // e.g., = 2
-      int roi_bin_grid_w = (sampling_ratio > 0)
-          ? sampling_ratio
-          : ceil(roi_width / pooled_width);
-
-      // We do average (integral) pooling inside a bin
-      // When the grid is empty, output zeros.
-      const ACC_T count =
-          std::max(roi_bin_grid_h * roi_bin_grid_w, 1); // e.g. = 4
-
-      // we want to precalculate indices and weights shared by all channels,
-      // this is the key point of optimization
-      std::vector<PreCalc<ACC_T>> pre_calc(
-          roi_bin_grid_h * roi_bin_grid_w * pooled_width * pooled_height);
-      pre_calc_for_bilinear_interpolate(
+      roi_align_single_roi_forward<T, ACC_T>(
+          input,
+          spatial_scale,
+          channels,
           height,
           width,
           pooled_height,
           pooled_width,
-          roi_start_h,
-          roi_start_w,
-          bin_size_h,
-          bin_size_w,
-          roi_bin_grid_h,
-          roi_bin_grid_w,
-          pre_calc);
-
-      if (is_channels_last) {
-        roi_align_single_framework_channels_last_forward<T, ACC_T>(
-            input + roi_batch_ind * height * width * channels,
-            count,
-            channels,
-            height,
-            width,
-            pooled_height,
-            pooled_width,
-            roi_bin_grid_h,
-            roi_bin_grid_w,
-            pre_calc,
-            output + n * pooled_width * pooled_height * channels);
-      } else {
-        roi_align_single_framework_forward<T, ACC_T>(
-            input + roi_batch_ind * channels * height * width,
-            count,
+          sampling_ratio,
+          aligned,
+          rois + n * 5,
+          output + n * channels * pooled_width * pooled_height,
+          is_channels_last);
+    } // for n
+  });
+}
+
+// The ROIs of all the levels of a feature pyramid are pooled in one pass, of
+// which the level of each ROI is assigned by the heuristic of FPN, i.e. Eqn.
+// (1) of https://arxiv.org/abs/1612.03144, the same as the LevelMapper of
+// torchvision. The ROIs are split across the threads by the sum of their
+// costs instead of their number, and each of them is written to its position
+// in rois.
+template <typename T, typename ACC_T>
+void multilevel_roi_align_forward_kernel_impl(
+    int n_rois,
+    const std::vector<const T*>& inputs,
+    const std::vector<ACC_T>& spatial_scales,
+    int channels,
+    const std::vector<int>& heights,
+    const std::vector<int>& widths,
+    int pooled_height,
+    int pooled_width,
+    int sampling_ratio,
+    bool aligned,
+    int canonical_scale,
+    int canonical_level,
+    const ACC_T* rois,
+    T* output,
+    bool is_channels_last) {
+  int num_levels = inputs.size();
+  // the spatial scales are 1 / 2 ^ k of the levels k_min, ..., k_max
+  int k_min = std::lround(-std::log2(static_cast<double>(spatial_scales[0])));
+
+  std::vector<int> levels(n_rois);
+  std::vector<int64_t> costs(n_rois + 1, 0);
+  at::parallel_for(0, n_rois, 64, [&](int begin, int end) {
+    for (int n = begin; n < end; n++) {
+      const ACC_T* offset_rois = rois + n * 5;
+      float s = std::sqrt(
+          static_cast<float>(offset_rois[3] - offset_rois[1]) *
+          static_cast<float>(offset_rois[4] - offset_rois[2]));
+      float k = std::floor(
+          canonical_level + std::log2(s / canonical_scale) + 1e-6f);
+      // the empty and the malformed ROIs go to the first level
+      int level = k > k_min
+          ? std::min<float>(k, k_min + num_levels - 1) - k_min
+          : 0;
+      levels[n] = level;
+      costs[n + 1] = roi_align_cost(
+          offset_rois,
+          spatial_scales[level],
+          pooled_height,
+          pooled_width,
+          sampling_ratio,
+          aligned);
+    }
+  });
+  // costs[n] is the cost of the ROIs before n
+  std::partial_sum(costs.begin(), costs.end(), costs.begin());
+
+  int64_t num_threads = at::get_num_threads();
+  int64_t total_cost = costs[n_rois];
+  parallel_trace::ParallelRegion region("multilevel_roi_align_forward");
+  at::parallel_for(0, num_threads, 1, [&](int64_t begin, int64_t end) {
+    IPEX_PARALLEL_CHUNK(region);
+    for (int64_t t = begin; t < end; t++) {
+      // the ROIs of which the costs before start in [t, t + 1) * total_cost /
+      // num_threads
+      int roi_begin = std::lower_bound(
+                          costs.begin(),
+                          costs.begin() + n_rois,
+                          total_cost * t / num_threads) -
+          costs.begin();
+      int roi_end = std::lower_bound(
+                        costs.begin(),
+                        costs.begin() + n_rois,
+                        total_cost * (t + 1) / num_threads) -
+          costs.begin();
+      for (int n = roi_begin; n < roi_end; n++) {
+        int level = levels[n];
+        roi_align_single_roi_forward<T, ACC_T>(
+            inputs[level],
+            spatial_scales[level],
             channels,
-            height,
-            width,
+            heights[level],
+            widths[level],
             pooled_height,
             pooled_width,
-            roi_bin_grid_h,
-            roi_bin_grid_w,
-            pre_calc,
-            output + n * channels * pooled_width * pooled_height);
+            sampling_ratio,
+            aligned,
+            rois + n * 5,
+            output + n * channels * pooled_width * pooled_height,
+            is_channels_last);
       }
-    } // for n
+    }
   });
 }
 
-template <class T>
-inline void add(T* address, const T& val) {
-  *address += val;
-}
-
+// The backward of the channels [c_begin, c_end) of one ROI, accumulated to
+// grad_input of which the channels are the planes of height * width.
 template <typename T, typename ACC_T>
 inline void roi_align_single_framework_backward(
     const T* grad_output,
     const ACC_T count,
-    int channels,
+    int c_begin,
+    int c_end,
     int height,
     int width,
     int pooled_height,
@@ -470,9 +618,9 @@ inline void roi_align_single_framework_backward(
     int roi_bin_grid_h,
     int roi_bin_grid_w,
     const std::vector<PreCalc<ACC_T>>& pre_calc,
-    T* grad_input) {
-  for (int c = 0; c < channels; c++) {
-    T* offset_grad_input = grad_input + c * height * width;
+    ACC_T* grad_input) {
+  for (int c = c_begin; c < c_end; c++) {
+    ACC_T* offset_grad_input = grad_input + (c - c_begin) * height * width;
     const T* offset_grad_output =
         grad_output + c * pooled_height * pooled_width;
     int pre_calc_index = 0;
@@ -485,15 +633,10 @@ inline void roi_align_single_framework_backward(
         for (int iy = 0; iy < roi_bin_grid_h; iy++) {
           for (int ix = 0; ix < roi_bin_grid_w; ix++) {
             PreCalc<ACC_T> pc = pre_calc[pre_calc_index];
-            T g1 = grad_output_this_bin * pc.w1 / count;
-            T g2 = grad_output_this_bin * pc.w2 / count;
-            T g3 = grad_output_this_bin * pc.w3 / count;
-            T g4 = grad_output_this_bin * pc.w4 / count;
-
-            add(offset_grad_input + pc.pos1, static_cast<T>(g1));
-            add(offset_grad_input + pc.pos2, static_cast<T>(g2));
-            add(offset_grad_input + pc.pos3, static_cast<T>(g3));
-            add(offset_grad_input + pc.pos4, static_cast<T>(g4));
+            offset_grad_input[pc.pos1] += grad_output_this_bin * pc.w1 / count;
+            offset_grad_input[pc.pos2] += grad_output_this_bin * pc.w2 / count;
+            offset_grad_input[pc.pos3] += grad_output_this_bin * pc.w3 / count;
+            offset_grad_input[pc.pos4] += grad_output_this_bin * pc.w4 / count;
             pre_calc_index += 1;
           } // ix
         } // iy
@@ -502,56 +645,68 @@ inline void roi_align_single_framework_backward(
   } // c
 }
 
+// The backward of the channels [c_begin, c_end) of one ROI, accumulated to
+// grad_input of which the pixels are the rows of ld.
 template <typename T, typename ACC_T>
 inline void roi_align_single_framework_channels_last_backward(
     const T* grad_output,
     const ACC_T count,
     int channels,
-    int height,
-    int width,
+    int c_begin,
+    int c_end,
     int pooled_height,
     int pooled_width,
     int roi_bin_grid_h,
     int roi_bin_grid_w,
     const std::vector<PreCalc<ACC_T>>& pre_calc,
-    T* grad_input) {
-  // for 'normal' size of channels, should be L1 fit;
-  // otherwise consider blocking on channels.
-  using Vec = at::vec::Vectorized<T>;
+    ACC_T* grad_input,
+    int64_t ld) {
+  using Vec = at::vec::Vectorized<ACC_T>;
+  int size = c_end - c_begin;
+  // the grad_output of a bin in ACC_T, shared by its sampling points
+  std::unique_ptr<ACC_T[]> g_out_arr;
+  if (!std::is_same<T, ACC_T>::value) {
+    g_out_arr.reset(new ACC_T[size]);
+  }
 
   int pre_calc_index = 0;
   for (int ph = 0; ph < pooled_height; ph++) {
     for (int pw = 0; pw < pooled_width; pw++) {
-      const T* g_out = grad_output + (ph * pooled_width + pw) * channels;
+      const T* g_out_bin =
+          grad_output + (ph * pooled_width + pw) * channels + c_begin;
+      const ACC_T* g_out;
+      if (std::is_same<T, ACC_T>::value) {
+        g_out = reinterpret_cast<const ACC_T*>(g_out_bin);
+      } else {
+        at::vec::convert(g_out_bin, g_out_arr.get(), size);
+        g_out = g_out_arr.get();
+      }
 
       for (int iy = 0; iy < roi_bin_grid_h; iy++) {
         for (int ix = 0; ix < roi_bin_grid_w; ix++) {
           PreCalc<ACC_T> pc = pre_calc[pre_calc_index];
-          T* g_in1 = grad_input + pc.pos1 * channels;
-          T* g_in2 = grad_input + pc.pos2 * channels;
-          T* g_in3 = grad_input + pc.pos3 * channels;
-          T* g_in4 = grad_input + pc.pos4 * channels;
-
-          Vec w1_vec = Vec(static_cast<T>(pc.w1 / count));
-          Vec w2_vec = Vec(static_cast<T>(pc.w2 / count));
-          Vec w3_vec = Vec(static_cast<T>(pc.w3 / count));
-          Vec w4_vec = Vec(static_cast<T>(pc.w4 / count));
+          ACC_T* g_in1 = grad_input + pc.pos1 * ld;
+          ACC_T* g_in2 = grad_input + pc.pos2 * ld;
+          ACC_T* g_in3 = grad_input + pc.pos3 * ld;
+          ACC_T* g_in4 = grad_input + pc.pos4 * ld;
+
+          Vec w1_vec = Vec(pc.w1 / count);
+          Vec w2_vec = Vec(pc.w2 / count);
+          Vec w3_vec = Vec(pc.w3 / count);
+          Vec w4_vec = Vec(pc.w4 / count);
           int64_t d2 = 0;
-          for (; d2 < channels - (channels % Vec::size()); d2 += Vec::size()) {
-            Vec g_in1_vec =
-                Vec::loadu(g_in1 + d2) + Vec::loadu(g_out + d2) * w1_vec;
-            g_in1_vec.store(g_in1 + d2);
-            Vec g_in2_vec =
-                Vec::loadu(g_in2 + d2) + Vec::loadu(g_out + d2) * w2_vec;
-            g_in2_vec.store(g_in2 + d2);
-            Vec g_in3_vec =
-                Vec::loadu(g_in3 + d2) + Vec::loadu(g_out + d2) * w3_vec;
-            g_in3_vec.store(g_in3 + d2);
-            Vec g_in4_vec =
-                Vec::loadu(g_in4 + d2) + Vec::loadu(g_out + d2) * w4_vec;
-            g_in4_vec.store(g_in4 + d2);
+          for (; d2 < size - (size % Vec::size()); d2 += Vec::size()) {
+            Vec g_out_vec = Vec::loadu(g_out + d2);
+            at::vec::fmadd(g_out_vec, w1_vec, Vec::loadu(g_in1 + d2))
+                .store(g_in1 + d2);
+            at::vec::fmadd(g_out_vec, w2_vec, Vec::loadu(g_in2 + d2))
+                .store(g_in2 + d2);
+            at::vec::fmadd(g_out_vec, w3_vec, Vec::loadu(g_in3 + d2))
+                .store(g_in3 + d2);
+            at::vec::fmadd(g_out_vec, w4_vec, Vec::loadu(g_in4 + d2))
+                .store(g_in4 + d2);
           }
-          for (; d2 < channels; d2++) {
+          for (; d2 < size; d2++) {
             g_in1[d2] += g_out[d2] * pc.w1 / count;
             g_in2[d2] += g_out[d2] * pc.w2 / count;
             g_in3[d2] += g_out[d2] * pc.w3 / count;
@@ -564,9 +719,15 @@ inline void roi_align_single_framework_channels_last_backward(
   } // ph
 }
 
+// The gradients are split into the tiles of an image and a block of channels,
+// each of which is owned by one thread and accumulated from all the ROIs of
+// the image, so that neither atomics nor a serial loop over the ROIs is
+// needed. The tiles are accumulated in ACC_T, i.e. float for BFloat16, and
+// converted to grad_input once all the ROIs are done.
 template <typename T, typename ACC_T>
 void roi_align_backward_kernel_impl(
     int n_rois,
+    int batch_size,
     const T* grad_output,
     const ACC_T& spatial_scale,
     int channels,
@@ -579,89 +740,148 @@ void roi_align_backward_kernel_impl(
     T* grad_input,
     const ACC_T* rois,
     bool is_channels_last) {
-  // (n, c, ph, pw) is an element in the pooled output
-  // can be parallelized using omp
-  // at::parallel_for(0, n_rois, 1, [&](int begin, int end) {
+  // the ROIs of each image
+  std::vector<std::vector<int>> image_rois(batch_size);
   for (int n = 0; n < n_rois; n++) {
-    const ACC_T* offset_rois = rois + n * 5;
-    int roi_batch_ind = offset_rois[0];
-
-    // Do not using rounding; this implementation detail is critical
-    ACC_T offset = aligned ? (ACC_T)0.5 : (ACC_T)0.0;
-    ACC_T roi_start_w = offset_rois[1] * spatial_scale - offset;
-    ACC_T roi_start_h = offset_rois[2] * spatial_scale - offset;
-    ACC_T roi_end_w = offset_rois[3] * spatial_scale - offset;
-    ACC_T roi_end_h = offset_rois[4] * spatial_scale - offset;
-
-    ACC_T roi_width = roi_end_w - roi_start_w;
-    ACC_T roi_height = roi_end_h - roi_start_h;
-    if (!aligned) {
-      // Force malformed ROIs to be 1x1
-      roi_width = std::max(roi_width, (ACC_T)1.);
-      roi_height = std::max(roi_height, (ACC_T)1.);
-    }
+    int roi_batch_ind = rois[n * 5];
+    image_rois[roi_batch_ind].push_back(n);
+  }
 
-    ACC_T bin_size_h =
-        static_cast<ACC_T>(roi_height) / static_cast<ACC_T>(pooled_height);
-    ACC_T bin_size_w =
-        static_cast<ACC_T>(roi_width) / static_cast<ACC_T>(pooled_width);
-
-    // We use roi_bin_grid to sample the grid and mimic integral
-    int roi_bin_grid_h = (sampling_ratio > 0)
-        ? sampling_ratio
-        : ceil(roi_height / pooled_height); // e.g., = 2
-    int roi_bin_grid_w =
-        (sampling_ratio > 0) ? sampling_ratio : ceil(roi_width / pooled_width);
-
-    // We do average (integral) pooling inside a bin
-    const ACC_T count = roi_bin_grid_h * roi_bin_grid_w; // e.g. = 4
-
-    // we want to precalculate indices and weights shared by all channels,
-    // this is the key point of optimization
-    std::vector<PreCalc<ACC_T>> pre_calc(
-        roi_bin_grid_h * roi_bin_grid_w * pooled_width * pooled_height);
-    pre_calc_for_bilinear_interpolate(
-        height,
-        width,
-        pooled_height,
-        pooled_width,
-        roi_start_h,
-        roi_start_w,
-        bin_size_h,
-        bin_size_w,
-        roi_bin_grid_h,
-        roi_bin_grid_w,
-        pre_calc);
+  // enough blocks of channels for all the threads, of whole vectors for
+  // channels last
+  int64_t num_threads = at::get_num_threads();
+  int64_t vec_size = is_channels_last ? at::vec::Vectorized<ACC_T>::size() : 1;
+  int64_t block_size = at::divup(channels, at::divup(num_threads, batch_size));
+  block_size =
+      std::min<int64_t>(at::divup(block_size, vec_size) * vec_size, channels);
+  int64_t num_blocks = at::divup(channels, block_size);
+  constexpr bool acc_in_place = std::is_same<T, ACC_T>::value;
+
+  parallel_trace::ParallelRegion region("roi_align_backward");
+  at::parallel_for(
+      0, batch_size * num_blocks, 1, [&](int64_t begin, int64_t end) {
+        IPEX_PARALLEL_CHUNK(region);
+        std::vector<ACC_T> tile;
+        for (int64_t task = begin; task < end; task++) {
+          int b = task / num_blocks;
+          int c_begin = task % num_blocks * block_size;
+          int c_end = std::min<int64_t>(c_begin + block_size, channels);
+          int size = c_end - c_begin;
+          T* offset_grad_input = grad_input + b * channels * height * width;
+
+          // the tile in grad_input if it is in ACC_T, or else in a buffer
+          ACC_T* grad_tile;
+          int64_t ld;
+          if (acc_in_place) {
+            grad_tile = reinterpret_cast<ACC_T*>(offset_grad_input) +
+                (is_channels_last ? c_begin : c_begin * height * width);
+            ld = channels;
+          } else {
+            tile.assign(size * height * width, ACC_T(0));
+            grad_tile = tile.data();
+            ld = size;
+          }
 
-    if (is_channels_last) {
-      roi_align_single_framework_channels_last_backward<T, ACC_T>(
-          grad_output + n * channels * pooled_height * pooled_width,
-          count,
-          channels,
-          height,
-          width,
-          pooled_height,
-          pooled_width,
-          roi_bin_grid_h,
-          roi_bin_grid_w,
-          pre_calc,
-          grad_input + roi_batch_ind * channels * height * width);
-    } else {
-      roi_align_single_framework_backward<T, ACC_T>(
-          grad_output + n * channels * pooled_height * pooled_width,
-          count,
-          channels,
-          height,
-          width,
-          pooled_height,
-          pooled_width,
-          roi_bin_grid_h,
-          roi_bin_grid_w,
-          pre_calc,
-          grad_input + roi_batch_ind * channels * height * width);
-    }
-  } // for n
-  // });
+          for (int n : image_rois[b]) {
+            const ACC_T* offset_rois = rois + n * 5;
+
+            // Do not using rounding; this implementation detail is critical
+            ACC_T offset = aligned ? (ACC_T)0.5 : (ACC_T)0.0;
+            ACC_T roi_start_w = offset_rois[1] * spatial_scale - offset;
+            ACC_T roi_start_h = offset_rois[2] * spatial_scale - offset;
+            ACC_T roi_end_w = offset_rois[3] * spatial_scale - offset;
+            ACC_T roi_end_h = offset_rois[4] * spatial_scale - offset;
+
+            ACC_T roi_width = roi_end_w - roi_start_w;
+            ACC_T roi_height = roi_end_h - roi_start_h;
+            if (!aligned) {
+              // Force malformed ROIs to be 1x1
+              roi_width = std::max(roi_width, (ACC_T)1.);
+              roi_height = std::max(roi_height, (ACC_T)1.);
+            }
+
+            ACC_T bin_size_h = static_cast<ACC_T>(roi_height) /
+                static_cast<ACC_T>(pooled_height);
+            ACC_T bin_size_w = static_cast<ACC_T>(roi_width) /
+                static_cast<ACC_T>(pooled_width);
+
+            // We use roi_bin_grid to sample the grid and mimic integral
+            int roi_bin_grid_h = (sampling_ratio > 0)
+                ? sampling_ratio
+                : ceil(roi_height / pooled_height); // e.g., = 2
+            int roi_bin_grid_w = (sampling_ratio > 0)
+                ? sampling_ratio
+                : ceil(roi_width / pooled_width);
+
+            // We do average (integral) pooling inside a bin
+            const ACC_T count = roi_bin_grid_h * roi_bin_grid_w; // e.g. = 4
+
+            // we want to precalculate indices and weights shared by all
+            // channels, this is the key point of optimization
+            std::vector<PreCalc<ACC_T>> pre_calc(
+                roi_bin_grid_h * roi_bin_grid_w * pooled_width *
+                pooled_height);
+            pre_calc_for_bilinear_interpolate(
+                height,
+                width,
+                pooled_height,
+                pooled_width,
+                roi_start_h,
+                roi_start_w,
+                bin_size_h,
+                bin_size_w,
+                roi_bin_grid_h,
+                roi_bin_grid_w,
+                pre_calc);
+
+            if (is_channels_last) {
+              roi_align_single_framework_channels_last_backward<T, ACC_T>(
+                  grad_output + n * channels * pooled_height * pooled_width,
+                  count,
+                  channels,
+                  c_begin,
+                  c_end,
+                  pooled_height,
+                  pooled_width,
+                  roi_bin_grid_h,
+                  roi_bin_grid_w,
+                  pre_calc,
+                  grad_tile,
+                  ld);
+            } else {
+              roi_align_single_framework_backward<T, ACC_T>(
+                  grad_output + n * channels * pooled_height * pooled_width,
+                  count,
+                  c_begin,
+                  c_end,
+                  height,
+                  width,
+                  pooled_height,
+                  pooled_width,
+                  roi_bin_grid_h,
+                  roi_bin_grid_w,
+                  pre_calc,
+                  grad_tile);
+            }
+          } // for n
+
+          if (!acc_in_place) {
+            if (is_channels_last) {
+              for (int64_t pos = 0; pos < height * width; pos++) {
+                at::vec::convert(
+                    grad_tile + pos * size,
+                    offset_grad_input + pos * channels + c_begin,
+                    size);
+              }
+            } else {
+              at::vec::convert(
+                  grad_tile,
+                  offset_grad_input + c_begin * height * width,
+                  size * height * width);
+            }
+          }
+        }
+      });
 }
 
 at::Tensor roi_align_forward_kernel(
@@ -675,9 +895,8 @@ at::Tensor roi_align_forward_kernel(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::ROIAlign_forward\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("torch_ipex::ROIAlign_forward", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::ROIAlign_forward", std::vector<c10::IValue>({}));
   TORCH_CHECK(input.device().is_cpu(), "input must be a CPU tensor");
   TORCH_CHECK(rois.device().is_cpu(), "rois must be a CPU tensor");
   TORCH_CHECK(rois.size(1) == 5, "rois must have shape as Tensor[K, 5]");
@@ -727,6 +946,88 @@ at::Tensor roi_align_forward_kernel(
   return output;
 }
 
+at::Tensor multilevel_roi_align_forward_kernel(
+    at::TensorList features,
+    const at::Tensor& rois,
+    at::ArrayRef<double> spatial_scales,
+    int64_t pooled_height,
+    int64_t pooled_width,
+    int64_t sampling_ratio,
+    bool aligned,
+    int64_t canonical_scale,
+    int64_t canonical_level) {
+#if defined(IPEX_DISP_OP)
+  printf("torch_ipex::multilevel_roi_align\n");
+#endif
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::multilevel_roi_align", std::vector<c10::IValue>({}));
+  TORCH_CHECK(features.size() > 0, "features must have at least one level");
+  TORCH_CHECK(
+      features.size() == spatial_scales.size(),
+      "features and spatial_scales must have the same number of levels");
+  TORCH_CHECK(rois.device().is_cpu(), "rois must be a CPU tensor");
+  TORCH_CHECK(rois.size(1) == 5, "rois must have shape as Tensor[K, 5]");
+
+  auto num_rois = rois.size(0);
+  auto channels = features[0].size(1);
+  auto memory_format = features[0].suggest_memory_format();
+  bool is_channels_last = memory_format == at::MemoryFormat::ChannelsLast;
+  std::vector<at::Tensor> features_;
+  std::vector<int> heights;
+  std::vector<int> widths;
+  for (const auto& feature : features) {
+    TORCH_CHECK(feature.device().is_cpu(), "features must be CPU tensors");
+    TORCH_CHECK(
+        feature.scalar_type() == features[0].scalar_type() &&
+            feature.size(0) == features[0].size(0) &&
+            feature.size(1) == channels,
+        "features must have the same dtype, batch size and channels");
+    features_.push_back(feature.contiguous(memory_format));
+    heights.push_back(feature.size(2));
+    widths.push_back(feature.size(3));
+  }
+
+  at::Tensor output = at::empty(
+      {num_rois, channels, pooled_height, pooled_width},
+      features[0].options().memory_format(memory_format));
+
+  if (output.numel() == 0)
+    return output;
+
+  auto rois_ = rois.contiguous();
+  AT_DISPATCH_FLOATING_TYPES_AND2(
+      at::ScalarType::Half,
+      at::ScalarType::BFloat16,
+      features[0].scalar_type(),
+      "multilevel_roi_align_forward_kernel",
+      [&] {
+        using accscalar_t = typename AccType<scalar_t>::type;
+        std::vector<const scalar_t*> inputs;
+        for (const auto& feature : features_) {
+          inputs.push_back(feature.data_ptr<scalar_t>());
+        }
+        std::vector<accscalar_t> scales(
+            spatial_scales.begin(), spatial_scales.end());
+        multilevel_roi_align_forward_kernel_impl<scalar_t, accscalar_t>(
+            num_rois,
+            inputs,
+            scales,
+            channels,
+            heights,
+            widths,
+            pooled_height,
+            pooled_width,
+            sampling_ratio,
+            aligned,
+            canonical_scale,
+            canonical_level,
+            rois_.data_ptr<accscalar_t>(),
+            output.data_ptr<scalar_t>(),
+            is_channels_last);
+      });
+  return output;
+}
+
 at::Tensor roi_align_backward_kernel(
     const at::Tensor& grad,
     const at::Tensor& rois,
@@ -742,10 +1043,8 @@ at::Tensor roi_align_backward_kernel(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::ROIAlign_backward\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::ROIAlign_backward", std::vector<c10::IValue>({}));
-#endif
   TORCH_CHECK(grad.device().is_cpu(), "grad must be a CPU tensor");
   TORCH_CHECK(rois.device().is_cpu(), "rois must be a CPU tensor");
 
@@ -778,6 +1077,7 @@ at::Tensor roi_align_backward_kernel(
         using accscalar_t = typename AccType<scalar_t>::type;
         roi_align_backward_kernel_impl<scalar_t, accscalar_t>(
             grad_.size(0),
+            batch_size,
             grad_.data_ptr<scalar_t>(),
             spatial_scale,
             channels,
@@ -802,9 +1102,8 @@ at::Tensor IPEXROIAlignOp::_forward(
     int64_t pooled_width,
     int64_t sampling_ratio,
     bool aligned) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("IPEXROIAlignOp::_forward", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION(
+      "IPEXROIAlignOp::_forward", std::vector<c10::IValue>({}));
   return roi_align_forward_kernel(
       input,
       rois,
@@ -824,9 +1123,7 @@ at::Tensor IPEXROIAlignOp::forward(
     int64_t pooled_width,
     int64_t sampling_ratio,
     bool aligned) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("IPEXROIAlignOp::forward", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("IPEXROIAlignOp::forward", std::vector<c10::IValue>({}));
   ctx->saved_data["input_shape"] = input.sizes();
   ctx->saved_data["spatial_scale"] = spatial_scale;
   ctx->saved_data["pooled_height"] = pooled_height;
@@ -847,9 +1144,8 @@ at::Tensor IPEXROIAlignOp::forward(
 torch::autograd::variable_list IPEXROIAlignOp::backward(
     torch::autograd::AutogradContext* ctx,
     torch::autograd::variable_list grad_outputs) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("IPEXROIAlignOp::backward", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION(
+      "IPEXROIAlignOp::backward", std::vector<c10::IValue>({}));
   auto input_shape = ctx->saved_data["input_shape"].toIntVector();
   auto spatial_scale = ctx->saved_data["spatial_scale"].toDouble();
   auto pooled_height = ctx->saved_data["pooled_height"].toInt();
@@ -926,6 +1222,9 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
   m.def(
       "ROIAlign_forward(Tensor input, Tensor rois, float spatial_scale, int pooled_height, int pooled_width, int sampling_ratio, bool aligned) -> Tensor",
       torch_ipex::cpu::ROIAlign_forward);
+  m.def(
+      "multilevel_roi_align(Tensor[] features, Tensor rois, float[] spatial_scales, int pooled_height, int pooled_width, int sampling_ratio, bool aligned, int canonical_scale=224, int canonical_level=4) -> Tensor",
+      torch_ipex::cpu::multilevel_roi_align_forward_kernel);
 }
 
 } // namespace
@@ -1012,10 +1311,47 @@ at::Tensor ROIAlign_forward(
   }
 }
 
+at::Tensor multilevel_roi_align(
+    at::TensorList features,
+    const at::Tensor& rois,
+    at::ArrayRef<double> spatial_scales,
+    int64_t pooled_height,
+    int64_t pooled_width,
+    int64_t sampling_ratio,
+    bool aligned,
+    int64_t canonical_scale,
+    int64_t canonical_level) {
+  c10::impl::ExcludeDispatchKeyGuard no_autocastCPU(DispatchKey::AutocastCPU);
+  static auto op =
+      torch::Dispatcher::singleton()
+          .findSchemaOrThrow("torch_ipex::multilevel_roi_align", "")
+          .typed<decltype(
+              torch_ipex::cpu::multilevel_roi_align_forward_kernel)>();
+#if defined(ENABLE_AUTOCAST_VERBOSE)
+  verbose::OpNameGuard op_name("multilevel_roi_align");
+#endif
+  auto rois_type = features[0].scalar_type() == at::ScalarType::BFloat16
+      ? at::kFloat
+      : features[0].scalar_type();
+  return op.call(
+      features,
+      cpu_cached_cast(rois_type, rois),
+      spatial_scales,
+      pooled_height,
+      pooled_width,
+      sampling_ratio,
+      aligned,
+      canonical_scale,
+      canonical_level);
+}
+
 IPEX_TORCH_LIBRARY_IMPL(torch_ipex, AutocastCPU, m) {
   m.impl(
       TORCH_SELECTIVE_NAME("torch_ipex::ROIAlign_forward"),
       TORCH_FN((&torch_ipex::autocast::ROIAlign_forward)));
+  m.impl(
+      TORCH_SELECTIVE_NAME("torch_ipex::multilevel_roi_align"),
+      TORCH_FN((&torch_ipex::autocast::multilevel_roi_align)));
 }
 
 } // namespace autocast
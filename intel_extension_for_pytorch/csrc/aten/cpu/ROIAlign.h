@@ -92,14 +92,30 @@ void roi_align_forward_kernel_impl(
     T* output,
     bool is_channels_last);
 
-template <class T>
-inline void add(T* address, const T& val);
+template <typename T, typename ACC_T>
+void multilevel_roi_align_forward_kernel_impl(
+    int n_rois,
+    const std::vector<const T*>& inputs,
+    const std::vector<ACC_T>& spatial_scales,
+    int channels,
+    const std::vector<int>& heights,
+    const std::vector<int>& widths,
+    int pooled_height,
+    int pooled_width,
+    int sampling_ratio,
+    bool aligned,
+    int canonical_scale,
+    int canonical_level,
+    const ACC_T* rois,
+    T* output,
+    bool is_channels_last);
 
 template <typename T, typename ACC_T>
 inline void roi_align_single_framework_backward(
     const T* grad_output,
     const ACC_T count,
-    int channels,
+    int c_begin,
+    int c_end,
     int height,
     int width,
     int pooled_height,
@@ -107,25 +123,27 @@ inline void roi_align_single_framework_backward(
     int roi_bin_grid_h,
     int roi_bin_grid_w,
     const std::vector<PreCalc<ACC_T>>& pre_calc,
-    T* grad_input);
+    ACC_T* grad_input);
 
 template <typename T, typename ACC_T>
 inline void roi_align_single_framework_channels_last_backward(
     const T* grad_output,
     const ACC_T count,
     int channels,
-    int height,
-    int width,
+    int c_begin,
+    int c_end,
     int pooled_height,
     int pooled_width,
     int roi_bin_grid_h,
     int roi_bin_grid_w,
     const std::vector<PreCalc<ACC_T>>& pre_calc,
-    T* grad_input);
+    ACC_T* grad_input,
+    int64_t ld);
 
 template <typename T, typename ACC_T>
 void roi_align_backward_kernel_impl(
     int n_rois,
+    int batch_size,
     const T* grad_output,
     const ACC_T& spatial_scale,
     int channels,
@@ -148,6 +166,17 @@ at::Tensor roi_align_forward_kernel(
     int64_t sampling_ratio,
     bool aligned);
 
+at::Tensor multilevel_roi_align_forward_kernel(
+    at::TensorList features,
+    const at::Tensor& rois,
+    at::ArrayRef<double> spatial_scales,
+    int64_t pooled_height,
+    int64_t pooled_width,
+    int64_t sampling_ratio,
+    bool aligned,
+    int64_t canonical_scale,
+    int64_t canonical_level);
+
 at::Tensor roi_align_backward_kernel(
     const at::Tensor& grad,
     const at::Tensor& rois,
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+#include "csrc/jit/cpu/kernels/OpContext.h"
+
+namespace torch_ipex {
+namespace kernel {
+
+// The helpers of the batched greedy decoder of RNN-T, see UpdateBatch.cpp and
+// RnntEmbedding.cpp for the arguments.
+
+// Returns whether the AVX-512 kernels of vec512 are built in and supported by
+// the running CPU, otherwise the portable kernels of vec512/ref are used.
+bool rnnt_use_avx512_kernels();
+
+// Returns whether all the time steps of the batch have been processed.
+bool rnnt_update_batch(
+    const at::Tensor& k,
+    const at::Tensor& out_lens,
+    at::Tensor label_col,
+    at::Tensor symbols_added,
+    at::Tensor time_idxs,
+    at::Tensor blankness_out,
+    at::Tensor blankvec_out,
+    at::Tensor not_blank_out,
+    at::Tensor label_to_put_out,
+    at::Tensor label_tensor_out,
+    at::Tensor label_for_next_loop_out,
+    at::Tensor hidden_0,
+    at::Tensor hidden_1,
+    const at::Tensor& hidden_prime_0,
+    const at::Tensor& hidden_prime_1,
+    at::Tensor x,
+    at::Tensor f,
+    int64_t max_symbols,
+    int64_t blank_id,
+    int64_t batch_size,
+    int64_t _SOS,
+    int64_t max_len);
+
+void rnnt_embedding(
+    const at::Tensor& embedding_table,
+    const at::Tensor& idx,
+    at::Tensor embedding_out,
+    int64_t _SOS,
+    int64_t batch_size,
+    int64_t embedding_dim);
+
+// Runs the whole loop of the batched greedy decoder, see RnntGreedyDecode.cpp.
+std::tuple<at::Tensor, at::Tensor> rnnt_greedy_decode(
+    const at::Tensor& x,
+    const at::Tensor& out_lens,
+    const at::Tensor& embedding_table,
+    const c10::intrusive_ptr<torch_ipex::cpu::LstmOpContext>& lstm,
+    const at::Tensor& joint_weight1,
+    const at::Tensor& joint_bias1,
+    const at::Tensor& joint_weight2,
+    const at::Tensor& joint_bias2,
+    int64_t max_symbols,
+    int64_t blank_id,
+    int64_t _SOS);
+
+// Runs the beam search decoder on the same networks, see RnntBeamSearch.cpp.
+std::tuple<at::Tensor, at::Tensor> rnnt_beam_search_decode(
+    const at::Tensor& x,
+    const at::Tensor& out_lens,
+    const at::Tensor& embedding_table,
+    const c10::intrusive_ptr<torch_ipex::cpu::LstmOpContext>& lstm,
+    const at::Tensor& joint_weight1,
+    const at::Tensor& joint_bias1,
+    const at::Tensor& joint_weight2,
+    const at::Tensor& joint_bias2,
+    int64_t beam_size,
+    int64_t max_symbols,
+    int64_t blank_id,
+    int64_t _SOS);
+
+} // namespace kernel
+} // namespace torch_ipex
@@ -0,0 +1,521 @@
+#include "Rnnt.h"
+#include "csrc/utils/op_trace.h"
+
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <c10/util/Exception.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace torch_ipex {
+namespace kernel {
+
+namespace {
+
+constexpr uint64_t kPrefixHashInit = 14695981039346656037ULL;
+
+// FNV-1a of the labels of a prefix, extended by one label
+inline uint64_t extend_prefix_hash(uint64_t hash, int64_t label) {
+  return (hash ^ static_cast<uint64_t>(label)) * 1099511628211ULL;
+}
+
+inline float log_add_exp(float a, float b) {
+  float m = std::max(a, b);
+  return m + std::log1p(std::exp(-std::abs(a - b)));
+}
+
+// dst[..., dst_row, :] = src[..., src_row, :] of the contiguous states of
+// [num_layers, rows, hidden_size] or [rows, hidden_size]
+inline void copy_state_row(
+    const at::Tensor& src,
+    int64_t src_row,
+    const at::Tensor& dst,
+    int64_t dst_row) {
+  int64_t outer = src.dim() == 3 ? src.size(0) : 1;
+  int64_t src_rows = src.size(-2);
+  int64_t dst_rows = dst.size(-2);
+  int64_t row_bytes = src.size(-1) * src.element_size();
+  auto src_ptr = static_cast<const char*>(src.data_ptr());
+  auto dst_ptr = static_cast<char*>(dst.data_ptr());
+  for (int64_t o = 0; o < outer; o++) {
+    std::memcpy(
+        dst_ptr + (o * dst_rows + dst_row) * row_bytes,
+        src_ptr + (o * src_rows + src_row) * row_bytes,
+        row_bytes);
+  }
+}
+
+// The hypotheses of the beam search as struct-of-arrays, allocated once
+// before the loop. The prefix hash finds the hypotheses of the same labels to
+// merge before comparing the labels.
+struct RnntHyps {
+  std::vector<float> scores;
+  std::vector<int64_t> lens;
+  std::vector<uint64_t> hashes;
+  // [capacity, max_labels]
+  std::vector<int64_t> labels;
+  int64_t max_labels;
+
+  RnntHyps(int64_t capacity, int64_t max_labels)
+      : scores(capacity),
+        lens(capacity),
+        hashes(capacity),
+        labels(capacity * max_labels),
+        max_labels(max_labels) {}
+
+  int64_t* labels_of(int64_t i) {
+    return labels.data() + i * max_labels;
+  }
+
+  const int64_t* labels_of(int64_t i) const {
+    return labels.data() + i * max_labels;
+  }
+
+  void copy_from(int64_t dst, const RnntHyps& src, int64_t i) {
+    scores[dst] = src.scores[i];
+    lens[dst] = src.lens[i];
+    hashes[dst] = src.hashes[i];
+    std::memcpy(
+        labels_of(dst), src.labels_of(i), src.lens[i] * sizeof(int64_t));
+  }
+
+  bool same_labels(int64_t i, const RnntHyps& other, int64_t j) const {
+    return hashes[i] == other.hashes[j] && lens[i] == other.lens[j] &&
+        std::equal(labels_of(i), labels_of(i) + lens[i], other.labels_of(j));
+  }
+};
+
+struct RnntCandidate {
+  float score;
+  // the index of the hypothesis to extend
+  int64_t parent;
+  int64_t label;
+};
+
+inline bool better_candidate(const RnntCandidate& a, const RnntCandidate& b) {
+  if (a.score != b.score) {
+    return a.score > b.score;
+  }
+  return a.parent != b.parent ? a.parent < b.parent : a.label < b.label;
+}
+
+/*
+  The hypotheses of all the samples of the batch, of which
+
+  - hyps are the hypotheses at the current time step, [offsets[b],
+    offsets[b + 1]) of sample b, with the states of the prediction network g,
+    h and c;
+  - final_hyps are the at most beam_size hypotheses of each sample ending at
+    the current time step, i.e. the ones having emitted the blank, in the
+    slots [b * beam_size, b * beam_size + final_counts[b]), with the states
+    final_g, final_h and final_c.
+*/
+class RnntBeams {
+ public:
+  RnntBeams(
+      int64_t batch_size,
+      int64_t beam_size,
+      int64_t max_labels,
+      int64_t topk,
+      const at::Tensor& g0,
+      const at::Tensor& h0,
+      const at::Tensor& c0)
+      : batch_size_(batch_size),
+        beam_size_(beam_size),
+        topk_(topk),
+        hyps_(batch_size * beam_size, max_labels),
+        next_hyps_(batch_size * beam_size, max_labels),
+        final_hyps_(batch_size * beam_size, max_labels),
+        offsets_(batch_size + 1, 0),
+        final_counts_(batch_size, 1),
+        candidates_(batch_size * beam_size * topk),
+        candidate_counts_(batch_size) {
+    int64_t capacity = batch_size * beam_size;
+    auto long_options = at::TensorOptions().dtype(at::kLong);
+    parents_ = at::empty({capacity}, long_options);
+    labels_ = at::empty({capacity}, long_options);
+    samples_ = at::empty({capacity}, long_options);
+    auto state_sizes = h0.sizes().vec();
+    state_sizes[1] = capacity;
+    final_g_ = at::empty({capacity, g0.size(1)}, g0.options());
+    final_h_ = at::empty(state_sizes, h0.options());
+    final_c_ = at::empty(state_sizes, c0.options());
+    // every sample starts from the empty hypothesis of the state of _SOS
+    for (int64_t b = 0; b < batch_size; b++) {
+      auto slot = b * beam_size;
+      final_hyps_.scores[slot] = 0;
+      final_hyps_.lens[slot] = 0;
+      final_hyps_.hashes[slot] = kPrefixHashInit;
+      copy_state_row(g0, b, final_g_, slot);
+      copy_state_row(h0, b, final_h_, slot);
+      copy_state_row(c0, b, final_c_, slot);
+    }
+  }
+
+  int64_t num_hyps() const {
+    return offsets_[batch_size_];
+  }
+
+  const at::Tensor& g() const {
+    return g_;
+  }
+
+  // the sample of each hypothesis of the current time step
+  at::Tensor samples() const {
+    return samples_.narrow(0, 0, num_hyps());
+  }
+
+  // Starts time step t by the final hypotheses of the samples of which
+  // out_lens[b] > t.
+  void start_time_step(const int32_t* out_lens_ptr, int64_t t) {
+    auto samples_ptr = samples_.data_ptr<int64_t>();
+    auto parents_ptr = parents_.data_ptr<int64_t>();
+    int64_t n = 0;
+    for (int64_t b = 0; b < batch_size_; b++) {
+      offsets_[b] = n;
+      if (out_lens_ptr[b] <= t) {
+        continue;
+      }
+      for (int64_t j = 0; j < final_counts_[b]; j++) {
+        auto slot = b * beam_size_ + j;
+        hyps_.copy_from(n, final_hyps_, slot);
+        samples_ptr[n] = b;
+        parents_ptr[n] = slot;
+        n++;
+      }
+      final_counts_[b] = 0;
+    }
+    offsets_[batch_size_] = n;
+    auto slots = parents_.narrow(0, 0, n);
+    g_ = final_g_.index_select(0, slots);
+    h_ = final_h_.index_select(1, slots);
+    c_ = final_c_.index_select(1, slots);
+  }
+
+  // The hypotheses having emitted max_symbols labels at the time step go to
+  // the next time step without the blank.
+  void finish_time_step() {
+    at::parallel_for(0, batch_size_, 1, [&](int64_t start, int64_t end) {
+      for (int64_t b = start; b < end; b++) {
+        for (int64_t i = offsets_[b]; i < offsets_[b + 1]; i++) {
+          push_final(b, i, hyps_.scores[i]);
+        }
+      }
+    });
+    std::fill(offsets_.begin(), offsets_.end(), 0);
+  }
+
+  // Extends the hypotheses of the current time step by the log probabilities
+  // logp [num_hyps, vocab_size] of the joint network, of which topk_values
+  // and topk_labels are the top-k of each hypothesis. The blank moves a
+  // hypothesis to the final ones, the top beam_size other extensions better
+  // than the worst final hypothesis stay at the time step. Returns the
+  // hypotheses to run the prediction network, as the indices of the parents
+  // and the labels.
+  std::tuple<at::Tensor, at::Tensor> extend(
+      const at::Tensor& logp,
+      const at::Tensor& topk_values,
+      const at::Tensor& topk_labels,
+      int64_t blank_id) {
+    auto vocab_size = logp.size(1);
+    auto logp_ptr = logp.data_ptr<float>();
+    auto topk_values_ptr = topk_values.data_ptr<float>();
+    auto topk_labels_ptr = topk_labels.data_ptr<int64_t>();
+    at::parallel_for(0, batch_size_, 1, [&](int64_t start, int64_t end) {
+      for (int64_t b = start; b < end; b++) {
+        auto candidates = candidates_.data() + b * beam_size_ * topk_;
+        int64_t num_candidates = 0;
+        for (int64_t i = offsets_[b]; i < offsets_[b + 1]; i++) {
+          auto score = hyps_.scores[i];
+          push_final(b, i, score + logp_ptr[i * vocab_size + blank_id]);
+          for (int64_t j = i * topk_; j < (i + 1) * topk_; j++) {
+            if (topk_labels_ptr[j] != blank_id) {
+              candidates[num_candidates++] = {
+                  score + topk_values_ptr[j], i, topk_labels_ptr[j]};
+            }
+          }
+        }
+        auto num_keep = std::min(num_candidates, beam_size_);
+        std::partial_sort(
+            candidates,
+            candidates + num_keep,
+            candidates + num_candidates,
+            better_candidate);
+        auto threshold = min_final_score(b);
+        while (num_keep > 0 && candidates[num_keep - 1].score <= threshold) {
+          num_keep--;
+        }
+        candidate_counts_[b] = num_keep;
+      }
+    });
+
+    int64_t n = 0;
+    for (int64_t b = 0; b < batch_size_; b++) {
+      offsets_[b] = n;
+      n += candidate_counts_[b];
+    }
+    offsets_[batch_size_] = n;
+    auto samples_ptr = samples_.data_ptr<int64_t>();
+    auto parents_ptr = parents_.data_ptr<int64_t>();
+    auto labels_ptr = labels_.data_ptr<int64_t>();
+    at::parallel_for(0, batch_size_, 1, [&](int64_t start, int64_t end) {
+      for (int64_t b = start; b < end; b++) {
+        auto candidates = candidates_.data() + b * beam_size_ * topk_;
+        for (int64_t j = 0; j < candidate_counts_[b]; j++) {
+          auto i = offsets_[b] + j;
+          auto& candidate = candidates[j];
+          next_hyps_.copy_from(i, hyps_, candidate.parent);
+          next_hyps_.labels_of(i)[next_hyps_.lens[i]++] = candidate.label;
+          next_hyps_.hashes[i] =
+              extend_prefix_hash(next_hyps_.hashes[i], candidate.label);
+          next_hyps_.scores[i] = candidate.score;
+          samples_ptr[i] = b;
+          parents_ptr[i] = candidate.parent;
+          labels_ptr[i] = candidate.label;
+        }
+      }
+    });
+    std::swap(hyps_, next_hyps_);
+    return std::make_tuple(parents_.narrow(0, 0, n), labels_.narrow(0, 0, n));
+  }
+
+  // The hidden states of the parents to run the prediction network.
+  std::vector<at::Tensor> parent_states(const at::Tensor& parents) const {
+    return {h_.index_select(1, parents), c_.index_select(1, parents)};
+  }
+
+  void set_states(at::Tensor g, at::Tensor h, at::Tensor c) {
+    g_ = g.contiguous();
+    h_ = h.contiguous();
+    c_ = c.contiguous();
+  }
+
+  // Writes the labels of the best final hypothesis of each sample to
+  // label_tensor[b, 1 : label_col[b] + 1].
+  void write_best(at::Tensor& label_tensor, at::Tensor& label_col) const {
+    auto label_tensor_ptr = label_tensor.data_ptr<int64_t>();
+    auto label_col_ptr = label_col.data_ptr<int32_t>();
+    auto row_stride = label_tensor.stride(0);
+    for (int64_t b = 0; b < batch_size_; b++) {
+      auto begin = b * beam_size_;
+      auto best = begin;
+      for (int64_t j = begin + 1; j < begin + final_counts_[b]; j++) {
+        if (final_hyps_.scores[j] > final_hyps_.scores[best]) {
+          best = j;
+        }
+      }
+      std::memcpy(
+          label_tensor_ptr + b * row_stride + 1,
+          final_hyps_.labels_of(best),
+          final_hyps_.lens[best] * sizeof(int64_t));
+      label_col_ptr[b] = final_hyps_.lens[best];
+    }
+  }
+
+ private:
+  float min_final_score(int64_t b) const {
+    if (final_counts_[b] < beam_size_) {
+      return -std::numeric_limits<float>::infinity();
+    }
+    auto begin = final_hyps_.scores.begin() + b * beam_size_;
+    return *std::min_element(begin, begin + beam_size_);
+  }
+
+  // Adds the hypothesis i of the current time step with score to the final
+  // hypotheses of sample b, merged with the one of the same labels if any,
+  // otherwise replacing the worst one if there are beam_size of them.
+  void push_final(int64_t b, int64_t i, float score) {
+    auto begin = b * beam_size_;
+    auto end = begin + final_counts_[b];
+    auto worst = begin;
+    for (int64_t j = begin; j < end; j++) {
+      if (final_hyps_.same_labels(j, hyps_, i)) {
+        final_hyps_.scores[j] = log_add_exp(final_hyps_.scores[j], score);
+        return;
+      }
+      if (final_hyps_.scores[j] < final_hyps_.scores[worst]) {
+        worst = j;
+      }
+    }
+    int64_t slot;
+    if (final_counts_[b] < beam_size_) {
+      slot = end;
+      final_counts_[b]++;
+    } else if (score > final_hyps_.scores[worst]) {
+      slot = worst;
+    } else {
+      return;
+    }
+    final_hyps_.copy_from(slot, hyps_, i);
+    final_hyps_.scores[slot] = score;
+    copy_state_row(g_, i, final_g_, slot);
+    copy_state_row(h_, i, final_h_, slot);
+    copy_state_row(c_, i, final_c_, slot);
+  }
+
+  int64_t batch_size_;
+  int64_t beam_size_;
+  int64_t topk_;
+  RnntHyps hyps_;
+  RnntHyps next_hyps_;
+  RnntHyps final_hyps_;
+  std::vector<int64_t> offsets_;
+  std::vector<int64_t> final_counts_;
+  std::vector<RnntCandidate> candidates_;
+  std::vector<int64_t> candidate_counts_;
+  at::Tensor parents_;
+  at::Tensor labels_;
+  at::Tensor samples_;
+  at::Tensor g_;
+  at::Tensor h_;
+  at::Tensor c_;
+  at::Tensor final_g_;
+  at::Tensor final_h_;
+  at::Tensor final_c_;
+};
+
+} // namespace
+
+/*
+  ipex::rnnt_beam_search_decode: the beam search decoder of RNN-T, of which
+  the whole loop runs in C++ for all the samples of the batch at once:
+
+  for t in range(max_len):
+      hyps, final_hyps = final_hyps, []
+      for s in range(max_symbols):
+          logp = joint_step(f[t], g(hyps)).log_softmax(-1)
+          final_hyps += hyps extended by the blank, merged by the labels
+          hyps = the top beam_size of hyps extended by the other labels,
+                 better than the worst of the beam_size final_hyps
+          g(hyps), hidden(hyps) = pred_step(label(hyps), hidden(parent))
+      final_hyps += hyps
+
+  The hypotheses of all the samples run the joint and the prediction
+  networks in one batch. The selection of each sample runs in parallel on
+  the OMP threads, from the top-(beam_size + 1) labels of each hypothesis.
+  The arguments are the ones of rnnt_greedy_decode, and beam_size is the
+  number of hypotheses kept for each sample.
+
+  Returns the labels of the best hypothesis of each sample, in the layout of
+  rnnt_greedy_decode, i.e. label_tensor[i, 1 : label_col[i] + 1].
+*/
+std::tuple<at::Tensor, at::Tensor> rnnt_beam_search_decode(
+    const at::Tensor& x,
+    const at::Tensor& out_lens,
+    const at::Tensor& embedding_table,
+    const c10::intrusive_ptr<torch_ipex::cpu::LstmOpContext>& lstm,
+    const at::Tensor& joint_weight1,
+    const at::Tensor& joint_bias1,
+    const at::Tensor& joint_weight2,
+    const at::Tensor& joint_bias2,
+    int64_t beam_size,
+    int64_t max_symbols,
+    int64_t blank_id,
+    int64_t _SOS) {
+#if defined(IPEX_DISP_OP)
+  printf("IPEX::rnnt_beam_search_decode\n");
+#endif
+  IPEX_RECORD_FUNCTION(
+      "IPEX::rnnt_beam_search_decode", std::vector<c10::IValue>({}));
+  TORCH_CHECK(
+      x.dim() == 3, "rnnt_beam_search_decode expects the 3-D encoder feature");
+  TORCH_CHECK(
+      out_lens.scalar_type() == at::kInt && out_lens.numel() == x.size(0),
+      "rnnt_beam_search_decode expects the int32 out_lens of each sample");
+  TORCH_CHECK(
+      beam_size > 0 && max_symbols > 0,
+      "rnnt_beam_search_decode expects positive beam_size and max_symbols");
+  int64_t batch_size = x.size(0);
+  int64_t enc_n_hidden = x.size(2);
+  int64_t embedding_dim = embedding_table.size(1);
+  int64_t vocab_size = joint_weight2.size(0);
+  auto out_lens_ = out_lens.contiguous();
+  int64_t max_len = out_lens_.max().item<int64_t>();
+  auto long_options = out_lens.options().dtype(at::kLong);
+  auto label_tensor =
+      at::full({batch_size, max_len * max_symbols + 1}, _SOS, long_options);
+  auto label_col = at::zeros({batch_size}, out_lens.options());
+  if (max_len <= 0) {
+    return std::make_tuple(label_tensor, label_col);
+  }
+
+  // The encoder part of the first joint linear of all the time steps.
+  auto joint_weight_f = joint_weight1.narrow(1, 0, enc_n_hidden);
+  auto joint_weight_g = joint_weight1.narrow(
+      1, enc_n_hidden, joint_weight1.size(1) - enc_n_hidden);
+  auto x_proj = at::linear(x, joint_weight_f, joint_bias1);
+
+  // the prediction of _SOS, of which the embedding is zero
+  auto capacity = batch_size * beam_size;
+  auto embedding = at::zeros({capacity, 1, embedding_dim}, x.options());
+  auto run_prediction = [&](const at::Tensor& input,
+                            const std::vector<at::Tensor>& hidden) {
+    at::Tensor g, h, c;
+    std::tie(g, h, c) = lstm->run(
+        lstm->get_batch_first() ? input : input.transpose(0, 1), hidden);
+    return std::make_tuple(g.select(lstm->get_batch_first() ? 1 : 0, 0), h, c);
+  };
+  auto hidden_sizes = lstm->get_hidden_state_sizes(batch_size);
+  at::Tensor g0, h0, c0;
+  std::tie(g0, h0, c0) = run_prediction(
+      embedding.narrow(0, 0, batch_size),
+      {at::zeros(hidden_sizes, x.options()),
+       at::zeros(hidden_sizes, x.options())});
+
+  // the top-k of each hypothesis has beam_size labels other than the blank
+  auto topk = std::min(beam_size + 1, vocab_size);
+  RnntBeams beams(
+      batch_size,
+      beam_size,
+      max_len * max_symbols,
+      topk,
+      g0.contiguous(),
+      h0.contiguous(),
+      c0.contiguous());
+  auto out_lens_ptr = out_lens_.data_ptr<int32_t>();
+  for (int64_t t = 0; t < max_len; t++) {
+    beams.start_time_step(out_lens_ptr, t);
+    auto f = x_proj.select(1, t);
+    for (int64_t s = 0; s < max_symbols && beams.num_hyps() > 0; s++) {
+      auto joint_hidden =
+          at::addmm(
+              f.index_select(0, beams.samples()),
+              beams.g(),
+              joint_weight_g.t())
+              .relu_();
+      auto logp = at::log_softmax(
+          at::addmm(joint_bias2, joint_hidden, joint_weight2.t()),
+          1,
+          at::kFloat);
+      at::Tensor topk_values, topk_labels;
+      std::tie(topk_values, topk_labels) = at::topk(logp, topk, 1);
+      at::Tensor parents, labels;
+      std::tie(parents, labels) = beams.extend(
+          logp.contiguous(),
+          topk_values.contiguous(),
+          topk_labels.contiguous(),
+          blank_id);
+      if (beams.num_hyps() == 0) {
+        break;
+      }
+      auto n = beams.num_hyps();
+      auto hyps_embedding = embedding.narrow(0, 0, n);
+      rnnt_embedding(
+          embedding_table, labels, hyps_embedding, _SOS, n, embedding_dim);
+      at::Tensor g, h, c;
+      std::tie(g, h, c) =
+          run_prediction(hyps_embedding, beams.parent_states(parents));
+      beams.set_states(g, h, c);
+    }
+    beams.finish_time_step();
+  }
+  beams.write_best(label_tensor, label_col);
+  return std::make_tuple(label_tensor, label_col);
+}
+
+} // namespace kernel
+} // namespace torch_ipex
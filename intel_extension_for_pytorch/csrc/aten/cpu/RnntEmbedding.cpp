@@ -1,3 +1,5 @@
+#include "Rnnt.h"
+
 #include <ATen/Parallel.h>
 #include <ATen/Tensor.h>
 #include <c10/util/Exception.h>
@@ -7,7 +9,10 @@
 #include <torch/csrc/autograd/variable.h>
 #include <torch/script.h>
 
+#include <cstring>
+
 #include "csrc/cpu/vec512/bf16/vec/bf16_vec_kernel.h"
+#include "csrc/utils/op_trace.h"
 
 namespace torch_ipex {
 namespace kernel {
@@ -24,6 +29,8 @@ inline void rnnt_embedding_kernel_impl(
   auto* embedding_out_ptr = embedding_out.data_ptr<T>();
 
   int64_t* idx_ptr = static_cast<int64_t*>(idx.data_ptr());
+  // memcpy picks the widest copy of the running CPU without AVX-512
+  bool use_avx512 = rnnt_use_avx512_kernels();
 
   at::parallel_for(0, batch_size, 16, [&](int64_t start, int64_t end) {
     for (int i = start; i < end; i++) {
@@ -33,10 +40,17 @@ inline void rnnt_embedding_kernel_impl(
       }
       int64_t in_pos = embed_idx * embedding_dim;
       int64_t out_pos = i * embedding_dim;
-      move_ker(
-          &embedding_out_ptr[out_pos],
-          &embedding_table_ptr[in_pos],
-          embedding_dim);
+      if (use_avx512) {
+        move_ker(
+            &embedding_out_ptr[out_pos],
+            &embedding_table_ptr[in_pos],
+            embedding_dim);
+      } else {
+        std::memcpy(
+            &embedding_out_ptr[out_pos],
+            &embedding_table_ptr[in_pos],
+            embedding_dim * sizeof(T));
+      }
     }
   });
 }
@@ -75,7 +89,7 @@ inline void rnnt_embedding_kernel(
   batch_size: equals to idx.shape[0]
   embedding_dim: equals to embedding_table.weight.shape[1]
 */
-static void rnnt_embedding(
+void rnnt_embedding(
     const at::Tensor& embedding_table,
     const at::Tensor& idx,
     at::Tensor embedding_out,
@@ -85,9 +99,7 @@ static void rnnt_embedding(
 #if defined(IPEX_DISP_OP)
   printf("IPEX::rnnt_embedding\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("IPEX::rnnt_embedding", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("IPEX::rnnt_embedding", std::vector<c10::IValue>({}));
   rnnt_embedding_kernel(
       embedding_table, idx, embedding_out, _SOS, batch_size, embedding_dim);
 }
@@ -0,0 +1,164 @@
+#include "Rnnt.h"
+#include "csrc/utils/op_trace.h"
+
+#include <ATen/ATen.h>
+#include <c10/util/Exception.h>
+
+namespace torch_ipex {
+namespace kernel {
+
+/*
+  ipex::rnnt_greedy_decode: the batched greedy decoder of RNN-T, of which
+  the whole loop runs in C++ on the buffers allocated once before the loop:
+
+  while True:
+      g, hidden_prime = pred_step(label_for_next_loop, hidden)
+      k = joint_step(f, g).argmax(1)
+      if rnnt_update_batch(k, ..., hidden, hidden_prime, x, f, ...):
+          break
+
+  The prediction step looks up the embedding of the labels by rnnt_embedding
+  and runs one step of the prepacked LSTM, i.e. the fused LSTM cell for a
+  small batch. The joint network is
+    linear(relu(linear(cat([f, g], -1), joint_weight1, joint_bias1)),
+           joint_weight2, joint_bias2),
+  of which the part of the encoder feature of joint_weight1 is applied to all
+  the time steps of x once before the loop.
+
+  x: the feature from the encoder, [batch_size, time_step, enc_n_hidden],
+  f32 or bf16
+  out_lens: valid time step of the encoded feature, [batch_size], torch.int32
+  embedding_table: the embedding of the labels, [vocab_size - 1, pred_n_embed]
+  lstm: the prepacked LSTM of the prediction network
+  joint_weight1: [joint_n_hidden, enc_n_hidden + pred_n_hidden]
+  joint_bias1: [joint_n_hidden]
+  joint_weight2: [vocab_size, joint_n_hidden]
+  joint_bias2: [vocab_size]
+  max_symbols: the max symbols to generate per time step
+  blank_id: id for blank symbol
+  _SOS: the mark of the Start Of Sequence
+
+  Returns the label tensor [batch_size, max_len * max_symbols + 1],
+  torch.int64, and the label col [batch_size], torch.int32, the labels of
+  sample i are label_tensor[i, 1 : label_col[i] + 1].
+*/
+std::tuple<at::Tensor, at::Tensor> rnnt_greedy_decode(
+    const at::Tensor& x,
+    const at::Tensor& out_lens,
+    const at::Tensor& embedding_table,
+    const c10::intrusive_ptr<torch_ipex::cpu::LstmOpContext>& lstm,
+    const at::Tensor& joint_weight1,
+    const at::Tensor& joint_bias1,
+    const at::Tensor& joint_weight2,
+    const at::Tensor& joint_bias2,
+    int64_t max_symbols,
+    int64_t blank_id,
+    int64_t _SOS) {
+#if defined(IPEX_DISP_OP)
+  printf("IPEX::rnnt_greedy_decode\n");
+#endif
+  IPEX_RECORD_FUNCTION(
+      "IPEX::rnnt_greedy_decode", std::vector<c10::IValue>({}));
+  TORCH_CHECK(
+      x.dim() == 3, "rnnt_greedy_decode expects the 3-D encoder feature");
+  TORCH_CHECK(
+      out_lens.scalar_type() == at::kInt && out_lens.numel() == x.size(0),
+      "rnnt_greedy_decode expects the int32 out_lens of each sample");
+  int64_t batch_size = x.size(0);
+  int64_t enc_n_hidden = x.size(2);
+  int64_t embedding_dim = embedding_table.size(1);
+  int64_t max_len = out_lens.max().item<int64_t>();
+  auto int_options = out_lens.options();
+  auto long_options = int_options.dtype(at::kLong);
+
+  // The encoder part of the first joint linear of all the time steps, laid
+  // out as [time_step, batch_size, joint_n_hidden] in memory as
+  // rnnt_update_batch expects. f is the feature of the current time step of
+  // each sample.
+  auto joint_weight_f = joint_weight1.narrow(1, 0, enc_n_hidden);
+  auto joint_weight_g = joint_weight1.narrow(
+      1, enc_n_hidden, joint_weight1.size(1) - enc_n_hidden);
+  auto x_proj =
+      at::linear(x.transpose(0, 1), joint_weight_f, joint_bias1).contiguous();
+  auto x_joint = x_proj.transpose(0, 1);
+  auto f = x_joint.narrow(1, 0, 1).clone(at::MemoryFormat::Contiguous);
+
+  // the batch status of rnnt_update_batch
+  auto label_col = at::zeros({batch_size}, int_options);
+  auto symbols_added = at::zeros({batch_size}, int_options);
+  auto time_idxs = at::zeros({batch_size}, int_options);
+  auto blankness = at::zeros({batch_size}, int_options);
+  auto blankvec = at::zeros({batch_size}, int_options);
+  auto not_blank = at::zeros({batch_size}, int_options);
+  auto label_to_put = at::zeros({batch_size}, long_options);
+  auto label_tensor =
+      at::full({batch_size, max_len * max_symbols + 1}, _SOS, long_options);
+  auto label_for_next_loop = at::full({batch_size}, _SOS, long_options);
+
+  // the buffers of the prediction and joint steps
+  auto hidden_sizes = lstm->get_hidden_state_sizes(batch_size);
+  auto hidden_0 = at::zeros(hidden_sizes, x.options());
+  auto hidden_1 = at::zeros(hidden_sizes, x.options());
+  auto embedding = at::empty({batch_size, 1, embedding_dim}, x.options());
+  auto lstm_input =
+      lstm->get_batch_first() ? embedding : embedding.transpose(0, 1);
+  auto joint_hidden =
+      at::empty({batch_size, joint_weight1.size(0)}, x.options());
+  auto logits = at::empty({batch_size, joint_weight2.size(0)}, x.options());
+  auto k = at::empty({batch_size}, long_options);
+
+  if (max_len == 0) {
+    return std::make_tuple(label_tensor, label_col);
+  }
+  while (true) {
+    // the embedding of _SOS is zero
+    embedding.zero_();
+    rnnt_embedding(
+        embedding_table,
+        label_for_next_loop,
+        embedding,
+        _SOS,
+        batch_size,
+        embedding_dim);
+    at::Tensor g, hidden_prime_0, hidden_prime_1;
+    std::tie(g, hidden_prime_0, hidden_prime_1) =
+        lstm->run(lstm_input, {hidden_0, hidden_1});
+    g = g.select(lstm->get_batch_first() ? 1 : 0, 0);
+
+    at::addmm_out(joint_hidden, f.squeeze(1), g, joint_weight_g.t());
+    joint_hidden.relu_();
+    at::addmm_out(logits, joint_bias2, joint_hidden, joint_weight2.t());
+    at::argmax_out(k, logits, 1);
+
+    bool finished = rnnt_update_batch(
+        k,
+        out_lens,
+        label_col,
+        symbols_added,
+        time_idxs,
+        blankness,
+        blankvec,
+        not_blank,
+        label_to_put,
+        label_tensor,
+        label_for_next_loop,
+        hidden_0,
+        hidden_1,
+        hidden_prime_0,
+        hidden_prime_1,
+        x_joint,
+        f,
+        max_symbols,
+        blank_id,
+        batch_size,
+        _SOS,
+        max_len);
+    if (finished) {
+      break;
+    }
+  }
+  return std::make_tuple(label_tensor, label_col);
+}
+
+} // namespace kernel
+} // namespace torch_ipex
@@ -0,0 +1,52 @@
+#include "SmallGemm.h"
+
+#include "csrc/utils/fast_path_stats.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+IPEX_DEFINE_DISPATCH(batched_small_gemm_kernel_stub);
+
+enum SmallGemmFallback {
+  kUnsupportedDtype,
+  kShapeMismatch,
+  kNotContiguous,
+  kLargeMatrix,
+};
+
+static fast_path::FastPathCounter small_gemm_counter(
+    "batched_small_gemm",
+    {"unsupported_dtype", "shape_mismatch", "not_contiguous", "large_matrix"});
+
+bool is_batched_small_gemm(
+    const at::Tensor& a,
+    const at::Tensor& b,
+    const at::Tensor& out) {
+  if (a.scalar_type() != at::kFloat || b.scalar_type() != at::kFloat ||
+      out.scalar_type() != at::kFloat) {
+    return small_gemm_counter.fallback(kUnsupportedDtype);
+  }
+  int64_t dim = a.dim();
+  // the mismatched shapes, e.g. of the broadcast batch dims, are left to
+  // oneDNN
+  if (dim < 3 || b.dim() != dim || out.dim() != dim ||
+      a.sizes().slice(0, dim - 2) != b.sizes().slice(0, dim - 2) ||
+      out.sizes().slice(0, dim - 2) != a.sizes().slice(0, dim - 2) ||
+      b.size(-2) != a.size(-1) || out.size(-2) != a.size(-2) ||
+      out.size(-1) != b.size(-1)) {
+    return small_gemm_counter.fallback(kShapeMismatch);
+  }
+  if (!a.is_contiguous() || !b.is_contiguous() || !out.is_contiguous()) {
+    return small_gemm_counter.fallback(kNotContiguous);
+  }
+  int64_t m = a.size(-2);
+  int64_t k = a.size(-1);
+  int64_t n = b.size(-1);
+  if (m > kSmallGemmMaxDim || n > kSmallGemmMaxDim || k > kSmallGemmMaxDim) {
+    return small_gemm_counter.fallback(kLargeMatrix);
+  }
+  return small_gemm_counter.hit();
+}
+
+} // namespace cpu
+} // namespace torch_ipex
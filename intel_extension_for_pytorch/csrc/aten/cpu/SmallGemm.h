@@ -0,0 +1,33 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+#include "csrc/cpu/dispatch/DispatchStub.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+// The largest M, N and K of the matrices of the batched small GEMM, e.g. of
+// the scores and the context of the attention of the short sequences, below
+// which running a matrix on a thread beats the oneDNN matmul primitive, of
+// which the overhead and the parallelism within a matrix dominate
+constexpr int64_t kSmallGemmMaxDim = 128;
+
+// Whether out = a x b runs on the batched small GEMM: a [..., M, K], b
+// [..., K, N] and out [..., M, N] of float are contiguous and of the same
+// batch dims, and M, N and K are at most kSmallGemmMaxDim.
+bool is_batched_small_gemm(
+    const at::Tensor& a,
+    const at::Tensor& b,
+    const at::Tensor& out);
+
+// out[i] = scale * a[i] x b[i] of each matrix i of the batch, of which the
+// matrices run in parallel, each on a thread
+using batched_small_gemm_kernel_fn =
+    void (*)(const at::Tensor&, const at::Tensor&, at::Tensor&, float);
+IPEX_DECLARE_DISPATCH(
+    batched_small_gemm_kernel_fn,
+    batched_small_gemm_kernel_stub);
+
+} // namespace cpu
+} // namespace torch_ipex
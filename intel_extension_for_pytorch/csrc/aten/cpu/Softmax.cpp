@@ -1,5 +1,11 @@
 #include "Softmax.h"
 #include "csrc/cpu/ideep/IDeepConversions.h"
+#include "csrc/cpu/isa/cpu_info.hpp"
+#include "utils/op_thread_policy.h"
+
+#if defined(CPU_AVX512)
+#include "csrc/cpu/vec512/add_softmax.h"
+#endif
 
 namespace torch_ipex {
 namespace cpu {
@@ -8,9 +14,24 @@ namespace cpu {
 at::Tensor softmax_impl(const at::Tensor& input, const int64_t dim) {
   const int64_t wrapped_dim = at::maybe_wrap_dim(dim, input.dim());
   auto input_ = input.is_contiguous() ? input : input.contiguous();
+#if defined(CPU_AVX512)
+  // the rows long enough to be memory bound are read twice by the online
+  // softmax instead of three times
+  if (wrapped_dim == input_.dim() - 1 &&
+      input_.size(wrapped_dim) >= cpu_tuning().online_softmax_min_size) {
+    if (input_.scalar_type() == at::kFloat) {
+      return torch_ipex::cpu::kernel::vec::vec512::dil_online_softmax<float>(
+          input_);
+    } else if (input_.scalar_type() == at::kBFloat16) {
+      return torch_ipex::cpu::kernel::vec::vec512::dil_online_softmax<
+          at::BFloat16>(input_);
+    }
+  }
+#endif
   ideep::tensor mkldnn_input = itensor_view_from_dense(input_);
   auto output = at::empty_like(input_);
   ideep::tensor mkldnn_output = itensor_view_from_dense(output);
+  OpThreadGuard op_thread_guard(ThreadPolicyOp::Softmax, input_.numel());
   ideep::softmax_forward::compute(mkldnn_input, mkldnn_output, wrapped_dim);
   return output;
 }
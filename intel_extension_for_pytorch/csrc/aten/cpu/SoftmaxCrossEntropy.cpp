@@ -0,0 +1,242 @@
+#include "SoftmaxCrossEntropy.h"
+#include <ATen/Parallel.h>
+#include <torch/extension.h>
+
+#if defined(CPU_AVX512)
+#include "csrc/cpu/vec512/add_softmax.h"
+#include "csrc/utils/op_trace.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+// the [M, C] logits of float or bfloat16 and the [M] class indices
+bool can_use_fused_kernel(const at::Tensor& input, const at::Tensor& target) {
+  return input.dim() == 2 && target.dim() == 1 &&
+      target.size(0) == input.size(0) && input.size(1) > 0 &&
+      target.scalar_type() == at::kLong &&
+      (input.scalar_type() == at::kFloat ||
+       input.scalar_type() == at::kBFloat16);
+}
+
+#if defined(CPU_AVX512)
+template <typename scalar_t>
+void softmax_cross_entropy_forward_kernel(
+    const at::Tensor& input,
+    const at::Tensor& target,
+    int64_t ignore_index,
+    at::Tensor& lse,
+    at::Tensor& losses) {
+  int64_t M = input.size(0);
+  int64_t C = input.size(1);
+  const scalar_t* input_data = input.data_ptr<scalar_t>();
+  const int64_t* target_data = target.data_ptr<int64_t>();
+  float* lse_data = lse.data_ptr<float>();
+  float* losses_data = losses.data_ptr<float>();
+  int64_t grain_size =
+      std::max<int64_t>(1, at::internal::GRAIN_SIZE / (16 * C));
+  at::parallel_for(0, M, grain_size, [&](int64_t begin, int64_t end) {
+    float max = 0.f;
+    float sum = 0.f;
+    for (int64_t i = begin; i < end; i++) {
+      int64_t t = target_data[i];
+      if (t == ignore_index) {
+        lse_data[i] = 0.f;
+        losses_data[i] = 0.f;
+        continue;
+      }
+      TORCH_CHECK(t >= 0 && t < C, "Target ", t, " is out of bounds.");
+      const scalar_t* row = input_data + i * C;
+      torch_ipex::cpu::kernel::vec::vec512::_dil_online_max_sum_kernel<
+          scalar_t>(row, C, max, sum);
+      lse_data[i] = max + std::log(sum);
+      losses_data[i] = lse_data[i] - float(row[t]);
+    }
+  });
+}
+
+// grad_input = (softmax(input) - one_hot(target)) * grad of the row
+template <typename scalar_t>
+void softmax_cross_entropy_backward_kernel(
+    const at::Tensor& input,
+    const at::Tensor& target,
+    const at::Tensor& lse,
+    const at::Tensor& grad_rows,
+    at::Tensor& grad_input) {
+  int64_t M = input.size(0);
+  int64_t C = input.size(1);
+  const scalar_t* input_data = input.data_ptr<scalar_t>();
+  const int64_t* target_data = target.data_ptr<int64_t>();
+  const float* lse_data = lse.data_ptr<float>();
+  const float* grad_rows_data = grad_rows.data_ptr<float>();
+  scalar_t* grad_input_data = grad_input.data_ptr<scalar_t>();
+  int64_t grain_size =
+      std::max<int64_t>(1, at::internal::GRAIN_SIZE / (16 * C));
+  at::parallel_for(0, M, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      scalar_t* grad_row = grad_input_data + i * C;
+      float g = grad_rows_data[i];
+      if (g == 0.f) {
+        std::fill(grad_row, grad_row + C, scalar_t(0));
+        continue;
+      }
+      torch_ipex::cpu::kernel::vec::vec512::_dil_exp_scale_kernel<scalar_t>(
+          input_data + i * C, lse_data[i], g, C, grad_row);
+      int64_t t = target_data[i];
+      grad_row[t] = scalar_t(float(grad_row[t]) - g);
+    }
+  });
+}
+#endif
+
+// the logsumexp and the loss of each row, 0 for the ignored ones
+std::tuple<at::Tensor, at::Tensor> softmax_cross_entropy_rows(
+    const at::Tensor& input,
+    const at::Tensor& target,
+    int64_t ignore_index) {
+#if defined(CPU_AVX512)
+  auto lse = at::empty({input.size(0)}, input.options().dtype(at::kFloat));
+  auto losses = at::empty_like(lse);
+  if (input.scalar_type() == at::kBFloat16) {
+    softmax_cross_entropy_forward_kernel<at::BFloat16>(
+        input, target, ignore_index, lse, losses);
+  } else {
+    softmax_cross_entropy_forward_kernel<float>(
+        input, target, ignore_index, lse, losses);
+  }
+  return std::make_tuple(lse, losses);
+#else
+  auto valid = target.ne(ignore_index);
+  auto safe_target = target.masked_fill(valid.logical_not(), 0).unsqueeze(1);
+  auto x = input.to(at::kFloat);
+  auto lse = at::logsumexp(x, {1}).masked_fill(valid.logical_not(), 0);
+  auto losses = (lse - x.gather(1, safe_target).squeeze(1)) * valid;
+  return std::make_tuple(lse, losses);
+#endif
+}
+
+at::Tensor reduce_losses(
+    const at::Tensor& losses,
+    const at::Tensor& target,
+    int64_t reduction,
+    int64_t ignore_index,
+    at::ScalarType dtype) {
+  if (reduction == at::Reduction::None) {
+    return losses.to(dtype);
+  }
+  auto loss = losses.sum();
+  if (reduction == at::Reduction::Mean) {
+    // the mean of the rows not ignored, i.e. nan if all of them are
+    loss = loss / target.ne(ignore_index).sum();
+  }
+  return loss.to(dtype);
+}
+
+} // namespace
+
+at::Tensor IPEXSoftmaxCrossEntropyOp::forward(
+    torch::autograd::AutogradContext* ctx,
+    const at::Tensor& input,
+    const at::Tensor& target,
+    int64_t reduction,
+    int64_t ignore_index) {
+  IPEX_RECORD_FUNCTION(
+      "IPEXSoftmaxCrossEntropyOp::forward", std::vector<c10::IValue>({}));
+  auto input_ = input.contiguous();
+  auto target_ = target.contiguous();
+  at::Tensor lse, losses;
+  std::tie(lse, losses) =
+      softmax_cross_entropy_rows(input_, target_, ignore_index);
+  ctx->saved_data["reduction"] = reduction;
+  ctx->saved_data["ignore_index"] = ignore_index;
+  // the logits are the input of the op and saved anyway, only the [M]
+  // logsumexp is added for the backward
+  ctx->save_for_backward({input_, target_, lse});
+  return reduce_losses(
+      losses, target_, reduction, ignore_index, input.scalar_type());
+}
+
+torch::autograd::variable_list IPEXSoftmaxCrossEntropyOp::backward(
+    torch::autograd::AutogradContext* ctx,
+    torch::autograd::variable_list grad_outputs) {
+  IPEX_RECORD_FUNCTION(
+      "IPEXSoftmaxCrossEntropyOp::backward", std::vector<c10::IValue>({}));
+  auto saved = ctx->get_saved_variables();
+  auto input = saved[0];
+  auto target = saved[1];
+  auto lse = saved[2];
+  int64_t reduction = ctx->saved_data["reduction"].toInt();
+  int64_t ignore_index = ctx->saved_data["ignore_index"].toInt();
+
+  // the grad of the loss of each row, of which the ignored ones are 0
+  auto valid = target.ne(ignore_index);
+  auto grad_rows = grad_outputs[0].to(at::kFloat);
+  if (reduction == at::Reduction::None) {
+    grad_rows = grad_rows * valid;
+  } else if (reduction == at::Reduction::Mean) {
+    grad_rows = valid * (grad_rows / valid.sum());
+  } else {
+    grad_rows = valid * grad_rows;
+  }
+  grad_rows = grad_rows.contiguous();
+
+#if defined(CPU_AVX512)
+  auto grad_input = at::empty_like(input);
+  if (input.scalar_type() == at::kBFloat16) {
+    softmax_cross_entropy_backward_kernel<at::BFloat16>(
+        input, target, lse, grad_rows, grad_input);
+  } else {
+    softmax_cross_entropy_backward_kernel<float>(
+        input, target, lse, grad_rows, grad_input);
+  }
+#else
+  auto safe_target = target.masked_fill(valid.logical_not(), 0).unsqueeze(1);
+  auto grad_input = (input.to(at::kFloat) - lse.unsqueeze(1)).exp() *
+      grad_rows.unsqueeze(1);
+  grad_input.scatter_add_(1, safe_target, grad_rows.neg().unsqueeze(1));
+  grad_input = grad_input.to(input.scalar_type());
+#endif
+  return {grad_input, at::Tensor(), at::Tensor(), at::Tensor()};
+}
+
+at::Tensor softmax_cross_entropy(
+    const at::Tensor& input,
+    const at::Tensor& target,
+    int64_t reduction,
+    int64_t ignore_index) {
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::softmax_cross_entropy", std::vector<c10::IValue>({}));
+  if (!can_use_fused_kernel(input, target)) {
+    return at::cross_entropy_loss(
+        input, target, {}, reduction, ignore_index, 0.0);
+  }
+  if (at::GradMode::is_enabled()) {
+    return IPEXSoftmaxCrossEntropyOp::apply(
+        input, target, reduction, ignore_index);
+  }
+  auto input_ = input.contiguous();
+  auto target_ = target.contiguous();
+  auto losses =
+      std::get<1>(softmax_cross_entropy_rows(input_, target_, ignore_index));
+  return reduce_losses(
+      losses, target_, reduction, ignore_index, input.scalar_type());
+}
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "softmax_cross_entropy(Tensor input, Tensor target, int reduction=1, "
+      "int ignore_index=-100) -> Tensor",
+      torch_ipex::cpu::softmax_cross_entropy);
+}
+
+} // namespace
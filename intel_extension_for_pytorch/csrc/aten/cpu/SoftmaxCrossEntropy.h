@@ -0,0 +1,36 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+#include <torch/csrc/autograd/custom_function.h>
+
+namespace torch_ipex {
+namespace cpu {
+
+// cross_entropy(input, target) of the logits of the last dim of the
+// classification and the LM heads, in a single read of each row of the
+// logits by the online softmax. Only the logsumexp of the rows is saved for
+// the backward, which recomputes the grad as softmax(input) - one_hot(target)
+// and does not keep the softmax of the vocabulary-sized logits.
+at::Tensor softmax_cross_entropy(
+    const at::Tensor& input,
+    const at::Tensor& target,
+    int64_t reduction,
+    int64_t ignore_index);
+
+class IPEXSoftmaxCrossEntropyOp
+    : public torch::autograd::Function<IPEXSoftmaxCrossEntropyOp> {
+ public:
+  static at::Tensor forward(
+      torch::autograd::AutogradContext* ctx,
+      const at::Tensor& input,
+      const at::Tensor& target,
+      int64_t reduction,
+      int64_t ignore_index);
+
+  static torch::autograd::variable_list backward(
+      torch::autograd::AutogradContext* ctx,
+      torch::autograd::variable_list grad_outputs);
+};
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,126 @@
+#include "SparseLinear.h"
+#include "WeightOnlyQuantizedLinear.h"
+
+#include <ATen/ATen.h>
+
+#include <tuple>
+
+namespace torch_ipex {
+namespace cpu {
+
+IPEX_DEFINE_DISPATCH(sparse_linear_kernel_stub);
+
+namespace {
+
+// the weights of the blocks [out_features / kSparseBlockN, in_features,
+// kSparseBlockN] and whether each block [out_features / kSparseBlockN,
+// in_features] has a nonzero
+std::tuple<at::Tensor, at::Tensor> linear_weight_blocks(
+    const at::Tensor& weight) {
+  TORCH_CHECK(
+      weight.dim() == 2 && weight.scalar_type() == at::kFloat,
+      "The block-sparse linear weight must be a 2-D fp32 tensor");
+  const int64_t out_features = weight.size(0);
+  const int64_t in_features = weight.size(1);
+  const int64_t pad =
+      (kSparseBlockN - out_features % kSparseBlockN) % kSparseBlockN;
+  auto weight_ = at::constant_pad_nd(weight.contiguous(), {0, 0, 0, pad});
+  auto blocks = weight_.view({-1, kSparseBlockN, in_features})
+                    .transpose(1, 2)
+                    .contiguous();
+  return std::make_tuple(blocks, blocks.ne(0).any(2));
+}
+
+// Returns the fp32 result of the linear and the post ops of attr, accumu is
+// the destination of the sum post op.
+at::Tensor sparse_linear_impl(
+    const at::Tensor& self,
+    const at::Tensor& values,
+    const at::Tensor& indices,
+    const at::Tensor& offsets,
+    int64_t out_features,
+    const at::Tensor& bias,
+    const at::Tensor& accumu,
+    const ideep::attr_t& attr) {
+  TORCH_CHECK(
+      (offsets.numel() - 1) * kSparseBlockN >= out_features &&
+          values.size(0) == indices.numel(),
+      "sparse_linear: the block-sparse weight is corrupted");
+  auto input = self.reshape({-1, self.size(-1)}).to(at::kFloat).contiguous();
+  auto bias_ = bias.defined() ? bias.to(at::kFloat).contiguous() : bias;
+  auto output = at::empty(
+      {input.size(0), out_features}, input.options().dtype(at::kFloat));
+  sparse_linear_kernel_stub(input, values, indices, offsets, bias_, output);
+  return quantized_linear_post_ops(output, accumu, attr);
+}
+
+} // namespace
+
+float linear_weight_block_sparsity(const at::Tensor& weight) {
+  auto nonzeros = std::get<1>(linear_weight_blocks(weight));
+  if (nonzeros.numel() == 0) {
+    return 0.f;
+  }
+  return 1.f -
+      static_cast<float>(nonzeros.sum().item<int64_t>()) / nonzeros.numel();
+}
+
+void pack_block_sparse_linear_weight(
+    const at::Tensor& weight,
+    at::Tensor& values,
+    at::Tensor& indices,
+    at::Tensor& offsets) {
+  at::Tensor blocks, nonzeros;
+  std::tie(blocks, nonzeros) = linear_weight_blocks(weight);
+  const int64_t in_features = weight.size(1);
+  // the nonzero blocks of the row-major order of nonzeros, i.e. of each
+  // kSparseBlockN output channels in turn
+  auto positions = nonzeros.nonzero();
+  auto block_index =
+      positions.select(1, 0).mul(in_features).add(positions.select(1, 1));
+  values = blocks.view({-1, kSparseBlockN})
+               .index_select(0, block_index)
+               .contiguous();
+  indices = positions.select(1, 1).to(at::kInt).contiguous();
+  offsets =
+      at::zeros({nonzeros.size(0) + 1}, nonzeros.options().dtype(at::kLong));
+  offsets.narrow(0, 1, nonzeros.size(0)).copy_(nonzeros.sum(1).cumsum(0));
+}
+
+at::Tensor sparse_linear_kernel(
+    const at::Tensor& self,
+    const at::Tensor& values,
+    const at::Tensor& indices,
+    const at::Tensor& offsets,
+    int64_t out_features,
+    const at::Tensor& bias,
+    const ideep::attr_t& attr) {
+  auto output = sparse_linear_impl(
+      self, values, indices, offsets, out_features, bias, at::Tensor(), attr);
+  auto output_size = self.sizes().vec();
+  output_size.back() = out_features;
+  return output.to(self.scalar_type()).reshape(output_size);
+}
+
+void sparse_linear_kernel_output(
+    const at::Tensor& self,
+    const at::Tensor& values,
+    const at::Tensor& indices,
+    const at::Tensor& offsets,
+    const at::Tensor& bias,
+    at::Tensor& output,
+    const ideep::attr_t& attr) {
+  auto result = sparse_linear_impl(
+      self,
+      values,
+      indices,
+      offsets,
+      output.size(-1),
+      bias,
+      output,
+      attr);
+  output.copy_(result.reshape(output.sizes()));
+}
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+#include "csrc/cpu/dispatch/DispatchStub.h"
+#include "csrc/cpu/ideep/ideep.hpp"
+
+namespace torch_ipex {
+namespace cpu {
+
+// The output channels of a block of the block-sparse linear weight, i.e. a
+// block is the kSparseBlockN consecutive weights of an input feature, which
+// fill a zmm register of AVX512 or a pair of ymm registers of AVX2
+constexpr int64_t kSparseBlockN = 16;
+
+// The least ratio of the zero blocks of the weight, from which the sparse
+// kernel skipping them beats the dense oneDNN inner product, which reads no
+// indices
+constexpr float kSparseLinearMinBlockSparsity = 0.75f;
+
+// Returns the ratio of the blocks of the fp32 linear weight [out_features,
+// in_features] of no nonzero, of which the output channels are padded with
+// zeros to a multiple of kSparseBlockN.
+float linear_weight_block_sparsity(const at::Tensor& weight);
+
+// Packs the fp32 linear weight [out_features, in_features] into the blocks
+// of its nonzeros, in the order of the blocks of the output channels and
+// then the input features: values [blocks, kSparseBlockN] of the weights of
+// the blocks, indices [blocks] of the int32 input features of the blocks,
+// and offsets [out_features / kSparseBlockN + 1] of the int64 first blocks
+// of each kSparseBlockN output channels, rounded up.
+void pack_block_sparse_linear_weight(
+    const at::Tensor& weight,
+    at::Tensor& values,
+    at::Tensor& indices,
+    at::Tensor& offsets);
+
+// Linear with the weight of pack_block_sparse_linear_weight, which skips the
+// zero blocks of the pruned weight, e.g. of the pruned MLPs of BERT and DLRM.
+// The input and the output stay in fp32/bf16 and the post ops of attr (sum,
+// relu and gelu) are applied to the output.
+at::Tensor sparse_linear_kernel(
+    const at::Tensor& self,
+    const at::Tensor& values,
+    const at::Tensor& indices,
+    const at::Tensor& offsets,
+    int64_t out_features,
+    const at::Tensor& bias,
+    const ideep::attr_t& attr);
+
+// The inplace version of sparse_linear_kernel, the result is written into
+// output, e.g. Linear+Add fusion.
+void sparse_linear_kernel_output(
+    const at::Tensor& self,
+    const at::Tensor& values,
+    const at::Tensor& indices,
+    const at::Tensor& offsets,
+    const at::Tensor& bias,
+    at::Tensor& output,
+    const ideep::attr_t& attr);
+
+// output [M, N] = input [M, K] x weight^T + bias of the contiguous fp32
+// input and output, and of the block-sparse weight of values, indices and
+// offsets, of which bias is undefined if there is none
+using sparse_linear_kernel_fn = void (*)(
+    const at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&,
+    const at::Tensor&,
+    at::Tensor&);
+IPEX_DECLARE_DISPATCH(sparse_linear_kernel_fn, sparse_linear_kernel_stub);
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -10,11 +10,14 @@
 #include <c10/util/accumulate.h>
 
 #include <math.h>
+#include <type_traits>
 #include <vector>
 
 #include "UpSample.h"
 
 #include "csrc/utils/library.h"
+#include "utils/stream_store.h"
+#include "csrc/utils/op_trace.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -330,6 +333,21 @@ void cpu_upsample_generic(at::TensorIterator& iter) {
   iter.for_each(loop);
 }
 
+// The pixel stride of a 4d output, if it is a channel slice of a wider
+// channels last tensor, e.g. the concat buffer of the fused upsample + cat,
+// so that it could be written in place. Otherwise returns 0.
+inline int64_t channels_last_slice_stride(const at::Tensor& output) {
+  if (output.dim() != 4 || output.stride(1) != 1) {
+    return 0;
+  }
+  int64_t ld = output.stride(3);
+  bool is_slice = ld >= output.size(1) &&
+      output.stride(2) == ld * output.size(3) &&
+      (output.size(0) == 1 ||
+       output.stride(0) == ld * output.size(3) * output.size(2));
+  return is_slice ? ld : 0;
+}
+
 template <typename scalar_t, typename scale_type>
 void cpu_upsample_nearest_channels_last(
     const at::Tensor& output_,
@@ -353,7 +371,11 @@ void cpu_upsample_nearest_channels_last(
       ? at::MemoryFormat::ChannelsLast
       : at::MemoryFormat::ChannelsLast3d;
   auto input = input_.contiguous(channels_last_memory_format);
-  auto output = output_.contiguous(channels_last_memory_format);
+  // write the channel slice of a channels last tensor in place
+  int64_t output_ld = channels_last_slice_stride(output_);
+  bool is_slice = output_ld > 0;
+  auto output =
+      is_slice ? output_ : output_.contiguous(channels_last_memory_format);
 
   auto input_data = input.data_ptr<scalar_t>();
   auto output_data = output.data_ptr<scalar_t>();
@@ -372,9 +394,23 @@ void cpu_upsample_nearest_channels_last(
       channels > 0,
       "expected input and output channels greater than 0 but got ",
       channels);
+  if (!is_slice) {
+    output_ld = channels;
+  }
 
+  // the output beyond half of the LLC is evicted before the next op reads it,
+  // which is written by the non-temporal stores
+  bool stream_output =
+      use_stream_store(numel * static_cast<int64_t>(sizeof(scalar_t)));
   using Vec = at::vec::Vectorized<scalar_t>;
-  auto copy = [](scalar_t* out, scalar_t* in, int64_t size) {
+  auto copy = [stream_output](scalar_t* out, scalar_t* in, int64_t size) {
+    if (stream_output) {
+      stream_copy(
+          reinterpret_cast<char*>(out),
+          reinterpret_cast<const char*>(in),
+          size * sizeof(scalar_t));
+      return;
+    }
     int64_t d = 0;
     for (; d < size - (size % Vec::size()); d += Vec::size()) {
       Vec out_vec = Vec::loadu(in + d);
@@ -395,7 +431,7 @@ void cpu_upsample_nearest_channels_last(
     for (int64_t i = begin; i < end; i++) {
       int64_t ih = nearest_idx(oh, input_height, output_height, scales[0]);
       int64_t iw = nearest_idx(ow, input_width, output_width, scales[1]);
-      scalar_t* output_ptr = output_data + i * channels;
+      scalar_t* output_ptr = output_data + i * output_ld;
       scalar_t* input_ptr = input_data +
           n * input_height * input_width * channels +
           ih * input_width * channels + iw * channels;
@@ -403,6 +439,9 @@ void cpu_upsample_nearest_channels_last(
       at::native::data_index_step(
           n, num_batches, oh, output_height, ow, output_width);
     }
+    if (stream_output) {
+      _mm_sfence();
+    }
   };
 
   auto loop3d = [&](int64_t begin, int64_t end) {
@@ -441,6 +480,9 @@ void cpu_upsample_nearest_channels_last(
           ow,
           output_width);
     }
+    if (stream_output) {
+      _mm_sfence();
+    }
   };
 
   if (ndim == 4) {
@@ -454,7 +496,7 @@ void cpu_upsample_nearest_channels_last(
         0, numel / channels, at::internal::GRAIN_SIZE / channels, loop3d);
   }
 
-  if (!output_.is_contiguous(channels_last_memory_format)) {
+  if (!is_slice && !output_.is_contiguous(channels_last_memory_format)) {
     output_.copy_(output);
   }
 }
@@ -751,6 +793,272 @@ void cpu_upsample_linear_channels_last(
   }
 }
 
+// Indices and weights of the interp_size taps of each output index of one
+// dimension, for the separable channels last kernel below, by the same
+// formulas as HelperInterpLinear and HelperInterpCubic.
+template <typename accscalar_t, int interp_size>
+static inline void compute_separable_indices_weights(
+    int64_t input_size,
+    int64_t output_size,
+    bool align_corners,
+    const c10::optional<double> opt_scale,
+    std::vector<int64_t>& indices,
+    std::vector<accscalar_t>& weights) {
+  indices.resize(output_size * interp_size);
+  weights.resize(output_size * interp_size);
+  accscalar_t scale = at::native::area_pixel_compute_scale<accscalar_t>(
+      input_size, output_size, align_corners, opt_scale);
+  for (int64_t i = 0; i < output_size; i++) {
+    int64_t* index = indices.data() + i * interp_size;
+    accscalar_t* weight = weights.data() + i * interp_size;
+    if (interp_size == 2) {
+      at::native::compute_source_index_and_lambda<accscalar_t>(
+          index[0],
+          index[1],
+          weight[0],
+          weight[1],
+          scale,
+          i,
+          input_size,
+          output_size,
+          align_corners);
+    } else {
+      const accscalar_t real_input_index =
+          at::native::area_pixel_compute_source_index<accscalar_t>(
+              scale, i, align_corners, /*cubic=*/true);
+      int64_t input_index = static_cast<int64_t>(floorf(real_input_index));
+      at::native::get_cubic_upsample_coefficients<accscalar_t>(
+          weight, real_input_index - input_index);
+      for (int j = 0; j < interp_size; j++) {
+        index[j] = std::max(
+            std::min(input_index + j - 1, input_size - 1),
+            static_cast<int64_t>(0));
+      }
+    }
+  }
+}
+
+// Separable 2d bilinear (interp_size = 2) and bicubic (interp_size = 4)
+// interpolation for channels last.
+//
+// The output rows are computed by tiles. For a tile, the input rows it refers
+// to are interpolated along the width into an intermediate buffer sized to fit
+// L2, which is then interpolated along the height to the output rows. Both
+// passes are vectorized along the contiguous width * channels, and are done
+// in float for BFloat16.
+template <typename scalar_t, int interp_size>
+void cpu_upsample_separable_channels_last(
+    const at::Tensor& output_,
+    const at::Tensor& input_,
+    bool align_corners,
+    const scale_t& scales) {
+  TORCH_CHECK(
+      input_.dtype() == output_.dtype(),
+      "expected dtype ",
+      input_.dtype(),
+      " for `output` but got dtype ",
+      output_.dtype());
+  TORCH_CHECK(
+      input_.dim() == 4,
+      "Separable upsample with NHWC format supports tensors with 4 dims.")
+
+  auto input = input_.contiguous(at::MemoryFormat::ChannelsLast);
+  // write the channel slice of a channels last tensor in place
+  int64_t output_ld = channels_last_slice_stride(output_);
+  bool is_slice = output_ld > 0;
+  auto output =
+      is_slice ? output_ : output_.contiguous(at::MemoryFormat::ChannelsLast);
+
+  auto input_data = input.data_ptr<scalar_t>();
+  auto output_data = output.data_ptr<scalar_t>();
+
+  int64_t num_batches = input.size(0);
+  int64_t channels = input.size(1);
+  int64_t input_height = input.size(2);
+  int64_t input_width = input.size(3);
+  int64_t output_height = output.size(2);
+  int64_t output_width = output.size(3);
+
+  TORCH_CHECK(
+      channels > 0,
+      "expected input and output channels greater than 0 but got ",
+      channels);
+  if (!is_slice) {
+    output_ld = channels;
+  }
+
+  // use float as immediate dtype for bfloat16 input so as to reduce rouding
+  // error and improve performance.
+  using accscalar_t = typename std::conditional<
+      std::is_same<scalar_t, at::BFloat16>::value,
+      float,
+      scalar_t>::type;
+  using Vec = at::vec::Vectorized<accscalar_t>;
+  constexpr bool is_acc = std::is_same<scalar_t, accscalar_t>::value;
+
+  std::vector<int64_t> h_indices, w_indices;
+  std::vector<accscalar_t> h_weights, w_weights;
+  compute_separable_indices_weights<accscalar_t, interp_size>(
+      input_height,
+      output_height,
+      align_corners,
+      scales[0],
+      h_indices,
+      h_weights);
+  compute_separable_indices_weights<accscalar_t, interp_size>(
+      input_width,
+      output_width,
+      align_corners,
+      scales[1],
+      w_indices,
+      w_weights);
+
+  // the output rows of a tile, of which the intermediate rows fit L2, and
+  // enough tiles for all the threads
+  constexpr int64_t kTileBytes = 512 * 1024;
+  int64_t input_row_size = input_width * channels;
+  int64_t output_row_size = output_width * channels;
+  int64_t tile_input_rows = std::max<int64_t>(
+      kTileBytes / (output_row_size * sizeof(accscalar_t)), interp_size);
+  int64_t tile_height = std::max<int64_t>(
+      (tile_input_rows - interp_size) * output_height / input_height, 1);
+  tile_height = std::min(
+      tile_height,
+      at::divup(
+          output_height, at::divup(at::get_num_threads(), num_batches)));
+  int64_t num_tiles = at::divup(output_height, tile_height);
+
+  auto weighted_sum = [](accscalar_t* out,
+                         const accscalar_t* const* in,
+                         const accscalar_t* weight,
+                         int64_t size) {
+    int64_t d = 0;
+    for (; d < size - (size % Vec::size()); d += Vec::size()) {
+      Vec out_vec = Vec::loadu(in[0] + d) * Vec(weight[0]);
+      for (int j = 1; j < interp_size; j++) {
+        out_vec =
+            at::vec::fmadd(Vec::loadu(in[j] + d), Vec(weight[j]), out_vec);
+      }
+      out_vec.store(out + d);
+    }
+    for (; d < size; d++) {
+      accscalar_t out_val = in[0][d] * weight[0];
+      for (int j = 1; j < interp_size; j++) {
+        out_val += in[j][d] * weight[j];
+      }
+      out[d] = out_val;
+    }
+  };
+
+  at::parallel_for(
+      0, num_batches * num_tiles, 1, [&](int64_t begin, int64_t end) {
+        std::vector<accscalar_t> tile;
+        std::vector<accscalar_t> input_row(is_acc ? 0 : input_row_size);
+        std::vector<accscalar_t> output_row(is_acc ? 0 : output_row_size);
+        std::vector<char> row_used;
+        const accscalar_t* in[interp_size];
+        for (int64_t task = begin; task < end; task++) {
+          int64_t n = task / num_tiles;
+          int64_t oh_begin = task % num_tiles * tile_height;
+          int64_t oh_end = std::min(oh_begin + tile_height, output_height);
+          // the input rows of the tile
+          int64_t ih_begin = h_indices[oh_begin * interp_size];
+          int64_t ih_end = ih_begin + 1;
+          for (int64_t oh = oh_begin; oh < oh_end; oh++) {
+            for (int j = 0; j < interp_size; j++) {
+              ih_begin = std::min(ih_begin, h_indices[oh * interp_size + j]);
+              ih_end = std::max(ih_end, h_indices[oh * interp_size + j] + 1);
+            }
+          }
+          row_used.assign(ih_end - ih_begin, 0);
+          for (int64_t oh = oh_begin; oh < oh_end; oh++) {
+            for (int j = 0; j < interp_size; j++) {
+              row_used[h_indices[oh * interp_size + j] - ih_begin] = 1;
+            }
+          }
+          tile.resize((ih_end - ih_begin) * output_row_size);
+
+          // pass I: interpolate along the width
+          for (int64_t ih = ih_begin; ih < ih_end; ih++) {
+            if (!row_used[ih - ih_begin]) {
+              continue;
+            }
+            const scalar_t* src =
+                input_data + (n * input_height + ih) * input_row_size;
+            const accscalar_t* src_acc;
+            if (is_acc) {
+              src_acc = reinterpret_cast<const accscalar_t*>(src);
+            } else {
+              at::vec::convert(src, input_row.data(), input_row_size);
+              src_acc = input_row.data();
+            }
+            accscalar_t* dst = tile.data() + (ih - ih_begin) * output_row_size;
+            for (int64_t ow = 0; ow < output_width; ow++) {
+              for (int j = 0; j < interp_size; j++) {
+                in[j] = src_acc + w_indices[ow * interp_size + j] * channels;
+              }
+              weighted_sum(
+                  dst + ow * channels,
+                  in,
+                  w_weights.data() + ow * interp_size,
+                  channels);
+            }
+          }
+
+          // pass II: interpolate along the height
+          for (int64_t oh = oh_begin; oh < oh_end; oh++) {
+            for (int j = 0; j < interp_size; j++) {
+              in[j] = tile.data() +
+                  (h_indices[oh * interp_size + j] - ih_begin) *
+                      output_row_size;
+            }
+            scalar_t* out = output_data +
+                (n * output_height + oh) * output_width * output_ld;
+            if (is_acc && output_ld == channels) {
+              weighted_sum(
+                  reinterpret_cast<accscalar_t*>(out),
+                  in,
+                  h_weights.data() + oh * interp_size,
+                  output_row_size);
+            } else if (is_acc) {
+              // the pixels of the output row are output_ld apart
+              const accscalar_t* in_pixel[interp_size];
+              for (int64_t ow = 0; ow < output_width; ow++) {
+                for (int j = 0; j < interp_size; j++) {
+                  in_pixel[j] = in[j] + ow * channels;
+                }
+                weighted_sum(
+                    reinterpret_cast<accscalar_t*>(out) + ow * output_ld,
+                    in_pixel,
+                    h_weights.data() + oh * interp_size,
+                    channels);
+              }
+            } else {
+              weighted_sum(
+                  output_row.data(),
+                  in,
+                  h_weights.data() + oh * interp_size,
+                  output_row_size);
+              if (output_ld == channels) {
+                at::vec::convert(output_row.data(), out, output_row_size);
+              } else {
+                for (int64_t ow = 0; ow < output_width; ow++) {
+                  at::vec::convert(
+                      output_row.data() + ow * channels,
+                      out + ow * output_ld,
+                      channels);
+                }
+              }
+            }
+          }
+        }
+      });
+
+  if (!is_slice && !output_.is_contiguous(at::MemoryFormat::ChannelsLast)) {
+    output_.copy_(output);
+  }
+}
+
 // Helper structs to use with upsample_generic_Nd_kernel_impl
 struct HelperInterpBase {
   static inline void init_indices_weights(
@@ -1136,14 +1444,13 @@ void upsample_bilinear2d_kernel_impl(
     bool align_corners,
     c10::optional<double> scales_h,
     c10::optional<double> scales_w) {
-  // Temporarily dispatch to original channels last implementation
   if (input.is_contiguous(at::MemoryFormat::ChannelsLast)) {
     AT_DISPATCH_FLOATING_TYPES_AND(
         at::ScalarType::BFloat16,
         input.scalar_type(),
         "upsample_bilinear2d_channels_last",
         [&] {
-          cpu_upsample_linear_channels_last<scalar_t, scale_t>(
+          cpu_upsample_separable_channels_last<scalar_t, 2>(
               output, input, align_corners, {scales_h, scales_w});
         });
   } else {
@@ -1180,8 +1487,19 @@ void upsample_bicubic2d_kernel_impl(
     bool align_corners,
     c10::optional<double> scales_h,
     c10::optional<double> scales_w) {
-  upsample_generic_Nd_kernel_impl<2, scale_t, HelperInterpCubic>(
-      output, input, align_corners, {scales_h, scales_w});
+  if (input.is_contiguous(at::MemoryFormat::ChannelsLast)) {
+    AT_DISPATCH_FLOATING_TYPES_AND(
+        at::ScalarType::BFloat16,
+        input.scalar_type(),
+        "upsample_bicubic2d_channels_last",
+        [&] {
+          cpu_upsample_separable_channels_last<scalar_t, 4>(
+              output, input, align_corners, {scales_h, scales_w});
+        });
+  } else {
+    upsample_generic_Nd_kernel_impl<2, scale_t, HelperInterpCubic>(
+        output, input, align_corners, {scales_h, scales_w});
+  }
 }
 
 template <typename scalar_t, typename scale_type>
@@ -1973,10 +2291,8 @@ at::Tensor upsample_nearest1d_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::upsample_nearest1d_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::upsample_nearest1d_out_cpu", std::vector<c10::IValue>({}));
-#endif
 
   auto full_output_size =
       at::native::upsample_1d_common_check(input.sizes(), output_size);
@@ -2000,11 +2316,9 @@ at::Tensor upsample_nearest1d_backward_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::upsample_nearest1d_backward_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::upsample_nearest1d_backward_out_cpu",
       std::vector<c10::IValue>({}));
-#endif
 
   auto full_output_size =
       at::native::upsample_1d_common_check(input_size, output_size);
@@ -2026,10 +2340,8 @@ at::Tensor upsample_nearest2d_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::upsample_nearest2d_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::upsample_nearest2d_out_cpu", std::vector<c10::IValue>({}));
-#endif
 
   auto full_output_size =
       at::native::upsample_2d_common_check(input.sizes(), output_size);
@@ -2058,11 +2370,9 @@ at::Tensor upsample_nearest2d_backward_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::upsample_nearest2d_backward_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::upsample_nearest2d_backward_out_cpu",
       std::vector<c10::IValue>({}));
-#endif
 
   auto full_output_size =
       at::native::upsample_2d_common_check(input_size, output_size);
@@ -2107,10 +2417,8 @@ at::Tensor upsample_nearest3d_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::upsample_nearest3d_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::upsample_nearest3d_out_cpu", std::vector<c10::IValue>({}));
-#endif
 
   auto full_output_size =
       at::native::upsample_3d_common_check(input.sizes(), output_size);
@@ -2140,11 +2448,9 @@ at::Tensor upsample_nearest3d_backward_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::upsample_nearest3d_backward_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::upsample_nearest3d_backward_out_cpu",
       std::vector<c10::IValue>({}));
-#endif
 
   auto full_output_size =
       at::native::upsample_3d_common_check(input_size, output_size);
@@ -2182,10 +2488,8 @@ at::Tensor upsample_linear1d_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::upsample_linear1d_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::upsample_linear1d_out_cpu", std::vector<c10::IValue>({}));
-#endif
 
   auto full_output_size =
       at::native::upsample_1d_common_check(input.sizes(), output_size);
@@ -2210,11 +2514,9 @@ at::Tensor upsample_linear1d_backward_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::upsample_linear1d_backward_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::upsample_linear1d_backward_out_cpu",
       std::vector<c10::IValue>({}));
-#endif
 
   auto full_output_size =
       at::native::upsample_1d_common_check(input_size, output_size);
@@ -2243,10 +2545,8 @@ at::Tensor upsample_bilinear2d_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::upsample_bilinear2d_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::upsample_bilinear2d_out_cpu", std::vector<c10::IValue>({}));
-#endif
 
   auto full_output_size =
       at::native::upsample_2d_common_check(input.sizes(), output_size);
@@ -2277,11 +2577,9 @@ at::Tensor upsample_bilinear2d_backward_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::upsample_bilinear2d_backward_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::upsample_bilinear2d_backward_out_cpu",
       std::vector<c10::IValue>({}));
-#endif
 
   auto full_output_size =
       at::native::upsample_2d_common_check(input_size, output_size);
@@ -2317,6 +2615,37 @@ at::Tensor upsample_bilinear2d_backward_out_cpu(
   return grad_input;
 }
 
+at::Tensor upsample_bicubic2d_out_cpu(
+    const at::Tensor& input,
+    at::IntArrayRef output_size,
+    bool align_corners,
+    c10::optional<double> scales_h,
+    c10::optional<double> scales_w) {
+#if defined(IPEX_DISP_OP)
+  printf("torch_ipex::upsample_bicubic2d_out_cpu\n");
+#endif
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::upsample_bicubic2d_out_cpu", std::vector<c10::IValue>({}));
+
+  auto full_output_size =
+      at::native::upsample_2d_common_check(input.sizes(), output_size);
+
+  // Allow for empty batch size but not other dimensions
+  TORCH_CHECK(
+      input.numel() != 0 ||
+          c10::multiply_integers(
+              input.sizes().begin() + 1, input.sizes().end()),
+      "Non-empty 4D data tensor expected but got a tensor with sizes ",
+      input.sizes());
+
+  at::Tensor output = at::empty(
+      full_output_size,
+      input.options().memory_format(input.suggest_memory_format()));
+  upsample_bicubic2d_kernel_impl(
+      output, input, align_corners, scales_h, scales_w);
+  return output;
+}
+
 at::Tensor upsample_trilinear3d_out_cpu(
     const at::Tensor& input,
     at::IntArrayRef output_size,
@@ -2327,10 +2656,8 @@ at::Tensor upsample_trilinear3d_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::upsample_trilinear3d_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::upsample_trilinear3d_out_cpu", std::vector<c10::IValue>({}));
-#endif
 
   auto full_output_size =
       at::native::upsample_3d_common_check(input.sizes(), output_size);
@@ -2362,11 +2689,9 @@ at::Tensor upsample_trilinear3d_backward_out_cpu(
 #if defined(IPEX_DISP_OP)
   printf("torch_ipex::upsample_trilinear3d_backward_out_cpu\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::upsample_trilinear3d_backward_out_cpu",
       std::vector<c10::IValue>({}));
-#endif
   auto full_output_size =
       at::native::upsample_3d_common_check(input_size, output_size);
 
@@ -2426,6 +2751,9 @@ IPEX_TORCH_LIBRARY_IMPL(aten, CPU, m) {
   m.impl(
       TORCH_SELECTIVE_NAME("aten::upsample_bilinear2d_backward"),
       TORCH_FN((&torch_ipex::cpu::upsample_bilinear2d_backward_out_cpu)));
+  m.impl(
+      TORCH_SELECTIVE_NAME("aten::upsample_bicubic2d"),
+      TORCH_FN((&torch_ipex::cpu::upsample_bicubic2d_out_cpu)));
   m.impl(
       TORCH_SELECTIVE_NAME("aten::upsample_trilinear3d"),
       TORCH_FN((&torch_ipex::cpu::upsample_trilinear3d_out_cpu)));
@@ -21,6 +21,13 @@ void cpu_upsample_linear_channels_last(
     bool align_corners,
     const scale_type& scales);
 
+template <typename scalar_t, int interp_size>
+void cpu_upsample_separable_channels_last(
+    const at::Tensor& output_,
+    const at::Tensor& input_,
+    bool align_corners,
+    const std::vector<c10::optional<double>>& scales);
+
 template <int out_ndims, typename scale_type, class F>
 void upsample_generic_Nd_kernel_impl(
     const at::Tensor& output,
@@ -193,6 +200,13 @@ at::Tensor upsample_bilinear2d_backward_out_cpu(
     c10::optional<double> scales_h,
     c10::optional<double> scales_w);
 
+at::Tensor upsample_bicubic2d_out_cpu(
+    const at::Tensor& input,
+    at::IntArrayRef output_size,
+    bool align_corners,
+    c10::optional<double> scales_h,
+    c10::optional<double> scales_w);
+
 at::Tensor upsample_trilinear3d_out_cpu(
     const at::Tensor& input,
     at::IntArrayRef output_size,
@@ -0,0 +1,409 @@
+#include "WeightOnlyQuantizedLinear.h"
+
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/vec.h>
+#include <c10/util/Exception.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+using Vec = at::vec::Vectorized<float>;
+
+// output[m, n] = sum_k(input[m, k] * weight[n, k]) * scale(n) + bias[n], of
+// which dequant_row(n, row) writes the fp32 row n of the weight into row and
+// returns scale(n).
+template <typename DequantRow>
+void woq_linear_fp32_kernel(
+    const at::Tensor& input,
+    int64_t N,
+    const DequantRow& dequant_row,
+    const at::Tensor& bias,
+    at::Tensor& output) {
+  const int64_t M = input.size(0);
+  const int64_t K = input.size(1);
+  const float* input_data = input.data_ptr<float>();
+  const float* bias_data = bias.defined() ? bias.data_ptr<float>() : nullptr;
+  float* output_data = output.data_ptr<float>();
+
+  // Each weight row is converted to fp32 once and then used by all the M
+  // input rows, so the weight is read from memory only once.
+  at::parallel_for(0, N, 16, [&](int64_t begin, int64_t end) {
+    std::vector<float> weight_row(K);
+    float partial_sums[Vec::size()];
+    for (int64_t n = begin; n < end; n++) {
+      float scale = dequant_row(n, weight_row.data());
+      for (int64_t m = 0; m < M; m++) {
+        const float* input_ptr = input_data + m * K;
+        Vec acc_vec(0.f);
+        int64_t k = 0;
+        for (; k < K - (K % Vec::size()); k += Vec::size()) {
+          acc_vec = at::vec::fmadd(
+              Vec::loadu(input_ptr + k),
+              Vec::loadu(weight_row.data() + k),
+              acc_vec);
+        }
+        acc_vec.store(partial_sums);
+        float acc = 0.f;
+        for (int64_t i = 0; i < Vec::size(); i++) {
+          acc += partial_sums[i];
+        }
+        for (; k < K; k++) {
+          acc += input_ptr[k] * weight_row[k];
+        }
+        acc *= scale;
+        if (bias_data != nullptr) {
+          acc += bias_data[n];
+        }
+        output_data[m * N + n] = acc;
+      }
+    }
+  });
+}
+
+// the weight of int8 and its per-channel scales
+void woq_linear_int8_fp32_kernel(
+    const at::Tensor& input,
+    const at::Tensor& weight_int8,
+    const at::Tensor& weight_scales,
+    const at::Tensor& bias,
+    at::Tensor& output) {
+  const int64_t K = weight_int8.size(1);
+  const int8_t* weight_data = weight_int8.data_ptr<int8_t>();
+  const float* scales_data = weight_scales.data_ptr<float>();
+  auto dequant_row = [&](int64_t n, float* row) {
+    const int8_t* weight_ptr = weight_data + n * K;
+    for (int64_t k = 0; k < K; k++) {
+      row[k] = static_cast<float>(weight_ptr[k]);
+    }
+    return scales_data[n];
+  };
+  woq_linear_fp32_kernel(
+      input, weight_int8.size(0), dequant_row, bias, output);
+}
+
+// the 4-bit weight of F, of which the scales of the groups are applied by
+// the dequantization
+template <Int4Format F>
+void woq_linear_int4_fp32_kernel(
+    const at::Tensor& input,
+    const at::Tensor& weight_int4,
+    const at::Tensor& weight_scales,
+    int64_t group_size,
+    const at::Tensor& bias,
+    at::Tensor& output) {
+  const int64_t K = input.size(1);
+  const int64_t row_bytes = weight_int4.size(1);
+  const int64_t groups = weight_scales.size(1);
+  const uint8_t* weight_data = weight_int4.data_ptr<uint8_t>();
+  const float* scales_data = weight_scales.data_ptr<float>();
+  auto dequant_row = [&](int64_t n, float* row) {
+    dequant_u4_row_ker<F>(
+        row,
+        weight_data + n * row_bytes,
+        scales_data + n * groups,
+        group_size,
+        K);
+    return 1.f;
+  };
+  woq_linear_fp32_kernel(
+      input, weight_int4.size(0), dequant_row, bias, output);
+}
+
+// Returns the fp32 result of the linear and the post ops of attr, accumu is
+// the destination of the sum post op.
+at::Tensor woq_linear_impl(
+    const at::Tensor& self,
+    const at::Tensor& weight_int8,
+    const at::Tensor& weight_scales,
+    const at::Tensor& bias,
+    const at::Tensor& accumu,
+    const ideep::attr_t& attr) {
+  TORCH_CHECK(
+      weight_int8.scalar_type() == at::kChar && weight_int8.dim() == 2 &&
+          weight_int8.is_contiguous(),
+      "woq_linear: the weight must be a contiguous 2-D int8 tensor");
+  TORCH_CHECK(
+      self.size(-1) == weight_int8.size(1),
+      "woq_linear: the input features don't match the weight");
+  auto input = self.reshape({-1, self.size(-1)}).to(at::kFloat).contiguous();
+  auto bias_ = bias.defined() ? bias.to(at::kFloat).contiguous() : bias;
+  auto scales = weight_scales.to(at::kFloat).contiguous();
+  auto output = at::empty(
+      {input.size(0), weight_int8.size(0)}, input.options().dtype(at::kFloat));
+  woq_linear_int8_fp32_kernel(input, weight_int8, scales, bias_, output);
+  return quantized_linear_post_ops(output, accumu, attr);
+}
+
+at::Tensor woq_linear_int4_impl(
+    const at::Tensor& self,
+    const at::Tensor& weight_int4,
+    const at::Tensor& weight_scales,
+    Int4Format format,
+    int64_t group_size,
+    const at::Tensor& bias,
+    const at::Tensor& accumu,
+    const ideep::attr_t& attr) {
+  TORCH_CHECK(
+      weight_int4.scalar_type() == at::kByte && weight_int4.dim() == 2 &&
+          weight_int4.is_contiguous(),
+      "woq_linear: the 4-bit weight must be a contiguous 2-D uint8 tensor");
+  const int64_t K = self.size(-1);
+  TORCH_CHECK(
+      weight_int4.size(1) == (K + 1) / 2 &&
+          weight_scales.size(0) == weight_int4.size(0) &&
+          weight_scales.size(1) * group_size == K,
+      "woq_linear: the input features don't match the 4-bit weight");
+  auto input = self.reshape({-1, K}).to(at::kFloat).contiguous();
+  auto bias_ = bias.defined() ? bias.to(at::kFloat).contiguous() : bias;
+  auto scales = weight_scales.to(at::kFloat).contiguous();
+  auto output = at::empty(
+      {input.size(0), weight_int4.size(0)}, input.options().dtype(at::kFloat));
+  if (format == Int4Format::NF4) {
+    woq_linear_int4_fp32_kernel<Int4Format::NF4>(
+        input, weight_int4, scales, group_size, bias_, output);
+  } else {
+    woq_linear_int4_fp32_kernel<Int4Format::INT4>(
+        input, weight_int4, scales, group_size, bias_, output);
+  }
+  return quantized_linear_post_ops(output, accumu, attr);
+}
+
+} // namespace
+
+at::Tensor quantized_linear_post_ops(
+    at::Tensor output,
+    const at::Tensor& accumu,
+    const ideep::attr_t& attr) {
+  auto post_ops = attr.get_post_ops();
+  for (int i = 0; i < post_ops.len(); i++) {
+    ideep::kind akind;
+    ideep::algorithm alg;
+    float scale = 1.0, alpha = 1.0, beta = 0.0;
+    std::tie(akind, scale, alpha, beta, alg) = attr.get_params(i);
+    if (akind == ideep::kind::sum) {
+      TORCH_CHECK(
+          accumu.defined(), "quantized linear: sum post op needs accumu");
+      output.add_(accumu.reshape(output.sizes()), scale);
+      continue;
+    }
+    TORCH_CHECK(
+        akind == ideep::kind::eltwise, "quantized linear: unsupported post op");
+    if (alg == ideep::algorithm::eltwise_relu && alpha == 0.f) {
+      output.relu_();
+    } else if (alg == ideep::algorithm::eltwise_gelu_erf) {
+      output = at::gelu(output);
+    } else {
+      TORCH_CHECK(false, "quantized linear: unsupported eltwise post op");
+    }
+    if (scale != 1.f) {
+      output.mul_(scale);
+    }
+  }
+  return output;
+}
+
+at::Tensor quantize_linear_weight_per_channel(const at::Tensor& weight) {
+  TORCH_CHECK(
+      weight.dim() == 2, "Only the 2-D linear weight can be quantized");
+  auto weight_ = weight.to(at::kFloat).contiguous();
+  // symmetric quantization, the zero points are 0
+  auto scales = std::get<0>(weight_.abs().max(1)).div(127.f).clamp_min(1e-8f);
+  auto zero_points =
+      at::zeros({weight_.size(0)}, weight_.options().dtype(at::kLong));
+  return at::quantize_per_channel(
+      weight_, scales.to(at::kDouble), zero_points, 0, at::kQInt8);
+}
+
+bool get_woq_int4_format(const std::string& dtype, Int4Format& format) {
+  if (dtype == "int4") {
+    format = Int4Format::INT4;
+    return true;
+  }
+  if (dtype == "nf4") {
+    format = Int4Format::NF4;
+    return true;
+  }
+  TORCH_CHECK(
+      dtype == "int8",
+      "Unsupported weight-only quantization dtype ",
+      dtype,
+      ", of which the valid ones are int8, int4 and nf4");
+  return false;
+}
+
+at::Tensor quantize_linear_weight_int4(
+    const at::Tensor& weight,
+    Int4Format format,
+    int64_t group_size) {
+  TORCH_CHECK(
+      weight.dim() == 2, "Only the 2-D linear weight can be quantized");
+  auto weight_ = weight.to(at::kFloat).contiguous();
+  const int64_t N = weight_.size(0);
+  const int64_t K = weight_.size(1);
+  if (group_size <= 0 || group_size % 2 != 0 || K % group_size != 0) {
+    group_size = K;
+  }
+  const int32_t header[2] = {
+      static_cast<int32_t>(format), static_cast<int32_t>(K / group_size)};
+  const int64_t groups = header[1];
+  const int64_t row_bytes = (K + 1) / 2;
+  const int64_t packed_row_bytes = std::max<int64_t>(
+      row_bytes + groups * sizeof(float), sizeof(header));
+  auto packed = at::zeros(
+      {N + 1, packed_row_bytes}, weight_.options().dtype(at::kByte));
+  const float* weight_data = weight_.data_ptr<float>();
+  uint8_t* packed_data = packed.data_ptr<uint8_t>();
+  std::memcpy(packed_data, header, sizeof(header));
+  at::parallel_for(0, N, 16, [&](int64_t begin, int64_t end) {
+    for (int64_t n = begin; n < end; n++) {
+      const float* w = weight_data + n * K;
+      uint8_t* row = packed_data + (n + 1) * packed_row_bytes;
+      for (int64_t g = 0; g < groups; g++) {
+        const int64_t k_begin = g * group_size;
+        float absmax = 0.f;
+        for (int64_t k = k_begin; k < k_begin + group_size; k++) {
+          absmax = std::max(absmax, std::abs(w[k]));
+        }
+        float scale = format == Int4Format::NF4 ? absmax : absmax / 7.f;
+        float inv_scale = scale > 0.f ? 1.f / scale : 0.f;
+        for (int64_t k = k_begin; k < k_begin + group_size; k++) {
+          float x = w[k] * inv_scale;
+          int32_t q = 0;
+          if (format == Int4Format::NF4) {
+            // the nearest of the levels
+            for (int32_t i = 1; i < 16; i++) {
+              if (std::abs(kNF4Levels[i] - x) < std::abs(kNF4Levels[q] - x)) {
+                q = i;
+              }
+            }
+          } else {
+            q = static_cast<int32_t>(
+                    std::nearbyint(std::min(std::max(x, -8.f), 7.f))) +
+                8;
+          }
+          row[k / 2] |= static_cast<uint8_t>(q << ((k % 2) * 4));
+        }
+        std::memcpy(
+            row + row_bytes + g * sizeof(float), &scale, sizeof(float));
+      }
+    }
+  });
+  return packed;
+}
+
+bool is_linear_weight_int4(
+    const at::Tensor& weight,
+    int64_t out_features,
+    int64_t in_features) {
+  if (weight.scalar_type() != at::kByte || weight.dim() != 2 ||
+      weight.size(0) != out_features + 1 || weight.size(1) < 8) {
+    return false;
+  }
+  int32_t header[2];
+  std::memcpy(header, weight.contiguous().data_ptr<uint8_t>(), sizeof(header));
+  int64_t groups = header[1];
+  return (header[0] == static_cast<int32_t>(Int4Format::INT4) ||
+          header[0] == static_cast<int32_t>(Int4Format::NF4)) &&
+      groups > 0 && in_features % groups == 0 &&
+      weight.size(1) >= (in_features + 1) / 2 + groups * 4;
+}
+
+void unpack_linear_weight_int4(
+    const at::Tensor& weight,
+    int64_t in_features,
+    at::Tensor& weight_int4,
+    at::Tensor& weight_scales,
+    Int4Format& format,
+    int64_t& group_size) {
+  auto packed = weight.contiguous();
+  const uint8_t* packed_data = packed.data_ptr<uint8_t>();
+  int32_t header[2];
+  std::memcpy(header, packed_data, sizeof(header));
+  format = static_cast<Int4Format>(header[0]);
+  const int64_t groups = header[1];
+  group_size = in_features / groups;
+  const int64_t N = packed.size(0) - 1;
+  const int64_t row_bytes = (in_features + 1) / 2;
+  const int64_t packed_row_bytes = packed.size(1);
+  weight_int4 = packed.narrow(0, 1, N).narrow(1, 0, row_bytes).contiguous();
+  weight_scales = at::empty({N, groups}, packed.options().dtype(at::kFloat));
+  float* scales_data = weight_scales.data_ptr<float>();
+  for (int64_t n = 0; n < N; n++) {
+    std::memcpy(
+        scales_data + n * groups,
+        packed_data + (n + 1) * packed_row_bytes + row_bytes,
+        groups * sizeof(float));
+  }
+}
+
+at::Tensor woq_linear_kernel(
+    const at::Tensor& self,
+    const at::Tensor& weight_int8,
+    const at::Tensor& weight_scales,
+    const at::Tensor& bias,
+    const ideep::attr_t& attr) {
+  auto output = woq_linear_impl(
+      self, weight_int8, weight_scales, bias, at::Tensor(), attr);
+  auto output_size = self.sizes().vec();
+  output_size.back() = weight_int8.size(0);
+  return output.to(self.scalar_type()).reshape(output_size);
+}
+
+void woq_linear_kernel_output(
+    const at::Tensor& self,
+    const at::Tensor& weight_int8,
+    const at::Tensor& weight_scales,
+    const at::Tensor& bias,
+    at::Tensor& output,
+    const ideep::attr_t& attr) {
+  auto result =
+      woq_linear_impl(self, weight_int8, weight_scales, bias, output, attr);
+  output.copy_(result.reshape(output.sizes()));
+}
+
+at::Tensor woq_linear_int4_kernel(
+    const at::Tensor& self,
+    const at::Tensor& weight_int4,
+    const at::Tensor& weight_scales,
+    Int4Format format,
+    int64_t group_size,
+    const at::Tensor& bias,
+    const ideep::attr_t& attr) {
+  auto output = woq_linear_int4_impl(
+      self,
+      weight_int4,
+      weight_scales,
+      format,
+      group_size,
+      bias,
+      at::Tensor(),
+      attr);
+  auto output_size = self.sizes().vec();
+  output_size.back() = weight_int4.size(0);
+  return output.to(self.scalar_type()).reshape(output_size);
+}
+
+void woq_linear_int4_kernel_output(
+    const at::Tensor& self,
+    const at::Tensor& weight_int4,
+    const at::Tensor& weight_scales,
+    Int4Format format,
+    int64_t group_size,
+    const at::Tensor& bias,
+    at::Tensor& output,
+    const ideep::attr_t& attr) {
+  auto result = woq_linear_int4_impl(
+      self, weight_int4, weight_scales, format, group_size, bias, output, attr);
+  output.copy_(result.reshape(output.sizes()));
+}
+
+} // namespace cpu
+} // namespace torch_ipex
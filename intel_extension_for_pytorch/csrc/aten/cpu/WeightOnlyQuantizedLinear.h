@@ -0,0 +1,109 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+#include <string>
+
+#include "csrc/cpu/ideep/ideep.hpp"
+#include "csrc/cpu/vec512/int4/vec/int4_vec_kernel.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+// Quantize the plain fp32/bf16 linear weight [out_features, in_features] to a
+// per-channel symmetric qint8 tensor, with one scale per output channel.
+at::Tensor quantize_linear_weight_per_channel(const at::Tensor& weight);
+
+// Returns true and the format of the 4-bit weight-only quantization dtype,
+// i.e. "int4" or "nf4", false if dtype is "int8".
+bool get_woq_int4_format(const std::string& dtype, Int4Format& format);
+
+// Quantize the plain fp32/bf16 linear weight [out_features, in_features] to
+// the 4-bit int4 or nf4 of int4_vec_kernel.h, with one scale per group of
+// group_size input features of each output channel. The scale of a group is
+// its absmax divided by 7 for int4, and its absmax for nf4. The weight is
+// quantized per channel if group_size is not an even divisor of in_features.
+// Returns the uint8 [out_features + 1, row_bytes], of which the first row is
+// the int32 format and number of groups, and each of the others is the packed
+// (in_features + 1) / 2 bytes of an output channel followed by the float
+// scales of its groups.
+at::Tensor quantize_linear_weight_int4(
+    const at::Tensor& weight,
+    Int4Format format,
+    int64_t group_size);
+
+// Returns true if weight is created by quantize_linear_weight_int4 of the
+// weight [out_features, in_features].
+bool is_linear_weight_int4(
+    const at::Tensor& weight,
+    int64_t out_features,
+    int64_t in_features);
+
+// Splits the weight of quantize_linear_weight_int4 into the packed weight
+// [out_features, (in_features + 1) / 2] and the scales [out_features, groups]
+// of its format and group size.
+void unpack_linear_weight_int4(
+    const at::Tensor& weight,
+    int64_t in_features,
+    at::Tensor& weight_int4,
+    at::Tensor& weight_scales,
+    Int4Format& format,
+    int64_t& group_size);
+
+// Applies the post ops of attr (sum, relu and gelu) to the fp32 output of a
+// quantized linear, accumu is the destination of the sum post op.
+at::Tensor quantized_linear_post_ops(
+    at::Tensor output,
+    const at::Tensor& accumu,
+    const ideep::attr_t& attr);
+
+// Linear with the int8 weight [out_features, in_features] and its fp32
+// per-channel scales, while the input and the output stay in fp32/bf16. The
+// weight is dequantized on the fly, so that only the int8 weight is read from
+// memory. It targets the memory bandwidth bound linear with a small batch,
+// e.g. of the decoder of a transformer. The post ops of attr (sum, relu and
+// gelu) are applied to the output.
+at::Tensor woq_linear_kernel(
+    const at::Tensor& self,
+    const at::Tensor& weight_int8,
+    const at::Tensor& weight_scales,
+    const at::Tensor& bias,
+    const ideep::attr_t& attr);
+
+// The inplace version of woq_linear_kernel, the result is written into output,
+// e.g. Linear+Add fusion.
+void woq_linear_kernel_output(
+    const at::Tensor& self,
+    const at::Tensor& weight_int8,
+    const at::Tensor& weight_scales,
+    const at::Tensor& bias,
+    at::Tensor& output,
+    const ideep::attr_t& attr);
+
+// woq_linear_kernel of the 4-bit weight of unpack_linear_weight_int4, i.e.
+// the packed weight [out_features, (in_features + 1) / 2] of format with the
+// scales [out_features, groups] of its groups of group_size input features.
+// Each row of the weight is dequantized once by the microkernels of
+// int4_vec_kernel.h and used by all the rows of the input.
+at::Tensor woq_linear_int4_kernel(
+    const at::Tensor& self,
+    const at::Tensor& weight_int4,
+    const at::Tensor& weight_scales,
+    Int4Format format,
+    int64_t group_size,
+    const at::Tensor& bias,
+    const ideep::attr_t& attr);
+
+// The inplace version of woq_linear_int4_kernel.
+void woq_linear_int4_kernel_output(
+    const at::Tensor& self,
+    const at::Tensor& weight_int4,
+    const at::Tensor& weight_scales,
+    Int4Format format,
+    int64_t group_size,
+    const at::Tensor& bias,
+    at::Tensor& output,
+    const ideep::attr_t& attr);
+
+} // namespace cpu
+} // namespace torch_ipex
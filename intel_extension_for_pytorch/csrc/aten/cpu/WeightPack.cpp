@@ -1,8 +1,10 @@
+#include <ATen/Parallel.h>
 #include <torch/extension.h>
 
 #include "WeightPack.h"
+#include "PackedWeightCache.h"
+#include "PackedWeightSerialization.h"
 #include "csrc/cpu/ideep/IDeepConversions.h"
-#include "csrc/utils/rw_lock.h"
 #include "csrc/utils/utils.h"
 
 namespace torch_ipex {
@@ -10,31 +12,137 @@ namespace cpu {
 
 namespace {
 
-using weakref_type =
-    c10::weak_intrusive_ptr<c10::TensorImpl, c10::UndefinedTensorImpl>;
-using val_blocked = std::tuple<weakref_type, ideep::tensor>;
-std::unordered_map<c10::TensorImpl*, val_blocked> cached_weights;
-
-using map_iter =
-    std::unordered_map<c10::TensorImpl*, val_blocked>::const_iterator;
-
-torch_ipex::ReadWriteMutex rwmutex;
-
 ideep::tensor read_cached_weights(const at::Tensor& weight) {
-  torch_ipex::UniqueReadLock<torch_ipex::ReadWriteMutex> lock(rwmutex);
   ideep::tensor cached_weight;
-  auto it = cached_weights.find(weight.unsafeGetTensorImpl());
-  if (it != cached_weights.end()) {
-    cached_weight = std::get<1>(it->second);
-  }
+  PackedWeightCache::get_instance().find(weight, cached_weight);
   return cached_weight;
 }
 
 void write_cached_weights(const at::Tensor& weight, ideep::tensor& result) {
-  torch_ipex::UniqueWriteLock<torch_ipex::ReadWriteMutex> lock(rwmutex);
-  cached_weights.emplace(
-      weight.unsafeGetTensorImpl(),
-      val_blocked{weakref_type(weight.getIntrusivePtr()), result});
+  PackedWeightCache::get_instance().insert(weight, result);
+}
+
+// Pack num_weights weights by pack(i) across the OMP threads. The reorder of
+// each weight runs on a single thread inside the parallel region, so that
+// the many small layers of a model are packed at the same time instead of
+// one after another.
+template <typename PackFunc>
+std::vector<at::Tensor> pack_weights_in_parallel(
+    int64_t num_weights,
+    const PackFunc& pack) {
+  std::vector<at::Tensor> outputs(num_weights);
+  at::parallel_for(0, num_weights, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; i++) {
+      outputs[i] = pack(i);
+    }
+  });
+  return outputs;
+}
+
+void check_batch_args(
+    const char* name,
+    int64_t num_weights,
+    at::IntArrayRef args,
+    int64_t num_values) {
+  TORCH_CHECK(
+      static_cast<int64_t>(args.size()) == num_weights * num_values,
+      name,
+      " should hold ",
+      num_values,
+      " values for each of the ",
+      num_weights,
+      " weights, but got ",
+      args.size());
+}
+
+// View the float tensor t as the bfloat16 tensor made of the top (higher) or
+// the trail (lower) 16 bits of each of its elements, i.e. the halves of the
+// split master weight of bfloat16 training. It assumes a little endian cpu.
+ideep::tensor bfloat16_half_view(const at::Tensor& t, bool top) {
+  TORCH_CHECK(
+      t.scalar_type() == at::kFloat,
+      "expected a float weight to split into bfloat16 halves");
+  auto strides = t.strides().vec();
+  for (auto& s : strides) {
+    s *= 2;
+  }
+  ideep::tensor::desc half_desc(
+      t.sizes().vec(), ideep::data_type::bf16, strides);
+  auto data =
+      static_cast<char*>(t.data_ptr()) + (top ? sizeof(c10::BFloat16) : 0);
+  return ideep::tensor(half_desc, data);
+}
+
+// Check the dtypes of the plain weight and its packed weight, returns true if
+// the packed weight is split into the bfloat16 top half packed and the trail
+// half packed_trail of the float plain weight.
+bool check_packed_weight_dtypes(
+    const at::Tensor& plain,
+    const at::Tensor& packed,
+    const c10::optional<at::Tensor>& packed_trail) {
+  if (!packed_trail.has_value() || !packed_trail.value().defined()) {
+    TORCH_CHECK(
+        plain.scalar_type() == packed.scalar_type(),
+        "expected the plain weight and the packed weight to have the same "
+        "dtype");
+    return false;
+  }
+  TORCH_CHECK(
+      plain.scalar_type() == at::kFloat &&
+          packed.scalar_type() == at::kBFloat16 &&
+          packed_trail.value().scalar_type() == at::kBFloat16,
+      "expected a float plain weight for the bfloat16 top and trail halves "
+      "of the packed weight");
+  TORCH_CHECK(
+      packed.sizes() == packed_trail.value().sizes(),
+      "expected the top and trail halves of the packed weight to have the "
+      "same sizes");
+  return true;
+}
+
+void check_packed_weight_buffer(
+    const at::Tensor& packed,
+    const ideep::tensor::desc& expected_desc) {
+  TORCH_CHECK(
+      packed.is_contiguous() && packed.nbytes() == expected_desc.get_size(),
+      "the buffer of the packed weight doesn't match the packed format of "
+      "the weight");
+}
+
+// Reorder the plain weight into the packed weight, or into its top and trail
+// halves if packed_trail is given. as_weights turns a view of the plain
+// weight into the weights layout of the packed weight.
+template <typename AsWeights>
+void reorder_plain_to_packed(
+    const at::Tensor& plain,
+    ideep::tensor& packed,
+    ideep::tensor* packed_trail,
+    const AsWeights& as_weights) {
+  if (packed_trail == nullptr) {
+    packed.feed_from(as_weights(itensor_view_from_dense(plain)));
+  } else {
+    packed.feed_from(as_weights(bfloat16_half_view(plain, true)));
+    packed_trail->feed_from(as_weights(bfloat16_half_view(plain, false)));
+  }
+}
+
+// The reverse of reorder_plain_to_packed.
+template <typename AsWeights>
+void reorder_packed_to_plain(
+    const ideep::tensor& packed,
+    const ideep::tensor* packed_trail,
+    const at::Tensor& plain,
+    const AsWeights& as_weights) {
+  if (packed_trail == nullptr) {
+    as_weights(itensor_view_from_dense(plain)).feed_from(packed);
+  } else {
+    as_weights(bfloat16_half_view(plain, true)).feed_from(packed);
+    as_weights(bfloat16_half_view(plain, false)).feed_from(*packed_trail);
+  }
+}
+
+ideep::tensor as_same_weights(ideep::tensor w) {
+  return w;
 }
 
 } // namespace
@@ -95,7 +203,26 @@ ideep::tensor get_conv_packed_weight(
     bool weight_packed,
     bool use_channels_last,
     at::IntArrayRef input_size,
-    const ideep::attr_t& attr) {
+    const ideep::attr_t& attr,
+    ideep::algorithm aalgorithm) {
+  if (is_serialized_packed_weight(weight)) {
+    // restore the packed weight saved by the packed weight serialization
+    auto w_dtype = get_serialized_packed_weight_desc(weight).get_data_type();
+    auto expected_desc = get_conv_expected_weights_desc(
+        weight_size.vec(),
+        w_dtype,
+        stride.vec(),
+        padding.vec(),
+        padding.vec(),
+        dilation.vec(),
+        groups,
+        input_size.empty() ? weight_is_channels_last : use_channels_last,
+        input_size.empty() ? ideep::algorithm::convolution_direct : aalgorithm,
+        w_dtype,
+        input_size.vec(),
+        attr);
+    return load_serialized_packed_weight(weight, expected_desc);
+  }
   auto data_type = weight.scalar_type();
   ideep::tensor packed_weight;
   if (weight_packed) {
@@ -130,7 +257,7 @@ ideep::tensor get_conv_packed_weight(
       dilation.vec(),
       groups,
       use_channels_last,
-      ideep::algorithm::convolution_direct,
+      aalgorithm,
       get_mkldnn_dtype(data_type),
       input_size.vec(),
       attr);
@@ -150,6 +277,39 @@ ideep::tensor get_conv_packed_weight(
   return expected_packed_weight;
 }
 
+ideep::tensor get_conv_packed_weight_for_input(
+    const ideep::tensor& packed_weight,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef dilation,
+    at::IntArrayRef weight_size,
+    int64_t groups,
+    bool use_channels_last,
+    at::IntArrayRef input_size,
+    const ideep::attr_t& attr,
+    ideep::algorithm aalgorithm) {
+  auto w_dtype = packed_weight.get_data_type();
+  auto expected_desc = get_conv_expected_weights_desc(
+      weight_size.vec(),
+      w_dtype,
+      stride.vec(),
+      padding.vec(),
+      padding.vec(),
+      dilation.vec(),
+      groups,
+      use_channels_last,
+      aalgorithm,
+      w_dtype,
+      input_size.vec(),
+      attr);
+  if (packed_weight.get_desc() == expected_desc) {
+    return packed_weight;
+  }
+  ideep::tensor expected_packed_weight{expected_desc};
+  expected_packed_weight.feed_from(packed_weight);
+  return expected_packed_weight;
+}
+
 at::Tensor conv2d_weight_pack(
     const at::Tensor& weight,
     at::IntArrayRef padding,
@@ -186,7 +346,8 @@ at::Tensor conv2d_weight_pack(
       is_channels_last);
   auto weight_dtype = w.get_data_type();
   expected_desc = expected_desc.to_type(weight_dtype);
-  auto output = empty_aten_tensor_from_desc(expected_desc, weight.options());
+  auto output = empty_aten_tensor_from_desc(
+      expected_desc, weight.options(), /*on_huge_pages=*/true);
   ideep::tensor y;
   if (ideep::data_type::f32 == weight_dtype) {
     y.init(expected_desc, output.template data_ptr<float>());
@@ -197,6 +358,29 @@ at::Tensor conv2d_weight_pack(
   return output;
 }
 
+std::vector<at::Tensor> conv2d_weight_pack_batch(
+    at::TensorList weights,
+    at::IntArrayRef padding,
+    at::IntArrayRef stride,
+    at::IntArrayRef dilation,
+    at::IntArrayRef groups,
+    c10::optional<at::ScalarType> dtype) {
+  int64_t num_weights = weights.size();
+  check_batch_args("padding", num_weights, padding, 2);
+  check_batch_args("stride", num_weights, stride, 2);
+  check_batch_args("dilation", num_weights, dilation, 2);
+  check_batch_args("groups", num_weights, groups, 1);
+  return pack_weights_in_parallel(num_weights, [&](int64_t i) {
+    return conv2d_weight_pack(
+        weights[i],
+        padding.slice(i * 2, 2),
+        stride.slice(i * 2, 2),
+        dilation.slice(i * 2, 2),
+        groups[i],
+        dtype);
+  });
+}
+
 at::Tensor conv2d_weight_unpack(
     const at::Tensor& weight,
     at::IntArrayRef padding,
@@ -314,15 +498,14 @@ std::tuple<ideep::tensor, ideep::tensor> get_lstm_packed_weight(
   }
   auto cached_weight_ih = read_cached_weights(weight_ih);
   auto cached_weight_hh = read_cached_weights(weight_hh);
+  // One of the weights may be evicted from the cache alone, pack both again.
   bool all_in_cache =
       !cached_weight_ih.is_empty() && !cached_weight_hh.is_empty();
-  bool all_miss = cached_weight_ih.is_empty() && cached_weight_hh.is_empty();
-  TORCH_CHECK(
-      all_in_cache || all_miss,
-      "both of the weights of LSTM should be "
-      "cached or neither should be cached");
 
-  if (cached_weight_ih.is_empty()) {
+  if (!all_in_cache) {
+    // Never init the packed weight shared with the cache.
+    cached_weight_ih = ideep::tensor();
+    cached_weight_hh = ideep::tensor();
     auto w1 = itensor_view_from_dense(
         weight_ih,
         {{1, 1, input_size, num_gates, hidden_size},
@@ -381,6 +564,108 @@ std::tuple<ideep::tensor, ideep::tensor> get_lstm_packed_weight(
   return std::make_tuple(cached_weight_ih, cached_weight_hh);
 }
 
+std::tuple<ideep::tensor, ideep::tensor> get_rnn_packed_weight(
+    const at::Tensor& weight_ih,
+    const at::Tensor& weight_hh,
+    ideep::rnn_kind mode,
+    int64_t input_size,
+    int64_t num_gates,
+    int64_t hidden_size,
+    const ideep::dims& output_sizes,
+    const ideep::tensor& src_layer,
+    const ideep::tensor& src_iter,
+    const ideep::tensor& bias,
+    const bool reverse) {
+  auto cached_weight_ih = read_cached_weights(weight_ih);
+  auto cached_weight_hh = read_cached_weights(weight_hh);
+  if (!cached_weight_ih.is_empty() && !cached_weight_hh.is_empty()) {
+    return std::make_tuple(cached_weight_ih, cached_weight_hh);
+  }
+
+  // MKLDNN GRU gates order is (zt, rt, nt) while PyTorch's is (rt, zt, nt)
+  auto shuffle = [&](const at::Tensor& weight) {
+    auto weight_t = weight.contiguous();
+    if (mode != ideep::rnn_kind::GRU) {
+      return weight_t;
+    }
+    auto gates = weight_t.chunk(3, /*gates*/ 0);
+    return at::cat({gates[1], gates[0], gates[2]}, /*gates*/ 0);
+  };
+  auto weight_ih_ = shuffle(weight_ih);
+  auto weight_hh_ = shuffle(weight_hh);
+  auto w1 = itensor_view_from_dense(
+      weight_ih_,
+      {{1, 1, input_size, num_gates, hidden_size},
+       get_mkldnn_dtype(weight_ih_.scalar_type()),
+       ideep::format_tag::ldgoi});
+  auto w2 = itensor_view_from_dense(
+      weight_hh_,
+      {{1, 1, hidden_size, num_gates, hidden_size},
+       get_mkldnn_dtype(weight_hh_.scalar_type()),
+       ideep::format_tag::ldgoi});
+
+  ideep::tensor::desc packed_desc_ih, packed_desc_hh;
+  if (mode == ideep::rnn_kind::GRU) {
+    std::tie(packed_desc_ih, packed_desc_hh) =
+        ideep::lbr_gru_forward_inference::expected_weights_desc(
+            output_sizes, src_layer, src_iter, w1, w2, bias, reverse);
+  } else {
+    std::tie(packed_desc_ih, packed_desc_hh) =
+        ideep::rnn_forward_inference::expected_weights_desc(
+            output_sizes, src_layer, src_iter, w1, w2, bias, mode, reverse);
+  }
+  // The reordered gates of GRU are temporaries, so the weights are always
+  // copied, and the plain ones are kept if the format is rnn_packed.
+  bool rnn_packed =
+      packed_desc_ih.is_rnn_packed() || packed_desc_hh.is_rnn_packed();
+  ideep::tensor packed_weight_ih, packed_weight_hh;
+  packed_weight_ih.init(rnn_packed ? w1.get_desc() : packed_desc_ih);
+  packed_weight_hh.init(rnn_packed ? w2.get_desc() : packed_desc_hh);
+  packed_weight_ih.feed_from(w1);
+  packed_weight_hh.feed_from(w2);
+  if (!rnn_packed) {
+    write_cached_weights(weight_ih, packed_weight_ih);
+    write_cached_weights(weight_hh, packed_weight_hh);
+  }
+  return std::make_tuple(packed_weight_ih, packed_weight_hh);
+}
+
+std::tuple<ideep::tensor::desc, ideep::tensor::desc>
+get_lstm_inference_packed_weight_desc(
+    const ideep::tensor& weight_ih,
+    const ideep::tensor& weight_hh,
+    const ideep::dims& output_sizes,
+    const ideep::tensor& src_layer,
+    const ideep::tensor& src_iter,
+    const ideep::tensor& src_iter_c,
+    const ideep::tensor& bias,
+    const bool reverse) {
+  ideep::tensor::desc packed_desc_ih, packed_desc_hh;
+  std::tie(packed_desc_ih, packed_desc_hh) =
+      ideep::lstm_forward_inference::expected_weights_desc(
+          output_sizes,
+          src_layer,
+          src_iter,
+          src_iter_c,
+          weight_ih,
+          weight_hh,
+          bias,
+          reverse);
+  // The rnn_packed format can't be reordered back to the public formats,
+  // see get_lstm_packed_weight.
+  if (packed_desc_ih.is_rnn_packed() || packed_desc_hh.is_rnn_packed()) {
+    packed_desc_ih = ideep::tensor::desc(
+        weight_ih.get_dims(),
+        weight_ih.get_data_type(),
+        ideep::format_tag::ldgoi);
+    packed_desc_hh = ideep::tensor::desc(
+        weight_hh.get_dims(),
+        weight_hh.get_data_type(),
+        ideep::format_tag::ldgoi);
+  }
+  return std::make_tuple(packed_desc_ih, packed_desc_hh);
+}
+
 at::Tensor linear_weight_pack(
     const at::Tensor& weight,
     c10::optional<at::ScalarType> dtype) {
@@ -414,7 +699,8 @@ at::Tensor linear_weight_pack(
   }
 
   // Case2: expected desc is block format
-  auto output = empty_aten_tensor_from_desc(expected_desc, weight.options());
+  auto output = empty_aten_tensor_from_desc(
+      expected_desc, weight.options(), /*on_huge_pages=*/true);
   ideep::tensor y;
   if (ideep::data_type::f32 == weight_dtype) {
     y.init(expected_desc, output.template data_ptr<float>());
@@ -425,6 +711,14 @@ at::Tensor linear_weight_pack(
   return output;
 }
 
+std::vector<at::Tensor> linear_weight_pack_batch(
+    at::TensorList weights,
+    c10::optional<at::ScalarType> dtype) {
+  return pack_weights_in_parallel(weights.size(), [&](int64_t i) {
+    return linear_weight_pack(weights[i], dtype);
+  });
+}
+
 at::Tensor linear_weight_unpack(
     const at::Tensor& weight,
     const int64_t out_features,
@@ -499,6 +793,12 @@ void sync_master_weight_to_bf16(
   w_bf16.feed_from(w_master);
 }
 
+// the channels last format of the 4-d deconv2d or the 5-d deconv3d weight
+static at::MemoryFormat conv_transpose_channels_last_format(int64_t dim) {
+  return dim == 5 ? at::MemoryFormat::ChannelsLast3d
+                  : at::MemoryFormat::ChannelsLast;
+}
+
 static ideep::tensor::desc get_conv_transpose2d_expected_weights_desc(
     const ideep::tensor::dims& weights_dims,
     ideep::tensor::data_type w_dtype = ideep::data_type::f32,
@@ -552,8 +852,8 @@ at::Tensor conv_transpose2d_weight_pack(
   auto weight_ = IS_CONTIGUOUS_ANY(weight)
       ? weight
       : weight.contiguous(weight.suggest_memory_format());
-  bool is_channels_last =
-      weight_.suggest_memory_format() == at::MemoryFormat::ChannelsLast;
+  bool is_channels_last = weight_.suggest_memory_format() ==
+      conv_transpose_channels_last_format(weight_.dim());
   auto w = itensor_view_from_dense(weight_);
 
   // get the format give data type.
@@ -573,7 +873,8 @@ at::Tensor conv_transpose2d_weight_pack(
 
   auto weight_dtype = w.get_data_type();
   expected_desc = expected_desc.to_type(weight_dtype);
-  auto output = empty_aten_tensor_from_desc(expected_desc, weight.options());
+  auto output = empty_aten_tensor_from_desc(
+      expected_desc, weight.options(), /*on_huge_pages=*/true);
   ideep::tensor y;
   if (ideep::data_type::f32 == weight_dtype) {
     y.init(expected_desc, output.template data_ptr<float>());
@@ -587,6 +888,32 @@ at::Tensor conv_transpose2d_weight_pack(
   return output;
 }
 
+std::vector<at::Tensor> conv_transpose2d_weight_pack_batch(
+    at::TensorList weights,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef output_padding,
+    at::IntArrayRef groups,
+    at::IntArrayRef dilation,
+    c10::optional<at::ScalarType> dtype) {
+  int64_t num_weights = weights.size();
+  check_batch_args("stride", num_weights, stride, 2);
+  check_batch_args("padding", num_weights, padding, 2);
+  check_batch_args("output_padding", num_weights, output_padding, 2);
+  check_batch_args("groups", num_weights, groups, 1);
+  check_batch_args("dilation", num_weights, dilation, 2);
+  return pack_weights_in_parallel(num_weights, [&](int64_t i) {
+    return conv_transpose2d_weight_pack(
+        weights[i],
+        stride.slice(i * 2, 2),
+        padding.slice(i * 2, 2),
+        output_padding.slice(i * 2, 2),
+        groups[i],
+        dilation.slice(i * 2, 2),
+        dtype);
+  });
+}
+
 ideep::tensor get_conv_transpose2d_packed_weight(
     const at::Tensor& weight,
     at::IntArrayRef stride,
@@ -599,6 +926,24 @@ ideep::tensor get_conv_transpose2d_packed_weight(
     bool use_channels_last,
     at::IntArrayRef input_size,
     const ideep::attr_t& attr) {
+  if (is_serialized_packed_weight(weight)) {
+    // restore the packed weight saved by the packed weight serialization
+    auto w_dtype = get_serialized_packed_weight_desc(weight).get_data_type();
+    auto expected_desc = get_conv_transpose2d_expected_weights_desc(
+        weight_size.vec(),
+        w_dtype,
+        stride.vec(),
+        padding.vec(),
+        padding.vec(),
+        dilation.vec(),
+        groups,
+        input_size.empty() ? weight_is_channels_last : use_channels_last,
+        ideep::algorithm::deconvolution_direct,
+        w_dtype,
+        input_size.vec(),
+        attr);
+    return load_serialized_packed_weight(weight, expected_desc);
+  }
   auto data_type = weight.scalar_type();
   ideep::tensor packed_weight;
   if (weight_packed) {
@@ -648,8 +993,9 @@ ideep::tensor get_conv_transpose2d_packed_weight(
     expected_packed_weight.feed_from(packed_weight);
     return expected_packed_weight;
   }
-  auto memory_format = use_channels_last ? at::MemoryFormat::ChannelsLast
-                                         : at::MemoryFormat::Contiguous;
+  auto memory_format = use_channels_last
+      ? conv_transpose_channels_last_format(weight.dim())
+      : at::MemoryFormat::Contiguous;
   auto weight_ = weight.contiguous(memory_format);
   ideep::tensor w = itensor_view_from_dense(weight_);
   w.transpose_(0, 1);
@@ -702,7 +1048,7 @@ at::Tensor conv_transpose2d_weight_unpack(
   // init output.
   at::Tensor result = at::empty(origin_weight_dims, weight.options());
   if (is_channels_last) {
-    result = result.to(at::MemoryFormat::ChannelsLast);
+    result = result.to(conv_transpose_channels_last_format(result.dim()));
   }
   auto y = itensor_view_from_dense(result);
   y.transpose_(0, 1);
@@ -711,6 +1057,327 @@ at::Tensor conv_transpose2d_weight_unpack(
   return result;
 }
 
+at::Tensor conv_transpose3d_weight_pack(
+    const at::Tensor& weight,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef output_padding,
+    int64_t groups,
+    at::IntArrayRef dilation,
+    c10::optional<at::ScalarType> dtype) {
+  TORCH_CHECK(
+      weight.dim() == 5,
+      "conv_transpose3d_weight_pack: expected the 5-d weight of deconv3d");
+  return conv_transpose2d_weight_pack(
+      weight, stride, padding, output_padding, groups, dilation, dtype);
+}
+
+at::Tensor conv_transpose3d_weight_unpack(
+    const at::Tensor& weight,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef output_padding,
+    int64_t groups,
+    at::IntArrayRef dilation,
+    at::IntArrayRef kernel_size,
+    int64_t output_channel,
+    int64_t input_channel,
+    bool is_channels_last,
+    c10::optional<at::ScalarType> dtype) {
+  TORCH_CHECK(
+      kernel_size.size() == 3,
+      "conv_transpose3d_weight_unpack: expected the 3-d kernel of deconv3d");
+  return conv_transpose2d_weight_unpack(
+      weight,
+      stride,
+      padding,
+      output_padding,
+      groups,
+      dilation,
+      kernel_size,
+      output_channel,
+      input_channel,
+      is_channels_last,
+      dtype);
+}
+
+at::Tensor& conv2d_weight_pack_out(
+    const at::Tensor& weight,
+    at::IntArrayRef padding,
+    at::IntArrayRef stride,
+    at::IntArrayRef dilation,
+    int64_t groups,
+    at::Tensor& out,
+    const c10::optional<at::Tensor>& out_trail,
+    c10::optional<at::ScalarType> dtype) {
+  bool is_split = check_packed_weight_dtypes(weight, out, out_trail);
+  // Same format as conv2d_weight_pack.
+  bool is_channels_last = weight.is_contiguous(at::MemoryFormat::ChannelsLast);
+  auto weight_ = IS_CONTIGUOUS_ANY(weight)
+      ? weight
+      : weight.contiguous(weight.suggest_memory_format());
+  auto out_dtype = get_mkldnn_dtype(out.scalar_type());
+  ideep::data_type desc_dtype =
+      dtype.has_value() ? get_mkldnn_dtype(dtype.value()) : out_dtype;
+  auto expected_desc = get_conv_expected_weights_desc(
+      weight_.sizes().vec(),
+      desc_dtype,
+      {stride.begin(), stride.end()},
+      {padding.begin(), padding.end()},
+      {padding.begin(), padding.end()},
+      {dilation.begin(), dilation.end()},
+      groups,
+      is_channels_last);
+  expected_desc = expected_desc.to_type(out_dtype);
+  check_packed_weight_buffer(out, expected_desc);
+  auto y = itensor_view_from_dense(out, expected_desc);
+  if (is_split) {
+    check_packed_weight_buffer(out_trail.value(), expected_desc);
+    auto y_trail = itensor_view_from_dense(out_trail.value(), expected_desc);
+    reorder_plain_to_packed(weight_, y, &y_trail, as_same_weights);
+  } else {
+    reorder_plain_to_packed(weight_, y, nullptr, as_same_weights);
+  }
+  return out;
+}
+
+at::Tensor& conv2d_weight_unpack_out(
+    const at::Tensor& weight,
+    const c10::optional<at::Tensor>& weight_trail,
+    at::IntArrayRef padding,
+    at::IntArrayRef stride,
+    at::IntArrayRef dilation,
+    at::IntArrayRef kernel_size,
+    int64_t groups,
+    int64_t output_channel,
+    int64_t input_channel,
+    bool is_channels_last,
+    at::Tensor& out,
+    c10::optional<at::ScalarType> dtype) {
+  bool is_split = check_packed_weight_dtypes(out, weight, weight_trail);
+  std::vector<int64_t> origin_weight_dims = {
+      output_channel, input_channel / groups};
+  origin_weight_dims.insert(
+      origin_weight_dims.end(), kernel_size.begin(), kernel_size.end());
+  TORCH_CHECK(
+      out.sizes() == at::IntArrayRef(origin_weight_dims),
+      "expected the output of conv2d_weight_unpack_out to have the sizes of "
+      "the original weight");
+  auto weight_dtype = get_mkldnn_dtype(weight.scalar_type());
+  // Same format as conv2d_weight_unpack.
+  ideep::data_type desc_dtype =
+      dtype.has_value() ? get_mkldnn_dtype(dtype.value()) : weight_dtype;
+  auto expected_desc = get_conv_expected_weights_desc(
+      {origin_weight_dims.begin(), origin_weight_dims.end()},
+      desc_dtype,
+      {stride.begin(), stride.end()},
+      {padding.begin(), padding.end()},
+      {padding.begin(), padding.end()},
+      {dilation.begin(), dilation.end()},
+      groups,
+      is_channels_last);
+  expected_desc = expected_desc.to_type(weight_dtype);
+  check_packed_weight_buffer(weight, expected_desc);
+  auto blocked_weight = itensor_view_from_dense(weight, expected_desc);
+  if (is_split) {
+    auto blocked_weight_trail =
+        itensor_view_from_dense(weight_trail.value(), expected_desc);
+    reorder_packed_to_plain(
+        blocked_weight, &blocked_weight_trail, out, as_same_weights);
+  } else {
+    reorder_packed_to_plain(blocked_weight, nullptr, out, as_same_weights);
+  }
+  return out;
+}
+
+// Get the desc of the packed linear weight, the packed weight is a plain 2-D
+// tensor if the desc is plain, see linear_weight_pack.
+static ideep::tensor::desc get_linear_packed_weight_desc(
+    int64_t out_features,
+    int64_t in_features,
+    ideep::data_type desc_dtype,
+    ideep::data_type weight_dtype) {
+  return ideep::inner_product_forward::expected_weights_desc(
+             {out_features, in_features},
+             /*input_size*/ {}, // pack weight without input, will use default
+                                // batchsize=128
+             /*dtype*/ desc_dtype, // assume input_dype is same with weight
+             /*input_dtype*/ desc_dtype)
+      .to_type(weight_dtype);
+}
+
+at::Tensor& linear_weight_pack_out(
+    const at::Tensor& weight,
+    at::Tensor& out,
+    const c10::optional<at::Tensor>& out_trail,
+    c10::optional<at::ScalarType> dtype) {
+  TORCH_CHECK(
+      weight.ndimension() == 2, "expected unpack weight which dim == 2");
+  TORCH_CHECK(
+      weight.is_contiguous() || is_transposed_2d(weight),
+      "ipex linear pack only support contiguous or transposed weight");
+  bool is_split = check_packed_weight_dtypes(weight, out, out_trail);
+  auto out_dtype = get_mkldnn_dtype(out.scalar_type());
+  ideep::data_type desc_dtype =
+      dtype.has_value() ? get_mkldnn_dtype(dtype.value()) : out_dtype;
+  auto expected_desc = get_linear_packed_weight_desc(
+      weight.size(0), weight.size(1), desc_dtype, out_dtype);
+  auto view_of = [&](const at::Tensor& packed) {
+    if (expected_desc.is_plain()) {
+      TORCH_CHECK(
+          packed.sizes() == weight.sizes(),
+          "expected the plain packed weight to have the sizes of the weight");
+      return itensor_view_from_dense(packed);
+    }
+    check_packed_weight_buffer(packed, expected_desc);
+    return itensor_view_from_dense(packed, expected_desc);
+  };
+  auto y = view_of(out);
+  if (is_split) {
+    auto y_trail = view_of(out_trail.value());
+    reorder_plain_to_packed(weight, y, &y_trail, as_same_weights);
+  } else {
+    reorder_plain_to_packed(weight, y, nullptr, as_same_weights);
+  }
+  return out;
+}
+
+at::Tensor& linear_weight_unpack_out(
+    const at::Tensor& weight,
+    const c10::optional<at::Tensor>& weight_trail,
+    const int64_t out_features,
+    const int64_t in_features,
+    at::Tensor& out,
+    c10::optional<at::ScalarType> dtype) {
+  bool is_split = check_packed_weight_dtypes(out, weight, weight_trail);
+  TORCH_CHECK(
+      out.sizes() == at::IntArrayRef({out_features, in_features}),
+      "expected the output of linear_weight_unpack_out to have the sizes of "
+      "the original weight");
+  auto weight_dtype = get_mkldnn_dtype(weight.scalar_type());
+  ideep::data_type desc_dtype =
+      dtype.has_value() ? get_mkldnn_dtype(dtype.value()) : weight_dtype;
+  auto expected_desc = get_linear_packed_weight_desc(
+      out_features, in_features, desc_dtype, weight_dtype);
+  // packed weight is public format if it is 2-D, see linear_weight_unpack
+  auto view_of = [&](const at::Tensor& packed) {
+    if (packed.ndimension() == 2) {
+      return itensor_view_from_dense(packed);
+    }
+    check_packed_weight_buffer(packed, expected_desc);
+    return itensor_view_from_dense(packed, expected_desc);
+  };
+  auto blocked_weight = view_of(weight);
+  if (is_split) {
+    auto blocked_weight_trail = view_of(weight_trail.value());
+    reorder_packed_to_plain(
+        blocked_weight, &blocked_weight_trail, out, as_same_weights);
+  } else {
+    reorder_packed_to_plain(blocked_weight, nullptr, out, as_same_weights);
+  }
+  return out;
+}
+
+at::Tensor& conv_transpose2d_weight_pack_out(
+    const at::Tensor& weight,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef output_padding,
+    int64_t groups,
+    at::IntArrayRef dilation,
+    at::Tensor& out,
+    const c10::optional<at::Tensor>& out_trail,
+    c10::optional<at::ScalarType> dtype) {
+  bool is_split = check_packed_weight_dtypes(weight, out, out_trail);
+  // Same format as conv_transpose2d_weight_pack.
+  auto weight_ = IS_CONTIGUOUS_ANY(weight)
+      ? weight
+      : weight.contiguous(weight.suggest_memory_format());
+  bool is_channels_last =
+      weight_.suggest_memory_format() == at::MemoryFormat::ChannelsLast;
+  auto out_dtype = get_mkldnn_dtype(out.scalar_type());
+  ideep::data_type desc_dtype =
+      dtype.has_value() ? get_mkldnn_dtype(dtype.value()) : out_dtype;
+  auto expected_desc = get_conv_transpose2d_expected_weights_desc(
+      weight_.sizes().vec(),
+      desc_dtype,
+      {stride.begin(), stride.end()},
+      {padding.begin(), padding.end()},
+      {padding.begin(), padding.end()},
+      {dilation.begin(), dilation.end()},
+      groups,
+      is_channels_last);
+  expected_desc = expected_desc.to_type(out_dtype);
+  check_packed_weight_buffer(out, expected_desc);
+  auto as_deconv_weights = [groups](ideep::tensor w) {
+    w.transpose_(0, 1);
+    return w.make_grouped_weights(groups, true);
+  };
+  auto y = itensor_view_from_dense(out, expected_desc);
+  if (is_split) {
+    check_packed_weight_buffer(out_trail.value(), expected_desc);
+    auto y_trail = itensor_view_from_dense(out_trail.value(), expected_desc);
+    reorder_plain_to_packed(weight_, y, &y_trail, as_deconv_weights);
+  } else {
+    reorder_plain_to_packed(weight_, y, nullptr, as_deconv_weights);
+  }
+  return out;
+}
+
+at::Tensor& conv_transpose2d_weight_unpack_out(
+    const at::Tensor& weight,
+    const c10::optional<at::Tensor>& weight_trail,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef output_padding,
+    int64_t groups,
+    at::IntArrayRef dilation,
+    at::IntArrayRef kernel_size,
+    int64_t output_channel,
+    int64_t input_channel,
+    bool is_channels_last,
+    at::Tensor& out,
+    c10::optional<at::ScalarType> dtype) {
+  bool is_split = check_packed_weight_dtypes(out, weight, weight_trail);
+  std::vector<int64_t> origin_weight_dims = {
+      input_channel, output_channel / groups};
+  origin_weight_dims.insert(
+      origin_weight_dims.end(), kernel_size.begin(), kernel_size.end());
+  TORCH_CHECK(
+      out.sizes() == at::IntArrayRef(origin_weight_dims),
+      "expected the output of conv_transpose2d_weight_unpack_out to have the "
+      "sizes of the original weight");
+  auto weight_dtype = get_mkldnn_dtype(weight.scalar_type());
+  // Same format as conv_transpose2d_weight_unpack.
+  ideep::data_type desc_dtype =
+      dtype.has_value() ? get_mkldnn_dtype(dtype.value()) : weight_dtype;
+  auto expected_desc = get_conv_transpose2d_expected_weights_desc(
+      {origin_weight_dims.begin(), origin_weight_dims.end()},
+      desc_dtype,
+      {stride.begin(), stride.end()},
+      {padding.begin(), padding.end()},
+      {padding.begin(), padding.end()},
+      {dilation.begin(), dilation.end()},
+      groups,
+      is_channels_last);
+  expected_desc = expected_desc.to_type(weight_dtype);
+  check_packed_weight_buffer(weight, expected_desc);
+  auto as_deconv_weights = [groups](ideep::tensor w) {
+    w.transpose_(0, 1);
+    return w.make_grouped_weights(groups, true);
+  };
+  auto blocked_weight = itensor_view_from_dense(weight, expected_desc);
+  if (is_split) {
+    auto blocked_weight_trail =
+        itensor_view_from_dense(weight_trail.value(), expected_desc);
+    reorder_packed_to_plain(
+        blocked_weight, &blocked_weight_trail, out, as_deconv_weights);
+  } else {
+    reorder_packed_to_plain(blocked_weight, nullptr, out, as_deconv_weights);
+  }
+  return out;
+}
+
 } // namespace cpu
 } // namespace torch_ipex
 
@@ -721,19 +1388,48 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
       "conv2d_weight_pack(Tensor weight, int[] padding, int[] stride, int[] "
       "dilation, int groups, ScalarType? dtype=None) -> Tensor",
       torch_ipex::cpu::conv2d_weight_pack);
+  m.def(
+      "conv2d_weight_pack_batch(Tensor[] weights, int[] padding, int[] "
+      "stride, int[] dilation, int[] groups, ScalarType? dtype=None) -> "
+      "Tensor[]",
+      torch_ipex::cpu::conv2d_weight_pack_batch);
   m.def(
       "conv2d_weight_unpack(Tensor weight, int[] padding, int[] stride, "
       "int[] dilation, int[] kernel_size, int groups, int output_channel, "
       "int input_channel, bool is_channels_last, ScalarType? dtype=None) -> "
       "Tensor",
       torch_ipex::cpu::conv2d_weight_unpack);
+  m.def(
+      "conv2d_weight_pack_out(Tensor weight, int[] padding, int[] stride, "
+      "int[] dilation, int groups, Tensor(a!) out, Tensor(b!)? "
+      "out_trail=None, ScalarType? dtype=None) -> Tensor(a!)",
+      torch_ipex::cpu::conv2d_weight_pack_out);
+  m.def(
+      "conv2d_weight_unpack_out(Tensor weight, Tensor? weight_trail, int[] "
+      "padding, int[] stride, int[] dilation, int[] kernel_size, int groups, "
+      "int output_channel, int input_channel, bool is_channels_last, "
+      "Tensor(a!) out, ScalarType? dtype=None) -> Tensor(a!)",
+      torch_ipex::cpu::conv2d_weight_unpack_out);
   m.def(
       "linear_weight_pack(Tensor weight, ScalarType? dtype=None) -> Tensor",
       torch_ipex::cpu::linear_weight_pack);
+  m.def(
+      "linear_weight_pack_batch(Tensor[] weights, ScalarType? dtype=None) -> "
+      "Tensor[]",
+      torch_ipex::cpu::linear_weight_pack_batch);
   m.def(
       "linear_weight_unpack(Tensor weight, int out_features, int "
       "in_features, bool transposed, ScalarType? dtype=None) -> Tensor",
       torch_ipex::cpu::linear_weight_unpack);
+  m.def(
+      "linear_weight_pack_out(Tensor weight, Tensor(a!) out, Tensor(b!)? "
+      "out_trail=None, ScalarType? dtype=None) -> Tensor(a!)",
+      torch_ipex::cpu::linear_weight_pack_out);
+  m.def(
+      "linear_weight_unpack_out(Tensor weight, Tensor? weight_trail, int "
+      "out_features, int in_features, Tensor(a!) out, ScalarType? "
+      "dtype=None) -> Tensor(a!)",
+      torch_ipex::cpu::linear_weight_unpack_out);
   m.def(
       "sync_master_weight_to_bf16(Tensor master_weight, Tensor bf16_weight) "
       "-> ()",
@@ -743,12 +1439,41 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
       "padding, int[] output_padding, int groups, int[] dilation, "
       "ScalarType? dtype=None) -> Tensor",
       torch_ipex::cpu::conv_transpose2d_weight_pack);
+  m.def(
+      "conv_transpose2d_weight_pack_batch(Tensor[] weights, int[] stride, "
+      "int[] padding, int[] output_padding, int[] groups, int[] dilation, "
+      "ScalarType? dtype=None) -> Tensor[]",
+      torch_ipex::cpu::conv_transpose2d_weight_pack_batch);
   m.def(
       "conv_transpose2d_weight_unpack(Tensor weight, int[] stride, int[] "
       "padding, int[] output_padding, int groups, int[] dilation, int[] "
       "kernel_size, int output_channel, int input_channel, bool "
       "is_channels_last, ScalarType? dtype=None) -> Tensor",
       torch_ipex::cpu::conv_transpose2d_weight_unpack);
+  m.def(
+      "conv_transpose2d_weight_pack_out(Tensor weight, int[] stride, int[] "
+      "padding, int[] output_padding, int groups, int[] dilation, Tensor(a!) "
+      "out, Tensor(b!)? out_trail=None, ScalarType? dtype=None) -> "
+      "Tensor(a!)",
+      torch_ipex::cpu::conv_transpose2d_weight_pack_out);
+  m.def(
+      "conv_transpose2d_weight_unpack_out(Tensor weight, Tensor? "
+      "weight_trail, int[] stride, int[] padding, int[] output_padding, int "
+      "groups, int[] dilation, int[] kernel_size, int output_channel, int "
+      "input_channel, bool is_channels_last, Tensor(a!) out, ScalarType? "
+      "dtype=None) -> Tensor(a!)",
+      torch_ipex::cpu::conv_transpose2d_weight_unpack_out);
+  m.def(
+      "conv_transpose3d_weight_pack(Tensor weight, int[] stride, int[] "
+      "padding, int[] output_padding, int groups, int[] dilation, "
+      "ScalarType? dtype=None) -> Tensor",
+      torch_ipex::cpu::conv_transpose3d_weight_pack);
+  m.def(
+      "conv_transpose3d_weight_unpack(Tensor weight, int[] stride, int[] "
+      "padding, int[] output_padding, int groups, int[] dilation, int[] "
+      "kernel_size, int output_channel, int input_channel, bool "
+      "is_channels_last, ScalarType? dtype=None) -> Tensor",
+      torch_ipex::cpu::conv_transpose3d_weight_unpack);
 }
 
 } // namespace
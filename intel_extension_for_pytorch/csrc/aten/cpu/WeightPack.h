@@ -14,6 +14,8 @@ namespace cpu {
 // weight_is_channels_last works when weight_packed=true, and
 // use_channels_last only works when input_size is none-empty, it will force
 // weight to channels last when use_channels_last is true given a input size.
+// The weight is packed in the format of aalgorithm for the input size, e.g.
+// of the winograd convolution.
 ideep::tensor get_conv_packed_weight(
     const at::Tensor& weight,
     at::IntArrayRef stride,
@@ -25,7 +27,23 @@ ideep::tensor get_conv_packed_weight(
     bool weight_packed,
     bool use_channels_last,
     at::IntArrayRef input_size,
-    const ideep::attr_t& attr);
+    const ideep::attr_t& attr,
+    ideep::algorithm aalgorithm = ideep::algorithm::convolution_direct);
+
+// Get the conv packed weight in the format preferred by input_size, it
+// returns packed_weight itself if it is already in that format, otherwise a
+// new tensor reordered from packed_weight.
+ideep::tensor get_conv_packed_weight_for_input(
+    const ideep::tensor& packed_weight,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef dilation,
+    at::IntArrayRef weight_size,
+    int64_t groups,
+    bool use_channels_last,
+    at::IntArrayRef input_size,
+    const ideep::attr_t& attr,
+    ideep::algorithm aalgorithm = ideep::algorithm::convolution_direct);
 
 // pack convolution's weight according to dummy input.
 // weight: weight need to be packed
@@ -38,6 +56,17 @@ at::Tensor conv2d_weight_pack(
     int64_t groups,
     c10::optional<at::ScalarType> dtype);
 
+// Pack a batch of convolution weights in parallel, one weight per thread.
+// padding, stride and dilation hold 2 values per weight and groups holds 1
+// value per weight, flattened in the order of weights.
+std::vector<at::Tensor> conv2d_weight_pack_batch(
+    at::TensorList weights,
+    at::IntArrayRef padding,
+    at::IntArrayRef stride,
+    at::IntArrayRef dilation,
+    at::IntArrayRef groups,
+    c10::optional<at::ScalarType> dtype);
+
 // Unpack convolution's weight according to dummy input.
 at::Tensor conv2d_weight_unpack(
     const at::Tensor& weight,
@@ -51,6 +80,39 @@ at::Tensor conv2d_weight_unpack(
     bool is_channels_last,
     c10::optional<at::ScalarType> dtype);
 
+// Pack the plain weight into out, the existing packed weight of the same
+// layer created by conv2d_weight_pack, without allocating a new buffer. If
+// out_trail is given, the float weight is split into the bfloat16 top half
+// out and trail half out_trail, as for the split master weight of bfloat16
+// training.
+at::Tensor& conv2d_weight_pack_out(
+    const at::Tensor& weight,
+    at::IntArrayRef padding,
+    at::IntArrayRef stride,
+    at::IntArrayRef dilation,
+    int64_t groups,
+    at::Tensor& out,
+    const c10::optional<at::Tensor>& out_trail,
+    c10::optional<at::ScalarType> dtype);
+
+// Unpack the packed weight into out, e.g. a tensor mapped from a file,
+// without a temporary copy. out must have the sizes of the original weight,
+// in any dense memory format. If weight_trail is given, the bfloat16 top
+// half weight and trail half weight_trail are joined into the float out.
+at::Tensor& conv2d_weight_unpack_out(
+    const at::Tensor& weight,
+    const c10::optional<at::Tensor>& weight_trail,
+    at::IntArrayRef padding,
+    at::IntArrayRef stride,
+    at::IntArrayRef dilation,
+    at::IntArrayRef kernel_size,
+    int64_t groups,
+    int64_t output_channel,
+    int64_t input_channel,
+    bool is_channels_last,
+    at::Tensor& out,
+    c10::optional<at::ScalarType> dtype);
+
 // Get the linear's expected ideep weight tensor, the weight may be a 2-D tensor
 // or has benn packed to a n-D tensor, if it is a plain tensor, it will reorder
 // to a expected weight according queried desc of OneDNN linear, or if it is
@@ -75,6 +137,39 @@ std::tuple<ideep::tensor, ideep::tensor> get_lstm_packed_weight(
     const bool reverse,
     const bool train);
 
+// Get the packed weights of one GRU or vanilla RNN layer for the inference.
+// weight_ih and weight_hh are of the PyTorch gate order and are the keys of
+// the cache, the gates of GRU are reordered to the oneDNN order only when the
+// weights have to be packed. Like get_lstm_packed_weight, the weights of the
+// rnn_packed format are never cached.
+std::tuple<ideep::tensor, ideep::tensor> get_rnn_packed_weight(
+    const at::Tensor& weight_ih,
+    const at::Tensor& weight_hh,
+    ideep::rnn_kind mode,
+    int64_t input_size,
+    int64_t num_gates,
+    int64_t hidden_size,
+    const ideep::dims& output_sizes,
+    const ideep::tensor& src_layer,
+    const ideep::tensor& src_iter,
+    const ideep::tensor& bias,
+    const bool reverse);
+
+// Get the descs of the weights of one LSTM layer preferred by the inference
+// primitive of src_layer. Different from get_lstm_packed_weight, nothing is
+// packed or cached, and the plain ldgoi format is returned if the preferred
+// format is rnn_packed.
+std::tuple<ideep::tensor::desc, ideep::tensor::desc>
+get_lstm_inference_packed_weight_desc(
+    const ideep::tensor& weight_ih,
+    const ideep::tensor& weight_hh,
+    const ideep::dims& output_sizes,
+    const ideep::tensor& src_layer,
+    const ideep::tensor& src_iter,
+    const ideep::tensor& src_iter_c,
+    const ideep::tensor& bias,
+    const bool reverse);
+
 bool is_packed(const at::Tensor& weight);
 
 // pack linear's weight according to dummy input.
@@ -85,6 +180,11 @@ at::Tensor linear_weight_pack(
     const at::Tensor& weight,
     c10::optional<at::ScalarType> dtype);
 
+// Pack a batch of linear weights in parallel, one weight per thread.
+std::vector<at::Tensor> linear_weight_pack_batch(
+    at::TensorList weights,
+    c10::optional<at::ScalarType> dtype);
+
 // Unpack Linear's weight according to dummy input
 at::Tensor linear_weight_unpack(
     const at::Tensor& weight,
@@ -93,6 +193,22 @@ at::Tensor linear_weight_unpack(
     const bool original_weight_transposed,
     c10::optional<at::ScalarType> dtype);
 
+// In-place variants of linear_weight_pack and linear_weight_unpack, see
+// conv2d_weight_pack_out and conv2d_weight_unpack_out.
+at::Tensor& linear_weight_pack_out(
+    const at::Tensor& weight,
+    at::Tensor& out,
+    const c10::optional<at::Tensor>& out_trail,
+    c10::optional<at::ScalarType> dtype);
+
+at::Tensor& linear_weight_unpack_out(
+    const at::Tensor& weight,
+    const c10::optional<at::Tensor>& weight_trail,
+    const int64_t out_features,
+    const int64_t in_features,
+    at::Tensor& out,
+    c10::optional<at::ScalarType> dtype);
+
 ideep::tensor get_conv_transpose2d_packed_weight(
     const at::Tensor& weight,
     at::IntArrayRef stride,
@@ -115,5 +231,72 @@ at::Tensor conv_transpose2d_weight_pack(
     at::IntArrayRef dilation,
     c10::optional<at::ScalarType> dtype);
 
+// The conv_transpose2d_weight_pack and conv_transpose2d_weight_unpack of the
+// 5-d weights of deconv3d, of which the channels last weight is of
+// ChannelsLast3d.
+at::Tensor conv_transpose3d_weight_pack(
+    const at::Tensor& weight,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef output_padding,
+    int64_t groups,
+    at::IntArrayRef dilation,
+    c10::optional<at::ScalarType> dtype);
+
+at::Tensor conv_transpose3d_weight_unpack(
+    const at::Tensor& weight,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef output_padding,
+    int64_t groups,
+    at::IntArrayRef dilation,
+    at::IntArrayRef kernel_size,
+    int64_t output_channel,
+    int64_t input_channel,
+    bool is_channels_last,
+    c10::optional<at::ScalarType> dtype);
+
+// In-place variants of conv_transpose2d_weight_pack and
+// conv_transpose2d_weight_unpack, see conv2d_weight_pack_out and
+// conv2d_weight_unpack_out.
+at::Tensor& conv_transpose2d_weight_pack_out(
+    const at::Tensor& weight,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef output_padding,
+    int64_t groups,
+    at::IntArrayRef dilation,
+    at::Tensor& out,
+    const c10::optional<at::Tensor>& out_trail,
+    c10::optional<at::ScalarType> dtype);
+
+at::Tensor& conv_transpose2d_weight_unpack_out(
+    const at::Tensor& weight,
+    const c10::optional<at::Tensor>& weight_trail,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef output_padding,
+    int64_t groups,
+    at::IntArrayRef dilation,
+    at::IntArrayRef kernel_size,
+    int64_t output_channel,
+    int64_t input_channel,
+    bool is_channels_last,
+    at::Tensor& out,
+    c10::optional<at::ScalarType> dtype);
+
+// Pack a batch of conv_transpose2d weights in parallel, one weight per
+// thread. stride, padding, output_padding and dilation hold 2 values per
+// weight and groups holds 1 value per weight, flattened in the order of
+// weights.
+std::vector<at::Tensor> conv_transpose2d_weight_pack_batch(
+    at::TensorList weights,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef output_padding,
+    at::IntArrayRef groups,
+    at::IntArrayRef dilation,
+    c10::optional<at::ScalarType> dtype);
+
 } // namespace cpu
 } // namespace torch_ipex
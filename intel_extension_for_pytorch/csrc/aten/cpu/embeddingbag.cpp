@@ -5,7 +5,12 @@
 #include "csrc/cpu/vec512/int8/vec/int8_vec_kernel.h"
 #include "csrc/jit/cpu/kernels/Embeddingbag.h"
 #include "csrc/quantization/AutoCast.hpp"
+#include "csrc/utils/fast_path_stats.h"
+#include "csrc/utils/op_trace.h"
 #include "csrc/utils/rw_lock.h"
+#include "utils/emb_prefetch.h"
+#include "utils/op_thread_policy.h"
+#include "utils/radix_sort.h"
 
 #include <ATen/Parallel.h>
 #include <ATen/Tensor.h>
@@ -44,20 +49,46 @@ static inline bool is_bfloat16_tensor(const at::Tensor tensor_) {
   return false;
 }
 
-bool embedding_bag_fast_path_sum(
+enum EmbeddingBagFallback {
+  kStridedRows,
+  kUnsupportedDtype,
+  kScaleGradByFreq,
+  kSparseMaxMode,
+  kPerSampleWeights,
+};
+
+static fast_path::FastPathCounter emb_fast_path_counter(
+    "embedding_bag",
+    {"strided_rows",
+     "unsupported_dtype",
+     "scale_grad_by_freq",
+     "sparse_max_mode",
+     "per_sample_weights"});
+
+bool embedding_bag_fast_path(
     const at::Tensor weight,
     const c10::optional<at::Tensor> per_sample_weights,
     int64_t mode,
-    const c10::optional<int64_t> padding_idx) {
-  if ((mode != MODE_SUM) || (weight.stride(1) != 1))
-    return false;
+    bool scale_grad_by_freq,
+    bool sparse) {
+  auto& counter = emb_fast_path_counter;
+  if (weight.stride(1) != 1)
+    return counter.fallback(kStridedRows);
   if ((weight.scalar_type() != at::kFloat) &&
       (weight.scalar_type() != at::kBFloat16))
-    return false;
-  if (padding_idx.has_value() ||
-      (per_sample_weights.has_value() && per_sample_weights.value().defined()))
-    return false;
-  return true;
+    return counter.fallback(kUnsupportedDtype);
+  if (scale_grad_by_freq)
+    return counter.fallback(kScaleGradByFreq);
+  if (sparse && mode == MODE_MAX)
+    return counter.fallback(kSparseMaxMode);
+  // the weights of the sum of the weight dtype only, the others are left to
+  // the errors of aten
+  if (per_sample_weights.has_value() && per_sample_weights.value().defined() &&
+      (mode != MODE_SUM ||
+       per_sample_weights.value().scalar_type() != weight.scalar_type() ||
+       per_sample_weights.value().dim() != 1))
+    return counter.fallback(kPerSampleWeights);
+  return counter.hit();
 }
 
 template <typename T>
@@ -102,18 +133,35 @@ static inline at::Tensor _embedding_bag_index_add_select_fast(
 
   at::Tensor output = at::empty({output_size, src.size(1)}, src.options());
   auto* output_data = output.data_ptr<T>();
-  auto indices_accessor = indices.accessor<int64_t, 1>();
+  auto* indices_data = indices.data_ptr<int64_t>();
+  auto prefetch_distance = cpu::emb_prefetch_distance(ddim * sizeof(T));
+  // the output beyond half of the LLC is evicted before the next op reads it,
+  // of which the bags are summed into a row of the thread and written by the
+  // non-temporal stores
+  bool stream_output = cpu::use_stream_store(output.nbytes());
   at::parallel_for(0, output_size, 16, [&](int64_t start, int64_t end) {
+    std::vector<T> bag_buffer(stream_output ? ddim : 0);
+    // the rows of the next bags of this thread are prefetched as well
+    auto prefetch_end = offsets_data[end];
     for (int64_t i = start; i < end; i++) {
       auto* out_data_ptr = &output_data[i * ddim];
-      zero_ker((T*)out_data_ptr, ddim);
+      T* bag_ptr = stream_output ? bag_buffer.data() : out_data_ptr;
+      zero_ker(bag_ptr, ddim);
       auto inputs_start = offsets_data[i];
       auto inputs_end = offsets_data[i + 1];
       for (int64_t s = inputs_start; s < inputs_end; s++) {
-        T* select_data_ptr = &src_data[indices_accessor[s] * ddim];
-        add_ker((T*)out_data_ptr, (T*)select_data_ptr, ddim);
+        cpu::emb_prefetch_row(
+            src_data, indices_data, s, prefetch_end, ddim, prefetch_distance);
+        T* select_data_ptr = &src_data[indices_data[s] * ddim];
+        add_ker(bag_ptr, (T*)select_data_ptr, ddim);
+      }
+      if (stream_output) {
+        stream_move_ker(out_data_ptr, bag_ptr, ddim);
       }
     }
+    if (stream_output) {
+      _mm_sfence();
+    }
   });
 
   return output;
@@ -126,14 +174,19 @@ at::Tensor embedding_bag_impl(
     bool include_last_offset) {
   at::Tensor offsets_ =
       offsets.is_contiguous() ? offsets : offsets.contiguous();
+  at::Tensor indices_ =
+      indices.is_contiguous() ? indices : indices.contiguous();
 
+  // The work is the number of the gathered elements.
+  cpu::OpThreadGuard op_thread_guard(
+      cpu::ThreadPolicyOp::EmbeddingBag, indices.numel() * weight.size(1));
   at::Tensor output;
   if (is_bfloat16_tensor(weight)) {
     output = _embedding_bag_index_add_select_fast<at::BFloat16>(
-        indices, weight, offsets_, include_last_offset);
+        indices_, weight, offsets_, include_last_offset);
   } else {
     output = _embedding_bag_index_add_select_fast<float>(
-        indices, weight, offsets_, include_last_offset);
+        indices_, weight, offsets_, include_last_offset);
   }
   return output;
 }
@@ -215,21 +268,75 @@ static inline at::Tensor embedding_bag_sparse_backward_sum_fast(
   return _sparse_coo_tensor_unsafe(index, values, weight_size);
 }
 
-static inline int64_t count_and_map_uniq(
-    const at::TensorAccessor<int64_t, 1>& indices_accessor,
-    int64_t indices_length,
-    std::vector<int64_t>& indices_to_index,
-    std::vector<int64_t>& index_to_indices) {
-  int64_t u = 0;
-  for (int64_t i = 0; i < indices_length; i++) {
-    int64_t indices = indices_accessor[i];
-    if (indices_to_index[indices] == -1ull) {
-      indices_to_index[indices] = u;
-      index_to_indices[u] = indices;
-      u++;
-    }
+// The dense grad of the weight of the rows of indices, of which the index i is
+// of the row of grad of the bag offset2bag[i], scaled by scales[i] if scales
+// is not nullptr, e.g. of the per sample weights or of the mean.
+template <typename T>
+static inline at::Tensor embedding_bag_dense_backward_fast(
+    const at::Tensor& grad,
+    const at::Tensor& indices,
+    const int64_t* offset2bag,
+    const float* scales,
+    int num_weights) {
+  int64_t indices_numel = indices.numel();
+  int64_t ddim = grad.size(1);
+  if (indices_numel == 0) {
+    return at::zeros({num_weights, ddim}, grad.options());
   }
-  return u;
+  const int64_t* indices_data = indices.data_ptr<int64_t>();
+
+  // sort the (row, bag, scale) of the indices by the row, of which the cost
+  // is of the indices instead of a map of the num_weights rows
+  std::vector<Key_Value_Weight_Tuple<int>> pairs(indices_numel);
+  std::vector<Key_Value_Weight_Tuple<int>> pairs_tmp(indices_numel);
+  at::parallel_for(0, indices_numel, 0, [&](int64_t start, int64_t end) {
+    for (int64_t i = start; i < end; i++) {
+      pairs[i] = Key_Value_Weight_Tuple<int>(
+          indices_data[i], offset2bag[i], scales ? scales[i] : 1.f);
+    }
+  });
+  Key_Value_Weight_Tuple<int>* sorted = radix_sort_parallel<int>(
+      pairs.data(), pairs_tmp.data(), indices_numel, num_weights);
+
+  int64_t grad_stride0 = grad.stride(0);
+  at::Tensor index_grad_weight = at::zeros({num_weights, ddim}, grad.options());
+  T* gradout_data = index_grad_weight.data_ptr<T>();
+  T* grad_data = grad.data_ptr<T>();
+
+  // the sorted pairs are split into the chunks of about the same number of
+  // the indices, of which the bounds are moved to the start of the next row,
+  // so that each row is accumulated and written by one thread without a lock
+  int64_t n_chunks = std::min<int64_t>(at::get_num_threads(), indices_numel);
+  auto row_of = [&](int64_t i) { return std::get<0>(sorted[i]); };
+  auto chunk_begin = [&](int64_t c) {
+    int64_t i = indices_numel * c / n_chunks;
+    while (i > 0 && i < indices_numel && row_of(i) == row_of(i - 1)) {
+      i++;
+    }
+    return i;
+  };
+  at::parallel_for(0, n_chunks, 1, [&](int64_t start, int64_t end) {
+    std::vector<float> temp_grad_weight(ddim);
+    float* temp_output = temp_grad_weight.data();
+    for (int64_t c = start; c < end; c++) {
+      int64_t chunk_end = chunk_begin(c + 1);
+      for (int64_t i = chunk_begin(c); i < chunk_end;) {
+        int64_t row = row_of(i);
+        zero_ker(temp_output, ddim);
+        for (; i < chunk_end && row_of(i) == row; i++) {
+          T* grad_row = grad_data + std::get<1>(sorted[i]) * grad_stride0;
+          if (scales) {
+            madd_ker(temp_output, grad_row, ddim, std::get<2>(sorted[i]));
+          } else {
+            add_ker(temp_output, grad_row, ddim);
+          }
+        }
+        move_ker((T*)(gradout_data + row * ddim), temp_output, ddim);
+      }
+    }
+  });
+
+  return index_grad_weight;
 }
 
 template <typename T>
@@ -248,71 +355,10 @@ static inline at::Tensor embedding_bag_dense_backward_sum_fast(
     make_offset2bag(offsets, indices, offset2bag_);
     offset2bag_.resize_({indices.sizes()[0]});
   } else {
-    offset2bag_ = offsets;
-  }
-  auto indices_accessor = indices.accessor<int64_t, 1>();
-  std::vector<int64_t> indices_to_index(num_weights, -1ull);
-  std::vector<int64_t> index_to_indices;
-  index_to_indices.reserve(num_weights);
-  int64_t unique_indices = count_and_map_uniq(
-      indices_accessor, indices_numel, indices_to_index, index_to_indices);
-
-  int max_threads = at::get_num_threads();
-  max_threads = (unique_indices < max_threads) ? unique_indices : max_threads;
-  int64_t avg_chunk_down = unique_indices / max_threads;
-  std::vector<int64_t> chuck_size(max_threads);
-  std::vector<int64_t> chuck_sum_size(max_threads + 1);
-  for (auto i = 0; i < max_threads; i++) {
-    chuck_size[i] = avg_chunk_down;
-  }
-  // make chunk balance among threads as 211
-  for (auto i = 0; i < unique_indices % max_threads; i++) {
-    chuck_size[i] += 1;
+    offset2bag_ = offsets.contiguous();
   }
-  chuck_sum_size[0] = 0;
-  for (auto i = 1; i < max_threads; i++) {
-    chuck_sum_size[i] = chuck_sum_size[i - 1] + chuck_size[i - 1];
-  }
-  chuck_sum_size[max_threads] = unique_indices;
-
-  int64_t ddim = grad.size(1);
-
-  at::Tensor index_grad_weight = at::empty({num_weights, ddim}, grad.options());
-  T* gradout_data = index_grad_weight.data_ptr<T>();
-  zero_ker((T*)gradout_data, num_weights * ddim);
-
-  std::vector<float> temp_grad_weight(unique_indices * ddim);
-  float* temp_output = temp_grad_weight.data();
-  zero_ker(temp_output, unique_indices * ddim);
-
-  auto offset2bag_accessor = offset2bag_.accessor<int64_t, 1>();
-  T* grad_data = grad.data_ptr<T>();
-  at::parallel_for(0, max_threads, 0, [&](int64_t start, int64_t end) {
-    for (int k = start; k < end; k++) {
-      int64_t chunk_start = chuck_sum_size[k];
-      int64_t chunk_end = chuck_sum_size[k + 1];
-      for (int64_t mb = 0; mb < indices_numel; mb++) {
-        int64_t indices_num = indices_accessor[mb];
-        int64_t index = indices_to_index[indices_num];
-        if (index >= chunk_start && index < chunk_end) {
-          auto s = offset2bag_accessor[mb];
-          add_ker(
-              (float*)(temp_output + index * ddim),
-              (T*)(grad_data + s * ddim),
-              ddim);
-        }
-      }
-      for (int64_t index = chunk_start; index < chunk_end; index++) {
-        auto indices = index_to_indices[index];
-        move_ker(
-            (T*)(gradout_data + indices * ddim),
-            (float*)(temp_output + index * ddim),
-            ddim);
-      }
-    }
-  });
-
-  return index_grad_weight;
+  return embedding_bag_dense_backward_fast<T>(
+      grad, indices, offset2bag_.data_ptr<int64_t>(), nullptr, num_weights);
 }
 
 bool embedding_bag_backward_fast_path_sum(
@@ -385,10 +431,9 @@ class NewEmbeddingBagOp : public torch::autograd::Function<NewEmbeddingBagOp> {
       const at::Tensor& offsets,
       bool sparse,
       bool include_last_offset) {
-#if defined(IPEX_PROFILE_OP)
-    RECORD_FUNCTION(
+    IPEX_RECORD_FUNCTION(
         "IPEXEmbeddingBagOp::_forward", std::vector<c10::IValue>({}));
-#endif
+    IPEX_TRACE_OP_INPUTS(weight, indices, offsets);
     auto ret =
         embedding_bag_impl(weight, indices, offsets, include_last_offset);
     return ret;
@@ -400,10 +445,8 @@ class NewEmbeddingBagOp : public torch::autograd::Function<NewEmbeddingBagOp> {
       const at::Tensor& offsets,
       bool sparse,
       bool include_last_offset) {
-#if defined(IPEX_PROFILE_OP)
-    RECORD_FUNCTION(
+    IPEX_RECORD_FUNCTION(
         "IPEXEmbeddingBagOp::forward", std::vector<c10::IValue>({}));
-#endif
     at::AutoNonVariableTypeMode g;
     ctx->saved_data["sparse"] = sparse;
     auto ret = _forward(weight, indices, offsets, sparse, include_last_offset);
@@ -414,10 +457,8 @@ class NewEmbeddingBagOp : public torch::autograd::Function<NewEmbeddingBagOp> {
   static torch::autograd::tensor_list backward(
       torch::autograd::AutogradContext* ctx,
       torch::autograd::tensor_list grad_outputs) {
-#if defined(IPEX_PROFILE_OP)
-    RECORD_FUNCTION(
+    IPEX_RECORD_FUNCTION(
         "IPEXEmbeddingBagOp::backward", std::vector<c10::IValue>({}));
-#endif
     at::AutoNonVariableTypeMode g;
     auto saved = ctx->get_saved_variables();
     at::Tensor weight = saved[0];
@@ -451,6 +492,465 @@ at::Tensor embedding_bag(
       weight, indices, offsets, sparse, include_last_offset);
 }
 
+// The offsets of the bags with the end of the last bag, i.e. of
+// include_last_offset
+static inline at::Tensor offsets_with_last(
+    const at::Tensor& offsets,
+    int64_t indices_numel,
+    bool include_last_offset) {
+  auto offsets_ = offsets.contiguous();
+  if (include_last_offset) {
+    return offsets_;
+  }
+  return at::cat({offsets_, at::full({1}, indices_numel, offsets_.options())});
+}
+
+// out = max(out, in) of the fp32 row of a bag, of which argmax keeps the index
+// of the first max of each element
+template <typename T>
+static inline void max_ker(
+    float* out,
+    int64_t* argmax,
+    const T* in,
+    int64_t index,
+    int64_t len) {
+#pragma omp simd
+  for (int64_t j = 0; j < len; j++) {
+    float v = float(in[j]);
+    bool greater = v > out[j];
+    out[j] = greater ? v : out[j];
+    argmax[j] = greater ? index : argmax[j];
+  }
+}
+
+// The mean, max or per sample weighted sum of the bags of offsets (with the
+// end of the last bag), of which the indices of padding_idx are skipped and
+// the empty bags are zeros. The bags are pooled in fp32 and written once. The
+// index of the row of the max of each element is written to max_indices of
+// the max, -1 of an empty bag, as aten.
+template <typename T>
+static inline at::Tensor _embedding_bag_pooling_fast(
+    const at::Tensor& weight,
+    const at::Tensor& indices,
+    const at::Tensor& offsets,
+    const at::Tensor& per_sample_weights,
+    int64_t mode,
+    int64_t padding_idx,
+    at::Tensor& max_indices) {
+  int64_t ddim = weight.size(1);
+  int64_t output_size = offsets.numel() - 1;
+  T* weight_data = weight.data_ptr<T>();
+  int64_t* indices_data = indices.data_ptr<int64_t>();
+  const int64_t* offsets_data = offsets.data_ptr<int64_t>();
+  const T* psw_data =
+      per_sample_weights.defined() ? per_sample_weights.data_ptr<T>() : nullptr;
+  at::Tensor output = at::empty({output_size, ddim}, weight.options());
+  T* output_data = output.data_ptr<T>();
+  int64_t* max_indices_data = nullptr;
+  if (mode == MODE_MAX) {
+    max_indices = at::empty({output_size, ddim}, indices.options());
+    max_indices_data = max_indices.data_ptr<int64_t>();
+  }
+  auto prefetch_distance = cpu::emb_prefetch_distance(ddim * sizeof(T));
+  at::parallel_for(0, output_size, 16, [&](int64_t start, int64_t end) {
+    std::vector<float> bag_buffer(ddim);
+    float* bag_ptr = bag_buffer.data();
+    auto prefetch_end = offsets_data[end];
+    for (int64_t i = start; i < end; i++) {
+      int64_t* argmax =
+          max_indices_data ? max_indices_data + i * ddim : nullptr;
+      int64_t bag_size = 0;
+      zero_ker(bag_ptr, ddim);
+      for (int64_t s = offsets_data[i]; s < offsets_data[i + 1]; s++) {
+        cpu::emb_prefetch_row(
+            weight_data,
+            indices_data,
+            s,
+            prefetch_end,
+            ddim,
+            prefetch_distance);
+        int64_t index = indices_data[s];
+        if (index == padding_idx) {
+          continue;
+        }
+        T* row = weight_data + index * ddim;
+        if (mode != MODE_MAX) {
+          if (psw_data) {
+            madd_ker(bag_ptr, row, ddim, float(psw_data[s]));
+          } else {
+            add_ker(bag_ptr, row, ddim);
+          }
+        } else if (bag_size == 0) {
+          add_ker(bag_ptr, row, ddim);
+          std::fill(argmax, argmax + ddim, index);
+        } else {
+          max_ker(bag_ptr, argmax, row, index, ddim);
+        }
+        bag_size++;
+      }
+      if (argmax && bag_size == 0) {
+        std::fill(argmax, argmax + ddim, -1);
+      }
+      if (mode == MODE_MEAN && bag_size > 1) {
+        float scale = 1.f / bag_size;
+#pragma omp simd
+        for (int64_t j = 0; j < ddim; j++) {
+          bag_ptr[j] *= scale;
+        }
+      }
+      move_ker(output_data + i * ddim, bag_ptr, ddim);
+    }
+  });
+  return output;
+}
+
+// The bag and the scale of the grad of each index of the bags of offsets: the
+// weight of the index of the weighted sum, 1 / size of the bag of the mean,
+// and 0 of padding_idx.
+template <typename T>
+static inline void embedding_bag_index_scales(
+    const at::Tensor& indices,
+    const at::Tensor& offsets,
+    const at::Tensor& per_sample_weights,
+    int64_t mode,
+    int64_t padding_idx,
+    std::vector<int64_t>& offset2bag,
+    std::vector<float>& scales) {
+  const int64_t* indices_data = indices.data_ptr<int64_t>();
+  const int64_t* offsets_data = offsets.data_ptr<int64_t>();
+  const T* psw_data =
+      per_sample_weights.defined() ? per_sample_weights.data_ptr<T>() : nullptr;
+  offset2bag.resize(indices.numel());
+  scales.resize(indices.numel());
+  at::parallel_for(0, offsets.numel() - 1, 16, [&](int64_t start, int64_t end) {
+    for (int64_t b = start; b < end; b++) {
+      int64_t bag_size = 0;
+      for (int64_t s = offsets_data[b]; s < offsets_data[b + 1]; s++) {
+        bag_size += indices_data[s] != padding_idx;
+      }
+      float mean_scale = bag_size > 0 ? 1.f / bag_size : 0.f;
+      for (int64_t s = offsets_data[b]; s < offsets_data[b + 1]; s++) {
+        offset2bag[s] = b;
+        if (indices_data[s] == padding_idx) {
+          scales[s] = 0.f;
+        } else if (psw_data) {
+          scales[s] = float(psw_data[s]);
+        } else {
+          scales[s] = mode == MODE_MEAN ? mean_scale : 1.f;
+        }
+      }
+    }
+  });
+}
+
+// The sparse grad of the weight of the scaled grads of the bags of the
+// indices, of a row of values for each index as the sum backward, of which
+// the indices of padding_idx are dropped as aten.
+template <typename T>
+static inline at::Tensor embedding_bag_sparse_backward_scaled_fast(
+    const at::Tensor& grad,
+    const at::Tensor& indices,
+    const std::vector<int64_t>& offset2bag,
+    const std::vector<float>& scales,
+    int64_t num_weights,
+    int64_t padding_idx) {
+  int64_t indices_numel = indices.numel();
+  int64_t ddim = grad.size(1);
+  auto weight_size = std::array<int64_t, 2>{{num_weights, ddim}};
+  if (indices_numel == 0) {
+    return _sparse_coo_tensor_unsafe(
+        at::empty({1, 0}, indices.options()),
+        at::empty({0, ddim}, grad.options()),
+        weight_size);
+  }
+  at::Tensor values = at::empty({indices_numel, ddim}, grad.options());
+  T* values_data = values.data_ptr<T>();
+  T* grad_data = grad.data_ptr<T>();
+  int64_t grad_stride0 = grad.stride(0);
+  at::parallel_for(0, indices_numel, 16, [&](int64_t start, int64_t end) {
+    std::vector<float> temp_buffer(ddim);
+    float* temp = temp_buffer.data();
+    for (int64_t s = start; s < end; s++) {
+      zero_ker(temp, ddim);
+      madd_ker(temp, grad_data + offset2bag[s] * grad_stride0, ddim, scales[s]);
+      move_ker(values_data + s * ddim, temp, ddim);
+    }
+  });
+  if (padding_idx >= 0) {
+    auto kept = indices.ne(padding_idx).nonzero().squeeze(1);
+    return _sparse_coo_tensor_unsafe(
+        indices.index_select(0, kept).reshape({1, -1}),
+        values.index_select(0, kept),
+        weight_size);
+  }
+  return _sparse_coo_tensor_unsafe(
+      indices.reshape({1, -1}), values, weight_size);
+}
+
+// The dense grad of the weight of the max, of which each element of the grad
+// of a bag goes to the element of its max. The threads split the columns, so
+// that an element of the weight is updated by one thread without a lock.
+template <typename T>
+static inline at::Tensor embedding_bag_dense_backward_max_fast(
+    const at::Tensor& grad,
+    const at::Tensor& max_indices,
+    int64_t num_weights) {
+  int64_t output_size = grad.size(0);
+  int64_t ddim = grad.size(1);
+  int64_t grad_stride0 = grad.stride(0);
+  at::Tensor grad_weight = at::zeros({num_weights, ddim}, grad.options());
+  T* grad_weight_data = grad_weight.data_ptr<T>();
+  const T* grad_data = grad.data_ptr<T>();
+  const int64_t* max_indices_data = max_indices.data_ptr<int64_t>();
+  // the chunks of the columns are of whole cache lines of fp32
+  at::parallel_for(0, ddim, 16, [&](int64_t start, int64_t end) {
+    for (int64_t b = 0; b < output_size; b++) {
+      const int64_t* argmax = max_indices_data + b * ddim;
+      const T* grad_row = grad_data + b * grad_stride0;
+      for (int64_t j = start; j < end; j++) {
+        if (argmax[j] >= 0) {
+          T& g = grad_weight_data[argmax[j] * ddim + j];
+          g = T(float(g) + float(grad_row[j]));
+        }
+      }
+    }
+  });
+  return grad_weight;
+}
+
+// The grad of the per sample weights: the dot of the grad of the bag of each
+// index and the row of the index, and 0 of padding_idx.
+template <typename T>
+static inline at::Tensor embedding_bag_per_sample_weights_backward_fast(
+    const at::Tensor& grad,
+    const at::Tensor& weight,
+    const at::Tensor& indices,
+    const std::vector<int64_t>& offset2bag,
+    int64_t padding_idx) {
+  int64_t indices_numel = indices.numel();
+  int64_t ddim = grad.size(1);
+  int64_t grad_stride0 = grad.stride(0);
+  at::Tensor grad_psw = at::empty({indices_numel}, grad.options());
+  T* grad_psw_data = grad_psw.data_ptr<T>();
+  const T* grad_data = grad.data_ptr<T>();
+  const T* weight_data = weight.data_ptr<T>();
+  const int64_t* indices_data = indices.data_ptr<int64_t>();
+  at::parallel_for(0, indices_numel, 64, [&](int64_t start, int64_t end) {
+    for (int64_t s = start; s < end; s++) {
+      float dot = 0.f;
+      if (indices_data[s] != padding_idx) {
+        const T* grad_row = grad_data + offset2bag[s] * grad_stride0;
+        const T* row = weight_data + indices_data[s] * ddim;
+#pragma omp simd reduction(+ : dot)
+        for (int64_t j = 0; j < ddim; j++) {
+          dot += float(grad_row[j]) * float(row[j]);
+        }
+      }
+      grad_psw_data[s] = T(dot);
+    }
+  });
+  return grad_psw;
+}
+
+at::Tensor embedding_bag_pooling_impl(
+    const at::Tensor& weight,
+    const at::Tensor& indices,
+    const at::Tensor& offsets,
+    const at::Tensor& per_sample_weights,
+    int64_t mode,
+    int64_t padding_idx,
+    at::Tensor& max_indices) {
+  // The work is the number of the gathered elements.
+  cpu::OpThreadGuard op_thread_guard(
+      cpu::ThreadPolicyOp::EmbeddingBag, indices.numel() * weight.size(1));
+  if (is_bfloat16_tensor(weight)) {
+    return _embedding_bag_pooling_fast<at::BFloat16>(
+        weight,
+        indices,
+        offsets,
+        per_sample_weights,
+        mode,
+        padding_idx,
+        max_indices);
+  }
+  return _embedding_bag_pooling_fast<float>(
+      weight,
+      indices,
+      offsets,
+      per_sample_weights,
+      mode,
+      padding_idx,
+      max_indices);
+}
+
+template <typename T>
+static inline torch::autograd::tensor_list embedding_bag_pooling_backward(
+    const at::Tensor& grad,
+    const at::Tensor& weight,
+    const at::Tensor& indices,
+    const at::Tensor& offsets,
+    const at::Tensor& per_sample_weights,
+    const at::Tensor& max_indices,
+    int64_t mode,
+    int64_t padding_idx,
+    bool sparse,
+    bool psw_requires_grad) {
+  int64_t num_weights = weight.size(0);
+  if (mode == MODE_MAX) {
+    return {
+        embedding_bag_dense_backward_max_fast<T>(
+            grad, max_indices, num_weights),
+        at::Tensor()};
+  }
+  std::vector<int64_t> offset2bag;
+  std::vector<float> scales;
+  embedding_bag_index_scales<T>(
+      indices,
+      offsets,
+      per_sample_weights,
+      mode,
+      padding_idx,
+      offset2bag,
+      scales);
+  at::Tensor grad_weight = sparse
+      ? embedding_bag_sparse_backward_scaled_fast<T>(
+            grad, indices, offset2bag, scales, num_weights, padding_idx)
+      : embedding_bag_dense_backward_fast<T>(
+            grad, indices, offset2bag.data(), scales.data(), num_weights);
+  at::Tensor grad_psw = psw_requires_grad
+      ? embedding_bag_per_sample_weights_backward_fast<T>(
+            grad, weight, indices, offset2bag, padding_idx)
+      : at::Tensor();
+  return {grad_weight, grad_psw};
+}
+
+class EmbeddingBagPoolingOp
+    : public torch::autograd::Function<EmbeddingBagPoolingOp> {
+ public:
+  static at::Tensor _forward(
+      const at::Tensor& weight,
+      const at::Tensor& indices,
+      const at::Tensor& offsets,
+      const at::Tensor& per_sample_weights,
+      int64_t mode,
+      int64_t padding_idx,
+      at::Tensor& max_indices) {
+    IPEX_RECORD_FUNCTION(
+        "IPEXEmbeddingBagPoolingOp::_forward", std::vector<c10::IValue>({}));
+    IPEX_TRACE_OP_INPUTS(weight, indices, offsets);
+    return embedding_bag_pooling_impl(
+        weight,
+        indices,
+        offsets,
+        per_sample_weights,
+        mode,
+        padding_idx,
+        max_indices);
+  }
+
+  static at::Tensor forward(
+      torch::autograd::AutogradContext* ctx,
+      const at::Tensor& weight,
+      const at::Tensor& indices,
+      const at::Tensor& offsets,
+      const at::Tensor& per_sample_weights,
+      int64_t mode,
+      int64_t padding_idx,
+      bool sparse) {
+    IPEX_RECORD_FUNCTION(
+        "IPEXEmbeddingBagPoolingOp::forward", std::vector<c10::IValue>({}));
+    at::AutoNonVariableTypeMode g;
+    at::Tensor max_indices;
+    auto ret = _forward(
+        weight,
+        indices,
+        offsets,
+        per_sample_weights,
+        mode,
+        padding_idx,
+        max_indices);
+    ctx->saved_data["mode"] = mode;
+    ctx->saved_data["padding_idx"] = padding_idx;
+    ctx->saved_data["sparse"] = sparse;
+    ctx->saved_data["psw_requires_grad"] =
+        per_sample_weights.defined() && per_sample_weights.requires_grad();
+    ctx->save_for_backward(
+        {weight, indices, offsets, per_sample_weights, max_indices});
+    return ret;
+  }
+
+  static torch::autograd::tensor_list backward(
+      torch::autograd::AutogradContext* ctx,
+      torch::autograd::tensor_list grad_outputs) {
+    IPEX_RECORD_FUNCTION(
+        "IPEXEmbeddingBagPoolingOp::backward", std::vector<c10::IValue>({}));
+    at::AutoNonVariableTypeMode g;
+    auto saved = ctx->get_saved_variables();
+    int64_t mode = ctx->saved_data["mode"].toInt();
+    int64_t padding_idx = ctx->saved_data["padding_idx"].toInt();
+    bool sparse = ctx->saved_data["sparse"].toBool();
+    bool psw_requires_grad = ctx->saved_data["psw_requires_grad"].toBool();
+    at::Tensor grad = grad_outputs[0].contiguous();
+    auto backward = is_bfloat16_tensor(grad)
+        ? embedding_bag_pooling_backward<at::BFloat16>
+        : embedding_bag_pooling_backward<float>;
+    auto grads = backward(
+        grad,
+        saved[0],
+        saved[1],
+        saved[2],
+        saved[3],
+        saved[4],
+        mode,
+        padding_idx,
+        sparse,
+        psw_requires_grad);
+    return {
+        grads[0],
+        at::Tensor(),
+        at::Tensor(),
+        grads[1],
+        at::Tensor(),
+        at::Tensor(),
+        at::Tensor()};
+  }
+};
+
+at::Tensor embedding_bag_pooling(
+    const at::Tensor& weight,
+    const at::Tensor& indices,
+    const at::Tensor& offsets,
+    const c10::optional<at::Tensor>& per_sample_weights,
+    int64_t mode,
+    int64_t padding_idx,
+    bool sparse,
+    bool include_last_offset) {
+  TORCH_CHECK(
+      mode == MODE_SUM || mode == MODE_MEAN || mode == MODE_MAX,
+      "embedding_bag_pooling: unknown mode ",
+      mode);
+  TORCH_CHECK(
+      !(sparse && mode == MODE_MAX),
+      "embedding_bag_pooling: max mode does not support sparse weights");
+  auto indices_ = indices.contiguous();
+  auto offsets_ =
+      offsets_with_last(offsets, indices_.numel(), include_last_offset);
+  at::Tensor psw;
+  if (per_sample_weights.has_value() && per_sample_weights.value().defined()) {
+    TORCH_CHECK(
+        mode == MODE_SUM,
+        "embedding_bag_pooling: per_sample_weights are only of the sum mode");
+    psw = per_sample_weights.value().contiguous();
+  }
+  if (at::GradMode::is_enabled() &&
+      (weight.requires_grad() || (psw.defined() && psw.requires_grad())))
+    return EmbeddingBagPoolingOp::apply(
+        weight, indices_, offsets_, psw, mode, padding_idx, sparse);
+  at::Tensor max_indices;
+  return EmbeddingBagPoolingOp::_forward(
+      weight, indices_, offsets_, psw, mode, padding_idx, max_indices);
+}
+
 namespace cpu {
 
 at::Tensor embedding_bag_int8_impl(
@@ -459,6 +959,9 @@ at::Tensor embedding_bag_int8_impl(
     const at::Tensor& offsets,
     bool include_last_offset) {
   int64_t ddim = qweight.size(1);
+  // The work is the number of the gathered elements.
+  OpThreadGuard op_thread_guard(
+      ThreadPolicyOp::EmbeddingBag, indices.numel() * ddim);
   double scale = at::native::q_scale_quant(qweight);
   int8_t* qweight_data =
       reinterpret_cast<int8_t*>(qweight.data_ptr<at::qint8>());
@@ -545,6 +1048,13 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
           "offsets, bool sparse, bool include_last_offset) -> Tensor",
           c10::AliasAnalysisKind::PURE_FUNCTION),
       torch_ipex::embedding_bag);
+  m.def(
+      torch::schema(
+          "torch_ipex::embedding_bag_pooling(Tensor weight, Tensor indices, "
+          "Tensor offsets, Tensor? per_sample_weights, int mode, int "
+          "padding_idx, bool sparse, bool include_last_offset) -> Tensor",
+          c10::AliasAnalysisKind::PURE_FUNCTION),
+      torch_ipex::embedding_bag_pooling);
 }
 } // namespace
 
@@ -577,8 +1087,46 @@ at::Tensor embedding_bag(
   return op.call(casted_weight, indices, offsets, sparse, include_last_offset);
 }
 
+at::Tensor embedding_bag_pooling(
+    const at::Tensor& weight,
+    const at::Tensor& indices,
+    const at::Tensor& offsets,
+    const c10::optional<at::Tensor>& per_sample_weights,
+    int64_t mode,
+    int64_t padding_idx,
+    bool sparse,
+    bool include_last_offset) {
+  c10::impl::ExcludeDispatchKeyGuard no_autocastCPU(DispatchKey::AutocastCPU);
+  static auto op =
+      torch::Dispatcher::singleton()
+          .findSchemaOrThrow("torch_ipex::embedding_bag_pooling", "")
+          .typed<decltype(embedding_bag_pooling)>();
+#if defined(ENABLE_AUTOCAST_VERBOSE)
+  verbose::OpNameGuard op_name("embedding_bag_pooling");
+#endif
+  // bf16 of the inference only as embedding_bag, of the per sample weights
+  // of the dtype of the weight
+  bool cast_to_bfloat16 =
+      !at::GradMode::is_enabled() && at::kBFloat16 == get_autocast_dtype();
+  auto casted_weight =
+      cast_to_bfloat16 ? cpu_cached_cast(at::kBFloat16, weight) : weight;
+  auto casted_psw = cast_to_bfloat16
+      ? cpu_cached_cast(at::kBFloat16, per_sample_weights)
+      : per_sample_weights;
+  return op.call(
+      casted_weight,
+      indices,
+      offsets,
+      casted_psw,
+      mode,
+      padding_idx,
+      sparse,
+      include_last_offset);
+}
+
 TORCH_LIBRARY_IMPL(torch_ipex, AutocastCPU, m) {
   m.impl("embedding_bag", torch_ipex::autocast::embedding_bag);
+  m.impl("embedding_bag_pooling", torch_ipex::autocast::embedding_bag_pooling);
 }
 
 } // namespace autocast
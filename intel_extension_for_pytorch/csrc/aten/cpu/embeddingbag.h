@@ -10,10 +10,25 @@ at::Tensor embedding_bag(
     bool sparse,
     bool include_last_offset);
 
-bool embedding_bag_fast_path_sum(
+// The mean, max or per sample weighted sum of the bags, of which the indices
+// of padding_idx are skipped, -1 of none.
+at::Tensor embedding_bag_pooling(
+    const at::Tensor& weight,
+    const at::Tensor& indices,
+    const at::Tensor& offsets,
+    const c10::optional<at::Tensor>& per_sample_weights,
+    int64_t mode,
+    int64_t padding_idx,
+    bool sparse,
+    bool include_last_offset);
+
+// Whether torch.embedding_bag of the args goes to embedding_bag or
+// embedding_bag_pooling instead of aten.
+bool embedding_bag_fast_path(
     const at::Tensor weight,
     const c10::optional<at::Tensor> per_sample_weights,
     int64_t mode,
-    const c10::optional<int64_t> padding_idx);
+    bool scale_grad_by_freq,
+    bool sparse);
 
 } // namespace torch_ipex
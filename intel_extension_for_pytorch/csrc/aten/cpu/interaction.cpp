@@ -1,12 +1,16 @@
 // Copyright (c) Facebook, Inc. and its affiliates. All Rights Reserved.
 #include "interaction.h"
+#include "embeddingbag.h"
 #include "csrc/autocast/autocast_mode.h"
 #include "csrc/autocast/autocast_verbose.h"
 #include "csrc/cpu/ideep/IDeepConversions.h"
+#include "csrc/cpu/isa/cpu_feature.hpp"
+#include "csrc/cpu/isa/cpu_info.hpp"
 #include "csrc/cpu/vec512/bf16/vec/bf16_vec_kernel.h"
 #include "csrc/cpu/vec512/int8/vec/int8_vec_kernel.h"
 #include "csrc/jit/cpu/kernels/Interaction.h"
 #include "csrc/quantization/AutoCast.hpp"
+#include "csrc/utils/op_trace.h"
 
 #include <ATen/Parallel.h>
 #include <ATen/quantized/Quantizer.h>
@@ -20,28 +24,6 @@
 
 namespace torch_ipex {
 
-template <typename T>
-static inline void cat(
-    const T* in1,
-    const T* in2,
-    T* out,
-    size_t in1_size,
-    size_t in2_size) {
-  move_ker(out, in1, in1_size);
-  move_ker(&out[in1_size], in2, in2_size);
-}
-
-template <typename T>
-static inline void cat_backward(
-    const T* in,
-    T* out1,
-    T* out2,
-    size_t out1_size,
-    size_t out2_size) {
-  move_ker(out1, in, out1_size);
-  move_ker(out2, &in[out1_size], out2_size);
-}
-
 template <typename T>
 static inline void cat(
     T* out,
@@ -55,21 +37,6 @@ static inline void cat(
   }
 }
 
-template <typename T>
-static inline void cat_backward(
-    const T* in,
-    std::vector<T*>& out,
-    const std::vector<uint32_t>& feature_sizes,
-    int64_t bs) {
-  size_t offset = 0;
-  for (int j = 0; j < feature_sizes.size(); j++) {
-    // std::memcpy(&out[j][bs * feature_sizes[j]], &in[offset], feature_sizes[j]
-    // * sizeof(T));
-    move_ker(&out[j][bs * feature_sizes[j]], &in[offset], feature_sizes[j]);
-    offset += feature_sizes[j];
-  }
-}
-
 template <typename T>
 static inline void flat_triangle(const T* in, T* out, size_t size) {
   size_t offset = 0;
@@ -79,33 +46,218 @@ static inline void flat_triangle(const T* in, T* out, size_t size) {
   }
 }
 
-template <typename T>
-static inline void flat_triangle_backward(const T* in, T* out, size_t size) {
-  size_t offset = 0;
-  for (int i = 0; i < size * size; i++) {
-    out[i] = 0.f;
-  }
-  for (int i = 1; i < size; i++) {
-    move_ker(&out[i * size], &in[offset], i);
-    offset += i;
+// The samples of which the interaction matmuls are batched into one
+// primitive execution, so that oneDNN runs a brgemm over the block, on the
+// AMX tiles if the CPU has them, instead of a tiny matmul per sample. It is
+// of the tuning of the CPU, i.e. larger on the CPUs of larger L2.
+static inline int64_t interaction_block_size() {
+  return cpu::cpu_tuning().interaction_block_size;
+}
+
+// The gram matrices of the [block, vector_nums, vector_size] interaction
+// inputs, i.e. the batched matmul of the inputs by their transpose.
+struct InteractionMatmul {
+  ideep::tensor::desc lhs_desc;
+  ideep::tensor::desc rhs_desc;
+  ideep::tensor::desc res_desc;
+  dnnl::matmul prim;
+
+  InteractionMatmul(
+      int64_t block,
+      int64_t vector_nums,
+      int64_t vector_size,
+      ideep::tensor::data_type src_dtype,
+      ideep::tensor::data_type dst_dtype)
+      : lhs_desc(
+            {block, vector_nums, vector_size},
+            src_dtype,
+            {vector_nums * vector_size, vector_size, 1}),
+        rhs_desc(
+            {block, vector_size, vector_nums},
+            src_dtype,
+            {vector_nums * vector_size, 1, vector_size}),
+        res_desc(
+            {block, vector_nums, vector_nums},
+            dst_dtype,
+            {vector_nums * vector_nums, vector_nums, 1}),
+        prim(ideep::matmul_forward::primitive_desc(
+            {lhs_desc, rhs_desc, res_desc},
+            ideep::engine::cpu_engine())) {}
+
+  void operator()(void* cat_buf, void* res_buf) const {
+    ideep::tensor lhs({lhs_desc, cat_buf});
+    ideep::tensor rhs({rhs_desc, cat_buf});
+    ideep::tensor res({res_desc, res_buf});
+    prim.execute(
+        ideep::stream::default_stream(),
+        {{DNNL_ARG_SRC, lhs}, {DNNL_ARG_WEIGHTS, rhs}, {DNNL_ARG_DST, res}});
   }
+};
+
+// Run prepare(i, cat) to write the interaction input of each sample i to cat,
+// the gram matrices of the blocks of interaction_block_size() samples, and
+// finish(i, res) to write the output of each sample of its gram matrix res.
+template <typename T, typename R, typename Prepare, typename Finish>
+static inline void interaction_blocks(
+    int64_t batch_size,
+    int64_t vector_nums,
+    int64_t vector_size,
+    ideep::tensor::data_type src_dtype,
+    ideep::tensor::data_type dst_dtype,
+    const Prepare& prepare,
+    const Finish& finish) {
+  const auto block_size = interaction_block_size();
+  auto num_blocks = (batch_size + block_size - 1) / block_size;
+  auto tail = batch_size - (num_blocks - 1) * block_size;
+  InteractionMatmul block_mm(
+      block_size, vector_nums, vector_size, src_dtype, dst_dtype);
+  InteractionMatmul tail_mm(
+      tail, vector_nums, vector_size, src_dtype, dst_dtype);
+  auto cat_size = vector_nums * vector_size;
+  auto res_size = vector_nums * vector_nums;
+
+  at::parallel_for(0, num_blocks, 0, [&](int64_t start, int64_t end) {
+    std::vector<T> cat_buf(block_size * cat_size);
+    std::vector<R> res_buf(block_size * res_size);
+    for (int64_t b = start; b < end; b++) {
+      auto first = b * block_size;
+      auto last = std::min(first + block_size, batch_size);
+      for (int64_t i = first; i < last; i++) {
+        prepare(i, &cat_buf[(i - first) * cat_size]);
+      }
+      const auto& mm = last - first == block_size ? block_mm : tail_mm;
+      mm(cat_buf.data(), res_buf.data());
+      for (int64_t i = first; i < last; i++) {
+        finish(i, &res_buf[(i - first) * res_size]);
+      }
+    }
+  });
+}
+
+IPEX_DEFINE_DISPATCH(interaction_gram_s8_kernel_stub);
+IPEX_DEFINE_DISPATCH(interaction_gram_bf16_kernel_stub);
+
+static inline void interaction_gram(
+    const int8_t* cat,
+    int64_t batch,
+    int64_t vector_nums,
+    int64_t vector_size,
+    int32_t* res) {
+  interaction_gram_s8_kernel_stub(cat, batch, vector_nums, vector_size, res);
 }
 
+static inline void interaction_gram(
+    const at::BFloat16* cat,
+    int64_t batch,
+    int64_t vector_nums,
+    int64_t vector_size,
+    float* res) {
+  interaction_gram_bf16_kernel_stub(cat, batch, vector_nums, vector_size, res);
+}
+
+// Whether the gram matrices of the interaction of T go to the AMX tile
+// kernels, i.e. on the CPUs of AMX and of the vectors of whole tile rows.
 template <typename T>
-static inline void transpose_add(T* out, const T* in, uint32_t vector_nums) {
-  for (int32_t j = 0; j < vector_nums; j++) {
-    for (int32_t k = 0; k < vector_nums; k++) {
-      out[j * vector_nums + k] =
-          in[j * vector_nums + k] + in[k * vector_nums + j];
+static inline bool use_interaction_tiles(int64_t vector_size);
+
+template <>
+inline bool use_interaction_tiles<int8_t>(int64_t vector_size) {
+  return vector_size % 64 == 0 &&
+      interaction_gram_s8_kernel_stub.is_available();
+}
+
+template <>
+inline bool use_interaction_tiles<at::BFloat16>(int64_t vector_size) {
+  return vector_size % 32 == 0 &&
+      interaction_gram_bf16_kernel_stub.is_available();
+}
+
+// interaction_blocks of which the gram matrices are computed by the AMX tile
+// kernels instead of the oneDNN matmul, into the int32 or the float
+// accumulators R of the tiles. This saves the primitive execution of each
+// block, of which the matmuls of the DLRM are too small to amortize.
+template <typename T, typename R, typename Prepare, typename Finish>
+static inline void interaction_tile_blocks(
+    int64_t batch_size,
+    int64_t vector_nums,
+    int64_t vector_size,
+    const Prepare& prepare,
+    const Finish& finish) {
+  const auto block_size = interaction_block_size();
+  auto num_blocks = (batch_size + block_size - 1) / block_size;
+  auto cat_size = vector_nums * vector_size;
+  auto res_size = vector_nums * vector_nums;
+
+  at::parallel_for(0, num_blocks, 0, [&](int64_t start, int64_t end) {
+    std::vector<T> cat_buf(block_size * cat_size);
+    std::vector<R> res_buf(block_size * res_size);
+    for (int64_t b = start; b < end; b++) {
+      auto first = b * block_size;
+      auto last = std::min(first + block_size, batch_size);
+      for (int64_t i = first; i < last; i++) {
+        prepare(i, &cat_buf[(i - first) * cat_size]);
+      }
+      interaction_gram(
+          cat_buf.data(),
+          last - first,
+          vector_nums,
+          vector_size,
+          res_buf.data());
+      for (int64_t i = first; i < last; i++) {
+        finish(i, &res_buf[(i - first) * res_size]);
+      }
     }
+  });
+}
+
+// The forward of the interaction of T on the AMX tiles, of which false is
+// returned if the tiles do not apply, i.e. for all but the bfloat16 one.
+template <typename T>
+static inline bool interaction_forward_tiles(
+    int64_t batch_size,
+    int64_t vector_nums,
+    int64_t vector_size,
+    const std::vector<T*>& input_data,
+    const std::vector<uint32_t>& feature_sizes,
+    T* out_data) {
+  return false;
+}
+
+template <>
+inline bool interaction_forward_tiles<at::BFloat16>(
+    int64_t batch_size,
+    int64_t vector_nums,
+    int64_t vector_size,
+    const std::vector<at::BFloat16*>& input_data,
+    const std::vector<uint32_t>& feature_sizes,
+    at::BFloat16* out_data) {
+  if (!use_interaction_tiles<at::BFloat16>(vector_size)) {
+    return false;
   }
+  auto out_size = vector_nums * (vector_nums - 1) / 2 + vector_size;
+  interaction_tile_blocks<at::BFloat16, float>(
+      batch_size,
+      vector_nums,
+      vector_size,
+      [&](int64_t i, at::BFloat16* cat_buf) {
+        cat<at::BFloat16>(cat_buf, input_data, feature_sizes, i);
+      },
+      [&](int64_t i, float* mm_buf) {
+        at::BFloat16* out_row = &out_data[i * out_size];
+        move_ker(out_row, &input_data[0][i * vector_size], vector_size);
+        // the triangle below the diagonal of the float gram matrix
+        at::BFloat16* flat = &out_row[vector_size];
+        for (int r = 1; r < vector_nums; r++) {
+          move_ker(flat, &mm_buf[r * vector_nums], r);
+          flat += r;
+        }
+      });
+  return true;
 }
 
 template <typename T>
 inline at::Tensor _interaction_forward(const std::vector<at::Tensor>& input) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("_interaction_forward", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("_interaction_forward", std::vector<c10::IValue>({}));
   uint32_t total_feature_size = 0;
   int64_t batch_size = input[0].sizes()[0];
   uint32_t vector_size = input[0].sizes()[1];
@@ -125,44 +277,37 @@ inline at::Tensor _interaction_forward(const std::vector<at::Tensor>& input) {
       {batch_size, interact_feature_size + vector_size}, input[0].options());
   auto out_data = out.data_ptr<T>();
 
-  auto mkldnn_dtype = cpu::get_mkldnn_dtype(input[0].scalar_type());
-  std::vector<int64_t> lhs_shape({vector_nums, vector_size});
-  std::vector<int64_t> lhs_stride({vector_size, 1});
-  std::vector<int64_t> rhs_shape({vector_size, vector_nums});
-  std::vector<int64_t> rhs_stride({1, vector_size});
-  std::vector<int64_t> res_shape({vector_nums, vector_nums});
-  std::vector<int64_t> res_stride({vector_nums, 1});
-  ideep::tensor::desc lhs_desc(
-      std::move(lhs_shape), mkldnn_dtype, std::move(lhs_stride));
-  ideep::tensor::desc rhs_desc(
-      std::move(rhs_shape), mkldnn_dtype, std::move(rhs_stride));
-  ideep::tensor::desc res_desc(
-      std::move(res_shape), mkldnn_dtype, std::move(res_stride));
-  auto pd = ideep::matmul_forward::primitive_desc(
-      {lhs_desc, rhs_desc, res_desc}, ideep::engine::cpu_engine());
+  if (batch_size == 0) {
+    return out;
+  }
 
-  at::parallel_for(0, batch_size, 0, [&](int64_t start, int64_t end) {
-    T cat_buf[vector_nums * vector_size];
-    ideep::tensor lhs({lhs_desc, cat_buf});
-    ideep::tensor rhs({lhs_desc, cat_buf});
-    T mm_buf[vector_nums * vector_nums];
-    ideep::tensor res({res_desc, mm_buf});
-    T flat_buf[interact_feature_size];
-    auto p = dnnl::matmul(pd);
-    for (int64_t i = start; i < end; i++) {
-      cat<T>(cat_buf, input_data, feature_sizes, i);
-      p.execute(
-          ideep::stream::default_stream(),
-          {{DNNL_ARG_SRC, lhs}, {DNNL_ARG_WEIGHTS, rhs}, {DNNL_ARG_DST, res}});
-      flat_triangle<T>(mm_buf, flat_buf, vector_nums);
-      cat<T>(
-          &input_data[0][i * vector_size],
-          flat_buf,
-          &out_data[i * (interact_feature_size + vector_size)],
+  auto out_size = interact_feature_size + vector_size;
+  if (interaction_forward_tiles<T>(
+          batch_size,
+          vector_nums,
           vector_size,
-          interact_feature_size);
-    }
-  });
+          input_data,
+          feature_sizes,
+          out_data)) {
+    return out;
+  }
+
+  auto mkldnn_dtype = cpu::get_mkldnn_dtype(input[0].scalar_type());
+  // the dense input and the triangle go straight to the output row
+  interaction_blocks<T, T>(
+      batch_size,
+      vector_nums,
+      vector_size,
+      mkldnn_dtype,
+      mkldnn_dtype,
+      [&](int64_t i, T* cat_buf) {
+        cat<T>(cat_buf, input_data, feature_sizes, i);
+      },
+      [&](int64_t i, const T* mm_buf) {
+        T* out_row = &out_data[i * out_size];
+        move_ker(out_row, &input_data[0][i * vector_size], vector_size);
+        flat_triangle<T>(mm_buf, &out_row[vector_size], vector_nums);
+      });
 
   return out;
 }
@@ -172,9 +317,7 @@ inline std::vector<at::Tensor> _interaction_backward(
     const at::Tensor& grad_out,
     const std::vector<at::Tensor>& input) {
   TORCH_INTERNAL_ASSERT_DEBUG_ONLY(grad_out.is_contiguous());
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("_interaction_backward", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("_interaction_backward", std::vector<c10::IValue>({}));
   uint32_t total_feature_size = 0;
   int64_t batch_size = input[0].sizes()[0];
   uint32_t vector_size = input[0].sizes()[1];
@@ -194,71 +337,46 @@ inline std::vector<at::Tensor> _interaction_backward(
   TORCH_INTERNAL_ASSERT_DEBUG_ONLY(total_feature_size % vector_size == 0);
   auto interact_feature_size = vector_nums * (vector_nums - 1) / 2;
   auto grad_out_data = grad_out.data_ptr<T>();
-
-  auto mkldnn_dtype = cpu::get_mkldnn_dtype(input[0].scalar_type());
-  std::vector<int64_t> lhs_shape({vector_nums, vector_nums});
-  std::vector<int64_t> lhs_stride({vector_nums, 1});
-  std::vector<int64_t> rhs_shape({vector_nums, vector_size});
-  std::vector<int64_t> rhs_stride({vector_size, 1});
-  std::vector<int64_t> res_shape({vector_nums, vector_size});
-  std::vector<int64_t> res_stride({vector_size, 1});
-  ideep::tensor::desc lhs_desc(
-      std::move(lhs_shape), mkldnn_dtype, std::move(lhs_stride));
-  ideep::tensor::desc rhs_desc(
-      std::move(rhs_shape), mkldnn_dtype, std::move(rhs_stride));
-  ideep::tensor::desc res_desc(
-      std::move(res_shape), mkldnn_dtype, std::move(res_stride));
-  auto pd = ideep::matmul_forward::primitive_desc(
-      {lhs_desc, rhs_desc, res_desc}, ideep::engine::cpu_engine());
-
+  auto out_size = interact_feature_size + vector_size;
+
+  // The grad of the interaction A A' of the vectors A of a sample is
+  //   gA = (gy + gy') A
+  // of which gy is only non-zero below the diagonal, i.e. on the triangle
+  // of the output, so the grad of each pair (r, c) of the triangle adds to
+  // both of the vectors:
+  //   gA[r] += gy[r][c] * A[c], gA[c] += gy[r][c] * A[r]
+  // This takes half the FLOPs of the matmul of the whole gy + gy', and the
+  // grads of the vectors go straight to the grads of the inputs.
   at::parallel_for(0, batch_size, 0, [&](int64_t start, int64_t end) {
-    T grad_input0_buf[vector_size];
-    T grad_flat_buf[interact_feature_size];
-    T grad_mm_buf[vector_nums * vector_nums];
-    T sum_buf[vector_nums * vector_nums];
-    T grad_cat_buf[vector_nums * vector_size];
-    T cat_buf[vector_nums * vector_size];
-    ideep::tensor lhs({lhs_desc, sum_buf});
-    ideep::tensor rhs({lhs_desc, cat_buf});
-    ideep::tensor res({res_desc, grad_cat_buf});
-    auto p = dnnl::matmul(pd);
+    std::vector<float> grad_buf(vector_nums * vector_size);
+    std::vector<T*> vectors(vector_nums);
+    std::vector<T*> grad_vectors(vector_nums);
     for (int64_t i = start; i < end; i++) {
-      cat_backward<T>(
-          &grad_out_data[i * (interact_feature_size + vector_size)],
-          grad_input0_buf,
-          grad_flat_buf,
-          vector_size,
-          interact_feature_size);
-      flat_triangle_backward<T>(grad_flat_buf, grad_mm_buf, vector_nums);
-
-      // Special BMM characteristics in Interaction layer
-      //  bmm(A, A'): two inputs are transposed to each other.
-      //
-      //             A --> (T) --> A'
-      //              \         /
-      //               \       /
-      //                \     /
-      //                 (bmm)
-      //                   |
-      //                   v
-      //                  out
-      //
-      //  For traditional bmm backward propagation.
-      //  e.g. gx: {gy, w'}, gw: {x', gy}
-      //
-      //  Can be expanded and optimized as:
-      //  gx: {gy, A}, gA': {A', gy}
-      //  gA = gx + (gA')' = {gy, A} + {A', gy}' = {gy + gy', A}
-
-      // Calculate A
-      cat<T>(cat_buf, input_data, feature_sizes, i);
-      // Calculate gy + gy'
-      transpose_add(sum_buf, grad_mm_buf, vector_nums);
-      p.execute(
-          ideep::stream::default_stream(),
-          {{DNNL_ARG_SRC, lhs}, {DNNL_ARG_WEIGHTS, rhs}, {DNNL_ARG_DST, res}});
-      cat_backward<T>(grad_cat_buf, output_data, feature_sizes, i);
-      add_ker(&output_data[0][i * vector_size], grad_input0_buf, vector_size);
+      int v = 0;
+      for (int j = 0; j < input.size(); j++) {
+        auto row = i * feature_sizes[j];
+        for (int k = 0; k < feature_sizes[j]; k += vector_size, v++) {
+          vectors[v] = &input_data[j][row + k];
+          grad_vectors[v] = &output_data[j][row + k];
+        }
+      }
+      T* grad_row = &grad_out_data[i * out_size];
+      const T* grad_flat = &grad_row[vector_size];
+
+      zero_ker(grad_buf.data(), vector_nums * vector_size);
+      // the dense input is also concatenated to the output
+      add_ker(grad_buf.data(), grad_row, vector_size);
+      size_t offset = 0;
+      for (int r = 1; r < vector_nums; r++) {
+        for (int c = 0; c < r; c++) {
+          auto g = toFloat(grad_flat[offset++]);
+          madd_ker(&grad_buf[r * vector_size], vectors[c], vector_size, g);
+          madd_ker(&grad_buf[c * vector_size], vectors[r], vector_size, g);
+        }
+      }
+      for (int r = 0; r < vector_nums; r++) {
+        move_ker(grad_vectors[r], &grad_buf[r * vector_size], vector_size);
+      }
     }
   });
   return output;
@@ -299,6 +417,115 @@ std::vector<at::Tensor> interaction_backward(
   }
 }
 
+// The same interaction as _interaction_forward of the dense input and the
+// sum pooled embedding bags, each bag pooled straight into the row of the
+// interaction input instead of into a pooled output tensor of its table.
+template <typename T>
+inline at::Tensor _embedding_bag_interaction_forward(
+    const at::Tensor& dense,
+    const std::vector<at::Tensor>& weights,
+    const std::vector<at::Tensor>& indices,
+    const std::vector<at::Tensor>& offsets,
+    bool include_last_offset) {
+  IPEX_RECORD_FUNCTION(
+      "_embedding_bag_interaction_forward", std::vector<c10::IValue>({}));
+  int64_t batch_size = dense.sizes()[0];
+  uint32_t vector_size = dense.sizes()[1];
+  uint32_t num_tables = weights.size();
+  uint32_t vector_nums = num_tables + 1;
+  T* dense_data = dense.data_ptr<T>();
+  std::vector<T*> weight_data(num_tables);
+  std::vector<int64_t*> indices_data(num_tables);
+  std::vector<int64_t*> offsets_data(num_tables);
+  std::vector<int64_t> num_indices(num_tables);
+  for (int j = 0; j < num_tables; j++) {
+    weight_data[j] = weights[j].data_ptr<T>();
+    indices_data[j] = indices[j].data_ptr<int64_t>();
+    offsets_data[j] = offsets[j].data_ptr<int64_t>();
+    num_indices[j] = indices[j].numel();
+  }
+  auto interact_feature_size = vector_nums * (vector_nums - 1) / 2;
+  auto out = at::empty(
+      {batch_size, interact_feature_size + vector_size}, dense.options());
+  auto out_data = out.data_ptr<T>();
+
+  if (batch_size == 0) {
+    return out;
+  }
+
+  auto mkldnn_dtype = cpu::get_mkldnn_dtype(dense.scalar_type());
+  auto out_size = interact_feature_size + vector_size;
+  interaction_blocks<T, T>(
+      batch_size,
+      vector_nums,
+      vector_size,
+      mkldnn_dtype,
+      mkldnn_dtype,
+      [&](int64_t i, T* cat_buf) {
+        move_ker(cat_buf, &dense_data[i * vector_size], vector_size);
+        for (int j = 0; j < num_tables; j++) {
+          T* pooled = &cat_buf[(j + 1) * vector_size];
+          zero_ker(pooled, vector_size);
+          auto bag_start = offsets_data[j][i];
+          auto bag_end = (include_last_offset || i + 1 < batch_size)
+              ? offsets_data[j][i + 1]
+              : num_indices[j];
+          for (int64_t s = bag_start; s < bag_end; s++) {
+            add_ker(
+                pooled,
+                &weight_data[j][indices_data[j][s] * vector_size],
+                vector_size);
+          }
+        }
+      },
+      [&](int64_t i, const T* mm_buf) {
+        T* out_row = &out_data[i * out_size];
+        move_ker(out_row, &dense_data[i * vector_size], vector_size);
+        flat_triangle<T>(mm_buf, &out_row[vector_size], vector_nums);
+      });
+
+  return out;
+}
+
+at::Tensor embedding_bag_interaction_forward(
+    const at::Tensor& dense,
+    const std::vector<at::Tensor>& weights,
+    const std::vector<at::Tensor>& indices,
+    const std::vector<at::Tensor>& offsets,
+    bool include_last_offset) {
+  TORCH_CHECK(
+      weights.size() == indices.size() && weights.size() == offsets.size(),
+      "embedding_bag_interaction_forward: expect the same number of weights, "
+      "indices and offsets");
+  auto dtype = dense.scalar_type();
+  bool fusible = (dtype == at::kFloat || dtype == at::kBFloat16) &&
+      dense.dim() == 2 && dense.is_contiguous();
+  auto num_bags = dense.size(0) + (include_last_offset ? 1 : 0);
+  for (int j = 0; fusible && j < weights.size(); j++) {
+    fusible = weights[j].scalar_type() == dtype &&
+        weights[j].is_contiguous() && weights[j].dim() == 2 &&
+        weights[j].size(1) == dense.size(1) &&
+        indices[j].scalar_type() == at::kLong && indices[j].is_contiguous() &&
+        offsets[j].scalar_type() == at::kLong && offsets[j].is_contiguous() &&
+        offsets[j].numel() == num_bags;
+  }
+  if (!fusible) {
+    // pool each table, then interact as the unfused graph does
+    std::vector<at::Tensor> input = {dense};
+    for (int j = 0; j < weights.size(); j++) {
+      input.push_back(embedding_bag(
+          weights[j], indices[j], offsets[j], false, include_last_offset));
+    }
+    return interaction_forward(input);
+  }
+  if (dtype == at::kFloat) {
+    return _embedding_bag_interaction_forward<float>(
+        dense, weights, indices, offsets, include_last_offset);
+  }
+  return _embedding_bag_interaction_forward<at::BFloat16>(
+      dense, weights, indices, offsets, include_last_offset);
+}
+
 namespace cpu {
 #if defined(CPU_AVX512)
 static inline void _interaction_s8s8_scale_s32s8_128(
@@ -341,23 +568,6 @@ static inline void _interaction_s8s8_scale_s32s8_128(
 }
 #endif
 
-static inline void _interaction_s8s8_scale_s32s8(
-    int8_t* out,
-    const std::vector<int8_t*>& input_addr,
-    size_t M,
-    size_t K,
-    float* scales) {
-  size_t offset = 0;
-  for (int i = 1; i < M; i++) {
-    int8_t* a = input_addr[i];
-    for (int j = 0; j < i; j++) {
-      int8_t* b = input_addr[j];
-      out[offset] = _dot_s8s8_scale_s32s8(a, b, K, scales[offset]);
-      offset++;
-    }
-  }
-}
-
 at::Tensor dil_qinteraction(
     const std::vector<at::Tensor> input,
     double output_scale,
@@ -409,16 +619,17 @@ at::Tensor dil_qinteraction(
 
   float dense_scale = in_scales[0] / output_scale;
 
-  at::parallel_for(0, batch_size, 0, [&](int64_t start, int64_t end) {
-    __m512i cat_buf[aligned_off] __attribute__((aligned(64)));
-    __m512i convert_to_s16_buf[vector_nums * 4] __attribute__((aligned(64)));
-    std::vector<int8_t*> input_addr(vector_nums);
-    for (int64_t i = start; i < end; i++) {
-      int8_t* out_ptr = &out_data[i * out_data_line_len];
-      int8_t* flat_buf = (int8_t*)(out_ptr + vector_size);
-      auto row_len = i * vector_size;
+  auto& cpu_feature = CPUFeature::get_instance();
+  bool use_amx = cpu_feature.os_amx() && cpu_feature.cpuid_amx_int8();
 #if defined(CPU_AVX512)
-      if (vector_size == 128) {
+  if (vector_size == 128 && !use_amx) {
+    at::parallel_for(0, batch_size, 0, [&](int64_t start, int64_t end) {
+      __m512i cat_buf[aligned_off] __attribute__((aligned(64)));
+      __m512i convert_to_s16_buf[vector_nums * 4] __attribute__((aligned(64)));
+      for (int64_t i = start; i < end; i++) {
+        int8_t* out_ptr = &out_data[i * out_data_line_len];
+        int8_t* flat_buf = (int8_t*)(out_ptr + vector_size);
+        auto row_len = i * vector_size;
         int k = 0;
         for (; k < vector_nums - 1; k += 2) {
           load_s8x128x2_to_s16x128x2(
@@ -435,17 +646,53 @@ at::Tensor dil_qinteraction(
         _interaction_s8s8_scale_s32s8_128(
             flat_buf, vector_nums, out_in_scales, convert_to_s16_buf, cat_buf);
       }
-      continue;
+    });
+    return output;
+  }
 #endif
-      for (int k = 0; k < vector_nums; k++) {
-        input_addr[k] = &input_data[k][row_len];
+  if (batch_size == 0) {
+    return output;
+  }
+
+  // Any other feature size, and any with the AMX tiles, by the s8s8s32
+  // gram matrices of the AMX tile kernel, or of the oneDNN matmul, which runs
+  // on the AMX tiles or with VNNI. The dense input and the scaled triangle go
+  // straight to the output row.
+  auto prepare = [&](int64_t i, int8_t* cat_buf) {
+    for (int k = 0; k < vector_nums; k++) {
+      move_ker(
+          &cat_buf[k * vector_size],
+          &input_data[k][i * vector_size],
+          vector_size);
+    }
+  };
+  auto finish = [&](int64_t i, const int32_t* mm_buf) {
+    int8_t* out_ptr = &out_data[i * out_data_line_len];
+    int8_t* flat_buf = out_ptr + vector_size;
+    scale_and_move_ker(
+        out_ptr, &input_data[0][i * vector_size], dense_scale, vector_size);
+    size_t offset = 0;
+    for (int r = 1; r < vector_nums; r++) {
+      for (int c = 0; c < r; c++) {
+        flat_buf[offset] = (int8_t)_scale_int32(
+            mm_buf[r * vector_nums + c], out_in_scales[offset]);
+        offset++;
       }
-      scale_and_move_ker(
-          out_ptr, &input_data[0][i * vector_size], dense_scale, vector_size);
-      _interaction_s8s8_scale_s32s8(
-          flat_buf, input_addr, vector_nums, vector_size, out_in_scales);
     }
-  });
+  };
+  if (use_interaction_tiles<int8_t>(vector_size)) {
+    interaction_tile_blocks<int8_t, int32_t>(
+        batch_size, vector_nums, vector_size, prepare, finish);
+  } else {
+    interaction_blocks<int8_t, int32_t>(
+        batch_size,
+        vector_nums,
+        vector_size,
+        ideep::tensor::data_type::s8,
+        ideep::tensor::data_type::s32,
+        prepare,
+        finish);
+  }
 
   return output;
 }
@@ -1,6 +1,8 @@
 #include <ATen/Tensor.h>
 #include <torch/extension.h>
 
+#include "csrc/cpu/dispatch/DispatchStub.h"
+
 namespace torch_ipex {
 
 at::Tensor interaction_forward(const std::vector<at::Tensor>& input);
@@ -8,4 +10,29 @@ std::vector<at::Tensor> interaction_backward(
     const at::Tensor& grad_out,
     const std::vector<at::Tensor>& input);
 
+// The interaction of the dense input and the sum pooled embedding bags of
+// each table, for the JIT inference of the DLRM sparse arch.
+at::Tensor embedding_bag_interaction_forward(
+    const at::Tensor& dense,
+    const std::vector<at::Tensor>& weights,
+    const std::vector<at::Tensor>& indices,
+    const std::vector<at::Tensor>& offsets,
+    bool include_last_offset);
+
+// The gram matrices res = A A' of the contiguous [batch, vector_nums,
+// vector_size] interaction inputs A into the [batch, vector_nums, vector_nums]
+// res, by the AMX tiles, of which only the triangle below the diagonal is
+// written. The kernels are only built for the AMX level, and take vector_size
+// of a multiple of the 64 bytes of a tile row.
+using interaction_gram_s8_kernel_fn =
+    void (*)(const int8_t*, int64_t, int64_t, int64_t, int32_t*);
+using interaction_gram_bf16_kernel_fn =
+    void (*)(const at::BFloat16*, int64_t, int64_t, int64_t, float*);
+IPEX_DECLARE_DISPATCH(
+    interaction_gram_s8_kernel_fn,
+    interaction_gram_s8_kernel_stub);
+IPEX_DECLARE_DISPATCH(
+    interaction_gram_bf16_kernel_fn,
+    interaction_gram_bf16_kernel_stub);
+
 } // namespace torch_ipex
@@ -0,0 +1,164 @@
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/functional.h>
+#include <ATen/cpu/vec/vec.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "csrc/aten/cpu/utils/float_vec.h"
+#include "csrc/aten/cpu/utils/vec_math.h"
+#include "csrc/jit/cpu/kernels/AddSoftmax.h"
+
+namespace torch_ipex {
+namespace jit {
+namespace cpu {
+namespace kernels {
+
+namespace {
+
+using torch_ipex::cpu::fVec;
+using torch_ipex::cpu::kFloatVecPairSize;
+using torch_ipex::cpu::load_fvec;
+using torch_ipex::cpu::store_fvec;
+using torch_ipex::cpu::sum_fvec;
+namespace vec_math = torch_ipex::cpu::vec_math;
+
+inline float max_fvec(const fVec& v) {
+  return at::vec::vec_reduce_all<float>(
+      [](fVec& x, fVec& y) { return at::vec::maximum(x, y); },
+      v,
+      fVec::size());
+}
+
+// out = a / dim_per_head + b in float, of which the max is returned
+template <typename scalar_t>
+float div_add_reduce_max(
+    const scalar_t* a,
+    const scalar_t* b,
+    float r_dim_per_head,
+    int64_t size,
+    float* out) {
+  const fVec r_vec(r_dim_per_head);
+  fVec max_vec(std::numeric_limits<float>::lowest());
+  int64_t i = 0;
+  for (; i <= size - kFloatVecPairSize; i += kFloatVecPairSize) {
+    fVec a0, a1, b0, b1;
+    load_fvec(a + i, a0, a1);
+    load_fvec(b + i, b0, b1);
+    auto out0 = at::vec::fmadd(a0, r_vec, b0);
+    auto out1 = at::vec::fmadd(a1, r_vec, b1);
+    max_vec = at::vec::maximum(max_vec, at::vec::maximum(out0, out1));
+    store_fvec(out + i, out0, out1);
+  }
+  float max = max_fvec(max_vec);
+  for (; i < size; i++) {
+    out[i] = float(a[i]) * r_dim_per_head + float(b[i]);
+    max = std::max(max, out[i]);
+  }
+  return max;
+}
+
+// data = exp(data - max) in place, of which the sum is returned
+template <vec_math::Accuracy A>
+float exp_reduce_sum(float* data, float max, int64_t size) {
+  const fVec max_vec(max);
+  fVec sum_vec(0.f);
+  int64_t i = 0;
+  for (; i <= size - fVec::size(); i += fVec::size()) {
+    auto x = vec_math::exp<A>(fVec::loadu(data + i) - max_vec);
+    sum_vec = sum_vec + x;
+    x.store(data + i);
+  }
+  if (i < size) {
+    auto x = vec_math::exp<A>(fVec::loadu(data + i, size - i) - max_vec);
+    // the lanes beyond the tail are loaded as 0, i.e. exp(-max)
+    sum_vec = sum_vec + fVec::set(fVec(0.f), x, size - i);
+    x.store(data + i, size - i);
+  }
+  return sum_fvec(sum_vec);
+}
+
+template <typename scalar_t>
+void normalize(const float* data, float sum, int64_t size, scalar_t* out) {
+  const fVec sum_vec(sum);
+  int64_t i = 0;
+  for (; i <= size - kFloatVecPairSize; i += kFloatVecPairSize) {
+    auto x0 = fVec::loadu(data + i) / sum_vec;
+    auto x1 = fVec::loadu(data + i + fVec::size()) / sum_vec;
+    store_fvec(out + i, x0, x1);
+  }
+  for (; i < size; i++) {
+    out[i] = scalar_t(data[i] / sum);
+  }
+}
+
+template <typename scalar_t>
+void div_add_softmax_kernel(
+    const at::Tensor& a,
+    const at::Tensor& b,
+    float dim_per_head,
+    at::Tensor& output) {
+  int64_t dim_size = a.size(-1);
+  int64_t outer_size = a.numel() / dim_size;
+  // the strides of b of the outer dimensions of a, 0 for the broadcasted ones
+  auto outer_sizes = a.sizes().slice(0, a.dim() - 1).vec();
+  auto b_strides = b.expand(a.sizes()).strides().slice(0, a.dim() - 1).vec();
+  bool need_broadcast = a.sizes() != b.sizes() || !b.is_contiguous();
+
+  const scalar_t* a_data = a.data_ptr<scalar_t>();
+  const scalar_t* b_data = b.data_ptr<scalar_t>();
+  scalar_t* output_data = output.data_ptr<scalar_t>();
+  float r_dim_per_head = 1.f / dim_per_head;
+  int64_t grain_size =
+      std::max<int64_t>(1, at::internal::GRAIN_SIZE / (16 * dim_size));
+  at::parallel_for(0, outer_size, grain_size, [&](int64_t begin, int64_t end) {
+    std::vector<float> buffer(dim_size);
+    for (int64_t i = begin; i < end; i++) {
+      int64_t b_offset = i * dim_size;
+      if (need_broadcast) {
+        b_offset = 0;
+        int64_t index = i;
+        for (int64_t d = outer_sizes.size() - 1; d >= 0; d--) {
+          b_offset += (index % outer_sizes[d]) * b_strides[d];
+          index /= outer_sizes[d];
+        }
+      }
+      float max = div_add_reduce_max<scalar_t>(
+          a_data + i * dim_size,
+          b_data + b_offset,
+          r_dim_per_head,
+          dim_size,
+          buffer.data());
+      float sum = exp_reduce_sum<vec_math::accuracy_of<scalar_t>()>(
+          buffer.data(), max, dim_size);
+      normalize<scalar_t>(
+          buffer.data(), sum, dim_size, output_data + i * dim_size);
+    }
+  });
+}
+
+at::Tensor div_add_softmax_kernel_impl(
+    const at::Tensor& a,
+    const at::Tensor& b,
+    float dim_per_head) {
+  auto output = at::empty_like(a);
+  if (a.scalar_type() == at::kBFloat16) {
+    div_add_softmax_kernel<at::BFloat16>(a, b, dim_per_head, output);
+  } else {
+    div_add_softmax_kernel<float>(a, b, dim_per_head, output);
+  }
+  return output;
+}
+
+} // namespace
+
+IPEX_REGISTER_DISPATCH(
+    div_add_softmax_kernel_stub,
+    &div_add_softmax_kernel_impl);
+
+} // namespace kernels
+} // namespace cpu
+} // namespace jit
+} // namespace torch_ipex
@@ -0,0 +1,303 @@
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/vec.h>
+
+#include <algorithm>
+
+#include "csrc/aten/cpu/ConvBackwardWeights.h"
+#include "csrc/aten/cpu/utils/float_vec.h"
+#include "csrc/utils/parallel_trace.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+// the tile of grad_weight of a task
+constexpr int64_t kTileOC = 64;
+constexpr int64_t kTileIC = 64;
+// The register tile of the microkernel: kMR output channels of kNP pairs of
+// float vectors of the input channels
+constexpr int kMR = 4;
+constexpr int kNP = fVec::size() == 16 ? 2 : 1;
+// the fewest pixels of a split of the reduction over the pixels
+constexpr int64_t kMinPixelsPerSplit = 16;
+// the elements of a task of the tree reduction
+constexpr int64_t kReduceChunk = 4096;
+
+// c[0:MR, 0:NP * kFloatVecPairSize] = g[0:pixels, 0:MR]^T x x[0:pixels, 0:NP
+// * kFloatVecPairSize]
+template <int MR, int NP, typename scalar_t>
+inline void gemm_tn_micro(
+    const scalar_t* g,
+    int64_t ldg,
+    const scalar_t* x,
+    int64_t ldx,
+    int64_t pixels,
+    float* c,
+    int64_t ldc) {
+  fVec acc[MR][2 * NP];
+  for (int i = 0; i < MR; i++) {
+    for (int j = 0; j < 2 * NP; j++) {
+      acc[i][j] = fVec(0.f);
+    }
+  }
+  for (int64_t p = 0; p < pixels; p++) {
+    fVec vx[2 * NP];
+    for (int j = 0; j < NP; j++) {
+      load_fvec(x + p * ldx + j * kFloatVecPairSize, vx[2 * j], vx[2 * j + 1]);
+    }
+    for (int i = 0; i < MR; i++) {
+      fVec vg(static_cast<float>(g[p * ldg + i]));
+      for (int j = 0; j < 2 * NP; j++) {
+        acc[i][j] = at::vec::fmadd(vg, vx[j], acc[i][j]);
+      }
+    }
+  }
+  for (int i = 0; i < MR; i++) {
+    for (int j = 0; j < 2 * NP; j++) {
+      acc[i][j].store(c + i * ldc + j * fVec::size());
+    }
+  }
+}
+
+// the tail of the input channels, fewer than a pair of vectors
+template <typename scalar_t>
+inline void gemm_tn_scalar(
+    const scalar_t* g,
+    int64_t ldg,
+    const scalar_t* x,
+    int64_t ldx,
+    int64_t pixels,
+    int64_t rows,
+    int64_t cols,
+    float* c,
+    int64_t ldc) {
+  for (int64_t i = 0; i < rows; i++) {
+    for (int64_t j = 0; j < cols; j++) {
+      float sum = 0.f;
+      for (int64_t p = 0; p < pixels; p++) {
+        sum += static_cast<float>(g[p * ldg + i]) *
+            static_cast<float>(x[p * ldx + j]);
+      }
+      c[i * ldc + j] = sum;
+    }
+  }
+}
+
+template <int MR, typename scalar_t>
+inline void gemm_tn_rows(
+    const scalar_t* g,
+    int64_t oc,
+    const scalar_t* x,
+    int64_t ic,
+    int64_t pixels,
+    int64_t ic_begin,
+    int64_t ic_end,
+    float* c) {
+  constexpr int64_t kTileN = kNP * kFloatVecPairSize;
+  int64_t j = ic_begin;
+  for (; j + kTileN <= ic_end; j += kTileN) {
+    gemm_tn_micro<MR, kNP>(g, oc, x + j, ic, pixels, c + j, ic);
+  }
+  for (; j + kFloatVecPairSize <= ic_end; j += kFloatVecPairSize) {
+    gemm_tn_micro<MR, 1>(g, oc, x + j, ic, pixels, c + j, ic);
+  }
+  if (j < ic_end) {
+    gemm_tn_scalar(g, oc, x + j, ic, pixels, MR, ic_end - j, c + j, ic);
+  }
+}
+
+// the partial sums over the pixels of a tile of grad_weight [OC, IC] and, of
+// the tiles of the first input channels, of grad_bias [OC]
+template <typename scalar_t>
+void conv1x1_backward_tile(
+    const scalar_t* g,
+    int64_t oc,
+    const scalar_t* x,
+    int64_t ic,
+    int64_t pixels,
+    int64_t oc_begin,
+    int64_t oc_end,
+    int64_t ic_begin,
+    int64_t ic_end,
+    float* partial_weight,
+    float* partial_bias) {
+  int64_t i = oc_begin;
+  for (; i + kMR <= oc_end; i += kMR) {
+    gemm_tn_rows<kMR>(
+        g + i, oc, x, ic, pixels, ic_begin, ic_end, partial_weight + i * ic);
+  }
+  for (; i < oc_end; i++) {
+    gemm_tn_rows<1>(
+        g + i, oc, x, ic, pixels, ic_begin, ic_end, partial_weight + i * ic);
+  }
+  if (partial_bias != nullptr && ic_begin == 0) {
+    std::fill(partial_bias + oc_begin, partial_bias + oc_end, 0.f);
+    for (int64_t p = 0; p < pixels; p++) {
+      for (int64_t k = oc_begin; k < oc_end; k++) {
+        partial_bias[k] += static_cast<float>(g[p * oc + k]);
+      }
+    }
+  }
+}
+
+// a[0:len] += b[0:len] of the partial sums of two splits
+inline void add_partial(float* a, const float* b, int64_t len) {
+  int64_t d = 0;
+  for (; d + fVec::size() <= len; d += fVec::size()) {
+    (fVec::loadu(a + d) + fVec::loadu(b + d)).store(a + d);
+  }
+  for (; d < len; d++) {
+    a[d] += b[d];
+  }
+}
+
+// out[0:len] = a[0:len] + b[0:len], of the last level of the tree, where b is
+// null if there is a split only
+template <typename scalar_t>
+inline void store_partial_sum(
+    const float* a,
+    const float* b,
+    scalar_t* out,
+    int64_t len) {
+  int64_t d = 0;
+  for (; d + kFloatVecPairSize <= len; d += kFloatVecPairSize) {
+    fVec v0, v1;
+    load_fvec(a + d, v0, v1);
+    if (b != nullptr) {
+      fVec w0, w1;
+      load_fvec(b + d, w0, w1);
+      v0 = v0 + w0;
+      v1 = v1 + w1;
+    }
+    store_fvec(out + d, v0, v1);
+  }
+  for (; d < len; d++) {
+    out[d] = static_cast<scalar_t>(b != nullptr ? a[d] + b[d] : a[d]);
+  }
+}
+
+template <typename scalar_t>
+void conv1x1_backward_weights_kernel(
+    const at::Tensor& grad_output,
+    const at::Tensor& input,
+    at::Tensor& grad_weight,
+    at::Tensor& grad_bias) {
+  const int64_t oc = grad_output.size(1);
+  const int64_t ic = input.size(1);
+  const int64_t pixels = input.numel() / ic;
+  const scalar_t* g = grad_output.data_ptr<scalar_t>();
+  const scalar_t* x = input.data_ptr<scalar_t>();
+
+  // The tiles of grad_weight run in parallel, and the pixels are split if the
+  // tiles are too few to occupy the threads, e.g. of the small layers on the
+  // many cores, of which each split keeps its partial sums in float
+  const int64_t ic_tiles = (ic + kTileIC - 1) / kTileIC;
+  const int64_t tiles = ((oc + kTileOC - 1) / kTileOC) * ic_tiles;
+  const int64_t splits = std::max<int64_t>(
+      1,
+      std::min(
+          (at::get_num_threads() + tiles - 1) / tiles,
+          pixels / kMinPixelsPerSplit));
+  const int64_t pixels_per_split = (pixels + splits - 1) / splits;
+  const int64_t partial_size = oc * ic + oc;
+  auto partials =
+      at::empty({splits, partial_size}, input.options().dtype(at::kFloat));
+  float* partial = partials.data_ptr<float>();
+  const bool with_bias = grad_bias.defined();
+
+  {
+    parallel_trace::ParallelRegion region("conv1x1_backward_weights");
+    at::parallel_for(0, splits * tiles, 1, [&](int64_t begin, int64_t end) {
+      IPEX_PARALLEL_CHUNK(region);
+      for (int64_t t = begin; t < end; t++) {
+        const int64_t s = t / tiles;
+        const int64_t oc_begin = (t % tiles) / ic_tiles * kTileOC;
+        const int64_t ic_begin = (t % tiles) % ic_tiles * kTileIC;
+        const int64_t p_begin = std::min(pixels, s * pixels_per_split);
+        const int64_t p_end = std::min(pixels, p_begin + pixels_per_split);
+        float* partial_weight = partial + s * partial_size;
+        conv1x1_backward_tile(
+            g + p_begin * oc,
+            oc,
+            x + p_begin * ic,
+            ic,
+            p_end - p_begin,
+            oc_begin,
+            std::min(oc, oc_begin + kTileOC),
+            ic_begin,
+            std::min(ic, ic_begin + kTileIC),
+            partial_weight,
+            with_bias ? partial_weight + oc * ic : nullptr);
+      }
+    });
+  }
+
+  // The tree reduction of the splits, of which a level adds the split i +
+  // step to the split i for each i of 2 * step, in parallel over the pairs
+  // and the chunks of the partial sums; the last level stores the sum of the
+  // splits 0 and step into grad_weight and grad_bias
+  const int64_t chunks = (partial_size + kReduceChunk - 1) / kReduceChunk;
+  int64_t step = 1;
+  for (; step * 2 < splits; step *= 2) {
+    const int64_t pairs = (splits - step + 2 * step - 1) / (2 * step);
+    at::parallel_for(0, pairs * chunks, 1, [&](int64_t begin, int64_t end) {
+      for (int64_t t = begin; t < end; t++) {
+        const int64_t i = t / chunks * 2 * step;
+        const int64_t offset = t % chunks * kReduceChunk;
+        add_partial(
+            partial + i * partial_size + offset,
+            partial + (i + step) * partial_size + offset,
+            std::min(kReduceChunk, partial_size - offset));
+      }
+    });
+  }
+  const float* second = step < splits ? partial + step * partial_size : nullptr;
+  scalar_t* weight_data = grad_weight.data_ptr<scalar_t>();
+  const int64_t weight_size = oc * ic;
+  at::parallel_for(
+      0,
+      (weight_size + kReduceChunk - 1) / kReduceChunk,
+      1,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t t = begin; t < end; t++) {
+          const int64_t offset = t * kReduceChunk;
+          store_partial_sum(
+              partial + offset,
+              second != nullptr ? second + offset : nullptr,
+              weight_data + offset,
+              std::min(kReduceChunk, weight_size - offset));
+        }
+      });
+  if (with_bias) {
+    store_partial_sum(
+        partial + weight_size,
+        second != nullptr ? second + weight_size : nullptr,
+        grad_bias.data_ptr<scalar_t>(),
+        oc);
+  }
+}
+
+void conv1x1_backward_weights_kernel_impl(
+    const at::Tensor& grad_output,
+    const at::Tensor& input,
+    at::Tensor& grad_weight,
+    at::Tensor& grad_bias) {
+  if (input.scalar_type() == at::kBFloat16) {
+    conv1x1_backward_weights_kernel<at::BFloat16>(
+        grad_output, input, grad_weight, grad_bias);
+  } else {
+    conv1x1_backward_weights_kernel<float>(
+        grad_output, input, grad_weight, grad_bias);
+  }
+}
+
+} // namespace
+
+IPEX_REGISTER_DISPATCH(
+    conv1x1_backward_weights_kernel_stub,
+    &conv1x1_backward_weights_kernel_impl);
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,216 @@
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/vec.h>
+
+#include "csrc/aten/cpu/DepthwiseConv.h"
+#include "csrc/aten/cpu/utils/float_vec.h"
+#include "csrc/aten/cpu/utils/vec_math.h"
+#include "csrc/utils/parallel_trace.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+// the vectors of the channels of a pixel accumulated at a time
+constexpr int kChannelVecs = 4;
+
+template <DepthwiseActivation A>
+inline fVec activate(const fVec& x, const fVec& lo, const fVec& hi) {
+  switch (A) {
+    case DepthwiseActivation::kRelu:
+      return at::vec::maximum(x, fVec(0.f));
+    case DepthwiseActivation::kClamp:
+      return at::vec::minimum(at::vec::maximum(x, lo), hi);
+    case DepthwiseActivation::kSwish:
+      return vec_math::silu(x);
+    case DepthwiseActivation::kHardswish:
+      return x *
+          at::vec::minimum(
+                 at::vec::maximum(x + fVec(3.f), fVec(0.f)), fVec(6.f)) *
+          fVec(1.f / 6.f);
+    default:
+      return x;
+  }
+}
+
+// NV vectors of the channels of an output pixel from the channel of in,
+// weight, bias and out, of which the count channels only if kTail
+template <int NV, bool kTail, DepthwiseActivation A>
+inline void depthwise_channels(
+    const float* in,
+    const float* weight,
+    const float* bias,
+    float* out,
+    int64_t ih0,
+    int64_t iw0,
+    int64_t height,
+    int64_t width,
+    int64_t channels,
+    const DepthwiseConvParams& p,
+    int64_t count,
+    const fVec& lo,
+    const fVec& hi) {
+  fVec acc[NV];
+  for (int j = 0; j < NV; j++) {
+    if (bias == nullptr) {
+      acc[j] = fVec(0.f);
+    } else {
+      acc[j] = kTail ? fVec::loadu(bias, count)
+                     : fVec::loadu(bias + j * fVec::size());
+    }
+  }
+  for (int64_t kh = 0; kh < p.kernel_h; kh++) {
+    int64_t ih = ih0 + kh * p.dilation_h;
+    if (ih < 0 || ih >= height) {
+      continue;
+    }
+    for (int64_t kw = 0; kw < p.kernel_w; kw++) {
+      int64_t iw = iw0 + kw * p.dilation_w;
+      if (iw < 0 || iw >= width) {
+        continue;
+      }
+      const float* x = in + (ih * width + iw) * channels;
+      const float* w = weight + (kh * p.kernel_w + kw) * channels;
+      for (int j = 0; j < NV; j++) {
+        fVec vx = kTail ? fVec::loadu(x, count)
+                        : fVec::loadu(x + j * fVec::size());
+        fVec vw = kTail ? fVec::loadu(w, count)
+                        : fVec::loadu(w + j * fVec::size());
+        acc[j] = at::vec::fmadd(vx, vw, acc[j]);
+      }
+    }
+  }
+  for (int j = 0; j < NV; j++) {
+    fVec r = activate<A>(acc[j], lo, hi);
+    if (kTail) {
+      r.store(out, count);
+    } else {
+      r.store(out + j * fVec::size());
+    }
+  }
+}
+
+template <DepthwiseActivation A>
+void depthwise_conv_kernel(
+    const at::Tensor& input,
+    const at::Tensor& weight,
+    const at::Tensor& bias,
+    at::Tensor& output,
+    int64_t row_begin,
+    const DepthwiseConvParams& p) {
+  const int64_t batch = input.size(0);
+  const int64_t channels = input.size(1);
+  const int64_t height = input.size(2);
+  const int64_t width = input.size(3);
+  const int64_t rows = output.size(2);
+  const int64_t out_width = output.size(3);
+  const float* in_data = input.data_ptr<float>();
+  const float* w_data = weight.data_ptr<float>();
+  const float* b_data = bias.defined() ? bias.data_ptr<float>() : nullptr;
+  float* out_data = output.data_ptr<float>();
+  const fVec lo(p.min);
+  const fVec hi(p.max);
+  constexpr int64_t kBlock = kChannelVecs * fVec::size();
+
+  parallel_trace::ParallelRegion region("depthwise_conv");
+  at::parallel_for(
+      0, batch * rows * out_width, 1, [&](int64_t begin, int64_t end) {
+        IPEX_PARALLEL_CHUNK(region);
+        for (int64_t i = begin; i < end; i++) {
+          const int64_t n = i / (rows * out_width);
+          const int64_t oh = row_begin + i / out_width % rows;
+          const int64_t ow = i % out_width;
+          const int64_t ih0 = oh * p.stride_h - p.pad_h;
+          const int64_t iw0 = ow * p.stride_w - p.pad_w;
+          const float* in = in_data + n * height * width * channels;
+          float* out = out_data + i * channels;
+          int64_t c = 0;
+          for (; c + kBlock <= channels; c += kBlock) {
+            depthwise_channels<kChannelVecs, false, A>(
+                in + c,
+                w_data + c,
+                b_data == nullptr ? nullptr : b_data + c,
+                out + c,
+                ih0,
+                iw0,
+                height,
+                width,
+                channels,
+                p,
+                0,
+                lo,
+                hi);
+          }
+          for (; c + fVec::size() <= channels; c += fVec::size()) {
+            depthwise_channels<1, false, A>(
+                in + c,
+                w_data + c,
+                b_data == nullptr ? nullptr : b_data + c,
+                out + c,
+                ih0,
+                iw0,
+                height,
+                width,
+                channels,
+                p,
+                0,
+                lo,
+                hi);
+          }
+          if (c < channels) {
+            depthwise_channels<1, true, A>(
+                in + c,
+                w_data + c,
+                b_data == nullptr ? nullptr : b_data + c,
+                out + c,
+                ih0,
+                iw0,
+                height,
+                width,
+                channels,
+                p,
+                channels - c,
+                lo,
+                hi);
+          }
+        }
+      });
+}
+
+void depthwise_conv_kernel_impl(
+    const at::Tensor& input,
+    const at::Tensor& weight,
+    const at::Tensor& bias,
+    at::Tensor& output,
+    int64_t row_begin,
+    const DepthwiseConvParams& params) {
+  switch (params.activation) {
+    case DepthwiseActivation::kRelu:
+      depthwise_conv_kernel<DepthwiseActivation::kRelu>(
+          input, weight, bias, output, row_begin, params);
+      break;
+    case DepthwiseActivation::kClamp:
+      depthwise_conv_kernel<DepthwiseActivation::kClamp>(
+          input, weight, bias, output, row_begin, params);
+      break;
+    case DepthwiseActivation::kSwish:
+      depthwise_conv_kernel<DepthwiseActivation::kSwish>(
+          input, weight, bias, output, row_begin, params);
+      break;
+    case DepthwiseActivation::kHardswish:
+      depthwise_conv_kernel<DepthwiseActivation::kHardswish>(
+          input, weight, bias, output, row_begin, params);
+      break;
+    default:
+      depthwise_conv_kernel<DepthwiseActivation::kNone>(
+          input, weight, bias, output, row_begin, params);
+  }
+}
+
+} // namespace
+
+IPEX_REGISTER_DISPATCH(depthwise_conv_kernel_stub, &depthwise_conv_kernel_impl);
+
+} // namespace cpu
+} // namespace torch_ipex
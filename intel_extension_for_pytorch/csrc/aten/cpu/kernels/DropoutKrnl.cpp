@@ -0,0 +1,120 @@
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/vec.h>
+
+#include <immintrin.h>
+#include <cstring>
+
+#include "csrc/aten/cpu/Dropout.h"
+#include "csrc/aten/cpu/utils/float_vec.h"
+#include "csrc/aten/cpu/utils/philox.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+// The bytes of the mask of a philox block
+constexpr int64_t kBlockBytes = philox::kBlockSize / 8;
+
+void dropout_mask_kernel_impl(
+    uint64_t seed,
+    uint32_t threshold,
+    int64_t numel,
+    uint8_t* mask) {
+  const int64_t blocks =
+      (numel + philox::kBlockSize - 1) / philox::kBlockSize;
+  at::parallel_for(
+      0,
+      blocks,
+      at::internal::GRAIN_SIZE / philox::kBlockSize,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t block = begin; block < end; block++) {
+          uint64_t bits = philox::block_bits(seed, block, threshold);
+          std::memcpy(mask + block * kBlockBytes, &bits, kBlockBytes);
+        }
+      });
+}
+
+// a, b = a, b * scale of the kept elements of the kFloatVecPairSize elements
+// from i, of a multiple of kFloatVecPairSize, i.e. of a byte of the mask
+inline void apply_mask(
+    const uint8_t* mask,
+    int64_t i,
+    float scale,
+    fVec& a,
+    fVec& b) {
+#if defined(CPU_CAPABILITY_AVX512)
+  static_assert(kFloatVecPairSize == 32, "the mask of 2 AVX-512 vectors");
+  uint32_t bits;
+  std::memcpy(&bits, mask + i / 8, sizeof(bits));
+  const __m512 scale_vec = _mm512_set1_ps(scale);
+  a = _mm512_maskz_mul_ps(static_cast<__mmask16>(bits), a, scale_vec);
+  b = _mm512_maskz_mul_ps(static_cast<__mmask16>(bits >> 16), b, scale_vec);
+#else
+  float buf[kFloatVecPairSize];
+  for (int64_t j = 0; j < kFloatVecPairSize; j++) {
+    buf[j] = dropout_mask_bit(mask, i + j) ? scale : 0.f;
+  }
+  fVec scale_a, scale_b;
+  load_fvec(buf, scale_a, scale_b);
+  a = a * scale_a;
+  b = b * scale_b;
+#endif
+}
+
+template <typename scalar_t>
+void dropout_apply_kernel(
+    const at::Tensor& src,
+    const at::Tensor& mask,
+    float scale,
+    at::Tensor& dst) {
+  const scalar_t* src_data = src.data_ptr<scalar_t>();
+  const uint8_t* mask_data = mask.data_ptr<uint8_t>();
+  scalar_t* dst_data = dst.data_ptr<scalar_t>();
+  const int64_t numel = src.numel();
+  const int64_t vecs = (numel + kFloatVecPairSize - 1) / kFloatVecPairSize;
+  // the chunks of the threads are of whole vectors, i.e. of whole bytes of
+  // the mask
+  at::parallel_for(
+      0,
+      vecs,
+      at::internal::GRAIN_SIZE / kFloatVecPairSize,
+      [&](int64_t begin, int64_t end) {
+        for (int64_t v = begin; v < end; v++) {
+          const int64_t i = v * kFloatVecPairSize;
+          if (i + kFloatVecPairSize <= numel) {
+            fVec a, b;
+            load_fvec(src_data + i, a, b);
+            apply_mask(mask_data, i, scale, a, b);
+            store_fvec(dst_data + i, a, b);
+          } else {
+            for (int64_t j = i; j < numel; j++) {
+              dst_data[j] = dropout_mask_bit(mask_data, j)
+                  ? static_cast<scalar_t>(float(src_data[j]) * scale)
+                  : static_cast<scalar_t>(0.f);
+            }
+          }
+        }
+      });
+}
+
+void dropout_apply_kernel_impl(
+    const at::Tensor& src,
+    const at::Tensor& mask,
+    float scale,
+    at::Tensor& dst) {
+  if (src.scalar_type() == at::kBFloat16) {
+    dropout_apply_kernel<at::BFloat16>(src, mask, scale, dst);
+  } else {
+    dropout_apply_kernel<float>(src, mask, scale, dst);
+  }
+}
+
+} // namespace
+
+IPEX_REGISTER_DISPATCH(dropout_mask_kernel_stub, &dropout_mask_kernel_impl);
+IPEX_REGISTER_DISPATCH(dropout_apply_kernel_stub, &dropout_apply_kernel_impl);
+
+} // namespace cpu
+} // namespace torch_ipex
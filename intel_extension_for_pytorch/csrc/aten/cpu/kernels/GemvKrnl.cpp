@@ -0,0 +1,153 @@
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/vec.h>
+
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+
+#include "csrc/aten/cpu/Gemv.h"
+#include "csrc/aten/cpu/utils/float_vec.h"
+#include "csrc/utils/parallel_trace.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+// How far ahead of the loads the weight stream is prefetched, of the lines
+// the core keeps in flight to hide the DRAM latency. The weight is read once
+// per call, so it is prefetched of the non-temporal hint, which doesn't evict
+// the other data of the caches, e.g. the KV cache of the decoding
+constexpr int64_t kGemvPrefetchBytes = 1024;
+constexpr int64_t kCacheLineBytes = 64;
+
+inline float gemv_post_op(float v, float old, const GemvParams& params) {
+  switch (params.post_op) {
+    case GemvPostOp::kRelu:
+      return std::max(v, 0.f);
+    case GemvPostOp::kGeluErf:
+      return 0.5f * v * (1.f + std::erf(v * static_cast<float>(M_SQRT1_2)));
+    case GemvPostOp::kGeluTanh:
+      return 0.5f * v *
+          (1.f +
+           std::tanh(
+               static_cast<float>(M_SQRT2 * M_2_SQRTPI * 0.5) *
+               (v + 0.044715f * v * v * v)));
+    case GemvPostOp::kSum:
+      return v + params.sum_scale * old;
+    default:
+      return v;
+  }
+}
+
+// out[0:M, n] of the output channels [n_begin, n_end), of which each weight
+// row is read once for the M input rows
+template <int M, typename scalar_t>
+void gemv_channels(
+    const scalar_t* x,
+    const scalar_t* weight,
+    const float* bias,
+    scalar_t* out,
+    int64_t N,
+    int64_t K,
+    int64_t n_begin,
+    int64_t n_end,
+    const GemvParams& params) {
+  constexpr int64_t kStepBytes = kFloatVecPairSize * sizeof(scalar_t);
+  for (int64_t n = n_begin; n < n_end; n++) {
+    const scalar_t* w = weight + n * K;
+    fVec acc[M][2];
+    for (int m = 0; m < M; m++) {
+      acc[m][0] = fVec(0.f);
+      acc[m][1] = fVec(0.f);
+    }
+    int64_t k = 0;
+    for (; k + kFloatVecPairSize <= K; k += kFloatVecPairSize) {
+      const char* ahead = reinterpret_cast<const char*>(w + k) +
+          kGemvPrefetchBytes;
+      for (int64_t line = 0; line < kStepBytes; line += kCacheLineBytes) {
+        _mm_prefetch(ahead + line, _MM_HINT_NTA);
+      }
+      fVec w0, w1;
+      load_fvec(w + k, w0, w1);
+      for (int m = 0; m < M; m++) {
+        fVec x0, x1;
+        load_fvec(x + m * K + k, x0, x1);
+        acc[m][0] = at::vec::fmadd(x0, w0, acc[m][0]);
+        acc[m][1] = at::vec::fmadd(x1, w1, acc[m][1]);
+      }
+    }
+    for (int m = 0; m < M; m++) {
+      float sum = sum_fvec(acc[m][0] + acc[m][1]);
+      for (int64_t kk = k; kk < K; kk++) {
+        sum += static_cast<float>(x[m * K + kk]) * static_cast<float>(w[kk]);
+      }
+      if (bias != nullptr) {
+        sum += bias[n];
+      }
+      scalar_t* o = out + m * N + n;
+      // the output is read of the sum post op only
+      float old =
+          params.post_op == GemvPostOp::kSum ? static_cast<float>(*o) : 0.f;
+      *o = static_cast<scalar_t>(gemv_post_op(sum, old, params));
+    }
+  }
+}
+
+template <typename scalar_t>
+void gemv_kernel(
+    const at::Tensor& input,
+    const at::Tensor& weight,
+    const at::Tensor& bias,
+    at::Tensor& output,
+    const GemvParams& params) {
+  const int64_t M = input.size(0);
+  const int64_t K = input.size(1);
+  const int64_t N = weight.size(0);
+  const scalar_t* x = input.data_ptr<scalar_t>();
+  const scalar_t* w = weight.data_ptr<scalar_t>();
+  const float* b = bias.defined() ? bias.data_ptr<float>() : nullptr;
+  scalar_t* out = output.data_ptr<scalar_t>();
+
+  // the same split of the output channels as of pack_gemv_weight
+  parallel_trace::ParallelRegion region("gemv");
+  at::parallel_for(
+      0, N, kGemvMinChannelsPerThread, [&](int64_t begin, int64_t end) {
+        IPEX_PARALLEL_CHUNK(region);
+        switch (M) {
+          case 1:
+            gemv_channels<1>(x, w, b, out, N, K, begin, end, params);
+            break;
+          case 2:
+            gemv_channels<2>(x, w, b, out, N, K, begin, end, params);
+            break;
+          case 3:
+            gemv_channels<3>(x, w, b, out, N, K, begin, end, params);
+            break;
+          default:
+            gemv_channels<4>(x, w, b, out, N, K, begin, end, params);
+        }
+      });
+}
+
+void gemv_kernel_impl(
+    const at::Tensor& input,
+    const at::Tensor& weight,
+    const at::Tensor& bias,
+    at::Tensor& output,
+    const GemvParams& params) {
+  static_assert(kGemvMaxRows == 4, "the rows of gemv_kernel are up to 4");
+  if (input.scalar_type() == at::kBFloat16) {
+    gemv_kernel<at::BFloat16>(input, weight, bias, output, params);
+  } else {
+    gemv_kernel<float>(input, weight, bias, output, params);
+  }
+}
+
+} // namespace
+
+IPEX_REGISTER_DISPATCH(gemv_kernel_stub, &gemv_kernel_impl);
+
+} // namespace cpu
+} // namespace torch_ipex
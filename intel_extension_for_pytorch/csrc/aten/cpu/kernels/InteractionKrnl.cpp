@@ -0,0 +1,105 @@
+#include <ATen/ATen.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "csrc/aten/cpu/interaction.h"
+#include "csrc/cpu/amx/amx_tile.h"
+
+namespace torch_ipex {
+
+#if defined(CPU_CAPABILITY_AMX)
+
+namespace {
+
+using namespace torch_ipex::cpu::amx;
+
+// The gram matrix of each sample of the [vector_nums, vector_size] A on the
+// 16 x 16 tiles: A is padded to the rows of a multiple of 16, of which the
+// garbage of the pad rows only ends up in the rows and the columns of the
+// gram matrix beyond vector_nums, and the b tiles are of the VNNI layout of
+// A'. The blocks of 32 x 32 of the lower triangle are computed only, as the
+// callers read the triangle below the diagonal.
+template <typename T>
+void interaction_gram_kernel_impl(
+    const T* cat,
+    int64_t batch,
+    int64_t vector_nums,
+    int64_t vector_size,
+    typename TileTraits<T>::acc_t* res) {
+  using acc_t = typename TileTraits<T>::acc_t;
+  constexpr int vnni = TileTraits<T>::vnni;
+  const int64_t padded_nums =
+      (vector_nums + kTileRows - 1) / kTileRows * kTileRows;
+  thread_local std::vector<T> a_buf;
+  thread_local std::vector<T> b_buf;
+  thread_local std::vector<acc_t> c_buf;
+  a_buf.resize(padded_nums * vector_size);
+  b_buf.resize(padded_nums * vector_size);
+  c_buf.resize(padded_nums * padded_nums);
+
+  TileConfigGuard guard;
+  for (int64_t i = 0; i < batch; i++) {
+    const T* a = cat + i * vector_nums * vector_size;
+    std::memcpy(a_buf.data(), a, vector_nums * vector_size * sizeof(T));
+    pack_vnni_transposed<T>(
+        a_buf.data(), padded_nums, vector_size, b_buf.data());
+    for (int64_t m = 0; m < padded_nums; m += 2 * kTileRows) {
+      int mb = std::min<int64_t>(2, (padded_nums - m) / kTileRows);
+      for (int64_t n = 0; n <= m; n += 2 * kTileRows) {
+        int nb = std::min<int64_t>(2, (padded_nums - n) / kTileRows);
+        tile_gemm<T>(
+            a_buf.data() + m * vector_size,
+            vector_size,
+            b_buf.data() + n * vnni,
+            padded_nums * vnni,
+            c_buf.data() + m * padded_nums + n,
+            padded_nums,
+            mb,
+            nb,
+            vector_size);
+      }
+    }
+    acc_t* out = res + i * vector_nums * vector_nums;
+    for (int64_t r = 0; r < vector_nums; r++) {
+      std::memcpy(
+          out + r * vector_nums,
+          c_buf.data() + r * padded_nums,
+          vector_nums * sizeof(acc_t));
+    }
+  }
+}
+
+void interaction_gram_s8_kernel_impl(
+    const int8_t* cat,
+    int64_t batch,
+    int64_t vector_nums,
+    int64_t vector_size,
+    int32_t* res) {
+  interaction_gram_kernel_impl<int8_t>(
+      cat, batch, vector_nums, vector_size, res);
+}
+
+void interaction_gram_bf16_kernel_impl(
+    const at::BFloat16* cat,
+    int64_t batch,
+    int64_t vector_nums,
+    int64_t vector_size,
+    float* res) {
+  interaction_gram_kernel_impl<at::BFloat16>(
+      cat, batch, vector_nums, vector_size, res);
+}
+
+} // namespace
+
+IPEX_REGISTER_DISPATCH(
+    interaction_gram_s8_kernel_stub,
+    &interaction_gram_s8_kernel_impl);
+IPEX_REGISTER_DISPATCH(
+    interaction_gram_bf16_kernel_stub,
+    &interaction_gram_bf16_kernel_impl);
+
+#endif
+
+} // namespace torch_ipex
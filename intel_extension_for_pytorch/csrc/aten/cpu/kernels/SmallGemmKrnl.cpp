@@ -0,0 +1,189 @@
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/vec.h>
+
+#include <algorithm>
+
+#include "csrc/aten/cpu/SmallGemm.h"
+#include "csrc/utils/parallel_trace.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+using Vec = at::vec::Vectorized<float>;
+
+// The register tile of the microkernel: kMR rows of kNV vectors of C, which
+// with a vector of B per column and a broadcast of A fill the 32 zmm
+// registers of AVX512 or the 16 ymm registers of AVX2
+constexpr int kMR = 4;
+constexpr int kNV = Vec::size() == 16 ? 4 : 2;
+
+// c[0:MR, 0:NV * Vec::size()] = scale * a[0:MR, 0:k] x b[0:k, 0:NV *
+// Vec::size()], of which K is a compile time constant if kK > 0, so that the
+// reduction of the common head dims unrolls
+template <int MR, int NV, int64_t kK>
+inline void gemm_micro(
+    const float* a,
+    int64_t lda,
+    const float* b,
+    int64_t ldb,
+    float* c,
+    int64_t ldc,
+    int64_t k_,
+    const Vec& scale) {
+  const int64_t k = kK > 0 ? kK : k_;
+  Vec acc[MR][NV];
+  for (int i = 0; i < MR; i++) {
+    for (int j = 0; j < NV; j++) {
+      acc[i][j] = Vec(0.f);
+    }
+  }
+  for (int64_t p = 0; p < k; p++) {
+    Vec vb[NV];
+    for (int j = 0; j < NV; j++) {
+      vb[j] = Vec::loadu(b + p * ldb + j * Vec::size());
+    }
+    for (int i = 0; i < MR; i++) {
+      Vec va(a[i * lda + p]);
+      for (int j = 0; j < NV; j++) {
+        acc[i][j] = at::vec::fmadd(va, vb[j], acc[i][j]);
+      }
+    }
+  }
+  for (int i = 0; i < MR; i++) {
+    for (int j = 0; j < NV; j++) {
+      (acc[i][j] * scale).store(c + i * ldc + j * Vec::size());
+    }
+  }
+}
+
+// the tail of the columns of C, fewer than a vector
+template <int MR, int64_t kK>
+inline void gemm_micro_tail(
+    const float* a,
+    int64_t lda,
+    const float* b,
+    int64_t ldb,
+    float* c,
+    int64_t ldc,
+    int64_t k_,
+    int64_t cols,
+    const Vec& scale) {
+  const int64_t k = kK > 0 ? kK : k_;
+  Vec acc[MR];
+  for (int i = 0; i < MR; i++) {
+    acc[i] = Vec(0.f);
+  }
+  for (int64_t p = 0; p < k; p++) {
+    Vec vb = Vec::loadu(b + p * ldb, cols);
+    for (int i = 0; i < MR; i++) {
+      acc[i] = at::vec::fmadd(Vec(a[i * lda + p]), vb, acc[i]);
+    }
+  }
+  for (int i = 0; i < MR; i++) {
+    (acc[i] * scale).store(c + i * ldc, cols);
+  }
+}
+
+// MR rows of C of a matrix of the batch
+template <int MR, int64_t kK>
+inline void gemm_rows(
+    const float* a,
+    const float* b,
+    float* c,
+    int64_t n,
+    int64_t k,
+    const Vec& scale) {
+  constexpr int64_t kTileN = kNV * Vec::size();
+  int64_t j = 0;
+  for (; j + kTileN <= n; j += kTileN) {
+    gemm_micro<MR, kNV, kK>(a, k, b + j, n, c + j, n, k, scale);
+  }
+  for (; j + Vec::size() <= n; j += Vec::size()) {
+    gemm_micro<MR, 1, kK>(a, k, b + j, n, c + j, n, k, scale);
+  }
+  if (j < n) {
+    gemm_micro_tail<MR, kK>(a, k, b + j, n, c + j, n, k, n - j, scale);
+  }
+}
+
+template <int64_t kK>
+void batched_small_gemm(
+    const float* a,
+    const float* b,
+    float* c,
+    int64_t batch,
+    int64_t m,
+    int64_t n,
+    int64_t k,
+    float scale) {
+  const Vec vscale(scale);
+  // A matrix is a task if there are enough of them to occupy the threads,
+  // e.g. of the batch x heads of the attention, otherwise the row blocks of
+  // the matrices are
+  const int64_t row_blocks =
+      batch >= at::get_num_threads() ? 1 : (m + kMR - 1) / kMR;
+  const int64_t rows_per_task = row_blocks == 1 ? m : kMR;
+  parallel_trace::ParallelRegion region("batched_small_gemm");
+  at::parallel_for(0, batch * row_blocks, 1, [&](int64_t begin, int64_t end) {
+    IPEX_PARALLEL_CHUNK(region);
+    for (int64_t t = begin; t < end; t++) {
+      const int64_t bi = t / row_blocks;
+      const int64_t row_begin = (t % row_blocks) * rows_per_task;
+      const int64_t row_end = std::min(m, row_begin + rows_per_task);
+      const float* a_ = a + bi * m * k;
+      const float* b_ = b + bi * k * n;
+      float* c_ = c + bi * m * n;
+      int64_t i = row_begin;
+      for (; i + kMR <= row_end; i += kMR) {
+        gemm_rows<kMR, kK>(a_ + i * k, b_, c_ + i * n, n, k, vscale);
+      }
+      for (; i < row_end; i++) {
+        gemm_rows<1, kK>(a_ + i * k, b_, c_ + i * n, n, k, vscale);
+      }
+    }
+  });
+}
+
+void batched_small_gemm_kernel_impl(
+    const at::Tensor& a,
+    const at::Tensor& b,
+    at::Tensor& out,
+    float scale) {
+  const int64_t m = a.size(-2);
+  const int64_t k = a.size(-1);
+  const int64_t n = b.size(-1);
+  if (out.numel() == 0) {
+    return;
+  }
+  const int64_t batch = out.numel() / (m * n);
+  const float* a_data = a.data_ptr<float>();
+  const float* b_data = b.data_ptr<float>();
+  float* out_data = out.data_ptr<float>();
+  // the head dims of the attention and the sequence lengths common enough to
+  // specialize
+  switch (k) {
+    case 32:
+      batched_small_gemm<32>(a_data, b_data, out_data, batch, m, n, k, scale);
+      break;
+    case 64:
+      batched_small_gemm<64>(a_data, b_data, out_data, batch, m, n, k, scale);
+      break;
+    case 128:
+      batched_small_gemm<128>(a_data, b_data, out_data, batch, m, n, k, scale);
+      break;
+    default:
+      batched_small_gemm<0>(a_data, b_data, out_data, batch, m, n, k, scale);
+  }
+}
+
+} // namespace
+
+IPEX_REGISTER_DISPATCH(
+    batched_small_gemm_kernel_stub,
+    &batched_small_gemm_kernel_impl);
+
+} // namespace cpu
+} // namespace torch_ipex
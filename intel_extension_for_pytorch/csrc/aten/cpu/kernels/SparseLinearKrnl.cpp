@@ -0,0 +1,156 @@
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/vec.h>
+
+#include <algorithm>
+
+#include "csrc/aten/cpu/SparseLinear.h"
+#include "csrc/utils/parallel_trace.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+using Vec = at::vec::Vectorized<float>;
+
+// The register tile of the microkernel: kMR input rows of the kNV vectors of
+// a block, of which the weights are loaded once for the kMR rows
+constexpr int kNV = kSparseBlockN / Vec::size();
+constexpr int kMR = Vec::size() == 16 ? 8 : 4;
+
+static_assert(
+    kSparseBlockN % Vec::size() == 0,
+    "the block-sparse weight block must be of whole float vectors");
+
+inline Vec load_cols(const float* p, int64_t count) {
+  if (count >= Vec::size()) {
+    return Vec::loadu(p);
+  }
+  return count > 0 ? Vec::loadu(p, count) : Vec(0.f);
+}
+
+inline void store_cols(const Vec& v, float* p, int64_t count) {
+  if (count >= Vec::size()) {
+    v.store(p);
+  } else if (count > 0) {
+    v.store(p, count);
+  }
+}
+
+// out[0:MR, 0:cols] = x[0:MR, :] x the blocks of kSparseBlockN output
+// channels + bias[0:cols], of which cols is of the last output channels only
+template <int MR>
+inline void sparse_gemm_micro(
+    const float* x,
+    int64_t ldx,
+    const float* values,
+    const int32_t* indices,
+    int64_t blocks,
+    const float* bias,
+    float* out,
+    int64_t ldo,
+    int64_t cols) {
+  Vec acc[MR][kNV];
+  for (int j = 0; j < kNV; j++) {
+    Vec b = bias == nullptr ? Vec(0.f)
+                            : load_cols(bias + j * Vec::size(),
+                                        cols - j * Vec::size());
+    for (int i = 0; i < MR; i++) {
+      acc[i][j] = b;
+    }
+  }
+  for (int64_t b = 0; b < blocks; b++) {
+    const int64_t k = indices[b];
+    Vec vw[kNV];
+    for (int j = 0; j < kNV; j++) {
+      vw[j] = Vec::loadu(values + b * kSparseBlockN + j * Vec::size());
+    }
+    for (int i = 0; i < MR; i++) {
+      Vec vx(x[i * ldx + k]);
+      for (int j = 0; j < kNV; j++) {
+        acc[i][j] = at::vec::fmadd(vx, vw[j], acc[i][j]);
+      }
+    }
+  }
+  for (int i = 0; i < MR; i++) {
+    for (int j = 0; j < kNV; j++) {
+      store_cols(
+          acc[i][j], out + i * ldo + j * Vec::size(), cols - j * Vec::size());
+    }
+  }
+}
+
+void sparse_linear_kernel_impl(
+    const at::Tensor& input,
+    const at::Tensor& values,
+    const at::Tensor& indices,
+    const at::Tensor& offsets,
+    const at::Tensor& bias,
+    at::Tensor& output) {
+  const int64_t M = input.size(0);
+  const int64_t K = input.size(1);
+  const int64_t N = output.size(1);
+  const int64_t col_blocks = offsets.numel() - 1;
+  const int64_t row_tiles = (M + kMR - 1) / kMR;
+  if (M == 0 || N == 0) {
+    return;
+  }
+  const float* x_data = input.data_ptr<float>();
+  const float* values_data = values.data_ptr<float>();
+  const int32_t* indices_data = indices.data_ptr<int32_t>();
+  const int64_t* offsets_data = offsets.data_ptr<int64_t>();
+  const float* b_data = bias.defined() ? bias.data_ptr<float>() : nullptr;
+  float* out_data = output.data_ptr<float>();
+
+  // The tasks of a block column run the row tiles in turn, so that the
+  // nonzero blocks of the column stay in the cache for all the rows
+  parallel_trace::ParallelRegion region("sparse_linear");
+  at::parallel_for(
+      0, col_blocks * row_tiles, 1, [&](int64_t begin, int64_t end) {
+        IPEX_PARALLEL_CHUNK(region);
+        for (int64_t t = begin; t < end; t++) {
+          const int64_t nb = t / row_tiles;
+          const int64_t row_begin = t % row_tiles * kMR;
+          const int64_t n = nb * kSparseBlockN;
+          const int64_t cols = std::min(kSparseBlockN, N - n);
+          const int64_t first = offsets_data[nb];
+          const int64_t blocks = offsets_data[nb + 1] - first;
+          const float* values_ = values_data + first * kSparseBlockN;
+          const int32_t* indices_ = indices_data + first;
+          const float* bias_ = b_data == nullptr ? nullptr : b_data + n;
+          if (row_begin + kMR <= M) {
+            sparse_gemm_micro<kMR>(
+                x_data + row_begin * K,
+                K,
+                values_,
+                indices_,
+                blocks,
+                bias_,
+                out_data + row_begin * N + n,
+                N,
+                cols);
+            continue;
+          }
+          for (int64_t m = row_begin; m < M; m++) {
+            sparse_gemm_micro<1>(
+                x_data + m * K,
+                K,
+                values_,
+                indices_,
+                blocks,
+                bias_,
+                out_data + m * N + n,
+                N,
+                cols);
+          }
+        }
+      });
+}
+
+} // namespace
+
+IPEX_REGISTER_DISPATCH(sparse_linear_kernel_stub, &sparse_linear_kernel_impl);
+
+} // namespace cpu
+} // namespace torch_ipex
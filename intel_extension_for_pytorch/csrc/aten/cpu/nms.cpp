@@ -5,363 +5,419 @@
 #include <immintrin.h>
 #include <torch/csrc/autograd/function.h>
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <vector>
 #include "csrc/autocast/autocast_mode.h"
 #include "csrc/autocast/autocast_verbose.h"
 #include "csrc/jit/cpu/kernels/Softmax.h"
+#include "csrc/utils/op_trace.h"
+#include "csrc/utils/parallel_trace.h"
 
 namespace torch_ipex {
+
+namespace {
+
+// The suppression masks are kept as bits, 64 boxes per mask
+constexpr int64_t kNmsMaskBits = 64;
+// The rows of the suppression masks computed at a time, to bound the memory of
+// the masks for the large number of boxes
+constexpr int64_t kNmsRowBlock = 1024;
+
+inline bool nms_mask_test(const uint64_t* mask, int64_t i) {
+  return (mask[i / kNmsMaskBits] >> (i % kNmsMaskBits)) & 1;
+}
+
+// mask[cb] for the column blocks cb from the one of box i: the bit j % 64 of
+// mask[j / 64] is set if box j > i has IoU >= threshold with box i.
+template <typename scalar_t>
+inline void nms_mask_row(
+    int64_t i,
+    int64_t ndets,
+    const scalar_t* x1,
+    const scalar_t* y1,
+    const scalar_t* x2,
+    const scalar_t* y2,
+    const scalar_t* areas,
+    float threshold,
+    float bias,
+    uint64_t* mask) {
+  auto ix1 = x1[i];
+  auto iy1 = y1[i];
+  auto ix2 = x2[i];
+  auto iy2 = y2[i];
+  auto iarea = areas[i];
+  auto col_blocks = (ndets + kNmsMaskBits - 1) / kNmsMaskBits;
+  for (int64_t cb = i / kNmsMaskBits; cb < col_blocks; cb++) {
+    uint64_t bits = 0;
+    auto col_begin = cb * kNmsMaskBits;
+    auto col_end = std::min(col_begin + kNmsMaskBits, ndets);
+    for (int64_t j = std::max(col_begin, i + 1); j < col_end; j++) {
+      auto xx1 = std::max(ix1, x1[j]);
+      auto yy1 = std::max(iy1, y1[j]);
+      auto xx2 = std::min(ix2, x2[j]);
+      auto yy2 = std::min(iy2, y2[j]);
+
+      auto w = std::max(static_cast<scalar_t>(0), xx2 - xx1 + bias);
+      auto h = std::max(static_cast<scalar_t>(0), yy2 - yy1 + bias);
+      auto inter = w * h;
+      auto ovr = inter / (iarea + areas[j] - inter);
+      bits |= static_cast<uint64_t>(ovr >= threshold) << (j - col_begin);
+    }
+    mask[cb] = bits;
+  }
+}
+
+#ifdef CPU_AVX512
+// The IoU of box i with 16 boxes per instruction, 4 of them per mask.
+template <>
+inline void nms_mask_row<float>(
+    int64_t i,
+    int64_t ndets,
+    const float* x1,
+    const float* y1,
+    const float* x2,
+    const float* y2,
+    const float* areas,
+    float threshold,
+    float bias,
+    uint64_t* mask) {
+  __m512 m512_zero = _mm512_setzero_ps();
+  __m512 m512_bias = _mm512_set1_ps(bias);
+  __m512 m512_threshold = _mm512_set1_ps(threshold);
+  __m512 m512_ix1 = _mm512_set1_ps(x1[i]);
+  __m512 m512_iy1 = _mm512_set1_ps(y1[i]);
+  __m512 m512_ix2 = _mm512_set1_ps(x2[i]);
+  __m512 m512_iy2 = _mm512_set1_ps(y2[i]);
+  __m512 m512_iarea = _mm512_set1_ps(areas[i]);
+  auto col_blocks = (ndets + kNmsMaskBits - 1) / kNmsMaskBits;
+  for (int64_t cb = i / kNmsMaskBits; cb < col_blocks; cb++) {
+    uint64_t bits = 0;
+    for (int64_t k = 0; k < kNmsMaskBits; k += 16) {
+      int64_t j = cb * kNmsMaskBits + k;
+      if (j >= ndets) {
+        break;
+      }
+      __mmask16 load_mask =
+          ndets - j >= 16 ? 0xffff : (1 << (ndets - j)) - 1;
+      __m512 m512_x1 = _mm512_maskz_loadu_ps(load_mask, x1 + j);
+      __m512 m512_y1 = _mm512_maskz_loadu_ps(load_mask, y1 + j);
+      __m512 m512_x2 = _mm512_maskz_loadu_ps(load_mask, x2 + j);
+      __m512 m512_y2 = _mm512_maskz_loadu_ps(load_mask, y2 + j);
+      __m512 m512_areas = _mm512_maskz_loadu_ps(load_mask, areas + j);
+
+      __m512 m512_xx1 = _mm512_max_ps(m512_ix1, m512_x1);
+      __m512 m512_yy1 = _mm512_max_ps(m512_iy1, m512_y1);
+      __m512 m512_xx2 = _mm512_min_ps(m512_ix2, m512_x2);
+      __m512 m512_yy2 = _mm512_min_ps(m512_iy2, m512_y2);
+      __m512 m512_w = _mm512_max_ps(
+          m512_zero,
+          _mm512_add_ps(_mm512_sub_ps(m512_xx2, m512_xx1), m512_bias));
+      __m512 m512_h = _mm512_max_ps(
+          m512_zero,
+          _mm512_add_ps(_mm512_sub_ps(m512_yy2, m512_yy1), m512_bias));
+      __m512 m512_inter = _mm512_mul_ps(m512_w, m512_h);
+      __m512 m512_over = _mm512_div_ps(
+          m512_inter,
+          _mm512_sub_ps(_mm512_add_ps(m512_iarea, m512_areas), m512_inter));
+      __mmask16 mask_sus = _mm512_mask_cmp_ps_mask(
+          load_mask, m512_over, m512_threshold, _CMP_GE_OS);
+      bits |= static_cast<uint64_t>(mask_sus) << k;
+    }
+    mask[cb] = bits;
+  }
+  // only the boxes after box i are suppressed by it
+  auto offset = i % kNmsMaskBits;
+  mask[i / kNmsMaskBits] &= offset == kNmsMaskBits - 1
+      ? 0
+      : ~((static_cast<uint64_t>(2) << offset) - 1);
+}
+#endif
+
+} // namespace
+
 /*
  When calculating the Intersection over Union:
   MaskRCNN: bias = 1
   SSD-Resnet34: bias = 0
+ At most max_output boxes of the highest scores are kept if max_output > 0.
 */
 template <typename scalar_t, bool sorted>
 at::Tensor nms_cpu_kernel(
     const at::Tensor& dets,
     const at::Tensor& scores,
     const float threshold,
-    float bias = 1.0);
+    float bias = 1.0,
+    int64_t max_output = -1);
 
+/*
+ The boxes are processed in the descending order of the scores, in blocks of
+ kNmsRowBlock boxes. The boxes of a block are selected from the candidates by
+ a partial sort, and their suppression masks of the candidates are computed
+ in parallel. Then the boxes of the block are kept or suppressed in order by
+ the OR of the masks of the kept boxes, and the suppressed candidates are
+ dropped before the next block. So that the candidates are sorted only as far
+ as the boxes are visited, e.g. until max_output boxes are kept.
+
+ The candidates are the indices of the boxes, of which the kept ones are
+ appended to kept in the descending order of the scores. The masks are
+ computed serially when it is called in a parallel region, e.g. per group of
+ batched_nms.
+*/
 template <typename scalar_t, bool sorted>
-at::Tensor nms_cpu_kernel(
-    const at::Tensor& dets,
-    const at::Tensor& scores,
+void nms_candidates(
+    const scalar_t* boxes,
+    const scalar_t* score,
+    std::vector<int64_t>& candidates,
     const float threshold,
-    float bias) {
-  AT_ASSERTM(!dets.is_cuda(), "dets must be a CPU tensor");
-  AT_ASSERTM(!scores.is_cuda(), "scores must be a CPU tensor");
-  AT_ASSERTM(
-      dets.scalar_type() == scores.scalar_type(),
-      "dets should have the same type as scores");
-
-  if (dets.numel() == 0) {
-    return at::empty({0}, dets.options().dtype(at::kLong).device(at::kCPU));
-  }
-
-  auto x1_t = dets.select(1, 0).contiguous();
-  auto y1_t = dets.select(1, 1).contiguous();
-  auto x2_t = dets.select(1, 2).contiguous();
-  auto y2_t = dets.select(1, 3).contiguous();
-
-  at::Tensor areas_t = (x2_t - x1_t + bias) * (y2_t - y1_t + bias);
+    float bias,
+    int64_t max_output,
+    std::vector<int64_t>& kept) {
+  auto higher_score = [&](int64_t a, int64_t b) {
+    return score[a] > score[b] || (score[a] == score[b] && a < b);
+  };
+
+  // The coordinates and the areas of the candidates as struct-of-arrays. If
+  // scores and dets are already sorted in descending order, we don't need to
+  // sort them again.
+  int64_t num_candidates = candidates.size();
+  std::vector<scalar_t> x1(num_candidates), y1(num_candidates);
+  std::vector<scalar_t> x2(num_candidates), y2(num_candidates);
+  std::vector<scalar_t> areas(num_candidates);
+  std::vector<uint64_t> removed;
+  std::vector<uint64_t> masks;
+  int64_t num_kept = 0;
+  while (num_candidates > 0 && num_kept < max_output) {
+    auto nrows = std::min(num_candidates, kNmsRowBlock);
+    auto begin = candidates.begin();
+    if (!sorted) {
+      std::nth_element(
+          begin, begin + nrows, begin + num_candidates, higher_score);
+      std::sort(begin, begin + nrows, higher_score);
+    }
+    for (int64_t p = 0; p < num_candidates; p++) {
+      auto box = boxes + candidates[p] * 4;
+      x1[p] = box[0];
+      y1[p] = box[1];
+      x2[p] = box[2];
+      y2[p] = box[3];
+      areas[p] = (x2[p] - x1[p] + bias) * (y2[p] - y1[p] + bias);
+    }
 
-  auto ndets = dets.size(0);
-  // If scores and dets are already sorted in descending order, we don't need to
-  // sort it again.
-  auto order_t = sorted
-      ? at::arange(0, ndets, scores.options().dtype(at::kLong))
-      : std::get<1>(scores.sort(0, /* descending=*/true));
-
-  at::Tensor suppressed_t =
-      at::zeros({ndets}, dets.options().dtype(at::kByte).device(at::kCPU));
-
-  auto suppressed = suppressed_t.data_ptr<uint8_t>();
-  auto order = order_t.data_ptr<int64_t>();
-  auto x1 = x1_t.data_ptr<scalar_t>();
-  auto y1 = y1_t.data_ptr<scalar_t>();
-  auto x2 = x2_t.data_ptr<scalar_t>();
-  auto y2 = y2_t.data_ptr<scalar_t>();
-  auto areas = areas_t.data_ptr<scalar_t>();
-  for (int64_t _i = 0; _i < ndets; _i++) {
-    auto i = order[_i];
-    if (suppressed[i] == 1)
-      continue;
-    auto ix1 = x1[i];
-    auto iy1 = y1[i];
-    auto ix2 = x2[i];
-    auto iy2 = y2[i];
-    auto iarea = areas[i];
+    auto col_blocks = (num_candidates + kNmsMaskBits - 1) / kNmsMaskBits;
+    removed.assign(col_blocks, 0);
+    masks.resize(nrows * col_blocks);
 
+    parallel_trace::ParallelRegion region("nms_mask_rows");
 #ifdef _OPENMP
-#if (_OPENMP >= 201307)
-#pragma omp parallel for simd schedule( \
-    static) if (omp_get_max_threads() > 1 && !omp_in_parallel())
-#else
 #pragma omp parallel for schedule( \
     static) if (omp_get_max_threads() > 1 && !omp_in_parallel())
 #endif
-#endif
-    for (int64_t _j = _i + 1; _j < ndets; _j++) {
-      auto j = order[_j];
-      if (suppressed[j] == 1)
+    for (int64_t r = 0; r < nrows; r++) {
+      IPEX_PARALLEL_CHUNK(region);
+      nms_mask_row<scalar_t>(
+          r,
+          num_candidates,
+          x1.data(),
+          y1.data(),
+          x2.data(),
+          y2.data(),
+          areas.data(),
+          threshold,
+          bias,
+          masks.data() + r * col_blocks);
+    }
+
+    for (int64_t r = 0; r < nrows && num_kept < max_output; r++) {
+      if (nms_mask_test(removed.data(), r)) {
         continue;
-      auto xx1 = std::max(ix1, x1[j]);
-      auto yy1 = std::max(iy1, y1[j]);
-      auto xx2 = std::min(ix2, x2[j]);
-      auto yy2 = std::min(iy2, y2[j]);
+      }
+      kept.push_back(candidates[r]);
+      num_kept++;
+      auto mask = masks.data() + r * col_blocks;
+      for (int64_t cb = r / kNmsMaskBits; cb < col_blocks; cb++) {
+        removed[cb] |= mask[cb];
+      }
+    }
 
-      auto w = std::max(static_cast<scalar_t>(0), xx2 - xx1 + bias);
-      auto h = std::max(static_cast<scalar_t>(0), yy2 - yy1 + bias);
-      auto inter = w * h;
-      auto ovr = inter / (iarea + areas[j] - inter);
-      if (ovr >= threshold)
-        suppressed[j] = 1;
+    int64_t n = 0;
+    for (int64_t p = nrows; p < num_candidates; p++) {
+      if (!nms_mask_test(removed.data(), p)) {
+        candidates[n++] = candidates[p];
+      }
     }
+    num_candidates = n;
   }
-  return at::nonzero(suppressed_t == 0).squeeze(1);
 }
 
-#ifdef CPU_AVX512
-// Optimized nms_cpu_kernel specialized for data type: float32 and sorted_score
-template <>
-at::Tensor nms_cpu_kernel</*scalar_t*/ float, /*sorted*/ true>(
+template <typename scalar_t, bool sorted>
+at::Tensor nms_cpu_kernel(
     const at::Tensor& dets,
     const at::Tensor& scores,
     const float threshold,
-    float bias) {
+    float bias,
+    int64_t max_output) {
   AT_ASSERTM(!dets.is_cuda(), "dets must be a CPU tensor");
   AT_ASSERTM(!scores.is_cuda(), "scores must be a CPU tensor");
   AT_ASSERTM(
       dets.scalar_type() == scores.scalar_type(),
       "dets should have the same type as scores");
 
-  AT_ASSERTM(dets.sizes().size() == 2, "dets should have 2 dimension");
-  AT_ASSERTM(scores.sizes().size() == 1, "scores should have 1 dimension");
-
-  at::Tensor dets_bbox_number_in_lastdim = dets.permute({1, 0}).contiguous();
-  AT_ASSERTM(
-      dets_bbox_number_in_lastdim.size(1) == scores.size(0),
-      "dets should have number of bboxs as scores");
-  AT_ASSERTM(
-      dets_bbox_number_in_lastdim.size(0) == 4,
-      "each bbox in dets should have 4 coordinates");
-
-  if (dets_bbox_number_in_lastdim.numel() == 0) {
-    return at::empty(
-        {0},
-        dets_bbox_number_in_lastdim.options().dtype(at::kLong).device(
-            at::kCPU));
+  if (dets.numel() == 0) {
+    return at::empty({0}, dets.options().dtype(at::kLong).device(at::kCPU));
   }
 
-  auto x1_t = dets_bbox_number_in_lastdim.select(0, 0).contiguous();
-  auto y1_t = dets_bbox_number_in_lastdim.select(0, 1).contiguous();
-  auto x2_t = dets_bbox_number_in_lastdim.select(0, 2).contiguous();
-  auto y2_t = dets_bbox_number_in_lastdim.select(0, 3).contiguous();
-
-  auto ndets = dets_bbox_number_in_lastdim.size(1);
-  auto ndets_up_scale = (ndets / 16 + 1) * 16;
-  auto ndets_down_scale = (ndets / 16) * 16;
-  at::Tensor&& areas_t =
-      at::zeros({ndets}, dets_bbox_number_in_lastdim.options()).contiguous();
-  auto areas = areas_t.data_ptr<float>();
-  auto x1 = x1_t.data_ptr<float>();
-  auto y1 = y1_t.data_ptr<float>();
-  auto x2 = x2_t.data_ptr<float>();
-  auto y2 = y2_t.data_ptr<float>();
-  __m512 m512_zero = _mm512_setzero_ps();
-  __m512 m512_bias = _mm512_set1_ps(bias);
-  __m128i m128_zeroi = _mm_setzero_si128();
+  auto ndets = dets.size(0);
+  if (max_output <= 0 || max_output > ndets) {
+    max_output = ndets;
+  }
+  auto dets_t = dets.contiguous();
+  auto scores_t = scores.contiguous();
+  std::vector<int64_t> candidates(ndets);
+  std::iota(candidates.begin(), candidates.end(), 0);
+  std::vector<int64_t> kept;
+  nms_candidates<scalar_t, sorted>(
+      dets_t.data_ptr<scalar_t>(),
+      scores_t.data_ptr<scalar_t>(),
+      candidates,
+      threshold,
+      bias,
+      max_output,
+      kept);
+
+  // the kept boxes in the order of the indices of dets
+  std::sort(kept.begin(), kept.end());
+  auto keep_t = at::empty(
+      {static_cast<int64_t>(kept.size())},
+      dets.options().dtype(at::kLong).device(at::kCPU));
+  std::copy(kept.begin(), kept.end(), keep_t.data_ptr<int64_t>());
+  return keep_t;
+}
 
-  // Step1: Calculate the area of all bbox's
-#ifdef _OPENMP
-#if (_OPENMP >= 201307)
-#pragma omp parallel for simd schedule( \
-    static) if (omp_get_max_threads() > 1 && !omp_in_parallel())
-#else
-#pragma omp parallel for schedule( \
-    static) if (omp_get_max_threads() > 1 && !omp_in_parallel())
-#endif
-#endif
-  for (int i = 0; i < ndets_up_scale; i += 16) {
-    __m512 m512_x1;
-    __m512 m512_x2;
-    __m512 m512_y1;
-    __m512 m512_y2;
-    __m512 m512_result;
-    if (i < ndets_down_scale) {
-      // vector
-      m512_x1 = _mm512_loadu_ps(x1 + i);
-      m512_x2 = _mm512_loadu_ps(x2 + i);
-      m512_y1 = _mm512_loadu_ps(y1 + i);
-      m512_y2 = _mm512_loadu_ps(y2 + i);
-      if (bias == 0) {
-        m512_result = _mm512_mul_ps(
-            _mm512_sub_ps(m512_x2, m512_x1), _mm512_sub_ps(m512_y2, m512_y1));
-      } else {
-        m512_result = _mm512_mul_ps(
-            _mm512_add_ps(_mm512_sub_ps(m512_x2, m512_x1), m512_bias),
-            _mm512_add_ps(_mm512_sub_ps(m512_y2, m512_y1), m512_bias));
-      }
-      _mm512_storeu_ps(areas + i, m512_result);
-    } else {
-      // tail case
-      unsigned short left_idx = ndets - ndets_down_scale;
-      __mmask16 mask = (1 << left_idx) - 1; // 0x03ff;
-      m512_x1 = _mm512_mask_loadu_ps(m512_zero, mask, x1 + i);
-      m512_x2 = _mm512_mask_loadu_ps(m512_zero, mask, x2 + i);
-      m512_y1 = _mm512_mask_loadu_ps(m512_zero, mask, y1 + i);
-      m512_y2 = _mm512_mask_loadu_ps(m512_zero, mask, y2 + i);
-      if (bias == 0) {
-        m512_result = _mm512_mask_mul_ps(
-            m512_zero,
-            mask,
-            _mm512_mask_sub_ps(m512_zero, mask, m512_x2, m512_x1),
-            _mm512_mask_sub_ps(m512_zero, mask, m512_y2, m512_y1));
-      } else {
-        m512_result = _mm512_mask_mul_ps(
-            m512_zero,
-            mask,
-            _mm512_mask_add_ps(
-                m512_zero,
-                mask,
-                _mm512_mask_sub_ps(m512_zero, mask, m512_x2, m512_x1),
-                m512_bias),
-            _mm512_mask_add_ps(
-                m512_zero,
-                mask,
-                _mm512_mask_sub_ps(m512_zero, mask, m512_y2, m512_y1),
-                m512_bias));
-      }
-      _mm512_mask_storeu_ps(areas + i, mask, m512_result);
+/*
+ The NMS of the boxes of each group of idxs, e.g. of each image and class of a
+ detection batch, of the IoU > iou_threshold as torchvision.ops.batched_nms.
+ The boxes are grouped by a sort of their indices by the groups, and the
+ groups run in parallel, one group per thread at a time from the largest one,
+ each with the vectorized masks of nms_candidates. The kept boxes of a group
+ are written into its range of the boxes in one buffer of all the boxes, which
+ is compacted and sorted by the scores at the end.
+*/
+template <typename scalar_t>
+at::Tensor batched_nms_kernel(
+    const at::Tensor& boxes,
+    const at::Tensor& scores,
+    const at::Tensor& idxs,
+    const double iou_threshold) {
+  auto nboxes = boxes.size(0);
+  if (nboxes == 0) {
+    return at::empty({0}, boxes.options().dtype(at::kLong));
+  }
+  auto boxes_t = boxes.contiguous();
+  auto scores_t = scores.contiguous();
+  auto idxs_t = idxs.to(at::kLong).contiguous();
+  const scalar_t* box_data = boxes_t.data_ptr<scalar_t>();
+  const scalar_t* score = scores_t.data_ptr<scalar_t>();
+  const int64_t* idx = idxs_t.data_ptr<int64_t>();
+
+  std::vector<int64_t> order(nboxes);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](int64_t a, int64_t b) {
+    return idx[a] < idx[b];
+  });
+  // the ranges of the groups in order, from the largest one
+  std::vector<std::pair<int64_t, int64_t>> groups;
+  for (int64_t begin = 0, end = 1; end <= nboxes; end++) {
+    if (end == nboxes || idx[order[end]] != idx[order[begin]]) {
+      groups.emplace_back(begin, end);
+      begin = end;
     }
   }
-  // Step2: Go through the NMS flow
-  at::Tensor suppressed_t = at::zeros(
-      {ndets},
-      dets_bbox_number_in_lastdim.options().dtype(at::kByte).device(at::kCPU));
-  auto suppressed = suppressed_t.data_ptr<uint8_t>();
-  for (int64_t i = 0; i < ndets; i++) {
-    if (suppressed[i] == 1)
-      continue;
-    auto ix1 = x1[i];
-    auto iy1 = y1[i];
-    auto ix2 = x2[i];
-    auto iy2 = y2[i];
-    auto iarea = areas[i];
-
-    __m512 m512_ix1 = _mm512_set1_ps(ix1);
-    __m512 m512_ix2 = _mm512_set1_ps(ix2);
-    __m512 m512_iy1 = _mm512_set1_ps(iy1);
-    __m512 m512_iy2 = _mm512_set1_ps(iy2);
-    __m512 m512_iarea = _mm512_set1_ps(iarea);
-    __m512 m512_threshold = _mm512_set1_ps(threshold);
-
-    auto ndets_i_up_scale = ((ndets - i - 1) / 16 + 1) * 16;
-    auto ndets_i_down_scale = ((ndets - i - 1) / 16) * 16;
+  std::sort(groups.begin(), groups.end(), [](const auto& a, const auto& b) {
+    return a.second - a.first > b.second - b.first;
+  });
+
+  // the masks are of IoU >= threshold, i.e. of the smallest float above
+  // iou_threshold for IoU > iou_threshold
+  float threshold = static_cast<float>(iou_threshold);
+  if (static_cast<double>(threshold) <= iou_threshold) {
+    threshold = std::nextafter(threshold, std::numeric_limits<float>::max());
+  }
 
+  std::vector<int64_t> kept_all(nboxes);
+  std::vector<int64_t> num_kept(groups.size());
+  const int64_t ngroups = groups.size();
+  parallel_trace::ParallelRegion region("batched_nms");
 #ifdef _OPENMP
-#if (_OPENMP >= 201307)
-#pragma omp parallel for simd schedule( \
-    static) if (omp_get_max_threads() > 1 && !omp_in_parallel())
-#else
 #pragma omp parallel for schedule( \
-    static) if (omp_get_max_threads() > 1 && !omp_in_parallel())
+    dynamic) if (omp_get_max_threads() > 1 && !omp_in_parallel())
 #endif
-#endif
-    for (int64_t _j = 0; _j < ndets_i_up_scale; _j += 16) {
-      if (_j < ndets_i_down_scale) {
-        int64_t j = _j + i + 1;
-        __m512 m512_x1 = _mm512_loadu_ps(x1 + j);
-        __m512 m512_x2 = _mm512_loadu_ps(x2 + j);
-        __m512 m512_y1 = _mm512_loadu_ps(y1 + j);
-        __m512 m512_y2 = _mm512_loadu_ps(y2 + j);
-
-        __m512 m512_xx1 = _mm512_max_ps(m512_ix1, m512_x1);
-        __m512 m512_yy1 = _mm512_max_ps(m512_iy1, m512_y1);
-        __m512 m512_xx2 = _mm512_min_ps(m512_ix2, m512_x2);
-        __m512 m512_yy2 = _mm512_min_ps(m512_iy2, m512_y2);
-
-        __m512 m512_w;
-        __m512 m512_h;
-        if (bias == 0) {
-          m512_w = _mm512_max_ps(m512_zero, _mm512_sub_ps(m512_xx2, m512_xx1));
-          m512_h = _mm512_max_ps(m512_zero, _mm512_sub_ps(m512_yy2, m512_yy1));
-        } else {
-          m512_w = _mm512_max_ps(
-              m512_zero,
-              _mm512_add_ps(_mm512_sub_ps(m512_xx2, m512_xx1), m512_bias));
-          m512_h = _mm512_max_ps(
-              m512_zero,
-              _mm512_add_ps(_mm512_sub_ps(m512_yy2, m512_yy1), m512_bias));
-        }
-
-        __m512 m512_inter = _mm512_mul_ps(m512_w, m512_h);
-        __m512 m512_areas = _mm512_loadu_ps(areas + j);
-        __m512 m512_over = _mm512_div_ps(
-            m512_inter,
-            _mm512_sub_ps(_mm512_add_ps(m512_iarea, m512_areas), m512_inter));
-        __mmask16 mask_sus =
-            _mm512_cmp_ps_mask(m512_over, m512_threshold, _CMP_GE_OS);
-        __m128i res_sus = _mm_mask_set1_epi8(m128_zeroi, mask_sus, 1);
-        _mm_mask_storeu_epi8(suppressed + j, mask_sus, res_sus);
+  for (int64_t g = 0; g < ngroups; g++) {
+    IPEX_PARALLEL_CHUNK(region);
+    auto begin = groups[g].first;
+    auto end = groups[g].second;
+    std::vector<int64_t> candidates(
+        order.begin() + begin, order.begin() + end);
+    std::vector<int64_t> kept;
+    kept.reserve(end - begin);
+    nms_candidates<scalar_t, /*sorted*/ false>(
+        box_data, score, candidates, threshold, /*bias*/ 0, end - begin, kept);
+    std::copy(kept.begin(), kept.end(), kept_all.begin() + begin);
+    num_kept[g] = kept.size();
+  }
 
-      } else {
-        // Tail case
-        int64_t j = _j + i + 1;
-        int64_t idx_left = ndets - j;
-        __mmask16 load_mask = (1 << idx_left) - 1;
-
-        __m512 m512_x1 = _mm512_mask_loadu_ps(m512_zero, load_mask, x1 + j);
-        __m512 m512_x2 = _mm512_mask_loadu_ps(m512_zero, load_mask, x2 + j);
-        __m512 m512_y1 = _mm512_mask_loadu_ps(m512_zero, load_mask, y1 + j);
-        __m512 m512_y2 = _mm512_mask_loadu_ps(m512_zero, load_mask, y2 + j);
-
-        __m512 m512_xx1 =
-            _mm512_mask_max_ps(m512_zero, load_mask, m512_ix1, m512_x1);
-        __m512 m512_yy1 =
-            _mm512_mask_max_ps(m512_zero, load_mask, m512_iy1, m512_y1);
-        __m512 m512_xx2 =
-            _mm512_mask_min_ps(m512_zero, load_mask, m512_ix2, m512_x2);
-        __m512 m512_yy2 =
-            _mm512_mask_min_ps(m512_zero, load_mask, m512_iy2, m512_y2);
-
-        __m512 m512_w;
-        __m512 m512_h;
-        if (bias == 0) {
-          m512_w = _mm512_mask_max_ps(
-              m512_zero,
-              load_mask,
-              m512_zero,
-              _mm512_mask_sub_ps(m512_zero, load_mask, m512_xx2, m512_xx1));
-          m512_h = _mm512_mask_max_ps(
-              m512_zero,
-              load_mask,
-              m512_zero,
-              _mm512_mask_sub_ps(m512_zero, load_mask, m512_yy2, m512_yy1));
-        } else {
-          m512_w = _mm512_mask_max_ps(
-              m512_zero,
-              load_mask,
-              m512_zero,
-              _mm512_mask_add_ps(
-                  m512_zero,
-                  load_mask,
-                  _mm512_mask_sub_ps(m512_zero, load_mask, m512_xx2, m512_xx1),
-                  m512_bias));
-          m512_h = _mm512_mask_max_ps(
-              m512_zero,
-              load_mask,
-              m512_zero,
-              _mm512_mask_add_ps(
-                  m512_zero,
-                  load_mask,
-                  _mm512_mask_sub_ps(m512_zero, load_mask, m512_yy2, m512_yy1),
-                  m512_bias));
-        }
-        __m512 m512_inter =
-            _mm512_mask_mul_ps(m512_zero, load_mask, m512_w, m512_h);
-        __m512 m512_areas =
-            _mm512_mask_loadu_ps(m512_zero, load_mask, areas + j);
-        __m512 m512_over = _mm512_mask_div_ps(
-            m512_zero,
-            load_mask,
-            m512_inter,
-            _mm512_mask_sub_ps(
-                m512_zero,
-                load_mask,
-                _mm512_mask_add_ps(
-                    m512_zero, load_mask, m512_iarea, m512_areas),
-                m512_inter));
-        __mmask16 mask_sus = _mm512_mask_cmp_ps_mask(
-            load_mask, m512_over, m512_threshold, _CMP_GE_OS);
-        __m128i res_sus = _mm_mask_set1_epi8(m128_zeroi, mask_sus, 1);
-        _mm_mask_storeu_epi8(suppressed + j, mask_sus, res_sus);
-      }
+  // the kept boxes of all the groups in the descending order of the scores
+  auto keep_t = at::empty(
+      {std::accumulate(num_kept.begin(), num_kept.end(), int64_t(0))},
+      boxes.options().dtype(at::kLong));
+  auto keep = keep_t.data_ptr<int64_t>();
+  int64_t total = 0;
+  for (int64_t g = 0; g < ngroups; g++) {
+    auto kept_begin = kept_all.begin() + groups[g].first;
+    std::copy(kept_begin, kept_begin + num_kept[g], keep + total);
+    total += num_kept[g];
+  }
+  std::sort(keep, keep + total, [&](int64_t a, int64_t b) {
+    return score[a] > score[b] || (score[a] == score[b] && a < b);
+  });
+  return keep_t;
+}
+
+// The indices of the top k scores > score_thresh, in the descending order of
+// the scores. The candidates above the threshold are collected in one pass,
+// of which only the top k are sorted.
+template <typename scalar_t>
+at::Tensor score_topk_indices(
+    const at::Tensor& score,
+    float score_thresh,
+    int64_t k) {
+  auto score_ptr = score.data_ptr<scalar_t>();
+  auto score_stride = score.stride(0);
+  auto value = [&](int64_t i) { return score_ptr[i * score_stride]; };
+  std::vector<int64_t> candidates;
+  for (int64_t i = 0; i < score.size(0); i++) {
+    if (value(i) > score_thresh) {
+      candidates.push_back(i);
     }
   }
-  return at::nonzero(suppressed_t == 0).squeeze(1);
+  auto higher_score = [&](int64_t a, int64_t b) {
+    return value(a) > value(b) || (value(a) == value(b) && a < b);
+  };
+  int64_t num_keep = std::min<int64_t>(candidates.size(), k);
+  std::partial_sort(
+      candidates.begin(),
+      candidates.begin() + num_keep,
+      candidates.end(),
+      higher_score);
+  auto indices =
+      at::empty({num_keep}, score.options().dtype(at::kLong).device(at::kCPU));
+  std::copy(
+      candidates.begin(),
+      candidates.begin() + num_keep,
+      indices.data_ptr<int64_t>());
+  return indices;
 }
-#endif
 
 std::vector<at::Tensor> remove_empty(
     std::vector<at::Tensor>& candidate,
@@ -376,6 +432,63 @@ std::vector<at::Tensor> remove_empty(
   return valid_candidate;
 }
 
+// The top max_output boxes of each image of the boxes kept by the NMS of each
+// image and class, of which the ones of image bs are [bs * nscore, (bs + 1) *
+// nscore).
+std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor>
+batch_score_nms_output(
+    std::vector<at::Tensor>& bboxes_out,
+    std::vector<at::Tensor>& scores_out,
+    std::vector<at::Tensor>& labels_out,
+    int64_t nbatch,
+    int64_t nscore,
+    const int max_output) {
+  std::vector<at::Tensor> output_bboxes_(nbatch);
+  std::vector<at::Tensor> output_labels_(nbatch);
+  std::vector<at::Tensor> output_scores_(nbatch);
+  std::vector<at::Tensor> output_length_(nbatch);
+#ifdef _OPENMP
+#if (_OPENMP >= 201307)
+#pragma omp parallel for simd schedule( \
+    static) if (omp_get_max_threads() > 1 && !omp_in_parallel())
+#else
+#pragma omp parallel for schedule( \
+    static) if (omp_get_max_threads() > 1 && !omp_in_parallel())
+#endif
+#endif
+  for (int bs = 0; bs < nbatch; bs++) {
+    // Post process the tensors to get the top max_output(number) for each
+    // Batchsize
+    std::vector<at::Tensor> valid_bboxes_out =
+        remove_empty(bboxes_out, bs * nscore, (bs + 1) * nscore);
+    std::vector<at::Tensor> valid_scores_out =
+        remove_empty(scores_out, bs * nscore, (bs + 1) * nscore);
+    std::vector<at::Tensor> valid_labels_out =
+        remove_empty(labels_out, bs * nscore, (bs + 1) * nscore);
+
+    at::Tensor bboxes_out_ = at::cat(valid_bboxes_out, 0);
+    at::Tensor labels_out_ = at::cat(valid_labels_out, 0);
+    at::Tensor scores_out_ = at::cat(valid_scores_out, 0);
+
+    std::tuple<at::Tensor, at::Tensor> sort_result = scores_out_.sort(0);
+    at::Tensor max_ids = std::get<1>(sort_result);
+    max_ids = max_ids.slice(
+        /*dim*/ 0,
+        /*start*/
+        std::max(max_ids.size(0) - max_output, static_cast<int64_t>(0)),
+        /*end*/ max_ids.size(0));
+    output_bboxes_[bs] = bboxes_out_.index_select(/*dim*/ 0, /*index*/ max_ids);
+    output_labels_[bs] = labels_out_.index_select(/*dim*/ 0, /*index*/ max_ids);
+    output_scores_[bs] = scores_out_.index_select(/*dim*/ 0, /*index*/ max_ids);
+    output_length_[bs] = torch::tensor(max_ids.size(0), {torch::kInt32});
+  }
+  return std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor>(
+      at::cat(output_bboxes_),
+      at::cat(output_labels_),
+      at::cat(output_scores_),
+      at::stack(output_length_));
+}
+
 template <typename scalar_t>
 std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor>
 batch_score_nms_kernel(
@@ -398,6 +511,7 @@ batch_score_nms_kernel(
   std::vector<at::Tensor> scores_out(nbatch_x_nscore);
   std::vector<at::Tensor> labels_out(nbatch_x_nscore);
 
+  parallel_trace::ParallelRegion region("batch_score_nms");
 #ifdef _OPENMP
 #if (_OPENMP >= 201307)
 #pragma omp parallel for simd schedule( \
@@ -409,6 +523,7 @@ batch_score_nms_kernel(
 #endif
   // skip background (i = 0)
   for (int index = 0; index < nbatch_x_nscore; index++) {
+    IPEX_PARALLEL_CHUNK(region);
     // Parallel in the dimentaion of: batch * nscore
     auto bs = index / nscore;
     auto i = index % nscore;
@@ -428,20 +543,16 @@ batch_score_nms_kernel(
                            .squeeze(1); // score for boxes per image per class:
                                         // (num_bbox); For example: (15130)
 
-    at::Tensor mask_index = at::nonzero(score > 0.05).squeeze(1);
-    at::Tensor bboxes = at::index_select(dets, /*dim*/ 0, mask_index);
-    score = at::index_select(score, /*dim*/ 0, mask_index);
-
-    if (score.size(0) == 0) {
+    // select max_output highest' score > 0.05 and bboxes
+    at::Tensor score_idx_sorted =
+        score_topk_indices<scalar_t>(score, 0.05, max_output);
+    if (score_idx_sorted.size(0) == 0) {
       continue;
     }
-
-    at::Tensor score_sliced, score_idx_sorted;
-    // select max_output highest' score and bboxes
-    std::tie(score_sliced, score_idx_sorted) = at::topk(
-        score, (max_output > score.size(0)) ? score.size(0) : max_output, 0);
+    at::Tensor score_sliced =
+        at::index_select(score, /*dim*/ 0, score_idx_sorted);
     at::Tensor bboxes_sliced =
-        at::index_select(bboxes, /*dim*/ 0, score_idx_sorted);
+        at::index_select(dets, /*dim*/ 0, score_idx_sorted);
 
     at::Tensor keep = nms_cpu_kernel<scalar_t, /*sorted*/ true>(
         bboxes_sliced, score_sliced, threshold, /*bias*/ 0);
@@ -452,50 +563,8 @@ batch_score_nms_kernel(
     labels_out[index] = at::empty({keep.sizes()}).fill_(i);
   }
 
-  std::vector<at::Tensor> output_bboxes_(nbatch);
-  std::vector<at::Tensor> output_labels_(nbatch);
-  std::vector<at::Tensor> output_scores_(nbatch);
-  std::vector<at::Tensor> output_length_(nbatch);
-#ifdef _OPENMP
-#if (_OPENMP >= 201307)
-#pragma omp parallel for simd schedule( \
-    static) if (omp_get_max_threads() > 1 && !omp_in_parallel())
-#else
-#pragma omp parallel for schedule( \
-    static) if (omp_get_max_threads() > 1 && !omp_in_parallel())
-#endif
-#endif
-  for (int bs = 0; bs < nbatch; bs++) {
-    // Post process the tensors to get the top max_output(number) for each
-    // Batchsize
-    std::vector<at::Tensor> valid_bboxes_out =
-        remove_empty(bboxes_out, bs * nscore, (bs + 1) * nscore);
-    std::vector<at::Tensor> valid_scores_out =
-        remove_empty(scores_out, bs * nscore, (bs + 1) * nscore);
-    std::vector<at::Tensor> valid_labels_out =
-        remove_empty(labels_out, bs * nscore, (bs + 1) * nscore);
-
-    at::Tensor bboxes_out_ = at::cat(valid_bboxes_out, 0);
-    at::Tensor labels_out_ = at::cat(valid_labels_out, 0);
-    at::Tensor scores_out_ = at::cat(valid_scores_out, 0);
-
-    std::tuple<at::Tensor, at::Tensor> sort_result = scores_out_.sort(0);
-    at::Tensor max_ids = std::get<1>(sort_result);
-    max_ids = max_ids.slice(
-        /*dim*/ 0,
-        /*start*/
-        std::max(max_ids.size(0) - max_output, static_cast<int64_t>(0)),
-        /*end*/ max_ids.size(0));
-    output_bboxes_[bs] = bboxes_out_.index_select(/*dim*/ 0, /*index*/ max_ids);
-    output_labels_[bs] = labels_out_.index_select(/*dim*/ 0, /*index*/ max_ids);
-    output_scores_[bs] = scores_out_.index_select(/*dim*/ 0, /*index*/ max_ids);
-    output_length_[bs] = torch::tensor(max_ids.size(0), {torch::kInt32});
-  }
-  return std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor>(
-      at::cat(output_bboxes_),
-      at::cat(output_labels_),
-      at::cat(output_scores_),
-      at::stack(output_length_));
+  return batch_score_nms_output(
+      bboxes_out, scores_out, labels_out, nbatch, nscore, max_output);
 }
 
 template <typename scalar_t>
@@ -511,6 +580,7 @@ std::tuple<std::vector<at::Tensor>, std::vector<at::Tensor>> rpn_nms_kernel(
   std::vector<at::Tensor> bboxes_out(nbatch);
   std::vector<at::Tensor> scores_out(nbatch);
 
+  parallel_trace::ParallelRegion region("rpn_nms");
 #ifdef _OPENMP
 #if (_OPENMP >= 201307)
 #pragma omp parallel for simd schedule( \
@@ -521,6 +591,7 @@ std::tuple<std::vector<at::Tensor>, std::vector<at::Tensor>> rpn_nms_kernel(
 #endif
 #endif
   for (int i = 0; i < nbatch; i++) {
+    IPEX_PARALLEL_CHUNK(region);
     at::Tensor dets = batch_dets[i].squeeze(
         0); // dets for boxes per image: (num_box, 4); For example: (15130, 4)
     at::Tensor scores = batch_scores[i].squeeze(
@@ -541,11 +612,8 @@ std::tuple<std::vector<at::Tensor>, std::vector<at::Tensor>> rpn_nms_kernel(
     dets = at::index_select(dets, 0, keep_index);
     scores = at::index_select(scores, 0, keep_index);
     if (threshold > 0) {
-      at::Tensor keep =
-          nms_cpu_kernel<scalar_t, /*sorted*/ true>(dets, scores, threshold);
-      if (max_output > 0) {
-        keep = keep.slice(0, 0, max_output);
-      }
+      at::Tensor keep = nms_cpu_kernel<scalar_t, /*sorted*/ true>(
+          dets, scores, threshold, /*bias*/ 1.0, max_output);
       bboxes_out[i] = dets.index_select(0, keep);
       scores_out[i] = scores.index_select(0, keep);
     } else {
@@ -577,6 +645,7 @@ box_head_nms_kernel(
   std::vector<at::Tensor> scores_out(nbatch_x_nclass);
   std::vector<at::Tensor> labels_out(nbatch_x_nclass);
 
+  parallel_trace::ParallelRegion region("box_head_nms");
 #ifdef _OPENMP
 #if (_OPENMP >= 201307)
 #pragma omp parallel for simd schedule( \
@@ -587,6 +656,7 @@ box_head_nms_kernel(
 #endif
 #endif
   for (int bs = 0; bs < nbatch; bs++) {
+    IPEX_PARALLEL_CHUNK(region);
     at::Tensor bboxes = batch_bboxes[bs].reshape({-1, 4});
     at::Tensor scores = batch_scores[bs];
     auto image_shape = image_shapes[bs];
@@ -610,8 +680,9 @@ box_head_nms_kernel(
       }
       auto iter = bs * num_classes + j;
       if (threshold > 0) {
-        at::Tensor keep =
-            nms_cpu_kernel<scalar_t, /*sorted*/ false>(bbox, score, threshold);
+        // at most detections_per_img boxes of a class are in the output
+        at::Tensor keep = nms_cpu_kernel<scalar_t, /*sorted*/ false>(
+            bbox, score, threshold, /*bias*/ 1.0, detections_per_img);
         bboxes_out[iter] = bbox.index_select(0, keep);
         scores_out[iter] = score.index_select(0, keep);
         labels_out[iter] = at::full({keep.sizes()}, j, torch::kInt64);
@@ -751,9 +822,7 @@ at::Tensor nms(
 #if defined(IPEX_DISP_OP)
   printf("IpexExternal::nms\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("IpexExternal::nms", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("IpexExternal::nms", std::vector<c10::IValue>({}));
   TORCH_INTERNAL_ASSERT_DEBUG_ONLY(dets.layout() == c10::kStrided);
   TORCH_INTERNAL_ASSERT_DEBUG_ONLY(scores.layout() == c10::kStrided);
   auto&& result = nms_cpu(dets, scores, threshold, sorted);
@@ -761,6 +830,34 @@ at::Tensor nms(
   return result;
 }
 
+at::Tensor batched_nms(
+    const at::Tensor& boxes,
+    const at::Tensor& scores,
+    const at::Tensor& idxs,
+    const double iou_threshold) {
+#if defined(IPEX_DISP_OP)
+  printf("IpexExternal::batched_nms\n");
+#endif
+  IPEX_RECORD_FUNCTION(
+      "IpexExternal::batched_nms", std::vector<c10::IValue>({}));
+  TORCH_CHECK(
+      boxes.dim() == 2 && boxes.size(1) == 4,
+      "batched_nms: boxes should be of shape [N, 4], got ",
+      boxes.sizes());
+  TORCH_CHECK(
+      scores.dim() == 1 && idxs.dim() == 1 &&
+          scores.size(0) == boxes.size(0) && idxs.size(0) == boxes.size(0),
+      "batched_nms: scores and idxs should be of shape [N] of the boxes");
+  TORCH_CHECK(
+      boxes.scalar_type() == scores.scalar_type(),
+      "batched_nms: boxes should have the same type as scores");
+  at::Tensor result;
+  AT_DISPATCH_FLOATING_TYPES(boxes.scalar_type(), "batched_nms", [&] {
+    result = batched_nms_kernel<scalar_t>(boxes, scores, idxs, iou_threshold);
+  });
+  return result;
+}
+
 std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor> batch_score_nms(
     const at::Tensor& dets,
     const at::Tensor& scores,
@@ -769,10 +866,8 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor> batch_score_nms(
 #if defined(IPEX_DISP_OP)
   printf("IpexExternal::batch_score_nms\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "IpexExternal::batch_score_nms", std::vector<c10::IValue>({}));
-#endif
   TORCH_INTERNAL_ASSERT_DEBUG_ONLY(dets.layout() == c10::kStrided);
   TORCH_INTERNAL_ASSERT_DEBUG_ONLY(scores.layout() == c10::kStrided);
   auto&& result = batch_score_nms_cpu(dets, scores, threshold, max_output);
@@ -790,9 +885,7 @@ std::tuple<std::vector<at::Tensor>, std::vector<at::Tensor>> rpn_nms(
 #if defined(IPEX_DISP_OP)
   printf("IpexExternal::rpn_nms\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("IpexExternal::rpn_nms", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("IpexExternal::rpn_nms", std::vector<c10::IValue>({}));
   TORCH_INTERNAL_ASSERT_DEBUG_ONLY(batch_dets.layout() == c10::kStrided);
   TORCH_INTERNAL_ASSERT_DEBUG_ONLY(batch_scores.layout() == c10::kStrided);
   auto&& result = rpn_nms_cpu(
@@ -816,9 +909,8 @@ box_head_nms(
 #if defined(IPEX_DISP_OP)
   printf("IpexExternal::box_head_nms\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("IpexExternal::box_head_nms", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION(
+      "IpexExternal::box_head_nms", std::vector<c10::IValue>({}));
   auto&& result = box_head_nms_cpu(
       batch_bboxes,
       batch_scores,
@@ -831,6 +923,53 @@ box_head_nms(
   return result;
 }
 
+// Scales and transforms one box from xywh to ltrb, see scale_back_batch_kernel
+template <typename scalar_t>
+inline void scale_back_box(
+    const scalar_t* in,
+    const double* dbox,
+    const float scale_xy,
+    const float scale_wh,
+    scalar_t* out) {
+  // bboxes_in[:, :, :2] = self.scale_xy*bboxes_in[:, :, :2]
+  out[0] = in[0] * scale_xy;
+  out[1] = in[1] * scale_xy;
+  // bboxes_in[:, :, 2:] = self.scale_wh*bboxes_in[:, :, 2:]
+  out[2] = in[2] * scale_wh;
+  out[3] = in[3] * scale_wh;
+
+  // bboxes_in[:, :, :2] = bboxes_in[:, :, :2]*self.dboxes_xywh[:, :, 2:] +
+  // self.dboxes_xywh[:, :, :2]
+  out[0] = out[0] * dbox[2] + dbox[0];
+  out[1] = out[1] * dbox[3] + dbox[1];
+  // bboxes_in[:, :, 2:] = bboxes_in[:, :, 2:].exp()*self.dboxes_xywh[:, :,
+  // 2:]
+  out[2] = exp(out[2]) * dbox[2];
+  out[3] = exp(out[3]) * dbox[3];
+
+  /*
+  # Transform format to ltrb
+  l, t, r, b = bboxes_in[:, :, 0] - 0.5*bboxes_in[:, :, 2],\
+                bboxes_in[:, :, 1] - 0.5*bboxes_in[:, :, 3],\
+                bboxes_in[:, :, 0] + 0.5*bboxes_in[:, :, 2],\
+                bboxes_in[:, :, 1] + 0.5*bboxes_in[:, :, 3]
+
+  bboxes_in[:, :, 0] = l
+  bboxes_in[:, :, 1] = t
+  bboxes_in[:, :, 2] = r
+  bboxes_in[:, :, 3] = b
+  */
+
+  auto l = out[0] - 0.5 * out[2];
+  auto t = out[1] - 0.5 * out[3];
+  auto r = out[0] + 0.5 * out[2];
+  auto b = out[1] + 0.5 * out[3];
+  out[0] = l;
+  out[1] = t;
+  out[2] = r;
+  out[3] = b;
+}
+
 template <typename scalar_t>
 at::Tensor scale_back_batch_kernel(
     const at::Tensor& _ipex_bboxes_in,
@@ -869,54 +1008,132 @@ at::Tensor scale_back_batch_kernel(
 
     int64_t index = i * boxes_per_image * 4 + j * 4;
 
-    // bboxes_in[:, :, :2] = self.scale_xy*bboxes_in[:, :, :2]
-    output_data[index] = input_data[index] * scale_xy;
-    output_data[index + 1] = input_data[index + 1] * scale_xy;
-    // bboxes_in[:, :, 2:] = self.scale_wh*bboxes_in[:, :, 2:]
-    output_data[index + 2] = input_data[index + 2] * scale_wh;
-    output_data[index + 3] = input_data[index + 3] * scale_wh;
-
-    int64_t index_dboxes_xywh = j * 4;
-    // bboxes_in[:, :, :2] = bboxes_in[:, :, :2]*self.dboxes_xywh[:, :, 2:] +
-    // self.dboxes_xywh[:, :, :2]
-    output_data[index] =
-        output_data[index] * input_dboxes_xywh_data[index_dboxes_xywh + 2] +
-        input_dboxes_xywh_data[index_dboxes_xywh];
-    output_data[index + 1] =
-        output_data[index + 1] * input_dboxes_xywh_data[index_dboxes_xywh + 3] +
-        input_dboxes_xywh_data[index_dboxes_xywh + 1];
-    // bboxes_in[:, :, 2:] = bboxes_in[:, :, 2:].exp()*self.dboxes_xywh[:, :,
-    // 2:]
-    output_data[index + 2] = exp(output_data[index + 2]) *
-        input_dboxes_xywh_data[index_dboxes_xywh + 2];
-    output_data[index + 3] = exp(output_data[index + 3]) *
-        input_dboxes_xywh_data[index_dboxes_xywh + 3];
-
-    /*
-    # Transform format to ltrb
-    l, t, r, b = bboxes_in[:, :, 0] - 0.5*bboxes_in[:, :, 2],\
-                  bboxes_in[:, :, 1] - 0.5*bboxes_in[:, :, 3],\
-                  bboxes_in[:, :, 0] + 0.5*bboxes_in[:, :, 2],\
-                  bboxes_in[:, :, 1] + 0.5*bboxes_in[:, :, 3]
-
-    bboxes_in[:, :, 0] = l
-    bboxes_in[:, :, 1] = t
-    bboxes_in[:, :, 2] = r
-    bboxes_in[:, :, 3] = b
-    */
-
-    auto l = output_data[index] - 0.5 * output_data[index + 2];
-    auto t = output_data[index + 1] - 0.5 * output_data[index + 3];
-    auto r = output_data[index] + 0.5 * output_data[index + 2];
-    auto b = output_data[index + 1] + 0.5 * output_data[index + 3];
-    output_data[index] = l;
-    output_data[index + 1] = t;
-    output_data[index + 2] = r;
-    output_data[index + 3] = b;
+    scale_back_box(
+        input_data + index,
+        input_dboxes_xywh_data + j * 4,
+        scale_xy,
+        scale_wh,
+        output_data + index);
   }
   return output;
 }
 
+template <typename scalar_t>
+std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor>
+detection_postprocess_kernel(
+    const at::Tensor& bboxes_in,
+    const at::Tensor& scores_in,
+    const at::Tensor& dboxes_xywh,
+    const float scale_xy,
+    const float scale_wh,
+    const float threshold,
+    const int max_output) {
+  // bboxes_in: [BS, number_boxes, 4], for example: [1, 15130, 4]
+  // scores_in: [BS, number_boxes, label_num], for example: [1, 15130, 81]
+  auto bboxes_in_conti = bboxes_in.contiguous();
+  auto scores_in_conti = scores_in.contiguous();
+  auto dboxes_xywh_conti = dboxes_xywh.to(at::kDouble).contiguous();
+  auto nbatch = scores_in.size(0); // number of batches
+  auto ndets = scores_in.size(1); // number of boxes
+  auto nscore = scores_in.size(2); // number of labels
+  auto* input_data = bboxes_in_conti.data_ptr<scalar_t>();
+  auto* score_data = scores_in_conti.data_ptr<scalar_t>();
+  auto* input_dboxes_xywh_data = dboxes_xywh_conti.data_ptr<double>();
+
+  // The max and the sum of the exp of the scores of each box, from which the
+  // softmax of a score is computed when its class is filtered.
+  int64_t nboxes = nbatch * ndets;
+  std::vector<scalar_t> score_max(nboxes);
+  std::vector<scalar_t> score_sum(nboxes);
+#ifdef _OPENMP
+#pragma omp parallel for schedule( \
+    static) if (omp_get_max_threads() > 1 && !omp_in_parallel())
+#endif
+  for (int64_t k = 0; k < nboxes; k++) {
+    auto score = score_data + k * nscore;
+    auto max = *std::max_element(score, score + nscore);
+    scalar_t sum = 0;
+    for (int64_t c = 0; c < nscore; c++) {
+      sum += std::exp(score[c] - max);
+    }
+    score_max[k] = max;
+    score_sum[k] = sum;
+  }
+
+  auto nbatch_x_nscore =
+      nbatch * nscore; // (number of batches) * (number of labels)
+  std::vector<at::Tensor> bboxes_out(nbatch_x_nscore);
+  std::vector<at::Tensor> scores_out(nbatch_x_nscore);
+  std::vector<at::Tensor> labels_out(nbatch_x_nscore);
+
+  parallel_trace::ParallelRegion region("detection_postprocess");
+#ifdef _OPENMP
+#pragma omp parallel for schedule( \
+    static) if (omp_get_max_threads() > 1 && !omp_in_parallel())
+#endif
+  for (int64_t index = 0; index < nbatch_x_nscore; index++) {
+    IPEX_PARALLEL_CHUNK(region);
+    // Parallel in the dimentaion of: batch * nscore
+    auto bs = index / nscore;
+    auto i = index % nscore;
+
+    // skip background (i = 0)
+    if (i == 0) {
+      continue;
+    }
+
+    // select max_output highest' score > 0.05
+    std::vector<std::pair<scalar_t, int64_t>> candidates;
+    for (int64_t j = 0; j < ndets; j++) {
+      auto k = bs * ndets + j;
+      scalar_t prob =
+          std::exp(score_data[k * nscore + i] - score_max[k]) / score_sum[k];
+      if (prob > 0.05) {
+        candidates.emplace_back(prob, j);
+      }
+    }
+    int64_t num_keep = std::min<int64_t>(candidates.size(), max_output);
+    if (num_keep <= 0) {
+      continue;
+    }
+    std::partial_sort(
+        candidates.begin(),
+        candidates.begin() + num_keep,
+        candidates.end(),
+        [](const std::pair<scalar_t, int64_t>& a,
+           const std::pair<scalar_t, int64_t>& b) {
+          return a.first > b.first ||
+              (a.first == b.first && a.second < b.second);
+        });
+
+    // only the selected boxes are scaled back
+    auto bboxes_sliced = at::empty({num_keep, 4}, bboxes_in.options());
+    auto score_sliced = at::empty({num_keep}, scores_in.options());
+    auto* bboxes_sliced_data = bboxes_sliced.data_ptr<scalar_t>();
+    auto* score_sliced_data = score_sliced.data_ptr<scalar_t>();
+    for (int64_t p = 0; p < num_keep; p++) {
+      auto j = candidates[p].second;
+      scale_back_box(
+          input_data + (bs * ndets + j) * 4,
+          input_dboxes_xywh_data + j * 4,
+          scale_xy,
+          scale_wh,
+          bboxes_sliced_data + p * 4);
+      score_sliced_data[p] = candidates[p].first;
+    }
+
+    at::Tensor keep = nms_cpu_kernel<scalar_t, /*sorted*/ true>(
+        bboxes_sliced, score_sliced, threshold, /*bias*/ 0);
+
+    bboxes_out[index] = at::index_select(bboxes_sliced, /*dim*/ 0, keep);
+    scores_out[index] = at::index_select(score_sliced, /*dim*/ 0, keep);
+    labels_out[index] = at::empty({keep.sizes()}).fill_(i);
+  }
+
+  return batch_score_nms_output(
+      bboxes_out, scores_out, labels_out, nbatch, nscore, max_output);
+}
+
 std::tuple<at::Tensor, at::Tensor> parallel_scale_back_batch(
     const at::Tensor& bboxes_in,
     const at::Tensor& scores_in,
@@ -926,10 +1143,8 @@ std::tuple<at::Tensor, at::Tensor> parallel_scale_back_batch(
 #if defined(IPEX_DISP_OP)
   printf("IpexExternal::parallel_scale_back_batch\n");
 #endif
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "IpexExternal::parallel_scale_back_batch", std::vector<c10::IValue>({}));
-#endif
   TORCH_INTERNAL_ASSERT_DEBUG_ONLY(bboxes_in.layout() == c10::kStrided);
   TORCH_INTERNAL_ASSERT_DEBUG_ONLY(dboxes_xywh.layout() == c10::kStrided);
 
@@ -943,17 +1158,52 @@ std::tuple<at::Tensor, at::Tensor> parallel_scale_back_batch(
 
   return std::tuple<at::Tensor, at::Tensor>(bbox_result, scores_result);
 }
+std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor>
+detection_postprocess(
+    const at::Tensor& bboxes_in,
+    const at::Tensor& scores_in,
+    const at::Tensor& dboxes_xywh,
+    const double scale_xy,
+    const double scale_wh,
+    const double threshold,
+    const int64_t max_output) {
+#if defined(IPEX_DISP_OP)
+  printf("IpexExternal::detection_postprocess\n");
+#endif
+  IPEX_RECORD_FUNCTION(
+      "IpexExternal::detection_postprocess", std::vector<c10::IValue>({}));
+  TORCH_INTERNAL_ASSERT_DEBUG_ONLY(bboxes_in.layout() == c10::kStrided);
+  TORCH_INTERNAL_ASSERT_DEBUG_ONLY(scores_in.layout() == c10::kStrided);
+  TORCH_INTERNAL_ASSERT_DEBUG_ONLY(dboxes_xywh.layout() == c10::kStrided);
+
+  std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor> result;
+  AT_DISPATCH_FLOATING_TYPES(
+      bboxes_in.scalar_type(), "detection_postprocess", [&] {
+        result = detection_postprocess_kernel<scalar_t>(
+            bboxes_in,
+            scores_in,
+            dboxes_xywh,
+            scale_xy,
+            scale_wh,
+            threshold,
+            max_output);
+      });
+  return result;
+}
 } // namespace torch_ipex
 
 namespace {
 static auto dispatch =
     torch::RegisterOperators()
         .op("torch_ipex::nms", &torch_ipex::nms)
+        .op("torch_ipex::batched_nms", &torch_ipex::batched_nms)
         .op("torch_ipex::batch_score_nms", &torch_ipex::batch_score_nms)
         .op("torch_ipex::rpn_nms", &torch_ipex::rpn_nms)
         .op("torch_ipex::box_head_nms", &torch_ipex::box_head_nms)
         .op("torch_ipex::parallel_scale_back_batch",
-            &torch_ipex::parallel_scale_back_batch);
+            &torch_ipex::parallel_scale_back_batch)
+        .op("torch_ipex::detection_postprocess",
+            &torch_ipex::detection_postprocess);
 }
 
 namespace torch_ipex {
@@ -977,6 +1227,25 @@ at::Tensor nms(
       sorted);
 }
 
+at::Tensor batched_nms(
+    const at::Tensor& boxes,
+    const at::Tensor& scores,
+    const at::Tensor& idxs,
+    const double iou_threshold) {
+  c10::impl::ExcludeDispatchKeyGuard no_autocastCPU(DispatchKey::AutocastCPU);
+  static auto op = torch::Dispatcher::singleton()
+                       .findSchemaOrThrow("torch_ipex::batched_nms", "")
+                       .typed<decltype(batched_nms)>();
+#if defined(ENABLE_AUTOCAST_VERBOSE)
+  verbose::OpNameGuard op_name("batched_nms");
+#endif
+  return op.call(
+      cpu_cached_cast(at::kFloat, boxes),
+      cpu_cached_cast(at::kFloat, scores),
+      idxs,
+      iou_threshold);
+}
+
 std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor> batch_score_nms(
     const at::Tensor& dets,
     const at::Tensor& scores,
@@ -1070,14 +1339,43 @@ std::tuple<at::Tensor, at::Tensor> parallel_scale_back_batch(
       scale_wh);
 }
 
+std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor>
+detection_postprocess(
+    const at::Tensor& bboxes_in,
+    const at::Tensor& scores_in,
+    const at::Tensor& dboxes_xywh,
+    const double scale_xy,
+    const double scale_wh,
+    const double threshold,
+    const int64_t max_output) {
+  c10::impl::ExcludeDispatchKeyGuard no_autocastCPU(DispatchKey::AutocastCPU);
+  static auto op =
+      torch::Dispatcher::singleton()
+          .findSchemaOrThrow("torch_ipex::detection_postprocess", "")
+          .typed<decltype(detection_postprocess)>();
+#if defined(ENABLE_AUTOCAST_VERBOSE)
+  verbose::OpNameGuard op_name("detection_postprocess");
+#endif
+  return op.call(
+      cpu_cached_cast(at::kFloat, bboxes_in),
+      cpu_cached_cast(at::kFloat, scores_in),
+      dboxes_xywh,
+      scale_xy,
+      scale_wh,
+      threshold,
+      max_output);
+}
+
 TORCH_LIBRARY_IMPL(torch_ipex, AutocastCPU, m) {
   m.impl("nms", torch_ipex::autocast::nms);
+  m.impl("batched_nms", torch_ipex::autocast::batched_nms);
   m.impl("batch_score_nms", torch_ipex::autocast::batch_score_nms);
   m.impl("rpn_nms", torch_ipex::autocast::rpn_nms);
   m.impl("box_head_nms", torch_ipex::autocast::box_head_nms);
   m.impl(
       "parallel_scale_back_batch",
       torch_ipex::autocast::parallel_scale_back_batch);
+  m.impl("detection_postprocess", torch_ipex::autocast::detection_postprocess);
 }
 
 } // namespace autocast
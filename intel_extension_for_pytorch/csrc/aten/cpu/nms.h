@@ -19,6 +19,24 @@ at::Tensor nms(
     const double threshold,
     const bool sorted);
 
+/// \brief Perform non-maximum suppression per group of boxes.
+///
+/// The IPEX version of torchvision.ops.batched_nms, of which the groups, e.g.
+/// the images and the classes of a detection batch, run in parallel.
+///
+/// \param boxes: the boxes in ltrb format, size [N, 4]. \param scores: the
+/// score of each box, size [N]. \param idxs: the group of each box, size [N],
+/// of which the boxes of different groups don't suppress each other. \param
+/// iou_threshold: the boxes of IoU > iou_threshold with a box of a higher
+/// score of the same group are suppressed.
+///
+/// \return the indices of the kept boxes in the descending order of scores.
+at::Tensor batched_nms(
+    const at::Tensor& boxes,
+    const at::Tensor& scores,
+    const at::Tensor& idxs,
+    const double iou_threshold);
+
 /// \brief Perform batch non-maximum suppression.
 ///
 /// C++ version of Encoder::decode_single.
@@ -132,4 +150,33 @@ std::tuple<at::Tensor, at::Tensor> parallel_scale_back_batch(
     const double scale_xy,
     const double scale_wh);
 
+/// \brief Do parallel_scale_back_batch and batch_score_nms in one op for the
+/// post-processing of SSD.
+///
+/// The softmax of the predicted score is computed only for the boxes filtered
+/// of each class, and only the boxes selected for the NMS of each class are
+/// scaled back, so that neither the true loc of all the boxes nor the
+/// normalized score of all the boxes is materialized.
+///
+/// \param bboxes_in: predicted loc in xywh format, size [BS, number_boxes,
+/// 4], for example: [1, 15130, 4]. \param scores_in: predicted score, size
+/// [BS, number_boxes, class_number], for example: [1, 15130, 81]. \param
+/// dboxes_xywh: scale factor for each bbox from predicted loc to true loc,
+/// size [1, number_boxes, 4]. \param scale_xy: scale factor(scalar) of xy
+/// dimention for bboxes_in. \param scale_wh: scale factor(scalar) of wh
+/// dimention for bboxes_in. \param threshold: IOU threshold(scalar) to
+/// suppress bboxs which has the IOU val larger than the threshold. \param
+/// max_output: the max number of output bbox.
+///
+/// \return the same tuple as batch_score_nms.
+std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor>
+detection_postprocess(
+    const at::Tensor& bboxes_in,
+    const at::Tensor& scores_in,
+    const at::Tensor& dboxes_xywh,
+    const double scale_xy,
+    const double scale_wh,
+    const double threshold,
+    const int64_t max_output);
+
 } // namespace torch_ipex
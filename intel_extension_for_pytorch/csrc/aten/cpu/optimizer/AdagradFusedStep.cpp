@@ -1,5 +1,7 @@
-#include "csrc/cpu/vec512/bf16/vec/vec_type_cvt.h"
+#include "bf16_param.h"
+#include "multi_tensor_apply.h"
 #include "optimizer.h"
+#include "csrc/utils/op_trace.h"
 
 #include <torch/csrc/autograd/function.h>
 #include <torch/extension.h>
@@ -18,7 +20,9 @@ void adagrad_fused_step_kernel(
     double learning_rate,
     double weight_decay,
     double lr_decay,
-    double eps) {
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding) {
   scalar_t* param_data = param.data_ptr<scalar_t>();
   scalar_t* grad_data = grad.data_ptr<scalar_t>();
   scalar_t* state_sum_data = state_sum.data_ptr<scalar_t>();
@@ -43,7 +47,7 @@ void adagrad_fused_step_kernel(
         int64_t d = 0;
         for (; d < size - (size % Vec::size()); d += Vec::size()) {
           Vec param_vec = Vec::loadu(param_ptr + d);
-          Vec grad_vec = Vec::loadu(grad_ptr + d) +
+          Vec grad_vec = Vec::loadu(grad_ptr + d) * Vec(scalar_t(grad_scale)) +
               param_vec * Vec(scalar_t(weight_decay));
 
           Vec sum_vec = Vec::loadu(state_sum_ptr + d) + grad_vec * grad_vec;
@@ -54,7 +58,8 @@ void adagrad_fused_step_kernel(
           param_vec.store(param_ptr + d);
         }
         for (; d < size; d++) {
-          scalar_t grad_val = grad_ptr[d] + param_ptr[d] * weight_decay;
+          scalar_t grad_val =
+              grad_ptr[d] * grad_scale + param_ptr[d] * weight_decay;
           state_sum_ptr[d] += grad_val * grad_val;
 
           scalar_t std_val = std::sqrt(state_sum_ptr[d]) + eps;
@@ -73,7 +78,9 @@ void adagrad_fused_step_kernel<at::BFloat16, at::BFloat16>(
     double learning_rate,
     double weight_decay,
     double lr_decay,
-    double eps) {
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding) {
   TORCH_CHECK(
       param.scalar_type() == at::kBFloat16,
       "adagrad_fused_step_kernel: expect param to be at::BFloat16");
@@ -84,13 +91,16 @@ void adagrad_fused_step_kernel<at::BFloat16, at::BFloat16>(
       state_sum.scalar_type() == at::kFloat,
       "adagrad_fused_step_kernel: expect stats_sum to be float32");
   TORCH_CHECK(
-      param2.scalar_type() == at::kBFloat16,
-      "adagrad_fused_step_kernel: expect param2 to be at::BFloat16");
+      param2.numel() == 0 || param2.scalar_type() == at::kBFloat16,
+      "adagrad_fused_step_kernel: expect param2 to be at::BFloat16 or empty");
 
   at::BFloat16* param_data = param.data_ptr<at::BFloat16>();
   at::BFloat16* grad_data = grad.data_ptr<at::BFloat16>();
   float* state_sum_data = state_sum.data_ptr<float>();
-  at::BFloat16* param2_data = param2.data_ptr<at::BFloat16>();
+  // no trail of the split master weight for the pure bf16 params
+  at::BFloat16* param2_data =
+      param2.numel() > 0 ? param2.data_ptr<at::BFloat16>() : nullptr;
+  uint64_t seed = stochastic_rounding ? bf16_rounding_seed() : 0;
 
   // update learning rate
   double clr = learning_rate / (1 + (step - 1) * lr_decay);
@@ -104,27 +114,26 @@ void adagrad_fused_step_kernel<at::BFloat16, at::BFloat16>(
   at::parallel_for(
       0, param.numel(), grain_size, [&](int64_t begin, int64_t end) {
         // local pointers
-        at::BFloat16* param_ptr = param_data + begin;
         at::BFloat16* grad_ptr = grad_data + begin;
         float* state_sum_ptr = state_sum_data + begin;
-        at::BFloat16* param2_ptr = param2_data + begin;
+        BFloat16ParamChunk params(
+            param_data, param2_data, stochastic_rounding, seed, begin);
 
         const int64_t size = end - begin;
 
         int64_t d = 0;
         for (; d < size - (size % bVec::size()); d += bVec::size()) {
-          bVec param_bvec = bVec::loadu(param_ptr + d);
-          bVec param2_bvec = bVec::loadu(param2_ptr + d);
           fVec param_fvec, param_fvec2;
-          std::tie(param_fvec, param_fvec2) =
-              bf16::pack_bfloat16_float(param_bvec, param2_bvec);
+          std::tie(param_fvec, param_fvec2) = params.load(d);
 
           bVec grad_bvec = bVec::loadu(grad_ptr + d);
           fVec grad_fvec, grad_fvec2;
           std::tie(grad_fvec, grad_fvec2) = convert_bfloat16_float(grad_bvec);
 
-          grad_fvec = grad_fvec + param_fvec * fVec(float(weight_decay));
-          grad_fvec2 = grad_fvec2 + param_fvec2 * fVec(float(weight_decay));
+          grad_fvec = grad_fvec * fVec(float(grad_scale)) +
+              param_fvec * fVec(float(weight_decay));
+          grad_fvec2 = grad_fvec2 * fVec(float(grad_scale)) +
+              param_fvec2 * fVec(float(weight_decay));
 
           fVec sum_fvec =
               fVec::loadu(state_sum_ptr + d) + grad_fvec * grad_fvec;
@@ -138,21 +147,17 @@ void adagrad_fused_step_kernel<at::BFloat16, at::BFloat16>(
           param_fvec = param_fvec - grad_fvec / std_fvec * fVec(float(clr));
           param_fvec2 = param_fvec2 - grad_fvec2 / std_fvec2 * fVec(float(clr));
 
-          std::tie(param_bvec, param2_bvec) =
-              bf16::unpack_float_bfloat16(param_fvec, param_fvec2);
-          param_bvec.store(param_ptr + d);
-          param2_bvec.store(param2_ptr + d);
+          params.store(d, param_fvec, param_fvec2);
         }
         for (; d < size; d++) {
-          float param_val =
-              bf16::pack_bfloat16_float(param_ptr[d], param2_ptr[d]);
-          float grad_val = float(grad_ptr[d]) + param_val * weight_decay;
+          float param_val = params.load_val(d);
+          float grad_val =
+              float(grad_ptr[d]) * grad_scale + param_val * weight_decay;
           state_sum_ptr[d] += grad_val * grad_val;
 
           float std_val = std::sqrt(state_sum_ptr[d]) + eps;
           param_val -= grad_val / std_val * clr;
-          std::tie(param_ptr[d], param2_ptr[d]) =
-              bf16::unpack_float_bfloat16(param_val);
+          params.store_val(d, param_val);
         }
       });
 }
@@ -167,7 +172,9 @@ void adagrad_fused_step_kernel<float, at::BFloat16>(
     double learning_rate,
     double weight_decay,
     double lr_decay,
-    double eps) {
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding) {
   TORCH_CHECK(
       param.scalar_type() == at::kFloat,
       "adagrad_fused_step_kernel: expect param to be float32");
@@ -214,8 +221,10 @@ void adagrad_fused_step_kernel<float, at::BFloat16>(
           fVec grad_fvec, grad_fvec2;
           std::tie(grad_fvec, grad_fvec2) = convert_bfloat16_float(grad_bvec);
 
-          grad_fvec = grad_fvec + param_fvec * fVec(float(weight_decay));
-          grad_fvec2 = grad_fvec2 + param_fvec2 * fVec(float(weight_decay));
+          grad_fvec = grad_fvec * fVec(float(grad_scale)) +
+              param_fvec * fVec(float(weight_decay));
+          grad_fvec2 = grad_fvec2 * fVec(float(grad_scale)) +
+              param_fvec2 * fVec(float(weight_decay));
 
           fVec sum_fvec =
               fVec::loadu(state_sum_ptr + d) + grad_fvec * grad_fvec;
@@ -238,7 +247,8 @@ void adagrad_fused_step_kernel<float, at::BFloat16>(
         for (; d < size; d++) {
           float param_val =
               bf16::pack_bfloat16_float(param_ptr[d], param2_ptr[d]);
-          float grad_val = float(grad_ptr[d]) + param_val * weight_decay;
+          float grad_val =
+              float(grad_ptr[d]) * grad_scale + param_val * weight_decay;
           state_sum_ptr[d] += grad_val * grad_val;
 
           float std_val = std::sqrt(state_sum_ptr[d]) + eps;
@@ -258,11 +268,11 @@ std::tuple<at::Tensor, at::Tensor> adagrad_fused_step(
     double learning_rate,
     double weight_decay,
     double lr_decay,
-    double eps) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding) {
+  IPEX_RECORD_FUNCTION(
       "torch_ipex::adagrad_fused_step", std::vector<c10::IValue>({}));
-#endif
   TORCH_CHECK(
       learning_rate >= 0, "Expect learning rate >= 0.0, got ", learning_rate);
   TORCH_CHECK(lr_decay >= 0, "Expect lr_decay >=0.0 , got ", lr_decay);
@@ -306,7 +316,9 @@ std::tuple<at::Tensor, at::Tensor> adagrad_fused_step(
         learning_rate,
         weight_decay,
         lr_decay,
-        eps);
+        eps,
+        grad_scale,
+        stochastic_rounding);
   } else if (at::ScalarType::Double == grad_dtype) {
     adagrad_fused_step_kernel<double, double>(
         param,
@@ -317,7 +329,9 @@ std::tuple<at::Tensor, at::Tensor> adagrad_fused_step(
         learning_rate,
         weight_decay,
         lr_decay,
-        eps);
+        eps,
+        grad_scale,
+        stochastic_rounding);
   } else if (
       at::ScalarType::BFloat16 == grad_dtype &&
       at::ScalarType::BFloat16 == param_dtype) {
@@ -330,7 +344,9 @@ std::tuple<at::Tensor, at::Tensor> adagrad_fused_step(
         learning_rate,
         weight_decay,
         lr_decay,
-        eps);
+        eps,
+        grad_scale,
+        stochastic_rounding);
   } else if (
       at::ScalarType::BFloat16 == grad_dtype &&
       at::ScalarType::Float == param_dtype) {
@@ -343,7 +359,9 @@ std::tuple<at::Tensor, at::Tensor> adagrad_fused_step(
         learning_rate,
         weight_decay,
         lr_decay,
-        eps);
+        eps,
+        grad_scale,
+        stochastic_rounding);
   } else {
     TORCH_CHECK(false, "expect bfloat16 or float or double param");
   }
@@ -361,6 +379,51 @@ std::tuple<at::Tensor, at::Tensor> adagrad_fused_step(
   return std::make_tuple(param_, state_sum_);
 }
 
+/**
+ * Adagrad fused update of a list of params, e.g. of a param group, of which
+ * the small params are updated together in one parallel loop.
+ * The args are the same as adagrad_fused_step, of a list for each tensor and
+ * the step of each param.
+ */
+void adagrad_fused_step_list(
+    at::TensorList params,
+    at::TensorList grads,
+    at::TensorList state_sums,
+    at::TensorList params2,
+    at::IntArrayRef steps,
+    double learning_rate,
+    double weight_decay,
+    double lr_decay,
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding) {
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::adagrad_fused_step_list", std::vector<c10::IValue>({}));
+  TORCH_CHECK(
+      grads.size() == params.size() && state_sums.size() == params.size() &&
+          params2.size() == params.size() && steps.size() == params.size(),
+      "Expect the same number of params, grads, state_sums, params2 and steps");
+
+  std::vector<int64_t> numels;
+  for (const auto& param : params) {
+    numels.push_back(param.numel());
+  }
+  multi_tensor_apply(numels, [&](int64_t i) {
+    adagrad_fused_step(
+        params[i],
+        grads[i],
+        state_sums[i],
+        params2[i],
+        steps[i],
+        learning_rate,
+        weight_decay,
+        lr_decay,
+        eps,
+        grad_scale,
+        stochastic_rounding);
+  });
+}
+
 } // namespace cpu
 } // namespace torch_ipex
 
@@ -370,8 +433,15 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
   m.def(
       "adagrad_fused_step(Tensor(a!) param, Tensor grad, Tensor(b!) "
       "state_sum, Tensor trail, int step, float lr, float weight_decay, "
-      "float lr_decay, float eps) -> (Tensor(a!), Tensor(b!))",
+      "float lr_decay, float eps, float grad_scale=1., bool "
+      "stochastic_rounding=False) -> (Tensor(a!), Tensor(b!))",
       torch_ipex::cpu::adagrad_fused_step);
+  m.def(
+      "adagrad_fused_step_list(Tensor(a!)[] params, Tensor[] grads, "
+      "Tensor(b!)[] state_sums, Tensor(c!)[] trails, int[] steps, float lr, "
+      "float weight_decay, float lr_decay, float eps, float grad_scale=1., "
+      "bool stochastic_rounding=False) -> ()",
+      torch_ipex::cpu::adagrad_fused_step_list);
 }
 
 } // namespace
@@ -0,0 +1,565 @@
+#include "bf16_param.h"
+#include "multi_tensor_apply.h"
+#include "optimizer.h"
+#include "csrc/utils/op_trace.h"
+
+#include <torch/csrc/autograd/function.h>
+#include <torch/extension.h>
+namespace torch_ipex {
+namespace cpu {
+
+using namespace at::vec;
+
+// The step of Adam, or of AdamW with the weight decay decoupled from the
+// grad, in the coefficients of one call.
+struct AdamCoefficients {
+  double beta1;
+  double beta2;
+  double eps;
+  double weight_decay;
+  // lr / bias_correction1
+  double step_size;
+  double bias_correction2_sqrt;
+  // 1 - lr * weight_decay of AdamW
+  double param_decay;
+  // the clip coefficient of the grad
+  double grad_scale;
+  // round the pure bf16 params stochastically
+  bool stochastic_rounding;
+  bool amsgrad;
+  bool adamw;
+
+  AdamCoefficients(
+      int64_t step,
+      double beta1,
+      double beta2,
+      double learning_rate,
+      double weight_decay,
+      double eps,
+      bool amsgrad,
+      bool adamw,
+      double grad_scale,
+      bool stochastic_rounding)
+      : beta1(beta1),
+        beta2(beta2),
+        eps(eps),
+        weight_decay(weight_decay),
+        step_size(learning_rate / (1 - std::pow(beta1, step))),
+        bias_correction2_sqrt(std::sqrt(1 - std::pow(beta2, step))),
+        param_decay(1 - learning_rate * weight_decay),
+        grad_scale(grad_scale),
+        stochastic_rounding(stochastic_rounding),
+        amsgrad(amsgrad),
+        adamw(adamw) {}
+};
+
+// Update the moments at exp_avg, exp_avg_sq and max_exp_avg_sq of a vector
+// of the param (of float or double), and return the updated param. The
+// moments, the param and the grad are read and written once.
+template <typename scalar_t>
+static inline Vectorized<scalar_t> adam_step_vec(
+    Vectorized<scalar_t> param_vec,
+    Vectorized<scalar_t> grad_vec,
+    scalar_t* exp_avg,
+    scalar_t* exp_avg_sq,
+    scalar_t* max_exp_avg_sq,
+    const AdamCoefficients& c) {
+  using Vec = Vectorized<scalar_t>;
+  grad_vec = grad_vec * Vec(scalar_t(c.grad_scale));
+  if (c.adamw) {
+    param_vec = param_vec * Vec(scalar_t(c.param_decay));
+  } else {
+    grad_vec = grad_vec + param_vec * Vec(scalar_t(c.weight_decay));
+  }
+  Vec exp_avg_vec = Vec::loadu(exp_avg) * Vec(scalar_t(c.beta1)) +
+      grad_vec * Vec(scalar_t(1 - c.beta1));
+  Vec exp_avg_sq_vec = Vec::loadu(exp_avg_sq) * Vec(scalar_t(c.beta2)) +
+      grad_vec * grad_vec * Vec(scalar_t(1 - c.beta2));
+  exp_avg_vec.store(exp_avg);
+  exp_avg_sq_vec.store(exp_avg_sq);
+  if (c.amsgrad) {
+    exp_avg_sq_vec = maximum(Vec::loadu(max_exp_avg_sq), exp_avg_sq_vec);
+    exp_avg_sq_vec.store(max_exp_avg_sq);
+  }
+  Vec denom_vec = exp_avg_sq_vec.sqrt() /
+          Vec(scalar_t(c.bias_correction2_sqrt)) +
+      Vec(scalar_t(c.eps));
+  return param_vec - exp_avg_vec / denom_vec * Vec(scalar_t(c.step_size));
+}
+
+template <typename scalar_t>
+static inline scalar_t adam_step_val(
+    scalar_t param_val,
+    scalar_t grad_val,
+    scalar_t* exp_avg,
+    scalar_t* exp_avg_sq,
+    scalar_t* max_exp_avg_sq,
+    const AdamCoefficients& c) {
+  grad_val = grad_val * c.grad_scale;
+  if (c.adamw) {
+    param_val = param_val * c.param_decay;
+  } else {
+    grad_val = grad_val + param_val * c.weight_decay;
+  }
+  *exp_avg = *exp_avg * c.beta1 + grad_val * (1 - c.beta1);
+  *exp_avg_sq = *exp_avg_sq * c.beta2 + grad_val * grad_val * (1 - c.beta2);
+  scalar_t exp_avg_sq_val = *exp_avg_sq;
+  if (c.amsgrad) {
+    exp_avg_sq_val = std::max(*max_exp_avg_sq, exp_avg_sq_val);
+    *max_exp_avg_sq = exp_avg_sq_val;
+  }
+  scalar_t denom_val =
+      std::sqrt(exp_avg_sq_val) / c.bias_correction2_sqrt + c.eps;
+  return param_val - *exp_avg / denom_val * c.step_size;
+}
+
+template <typename scalar_t, typename grad_t>
+void adam_fused_step_kernel(
+    const at::Tensor& param,
+    const at::Tensor& exp_avg,
+    const at::Tensor& exp_avg_sq,
+    const at::Tensor& max_exp_avg_sq,
+    const at::Tensor& grad,
+    const at::Tensor& param2,
+    const AdamCoefficients& c) {
+  scalar_t* param_data = param.data_ptr<scalar_t>();
+  scalar_t* exp_avg_data = exp_avg.data_ptr<scalar_t>();
+  scalar_t* exp_avg_sq_data = exp_avg_sq.data_ptr<scalar_t>();
+  scalar_t* max_exp_avg_sq_data =
+      c.amsgrad ? max_exp_avg_sq.data_ptr<scalar_t>() : nullptr;
+  scalar_t* grad_data = grad.data_ptr<scalar_t>();
+
+  using Vec = at::vec::Vectorized<scalar_t>;
+
+  int64_t grain_size = 512;
+
+  // purely element-wise operations
+  at::parallel_for(
+      0, param.numel(), grain_size, [&](int64_t begin, int64_t end) {
+        // local pointers
+        scalar_t* param_ptr = param_data + begin;
+        scalar_t* exp_avg_ptr = exp_avg_data + begin;
+        scalar_t* exp_avg_sq_ptr = exp_avg_sq_data + begin;
+        scalar_t* max_exp_avg_sq_ptr =
+            c.amsgrad ? max_exp_avg_sq_data + begin : nullptr;
+        scalar_t* grad_ptr = grad_data + begin;
+
+        const int64_t size = end - begin;
+
+        int64_t d = 0;
+        for (; d < size - (size % Vec::size()); d += Vec::size()) {
+          Vec param_vec = adam_step_vec(
+              Vec::loadu(param_ptr + d),
+              Vec::loadu(grad_ptr + d),
+              exp_avg_ptr + d,
+              exp_avg_sq_ptr + d,
+              c.amsgrad ? max_exp_avg_sq_ptr + d : nullptr,
+              c);
+          param_vec.store(param_ptr + d);
+        }
+        for (; d < size; d++) {
+          param_ptr[d] = adam_step_val(
+              param_ptr[d],
+              grad_ptr[d],
+              exp_avg_ptr + d,
+              exp_avg_sq_ptr + d,
+              c.amsgrad ? max_exp_avg_sq_ptr + d : nullptr,
+              c);
+        }
+      });
+}
+
+template <>
+void adam_fused_step_kernel<at::BFloat16, at::BFloat16>(
+    const at::Tensor& param,
+    const at::Tensor& exp_avg,
+    const at::Tensor& exp_avg_sq,
+    const at::Tensor& max_exp_avg_sq,
+    const at::Tensor& grad,
+    const at::Tensor& param2,
+    const AdamCoefficients& c) {
+  TORCH_CHECK(
+      param.scalar_type() == at::kBFloat16,
+      "adam_fused_step_kernel: expect param to be at::BFloat16");
+  TORCH_CHECK(
+      grad.scalar_type() == at::kBFloat16,
+      "adam_fused_step_kernel: expect grad to be at::BFloat16");
+  TORCH_CHECK(
+      exp_avg.scalar_type() == at::kFloat,
+      "adam_fused_step_kernel: expect exp_avg to be float32");
+  TORCH_CHECK(
+      exp_avg_sq.scalar_type() == at::kFloat,
+      "adam_fused_step_kernel: expect exp_avg_sq to be float32");
+  TORCH_CHECK(
+      !c.amsgrad || max_exp_avg_sq.scalar_type() == at::kFloat,
+      "adam_fused_step_kernel: expect max_exp_avg_sq to be float32");
+  TORCH_CHECK(
+      param2.numel() == 0 || param2.scalar_type() == at::kBFloat16,
+      "adam_fused_step_kernel: expect param2 to be at::BFloat16 or empty");
+
+  at::BFloat16* param_data = param.data_ptr<at::BFloat16>();
+  float* exp_avg_data = exp_avg.data_ptr<float>();
+  float* exp_avg_sq_data = exp_avg_sq.data_ptr<float>();
+  float* max_exp_avg_sq_data =
+      c.amsgrad ? max_exp_avg_sq.data_ptr<float>() : nullptr;
+  at::BFloat16* grad_data = grad.data_ptr<at::BFloat16>();
+  // no trail of the split master weight for the pure bf16 params
+  at::BFloat16* param2_data =
+      param2.numel() > 0 ? param2.data_ptr<at::BFloat16>() : nullptr;
+  uint64_t seed = c.stochastic_rounding ? bf16_rounding_seed() : 0;
+
+  using bVec = at::vec::Vectorized<at::BFloat16>;
+  using fVec = at::vec::Vectorized<float>;
+
+  int64_t grain_size = 512;
+
+  // purely element-wise operations
+  at::parallel_for(
+      0, param.numel(), grain_size, [&](int64_t begin, int64_t end) {
+        // local pointers
+        float* exp_avg_ptr = exp_avg_data + begin;
+        float* exp_avg_sq_ptr = exp_avg_sq_data + begin;
+        float* max_exp_avg_sq_ptr =
+            c.amsgrad ? max_exp_avg_sq_data + begin : nullptr;
+        at::BFloat16* grad_ptr = grad_data + begin;
+        BFloat16ParamChunk params(
+            param_data, param2_data, c.stochastic_rounding, seed, begin);
+
+        const int64_t size = end - begin;
+
+        int64_t d = 0;
+        for (; d < size - (size % bVec::size()); d += bVec::size()) {
+          fVec param_fvec, param_fvec2;
+          std::tie(param_fvec, param_fvec2) = params.load(d);
+
+          bVec grad_bvec = bVec::loadu(grad_ptr + d);
+          fVec grad_fvec, grad_fvec2;
+          std::tie(grad_fvec, grad_fvec2) = convert_bfloat16_float(grad_bvec);
+
+          param_fvec = adam_step_vec(
+              param_fvec,
+              grad_fvec,
+              exp_avg_ptr + d,
+              exp_avg_sq_ptr + d,
+              c.amsgrad ? max_exp_avg_sq_ptr + d : nullptr,
+              c);
+          param_fvec2 = adam_step_vec(
+              param_fvec2,
+              grad_fvec2,
+              exp_avg_ptr + d + fVec::size(),
+              exp_avg_sq_ptr + d + fVec::size(),
+              c.amsgrad ? max_exp_avg_sq_ptr + d + fVec::size() : nullptr,
+              c);
+
+          params.store(d, param_fvec, param_fvec2);
+        }
+        for (; d < size; d++) {
+          float param_val = params.load_val(d);
+          param_val = adam_step_val(
+              param_val,
+              float(grad_ptr[d]),
+              exp_avg_ptr + d,
+              exp_avg_sq_ptr + d,
+              c.amsgrad ? max_exp_avg_sq_ptr + d : nullptr,
+              c);
+          params.store_val(d, param_val);
+        }
+      });
+}
+
+template <>
+void adam_fused_step_kernel<float, at::BFloat16>(
+    const at::Tensor& param,
+    const at::Tensor& exp_avg,
+    const at::Tensor& exp_avg_sq,
+    const at::Tensor& max_exp_avg_sq,
+    const at::Tensor& grad,
+    const at::Tensor& param2,
+    const AdamCoefficients& c) {
+  TORCH_CHECK(
+      param.scalar_type() == at::kFloat,
+      "adam_fused_step_kernel: expect param to be float32");
+  TORCH_CHECK(
+      grad.scalar_type() == at::kBFloat16,
+      "adam_fused_step_kernel: expect grad to be at::BFloat16");
+  TORCH_CHECK(
+      exp_avg.scalar_type() == at::kFloat,
+      "adam_fused_step_kernel: expect exp_avg to be float32");
+  TORCH_CHECK(
+      exp_avg_sq.scalar_type() == at::kFloat,
+      "adam_fused_step_kernel: expect exp_avg_sq to be float32");
+  TORCH_CHECK(
+      !c.amsgrad || max_exp_avg_sq.scalar_type() == at::kFloat,
+      "adam_fused_step_kernel: expect max_exp_avg_sq to be float32");
+  TORCH_CHECK(
+      param2.scalar_type() == at::kBFloat16,
+      "adam_fused_step_kernel: expect param2 to be at::BFloat16");
+
+  float* param_data = param.data_ptr<float>();
+  float* exp_avg_data = exp_avg.data_ptr<float>();
+  float* exp_avg_sq_data = exp_avg_sq.data_ptr<float>();
+  float* max_exp_avg_sq_data =
+      c.amsgrad ? max_exp_avg_sq.data_ptr<float>() : nullptr;
+  at::BFloat16* grad_data = grad.data_ptr<at::BFloat16>();
+  at::BFloat16* param2_data = param2.data_ptr<at::BFloat16>();
+
+  using bVec = at::vec::Vectorized<at::BFloat16>;
+  using fVec = at::vec::Vectorized<float>;
+
+  int64_t grain_size = 512;
+
+  // purely element-wise operations
+  at::parallel_for(
+      0, param.numel(), grain_size, [&](int64_t begin, int64_t end) {
+        // local pointers
+        float* param_ptr = param_data + begin;
+        float* exp_avg_ptr = exp_avg_data + begin;
+        float* exp_avg_sq_ptr = exp_avg_sq_data + begin;
+        float* max_exp_avg_sq_ptr =
+            c.amsgrad ? max_exp_avg_sq_data + begin : nullptr;
+        at::BFloat16* grad_ptr = grad_data + begin;
+        at::BFloat16* param2_ptr = param2_data + begin;
+
+        const int64_t size = end - begin;
+
+        int64_t d = 0;
+        for (; d < size - (size % bVec::size()); d += bVec::size()) {
+          bVec grad_bvec = bVec::loadu(grad_ptr + d);
+          fVec grad_fvec, grad_fvec2;
+          std::tie(grad_fvec, grad_fvec2) = convert_bfloat16_float(grad_bvec);
+
+          fVec param_fvec = adam_step_vec(
+              fVec::loadu(param_ptr + d),
+              grad_fvec,
+              exp_avg_ptr + d,
+              exp_avg_sq_ptr + d,
+              c.amsgrad ? max_exp_avg_sq_ptr + d : nullptr,
+              c);
+          fVec param_fvec2 = adam_step_vec(
+              fVec::loadu(param_ptr + d + fVec::size()),
+              grad_fvec2,
+              exp_avg_ptr + d + fVec::size(),
+              exp_avg_sq_ptr + d + fVec::size(),
+              c.amsgrad ? max_exp_avg_sq_ptr + d + fVec::size() : nullptr,
+              c);
+
+          param_fvec.store(param_ptr + d);
+          param_fvec2.store(param_ptr + d + fVec::size());
+          // sync float param to bfloat16
+          bVec param2_bvec = convert_float_bfloat16(param_fvec, param_fvec2);
+          param2_bvec.store(param2_ptr + d);
+        }
+        for (; d < size; d++) {
+          float param_val = adam_step_val(
+              param_ptr[d],
+              float(grad_ptr[d]),
+              exp_avg_ptr + d,
+              exp_avg_sq_ptr + d,
+              c.amsgrad ? max_exp_avg_sq_ptr + d : nullptr,
+              c);
+          param_ptr[d] = param_val;
+          param2_ptr[d] = at::BFloat16(param_val);
+        }
+      });
+}
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor> adam_fused_step(
+    const at::Tensor& param_,
+    const at::Tensor& exp_avg_,
+    const at::Tensor& exp_avg_sq_,
+    const at::Tensor& max_exp_avg_sq_,
+    const at::Tensor& grad_,
+    const at::Tensor& param2_,
+    int64_t step,
+    bool amsgrad,
+    bool adamw,
+    double beta1,
+    double beta2,
+    double learning_rate,
+    double weight_decay,
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding) {
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::adam_fused_step", std::vector<c10::IValue>({}));
+  TORCH_CHECK(
+      learning_rate >= 0, "Expect learning rate >= 0.0, got ", learning_rate);
+  TORCH_CHECK(eps >= 0, "Expect eps >= 0.0, got ", eps);
+  TORCH_CHECK(
+      beta1 >= 0 && beta1 < 1, "Expect 0.0 <= beta1 < 1.0, got ", beta1);
+  TORCH_CHECK(
+      beta2 >= 0 && beta2 < 1, "Expect 0.0 <= beta2 < 1.0, got ", beta2);
+  TORCH_CHECK(
+      weight_decay >= 0, "Expect weight_decay >= 0.0, got ", weight_decay);
+  TORCH_CHECK(step >= 1, "Expect step >= 1, got ", step);
+
+  TORCH_CHECK(
+      param_.sizes() == grad_.sizes(),
+      "Expect param and grad_ have the same sizes, param sizes: ",
+      param_.sizes(),
+      "; grad_ sizes: ",
+      grad_.sizes());
+  TORCH_CHECK(
+      param_.sizes() == exp_avg_.sizes(),
+      "Expect param and exp_avg have the same sizes, param sizes: ",
+      param_.sizes(),
+      "; exp_avg sizes: ",
+      exp_avg_.sizes());
+  TORCH_CHECK(
+      param_.sizes() == exp_avg_sq_.sizes(),
+      "Expect param and exp_avg_sq have the same sizes, param sizes: ",
+      param_.sizes(),
+      "; exp_avg_sq sizes: ",
+      exp_avg_sq_.sizes());
+  TORCH_CHECK(
+      !amsgrad || param_.sizes() == max_exp_avg_sq_.sizes(),
+      "Expect param and max_exp_avg_sq have the same sizes, param sizes: ",
+      param_.sizes(),
+      "; max_exp_avg_sq sizes: ",
+      max_exp_avg_sq_.sizes());
+  TORCH_CHECK(
+      param2_.numel() == 0 || param_.sizes() == param2_.sizes(),
+      "Expect param and param2_ have the same sizes, param sizes: ",
+      param_.sizes(),
+      "; param2_ sizes: ",
+      param2_.sizes());
+
+  auto param = param_.contiguous();
+  auto exp_avg = exp_avg_.contiguous();
+  auto exp_avg_sq = exp_avg_sq_.contiguous();
+  auto max_exp_avg_sq = max_exp_avg_sq_.contiguous();
+  auto grad = grad_.contiguous();
+  auto param2 = param2_.contiguous();
+
+  AdamCoefficients c(
+      step,
+      beta1,
+      beta2,
+      learning_rate,
+      weight_decay,
+      eps,
+      amsgrad,
+      adamw,
+      grad_scale,
+      stochastic_rounding);
+  auto grad_dtype = grad_.scalar_type();
+  auto param_dtype = param_.scalar_type();
+  if (at::ScalarType::Float == grad_dtype) {
+    adam_fused_step_kernel<float, float>(
+        param, exp_avg, exp_avg_sq, max_exp_avg_sq, grad, param2, c);
+  } else if (at::ScalarType::Double == grad_dtype) {
+    adam_fused_step_kernel<double, double>(
+        param, exp_avg, exp_avg_sq, max_exp_avg_sq, grad, param2, c);
+  } else if (
+      at::ScalarType::BFloat16 == grad_dtype &&
+      at::ScalarType::BFloat16 == param_dtype) {
+    adam_fused_step_kernel<at::BFloat16, at::BFloat16>(
+        param, exp_avg, exp_avg_sq, max_exp_avg_sq, grad, param2, c);
+  } else if (
+      at::ScalarType::BFloat16 == grad_dtype &&
+      at::ScalarType::Float == param_dtype) {
+    adam_fused_step_kernel<float, at::BFloat16>(
+        param, exp_avg, exp_avg_sq, max_exp_avg_sq, grad, param2, c);
+  } else {
+    TORCH_CHECK(false, "expect bfloat16 or float or double param");
+  }
+
+  if (!param_.is_contiguous()) {
+    param_.copy_(param);
+  }
+  if (!exp_avg_.is_contiguous()) {
+    exp_avg_.copy_(exp_avg);
+  }
+  if (!exp_avg_sq_.is_contiguous()) {
+    exp_avg_sq_.copy_(exp_avg_sq);
+  }
+  if (amsgrad && !max_exp_avg_sq_.is_contiguous()) {
+    max_exp_avg_sq_.copy_(max_exp_avg_sq);
+  }
+  if (!param2_.is_contiguous()) {
+    param2_.copy_(param2);
+  }
+
+  return std::make_tuple(param_, exp_avg_, exp_avg_sq_);
+}
+
+/**
+ * Adam or AdamW fused update of a list of params, e.g. of a param group, of
+ * which the small params are updated together in one parallel loop.
+ * The args are the same as adam_fused_step, of a list for each tensor and the
+ * step of each param.
+ */
+void adam_fused_step_list(
+    at::TensorList params,
+    at::TensorList exp_avgs,
+    at::TensorList exp_avg_sqs,
+    at::TensorList max_exp_avg_sqs,
+    at::TensorList grads,
+    at::TensorList params2,
+    at::IntArrayRef steps,
+    bool amsgrad,
+    bool adamw,
+    double beta1,
+    double beta2,
+    double learning_rate,
+    double weight_decay,
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding) {
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::adam_fused_step_list", std::vector<c10::IValue>({}));
+  TORCH_CHECK(
+      exp_avgs.size() == params.size() && exp_avg_sqs.size() == params.size() &&
+          max_exp_avg_sqs.size() == params.size() &&
+          grads.size() == params.size() && params2.size() == params.size() &&
+          steps.size() == params.size(),
+      "Expect the same number of params, exp_avgs, exp_avg_sqs, max_exp_avg_sqs, grads, params2 and steps");
+
+  std::vector<int64_t> numels;
+  for (const auto& param : params) {
+    numels.push_back(param.numel());
+  }
+  multi_tensor_apply(numels, [&](int64_t i) {
+    adam_fused_step(
+        params[i],
+        exp_avgs[i],
+        exp_avg_sqs[i],
+        max_exp_avg_sqs[i],
+        grads[i],
+        params2[i],
+        steps[i],
+        amsgrad,
+        adamw,
+        beta1,
+        beta2,
+        learning_rate,
+        weight_decay,
+        eps,
+        grad_scale,
+        stochastic_rounding);
+  });
+}
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "adam_fused_step(Tensor(a!) param, Tensor(b!) exp_avg, Tensor(c!) "
+      "exp_avg_sq, Tensor(d!) max_exp_avg_sq, Tensor grad, Tensor trail, int "
+      "step, bool amsgrad, bool adamw, float beta1, float beta2, float lr, "
+      "float weight_decay, float eps, float grad_scale=1., bool "
+      "stochastic_rounding=False) -> (Tensor(a!), Tensor(b!), Tensor(c!))",
+      torch_ipex::cpu::adam_fused_step);
+  m.def(
+      "adam_fused_step_list(Tensor(a!)[] params, Tensor(b!)[] exp_avgs, "
+      "Tensor(c!)[] exp_avg_sqs, Tensor(d!)[] max_exp_avg_sqs, Tensor[] "
+      "grads, Tensor(e!)[] trails, int[] steps, bool amsgrad, bool adamw, "
+      "float beta1, float beta2, float lr, float weight_decay, float eps, "
+      "float grad_scale=1., bool stochastic_rounding=False) -> ()",
+      torch_ipex::cpu::adam_fused_step_list);
+}
+
+} // namespace
@@ -0,0 +1,103 @@
+#include "bf16_param.h"
+#include "optimizer.h"
+#include "csrc/utils/op_trace.h"
+
+#include <torch/csrc/autograd/function.h>
+#include <torch/extension.h>
+
+namespace torch_ipex {
+namespace cpu {
+
+using namespace at::vec;
+
+template <typename grad_t>
+void grad_accumulate_kernel(const at::Tensor& acc, const at::Tensor& grad) {
+  float* acc_data = acc.data_ptr<float>();
+  const float* grad_data = grad.data_ptr<float>();
+  using fVec = Vectorized<float>;
+  at::parallel_for(0, acc.numel(), 2048, [&](int64_t begin, int64_t end) {
+    float* acc_ptr = acc_data + begin;
+    const float* grad_ptr = grad_data + begin;
+    const int64_t size = end - begin;
+    int64_t d = 0;
+    for (; d < size - (size % fVec::size()); d += fVec::size()) {
+      fVec acc_fvec = fVec::loadu(acc_ptr + d) + fVec::loadu(grad_ptr + d);
+      acc_fvec.store(acc_ptr + d);
+    }
+    for (; d < size; d++) {
+      acc_ptr[d] += grad_ptr[d];
+    }
+  });
+}
+
+template <>
+void grad_accumulate_kernel<at::BFloat16>(
+    const at::Tensor& acc,
+    const at::Tensor& grad) {
+  float* acc_data = acc.data_ptr<float>();
+  const at::BFloat16* grad_data = grad.data_ptr<at::BFloat16>();
+  using bVec = Vectorized<at::BFloat16>;
+  using fVec = Vectorized<float>;
+  at::parallel_for(0, acc.numel(), 2048, [&](int64_t begin, int64_t end) {
+    float* acc_ptr = acc_data + begin;
+    const at::BFloat16* grad_ptr = grad_data + begin;
+    const int64_t size = end - begin;
+    int64_t d = 0;
+    for (; d < size - (size % bVec::size()); d += bVec::size()) {
+      fVec grad_fvec, grad_fvec2;
+      std::tie(grad_fvec, grad_fvec2) =
+          convert_bfloat16_float(bVec::loadu(grad_ptr + d));
+      fVec acc_fvec = fVec::loadu(acc_ptr + d) + grad_fvec;
+      fVec acc_fvec2 = fVec::loadu(acc_ptr + d + fVec::size()) + grad_fvec2;
+      acc_fvec.store(acc_ptr + d);
+      acc_fvec2.store(acc_ptr + d + fVec::size());
+    }
+    for (; d < size; d++) {
+      acc_ptr[d] += float(grad_ptr[d]);
+    }
+  });
+}
+
+/**
+ * Accumulate a grad into its float view of a flat grad accumulation buffer,
+ * converting a bf16 grad to float in the same pass, so that the grads of the
+ * micro-batches are neither cast nor accumulated in separate passes.
+ *@param acc The float and contiguous view of the buffer.
+ *@param grad The dense grad of float or bfloat16 of the same numel.
+ */
+void grad_accumulate_(const at::Tensor& acc, const at::Tensor& grad_) {
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::grad_accumulate_", std::vector<c10::IValue>({}));
+  TORCH_CHECK(
+      acc.scalar_type() == at::kFloat && acc.is_contiguous(),
+      "grad_accumulate_: expect acc to be a contiguous float32 tensor");
+  TORCH_CHECK(!grad_.is_sparse(), "grad_accumulate_: expect a dense grad");
+  TORCH_CHECK(
+      acc.numel() == grad_.numel(),
+      "Expect acc and grad_ have the same numel, acc sizes: ",
+      acc.sizes(),
+      "; grad_ sizes: ",
+      grad_.sizes());
+  auto grad = grad_.contiguous();
+  auto grad_dtype = grad.scalar_type();
+  if (at::ScalarType::Float == grad_dtype) {
+    grad_accumulate_kernel<float>(acc, grad);
+  } else if (at::ScalarType::BFloat16 == grad_dtype) {
+    grad_accumulate_kernel<at::BFloat16>(acc, grad);
+  } else {
+    TORCH_CHECK(false, "expect bfloat16 or float grad");
+  }
+}
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "grad_accumulate_(Tensor(a!) acc, Tensor grad) -> ()",
+      torch_ipex::cpu::grad_accumulate_);
+}
+
+} // namespace
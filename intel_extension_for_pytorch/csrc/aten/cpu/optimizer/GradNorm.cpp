@@ -0,0 +1,126 @@
+#include "multi_tensor_apply.h"
+#include "optimizer.h"
+#include "csrc/utils/op_trace.h"
+
+#include <torch/csrc/autograd/function.h>
+#include <torch/extension.h>
+
+namespace torch_ipex {
+namespace cpu {
+
+using namespace at::vec;
+
+template <typename scalar_t>
+static inline double acc_vec(const Vectorized<scalar_t>& v) {
+  const int64_t K = Vectorized<scalar_t>::size();
+  std::array<scalar_t, K> arr;
+  v.store(arr.data());
+  return std::accumulate(arr.cbegin(), arr.cend(), double(0));
+}
+
+// The sum of the squares of the grad, accumulated in scalar_t within a
+// chunk of the grad and in double across the chunks.
+template <typename scalar_t>
+double grad_sum_of_squares(const at::Tensor& grad) {
+  const scalar_t* grad_data = grad.data_ptr<scalar_t>();
+  using Vec = Vectorized<scalar_t>;
+  return at::parallel_reduce(
+      0,
+      grad.numel(),
+      2048,
+      double(0),
+      [&](int64_t begin, int64_t end, double ident) {
+        const scalar_t* grad_ptr = grad_data + begin;
+        const int64_t size = end - begin;
+        Vec sum_vec = Vec(scalar_t(0));
+        double sum_val = ident;
+        int64_t d = 0;
+        for (; d < size - (size % Vec::size()); d += Vec::size()) {
+          Vec grad_vec = Vec::loadu(grad_ptr + d);
+          sum_vec = sum_vec + grad_vec * grad_vec;
+        }
+        for (; d < size; d++) {
+          sum_val += double(grad_ptr[d]) * grad_ptr[d];
+        }
+        return sum_val + acc_vec(sum_vec);
+      },
+      std::plus<double>());
+}
+
+template <>
+double grad_sum_of_squares<at::BFloat16>(const at::Tensor& grad) {
+  const at::BFloat16* grad_data = grad.data_ptr<at::BFloat16>();
+  using bVec = Vectorized<at::BFloat16>;
+  using fVec = Vectorized<float>;
+  return at::parallel_reduce(
+      0,
+      grad.numel(),
+      2048,
+      double(0),
+      [&](int64_t begin, int64_t end, double ident) {
+        const at::BFloat16* grad_ptr = grad_data + begin;
+        const int64_t size = end - begin;
+        fVec sum_fvec = fVec(float(0));
+        double sum_val = ident;
+        int64_t d = 0;
+        for (; d < size - (size % bVec::size()); d += bVec::size()) {
+          fVec grad_fvec, grad_fvec2;
+          std::tie(grad_fvec, grad_fvec2) =
+              convert_bfloat16_float(bVec::loadu(grad_ptr + d));
+          sum_fvec = sum_fvec + grad_fvec * grad_fvec;
+          sum_fvec = sum_fvec + grad_fvec2 * grad_fvec2;
+        }
+        for (; d < size; d++) {
+          float grad_val = float(grad_ptr[d]);
+          sum_val += grad_val * grad_val;
+        }
+        return sum_val + acc_vec(sum_fvec);
+      },
+      std::plus<double>());
+}
+
+/**
+ * The global L2 norm of a list of grads, e.g. of all the params of an
+ * optimizer, as torch.nn.utils.clip_grad_norm_ computes before clipping.
+ * The grads are read once, the small ones together in one parallel loop,
+ * and the clip coefficient of the norm is then passed to the fused steps as
+ * grad_scale, so that the grads are neither read nor written again to clip.
+ *@param grads The dense grads of float, double or bfloat16.
+ */
+double grad_norm_list(at::TensorList grads) {
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::grad_norm_list", std::vector<c10::IValue>({}));
+  std::vector<int64_t> numels;
+  for (const auto& grad : grads) {
+    TORCH_CHECK(!grad.is_sparse(), "grad_norm_list: expect dense grads");
+    numels.push_back(grad.numel());
+  }
+  std::vector<double> sums(grads.size(), 0);
+  multi_tensor_apply(numels, [&](int64_t i) {
+    auto grad = grads[i].contiguous();
+    auto grad_dtype = grad.scalar_type();
+    if (at::ScalarType::Float == grad_dtype) {
+      sums[i] = grad_sum_of_squares<float>(grad);
+    } else if (at::ScalarType::Double == grad_dtype) {
+      sums[i] = grad_sum_of_squares<double>(grad);
+    } else if (at::ScalarType::BFloat16 == grad_dtype) {
+      sums[i] = grad_sum_of_squares<at::BFloat16>(grad);
+    } else {
+      TORCH_CHECK(false, "expect bfloat16 or float or double grad");
+    }
+  });
+  return std::sqrt(std::accumulate(sums.begin(), sums.end(), double(0)));
+}
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "grad_norm_list(Tensor[] grads) -> float",
+      torch_ipex::cpu::grad_norm_list);
+}
+
+} // namespace
@@ -1,13 +1,22 @@
-#include "csrc/cpu/vec512/bf16/vec/vec_type_cvt.h"
+#include "bf16_param.h"
+#include "multi_tensor_apply.h"
 #include "optimizer.h"
+#include "csrc/utils/op_trace.h"
 
 #include <torch/csrc/autograd/function.h>
 #include <torch/extension.h>
+
+#include <atomic>
+#include <vector>
 namespace torch_ipex {
 namespace cpu {
 
 using namespace at::vec;
 
+// The max numel of the Adam steps of the chunk of a thread that are kept in
+// its L2 cache from the first phase to the second phase of a Lamb step.
+const int64_t LAMB_STEP_CACHE_NUMEL = 131072;
+
 template <typename scalar_t>
 static inline scalar_t acc_vec(const at::vec::Vectorized<scalar_t>& v) {
   const int64_t K = at::vec::Vectorized<scalar_t>::size();
@@ -16,6 +25,98 @@ static inline scalar_t acc_vec(const at::vec::Vectorized<scalar_t>& v) {
   return std::accumulate(arr.cbegin(), arr.cend(), scalar_t(0));
 }
 
+// The coefficients of the Adam step of Lamb of one call.
+struct LambCoefficients {
+  double bias_correction1;
+  double bias_correction2;
+  double eps;
+  double weight_decay;
+
+  LambCoefficients(
+      int64_t step,
+      double beta1,
+      double beta2,
+      double eps,
+      double weight_decay)
+      : bias_correction1(1 - std::pow(beta1, step)),
+        bias_correction2(1 - std::pow(beta2, step)),
+        eps(eps),
+        weight_decay(weight_decay) {}
+};
+
+// The Adam step with the weight decay of the updated moments, the same in the
+// first phase and when it is recomputed by the second phase.
+template <typename scalar_t>
+static inline Vectorized<scalar_t> lamb_adam_step(
+    const Vectorized<scalar_t>& exp_avg,
+    const Vectorized<scalar_t>& exp_avg_sq,
+    const Vectorized<scalar_t>& param,
+    const LambCoefficients& coef) {
+  using Vec = Vectorized<scalar_t>;
+  Vec adam_step = exp_avg / Vec(scalar_t(coef.bias_correction1)) /
+      ((exp_avg_sq / Vec(scalar_t(coef.bias_correction2))).sqrt() +
+       Vec(scalar_t(coef.eps)));
+  return adam_step + param * Vec(scalar_t(coef.weight_decay));
+}
+
+template <typename scalar_t>
+static inline scalar_t lamb_adam_step_val(
+    scalar_t exp_avg,
+    scalar_t exp_avg_sq,
+    scalar_t param,
+    const LambCoefficients& coef) {
+  scalar_t adam_step = (exp_avg / coef.bias_correction1) /
+      (std::sqrt(exp_avg_sq / coef.bias_correction2) + coef.eps);
+  adam_step += param * coef.weight_decay;
+  return adam_step;
+}
+
+// The Adam steps of the chunk of the first phase of the last Lamb step on this
+// thread. The second phase reads them back when it runs the same chunk on the
+// same thread, as the static partition of at::parallel_for does, and else
+// recomputes them from the updated moments, so that neither the grad is
+// overwritten nor a workspace of the whole param is written and read back.
+template <typename step_t>
+class LambStepCache {
+ public:
+  // the buffer of the steps of the chunk, or nullptr if it exceeds the budget
+  step_t* acquire(uint64_t call, int64_t begin, int64_t end) {
+    call_ = 0;
+    if (end - begin > LAMB_STEP_CACHE_NUMEL) {
+      return nullptr;
+    }
+    call_ = call;
+    begin_ = begin;
+    end_ = end;
+    steps_.resize(end - begin);
+    return steps_.data();
+  }
+
+  // the steps of the chunk of the call, or nullptr if they are not cached
+  const step_t* lookup(uint64_t call, int64_t begin, int64_t end) const {
+    return call_ == call && begin_ == begin && end_ == end ? steps_.data()
+                                                           : nullptr;
+  }
+
+ private:
+  uint64_t call_ = 0;
+  int64_t begin_ = 0;
+  int64_t end_ = 0;
+  std::vector<step_t> steps_;
+};
+
+template <typename step_t>
+static LambStepCache<step_t>& lamb_step_cache() {
+  static thread_local LambStepCache<step_t> cache;
+  return cache;
+}
+
+// a nonzero id of each call, so that the steps of another call are not found
+static uint64_t next_lamb_call() {
+  static std::atomic<uint64_t> calls{0};
+  return ++calls;
+}
+
 template <typename scalar_t, typename grad_t>
 void lamb_fused_step_kernel(
     const at::Tensor& param,
@@ -28,14 +129,16 @@ void lamb_fused_step_kernel(
     double beta2,
     double learning_rate,
     double weight_decay,
-    double eps) {
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding) {
   scalar_t* param_data = param.data_ptr<scalar_t>();
   scalar_t* exp_avg_data = exp_avg.data_ptr<scalar_t>();
   scalar_t* exp_avg_sq_data = exp_avg_sq.data_ptr<scalar_t>();
-  scalar_t* grad_data = grad.data_ptr<scalar_t>();
+  const scalar_t* grad_data = grad.data_ptr<scalar_t>();
 
-  double bias_correction1 = 1 - std::pow(beta1, step);
-  double bias_correction2 = 1 - std::pow(beta2, step);
+  LambCoefficients coef(step, beta1, beta2, eps, weight_decay);
+  uint64_t call = next_lamb_call();
 
   int num_threads = at::get_num_threads();
   scalar_t param_norm_acc[num_threads];
@@ -57,7 +160,9 @@ void lamb_fused_step_kernel(
         scalar_t* param_ptr = param_data + begin;
         scalar_t* exp_avg_ptr = exp_avg_data + begin;
         scalar_t* exp_avg_sq_ptr = exp_avg_sq_data + begin;
-        scalar_t* grad_ptr = grad_data + begin;
+        const scalar_t* grad_ptr = grad_data + begin;
+        scalar_t* step_ptr =
+            lamb_step_cache<scalar_t>().acquire(call, begin, end);
 
         const int64_t size = end - begin;
 
@@ -69,38 +174,36 @@ void lamb_fused_step_kernel(
 
         int64_t d = 0;
         for (; d < size - (size % Vec::size()); d += Vec::size()) {
-          Vec grad_vec = Vec::loadu(grad_ptr + d);
+          Vec grad_vec = Vec::loadu(grad_ptr + d) * Vec(scalar_t(grad_scale));
           Vec exp_avg_vec = Vec::loadu(exp_avg_ptr + d) * Vec(scalar_t(beta1)) +
               grad_vec * Vec(scalar_t(1 - beta1));
           Vec exp_avg_sq_vec =
               Vec::loadu(exp_avg_sq_ptr + d) * Vec(scalar_t(beta2)) +
               grad_vec * grad_vec * Vec(scalar_t(1 - beta2));
-          Vec adam_step_vec = exp_avg_vec / Vec(scalar_t(bias_correction1)) /
-              ((exp_avg_sq_vec / Vec(scalar_t(bias_correction2))).sqrt() +
-               Vec(scalar_t(eps)));
 
           exp_avg_vec.store(exp_avg_ptr + d);
           exp_avg_sq_vec.store(exp_avg_sq_ptr + d);
 
           Vec param_vec = Vec::loadu(param_ptr + d);
-          adam_step_vec =
-              adam_step_vec + param_vec * Vec(scalar_t(weight_decay));
-          // reuse grad to store adam_step
-          adam_step_vec.store(grad_ptr + d);
+          Vec adam_step_vec =
+              lamb_adam_step(exp_avg_vec, exp_avg_sq_vec, param_vec, coef);
+          if (step_ptr != nullptr) {
+            adam_step_vec.store(step_ptr + d);
+          }
 
           sum1_vec = sum1_vec + param_vec * param_vec;
           sum2_vec = sum2_vec + adam_step_vec * adam_step_vec;
         }
         for (; d < size; d++) {
-          exp_avg_ptr[d] = exp_avg_ptr[d] * beta1 + grad_ptr[d] * (1 - beta1);
-          exp_avg_sq_ptr[d] = exp_avg_sq_ptr[d] * beta2 +
-              grad_ptr[d] * grad_ptr[d] * (1 - beta2);
-          scalar_t adam_step_val = (exp_avg_ptr[d] / bias_correction1) /
-              (std::sqrt(exp_avg_sq_ptr[d] / bias_correction2) + eps);
-
-          adam_step_val += param_ptr[d] * weight_decay;
-          // reuse grad to store adam_step
-          grad_ptr[d] = adam_step_val;
+          scalar_t grad_val = grad_ptr[d] * grad_scale;
+          exp_avg_ptr[d] = exp_avg_ptr[d] * beta1 + grad_val * (1 - beta1);
+          exp_avg_sq_ptr[d] =
+              exp_avg_sq_ptr[d] * beta2 + grad_val * grad_val * (1 - beta2);
+          scalar_t adam_step_val = lamb_adam_step_val(
+              exp_avg_ptr[d], exp_avg_sq_ptr[d], param_ptr[d], coef);
+          if (step_ptr != nullptr) {
+            step_ptr[d] = adam_step_val;
+          }
 
           sum1_val += param_ptr[d] * param_ptr[d];
           sum2_val += adam_step_val * adam_step_val;
@@ -133,19 +236,33 @@ void lamb_fused_step_kernel(
       0, param.numel(), grain_size, [&](int64_t begin, int64_t end) {
         // local pointers
         scalar_t* param_ptr = param_data + begin;
-        scalar_t* grad_ptr = grad_data + begin;
+        const scalar_t* exp_avg_ptr = exp_avg_data + begin;
+        const scalar_t* exp_avg_sq_ptr = exp_avg_sq_data + begin;
+        const scalar_t* step_ptr =
+            lamb_step_cache<scalar_t>().lookup(call, begin, end);
 
         const int64_t size = end - begin;
 
         int64_t d = 0;
         for (; d < size - (size % Vec::size()); d += Vec::size()) {
-          Vec param_vec = Vec::loadu(param_ptr + d) -
-              Vec::loadu(grad_ptr + d) *
-                  Vec(scalar_t(learning_rate * true_ratio));
+          Vec param_vec = Vec::loadu(param_ptr + d);
+          Vec adam_step_vec = step_ptr != nullptr
+              ? Vec::loadu(step_ptr + d)
+              : lamb_adam_step(
+                    Vec::loadu(exp_avg_ptr + d),
+                    Vec::loadu(exp_avg_sq_ptr + d),
+                    param_vec,
+                    coef);
+          param_vec = param_vec -
+              adam_step_vec * Vec(scalar_t(learning_rate * true_ratio));
           param_vec.store(param_ptr + d);
         }
         for (; d < size; d++) {
-          param_ptr[d] -= grad_ptr[d] * learning_rate * true_ratio;
+          scalar_t adam_step_val = step_ptr != nullptr
+              ? step_ptr[d]
+              : lamb_adam_step_val(
+                    exp_avg_ptr[d], exp_avg_sq_ptr[d], param_ptr[d], coef);
+          param_ptr[d] -= adam_step_val * learning_rate * true_ratio;
         }
       });
 }
@@ -162,7 +279,9 @@ void lamb_fused_step_kernel<at::BFloat16, at::BFloat16>(
     double beta2,
     double learning_rate,
     double weight_decay,
-    double eps) {
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding) {
   TORCH_CHECK(
       param.scalar_type() == at::kBFloat16,
       "lamb_fused_step_kernel: expect param to be at::BFloat16");
@@ -176,17 +295,20 @@ void lamb_fused_step_kernel<at::BFloat16, at::BFloat16>(
       exp_avg_sq.scalar_type() == at::kFloat,
       "lamb_fused_step_kernel: expect exp_avg_sq to be float32");
   TORCH_CHECK(
-      param2.scalar_type() == at::kBFloat16,
-      "lamb_fused_step_kernel: expect param2 to be at::BFloat16");
+      param2.numel() == 0 || param2.scalar_type() == at::kBFloat16,
+      "lamb_fused_step_kernel: expect param2 to be at::BFloat16 or empty");
 
   at::BFloat16* param_data = param.data_ptr<at::BFloat16>();
   float* exp_avg_data = exp_avg.data_ptr<float>();
   float* exp_avg_sq_data = exp_avg_sq.data_ptr<float>();
   at::BFloat16* grad_data = grad.data_ptr<at::BFloat16>();
-  at::BFloat16* param2_data = param2.data_ptr<at::BFloat16>();
+  // no trail of the split master weight for the pure bf16 params
+  at::BFloat16* param2_data =
+      param2.numel() > 0 ? param2.data_ptr<at::BFloat16>() : nullptr;
+  uint64_t seed = stochastic_rounding ? bf16_rounding_seed() : 0;
 
-  double bias_correction1 = 1 - std::pow(beta1, step);
-  double bias_correction2 = 1 - std::pow(beta2, step);
+  LambCoefficients coef(step, beta1, beta2, eps, weight_decay);
+  uint64_t call = next_lamb_call();
 
   int num_threads = at::get_num_threads();
   float param_norm_acc[num_threads];
@@ -194,12 +316,7 @@ void lamb_fused_step_kernel<at::BFloat16, at::BFloat16>(
   std::fill_n(&param_norm_acc[0], num_threads, float(0));
   std::fill_n(&rtw_norm_acc[0], num_threads, float(0));
 
-  // for float32 path, we can reuse grad to store adam_step
-  // but for bfloat16 path, this can't be done since grad is in bfloat16
-  // and we want to keep adam_step to be float32
   int64_t numel = param.numel();
-  at::Tensor workspace = at::empty({numel}, exp_avg.options());
-  float* workspace_data = workspace.data_ptr<float>();
 
   using bVec = at::vec::Vectorized<at::BFloat16>;
   using fVec = at::vec::Vectorized<float>;
@@ -210,12 +327,13 @@ void lamb_fused_step_kernel<at::BFloat16, at::BFloat16>(
     int tid = at::get_thread_num();
 
     // local pointers
-    at::BFloat16* param_ptr = param_data + begin;
     float* exp_avg_ptr = exp_avg_data + begin;
     float* exp_avg_sq_ptr = exp_avg_sq_data + begin;
     at::BFloat16* grad_ptr = grad_data + begin;
-    at::BFloat16* param2_ptr = param2_data + begin;
-    float* workspace_ptr = workspace_data + begin;
+    BFloat16ParamChunk params(
+        param_data, param2_data, stochastic_rounding, seed, begin);
+    // the adam steps are kept in float32 rather than in the bfloat16 grad
+    float* step_ptr = lamb_step_cache<float>().acquire(call, begin, end);
 
     const int64_t size = end - begin;
 
@@ -230,15 +348,14 @@ void lamb_fused_step_kernel<at::BFloat16, at::BFloat16>(
       bVec grad_bvec = bVec::loadu(grad_ptr + d);
       fVec grad_fvec, grad_fvec2;
       std::tie(grad_fvec, grad_fvec2) = convert_bfloat16_float(grad_bvec);
+      grad_fvec = grad_fvec * fVec(float(grad_scale));
+      grad_fvec2 = grad_fvec2 * fVec(float(grad_scale));
 
       fVec exp_avg_fvec = fVec::loadu(exp_avg_ptr + d) * fVec(float(beta1)) +
           grad_fvec * fVec(float(1 - beta1));
       fVec exp_avg_sq_fvec =
           fVec::loadu(exp_avg_sq_ptr + d) * fVec(float(beta2)) +
           grad_fvec * grad_fvec * fVec(float(1 - beta2));
-      fVec adam_step_fvec = exp_avg_fvec / fVec(float(bias_correction1)) /
-          ((exp_avg_sq_fvec / fVec(float(bias_correction2))).sqrt() +
-           fVec(float(eps)));
 
       fVec exp_avg_fvec2 =
           fVec::loadu(exp_avg_ptr + d + fVec::size()) * fVec(float(beta1)) +
@@ -246,26 +363,23 @@ void lamb_fused_step_kernel<at::BFloat16, at::BFloat16>(
       fVec exp_avg_sq_fvec2 =
           fVec::loadu(exp_avg_sq_ptr + d + fVec::size()) * fVec(float(beta2)) +
           grad_fvec2 * grad_fvec2 * fVec(float(1 - beta2));
-      fVec adam_step_fvec2 = exp_avg_fvec2 / fVec(float(bias_correction1)) /
-          ((exp_avg_sq_fvec2 / fVec(float(bias_correction2))).sqrt() +
-           fVec(float(eps)));
 
       exp_avg_fvec.store(exp_avg_ptr + d);
       exp_avg_fvec2.store(exp_avg_ptr + d + fVec::size());
       exp_avg_sq_fvec.store(exp_avg_sq_ptr + d);
       exp_avg_sq_fvec2.store(exp_avg_sq_ptr + d + fVec::size());
 
-      bVec param_bvec = bVec::loadu(param_ptr + d);
-      bVec param2_bvec = bVec::loadu(param2_ptr + d);
       fVec param_fvec, param_fvec2;
-      std::tie(param_fvec, param_fvec2) =
-          bf16::pack_bfloat16_float(param_bvec, param2_bvec);
+      std::tie(param_fvec, param_fvec2) = params.load(d);
 
-      adam_step_fvec = adam_step_fvec + param_fvec * fVec(float(weight_decay));
-      adam_step_fvec2 =
-          adam_step_fvec2 + param_fvec2 * fVec(float(weight_decay));
-      adam_step_fvec.store(workspace_ptr + d);
-      adam_step_fvec2.store(workspace_ptr + d + fVec::size());
+      fVec adam_step_fvec =
+          lamb_adam_step(exp_avg_fvec, exp_avg_sq_fvec, param_fvec, coef);
+      fVec adam_step_fvec2 =
+          lamb_adam_step(exp_avg_fvec2, exp_avg_sq_fvec2, param_fvec2, coef);
+      if (step_ptr != nullptr) {
+        adam_step_fvec.store(step_ptr + d);
+        adam_step_fvec2.store(step_ptr + d + fVec::size());
+      }
 
       sum1_fvec += param_fvec * param_fvec;
       sum1_fvec += param_fvec2 * param_fvec2;
@@ -273,16 +387,17 @@ void lamb_fused_step_kernel<at::BFloat16, at::BFloat16>(
       sum2_fvec += adam_step_fvec2 * adam_step_fvec2;
     }
     for (; d < size; d++) {
-      float grad_val = float(grad_ptr[d]);
+      float grad_val = float(grad_ptr[d]) * grad_scale;
       exp_avg_ptr[d] = exp_avg_ptr[d] * beta1 + grad_val * (1 - beta1);
       exp_avg_sq_ptr[d] =
           exp_avg_sq_ptr[d] * beta2 + grad_val * grad_val * (1 - beta2);
-      float adam_step_val = (exp_avg_ptr[d] / bias_correction1) /
-          (std::sqrt(exp_avg_sq_ptr[d] / bias_correction2) + eps);
 
-      float param_val = bf16::pack_bfloat16_float(param_ptr[d], param2_ptr[d]);
-      adam_step_val += param_val * weight_decay;
-      workspace_ptr[d] = adam_step_val;
+      float param_val = params.load_val(d);
+      float adam_step_val = lamb_adam_step_val(
+          exp_avg_ptr[d], exp_avg_sq_ptr[d], param_val, coef);
+      if (step_ptr != nullptr) {
+        step_ptr[d] = adam_step_val;
+      }
 
       sum1_val += param_val * param_val;
       sum2_val += adam_step_val * adam_step_val;
@@ -305,35 +420,49 @@ void lamb_fused_step_kernel<at::BFloat16, at::BFloat16>(
   // update param
   at::parallel_for(0, numel, grain_size, [&](int64_t begin, int64_t end) {
     // local pointers
-    at::BFloat16* param_ptr = param_data + begin;
-    at::BFloat16* param2_ptr = param2_data + begin;
-    float* workspace_ptr = workspace_data + begin;
+    BFloat16ParamChunk params(
+        param_data, param2_data, stochastic_rounding, seed, begin);
+    const float* exp_avg_ptr = exp_avg_data + begin;
+    const float* exp_avg_sq_ptr = exp_avg_sq_data + begin;
+    const float* step_ptr = lamb_step_cache<float>().lookup(call, begin, end);
 
     const int64_t size = end - begin;
 
     int64_t d = 0;
     for (; d < size - (size % bVec::size()); d += bVec::size()) {
-      bVec param_bvec = bVec::loadu(param_ptr + d);
-      bVec param2_bvec = bVec::loadu(param2_ptr + d);
       fVec param_fvec, param_fvec2;
-      std::tie(param_fvec, param_fvec2) =
-          bf16::pack_bfloat16_float(param_bvec, param2_bvec);
-
-      param_fvec -= fVec::loadu(workspace_ptr + d) *
-          fVec(float(learning_rate * true_ratio));
-      param_fvec2 -= fVec::loadu(workspace_ptr + d + fVec::size()) *
-          fVec(float(learning_rate * true_ratio));
-
-      std::tie(param_bvec, param2_bvec) =
-          bf16::unpack_float_bfloat16(param_fvec, param_fvec2);
-      param_bvec.store(param_ptr + d);
-      param2_bvec.store(param2_ptr + d);
+      std::tie(param_fvec, param_fvec2) = params.load(d);
+
+      fVec adam_step_fvec, adam_step_fvec2;
+      if (step_ptr != nullptr) {
+        adam_step_fvec = fVec::loadu(step_ptr + d);
+        adam_step_fvec2 = fVec::loadu(step_ptr + d + fVec::size());
+      } else {
+        adam_step_fvec = lamb_adam_step(
+            fVec::loadu(exp_avg_ptr + d),
+            fVec::loadu(exp_avg_sq_ptr + d),
+            param_fvec,
+            coef);
+        adam_step_fvec2 = lamb_adam_step(
+            fVec::loadu(exp_avg_ptr + d + fVec::size()),
+            fVec::loadu(exp_avg_sq_ptr + d + fVec::size()),
+            param_fvec2,
+            coef);
+      }
+
+      param_fvec -= adam_step_fvec * fVec(float(learning_rate * true_ratio));
+      param_fvec2 -= adam_step_fvec2 * fVec(float(learning_rate * true_ratio));
+
+      params.store(d, param_fvec, param_fvec2);
     }
     for (; d < size; d++) {
-      float param_val = bf16::pack_bfloat16_float(param_ptr[d], param2_ptr[d]);
-      param_val -= workspace_ptr[d] * learning_rate * true_ratio;
-      std::tie(param_ptr[d], param2_ptr[d]) =
-          bf16::unpack_float_bfloat16(param_val);
+      float param_val = params.load_val(d);
+      float adam_step_val = step_ptr != nullptr
+          ? step_ptr[d]
+          : lamb_adam_step_val(
+                exp_avg_ptr[d], exp_avg_sq_ptr[d], param_val, coef);
+      param_val -= adam_step_val * learning_rate * true_ratio;
+      params.store_val(d, param_val);
     }
   });
 }
@@ -350,7 +479,9 @@ void lamb_fused_step_kernel<float, at::BFloat16>(
     double beta2,
     double learning_rate,
     double weight_decay,
-    double eps) {
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding) {
   TORCH_CHECK(
       param.scalar_type() == at::kFloat,
       "lamb_fused_step_kernel: expect param to be at::Float");
@@ -373,8 +504,8 @@ void lamb_fused_step_kernel<float, at::BFloat16>(
   at::BFloat16* grad_data = grad.data_ptr<at::BFloat16>();
   at::BFloat16* param2_data = param2.data_ptr<at::BFloat16>();
 
-  double bias_correction1 = 1 - std::pow(beta1, step);
-  double bias_correction2 = 1 - std::pow(beta2, step);
+  LambCoefficients coef(step, beta1, beta2, eps, weight_decay);
+  uint64_t call = next_lamb_call();
 
   int num_threads = at::get_num_threads();
   float param_norm_acc[num_threads];
@@ -382,12 +513,7 @@ void lamb_fused_step_kernel<float, at::BFloat16>(
   std::fill_n(&param_norm_acc[0], num_threads, float(0));
   std::fill_n(&rtw_norm_acc[0], num_threads, float(0));
 
-  // for float32 path, we can reuse grad to store adam_step
-  // but for bfloat16 path, this can't be done since grad is in bfloat16
-  // and we want to keep adam_step to be float32
   int64_t numel = param.numel();
-  at::Tensor workspace = at::empty({numel}, exp_avg.options());
-  float* workspace_data = workspace.data_ptr<float>();
 
   using bVec = at::vec::Vectorized<at::BFloat16>;
   using fVec = at::vec::Vectorized<float>;
@@ -402,7 +528,8 @@ void lamb_fused_step_kernel<float, at::BFloat16>(
     float* exp_avg_ptr = exp_avg_data + begin;
     float* exp_avg_sq_ptr = exp_avg_sq_data + begin;
     at::BFloat16* grad_ptr = grad_data + begin;
-    float* workspace_ptr = workspace_data + begin;
+    // the adam steps are kept in float32 rather than in the bfloat16 grad
+    float* step_ptr = lamb_step_cache<float>().acquire(call, begin, end);
 
     const int64_t size = end - begin;
 
@@ -417,15 +544,14 @@ void lamb_fused_step_kernel<float, at::BFloat16>(
       bVec grad_bvec = bVec::loadu(grad_ptr + d);
       fVec grad_fvec, grad_fvec2;
       std::tie(grad_fvec, grad_fvec2) = convert_bfloat16_float(grad_bvec);
+      grad_fvec = grad_fvec * fVec(float(grad_scale));
+      grad_fvec2 = grad_fvec2 * fVec(float(grad_scale));
 
       fVec exp_avg_fvec = fVec::loadu(exp_avg_ptr + d) * fVec(float(beta1)) +
           grad_fvec * fVec(float(1 - beta1));
       fVec exp_avg_sq_fvec =
           fVec::loadu(exp_avg_sq_ptr + d) * fVec(float(beta2)) +
           grad_fvec * grad_fvec * fVec(float(1 - beta2));
-      fVec adam_step_fvec = exp_avg_fvec / fVec(float(bias_correction1)) /
-          ((exp_avg_sq_fvec / fVec(float(bias_correction2))).sqrt() +
-           fVec(float(eps)));
 
       fVec exp_avg_fvec2 =
           fVec::loadu(exp_avg_ptr + d + fVec::size()) * fVec(float(beta1)) +
@@ -433,9 +559,6 @@ void lamb_fused_step_kernel<float, at::BFloat16>(
       fVec exp_avg_sq_fvec2 =
           fVec::loadu(exp_avg_sq_ptr + d + fVec::size()) * fVec(float(beta2)) +
           grad_fvec2 * grad_fvec2 * fVec(float(1 - beta2));
-      fVec adam_step_fvec2 = exp_avg_fvec2 / fVec(float(bias_correction1)) /
-          ((exp_avg_sq_fvec2 / fVec(float(bias_correction2))).sqrt() +
-           fVec(float(eps)));
 
       exp_avg_fvec.store(exp_avg_ptr + d);
       exp_avg_fvec2.store(exp_avg_ptr + d + fVec::size());
@@ -445,11 +568,14 @@ void lamb_fused_step_kernel<float, at::BFloat16>(
       fVec param_fvec = fVec::loadu(param_ptr + d);
       fVec param_fvec2 = fVec::loadu(param_ptr + d + fVec::size());
 
-      adam_step_fvec = adam_step_fvec + param_fvec * fVec(float(weight_decay));
-      adam_step_fvec2 =
-          adam_step_fvec2 + param_fvec2 * fVec(float(weight_decay));
-      adam_step_fvec.store(workspace_ptr + d);
-      adam_step_fvec2.store(workspace_ptr + d + fVec::size());
+      fVec adam_step_fvec =
+          lamb_adam_step(exp_avg_fvec, exp_avg_sq_fvec, param_fvec, coef);
+      fVec adam_step_fvec2 =
+          lamb_adam_step(exp_avg_fvec2, exp_avg_sq_fvec2, param_fvec2, coef);
+      if (step_ptr != nullptr) {
+        adam_step_fvec.store(step_ptr + d);
+        adam_step_fvec2.store(step_ptr + d + fVec::size());
+      }
 
       sum1_fvec += param_fvec * param_fvec;
       sum1_fvec += param_fvec2 * param_fvec2;
@@ -457,16 +583,17 @@ void lamb_fused_step_kernel<float, at::BFloat16>(
       sum2_fvec += adam_step_fvec2 * adam_step_fvec2;
     }
     for (; d < size; d++) {
-      float grad_val = float(grad_ptr[d]);
+      float grad_val = float(grad_ptr[d]) * grad_scale;
       exp_avg_ptr[d] = exp_avg_ptr[d] * beta1 + grad_val * (1 - beta1);
       exp_avg_sq_ptr[d] =
           exp_avg_sq_ptr[d] * beta2 + grad_val * grad_val * (1 - beta2);
-      float adam_step_val = (exp_avg_ptr[d] / bias_correction1) /
-          (std::sqrt(exp_avg_sq_ptr[d] / bias_correction2) + eps);
 
       float param_val = param_ptr[d];
-      adam_step_val += param_val * weight_decay;
-      workspace_ptr[d] = adam_step_val;
+      float adam_step_val = lamb_adam_step_val(
+          exp_avg_ptr[d], exp_avg_sq_ptr[d], param_val, coef);
+      if (step_ptr != nullptr) {
+        step_ptr[d] = adam_step_val;
+      }
 
       sum1_val += param_val * param_val;
       sum2_val += adam_step_val * adam_step_val;
@@ -491,7 +618,9 @@ void lamb_fused_step_kernel<float, at::BFloat16>(
     // local pointers
     float* param_ptr = param_data + begin;
     at::BFloat16* param2_ptr = param2_data + begin;
-    float* workspace_ptr = workspace_data + begin;
+    const float* exp_avg_ptr = exp_avg_data + begin;
+    const float* exp_avg_sq_ptr = exp_avg_sq_data + begin;
+    const float* step_ptr = lamb_step_cache<float>().lookup(call, begin, end);
 
     const int64_t size = end - begin;
 
@@ -500,10 +629,25 @@ void lamb_fused_step_kernel<float, at::BFloat16>(
       fVec param_fvec = fVec::loadu(param_ptr + d);
       fVec param_fvec2 = fVec::loadu(param_ptr + d + fVec::size());
 
-      param_fvec -= fVec::loadu(workspace_ptr + d) *
-          fVec(float(learning_rate * true_ratio));
-      param_fvec2 -= fVec::loadu(workspace_ptr + d + fVec::size()) *
-          fVec(float(learning_rate * true_ratio));
+      fVec adam_step_fvec, adam_step_fvec2;
+      if (step_ptr != nullptr) {
+        adam_step_fvec = fVec::loadu(step_ptr + d);
+        adam_step_fvec2 = fVec::loadu(step_ptr + d + fVec::size());
+      } else {
+        adam_step_fvec = lamb_adam_step(
+            fVec::loadu(exp_avg_ptr + d),
+            fVec::loadu(exp_avg_sq_ptr + d),
+            param_fvec,
+            coef);
+        adam_step_fvec2 = lamb_adam_step(
+            fVec::loadu(exp_avg_ptr + d + fVec::size()),
+            fVec::loadu(exp_avg_sq_ptr + d + fVec::size()),
+            param_fvec2,
+            coef);
+      }
+
+      param_fvec -= adam_step_fvec * fVec(float(learning_rate * true_ratio));
+      param_fvec2 -= adam_step_fvec2 * fVec(float(learning_rate * true_ratio));
 
       param_fvec.store(param_ptr + d);
       param_fvec2.store(param_ptr + d + fVec::size());
@@ -513,7 +657,11 @@ void lamb_fused_step_kernel<float, at::BFloat16>(
     }
     for (; d < size; d++) {
       float param_val = param_ptr[d];
-      param_val -= workspace_ptr[d] * learning_rate * true_ratio;
+      float adam_step_val = step_ptr != nullptr
+          ? step_ptr[d]
+          : lamb_adam_step_val(
+                exp_avg_ptr[d], exp_avg_sq_ptr[d], param_val, coef);
+      param_val -= adam_step_val * learning_rate * true_ratio;
       param_ptr[d] = param_val;
       param2_ptr[d] = at::BFloat16(param_val);
     }
@@ -531,10 +679,11 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> lamb_fused_step(
     double beta2,
     double learning_rate,
     double weight_decay,
-    double eps) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("torch_ipex::lamb_fused_step", std::vector<c10::IValue>({}));
-#endif
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding) {
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::lamb_fused_step", std::vector<c10::IValue>({}));
   TORCH_CHECK(
       learning_rate >= 0, "Expect learning rate >= 0.0, got ", learning_rate);
   TORCH_CHECK(eps >= 0, "Expect eps >= 0.0, got ", eps);
@@ -588,7 +737,9 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> lamb_fused_step(
         beta2,
         learning_rate,
         weight_decay,
-        eps);
+        eps,
+        grad_scale,
+        stochastic_rounding);
   } else if (at::ScalarType::Double == grad_dtype) {
     lamb_fused_step_kernel<double, double>(
         param,
@@ -601,7 +752,9 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> lamb_fused_step(
         beta2,
         learning_rate,
         weight_decay,
-        eps);
+        eps,
+        grad_scale,
+        stochastic_rounding);
   } else if (
       at::ScalarType::BFloat16 == grad_dtype &&
       at::ScalarType::BFloat16 == param_dtype) {
@@ -616,7 +769,9 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> lamb_fused_step(
         beta2,
         learning_rate,
         weight_decay,
-        eps);
+        eps,
+        grad_scale,
+        stochastic_rounding);
   } else if (
       at::ScalarType::BFloat16 == grad_dtype &&
       at::ScalarType::Float == param_dtype) {
@@ -631,7 +786,9 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> lamb_fused_step(
         beta2,
         learning_rate,
         weight_decay,
-        eps);
+        eps,
+        grad_scale,
+        stochastic_rounding);
   } else {
     TORCH_CHECK(false, "expect bfloat16 or float or double param");
   }
@@ -652,6 +809,57 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> lamb_fused_step(
   return std::make_tuple(param_, exp_avg_, exp_avg_sq_);
 }
 
+/**
+ * Lamb fused update of a list of params, e.g. of a param group, of which the
+ * small params are updated together in one parallel loop. The trust ratio is
+ * still of the norms of each param.
+ * The args are the same as lamb_fused_step, of a list for each tensor and the
+ * step of each param.
+ */
+void lamb_fused_step_list(
+    at::TensorList params,
+    at::TensorList exp_avgs,
+    at::TensorList exp_avg_sqs,
+    at::TensorList grads,
+    at::TensorList params2,
+    at::IntArrayRef steps,
+    double beta1,
+    double beta2,
+    double learning_rate,
+    double weight_decay,
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding) {
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::lamb_fused_step_list", std::vector<c10::IValue>({}));
+  TORCH_CHECK(
+      exp_avgs.size() == params.size() && exp_avg_sqs.size() == params.size() &&
+          grads.size() == params.size() && params2.size() == params.size() &&
+          steps.size() == params.size(),
+      "Expect the same number of params, exp_avgs, exp_avg_sqs, grads, params2 and steps");
+
+  std::vector<int64_t> numels;
+  for (const auto& param : params) {
+    numels.push_back(param.numel());
+  }
+  multi_tensor_apply(numels, [&](int64_t i) {
+    lamb_fused_step(
+        params[i],
+        exp_avgs[i],
+        exp_avg_sqs[i],
+        grads[i],
+        params2[i],
+        steps[i],
+        beta1,
+        beta2,
+        learning_rate,
+        weight_decay,
+        eps,
+        grad_scale,
+        stochastic_rounding);
+  });
+}
+
 } // namespace cpu
 } // namespace torch_ipex
 
@@ -661,9 +869,16 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
   m.def(
       "lamb_fused_step(Tensor(a!) param, Tensor(b!) exp_avg, Tensor(c!) "
       "exp_avg_sq, Tensor grad, Tensor trail, int step, float beta1, float "
-      "beta2, float lr, float weight_decay, float eps) -> (Tensor(a!), "
-      "Tensor(b!), Tensor(c!))",
+      "beta2, float lr, float weight_decay, float eps, float grad_scale=1., "
+      "bool stochastic_rounding=False) -> (Tensor(a!), Tensor(b!), "
+      "Tensor(c!))",
       torch_ipex::cpu::lamb_fused_step);
+  m.def(
+      "lamb_fused_step_list(Tensor(a!)[] params, Tensor(b!)[] exp_avgs, "
+      "Tensor(c!)[] exp_avg_sqs, Tensor[] grads, Tensor(d!)[] trails, int[] "
+      "steps, float beta1, float beta2, float lr, float weight_decay, float "
+      "eps, float grad_scale=1., bool stochastic_rounding=False) -> ()",
+      torch_ipex::cpu::lamb_fused_step_list);
 }
 
 } // namespace
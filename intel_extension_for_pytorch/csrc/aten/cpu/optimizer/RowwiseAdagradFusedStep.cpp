@@ -0,0 +1,318 @@
+#include "bf16_param.h"
+#include "optimizer.h"
+#include "csrc/utils/op_trace.h"
+
+#include <torch/csrc/autograd/function.h>
+#include <torch/extension.h>
+
+namespace torch_ipex {
+namespace cpu {
+
+using namespace at::vec;
+
+template <typename scalar_t>
+static inline scalar_t sum_vec(const Vectorized<scalar_t>& v) {
+  const int64_t K = Vectorized<scalar_t>::size();
+  std::array<scalar_t, K> arr;
+  v.store(arr.data());
+  return std::accumulate(arr.cbegin(), arr.cend(), scalar_t(0));
+}
+
+// The rows of the grad values to update, of the coalesced indices of a
+// sparse grad, or all the rows of a dense grad if rows is nullptr.
+template <typename scalar_t>
+void rowwise_adagrad_fused_step_kernel(
+    const at::Tensor& param,
+    const int64_t* rows,
+    const at::Tensor& values,
+    const at::Tensor& state_sum,
+    const at::Tensor& param2,
+    double learning_rate,
+    double weight_decay,
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding) {
+  scalar_t* param_data = param.data_ptr<scalar_t>();
+  scalar_t* grad_data = values.data_ptr<scalar_t>();
+  scalar_t* state_sum_data = state_sum.data_ptr<scalar_t>();
+  const int64_t n_rows = values.size(0);
+  const int64_t row_size =
+      param.numel() / std::max<int64_t>(param.size(0), 1);
+
+  using Vec = at::vec::Vectorized<scalar_t>;
+
+  // about the elements of the grain of the dense fused steps
+  int64_t grain_size =
+      std::max<int64_t>(1, 512 / std::max<int64_t>(row_size, 1));
+
+  at::parallel_for(0, n_rows, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t r = begin; r < end; r++) {
+      int64_t row = rows == nullptr ? r : rows[r];
+      scalar_t* param_ptr = param_data + row * row_size;
+      scalar_t* grad_ptr = grad_data + r * row_size;
+
+      // the mean squared grad of the row
+      Vec sq_vec = Vec(scalar_t(0));
+      scalar_t sq_val = 0;
+      int64_t d = 0;
+      for (; d < row_size - (row_size % Vec::size()); d += Vec::size()) {
+        Vec grad_vec = Vec::loadu(grad_ptr + d) * Vec(scalar_t(grad_scale)) +
+            Vec::loadu(param_ptr + d) * Vec(scalar_t(weight_decay));
+        sq_vec = sq_vec + grad_vec * grad_vec;
+      }
+      for (; d < row_size; d++) {
+        scalar_t grad_val =
+            grad_ptr[d] * grad_scale + param_ptr[d] * weight_decay;
+        sq_val += grad_val * grad_val;
+      }
+      state_sum_data[row] += (sq_val + sum_vec(sq_vec)) / row_size;
+      scalar_t clr = learning_rate / (std::sqrt(state_sum_data[row]) + eps);
+
+      d = 0;
+      for (; d < row_size - (row_size % Vec::size()); d += Vec::size()) {
+        Vec param_vec = Vec::loadu(param_ptr + d);
+        Vec grad_vec = Vec::loadu(grad_ptr + d) * Vec(scalar_t(grad_scale)) +
+            param_vec * Vec(scalar_t(weight_decay));
+        param_vec = param_vec - grad_vec * Vec(clr);
+        param_vec.store(param_ptr + d);
+      }
+      for (; d < row_size; d++) {
+        scalar_t grad_val =
+            grad_ptr[d] * grad_scale + param_ptr[d] * weight_decay;
+        param_ptr[d] -= grad_val * clr;
+      }
+    }
+  });
+}
+
+template <>
+void rowwise_adagrad_fused_step_kernel<at::BFloat16>(
+    const at::Tensor& param,
+    const int64_t* rows,
+    const at::Tensor& values,
+    const at::Tensor& state_sum,
+    const at::Tensor& param2,
+    double learning_rate,
+    double weight_decay,
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding) {
+  TORCH_CHECK(
+      state_sum.scalar_type() == at::kFloat,
+      "rowwise_adagrad_fused_step_kernel: expect stats_sum to be float32");
+  TORCH_CHECK(
+      param2.numel() == 0 || param2.scalar_type() == at::kBFloat16,
+      "rowwise_adagrad_fused_step_kernel: expect param2 to be at::BFloat16 or empty");
+
+  at::BFloat16* param_data = param.data_ptr<at::BFloat16>();
+  at::BFloat16* grad_data = values.data_ptr<at::BFloat16>();
+  float* state_sum_data = state_sum.data_ptr<float>();
+  // no trail of the split master weight for the pure bf16 params
+  at::BFloat16* param2_data =
+      param2.numel() > 0 ? param2.data_ptr<at::BFloat16>() : nullptr;
+  uint64_t seed = stochastic_rounding ? bf16_rounding_seed() : 0;
+  const int64_t n_rows = values.size(0);
+  const int64_t row_size =
+      param.numel() / std::max<int64_t>(param.size(0), 1);
+
+  using bVec = at::vec::Vectorized<at::BFloat16>;
+  using fVec = at::vec::Vectorized<float>;
+
+  // about the elements of the grain of the dense fused steps
+  int64_t grain_size =
+      std::max<int64_t>(1, 512 / std::max<int64_t>(row_size, 1));
+
+  at::parallel_for(0, n_rows, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t r = begin; r < end; r++) {
+      int64_t row = rows == nullptr ? r : rows[r];
+      at::BFloat16* grad_ptr = grad_data + r * row_size;
+      BFloat16ParamChunk params(
+          param_data, param2_data, stochastic_rounding, seed, row * row_size);
+
+      // the mean squared grad of the row
+      fVec sq_fvec = fVec(float(0));
+      float sq_val = 0;
+      int64_t d = 0;
+      for (; d < row_size - (row_size % bVec::size()); d += bVec::size()) {
+        fVec param_fvec, param_fvec2;
+        std::tie(param_fvec, param_fvec2) = params.load(d);
+        fVec grad_fvec, grad_fvec2;
+        std::tie(grad_fvec, grad_fvec2) =
+            convert_bfloat16_float(bVec::loadu(grad_ptr + d));
+        grad_fvec = grad_fvec * fVec(float(grad_scale)) +
+            param_fvec * fVec(float(weight_decay));
+        grad_fvec2 = grad_fvec2 * fVec(float(grad_scale)) +
+            param_fvec2 * fVec(float(weight_decay));
+        sq_fvec = sq_fvec + grad_fvec * grad_fvec + grad_fvec2 * grad_fvec2;
+      }
+      for (; d < row_size; d++) {
+        float grad_val = float(grad_ptr[d]) * grad_scale +
+            params.load_val(d) * weight_decay;
+        sq_val += grad_val * grad_val;
+      }
+      state_sum_data[row] += (sq_val + sum_vec(sq_fvec)) / row_size;
+      float clr = learning_rate / (std::sqrt(state_sum_data[row]) + eps);
+
+      d = 0;
+      for (; d < row_size - (row_size % bVec::size()); d += bVec::size()) {
+        fVec param_fvec, param_fvec2;
+        std::tie(param_fvec, param_fvec2) = params.load(d);
+        fVec grad_fvec, grad_fvec2;
+        std::tie(grad_fvec, grad_fvec2) =
+            convert_bfloat16_float(bVec::loadu(grad_ptr + d));
+        grad_fvec = grad_fvec * fVec(float(grad_scale)) +
+            param_fvec * fVec(float(weight_decay));
+        grad_fvec2 = grad_fvec2 * fVec(float(grad_scale)) +
+            param_fvec2 * fVec(float(weight_decay));
+        param_fvec = param_fvec - grad_fvec * fVec(clr);
+        param_fvec2 = param_fvec2 - grad_fvec2 * fVec(clr);
+        params.store(d, param_fvec, param_fvec2);
+      }
+      for (; d < row_size; d++) {
+        float param_val = params.load_val(d);
+        float grad_val =
+            float(grad_ptr[d]) * grad_scale + param_val * weight_decay;
+        params.store_val(d, param_val - grad_val * clr);
+      }
+    }
+  });
+}
+
+/**
+ * Row-wise Adagrad fused update, e.g. of an embedding table, of which each
+ * row keeps one state sum, the sum of the mean squared grads of the row, so
+ * that the state is feature_size times smaller than of Adagrad. Only the
+ * rows of a sparse grad are read and updated, by
+ * param -= lr / (sqrt(state_sum) + eps) * grad, as
+ * MergedEmbeddingBagWithRowwiseAdagrad updates its tables in its backward.
+ *@param param The param of the rows of its first dim to update.
+ *@param grad The sparse grad of the rows of the param, which is coalesced
+ * first, or the dense grad of all the rows.
+ *@param state_sum The state sum of each row, of float for the bf16 param.
+ *@param param2 The trail of the split bf16 master weight, or empty.
+ *@param grad_scale The scale of the grad, e.g. to clip the grads.
+ *@param stochastic_rounding Round the pure bf16 param stochastically.
+ */
+void rowwise_adagrad_fused_step(
+    const at::Tensor& param_,
+    const at::Tensor& grad_,
+    const at::Tensor& state_sum_,
+    const at::Tensor& param2_,
+    double learning_rate,
+    double weight_decay,
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding) {
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::rowwise_adagrad_fused_step", std::vector<c10::IValue>({}));
+  TORCH_CHECK(
+      learning_rate >= 0, "Expect learning rate >= 0.0, got ", learning_rate);
+  TORCH_CHECK(eps >= 0, "Expect eps >= 0.0, got ", eps);
+  TORCH_CHECK(
+      weight_decay >= 0, "Expect weight_decay >= 0.0, got ", weight_decay);
+  TORCH_CHECK(param_.dim() >= 1, "Expect param of at least 1 dim");
+
+  TORCH_CHECK(
+      param_.sizes() == grad_.sizes(),
+      "Expect param and grad_ have the same sizes, param sizes: ",
+      param_.sizes(),
+      "; grad_ sizes: ",
+      grad_.sizes());
+  TORCH_CHECK(
+      state_sum_.dim() == 1 && state_sum_.size(0) == param_.size(0),
+      "Expect a state_sum of each row of param, param sizes: ",
+      param_.sizes(),
+      "; state_sum sizes: ",
+      state_sum_.sizes());
+  TORCH_CHECK(
+      param2_.numel() == 0 || param_.sizes() == param2_.sizes(),
+      "Expect param and param2_ have the same sizes, param sizes: ",
+      param_.sizes(),
+      "; param2_ sizes: ",
+      param2_.sizes());
+  TORCH_CHECK(
+      param_.scalar_type() == grad_.scalar_type(),
+      "Expect param and grad_ of the same dtype");
+
+  auto param = param_.contiguous();
+  auto state_sum = state_sum_.contiguous();
+  auto param2 = param2_.contiguous();
+  at::Tensor values, rows;
+  if (grad_.is_sparse()) {
+    auto grad = grad_.coalesce();
+    TORCH_CHECK(
+        grad.sparse_dim() == 1, "Expect the sparse grad of the rows of param");
+    rows = grad._indices()[0].contiguous();
+    values = grad._values().contiguous();
+  } else {
+    values = grad_.contiguous();
+  }
+  const int64_t* rows_data =
+      rows.defined() ? rows.data_ptr<int64_t>() : nullptr;
+
+  auto param_dtype = param_.scalar_type();
+  if (at::ScalarType::Float == param_dtype) {
+    rowwise_adagrad_fused_step_kernel<float>(
+        param,
+        rows_data,
+        values,
+        state_sum,
+        param2,
+        learning_rate,
+        weight_decay,
+        eps,
+        grad_scale,
+        stochastic_rounding);
+  } else if (at::ScalarType::Double == param_dtype) {
+    rowwise_adagrad_fused_step_kernel<double>(
+        param,
+        rows_data,
+        values,
+        state_sum,
+        param2,
+        learning_rate,
+        weight_decay,
+        eps,
+        grad_scale,
+        stochastic_rounding);
+  } else if (at::ScalarType::BFloat16 == param_dtype) {
+    rowwise_adagrad_fused_step_kernel<at::BFloat16>(
+        param,
+        rows_data,
+        values,
+        state_sum,
+        param2,
+        learning_rate,
+        weight_decay,
+        eps,
+        grad_scale,
+        stochastic_rounding);
+  } else {
+    TORCH_CHECK(false, "expect bfloat16 or float or double param");
+  }
+
+  if (!param_.is_contiguous()) {
+    param_.copy_(param);
+  }
+  if (!state_sum_.is_contiguous()) {
+    state_sum_.copy_(state_sum);
+  }
+  if (!param2_.is_contiguous()) {
+    param2_.copy_(param2);
+  }
+}
+
+} // namespace cpu
+} // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "rowwise_adagrad_fused_step(Tensor(a!) param, Tensor grad, Tensor(b!) "
+      "state_sum, Tensor(c!) trail, float lr, float weight_decay, float eps, "
+      "float grad_scale=1., bool stochastic_rounding=False) -> ()",
+      torch_ipex::cpu::rowwise_adagrad_fused_step);
+}
+
+} // namespace
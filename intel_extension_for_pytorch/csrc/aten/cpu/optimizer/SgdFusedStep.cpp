@@ -1,5 +1,7 @@
-#include "csrc/cpu/vec512/bf16/vec/vec_type_cvt.h"
+#include "bf16_param.h"
+#include "multi_tensor_apply.h"
 #include "optimizer.h"
+#include "csrc/utils/op_trace.h"
 
 #include <torch/csrc/autograd/function.h>
 #include <torch/extension.h>
@@ -19,7 +21,9 @@ void sgd_fused_step_kernel(
     double learning_rate,
     double weight_decay,
     double dampening,
-    bool nesterov) {
+    bool nesterov,
+    double grad_scale,
+    bool stochastic_rounding) {
   scalar_t* param_data = param.data_ptr<scalar_t>();
   scalar_t* grad_data = grad.data_ptr<scalar_t>();
   scalar_t* momentum_buf_data = momentum_buf.data_ptr<scalar_t>();
@@ -41,7 +45,7 @@ void sgd_fused_step_kernel(
         int64_t d = 0;
         for (; d < size - (size % Vec::size()); d += Vec::size()) {
           Vec param_vec = Vec::loadu(param_ptr + d);
-          Vec grad_vec = Vec::loadu(grad_ptr + d) +
+          Vec grad_vec = Vec::loadu(grad_ptr + d) * Vec(scalar_t(grad_scale)) +
               param_vec * Vec(scalar_t(weight_decay));
 
           if (momentum != 0) {
@@ -59,7 +63,8 @@ void sgd_fused_step_kernel(
           param_vec.store(param_ptr + d);
         }
         for (; d < size; d++) {
-          scalar_t grad_val = grad_ptr[d] + param_ptr[d] * weight_decay;
+          scalar_t grad_val =
+              grad_ptr[d] * grad_scale + param_ptr[d] * weight_decay;
           if (momentum != 0) {
             momentum_buf_ptr[d] =
                 momentum_buf_ptr[d] * momentum + grad_val * grad_decay;
@@ -84,7 +89,9 @@ void sgd_fused_step_kernel<at::BFloat16, at::BFloat16>(
     double learning_rate,
     double weight_decay,
     double dampening,
-    bool nesterov) {
+    bool nesterov,
+    double grad_scale,
+    bool stochastic_rounding) {
   TORCH_CHECK(
       param.scalar_type() == at::kBFloat16,
       "sgd_fused_step_kernel: expect param to be at::BFloat16");
@@ -95,13 +102,16 @@ void sgd_fused_step_kernel<at::BFloat16, at::BFloat16>(
       momentum_buf.scalar_type() == at::kFloat,
       "sgd_fused_step_kernel: expect stats_sum to be float32");
   TORCH_CHECK(
-      param2.scalar_type() == at::kBFloat16,
-      "sgd_fused_step_kernel: expect param2 to be at::BFloat16");
+      param2.numel() == 0 || param2.scalar_type() == at::kBFloat16,
+      "sgd_fused_step_kernel: expect param2 to be at::BFloat16 or empty");
 
   at::BFloat16* param_data = param.data_ptr<at::BFloat16>();
   at::BFloat16* grad_data = grad.data_ptr<at::BFloat16>();
   float* momentum_buf_data = momentum_buf.data_ptr<float>();
-  at::BFloat16* param2_data = param2.data_ptr<at::BFloat16>();
+  // no trail of the split master weight for the pure bf16 params
+  at::BFloat16* param2_data =
+      param2.numel() > 0 ? param2.data_ptr<at::BFloat16>() : nullptr;
+  uint64_t seed = stochastic_rounding ? bf16_rounding_seed() : 0;
 
   using bVec = at::vec::Vectorized<at::BFloat16>;
   using fVec = at::vec::Vectorized<float>;
@@ -112,27 +122,26 @@ void sgd_fused_step_kernel<at::BFloat16, at::BFloat16>(
   at::parallel_for(
       0, param.numel(), grain_size, [&](int64_t begin, int64_t end) {
         // local pointers
-        at::BFloat16* param_ptr = param_data + begin;
         at::BFloat16* grad_ptr = grad_data + begin;
         float* momentum_buf_ptr = momentum_buf_data + begin;
-        at::BFloat16* param2_ptr = param2_data + begin;
+        BFloat16ParamChunk params(
+            param_data, param2_data, stochastic_rounding, seed, begin);
 
         const int64_t size = end - begin;
         float grad_decay = 1 - dampening;
         int64_t d = 0;
         for (; d < size - (size % bVec::size()); d += bVec::size()) {
-          bVec param_bvec = bVec::loadu(param_ptr + d);
-          bVec param2_bvec = bVec::loadu(param2_ptr + d);
           fVec param_fvec, param_fvec2;
-          std::tie(param_fvec, param_fvec2) =
-              bf16::pack_bfloat16_float(param_bvec, param2_bvec);
+          std::tie(param_fvec, param_fvec2) = params.load(d);
 
           bVec grad_bvec = bVec::loadu(grad_ptr + d);
           fVec grad_fvec, grad_fvec2;
           std::tie(grad_fvec, grad_fvec2) = convert_bfloat16_float(grad_bvec);
 
-          grad_fvec = grad_fvec + param_fvec * fVec(float(weight_decay));
-          grad_fvec2 = grad_fvec2 + param_fvec2 * fVec(float(weight_decay));
+          grad_fvec = grad_fvec * fVec(float(grad_scale)) +
+              param_fvec * fVec(float(weight_decay));
+          grad_fvec2 = grad_fvec2 * fVec(float(grad_scale)) +
+              param_fvec2 * fVec(float(weight_decay));
 
           if (momentum != 0) {
             fVec momentum_vec =
@@ -156,15 +165,12 @@ void sgd_fused_step_kernel<at::BFloat16, at::BFloat16>(
           param_fvec -= grad_fvec * fVec(learning_rate);
           param_fvec2 -= grad_fvec2 * fVec(learning_rate);
 
-          std::tie(param_bvec, param2_bvec) =
-              bf16::unpack_float_bfloat16(param_fvec, param_fvec2);
-          param_bvec.store(param_ptr + d);
-          param2_bvec.store(param2_ptr + d);
+          params.store(d, param_fvec, param_fvec2);
         }
         for (; d < size; d++) {
-          float param_val =
-              bf16::pack_bfloat16_float(param_ptr[d], param2_ptr[d]);
-          float grad_val = float(grad_ptr[d]) + param_val * weight_decay;
+          float param_val = params.load_val(d);
+          float grad_val =
+              float(grad_ptr[d]) * grad_scale + param_val * weight_decay;
           if (momentum != 0) {
             momentum_buf_ptr[d] =
                 momentum_buf_ptr[d] * momentum + grad_val * grad_decay;
@@ -175,8 +181,7 @@ void sgd_fused_step_kernel<at::BFloat16, at::BFloat16>(
             }
           }
           param_val -= grad_val * learning_rate;
-          std::tie(param_ptr[d], param2_ptr[d]) =
-              bf16::unpack_float_bfloat16(param_val);
+          params.store_val(d, param_val);
         }
       });
 }
@@ -191,7 +196,9 @@ void sgd_fused_step_kernel<float, at::BFloat16>(
     double learning_rate,
     double weight_decay,
     double dampening,
-    bool nesterov) {
+    bool nesterov,
+    double grad_scale,
+    bool stochastic_rounding) {
   TORCH_CHECK(
       param.scalar_type() == at::kFloat,
       "sgd_fused_step_kernel: expect param to be at::kFloat");
@@ -234,8 +241,10 @@ void sgd_fused_step_kernel<float, at::BFloat16>(
           fVec grad_fvec, grad_fvec2;
           std::tie(grad_fvec, grad_fvec2) = convert_bfloat16_float(grad_bvec);
 
-          grad_fvec = grad_fvec + param_fvec * fVec(float(weight_decay));
-          grad_fvec2 = grad_fvec2 + param_fvec2 * fVec(float(weight_decay));
+          grad_fvec = grad_fvec * fVec(float(grad_scale)) +
+              param_fvec * fVec(float(weight_decay));
+          grad_fvec2 = grad_fvec2 * fVec(float(grad_scale)) +
+              param_fvec2 * fVec(float(weight_decay));
 
           if (momentum != 0) {
             fVec momentum_vec =
@@ -267,7 +276,8 @@ void sgd_fused_step_kernel<float, at::BFloat16>(
         }
         for (; d < size; d++) {
           float param_val = param_ptr[d];
-          float grad_val = float(grad_ptr[d]) + param_val * weight_decay;
+          float grad_val =
+              float(grad_ptr[d]) * grad_scale + param_val * weight_decay;
           if (momentum != 0) {
             momentum_buf_ptr[d] =
                 momentum_buf_ptr[d] * momentum + grad_val * grad_decay;
@@ -289,7 +299,8 @@ void sgd_fused_step_kernel<float, at::BFloat16>(
  * Support Double, Float, BFloat16 training
  *@param param_ Parameters to be update
  *@param grad_ Grad used to update Parameters
- *@param momentum_buf_ momentum to accelerate convergence
+ *@param momentum_buf_ momentum to accelerate convergence, in the layout of
+ *param_, e.g. the blocked layout of a packed weight, or empty if momentum is 0
  *@param param2_ Used for BF16 training, if param_ is float, param2_ is bf16
  *params need to be synced after update if param_ is BFloat16, param2_ is
  *params_ last 16 bit matissa to construct float params
@@ -298,6 +309,9 @@ void sgd_fused_step_kernel<float, at::BFloat16>(
  *@param weight_decay Args for regularization to avoid over-fit.
  *@param dampening Attribute for momentum.
  *@param nesterov Attribute for momentum.
+ *@param grad_scale The coefficient of grad_, e.g. to clip it by the norm.
+ *@param stochastic_rounding Round the pure BFloat16 params_ (without param2_)
+ *stochastically rather than to nearest after update.
  */
 void sgd_fused_step(
     at::Tensor& param_,
@@ -308,10 +322,11 @@ void sgd_fused_step(
     double learning_rate,
     double weight_decay,
     double dampening,
-    bool nesterov) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("torch_ipex::sgd_fused_step", std::vector<c10::IValue>({}));
-#endif
+    bool nesterov,
+    double grad_scale,
+    bool stochastic_rounding) {
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::sgd_fused_step", std::vector<c10::IValue>({}));
   TORCH_CHECK(
       learning_rate >= 0, "Expect learning rate >= 0.0, got ", learning_rate);
   TORCH_CHECK(
@@ -324,7 +339,8 @@ void sgd_fused_step(
       "; grad_ sizes: ",
       grad_.sizes());
   TORCH_CHECK(
-      param_.sizes() == momentum_buf_.sizes(),
+      (momentum == 0 && momentum_buf_.numel() == 0) ||
+          param_.sizes() == momentum_buf_.sizes(),
       "Expect param and momentum_buf have the same sizes, param sizes: ",
       param_.sizes(),
       "; momentum_buf sizes: ",
@@ -353,7 +369,9 @@ void sgd_fused_step(
         learning_rate,
         weight_decay,
         dampening,
-        nesterov);
+        nesterov,
+        grad_scale,
+        stochastic_rounding);
   } else if (at::ScalarType::Double == grad_dtype) {
     sgd_fused_step_kernel<double, double>(
         param,
@@ -364,7 +382,9 @@ void sgd_fused_step(
         learning_rate,
         weight_decay,
         dampening,
-        nesterov);
+        nesterov,
+        grad_scale,
+        stochastic_rounding);
   } else if (
       at::ScalarType::BFloat16 == grad_dtype &&
       at::ScalarType::BFloat16 == param_dtype) {
@@ -377,7 +397,9 @@ void sgd_fused_step(
         learning_rate,
         weight_decay,
         dampening,
-        nesterov);
+        nesterov,
+        grad_scale,
+        stochastic_rounding);
   } else if (
       at::ScalarType::BFloat16 == grad_dtype &&
       at::ScalarType::Float == param_dtype) {
@@ -390,7 +412,9 @@ void sgd_fused_step(
         learning_rate,
         weight_decay,
         dampening,
-        nesterov);
+        nesterov,
+        grad_scale,
+        stochastic_rounding);
   } else {
     TORCH_CHECK(false, "expect bfloat16 or float or double param");
   }
@@ -408,6 +432,53 @@ void sgd_fused_step(
   return;
 }
 
+/**
+ * SGD fused update of a list of params, e.g. of a param group, of which the
+ * small params are updated together in one parallel loop.
+ * The args are the same as sgd_fused_step, of a list for each tensor.
+ */
+void sgd_fused_step_list(
+    at::TensorList params,
+    at::TensorList grads,
+    at::TensorList momentum_bufs,
+    at::TensorList params2,
+    double momentum,
+    double learning_rate,
+    double weight_decay,
+    double dampening,
+    bool nesterov,
+    double grad_scale,
+    bool stochastic_rounding) {
+  IPEX_RECORD_FUNCTION(
+      "torch_ipex::sgd_fused_step_list", std::vector<c10::IValue>({}));
+  TORCH_CHECK(
+      grads.size() == params.size() && momentum_bufs.size() == params.size() &&
+          params2.size() == params.size(),
+      "Expect the same number of params, grads, momentum_bufs and params2");
+
+  std::vector<int64_t> numels;
+  for (const auto& param : params) {
+    numels.push_back(param.numel());
+  }
+  multi_tensor_apply(numels, [&](int64_t i) {
+    auto param = params[i];
+    auto momentum_buf = momentum_bufs[i];
+    auto param2 = params2[i];
+    sgd_fused_step(
+        param,
+        grads[i],
+        momentum_buf,
+        param2,
+        momentum,
+        learning_rate,
+        weight_decay,
+        dampening,
+        nesterov,
+        grad_scale,
+        stochastic_rounding);
+  });
+}
+
 } // namespace cpu
 } // namespace torch_ipex
 
@@ -417,8 +488,15 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
   m.def(
       "sgd_fused_step(Tensor param, Tensor grad, Tensor momentum_buf, Tensor "
       "trail, float momentum, float learning_rate, float weight_decay, float "
-      "dampening, bool nesterov) -> ()",
+      "dampening, bool nesterov, float grad_scale=1., bool "
+      "stochastic_rounding=False) -> ()",
       torch_ipex::cpu::sgd_fused_step);
+  m.def(
+      "sgd_fused_step_list(Tensor(a!)[] params, Tensor[] grads, Tensor(b!)[] "
+      "momentum_bufs, Tensor(c!)[] trails, float momentum, float "
+      "learning_rate, float weight_decay, float dampening, bool nesterov, "
+      "float grad_scale=1., bool stochastic_rounding=False) -> ()",
+      torch_ipex::cpu::sgd_fused_step_list);
 }
 
 } // namespace
@@ -1,5 +1,6 @@
 #include "csrc/cpu/vec512/bf16/vec/bf16_vec_kernel.h"
 #include "optimizer.h"
+#include "csrc/utils/op_trace.h"
 
 #include <torch/csrc/autograd/function.h>
 #include <torch/extension.h>
@@ -24,9 +25,7 @@ void packed_add(
   at::Tensor bot_half = bot_half_.contiguous();
   at::Tensor grad = grad_.is_sparse() ? grad_ : grad_.contiguous();
 
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("packed_add", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("packed_add", std::vector<c10::IValue>({}));
 
   float alpha_ = static_cast<float>(alpha);
   if (grad.is_sparse()) {
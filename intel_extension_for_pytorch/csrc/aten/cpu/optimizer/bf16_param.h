@@ -0,0 +1,133 @@
+#pragma once
+
+#include <ATen/CPUGeneratorImpl.h>
+#include "csrc/cpu/vec512/bf16/vec/vec_type_cvt.h"
+
+#include <cstring>
+#include <mutex>
+
+namespace torch_ipex {
+namespace cpu {
+
+// The seed of the stochastic rounding of a fused step, drawn from the default
+// CPU generator, so that torch.manual_seed reproduces the rounding.
+inline uint64_t bf16_rounding_seed() {
+  auto gen = at::get_generator_or_default<at::CPUGeneratorImpl>(
+      c10::nullopt, at::detail::getDefaultCPUGenerator());
+  std::lock_guard<std::mutex> lock(gen->mutex_);
+  return gen->random64();
+}
+
+// The bf16 params of a chunk of the elements of a fused step, read as float
+// and written back after the update.
+// With the trail of the split master weight, the float param is the bf16
+// param of its top half and the trail of its low half. Without the trail,
+// i.e. of the pure bf16 params, the float param is the bf16 param, and the
+// updated param is rounded to the nearest bf16, or stochastically, i.e. up
+// with the probability of the low half dropped, so that the updates smaller
+// than the ulp of bf16 are not lost in expectation. The random bits are of a
+// xorshift generator of each lane, seeded by the seed of the step and the
+// beginning of the chunk.
+class BFloat16ParamChunk {
+ public:
+  using bVec = at::vec::Vectorized<at::BFloat16>;
+  using fVec = at::vec::Vectorized<float>;
+
+  BFloat16ParamChunk(
+      at::BFloat16* param,
+      at::BFloat16* trail,
+      bool stochastic,
+      uint64_t seed,
+      int64_t begin)
+      : param_(param + begin),
+        trail_(trail == nullptr ? nullptr : trail + begin),
+        stochastic_(stochastic) {
+    uint32_t lanes[fVec::size()];
+    uint64_t x = seed + uint64_t(begin) * 0x9E3779B97F4A7C15ULL;
+    for (int64_t i = 0; i < fVec::size(); i++) {
+      // splitmix64 of the seed and the chunk, nonzero for xorshift
+      x += 0x9E3779B97F4A7C15ULL;
+      uint64_t z = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+      lanes[i] = uint32_t(z ^ (z >> 31)) | 1;
+    }
+    state_ = _mm256_loadu_si256(reinterpret_cast<__m256i*>(lanes));
+    state_val_ = lanes[0];
+  }
+
+  std::tuple<fVec, fVec> load(int64_t d) const {
+    bVec param_bvec = bVec::loadu(param_ + d);
+    if (trail_ == nullptr) {
+      return convert_bfloat16_float(param_bvec);
+    }
+    return bf16::pack_bfloat16_float(param_bvec, bVec::loadu(trail_ + d));
+  }
+
+  float load_val(int64_t d) const {
+    if (trail_ == nullptr) {
+      return float(param_[d]);
+    }
+    return bf16::pack_bfloat16_float(param_[d], trail_[d]);
+  }
+
+  void store(int64_t d, const fVec& a, const fVec& b) {
+    if (trail_ != nullptr) {
+      bVec param_bvec, trail_bvec;
+      std::tie(param_bvec, trail_bvec) = bf16::unpack_float_bfloat16(a, b);
+      param_bvec.store(param_ + d);
+      trail_bvec.store(trail_ + d);
+    } else if (stochastic_) {
+      __m256i x0 = round_stochastic(_mm256_castps_si256(__m256(a)));
+      __m256i x1 = round_stochastic(_mm256_castps_si256(__m256(b)));
+      __m256i y = _mm256_packus_epi32(x0, x1);
+      bVec(_mm256_permute4x64_epi64(y, 0xd8)).store(param_ + d);
+    } else {
+      convert_float_bfloat16(a, b).store(param_ + d);
+    }
+  }
+
+  void store_val(int64_t d, float val) {
+    if (trail_ != nullptr) {
+      std::tie(param_[d], trail_[d]) = bf16::unpack_float_bfloat16(val);
+    } else if (stochastic_) {
+      uint32_t bits;
+      std::memcpy(&bits, &val, sizeof(bits));
+      state_val_ ^= state_val_ << 13;
+      state_val_ ^= state_val_ >> 17;
+      state_val_ ^= state_val_ << 5;
+      // keep inf and nan
+      if ((bits & 0x7f800000) != 0x7f800000) {
+        bits += state_val_ >> 16;
+      }
+      param_[d] =
+          at::BFloat16(uint16_t(bits >> 16), at::BFloat16::from_bits());
+    } else {
+      param_[d] = at::BFloat16(val);
+    }
+  }
+
+ private:
+  // Add the random low 16 bits to the float bits, and return the top half
+  // in the low half of each lane.
+  __m256i round_stochastic(__m256i x) {
+    state_ = _mm256_xor_si256(state_, _mm256_slli_epi32(state_, 13));
+    state_ = _mm256_xor_si256(state_, _mm256_srli_epi32(state_, 17));
+    state_ = _mm256_xor_si256(state_, _mm256_slli_epi32(state_, 5));
+    const __m256i exp_mask = _mm256_set1_epi32(0x7f800000);
+    // keep inf and nan
+    __m256i non_finite =
+        _mm256_cmpeq_epi32(_mm256_and_si256(x, exp_mask), exp_mask);
+    __m256i noise =
+        _mm256_andnot_si256(non_finite, _mm256_srli_epi32(state_, 16));
+    return _mm256_srli_epi32(_mm256_add_epi32(x, noise), 16);
+  }
+
+  at::BFloat16* param_;
+  at::BFloat16* trail_;
+  bool stochastic_;
+  __m256i state_;
+  uint32_t state_val_;
+};
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <ATen/Parallel.h>
+
+#include <vector>
+
+namespace torch_ipex {
+namespace cpu {
+
+// The elements of a chunk of the small tensors of a multi tensor step, about
+// enough work to amortize the fork/join of a parallel loop.
+const int64_t MULTI_TENSOR_CHUNK_NUMEL = 65536;
+
+// Apply fn(i) to each tensor i of the numels of a list of tensors, e.g. the
+// fused step of each param of a param group. A tensor of at least a chunk of
+// elements is applied alone, so that fn parallelizes over its elements as
+// usual. The other tensors, e.g. the biases and the norm weights, are packed
+// in order into the chunks of about the same elements, and all the chunks
+// run in one parallel loop, in which the parallel loops of fn run inline on
+// the thread of the chunk.
+template <typename F>
+void multi_tensor_apply(const std::vector<int64_t>& numels, const F& fn) {
+  std::vector<int64_t> small;
+  std::vector<int64_t> chunk_begins = {0};
+  int64_t chunk_numel = 0;
+  for (int64_t i = 0; i < numels.size(); i++) {
+    if (numels[i] >= MULTI_TENSOR_CHUNK_NUMEL) {
+      fn(i);
+      continue;
+    }
+    small.push_back(i);
+    chunk_numel += numels[i];
+    if (chunk_numel >= MULTI_TENSOR_CHUNK_NUMEL) {
+      chunk_begins.push_back(small.size());
+      chunk_numel = 0;
+    }
+  }
+  if (chunk_begins.back() < small.size()) {
+    chunk_begins.push_back(small.size());
+  }
+
+  int64_t n_chunks = chunk_begins.size() - 1;
+  at::parallel_for(0, n_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; c++) {
+      for (int64_t s = chunk_begins[c]; s < chunk_begins[c + 1]; s++) {
+        fn(small[s]);
+      }
+    }
+  });
+}
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -14,7 +14,57 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> lamb_fused_step(
     double beta2,
     double learning_rate,
     double weight_decay,
-    double eps);
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding);
+void lamb_fused_step_list(
+    at::TensorList params,
+    at::TensorList exp_avgs,
+    at::TensorList exp_avg_sqs,
+    at::TensorList grads,
+    at::TensorList params2,
+    at::IntArrayRef steps,
+    double beta1,
+    double beta2,
+    double learning_rate,
+    double weight_decay,
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding);
+std::tuple<at::Tensor, at::Tensor, at::Tensor> adam_fused_step(
+    const at::Tensor& param_,
+    const at::Tensor& exp_avg_,
+    const at::Tensor& exp_avg_sq_,
+    const at::Tensor& max_exp_avg_sq_,
+    const at::Tensor& grad_,
+    const at::Tensor& param2_,
+    int64_t step,
+    bool amsgrad,
+    bool adamw,
+    double beta1,
+    double beta2,
+    double learning_rate,
+    double weight_decay,
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding);
+void adam_fused_step_list(
+    at::TensorList params,
+    at::TensorList exp_avgs,
+    at::TensorList exp_avg_sqs,
+    at::TensorList max_exp_avg_sqs,
+    at::TensorList grads,
+    at::TensorList params2,
+    at::IntArrayRef steps,
+    bool amsgrad,
+    bool adamw,
+    double beta1,
+    double beta2,
+    double learning_rate,
+    double weight_decay,
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding);
 std::tuple<at::Tensor, at::Tensor> adagrad_fused_step(
     const at::Tensor& param_,
     const at::Tensor& grad_,
@@ -24,7 +74,31 @@ std::tuple<at::Tensor, at::Tensor> adagrad_fused_step(
     double learning_rate,
     double weight_decay,
     double lr_decay,
-    double eps);
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding);
+void adagrad_fused_step_list(
+    at::TensorList params,
+    at::TensorList grads,
+    at::TensorList state_sums,
+    at::TensorList params2,
+    at::IntArrayRef steps,
+    double learning_rate,
+    double weight_decay,
+    double lr_decay,
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding);
+void rowwise_adagrad_fused_step(
+    const at::Tensor& param_,
+    const at::Tensor& grad_,
+    const at::Tensor& state_sum_,
+    const at::Tensor& param2_,
+    double learning_rate,
+    double weight_decay,
+    double eps,
+    double grad_scale,
+    bool stochastic_rounding);
 void packed_add(
     at::Tensor& top_half,
     at::Tensor& bot_half,
@@ -39,7 +113,23 @@ void sgd_fused_step(
     double learning_rate,
     double weight_decay,
     double dampening,
-    bool nesterov);
+    bool nesterov,
+    double grad_scale,
+    bool stochastic_rounding);
+void sgd_fused_step_list(
+    at::TensorList params,
+    at::TensorList grads,
+    at::TensorList momentum_bufs,
+    at::TensorList params2,
+    double momentum,
+    double learning_rate,
+    double weight_decay,
+    double dampening,
+    bool nesterov,
+    double grad_scale,
+    bool stochastic_rounding);
+double grad_norm_list(at::TensorList grads);
+void grad_accumulate_(const at::Tensor& acc, const at::Tensor& grad_);
 
 } // namespace cpu
 } // namespace torch_ipex
@@ -1,5 +1,10 @@
 #include "csr2csc.h"
 #include "radix_sort.h"
+#include "csrc/utils/op_trace.h"
+
+#include <ATen/Parallel.h>
+#include <algorithm>
+#include <numeric>
 
 namespace torch_ipex {
 namespace cpu {
@@ -10,9 +15,7 @@ void sort_based_batched_csr2csc_opt(
     const Tensor& indices,
     std::vector<int64_t> pooling_modes,
     int64_t max_embeddings) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(__FUNCTION__, std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION(__FUNCTION__, std::vector<c10::IValue>({}));
   Allocator* allocator = c10::GetAllocator(c10::DeviceType::CPU);
   TensorAccessor<int64_t, 1> offsets_data = offsets.accessor<int64_t, 1>();
   TensorAccessor<int64_t, 1> batched_csr_indices =
@@ -31,6 +34,10 @@ void sort_based_batched_csr2csc_opt(
 
   auto get_table_id = [&](int n) { return n / B; };
 
+  if (n_indices == 0) {
+    return;
+  }
+
   Key_Value_Weight_Tuple<int>* tmpBuf =
       (Key_Value_Weight_Tuple<int>*)allocator->raw_allocate(
           (n_indices) * sizeof(Key_Value_Weight_Tuple<int>));
@@ -57,7 +64,12 @@ void sort_based_batched_csr2csc_opt(
       radix_sort_parallel<int>(
           &tmpBuf[0], &tmpBuf1[0], n_indices, max_embeddings);
   int max_thds = omp_get_max_threads();
+  // the unique indices counted by each thread, padded to separate cache
+  // lines; the team may have fewer threads than max_thds
   int num_uniq[max_thds][64];
+  for (int i = 0; i < max_thds; i++) {
+    num_uniq[i][0] = 0;
+  }
 
 #pragma omp parallel
   {
@@ -75,7 +87,9 @@ void sort_based_batched_csr2csc_opt(
     num_uniq[i][0] += num_uniq[i - 1][0];
   int U = num_uniq[max_thds - 1][0];
 
-  batched_csc.segment_ptr = (int*)allocator->raw_allocate(U * sizeof(int));
+  // with the end of the last segment
+  batched_csc.segment_ptr =
+      (int*)allocator->raw_allocate((U + 1) * sizeof(int));
   batched_csc.segment_indices = (int*)allocator->raw_allocate(U * sizeof(int));
   batched_csc.output_row_indices =
       (int*)allocator->raw_allocate(n_indices * sizeof(int));
@@ -119,5 +133,76 @@ void sort_based_batched_csr2csc_opt(
   allocator->raw_deallocate(tmpBuf1);
 }
 
+Tensor sort_based_unique_keys(
+    const Tensor& indices,
+    const Tensor& offsets,
+    int B,
+    const std::vector<int64_t>& keys_begin,
+    int64_t max_keys,
+    Tensor& inverse) {
+  IPEX_RECORD_FUNCTION(__FUNCTION__, std::vector<c10::IValue>({}));
+  int64_t n_indices = indices.numel();
+  inverse = at::empty({n_indices}, indices.options());
+  if (n_indices == 0) {
+    return at::empty({0}, indices.options());
+  }
+  Allocator* allocator = c10::GetAllocator(c10::DeviceType::CPU);
+  const int64_t* indices_data = indices.data_ptr<int64_t>();
+  const int64_t* offsets_data = offsets.data_ptr<int64_t>();
+  int64_t* inverse_data = inverse.data_ptr<int64_t>();
+  int64_t n_offsets = offsets.numel() - 1;
+
+  Key_Value_Weight_Tuple<int>* tmpBuf =
+      (Key_Value_Weight_Tuple<int>*)allocator->raw_allocate(
+          (n_indices) * sizeof(Key_Value_Weight_Tuple<int>));
+  Key_Value_Weight_Tuple<int>* tmpBuf1 =
+      (Key_Value_Weight_Tuple<int>*)allocator->raw_allocate(
+          (n_indices) * sizeof(Key_Value_Weight_Tuple<int>));
+#pragma omp parallel for
+  for (int n = 0; n < n_offsets; ++n) {
+    int64_t key_begin = keys_begin[n / B];
+    for (int64_t p = offsets_data[n]; p < offsets_data[n + 1]; ++p) {
+      std::get<0>(tmpBuf[p]) = key_begin + indices_data[p];
+      std::get<1>(tmpBuf[p]) = p;
+      std::get<2>(tmpBuf[p]) = 1;
+    }
+  }
+  Key_Value_Weight_Tuple<int>* sorted =
+      radix_sort_parallel<int>(&tmpBuf[0], &tmpBuf1[0], n_indices, max_keys);
+
+  // count the unique keys of each chunk of the sorted keys, then write them
+  // from the prefix sums of the counts
+  int64_t n_chunks = std::min<int64_t>(at::get_num_threads(), n_indices);
+  auto chunk_begin = [&](int64_t c) { return n_indices * c / n_chunks; };
+  auto is_new_key = [&](int64_t i) {
+    return i == 0 || std::get<0>(sorted[i]) != std::get<0>(sorted[i - 1]);
+  };
+  std::vector<int64_t> num_uniq(n_chunks + 1, 0);
+  at::parallel_for(0, n_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; ++c) {
+      for (int64_t i = chunk_begin(c); i < chunk_begin(c + 1); ++i) {
+        num_uniq[c + 1] += is_new_key(i);
+      }
+    }
+  });
+  std::partial_sum(num_uniq.begin(), num_uniq.end(), num_uniq.begin());
+  auto unique_keys = at::empty({num_uniq[n_chunks]}, indices.options());
+  int64_t* unique_keys_data = unique_keys.data_ptr<int64_t>();
+  at::parallel_for(0, n_chunks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t c = begin; c < end; ++c) {
+      int64_t u = num_uniq[c] - 1;
+      for (int64_t i = chunk_begin(c); i < chunk_begin(c + 1); ++i) {
+        if (is_new_key(i)) {
+          unique_keys_data[++u] = std::get<0>(sorted[i]);
+        }
+        inverse_data[std::get<1>(sorted[i])] = u;
+      }
+    }
+  });
+  allocator->raw_deallocate(tmpBuf);
+  allocator->raw_deallocate(tmpBuf1);
+  return unique_keys;
+}
+
 } // namespace cpu
 } // namespace torch_ipex
@@ -76,5 +76,17 @@ void sort_based_batched_csr2csc_opt(
     std::vector<int64_t> pooling_modes,
     int64_t max_embeddings);
 
+// Sort the keys of the indices of the T x B bags, i.e. keys_begin[t] +
+// indices[p] for the index p of the table t, where max_keys is the number of
+// the keys. Return the unique keys in the ascending order, and write the id of
+// the unique key of each index to inverse.
+Tensor sort_based_unique_keys(
+    const Tensor& indices,
+    const Tensor& offsets,
+    int B,
+    const std::vector<int64_t>& keys_begin,
+    int64_t max_keys,
+    Tensor& inverse);
+
 } // namespace cpu
 } // namespace torch_ipex
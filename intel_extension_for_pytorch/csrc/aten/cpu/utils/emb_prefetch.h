@@ -0,0 +1,54 @@
+#pragma once
+
+#include <immintrin.h>
+#include <algorithm>
+#include <cstdint>
+
+#include "csrc/cpu/isa/cpu_info.hpp"
+
+namespace torch_ipex {
+namespace cpu {
+
+const int64_t EMB_CACHE_LINE_SIZE = 64;
+
+// How many indices ahead the embedding row gathers prefetch. A short row is
+// summed quickly, so more of them must be in flight to hide the DRAM
+// latency, while a long row takes several of the lines in flight alone. The
+// lines in flight, i.e. the misses a core can track before the prefetches
+// are dropped, are of the tuning of the CPU.
+inline int64_t emb_prefetch_distance(int64_t row_bytes) {
+  const auto& tuning = cpu_tuning();
+  auto lines = (row_bytes + EMB_CACHE_LINE_SIZE - 1) / EMB_CACHE_LINE_SIZE;
+  auto distance = tuning.emb_prefetch_lines / std::max<int64_t>(lines, 1);
+  return std::min<int64_t>(
+      std::max<int64_t>(distance, 2), tuning.emb_max_prefetch_distance);
+}
+
+inline void emb_prefetch_lines(const void* row, int64_t row_bytes) {
+  auto lines = reinterpret_cast<const char*>(row);
+  for (int64_t line = 0; line < row_bytes; line += EMB_CACHE_LINE_SIZE) {
+    _mm_prefetch(lines + line, _MM_HINT_T0);
+  }
+}
+
+// Prefetch the row of the weight at indices[p + distance] if it is before
+// prefetch_end, the end of the indices gathered by the current thread.
+template <typename T>
+inline void emb_prefetch_row(
+    const T* weight,
+    const int64_t* indices,
+    int64_t p,
+    int64_t prefetch_end,
+    int64_t vector_size,
+    int64_t distance) {
+  auto ahead = p + distance;
+  if (ahead >= prefetch_end) {
+    return;
+  }
+  emb_prefetch_lines(
+      &weight[indices[ahead] * vector_size],
+      vector_size * static_cast<int64_t>(sizeof(T)));
+}
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <ATen/cpu/vec/vec.h>
+
+#include <array>
+#include <numeric>
+#include <tuple>
+
+namespace torch_ipex {
+namespace cpu {
+
+// The rows of the float and the bfloat16 kernels computed in float are
+// processed by 2 float vectors, i.e. a bfloat16 one, at a time.
+using fVec = at::vec::Vectorized<float>;
+using bVec = at::vec::Vectorized<at::BFloat16>;
+constexpr int64_t kFloatVecPairSize = 2 * fVec::size();
+
+inline void load_fvec(const float* p, fVec& a, fVec& b) {
+  a = fVec::loadu(p);
+  b = fVec::loadu(p + fVec::size());
+}
+
+inline void load_fvec(const at::BFloat16* p, fVec& a, fVec& b) {
+  std::tie(a, b) = convert_bfloat16_float(bVec::loadu(p));
+}
+
+inline void store_fvec(float* p, const fVec& a, const fVec& b) {
+  a.store(p);
+  b.store(p + fVec::size());
+}
+
+inline void store_fvec(at::BFloat16* p, const fVec& a, const fVec& b) {
+  convert_float_bfloat16(a, b).store(p);
+}
+
+inline float sum_fvec(const fVec& v) {
+  std::array<float, fVec::size()> arr;
+  v.store(arr.data());
+  return std::accumulate(arr.cbegin(), arr.cend(), 0.f);
+}
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,87 @@
+#include "op_thread_policy.h"
+#include "csrc/cpu/isa/cpu_info.hpp"
+
+#include <algorithm>
+#include <atomic>
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+const char* thread_policy_op_names[] = {
+    "layer_norm",
+    "softmax",
+    "embedding_bag",
+};
+
+// The defaults keep half of L1d of fp32 data per thread, i.e. 4096 elements
+// of the 32 KB L1d.
+std::atomic<int64_t>* op_min_work_per_thread() {
+  static const int64_t min_work = cpu_tuning().op_min_work_per_thread;
+  static std::atomic<int64_t> min_work_per_thread[] = {
+      {min_work}, {min_work}, {min_work}};
+  return min_work_per_thread;
+}
+
+static_assert(
+    sizeof(thread_policy_op_names) / sizeof(thread_policy_op_names[0]) ==
+        static_cast<size_t>(ThreadPolicyOp::NumOps),
+    "Every ThreadPolicyOp must have a name");
+
+} // namespace
+
+void set_op_min_work_per_thread(
+    ThreadPolicyOp op,
+    int64_t min_work_per_thread) {
+  op_min_work_per_thread()[static_cast<int32_t>(op)] = min_work_per_thread;
+}
+
+int64_t get_op_min_work_per_thread(ThreadPolicyOp op) {
+  return op_min_work_per_thread()[static_cast<int32_t>(op)].load(
+      std::memory_order_relaxed);
+}
+
+ThreadPolicyOp get_thread_policy_op(const std::string& op_name) {
+  for (int32_t i = 0; i < static_cast<int32_t>(ThreadPolicyOp::NumOps); i++) {
+    if (op_name == thread_policy_op_names[i]) {
+      return static_cast<ThreadPolicyOp>(i);
+    }
+  }
+  return ThreadPolicyOp::NumOps;
+}
+
+int32_t get_op_num_threads(ThreadPolicyOp op, int64_t work) {
+  int32_t max_threads = omp_get_max_threads();
+  int64_t min_work_per_thread = get_op_min_work_per_thread(op);
+  if (min_work_per_thread <= 0) {
+    return max_threads;
+  }
+  int64_t num_threads = (work + min_work_per_thread - 1) / min_work_per_thread;
+  return static_cast<int32_t>(
+      std::max<int64_t>(1, std::min<int64_t>(num_threads, max_threads)));
+}
+
+OpThreadGuard::OpThreadGuard(ThreadPolicyOp op, int64_t work) {
+  // Don't touch the thread count of the nested parallel region.
+  if (omp_in_parallel()) {
+    return;
+  }
+  int32_t max_threads = omp_get_max_threads();
+  int32_t num_threads = get_op_num_threads(op, work);
+  if (num_threads < max_threads) {
+    // IOMP keeps the threads of the hot team, so shrinking and restoring the
+    // team doesn't re-create the threads.
+    omp_set_num_threads(num_threads);
+    this->previous_num_threads = max_threads;
+  }
+}
+
+OpThreadGuard::~OpThreadGuard() {
+  if (this->previous_num_threads > 0) {
+    omp_set_num_threads(this->previous_num_threads);
+  }
+}
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <omp.h>
+#include <cstdint>
+#include <string>
+
+namespace torch_ipex {
+namespace cpu {
+
+// The ops whose intra-op thread count is adapted to the size of their work.
+enum class ThreadPolicyOp : int32_t {
+  LayerNorm = 0,
+  Softmax,
+  EmbeddingBag,
+  NumOps,
+};
+
+// Cost model of the thread count: each thread should get at least
+// min_work_per_thread elements, so a tiny op doesn't pay the fork/join of all
+// the OMP threads. min_work_per_thread <= 0 disables the policy of the op.
+void set_op_min_work_per_thread(ThreadPolicyOp op, int64_t min_work_per_thread);
+int64_t get_op_min_work_per_thread(ThreadPolicyOp op);
+// Return the ThreadPolicyOp::NumOps if op_name is not a known op.
+ThreadPolicyOp get_thread_policy_op(const std::string& op_name);
+int32_t get_op_num_threads(ThreadPolicyOp op, int64_t work);
+
+/*OpThreadGuard limits the OMP threads of the current thread according to the
+ * work of the op during its scope, and restores the thread count on exit. The
+ * OMP parallel regions inside the scope (oneDNN primitives and
+ * at::parallel_for) then use only the needed threads.*/
+class OpThreadGuard {
+ public:
+  OpThreadGuard(ThreadPolicyOp op, int64_t work);
+  ~OpThreadGuard();
+
+ private:
+  // 0 means the thread count is not changed.
+  int32_t previous_num_threads{0};
+
+  OpThreadGuard(const OpThreadGuard& op_thread_guard) = delete;
+  OpThreadGuard& operator=(const OpThreadGuard& op_thread_guard) = delete;
+};
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include <cstdint>
+
+// The counter-based Philox4x32-10 of Salmon et al., "Parallel random numbers:
+// as easy as 1, 2, 3", of which the random bits of an element are a function
+// of the key, i.e. the seed of the op, and of the index of the element only.
+// The elements are generated in any order and by any thread, e.g. by the
+// chunks of the threads of a parallel_for, and give the same bits again in
+// the backward.
+//
+// The elements are generated by the blocks of 64, of which the 16 counters
+// are run in the 16 lanes of the uint32 vectors on AVX-512, each counter of 4
+// uint32 outputs: the element 16 * j + lane of the block is of the output j
+// of the counter of the lane.
+
+namespace torch_ipex {
+namespace cpu {
+namespace philox {
+
+constexpr int64_t kBlockSize = 64;
+constexpr int kLanes = 16;
+constexpr int kRounds = 10;
+constexpr uint32_t kMul0 = 0xD2511F53;
+constexpr uint32_t kMul1 = 0xCD9E8D57;
+constexpr uint32_t kWeyl0 = 0x9E3779B9;
+constexpr uint32_t kWeyl1 = 0xBB67AE85;
+
+// The uint32 threshold of the elements of the probability prob, of which an
+// output below it is taken.
+inline uint32_t threshold_of(double prob) {
+  double threshold = prob * 4294967296.0;
+  return threshold >= 4294967295.0 ? 4294967295u
+                                   : static_cast<uint32_t>(threshold);
+}
+
+#if defined(__AVX512F__)
+// the low halves of a * mul of the 16 lanes, and the high ones in hi
+inline __m512i mulhilo(__m512i a, __m512i mul, __m512i& hi) {
+  __m512i even = _mm512_mul_epu32(a, mul);
+  __m512i odd = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), mul);
+  hi = _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(even, 32), odd);
+  return _mm512_mask_blend_epi32(0xAAAA, even, _mm512_slli_epi64(odd, 32));
+}
+
+// The bit i of the 64 elements of the block is whether its output is below
+// threshold.
+inline uint64_t block_bits(uint64_t key, int64_t block, uint32_t threshold) {
+  const uint64_t base = static_cast<uint64_t>(block) * kLanes;
+  // base is of a multiple of 16, the low halves of the lanes don't carry
+  __m512i c0 = _mm512_add_epi32(
+      _mm512_set1_epi32(static_cast<int>(base)),
+      _mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+  __m512i c1 = _mm512_set1_epi32(static_cast<int>(base >> 32));
+  __m512i c2 = _mm512_setzero_si512();
+  __m512i c3 = _mm512_setzero_si512();
+  const __m512i mul0 = _mm512_set1_epi32(static_cast<int>(kMul0));
+  const __m512i mul1 = _mm512_set1_epi32(static_cast<int>(kMul1));
+  uint32_t k0 = static_cast<uint32_t>(key);
+  uint32_t k1 = static_cast<uint32_t>(key >> 32);
+  for (int r = 0; r < kRounds; r++) {
+    __m512i hi0, hi1;
+    __m512i lo0 = mulhilo(c0, mul0, hi0);
+    __m512i lo1 = mulhilo(c2, mul1, hi1);
+    c0 = _mm512_xor_si512(
+        _mm512_xor_si512(hi1, c1), _mm512_set1_epi32(static_cast<int>(k0)));
+    c2 = _mm512_xor_si512(
+        _mm512_xor_si512(hi0, c3), _mm512_set1_epi32(static_cast<int>(k1)));
+    c1 = lo1;
+    c3 = lo0;
+    k0 += kWeyl0;
+    k1 += kWeyl1;
+  }
+  const __m512i thr = _mm512_set1_epi32(static_cast<int>(threshold));
+  return static_cast<uint64_t>(_mm512_cmplt_epu32_mask(c0, thr)) |
+      static_cast<uint64_t>(_mm512_cmplt_epu32_mask(c1, thr)) << 16 |
+      static_cast<uint64_t>(_mm512_cmplt_epu32_mask(c2, thr)) << 32 |
+      static_cast<uint64_t>(_mm512_cmplt_epu32_mask(c3, thr)) << 48;
+}
+#else
+// The same bits of the scalar counters, of which the loop of the lanes is
+// left to the vectorizer of the level, e.g. AVX2.
+inline uint64_t block_bits(uint64_t key, int64_t block, uint32_t threshold) {
+  const uint64_t base = static_cast<uint64_t>(block) * kLanes;
+  uint32_t out[4][kLanes];
+  for (int lane = 0; lane < kLanes; lane++) {
+    uint32_t c0 = static_cast<uint32_t>(base + lane);
+    uint32_t c1 = static_cast<uint32_t>((base + lane) >> 32);
+    uint32_t c2 = 0;
+    uint32_t c3 = 0;
+    uint32_t k0 = static_cast<uint32_t>(key);
+    uint32_t k1 = static_cast<uint32_t>(key >> 32);
+    for (int r = 0; r < kRounds; r++) {
+      uint64_t p0 = static_cast<uint64_t>(kMul0) * c0;
+      uint64_t p1 = static_cast<uint64_t>(kMul1) * c2;
+      c0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+      c2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+      c1 = static_cast<uint32_t>(p1);
+      c3 = static_cast<uint32_t>(p0);
+      k0 += kWeyl0;
+      k1 += kWeyl1;
+    }
+    out[0][lane] = c0;
+    out[1][lane] = c1;
+    out[2][lane] = c2;
+    out[3][lane] = c3;
+  }
+  uint64_t bits = 0;
+  for (int j = 0; j < 4; j++) {
+    for (int lane = 0; lane < kLanes; lane++) {
+      bits |= static_cast<uint64_t>(out[j][lane] < threshold)
+          << (j * kLanes + lane);
+    }
+  }
+  return bits;
+}
+#endif
+
+} // namespace philox
+} // namespace cpu
+} // namespace torch_ipex
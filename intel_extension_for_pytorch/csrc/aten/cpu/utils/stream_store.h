@@ -0,0 +1,43 @@
+#pragma once
+
+#include <immintrin.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "csrc/cpu/isa/cpu_info.hpp"
+
+namespace torch_ipex {
+namespace cpu {
+
+// Whether the kernels write the output of the bytes by the non-temporal
+// stores, i.e. the output is beyond half of the LLC, of which the lines would
+// be evicted before the next op reads them and would evict the cached inputs
+// by the way. The threshold is of the tuning of the CPU.
+//
+// The non-temporal stores are weakly ordered, of which the writer fences them
+// by _mm_sfence before the output is read by the other threads, i.e. at the
+// end of each chunk of the parallel loop.
+inline bool use_stream_store(int64_t bytes) {
+  static const int64_t min_bytes = cpu_tuning().stream_store_min_bytes;
+  return bytes >= min_bytes;
+}
+
+// copies n bytes with the non-temporal stores of the 16 bytes aligned part of
+// dst, i.e. without reading the lines of dst into the cache first and without
+// evicting the cached inputs by them
+inline void stream_copy(char* dst, const char* src, int64_t n) {
+  int64_t head = std::min<int64_t>(
+      n, (16 - reinterpret_cast<uintptr_t>(dst) % 16) % 16);
+  std::memcpy(dst, src, head);
+  int64_t i = head;
+  for (; i + 16 <= n; i += 16) {
+    _mm_stream_si128(
+        reinterpret_cast<__m128i*>(dst + i),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+  }
+  std::memcpy(dst + i, src + i, n - i);
+}
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,456 @@
+#pragma once
+
+#include <immintrin.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#include "float_vec.h"
+
+// The vectorized transcendental functions of the hand-written kernels, i.e.
+// exp, log, tanh, erf and the sigmoid, gelu and silu of them, of one
+// implementation and of an accuracy chosen per call:
+//   Accuracy::Accurate  ~3e-7 relative of exp, log and tanh and ~6e-7 of
+//                       erf, for the float outputs
+//   Accuracy::Fast      ~1.5e-4 relative, i.e. well below the rounding of the
+//                       bfloat16 outputs, of the shorter polynomials
+// They are written once over the vector ops of the raw __m512 and __m256, for
+// the AVX-512 and the AVX2 levels the kernel sources are compiled for (see
+// csrc/cpu/dispatch/DispatchStub.h), and applied to the fVec of the level.
+// The fVec of the DEFAULT level maps the scalar functions instead.
+
+namespace torch_ipex {
+namespace cpu {
+namespace vec_math {
+
+enum class Accuracy { Fast, Accurate };
+
+// The accuracy of the math of the outputs of scalar_t.
+template <typename scalar_t>
+constexpr Accuracy accuracy_of() {
+  return std::is_same<scalar_t, at::BFloat16>::value ? Accuracy::Fast
+                                                     : Accuracy::Accurate;
+}
+
+namespace detail {
+
+// The vector ops of the functions of each ISA.
+#if defined(__AVX512F__)
+struct Avx512Ops {
+  using vec_t = __m512;
+  using mask_t = __mmask16;
+
+  static inline __m512 set1(float v) {
+    return _mm512_set1_ps(v);
+  }
+  static inline __m512 add(__m512 a, __m512 b) {
+    return _mm512_add_ps(a, b);
+  }
+  static inline __m512 sub(__m512 a, __m512 b) {
+    return _mm512_sub_ps(a, b);
+  }
+  static inline __m512 mul(__m512 a, __m512 b) {
+    return _mm512_mul_ps(a, b);
+  }
+  static inline __m512 div(__m512 a, __m512 b) {
+    return _mm512_div_ps(a, b);
+  }
+  // a * b + c
+  static inline __m512 fmadd(__m512 a, __m512 b, __m512 c) {
+    return _mm512_fmadd_ps(a, b, c);
+  }
+  // c - a * b
+  static inline __m512 fnmadd(__m512 a, __m512 b, __m512 c) {
+    return _mm512_fnmadd_ps(a, b, c);
+  }
+  // of b if a or b is NaN
+  static inline __m512 min(__m512 a, __m512 b) {
+    return _mm512_min_ps(a, b);
+  }
+  static inline __m512 max(__m512 a, __m512 b) {
+    return _mm512_max_ps(a, b);
+  }
+  static inline __m512 round(__m512 a) {
+    return _mm512_roundscale_ps(
+        a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  }
+  static inline __m512 abs(__m512 a) {
+    return _mm512_castsi512_ps(_mm512_and_epi32(
+        _mm512_castps_si512(a), _mm512_set1_epi32(0x7fffffff)));
+  }
+  // the magnitude of mag of the sign of sign
+  static inline __m512 copysign(__m512 mag, __m512 sign) {
+    return _mm512_castsi512_ps(_mm512_ternarylogic_epi32(
+        _mm512_castps_si512(mag),
+        _mm512_castps_si512(sign),
+        _mm512_set1_epi32(0x7fffffff),
+        0xe4));
+  }
+  static inline mask_t lt(__m512 a, __m512 b) {
+    return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ);
+  }
+  static inline mask_t gt(__m512 a, __m512 b) {
+    return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ);
+  }
+  static inline mask_t eq(__m512 a, __m512 b) {
+    return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ);
+  }
+  static inline mask_t isnan(__m512 a) {
+    return _mm512_cmp_ps_mask(a, a, _CMP_UNORD_Q);
+  }
+  // b of the lanes of mask and a of the others
+  static inline __m512 select(mask_t mask, __m512 a, __m512 b) {
+    return _mm512_mask_blend_ps(mask, a, b);
+  }
+  // 2^n of the integral n in [-126, 127]
+  static inline __m512 pow2n(__m512 n) {
+    auto e = _mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127));
+    return _mm512_castsi512_ps(_mm512_slli_epi32(e, 23));
+  }
+  // x = mantissa(x) * 2^exponent(x) of the positive normal x, of the
+  // mantissa in [1, 2)
+  static inline __m512 exponent(__m512 x) {
+    return _mm512_getexp_ps(x);
+  }
+  static inline __m512 mantissa(__m512 x) {
+    return _mm512_getmant_ps(x, _MM_MANT_NORM_1_2, _MM_MANT_SIGN_zero);
+  }
+};
+#endif
+
+#if defined(__AVX2__) && defined(__FMA__)
+struct Avx2Ops {
+  using vec_t = __m256;
+  using mask_t = __m256;
+
+  static inline __m256 set1(float v) {
+    return _mm256_set1_ps(v);
+  }
+  static inline __m256 add(__m256 a, __m256 b) {
+    return _mm256_add_ps(a, b);
+  }
+  static inline __m256 sub(__m256 a, __m256 b) {
+    return _mm256_sub_ps(a, b);
+  }
+  static inline __m256 mul(__m256 a, __m256 b) {
+    return _mm256_mul_ps(a, b);
+  }
+  static inline __m256 div(__m256 a, __m256 b) {
+    return _mm256_div_ps(a, b);
+  }
+  static inline __m256 fmadd(__m256 a, __m256 b, __m256 c) {
+    return _mm256_fmadd_ps(a, b, c);
+  }
+  static inline __m256 fnmadd(__m256 a, __m256 b, __m256 c) {
+    return _mm256_fnmadd_ps(a, b, c);
+  }
+  static inline __m256 min(__m256 a, __m256 b) {
+    return _mm256_min_ps(a, b);
+  }
+  static inline __m256 max(__m256 a, __m256 b) {
+    return _mm256_max_ps(a, b);
+  }
+  static inline __m256 round(__m256 a) {
+    return _mm256_round_ps(a, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  }
+  static inline __m256 abs(__m256 a) {
+    return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a);
+  }
+  static inline __m256 copysign(__m256 mag, __m256 sign) {
+    const __m256 sign_mask = _mm256_set1_ps(-0.f);
+    return _mm256_or_ps(
+        _mm256_andnot_ps(sign_mask, mag), _mm256_and_ps(sign_mask, sign));
+  }
+  static inline mask_t lt(__m256 a, __m256 b) {
+    return _mm256_cmp_ps(a, b, _CMP_LT_OQ);
+  }
+  static inline mask_t gt(__m256 a, __m256 b) {
+    return _mm256_cmp_ps(a, b, _CMP_GT_OQ);
+  }
+  static inline mask_t eq(__m256 a, __m256 b) {
+    return _mm256_cmp_ps(a, b, _CMP_EQ_OQ);
+  }
+  static inline mask_t isnan(__m256 a) {
+    return _mm256_cmp_ps(a, a, _CMP_UNORD_Q);
+  }
+  static inline __m256 select(mask_t mask, __m256 a, __m256 b) {
+    return _mm256_blendv_ps(a, b, mask);
+  }
+  static inline __m256 pow2n(__m256 n) {
+    auto e = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+    return _mm256_castsi256_ps(_mm256_slli_epi32(e, 23));
+  }
+  static inline __m256 exponent(__m256 x) {
+    auto bits = _mm256_srli_epi32(_mm256_castps_si256(x), 23);
+    return _mm256_cvtepi32_ps(_mm256_sub_epi32(bits, _mm256_set1_epi32(127)));
+  }
+  static inline __m256 mantissa(__m256 x) {
+    auto bits = _mm256_and_si256(
+        _mm256_castps_si256(x), _mm256_set1_epi32(0x007fffff));
+    return _mm256_castsi256_ps(
+        _mm256_or_si256(bits, _mm256_set1_epi32(0x3f800000)));
+  }
+};
+#endif
+
+constexpr float kLog2e = 1.44269504f;
+// ln(2) = kLn2Hi + kLn2Lo, of which n * kLn2Hi is exact for the n of exp
+constexpr float kLn2Hi = 0.693359375f;
+constexpr float kLn2Lo = -2.12194440e-4f;
+constexpr float kLnFltMin = -87.3365479f;
+constexpr float kLnFltMax = 88.7228394f;
+constexpr float kSqrt2 = 1.41421356f;
+constexpr float kTwoOverSqrtPi = 1.12837917f;
+
+// p = c[0] * r^(n - 1) + ... + c[n - 1] by Horner
+template <typename Ops, int N>
+inline typename Ops::vec_t polynomial(
+    typename Ops::vec_t r,
+    const float (&c)[N]) {
+  auto p = Ops::set1(c[0]);
+  for (int i = 1; i < N; i++) {
+    p = Ops::fmadd(p, r, Ops::set1(c[i]));
+  }
+  return p;
+}
+
+// exp(x) = 2^n * exp(r) of r = x - n * ln(2) in [-ln(2) / 2, ln(2) / 2], of
+// the minimax polynomials of exp(r). It is 0 below ln(FLT_MIN), i.e. the
+// subnormal results are flushed.
+template <Accuracy A, typename Ops>
+inline typename Ops::vec_t exp_impl(typename Ops::vec_t x) {
+  static constexpr float kFastCoeffs[] = {
+      0.165239547f, 0.504229912f, 1.00015302f, 0.999951254f};
+  static constexpr float kAccurateCoeffs[] = {
+      0.00828929059f,
+      0.0418978221f,
+      0.166676521f,
+      0.499991506f,
+      0.999999701f,
+      1.f};
+  auto zero = Ops::set1(0.f);
+  auto one = Ops::set1(1.f);
+  auto x_c = Ops::min(
+      Ops::max(x, Ops::set1(kLnFltMin)), Ops::set1(kLnFltMax));
+  auto n = Ops::round(Ops::mul(x_c, Ops::set1(kLog2e)));
+  auto r = Ops::fnmadd(n, Ops::set1(kLn2Hi), x_c);
+  r = Ops::fnmadd(n, Ops::set1(kLn2Lo), r);
+  auto p = A == Accuracy::Fast ? polynomial<Ops>(r, kFastCoeffs)
+                               : polynomial<Ops>(r, kAccurateCoeffs);
+  // 2^n = 2^(n - 1) * 2 of the positive n, of which the n = 128 of
+  // ln(FLT_MAX) is in the range of pow2n
+  auto positive_mask = Ops::gt(n, zero);
+  auto scale = Ops::pow2n(Ops::select(positive_mask, n, Ops::sub(n, one)));
+  auto y = Ops::mul(
+      Ops::mul(p, scale), Ops::select(positive_mask, one, Ops::set1(2.f)));
+  y = Ops::select(Ops::lt(x, Ops::set1(kLnFltMin)), y, zero);
+  y = Ops::select(
+      Ops::gt(x, Ops::set1(kLnFltMax)),
+      y,
+      Ops::set1(std::numeric_limits<float>::infinity()));
+  return Ops::select(Ops::isnan(x), y, x);
+}
+
+// log(x) = e * ln(2) + log(m) of x = m * 2^e, m in [sqrt(1/2), sqrt(2)), of
+// log(m) = 2 * atanh(s) of s = (m - 1) / (m + 1) in the series of atanh.
+template <Accuracy A, typename Ops>
+inline typename Ops::vec_t log_impl(typename Ops::vec_t x) {
+  static constexpr float kFastCoeffs[] = {2.f / 5, 2.f / 3, 2.f};
+  static constexpr float kAccurateCoeffs[] = {
+      2.f / 9, 2.f / 7, 2.f / 5, 2.f / 3, 2.f};
+  auto zero = Ops::set1(0.f);
+  auto one = Ops::set1(1.f);
+  // the subnormal x are scaled into the normal ones
+  auto tiny_mask =
+      Ops::lt(x, Ops::set1(std::numeric_limits<float>::min()));
+  auto x_n = Ops::select(tiny_mask, x, Ops::mul(x, Ops::set1(8388608.f)));
+  auto e = Ops::add(
+      Ops::exponent(x_n), Ops::select(tiny_mask, zero, Ops::set1(-23.f)));
+  auto m = Ops::mantissa(x_n);
+  auto big_mask = Ops::gt(m, Ops::set1(kSqrt2));
+  m = Ops::select(big_mask, m, Ops::mul(m, Ops::set1(0.5f)));
+  e = Ops::select(big_mask, e, Ops::add(e, one));
+  auto s = Ops::div(Ops::sub(m, one), Ops::add(m, one));
+  auto s2 = Ops::mul(s, s);
+  auto p = A == Accuracy::Fast ? polynomial<Ops>(s2, kFastCoeffs)
+                               : polynomial<Ops>(s2, kAccurateCoeffs);
+  auto y = Ops::fmadd(e, Ops::set1(kLn2Lo), Ops::mul(p, s));
+  y = Ops::fmadd(e, Ops::set1(kLn2Hi), y);
+  const float inf = std::numeric_limits<float>::infinity();
+  y = Ops::select(
+      Ops::lt(x, zero), y, Ops::set1(std::numeric_limits<float>::quiet_NaN()));
+  y = Ops::select(Ops::eq(x, zero), y, Ops::set1(-inf));
+  y = Ops::select(Ops::eq(x, Ops::set1(inf)), y, x);
+  return Ops::select(Ops::isnan(x), y, x);
+}
+
+// tanh(x) = 1 - 2 / (exp(2x) + 1), of the Taylor series below 0.3 where the
+// subtraction would cancel.
+template <Accuracy A, typename Ops>
+inline typename Ops::vec_t tanh_impl(typename Ops::vec_t x) {
+  static constexpr float kFastCoeffs[] = {2.f / 15, -1.f / 3, 1.f};
+  static constexpr float kAccurateCoeffs[] = {
+      62.f / 2835, -17.f / 315, 2.f / 15, -1.f / 3, 1.f};
+  auto one = Ops::set1(1.f);
+  auto a = Ops::abs(x);
+  auto e = exp_impl<A, Ops>(Ops::add(a, a));
+  auto large = Ops::sub(one, Ops::div(Ops::set1(2.f), Ops::add(e, one)));
+  auto a2 = Ops::mul(a, a);
+  auto p = A == Accuracy::Fast ? polynomial<Ops>(a2, kFastCoeffs)
+                               : polynomial<Ops>(a2, kAccurateCoeffs);
+  auto small = Ops::mul(p, a);
+  auto y = Ops::select(Ops::lt(a, Ops::set1(0.3f)), large, small);
+  return Ops::copysign(y, x);
+}
+
+// erf(x) = 1 - t * P(t) * exp(-x^2) of t = 1 / (1 + p * x), i.e. the 7.1.26 of
+// Abramowitz and Stegun of 1.5e-7 absolute error, of the Taylor series below
+// 0.5 where the subtraction would cancel.
+template <Accuracy A, typename Ops>
+inline typename Ops::vec_t erf_impl(typename Ops::vec_t x) {
+  static constexpr float kAbramowitzStegun[] = {
+      1.061405429f, -1.453152027f, 1.421413741f, -0.284496736f, 0.254829592f};
+  static constexpr float kFastCoeffs[] = {
+      -kTwoOverSqrtPi / 42,
+      kTwoOverSqrtPi / 10,
+      -kTwoOverSqrtPi / 3,
+      kTwoOverSqrtPi};
+  static constexpr float kAccurateCoeffs[] = {
+      -kTwoOverSqrtPi / 1320,
+      kTwoOverSqrtPi / 216,
+      -kTwoOverSqrtPi / 42,
+      kTwoOverSqrtPi / 10,
+      -kTwoOverSqrtPi / 3,
+      kTwoOverSqrtPi};
+  auto one = Ops::set1(1.f);
+  auto a = Ops::abs(x);
+  auto a2 = Ops::mul(a, a);
+  auto t = Ops::div(one, Ops::fmadd(Ops::set1(0.3275911f), a, one));
+  auto q = Ops::mul(
+      Ops::mul(polynomial<Ops>(t, kAbramowitzStegun), t),
+      exp_impl<A, Ops>(Ops::sub(Ops::set1(0.f), a2)));
+  auto large = Ops::sub(one, q);
+  auto p = A == Accuracy::Fast ? polynomial<Ops>(a2, kFastCoeffs)
+                               : polynomial<Ops>(a2, kAccurateCoeffs);
+  auto small = Ops::mul(p, a);
+  auto y = Ops::select(Ops::lt(a, Ops::set1(0.5f)), large, small);
+  return Ops::copysign(y, x);
+}
+
+} // namespace detail
+
+// The functions of the raw vectors of the ISA.
+#if defined(__AVX512F__)
+template <Accuracy A>
+inline __m512 exp_ps(__m512 x) {
+  return detail::exp_impl<A, detail::Avx512Ops>(x);
+}
+template <Accuracy A>
+inline __m512 log_ps(__m512 x) {
+  return detail::log_impl<A, detail::Avx512Ops>(x);
+}
+template <Accuracy A>
+inline __m512 tanh_ps(__m512 x) {
+  return detail::tanh_impl<A, detail::Avx512Ops>(x);
+}
+template <Accuracy A>
+inline __m512 erf_ps(__m512 x) {
+  return detail::erf_impl<A, detail::Avx512Ops>(x);
+}
+#endif
+
+#if defined(__AVX2__) && defined(__FMA__)
+template <Accuracy A>
+inline __m256 exp_ps(__m256 x) {
+  return detail::exp_impl<A, detail::Avx2Ops>(x);
+}
+template <Accuracy A>
+inline __m256 log_ps(__m256 x) {
+  return detail::log_impl<A, detail::Avx2Ops>(x);
+}
+template <Accuracy A>
+inline __m256 tanh_ps(__m256 x) {
+  return detail::tanh_impl<A, detail::Avx2Ops>(x);
+}
+template <Accuracy A>
+inline __m256 erf_ps(__m256 x) {
+  return detail::erf_impl<A, detail::Avx2Ops>(x);
+}
+#endif
+
+// The functions of the fVec of the kernel level.
+#if defined(CPU_CAPABILITY_AVX512)
+#define IPEX_VEC_MATH_NATIVE __m512
+#elif defined(CPU_CAPABILITY_AVX2) && defined(__AVX2__) && defined(__FMA__)
+#define IPEX_VEC_MATH_NATIVE __m256
+#endif
+
+template <Accuracy A = Accuracy::Accurate>
+inline fVec exp(const fVec& x) {
+#if defined(IPEX_VEC_MATH_NATIVE)
+  return exp_ps<A>(static_cast<IPEX_VEC_MATH_NATIVE>(x));
+#else
+  return x.exp();
+#endif
+}
+
+template <Accuracy A = Accuracy::Accurate>
+inline fVec log(const fVec& x) {
+#if defined(IPEX_VEC_MATH_NATIVE)
+  return log_ps<A>(static_cast<IPEX_VEC_MATH_NATIVE>(x));
+#else
+  return x.log();
+#endif
+}
+
+template <Accuracy A = Accuracy::Accurate>
+inline fVec tanh(const fVec& x) {
+#if defined(IPEX_VEC_MATH_NATIVE)
+  return tanh_ps<A>(static_cast<IPEX_VEC_MATH_NATIVE>(x));
+#else
+  return x.tanh();
+#endif
+}
+
+template <Accuracy A = Accuracy::Accurate>
+inline fVec erf(const fVec& x) {
+#if defined(IPEX_VEC_MATH_NATIVE)
+  return erf_ps<A>(static_cast<IPEX_VEC_MATH_NATIVE>(x));
+#else
+  return x.erf();
+#endif
+}
+
+#undef IPEX_VEC_MATH_NATIVE
+
+template <Accuracy A = Accuracy::Accurate>
+inline fVec sigmoid(const fVec& x) {
+  return fVec(1.f) / (fVec(1.f) + exp<A>(x.neg()));
+}
+
+// x * sigmoid(x), a.k.a. swish
+template <Accuracy A = Accuracy::Accurate>
+inline fVec silu(const fVec& x) {
+  return x / (fVec(1.f) + exp<A>(x.neg()));
+}
+
+// x * Phi(x) of the erf
+template <Accuracy A = Accuracy::Accurate>
+inline fVec gelu(const fVec& x) {
+  return x * fVec(0.5f) * (fVec(1.f) + erf<A>(x * fVec(float(M_SQRT1_2))));
+}
+
+// x * Phi(x) of the tanh approximation
+template <Accuracy A = Accuracy::Accurate>
+inline fVec gelu_tanh(const fVec& x) {
+  const fVec beta(float(M_SQRT2 * M_2_SQRTPI * 0.5));
+  const fVec kappa(0.044715f);
+  auto inner = beta * (x + kappa * x * x * x);
+  return x * fVec(0.5f) * (fVec(1.f) + tanh<A>(inner));
+}
+
+} // namespace vec_math
+} // namespace cpu
+} // namespace torch_ipex
@@ -14,13 +14,14 @@ Ret DataTypeCastFuction(
     std::string register_op_name,
     Args... args) {
   c10::impl::ExcludeDispatchKeyGuard no_autocastCPU(DispatchKey::AutocastCPU);
-  auto target_type = get_autocast_dtype();
 #if defined(ENABLE_AUTOCAST_VERBOSE)
   verbose::OpNameGuard op_name(register_op_name);
 #endif
   if (is_quantization_enabled()) {
+    auto target_type = get_autocast_dtype();
     return Quant(cpu_cached_cast(target_type, args)...);
   } else {
+    auto target_type = get_lower_precision_dtype(register_op_name);
     return At(cpu_cached_cast(target_type, args)...);
   }
 }
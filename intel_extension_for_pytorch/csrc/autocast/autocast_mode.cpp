@@ -4,18 +4,216 @@
 
 #include "library.h"
 
+#include "intel_extension_for_pytorch/csrc/cpu/isa/cpu_feature.hpp"
+#include "intel_extension_for_pytorch/csrc/utils/fast_path_stats.h"
+#include "intel_extension_for_pytorch/csrc/utils/rw_lock.h"
+#include "intel_extension_for_pytorch/csrc/utils/weight_cache.h"
+
+#include <torch/csrc/autograd/custom_function.h>
+
+#include <array>
+#include <atomic>
 #include <exception>
 #include <iostream>
+#include <unordered_set>
 
 namespace torch_ipex {
 namespace autocast {
 
 namespace {
 
-using weakref_type =
-    c10::weak_intrusive_ptr<c10::TensorImpl, c10::UndefinedTensorImpl>;
-using val_type = std::tuple<weakref_type, at::Tensor>;
-thread_local std::unordered_map<c10::TensorImpl*, val_type> cached_casts;
+// The casted weights are shared by all threads, e.g. by the streams of
+// MultiStreamModule, keyed by the weight and the target dtype. They are kept
+// across the iterations until the weights are modified, e.g. by
+// optimizer.step().
+// The cached casts have no grad_fn, or they would keep their weights alive
+// through the AccumulateGrad nodes. They are the first to evict by the memory
+// budget after the LSTM workspaces, since a cast is cheap to redo.
+torch_ipex::WeightCache<at::Tensor> cached_casts(
+    "autocast_casts",
+    1,
+    [](const at::Tensor& casted) {
+      return static_cast<int64_t>(casted.nbytes());
+    });
+
+// the casts of the weights taking the cache, the reasons are in the order of
+// the conditions of can_try_cache of cpu_cached_cast
+torch_ipex::fast_path::FastPathCounter cached_cast_counter(
+    "autocast_cached_cast",
+    {"not_float_to_low_precision", "not_leaf_param", "jit_tracing"});
+
+// A small direct-mapped cache of the casts looked up on this thread, in front
+// of cached_casts, so that the lookups of the hot weights take neither the
+// lock nor the hash map of the shared cache. The casts are held by weak refs,
+// so that the casts released by cached_casts are not kept alive by the
+// threads.
+class ThreadCastCache {
+ public:
+  bool find(const at::Tensor& tensor, int64_t format, at::Tensor& value) {
+    auto weight = tensor.unsafeGetTensorImpl();
+    const Entry& entry = this->slot(weight, format);
+    // the weak ref of the weight keeps its address from being reused
+    if (entry.weight != weight || entry.format != format ||
+        entry.weak_weight.expired() ||
+        entry.version != weight->version_counter().current_version()) {
+      return false;
+    }
+    auto casted = entry.weak_value.lock();
+    if (!casted.defined()) {
+      return false;
+    }
+    value = at::Tensor(std::move(casted));
+    return true;
+  }
+
+  void insert(
+      const at::Tensor& tensor,
+      int64_t format,
+      const at::Tensor& value) {
+    auto weight = tensor.unsafeGetTensorImpl();
+    Entry& entry = this->slot(weight, format);
+    entry.weight = weight;
+    entry.format = format;
+    entry.weak_weight = WeakRef(tensor.getIntrusivePtr());
+    entry.version = weight->version_counter().current_version();
+    entry.weak_value = WeakRef(value.getIntrusivePtr());
+  }
+
+ private:
+  using WeakRef =
+      c10::weak_intrusive_ptr<c10::TensorImpl, c10::UndefinedTensorImpl>;
+
+  static constexpr size_t kNumEntries = 64;
+
+  struct Entry {
+    c10::TensorImpl* weight = nullptr;
+    int64_t format = 0;
+    WeakRef weak_weight{c10::intrusive_ptr<c10::TensorImpl>()};
+    uint32_t version = 0;
+    WeakRef weak_value{c10::intrusive_ptr<c10::TensorImpl>()};
+  };
+
+  Entry& slot(c10::TensorImpl* weight, int64_t format) {
+    auto hash = (reinterpret_cast<uintptr_t>(weight) >> 4) ^
+        static_cast<uintptr_t>(format);
+    return this->entries[hash % kNumEntries];
+  }
+
+  std::array<Entry, kNumEntries> entries;
+};
+
+thread_local ThreadCastCache thread_casts;
+
+// Attach the cached cast of a weight to the autograd graph of the current
+// forward, of which the backward casts the grad back to the dtype of the
+// weight as the backward of the cast does.
+class CachedCastOp : public torch::autograd::Function<CachedCastOp> {
+ public:
+  static at::Tensor forward(
+      torch::autograd::AutogradContext* ctx,
+      const at::Tensor& weight,
+      const at::Tensor& casted) {
+    ctx->saved_data["dtype"] = static_cast<int64_t>(weight.scalar_type());
+    // returned as a new view of the cached cast with the grad_fn of this node
+    return casted;
+  }
+
+  static torch::autograd::tensor_list backward(
+      torch::autograd::AutogradContext* ctx,
+      torch::autograd::tensor_list grad_outputs) {
+    auto dtype = static_cast<at::ScalarType>(ctx->saved_data["dtype"].toInt());
+    return {grad_outputs[0].to(dtype), at::Tensor()};
+  }
+};
+
+// The op types of the lower_precision_fp category, of both the aten and the
+// ipex ops.
+const std::vector<std::string> lower_precision_ops = {
+    "conv1d",
+    "conv2d",
+    "conv3d",
+    "conv_transpose1d",
+    "conv_transpose2d",
+    "conv_transpose3d",
+    "convolution_forward",
+    "bmm",
+    "mm",
+    "baddbmm",
+    "addmm",
+    "addbmm",
+    "matmul",
+    "linear",
+    "ipex_linear",
+    "ipex_linear_eltwise"};
+
+// The op types with the float16 kernels of oneDNN. The aten ops have no
+// float16 kernels on CPU, and run in float32 if the autocast dtype is float16.
+const std::unordered_set<std::string> fp16_ops = {
+    "convolution_forward",
+    "ipex_linear",
+    "ipex_linear_eltwise"};
+
+std::string op_type(const std::string& op_name) {
+  return op_name.substr(0, op_name.find('.'));
+}
+
+// The op types of the lower_precision_fp category that run in float32. The
+// lookups skip the lock while no op type runs in float32.
+class LowerPrecisionPolicy {
+ public:
+  LowerPrecisionPolicy() {
+    // Without avx512 core, the bfloat16 convolutions and matmuls of oneDNN
+    // fall back to the reference kernels, which are much slower than float32.
+    // With avx512 core but neither avx512_bf16 nor amx_bf16, they are
+    // emulated and left to the calibration.
+    auto& cpu_feature = torch_ipex::cpu::CPUFeature::get_instance();
+    bool avx512_core = cpu_feature.os_avx512() &&
+        cpu_feature.cpuid_avx512_f() && cpu_feature.cpuid_avx512_bw() &&
+        cpu_feature.cpuid_avx512_vl() && cpu_feature.cpuid_avx512_dq();
+    if (!avx512_core) {
+      this->fp32_ops.insert(
+          lower_precision_ops.begin(), lower_precision_ops.end());
+      this->has_fp32_ops = true;
+    }
+    // the float16 kernels of oneDNN are only faster with avx512_fp16
+    this->fp16 = cpu_feature.os_avx512() && cpu_feature.cpuid_avx512_fp16();
+  }
+
+  bool is_fp16_enabled(const std::string& op_name) {
+    return this->fp16 && fp16_ops.count(op_type(op_name)) > 0 &&
+        this->is_enabled(op_name);
+  }
+
+  bool is_enabled(const std::string& op_name) {
+    if (!this->has_fp32_ops.load(std::memory_order_acquire)) {
+      return true;
+    }
+    UniqueReadLock<ReadWriteMutex> lock(this->rwmutex);
+    return this->fp32_ops.count(op_type(op_name)) == 0;
+  }
+
+  void set_enabled(const std::string& op_name, bool enabled) {
+    UniqueWriteLock<ReadWriteMutex> lock(this->rwmutex);
+    if (enabled) {
+      this->fp32_ops.erase(op_type(op_name));
+    } else {
+      this->fp32_ops.insert(op_type(op_name));
+    }
+    this->has_fp32_ops.store(
+        !this->fp32_ops.empty(), std::memory_order_release);
+  }
+
+ private:
+  std::unordered_set<std::string> fp32_ops;
+  std::atomic<bool> has_fp32_ops{false};
+  bool fp16 = false;
+  ReadWriteMutex rwmutex;
+};
+
+LowerPrecisionPolicy& lower_precision_policy() {
+  static LowerPrecisionPolicy policy;
+  return policy;
+}
 
 thread_local int nesting = 0;
 
@@ -46,6 +244,30 @@ void set_autocast_dtype(at::ScalarType dtype) {
   current_target_dtype = dtype;
 }
 
+at::ScalarType get_lower_precision_dtype(const std::string& op_name) {
+  if (current_target_dtype == at::kBFloat16 &&
+      !lower_precision_policy().is_enabled(op_name)) {
+    return at::kFloat;
+  }
+  if (current_target_dtype == at::kHalf &&
+      !lower_precision_policy().is_fp16_enabled(op_name)) {
+    return at::kFloat;
+  }
+  return current_target_dtype;
+}
+
+bool is_lower_precision_enabled(const std::string& op_name) {
+  return lower_precision_policy().is_enabled(op_name);
+}
+
+void set_lower_precision_enabled(const std::string& op_name, bool enabled) {
+  lower_precision_policy().set_enabled(op_name, enabled);
+}
+
+std::vector<std::string> get_lower_precision_ops() {
+  return lower_precision_ops;
+}
+
 int autocast_increment_nesting() {
   return ++nesting;
 }
@@ -55,23 +277,45 @@ int autocast_decrement_nesting() {
 }
 
 void clear_autocast_cache() {
-  cached_casts.clear();
+  // Other threads may still run inside autocast, e.g. the streams of
+  // MultiStreamModule, so only the casts of the freed or modified weights are
+  // released.
+  cached_casts.prune();
+}
+
+size_t get_autocast_cache_size() {
+  return cached_casts.size();
 }
 
 Tensor cpu_cached_cast(at::ScalarType to_type, const Tensor& arg) {
   if (is_eligible_cpu(arg) && (arg.scalar_type() != to_type)) {
-    bool can_try_cache = !at::GradMode::is_enabled() &&
-        (to_type == at::kBFloat16 && arg.scalar_type() == at::kFloat &&
-         arg.requires_grad() && arg.is_leaf() && !arg.is_view() &&
-         !torch::jit::tracer::isTracing()); // Disable cache in jit mode
+    // The casts of the weights are also cached in the training, and refreshed
+    // once the weights are modified.
+    bool can_try_cache = cached_cast_counter.check(
+        {(to_type == at::kBFloat16 || to_type == at::kHalf) &&
+             arg.scalar_type() == at::kFloat,
+         arg.requires_grad() && arg.is_leaf() && !arg.is_view(),
+         !torch::jit::tracer::isTracing()}); // Disable cache in jit mode
 
+    at::Tensor casted_arg;
     if (can_try_cache) {
-      auto it = cached_casts.find(arg.unsafeGetTensorImpl());
-      if (it != cached_casts.end()) {
-        return std::get<1>(it->second);
+      auto format = static_cast<int64_t>(to_type);
+      if (!thread_casts.find(arg, format, casted_arg)) {
+        if (!cached_casts.find(arg, format, casted_arg)) {
+#if defined(ENABLE_AUTOCAST_VERBOSE)
+          verbose::autocast_verbose(to_type, arg);
+#endif
+          casted_arg = arg.detach().to(to_type);
+          cached_casts.insert(arg, format, casted_arg);
+        }
+        thread_casts.insert(arg, format, casted_arg);
+      }
+      if (at::GradMode::is_enabled()) {
+        return CachedCastOp::apply(arg, casted_arg);
       }
+      return casted_arg;
     }
-    auto casted_arg = arg;
+    casted_arg = arg;
     if (arg.scalar_type() == at::kFloat && to_type == at::kBFloat16) {
       // This path works for fp32 to bf16
 #if defined(ENABLE_AUTOCAST_VERBOSE)
@@ -86,11 +330,14 @@ Tensor cpu_cached_cast(at::ScalarType to_type, const Tensor& arg) {
 #endif
       casted_arg = arg.to(at::kFloat);
       // casted_arg = arg.to_dense(at::kFloat);
-    }
-    if (can_try_cache) {
-      cached_casts.emplace(
-          arg.unsafeGetTensorImpl(),
-          val_type{weakref_type(arg.getIntrusivePtr()), casted_arg});
+    } else if (
+        (arg.scalar_type() == at::kFloat && to_type == at::kHalf) ||
+        (arg.scalar_type() == at::kHalf && to_type == at::kFloat)) {
+      // This path works between fp32 and fp16
+#if defined(ENABLE_AUTOCAST_VERBOSE)
+      verbose::autocast_verbose(to_type, arg);
+#endif
+      casted_arg = arg.to(to_type);
     }
     return casted_arg;
   } else {
@@ -144,7 +391,12 @@ struct CPU_WrapFunction_<
 #if defined(ENABLE_AUTOCAST_VERBOSE)
     verbose::OpNameGuard op_name(get_op_name<Redispatch, F>());
 #endif
-    return (*F)(cpu_cached_cast(current_target_dtype, args)...);
+    static const std::string name = get_op_name<Redispatch, F>();
+    auto to_type = get_lower_precision_dtype(name);
+    if (!any_needs_cast(to_type, args...)) {
+      return (*F)(args...);
+    }
+    return (*F)(cpu_cached_cast(to_type, args)...);
   }
 };
 
@@ -161,6 +413,9 @@ struct CPU_WrapFunction_<
 #if defined(ENABLE_AUTOCAST_VERBOSE)
     verbose::OpNameGuard op_name(get_op_name<Redispatch, F>());
 #endif
+    if (!any_needs_cast(at::kFloat, args...)) {
+      return (*F)(args...);
+    }
     return (*F)(cpu_cached_cast(at::kFloat, args)...);
   }
 };
@@ -175,10 +430,15 @@ struct CPU_WrapFunction_<
     guts::typelist::typelist<Args...>> {
   static Ret call(Args... args) {
     c10::impl::ExcludeDispatchKeyGuard no_autocastCPU(DispatchKey::AutocastCPU);
-    auto to_type = promote_type(at::kBFloat16, args...);
+    auto to_type = promote_type(
+        current_target_dtype == at::kHalf ? at::kHalf : at::kBFloat16,
+        args...);
 #if defined(ENABLE_AUTOCAST_VERBOSE)
     verbose::OpNameGuard op_name(get_op_name<Redispatch, F>());
 #endif
+    if (!any_needs_cast(to_type, args...)) {
+      return (*F)(args...);
+    }
     return (*F)(cpu_cached_cast(to_type, args)...);
   }
 };
@@ -0,0 +1,170 @@
+#pragma once
+
+// The AMX tile helpers of the hand-written kernels, i.e. the tile config,
+// the tile loads / stores and the TDPBSSD / TDPBF16PS microkernels. They are
+// only built into the AMX level of the kernel sources of csrc/aten/cpu/kernels
+// (see csrc/cpu/dispatch/DispatchStub.h), of which the dispatch has requested
+// the tile data permission of the process already.
+
+#if defined(CPU_CAPABILITY_AMX)
+
+#include <c10/util/BFloat16.h>
+#include <immintrin.h>
+
+#include <cstdint>
+#include <cstring>
+
+namespace torch_ipex {
+namespace cpu {
+namespace amx {
+
+constexpr int kTileRows = 16;
+constexpr int kTileColsBytes = 64;
+
+// The 64 bytes of the config of palette 1 of LDTILECFG.
+struct alignas(64) TileConfig {
+  uint8_t palette_id;
+  uint8_t start_row;
+  uint8_t reserved[14];
+  uint16_t colsb[16];
+  uint8_t rows[16];
+};
+
+// Loads the config of the 8 tiles as full 16 x 64 bytes ones for the scope
+// and releases the tiles at the end of it. The config is loaded per kernel
+// call instead of once per thread, as the oneDNN kernels run on the same
+// threads configure the tiles of their own.
+class TileConfigGuard {
+ public:
+  TileConfigGuard() {
+    TileConfig config;
+    std::memset(&config, 0, sizeof(config));
+    config.palette_id = 1;
+    for (int t = 0; t < 8; t++) {
+      config.rows[t] = kTileRows;
+      config.colsb[t] = kTileColsBytes;
+    }
+    _tile_loadconfig(&config);
+  }
+
+  ~TileConfigGuard() {
+    _tile_release();
+  }
+
+  TileConfigGuard(const TileConfigGuard&) = delete;
+  TileConfigGuard& operator=(const TileConfigGuard&) = delete;
+};
+
+// The dot products of the tiles: the 4 int8 or the 2 bfloat16 of K of a
+// 32-bit lane of the VNNI layout of B are summed into the int32 or the float
+// accumulator.
+template <typename T>
+struct TileTraits;
+
+template <>
+struct TileTraits<int8_t> {
+  using acc_t = int32_t;
+  static constexpr int vnni = 4;
+
+  template <int C, int A, int B>
+  static inline void dot() {
+    _tile_dpbssd(C, A, B);
+  }
+};
+
+template <>
+struct TileTraits<c10::BFloat16> {
+  using acc_t = float;
+  static constexpr int vnni = 2;
+
+  template <int C, int A, int B>
+  static inline void dot() {
+    _tile_dpbf16ps(C, A, B);
+  }
+};
+
+// b[k / vnni][n * vnni + k % vnni] = a[n][k], i.e. the VNNI layout of the
+// transpose of the [rows, cols] a, which is a transpose of the 32-bit groups
+// of vnni elements of a. cols is a multiple of vnni.
+template <typename T>
+inline void pack_vnni_transposed(
+    const T* a,
+    int64_t rows,
+    int64_t cols,
+    T* b) {
+  constexpr int vnni = TileTraits<T>::vnni;
+  const int64_t groups = cols / vnni;
+  const int32_t* a32 = reinterpret_cast<const int32_t*>(a);
+  int32_t* b32 = reinterpret_cast<int32_t*>(b);
+  for (int64_t g = 0; g < groups; g++) {
+    for (int64_t n = 0; n < rows; n++) {
+      b32[g * rows + n] = a32[n * groups + g];
+    }
+  }
+}
+
+// c = a * b of the block of mb x nb tiles, mb and nb of 1 or 2, i.e. of up
+// to 32 x 32 accumulators, with the 4 accumulator tiles 0 - 3, the a tiles
+// 4 - 5 and the b tiles 6 - 7 of the TileConfigGuard config.
+//   a: [mb * 16, K] of lda elements per row
+//   b: [K / vnni, nb * 16 * vnni] of the VNNI layout of ldb elements per row
+//   c: [mb * 16, nb * 16] of ldc accumulators per row
+// K is a multiple of the 64 bytes of a tile row.
+template <typename T>
+inline void tile_gemm(
+    const T* a,
+    int64_t lda,
+    const T* b,
+    int64_t ldb,
+    typename TileTraits<T>::acc_t* c,
+    int64_t ldc,
+    int mb,
+    int nb,
+    int64_t K) {
+  using Traits = TileTraits<T>;
+  constexpr int vnni = Traits::vnni;
+  constexpr int64_t k_step = kTileColsBytes / sizeof(T);
+  const int64_t a_stride = lda * sizeof(T);
+  const int64_t b_stride = ldb * sizeof(T);
+  const int64_t c_stride = ldc * sizeof(typename Traits::acc_t);
+  const T* a1 = a + kTileRows * lda;
+  const T* b1 = b + kTileRows * vnni;
+
+  _tile_zero(0);
+  _tile_zero(1);
+  _tile_zero(2);
+  _tile_zero(3);
+  for (int64_t k = 0; k < K; k += k_step) {
+    const int64_t b_offset = (k / vnni) * ldb;
+    _tile_loadd(4, a + k, a_stride);
+    _tile_loadd(6, b + b_offset, b_stride);
+    Traits::template dot<0, 4, 6>();
+    if (nb == 2) {
+      _tile_loadd(7, b1 + b_offset, b_stride);
+      Traits::template dot<1, 4, 7>();
+    }
+    if (mb == 2) {
+      _tile_loadd(5, a1 + k, a_stride);
+      Traits::template dot<2, 5, 6>();
+      if (nb == 2) {
+        Traits::template dot<3, 5, 7>();
+      }
+    }
+  }
+  _tile_stored(0, c, c_stride);
+  if (nb == 2) {
+    _tile_stored(1, c + kTileRows, c_stride);
+  }
+  if (mb == 2) {
+    _tile_stored(2, c + kTileRows * ldc, c_stride);
+    if (nb == 2) {
+      _tile_stored(3, c + kTileRows * ldc + kTileRows, c_stride);
+    }
+  }
+}
+
+} // namespace amx
+} // namespace cpu
+} // namespace torch_ipex
+
+#endif
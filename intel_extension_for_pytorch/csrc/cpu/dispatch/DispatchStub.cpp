@@ -0,0 +1,107 @@
+#include "DispatchStub.h"
+
+#include <c10/util/Exception.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <string>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "csrc/cpu/isa/cpu_feature.hpp"
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+// Linux only allows the AMX tile data to the processes which request it, of
+// which the permission is for all the threads of the process.
+bool request_amx_permission() {
+#if defined(__linux__)
+  const int ARCH_REQ_XCOMP_PERM = 0x1023;
+  const int XFEATURE_XTILEDATA = 18;
+  return syscall(SYS_arch_prctl, ARCH_REQ_XCOMP_PERM, XFEATURE_XTILEDATA) == 0;
+#else
+  return true;
+#endif
+}
+
+CPUCapability detect_cpu_capability() {
+  auto& cpu_feature = CPUFeature::get_instance();
+  bool avx2 = cpu_feature.os_avx2() && cpu_feature.cpuid_avx2();
+  if (!avx2) {
+    return CPUCapability::DEFAULT;
+  }
+  bool avx512 = cpu_feature.os_avx512() && cpu_feature.cpuid_avx512_f() &&
+      cpu_feature.cpuid_avx512_bw() && cpu_feature.cpuid_avx512_vl() &&
+      cpu_feature.cpuid_avx512_dq();
+  if (!avx512) {
+    return CPUCapability::AVX2;
+  }
+  bool avx512_bf16 =
+      cpu_feature.cpuid_avx512_bf16() && cpu_feature.cpuid_avx512_vnni();
+  if (!avx512_bf16) {
+    return CPUCapability::AVX512;
+  }
+  bool amx = cpu_feature.os_amx() && cpu_feature.cpuid_amx_tile() &&
+      cpu_feature.cpuid_amx_bf16() && cpu_feature.cpuid_amx_int8() &&
+      request_amx_permission();
+  return amx ? CPUCapability::AMX : CPUCapability::AVX512_BF16;
+}
+
+CPUCapability compute_cpu_capability() {
+  auto capability = detect_cpu_capability();
+  const char* env = std::getenv("IPEX_CPU_CAPABILITY");
+  if (env == nullptr) {
+    return capability;
+  }
+  std::string name(env);
+  std::transform(name.begin(), name.end(), name.begin(), [](char c) {
+    return std::toupper(static_cast<unsigned char>(c));
+  });
+  for (int i = 0; i < static_cast<int>(CPUCapability::NUM_OPTIONS); i++) {
+    auto candidate = static_cast<CPUCapability>(i);
+    if (name == get_cpu_capability_name(candidate)) {
+      // the level is only lowered, the kernels above the CPU would not run
+      return std::min(candidate, capability);
+    }
+  }
+  TORCH_WARN(
+      "ignoring the invalid IPEX_CPU_CAPABILITY ",
+      env,
+      ", of which the valid ones are default, avx2, avx512, avx512_bf16 and ",
+      "amx");
+  return capability;
+}
+
+} // namespace
+
+CPUCapability get_cpu_capability() {
+  static CPUCapability capability = compute_cpu_capability();
+  return capability;
+}
+
+const char* get_cpu_capability_name(CPUCapability capability) {
+  switch (capability) {
+    case CPUCapability::DEFAULT:
+      return "DEFAULT";
+    case CPUCapability::AVX2:
+      return "AVX2";
+    case CPUCapability::AVX512:
+      return "AVX512";
+    case CPUCapability::AVX512_BF16:
+      return "AVX512_BF16";
+    case CPUCapability::AMX:
+      return "AMX";
+    default:
+      TORCH_INTERNAL_ASSERT(false, "unknown CPUCapability");
+  }
+}
+
+} // namespace cpu
+} // namespace torch_ipex
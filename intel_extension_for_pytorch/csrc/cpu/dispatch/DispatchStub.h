@@ -0,0 +1,134 @@
+#pragma once
+
+#include <c10/macros/Macros.h>
+#include <c10/util/Exception.h>
+
+#include <atomic>
+#include <utility>
+
+// The runtime ISA dispatch of the IPEX kernels, after the DispatchStub of
+// ATen. The kernel sources of csrc/aten/cpu/kernels are compiled once per ISA
+// level of CPUCapability, each with the flags of its level only and with
+// CPU_CAPABILITY defined to the name of the level, and register their kernel to
+// the stub by IPEX_REGISTER_DISPATCH. The first call of a stub selects the
+// kernel of the highest level supported by the running CPU, so that a single
+// binary runs the AVX512 or the AMX kernels on the machines of them and the
+// AVX2 ones elsewhere instead of the ISA fixed at build time.
+//
+//   // the op header
+//   using add_kernel_fn = void (*)(const at::Tensor&, at::Tensor&);
+//   IPEX_DECLARE_DISPATCH(add_kernel_fn, add_kernel_stub);
+//
+//   // the op source
+//   IPEX_DEFINE_DISPATCH(add_kernel_stub);
+//   add_kernel_stub(src, dst);
+//
+//   // csrc/aten/cpu/kernels/AddKrnl.cpp, of which the kernels are in an
+//   // anonymous namespace, as each ISA level of it is linked into the library
+//   IPEX_REGISTER_DISPATCH(add_kernel_stub, &add_kernel_impl);
+//
+// The stub is named unqualified by IPEX_REGISTER_DISPATCH, i.e. the kernel
+// source registers it in the namespace of its declaration.
+
+namespace torch_ipex {
+namespace cpu {
+
+// The ISA levels of the kernels from the lowest to the highest, each of which
+// implies the ones below it.
+enum class CPUCapability {
+  DEFAULT = 0,
+  AVX2 = 1,
+  // avx512f, avx512bw, avx512vl and avx512dq
+  AVX512 = 2,
+  // AVX512 with avx512_bf16 and avx512_vnni, e.g. Cooper Lake
+  AVX512_BF16 = 3,
+  // AVX512_BF16 with amx_tile, amx_bf16 and amx_int8, e.g. Sapphire Rapids
+  AMX = 4,
+  NUM_OPTIONS
+};
+
+// The highest ISA level of the running CPU and OS, detected once. Setting
+// IPEX_CPU_CAPABILITY to the name of a lower level, e.g. "avx2", caps it for
+// the validation of the kernels of that level.
+CPUCapability get_cpu_capability();
+
+const char* get_cpu_capability_name(CPUCapability capability);
+
+template <typename FnPtr>
+class DispatchStub {
+ public:
+  constexpr DispatchStub() : table_(), selected_(nullptr) {}
+
+  DispatchStub(const DispatchStub&) = delete;
+  DispatchStub& operator=(const DispatchStub&) = delete;
+
+  template <typename... ArgTypes>
+  auto operator()(ArgTypes&&... args)
+      -> decltype(std::declval<FnPtr>()(std::forward<ArgTypes>(args)...)) {
+    return (*choose())(std::forward<ArgTypes>(args)...);
+  }
+
+  void set(CPUCapability capability, FnPtr fn) {
+    table_[static_cast<int>(capability)] = fn;
+  }
+
+  // whether a kernel is registered for the CPU, for the stubs of which the
+  // kernels are only built for some of the levels, e.g. the AMX ones, and
+  // the caller takes another path otherwise
+  bool is_available() {
+    return lookup() != nullptr;
+  }
+
+ private:
+  // the kernel of the highest level registered and not above the one of the
+  // CPU, of which the lookup is done once and cached
+  FnPtr lookup() {
+    FnPtr fn = selected_.load(std::memory_order_acquire);
+    if (C10_LIKELY(fn != nullptr)) {
+      return fn;
+    }
+    for (int i = static_cast<int>(get_cpu_capability()); i >= 0; i--) {
+      if (table_[i] != nullptr) {
+        fn = table_[i];
+        selected_.store(fn, std::memory_order_release);
+        break;
+      }
+    }
+    return fn;
+  }
+
+  FnPtr choose() {
+    FnPtr fn = lookup();
+    TORCH_INTERNAL_ASSERT(
+        fn != nullptr, "DispatchStub: no kernel is registered for the CPU");
+    return fn;
+  }
+
+  // constant initialized, so that the registration of the kernels from the
+  // static initializers of the other sources does not depend on their order
+  FnPtr table_[static_cast<int>(CPUCapability::NUM_OPTIONS)];
+  std::atomic<FnPtr> selected_;
+};
+
+template <typename Stub>
+struct DispatchRegistrar {
+  template <typename FnPtr>
+  DispatchRegistrar(Stub& stub, CPUCapability capability, FnPtr fn) {
+    stub.set(capability, fn);
+  }
+};
+
+} // namespace cpu
+} // namespace torch_ipex
+
+#define IPEX_DECLARE_DISPATCH(fn_type, name) \
+  extern torch_ipex::cpu::DispatchStub<fn_type> name
+
+#define IPEX_DEFINE_DISPATCH(name) decltype(name) name
+
+#if defined(CPU_CAPABILITY)
+#define IPEX_REGISTER_DISPATCH(name, fn)                    \
+  static torch_ipex::cpu::DispatchRegistrar<decltype(name)> \
+      C10_CONCATENATE(name##_registrar_, CPU_CAPABILITY)(   \
+          name, torch_ipex::cpu::CPUCapability::CPU_CAPABILITY, fn)
+#endif
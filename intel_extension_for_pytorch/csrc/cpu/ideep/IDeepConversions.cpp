@@ -2,6 +2,8 @@
 #include <ATen/OpaqueTensorImpl.h>
 #include <c10/core/Allocator.h>
 
+#include "csrc/utils/huge_pages.h"
+
 namespace torch_ipex {
 namespace cpu {
 
@@ -50,6 +52,8 @@ ideep::tensor::data_type get_mkldnn_dtype(at::ScalarType type) {
       return ideep::tensor::data_type::u8;
     case at::ScalarType::BFloat16:
       return ideep::tensor::data_type::bf16;
+    case at::ScalarType::Half:
+      return ideep::tensor::data_type::f16;
     default:
       TORCH_CHECK(false, "get_mkldnn_dtype: unsupported data type");
   }
@@ -73,7 +77,8 @@ ideep::tensor itensor_view_from_dense(const at::Tensor& tensor) {
       "itensor_view_from_dense expects dense tensor input");
   TORCH_CHECK(
       tensor.scalar_type() == at::ScalarType::Float ||
-          tensor.scalar_type() == at::ScalarType::BFloat16,
+          tensor.scalar_type() == at::ScalarType::BFloat16 ||
+          tensor.scalar_type() == at::ScalarType::Half,
       "itensor_view_from_dense expects float tensor input");
   return {
       {tensor.sizes().vec(),
@@ -93,8 +98,9 @@ ideep::tensor itensor_view_from_dense(
       "itensor_view_from_dense expects dense tensor input");
   TORCH_CHECK(
       tensor.scalar_type() == at::ScalarType::Float ||
-          tensor.scalar_type() == at::ScalarType::BFloat16,
-      "itensor_view_from_dense expects float or bfloat16 tensor input");
+          tensor.scalar_type() == at::ScalarType::BFloat16 ||
+          tensor.scalar_type() == at::ScalarType::Half,
+      "itensor_view_from_dense expects float, bfloat16 or half tensor input");
   return {desc, tensor.data_ptr()};
 }
 
@@ -166,7 +172,8 @@ ideep::tensor itensor_from_tensor(const at::Tensor& tensor) {
 // Init a aten tensor according to ideep tensor's desc.
 at::Tensor empty_aten_tensor_from_desc(
     const ideep::tensor::desc& desc,
-    const at::TensorOptions& options) {
+    const at::TensorOptions& options,
+    bool on_huge_pages) {
   auto ndims = desc.data.ndims;
   auto nblks = desc.blocking_desc().inner_nblks;
   std::vector<int64_t> at_sizes(ndims + nblks);
@@ -181,6 +188,9 @@ at::Tensor empty_aten_tensor_from_desc(
   for (auto i = 0; i < ndims; i++) {
     at_sizes[i] = padded_dims[i] / blk_size_per_dim[i];
   }
+  if (on_huge_pages) {
+    return huge_pages::empty(at_sizes, options);
+  }
   return at::empty(at_sizes, options);
 }
 
@@ -34,9 +34,12 @@ at::Tensor mkldnn_to_dense(
 
 ideep::tensor itensor_from_tensor(const at::Tensor& tensor);
 
+// The tensor is placed on the huge pages if on_huge_pages, e.g. of the
+// packed weights, see csrc/utils/huge_pages.h.
 at::Tensor empty_aten_tensor_from_desc(
     const ideep::tensor::desc& desc,
-    const at::TensorOptions& options);
+    const at::TensorOptions& options,
+    bool on_huge_pages = false);
 
 int mkldnn_set_verbose(int level);
 
@@ -4,25 +4,94 @@
 // needs to be included only once in library.
 #include "ideep_pin_singletons.hpp"
 
+#include "csrc/utils/huge_pages.h"
+#include "csrc/utils/memory_stats.h"
+
+#include <c10/core/CPUAllocator.h>
+
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
+
 using namespace ideep;
 
+namespace {
+
+// The buffers placed on the huge pages, e.g. of the packed weights of the op
+// contexts, which are freed by c10::free_cpu instead of the CPU allocator.
+std::mutex huge_page_buffers_mutex;
+std::unordered_set<void*> huge_page_buffers;
+std::atomic<int64_t> num_huge_page_buffers{0};
+
+void* allocate_buffer(size_t size) {
+  if (!torch_ipex::huge_pages::is_placed(size)) {
+    return c10::GetAllocator(c10::DeviceType::CPU)->raw_allocate(size);
+  }
+  void* p = torch_ipex::huge_pages::alloc_cpu(size);
+  std::lock_guard<std::mutex> lock(huge_page_buffers_mutex);
+  huge_page_buffers.insert(p);
+  num_huge_page_buffers.fetch_add(1, std::memory_order_relaxed);
+  return p;
+}
+
+void free_buffer(void* p) {
+  // a relaxed load only until any buffer is placed on the huge pages
+  if (num_huge_page_buffers.load(std::memory_order_relaxed) > 0) {
+    std::lock_guard<std::mutex> lock(huge_page_buffers_mutex);
+    if (huge_page_buffers.erase(p) > 0) {
+      num_huge_page_buffers.fetch_sub(1, std::memory_order_relaxed);
+      c10::free_cpu(p);
+      return;
+    }
+  }
+  c10::GetAllocator(c10::DeviceType::CPU)->raw_deallocate(p);
+}
+
+} // namespace
+
 RegisterEngineAllocator cpu_alloc(
     engine::cpu_engine(),
-    [](size_t size) {
-      return c10::GetAllocator(c10::DeviceType::CPU)->raw_allocate(size);
-    },
-    [](void* p) {
-      c10::GetAllocator(c10::DeviceType::CPU)->raw_deallocate(p);
-    });
+    allocate_buffer,
+    free_buffer);
 
 namespace torch_ipex {
 namespace cpu {
 namespace mkldnn {
 
+namespace {
+
+// The primitive descs cached by ideep on each thread. The caches of the other
+// threads are dropped at their next lookup, so the bytes evicted are freed
+// lazily.
+memory_stats::CacheAccount primitive_descs_account(
+    "ideep_primitive_descs",
+    2,
+    [](int64_t) {
+      ideep::utils::computation_cache_epoch().fetch_add(1);
+      return primitive_descs_account.bytes();
+    });
+
+void account_primitive_descs(int64_t bytes, int64_t entries) {
+  primitive_descs_account.update(bytes, entries);
+  if (bytes > 0) {
+    memory_stats::enforce_memory_budget();
+  }
+}
+
+struct RegisterComputationCacheObserver {
+  RegisterComputationCacheObserver() {
+    ideep::utils::computation_cache_observer().store(account_primitive_descs);
+  }
+};
+
+RegisterComputationCacheObserver computation_cache_observer;
+
+} // namespace
+
 void clear_computation_cache() {
   // Reset computation_cache for forward convolutions
   // As it also caches max number of OpenMP workers
-  ideep::convolution_forward::t_store().clear();
+  ideep::convolution_forward::clear();
 }
 
 } // namespace mkldnn
@@ -1,6 +1,7 @@
 #ifndef IDEEP_LRU_CACHE_CPP
 #define IDEEP_LRU_CACHE_CPP
 
+#include <atomic>
 #include <list>
 #include <unordered_map>
 #include "abstract_types.hpp"
@@ -8,6 +9,32 @@
 namespace ideep {
 namespace utils {
 
+// The accounting of the memory of the computation caches by the framework,
+// called with the bytes and the entries added to the cache of a thread,
+// negative if dropped.
+using computation_cache_observer_t = void (*)(int64_t bytes, int64_t entries);
+
+inline std::atomic<computation_cache_observer_t>& computation_cache_observer() {
+  static std::atomic<computation_cache_observer_t> observer{nullptr};
+  return observer;
+}
+
+// The caches are thread local, so the other threads drop them by bumping the
+// epoch, and each thread clears its cache at its next lookup of a newer epoch.
+inline std::atomic<uint64_t>& computation_cache_epoch() {
+  static std::atomic<uint64_t> epoch{0};
+  return epoch;
+}
+
+template <class key_t>
+inline size_t key_bytes(const key_t&) {
+  return sizeof(key_t);
+}
+
+inline size_t key_bytes(const std::string& key) {
+  return sizeof(std::string) + key.capacity();
+}
+
 template <
     class key_t,
     class value_t,
@@ -37,7 +64,13 @@ class lru_cache {
   lru_cache(size_type capacity) : capacity_(capacity) {}
 
   size_type size() const {
-    map_.size();
+    return map_.size();
+  }
+
+  // the bytes of the keys and the values, without the memory held by the
+  // values, e.g. by the primitive descs
+  size_t bytes() const {
+    return bytes_;
   }
 
   size_type max_size() const {
@@ -50,6 +83,7 @@ class lru_cache {
     while (map_.size() > capacity_) {
       auto last = vlist_.end();
       last--;
+      bytes_ -= node_bytes(last->first->first);
       map_.erase(last->first);
       vlist_.pop_back();
     }
@@ -107,6 +141,7 @@ class lru_cache {
   void clear() noexcept {
     vlist_.clear();
     map_.clear();
+    bytes_ = 0;
   }
 
   std::pair<iterator, bool> insert(const value_type& value) {
@@ -117,6 +152,7 @@ class lru_cache {
       auto updated = map_.insert(map_it, std::make_pair(value.first, list_it));
       // Update node to pointer to new map position
       list_it->first = updated;
+      bytes_ += node_bytes(value.first);
     } else
       return std::make_pair(map_it->second, false);
 
@@ -124,6 +160,7 @@ class lru_cache {
     while (map_.size() > capacity_) {
       auto last = vlist_.end();
       last--;
+      bytes_ -= node_bytes(last->first->first);
       map_.erase(last->first);
       vlist_.pop_back();
     }
@@ -132,6 +169,7 @@ class lru_cache {
 
   iterator erase(iterator pos) {
     auto map_pos = pos->first;
+    bytes_ -= node_bytes(map_pos->first);
     map_.erase(map_pos);
     return vlist_.erase(pos);
   }
@@ -141,12 +179,18 @@ class lru_cache {
     std::swap(vlist_, other.vlist_);
     std::swap(map_, other.map_);
     std::swap(capacity_, other.capacity_);
+    std::swap(bytes_, other.bytes_);
   }
 
  private:
+  static size_t node_bytes(const key_t& key) {
+    return key_bytes(key) + sizeof(node_t) + sizeof(iterator);
+  }
+
   std::list<node_t> vlist_;
   map<key_t, iterator> map_;
   size_type capacity_;
+  size_t bytes_ = 0;
 };
 
 template <class value_t, size_t capacity = 1024, class key_t = std::string>
@@ -158,6 +202,7 @@ class computation_cache {
   template <typename T>
   static inline iterator create(const key_t& key, T&& args) {
     auto it = t_store().insert(std::make_pair(key, std::forward<T>(args)));
+    thread_store().report();
     return it.first;
   }
 
@@ -170,7 +215,14 @@ class computation_cache {
   }
 
   static inline iterator find(const key_t& key) {
-    return t_store().find(key);
+    auto& store = thread_store();
+    auto epoch = computation_cache_epoch().load(std::memory_order_relaxed);
+    if (store.epoch != epoch) {
+      store.epoch = epoch;
+      store.cache.clear();
+      store.report();
+    }
+    return store.cache.find(key);
   }
 
   static inline iterator end() {
@@ -190,18 +242,59 @@ class computation_cache {
   static inline void release(const key_t& key, value_t&& computation) {}
 
   static inline lru_cache<key_t, value_t>& t_store() {
-    static thread_local lru_cache<key_t, value_t> t_store_(capacity);
-    static thread_local int new_capacity = [&](const char* pt) {
+    return thread_store().cache;
+  }
+
+  // clears the cache of this thread
+  static inline void clear() {
+    auto& store = thread_store();
+    store.cache.clear();
+    store.report();
+  }
+
+ private:
+  struct thread_store_t {
+    lru_cache<key_t, value_t> cache{capacity};
+    uint64_t epoch = computation_cache_epoch().load(std::memory_order_relaxed);
+    // the bytes and the entries reported to the observer
+    int64_t reported_bytes = 0;
+    int64_t reported_entries = 0;
+
+    thread_store_t() {
+      const char* pt = std::getenv("LRU_CACHE_CAPACITY");
       if (pt != NULL) {
         IDEEP_ENFORCE(
             std::atoi(pt) > 0, "The LRU_CACHE_CAPACITY should be positive");
-        t_store_.resize(std::atoi(pt));
-        return std::atoi(pt);
-      } else {
-        return 0;
+        cache.resize(std::atoi(pt));
+      }
+    }
+
+    ~thread_store_t() {
+      cache.clear();
+      report();
+    }
+
+    // reports the changes since the last report, which includes the ones
+    // made by t_store() directly
+    void report() {
+      auto observer =
+          computation_cache_observer().load(std::memory_order_relaxed);
+      if (observer == nullptr) {
+        return;
+      }
+      auto bytes = static_cast<int64_t>(cache.bytes());
+      auto entries = static_cast<int64_t>(cache.size());
+      if (bytes != reported_bytes || entries != reported_entries) {
+        observer(bytes - reported_bytes, entries - reported_entries);
+        reported_bytes = bytes;
+        reported_entries = entries;
       }
-    }(std::getenv("LRU_CACHE_CAPACITY"));
-    return t_store_;
+    }
+  };
+
+  static inline thread_store_t& thread_store() {
+    static thread_local thread_store_t store;
+    return store;
   }
 };
 } // namespace utils
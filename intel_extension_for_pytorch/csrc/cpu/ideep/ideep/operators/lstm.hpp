@@ -67,6 +67,73 @@ struct lstm_forward_inference : public dnnl::lstm_forward {
          {DNNL_ARG_DST_ITER_C, dst_iter_c}});
   }
 
+  // int8 inference, of which src_layer and src_iter are u8 quantized by
+  // data_scale and data_shift, i.e. u8 = data_scale * f32 + data_shift, and
+  // the f32 weights are quantized to s8 by weights_scales, one scale per gate
+  // and output channel, or a single scale.
+  static void compute(
+      const tensor& src_layer,
+      const tensor& src_iter,
+      const tensor& src_iter_c,
+      const tensor& weights_layer,
+      const tensor& weights_iter,
+      const tensor& bias,
+      tensor& dst_layer,
+      tensor& dst_iter,
+      tensor& dst_iter_c,
+      float data_scale,
+      float data_shift,
+      const scale_t& weights_scales,
+      const bool reverse = false,
+      const engine& aengine = engine::cpu_engine()) {
+    auto direction = reverse ? rnn_direction::unidirectional_right2left
+                             : rnn_direction::unidirectional_left2right;
+    // the gates and the output channels of the ldigo weights
+    int weights_mask = weights_scales.size() > 1 ? (1 << 3) + (1 << 4) : 0;
+
+    attr_t op_attr;
+    op_attr.set_rnn_data_qparams(data_scale, data_shift);
+    op_attr.set_rnn_weights_qparams(weights_mask, weights_scales);
+
+    auto weights_layer_desc =
+        weights_layer.get_desc().to_format_any().to_type(data_type::s8);
+    auto weights_iter_desc =
+        weights_iter.get_desc().to_format_any().to_type(data_type::s8);
+
+    auto pd = primitive_desc(
+        {prop_kind::forward_inference,
+         direction,
+         src_layer.get_desc(),
+         src_iter.get_desc(),
+         src_iter_c.get_desc(),
+         weights_layer_desc,
+         weights_iter_desc,
+         bias.get_desc(),
+         dst_layer.get_desc(),
+         dst_iter.get_desc(),
+         dst_iter_c.get_desc()},
+        op_attr,
+        aengine);
+
+    attr_t weights_attr(weights_mask, weights_scales);
+    auto expected_weights_layer = weights_layer.reorder_if_differ_in(
+        pd.weights_layer_desc(), weights_attr);
+    auto expected_weights_iter = weights_iter.reorder_if_differ_in(
+        pd.weights_iter_desc(), weights_attr);
+
+    super(pd).execute(
+        stream::default_stream(),
+        {{DNNL_ARG_SRC_LAYER, src_layer},
+         {DNNL_ARG_SRC_ITER, src_iter},
+         {DNNL_ARG_SRC_ITER_C, src_iter_c},
+         {DNNL_ARG_WEIGHTS_LAYER, expected_weights_layer},
+         {DNNL_ARG_WEIGHTS_ITER, expected_weights_iter},
+         {DNNL_ARG_BIAS, bias},
+         {DNNL_ARG_DST_LAYER, dst_layer},
+         {DNNL_ARG_DST_ITER, dst_iter},
+         {DNNL_ARG_DST_ITER_C, dst_iter_c}});
+  }
+
   static std::tuple<tensor::desc, tensor::desc> expected_weights_desc(
       const dims& output_sizes,
       const tensor& src_layer,
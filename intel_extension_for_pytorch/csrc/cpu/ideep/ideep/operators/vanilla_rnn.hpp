@@ -3,26 +3,169 @@
 
 namespace ideep {
 
-struct rnn_forward : public dnnl::vanilla_rnn_forward {
+// The Elman RNN, of which the activation is given by akind, i.e. RNN_TANH or
+// RNN_RELU.
+struct rnn_forward_inference : public dnnl::vanilla_rnn_forward {
+  using super = dnnl::vanilla_rnn_forward;
+
   static void compute(
       const tensor& src_layer,
       const tensor& src_iter,
       const tensor& weights_layer,
       const tensor& weights_iter,
       const tensor& bias,
-      const dims& dst_layer_dims,
       tensor& dst_layer,
-      const dims& dst_iter_dims,
       tensor& dst_iter,
-      tensor& workspace,
       rnn_kind akind,
-      dnnl_rnn_direction_t direction,
-      prop_kind aprop_kind = prop_kind::forward_training) {}
+      const bool reverse = false,
+      const prop_kind aprop = prop_kind::forward_inference,
+      const engine& aengine = engine::cpu_engine()) {
+    auto direction = reverse ? rnn_direction::unidirectional_right2left
+                             : rnn_direction::unidirectional_left2right;
+
+    // use any format for weights
+    auto weights_layer_desc = weights_layer.get_desc().to_format_any();
+    auto weights_iter_desc = weights_iter.get_desc().to_format_any();
+
+    auto pd = primitive_desc(
+        {aprop,
+         utils::rnn_kind_to_activation(akind),
+         direction,
+         src_layer.get_desc(),
+         src_iter.get_desc(),
+         weights_layer_desc,
+         weights_iter_desc,
+         bias.get_desc(),
+         dst_layer.get_desc(),
+         dst_iter.get_desc()},
+        aengine);
+
+    auto expected_weights_layer =
+        weights_layer.reorder_if_differ_in(pd.weights_layer_desc());
+    auto expected_weights_iter =
+        weights_iter.reorder_if_differ_in(pd.weights_iter_desc());
+
+    super(pd).execute(
+        stream::default_stream(),
+        {{DNNL_ARG_SRC_LAYER, src_layer},
+         {DNNL_ARG_SRC_ITER, src_iter},
+         {DNNL_ARG_WEIGHTS_LAYER, expected_weights_layer},
+         {DNNL_ARG_WEIGHTS_ITER, expected_weights_iter},
+         {DNNL_ARG_BIAS, bias},
+         {DNNL_ARG_DST_LAYER, dst_layer},
+         {DNNL_ARG_DST_ITER, dst_iter}});
+  }
+
+  static std::tuple<tensor::desc, tensor::desc> expected_weights_desc(
+      const dims& output_sizes,
+      const tensor& src_layer,
+      const tensor& src_iter,
+      const tensor& weights_layer,
+      const tensor& weights_iter,
+      const tensor& bias,
+      rnn_kind akind,
+      const bool reverse = false,
+      prop_kind aprop = prop_kind::forward_inference,
+      const engine& aengine = engine::cpu_engine()) {
+    auto direction = reverse ? rnn_direction::unidirectional_right2left
+                             : rnn_direction::unidirectional_left2right;
+
+    auto src_iter_desc = src_iter.get_desc();
+    auto weights_layer_desc = weights_layer.get_desc().to_format_any();
+    auto weights_iter_desc = weights_iter.get_desc().to_format_any();
+    tensor::desc dst_layer_desc(
+        output_sizes, src_layer.get_data_type(), tag::tnc);
+
+    auto pd = primitive_desc(
+        {aprop,
+         utils::rnn_kind_to_activation(akind),
+         direction,
+         src_layer.get_desc(),
+         src_iter_desc,
+         weights_layer_desc,
+         weights_iter_desc,
+         bias.get_desc(),
+         dst_layer_desc,
+         src_iter_desc},
+        aengine);
+
+    return std::make_tuple(pd.weights_layer_desc(), pd.weights_iter_desc());
+  }
+};
+
+struct rnn_forward_training : public dnnl::vanilla_rnn_forward {
+  using super = dnnl::vanilla_rnn_forward;
+
+  static primitive_desc prepare(
+      const tensor& src_layer,
+      const tensor& src_iter,
+      const tensor& weights_layer,
+      const tensor& weights_iter,
+      const tensor& bias,
+      tensor& dst_layer,
+      tensor& dst_iter,
+      rnn_kind akind,
+      const bool reverse = false,
+      const engine& aengine = engine::cpu_engine()) {
+    auto direction = reverse ? rnn_direction::unidirectional_right2left
+                             : rnn_direction::unidirectional_left2right;
+
+    // use any format for weights
+    auto weights_layer_desc = weights_layer.get_desc().to_format_any();
+    auto weights_iter_desc = weights_iter.get_desc().to_format_any();
+
+    auto pd = primitive_desc(
+        {prop_kind::forward_training,
+         utils::rnn_kind_to_activation(akind),
+         direction,
+         src_layer.get_desc(),
+         src_iter.get_desc(),
+         weights_layer_desc,
+         weights_iter_desc,
+         bias.get_desc(),
+         dst_layer.get_desc(),
+         dst_iter.get_desc()},
+        aengine);
+    return pd;
+  }
+
+  static void compute(
+      const primitive_desc& pd,
+      const tensor& src_layer,
+      const tensor& src_iter,
+      const tensor& weights_layer,
+      const tensor& weights_iter,
+      const tensor& bias,
+      const tensor& workspace,
+      tensor& dst_layer,
+      tensor& dst_iter,
+      const engine& aengine = engine::cpu_engine()) {
+    auto expected_weights_layer =
+        weights_layer.reorder_if_differ_in(pd.weights_layer_desc());
+    auto expected_weights_iter =
+        weights_iter.reorder_if_differ_in(pd.weights_iter_desc());
+
+    dst_layer.reinit_if_possible(pd.dst_layer_desc());
+    dst_iter.reinit_if_possible(pd.dst_iter_desc());
+
+    super(pd).execute(
+        stream::default_stream(),
+        {{DNNL_ARG_SRC_LAYER, src_layer},
+         {DNNL_ARG_SRC_ITER, src_iter},
+         {DNNL_ARG_WEIGHTS_LAYER, expected_weights_layer},
+         {DNNL_ARG_WEIGHTS_ITER, expected_weights_iter},
+         {DNNL_ARG_BIAS, bias},
+         {DNNL_ARG_DST_LAYER, dst_layer},
+         {DNNL_ARG_DST_ITER, dst_iter},
+         {DNNL_ARG_WORKSPACE, workspace}});
+  }
 };
 
 struct rnn_backward : public dnnl::vanilla_rnn_backward {
-  template <class alloc = utils::allocator>
+  using super = dnnl::vanilla_rnn_backward;
+
   static void compute(
+      const dnnl::vanilla_rnn_forward::primitive_desc& forward_hints,
       const tensor& src_layer,
       const tensor& src_iter,
       const tensor& weights_layer,
@@ -33,17 +176,88 @@ struct rnn_backward : public dnnl::vanilla_rnn_backward {
       const tensor& diff_dst_layer,
       const tensor& diff_dst_iter,
       const tensor& workspace,
-      const bool with_bias,
       tensor& diff_src_layer,
       tensor& diff_src_iter,
       tensor& diff_weights_layer,
       tensor& diff_weights_iter,
       tensor& diff_bias,
       rnn_kind akind,
-      dnnl_rnn_direction_t direction,
-      prop_kind aprop_kind = prop_kind::backward) {}
+      const bool reverse = false,
+      const engine& aengine = engine::cpu_engine()) {
+    auto direction = reverse ? rnn_direction::unidirectional_right2left
+                             : rnn_direction::unidirectional_left2right;
+    auto src_layer_desc = src_layer.get_desc();
+    auto src_iter_desc = src_iter.get_desc();
+    auto bias_desc = bias.get_desc();
+    auto dst_layer_desc = dst_layer.get_desc();
+    auto dst_iter_desc = dst_iter.get_desc();
+
+    // use any format for weights
+    auto weights_layer_desc = weights_layer.get_desc().to_format_any();
+    auto weights_iter_desc = weights_iter.get_desc().to_format_any();
+
+    auto pd = primitive_desc(
+        {prop_kind::backward,
+         utils::rnn_kind_to_activation(akind),
+         direction,
+         src_layer_desc,
+         src_iter_desc,
+         weights_layer_desc,
+         weights_iter_desc,
+         bias_desc,
+         dst_layer_desc,
+         dst_iter_desc,
+         src_layer_desc.to_type(data_type::f32),
+         src_iter_desc.to_type(data_type::f32),
+         weights_layer_desc.to_type(data_type::f32),
+         weights_iter_desc.to_type(data_type::f32),
+         bias_desc.to_type(data_type::f32),
+         dst_layer_desc.to_type(data_type::f32),
+         dst_iter_desc.to_type(data_type::f32)},
+        aengine,
+        forward_hints);
+
+    auto expected_weights_layer =
+        weights_layer.reorder_if_differ_in(pd.weights_layer_desc());
+    auto expected_weights_iter =
+        weights_iter.reorder_if_differ_in(pd.weights_iter_desc());
+
+    diff_src_layer.reinit_if_possible(pd.diff_src_layer_desc());
+    diff_src_iter.reinit_if_possible(pd.diff_src_iter_desc());
+
+    // workaround: diff_weights_layer, diff_weights_iter and diff_bias need to
+    // clear before operation begin.
+    tensor expected_diff_weights_layer;
+    expected_diff_weights_layer.zero_init(pd.diff_weights_layer_desc());
+    tensor expected_diff_weights_iter;
+    expected_diff_weights_iter.zero_init(pd.diff_weights_iter_desc());
+    tensor expected_diff_bias;
+    expected_diff_bias.zero_init(pd.diff_bias_desc());
+
+    super(pd).execute(
+        stream::default_stream(),
+        {{DNNL_ARG_SRC_LAYER, src_layer},
+         {DNNL_ARG_SRC_ITER, src_iter},
+         {DNNL_ARG_WEIGHTS_LAYER, expected_weights_layer},
+         {DNNL_ARG_WEIGHTS_ITER, expected_weights_iter},
+         {DNNL_ARG_BIAS, bias},
+         {DNNL_ARG_DST_LAYER, dst_layer},
+         {DNNL_ARG_DST_ITER, dst_iter},
+         {DNNL_ARG_DIFF_SRC_LAYER, diff_src_layer},
+         {DNNL_ARG_DIFF_SRC_ITER, diff_src_iter},
+         {DNNL_ARG_DIFF_WEIGHTS_LAYER, expected_diff_weights_layer},
+         {DNNL_ARG_DIFF_WEIGHTS_ITER, expected_diff_weights_iter},
+         {DNNL_ARG_DIFF_BIAS, expected_diff_bias},
+         {DNNL_ARG_DIFF_DST_LAYER, diff_dst_layer},
+         {DNNL_ARG_DIFF_DST_ITER, diff_dst_iter},
+         {DNNL_ARG_WORKSPACE, workspace}});
+
+    diff_weights_layer.feed_from(expected_diff_weights_layer);
+    diff_weights_iter.feed_from(expected_diff_weights_iter);
+    diff_bias.feed_from(expected_diff_bias);
+  }
 };
 
 } // namespace ideep
 
-#endif
\ No newline at end of file
+#endif
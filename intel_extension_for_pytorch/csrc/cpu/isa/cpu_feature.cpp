@@ -1,5 +1,6 @@
 #include "cpu_feature.hpp"
 #include <stdio.h>
+#include <cstdint>
 #include "embedded_function.h"
 
 namespace torch_ipex {
@@ -324,5 +325,80 @@ void CPUFeature::show_features() {
   MICRO_CLASS_PRINT_BOOL_STATUS(prefetchwt1);
 #endif
 }
+
+static void append_feature(
+    std::string& features,
+    const char* p_name,
+    bool b_status) {
+  if (b_status) {
+    if (!features.empty()) {
+      features += ",";
+    }
+    features += p_name;
+  }
+}
+
+std::string CPUFeature::features() {
+  std::string features;
+  MICRO_CLASS_APPEND_FEATURE(features, mmx);
+  MICRO_CLASS_APPEND_FEATURE(features, sse);
+  MICRO_CLASS_APPEND_FEATURE(features, sse2);
+  MICRO_CLASS_APPEND_FEATURE(features, sse3);
+  MICRO_CLASS_APPEND_FEATURE(features, ssse3);
+  MICRO_CLASS_APPEND_FEATURE(features, sse4_1);
+  MICRO_CLASS_APPEND_FEATURE(features, sse4_2);
+  MICRO_CLASS_APPEND_FEATURE(features, aes_ni);
+  MICRO_CLASS_APPEND_FEATURE(features, sha);
+
+  MICRO_CLASS_APPEND_FEATURE(features, xsave);
+
+  MICRO_CLASS_APPEND_FEATURE(features, avx);
+  MICRO_CLASS_APPEND_FEATURE(features, avx2);
+  MICRO_CLASS_APPEND_FEATURE(features, avx_vnni);
+
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_f);
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_cd);
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_pf);
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_er);
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_vl);
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_bw);
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_dq);
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_ifma);
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_vbmi);
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_vpopcntdq);
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_4fmaps);
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_4vnniw);
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_vbmi2);
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_vpclmul);
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_vnni);
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_bitalg);
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_fp16);
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_bf16);
+  MICRO_CLASS_APPEND_FEATURE(features, avx512_vp2intersect);
+
+  MICRO_CLASS_APPEND_FEATURE(features, amx_bf16);
+  MICRO_CLASS_APPEND_FEATURE(features, amx_tile);
+  MICRO_CLASS_APPEND_FEATURE(features, amx_int8);
+
+  MICRO_CLASS_APPEND_FEATURE(features, prefetchw);
+  MICRO_CLASS_APPEND_FEATURE(features, prefetchwt1);
+
+  append_feature(features, "os_avx", os_avx());
+  append_feature(features, "os_avx2", os_avx2());
+  append_feature(features, "os_avx512", os_avx512());
+  append_feature(features, "os_amx", os_amx());
+  return features;
+}
+
+std::string CPUFeature::fingerprint() {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (unsigned char c : features()) {
+    hash ^= c;
+    hash *= 0x100000001b3ull;
+  }
+  char hex[17];
+  snprintf(hex, sizeof(hex), "%016llx", static_cast<unsigned long long>(hash));
+  return hex;
+}
 } // namespace cpu
-} // namespace torch_ipex
\ No newline at end of file
+} // namespace torch_ipex
@@ -8,6 +8,10 @@
   }
 #define MICRO_CLASS_PRINT_BOOL_STATUS(feature_name) \
   print_bool_status(#feature_name, m_##feature_name)
+#define MICRO_CLASS_APPEND_FEATURE(features, feature_name) \
+  append_feature(features, #feature_name, m_##feature_name)
+
+#include <string>
 
 namespace torch_ipex {
 namespace cpu {
@@ -20,6 +24,12 @@ class CPUFeature {
  public:
   static CPUFeature& get_instance();
   void show_features();
+  // The names of the features supported by the CPU and enabled by the OS,
+  // separated by commas, e.g. "sse,...,avx512_f,...,os_avx512"
+  std::string features();
+  // The 16 hex digits of the FNV-1a hash of features(), which is the same on
+  // the machines of the same ISA, e.g. to key the results of the benchmarks
+  std::string fingerprint();
 
  public:
   bool os_avx();
@@ -1,5 +1,6 @@
 #include <stdio.h>
 #include "cpu_feature.hpp"
+#include "cpu_info.hpp"
 #include "embedded_function.h"
 
 using namespace torch_ipex::cpu;
@@ -35,6 +36,23 @@ int main() {
       CPUFeature::get_instance().os_amx() ? "true" : "false");
   CPUFeature::get_instance().show_features();
 
+  const auto& cpu_info = CPUInfo::get_instance();
+  printf(
+      "micro arch: %s (%02x_%02x stepping %u)\n",
+      cpu_info.micro_arch_name(),
+      cpu_info.family(),
+      cpu_info.model(),
+      cpu_info.stepping());
+  printf(
+      "L1d: %ld, L2: %ld, L3: %ld bytes\n",
+      (long)cpu_info.l1d().size,
+      (long)cpu_info.l2().size,
+      (long)cpu_info.l3().size);
+  printf(
+      "threads per core: %ld, cores per L3: %ld\n",
+      (long)cpu_info.threads_per_core(),
+      (long)cpu_info.cores_per_l3());
+
   return 0;
 }
 #endif
\ No newline at end of file
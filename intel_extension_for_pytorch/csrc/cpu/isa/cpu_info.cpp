@@ -0,0 +1,253 @@
+#include "cpu_info.hpp"
+
+#include <string.h>
+#include <algorithm>
+
+#include "embedded_function.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+// The caches assumed if CPUID doesn't enumerate them, of Skylake-SP.
+const int64_t kDefaultL1dSize = 32 * 1024;
+const int64_t kDefaultL2Size = 1024 * 1024;
+const int64_t kDefaultL3Size = 32 * 1024 * 1024;
+
+// The tuning of the microarchitecture, of which the cache dependent fields
+// are set from the caches by init_tuning.
+struct MicroArchTuning {
+  CPUMicroArch micro_arch;
+  const char* name;
+  int64_t emb_prefetch_lines;
+  int64_t emb_max_prefetch_distance;
+  int64_t interaction_block_size;
+  int64_t avx512_fma_units;
+};
+
+// Sunny Cove and Golden Cove track more L2 misses than Skylake, so that the
+// embedding gathers keep more rows in flight. The 2MB L2 of Golden Cove fits
+// the interaction inputs of blocks of 32 samples, which halves the matmul
+// executions of the blocks.
+const MicroArchTuning micro_arch_tunings[] = {
+    {CPUMicroArch::GENERIC, "generic", 32, 16, 16, 1},
+    {CPUMicroArch::SKYLAKE_X, "skylake_x", 32, 16, 16, 2},
+    {CPUMicroArch::COOPER_LAKE, "cooper_lake", 32, 16, 16, 2},
+    {CPUMicroArch::ICELAKE_X, "icelake_x", 48, 16, 16, 2},
+    {CPUMicroArch::SAPPHIRE_RAPIDS, "sapphire_rapids", 48, 16, 32, 2},
+    {CPUMicroArch::EMERALD_RAPIDS, "emerald_rapids", 48, 16, 32, 2},
+};
+
+static_assert(
+    sizeof(micro_arch_tunings) / sizeof(micro_arch_tunings[0]) ==
+        static_cast<size_t>(CPUMicroArch::NUM_OPTIONS),
+    "Every CPUMicroArch must have a tuning");
+
+const MicroArchTuning& get_micro_arch_tuning(CPUMicroArch micro_arch) {
+  return micro_arch_tunings[static_cast<int>(micro_arch)];
+}
+
+} // namespace
+
+CPUInfo::CPUInfo() {
+  uint32_t eax = 0;
+  uint32_t ebx = 0;
+  uint32_t ecx = 0;
+  uint32_t edx = 0;
+
+  read_cpuid(0, &eax, &ebx, &ecx, &edx);
+  uint32_t max_basic_id = eax;
+  // the vendor string is of EBX, EDX and ECX
+  char vendor[13] = {0};
+  memcpy(vendor, &ebx, 4);
+  memcpy(vendor + 4, &edx, 4);
+  memcpy(vendor + 8, &ecx, 4);
+  intel_ = strcmp(vendor, "GenuineIntel") == 0;
+  amd_ = strcmp(vendor, "AuthenticAMD") == 0;
+
+  read_cpuid(0x80000000, &eax, &ebx, &ecx, &edx);
+  uint32_t max_extend_id = eax;
+
+  if (max_basic_id >= 0x00000001) {
+    detect_model();
+  }
+  if (intel_ && max_basic_id >= 0x00000004) {
+    detect_caches(0x00000004);
+  } else if (amd_ && max_extend_id >= 0x8000001D) {
+    detect_caches(0x8000001D);
+  }
+  if (max_basic_id >= 0x0000000B) {
+    detect_topology();
+  }
+  init_tuning();
+}
+
+const CPUInfo& CPUInfo::get_instance() {
+  static CPUInfo _instance;
+
+  return _instance;
+}
+
+void CPUInfo::detect_model() {
+  uint32_t eax = 0;
+  uint32_t ebx = 0;
+  uint32_t ecx = 0;
+  uint32_t edx = 0;
+
+  /*
+  Intel® 64 and IA-32 Architectures Software Developer’s Manual, CPUID:
+  the DisplayFamily is the Family ID plus the Extended Family ID if the
+  Family ID is 0FH, and the DisplayModel is the Model ID plus the Extended
+  Model ID shifted left by 4 if the Family ID is 06H or 0FH.
+  */
+  read_cpuid(0x00000001, &eax, &ebx, &ecx, &edx);
+  stepping_ = BIT_M_TO_N(eax, 0, 3);
+  uint32_t model = BIT_M_TO_N(eax, 4, 7);
+  uint32_t family = BIT_M_TO_N(eax, 8, 11);
+  uint32_t ext_model = BIT_M_TO_N(eax, 16, 19);
+  uint32_t ext_family = BIT_M_TO_N(eax, 20, 27);
+  family_ = family == 0xF ? family + ext_family : family;
+  model_ = (family == 0x6 || family == 0xF) ? (ext_model << 4) + model : model;
+
+  if (!intel_ || family_ != 0x6) {
+    return;
+  }
+  switch (model_) {
+    case 0x55:
+      micro_arch_ = stepping_ >= 10 ? CPUMicroArch::COOPER_LAKE
+                                    : CPUMicroArch::SKYLAKE_X;
+      break;
+    case 0x6A:
+    case 0x6C:
+      micro_arch_ = CPUMicroArch::ICELAKE_X;
+      break;
+    case 0x8F:
+      micro_arch_ = CPUMicroArch::SAPPHIRE_RAPIDS;
+      break;
+    case 0xCF:
+      micro_arch_ = CPUMicroArch::EMERALD_RAPIDS;
+      break;
+    default:
+      break;
+  }
+}
+
+void CPUInfo::detect_caches(uint32_t leaf) {
+  uint32_t eax = 0;
+  uint32_t ebx = 0;
+  uint32_t ecx = 0;
+  uint32_t edx = 0;
+
+  /*
+  Deterministic Cache Parameters Leaf (EAX = 04H, and EAX = 8000001DH of AMD
+  of the same layout), a sub-leaf per cache:
+  EAX:
+      Bits 04-00: Cache Type Field, 0 = Null (no more caches), 1 = Data,
+                  2 = Instruction, 3 = Unified
+      Bits 07-05: Cache Level (starts at 1)
+      Bits 25-14: Maximum number of addressable IDs for logical processors
+                  sharing this cache, minus 1
+  EBX:
+      Bits 11-00: L = System Coherency Line Size, minus 1
+      Bits 21-12: P = Physical Line partitions, minus 1
+      Bits 31-22: W = Ways of associativity, minus 1
+  ECX: S = Number of Sets, minus 1
+  The cache size in bytes = (W + 1) * (P + 1) * (L + 1) * (S + 1).
+  */
+  for (uint32_t sub_leaf = 0; sub_leaf < 16; sub_leaf++) {
+    read_cpuidex(leaf, sub_leaf, &eax, &ebx, &ecx, &edx);
+    uint32_t type = BIT_M_TO_N(eax, 0, 4);
+    if (type == 0) {
+      break;
+    }
+    if (type == 2) {
+      continue;
+    }
+    CacheInfo cache;
+    cache.line_size = BIT_M_TO_N(ebx, 0, 11) + 1;
+    int64_t partitions = BIT_M_TO_N(ebx, 12, 21) + 1;
+    int64_t ways = BIT_M_TO_N(ebx, 22, 31) + 1;
+    int64_t sets = static_cast<int64_t>(ecx) + 1;
+    cache.size = ways * partitions * cache.line_size * sets;
+    cache.shared_threads = BIT_M_TO_N(eax, 14, 25) + 1;
+    switch (BIT_M_TO_N(eax, 5, 7)) {
+      case 1:
+        l1d_ = cache;
+        break;
+      case 2:
+        l2_ = cache;
+        break;
+      case 3:
+        l3_ = cache;
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+void CPUInfo::detect_topology() {
+  uint32_t eax = 0;
+  uint32_t ebx = 0;
+  uint32_t ecx = 0;
+  uint32_t edx = 0;
+
+  /*
+  Extended Topology Enumeration Leaf (EAX = 0BH), a sub-leaf per level:
+  EBX:
+      Bits 15-00: Number of logical processors at this level type
+  ECX:
+      Bits 15-08: Level type, 0 = Invalid, 1 = SMT, 2 = Core
+  */
+  for (uint32_t sub_leaf = 0; sub_leaf < 8; sub_leaf++) {
+    read_cpuidex(0x0000000B, sub_leaf, &eax, &ebx, &ecx, &edx);
+    uint32_t level_type = BIT_M_TO_N(ecx, 8, 15);
+    int64_t threads = BIT_M_TO_N(ebx, 0, 15);
+    if (level_type == 0) {
+      break;
+    }
+    if (level_type == 1 && threads > 0) {
+      threads_per_core_ = threads;
+    } else if (level_type == 2) {
+      threads_per_package_ = threads;
+    }
+  }
+}
+
+void CPUInfo::init_tuning() {
+  const auto& micro_arch_tuning = get_micro_arch_tuning(micro_arch_);
+  auto& cpu_feature = CPUFeature::get_instance();
+  bool avx512 = cpu_feature.os_avx512() && cpu_feature.cpuid_avx512_f();
+  avx512_fma_units_ = avx512 ? micro_arch_tuning.avx512_fma_units : 0;
+
+  int64_t l1d_size = l1d_.size > 0 ? l1d_.size : kDefaultL1dSize;
+  int64_t l2_size = l2_.size > 0 ? l2_.size : kDefaultL2Size;
+  int64_t l3_size = l3_.size > 0 ? l3_.size : kDefaultL3Size;
+  tuning_.emb_prefetch_lines = micro_arch_tuning.emb_prefetch_lines;
+  tuning_.emb_max_prefetch_distance =
+      micro_arch_tuning.emb_max_prefetch_distance;
+  tuning_.interaction_block_size = micro_arch_tuning.interaction_block_size;
+  tuning_.cumsum_chunk_bytes = l2_size / 4;
+  tuning_.online_softmax_min_size = l1d_size / 8 / sizeof(float);
+  tuning_.op_min_work_per_thread = l1d_size / 2 / sizeof(float);
+  tuning_.stream_store_min_bytes = l3_size / 2;
+}
+
+const char* CPUInfo::micro_arch_name() const {
+  return get_micro_arch_tuning(micro_arch_).name;
+}
+
+int64_t CPUInfo::cores_per_l3() const {
+  if (l3_.size == 0) {
+    return 0;
+  }
+  int64_t threads = l3_.shared_threads;
+  if (threads_per_package_ > 0) {
+    threads = std::min(threads, threads_per_package_);
+  }
+  return std::max<int64_t>(1, threads / threads_per_core_);
+}
+
+} // namespace cpu
+} // namespace torch_ipex
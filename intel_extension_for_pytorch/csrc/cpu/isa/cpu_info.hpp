@@ -0,0 +1,148 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "cpu_feature.hpp"
+
+namespace torch_ipex {
+namespace cpu {
+
+// The microarchitectures of which the kernels have a tuning of their own,
+// detected from the family / model / stepping of CPUID leaf 1.
+enum class CPUMicroArch {
+  GENERIC = 0,
+  // Skylake-SP and Cascade Lake, 06_55 of the steppings 0 - 7
+  SKYLAKE_X,
+  // 06_55 of the steppings 10 - 11
+  COOPER_LAKE,
+  // 06_6A and 06_6C
+  ICELAKE_X,
+  // 06_8F
+  SAPPHIRE_RAPIDS,
+  // 06_CF
+  EMERALD_RAPIDS,
+  NUM_OPTIONS
+};
+
+struct CacheInfo {
+  // bytes, 0 if the CPU doesn't have or doesn't enumerate the cache
+  int64_t size = 0;
+  int64_t line_size = 64;
+  // the max logical processors sharing the cache, an upper bound of the
+  // ones present
+  int64_t shared_threads = 1;
+};
+
+// The blocking factors, prefetch distances and thread thresholds of the
+// hand-written kernels. The prefetch and blocking ones come from the table of
+// the microarchitecture, the others are derived from the detected caches.
+struct CPUTuning {
+  // the cache lines of the embedding rows the gathers keep in flight, about
+  // the L1 / L2 misses a core can track, beyond which the prefetches drop
+  int64_t emb_prefetch_lines;
+  // the most indices the embedding gathers prefetch ahead
+  int64_t emb_max_prefetch_distance;
+  // the samples of which the interaction matmuls are batched
+  int64_t interaction_block_size;
+  // the bytes of the chunk of the cumsum of each thread, a quarter of L2
+  int64_t cumsum_chunk_bytes;
+  // the size of the last dim from which the softmax of it is memory bound,
+  // i.e. the float rows beyond an eighth of L1d
+  int64_t online_softmax_min_size;
+  // the default min work per thread of the ops of the thread policy, the
+  // float elements of half of L1d
+  int64_t op_min_work_per_thread;
+  // the bytes of the output from which the kernels write it by the
+  // non-temporal stores, half of the LLC, beyond which the output is evicted
+  // before the next op reads it
+  int64_t stream_store_min_bytes;
+};
+
+/*CPUInfo describes the running CPU for the kernels: the ISA features of
+ * CPUFeature, the data caches of CPUID leaf 4 (0x8000001D on AMD), the SMT
+ * layout of leaf 0xB, and the tuning of the microarchitecture. It is detected
+ * once and read only after that.*/
+class CPUInfo {
+ public:
+  static const CPUInfo& get_instance();
+
+  CPUFeature& features() const {
+    return CPUFeature::get_instance();
+  }
+
+  CPUMicroArch micro_arch() const {
+    return micro_arch_;
+  }
+  const char* micro_arch_name() const;
+  uint32_t family() const {
+    return family_;
+  }
+  uint32_t model() const {
+    return model_;
+  }
+  uint32_t stepping() const {
+    return stepping_;
+  }
+
+  const CacheInfo& l1d() const {
+    return l1d_;
+  }
+  const CacheInfo& l2() const {
+    return l2_;
+  }
+  const CacheInfo& l3() const {
+    return l3_;
+  }
+
+  // the logical processors of a core, 1 without SMT
+  int64_t threads_per_core() const {
+    return threads_per_core_;
+  }
+  // the cores sharing the L3, i.e. the cores of the socket on the Xeons of
+  // which SNC is off, 0 without L3
+  int64_t cores_per_l3() const;
+  // the 512-bit FMA units of a core, which are 2 on most of the Xeons of
+  // AVX-512 but not enumerated by CPUID, 0 without AVX-512
+  int64_t avx512_fma_units() const {
+    return avx512_fma_units_;
+  }
+
+  const CPUTuning& tuning() const {
+    return tuning_;
+  }
+
+ private:
+  CPUInfo();
+
+  void detect_model();
+  void detect_caches(uint32_t leaf);
+  void detect_topology();
+  void init_tuning();
+
+  CPUInfo(const CPUInfo&) = delete;
+  CPUInfo& operator=(const CPUInfo&) = delete;
+
+  bool intel_ = false;
+  bool amd_ = false;
+  uint32_t family_ = 0;
+  uint32_t model_ = 0;
+  uint32_t stepping_ = 0;
+  CPUMicroArch micro_arch_ = CPUMicroArch::GENERIC;
+
+  CacheInfo l1d_;
+  CacheInfo l2_;
+  CacheInfo l3_;
+  int64_t threads_per_core_ = 1;
+  // the logical processors of the package, 0 if not enumerated
+  int64_t threads_per_package_ = 0;
+  int64_t avx512_fma_units_ = 0;
+
+  CPUTuning tuning_;
+};
+
+inline const CPUTuning& cpu_tuning() {
+  return CPUInfo::get_instance().tuning();
+}
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -1,4 +1,12 @@
 #include "CPUPool.h"
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#ifndef MPOL_PREFERRED
+#define MPOL_PREFERRED 1
+#endif
+
 namespace torch_ipex {
 namespace runtime {
 
@@ -8,12 +16,28 @@ kmp_set_affinity_mask_proc_p kmp_set_affinity_mask_proc_ext;
 kmp_set_affinity_p kmp_set_affinity_ext;
 kmp_destroy_affinity_mask_p kmp_destroy_affinity_mask_ext;
 kmp_get_affinity_p kmp_get_affinity_ext;
+// Optional, nullptr if not exported by the OpenMP runtime.
+kmp_set_blocktime_p kmp_set_blocktime_ext;
 
 std::once_flag
     iomp_symbol_loading_call_once_flag; // call_once_flag to ensure the iomp
                                         // symbol loaded once globally
 bool iomp_symbol_loaded{
     false}; // Notice: iomp_symbol_loaded is not thread safe.
+
+// The cores the OMP threads of the current thread are pinned to by
+// _pin_cpu_cores, empty if not pinned by the runtime API.
+thread_local std::vector<int32_t> pinned_cpu_core_list;
+
+const int32_t kBitsPerMask = sizeof(unsigned long) * 8;
+
+// The nodemask of the set_mempolicy / mbind of the numa_node_id only.
+std::vector<unsigned long> numa_node_mask(int32_t numa_node_id) {
+  std::vector<unsigned long> node_mask(numa_node_id / kBitsPerMask + 1, 0);
+  node_mask[numa_node_id / kBitsPerMask] |= 1UL
+      << (numa_node_id % kBitsPerMask);
+  return node_mask;
+}
 } // namespace
 
 void loading_iomp_symbol() {
@@ -35,6 +59,8 @@ void loading_iomp_symbol() {
   kmp_get_affinity_ext = (kmp_get_affinity_p)dlsym(handle, "kmp_get_affinity");
   kmp_destroy_affinity_mask_ext =
       (kmp_destroy_affinity_mask_p)dlsym(handle, "kmp_destroy_affinity_mask");
+  kmp_set_blocktime_ext =
+      (kmp_set_blocktime_p)dlsym(handle, "kmp_set_blocktime");
 
   iomp_symbol_loaded = true;
   return;
@@ -73,6 +99,72 @@ void _pin_cpu_cores(const std::vector<int32_t>& cpu_core_list) {
     kmp_set_affinity_ext(&mask);
     kmp_destroy_affinity_mask_ext(&mask);
   }
+  pinned_cpu_core_list = cpu_core_list;
+  return;
+}
+
+const std::vector<int32_t>& _get_pinned_cpu_core_list() {
+  return pinned_cpu_core_list;
+}
+
+bool _set_preferred_numa_node(int32_t numa_node_id) {
+  if (numa_node_id < 0) {
+    return false;
+  }
+  // The memory of the calling thread is preferred to be allocated on
+  // numa_node_id, and falls back to other nodes when it's out of memory.
+  auto node_mask = numa_node_mask(numa_node_id);
+  return syscall(
+             SYS_set_mempolicy,
+             MPOL_PREFERRED,
+             node_mask.data(),
+             node_mask.size() * kBitsPerMask + 1) == 0;
+}
+
+bool _bind_memory_to_numa_node(void* ptr, size_t bytes, int32_t numa_node_id) {
+  if (numa_node_id < 0) {
+    return false;
+  }
+  // Only the whole pages of the range are bound, of which the ones not
+  // touched yet are allocated on numa_node_id, the memory policy of the
+  // calling thread is left as is.
+  const uintptr_t page_size = sysconf(_SC_PAGESIZE);
+  uintptr_t begin = (reinterpret_cast<uintptr_t>(ptr) + page_size - 1) /
+      page_size * page_size;
+  uintptr_t end = (reinterpret_cast<uintptr_t>(ptr) + bytes) / page_size *
+      page_size;
+  if (begin >= end) {
+    return false;
+  }
+  auto node_mask = numa_node_mask(numa_node_id);
+  return syscall(
+             SYS_mbind,
+             begin,
+             end - begin,
+             MPOL_PREFERRED,
+             node_mask.data(),
+             node_mask.size() * kBitsPerMask + 1,
+             0) == 0;
+}
+
+bool _set_omp_blocktime(int32_t blocktime_ms) {
+  if (!is_runtime_ext_enabled() || kmp_set_blocktime_ext == nullptr) {
+    return false;
+  }
+  kmp_set_blocktime_ext(blocktime_ms);
+  return true;
+}
+
+void _pin_cpu_cores(
+    const std::vector<int32_t>& cpu_core_list,
+    int32_t numa_node_id) {
+  _pin_cpu_cores(cpu_core_list);
+  if (numa_node_id < 0) {
+    return;
+  }
+  _set_preferred_numa_node(numa_node_id);
+#pragma omp parallel num_threads(cpu_core_list.size())
+  { _set_preferred_numa_node(numa_node_id); }
   return;
 }
 
@@ -92,7 +184,9 @@ CPUPool get_cpu_pool_from_mask_affinity() {
     kmp_get_affinity_ext(&mask);
     threads_mask[thread_id] = mask;
   }
-  return CPUPool(std::move(threads_mask));
+  CPUPool cpu_pool(std::move(threads_mask));
+  cpu_pool.pinned_cpu_core_list = pinned_cpu_core_list;
+  return cpu_pool;
 }
 
 void set_mask_affinity_from_cpu_pool(const CPUPool& cpu_pool) {
@@ -110,6 +204,7 @@ void set_mask_affinity_from_cpu_pool(const CPUPool& cpu_pool) {
     kmp_affinity_mask_t mask = threads_mask[thread_id];
     kmp_set_affinity_ext(&mask);
   }
+  pinned_cpu_core_list = cpu_pool.pinned_cpu_core_list;
 }
 
 CPUPool::CPUPool(const std::vector<int32_t>& cpu_core_list) {
@@ -123,6 +218,13 @@ CPUPool::CPUPool(const std::vector<int32_t>& cpu_core_list) {
   this->cpu_core_list_initialized_ = true;
 }
 
+CPUPool::CPUPool(
+    const std::vector<int32_t>& cpu_core_list,
+    int32_t numa_node_id)
+    : CPUPool(cpu_core_list) {
+  this->numa_node_id = numa_node_id;
+}
+
 CPUPool::CPUPool(std::vector<kmp_affinity_mask_t>&& cpu_core_mask) {
   // Notice: We shouldn't load iomp symbol in sub_thread, otherwise race
   // condition happens.
@@ -140,6 +242,10 @@ CPUPool::CPUPool(CPUPool&& source_cpu_pool) {
     throw std::runtime_error(
         "Fail to CPUPool move construct. Neither cpu_core_list_initialized_ and cpu_affinity_mask_initialized_ init.");
   }
+  this->numa_node_id = source_cpu_pool.get_numa_node_id();
+  this->memory_arena = source_cpu_pool.get_memory_arena();
+  this->spin_time_us = source_cpu_pool.get_spin_time_us();
+  this->pinned_cpu_core_list = source_cpu_pool.pinned_cpu_core_list;
   if (source_cpu_pool.is_cpu_core_list_initialized()) {
     this->cpu_core_list = std::move(
         const_cast<std::vector<int32_t>&>(source_cpu_pool.get_cpu_core_list()));
@@ -176,6 +282,31 @@ bool CPUPool::is_cpu_affinity_mask_initialized() const {
   return this->cpu_affinity_mask_initialized_;
 }
 
+int32_t CPUPool::get_numa_node_id() const {
+  return this->numa_node_id;
+}
+
+void CPUPool::enable_memory_arena() {
+  if (!this->memory_arena) {
+    this->memory_arena = MemoryArena::create();
+  }
+}
+
+std::shared_ptr<MemoryArena> CPUPool::get_memory_arena() const {
+  return this->memory_arena;
+}
+
+void CPUPool::set_spin_time_us(int64_t spin_time_us) {
+  if (spin_time_us < 0) {
+    throw std::runtime_error("spin_time_us of CPUPool must be >= 0");
+  }
+  this->spin_time_us = spin_time_us;
+}
+
+int64_t CPUPool::get_spin_time_us() const {
+  return this->spin_time_us;
+}
+
 CPUPool::~CPUPool() {
   if (this->cpu_affinity_mask_initialized_) {
     // If we are using the cpu_affinity_mask expression for CPUPool
@@ -1,9 +1,12 @@
 #pragma once
 #include <dlfcn.h>
 #include <omp.h>
+#include <memory>
 #include <mutex>
 #include <vector>
 
+#include "MemoryArena.h"
+
 namespace torch_ipex {
 namespace runtime {
 
@@ -13,10 +16,14 @@ typedef int (*kmp_set_affinity_mask_proc_p)(int, kmp_affinity_mask_t*);
 typedef int (*kmp_set_affinity_p)(kmp_affinity_mask_t*);
 typedef void (*kmp_destroy_affinity_mask_p)(kmp_affinity_mask_t*);
 typedef int (*kmp_get_affinity_p)(kmp_affinity_mask_t*);
+typedef void (*kmp_set_blocktime_p)(int);
 
 class CPUPool {
  public:
   explicit CPUPool(const std::vector<int32_t>& cpu_core_list);
+  explicit CPUPool(
+      const std::vector<int32_t>& cpu_core_list,
+      int32_t numa_node_id);
   explicit CPUPool(std::vector<kmp_affinity_mask_t>&& cpu_core_mask);
   CPUPool(CPUPool&& source_cpu_pool);
 
@@ -24,8 +31,21 @@ class CPUPool {
   const std::vector<kmp_affinity_mask_t>& get_cpu_affinity_mask() const;
   bool is_cpu_core_list_initialized() const;
   bool is_cpu_affinity_mask_initialized() const;
+  // -1 means the cores of this CPUPool don't belong to one specific numa node.
+  int32_t get_numa_node_id() const;
+  // Create the memory arena shared by the TaskExecutors created on this
+  // CPUPool afterwards.
+  void enable_memory_arena();
+  std::shared_ptr<MemoryArena> get_memory_arena() const;
+  // Idle policy of the TaskExecutors created on this CPUPool afterwards: the
+  // worker and its OMP threads spin spin_time_us before going to sleep.
+  void set_spin_time_us(int64_t spin_time_us);
+  int64_t get_spin_time_us() const;
   ~CPUPool();
 
+  friend CPUPool get_cpu_pool_from_mask_affinity();
+  friend void set_mask_affinity_from_cpu_pool(const CPUPool& cpu_pool);
+
  private:
   // CPUPool has 2 kinds of expression: 1. cpu_core_list 2. cpu_affinity_mask
   // Notice: only one of these 2 expressions allow to use for specific CPUPool
@@ -34,6 +54,17 @@ class CPUPool {
   bool cpu_core_list_initialized_{false};
   std::vector<kmp_affinity_mask_t> cpu_affinity_mask;
   bool cpu_affinity_mask_initialized_{false};
+  // The numa node where the memory of the threads in this CPUPool is
+  // preferred to be allocated.
+  int32_t numa_node_id{-1};
+  // Caching allocator of the tasks running on this CPUPool, nullptr if the
+  // memory arena is not enabled.
+  std::shared_ptr<MemoryArena> memory_arena;
+  // 0 means the idle workers sleep immediately.
+  int64_t spin_time_us{0};
+  // The pinned core list of the thread captured together with
+  // cpu_affinity_mask, restored by set_mask_affinity_from_cpu_pool.
+  std::vector<int32_t> pinned_cpu_core_list;
 
   // Put deleted function into private.
   CPUPool() = delete;
@@ -47,6 +78,23 @@ class CPUPool {
 bool is_runtime_ext_enabled();
 void init_runtime_ext();
 void _pin_cpu_cores(const std::vector<int32_t>& cpu_core_list);
+// Pin the OMP threads to cpu_core_list, and set the memory policy of the
+// current thread and the OMP threads to prefer the numa_node_id.
+void _pin_cpu_cores(
+    const std::vector<int32_t>& cpu_core_list,
+    int32_t numa_node_id);
+// The core list of the last _pin_cpu_cores on the current thread, empty if
+// the current thread isn't pinned by the runtime API.
+const std::vector<int32_t>& _get_pinned_cpu_core_list();
+bool _set_preferred_numa_node(int32_t numa_node_id);
+// Set the memory policy of the pages of [ptr, ptr + bytes) to prefer the
+// numa_node_id, e.g. of the new tensors before they are first touched by the
+// threads of another numa node. Return false if it's not applied.
+bool _bind_memory_to_numa_node(void* ptr, size_t bytes, int32_t numa_node_id);
+// Set the time the OMP threads of the current thread's team spin before
+// sleeping (KMP_BLOCKTIME), return false if it's not supported by the OpenMP
+// runtime.
+bool _set_omp_blocktime(int32_t blocktime_ms);
 CPUPool get_cpu_pool_from_mask_affinity();
 void set_mask_affinity_from_cpu_pool(const CPUPool& cpu_pool);
 
@@ -0,0 +1,140 @@
+#include "MemoryArena.h"
+
+#include <c10/core/CPUAllocator.h>
+
+#include "csrc/utils/huge_pages.h"
+
+namespace torch_ipex {
+namespace runtime {
+
+namespace {
+
+// The header is put in front of the data of each block, and keeps the data
+// aligned as the default CPU allocator does.
+constexpr size_t kBlockHeaderSize = 64;
+// Round up the block size, so that tensors with slightly different sizes can
+// share the cached blocks.
+constexpr size_t kBlockSizeAlignment = 512;
+
+thread_local MemoryArena* current_memory_arena = nullptr;
+c10::Allocator* default_cpu_allocator = nullptr;
+
+// ArenaDispatchAllocator replaces the CPU allocator once any MemoryArena is
+// created. It dispatches the allocation to the memory arena of the current
+// thread, or to the original CPU allocator if no arena is installed.
+struct ArenaDispatchAllocator final : public c10::Allocator {
+  c10::DataPtr allocate(size_t nbytes) const override {
+    if (current_memory_arena != nullptr) {
+      return current_memory_arena->allocate(nbytes);
+    }
+    return default_cpu_allocator->allocate(nbytes);
+  }
+
+  // The blocks of the arena have their own deleter, so raw_allocate is not
+  // supported.
+  c10::DeleterFnPtr raw_deleter() const override {
+    return nullptr;
+  }
+};
+
+ArenaDispatchAllocator arena_dispatch_allocator;
+std::once_flag arena_dispatch_allocator_install_flag;
+
+void install_arena_dispatch_allocator() {
+  default_cpu_allocator = c10::GetAllocator(c10::DeviceType::CPU);
+  c10::SetAllocator(c10::DeviceType::CPU, &arena_dispatch_allocator);
+}
+
+} // namespace
+
+std::shared_ptr<MemoryArena> MemoryArena::create() {
+  std::call_once(
+      arena_dispatch_allocator_install_flag, install_arena_dispatch_allocator);
+  return std::shared_ptr<MemoryArena>(new MemoryArena());
+}
+
+MemoryArena::~MemoryArena() {
+  this->reset();
+}
+
+c10::DataPtr MemoryArena::allocate(size_t nbytes) {
+  size_t block_size = (nbytes + kBlockSizeAlignment - 1) / kBlockSizeAlignment *
+      kBlockSizeAlignment;
+  BlockHeader* header = nullptr;
+  {
+    std::unique_lock<std::mutex> lock(this->arena_mutex);
+    auto it = this->free_blocks.find(block_size);
+    if (it != this->free_blocks.end() && !it->second.empty()) {
+      header = it->second.back();
+      it->second.pop_back();
+      this->stats.cached_bytes -= block_size;
+      this->stats.hits++;
+    } else {
+      this->stats.misses++;
+    }
+    this->stats.allocated_bytes += block_size;
+    if (this->alive_blocks++ == 0) {
+      this->self_holder = this->shared_from_this();
+    }
+  }
+  if (header == nullptr) {
+    // the large blocks may be on the huge pages, which are also freed by
+    // c10::free_cpu
+    header = static_cast<BlockHeader*>(
+        huge_pages::alloc_cpu(kBlockHeaderSize + block_size));
+    header->arena = this;
+    header->block_size = block_size;
+  }
+  void* data = reinterpret_cast<char*>(header) + kBlockHeaderSize;
+  return {data, header, &MemoryArena::free_block, c10::Device(c10::kCPU)};
+}
+
+void MemoryArena::free_block(void* ctx) {
+  BlockHeader* header = static_cast<BlockHeader*>(ctx);
+  header->arena->release_block(header);
+}
+
+void MemoryArena::release_block(BlockHeader* header) {
+  // Destroy the self holder outside the lock, since it may destroy the arena.
+  std::shared_ptr<MemoryArena> holder;
+  {
+    std::unique_lock<std::mutex> lock(this->arena_mutex);
+    this->free_blocks[header->block_size].emplace_back(header);
+    this->stats.allocated_bytes -= header->block_size;
+    this->stats.cached_bytes += header->block_size;
+    if (--this->alive_blocks == 0) {
+      holder = std::move(this->self_holder);
+    }
+  }
+}
+
+void MemoryArena::reset() {
+  std::unordered_map<size_t, std::vector<BlockHeader*>> blocks_to_free;
+  {
+    std::unique_lock<std::mutex> lock(this->arena_mutex);
+    blocks_to_free.swap(this->free_blocks);
+    this->stats.cached_bytes = 0;
+  }
+  for (auto& blocks : blocks_to_free) {
+    for (auto header : blocks.second) {
+      c10::free_cpu(header);
+    }
+  }
+}
+
+MemoryArenaStats MemoryArena::get_stats() {
+  std::unique_lock<std::mutex> lock(this->arena_mutex);
+  return this->stats;
+}
+
+MemoryArenaGuard::MemoryArenaGuard(MemoryArena* memory_arena)
+    : previous_memory_arena(current_memory_arena) {
+  current_memory_arena = memory_arena;
+}
+
+MemoryArenaGuard::~MemoryArenaGuard() {
+  current_memory_arena = this->previous_memory_arena;
+}
+
+} // namespace runtime
+} // namespace torch_ipex
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <c10/core/Allocator.h>
+
+namespace torch_ipex {
+namespace runtime {
+
+struct MemoryArenaStats {
+  // bytes of the blocks used by alive tensors
+  int64_t allocated_bytes{0};
+  // bytes of the free blocks cached in the arena
+  int64_t cached_bytes{0};
+  // allocations served from the cached blocks
+  int64_t hits{0};
+  // allocations which have to allocate a new block
+  int64_t misses{0};
+};
+
+/*MemoryArena is a caching allocator for the tensors allocated by the tasks of
+ * one TaskExecutor. The freed blocks are cached by their size and reused by
+ * the next allocation of the same size, so that the steady-state inference of
+ * the same shape doesn't call the system allocator at all.
+ * The arena is installed for the current thread by MemoryArenaGuard, the
+ * allocations outside the guard go to the default CPU allocator.*/
+class MemoryArena : public std::enable_shared_from_this<MemoryArena> {
+ public:
+  static std::shared_ptr<MemoryArena> create();
+  ~MemoryArena();
+
+  c10::DataPtr allocate(size_t nbytes);
+  // Release all the cached free blocks to the system allocator.
+  void reset();
+  MemoryArenaStats get_stats();
+
+ private:
+  struct BlockHeader {
+    // Hold the arena until all its blocks are freed.
+    MemoryArena* arena;
+    size_t block_size;
+  };
+
+  MemoryArena() = default;
+  static void free_block(void* ctx);
+  void release_block(BlockHeader* header);
+
+  std::unordered_map<size_t, std::vector<BlockHeader*>> free_blocks;
+  MemoryArenaStats stats;
+  std::mutex arena_mutex;
+  // Keep the arena alive while any block allocated from it is still in use.
+  std::shared_ptr<MemoryArena> self_holder;
+  int64_t alive_blocks{0};
+
+  MemoryArena(const MemoryArena& memory_arena) = delete;
+  MemoryArena& operator=(const MemoryArena& memory_arena) = delete;
+};
+
+/*MemoryArenaGuard installs the memory arena for the CPU allocations of the
+ * current thread during its scope.*/
+class MemoryArenaGuard {
+ public:
+  explicit MemoryArenaGuard(MemoryArena* memory_arena);
+  ~MemoryArenaGuard();
+
+ private:
+  MemoryArena* previous_memory_arena;
+
+  MemoryArenaGuard(const MemoryArenaGuard& memory_arena_guard) = delete;
+  MemoryArenaGuard& operator=(const MemoryArenaGuard& memory_arena_guard) =
+      delete;
+};
+
+} // namespace runtime
+} // namespace torch_ipex
@@ -6,82 +6,160 @@
 #include <iostream>
 #include <memory>
 #include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include <ATen/core/ivalue.h>
 #include <torch/csrc/jit/api/module.h>
 #include "TaskExecutor.h"
+#include "TaskFuture.h"
 
 namespace torch_ipex {
 namespace runtime {
 
+namespace detail {
+
+template <class F, class Tuple, size_t... I>
+auto apply_task_args(F& f, Tuple& args, std::index_sequence<I...>)
+    -> decltype(f(std::move(std::get<I>(args))...)) {
+  return f(std::move(std::get<I>(args))...);
+}
+
+// Call f with the arguments moved out of the tuple.
+template <class F, class... Args>
+auto apply_task_args(F& f, std::tuple<Args...>& args)
+    -> decltype(apply_task_args(f, args, std::index_sequence_for<Args...>())) {
+  return apply_task_args(f, args, std::index_sequence_for<Args...>());
+}
+
+template <class R, class F, class Tuple>
+void run_task(
+    TaskFutureState<R>& state,
+    F& f,
+    Tuple& args,
+    std::false_type /*is_void*/) {
+  state.set_value(apply_task_args(f, args));
+}
+
+template <class R, class F, class Tuple>
+void run_task(
+    TaskFutureState<R>& state,
+    F& f,
+    Tuple& args,
+    std::true_type /*is_void*/) {
+  apply_task_args(f, args);
+  state.set_value();
+}
+
+// Run f and store its result or its exception into the state.
+template <class R, class F, class Tuple>
+void run_task(TaskFutureState<R>& state, F& f, Tuple& args) {
+  try {
+    run_task(state, f, args, std::is_void<R>());
+  } catch (...) {
+    state.set_exception(std::current_exception());
+  }
+}
+
+} // namespace detail
+
 // refer to http://www.open-std.org/jtc1/sc22/wg21/docs/papers/2008/n2709.html
 /*Task is used to handle input of general C++ functions*/
 template <class F, class... Args>
 class Task {
  public:
+  using result_type = decltype(std::declval<F&>()(std::declval<Args>()...));
+
   explicit Task(F&& f, std::shared_ptr<TaskExecutor> task_executor);
+  // A template, so that it doesn't conflict with the constructor above when
+  // Args is empty.
+  template <typename T = void>
   explicit Task(
       F&& f,
       Args&&... args,
       std::shared_ptr<TaskExecutor> task_executor);
   Task(const Task& task);
   ~Task();
-  auto operator()(Args&&... args)
-      -> std::future<typename std::result_of<F(Args...)>::type>;
+  // The lane of the TaskExecutor which the following inputs are submitted to.
+  void set_priority(TaskPriority priority);
+  auto operator()(Args&&... args) -> std::future<result_type>;
+  // Submit the input without copying the arguments, which can be move-only.
+  // It returns the light-weight TaskFuture instead of std::future.
+  auto run_async(Args&&... args) -> TaskFuture<result_type>;
 
  private:
   F f;
   std::shared_ptr<TaskExecutor> task_executor;
+  TaskPriority priority{TaskPriority::Normal};
 };
 
 template <class F, class... Args>
-Task<F, Args...>::Task(F&& f, std::shared_ptr<TaskExecutor> task_executor) {
-  this->f = f;
-  this->task_executor = task_executor;
-}
+Task<F, Args...>::Task(F&& f, std::shared_ptr<TaskExecutor> task_executor)
+    : f(std::forward<F>(f)), task_executor(std::move(task_executor)) {}
 
 template <class F, class... Args>
+template <typename T>
 Task<F, Args...>::Task(
     F&& f,
     Args&&... args,
-    std::shared_ptr<TaskExecutor> task_executor) {
-  this->f = f;
-  this->task_executor = task_executor;
-}
+    std::shared_ptr<TaskExecutor> task_executor)
+    : f(std::forward<F>(f)), task_executor(std::move(task_executor)) {}
 
 template <class F, class... Args>
-Task<F, Args...>::Task(const Task& task) {
-  this->f = task.f;
-  this->task_executor = task.task_executor;
-}
+Task<F, Args...>::Task(const Task& task)
+    : f(task.f),
+      task_executor(task.task_executor),
+      priority(task.priority) {}
 
 template <class F, class... Args>
 Task<F, Args...>::~Task() {}
 
+template <class F, class... Args>
+void Task<F, Args...>::set_priority(TaskPriority priority) {
+  this->priority = priority;
+}
+
 template <class F, class... Args>
 auto Task<F, Args...>::operator()(Args&&... args)
-    -> std::future<typename std::result_of<F(Args...)>::type> {
-  using return_type = typename std::result_of<F(Args...)>::type;
-  auto task = std::make_shared<std::packaged_task<return_type()>>(
-      std::bind(std::forward<F>(this->f), std::forward<Args>(args)...));
-  std::future<return_type> res = task->get_future();
+    -> std::future<result_type> {
+  std::packaged_task<result_type()> task(
+      [f = this->f,
+       args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+        return detail::apply_task_args(f, args);
+      });
+  std::future<result_type> res = task.get_future();
   auto grad_mode = at::GradMode::is_enabled();
-  {
-    std::unique_lock<std::mutex> lock(this->task_executor->get_mutex());
-    // submit task to a stopping the pool is not allowed
-    if (this->task_executor->is_stop())
-      throw std::runtime_error("Task submit on stopped ThreadPool");
-    this->task_executor->get_tasks().emplace([task, grad_mode]() {
-      // set the thread local status, such as the grad mode before execuating
-      // the status
-      at::GradMode::set_enabled(grad_mode);
-      // execuate the task
-      (*task)();
-    });
-  }
+  this->task_executor->submit(
+      [task = std::move(task), grad_mode]() mutable {
+        // set the thread local status, such as the grad mode before
+        // execuating the status
+        at::GradMode::set_enabled(grad_mode);
+        // execuate the task
+        task();
+      },
+      this->priority);
+  return res;
+}
 
-  this->task_executor->get_condition().notify_one();
+template <class F, class... Args>
+auto Task<F, Args...>::run_async(Args&&... args)
+    -> TaskFuture<result_type> {
+  // The only allocation of the submission, the callable below is small enough
+  // to be kept inside the TaskFunction.
+  auto state = std::make_shared<detail::TaskFutureState<result_type>>();
+  auto grad_mode = at::GradMode::is_enabled();
+  TaskFuture<result_type> res(state);
+  this->task_executor->submit(
+      [promise = detail::TaskFuturePromise<result_type>(std::move(state)),
+       grad_mode,
+       f = this->f,
+       args = std::make_tuple(std::forward<Args>(args)...)]() mutable {
+        at::GradMode::set_enabled(grad_mode);
+        detail::run_task(promise.get_state(), f, args);
+      },
+      this->priority);
   return res;
 }
 
@@ -1,9 +1,104 @@
 #include "TaskExecutor.h"
 
+#include <algorithm>
+#include <string>
+
 namespace torch_ipex {
 namespace runtime {
 
-TaskExecutor::TaskExecutor(const std::vector<int32_t>& cpu_core_list) {
+namespace {
+std::atomic<int64_t> next_executor_id{0};
+} // namespace
+
+void TaskExecutorGroup::register_executor(TaskExecutor* task_executor) {
+  std::unique_lock<std::mutex> lock(this->group_mutex);
+  this->task_executors.emplace_back(task_executor);
+}
+
+void TaskExecutorGroup::unregister_executor(TaskExecutor* task_executor) {
+  std::unique_lock<std::mutex> lock(this->group_mutex);
+  this->task_executors.erase(
+      std::remove(
+          this->task_executors.begin(),
+          this->task_executors.end(),
+          task_executor),
+      this->task_executors.end());
+}
+
+bool TaskExecutorGroup::steal(TaskExecutor* thief, TaskFunction& task) {
+  std::unique_lock<std::mutex> lock(this->group_mutex);
+  for (auto victim : this->task_executors) {
+    if (victim == thief) {
+      continue;
+    }
+    // Never block on a busy victim, just try the next one.
+    std::unique_lock<std::mutex> victim_lock(
+        victim->worker_mutex, std::try_to_lock);
+    if (!victim_lock.owns_lock() || !victim->has_queued_tasks()) {
+      continue;
+    }
+    if (!victim->high_priority_tasks.empty()) {
+      // Keep the FIFO order of the latency-critical tasks.
+      task = std::move(victim->high_priority_tasks.front());
+      victim->high_priority_tasks.pop_front();
+    } else {
+      task = std::move(victim->tasks.back());
+      victim->tasks.pop_back();
+      victim->on_task_dequeued();
+    }
+    this->decrease_pending_tasks();
+    return true;
+  }
+  return false;
+}
+
+void TaskExecutorGroup::notify_idle(TaskExecutor* source) {
+  if (this->idle_workers.load() == 0) {
+    return;
+  }
+  std::unique_lock<std::mutex> lock(this->group_mutex);
+  for (auto task_executor : this->task_executors) {
+    if (task_executor == source) {
+      continue;
+    }
+    bool is_idle = false;
+    {
+      // Take the lock of the idle worker to avoid missing the wakeup between
+      // its predicate check and its wait.
+      std::unique_lock<std::mutex> idle_lock(task_executor->worker_mutex);
+      is_idle = !task_executor->has_queued_tasks() && !task_executor->stop;
+    }
+    if (is_idle) {
+      task_executor->worker_condition.notify_one();
+      return;
+    }
+  }
+}
+
+bool TaskExecutorGroup::has_pending_tasks() const {
+  return this->pending_tasks.load() > 0;
+}
+
+void TaskExecutorGroup::increase_pending_tasks() {
+  this->pending_tasks++;
+}
+
+void TaskExecutorGroup::decrease_pending_tasks() {
+  this->pending_tasks--;
+}
+
+void TaskExecutorGroup::increase_idle_workers() {
+  this->idle_workers++;
+}
+
+void TaskExecutorGroup::decrease_idle_workers() {
+  this->idle_workers--;
+}
+
+TaskExecutor::TaskExecutor(
+    const std::vector<int32_t>& cpu_core_list,
+    std::shared_ptr<TaskExecutorGroup> task_executor_group,
+    int32_t numa_node_id) {
   // Notice: We shouldn't load iomp symbol in sub_thread, otherwise race
   // condition happens.
   if (!is_runtime_ext_enabled()) {
@@ -12,28 +107,147 @@ TaskExecutor::TaskExecutor(const std::vector<int32_t>& cpu_core_list) {
         "before using the runtime API.");
   }
   this->cpu_core_list = cpu_core_list;
+  this->numa_node_id = numa_node_id;
+  this->stop = false;
+  this->task_executor_group = task_executor_group;
+  this->start_worker();
+}
+
+TaskExecutor::TaskExecutor(
+    const CPUPool& cpu_pool,
+    std::shared_ptr<TaskExecutorGroup> task_executor_group) {
+  if (!is_runtime_ext_enabled()) {
+    throw std::runtime_error(
+        "Fail to init TaskExecutor. Didn't preload IOMP "
+        "before using the runtime API.");
+  }
+  this->cpu_core_list = cpu_pool.get_cpu_core_list();
+  this->numa_node_id = cpu_pool.get_numa_node_id();
+  this->memory_arena = cpu_pool.get_memory_arena();
+  this->spin_time_us = cpu_pool.get_spin_time_us();
   this->stop = false;
+  this->task_executor_group = task_executor_group;
+  this->start_worker();
+}
+
+void TaskExecutor::start_worker() {
+  this->executor_id = next_executor_id++;
+  if (this->task_executor_group) {
+    this->task_executor_group->register_executor(this);
+  }
 
   this->worker = std::make_shared<std::thread>([&, this] {
-    _pin_cpu_cores(this->cpu_core_list);
+    this->setup_worker_team();
+    auto group = this->task_executor_group;
     while (true) {
-      std::function<void()> task;
+      TaskFunction task;
+      bool should_repin = false;
+      if (this->spin_time_us > 0) {
+        // Busy wait first, so that the next task is picked up in
+        // microseconds instead of going through the futex wakeup.
+        this->spin_wait_for_work();
+      }
       {
         std::unique_lock<std::mutex> lock(this->worker_mutex);
-        this->worker_condition.wait(
-            lock, [this] { return this->stop || !this->tasks.empty(); });
+        if (!this->has_work()) {
+          if (group) {
+            group->increase_idle_workers();
+          }
+          this->worker_condition.wait(
+              lock, [this] { return this->has_work(); });
+          if (group) {
+            group->decrease_idle_workers();
+          }
+        }
 
-        if (this->stop && this->tasks.empty())
+        if (this->stop && !this->has_queued_tasks())
           return;
 
-        task = std::move(this->tasks.front());
-        this->tasks.pop();
+        if (this->repin_requested) {
+          this->cpu_core_list = std::move(this->repin_cpu_core_list);
+          this->numa_node_id = this->repin_numa_node_id;
+          this->spin_time_us = this->repin_spin_time_us;
+          this->repin_requested = false;
+          should_repin = true;
+        }
+
+        if (!this->high_priority_tasks.empty()) {
+          task = std::move(this->high_priority_tasks.front());
+          this->high_priority_tasks.pop_front();
+        } else if (!this->tasks.empty()) {
+          task = std::move(this->tasks.front());
+          this->tasks.pop_front();
+          this->on_task_dequeued();
+        }
+        if (task && group) {
+          group->decrease_pending_tasks();
+        }
+      }
+      if (should_repin) {
+        // Only the worker thread accesses cpu_core_list after start.
+        this->setup_worker_team();
+      }
+      if (!task) {
+        // Woken up only to repin.
+        if (!group) {
+          continue;
+        }
+        // Own queue is empty but other TaskExecutors in the group have
+        // pending tasks.
+        if (!group->steal(this, task)) {
+          std::this_thread::yield();
+          continue;
+        }
+      }
+      {
+        // The allocations of the task are served by the memory arena.
+        MemoryArenaGuard memory_arena_guard(this->memory_arena.get());
+        task();
+      }
+      if (omp_get_max_threads() !=
+          static_cast<int32_t>(this->cpu_core_list.size())) {
+        // The task changed the number of OMP threads, which makes the next
+        // parallel region re-create an unpinned team. Restore the pinned team
+        // of the core list.
+        this->setup_worker_team();
       }
-      task();
     }
   });
 }
 
+void TaskExecutor::setup_worker_team() {
+  // The parallel regions inside _pin_cpu_cores create the OMP team of the
+  // worker. IOMP keeps reusing this team as long as the number of threads
+  // doesn't change.
+  _pin_cpu_cores(this->cpu_core_list, this->numa_node_id);
+  if (this->spin_time_us > 0) {
+    // Keep the OMP threads spinning between the parallel regions of the
+    // consecutive tasks as long as the worker itself.
+    _set_omp_blocktime(
+        static_cast<int32_t>((this->spin_time_us + 999) / 1000));
+  }
+}
+
+bool TaskExecutor::has_work() const {
+  return this->stop || this->repin_requested || this->has_queued_tasks() ||
+      (this->task_executor_group &&
+       this->task_executor_group->has_pending_tasks());
+}
+
+void TaskExecutor::spin_wait_for_work() {
+  auto deadline = std::chrono::steady_clock::now() +
+      std::chrono::microseconds(this->spin_time_us);
+  do {
+    {
+      std::unique_lock<std::mutex> lock(this->worker_mutex);
+      if (this->has_work()) {
+        return;
+      }
+    }
+    std::this_thread::yield();
+  } while (std::chrono::steady_clock::now() < deadline);
+}
+
 std::mutex& TaskExecutor::get_mutex() {
   return this->worker_mutex;
 }
@@ -46,12 +260,102 @@ bool TaskExecutor::is_stop() {
   return this->stop;
 }
 
-std::queue<std::function<void()>>& TaskExecutor::get_tasks() {
+std::deque<TaskFunction>& TaskExecutor::get_tasks() {
   return this->tasks;
 }
 
+bool TaskExecutor::has_queued_tasks() const {
+  return !this->tasks.empty() || !this->high_priority_tasks.empty();
+}
+
+void TaskExecutor::submit(TaskFunction&& task, TaskPriority priority) {
+  if (is_task_tracing_enabled()) {
+    task = trace_task(std::move(task), this->executor_id);
+  }
+  // Destroyed outside the lock, since it may run the callbacks of its future.
+  TaskFunction dropped_task;
+  {
+    std::unique_lock<std::mutex> lock(this->worker_mutex);
+    // submit task to a stopping the pool is not allowed
+    if (this->stop)
+      throw std::runtime_error("Task submit on stopped ThreadPool");
+    if (priority == TaskPriority::High) {
+      this->high_priority_tasks.emplace_back(std::move(task));
+    } else {
+      if (this->max_queued_tasks > 0 &&
+          static_cast<int64_t>(this->tasks.size()) >= this->max_queued_tasks) {
+        if (this->queue_full_policy == QueueFullPolicy::Reject) {
+          this->queue_stats.rejected_tasks++;
+          throw TaskQueueFullError(
+              "Task submit on full queue of TaskExecutor, the queue limit is " +
+              std::to_string(this->max_queued_tasks));
+        } else if (this->queue_full_policy == QueueFullPolicy::Block) {
+          this->queue_stats.blocked_submissions++;
+          this->queue_space_condition.wait(lock, [this] {
+            return this->stop || this->max_queued_tasks <= 0 ||
+                static_cast<int64_t>(this->tasks.size()) <
+                this->max_queued_tasks;
+          });
+          if (this->stop)
+            throw std::runtime_error("Task submit on stopped ThreadPool");
+        } else if (!this->tasks.empty()) {
+          dropped_task = std::move(this->tasks.front());
+          this->tasks.pop_front();
+          this->queue_stats.dropped_tasks++;
+          if (this->task_executor_group) {
+            this->task_executor_group->decrease_pending_tasks();
+          }
+        }
+      }
+      this->tasks.emplace_back(std::move(task));
+      this->queue_stats.peak_queued_tasks = std::max(
+          this->queue_stats.peak_queued_tasks,
+          static_cast<int64_t>(this->tasks.size()));
+    }
+    if (this->task_executor_group) {
+      this->task_executor_group->increase_pending_tasks();
+    }
+  }
+  this->worker_condition.notify_one();
+  if (this->task_executor_group) {
+    this->task_executor_group->notify_idle(this);
+  }
+}
+
+void TaskExecutor::on_task_dequeued() {
+  if (this->max_queued_tasks > 0 &&
+      this->queue_full_policy == QueueFullPolicy::Block) {
+    this->queue_space_condition.notify_one();
+  }
+}
+
+void TaskExecutor::set_queue_limit(
+    int64_t max_queued_tasks,
+    QueueFullPolicy policy) {
+  {
+    std::unique_lock<std::mutex> lock(this->worker_mutex);
+    this->max_queued_tasks = max_queued_tasks;
+    this->queue_full_policy = policy;
+  }
+  // Re-evaluate the blocked submitters with the new limit.
+  this->queue_space_condition.notify_all();
+}
+
+TaskQueueStats TaskExecutor::get_queue_stats() {
+  std::unique_lock<std::mutex> lock(this->worker_mutex);
+  TaskQueueStats stats = this->queue_stats;
+  stats.queued_tasks = this->tasks.size();
+  stats.high_priority_queued_tasks = this->high_priority_tasks.size();
+  return stats;
+}
+
 void TaskExecutor::stop_executor() {
   bool should_wait_worker_join = false;
+  if (this->task_executor_group) {
+    // Leave the work stealing domain before stopping, so that no other
+    // TaskExecutor steals from or wakes up this TaskExecutor any more.
+    this->task_executor_group->unregister_executor(this);
+  }
   {
     std::unique_lock<std::mutex> lock(this->worker_mutex);
     if (this->stop == false) {
@@ -61,11 +365,37 @@ void TaskExecutor::stop_executor() {
   }
   if (should_wait_worker_join) {
     this->worker_condition.notify_all();
+    // Wake up the blocked submitters to fail.
+    this->queue_space_condition.notify_all();
     this->worker->join();
   }
   return;
 }
 
+void TaskExecutor::repin(const CPUPool& cpu_pool) {
+  {
+    std::unique_lock<std::mutex> lock(this->worker_mutex);
+    if (this->stop)
+      throw std::runtime_error("Repin on stopped ThreadPool");
+    this->repin_cpu_core_list = cpu_pool.get_cpu_core_list();
+    this->repin_numa_node_id = cpu_pool.get_numa_node_id();
+    this->repin_spin_time_us = cpu_pool.get_spin_time_us();
+    this->repin_requested = true;
+  }
+  // Wake up the idle worker to apply the new cores immediately.
+  this->worker_condition.notify_one();
+}
+
+std::vector<int32_t> TaskExecutor::get_cpu_core_list() {
+  std::unique_lock<std::mutex> lock(this->worker_mutex);
+  return this->repin_requested ? this->repin_cpu_core_list
+                               : this->cpu_core_list;
+}
+
+int64_t TaskExecutor::get_executor_id() const {
+  return this->executor_id;
+}
+
 TaskExecutor::~TaskExecutor() {
   this->stop_executor();
 }
@@ -2,14 +2,16 @@
 
 #include <dlfcn.h>
 #include <omp.h>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <future>
 #include <iostream>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <stdexcept>
 #include <thread>
 #include <vector>
@@ -18,31 +20,168 @@
 #include <torch/csrc/autograd/profiler.h>
 #include <torch/csrc/jit/api/module.h>
 #include "CPUPool.h"
+#include "TaskFunction.h"
+#include "TaskTracer.h"
 
 namespace torch_ipex {
 namespace runtime {
 
+class TaskExecutor;
+
+// Priority lane of the tasks submitted into one TaskExecutor. The queued High
+// tasks are always executed before the queued Normal tasks, while the running
+// task is never interrupted.
+enum class TaskPriority : int32_t {
+  Normal = 0,
+  High = 1,
+};
+
+// Behavior of TaskExecutor::submit when the Normal lane already holds
+// max_queued_tasks tasks. The High lane is never bounded.
+enum class QueueFullPolicy : int32_t {
+  // Throw TaskQueueFullError to the submitter.
+  Reject = 0,
+  // Block the submitter until the worker (or a thief) picks up a queued task.
+  Block = 1,
+  // Drop the oldest queued task to make room. The future of the dropped task
+  // raises an error instead of waiting forever.
+  DropOldest = 2,
+};
+
+class TaskQueueFullError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+// Queue-depth gauges and the admission counters of one TaskExecutor.
+struct TaskQueueStats {
+  // tasks queued in the Normal lane
+  int64_t queued_tasks{0};
+  // tasks queued in the High lane
+  int64_t high_priority_queued_tasks{0};
+  // the highest value of queued_tasks so far
+  int64_t peak_queued_tasks{0};
+  // submissions rejected by QueueFullPolicy::Reject
+  int64_t rejected_tasks{0};
+  // queued tasks dropped by QueueFullPolicy::DropOldest
+  int64_t dropped_tasks{0};
+  // submissions blocked by QueueFullPolicy::Block
+  int64_t blocked_submissions{0};
+};
+
+/*TaskExecutorGroup is a work stealing domain shared by several TaskExecutors.
+ * When the worker of one TaskExecutor is idle, it steals the pending tasks
+ * from the queue of a busy TaskExecutor inside the same group and executes
+ * them on its own cores. The TaskExecutors inside one group are supposed to be
+ * pinned on the cores of the same numa node.*/
+class TaskExecutorGroup {
+ public:
+  TaskExecutorGroup() = default;
+  ~TaskExecutorGroup() = default;
+
+  void register_executor(TaskExecutor* task_executor);
+  void unregister_executor(TaskExecutor* task_executor);
+  // Try to pop one pending task from the other TaskExecutors in this group.
+  bool steal(TaskExecutor* thief, TaskFunction& task);
+  // Wake up one idle TaskExecutor of this group to steal the new task.
+  void notify_idle(TaskExecutor* source);
+  bool has_pending_tasks() const;
+  void increase_pending_tasks();
+  void decrease_pending_tasks();
+  void increase_idle_workers();
+  void decrease_idle_workers();
+
+ private:
+  std::vector<TaskExecutor*> task_executors;
+  std::mutex group_mutex;
+  // Number of tasks queued (not started yet) in all TaskExecutors of the group
+  std::atomic<int64_t> pending_tasks{0};
+  // Number of workers waiting for tasks
+  std::atomic<int64_t> idle_workers{0};
+
+  TaskExecutorGroup(const TaskExecutorGroup& task_executor_group) = delete;
+  TaskExecutorGroup& operator=(const TaskExecutorGroup& task_executor_group) =
+      delete;
+};
+
 class TaskExecutor {
  public:
-  explicit TaskExecutor(const std::vector<int32_t>& cpu_core_list);
+  explicit TaskExecutor(
+      const std::vector<int32_t>& cpu_core_list,
+      std::shared_ptr<TaskExecutorGroup> task_executor_group = nullptr,
+      int32_t numa_node_id = -1);
+  // Create the TaskExecutor with the cores, the numa node and the memory arena
+  // of the cpu_pool.
+  explicit TaskExecutor(
+      const CPUPool& cpu_pool,
+      std::shared_ptr<TaskExecutorGroup> task_executor_group = nullptr);
   std::mutex& get_mutex();
   std::condition_variable& get_condition();
   bool is_stop();
-  std::queue<std::function<void()>>& get_tasks();
+  std::deque<TaskFunction>& get_tasks();
+  // Submit one task into the queue of this TaskExecutor and notify the worker.
+  // If the Normal lane is full, the QueueFullPolicy is applied.
+  void submit(
+      TaskFunction&& task,
+      TaskPriority priority = TaskPriority::Normal);
   void stop_executor();
+  // Bound the Normal lane to max_queued_tasks, 0 means unbounded (default).
+  void set_queue_limit(int64_t max_queued_tasks, QueueFullPolicy policy);
+  TaskQueueStats get_queue_stats();
+  // Re-pin the worker and its OMP threads to the cores and the numa node of
+  // cpu_pool. It takes effect at the next task boundary of the worker, the
+  // queued tasks are kept.
+  void repin(const CPUPool& cpu_pool);
+  std::vector<int32_t> get_cpu_core_list();
+  // Unique id of this TaskExecutor in the TaskTraceRecord.
+  int64_t get_executor_id() const;
   ~TaskExecutor();
 
+  friend class TaskExecutorGroup;
+
  private:
-  std::queue<std::function<void()>> tasks;
+  // The owner pops tasks from the front of the deque, while the thief from
+  // the same TaskExecutorGroup steals tasks from the back.
+  std::deque<TaskFunction> tasks;
+  // Latency-critical tasks, popped from the front by both the owner and the
+  // thief before any task of the Normal lane.
+  std::deque<TaskFunction> high_priority_tasks;
   std::shared_ptr<std::thread> worker;
 
   // Synchronization
   bool stop;
   std::mutex worker_mutex;
   std::condition_variable worker_condition;
+  // Notified when a task leaves the Normal lane, for QueueFullPolicy::Block.
+  std::condition_variable queue_space_condition;
+
+  // Admission control of the Normal lane
+  int64_t max_queued_tasks{0};
+  QueueFullPolicy queue_full_policy{QueueFullPolicy::Reject};
+  TaskQueueStats queue_stats;
 
   // Executor' thread_pool
   std::vector<int32_t> cpu_core_list;
+  // The numa node preferred by the memory allocation of the worker threads,
+  // -1 means no memory binding.
+  int32_t numa_node_id;
+  // The idle worker spins spin_time_us waiting for the next task before
+  // sleeping on worker_condition, 0 means sleep immediately.
+  int64_t spin_time_us{0};
+  // Cores, numa node and idle policy requested by repin, applied before the
+  // next task.
+  bool repin_requested{false};
+  std::vector<int32_t> repin_cpu_core_list;
+  int32_t repin_numa_node_id{-1};
+  int64_t repin_spin_time_us{0};
+
+  // Caching allocator installed around each task, nullptr if not enabled.
+  std::shared_ptr<MemoryArena> memory_arena;
+
+  // Work stealing domain, nullptr if work stealing is not enabled.
+  std::shared_ptr<TaskExecutorGroup> task_executor_group;
+
+  int64_t executor_id;
 
   // Put the deleted function in the private.
   TaskExecutor(const TaskExecutor& task_executor) =
@@ -53,6 +192,18 @@ class TaskExecutor {
       delete; // Not support copy or move construtor.
   TaskExecutor& operator=(TaskExecutor&& task_executor) =
       delete; // Not support copy or move construtor.
+
+  void start_worker();
+  // Pin the worker and warm up its OMP team for cpu_core_list.
+  void setup_worker_team();
+  bool has_queued_tasks() const;
+  // Must be called with worker_mutex held.
+  bool has_work() const;
+  // Spin up to spin_time_us until has_work.
+  void spin_wait_for_work();
+  // Must be called with worker_mutex held, after a task leaves the Normal
+  // lane.
+  void on_task_dequeued();
 };
 
 } // namespace runtime
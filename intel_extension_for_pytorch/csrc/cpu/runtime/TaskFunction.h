@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace torch_ipex {
+namespace runtime {
+
+/*TaskFunction is a move-only void() callable queued by the TaskExecutor.
+ * Unlike std::function, it accepts the move-only callables, e.g. the lambdas
+ * capturing a std::packaged_task or std::unique_ptr, and keeps the callables
+ * up to kInlineSize bytes inside itself without any heap allocation.*/
+class TaskFunction {
+ public:
+  static constexpr size_t kInlineSize = 12 * sizeof(void*);
+
+  TaskFunction() noexcept = default;
+
+  template <
+      class F,
+      typename = typename std::enable_if<!std::is_same<
+          typename std::decay<F>::type,
+          TaskFunction>::value>::type>
+  TaskFunction(F&& f) {
+    using Fn = typename std::decay<F>::type;
+    this->init<Fn>(std::forward<F>(f), IsInline<Fn>());
+  }
+
+  TaskFunction(TaskFunction&& other) noexcept {
+    this->move_from(other);
+  }
+
+  TaskFunction& operator=(TaskFunction&& other) noexcept {
+    if (this != &other) {
+      this->reset();
+      this->move_from(other);
+    }
+    return *this;
+  }
+
+  ~TaskFunction() {
+    this->reset();
+  }
+
+  void operator()() {
+    this->vtable->invoke(&this->storage);
+  }
+
+  explicit operator bool() const noexcept {
+    return this->vtable != nullptr;
+  }
+
+ private:
+  struct VTable {
+    void (*invoke)(void* storage);
+    // Move the callable from src into the empty dst, src is left empty.
+    void (*move)(void* dst, void* src);
+    void (*destroy)(void* storage);
+  };
+
+  template <class Fn>
+  using IsInline = std::integral_constant<
+      bool,
+      sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(std::max_align_t) &&
+          std::is_nothrow_move_constructible<Fn>::value>;
+
+  template <class Fn, class F>
+  void init(F&& f, std::true_type /*is_inline*/) {
+    new (&this->storage) Fn(std::forward<F>(f));
+    static const VTable inline_vtable = {
+        [](void* storage) { (*static_cast<Fn*>(storage))(); },
+        [](void* dst, void* src) {
+          new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+          static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* storage) { static_cast<Fn*>(storage)->~Fn(); }};
+    this->vtable = &inline_vtable;
+  }
+
+  template <class Fn, class F>
+  void init(F&& f, std::false_type /*is_inline*/) {
+    // Too large to be inlined, the storage keeps the pointer to the callable.
+    new (&this->storage) Fn*(new Fn(std::forward<F>(f)));
+    static const VTable heap_vtable = {
+        [](void* storage) { (**static_cast<Fn**>(storage))(); },
+        [](void* dst, void* src) {
+          new (dst) Fn*(*static_cast<Fn**>(src));
+        },
+        [](void* storage) { delete *static_cast<Fn**>(storage); }};
+    this->vtable = &heap_vtable;
+  }
+
+  void move_from(TaskFunction& other) noexcept {
+    if (other.vtable != nullptr) {
+      other.vtable->move(&this->storage, &other.storage);
+      this->vtable = other.vtable;
+      other.vtable = nullptr;
+    }
+  }
+
+  void reset() noexcept {
+    if (this->vtable != nullptr) {
+      this->vtable->destroy(&this->storage);
+      this->vtable = nullptr;
+    }
+  }
+
+  typename std::aligned_storage<kInlineSize, alignof(std::max_align_t)>::type
+      storage;
+  const VTable* vtable{nullptr};
+
+  TaskFunction(const TaskFunction& task_function) = delete;
+  TaskFunction& operator=(const TaskFunction& task_function) = delete;
+};
+
+} // namespace runtime
+} // namespace torch_ipex
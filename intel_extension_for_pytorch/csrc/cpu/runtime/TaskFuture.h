@@ -0,0 +1,176 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include <c10/util/Optional.h>
+
+namespace torch_ipex {
+namespace runtime {
+
+// The error of the future whose task is destroyed without running, e.g. dropped
+// from the full queue of the TaskExecutor by QueueFullPolicy::DropOldest.
+class TaskDroppedError : public std::runtime_error {
+ public:
+  using std::runtime_error::runtime_error;
+};
+
+namespace detail {
+
+// The shared state between one TaskFuture and the task producing its result.
+class TaskFutureStateBase {
+ public:
+  bool is_ready() const {
+    return this->ready.load(std::memory_order_acquire);
+  }
+
+  void wait() {
+    // Most of the results are ready soon after the submission, so spin a
+    // while before sleeping on the condition variable.
+    for (int i = 0; i < kSpinCount; i++) {
+      if (this->is_ready()) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->condition.wait(lock, [this] { return this->is_ready(); });
+  }
+
+  void set_exception(std::exception_ptr exception) {
+    this->exception = std::move(exception);
+    this->mark_ready();
+  }
+
+ protected:
+  void mark_ready() {
+    {
+      std::unique_lock<std::mutex> lock(this->mutex);
+      this->ready.store(true, std::memory_order_release);
+    }
+    this->condition.notify_all();
+  }
+
+  void rethrow_if_failed() {
+    if (this->exception) {
+      std::rethrow_exception(this->exception);
+    }
+  }
+
+ private:
+  static constexpr int kSpinCount = 64;
+  std::atomic<bool> ready{false};
+  std::mutex mutex;
+  std::condition_variable condition;
+  std::exception_ptr exception;
+};
+
+template <class T>
+class TaskFutureState : public TaskFutureStateBase {
+ public:
+  void set_value(T&& value) {
+    this->value = std::move(value);
+    this->mark_ready();
+  }
+
+  T get() {
+    this->wait();
+    this->rethrow_if_failed();
+    return std::move(*this->value);
+  }
+
+ private:
+  c10::optional<T> value;
+};
+
+template <>
+class TaskFutureState<void> : public TaskFutureStateBase {
+ public:
+  void set_value() {
+    this->mark_ready();
+  }
+
+  void get() {
+    this->wait();
+    this->rethrow_if_failed();
+  }
+};
+
+// TaskFuturePromise is owned by the submitted callable. If the callable is
+// destroyed without setting the result, the future gets TaskDroppedError
+// instead of waiting forever.
+template <class T>
+class TaskFuturePromise {
+ public:
+  explicit TaskFuturePromise(std::shared_ptr<TaskFutureState<T>> state)
+      : state(std::move(state)) {}
+  TaskFuturePromise(TaskFuturePromise&& promise) = default;
+  ~TaskFuturePromise() {
+    if (this->state && !this->state->is_ready()) {
+      this->state->set_exception(std::make_exception_ptr(
+          TaskDroppedError("The task is dropped before running")));
+    }
+  }
+
+  TaskFutureState<T>& get_state() {
+    return *this->state;
+  }
+
+ private:
+  std::shared_ptr<TaskFutureState<T>> state;
+
+  TaskFuturePromise(const TaskFuturePromise& promise) = delete;
+  TaskFuturePromise& operator=(const TaskFuturePromise& promise) = delete;
+};
+
+} // namespace detail
+
+/*TaskFuture is the light-weight future returned by Task::run_async. Its
+ * shared state takes a single allocation per submission, and
+ * waiting on a result which is already ready doesn't take any lock.*/
+template <class T>
+class TaskFuture {
+ public:
+  TaskFuture() = default;
+  explicit TaskFuture(std::shared_ptr<detail::TaskFutureState<T>> state)
+      : state(std::move(state)) {}
+
+  bool valid() const {
+    return static_cast<bool>(this->state);
+  }
+
+  bool is_ready() const {
+    return this->valid() && this->state->is_ready();
+  }
+
+  void wait() const {
+    this->check_valid();
+    this->state->wait();
+  }
+
+  // Wait and return the result, or rethrow the exception of the task. It can
+  // be called only once.
+  T get() {
+    this->check_valid();
+    auto state = std::move(this->state);
+    return state->get();
+  }
+
+ private:
+  void check_valid() const {
+    if (!this->state) {
+      throw std::runtime_error("TaskFuture has no shared state");
+    }
+  }
+
+  std::shared_ptr<detail::TaskFutureState<T>> state;
+};
+
+} // namespace runtime
+} // namespace torch_ipex
@@ -0,0 +1,92 @@
+#include "TaskTracer.h"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+
+#include <ATen/ThreadLocalState.h>
+#include <ATen/record_function.h>
+
+namespace torch_ipex {
+namespace runtime {
+
+namespace {
+
+std::atomic<bool> task_tracing_enabled{false};
+std::mutex task_traces_mutex;
+std::vector<TaskTraceRecord> task_traces;
+// The request ids generated for the tasks submitted without request id are
+// negative, so that they never conflict with the ids given by the user.
+std::atomic<int64_t> next_anonymous_request_id{-2};
+thread_local int64_t current_request_id = -1;
+
+int64_t now_us() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+} // namespace
+
+void set_task_tracing_enabled(bool enabled) {
+  task_tracing_enabled.store(enabled);
+}
+
+bool is_task_tracing_enabled() {
+  return task_tracing_enabled.load(std::memory_order_relaxed);
+}
+
+std::vector<TaskTraceRecord> get_task_traces() {
+  std::unique_lock<std::mutex> lock(task_traces_mutex);
+  return task_traces;
+}
+
+void clear_task_traces() {
+  std::unique_lock<std::mutex> lock(task_traces_mutex);
+  task_traces.clear();
+}
+
+int64_t get_current_request_id() {
+  return current_request_id;
+}
+
+void set_current_request_id(int64_t request_id) {
+  current_request_id = request_id;
+}
+
+TaskFunction trace_task(TaskFunction&& task, int64_t executor_id) {
+  int64_t request_id = current_request_id != -1
+      ? current_request_id
+      : next_anonymous_request_id.fetch_sub(1);
+  int64_t submit_time_us = now_us();
+  return TaskFunction([task = std::move(task),
+                       request_id,
+                       executor_id,
+                       submit_time_us,
+                       thread_local_state = at::ThreadLocalState()]() mutable {
+    at::ThreadLocalStateGuard thread_local_state_guard(thread_local_state);
+    RequestIdGuard request_id_guard(request_id);
+    TaskTraceRecord record{request_id, executor_id, submit_time_us, 0, 0};
+    record.start_time_us = now_us();
+    {
+      RECORD_FUNCTION(
+          "ipex::run_task", std::vector<c10::IValue>({request_id}));
+      task();
+    }
+    record.end_time_us = now_us();
+    std::unique_lock<std::mutex> lock(task_traces_mutex);
+    task_traces.emplace_back(record);
+  });
+}
+
+RequestIdGuard::RequestIdGuard(int64_t request_id)
+    : previous_request_id(current_request_id) {
+  current_request_id = request_id;
+}
+
+RequestIdGuard::~RequestIdGuard() {
+  current_request_id = this->previous_request_id;
+}
+
+} // namespace runtime
+} // namespace torch_ipex
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "TaskFunction.h"
+
+namespace torch_ipex {
+namespace runtime {
+
+// The timeline of one task executed by a TaskExecutor, the timestamps are in
+// microseconds of the steady clock.
+struct TaskTraceRecord {
+  // The request owning the task, see RequestIdGuard.
+  int64_t request_id;
+  // The TaskExecutor executing the task.
+  int64_t executor_id;
+  int64_t submit_time_us;
+  int64_t start_time_us;
+  int64_t end_time_us;
+};
+
+// Record the TaskTraceRecord of the tasks submitted afterwards. The traced
+// tasks also run with the thread local state of the submitting thread, so
+// that the profiler links the ops executed on the worker to the submission.
+void set_task_tracing_enabled(bool enabled);
+bool is_task_tracing_enabled();
+std::vector<TaskTraceRecord> get_task_traces();
+void clear_task_traces();
+
+// The request id of the tasks submitted by the current thread, -1 if not set.
+// The tasks submitted by a traced task inherit its request id.
+int64_t get_current_request_id();
+void set_current_request_id(int64_t request_id);
+
+// Wrap the task to record its TaskTraceRecord when it's executed.
+TaskFunction trace_task(TaskFunction&& task, int64_t executor_id);
+
+/*RequestIdGuard sets the request id of the tasks submitted by the current
+ * thread during its scope. The tasks submitted without any request id get a
+ * unique one.*/
+class RequestIdGuard {
+ public:
+  explicit RequestIdGuard(int64_t request_id);
+  ~RequestIdGuard();
+
+ private:
+  int64_t previous_request_id;
+
+  RequestIdGuard(const RequestIdGuard& request_id_guard) = delete;
+  RequestIdGuard& operator=(const RequestIdGuard& request_id_guard) = delete;
+};
+
+} // namespace runtime
+} // namespace torch_ipex
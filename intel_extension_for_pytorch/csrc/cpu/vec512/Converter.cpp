@@ -2,6 +2,10 @@
 #include <ATen/Parallel.h>
 #include <torch/extension.h>
 #include "bf16/vec/vec_type_cvt.h"
+#include "csrc/cpu/runtime/CPUPool.h"
+
+#include <algorithm>
+#include <vector>
 
 #define BF16_2_FP32(dst, src, len) cvt_bf16_to_fp32(dst, src, len)
 #define FP32_2_BF16(dst, src, len) cvt_fp32_to_bf16(dst, src, len)
@@ -19,109 +23,311 @@ void fp32_to_bf16(void* dst, const void* src, int len) {
   FP32_2_BF16((at::BFloat16*)dst, (float*)src, len);
 }
 
-at::Tensor cat_bfloat16_float(
-    const at::Tensor top_half_,
-    const at::Tensor bottom_half_) {
-  TORCH_CHECK(
-      top_half_.scalar_type() == at::kBFloat16 &&
-          bottom_half_.scalar_type() == at::kBFloat16,
-      "pack_bfloat16_float: expect both args to be at::BFloat16");
-  at::Tensor top_half = top_half_.contiguous();
-  at::Tensor bottom_half = bottom_half_.contiguous();
-  at::Tensor output = at::empty_strided(
-      top_half_.sizes(),
-      top_half_.strides(),
-      top_half_.options().dtype(at::kFloat));
-  at::Tensor output_contiguous = output.contiguous();
+namespace {
+
+// whether the tensors are of the same sizes and strides of a non-overlapping
+// and dense layout, e.g. contiguous or channels last, of which the elements
+// are computed in the order of memory without the contiguous copies
+bool is_same_dense_layout(const at::Tensor& a, const at::Tensor& b) {
+  return a.sizes() == b.sizes() && a.strides() == b.strides() &&
+      a.is_non_overlapping_and_dense();
+}
+
+void cat_bfloat16_float_kernel(
+    const at::BFloat16* top_half_data,
+    const at::BFloat16* bottom_half_data,
+    float* output_data,
+    int64_t numel) {
+  int64_t grain_size = 512;
+  at::parallel_for(0, numel, grain_size, [&](int64_t begin, int64_t end) {
+    // local pointers
+    const at::BFloat16* top_half_ptr = top_half_data + begin;
+    const at::BFloat16* bottom_half_ptr = bottom_half_data + begin;
+    float* output_ptr = output_data + begin;
+    const int64_t size = end - begin;
+#if defined(CPU_AVX512)
+    // float = top << 16 | bottom of 16 lanes at a time, of which the tail
+    // is masked
+    for (int64_t d = 0; d < size; d += 16) {
+      __mmask16 mask = size - d >= 16 ? 0xffff : (1 << (size - d)) - 1;
+      auto top = _mm512_cvtepu16_epi32(
+          _mm256_maskz_loadu_epi16(mask, top_half_ptr + d));
+      auto bottom = _mm512_cvtepu16_epi32(
+          _mm256_maskz_loadu_epi16(mask, bottom_half_ptr + d));
+      auto out = _mm512_or_si512(_mm512_slli_epi32(top, 16), bottom);
+      _mm512_mask_storeu_ps(output_ptr + d, mask, _mm512_castsi512_ps(out));
+    }
+#else
+    using bVec = at::vec::Vectorized<at::BFloat16>;
+    using fVec = at::vec::Vectorized<float>;
+    int64_t d = 0;
+    for (; d < size - (size % bVec::size()); d += bVec::size()) {
+      bVec top_half_bvec = bVec::loadu(top_half_ptr + d);
+      bVec bottom_half_bvec = bVec::loadu(bottom_half_ptr + d);
+      fVec fvec, fvec2;
+      std::tie(fvec, fvec2) =
+          pack_bfloat16_float(top_half_bvec, bottom_half_bvec);
+      fvec.store(output_ptr + d);
+      fvec2.store(output_ptr + d + fVec::size());
+    }
+    for (; d < size; d++) {
+      output_ptr[d] =
+          bf16::pack_bfloat16_float(top_half_ptr[d], bottom_half_ptr[d]);
+    }
+#endif
+  });
+}
+
+// splits the size floats of the range of a thread
+void split_float_bfloat16_range(
+    const float* tensor_ptr,
+    at::BFloat16* top_half_ptr,
+    at::BFloat16* bottom_half_ptr,
+    int64_t size) {
+#if defined(CPU_AVX512)
+  // top = float >> 16 and bottom = float & 0xffff of 16 lanes at a time,
+  // of which the tail is masked
+  const auto low_mask = _mm512_set1_epi32(0xffff);
+  for (int64_t d = 0; d < size; d += 16) {
+    __mmask16 mask = size - d >= 16 ? 0xffff : (1 << (size - d)) - 1;
+    auto x = _mm512_castps_si512(_mm512_maskz_loadu_ps(mask, tensor_ptr + d));
+    auto top = _mm512_cvtepi32_epi16(_mm512_srli_epi32(x, 16));
+    auto bottom = _mm512_cvtepi32_epi16(_mm512_and_si512(x, low_mask));
+    _mm256_mask_storeu_epi16(top_half_ptr + d, mask, top);
+    _mm256_mask_storeu_epi16(bottom_half_ptr + d, mask, bottom);
+  }
+#else
+  using bVec = at::vec::Vectorized<at::BFloat16>;
+  using fVec = at::vec::Vectorized<float>;
+  int64_t d = 0;
+  for (; d < size - (size % bVec::size()); d += bVec::size()) {
+    fVec fvec = fVec::loadu(tensor_ptr + d);
+    fVec fvec2 = fVec::loadu(tensor_ptr + d + fVec::size());
+    bVec top_half_bvec, bottom_half_bvec;
+    std::tie(top_half_bvec, bottom_half_bvec) =
+        unpack_float_bfloat16(fvec, fvec2);
+    top_half_bvec.store(top_half_ptr + d);
+    bottom_half_bvec.store(bottom_half_ptr + d);
+  }
+  for (; d < size; d++) {
+    at::BFloat16 top_half_val;
+    at::BFloat16 bottom_half_val;
+    std::tie(top_half_val, bottom_half_val) =
+        unpack_float_bfloat16(tensor_ptr[d]);
+    top_half_ptr[d] = top_half_val;
+    bottom_half_ptr[d] = bottom_half_val;
+  }
+#endif
+}
+
+// the bf16 of the size floats of the range of a thread, rounded to nearest
+// even as the Tensor.bfloat16() of them
+void cast_float_bfloat16_range(
+    const float* tensor_ptr,
+    at::BFloat16* output_ptr,
+    int64_t size) {
   using bVec = at::vec::Vectorized<at::BFloat16>;
   using fVec = at::vec::Vectorized<float>;
-  at::BFloat16* top_half_data = top_half.data_ptr<at::BFloat16>();
-  at::BFloat16* bottom_half_data = bottom_half.data_ptr<at::BFloat16>();
-  float* output_data = output_contiguous.data_ptr<float>();
+  int64_t d = 0;
+  for (; d < size - (size % bVec::size()); d += bVec::size()) {
+    fVec fvec = fVec::loadu(tensor_ptr + d);
+    fVec fvec2 = fVec::loadu(tensor_ptr + d + fVec::size());
+    bVec out = at::vec::convert_float_bfloat16(fvec, fvec2);
+    out.store(output_ptr + d);
+  }
+  for (; d < size; d++) {
+    output_ptr[d] = at::BFloat16(tensor_ptr[d]);
+  }
+}
+
+void split_float_bfloat16_kernel(
+    const float* tensor_data,
+    at::BFloat16* top_half_data,
+    at::BFloat16* bottom_half_data,
+    int64_t numel) {
   int64_t grain_size = 512;
-  at::parallel_for(
-      0, top_half.numel(), grain_size, [&](int64_t begin, int64_t end) {
-        // local pointers
-        at::BFloat16* top_half_ptr = top_half_data + begin;
-        at::BFloat16* bottom_half_ptr = bottom_half_data + begin;
-        float* output_ptr = output_data + begin;
-        const int64_t size = end - begin;
-        int64_t d = 0;
-        for (; d < size - (size % bVec::size()); d += bVec::size()) {
-          bVec top_half_bvec = bVec::loadu(top_half_ptr + d);
-          bVec bottom_half_bvec = bVec::loadu(bottom_half_ptr + d);
-          fVec fvec, fvec2;
-          std::tie(fvec, fvec2) =
-              pack_bfloat16_float(top_half_bvec, bottom_half_bvec);
-          fvec.store(output_ptr + d);
-          fvec2.store(output_ptr + d + fVec::size());
-        }
-        for (; d < size; d++) {
-          output_ptr[d] =
-              bf16::pack_bfloat16_float(top_half_ptr[d], bottom_half_ptr[d]);
-        }
-      });
-  if (!output.is_contiguous()) {
+  at::parallel_for(0, numel, grain_size, [&](int64_t begin, int64_t end) {
+    split_float_bfloat16_range(
+        tensor_data + begin,
+        top_half_data + begin,
+        bottom_half_data + begin,
+        end - begin);
+  });
+}
+
+} // namespace
+
+at::Tensor& cat_bfloat16_float_out(
+    const at::Tensor& top_half,
+    const at::Tensor& bottom_half,
+    at::Tensor& output) {
+  TORCH_CHECK(
+      top_half.scalar_type() == at::kBFloat16 &&
+          bottom_half.scalar_type() == at::kBFloat16,
+      "cat_bfloat16_float: expect both args to be at::BFloat16");
+  TORCH_CHECK(
+      output.scalar_type() == at::kFloat,
+      "cat_bfloat16_float: expect the output to be at::kFloat");
+  TORCH_CHECK(
+      top_half.sizes() == bottom_half.sizes() &&
+          top_half.sizes() == output.sizes(),
+      "cat_bfloat16_float: expect the halves and the output of the same size");
+  if (is_same_dense_layout(top_half, bottom_half) &&
+      is_same_dense_layout(top_half, output)) {
+    cat_bfloat16_float_kernel(
+        top_half.data_ptr<at::BFloat16>(),
+        bottom_half.data_ptr<at::BFloat16>(),
+        output.data_ptr<float>(),
+        output.numel());
+    return output;
+  }
+  auto top_half_contiguous = top_half.contiguous();
+  auto bottom_half_contiguous = bottom_half.contiguous();
+  auto output_contiguous = output.contiguous();
+  cat_bfloat16_float_kernel(
+      top_half_contiguous.data_ptr<at::BFloat16>(),
+      bottom_half_contiguous.data_ptr<at::BFloat16>(),
+      output_contiguous.data_ptr<float>(),
+      output.numel());
+  if (!output.is_same(output_contiguous)) {
     output.copy_(output_contiguous);
   }
   return output;
 }
 
-std::tuple<at::Tensor, at::Tensor> split_float_bfloat16(
-    const at::Tensor tensor_) {
+at::Tensor cat_bfloat16_float(
+    const at::Tensor top_half,
+    const at::Tensor bottom_half) {
+  auto output = at::empty_strided(
+      top_half.sizes(),
+      top_half.strides(),
+      top_half.options().dtype(at::kFloat));
+  cat_bfloat16_float_out(top_half, bottom_half, output);
+  return output;
+}
+
+void split_float_bfloat16_out(
+    const at::Tensor& tensor,
+    at::Tensor& top_half,
+    at::Tensor& bottom_half) {
+  TORCH_CHECK(
+      tensor.scalar_type() == at::kFloat,
+      "split_float_bfloat16: expect the tensor to be at::kFloat");
   TORCH_CHECK(
-      tensor_.scalar_type() == at::kFloat,
-      "pack_bfloat16_float: expect both tensor to be at::kFloat");
-
-  auto tensor = tensor_.contiguous();
-  auto top_half = at::empty_strided(
-      tensor_.sizes(),
-      tensor_.strides(),
-      tensor_.options().dtype(at::kBFloat16));
+      top_half.scalar_type() == at::kBFloat16 &&
+          bottom_half.scalar_type() == at::kBFloat16,
+      "split_float_bfloat16: expect both halves to be at::BFloat16");
+  TORCH_CHECK(
+      tensor.sizes() == top_half.sizes() &&
+          tensor.sizes() == bottom_half.sizes(),
+      "split_float_bfloat16: expect the tensor and the halves of the same "
+      "size");
+  if (is_same_dense_layout(tensor, top_half) &&
+      is_same_dense_layout(tensor, bottom_half)) {
+    split_float_bfloat16_kernel(
+        tensor.data_ptr<float>(),
+        top_half.data_ptr<at::BFloat16>(),
+        bottom_half.data_ptr<at::BFloat16>(),
+        tensor.numel());
+    return;
+  }
+  auto tensor_contiguous = tensor.contiguous();
   auto top_half_contiguous = top_half.contiguous();
-  auto bottom_half = at::empty_strided(
-      tensor_.sizes(),
-      tensor_.strides(),
-      tensor_.options().dtype(at::kBFloat16));
   auto bottom_half_contiguous = bottom_half.contiguous();
-  using bVec = at::vec::Vectorized<at::BFloat16>;
-  using fVec = at::vec::Vectorized<float>;
-  at::BFloat16* top_half_data = top_half_contiguous.data_ptr<at::BFloat16>();
-  at::BFloat16* bottom_half_data =
-      bottom_half_contiguous.data_ptr<at::BFloat16>();
-  float* tensor_data = tensor.data_ptr<float>();
-  int64_t grain_size = 512;
-  at::parallel_for(
-      0, top_half.numel(), grain_size, [&](int64_t begin, int64_t end) {
-        // local pointers
-        at::BFloat16* top_half_ptr = top_half_data + begin;
-        at::BFloat16* bottom_half_ptr = bottom_half_data + begin;
-        float* tensor_ptr = tensor_data + begin;
-        const int64_t size = end - begin;
-        int64_t d = 0;
-        for (; d < size - (size % bVec::size()); d += bVec::size()) {
-          fVec fvec = fVec::loadu(tensor_ptr + d);
-          fVec fvec2 = fVec::loadu(tensor_ptr + d + fVec::size());
-          bVec top_half_bvec, bottom_half_bvec;
-          std::tie(top_half_bvec, bottom_half_bvec) =
-              unpack_float_bfloat16(fvec, fvec2);
-          top_half_bvec.store(top_half_ptr + d);
-          bottom_half_bvec.store(bottom_half_ptr + d);
-        }
-        for (; d < size; d++) {
-          at::BFloat16 top_half_val;
-          at::BFloat16 bottom_half_val;
-          std::tie(top_half_val, bottom_half_val) =
-              unpack_float_bfloat16(tensor_ptr[d]);
-          top_half_ptr[d] = top_half_val;
-          bottom_half_ptr[d] = bottom_half_val;
-        }
-      });
-  if (!top_half.is_contiguous()) {
+  split_float_bfloat16_kernel(
+      tensor_contiguous.data_ptr<float>(),
+      top_half_contiguous.data_ptr<at::BFloat16>(),
+      bottom_half_contiguous.data_ptr<at::BFloat16>(),
+      tensor.numel());
+  if (!top_half.is_same(top_half_contiguous)) {
     top_half.copy_(top_half_contiguous);
+  }
+  if (!bottom_half.is_same(bottom_half_contiguous)) {
     bottom_half.copy_(bottom_half_contiguous);
   }
-  return std::tie(top_half, bottom_half);
+}
+
+std::tuple<at::Tensor, at::Tensor> split_float_bfloat16(
+    const at::Tensor tensor) {
+  auto options = tensor.options().dtype(at::kBFloat16);
+  auto top_half = at::empty_strided(tensor.sizes(), tensor.strides(), options);
+  auto bottom_half =
+      at::empty_strided(tensor.sizes(), tensor.strides(), options);
+  split_float_bfloat16_out(tensor, top_half, bottom_half);
+  return std::make_tuple(top_half, bottom_half);
+}
+
+std::tuple<std::vector<at::Tensor>, std::vector<at::Tensor>>
+cast_to_bfloat16_batch(
+    const std::vector<at::Tensor>& tensors,
+    bool split,
+    int64_t numa_node_id) {
+  // the dense inputs of the tensors and the outputs of their layouts, of
+  // which the elements are cast in the order of the memory
+  std::vector<at::Tensor> inputs;
+  std::vector<at::Tensor> top_halves;
+  std::vector<at::Tensor> bottom_halves;
+  // the elements of the tensors before each of them in all the tensors
+  std::vector<int64_t> offsets = {0};
+  for (const auto& tensor : tensors) {
+    TORCH_CHECK(
+        tensor.scalar_type() == at::kFloat,
+        "cast_to_bfloat16_batch: expect the tensors to be at::kFloat");
+    auto input =
+        tensor.is_non_overlapping_and_dense() ? tensor : tensor.contiguous();
+    auto options = input.options().dtype(at::kBFloat16);
+    top_halves.push_back(
+        at::empty_strided(input.sizes(), input.strides(), options));
+    if (split) {
+      bottom_halves.push_back(
+          at::empty_strided(input.sizes(), input.strides(), options));
+    }
+    offsets.push_back(offsets.back() + input.numel());
+    inputs.push_back(std::move(input));
+  }
+
+  // the outputs are not touched yet, of which the pages are allocated on the
+  // given node, or by the first touch of the threads which cast them
+  auto bind_outputs = [&](const std::vector<at::Tensor>& outputs) {
+    for (const auto& output : outputs) {
+      torch_ipex::runtime::_bind_memory_to_numa_node(
+          output.data_ptr(), output.nbytes(), numa_node_id);
+    }
+  };
+  if (numa_node_id >= 0) {
+    bind_outputs(top_halves);
+    bind_outputs(bottom_halves);
+  }
+
+  // parallel on the elements of all the tensors instead of one tensor at a
+  // time, so that the small ones, e.g. the biases, are cast together
+  int64_t grain_size = 2048;
+  int64_t numel = offsets.back();
+  at::parallel_for(0, numel, grain_size, [&](int64_t begin, int64_t end) {
+    int64_t i = std::upper_bound(offsets.begin(), offsets.end(), begin) -
+        offsets.begin() - 1;
+    for (int64_t pos = begin; pos < end; i++) {
+      int64_t local_begin = pos - offsets[i];
+      int64_t size = std::min(end, offsets[i + 1]) - pos;
+      if (size <= 0) {
+        continue;
+      }
+      const float* input_ptr = inputs[i].data_ptr<float>() + local_begin;
+      at::BFloat16* top_half_ptr =
+          top_halves[i].data_ptr<at::BFloat16>() + local_begin;
+      if (split) {
+        split_float_bfloat16_range(
+            input_ptr,
+            top_half_ptr,
+            bottom_halves[i].data_ptr<at::BFloat16>() + local_begin,
+            size);
+      } else {
+        cast_float_bfloat16_range(input_ptr, top_half_ptr, size);
+      }
+      pos += size;
+    }
+  });
+  return std::make_tuple(std::move(top_halves), std::move(bottom_halves));
 }
 
 } // namespace converter
@@ -138,6 +344,18 @@ TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
   m.def(
       "cat_bfloat16_float(Tensor top_half, Tensor bot_half) -> Tensor",
       torch_ipex::cpu::bf16::converter::cat_bfloat16_float);
+  m.def(
+      "split_float_bfloat16_out(Tensor tensor, Tensor(a!) top, "
+      "Tensor(b!) bot) -> ()",
+      torch_ipex::cpu::bf16::converter::split_float_bfloat16_out);
+  m.def(
+      "cat_bfloat16_float_out(Tensor top_half, Tensor bot_half, "
+      "Tensor(a!) out) -> Tensor(a!)",
+      torch_ipex::cpu::bf16::converter::cat_bfloat16_float_out);
+  m.def(
+      "cast_to_bfloat16_batch(Tensor[] tensors, bool split, "
+      "int numa_node_id=-1) -> (Tensor[], Tensor[])",
+      torch_ipex::cpu::bf16::converter::cast_to_bfloat16_batch);
 }
 
 } // namespace
@@ -1,5 +1,9 @@
 #pragma once
 #include <ATen/Tensor.h>
+
+#include <tuple>
+#include <vector>
+
 namespace torch_ipex {
 namespace cpu {
 namespace bf16 {
@@ -12,6 +16,28 @@ at::Tensor cat_bfloat16_float(
     const at::Tensor bottom_half);
 std::tuple<at::Tensor, at::Tensor> split_float_bfloat16(
     const at::Tensor tensor);
+// The variants of which the output is written in place of the given tensors,
+// e.g. of the master weight and its trail, instead of the new tensors.
+// Tensors of the same dense layout are computed without the contiguous
+// copies, and the others through them.
+at::Tensor& cat_bfloat16_float_out(
+    const at::Tensor& top_half,
+    const at::Tensor& bottom_half,
+    at::Tensor& output);
+void split_float_bfloat16_out(
+    const at::Tensor& tensor,
+    at::Tensor& top_half,
+    at::Tensor& bottom_half);
+// The bf16 of all the fp32 tensors, or their top and bottom halves if split,
+// which are cast in parallel on the elements of all of them. The outputs are
+// bound to the numa_node_id, e.g. of the CPUPool the model runs on, before
+// they are touched, and otherwise allocated by the first touch of the casting
+// threads for -1.
+std::tuple<std::vector<at::Tensor>, std::vector<at::Tensor>>
+cast_to_bfloat16_batch(
+    const std::vector<at::Tensor>& tensors,
+    bool split,
+    int64_t numa_node_id);
 } // namespace converter
 } // namespace bf16
 } // namespace cpu
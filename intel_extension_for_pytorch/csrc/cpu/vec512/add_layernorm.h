@@ -7,6 +7,7 @@
 #include <ATen/Parallel.h>
 #include <c10/util/SmallVector.h>
 #include <limits>
+#include <vector>
 #include "utils.h"
 
 namespace torch_ipex {
@@ -57,6 +58,37 @@ std::pair<float, float> _add_and_compute_mean_var(
   return std::make_pair(mean_var, var_val);
 }
 
+// sum of the squares of a + b, or of a if there is no b, of which the float
+// values are stored to out for the normalization
+template <typename T>
+float _add_and_compute_sum_square(
+    const T* a_ptr,
+    const T* b_ptr,
+    const int64_t& size,
+    float* out) {
+  auto vec_acc_pow = _mm512_setzero_ps();
+  int64_t i = 0;
+  for (; i <= size - 16; i += 16) {
+    auto vec_x = _load_f32_data(a_ptr + i);
+    if (b_ptr) {
+      vec_x = _mm512_add_ps(vec_x, _load_f32_data(b_ptr + i));
+    }
+    _mm512_storeu_ps(out + i, vec_x);
+    vec_acc_pow = _mm512_fmadd_ps(vec_x, vec_x, vec_acc_pow);
+  }
+  if (i < size) {
+    __mmask16 mask = (1 << (size - i)) - 1;
+    auto vec_x = _maskz_load_f32_data(a_ptr + i, mask);
+    if (b_ptr) {
+      vec_x = _mm512_add_ps(vec_x, _maskz_load_f32_data(b_ptr + i, mask));
+    }
+    _mm512_mask_storeu_ps(out + i, mask, vec_x);
+    // the masked lanes are zeros
+    vec_acc_pow = _mm512_fmadd_ps(vec_x, vec_x, vec_acc_pow);
+  }
+  return _mm512_reduce_add_ps(vec_acc_pow);
+}
+
 template <typename T, typename T1>
 void _normalize_kernel(
     T* out_ptr,
@@ -91,10 +123,10 @@ void _normalize_kernel(
     auto vec_input = _maskz_load_f32_data(input_ptr + i, mask);
     auto vec_gamma = vec_one;
     auto vec_beta = vec_zero;
-    if (!gamma_ptr) {
+    if (gamma_ptr) {
       vec_gamma = _maskz_load_f32_data(gamma_ptr + i, mask);
     }
-    if (!beta_ptr) {
+    if (beta_ptr) {
       vec_beta = _maskz_load_f32_data(beta_ptr + i, mask);
     }
     //(a_ptr[i] * scale + bias) * gamma + beta;
@@ -147,6 +179,58 @@ void AddLayerNormKernelImpl(
   });
 }
 
+// rms_norm of the rows of a + b, or of a if b is not defined. The sum is also
+// stored to S if it is defined, and the rstd of the rows to rstd_data if it
+// is not null, for the backward.
+template <typename T, typename T1>
+void RMSNormKernelImpl(
+    const Tensor& a,
+    const Tensor& b,
+    const Tensor& gamma,
+    int64_t M,
+    int64_t N,
+    float eps,
+    Tensor& Y,
+    Tensor& S,
+    float* rstd_data) {
+  DCHECK_EQ(a.numel(), M * N);
+  DCHECK(!gamma.defined() || gamma.numel() == N);
+  const T* a_data = a.data_ptr<T>();
+  const T* b_data = b.defined() ? b.data_ptr<T>() : nullptr;
+  const T1* gamma_data = gamma.defined() ? gamma.data_ptr<T1>() : nullptr;
+  T* Y_data = Y.data_ptr<T>();
+  T* S_data = S.defined() ? S.data_ptr<T>() : nullptr;
+  int64_t grain_size =
+      std::max<int64_t>(1, at::internal::GRAIN_SIZE / std::max<int64_t>(N, 1));
+  at::parallel_for(0, M, grain_size, [&](int64_t start, int64_t end) {
+    std::vector<float> tmp_out(N);
+    for (const auto i : c10::irange(start, end)) {
+      float sum_square = _add_and_compute_sum_square<T>(
+          a_data + i * N,
+          b_data ? b_data + i * N : nullptr,
+          N,
+          tmp_out.data());
+      float rstd_val =
+          float(1.0) / std::sqrt(sum_square / static_cast<float>(N) + eps);
+      if (S_data) {
+        _normalize_kernel<T, T1>(
+            S_data + i * N, tmp_out.data(), N, 1.0, 0.0, nullptr, nullptr);
+      }
+      _normalize_kernel<T, T1>(
+          Y_data + i * N,
+          tmp_out.data(),
+          N,
+          rstd_val,
+          0.0,
+          gamma_data,
+          nullptr);
+      if (rstd_data) {
+        rstd_data[i] = rstd_val;
+      }
+    }
+  });
+}
+
 } // namespace vec512
 } // namespace vec
 } // namespace kernel
@@ -7,6 +7,7 @@
 #include <ATen/Parallel.h>
 #include <c10/util/SmallVector.h>
 #include <limits>
+#include "csrc/aten/cpu/utils/vec_math.h"
 #include "utils.h"
 
 namespace torch_ipex {
@@ -59,67 +60,7 @@ inline int64_t _calc_element_offset(
 }
 
 inline __m512 _dil_exp_kernel(__m512 vec_src) {
-  static __m512 vec_factorial_1 =
-      _mm512_set1_ps(0.999999701f); // 1/factorial(1)
-  static __m512 vec_factorial_2 =
-      _mm512_set1_ps(0.499991506f); // 1/factorial(2)
-  static __m512 vec_factorial_3 =
-      _mm512_set1_ps(0.166676521f); // 1/factorial(3)
-  static __m512 vec_factorial_4 =
-      _mm512_set1_ps(0.0418978221f); // 1/factorial(4)
-  static __m512 vec_factorial_5 =
-      _mm512_set1_ps(0.00828929059f); // 1/factorial(5)
-  static __m512 vec_exp_log2ef =
-      (__m512)_mm512_set1_epi32(0x3fb8aa3b); // log2(e)
-  static __m512 vec_half = _mm512_set1_ps(0.5f);
-  static __m512 vec_one = _mm512_set1_ps(1.f);
-  static __m512 vec_zero = _mm512_set1_ps(0.f);
-  static __m512 vec_two = _mm512_set1_ps(2.f);
-  static __m512 vec_ln2f = (__m512)_mm512_set1_epi32(0x3f317218); // ln(2)
-  static __m512 vec_ln_flt_min = (__m512)_mm512_set1_epi32(0xc2aeac50);
-  static __m512 vec_ln_flt_max = (__m512)_mm512_set1_epi32(0x42b17218);
-  static __m512i vec_127 = _mm512_set1_epi32(0x0000007f);
-  static int n_mantissa_bits = 23;
-
-  // exp(x) =
-  // = exp(n * ln(2) + r) // divide x by ln(2) and get quot and rem
-  // = 2^n * exp(r) // simplify the exp(n*ln(2)) expression
-
-  auto less_ln_flt_min_mask =
-      _mm512_cmp_ps_mask(vec_src, vec_ln_flt_min, 1 /*_CMP_LT_OS*/);
-  vec_src = _mm512_min_ps(vec_src, vec_ln_flt_max);
-  vec_src = _mm512_max_ps(vec_src, vec_ln_flt_min);
-
-  // fx = floorf(x * log2ef + 0.5)
-  auto vec_fx = _mm512_fmadd_ps(vec_src, vec_exp_log2ef, vec_half);
-  auto vec_fx_i = _mm512_cvt_roundps_epi32(
-      vec_fx, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC);
-  vec_fx = _mm512_cvtepi32_ps(vec_fx_i);
-
-  // x = x - fx * ln2
-  auto vec_exp_poly = _mm512_fnmadd_ps(vec_fx, vec_ln2f, vec_src);
-
-  // compute polynomial
-  auto vec_res =
-      _mm512_fmadd_ps(vec_exp_poly, vec_factorial_5, vec_factorial_4);
-  vec_res = _mm512_fmadd_ps(vec_exp_poly, vec_res, vec_factorial_3);
-  vec_res = _mm512_fmadd_ps(vec_exp_poly, vec_res, vec_factorial_2);
-  vec_res = _mm512_fmadd_ps(vec_exp_poly, vec_res, vec_factorial_1);
-  vec_res = _mm512_fmadd_ps(vec_exp_poly, vec_res, vec_one);
-
-  // compute 2^(n-1)
-  auto vec_exp_number = _mm512_sub_ps(vec_fx, vec_one);
-  auto vec_exp_number_i = _mm512_cvtps_epi32(vec_exp_number);
-  auto vec_two_pow_n_i = _mm512_add_epi32(vec_exp_number_i, vec_127);
-  vec_two_pow_n_i = _mm512_slli_epi32(vec_two_pow_n_i, n_mantissa_bits);
-  auto vec_two_pow_n = (__m512)vec_two_pow_n_i;
-  vec_two_pow_n =
-      _mm512_mask_blend_ps(less_ln_flt_min_mask, vec_two_pow_n, vec_zero);
-
-  // y = y * 2^n
-  vec_res = _mm512_mul_ps(vec_res, vec_two_pow_n);
-  vec_res = _mm512_mul_ps(vec_res, vec_two);
-  return vec_res;
+  return vec_math::exp_ps<vec_math::Accuracy::Accurate>(vec_src);
 }
 
 template <typename scalar_t>
@@ -312,6 +253,125 @@ at::Tensor dil_div_add_softmax(
   return output;
 } // dil_add_softmax
 
+// The max and the sum of exp(a - max) of a row in a single read of it: each
+// lane keeps the running max and the running sum, which is rescaled by
+// exp(old_max - new_max) whenever the max rises, and the lanes are merged
+// the same way at the end.
+template <typename scalar_t>
+inline void _dil_online_max_sum_kernel(
+    const scalar_t* a,
+    const int64_t& size,
+    float& max,
+    float& sum) {
+  // the lowest float instead of -inf, of which the rescale would be NaN
+  auto vec_max = _mm512_set1_ps(std::numeric_limits<float>::lowest());
+  auto vec_sum = _mm512_setzero_ps();
+
+  int64_t i = 0;
+  for (; i <= size - 16; i += 16) {
+    auto vec_a = _load_f32_data(a + i);
+    auto vec_new_max = _mm512_max_ps(vec_max, vec_a);
+    vec_sum = _mm512_mul_ps(
+        vec_sum, _dil_exp_kernel(_mm512_sub_ps(vec_max, vec_new_max)));
+    vec_sum = _mm512_add_ps(
+        vec_sum, _dil_exp_kernel(_mm512_sub_ps(vec_a, vec_new_max)));
+    vec_max = vec_new_max;
+  }
+
+  if (i < size) {
+    __mmask16 mask = (1 << (size - i)) - 1;
+    auto vec_a = _maskz_load_f32_data(a + i, mask);
+    auto vec_new_max = _mm512_mask_max_ps(vec_max, mask, vec_max, vec_a);
+    vec_sum = _mm512_mul_ps(
+        vec_sum, _dil_exp_kernel(_mm512_sub_ps(vec_max, vec_new_max)));
+    vec_sum = _mm512_mask_add_ps(
+        vec_sum,
+        mask,
+        vec_sum,
+        _dil_exp_kernel(_mm512_sub_ps(vec_a, vec_new_max)));
+    vec_max = vec_new_max;
+  }
+
+  // NOTE: _mm512_reduce_max_ps and _mm512_reduce_add_ps are sequence
+  // instructions
+  max = _mm512_reduce_max_ps(vec_max);
+  vec_sum = _mm512_mul_ps(
+      vec_sum,
+      _dil_exp_kernel(_mm512_sub_ps(vec_max, _mm512_set1_ps(max))));
+  sum = _mm512_reduce_add_ps(vec_sum);
+}
+
+// out = exp(a - shift) * scale
+template <typename scalar_t>
+inline void _dil_exp_scale_kernel(
+    const scalar_t* a,
+    const float& shift,
+    const float& scale,
+    const int64_t& size,
+    scalar_t* out) {
+  auto vec_shift = _mm512_set1_ps(shift);
+  auto vec_scale = _mm512_set1_ps(scale);
+
+  int64_t i = 0;
+  for (; i <= size - 16; i += 16) {
+    auto vec_a = _load_f32_data(a + i);
+    auto vec_out = _dil_exp_kernel(_mm512_sub_ps(vec_a, vec_shift));
+    _store_data(out + i, _mm512_mul_ps(vec_out, vec_scale));
+  }
+
+  if (i < size) {
+    __mmask16 mask = (1 << (size - i)) - 1;
+    auto vec_a = _maskz_load_f32_data(a + i, mask);
+    auto vec_out = _dil_exp_kernel(_mm512_sub_ps(vec_a, vec_shift));
+    _mask_store_data(out + i, _mm512_mul_ps(vec_out, vec_scale), mask);
+  }
+}
+
+/**
+ * @brief The softmax of the last dim in two reads of each row instead of
+ * three: the max and the sum of the exp are found together by the online
+ * softmax, and the row is normalized in the second read, so that the long
+ * rows, e.g. of the attention of long sequences or of the logits of a
+ * vocabulary, are not read a third time.
+ *
+ * @attention
+ * - The input tensor is contiguous
+ * - The datatype for input and output are same.
+ *
+ * @param[in] input a contiguous tensor
+ * @return The tensor stores the result of @code softmax(input, -1) @endcode
+ */
+template <typename scalar_t>
+at::Tensor dil_online_softmax(const at::Tensor& input) {
+  const scalar_t* input_data_base = input.data_ptr<scalar_t>();
+  at::Tensor output = at::empty_like(input);
+  scalar_t* output_data_base = output.data_ptr<scalar_t>();
+
+  int64_t dim_size = input.size(-1);
+  int64_t outer_size = dim_size == 0 ? 0 : input.numel() / dim_size;
+  int64_t grain_size =
+      at::internal::GRAIN_SIZE / std::max<int64_t>(16 * dim_size, 1);
+  if (grain_size < 1)
+    grain_size = 1;
+
+  at::parallel_for(0, outer_size, grain_size, [&](int64_t begin, int64_t end) {
+    float max = 0.f;
+    float sum = 0.f;
+    for (int64_t i = begin; i < end; i++) {
+      _dil_online_max_sum_kernel<scalar_t>(
+          input_data_base + i * dim_size, dim_size, max, sum);
+      // out = exp(a - max) / sum
+      _dil_exp_scale_kernel<scalar_t>(
+          input_data_base + i * dim_size,
+          max,
+          1.f / sum,
+          dim_size,
+          output_data_base + i * dim_size);
+    }
+  });
+  return output;
+}
+
 } // namespace vec512
 } // namespace vec
 } // namespace kernel
@@ -1,5 +1,7 @@
 #include "vec_type_cvt.h"
 
+#include "csrc/aten/cpu/utils/stream_store.h"
+
 #if defined(CPU_AVX512)
 #include <immintrin.h>
 #else
@@ -181,9 +183,31 @@ inline void add_ker(double* inout, double* in, int len) {
   }
 }
 
-static inline void move_ker(at::BFloat16* out, float* in, int64_t len) {
+// The non-temporal variants of move_ker and zero_ker, which write the 64
+// bytes aligned lines of out by the streaming stores and the head and the
+// tail of out by the regular ones. The caller fences the stores by _mm_sfence
+// before the output is read by the other threads. move_ker and zero_ker
+// switch to them by themselves for the len of use_stream_store.
+static inline void stream_move_ker(
+    at::BFloat16* out,
+    const float* in,
+    int64_t len);
+static inline void stream_move_ker(float* out, const float* in, int64_t len);
+static inline void stream_move_ker(
+    at::BFloat16* out,
+    const at::BFloat16* in,
+    int64_t len);
+static inline void stream_zero_ker(float* out, int64_t len);
+static inline void stream_zero_ker(at::BFloat16* out, int64_t len);
+
+static inline void move_ker(at::BFloat16* out, const float* in, int64_t len) {
   int64_t i = 0;
 #if defined(CPU_AVX512)
+  if (torch_ipex::cpu::use_stream_store(len * sizeof(at::BFloat16))) {
+    stream_move_ker(out, in, len);
+    _mm_sfence();
+    return;
+  }
 #pragma unroll(4)
   for (i = 0; i < len - 31; i += 32) {
     auto in0 = cvt_fp32_to_bf16(_mm512_loadu_ps(in + i));
@@ -211,6 +235,11 @@ static inline void move_ker(at::BFloat16* out, float* in, int64_t len) {
 static inline void move_ker(float* out, const float* in, int64_t len) {
   int64_t i = 0;
 #if defined(CPU_AVX512)
+  if (torch_ipex::cpu::use_stream_store(len * sizeof(float))) {
+    stream_move_ker(out, in, len);
+    _mm_sfence();
+    return;
+  }
 #pragma unroll(4)
   for (i = 0; i < len - 15; i += 16) {
     auto in0 = _mm512_loadu_ps(in + i);
@@ -233,6 +262,11 @@ static inline void move_ker(
     int64_t len) {
   int64_t i = 0;
 #if defined(CPU_AVX512)
+  if (torch_ipex::cpu::use_stream_store(len * sizeof(at::BFloat16))) {
+    stream_move_ker(out, in, len);
+    _mm_sfence();
+    return;
+  }
 #pragma unroll(4)
   for (i = 0; i < len - 31; i += 32) {
     auto in0 = _mm512_loadu_si512(in + i);
@@ -304,6 +338,11 @@ static inline void zero_ker(double* out, int len) {
 static inline void zero_ker(float* out, int64_t len) {
   int64_t i = 0;
 #if defined(CPU_AVX512)
+  if (torch_ipex::cpu::use_stream_store(len * sizeof(float))) {
+    stream_zero_ker(out, len);
+    _mm_sfence();
+    return;
+  }
   __m512 zero_512 = _mm512_setzero_ps();
 #pragma unroll(4)
   for (i = 0; i < len - 15; i += 16) {
@@ -322,6 +361,11 @@ static inline void zero_ker(float* out, int64_t len) {
 static inline void zero_ker(at::BFloat16* out, int64_t len) {
   int64_t i = 0;
 #if defined(CPU_AVX512)
+  if (torch_ipex::cpu::use_stream_store(len * sizeof(at::BFloat16))) {
+    stream_zero_ker(out, len);
+    _mm_sfence();
+    return;
+  }
   __m512i zero_512 = _mm512_setzero_si512();
 #pragma unroll(4)
   for (i = 0; i < len - 31; i += 32) {
@@ -337,6 +381,91 @@ static inline void zero_ker(at::BFloat16* out, int64_t len) {
 #endif
 }
 
+// the elements of out before the first 64 bytes aligned one of it, up to len
+template <typename T>
+static inline int64_t stream_head_size(const T* out, int64_t len) {
+  auto unaligned = reinterpret_cast<uintptr_t>(out) % 64;
+  int64_t head = unaligned == 0 ? 0 : (64 - unaligned) / sizeof(T);
+  return std::min(head, len);
+}
+
+static inline void stream_move_ker(
+    at::BFloat16* out,
+    const float* in,
+    int64_t len) {
+#if defined(CPU_AVX512)
+  int64_t i = stream_head_size(out, len);
+  move_ker(out, in, i);
+  for (; i < len - 31; i += 32) {
+    auto in0 = cvt_fp32_to_bf16(_mm512_loadu_ps(in + i));
+    auto in1 = cvt_fp32_to_bf16(_mm512_loadu_ps(in + i + 16));
+    _mm512_stream_si512(
+        (__m512i*)(out + i),
+        _mm512_inserti64x4(_mm512_castsi256_si512(in0), in1, 1));
+  }
+  move_ker(out + i, in + i, len - i);
+#else
+  move_ker(out, in, len);
+#endif
+}
+
+static inline void stream_move_ker(float* out, const float* in, int64_t len) {
+#if defined(CPU_AVX512)
+  int64_t i = stream_head_size(out, len);
+  move_ker(out, in, i);
+  for (; i < len - 15; i += 16) {
+    _mm512_stream_ps(out + i, _mm512_loadu_ps(in + i));
+  }
+  move_ker(out + i, in + i, len - i);
+#else
+  move_ker(out, in, len);
+#endif
+}
+
+static inline void stream_move_ker(
+    at::BFloat16* out,
+    const at::BFloat16* in,
+    int64_t len) {
+#if defined(CPU_AVX512)
+  int64_t i = stream_head_size(out, len);
+  move_ker(out, in, i);
+  for (; i < len - 31; i += 32) {
+    _mm512_stream_si512((__m512i*)(out + i), _mm512_loadu_si512(in + i));
+  }
+  move_ker(out + i, in + i, len - i);
+#else
+  move_ker(out, in, len);
+#endif
+}
+
+static inline void stream_zero_ker(float* out, int64_t len) {
+#if defined(CPU_AVX512)
+  int64_t i = stream_head_size(out, len);
+  zero_ker(out, i);
+  __m512 zero_512 = _mm512_setzero_ps();
+  for (; i < len - 15; i += 16) {
+    _mm512_stream_ps(out + i, zero_512);
+  }
+  zero_ker(out + i, len - i);
+#else
+  zero_ker(out, len);
+#endif
+}
+
+static inline void stream_zero_ker(at::BFloat16* out, int64_t len) {
+#if defined(CPU_AVX512)
+  int64_t i = stream_head_size(out, len);
+  zero_ker(out, i);
+  __m512i zero_512 = _mm512_setzero_si512();
+  for (; i < len - 31; i += 32) {
+    _mm512_stream_si512((__m512i*)(out + i), zero_512);
+  }
+  zero_ker(out + i, len - i);
+#else
+  zero_ker(out, len);
+#endif
+}
+
 #if defined(CPU_AVX512)
 inline __m512 convert_bf16_to_fp32(const __m256i src) {
   __m512i y = _mm512_cvtepu16_epi32(src);
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#if defined(CPU_AVX512) || defined(CPU_AVX2)
+#include <immintrin.h>
+#endif
+
+// The unpack and dequantization microkernels of the 4-bit weights, of the
+// weight-only quantized linear and of the row-wise quantized embedding
+// tables. A 4-bit row holds two elements per byte with the low nibble first,
+// i.e. element i is the nibble (in[i / 2] >> (i % 2 * 4)) & 0xF.
+//   INT4: the signed [-8, 7] of the nibble minus 8, times the scale of the
+//         group of the element
+//   NF4:  the 16 NormalFloat levels of QLoRA, i.e. the quantiles of N(0, 1)
+//         normalized into [-1, 1], times the absmax of the group
+// The AVX-512 kernels unpack 16 elements per step, the AVX2 ones 8, and the
+// others are scalar.
+
+namespace torch_ipex {
+namespace cpu {
+
+enum class Int4Format { INT4, NF4 };
+
+alignas(64) static const float kNF4Levels[16] = {
+    -1.0f,
+    -0.6961928009986877f,
+    -0.5250730514526367f,
+    -0.39491748809814453f,
+    -0.28444138169288635f,
+    -0.18477343022823334f,
+    -0.09105003625154495f,
+    0.0f,
+    0.07958029955625534f,
+    0.16093020141124725f,
+    0.24611230194568634f,
+    0.33791524171829224f,
+    0.44070982933044434f,
+    0.5626170039176941f,
+    0.7229568362236023f,
+    1.0f};
+
+static inline __attribute__((always_inline)) int32_t load_u4(
+    const uint8_t* in,
+    int64_t i) {
+  return (in[i / 2] >> ((i % 2) * 4)) & 0xF;
+}
+
+template <Int4Format F>
+static inline __attribute__((always_inline)) float dequant_u4(
+    int32_t q,
+    float scale) {
+  return F == Int4Format::NF4 ? kNF4Levels[q] * scale
+                              : static_cast<float>(q - 8) * scale;
+}
+
+#if defined(CPU_AVX512)
+// the 16 elements of the 8 bytes of in as the int32 nibbles, in order
+static inline __attribute__((always_inline)) __m512i load_u4x16(
+    const uint8_t* in) {
+  auto bytes = _mm_loadl_epi64((const __m128i*)in);
+  auto nibble_mask = _mm_set1_epi8(0x0F);
+  auto lo = _mm_and_si128(bytes, nibble_mask);
+  auto hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble_mask);
+  return _mm512_cvtepu8_epi32(_mm_unpacklo_epi8(lo, hi));
+}
+
+// NF4 looks the levels up by a permute of the 16 of them in a register
+template <Int4Format F>
+static inline __attribute__((always_inline)) __m512 dequant_u4x16(
+    __m512i q,
+    __m512 scale) {
+  if (F == Int4Format::NF4) {
+    auto levels = _mm512_load_ps(kNF4Levels);
+    return _mm512_mul_ps(_mm512_permutexvar_ps(q, levels), scale);
+  }
+  auto q_ps = _mm512_cvtepi32_ps(_mm512_sub_epi32(q, _mm512_set1_epi32(8)));
+  return _mm512_mul_ps(q_ps, scale);
+}
+#elif defined(CPU_AVX2)
+// the 8 elements of the 4 bytes of in as the int32 nibbles, in order
+static inline __attribute__((always_inline)) __m256i load_u4x8(
+    const uint8_t* in) {
+  int32_t word;
+  std::memcpy(&word, in, sizeof(word));
+  auto bytes = _mm_cvtsi32_si128(word);
+  auto nibble_mask = _mm_set1_epi8(0x0F);
+  auto lo = _mm_and_si128(bytes, nibble_mask);
+  auto hi = _mm_and_si128(_mm_srli_epi16(bytes, 4), nibble_mask);
+  return _mm256_cvtepu8_epi32(_mm_unpacklo_epi8(lo, hi));
+}
+
+// NF4 looks the levels up by the permutes of the two halves of them, of which
+// the one of each element is selected by bit 3 of its nibble
+template <Int4Format F>
+static inline __attribute__((always_inline)) __m256 dequant_u4x8(
+    __m256i q,
+    __m256 scale) {
+  if (F == Int4Format::NF4) {
+    auto lo = _mm256_permutevar8x32_ps(_mm256_load_ps(kNF4Levels), q);
+    auto hi = _mm256_permutevar8x32_ps(_mm256_load_ps(kNF4Levels + 8), q);
+    auto upper = _mm256_castsi256_ps(
+        _mm256_cmpgt_epi32(q, _mm256_set1_epi32(7)));
+    return _mm256_mul_ps(_mm256_blendv_ps(lo, hi, upper), scale);
+  }
+  auto q_ps = _mm256_cvtepi32_ps(_mm256_sub_epi32(q, _mm256_set1_epi32(8)));
+  return _mm256_mul_ps(q_ps, scale);
+}
+#endif
+
+// out[i] = the element i of the 4-bit in times scale, of the len elements
+template <Int4Format F>
+static inline void dequant_u4_ker(
+    float* out,
+    const uint8_t* in,
+    float scale,
+    int64_t len) {
+  int64_t i = 0;
+#if defined(CPU_AVX512)
+  auto scale_vec = _mm512_set1_ps(scale);
+  for (; i < len - 15; i += 16) {
+    _mm512_storeu_ps(
+        out + i, dequant_u4x16<F>(load_u4x16(in + i / 2), scale_vec));
+  }
+#elif defined(CPU_AVX2)
+  auto scale_vec = _mm256_set1_ps(scale);
+  for (; i < len - 7; i += 8) {
+    _mm256_storeu_ps(
+        out + i, dequant_u4x8<F>(load_u4x8(in + i / 2), scale_vec));
+  }
+#endif
+  for (; i < len; i++) {
+    out[i] = dequant_u4<F>(load_u4(in, i), scale);
+  }
+}
+
+// Dequantizes the len elements of a 4-bit row of the groups of group_size
+// elements, of which scales are the scales of the groups. group_size is even
+// unless it is len, so that each group starts at a byte.
+template <Int4Format F>
+static inline void dequant_u4_row_ker(
+    float* out,
+    const uint8_t* in,
+    const float* scales,
+    int64_t group_size,
+    int64_t len) {
+  for (int64_t i = 0, g = 0; i < len; i += group_size, g++) {
+    dequant_u4_ker<F>(
+        out + i, in + i / 2, scales[g], std::min(group_size, len - i));
+  }
+}
+
+// out[i] += nibble i of in * scale + bias, the accumulation of the unsigned
+// 4-bit rows of the row-wise quantized embedding tables
+static inline void dequant_add_u4_ker(
+    float* out,
+    const uint8_t* in,
+    float scale,
+    float bias,
+    int64_t len) {
+  int64_t i = 0;
+#if defined(CPU_AVX512)
+  auto scale_vec = _mm512_set1_ps(scale);
+  auto bias_vec = _mm512_set1_ps(bias);
+  for (; i < len - 15; i += 16) {
+    auto q = _mm512_cvtepi32_ps(load_u4x16(in + i / 2));
+    _mm512_storeu_ps(
+        out + i,
+        _mm512_add_ps(
+            _mm512_loadu_ps(out + i),
+            _mm512_fmadd_ps(q, scale_vec, bias_vec)));
+  }
+#elif defined(CPU_AVX2)
+  auto scale_vec = _mm256_set1_ps(scale);
+  auto bias_vec = _mm256_set1_ps(bias);
+  for (; i < len - 7; i += 8) {
+    auto q = _mm256_cvtepi32_ps(load_u4x8(in + i / 2));
+    _mm256_storeu_ps(
+        out + i,
+        _mm256_add_ps(
+            _mm256_loadu_ps(out + i),
+            _mm256_fmadd_ps(q, scale_vec, bias_vec)));
+  }
+#endif
+  for (; i < len; i++) {
+    out[i] += scale * load_u4(in, i) + bias;
+  }
+}
+
+} // namespace cpu
+} // namespace torch_ipex
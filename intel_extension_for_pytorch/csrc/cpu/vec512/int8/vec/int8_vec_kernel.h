@@ -150,7 +150,8 @@ static inline __attribute__((always_inline)) void move_ker(
   }
 
   if (i < len) {
-    auto mask = ((1 << (len - i)) - 1);
+    // up to 63 bytes are left, the mask is of 64 bits
+    __mmask64 mask = (1ULL << (len - i)) - 1;
     auto in0 = _mm512_maskz_loadu_epi8(mask, in + i);
     _mm512_mask_storeu_epi8(out + i, mask, in0);
   }
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace torch_ipex {
+namespace kernel {
+namespace vec {
+namespace ref {
+
+// The portable counterparts of the kernels of vec512/update_batch.h, for the
+// builds and the CPUs without AVX-512. The batch status is updated by plain
+// loops, which the compiler vectorizes for the ISA of the build, and the rows
+// of the hidden states and the features are copied by memcpy, which picks the
+// widest copy of the running CPU.
+
+inline void update_batch_kernel(
+    const at::Tensor& k,
+    const at::Tensor& out_lens,
+    at::Tensor label_col,
+    at::Tensor symbols_added,
+    at::Tensor time_idxs,
+    at::Tensor blankness_out,
+    at::Tensor blankvec_out,
+    at::Tensor not_blank_out,
+    at::Tensor label_to_put_out,
+    int max_symbols,
+    int blank_id,
+    int len,
+    int _SOS) {
+  auto k_ptr = k.data_ptr<int64_t>();
+  auto out_lens_ptr = out_lens.data_ptr<int32_t>();
+  auto label_col_ptr = label_col.data_ptr<int32_t>();
+  auto symbols_added_ptr = symbols_added.data_ptr<int32_t>();
+  auto time_idxs_ptr = time_idxs.data_ptr<int32_t>();
+  auto blankness_out_ptr = blankness_out.data_ptr<int32_t>();
+  auto blankvec_out_ptr = blankvec_out.data_ptr<int32_t>();
+  auto not_blank_out_ptr = not_blank_out.data_ptr<int32_t>();
+  auto label_to_put_out_ptr = label_to_put_out.data_ptr<int64_t>();
+
+  for (int i = 0; i < len; i++) {
+    // blankness = k.eq(self._blank_id)
+    // symbols_added *= blankness.logical_not()
+    // time_idxs = time_idxs + blankness
+    // blank_vec = time_idxs.ge(out_lens)
+    int32_t blankness = k_ptr[i] == blank_id;
+    int32_t symbols_added_i = blankness ? 0 : symbols_added_ptr[i];
+    int32_t time_idx = time_idxs_ptr[i] + blankness;
+    int32_t blank_vec = time_idx >= out_lens_ptr[i];
+
+    // not_blank = tmp_blank_vec.eq(0)
+    // label_col += not_blank
+    // symbols_added += not_blank
+    int32_t not_blank = !(blankness || blank_vec);
+    label_col_ptr[i] += not_blank;
+    symbols_added_i += not_blank;
+
+    // time_idxs += need_add
+    // symbols_added *= symbols_added.lt(max_symbols)
+    // blankness.logical_or_(need_add)
+    int32_t need_add = symbols_added_i >= max_symbols;
+    time_idxs_ptr[i] = time_idx + need_add;
+    symbols_added_ptr[i] = need_add ? 0 : symbols_added_i;
+    blankness_out_ptr[i] = blankness || need_add;
+    blankvec_out_ptr[i] = blank_vec;
+    not_blank_out_ptr[i] = not_blank;
+
+    // (k-self._SOS)*not_blank
+    label_to_put_out_ptr[i] = (k_ptr[i] - _SOS) * not_blank;
+  }
+}
+
+inline bool all_time_idxs_processed_kernel(
+    const at::Tensor& blankvec_out,
+    int len) {
+  // if blank_vec.nonzero().size(0) == batch_size, return true; else return
+  // false
+  auto blankvec_out_ptr = blankvec_out.data_ptr<int32_t>();
+  return std::all_of(blankvec_out_ptr, blankvec_out_ptr + len, [](int32_t v) {
+    return v != 0;
+  });
+}
+
+inline void label_index_put_kernel(
+    at::Tensor label_tensor_out,
+    at::Tensor label_to_put_out,
+    const at::Tensor& label_col,
+    at::Tensor label_for_next_loop_out,
+    int64_t max_symbols,
+    int64_t batch_size,
+    int64_t max_len) {
+  // label_tensor.index_put_([label_row, label_col.to(torch.int64)],
+  // label_to_put, accumulate=True)
+  // label_tensor.gather(1, label_col.to(torch.int64).unsqueeze(1))
+  auto label_tensor_out_ptr = label_tensor_out.data_ptr<int64_t>();
+  auto label_to_put_out_ptr = label_to_put_out.data_ptr<int64_t>();
+  auto label_col_ptr = label_col.data_ptr<int32_t>();
+  auto label_for_next_loop_out_ptr =
+      label_for_next_loop_out.data_ptr<int64_t>();
+  auto row_stride = label_tensor_out.stride(0);
+  for (int64_t i = 0; i < batch_size; i++) {
+    auto label = label_tensor_out_ptr + i * row_stride + label_col_ptr[i];
+    *label += label_to_put_out_ptr[i];
+    label_for_next_loop_out_ptr[i] = *label;
+  }
+}
+
+inline void update_hidden_idx_kernel(
+    at::Tensor not_blank_out,
+    at::Tensor hidden_0,
+    at::Tensor hidden_1,
+    const at::Tensor& hidden_prime_0,
+    const at::Tensor& hidden_prime_1,
+    int64_t batch_size) {
+  // idx = (not_blank).nonzero(as_tuple=True)[0]
+  // hidden[0][:, idx, :] = hidden_prime[0][:, idx, :]
+  // hidden[1][:, idx, :] = hidden_prime[1][:, idx, :]
+  AT_ASSERTM(
+      hidden_0.scalar_type() == hidden_prime_0.scalar_type() &&
+          hidden_1.scalar_type() == hidden_prime_1.scalar_type(),
+      "hidden and hidden_prime should be in same dtype.");
+  auto not_blank_out_ptr = not_blank_out.data_ptr<int32_t>();
+  auto update_hidden = [&](at::Tensor& hidden, const at::Tensor& prime) {
+    auto hidden_ptr = static_cast<char*>(hidden.data_ptr());
+    auto prime_ptr = static_cast<const char*>(prime.data_ptr());
+    int64_t ld = hidden.size(0);
+    int64_t row_bytes = hidden.size(2) * hidden.element_size();
+    for (int64_t i = 0; i < ld; i++) {
+      for (int64_t j = 0; j < batch_size; j++) {
+        if (not_blank_out_ptr[j] != 0) {
+          auto pos = (i * hidden.size(1) + j) * row_bytes;
+          std::memcpy(hidden_ptr + pos, prime_ptr + pos, row_bytes);
+        }
+      }
+    }
+  };
+  update_hidden(hidden_0, hidden_prime_0);
+  update_hidden(hidden_1, hidden_prime_1);
+}
+
+inline void update_feature_idx_kernel(
+    const at::Tensor& blankness_out,
+    at::Tensor x,
+    at::Tensor f,
+    const at::Tensor& time_idxs,
+    int64_t batch_size,
+    int64_t max_len) {
+  // if blankness.nonzero().size(0) > 0:
+  //     fetch_time_idxs = time_idxs.min(max_lens)
+  //     f = x[label_row_list, fetch_time_idxs, :].unsqueeze(1)
+  auto blankness_out_ptr = blankness_out.data_ptr<int32_t>();
+  if (std::none_of(
+          blankness_out_ptr, blankness_out_ptr + batch_size, [](int32_t v) {
+            return v != 0;
+          })) {
+    return;
+  }
+  AT_ASSERTM(
+      x.scalar_type() == f.scalar_type() && x.stride(2) == 1 &&
+          f.stride(2) == 1,
+      "x and f should be in same dtype with contiguous features.");
+  auto time_idxs_ptr = time_idxs.data_ptr<int32_t>();
+  auto x_ptr = static_cast<const char*>(x.data_ptr());
+  auto f_ptr = static_cast<char*>(f.data_ptr());
+  auto element_size = x.element_size();
+  auto row_bytes = x.size(2) * element_size;
+  at::parallel_for(0, batch_size, 16, [&](int64_t start, int64_t end) {
+    for (int64_t i = start; i < end; i++) {
+      int64_t fetch_time_idx =
+          std::min<int64_t>(time_idxs_ptr[i], max_len - 1);
+      auto x_pos = i * x.stride(0) + fetch_time_idx * x.stride(1);
+      std::memcpy(
+          f_ptr + i * f.stride(0) * element_size,
+          x_ptr + x_pos * element_size,
+          row_bytes);
+    }
+  });
+}
+
+// rnnt_update_batch, returns whether all the time steps have been processed.
+inline bool rnnt_update_batch_kernel(
+    const at::Tensor& k,
+    const at::Tensor& out_lens,
+    at::Tensor label_col,
+    at::Tensor symbols_added,
+    at::Tensor time_idxs,
+    at::Tensor blankness_out,
+    at::Tensor blankvec_out,
+    at::Tensor not_blank_out,
+    at::Tensor label_to_put_out,
+    at::Tensor label_tensor_out,
+    at::Tensor label_for_next_loop_out,
+    at::Tensor hidden_0,
+    at::Tensor hidden_1,
+    const at::Tensor& hidden_prime_0,
+    const at::Tensor& hidden_prime_1,
+    at::Tensor x,
+    at::Tensor f,
+    int64_t max_symbols,
+    int64_t blank_id,
+    int64_t batch_size,
+    int64_t _SOS,
+    int64_t max_len) {
+  update_batch_kernel(
+      k,
+      out_lens,
+      label_col,
+      symbols_added,
+      time_idxs,
+      blankness_out,
+      blankvec_out,
+      not_blank_out,
+      label_to_put_out,
+      (int32_t)max_symbols,
+      (int32_t)blank_id,
+      (int32_t)batch_size,
+      (int32_t)_SOS);
+
+  // if blank_vec.nonzero().size(0) == batch_size:
+  //     # all time_idxs processed, stop
+  //     break
+  if (all_time_idxs_processed_kernel(blankvec_out, batch_size))
+    return true;
+
+  // label_tensor.index_put_([label_row, label_col.to(torch.int64)],
+  // label_to_put, accumulate=True) label_tensor.gather(1,
+  // label_col.to(torch.int64).unsqueeze(1))
+  label_index_put_kernel(
+      label_tensor_out,
+      label_to_put_out,
+      label_col,
+      label_for_next_loop_out,
+      max_symbols,
+      batch_size,
+      max_len);
+
+  // idx = (not_blank).nonzero(as_tuple=True)[0]
+  // hidden[0][:, idx, :] = hidden_prime[0][:, idx, :]
+  // hidden[1][:, idx, :] = hidden_prime[1][:, idx, :]
+  update_hidden_idx_kernel(
+      not_blank_out,
+      hidden_0,
+      hidden_1,
+      hidden_prime_0,
+      hidden_prime_1,
+      batch_size);
+
+  // if blankness.nonzero().size(0) > 0:
+  //     fetch_time_idxs = time_idxs.min(max_lens)
+  //     f = x[label_row_list, fetch_time_idxs, :].unsqueeze(1)
+  update_feature_idx_kernel(
+      blankness_out, x, f, time_idxs, batch_size, max_len);
+  return false;
+}
+
+} // namespace ref
+} // namespace vec
+} // namespace kernel
+} // namespace torch_ipex
@@ -349,10 +349,13 @@ inline void label_index_put_kernel(
       static_cast<int64_t*>(label_to_put_out.data_ptr());
 
   int32_t* label_col_ptr = static_cast<int32_t*>(label_col.data_ptr());
+  // the rows may be longer than max_len * max_symbols, e.g. of
+  // rnnt_greedy_decode
+  int64_t row_stride = label_tensor_out.stride(0);
 
   at::parallel_for(0, batch_size, 16, [&](int64_t start, int64_t end) {
     for (int64_t i = start; i < end; i++) {
-      label_tensor_out_ptr[i * max_len * max_symbols + label_col_ptr[i]] +=
+      label_tensor_out_ptr[i * row_stride + label_col_ptr[i]] +=
           label_to_put_out_ptr[i];
     }
   });
@@ -364,7 +367,7 @@ inline void label_index_put_kernel(
   at::parallel_for(0, batch_size, 16, [&](int64_t start, int64_t end) {
     for (int64_t i = start; i < end; i++) {
       label_for_next_loop_out_ptr[i] =
-          label_tensor_out_ptr[i * max_len * max_symbols + label_col_ptr[i]];
+          label_tensor_out_ptr[i * row_stride + label_col_ptr[i]];
     }
   });
 }
@@ -423,6 +426,82 @@ inline void update_feature_idx_kernel(
   }
 }
 
+// rnnt_update_batch, returns whether all the time steps have been processed.
+inline bool rnnt_update_batch_kernel(
+    const at::Tensor& k,
+    const at::Tensor& out_lens,
+    at::Tensor label_col,
+    at::Tensor symbols_added,
+    at::Tensor time_idxs,
+    at::Tensor blankness_out,
+    at::Tensor blankvec_out,
+    at::Tensor not_blank_out,
+    at::Tensor label_to_put_out,
+    at::Tensor label_tensor_out,
+    at::Tensor label_for_next_loop_out,
+    at::Tensor hidden_0,
+    at::Tensor hidden_1,
+    const at::Tensor& hidden_prime_0,
+    const at::Tensor& hidden_prime_1,
+    at::Tensor x,
+    at::Tensor f,
+    int64_t max_symbols,
+    int64_t blank_id,
+    int64_t batch_size,
+    int64_t _SOS,
+    int64_t max_len) {
+  update_batch_kernel(
+      k,
+      out_lens,
+      label_col,
+      symbols_added,
+      time_idxs,
+      blankness_out,
+      blankvec_out,
+      not_blank_out,
+      label_to_put_out,
+      (int32_t)max_symbols,
+      (int32_t)blank_id,
+      (int32_t)batch_size,
+      (int32_t)_SOS);
+
+  // if blank_vec.nonzero().size(0) == batch_size:
+  //     # all time_idxs processed, stop
+  //     break
+  if (all_time_idxs_processed_kernel(blankvec_out, batch_size))
+    return true;
+
+  // label_tensor.index_put_([label_row, label_col.to(torch.int64)],
+  // label_to_put, accumulate=True) label_tensor.gather(1,
+  // label_col.to(torch.int64).unsqueeze(1))
+  label_index_put_kernel(
+      label_tensor_out,
+      label_to_put_out,
+      label_col,
+      label_for_next_loop_out,
+      max_symbols,
+      batch_size,
+      max_len);
+
+  // idx = (not_blank).nonzero(as_tuple=True)[0]
+  // hidden[0][:, idx, :] = hidden_prime[0][:, idx, :]
+  // hidden[1][:, idx, :] = hidden_prime[1][:, idx, :]
+  update_hidden_idx_kernel(
+      not_blank_out,
+      hidden_0,
+      hidden_1,
+      hidden_prime_0,
+      hidden_prime_1,
+      batch_size);
+
+  // if blankness.nonzero().size(0) > 0:
+  //     fetch_time_idxs = time_idxs.min(max_lens)
+  //     f = x[label_row_list, fetch_time_idxs, :].unsqueeze(1)
+  update_feature_idx_kernel(
+      blankness_out, x, f, time_idxs, batch_size, max_len);
+  return false;
+}
+
 } // namespace vec512
 } // namespace vec
 } // namespace kernel
@@ -2,8 +2,11 @@
 
 #include "bf16/vec/vec_type_cvt.h"
 
+// the float data is loaded and stored unaligned, as the rows of the kernels
+// are only 64-byte aligned when their size is a multiple of 16
+
 inline __m512 _load_f32_data(const float* data_base) {
-  return _mm512_load_ps(data_base);
+  return _mm512_loadu_ps(data_base);
 }
 
 inline __m512 _load_f32_data(const at::BFloat16* data_base) {
@@ -11,7 +14,7 @@ inline __m512 _load_f32_data(const at::BFloat16* data_base) {
 }
 
 inline __m512 _maskz_load_f32_data(const float* data_base, __mmask16 mask) {
-  return _mm512_maskz_load_ps(mask, data_base);
+  return _mm512_maskz_loadu_ps(mask, data_base);
 }
 
 inline __m512 _maskz_load_f32_data(
@@ -21,16 +24,16 @@ inline __m512 _maskz_load_f32_data(
 }
 
 inline void _store_data(float* data_base, __m512 a) {
-  _mm512_store_ps(data_base, a);
+  _mm512_storeu_ps(data_base, a);
 }
 
 inline void _store_data(at::BFloat16* data_base, __m512 a) {
   auto vec_bf16_out = cvt_fp32_to_bf16(a);
-  _mm256_store_si256((__m256i*)data_base, vec_bf16_out);
+  _mm256_storeu_si256((__m256i*)data_base, vec_bf16_out);
 }
 
 inline void _mask_store_data(float* data_base, __m512 a, __mmask16 mask) {
-  _mm512_mask_store_ps(data_base, mask, a);
+  _mm512_mask_storeu_ps(data_base, mask, a);
 }
 
 inline void _mask_store_data(
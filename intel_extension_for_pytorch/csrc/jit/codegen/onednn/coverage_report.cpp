@@ -0,0 +1,84 @@
+#include "coverage_report.h"
+
+#include <mutex>
+#include <sstream>
+
+namespace torch {
+namespace jit {
+namespace fuser {
+namespace onednn {
+namespace coverage_report {
+
+namespace {
+
+std::atomic<bool> enabled{false};
+
+std::mutex& reportMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+Report& report() {
+  static Report report;
+  return report;
+}
+
+} // namespace
+
+void setEnabled(bool enable) {
+  enabled.store(enable);
+}
+
+bool isEnabled() {
+  return enabled.load(std::memory_order_relaxed);
+}
+
+void clear() {
+  std::lock_guard<std::mutex> guard(reportMutex());
+  report().unsupported.clear();
+  report().kernels.clear();
+}
+
+void recordUnsupported(const Node* node, const std::string& reason) {
+  if (!isEnabled()) {
+    return;
+  }
+  std::ostringstream os;
+  os << *node;
+  auto printed = os.str();
+  // drop the trailing newline and the source location
+  auto end = printed.find('\n');
+  if (end != std::string::npos) {
+    printed.resize(end);
+  }
+  auto comment = printed.find(" # ");
+  if (comment != std::string::npos) {
+    printed.resize(comment);
+  }
+  std::lock_guard<std::mutex> guard(reportMutex());
+  report().unsupported.push_back(
+      {node->kind().toQualString(), std::move(printed), reason});
+}
+
+std::shared_ptr<KernelStats> registerKernel(
+    const std::string& name,
+    std::vector<std::string> ops) {
+  if (!isEnabled()) {
+    return nullptr;
+  }
+  auto stats = std::make_shared<KernelStats>(name, std::move(ops));
+  std::lock_guard<std::mutex> guard(reportMutex());
+  report().kernels.push_back(stats);
+  return stats;
+}
+
+Report getReport() {
+  std::lock_guard<std::mutex> guard(reportMutex());
+  return report();
+}
+
+} // namespace coverage_report
+} // namespace onednn
+} // namespace fuser
+} // namespace jit
+} // namespace torch
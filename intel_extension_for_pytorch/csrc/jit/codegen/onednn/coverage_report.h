@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <torch/csrc/jit/ir/ir.h>
+
+namespace torch {
+namespace jit {
+namespace fuser {
+namespace onednn {
+
+// The record of what the LLGA fuser made of the graphs it optimized while the
+// report is enabled: the nodes left to ATen with the reason they were not
+// fused, and the LlgaKernels created, with the ops of their partitions and
+// the number and total time of their runs. Nothing is recorded while the
+// report is disabled, which is the default.
+namespace coverage_report {
+
+struct UnsupportedNode {
+  std::string kind;
+  // the node as printed in the graph
+  std::string node;
+  std::string reason;
+};
+
+struct KernelStats {
+  KernelStats(std::string name, std::vector<std::string> ops)
+      : name(std::move(name)), ops(std::move(ops)) {}
+
+  std::string name;
+  std::vector<std::string> ops;
+  std::atomic<uint64_t> calls{0};
+  std::atomic<uint64_t> totalNs{0};
+};
+
+struct Report {
+  std::vector<UnsupportedNode> unsupported;
+  std::vector<std::shared_ptr<KernelStats>> kernels;
+};
+
+void setEnabled(bool enabled);
+
+bool isEnabled();
+
+// Drops everything recorded so far.
+void clear();
+
+void recordUnsupported(const Node* node, const std::string& reason);
+
+// Returns the stats an LlgaKernel of the ops updates on each run, nullptr if
+// the report is disabled.
+std::shared_ptr<KernelStats> registerKernel(
+    const std::string& name,
+    std::vector<std::string> ops);
+
+Report getReport();
+
+} // namespace coverage_report
+
+} // namespace onednn
+} // namespace fuser
+} // namespace jit
+} // namespace torch
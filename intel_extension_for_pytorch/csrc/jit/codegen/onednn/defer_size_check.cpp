@@ -7,6 +7,13 @@ namespace jit {
 namespace fuser {
 namespace onednn {
 
+// aten::dim and aten::numel are deferred like aten::size, since the ops moved
+// over preserve the shape.
+static bool isShapeQuery(Node* node) {
+  return node->kind() == aten::size || node->kind() == aten::dim ||
+      node->kind() == aten::numel;
+}
+
 class SizeCheckMover {
  private:
   Block* block_;
@@ -39,7 +46,7 @@ class SizeCheckMover {
     // %d = aten::quantize_per_tensor(%c, %scale, %zp, %dtype)
     // %sz1 = aten::size(%d, %0) <--defer size after quantize_per_tensor
     // %sz2 = aten::size(%d, %1) <--defer size after quantize_per_tensor
-    if (node->kind() != aten::size)
+    if (!isShapeQuery(node))
       return false;
 
     auto* input = node->input(0);
@@ -47,7 +54,7 @@ class SizeCheckMover {
     bool onlyUsedByShapePreserveOp = uses.size() > 1 &&
         std::all_of(uses.begin(), uses.end(), [node](auto& u) {
                                        return u.user == node ||
-                                           u.user->kind() == aten::size ||
+                                           isShapeQuery(u.user) ||
                                            utils::isEltwiseOp(u.user);
                                      });
 
@@ -55,8 +62,8 @@ class SizeCheckMover {
       return false;
 
     for (const auto& use : uses) {
-      // skip the node itself and aten::size
-      if (use.user == node || use.user->kind() == aten::size)
+      // skip the node itself and the other shape queries
+      if (use.user == node || isShapeQuery(use.user))
         continue;
       auto shapePreserveOp = use.user;
       if (aliasDb.moveAfterTopologicallyValid(node, shapePreserveOp)) {
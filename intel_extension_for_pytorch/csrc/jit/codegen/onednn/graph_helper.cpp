@@ -1,5 +1,7 @@
 #include "graph_helper.h"
+#include "coverage_report.h"
 #include "fusion_group_name.h"
+#include "lowering_selection.h"
 
 #include "csrc/autocast/autocast_mode.h"
 #include "csrc/jit/codegen/LlgaTensorImpl.h"
@@ -8,6 +10,8 @@
 #include <torch/csrc/jit/jit_log.h>
 #include <torch/csrc/jit/passes/utils/subgraph_utils.h>
 
+#include <unordered_set>
+
 namespace torch {
 namespace jit {
 namespace fuser {
@@ -60,9 +64,14 @@ Operator makeWildcardOp(Node* node) {
   return o;
 }
 
+// The condition of the last REQ which made a node a wildcard on this thread,
+// for the coverage report.
+static thread_local const char* lastUnsupportedCondition = nullptr;
+
 #define REQ(cond)                                     \
   if (!(cond)) {                                      \
     GRAPH_DEBUG("Unsupported condition " #cond "\n"); \
+    lastUnsupportedCondition = #cond;                 \
     return makeWildcardOp(node);                      \
   }
 
@@ -208,11 +217,16 @@ Operator createOperator(Node* node) {
   } else if (node->kind() == Symbol::aten("layer_norm")) {
     auto normalized_shape = Operator::Ints(node, 1);
     REQ(normalized_shape.size() == 1);
+    // weight and bias are None when elementwise_affine is false, e.g. the
+    // layer norm without the affine transform in some transformer blocks.
+    auto use_affine = node->input(2)->mustNotBeNone();
+    REQ(node->input(3)->mustNotBeNone() == use_affine);
     return Operator(node, opkind::LayerNorm)
         .setInput(0, 2, 3)
         .setOutput(0)
         .setAttr("epsilon", Operator::Float, 4)
-        .setAttr("keep_stats", false);
+        .setAttr("keep_stats", false)
+        .setAttr("use_affine", use_affine);
   } else if (node->kind() == Symbol::aten("add")) {
     return makeBinaryOp(node, opkind::Add);
   } else if (node->kind() == Symbol::aten("div")) {
@@ -383,10 +397,6 @@ Operator createOperator(Node* node) {
   return makeWildcardOp(node);
 }
 
-dnnl::graph::op createLlgaOp(Node* node) {
-  return createOperator(node).llgaOp();
-}
-
 bool isSupported(Node* node) {
   return createOperator(node).kind() != opkind::Wildcard;
 };
@@ -436,7 +446,8 @@ void mayAddListConstructIntoConcatPartition(
   }
 }
 
-// Currently, we only rewrite quantization partitions with LLGA.
+// Currently, we only rewrite quantization partitions with LLGA, and the fp32
+// and bf16 ones chosen by the lowering selection.
 // TODO: remove this check in the future if we want to use LLGA for fp32 and
 // bf16
 bool shouldRewrite(dnnl::graph::partition partition) {
@@ -447,6 +458,7 @@ bool shouldRewrite(dnnl::graph::partition partition) {
 
   // check if the partition is quantization-related
   auto opIds = partition.get_ops();
+  std::vector<Node*> nodes;
   for (size_t opId : opIds) {
     auto node_in_partition = Operator::getNode(opId);
     if (node_in_partition->kind() == Symbol::aten("quantize_per_tensor") ||
@@ -454,6 +466,11 @@ bool shouldRewrite(dnnl::graph::partition partition) {
         node_in_partition->kind() == Symbol::aten("dequantize")) {
       return true;
     }
+    nodes.push_back(node_in_partition);
+  }
+  if (lowering_selection::isEnabled() &&
+      lowering_selection::shouldLowerWithLlga(nodes)) {
+    return true;
   }
   GRAPH_DEBUG("Excluding non-quantization partition ", partition.get_id());
   return false;
@@ -467,17 +484,39 @@ LlgaGraphHelper::LlgaGraphHelper(
   dnnl::graph::graph g{engineKind};
 
   GRAPH_DEBUG("Constructing LLGA graph");
+  bool report = coverage_report::isEnabled();
+  // the nodes added as the ops they are mapped to, i.e. not as wildcards
+  std::unordered_set<Node*> mappedNodes;
   // TODO: select nodes in top-level block for now
   for (auto* node : graph->block()->nodes()) {
-    auto op = createLlgaOp(node);
+    lastUnsupportedCondition = nullptr;
+    auto o = createOperator(node);
+    bool mapped = o.kind() != opkind::Wildcard;
+    if (!mapped && report && !node->kind().is_prim()) {
+      coverage_report::recordUnsupported(
+          node,
+          lastUnsupportedCondition
+              ? std::string("unsupported condition ") +
+                  lastUnsupportedCondition
+              : std::string("not mapped to a oneDNN graph op"));
+    }
 
     try {
-      g.add_op(op);
+      g.add_op(o.llgaOp());
     } catch (std::exception& e) {
       GRAPH_DEBUG(
           "The backend failed to add node ", node->kind().toQualString());
+      if (mapped && report) {
+        coverage_report::recordUnsupported(
+            node,
+            std::string("oneDNN graph failed to add the op: ") + e.what());
+      }
+      mapped = false;
       g.add_op(makeWildcardOp(node).llgaOp());
     }
+    if (mapped) {
+      mappedNodes.insert(node);
+    }
 
     GRAPH_DEBUG("  Added node ", node->kind().toQualString());
 
@@ -490,8 +529,24 @@ LlgaGraphHelper::LlgaGraphHelper(
   std::vector<dnnl::graph::partition> partitions = g.get_partitions(policy);
   // excluded unsupported Wildcard partitions
   for (size_t partId = 0; partId < partitions.size(); partId++) {
-    if (partitions[partId].is_supported() && shouldRewrite(partitions[partId]))
+    bool supported = partitions[partId].is_supported();
+    if (supported && shouldRewrite(partitions[partId])) {
       partitions_.push_back(partitions[partId]);
+    } else if (report) {
+      for (auto opId : partitions[partId].get_ops()) {
+        auto* node = Operator::getNode(opId);
+        if (mappedNodes.count(node) == 0) {
+          // already reported as a wildcard
+          continue;
+        }
+        coverage_report::recordUnsupported(
+            node,
+            !supported ? "the partition is not supported by oneDNN graph"
+                : lowering_selection::isEnabled()
+                ? "left to the IPEX fusion pass by the lowering selection"
+                : "excluded as a partition of no quantization op");
+      }
+    }
   }
 
   GRAPH_DEBUG("  Got #partitions: ", partitions_.size());
@@ -1,15 +1,168 @@
 #include "guard_shape.h"
 #include "fusion_group_name.h"
+#include "graph_helper.h"
+#include "interface.h"
 
 #include <torch/csrc/jit/jit_log.h>
 #include <torch/csrc/jit/passes/tensorexpr_fuser.h>
 #include <torch/csrc/jit/runtime/graph_executor.h>
 
+#include <mutex>
+#include <numeric>
+
 namespace torch {
 namespace jit {
 namespace fuser {
 namespace onednn {
 
+namespace {
+
+std::mutex& symbolicDimsMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::vector<int64_t>& symbolicDims() {
+  static std::vector<int64_t> dims;
+  return dims;
+}
+
+// t with the sizes of dims unknown, and the strides unknown if any size is,
+// or nullptr if none of dims is a known size of t.
+TensorTypePtr withUnknownDims(
+    const TensorTypePtr& t,
+    const std::vector<int64_t>& dims) {
+  auto ssizes = t->sizes().sizes();
+  if (!ssizes) {
+    return nullptr;
+  }
+  auto sizes = *ssizes;
+  bool changed = false;
+  for (auto d : dims) {
+    if (d < static_cast<int64_t>(sizes.size()) && sizes[d].has_value()) {
+      sizes[d] = c10::nullopt;
+      changed = true;
+    }
+  }
+  if (!changed) {
+    return nullptr;
+  }
+  return TensorType::create(
+      t->scalarType(),
+      t->device(),
+      c10::VaryingShape<int64_t>(sizes),
+      c10::VaryingShape<int64_t>(sizes.size()),
+      t->requiresGrad());
+}
+
+std::vector<int64_t> allDims(const TensorTypePtr& t) {
+  std::vector<int64_t> dims(t->dim().value_or(0));
+  std::iota(dims.begin(), dims.end(), 0);
+  return dims;
+}
+
+// The subgraph of fusionGroup with the symbolic dims of its inputs and all
+// the sizes of the other values unknown, or nullptr if it doesn't form a
+// single partition any more.
+std::shared_ptr<Graph> relaxSubgraph(
+    Node* fusionGroup,
+    const std::vector<int64_t>& dims) {
+  auto subgraph = fusionGroup->g(attr::Subgraph)->copy();
+  bool changed = false;
+  for (auto* input : subgraph->inputs()) {
+    auto t = input->type()->cast<TensorType>();
+    if (!t) {
+      continue;
+    }
+    if (auto relaxed = withUnknownDims(t, dims)) {
+      input->setType(relaxed);
+      changed = true;
+    }
+  }
+  if (!changed) {
+    return subgraph;
+  }
+  for (auto* node : subgraph->nodes()) {
+    if (node->kind() == prim::Constant) {
+      continue;
+    }
+    for (auto* output : node->outputs()) {
+      auto t = output->type()->cast<TensorType>();
+      if (!t) {
+        continue;
+      }
+      if (auto relaxed = withUnknownDims(t, allDims(t))) {
+        output->setType(relaxed);
+      }
+    }
+  }
+  if (LlgaGraphHelper(subgraph).getPartitions().size() != 1) {
+    GRAPH_DEBUG(
+        "The subgraph of ",
+        *fusionGroup,
+        " doesn't form a single partition without the sizes");
+    return nullptr;
+  }
+  return subgraph;
+}
+
+void collectFusionGroups(Block* block, std::vector<Node*>& fusionGroups) {
+  for (Node* n : block->nodes()) {
+    for (Block* b : n->blocks()) {
+      collectFusionGroups(b, fusionGroups);
+    }
+    if (n->kind() == Symbol::fromQualString(LlgaFusionGroupName())) {
+      fusionGroups.push_back(n);
+    }
+  }
+}
+
+Symbol symbolicDimsAttr() {
+  return Symbol::attr("symbolic_dims");
+}
+
+} // namespace
+
+void setLlgaSymbolicDims(const std::vector<int64_t>& dims) {
+  for (auto d : dims) {
+    TORCH_CHECK(d >= 0, "The symbolic dims must be non-negative, got ", d);
+  }
+  std::lock_guard<std::mutex> guard(symbolicDimsMutex());
+  symbolicDims() = dims;
+}
+
+std::vector<int64_t> getLlgaSymbolicDims() {
+  std::lock_guard<std::mutex> guard(symbolicDimsMutex());
+  return symbolicDims();
+}
+
+void relaxFusionGroupShapes(const std::shared_ptr<Graph>& graph) {
+  auto dims = getLlgaSymbolicDims();
+  if (dims.empty()) {
+    return;
+  }
+  std::vector<Node*> fusionGroups;
+  collectFusionGroups(graph->block(), fusionGroups);
+
+  // The outputs of a fusion group are not guarded by the fusion groups
+  // consuming them, so either all the fusion groups are relaxed or none.
+  std::vector<std::shared_ptr<Graph>> subgraphs;
+  for (Node* fusionGroup : fusionGroups) {
+    auto subgraph = relaxSubgraph(fusionGroup, dims);
+    if (!subgraph) {
+      return;
+    }
+    subgraphs.push_back(subgraph);
+  }
+
+  // The types outside the fusion groups are left for the other passes, only
+  // the guards take the symbolic dims.
+  for (size_t i = 0; i < fusionGroups.size(); i++) {
+    fusionGroups[i]->g_(attr::Subgraph, subgraphs[i]);
+    fusionGroups[i]->is_(symbolicDimsAttr(), dims);
+  }
+}
+
 using tensor_type_converter_t =
     c10::function_ref<TensorTypePtr(const TensorTypePtr& t)>;
 
@@ -133,9 +286,16 @@ void prepareFusionGroupAndGuardOutputs(Block* block) {
     // refer to
     // `torch/csrc/jit/passes/tensorexpr_fuser.cpp:removeOutputsUsedOnlyInSize`
     // removeOutputsUsedOnlyInSize(fusion_group);
+    std::vector<int64_t> dims;
+    if (fusion_group->hasAttribute(symbolicDimsAttr())) {
+      dims = fusion_group->is(symbolicDimsAttr());
+    }
     insertTypeGuardForFusionGroup(
         fusion_group,
-        [](const TensorTypePtr& t) { return t; },
+        [&dims](const TensorTypePtr& t) {
+          auto relaxed = withUnknownDims(t, dims);
+          return relaxed ? relaxed : t;
+        },
         Symbol::fromQualString(fuser::onednn::LlgaGuardName()));
   }
 }
@@ -7,6 +7,16 @@ namespace jit {
 namespace fuser {
 namespace onednn {
 
+// Makes the symbolic dims (see setLlgaSymbolicDims) of the graph inputs of
+// all the fusion groups of graph unknown, in the types of the fusion groups
+// and of their subgraphs, so that the guards inserted by
+// prepareFusionGroupAndGuardOutputs accept any size of those dims and the
+// LlgaKernel compiles the partition for the sizes it runs with. The sizes of
+// the values inside the subgraphs are left to the shape inference of oneDNN
+// graph. The graph is left as it is if any of the subgraphs doesn't form a
+// single partition without the sizes.
+void relaxFusionGroupShapes(const std::shared_ptr<Graph>& graph);
+
 void prepareFusionGroupAndGuardOutputs(Block* block);
 
 } // namespace onednn
@@ -6,10 +6,13 @@
 #include "guard_shape.h"
 #include "kernel.h"
 #include "layout_propagation.h"
+#include "partition_cache.h"
 #include "lift_up_quant.h"
 #include "prepare_binary.h"
 #include "prepare_dequant.h"
+#include "propagate_quant.h"
 #include "quantization_patterns.h"
+#include "csrc/utils/op_trace.h"
 
 #include <torch/csrc/jit/jit_log.h>
 #include <torch/csrc/jit/passes/common_subexpression_elimination.h>
@@ -74,6 +77,12 @@ void fuseGraph(std::shared_ptr<Graph>& g) {
     GRAPH_DUMP(
         "After PropagateLayout. Before prepareFusionGroupAndGuardOutputs", g);
 
+    relaxFusionGroupShapes(g);
+    GRAPH_DUMP(
+        "After relaxFusionGroupShapes. Before "
+        "prepareFusionGroupAndGuardOutputs",
+        g);
+
     // Add shape guard for profiling mode and wipe the tensor type information
     // from the IR
     prepareFusionGroupAndGuardOutputs(g->block());
@@ -84,10 +93,30 @@ void fuseGraph(std::shared_ptr<Graph>& g) {
     RevertPrepareBinaryForLLGA(g);
     GRAPH_DUMP("After RevertPrepareBinaryForLLGA. Before IpexQuantFusion", g);
     IpexQuantFusion(g);
-    GRAPH_DUMP("After IpexQuantFusion. End of INT8 optimization pass", g);
+    GRAPH_DUMP("After IpexQuantFusion. Before PropagateQuantizedTensors", g);
+    // PropagateQuantizedTensors must be placed after IpexQuantFusion, which
+    // creates the quantized ipex::qembedding_bag and ipex::qinteraction
+    PropagateQuantizedTensors(g);
+    GRAPH_DUMP(
+        "After PropagateQuantizedTensors. End of INT8 optimization pass", g);
   }
 }
 
+namespace {
+// The weights and biases of a frozen model are prim::Constant inputs of the
+// partitions, whose logical tensors are of property constant. With the
+// constant cache, oneDNN graph keeps their reordered (and quantized) form
+// after the first execution of a compiled partition instead of preparing
+// them on every call, so it is enabled unless the user turns it off.
+struct LlgaWeightCacheDefault {
+  LlgaWeightCacheDefault() {
+    dnnl::graph::set_constant_cache(true);
+  }
+};
+
+static LlgaWeightCacheDefault llga_weight_cache_default_;
+} // namespace
+
 void setLlgaWeightCacheEnabled(bool enabled) {
   dnnl::graph::set_constant_cache(enabled);
 }
@@ -96,15 +125,21 @@ bool getLlgaWeightCacheEnabled() {
   return dnnl::graph::get_constant_cache();
 }
 
+void setLlgaPartitionRecordDir(const std::string& dir) {
+  partition_cache::setDir(dir);
+}
+
+std::string getLlgaPartitionRecordDir() {
+  return partition_cache::getDir();
+}
+
 } // namespace onednn
 } // namespace fuser
 
 Operation createLlgaKernel(const Node* node) {
   auto kernel = std::make_shared<fuser::onednn::LlgaKernel>(node);
   return [kernel](Stack* stack) {
-#if defined(IPEX_PROFILE_OP)
-    RECORD_FUNCTION(kernel->profileName(), std::vector<c10::IValue>());
-#endif
+    IPEX_RECORD_FUNCTION(kernel->profileName(), std::vector<c10::IValue>());
     kernel->run(*stack);
     return 0;
   };
@@ -119,9 +154,8 @@ RegisterOperators LLGAFusionGroupOp({
 
 Operation createLlgaGuardKernel(const Node* node) {
   return [node](Stack* stack) {
-#if defined(IPEX_PROFILE_OP)
-    RECORD_FUNCTION(fuser::onednn::LlgaGuardName(), std::vector<c10::IValue>());
-#endif
+    IPEX_RECORD_FUNCTION(
+        fuser::onednn::LlgaGuardName(), std::vector<c10::IValue>());
     GRAPH_DEBUG("Guarding node: ", node->kind().toQualString());
     std::vector<TypePtr> types = node->tys(attr::types);
     const auto num_inputs = types.size();
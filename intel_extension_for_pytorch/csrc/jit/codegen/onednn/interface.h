@@ -16,10 +16,35 @@ static std::atomic<bool>& getLlgaEnabled() {
 
 TORCH_API void fuseGraph(std::shared_ptr<Graph>& g);
 
+// Whether oneDNN graph keeps the constant inputs of the compiled partitions,
+// e.g. the packed weights of a frozen model, across the executions. Enabled
+// by default.
 void setLlgaWeightCacheEnabled(bool enabled);
 
 bool getLlgaWeightCacheEnabled();
 
+// Max number of the partitions compiled for different input shapes kept by
+// each LLGA fusion group.
+void setLlgaCompiledPartitionCacheCapacity(int64_t capacity);
+
+int64_t getLlgaCompiledPartitionCacheCapacity();
+
+// The directory recording the input shapes each partition has been compiled
+// for, so that the later processes compile them ahead of the first run. An
+// empty dir disables the record, which is the default.
+void setLlgaPartitionRecordDir(const std::string& dir);
+
+std::string getLlgaPartitionRecordDir();
+
+// The dims of the graph inputs of the LLGA fusion groups, e.g. 0 for the
+// batch or 1 for the sequence length of a [batch, seq, hidden] input, whose
+// size may change without failing the shape guard and running the fallback
+// graph. A fusion group whose partition can only be formed on the profiled
+// sizes keeps the exact guard. Empty by default.
+void setLlgaSymbolicDims(const std::vector<int64_t>& dims);
+
+std::vector<int64_t> getLlgaSymbolicDims();
+
 } // namespace onednn
 } // namespace fuser
 
@@ -1,12 +1,22 @@
 #include "kernel.h"
 #include "graph_helper.h"
+#include "interface.h"
 #include "operator.h"
+#include "partition_cache.h"
 #include "runtime.h"
+#include "csrc/utils/memory_stats.h"
+#include "csrc/utils/op_trace.h"
 
+#include <ATen/Parallel.h>
 #include <ATen/core/functional.h>
 #include <ATen/quantized/Quantizer.h>
 #include <torch/csrc/jit/jit_log.h>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <unordered_set>
+
 namespace torch {
 namespace jit {
 namespace fuser {
@@ -16,6 +26,57 @@ using namespace dnnl::graph;
 
 using data_type = dnnl::graph::logical_tensor::data_type;
 
+static std::atomic<int64_t> compiledPartitionCacheCapacity{16};
+
+void setLlgaCompiledPartitionCacheCapacity(int64_t capacity) {
+  TORCH_CHECK(
+      capacity > 0,
+      "The capacity of the LLGA compiled partition cache should be positive, "
+      "but got ",
+      capacity);
+  compiledPartitionCacheCapacity = capacity;
+}
+
+int64_t getLlgaCompiledPartitionCacheCapacity() {
+  return compiledPartitionCacheCapacity;
+}
+
+namespace {
+
+// the live kernels, of which the compiled partitions are evicted by the
+// memory budget
+struct KernelRegistry {
+  std::mutex mutex;
+  std::unordered_set<LlgaKernel*> kernels;
+};
+
+KernelRegistry& getKernelRegistry() {
+  static KernelRegistry registry;
+  return registry;
+}
+
+} // namespace
+
+torch_ipex::memory_stats::CacheAccount LlgaKernel::compiledPartitionsAccount_(
+    "llga_compiled_partitions",
+    3,
+    [](int64_t bytes) { return LlgaKernel::evictCompiledPartitions(bytes); });
+
+int64_t LlgaKernel::evictCompiledPartitions(int64_t bytes) {
+  auto& registry = getKernelRegistry();
+  std::lock_guard<std::mutex> registryGuard(registry.mutex);
+  for (auto kernel : registry.kernels) {
+    std::lock_guard<std::mutex> guard(kernel->compiledPartitionsMutex_);
+    auto& compiledPartitions = kernel->compiledPartitions_;
+    if (compiledPartitions.size() > 1) {
+      compiledPartitionsAccount_.update(
+          0, 1 - static_cast<int64_t>(compiledPartitions.size()));
+      compiledPartitions.resize(1);
+    }
+  }
+  return 0;
+}
+
 LlgaKernel::LlgaKernel(const Node* fusionNode)
     : fusionNode_(fusionNode),
       graph_(fusionNode->g(attr::Subgraph)),
@@ -37,6 +98,62 @@ LlgaKernel::LlgaKernel(const Node* fusionNode)
   partition_ = partitions[0];
   nPartitionInputs_ = partition_.get_in_ports().size();
   GRAPH_DEBUG("Initialized ", debugName(), "\n", graph_->toString());
+
+  stats_ = coverage_report::registerKernel(debugName_, genOpList());
+
+  recordPath_ = partition_cache::recordPath(graph_->toString());
+  if (!recordPath_.empty()) {
+    precompileRecordedSignatures();
+  }
+
+  auto& registry = getKernelRegistry();
+  std::lock_guard<std::mutex> guard(registry.mutex);
+  registry.kernels.insert(this);
+}
+
+LlgaKernel::~LlgaKernel() {
+  {
+    auto& registry = getKernelRegistry();
+    std::lock_guard<std::mutex> guard(registry.mutex);
+    registry.kernels.erase(this);
+  }
+  compiledPartitionsAccount_.update(
+      0, -static_cast<int64_t>(compiledPartitions_.size()));
+  // the background compilations refer to this kernel.
+  for (auto& precompilation : precompilations_) {
+    precompilation.second.wait();
+  }
+}
+
+void LlgaKernel::precompileRecordedSignatures() {
+  std::vector<size_t> tids;
+  for (size_t i = 0; i < nGraphInputs_; i++) {
+    tids.push_back(ArgSpec(graph_->inputs()[i]).tid());
+  }
+  auto signatures = partition_cache::loadSignatures(recordPath_, tids);
+  if (signatures.empty()) {
+    return;
+  }
+  initialize();
+  for (auto& signature : signatures) {
+    if (std::find(
+            recordedSignatures_.begin(),
+            recordedSignatures_.end(),
+            signature) != recordedSignatures_.end()) {
+      continue;
+    }
+    recordedSignatures_.push_back(signature);
+    auto promise =
+        std::make_shared<std::promise<std::shared_ptr<CompiledPartition>>>();
+    precompilations_.emplace_back(signature, promise->get_future().share());
+    at::launch([this, signature, promise]() {
+      try {
+        promise->set_value(compile(partition_, signature));
+      } catch (...) {
+        promise->set_exception(std::current_exception());
+      }
+    });
+  }
 }
 
 bool LlgaKernel::useOpaqueLayout(size_t offset) const {
@@ -90,28 +207,13 @@ void LlgaKernel::initializeConstantInputs() {
   }
 }
 
-ArgSpecs LlgaKernel::initializeInputSpecs(const TensorArgs& inputs) {
+ArgSpecs LlgaKernel::initializeGraphInputSpecs(
+    const TensorArgs& inputs) const {
   ArgSpecs inputSpecs;
   inputSpecs.reserve(nPartitionInputs_);
-  GRAPH_DEBUG("Initializing graph input logical tensors");
   for (size_t i = 0; i < nGraphInputs_; i++) {
-    auto spec = ArgSpec(graph_->inputs()[i]).supplementTensorInfo(inputs[i]);
-    initializedInputIds_.insert(spec.tid());
-    inputSpecs.emplace_back(spec);
-  }
-
-  GRAPH_DEBUG("Initializing constant input tensors");
-  initializeConstantInputs();
-
-  TORCH_CHECK(
-      inputSpecs.size() + constantValues_.size() == nPartitionInputs_,
-      "Partition inputs are missing");
-
-  GRAPH_DEBUG(
-      "Concatenating constant input logical tensors to graph input "
-      "logical tensors");
-  for (size_t i = 0; i < constantValues_.size(); i++) {
-    inputSpecs.emplace_back(ArgSpec(constantValues_[i]));
+    inputSpecs.emplace_back(
+        ArgSpec(graph_->inputs()[i]).supplementTensorInfo(inputs[i]));
   }
   return inputSpecs;
 }
@@ -132,103 +234,248 @@ ArgSpecs LlgaKernel::initializeOutputSpecs() const {
   return outputSpecs;
 }
 
+at::Tensor LlgaKernel::allocateOutput(const ArgSpec& spec) const {
+  auto opt = c10::TensorOptions(spec.aten_scalar_type()).device(device_);
+  if (spec.is_opaque()) {
+    return at::empty_llga(spec, opt);
+  }
+  if (spec.is_quantized()) {
+    at::QuantizerPtr quantizer = spec.get_quantizer();
+    auto qtensor = at::new_qtensor(spec.sizes(), opt, quantizer);
+    // TODO: Setting strides is possible only on uniformly quantized tensor.
+    // Currently, only weight will use quantize_per_channel, data will
+    // always use quantize_per_tensor. We will only allocate buffer for data
+    // (output of a LlgaPartition). If in the future, we need allocate
+    // buffer for qensor that is quantized per channel, need implemeted
+    // as_strided_qtensorimpl for PER_CHANNEL QScheme.
+    qtensor.as_strided_(spec.sizes(), spec.strides());
+    return qtensor;
+  }
+  return at::empty_strided(spec.sizes(), spec.strides(), opt);
+}
+
+// Whether the output buffer held by a compiled partition is no longer used by
+// the consumers of the previous run, neither directly nor through a view.
+// An LlgaTensorImpl can't be viewed and doesn't expose its storage.
+static bool isUnreferenced(const at::Tensor& buffer) {
+  if (!(buffer.defined() && buffer.use_count() == 1)) {
+    return false;
+  }
+  return buffer.is_mkldnn() || buffer.storage().use_count() == 1;
+}
+
 std::tuple<RunArgs, RunArgs> LlgaKernel::prepareRunArgs(
+    CompiledPartition& compiled,
     const TensorArgs& inputs,
     TensorArgs& outputs) const {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("LLGA_bridge::prepareRunArgs", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION(
+      "LLGA_bridge::prepareRunArgs", std::vector<c10::IValue>({}));
   RunArgs runInputs, runOutputs;
+  runInputs.reserve(nPartitionInputs_);
+  runOutputs.reserve(nOutputs_);
+  outputs.reserve(nOutputs_);
   for (size_t i = 0; i < nGraphInputs_; i++) {
-    auto spec = inputSpecs_[i];
+    auto& spec = compiled.inputSpecs[i];
     runInputs.push_back(
         {spec.logical_tensor(), Engine::getEngine(), inputs[i].data_ptr()});
   }
   for (size_t i = 0; i < constantInputs_.size(); i++) {
     // constantInputSpecs are placed after graphInputSpecs
     auto constantInputSpecIdx = nGraphInputs_ + i;
-    auto constantInputSpec = inputSpecs_[constantInputSpecIdx];
+    auto& constantInputSpec = compiled.inputSpecs[constantInputSpecIdx];
     runInputs.push_back(
         {constantInputSpec.logical_tensor(),
          Engine::getEngine(),
          constantInputs_[i].data_ptr()});
   }
 
+  // The runs on the other threads which can't take the buffers allocate
+  // their outputs as before.
+  std::unique_lock<std::mutex> buffersLock(
+      compiled.outputBuffersMutex, std::try_to_lock);
+  if (buffersLock.owns_lock() && compiled.outputBuffers.empty()) {
+    compiled.outputBuffers.resize(nOutputs_);
+  }
   for (size_t i = 0; i < nOutputs_; i++) {
-    auto spec = outputSpecs_[i];
-    auto opt = c10::TensorOptions(spec.aten_scalar_type()).device(device_);
-
+    auto& spec = compiled.outputSpecs[i];
     auto outputId = spec.tid();
-    auto iter = inplacePairs_.find(outputId);
-    if (iter != inplacePairs_.end()) {
+    auto iter = compiled.inplacePairs.find(outputId);
+    if (iter != compiled.inplacePairs.end()) {
       // output reuses one of input tensors
       auto inputOffset = iter->second;
       auto inputTensor = inputs[inputOffset];
       outputs.push_back(inputTensor);
       runOutputs.push_back(
           {spec.logical_tensor(), Engine::getEngine(), inputTensor.data_ptr()});
-    } else if (spec.is_opaque()) {
-      auto tensor = at::empty_llga(spec, opt);
-      outputs.push_back(tensor);
+      continue;
+    }
+
+    at::Tensor tensor;
+    if (buffersLock.owns_lock()) {
+      auto& buffer = compiled.outputBuffers[i];
+      if (!isUnreferenced(buffer)) {
+        // the previous output is still alive, keep the new one instead.
+        buffer = allocateOutput(spec);
+      }
+      tensor = buffer;
+    } else {
+      tensor = allocateOutput(spec);
+    }
+    outputs.push_back(tensor);
+    if (spec.is_opaque()) {
       runOutputs.push_back(at::llga_from_aten_tensor(tensor));
     } else {
-      if (spec.is_quantized()) {
-        at::QuantizerPtr quantizer = spec.get_quantizer();
-        auto qtensor = at::new_qtensor(spec.sizes(), opt, quantizer);
-        // TODO: Setting strides is possible only on uniformly quantized tensor.
-        // Currently, only weight will use quantize_per_channel, data will
-        // always use quantize_per_tensor. We will only allocate buffer for data
-        // (output of a LlgaPartition). If in the future, we need allocate
-        // buffer for qensor that is quantized per channel, need implemeted
-        // as_strided_qtensorimpl for PER_CHANNEL QScheme.
-        qtensor.as_strided_(spec.sizes(), spec.strides());
-        outputs.push_back(qtensor);
-        runOutputs.push_back(
-            {spec.logical_tensor(), Engine::getEngine(), qtensor.data_ptr()});
-      } else {
-        auto tensor = at::empty_strided(spec.sizes(), spec.strides(), opt);
-        outputs.push_back(tensor);
-        runOutputs.push_back(
-            {spec.logical_tensor(), Engine::getEngine(), tensor.data_ptr()});
-      }
+      runOutputs.push_back(
+          {spec.logical_tensor(), Engine::getEngine(), tensor.data_ptr()});
     }
   }
 
-  return std::make_tuple(runInputs, runOutputs);
+  return std::make_tuple(std::move(runInputs), std::move(runOutputs));
 }
 
-compiled_partition LlgaKernel::compile(const partition& partition) {
-  auto inputs = fmap(inputSpecs_, toLogicalTensor);
-  auto outputs = fmap(outputSpecs_, toLogicalTensor);
-  auto compilation = partition.compile(inputs, outputs, Engine::getEngine());
+std::shared_ptr<LlgaKernel::CompiledPartition> LlgaKernel::compile(
+    const partition& partition,
+    const ArgSpecs& graphInputSpecs) const {
+  auto compiled = std::make_shared<CompiledPartition>();
+  compiled->inputSpecs = graphInputSpecs;
+  GRAPH_DEBUG(
+      "Concatenating constant input logical tensors to graph input "
+      "logical tensors");
+  for (size_t i = 0; i < constantValues_.size(); i++) {
+    compiled->inputSpecs.emplace_back(ArgSpec(constantValues_[i]));
+  }
+  GRAPH_DEBUG("Initializing output logical tensors");
+  compiled->outputSpecs = initializeOutputSpecs();
+
+  auto inputs = fmap(compiled->inputSpecs, toLogicalTensor);
+  auto outputs = fmap(compiled->outputSpecs, toLogicalTensor);
+  compiled->compilation =
+      partition.compile(inputs, outputs, Engine::getEngine());
 
   // Since layouts of opaque outputs would be known after compilation,
   // we need to query them out from compilation and update outputSpecs
+  auto& outputSpecs = compiled->outputSpecs;
   for (size_t i = 0; i < nOutputs_; i++) {
-    auto tid = outputSpecs_[i].tid();
-    outputSpecs_[i] =
-        outputSpecs_[i].update_desc(compilation.query_logical_tensor(tid));
+    auto tid = outputSpecs[i].tid();
+    outputSpecs[i] = outputSpecs[i].update_desc(
+        compiled->compilation.query_logical_tensor(tid));
   }
 
   // Build static mapping from output id to input offset
   // in accordance with available inplace options
-  for (auto&& option : compilation.get_inplace_ports()) {
+  auto& inputSpecs = compiled->inputSpecs;
+  for (auto&& option : compiled->compilation.get_inplace_ports()) {
     size_t inputId = option.first;
     size_t outputId = option.second;
     auto inputSpecIter =
-        std::find_if(inputSpecs_.begin(), inputSpecs_.end(), [&](auto& spec) {
+        std::find_if(inputSpecs.begin(), inputSpecs.end(), [&](auto& spec) {
           return spec.tid() == inputId;
         });
-    TORCH_CHECK(inputSpecIter != inputSpecs_.end(), "In-place input not found");
-    auto inputOffset = inputSpecIter - inputSpecs_.begin();
-    inplacePairs_[outputId] = inputOffset;
+    TORCH_CHECK(inputSpecIter != inputSpecs.end(), "In-place input not found");
+    auto inputOffset = inputSpecIter - inputSpecs.begin();
+    compiled->inplacePairs[outputId] = inputOffset;
   }
 
-  return compilation;
+  return compiled;
+}
+
+std::shared_ptr<LlgaKernel::CompiledPartition> LlgaKernel::
+    getCompiledPartition(const ArgSpecs& graphInputSpecs) {
+  auto sameSignature = [&](const ArgSpecs& inputSpecs) {
+    return std::equal(
+        graphInputSpecs.begin(), graphInputSpecs.end(), inputSpecs.begin());
+  };
+  auto matches = [&](const std::shared_ptr<CompiledPartition>& compiled) {
+    return sameSignature(compiled->inputSpecs);
+  };
+  {
+    std::lock_guard<std::mutex> guard(compiledPartitionsMutex_);
+    auto it = std::find_if(
+        compiledPartitions_.begin(), compiledPartitions_.end(), matches);
+    if (it != compiledPartitions_.end()) {
+      compiledPartitions_.splice(
+          compiledPartitions_.begin(), compiledPartitions_, it);
+      return compiledPartitions_.front();
+    }
+  }
+
+  std::shared_ptr<CompiledPartition> compiled;
+  std::shared_future<std::shared_ptr<CompiledPartition>> precompilation;
+  {
+    std::lock_guard<std::mutex> guard(compiledPartitionsMutex_);
+    auto it = std::find_if(
+        precompilations_.begin(),
+        precompilations_.end(),
+        [&](auto& p) { return sameSignature(p.first); });
+    if (it != precompilations_.end()) {
+      precompilation = it->second;
+      precompilations_.erase(it);
+    }
+  }
+  if (precompilation.valid()) {
+    try {
+      compiled = precompilation.get();
+    } catch (const std::exception& e) {
+      GRAPH_DEBUG("Failed to compile the recorded signature: ", e.what());
+    }
+  }
+
+  // Compile out of the lock, so that the other signatures keep running. The
+  // threads missing the same signature at the same time may each compile it,
+  // only the first one is kept.
+  if (!compiled) {
+    GRAPH_DEBUG("Compiling partition");
+    compiled = compile(partition_, graphInputSpecs);
+  }
+
+  std::lock_guard<std::mutex> guard(compiledPartitionsMutex_);
+  if (!recordPath_.empty() &&
+      std::find_if(
+          recordedSignatures_.begin(),
+          recordedSignatures_.end(),
+          sameSignature) == recordedSignatures_.end()) {
+    recordedSignatures_.push_back(graphInputSpecs);
+    partition_cache::appendSignature(recordPath_, graphInputSpecs);
+  }
+  auto it = std::find_if(
+      compiledPartitions_.begin(), compiledPartitions_.end(), matches);
+  if (it != compiledPartitions_.end()) {
+    return *it;
+  }
+  compiledPartitions_.push_front(compiled);
+  compiledPartitionsAccount_.update(0, 1);
+  while (compiledPartitions_.size() >
+         static_cast<size_t>(getLlgaCompiledPartitionCacheCapacity())) {
+    compiledPartitions_.pop_back();
+    compiledPartitionsAccount_.update(0, -1);
+  }
+  return compiled;
+}
+
+void LlgaKernel::initialize() {
+  if (is_initialized_.load(std::memory_order_acquire)) {
+    return;
+  }
+  std::lock_guard<std::mutex> guard(init_mutex_);
+  if (!is_initialized_.load(std::memory_order_relaxed)) {
+    for (size_t i = 0; i < nGraphInputs_; i++) {
+      initializedInputIds_.insert(ArgSpec(graph_->inputs()[i]).tid());
+    }
+    GRAPH_DEBUG("Initializing constant input tensors");
+    initializeConstantInputs();
+    TORCH_CHECK(
+        nGraphInputs_ + constantValues_.size() == nPartitionInputs_,
+        "Partition inputs are missing");
+    is_initialized_.store(true, std::memory_order_release);
+  }
 }
 
 void LlgaKernel::run(Stack& stack) {
   GRAPH_DEBUG("In ", debugName(), "\n");
+  std::chrono::steady_clock::time_point start;
+  if (stats_) {
+    start = std::chrono::steady_clock::now();
+  }
 
   // Grab input values from stack
   auto stackInputs = last(stack, nGraphInputs_);
@@ -238,32 +485,18 @@ void LlgaKernel::run(Stack& stack) {
     return v.toTensor();
   });
 
-  lock_read();
-  if (is_initialized_) {
-    unlock_read();
-  } else {
-    unlock_read();
-
-    lock_write();
-    if (!is_initialized_) {
-      GRAPH_DEBUG("Initializing input logical tensors");
-      inputSpecs_ = initializeInputSpecs(inputs);
-      GRAPH_DEBUG("Initializing output logical tensors");
-      outputSpecs_ = initializeOutputSpecs();
-      GRAPH_DEBUG("Compiling partition");
-      compilation_ = compile(partition_);
-      is_initialized_ = true;
-    }
-    unlock_write();
-  }
+  initialize();
+
+  GRAPH_DEBUG("Initializing input logical tensors");
+  auto compiled = getCompiledPartition(initializeGraphInputSpecs(inputs));
 
   GRAPH_DEBUG("Preparing runtime tensors");
   TensorArgs outputs;
   RunArgs runInputs, runOutputs;
-  std::tie(runInputs, runOutputs) = prepareRunArgs(inputs, outputs);
+  std::tie(runInputs, runOutputs) = prepareRunArgs(*compiled, inputs, outputs);
 
   GRAPH_DEBUG("Executing partition");
-  compilation_.execute(Stream::getStream(), runInputs, runOutputs);
+  compiled->compilation.execute(Stream::getStream(), runInputs, runOutputs);
   GRAPH_DEBUG("Partition executed");
 
   // Update the stack.
@@ -271,6 +504,13 @@ void LlgaKernel::run(Stack& stack) {
   for (auto& o : outputs)
     push_one(stack, std::move(o));
   GRAPH_DEBUG("Stack updated");
+
+  if (stats_) {
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start);
+    stats_->calls++;
+    stats_->totalNs += elapsed.count();
+  }
 }
 
 } // namespace onednn
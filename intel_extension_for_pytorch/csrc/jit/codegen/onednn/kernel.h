@@ -1,8 +1,14 @@
 #pragma once
 
+#include <atomic>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
 #include <unordered_map>
+#include "coverage_report.h"
 #include "csrc/jit/codegen/LlgaTensorImpl.h"
-#include "csrc/utils/rw_lock.h"
+#include "csrc/utils/memory_stats.h"
 #include "graph_helper.h"
 
 #include <oneapi/dnnl/dnnl_graph.hpp>
@@ -25,6 +31,8 @@ class LlgaKernel {
  public:
   explicit LlgaKernel(const Node* fusionNode);
 
+  ~LlgaKernel();
+
   void run(Stack& stack);
 
   const std::string& debugName() const {
@@ -45,20 +53,61 @@ class LlgaKernel {
   // create qtensor for output of public format
   ArgSpec getQuantizedSpec(ArgSpec spec, size_t offset) const;
 
+  // The partition compiled for one signature of the graph inputs, i.e. their
+  // shapes, strides (or opaque layouts) and dtypes.
+  struct CompiledPartition {
+    ArgSpecs inputSpecs;
+    ArgSpecs outputSpecs;
+    dnnl::graph::compiled_partition compilation;
+    // output id -> input offset
+    std::unordered_map<size_t, size_t> inplacePairs;
+    // The outputs of the last run, indexed by the output offset. A buffer
+    // which nothing else refers to any more is handed out again as the output
+    // of the next run. Guarded by outputBuffersMutex.
+    TensorArgs outputBuffers;
+    std::mutex outputBuffersMutex;
+  };
+
   // PyTorch copy constants inside the subgraph instead of referencing them.
   // Constants inputs to the partition are no longer in the graph->inputs().
   // Need use the tid retrieved from the partition to find the missing
   // constant inputs.
   void initializeConstantInputs();
 
-  ArgSpecs initializeInputSpecs(const TensorArgs& inputs);
+  // Collects the constant inputs on the first call.
+  void initialize();
+
+  // Compiles the signatures recorded by the previous processes in the
+  // background, see partition_cache.h.
+  void precompileRecordedSignatures();
+
+  // The specs of the graph inputs, which are the key of the compiled
+  // partitions.
+  ArgSpecs initializeGraphInputSpecs(const TensorArgs& inputs) const;
 
   ArgSpecs initializeOutputSpecs() const;
 
-  dnnl::graph::compiled_partition compile(
-      const dnnl::graph::partition& partition);
+  std::shared_ptr<CompiledPartition> compile(
+      const dnnl::graph::partition& partition,
+      const ArgSpecs& graphInputSpecs) const;
+
+  // Returns the partition compiled for graphInputSpecs, which is compiled on
+  // the first use of the signature.
+  std::shared_ptr<CompiledPartition> getCompiledPartition(
+      const ArgSpecs& graphInputSpecs);
+
+  // Drops all but the most recently used compiled partition of each live
+  // kernel for the memory budget. The memory of a compiled partition is not
+  // queryable from oneDNN graph, so the partitions are accounted by their
+  // entries only.
+  static int64_t evictCompiledPartitions(int64_t bytes);
+
+  static torch_ipex::memory_stats::CacheAccount compiledPartitionsAccount_;
+
+  at::Tensor allocateOutput(const ArgSpec& spec) const;
 
   std::tuple<RunArgs, RunArgs> prepareRunArgs(
+      CompiledPartition& compiled,
       const TensorArgs& inputs,
       TensorArgs& outputs) const;
 
@@ -67,34 +116,22 @@ class LlgaKernel {
     return "LlgaPartition_" + std::to_string(debugId++);
   }
 
-  std::string genProfileName() {
+  std::vector<std::string> genOpList() {
     std::vector<std::string> op_list;
     for (auto* node : graph_->block()->nodes()) {
       if (node->kind().is_aten()) {
         op_list.push_back(node->kind().toUnqualString());
       }
     }
-    return c10::Join("+", op_list);
-  }
-
-  static dnnl::graph::logical_tensor toLogicalTensor(const ArgSpec& s) {
-    return s.logical_tensor();
-  }
-
-  void lock_read() {
-    rw_mutex_.lock_read();
+    return op_list;
   }
 
-  void lock_write() {
-    rw_mutex_.lock_write();
-  }
-
-  void unlock_read() {
-    rw_mutex_.unlock_read();
+  std::string genProfileName() {
+    return c10::Join("+", genOpList());
   }
 
-  void unlock_write() {
-    rw_mutex_.unlock_write();
+  static dnnl::graph::logical_tensor toLogicalTensor(const ArgSpec& s) {
+    return s.logical_tensor();
   }
 
   at::Device device_ = at::kCPU;
@@ -109,17 +146,36 @@ class LlgaKernel {
   // nPartitionInputs_ = nGraphInputs_ + constantInputs_.size() since Constant
   // inputs are copied to the inside of the subgraph
   int64_t nPartitionInputs_;
-  dnnl::graph::compiled_partition compilation_;
   std::set<size_t> initializedInputIds_;
   std::vector<Value*> constantValues_;
   TensorArgs constantInputs_;
-  ArgSpecs inputSpecs_;
-  ArgSpecs outputSpecs_;
-  std::unordered_map<size_t, size_t> inplacePairs_; // output id -> input offset
+  // The partitions compiled for the recent signatures of the graph inputs,
+  // most recently used first, so that e.g. each sequence length of a BERT
+  // model runs its own compiled partition without compiling on every call.
+  // Guarded by compiledPartitionsMutex_.
+  std::list<std::shared_ptr<CompiledPartition>> compiledPartitions_;
+  // The recorded signatures being compiled in the background, which are
+  // moved to compiledPartitions_ on their first use. Guarded by
+  // compiledPartitionsMutex_.
+  std::vector<std::pair<
+      ArgSpecs,
+      std::shared_future<std::shared_ptr<CompiledPartition>>>>
+      precompilations_;
+  std::mutex compiledPartitionsMutex_;
+  // The record of the signatures of this partition, empty if disabled, and
+  // the signatures in it. Guarded by compiledPartitionsMutex_.
+  std::string recordPath_;
+  std::vector<ArgSpecs> recordedSignatures_;
   std::string debugName_;
   std::string profileName_;
-  torch_ipex::ReadWriteMutex rw_mutex_;
-  bool is_initialized_ = false;
+  // The runs of this kernel in the coverage report, nullptr if the report
+  // was disabled when the kernel was created.
+  std::shared_ptr<coverage_report::KernelStats> stats_;
+  // is_initialized_ is set with release order once the constant inputs are
+  // collected under init_mutex_, so that the runs after the first one only
+  // take an acquire load.
+  std::mutex init_mutex_;
+  std::atomic<bool> is_initialized_{false};
 };
 
 } // namespace onednn
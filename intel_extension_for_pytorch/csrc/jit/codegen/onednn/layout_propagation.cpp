@@ -6,9 +6,15 @@ namespace jit {
 namespace fuser {
 namespace onednn {
 
+// The ops which only read the metadata kept by LlgaTensorImpl, i.e. the sizes,
+// dtype and device, and never its memory or strides.
 bool couldSupportOpaqueLayout(Node* node) {
   switch (node->kind()) {
     case aten::size:
+    case aten::dim:
+    case aten::numel:
+    case prim::dtype:
+    case prim::device:
       return true;
     default:
       return false;
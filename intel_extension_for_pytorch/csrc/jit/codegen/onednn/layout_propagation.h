@@ -11,6 +11,9 @@ namespace onednn {
 // e.g. llga fusion ops, prim ops
 // (torch/csrc/jit/runtime/register_prim_ops.cpp). If a LlgaPartition is only
 // fed to JIT-only ops, the output format of this partition will be set as ANY.
+// The metadata ops aten::size, aten::dim, aten::numel, prim::dtype and
+// prim::device keep the output opaque as well, since they don't read the
+// blocked memory.
 void PropagateLayout(const std::shared_ptr<Graph>& graph);
 
 } // namespace onednn
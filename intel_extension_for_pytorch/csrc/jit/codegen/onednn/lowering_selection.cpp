@@ -0,0 +1,235 @@
+#include "lowering_selection.h"
+
+#include <torch/csrc/jit/ir/constants.h>
+#include <torch/csrc/jit/jit_log.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <sstream>
+#include <unordered_set>
+
+namespace torch {
+namespace jit {
+namespace fuser {
+namespace onednn {
+namespace lowering_selection {
+
+namespace {
+
+// The run overhead of an LLGA fusion group, i.e. of its shape guard, the
+// lookup of its compiled partition and the binding of its tensors, and of a
+// kernel of the IPEX fusion pass, i.e. of the dispatch of its op and its
+// OpContext, in ns.
+constexpr double kLlgaPartitionOverheadNs = 5000;
+constexpr double kIpexKernelOverheadNs = 1000;
+// The memory bandwidth of an intermediate written and read back, in bytes per
+// ns.
+constexpr double kBytesPerNs = 20;
+
+std::atomic<bool> enabled{false};
+
+std::mutex& planMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+// of LLGA if true, of the IPEX fusion pass otherwise
+std::unordered_map<std::string, bool>& plan() {
+  static std::unordered_map<std::string, bool> plan;
+  return plan;
+}
+
+bool isAnchor(const Node* n) {
+  switch (n->kind()) {
+    case aten::_convolution:
+    case aten::conv2d:
+    case aten::conv3d:
+    case aten::conv_transpose2d:
+    case aten::linear:
+    case aten::addmm:
+    case aten::matmul:
+    case aten::bmm:
+    case aten::baddbmm:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool isEltwise(const Node* n) {
+  static const std::unordered_set<Symbol> eltwise = {
+      aten::relu,
+      Symbol::fromQualString("aten::relu_"),
+      aten::gelu,
+      aten::sigmoid,
+      aten::tanh,
+      aten::hardswish,
+      aten::hardsigmoid,
+      aten::hardtanh,
+      aten::elu,
+      aten::leaky_relu,
+      aten::silu,
+      aten::mish,
+      aten::clamp,
+      aten::abs,
+      aten::exp,
+      aten::log,
+      aten::sqrt,
+      aten::square,
+      aten::pow,
+      aten::round,
+      aten::add,
+      aten::add_,
+      aten::sub,
+      aten::mul,
+      aten::div,
+  };
+  return eltwise.count(n->kind()) > 0;
+}
+
+double tensorBytes(const Value* v) {
+  auto type = v->type()->cast<TensorType>();
+  if (!type) {
+    return 0;
+  }
+  auto numel = type->numel();
+  auto dtype = type->scalarType();
+  if (!numel || !dtype) {
+    return 0;
+  }
+  return static_cast<double>(*numel) * c10::elementSize(*dtype);
+}
+
+// The hash of the ops of nodes, in the order of the graph, with the types of
+// their inputs and the values of their constant non-tensor inputs, e.g. the
+// strides of a conv.
+std::string signature(const std::vector<Node*>& nodes) {
+  std::ostringstream os;
+  for (auto* n : nodes) {
+    os << n->kind().toQualString() << "(";
+    for (size_t i = 0; i < n->inputs().size(); i++) {
+      auto* v = n->input(i);
+      os << (i ? "," : "") << *v->type();
+      if (v->node()->kind() == prim::Constant &&
+          !v->type()->cast<TensorType>()) {
+        auto ivalue = toIValue(v);
+        if (ivalue) {
+          os << "=" << *ivalue;
+        }
+      }
+    }
+    os << ");";
+  }
+  std::ostringstream key;
+  key << std::hex << std::hash<std::string>()(os.str());
+  return key.str();
+}
+
+// The cost of the IPEX fusion pass running the nodes. It runs each anchor,
+// i.e. a conv, linear or matmul, with the eltwise ops after it as its post
+// ops, and a chain of the other eltwise ops as one loop, while each of the
+// remaining ops, e.g. a softmax or a norm, is a kernel of its own. An
+// intermediate of the partition read by another kernel is written and read
+// back, which the LLGA partition keeps inside its fused kernel.
+double ipexCostNs(const std::vector<Node*>& nodes) {
+  std::unordered_set<const Node*> inPartition(nodes.begin(), nodes.end());
+  int64_t kernels = 0;
+  double bytes = 0;
+  for (auto* n : nodes) {
+    // e.g. the prim::ListConstruct of a cat
+    if (n->kind().is_prim()) {
+      continue;
+    }
+    bool fused = false;
+    if (isEltwise(n) && n->inputs().size() > 0) {
+      auto* producer = n->input(0)->node();
+      fused = inPartition.count(producer) && n->input(0)->uses().size() == 1 &&
+          (isAnchor(producer) || isEltwise(producer));
+    }
+    if (!fused) {
+      kernels++;
+    }
+    for (auto* v : n->inputs()) {
+      if (inPartition.count(v->node()) && !(fused && v == n->input(0))) {
+        bytes += 2 * tensorBytes(v);
+      }
+    }
+  }
+  return kernels * kIpexKernelOverheadNs + bytes / kBytesPerNs;
+}
+
+} // namespace
+
+void setEnabled(bool enable) {
+  enabled.store(enable);
+}
+
+bool isEnabled() {
+  return enabled.load(std::memory_order_relaxed);
+}
+
+bool shouldLowerWithLlga(const std::vector<Node*>& partitionNodes) {
+  auto nodes = partitionNodes;
+  std::sort(nodes.begin(), nodes.end(), [](Node* a, Node* b) {
+    return a->isBefore(b);
+  });
+  auto key = signature(nodes);
+  std::lock_guard<std::mutex> guard(planMutex());
+  auto it = plan().find(key);
+  if (it != plan().end()) {
+    return it->second;
+  }
+  auto ipexNs = ipexCostNs(nodes);
+  bool llga = kLlgaPartitionOverheadNs < ipexNs;
+  GRAPH_DEBUG(
+      "Lowering partition ",
+      key,
+      " of ",
+      nodes.size(),
+      " ops with ",
+      llga ? "LLGA" : "IPEX",
+      ", estimated ",
+      kLlgaPartitionOverheadNs,
+      " ns of LLGA and ",
+      ipexNs,
+      " ns of IPEX");
+  plan()[key] = llga;
+  return llga;
+}
+
+std::unordered_map<std::string, std::string> getPlan() {
+  std::unordered_map<std::string, std::string> result;
+  std::lock_guard<std::mutex> guard(planMutex());
+  for (auto& decision : plan()) {
+    result[decision.first] = decision.second ? "llga" : "ipex";
+  }
+  return result;
+}
+
+void setPlan(const std::unordered_map<std::string, std::string>& decisions) {
+  for (auto& decision : decisions) {
+    TORCH_CHECK(
+        decision.second == "llga" || decision.second == "ipex",
+        "The lowering of partition ",
+        decision.first,
+        " must be llga or ipex, but got ",
+        decision.second);
+  }
+  std::lock_guard<std::mutex> guard(planMutex());
+  for (auto& decision : decisions) {
+    plan()[decision.first] = decision.second == "llga";
+  }
+}
+
+void clearPlan() {
+  std::lock_guard<std::mutex> guard(planMutex());
+  plan().clear();
+}
+
+} // namespace lowering_selection
+} // namespace onednn
+} // namespace fuser
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <torch/csrc/jit/ir/ir.h>
+
+namespace torch {
+namespace jit {
+namespace fuser {
+namespace onednn {
+
+// The choice between the LLGA partition and the IPEX fusion pass, i.e. the
+// prepacked OpContexts and the fusion rules of IPEXFusionPass, for each fp32
+// or bf16 partition of oneDNN graph, while the selection is enabled. The
+// quantization partitions are always lowered by LLGA. Without the selection,
+// which is the default, the fp32 and bf16 partitions are lowered by LLGA only
+// if set_llga_fp32_bf16_enabled(True).
+//
+// A partition is kept as an LLGA fusion group if the plan says so for its
+// signature, i.e. its ops with the types, shapes and constant arguments of
+// their inputs, or, of a signature not in the plan, if its cost estimate is
+// below the one of the IPEX lowering. The decision of the estimate is added
+// to the plan, so that the plan can be saved with the model and loaded before
+// it is optimized in the next process, or edited with the lowering measured
+// faster.
+namespace lowering_selection {
+
+void setEnabled(bool enabled);
+
+bool isEnabled();
+
+// Whether the partition of nodes is lowered by LLGA rather than being left to
+// the IPEX fusion pass.
+bool shouldLowerWithLlga(const std::vector<Node*>& nodes);
+
+// The decision of each signature so far, keyed by the hash of the signature,
+// "llga" or "ipex".
+std::unordered_map<std::string, std::string> getPlan();
+
+// Adds the decisions of plan, overriding the ones of the same signatures.
+void setPlan(const std::unordered_map<std::string, std::string>& plan);
+
+// Drops all the decisions.
+void clearPlan();
+
+} // namespace lowering_selection
+
+} // namespace onednn
+} // namespace fuser
+} // namespace jit
+} // namespace torch
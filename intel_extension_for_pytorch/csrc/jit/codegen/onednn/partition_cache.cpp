@@ -0,0 +1,159 @@
+#include "partition_cache.h"
+
+#include <oneapi/dnnl/dnnl.hpp>
+
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <sstream>
+
+namespace torch {
+namespace jit {
+namespace fuser {
+namespace onednn {
+namespace partition_cache {
+
+using data_type = dnnl::graph::logical_tensor::data_type;
+using property_type = dnnl::graph::logical_tensor::property_type;
+
+namespace {
+
+std::mutex& recordMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::string& cacheDir() {
+  static std::string dir;
+  return dir;
+}
+
+void writeDims(std::ostream& os, const std::vector<int64_t>& dims) {
+  for (size_t i = 0; i < dims.size(); i++) {
+    os << (i ? "," : "") << dims[i];
+  }
+}
+
+bool readDims(const std::string& s, std::vector<int64_t>& dims) {
+  std::istringstream is(s);
+  std::string d;
+  while (std::getline(is, d, ',')) {
+    try {
+      dims.push_back(std::stoll(d));
+    } catch (const std::exception&) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// One input is recorded as <dtype>:<sizes>:<strides>, and the inputs of one
+// signature are separated by ';' on one line.
+bool readSignature(
+    const std::string& line,
+    const std::vector<size_t>& tids,
+    std::vector<at::LlgaTensorDesc>& specs) {
+  std::istringstream is(line);
+  std::string input;
+  while (std::getline(is, input, ';')) {
+    if (specs.size() == tids.size()) {
+      return false;
+    }
+    std::istringstream fields(input);
+    std::string dtype, sizes_str, strides_str;
+    if (!std::getline(fields, dtype, ':') ||
+        !std::getline(fields, sizes_str, ':') ||
+        !std::getline(fields, strides_str, ':')) {
+      return false;
+    }
+    std::vector<int64_t> sizes, strides;
+    if (!readDims(sizes_str, sizes) || !readDims(strides_str, strides) ||
+        sizes.size() != strides.size()) {
+      return false;
+    }
+    int dtype_value;
+    try {
+      dtype_value = std::stoi(dtype);
+    } catch (const std::exception&) {
+      return false;
+    }
+    specs.emplace_back(
+        tids[specs.size()],
+        sizes,
+        strides,
+        static_cast<data_type>(dtype_value),
+        property_type::variable);
+  }
+  return specs.size() == tids.size();
+}
+
+} // namespace
+
+void setDir(const std::string& dir) {
+  std::lock_guard<std::mutex> guard(recordMutex());
+  cacheDir() = dir;
+}
+
+std::string getDir() {
+  std::lock_guard<std::mutex> guard(recordMutex());
+  return cacheDir();
+}
+
+std::string recordPath(const std::string& subgraph) {
+  auto dir = getDir();
+  if (dir.empty()) {
+    return "";
+  }
+  auto version = dnnl_graph_version();
+  std::ostringstream key;
+  key << subgraph << "|" << version->major << "." << version->minor << "."
+      << version->patch << "." << version->hash << "|"
+      << static_cast<int>(dnnl::get_effective_cpu_isa());
+  std::ostringstream path;
+  path << dir << "/llga_partition_" << std::hex
+       << std::hash<std::string>()(key.str()) << ".txt";
+  return path.str();
+}
+
+std::vector<std::vector<at::LlgaTensorDesc>> loadSignatures(
+    const std::string& path,
+    const std::vector<size_t>& tids) {
+  std::vector<std::vector<at::LlgaTensorDesc>> signatures;
+  std::lock_guard<std::mutex> guard(recordMutex());
+  std::ifstream is(path);
+  std::string line;
+  while (std::getline(is, line)) {
+    std::vector<at::LlgaTensorDesc> specs;
+    // skip the malformed, e.g. partially written, lines.
+    if (readSignature(line, tids, specs)) {
+      signatures.push_back(std::move(specs));
+    }
+  }
+  return signatures;
+}
+
+void appendSignature(
+    const std::string& path,
+    const std::vector<at::LlgaTensorDesc>& graphInputSpecs) {
+  std::ostringstream line;
+  for (size_t i = 0; i < graphInputSpecs.size(); i++) {
+    auto& spec = graphInputSpecs[i];
+    if (!spec.is_strided()) {
+      return;
+    }
+    line << (i ? ";" : "") << static_cast<int>(spec.dtype()) << ":";
+    writeDims(line, spec.sizes());
+    line << ":";
+    writeDims(line, spec.strides());
+  }
+  line << "\n";
+  std::lock_guard<std::mutex> guard(recordMutex());
+  std::ofstream os(path, std::ios::app);
+  os << line.str();
+}
+
+} // namespace partition_cache
+} // namespace onednn
+} // namespace fuser
+} // namespace jit
+} // namespace torch
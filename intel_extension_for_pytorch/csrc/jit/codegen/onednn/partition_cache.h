@@ -0,0 +1,50 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "csrc/jit/codegen/LlgaTensorImpl.h"
+
+namespace torch {
+namespace jit {
+namespace fuser {
+namespace onednn {
+
+// The on-disk record of the input signatures each LLGA partition has been
+// compiled for. oneDNN Graph can't serialize a compiled partition, so a new
+// process still compiles every partition; with the record, it compiles the
+// signatures seen by the previous processes in the background as soon as the
+// LlgaKernel is created, instead of one after another on the first run of
+// each partition. The record of a partition is keyed by the hash of its
+// subgraph, the oneDNN Graph version and the CPU ISA, so a record never
+// applies to another build or machine.
+namespace partition_cache {
+
+// Enables the record in dir, or disables it if dir is empty.
+void setDir(const std::string& dir);
+
+std::string getDir();
+
+// The path of the record of the partition of subgraph, or an empty string if
+// the record is disabled.
+std::string recordPath(const std::string& subgraph);
+
+// The signatures recorded in path, as the specs of the graph inputs of tids.
+// Returns no signature if there is no record yet.
+std::vector<std::vector<at::LlgaTensorDesc>> loadSignatures(
+    const std::string& path,
+    const std::vector<size_t>& tids);
+
+// Appends the signature of graphInputSpecs to the record in path. The
+// signatures with inputs of opaque layouts, which are only known to the
+// process compiling the upstream partitions, are not recorded.
+void appendSignature(
+    const std::string& path,
+    const std::vector<at::LlgaTensorDesc>& graphInputSpecs);
+
+} // namespace partition_cache
+
+} // namespace onednn
+} // namespace fuser
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,192 @@
+#include "propagate_quant.h"
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/passes/dead_code_elimination.h>
+#include "utils.h"
+
+namespace torch {
+namespace jit {
+namespace fuser {
+namespace onednn {
+
+namespace {
+
+// The ops whose result on a quantized tensor is the quantized result on the
+// dequantized tensor, of the same scale and zero point.
+bool isQuantInvariantOp(Node* n) {
+  if (utils::isViewOp(n)) {
+    return true;
+  }
+  switch (n->kind()) {
+    case aten::max_pool2d:
+    case aten::upsample_nearest2d:
+    case aten::channel_shuffle:
+    case aten::pixel_shuffle:
+    case aten::relu:
+    case aten::flatten:
+    case aten::reshape:
+    case aten::contiguous:
+    case aten::squeeze:
+    case aten::unsqueeze:
+      break;
+    default:
+      return false;
+  }
+  // the other inputs are the sizes, dims or pooling params
+  for (size_t i = 1; i < n->inputs().size(); i++) {
+    if (n->input(i)->type()->cast<TensorType>()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The ops producing a quantized tensor of their last three inputs, the
+// scale, zero point and dtype.
+bool hasOutputQuantParams(Node* n) {
+  if (n->kind() == Symbol::aten("quantize_per_tensor")) {
+    return n->inputs().size() == 4 && n->input(0)->type()->cast<TensorType>();
+  }
+  return n->kind() == Symbol::fromQualString("ipex::qembedding_bag") ||
+      n->kind() == Symbol::fromQualString("ipex::qinteraction") ||
+      n->kind() == Symbol::fromQualString("ipex::qadd") ||
+      n->kind() == Symbol::fromQualString("ipex::qcat");
+}
+
+struct QuantParams {
+  double scale;
+  int64_t zero_point;
+  int64_t dtype;
+};
+
+c10::optional<QuantParams> outputQuantParams(Node* n) {
+  if (!hasOutputQuantParams(n)) {
+    return c10::nullopt;
+  }
+  auto num_inputs = n->inputs().size();
+  auto scale = toIValue(n->input(num_inputs - 3));
+  auto zero_point = toIValue(n->input(num_inputs - 2));
+  auto dtype = toIValue(n->input(num_inputs - 1));
+  if (!scale || !zero_point || !dtype || !scale->isDouble() ||
+      !zero_point->isInt() || !dtype->isInt()) {
+    return c10::nullopt;
+  }
+  return QuantParams{scale->toDouble(), zero_point->toInt(), dtype->toInt()};
+}
+
+class QuantPropagator {
+ private:
+  std::shared_ptr<Graph> graph_;
+
+ public:
+  QuantPropagator(std::shared_ptr<Graph> graph) : graph_(std::move(graph)) {}
+
+  void run(Block* block) {
+    std::vector<Node*> quants;
+    for (Node* node : block->nodes()) {
+      for (Block* sub : node->blocks()) {
+        run(sub);
+      }
+      if (node->kind() == Symbol::aten("quantize_per_tensor")) {
+        quants.push_back(node);
+      }
+    }
+    for (Node* quant : quants) {
+      propagate(quant);
+    }
+  }
+
+ private:
+  // From:
+  // producer -> dequantize -> max_pool2d -> flatten -> quantize (quant)
+  // To:
+  // producer -> max_pool2d -> flatten
+  // with the scale of quant folded into the producer if it is not the same.
+  void propagate(Node* quant) {
+    auto quant_params = outputQuantParams(quant);
+    if (!quant_params) {
+      return;
+    }
+
+    // the invariant ops between the dequantize and quant, from the last one
+    std::vector<Node*> ops;
+    Value* v = quant->input(0);
+    while (isQuantInvariantOp(v->node()) && v->uses().size() == 1) {
+      ops.push_back(v->node());
+      v = v->node()->input(0);
+    }
+    Node* dequant = v->node();
+    if (dequant->kind() != Symbol::aten("dequantize") ||
+        !dequant->input(0)->type()->cast<TensorType>()) {
+      return;
+    }
+    Value* qinput = dequant->input(0);
+    Node* producer = qinput->node();
+    auto producer_params = outputQuantParams(producer);
+    // the scale of the producer is only seen through quant
+    bool exclusive =
+        qinput->uses().size() == 1 && dequant->output()->uses().size() == 1;
+
+    bool same_params = producer_params &&
+        producer_params->scale == quant_params->scale &&
+        producer_params->zero_point == quant_params->zero_point &&
+        producer_params->dtype == quant_params->dtype;
+    bool foldable = producer_params && exclusive &&
+        producer_params->dtype == quant_params->dtype;
+    if (!same_params && !foldable && ops.empty()) {
+      return;
+    }
+
+    // run the invariant ops on the quantized tensor
+    Value* qresult = qinput;
+    if (!ops.empty()) {
+      ops.back()->replaceInput(0, qinput);
+      auto scalar_type = qinput->type()->expect<TensorType>()->scalarType();
+      for (auto it = ops.rbegin(); it != ops.rend(); it++) {
+        auto type = (*it)->output()->type()->expect<TensorType>();
+        (*it)->output()->setType(type->withScalarType(scalar_type));
+      }
+      qresult = ops.front()->output();
+    }
+
+    if (same_params || foldable) {
+      if (!same_params) {
+        // requantize at the producer
+        WithInsertPoint guard(producer);
+        auto num_inputs = producer->inputs().size();
+        producer->replaceInput(
+            num_inputs - 3, graph_->insertConstant(quant_params->scale));
+        producer->replaceInput(
+            num_inputs - 2, graph_->insertConstant(quant_params->zero_point));
+      }
+      quant->output()->replaceAllUsesWith(qresult);
+      quant->destroy();
+      GRAPH_DEBUG(
+          "Propagated ",
+          producer->kind().toQualString(),
+          " through ",
+          ops.size(),
+          " ops");
+    } else {
+      // keep the requantization to the scale of quant after the ops
+      WithInsertPoint guard(quant);
+      auto requant_input =
+          graph_->insert(Symbol::aten("dequantize"), {qresult});
+      quant->replaceInput(0, requant_input);
+    }
+    if (dequant->output()->uses().empty()) {
+      dequant->destroy();
+    }
+  }
+};
+
+} // namespace
+
+void PropagateQuantizedTensors(std::shared_ptr<Graph>& graph) {
+  QuantPropagator(graph).run(graph->block());
+  EliminateDeadCode(graph);
+}
+
+} // namespace onednn
+} // namespace fuser
+} // namespace jit
+} // namespace torch
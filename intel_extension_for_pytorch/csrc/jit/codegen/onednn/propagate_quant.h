@@ -0,0 +1,20 @@
+#pragma once
+
+#include <torch/csrc/jit/ir/ir.h>
+
+namespace torch {
+namespace jit {
+namespace fuser {
+namespace onednn {
+
+// Run the quantization invariant ops left out of the LLGA partitions, e.g.
+// max_pool2d, upsample_nearest2d, channel_shuffle, relu, flatten or view, on
+// the quantized tensors instead of between a dequantize and a quantize, and
+// fold the back-to-back dequantize and quantize pairs into the scale of the
+// quantized producer, e.g. of ipex::qadd and ipex::qcat.
+void PropagateQuantizedTensors(std::shared_ptr<Graph>& graph);
+
+} // namespace onednn
+} // namespace fuser
+} // namespace jit
+} // namespace torch
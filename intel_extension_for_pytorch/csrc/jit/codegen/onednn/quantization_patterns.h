@@ -63,7 +63,15 @@ void IpexQuantFusion(std::shared_ptr<Graph>& graph) {
       "aten::flatten",
       {"%start_dim, %end_dim"},
       {"%start_dim, %end_dim"});
+  auto avg_pool2d_patten = getIpexFusionInfo(
+      "aten::avg_pool2d",
+      "aten::avg_pool2d",
+      {"%kernel_size, %stride, %padding, %ceil_mode, %count_include_pad, "
+       "%divisor_override"},
+      {"%kernel_size, %stride, %padding, %ceil_mode, %count_include_pad, "
+       "%divisor_override"});
   patterns.emplace_back(adaptive_avg_pool2d_patten);
+  patterns.emplace_back(avg_pool2d_patten);
   patterns.emplace_back(flatten_patten);
   for (const auto& info : patterns) {
     SubgraphRewriter rewriter;
@@ -72,6 +80,9 @@ void IpexQuantFusion(std::shared_ptr<Graph>& graph) {
   }
   graph_rewrite::replaceEmbeddingBagWithQEmbeddingBag(graph);
   graph_rewrite::replaceInteractionWithQInteraction(graph);
+  // the int8 add and concat left out of the LLGA partitions
+  graph_rewrite::replaceAddWithQAdd(graph);
+  graph_rewrite::replaceCatWithQCat(graph);
 }
 
 } // namespace jit
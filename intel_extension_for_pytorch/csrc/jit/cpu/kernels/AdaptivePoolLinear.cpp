@@ -0,0 +1,32 @@
+#include "AdaptivePoolLinear.h"
+#include "csrc/aten/cpu/AdaptiveAveragePooling.h"
+#include "csrc/utils/op_trace.h"
+
+#include <ATen/ATen.h>
+#include <ATen/record_function.h>
+
+namespace torch_ipex {
+namespace cpu {
+
+at::Tensor adaptive_avg_pool_linear_run(
+    const at::Tensor& input,
+    at::IntArrayRef output_size,
+    const c10::intrusive_ptr<LinearOpContext>& op_context) {
+  IPEX_RECORD_FUNCTION(
+      "ipex_prepack::adaptive_avg_pool_linear_run",
+      std::vector<c10::IValue>({}));
+  if (input.dim() != 4) {
+    return op_context->run(
+        at::adaptive_avg_pool2d(input, output_size).flatten(1),
+        ideep::attr_t());
+  }
+  // the pooled output of the size 1x1 is of the layout [N, C] for both the
+  // memory formats, so it is flattened without copy
+  auto pooled = at::empty({0}, input.options());
+  adaptive_avg_pool2d_out_cpu_template(pooled, input, output_size);
+  return op_context->run(
+      pooled.reshape({input.size(0), -1}), ideep::attr_t());
+}
+
+} // namespace cpu
+} // namespace torch_ipex
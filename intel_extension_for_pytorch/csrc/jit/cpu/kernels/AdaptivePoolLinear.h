@@ -0,0 +1,19 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+#include "OpContext.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+// The linear of the flattened adaptive average pooling, i.e. the classifier
+// head of the CNNs. The global pooling of channels last is already the
+// input of the linear, so it is pooled straight into the linear input.
+at::Tensor adaptive_avg_pool_linear_run(
+    const at::Tensor& input,
+    at::IntArrayRef output_size,
+    const c10::intrusive_ptr<LinearOpContext>& op_context);
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -7,6 +7,8 @@
 
 #if defined(CPU_AVX512)
 #include "csrc/cpu/vec512/add_layernorm.h"
+#include "csrc/utils/fast_path_stats.h"
+#include "csrc/utils/op_trace.h"
 #endif
 #include <torch/csrc/autograd/function.h>
 
@@ -74,6 +76,12 @@ at::Tensor AddLayerNorm(
 
 namespace torch_ipex {
 namespace cpu {
+
+// the reasons are in the order of the conditions of dil_add_layernorm
+static fast_path::FastPathCounter add_layernorm_counter(
+    "add_layernorm",
+    {"broadcast", "unaligned", "not_contiguous", "alpha"});
+
 at::Tensor dil_add_layernorm(
     const at::Tensor& a,
     const at::Tensor& b,
@@ -83,9 +91,7 @@ at::Tensor dil_add_layernorm(
     const c10::optional<at::Tensor>& bias_opt,
     float eps,
     bool cuda_enable) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("dil_add_layernorm", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("dil_add_layernorm", std::vector<c10::IValue>({}));
   // no broadcast
   bool no_broadcast = true;
   for (auto i = 0; i < a.ndimension(); i++) {
@@ -99,7 +105,8 @@ at::Tensor dil_add_layernorm(
       b.size(b.ndimension() - 1) % 16 == 0;
   // Only support contiguous tensor
   bool is_contiguous = a.is_contiguous() && b.is_contiguous();
-  if (no_broadcast && aligned_64_bytes && is_contiguous && alpha == 1.0f) {
+  if (add_layernorm_counter.check(
+          {no_broadcast, aligned_64_bytes, is_contiguous, alpha == 1.0f})) {
     return jit::cpu::kernels::AddLayerNorm(
         a, b, alpha, normalized_shape, weight_opt, bias_opt, eps);
   } else {
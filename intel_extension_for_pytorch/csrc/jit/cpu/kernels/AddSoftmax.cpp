@@ -1,33 +1,30 @@
-#include "AddSoftmax.h"
-
-#if defined(CPU_AVX512)
-#include "csrc/cpu/vec512/add_softmax.h"
-#endif
-
-namespace torch_ipex {
-namespace jit {
-namespace cpu {
-namespace kernels {
-
-at::Tensor DivAddSoftmax(
-    at::Tensor& a,
-    const at::Tensor& b,
-    const float& dim_per_head) {
-#if defined(CPU_AVX512)
-  if (a.scalar_type() == at::kFloat && b.scalar_type() == at::kFloat) {
-    return torch_ipex::cpu::kernel::vec::vec512::dil_div_add_softmax<float>(
-        a, b, dim_per_head);
-  } else if (
-      a.scalar_type() == at::kBFloat16 && b.scalar_type() == at::kBFloat16) {
-    return torch_ipex::cpu::kernel::vec::vec512::dil_div_add_softmax<
-        at::BFloat16>(a, b, dim_per_head);
-  }
-#endif
-  a = at::div(a, dim_per_head);
-  return at::softmax(at::add(a, b, 1.0f), -1);
-}
-
-} // namespace kernels
-} // namespace cpu
-} // namespace jit
-} // namespace torch_ipex
+#include "AddSoftmax.h"
+
+namespace torch_ipex {
+namespace jit {
+namespace cpu {
+namespace kernels {
+
+IPEX_DEFINE_DISPATCH(div_add_softmax_kernel_stub);
+
+at::Tensor DivAddSoftmax(
+    at::Tensor& a,
+    const at::Tensor& b,
+    const float& dim_per_head) {
+  // b is only broadcasted in the outer dimensions of a
+  bool fusable = a.dim() >= 2 && b.dim() >= 1 &&
+      a.scalar_type() == b.scalar_type() &&
+      (a.scalar_type() == at::kFloat || a.scalar_type() == at::kBFloat16) &&
+      a.is_contiguous() && b.stride(-1) == 1 && b.size(-1) == a.size(-1) &&
+      at::infer_size(a.sizes(), b.sizes()) == a.sizes();
+  if (fusable) {
+    return div_add_softmax_kernel_stub(a, b, dim_per_head);
+  }
+  a = at::div(a, dim_per_head);
+  return at::softmax(at::add(a, b, 1.0f), -1);
+}
+
+} // namespace kernels
+} // namespace cpu
+} // namespace jit
+} // namespace torch_ipex
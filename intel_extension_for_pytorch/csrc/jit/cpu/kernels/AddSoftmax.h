@@ -1,20 +1,28 @@
-#pragma once
-
-#include <ATen/ATen.h>
-
-namespace torch_ipex {
-namespace jit {
-namespace cpu {
-namespace kernels {
-
-// This operator assumes that the softmax is applied to the last
-// dimension.
-at::Tensor DivAddSoftmax(
-    at::Tensor& a,
-    const at::Tensor& b,
-    const float& dim_per_head);
-
-} // namespace kernels
-} // namespace cpu
-} // namespace jit
-} // namespace torch_ipex
+#pragma once
+
+#include <ATen/ATen.h>
+
+#include "csrc/cpu/dispatch/DispatchStub.h"
+
+namespace torch_ipex {
+namespace jit {
+namespace cpu {
+namespace kernels {
+
+// This operator assumes that the softmax is applied to the last
+// dimension.
+at::Tensor DivAddSoftmax(
+    at::Tensor& a,
+    const at::Tensor& b,
+    const float& dim_per_head);
+
+// softmax(a / dim_per_head + b) of the last dimension of the contiguous float
+// or bfloat16 a and b of the dtype of a, broadcastable to a
+using div_add_softmax_kernel_fn =
+    at::Tensor (*)(const at::Tensor&, const at::Tensor&, float);
+IPEX_DECLARE_DISPATCH(div_add_softmax_kernel_fn, div_add_softmax_kernel_stub);
+
+} // namespace kernels
+} // namespace cpu
+} // namespace jit
+} // namespace torch_ipex
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+#include "csrc/cpu/ideep/ideep.hpp"
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace torch_ipex {
+namespace cpu {
+namespace detail {
+
+// The convolution primitive of the last run of an op context, together with
+// the weight and bias reordered to the formats it expects.
+// A run whose input sizes, dtype, memory format, post ops and number of
+// threads are the same as the cached ones executes the primitive directly,
+// without creating the primitive desc or looking up the global primitive
+// cache. mutex_ must be held to use the cached primitive; a run which can't
+// take it goes through the regular ideep path.
+// Once the primitive is created, finalize() binds its arguments, so that a
+// run of plain src and dst, e.g. of a frozen graph, only sets the data
+// handles of src_ and dst_ and executes the primitive.
+struct CachedConvolutionPrimitive final {
+  std::vector<int64_t> input_sizes_;
+  at::ScalarType input_dtype_;
+  at::MemoryFormat memory_format_;
+  int num_threads_;
+  // post ops and output scales of the attr, as in ideep's primitive key.
+  ideep::utils::bytestring attr_key_;
+  // the attr key of the current run, of which the buffer is reused
+  ideep::utils::bytestring run_attr_key_;
+  bool valid_ = false;
+  // whether the plain views of the input and the output are of the formats
+  // the primitive expects, so that they need no reorder.
+  bool plain_src_dst_ = false;
+
+  // params_.scratchpad is left empty, a run borrows a scratchpad of
+  // scratchpad_desc_ from the ScratchpadArena of its thread.
+  ideep::convolution_forward_params params_;
+  ideep::tensor::desc scratchpad_desc_;
+  dnnl::convolution_forward primitive_;
+  ideep::tensor weight_;
+  ideep::tensor bias_;
+  // the contiguous bias which bias_ may be a view of
+  at::Tensor bias_dense_;
+
+  // of the descs of the primitive, and of no data until a run sets them.
+  dnnl::memory src_;
+  dnnl::memory dst_;
+  // the arguments of the primitive, of which a run sets the scratchpad.
+  std::unordered_map<int, dnnl::memory> args_;
+
+  std::mutex mutex_;
+
+  bool matches(
+      const at::Tensor& input,
+      at::MemoryFormat memory_format,
+      int num_threads,
+      const ideep::utils::bytestring& attr_key) const {
+    return valid_ && input.sizes() == at::IntArrayRef(input_sizes_) &&
+        input.scalar_type() == input_dtype_ &&
+        memory_format == memory_format_ && num_threads == num_threads_ &&
+        attr_key == attr_key_;
+  }
+
+  void finalize() {
+    args_.clear();
+    if (!plain_src_dst_) {
+      return;
+    }
+    const auto& pd = params_.pd;
+    auto& engine = ideep::engine::cpu_engine();
+    src_ = dnnl::memory(pd.src_desc(), engine, DNNL_MEMORY_NONE);
+    dst_ = dnnl::memory(pd.dst_desc(), engine, DNNL_MEMORY_NONE);
+    args_ = {
+        {DNNL_ARG_SRC, src_},
+        {DNNL_ARG_WEIGHTS, weight_},
+        {DNNL_ARG_DST, dst_},
+        {DNNL_ARG_SCRATCHPAD, dnnl::memory()}};
+    if (!bias_.is_empty()) {
+      args_.insert({DNNL_ARG_BIAS, bias_});
+    }
+  }
+};
+
+} // namespace detail
+} // namespace cpu
+} // namespace torch_ipex
@@ -4,21 +4,24 @@
 
 #include "csrc/cpu/ideep/ideep.hpp"
 
+#include <vector>
+
 namespace torch_ipex {
 namespace cpu {
 namespace detail {
 
+// The sizes and params are of 2 spatial dims of deconv2d or 3 of deconv3d.
 struct ContextConvTranspose final {
   ideep::tensor weight_packed_;
   c10::optional<at::Tensor> bias_;
-  std::array<int64_t, 4> weight_size_;
-  std::array<int64_t, 2> padding_;
-  std::array<int64_t, 2> output_padding_;
-  std::array<int64_t, 2> stride_;
-  std::array<int64_t, 2> dilation_;
-  std::array<int64_t, 4> input_size_;
+  std::vector<int64_t> weight_size_;
+  std::vector<int64_t> padding_;
+  std::vector<int64_t> output_padding_;
+  std::vector<int64_t> stride_;
+  std::vector<int64_t> dilation_;
+  std::vector<int64_t> input_size_;
   int64_t groups_;
-  std::array<int64_t, 4> origin_weight_dims_;
+  std::vector<int64_t> origin_weight_dims_;
   bool weight_is_channels_last_;
 
   ContextConvTranspose() = delete;
@@ -26,25 +29,25 @@ struct ContextConvTranspose final {
   ContextConvTranspose(
       ideep::tensor&& weight_packed,
       c10::optional<at::Tensor>&& bias,
-      std::array<int64_t, 4> weight_size,
-      std::array<int64_t, 2> padding,
-      std::array<int64_t, 2> output_padding,
-      std::array<int64_t, 2> stride,
-      std::array<int64_t, 2> dilation,
+      std::vector<int64_t> weight_size,
+      std::vector<int64_t> padding,
+      std::vector<int64_t> output_padding,
+      std::vector<int64_t> stride,
+      std::vector<int64_t> dilation,
       int64_t groups,
-      std::array<int64_t, 4> input_size,
-      std::array<int64_t, 4> origin_weight_dims,
+      std::vector<int64_t> input_size,
+      std::vector<int64_t> origin_weight_dims,
       bool weight_is_channels_last)
       : weight_packed_(std::move(weight_packed)),
         bias_(std::move(bias)),
-        weight_size_(weight_size),
-        padding_(padding),
-        output_padding_(output_padding),
-        stride_(stride),
-        dilation_(dilation),
-        input_size_(input_size),
+        weight_size_(std::move(weight_size)),
+        padding_(std::move(padding)),
+        output_padding_(std::move(output_padding)),
+        stride_(std::move(stride)),
+        dilation_(std::move(dilation)),
+        input_size_(std::move(input_size)),
         groups_(groups),
-        origin_weight_dims_(origin_weight_dims),
+        origin_weight_dims_(std::move(origin_weight_dims)),
         weight_is_channels_last_(weight_is_channels_last) {}
 
   ContextConvTranspose(ContextConvTranspose&&) = default;
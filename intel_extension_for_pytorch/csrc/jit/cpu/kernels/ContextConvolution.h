@@ -2,8 +2,12 @@
 
 #include <ATen/Tensor.h>
 
+#include "CachedConvolutionPrimitive.h"
+#include "PackedWeightVariants.h"
 #include "csrc/cpu/ideep/ideep.hpp"
 
+#include <memory>
+
 namespace torch_ipex {
 namespace cpu {
 namespace detail {
@@ -18,6 +22,13 @@ struct ContextConvolution final {
   std::array<int64_t, 4> input_size_;
   int64_t groups_;
   bool weight_is_channels_last_;
+  // the algorithm weight_packed_ is packed for, of which the runs create the
+  // primitives, see select_conv_algorithm
+  ideep::algorithm algorithm_;
+  // weight_packed_ reordered for the input shapes other than input_size_
+  std::unique_ptr<PackedWeightVariants> weight_variants_;
+  // the primitive of the last run, see CachedConvolutionPrimitive
+  std::unique_ptr<CachedConvolutionPrimitive> cached_primitive_;
 
   ContextConvolution() = delete;
 
@@ -30,7 +41,8 @@ struct ContextConvolution final {
       std::array<int64_t, 2> dilation,
       int64_t groups,
       std::array<int64_t, 4> input_size,
-      bool weight_is_channels_last)
+      bool weight_is_channels_last,
+      ideep::algorithm algorithm = ideep::algorithm::convolution_direct)
       : weight_packed_(std::move(weight_packed)),
         bias_(std::move(bias)),
         weight_size_(weight_size),
@@ -39,7 +51,10 @@ struct ContextConvolution final {
         dilation_(dilation),
         input_size_(input_size),
         groups_(groups),
-        weight_is_channels_last_(weight_is_channels_last) {}
+        weight_is_channels_last_(weight_is_channels_last),
+        algorithm_(algorithm),
+        weight_variants_(std::make_unique<PackedWeightVariants>()),
+        cached_primitive_(std::make_unique<CachedConvolutionPrimitive>()) {}
 
   ContextConvolution(ContextConvolution&&) = default;
   ContextConvolution& operator=(ContextConvolution&&) = default;
@@ -3,6 +3,7 @@
 #include <ATen/Tensor.h>
 
 #include "csrc/cpu/ideep/ideep.hpp"
+#include "csrc/cpu/vec512/int4/vec/int4_vec_kernel.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -10,12 +11,89 @@ namespace detail {
 struct ContextLinear final {
   ideep::tensor weight_packed_;
   c10::optional<at::Tensor> bias_;
+  // The int8 weight of the weight-only quantized linear, undefined otherwise.
+  // weight_packed_ is empty in this case.
+  at::Tensor weight_int8_;
+  // The packed 4-bit weight of the weight-only quantized linear of
+  // int4_vec_kernel.h, undefined otherwise. weight_packed_ is empty in this
+  // case, and weight_scales_ are the scales of the groups of
+  // weight_group_size_ input features of each output channel.
+  at::Tensor weight_int4_;
+  Int4Format weight_int4_format_ = Int4Format::INT4;
+  int64_t weight_group_size_ = 0;
+  // The per-channel scales of the weight of the quantized linear.
+  at::Tensor weight_scales_;
+  // The sum of each weight row times its scale of the dynamic quantized
+  // linear, undefined otherwise. weight_packed_ is the packed s8 weight with
+  // the reciprocals of the scales in this case.
+  at::Tensor weight_compensation_;
+  // The weight of SparseLinear.h of the block-sparse linear, undefined
+  // otherwise. weight_packed_ is empty in this case, and the output channels
+  // of the weight are padded to the blocks.
+  at::Tensor weight_sparse_values_;
+  at::Tensor weight_sparse_indices_;
+  at::Tensor weight_sparse_offsets_;
+  int64_t weight_sparse_out_features_ = 0;
 
   ContextLinear() = delete;
 
   ContextLinear(ideep::tensor&& weight_packed, c10::optional<at::Tensor>&& bias)
       : weight_packed_(std::move(weight_packed)), bias_(std::move(bias)) {}
 
+  ContextLinear(
+      at::Tensor&& weight_int8,
+      at::Tensor&& weight_scales,
+      c10::optional<at::Tensor>&& bias)
+      : bias_(std::move(bias)),
+        weight_int8_(std::move(weight_int8)),
+        weight_scales_(std::move(weight_scales)) {}
+
+  ContextLinear(
+      at::Tensor&& weight_int4,
+      Int4Format weight_int4_format,
+      int64_t weight_group_size,
+      at::Tensor&& weight_scales,
+      c10::optional<at::Tensor>&& bias)
+      : bias_(std::move(bias)),
+        weight_int4_(std::move(weight_int4)),
+        weight_int4_format_(weight_int4_format),
+        weight_group_size_(weight_group_size),
+        weight_scales_(std::move(weight_scales)) {}
+
+  ContextLinear(
+      ideep::tensor&& weight_packed,
+      at::Tensor&& weight_scales,
+      at::Tensor&& weight_compensation,
+      c10::optional<at::Tensor>&& bias)
+      : weight_packed_(std::move(weight_packed)),
+        bias_(std::move(bias)),
+        weight_scales_(std::move(weight_scales)),
+        weight_compensation_(std::move(weight_compensation)) {}
+
+  ContextLinear(
+      at::Tensor&& weight_sparse_values,
+      at::Tensor&& weight_sparse_indices,
+      at::Tensor&& weight_sparse_offsets,
+      int64_t weight_sparse_out_features,
+      c10::optional<at::Tensor>&& bias)
+      : bias_(std::move(bias)),
+        weight_sparse_values_(std::move(weight_sparse_values)),
+        weight_sparse_indices_(std::move(weight_sparse_indices)),
+        weight_sparse_offsets_(std::move(weight_sparse_offsets)),
+        weight_sparse_out_features_(weight_sparse_out_features) {}
+
+  bool is_block_sparse() const {
+    return weight_sparse_values_.defined();
+  }
+
+  bool is_weight_only_quantized() const {
+    return weight_int8_.defined() || weight_int4_.defined();
+  }
+
+  bool is_dynamic_quantized() const {
+    return weight_compensation_.defined();
+  }
+
   ContextLinear(ContextLinear&&) = default;
   ContextLinear& operator=(ContextLinear&&) = default;
 
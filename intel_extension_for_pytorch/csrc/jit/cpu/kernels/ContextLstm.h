@@ -0,0 +1,68 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+#include "PackedWeightVariants.h"
+#include "csrc/cpu/ideep/ideep.hpp"
+
+#include <memory>
+
+namespace torch_ipex {
+namespace cpu {
+namespace detail {
+
+struct ContextLstm final {
+  // The weights and the bias (bias_ih + bias_hh) of each layer and direction,
+  // at index layer * num_directions + direction. The weights are packed for
+  // the input of seq_length_ and mini_batch_.
+  std::vector<ideep::tensor> weights_ih_packed_;
+  std::vector<ideep::tensor> weights_hh_packed_;
+  std::vector<at::Tensor> biases_;
+  // The weights of each layer and direction packed for the other input
+  // shapes, keyed by the shape and by weight_ih (0) or weight_hh (1), and the
+  // [weight_ih, weight_hh] of the fused cell packed for the inner product of
+  // the small batch of one step, keyed by {1, mini_batch, 2}.
+  std::vector<std::unique_ptr<PackedWeightVariants>> weight_variants_;
+  int64_t seq_length_;
+  int64_t mini_batch_;
+  int64_t hidden_size_;
+  int64_t num_layers_;
+  bool bidirectional_;
+  bool batch_first_;
+
+  ContextLstm() = delete;
+
+  ContextLstm(
+      std::vector<ideep::tensor>&& weights_ih_packed,
+      std::vector<ideep::tensor>&& weights_hh_packed,
+      std::vector<at::Tensor>&& biases,
+      int64_t seq_length,
+      int64_t mini_batch,
+      int64_t hidden_size,
+      int64_t num_layers,
+      bool bidirectional,
+      bool batch_first)
+      : weights_ih_packed_(std::move(weights_ih_packed)),
+        weights_hh_packed_(std::move(weights_hh_packed)),
+        biases_(std::move(biases)),
+        seq_length_(seq_length),
+        mini_batch_(mini_batch),
+        hidden_size_(hidden_size),
+        num_layers_(num_layers),
+        bidirectional_(bidirectional),
+        batch_first_(batch_first) {
+    for (size_t i = 0; i < weights_ih_packed_.size(); i++) {
+      weight_variants_.push_back(std::make_unique<PackedWeightVariants>(
+          3 * PackedWeightVariants::kDefaultCapacity));
+    }
+  }
+
+  ContextLstm(ContextLstm&&) = default;
+  ContextLstm& operator=(ContextLstm&&) = default;
+
+  ~ContextLstm() {}
+};
+
+} // namespace detail
+} // namespace cpu
+} // namespace torch_ipex
@@ -1,9 +1,19 @@
 #include "ConvPacked.h"
+#include "ScratchpadArena.h"
 #include "csrc/aten/cpu/Conv.h"
 #include "csrc/aten/cpu/ParamUtils.h"
+#include "csrc/aten/cpu/PackedWeightSerialization.h"
 #include "csrc/aten/cpu/WeightPack.h"
 #include "csrc/cpu/ideep/IDeepConversions.h"
 #include "csrc/cpu/ideep/ideep.hpp"
+#include "csrc/quantization/auto_opt_config.hpp"
+#include "csrc/utils/op_trace.h"
+
+#include <omp.h>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <unordered_map>
 
 namespace torch_ipex {
 namespace cpu {
@@ -22,11 +32,9 @@ c10::intrusive_ptr<ConvolutionOpContext> createConvolutionPrePackOpContext(
     bool weight_is_channels_last,
     bool weight_is_packed,
     std::vector<int64_t>&& input_size) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "ipex_prepack::createConvolutionPrePackOpContext",
       std::vector<c10::IValue>({}));
-#endif
   return IpexConvolutionOpContext::create_context(
       std::move(weight),
       std::move(bias),
@@ -44,30 +52,24 @@ c10::intrusive_ptr<ConvolutionOpContext> createConvolutionPrePackOpContext(
 at::Tensor convolution_run(
     const at::Tensor& input,
     const c10::intrusive_ptr<ConvolutionOpContext>& op_context) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "ipex_prepack::convolution_run", std::vector<c10::IValue>({}));
-#endif
   return op_context->run(input, ideep::attr_t());
 }
 
 at::Tensor convolution_relu_run(
     const at::Tensor& input,
     const c10::intrusive_ptr<ConvolutionOpContext>& op_context) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "ipex_prepack::convolution_relu_run", std::vector<c10::IValue>({}));
-#endif
   return op_context->run(input, ideep::attr_t::fuse_relu());
 }
 
 at::Tensor convolution_sigmoid_run(
     const at::Tensor& input,
     const c10::intrusive_ptr<ConvolutionOpContext>& op_context) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "ipex_prepack::convolution_sigmoid_run", std::vector<c10::IValue>({}));
-#endif
   return op_context->run(input, ideep::attr_t::fuse_sigmoid());
 }
 
@@ -76,10 +78,8 @@ at::Tensor convolution_hardtanh_run(
     at::Scalar lower_bound,
     at::Scalar upper_bound,
     const c10::intrusive_ptr<ConvolutionOpContext>& op_context) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "ipex_prepack::convolution_hardtanh_run", std::vector<c10::IValue>({}));
-#endif
   auto lower_bound_value = lower_bound.to<float>();
   auto upper_bound_value = upper_bound.to<float>();
   return op_context->run(
@@ -92,10 +92,8 @@ at::Tensor convolution_elu_run(
     at::Scalar scale,
     at::Scalar input_scale,
     const c10::intrusive_ptr<ConvolutionOpContext>& op_context) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "ipex_prepack::convolution_elu_run", std::vector<c10::IValue>({}));
-#endif
   auto alpha_value = alpha.to<float>();
   auto scale_value = scale.to<float>();
   auto input_scale_value = input_scale.to<float>();
@@ -107,10 +105,8 @@ at::Tensor convolution_elu_run(
 at::Tensor convolution_swish_run(
     const at::Tensor& input,
     const c10::intrusive_ptr<ConvolutionOpContext>& op_context) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "ipex_prepack::convolution_swish_run", std::vector<c10::IValue>({}));
-#endif
   return op_context->run(input, ideep::attr_t::fuse_swish());
 }
 
@@ -119,10 +115,8 @@ at::Tensor convolution_add_run(
     at::Tensor& accumu,
     const c10::optional<at::Scalar>& alpha,
     const c10::intrusive_ptr<ConvolutionOpContext>& op_context) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "ipex_prepack::convolution_add_run", std::vector<c10::IValue>({}));
-#endif
   auto scale = alpha.has_value() ? alpha.value().to<float>() : 1.0;
   return op_context->run(input, accumu, ideep::attr_t::fuse_sum(scale));
 }
@@ -132,14 +126,148 @@ at::Tensor convolution_add_relu_run(
     at::Tensor& accumu,
     const c10::optional<at::Scalar>& alpha,
     const c10::intrusive_ptr<ConvolutionOpContext>& op_context) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "ipex_prepack::convolution_add_relu_run", std::vector<c10::IValue>({}));
-#endif
   auto scale = alpha.has_value() ? alpha.value().to<float>() : 1.0;
   return op_context->run(input, accumu, ideep::attr_t::residual(scale));
 }
 
+// the fewest output pixels of the 3x3 convolutions of which the winograd
+// algorithm is timed, as of the first stage of ResNet-50
+constexpr int64_t kWinogradMinOutputPixels = 56 * 56;
+constexpr int kAlgorithmWarmupIters = 2;
+constexpr int kAlgorithmMeasureIters = 5;
+
+// Whether oneDNN may run the convolution by winograd F(4, 3), i.e. it is a
+// fp32 3x3 convolution of stride and dilation 1 without groups, of an output
+// large enough for the saved FLOPs to pay for the transforms.
+static bool is_winograd_candidate(
+    const at::Tensor& weight,
+    at::IntArrayRef kernel_size,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef dilation,
+    int64_t groups,
+    at::IntArrayRef input_size) {
+  if (weight.scalar_type() != at::kFloat ||
+      is_serialized_packed_weight(weight) || kernel_size.size() != 2 ||
+      input_size.size() != 4 || groups != 1) {
+    return false;
+  }
+  for (size_t d = 0; d < 2; d++) {
+    if (kernel_size[d] != 3 || stride[d] != 1 || dilation[d] != 1) {
+      return false;
+    }
+  }
+  return (input_size[2] + 2 * padding[0] - 2) *
+      (input_size[3] + 2 * padding[1] - 2) >=
+      kWinogradMinOutputPixels;
+}
+
+// the average seconds of a run of the convolution of input into output by
+// aalgorithm
+static double time_convolution(
+    const at::Tensor& input,
+    const ideep::tensor& weight,
+    const c10::optional<at::Tensor>& bias,
+    at::Tensor& output,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef dilation,
+    int64_t groups,
+    ideep::algorithm aalgorithm) {
+  auto run_once = [&]() {
+    convolution_kernel_output(
+        input,
+        weight,
+        bias,
+        output,
+        stride,
+        padding,
+        dilation,
+        groups,
+        ideep::attr_t(),
+        aalgorithm);
+  };
+  for (int i = 0; i < kAlgorithmWarmupIters; i++) {
+    run_once();
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kAlgorithmMeasureIters; i++) {
+    run_once();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  return elapsed.count() / kAlgorithmMeasureIters;
+}
+
+// Times the winograd algorithm against the direct one of packed_weight on
+// input_size, and returns the faster. packed_weight is replaced by the weight
+// packed for winograd if it wins. The direct one is kept if oneDNN has no
+// winograd implementation of the shape on this CPU, e.g. without AVX512.
+static ideep::algorithm select_conv_algorithm(
+    const at::Tensor& weight,
+    const c10::optional<at::Tensor>& bias,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef dilation,
+    at::IntArrayRef weight_size,
+    int64_t groups,
+    bool weight_is_channels_last,
+    bool weight_is_packed,
+    at::IntArrayRef input_size,
+    ideep::tensor& packed_weight) {
+  auto memory_format = weight_is_channels_last ? at::MemoryFormat::ChannelsLast
+                                               : at::MemoryFormat::Contiguous;
+  auto options = at::TensorOptions(at::kFloat).memory_format(memory_format);
+  auto input = at::empty(input_size, options).uniform_();
+  auto output = at::empty(
+      calc_conv_output_size(input_size, weight_size, padding, stride, dilation),
+      options);
+  try {
+    ideep::tensor winograd_weight = get_conv_packed_weight(
+        weight,
+        stride,
+        padding,
+        dilation,
+        weight_size,
+        groups,
+        weight_is_channels_last,
+        weight_is_packed,
+        weight_is_channels_last,
+        input_size,
+        ideep::attr_t(),
+        ideep::algorithm::convolution_winograd);
+    double winograd_time = time_convolution(
+        input,
+        winograd_weight,
+        bias,
+        output,
+        stride,
+        padding,
+        dilation,
+        groups,
+        ideep::algorithm::convolution_winograd);
+    double direct_time = time_convolution(
+        input,
+        packed_weight,
+        bias,
+        output,
+        stride,
+        padding,
+        dilation,
+        groups,
+        ideep::algorithm::convolution_direct);
+    if (winograd_time < direct_time) {
+      packed_weight = std::move(winograd_weight);
+      return ideep::algorithm::convolution_winograd;
+    }
+  } catch (const std::exception&) {
+    // no winograd primitive of the shape
+  }
+  return ideep::algorithm::convolution_direct;
+}
+
 ContextConvolution create(
     const at::Tensor& weight,
     const c10::optional<at::Tensor>& bias,
@@ -157,15 +285,19 @@ ContextConvolution create(
   const auto dilation_expanded =
       expand_param_if_needed(dilation, "dilation", 2);
 
+  // The serialized packed weight keeps weight_is_channels_last of the saved
+  // op context.
+  bool weight_is_plain =
+      !weight_is_packed && !is_serialized_packed_weight(weight);
   bool weight_is_channels_last_ = weight_is_channels_last;
-  if (!weight_is_packed) {
+  if (weight_is_plain) {
     weight_is_channels_last_ =
         weight.suggest_memory_format() == at::MemoryFormat::ChannelsLast;
   }
   auto memory_format = weight_is_channels_last_ ? at::MemoryFormat::ChannelsLast
                                                 : at::MemoryFormat::Contiguous;
   auto weight_ = weight;
-  if (!weight_is_packed) {
+  if (weight_is_plain) {
     weight_ = weight.contiguous(memory_format);
   }
 
@@ -188,6 +320,29 @@ ContextConvolution create(
       weight_is_channels_last_,
       input_size,
       ideep::attr_t());
+  auto algorithm = ideep::algorithm::convolution_direct;
+  if (AutoOptConfig::singleton().get_conv_algorithm_selection() &&
+      is_winograd_candidate(
+          weight_,
+          kernel_size,
+          stride_expanded,
+          padding_expanded,
+          dilation_expanded,
+          groups,
+          input_size)) {
+    algorithm = select_conv_algorithm(
+        weight_,
+        bias,
+        stride_expanded,
+        padding_expanded,
+        dilation_expanded,
+        origin_weight_dims,
+        groups,
+        weight_is_channels_last_,
+        weight_is_packed,
+        input_size,
+        packed_weight);
+  }
 
   return ContextConvolution{
       std::move(packed_weight),
@@ -198,7 +353,205 @@ ContextConvolution create(
       {dilation_expanded[0], dilation_expanded[1]},
       groups,
       {input_size[0], input_size[1], input_size[2], input_size[3]},
-      weight_is_channels_last_};
+      weight_is_channels_last_,
+      algorithm};
+}
+
+// The algorithm of the run of input, context.algorithm_ for the input shape it
+// is selected on, otherwise the direct one, of which oneDNN implements all the
+// shapes.
+static ideep::algorithm get_algorithm(
+    const ContextConvolution& context,
+    const at::Tensor& input) {
+  return input.sizes() == at::IntArrayRef(context.input_size_)
+      ? context.algorithm_
+      : ideep::algorithm::convolution_direct;
+}
+
+// Get the packed weight in the format preferred by the shape of input. The
+// weight packed for another shape is kept in context.weight_variants_, so that
+// the recurring shapes don't reorder the weight on every call.
+static ideep::tensor get_packed_weight(
+    const ContextConvolution& context,
+    const at::Tensor& input,
+    bool use_channels_last) {
+  auto input_size = input.sizes();
+  if (use_channels_last == context.weight_is_channels_last_ &&
+      input_size == at::IntArrayRef(context.input_size_)) {
+    return context.weight_packed_;
+  }
+  std::vector<int64_t> key(input_size.begin(), input_size.end());
+  key.push_back(use_channels_last);
+  return context.weight_variants_->get(key, [&]() {
+    // original weight dims
+    std::vector<int64_t> weight_size = {
+        context.weight_size_[0],
+        context.weight_size_[1] / context.groups_,
+        context.weight_size_[2],
+        context.weight_size_[3]};
+    return get_conv_packed_weight_for_input(
+        context.weight_packed_,
+        context.stride_,
+        context.padding_,
+        context.dilation_,
+        weight_size,
+        context.groups_,
+        use_channels_last,
+        input_size,
+        ideep::attr_t(),
+        get_algorithm(context, input));
+  });
+}
+
+// Compute the convolution of input into output. The primitive of the last run
+// is kept in context.cached_primitive_, so that a run of the same shape and
+// attr executes it directly. A run which misses the cached primitive replaces
+// it, and a run which can't take it, e.g. of another thread running the same
+// op context, computes through ideep as convolution_kernel_output.
+static void compute_with_cached_primitive(
+    const ContextConvolution& context,
+    const at::Tensor& input,
+    bool use_channels_last,
+    at::Tensor& output,
+    const ideep::attr_t& attr) {
+  auto& cache = *context.cached_primitive_;
+  std::unique_lock<std::mutex> lock(cache.mutex_, std::try_to_lock);
+  if (!lock.owns_lock()) {
+    convolution_kernel_output(
+        input,
+        get_packed_weight(context, input, use_channels_last),
+        context.bias_,
+        output,
+        context.stride_,
+        context.padding_,
+        context.dilation_,
+        context.groups_,
+        attr,
+        get_algorithm(context, input));
+    return;
+  }
+  auto memory_format = use_channels_last ? at::MemoryFormat::ChannelsLast
+                                         : at::MemoryFormat::Contiguous;
+  int num_threads = omp_get_max_threads();
+  auto& attr_key = cache.run_attr_key_;
+  attr_key.clear();
+  attr.to_bytes(attr_key);
+  if (cache.matches(input, memory_format, num_threads, attr_key) &&
+      cache.plain_src_dst_) {
+    // the arguments are bound by finalize(), only the data handles are set
+    cache.src_.set_data_handle(input.data_ptr());
+    cache.dst_.set_data_handle(output.data_ptr());
+    cache.args_[DNNL_ARG_SCRATCHPAD] =
+        ScratchpadArena::get(cache.scratchpad_desc_);
+    cache.primitive_.execute(ideep::stream::default_stream(), cache.args_);
+    return;
+  }
+  const ideep::tensor mkldnn_input = itensor_view_from_dense(input);
+  ideep::tensor mkldnn_output = itensor_view_from_dense(output);
+  bool with_bias = context.bias_.has_value() && context.bias_->defined();
+  if (!cache.matches(input, memory_format, num_threads, attr_key)) {
+    cache.valid_ = false;
+    auto weight = get_packed_weight(context, input, use_channels_last);
+    auto algorithm = get_algorithm(context, input);
+    auto output_sizes = output.sizes();
+    ideep::dims dst_dims(output_sizes.begin(), output_sizes.end());
+    ideep::dims strides(context.stride_.begin(), context.stride_.end());
+    ideep::dims dilates(context.dilation_.begin(), context.dilation_.end());
+    ideep::dims padding(context.padding_.begin(), context.padding_.end());
+    ideep::tensor mkldnn_bias;
+    if (with_bias) {
+      cache.bias_dense_ = context.bias_->contiguous();
+      mkldnn_bias = itensor_view_from_dense(cache.bias_dense_);
+      ideep::convolution_forward::prepare(
+          cache.params_,
+          mkldnn_input,
+          weight,
+          mkldnn_bias,
+          dst_dims,
+          mkldnn_output,
+          strides,
+          dilates,
+          padding,
+          padding,
+          context.groups_,
+          ideep::scale_t(),
+          ideep::scale_t(),
+          ideep::scale_t(),
+          attr,
+          algorithm);
+    } else {
+      ideep::convolution_forward::prepare(
+          cache.params_,
+          mkldnn_input,
+          weight,
+          dst_dims,
+          mkldnn_output,
+          strides,
+          dilates,
+          padding,
+          padding,
+          context.groups_,
+          ideep::scale_t(),
+          ideep::scale_t(),
+          ideep::scale_t(),
+          attr,
+          algorithm);
+    }
+    auto& pd = cache.params_.pd;
+    // reorder the weight and the bias once, as convolution_forward::compute
+    // would do on every call.
+    if (!weight.get_desc().is_plain() &&
+        weight.get_desc() != pd.weights_desc()) {
+      cache.weight_ = weight.to_public(nullptr, weight.get_data_type())
+                          .reorder_if_differ_in(pd.weights_desc());
+    } else {
+      cache.weight_ = weight.make_grouped_weights(context.groups_)
+                          .reorder_if_differ_in(pd.weights_desc());
+    }
+    if (with_bias) {
+      cache.bias_ = mkldnn_bias.reorder_if_differ_in(
+          pd.bias_desc(), cache.params_.bias_attr);
+    } else {
+      cache.bias_dense_ = at::Tensor();
+      cache.bias_ = ideep::tensor();
+    }
+    cache.primitive_ = dnnl::convolution_forward(pd);
+    // the runs borrow the scratchpad of the thread's arena instead.
+    cache.scratchpad_desc_ = pd.scratchpad_desc();
+    cache.params_.scratchpad = ideep::tensor();
+    cache.plain_src_dst_ = mkldnn_input.get_desc() == pd.src_desc() &&
+        mkldnn_output.get_desc() == pd.dst_desc();
+    cache.input_sizes_ = input.sizes().vec();
+    cache.input_dtype_ = input.scalar_type();
+    cache.memory_format_ = memory_format;
+    cache.num_threads_ = num_threads;
+    cache.attr_key_ = attr_key;
+    cache.finalize();
+    cache.valid_ = true;
+  }
+
+  auto scratchpad = ScratchpadArena::get(cache.scratchpad_desc_);
+  if (!cache.plain_src_dst_) {
+    // the input or the output needs a reorder, which ideep takes care of.
+    cache.params_.scratchpad = scratchpad;
+    if (with_bias) {
+      ideep::convolution_forward::compute(
+          cache.params_,
+          mkldnn_input,
+          cache.weight_,
+          cache.bias_,
+          mkldnn_output);
+    } else {
+      ideep::convolution_forward::compute(
+          cache.params_, mkldnn_input, cache.weight_, mkldnn_output);
+    }
+    cache.params_.scratchpad = ideep::tensor();
+    return;
+  }
+  cache.src_.set_data_handle(mkldnn_input.get_data_handle());
+  cache.dst_.set_data_handle(mkldnn_output.get_data_handle());
+  cache.args_[DNNL_ARG_SCRATCHPAD] = scratchpad;
+  cache.primitive_.execute(ideep::stream::default_stream(), cache.args_);
 }
 
 at::Tensor run(
@@ -211,15 +564,17 @@ at::Tensor run(
   auto memory_format = use_channels_last ? at::MemoryFormat::ChannelsLast
                                          : at::MemoryFormat::Contiguous;
   auto input_ = input.contiguous(memory_format);
-  return convolution_kernel(
-      input_,
-      context.weight_packed_,
-      context.bias_,
-      context.stride_,
+  auto output_sizes = calc_conv_output_size(
+      input_.sizes(),
+      context.weight_size_,
       context.padding_,
-      context.dilation_,
-      context.groups_,
-      attr);
+      context.stride_,
+      context.dilation_);
+  auto output =
+      at::empty(output_sizes, input_.options().memory_format(memory_format));
+  compute_with_cached_primitive(
+      context, input_, use_channels_last, output, attr);
+  return output;
 }
 
 at::Tensor& run(
@@ -235,16 +590,8 @@ at::Tensor& run(
   auto input_ = input.contiguous(memory_format);
   // always align accumu format with inputs' format.
   accumu = accumu.contiguous(memory_format);
-  convolution_kernel_output(
-      input_,
-      context.weight_packed_,
-      context.bias_,
-      accumu,
-      context.stride_,
-      context.padding_,
-      context.dilation_,
-      context.groups_,
-      attr);
+  compute_with_cached_primitive(
+      context, input_, use_channels_last, accumu, attr);
   return accumu;
 }
 
@@ -1,9 +1,11 @@
 #include "ConvTransposePacked.h"
 #include "csrc/aten/cpu/ConvTranspose.h"
 #include "csrc/aten/cpu/ParamUtils.h"
+#include "csrc/aten/cpu/PackedWeightSerialization.h"
 #include "csrc/aten/cpu/WeightPack.h"
 #include "csrc/cpu/ideep/IDeepConversions.h"
 #include "csrc/cpu/ideep/ideep.hpp"
+#include "csrc/utils/op_trace.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -23,11 +25,9 @@ c10::intrusive_ptr<ConvTransposeOpContext> createConvTransposePrePackOpContext(
     bool weight_is_channels_last,
     bool weight_is_packed,
     std::vector<int64_t>&& input_size) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "ipex_prepack::createConvTransposePrePackOpContext",
       std::vector<c10::IValue>({}));
-#endif
   return IpexConvTransposeOpContext::create_context(
       std::move(weight),
       std::move(bias),
@@ -46,13 +46,26 @@ c10::intrusive_ptr<ConvTransposeOpContext> createConvTransposePrePackOpContext(
 at::Tensor conv_transpose2d_run(
     const at::Tensor& input,
     const c10::intrusive_ptr<ConvTransposeOpContext>& op_context) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "ipex_prepack::conv_transpose2d_run", std::vector<c10::IValue>({}));
-#endif
   return op_context->run(input, ideep::attr_t());
 }
 
+at::Tensor conv_transpose3d_run(
+    const at::Tensor& input,
+    const c10::intrusive_ptr<ConvTransposeOpContext>& op_context) {
+  IPEX_RECORD_FUNCTION(
+      "ipex_prepack::conv_transpose3d_run", std::vector<c10::IValue>({}));
+  return op_context->run(input, ideep::attr_t());
+}
+
+// the channels last format of the 4-d input of deconv2d or the 5-d one of
+// deconv3d
+static at::MemoryFormat channels_last_format(int64_t dim) {
+  return dim == 5 ? at::MemoryFormat::ChannelsLast3d
+                  : at::MemoryFormat::ChannelsLast;
+}
+
 ContextConvTranspose create(
     const at::Tensor& weight,
     const c10::optional<at::Tensor>& bias,
@@ -66,29 +79,37 @@ ContextConvTranspose create(
     const bool weight_is_channels_last,
     const bool weight_is_packed,
     const at::IntArrayRef input_size) {
-  const auto stride_expanded = expand_param_if_needed(stride, "stride", 2);
-  const auto padding_expanded = expand_param_if_needed(padding, "padding", 2);
+  // 2 of deconv2d or 3 of deconv3d
+  const int64_t spatial_dims = kernel_size.size();
+  const auto stride_expanded =
+      expand_param_if_needed(stride, "stride", spatial_dims);
+  const auto padding_expanded =
+      expand_param_if_needed(padding, "padding", spatial_dims);
   const auto output_padding_expanded =
-      expand_param_if_needed(output_padding, "output_padding", 2);
+      expand_param_if_needed(output_padding, "output_padding", spatial_dims);
   const auto dilation_expanded =
-      expand_param_if_needed(dilation, "dilation", 2);
+      expand_param_if_needed(dilation, "dilation", spatial_dims);
+  const auto channels_last = channels_last_format(spatial_dims + 2);
 
+  // The serialized packed weight keeps weight_is_channels_last of the saved
+  // op context.
+  bool weight_is_plain =
+      !weight_is_packed && !is_serialized_packed_weight(weight);
   bool weight_is_channels_last_ = weight_is_channels_last;
 
-  if (!weight_is_packed) {
-    weight_is_channels_last_ =
-        weight.suggest_memory_format() == at::MemoryFormat::ChannelsLast;
+  if (weight_is_plain) {
+    weight_is_channels_last_ = weight.suggest_memory_format() == channels_last;
   }
-  auto memory_format = weight_is_channels_last_ ? at::MemoryFormat::ChannelsLast
-                                                : at::MemoryFormat::Contiguous;
+  auto memory_format =
+      weight_is_channels_last_ ? channels_last : at::MemoryFormat::Contiguous;
   auto weight_ = weight;
-  if (!weight_is_packed) {
+  if (weight_is_plain) {
     weight_ = weight.contiguous(memory_format);
   }
 
   // get original weight dims.
   std::vector<int64_t> origin_weight_dims;
-  if (weight_is_packed) {
+  if (!weight_is_plain) {
     origin_weight_dims.push_back(input_size[1]);
     origin_weight_dims.push_back(output_channel / groups);
     for (auto& s : kernel_size) {
@@ -113,20 +134,20 @@ ContextConvTranspose create(
       input_size,
       ideep::attr_t());
 
+  std::vector<int64_t> weight_size = {output_channel, input_size[1]};
+  weight_size.insert(weight_size.end(), kernel_size.begin(), kernel_size.end());
+
   return ContextConvTranspose{
       std::move(packed_weight),
       bias.has_value() ? c10::make_optional(*bias) : c10::nullopt,
-      {output_channel, input_size[1], kernel_size[0], kernel_size[1]},
-      {padding_expanded[0], padding_expanded[1]},
-      {output_padding_expanded[0], output_padding_expanded[1]},
-      {stride_expanded[0], stride_expanded[1]},
-      {dilation_expanded[0], dilation_expanded[1]},
+      std::move(weight_size),
+      padding_expanded,
+      output_padding_expanded,
+      stride_expanded,
+      dilation_expanded,
       groups,
-      {input_size[0], input_size[1], input_size[2], input_size[3]},
-      {origin_weight_dims[0],
-       origin_weight_dims[1],
-       origin_weight_dims[2],
-       origin_weight_dims[3]},
+      input_size.vec(),
+      std::move(origin_weight_dims),
       weight_is_channels_last_};
 }
 
@@ -134,11 +155,11 @@ at::Tensor run(
     const ContextConvTranspose& context,
     const at::Tensor& input,
     const ideep::attr_t& attr) {
-  bool use_channels_last =
-      input.suggest_memory_format() == at::MemoryFormat::ChannelsLast ||
+  const auto channels_last = channels_last_format(input.dim());
+  bool use_channels_last = input.suggest_memory_format() == channels_last ||
       context.weight_is_channels_last_;
-  auto memory_format = use_channels_last ? at::MemoryFormat::ChannelsLast
-                                         : at::MemoryFormat::Contiguous;
+  auto memory_format =
+      use_channels_last ? channels_last : at::MemoryFormat::Contiguous;
   auto input_ = input.contiguous(memory_format);
 
   return conv_transpose2d_kernel_impl(
@@ -29,6 +29,10 @@ at::Tensor conv_transpose2d_run(
     const at::Tensor& input,
     const c10::intrusive_ptr<ConvTransposeOpContext>& op_context);
 
+at::Tensor conv_transpose3d_run(
+    const at::Tensor& input,
+    const c10::intrusive_ptr<ConvTransposeOpContext>& op_context);
+
 ContextConvTranspose create(
     const at::Tensor& weight,
     const c10::optional<at::Tensor>& bias,
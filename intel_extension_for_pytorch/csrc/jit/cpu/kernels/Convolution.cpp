@@ -12,6 +12,7 @@
 #include <limits>
 
 #include "csrc/cpu/ideep/ideep.hpp"
+#include "csrc/utils/op_trace.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -24,9 +25,7 @@ at::Tensor dil_convolution_base(
     at::IntArrayRef padding,
     at::IntArrayRef dilation,
     int64_t groups) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("dil_convolution_base", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("dil_convolution_base", std::vector<c10::IValue>({}));
   return convolution_impl(
       input, weight, bias, stride, padding, dilation, groups, ideep::attr_t());
 }
@@ -39,9 +38,7 @@ at::Tensor dil_convolution_relu(
     at::IntArrayRef padding,
     at::IntArrayRef dilation,
     int64_t groups) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("dil_convolution_relu", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("dil_convolution_relu", std::vector<c10::IValue>({}));
   return convolution_impl(
       input,
       weight,
@@ -63,9 +60,7 @@ at::Tensor& dil_convolution_sum(
     int64_t groups,
     at::Tensor& accumu,
     at::Scalar alpha) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("dil_convolution_sum", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("dil_convolution_sum", std::vector<c10::IValue>({}));
   auto scale = alpha.to<float>();
   convolution_inplace_impl(
       input,
@@ -90,9 +85,8 @@ at::Tensor& dil_convolution_sum_relu(
     int64_t groups,
     at::Tensor& accumu,
     at::Scalar alpha) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("dil_convolution_sum_relu", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION(
+      "dil_convolution_sum_relu", std::vector<c10::IValue>({}));
   auto scale = alpha.to<float>();
   convolution_inplace_impl(
       input,
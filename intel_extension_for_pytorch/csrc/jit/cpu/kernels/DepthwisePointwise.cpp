@@ -0,0 +1,282 @@
+#include "DepthwisePointwise.h"
+#include "EltwisePostOp.h"
+#include "csrc/aten/cpu/DepthwiseConv.h"
+#include "csrc/utils/fast_path_stats.h"
+#include "csrc/utils/op_trace.h"
+
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/record_function.h>
+
+#include <algorithm>
+
+namespace torch_ipex {
+namespace cpu {
+
+IPEX_DEFINE_DISPATCH(depthwise_conv_kernel_stub);
+
+namespace {
+
+// The bytes of the depthwise output of a block per thread, which is written
+// into and read from the cache of the threads, as of the FFN blocks of
+// linear_gelu_linear_run.
+constexpr int64_t kDwPwBlockBytesPerThread = 256 * 1024;
+
+enum DepthwisePointwiseFallback {
+  kUnsupportedDtype,
+  kNotChannelsLast,
+  kNotDepthwise,
+  kNotPointwise,
+  kUnsupportedEltwise,
+};
+
+static fast_path::FastPathCounter depthwise_pointwise_counter(
+    "convolution_depthwise_pointwise",
+    {"unsupported_dtype",
+     "not_channels_last",
+     "not_depthwise",
+     "not_pointwise",
+     "unsupported_eltwise"});
+
+bool parse_activation(
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    DepthwiseConvParams& params) {
+  if (eltwise == "relu") {
+    // of no negative slope
+    params.activation = DepthwiseActivation::kRelu;
+    return !alpha.has_value() || alpha.value().to<float>() == 0.f;
+  }
+  if (eltwise == "clamp") {
+    params.activation = DepthwiseActivation::kClamp;
+    params.min = alpha.has_value() ? alpha.value().to<float>() : 0.f;
+    params.max = beta.has_value() ? beta.value().to<float>() : 0.f;
+    return true;
+  }
+  if (eltwise == "swish") {
+    // x * sigmoid(alpha * x) of alpha 1
+    params.activation = DepthwiseActivation::kSwish;
+    return alpha.has_value() && alpha.value().to<float>() == 1.f;
+  }
+  if (eltwise == "hardswish") {
+    params.activation = DepthwiseActivation::kHardswish;
+    return true;
+  }
+  return false;
+}
+
+// Whether the block runs on the direct depthwise kernel, of which params and
+// the depthwise weight are returned.
+bool is_depthwise_pointwise(
+    const at::Tensor& input,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context2,
+    DepthwiseConvParams& params,
+    at::Tensor& weight) {
+  const auto& bias = op_context->get_bias();
+  if (input.scalar_type() != at::kFloat ||
+      (bias.has_value() && bias.value().scalar_type() != at::kFloat)) {
+    return depthwise_pointwise_counter.fallback(kUnsupportedDtype);
+  }
+  if (input.dim() != 4 ||
+      !input.is_contiguous(at::MemoryFormat::ChannelsLast)) {
+    return depthwise_pointwise_counter.fallback(kNotChannelsLast);
+  }
+  const auto& kernel_size = op_context->get_kernel_size();
+  if (kernel_size.size() != 2 || op_context->get_groups() != input.size(1)) {
+    return depthwise_pointwise_counter.fallback(kNotDepthwise);
+  }
+  weight = op_context->get_depthwise_weight();
+  if (!weight.defined()) {
+    return depthwise_pointwise_counter.fallback(kNotDepthwise);
+  }
+  const auto& kernel_size2 = op_context2->get_kernel_size();
+  const auto& stride2 = op_context2->get_stride();
+  const auto& padding2 = op_context2->get_padding();
+  bool is_pointwise = op_context2->get_groups() == 1 &&
+      kernel_size2.size() == 2 && stride2.size() == 2 && padding2.size() == 2;
+  for (size_t d = 0; is_pointwise && d < kernel_size2.size(); d++) {
+    is_pointwise =
+        kernel_size2[d] == 1 && stride2[d] == 1 && padding2[d] == 0;
+  }
+  if (!is_pointwise) {
+    return depthwise_pointwise_counter.fallback(kNotPointwise);
+  }
+  if (!parse_activation(eltwise, alpha, beta, params)) {
+    return depthwise_pointwise_counter.fallback(kUnsupportedEltwise);
+  }
+  const auto& stride = op_context->get_stride();
+  const auto& padding = op_context->get_padding();
+  const auto& dilation = op_context->get_dilation();
+  params.kernel_h = kernel_size[0];
+  params.kernel_w = kernel_size[1];
+  params.stride_h = stride[0];
+  params.stride_w = stride[1];
+  params.pad_h = padding[0];
+  params.pad_w = padding[1];
+  params.dilation_h = dilation[0];
+  params.dilation_w = dilation[1];
+  return depthwise_pointwise_counter.hit();
+}
+
+// the largest divisor of n of at most limit, so that the blocks are of the
+// same shape, of which the pointwise convolution reuses its primitive
+int64_t largest_divisor(int64_t n, int64_t limit) {
+  for (int64_t d = std::min(n, std::max<int64_t>(limit, 1)); d > 1; d--) {
+    if (n % d == 0) {
+      return d;
+    }
+  }
+  return 1;
+}
+
+// Runs the depthwise convolution into the blocks, each of which is then run
+// by the pointwise convolution into its slice of output of attr, e.g. the sum
+// of the residual add.
+void depthwise_pointwise_blocks(
+    const at::Tensor& input,
+    const DepthwiseConvParams& params,
+    const at::Tensor& weight,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context2,
+    at::Tensor& output,
+    const ideep::attr_t& attr) {
+  IPEX_TRACE_OP_KERNEL("direct_depthwise");
+  const int64_t batch = input.size(0);
+  const int64_t channels = input.size(1);
+  const int64_t out_height = output.size(2);
+  const int64_t out_width = output.size(3);
+
+  // The blocks are of whole images if an image fits, otherwise of the output
+  // rows of an image. Either is a contiguous slice of the channels last
+  // output, into which the pointwise convolution writes in place.
+  const int64_t row_bytes = out_width * channels * sizeof(float);
+  const int64_t block_bytes = kDwPwBlockBytesPerThread * at::get_num_threads();
+  int64_t block_images = 1;
+  int64_t block_rows = out_height;
+  if (row_bytes * out_height <= block_bytes) {
+    block_images =
+        largest_divisor(batch, block_bytes / (row_bytes * out_height));
+  } else {
+    block_rows = largest_divisor(out_height, block_bytes / row_bytes);
+  }
+  auto block = at::empty(
+      {block_images, channels, block_rows, out_width},
+      input.options().memory_format(at::MemoryFormat::ChannelsLast));
+  const auto& bias = op_context->get_bias();
+  const at::Tensor bias_ =
+      bias.has_value() ? bias.value().contiguous() : at::Tensor();
+  for (int64_t n = 0; n < batch; n += block_images) {
+    auto input_block = input.narrow(0, n, block_images);
+    for (int64_t row = 0; row < out_height; row += block_rows) {
+      depthwise_conv_kernel_stub(
+          input_block, weight, bias_, block, row, params);
+      auto output_block =
+          output.narrow(0, n, block_images).narrow(2, row, block_rows);
+      op_context2->run(block, output_block, attr);
+    }
+  }
+}
+
+std::vector<int64_t> depthwise_pointwise_output_size(
+    const at::Tensor& input,
+    const DepthwiseConvParams& p,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context2) {
+  return {
+      input.size(0),
+      op_context2->get_output_channel(),
+      (input.size(2) + 2 * p.pad_h - p.dilation_h * (p.kernel_h - 1) - 1) /
+              p.stride_h +
+          1,
+      (input.size(3) + 2 * p.pad_w - p.dilation_w * (p.kernel_w - 1) - 1) /
+              p.stride_w +
+          1};
+}
+
+} // namespace
+
+at::Tensor convolution_depthwise_pointwise_run(
+    const at::Tensor& input,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context2) {
+  IPEX_RECORD_FUNCTION(
+      "ipex_prepack::convolution_depthwise_pointwise_run",
+      std::vector<c10::IValue>({}));
+  DepthwiseConvParams params;
+  at::Tensor weight;
+  if (!is_depthwise_pointwise(
+          input,
+          eltwise,
+          alpha,
+          beta,
+          op_context,
+          op_context2,
+          params,
+          weight)) {
+    return op_context2->run(
+        op_context->run(input, eltwise_post_op(eltwise, alpha, beta, 1.f)),
+        ideep::attr_t());
+  }
+  auto output = at::empty(
+      depthwise_pointwise_output_size(input, params, op_context2),
+      input.options().memory_format(at::MemoryFormat::ChannelsLast));
+  depthwise_pointwise_blocks(
+      input, params, weight, op_context, op_context2, output, ideep::attr_t());
+  return output;
+}
+
+at::Tensor convolution_depthwise_pointwise_add_run(
+    const at::Tensor& input,
+    at::Tensor& accumu,
+    const c10::optional<at::Scalar>& add_alpha,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context2) {
+  IPEX_RECORD_FUNCTION(
+      "ipex_prepack::convolution_depthwise_pointwise_add_run",
+      std::vector<c10::IValue>({}));
+  auto scale = add_alpha.has_value() ? add_alpha.value().to<float>() : 1.0;
+  DepthwiseConvParams params;
+  at::Tensor weight;
+  // the residual is summed in place, of the output shape and format
+  if (!is_depthwise_pointwise(
+          input,
+          eltwise,
+          alpha,
+          beta,
+          op_context,
+          op_context2,
+          params,
+          weight) ||
+      accumu.scalar_type() != at::kFloat ||
+      !accumu.is_contiguous(at::MemoryFormat::ChannelsLast) ||
+      accumu.sizes() !=
+          at::IntArrayRef(
+              depthwise_pointwise_output_size(input, params, op_context2))) {
+    return op_context2->run(
+        op_context->run(input, eltwise_post_op(eltwise, alpha, beta, 1.f)),
+        accumu,
+        ideep::attr_t::fuse_sum(scale));
+  }
+  depthwise_pointwise_blocks(
+      input,
+      params,
+      weight,
+      op_context,
+      op_context2,
+      accumu,
+      ideep::attr_t::fuse_sum(scale));
+  return accumu;
+}
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+#include <c10/core/Scalar.h>
+
+#include <string>
+
+#include "OpContext.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+// The inverted residual block of MobileNet and EfficientNet, i.e. the
+// pointwise convolution of the activated depthwise convolution, with the op
+// contexts of the two. eltwise is the activation of the depthwise one, with
+// alpha and beta as of convolution_eltwise_run, i.e. "relu", "clamp" of
+// [alpha, beta], "swish" or "hardswish". The depthwise convolution runs on the
+// direct kernel by blocks of images or output rows whose output fits in the
+// cache, each of which is read by the pointwise convolution from the cache
+// instead of the memory. The float channels last inputs only, others run the
+// two convolutions as they are.
+at::Tensor convolution_depthwise_pointwise_run(
+    const at::Tensor& input,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context2);
+
+// convolution_depthwise_pointwise_run whose output is added to accumu as
+// convolution_add_run, e.g. of the residual of the block.
+at::Tensor convolution_depthwise_pointwise_add_run(
+    const at::Tensor& input,
+    at::Tensor& accumu,
+    const c10::optional<at::Scalar>& add_alpha,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context2);
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,254 @@
+#include "EltwiseChain.h"
+
+#include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/vec.h>
+#include <ATen/record_function.h>
+
+#include "csrc/aten/cpu/utils/vec_math.h"
+#include "csrc/utils/op_trace.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+using Vec = at::vec::Vectorized<float>;
+
+struct Program {
+  const int64_t* code;
+  int64_t num_instructions;
+  int64_t num_inputs;
+};
+
+template <typename T>
+inline const T& operand(
+    int64_t code,
+    const std::vector<T>& regs,
+    const std::vector<T>& scalars) {
+  return code >= 0 ? regs[code] : scalars[-code - 1];
+}
+
+// Run the program on the registers, whose first num_inputs ones hold the
+// inputs. The result is in the last register. The transcendental ops are of
+// the accuracy A of the output dtype.
+template <vec_math::Accuracy A>
+inline void run_program(
+    const Program& program,
+    std::vector<Vec>& regs,
+    const std::vector<Vec>& scalars) {
+  static const Vec zero(0.f);
+  for (int64_t i = 0; i < program.num_instructions; i++) {
+    const int64_t* inst = program.code + i * 3;
+    const Vec& a = operand(inst[1], regs, scalars);
+    auto& result = regs[program.num_inputs + i];
+    switch (static_cast<EltwiseChainOp>(inst[0])) {
+      case EltwiseChainOp::Add:
+        result = a + operand(inst[2], regs, scalars);
+        break;
+      case EltwiseChainOp::Sub:
+        result = a - operand(inst[2], regs, scalars);
+        break;
+      case EltwiseChainOp::Mul:
+        result = a * operand(inst[2], regs, scalars);
+        break;
+      case EltwiseChainOp::Div:
+        result = a / operand(inst[2], regs, scalars);
+        break;
+      case EltwiseChainOp::Relu:
+        result = at::vec::maximum(a, zero);
+        break;
+      case EltwiseChainOp::Sigmoid:
+        result = vec_math::sigmoid<A>(a);
+        break;
+      case EltwiseChainOp::Tanh:
+        result = vec_math::tanh<A>(a);
+        break;
+      case EltwiseChainOp::Exp:
+        result = vec_math::exp<A>(a);
+        break;
+      case EltwiseChainOp::Gelu:
+        result = vec_math::gelu<A>(a);
+        break;
+      case EltwiseChainOp::Silu:
+        result = vec_math::silu<A>(a);
+        break;
+    }
+  }
+}
+
+void eltwise_chain_kernel(
+    const Program& program,
+    const std::vector<const float*>& inputs,
+    const std::vector<Vec>& scalars,
+    float* out,
+    int64_t numel) {
+  at::parallel_for(
+      0, numel, at::internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+        std::vector<Vec> regs(program.num_inputs + program.num_instructions);
+        for (int64_t i = begin; i < end; i += Vec::size()) {
+          int64_t len = std::min<int64_t>(Vec::size(), end - i);
+          for (int64_t j = 0; j < program.num_inputs; j++) {
+            regs[j] = Vec::loadu(inputs[j] + i, len);
+          }
+          run_program<vec_math::Accuracy::Accurate>(program, regs, scalars);
+          regs.back().store(out + i, len);
+        }
+      });
+}
+
+void eltwise_chain_kernel(
+    const Program& program,
+    const std::vector<const at::BFloat16*>& inputs,
+    const std::vector<Vec>& scalars,
+    at::BFloat16* out,
+    int64_t numel) {
+  using bVec = at::vec::Vectorized<at::BFloat16>;
+  at::parallel_for(
+      0, numel, at::internal::GRAIN_SIZE, [&](int64_t begin, int64_t end) {
+        auto num_regs = program.num_inputs + program.num_instructions;
+        std::vector<Vec> regs_lo(num_regs), regs_hi(num_regs);
+        for (int64_t i = begin; i < end; i += bVec::size()) {
+          int64_t len = std::min<int64_t>(bVec::size(), end - i);
+          for (int64_t j = 0; j < program.num_inputs; j++) {
+            auto v = bVec::loadu(inputs[j] + i, len);
+            std::tie(regs_lo[j], regs_hi[j]) =
+                at::vec::convert_bfloat16_float(v);
+          }
+          // the program runs in float on both halves of the bfloat16 vector
+          run_program<vec_math::Accuracy::Fast>(program, regs_lo, scalars);
+          run_program<vec_math::Accuracy::Fast>(program, regs_hi, scalars);
+          at::vec::convert_float_bfloat16(regs_lo.back(), regs_hi.back())
+              .store(out + i, len);
+        }
+      });
+}
+
+template <typename scalar_t>
+void run_vectorized(
+    const Program& program,
+    const std::vector<at::Tensor>& inputs,
+    const std::vector<Vec>& scalars,
+    at::Tensor& output) {
+  std::vector<const scalar_t*> input_data;
+  for (const auto& input : inputs) {
+    input_data.push_back(input.data_ptr<scalar_t>());
+  }
+  eltwise_chain_kernel(
+      program,
+      input_data,
+      scalars,
+      output.data_ptr<scalar_t>(),
+      output.numel());
+}
+
+// Evaluate the program op by op, for the inputs not taking the vectorized
+// loop.
+at::Tensor eltwise_chain_reference(
+    const Program& program,
+    const std::vector<at::Tensor>& inputs,
+    const std::vector<double>& scalars) {
+  std::vector<at::Tensor> regs(inputs);
+  regs.resize(program.num_inputs + program.num_instructions);
+  auto rhs = [&](int64_t code) -> at::Tensor {
+    if (code >= 0) {
+      return regs[code];
+    }
+    return at::scalar_tensor(scalars[-code - 1], regs[0].options());
+  };
+  for (int64_t i = 0; i < program.num_instructions; i++) {
+    const int64_t* inst = program.code + i * 3;
+    auto a = rhs(inst[1]);
+    auto& result = regs[program.num_inputs + i];
+    switch (static_cast<EltwiseChainOp>(inst[0])) {
+      case EltwiseChainOp::Add:
+        result = at::add(a, rhs(inst[2]));
+        break;
+      case EltwiseChainOp::Sub:
+        result = at::sub(a, rhs(inst[2]));
+        break;
+      case EltwiseChainOp::Mul:
+        result = at::mul(a, rhs(inst[2]));
+        break;
+      case EltwiseChainOp::Div:
+        result = at::div(a, rhs(inst[2]));
+        break;
+      case EltwiseChainOp::Relu:
+        result = at::relu(a);
+        break;
+      case EltwiseChainOp::Sigmoid:
+        result = at::sigmoid(a);
+        break;
+      case EltwiseChainOp::Tanh:
+        result = at::tanh(a);
+        break;
+      case EltwiseChainOp::Exp:
+        result = at::exp(a);
+        break;
+      case EltwiseChainOp::Gelu:
+        result = at::gelu(a);
+        break;
+      case EltwiseChainOp::Silu:
+        result = at::silu(a);
+        break;
+    }
+  }
+  return regs.back();
+}
+
+// Whether the inputs are of the same sizes, dtype and memory format, so that
+// the elements of the same offset are computed together.
+bool is_vectorizable(const std::vector<at::Tensor>& inputs) {
+  const auto& first = inputs[0];
+  if (first.scalar_type() != at::kFloat &&
+      first.scalar_type() != at::kBFloat16) {
+    return false;
+  }
+  auto memory_format = first.suggest_memory_format();
+  for (const auto& input : inputs) {
+    if (input.sizes() != first.sizes() ||
+        input.scalar_type() != first.scalar_type() ||
+        !input.is_contiguous(memory_format)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+at::Tensor eltwise_chain(
+    const std::vector<at::Tensor>& inputs,
+    const std::vector<double>& scalars,
+    const std::vector<int64_t>& program) {
+  IPEX_RECORD_FUNCTION("ipex::eltwise_chain", std::vector<c10::IValue>({}));
+  TORCH_CHECK(
+      !inputs.empty() && !program.empty() && program.size() % 3 == 0,
+      "eltwise_chain: expect at least one input and one instruction");
+  Program prog{
+      program.data(),
+      static_cast<int64_t>(program.size() / 3),
+      static_cast<int64_t>(inputs.size())};
+  if (!is_vectorizable(inputs)) {
+    return eltwise_chain_reference(prog, inputs, scalars);
+  }
+
+  const auto& first = inputs[0];
+  auto output = at::empty_like(first, first.suggest_memory_format());
+  std::vector<Vec> scalar_vecs;
+  for (auto scalar : scalars) {
+    scalar_vecs.emplace_back(static_cast<float>(scalar));
+  }
+  if (first.scalar_type() == at::kFloat) {
+    run_vectorized<float>(prog, inputs, scalar_vecs, output);
+  } else {
+    run_vectorized<at::BFloat16>(prog, inputs, scalar_vecs, output);
+  }
+  return output;
+}
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace torch_ipex {
+namespace cpu {
+
+// The instructions of an element-wise chain. Each one is encoded in the
+// program as three ints (op, a, b), where b is ignored by the unary ops.
+enum class EltwiseChainOp : int64_t {
+  Add = 0,
+  Sub,
+  Mul,
+  Div,
+  Relu,
+  Sigmoid,
+  Tanh,
+  Exp,
+  Gelu,
+  Silu,
+};
+
+// The operand code of the index-th scalar. The non-negative operand codes
+// are the registers, the inputs being the first ones and the result of each
+// instruction the register following them.
+inline int64_t eltwise_chain_scalar(int64_t index) {
+  return -index - 1;
+}
+
+// Evaluate the program over the inputs in one pass, the result being the
+// register of the last instruction. The inputs of the same sizes, dtype
+// (float or bfloat16) and memory format are read once by the vectorized
+// loop, the others are evaluated op by op with broadcasting.
+at::Tensor eltwise_chain(
+    const std::vector<at::Tensor>& inputs,
+    const std::vector<double>& scalars,
+    const std::vector<int64_t>& program);
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,184 @@
+#include "EltwisePostOp.h"
+#include "csrc/aten/cpu/Conv.h"
+#include "csrc/utils/op_trace.h"
+
+#include <ATen/record_function.h>
+
+#include <unordered_map>
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+ideep::algorithm eltwise_algorithm(const std::string& eltwise) {
+  static const std::unordered_map<std::string, ideep::algorithm> algorithms =
+      {
+          {"relu", ideep::algorithm::eltwise_relu},
+          // relu of the negative slope alpha
+          {"leaky_relu", ideep::algorithm::eltwise_relu},
+          {"sigmoid", ideep::algorithm::eltwise_logistic},
+          {"tanh", ideep::algorithm::eltwise_tanh},
+          // clip between alpha and beta
+          {"clamp", ideep::algorithm::eltwise_clip},
+          {"elu", ideep::algorithm::eltwise_elu},
+          {"swish", ideep::algorithm::eltwise_swish},
+          {"hardswish", ideep::algorithm::eltwise_hardswish},
+          {"mish", ideep::algorithm::eltwise_mish},
+          {"gelu", ideep::algorithm::eltwise_gelu_erf},
+      };
+  auto it = algorithms.find(eltwise);
+  TORCH_CHECK(
+      it != algorithms.end(), "unsupported eltwise post op: ", eltwise);
+  return it->second;
+}
+
+} // namespace
+
+ideep::attr_t eltwise_post_op(
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const at::Scalar& scale) {
+  ideep::post_ops po;
+  po.append_eltwise(
+      scale.to<float>(),
+      eltwise_algorithm(eltwise),
+      alpha.has_value() ? alpha.value().to<float>() : 0.f,
+      beta.has_value() ? beta.value().to<float>() : 0.f);
+  return ideep::attr_t::attr_post_ops(po);
+}
+
+ideep::attr_t sum_eltwise_post_op(
+    float sum_scale,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const at::Scalar& scale) {
+  ideep::post_ops po;
+  po.append_sum(sum_scale);
+  po.append_eltwise(
+      scale.to<float>(),
+      eltwise_algorithm(eltwise),
+      alpha.has_value() ? alpha.value().to<float>() : 0.f,
+      beta.has_value() ? beta.value().to<float>() : 0.f);
+  return ideep::attr_t::attr_post_ops(po);
+}
+
+at::Tensor convolution_eltwise_run(
+    const at::Tensor& input,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const at::Scalar& scale,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context) {
+  IPEX_RECORD_FUNCTION(
+      "ipex_prepack::convolution_eltwise_run", std::vector<c10::IValue>({}));
+  return op_context->run(
+      input, eltwise_post_op(eltwise, alpha, beta, scale));
+}
+
+at::Tensor convolution_add_eltwise_run(
+    const at::Tensor& input,
+    at::Tensor& accumu,
+    const c10::optional<at::Scalar>& add_alpha,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const at::Scalar& scale,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context) {
+  IPEX_RECORD_FUNCTION(
+      "ipex_prepack::convolution_add_eltwise_run",
+      std::vector<c10::IValue>({}));
+  auto sum_scale = add_alpha.has_value() ? add_alpha.value().to<float>() : 1.0;
+  return op_context->run(
+      input,
+      accumu,
+      sum_eltwise_post_op(sum_scale, eltwise, alpha, beta, scale));
+}
+
+at::Tensor linear_eltwise_run(
+    const at::Tensor& input,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const at::Scalar& scale,
+    const c10::intrusive_ptr<LinearOpContext>& op_context) {
+  IPEX_RECORD_FUNCTION(
+      "ipex_prepack::linear_eltwise_run", std::vector<c10::IValue>({}));
+  return op_context->run(
+      input, eltwise_post_op(eltwise, alpha, beta, scale));
+}
+
+at::Tensor linear_add_eltwise_run(
+    const at::Tensor& input,
+    at::Tensor& accumu,
+    const c10::optional<at::Scalar>& add_alpha,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const at::Scalar& scale,
+    const c10::intrusive_ptr<LinearOpContext>& op_context) {
+  IPEX_RECORD_FUNCTION(
+      "ipex_prepack::linear_add_eltwise_run", std::vector<c10::IValue>({}));
+  auto sum_scale = add_alpha.has_value() ? add_alpha.value().to<float>() : 1.0;
+  return op_context->run(
+      input,
+      accumu,
+      sum_eltwise_post_op(sum_scale, eltwise, alpha, beta, scale));
+}
+
+at::Tensor conv_transpose2d_eltwise_run(
+    const at::Tensor& input,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const at::Scalar& scale,
+    const c10::intrusive_ptr<ConvTransposeOpContext>& op_context) {
+  IPEX_RECORD_FUNCTION(
+      "ipex_prepack::conv_transpose2d_eltwise_run",
+      std::vector<c10::IValue>({}));
+  return op_context->run(
+      input, eltwise_post_op(eltwise, alpha, beta, scale));
+}
+
+at::Tensor conv_transpose3d_eltwise_run(
+    const at::Tensor& input,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const at::Scalar& scale,
+    const c10::intrusive_ptr<ConvTransposeOpContext>& op_context) {
+  IPEX_RECORD_FUNCTION(
+      "ipex_prepack::conv_transpose3d_eltwise_run",
+      std::vector<c10::IValue>({}));
+  return op_context->run(
+      input, eltwise_post_op(eltwise, alpha, beta, scale));
+}
+
+at::Tensor dil_convolution_eltwise(
+    const at::Tensor& input,
+    const at::Tensor& weight,
+    const at::Tensor& bias,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef dilation,
+    int64_t groups,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const at::Scalar& scale) {
+  IPEX_RECORD_FUNCTION("dil_convolution_eltwise", std::vector<c10::IValue>({}));
+  return convolution_impl(
+      input,
+      weight,
+      bias,
+      stride,
+      padding,
+      dilation,
+      groups,
+      eltwise_post_op(eltwise, alpha, beta, scale));
+}
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+#include <c10/core/Scalar.h>
+
+#include <string>
+
+#include "OpContext.h"
+#include "csrc/cpu/ideep/ideep.hpp"
+
+namespace torch_ipex {
+namespace cpu {
+
+// The oneDNN attr of the eltwise post op named eltwise, computing
+// scale * eltwise(x; alpha, beta). The names are those of the
+// fuseWithEltwisePostOps table, e.g. "hardswish", "mish" or "clamp".
+ideep::attr_t eltwise_post_op(
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const at::Scalar& scale);
+
+// The same eltwise post op after summing sum_scale times the destination.
+ideep::attr_t sum_eltwise_post_op(
+    float sum_scale,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const at::Scalar& scale);
+
+// The convolution, linear and deconvolution with any eltwise post op.
+at::Tensor convolution_eltwise_run(
+    const at::Tensor& input,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const at::Scalar& scale,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context);
+
+at::Tensor convolution_add_eltwise_run(
+    const at::Tensor& input,
+    at::Tensor& accumu,
+    const c10::optional<at::Scalar>& add_alpha,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const at::Scalar& scale,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context);
+
+at::Tensor linear_eltwise_run(
+    const at::Tensor& input,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const at::Scalar& scale,
+    const c10::intrusive_ptr<LinearOpContext>& op_context);
+
+at::Tensor linear_add_eltwise_run(
+    const at::Tensor& input,
+    at::Tensor& accumu,
+    const c10::optional<at::Scalar>& add_alpha,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const at::Scalar& scale,
+    const c10::intrusive_ptr<LinearOpContext>& op_context);
+
+at::Tensor conv_transpose2d_eltwise_run(
+    const at::Tensor& input,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const at::Scalar& scale,
+    const c10::intrusive_ptr<ConvTransposeOpContext>& op_context);
+
+at::Tensor conv_transpose3d_eltwise_run(
+    const at::Tensor& input,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const at::Scalar& scale,
+    const c10::intrusive_ptr<ConvTransposeOpContext>& op_context);
+
+// The conv3d of the JIT path with any eltwise post op.
+at::Tensor dil_convolution_eltwise(
+    const at::Tensor& input,
+    const at::Tensor& weight,
+    const at::Tensor& bias,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef dilation,
+    int64_t groups,
+    const std::string& eltwise,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::optional<at::Scalar>& beta,
+    const at::Scalar& scale);
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -1,14 +1,65 @@
 #include "LinearPacked.h"
+#include "csrc/aten/cpu/DynamicQuantizedLinear.h"
+#include "csrc/aten/cpu/Gemv.h"
 #include "csrc/aten/cpu/Linear.h"
+#include "csrc/aten/cpu/PackedWeightSerialization.h"
+#include "csrc/aten/cpu/SparseLinear.h"
+#include "csrc/aten/cpu/WeightOnlyQuantizedLinear.h"
 #include "csrc/aten/cpu/WeightPack.h"
 #include "csrc/cpu/ideep/IDeepConversions.h"
 #include "csrc/cpu/ideep/ideep.hpp"
+#include "csrc/quantization/auto_opt_config.hpp"
+#include "csrc/utils/op_trace.h"
+
+#include <ATen/Parallel.h>
+
+#include <algorithm>
 
 namespace torch_ipex {
 namespace cpu {
 namespace detail {
 namespace linear {
 
+namespace {
+
+// The bytes of the gelu output of a row block of the FFN per thread, about
+// half of the L2 of a core, so that the input and the weight blocks of the
+// second linear fit along with it.
+constexpr int64_t kFfnBlockBytesPerThread = 512 * 1024;
+// A smaller row block makes the GEMMs too narrow to be efficient.
+constexpr int64_t kFfnMinBlockRows = 64;
+
+// Returns the rows of the FFN row blocks of input, 0 if all the rows fit in
+// a single block, which runs the two linears as they are.
+int64_t ffn_block_rows(
+    const at::Tensor& input,
+    const c10::intrusive_ptr<LinearOpContext>& op_context) {
+  auto rows = input.numel() / input.size(input.dim() - 1);
+  auto row_bytes = op_context->get_out_features() * input.element_size();
+  auto block_rows = std::max(
+      kFfnMinBlockRows,
+      kFfnBlockBytesPerThread * at::get_num_threads() /
+          std::max<int64_t>(row_bytes, 1));
+  return block_rows < rows ? block_rows : 0;
+}
+
+// The weight of the linear prepacked for at most kGemvMaxRows input rows,
+// e.g. of the decoding, is kept plain for the GEMV of linear_kernel_output,
+// which is of the rows of the threads first touched by them. The larger
+// batches, e.g. of the prefill, run oneDNN on the plain weight.
+ideep::tensor gemv_packed_weight(
+    ideep::tensor&& packed_weight,
+    int64_t batch_size) {
+  auto dtype = packed_weight.get_data_type();
+  if (batch_size < 1 || batch_size > kGemvMaxRows ||
+      (dtype != ideep::data_type::f32 && dtype != ideep::data_type::bf16)) {
+    return std::move(packed_weight);
+  }
+  return pack_gemv_weight(packed_weight);
+}
+
+} // namespace
+
 c10::intrusive_ptr<LinearOpContext> createLinearPrePackOpContext(
     at::Tensor&& weight,
     c10::optional<at::Tensor>&& bias,
@@ -16,11 +67,9 @@ c10::intrusive_ptr<LinearOpContext> createLinearPrePackOpContext(
     int64_t in_features,
     int64_t batch_size,
     bool weight_is_packed) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "ipex_prepack::createLinearPrePackOpContext",
       std::vector<c10::IValue>({}));
-#endif
   return IpexLinearOpContext::create_context(
       std::move(weight),
       std::move(bias),
@@ -33,29 +82,24 @@ c10::intrusive_ptr<LinearOpContext> createLinearPrePackOpContext(
 at::Tensor linear_run(
     const at::Tensor& input,
     const c10::intrusive_ptr<LinearOpContext>& op_context) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("ipex_prepack::linear_run", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION(
+      "ipex_prepack::linear_run", std::vector<c10::IValue>({}));
   return op_context->run(input, ideep::attr_t());
 }
 
 at::Tensor linear_relu_run(
     const at::Tensor& input,
     const c10::intrusive_ptr<LinearOpContext>& op_context) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "ipex_prepack::linear_relu_run", std::vector<c10::IValue>({}));
-#endif
   return op_context->run(input, ideep::attr_t::fuse_relu());
 }
 
 at::Tensor linear_gelu_run(
     const at::Tensor& input,
     const c10::intrusive_ptr<LinearOpContext>& op_context) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION(
+  IPEX_RECORD_FUNCTION(
       "ipex_prepack::linear_gelu_run", std::vector<c10::IValue>({}));
-#endif
   return op_context->run(input, ideep::attr_t::fuse_gelu());
 }
 
@@ -64,13 +108,76 @@ at::Tensor linear_add_run(
     at::Tensor& accumu,
     const c10::optional<at::Scalar>& alpha,
     const c10::intrusive_ptr<LinearOpContext>& op_context) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("ipex_prepack::linear_add_run", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION(
+      "ipex_prepack::linear_add_run", std::vector<c10::IValue>({}));
   auto scale = alpha.has_value() ? alpha.value().to<float>() : 1.0;
   return op_context->run(input, accumu, ideep::attr_t::fuse_sum(scale));
 }
 
+at::Tensor linear_gelu_linear_run(
+    const at::Tensor& input,
+    const c10::intrusive_ptr<LinearOpContext>& op_context,
+    const c10::intrusive_ptr<LinearOpContext>& op_context2) {
+  IPEX_RECORD_FUNCTION(
+      "ipex_prepack::linear_gelu_linear_run", std::vector<c10::IValue>({}));
+  auto block_rows = ffn_block_rows(input, op_context);
+  if (block_rows == 0) {
+    return op_context2->run(
+        op_context->run(input, ideep::attr_t::fuse_gelu()), ideep::attr_t());
+  }
+  auto input_ = input.contiguous();
+  auto input_2d = input_.reshape({-1, input_.size(input_.dim() - 1)});
+  auto rows = input_2d.size(0);
+  auto output =
+      at::empty({rows, op_context2->get_out_features()}, input_.options());
+  for (int64_t row = 0; row < rows; row += block_rows) {
+    auto n = std::min(block_rows, rows - row);
+    auto output_block = output.narrow(0, row, n);
+    op_context2->run(
+        op_context->run(
+            input_2d.narrow(0, row, n), ideep::attr_t::fuse_gelu()),
+        output_block,
+        ideep::attr_t());
+  }
+  auto output_size = input_.sizes().vec();
+  output_size.back() = op_context2->get_out_features();
+  return output.view(output_size);
+}
+
+at::Tensor linear_gelu_linear_add_run(
+    const at::Tensor& input,
+    at::Tensor& accumu,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::intrusive_ptr<LinearOpContext>& op_context,
+    const c10::intrusive_ptr<LinearOpContext>& op_context2) {
+  IPEX_RECORD_FUNCTION(
+      "ipex_prepack::linear_gelu_linear_add_run",
+      std::vector<c10::IValue>({}));
+  auto scale = alpha.has_value() ? alpha.value().to<float>() : 1.0;
+  auto block_rows = ffn_block_rows(input, op_context);
+  auto rows = input.numel() / input.size(input.dim() - 1);
+  if (block_rows == 0 || !accumu.is_contiguous() ||
+      accumu.numel() != rows * op_context2->get_out_features()) {
+    return op_context2->run(
+        op_context->run(input, ideep::attr_t::fuse_gelu()),
+        accumu,
+        ideep::attr_t::fuse_sum(scale));
+  }
+  auto input_ = input.contiguous();
+  auto input_2d = input_.reshape({-1, input_.size(input_.dim() - 1)});
+  auto accumu_2d = accumu.view({rows, accumu.size(accumu.dim() - 1)});
+  for (int64_t row = 0; row < rows; row += block_rows) {
+    auto n = std::min(block_rows, rows - row);
+    auto accumu_block = accumu_2d.narrow(0, row, n);
+    op_context2->run(
+        op_context->run(
+            input_2d.narrow(0, row, n), ideep::attr_t::fuse_gelu()),
+        accumu_block,
+        ideep::attr_t::fuse_sum(scale));
+  }
+  return accumu;
+}
+
 ContextLinear create(
     const at::Tensor& weight,
     const c10::optional<at::Tensor>& bias,
@@ -78,13 +185,110 @@ ContextLinear create(
     const int64_t in_features,
     const int64_t batch_size,
     const bool weight_is_packed) {
-  auto weight_dtype = get_mkldnn_dtype(weight.scalar_type());
+  if (weight.is_quantized()) {
+    // weight-only or dynamic quantized linear
+    TORCH_CHECK(
+        weight.scalar_type() == at::kQInt8 &&
+            weight.qscheme() == at::kPerChannelAffine &&
+            weight.q_per_channel_axis() == 0 &&
+            weight.q_per_channel_zero_points().eq(0).all().item<bool>(),
+        "The quantized linear only supports the symmetric per-channel qint8 "
+        "weight along the output channels");
+    auto weight_int8 = at::int_repr(weight).contiguous();
+    auto weight_scales =
+        weight.q_per_channel_scales().to(at::kFloat).contiguous();
+    if (AutoOptConfig::singleton().get_jit_dynamic_quantization()) {
+      auto weight_compensation =
+          dynamic_quantized_linear_compensation(weight_int8, weight_scales);
+      auto weight_packed = pack_dynamic_quantized_linear_weight(
+          weight_int8, weight_scales, batch_size);
+      return ContextLinear{
+          std::move(weight_packed),
+          std::move(weight_scales),
+          std::move(weight_compensation),
+          bias.has_value() ? c10::make_optional(*bias) : c10::nullopt,
+      };
+    }
+    return ContextLinear{
+        std::move(weight_int8),
+        std::move(weight_scales),
+        bias.has_value() ? c10::make_optional(*bias) : c10::nullopt,
+    };
+  }
+  bool weight_is_serialized = is_serialized_packed_weight(weight);
+  if (!weight_is_serialized &&
+      is_linear_weight_int4(weight, out_features, in_features)) {
+    // the 4-bit weight-only quantized linear
+    at::Tensor weight_int4;
+    at::Tensor weight_scales;
+    Int4Format format;
+    int64_t group_size;
+    unpack_linear_weight_int4(
+        weight, in_features, weight_int4, weight_scales, format, group_size);
+    return ContextLinear{
+        std::move(weight_int4),
+        format,
+        group_size,
+        std::move(weight_scales),
+        bias.has_value() ? c10::make_optional(*bias) : c10::nullopt,
+    };
+  }
+  if (weight_is_serialized) {
+    auto qparams = get_serialized_packed_weight_qparams(weight);
+    if (qparams.defined()) {
+      // the packed s8 weight of the dynamic quantized linear, saved with its
+      // scales and compensation
+      TORCH_CHECK(
+          qparams.size(0) == 2 && qparams.size(1) == out_features,
+          "The serialized dynamic quantized linear weight is corrupted");
+      auto weight_scales = qparams[0].contiguous();
+      auto weight_packed = load_dynamic_quantized_linear_weight(
+          weight, weight_scales, out_features, in_features, batch_size);
+      return ContextLinear{
+          std::move(weight_packed),
+          std::move(weight_scales),
+          qparams[1].contiguous(),
+          bias.has_value() ? c10::make_optional(*bias) : c10::nullopt,
+      };
+    }
+  }
+  if (!weight_is_serialized && weight.scalar_type() == at::kFloat &&
+      AutoOptConfig::singleton().get_sparse_linear()) {
+    // the pruned weight of enough zero blocks
+    auto weight_ = weight_is_packed
+        ? linear_weight_unpack(
+              weight, out_features, in_features, false, c10::nullopt)
+        : weight;
+    if (linear_weight_block_sparsity(weight_) >=
+        kSparseLinearMinBlockSparsity) {
+      at::Tensor values, indices, offsets;
+      pack_block_sparse_linear_weight(weight_, values, indices, offsets);
+      return ContextLinear{
+          std::move(values),
+          std::move(indices),
+          std::move(offsets),
+          out_features,
+          bias.has_value() ? c10::make_optional(*bias) : c10::nullopt,
+      };
+    }
+  }
+  auto weight_dtype = weight_is_serialized
+      ? get_serialized_packed_weight_desc(weight).get_data_type()
+      : get_mkldnn_dtype(weight.scalar_type());
   ideep::tensor parcked_weight;
   auto packed_desc = ideep::inner_product_forward::expected_weights_desc(
       {out_features, in_features},
       {batch_size, in_features},
       /* weight dtype */ weight_dtype,
       /* src dtype */ weight_dtype);
+  if (weight_is_serialized) {
+    // restore the packed weight saved by the packed weight serialization
+    return ContextLinear{
+        gemv_packed_weight(
+            load_serialized_packed_weight(weight, packed_desc), batch_size),
+        bias.has_value() ? c10::make_optional(*bias) : c10::nullopt,
+    };
+  }
   parcked_weight.init(packed_desc);
   if (!weight_is_packed) {
     auto weight_ = weight.contiguous();
@@ -95,7 +299,7 @@ ContextLinear create(
     parcked_weight.feed_from(w);
   }
   return ContextLinear{
-      std::move(parcked_weight),
+      gemv_packed_weight(std::move(parcked_weight), batch_size),
       bias.has_value() ? c10::make_optional(*bias) : c10::nullopt,
   };
 }
@@ -108,6 +312,44 @@ at::Tensor run(
   c10::MaybeOwned<at::Tensor> bias_maybe_owned =
       at::borrow_from_optional_tensor(context.bias_);
   const at::Tensor& bias = *bias_maybe_owned;
+  IPEX_TRACE_OP_INPUTS(input_);
+  if (context.weight_int4_.defined()) {
+    IPEX_TRACE_OP_KERNEL("woq_int4");
+    return woq_linear_int4_kernel(
+        input_,
+        context.weight_int4_,
+        context.weight_scales_,
+        context.weight_int4_format_,
+        context.weight_group_size_,
+        bias,
+        attr);
+  }
+  if (context.is_block_sparse()) {
+    IPEX_TRACE_OP_KERNEL("block_sparse");
+    return sparse_linear_kernel(
+        input_,
+        context.weight_sparse_values_,
+        context.weight_sparse_indices_,
+        context.weight_sparse_offsets_,
+        context.weight_sparse_out_features_,
+        bias,
+        attr);
+  }
+  if (context.is_weight_only_quantized()) {
+    IPEX_TRACE_OP_KERNEL("woq_int8");
+    return woq_linear_kernel(
+        input_, context.weight_int8_, context.weight_scales_, bias, attr);
+  }
+  if (context.is_dynamic_quantized()) {
+    IPEX_TRACE_OP_KERNEL("dynamic_quantized");
+    return dq_linear_kernel(
+        input_,
+        context.weight_packed_,
+        context.weight_compensation_,
+        bias,
+        attr);
+  }
+  IPEX_TRACE_OP_KERNEL("onednn");
   return linear_kernel(input_, context.weight_packed_, bias, attr);
 }
 
@@ -120,6 +362,55 @@ at::Tensor& run(
   c10::MaybeOwned<at::Tensor> bias_maybe_owned =
       at::borrow_from_optional_tensor(context.bias_);
   const at::Tensor& bias = *bias_maybe_owned;
+  IPEX_TRACE_OP_INPUTS(input_);
+  if (context.weight_int4_.defined()) {
+    IPEX_TRACE_OP_KERNEL("woq_int4");
+    woq_linear_int4_kernel_output(
+        input_,
+        context.weight_int4_,
+        context.weight_scales_,
+        context.weight_int4_format_,
+        context.weight_group_size_,
+        bias,
+        accumu,
+        attr);
+    return accumu;
+  }
+  if (context.is_block_sparse()) {
+    IPEX_TRACE_OP_KERNEL("block_sparse");
+    sparse_linear_kernel_output(
+        input_,
+        context.weight_sparse_values_,
+        context.weight_sparse_indices_,
+        context.weight_sparse_offsets_,
+        bias,
+        accumu,
+        attr);
+    return accumu;
+  }
+  if (context.is_weight_only_quantized()) {
+    IPEX_TRACE_OP_KERNEL("woq_int8");
+    woq_linear_kernel_output(
+        input_,
+        context.weight_int8_,
+        context.weight_scales_,
+        bias,
+        accumu,
+        attr);
+    return accumu;
+  }
+  if (context.is_dynamic_quantized()) {
+    IPEX_TRACE_OP_KERNEL("dynamic_quantized");
+    dq_linear_kernel_output(
+        input_,
+        context.weight_packed_,
+        context.weight_compensation_,
+        bias,
+        accumu,
+        attr);
+    return accumu;
+  }
+  IPEX_TRACE_OP_KERNEL("onednn");
   linear_kernel_output(input_, context.weight_packed_, bias, accumu, attr);
   return accumu;
 }
@@ -127,4 +418,4 @@ at::Tensor& run(
 } // namespace linear
 } // namespace detail
 } // namespace cpu
-} // namespace torch_ipex
\ No newline at end of file
+} // namespace torch_ipex
\ No newline at end of file
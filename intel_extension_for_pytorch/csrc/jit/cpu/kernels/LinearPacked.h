@@ -35,6 +35,23 @@ at::Tensor linear_add_run(
     const c10::optional<at::Scalar>& alpha,
     const c10::intrusive_ptr<LinearOpContext>& op_context);
 
+// The FFN of the transformers, linear(gelu(linear(input))) with the op
+// contexts of the two linears. The rows of the input are run by blocks whose
+// gelu output fits in the cache, so that the wide intermediate is read by the
+// second linear from the cache instead of the memory.
+at::Tensor linear_gelu_linear_run(
+    const at::Tensor& input,
+    const c10::intrusive_ptr<LinearOpContext>& op_context,
+    const c10::intrusive_ptr<LinearOpContext>& op_context2);
+
+// linear_gelu_linear_run whose output is added to accumu as linear_add_run.
+at::Tensor linear_gelu_linear_add_run(
+    const at::Tensor& input,
+    at::Tensor& accumu,
+    const c10::optional<at::Scalar>& alpha,
+    const c10::intrusive_ptr<LinearOpContext>& op_context,
+    const c10::intrusive_ptr<LinearOpContext>& op_context2);
+
 ContextLinear create(
     const at::Tensor& weight,
     const c10::optional<at::Tensor>& bias,
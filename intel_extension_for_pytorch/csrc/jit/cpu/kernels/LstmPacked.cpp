@@ -0,0 +1,490 @@
+#include "LstmPacked.h"
+#include "csrc/aten/cpu/PackedWeightSerialization.h"
+#include "csrc/aten/cpu/WeightPack.h"
+#include "csrc/aten/cpu/utils/vec_math.h"
+#include "csrc/cpu/ideep/IDeepConversions.h"
+#include "csrc/cpu/ideep/ideep.hpp"
+#include "csrc/utils/op_trace.h"
+
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/vec.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace torch_ipex {
+namespace cpu {
+namespace detail {
+namespace lstm {
+
+namespace {
+
+using format = ideep::format_tag;
+using desc = ideep::tensor::desc;
+using dtype = ideep::tensor::data_type;
+
+constexpr int64_t kNumGates = 4;
+// The largest batch of one step run by the fused cell, e.g. the prediction
+// network of the RNN-T greedy decoding, for which creating the LSTM primitive
+// costs more than the math.
+constexpr int64_t kMaxFusedCellBatch = 32;
+
+// The formats of the LSTM layer are the same as those of RNN.cpp.
+desc src_layer_desc(
+    int64_t seq_length,
+    int64_t mini_batch,
+    int64_t input_size,
+    dtype dtype) {
+  return {{seq_length, mini_batch, input_size}, dtype, format::tnc};
+}
+
+desc iter_desc(int64_t mini_batch, int64_t hidden_size, dtype dtype) {
+  return {{1, 1, mini_batch, hidden_size}, dtype, format::ldnc};
+}
+
+desc weights_desc(int64_t input_size, int64_t hidden_size, dtype dtype) {
+  return {{1, 1, input_size, kNumGates, hidden_size}, dtype, format::ldgoi};
+}
+
+desc bias_desc(int64_t hidden_size, dtype dtype) {
+  return {{1, 1, kNumGates, hidden_size}, dtype, format::ldgo};
+}
+
+// An ideep tensor without buffer, which only carries the desc to query the
+// packed weight formats.
+ideep::tensor desc_only_tensor(const desc& tensor_desc) {
+  ideep::tensor t;
+  t.init(tensor_desc, /* ahandle */ nullptr);
+  return t;
+}
+
+dtype get_weight_dtype(const at::Tensor& weight) {
+  return is_serialized_packed_weight(weight)
+      ? get_serialized_packed_weight_desc(weight).get_data_type()
+      : get_mkldnn_dtype(weight.scalar_type());
+}
+
+// Pack the plain weight, or restore the serialized packed weight, in
+// packed_desc.
+ideep::tensor pack_weight(
+    const at::Tensor& weight,
+    const desc& plain_desc,
+    const desc& packed_desc) {
+  if (is_serialized_packed_weight(weight)) {
+    return load_serialized_packed_weight(weight, packed_desc);
+  }
+  auto weight_ = weight.contiguous();
+  auto w = itensor_view_from_dense(weight_, plain_desc);
+  ideep::tensor packed_weight;
+  packed_weight.init(packed_desc);
+  packed_weight.feed_from(w);
+  return packed_weight;
+}
+
+// Get the packed weights of the layer and direction index in the formats
+// preferred by the shape of src_layer. The weights packed for another shape
+// are kept in context.weight_variants_, so that the recurring sequence lengths
+// and batch sizes don't reorder the weights on every call.
+std::tuple<ideep::tensor, ideep::tensor> get_packed_weights(
+    const ContextLstm& context,
+    int64_t index,
+    const ideep::dims& output_sizes,
+    const ideep::tensor& src_layer,
+    const ideep::tensor& src_iter,
+    const ideep::tensor& src_iter_c,
+    const ideep::tensor& bias,
+    bool reverse) {
+  const auto& weight_ih = context.weights_ih_packed_[index];
+  const auto& weight_hh = context.weights_hh_packed_[index];
+  int64_t seq_length = output_sizes[0];
+  int64_t mini_batch = output_sizes[1];
+  if (seq_length == context.seq_length_ && mini_batch == context.mini_batch_) {
+    return std::make_tuple(weight_ih, weight_hh);
+  }
+  auto pack = [&](bool is_weight_ih) {
+    desc packed_desc_ih, packed_desc_hh;
+    std::tie(packed_desc_ih, packed_desc_hh) =
+        get_lstm_inference_packed_weight_desc(
+            weight_ih,
+            weight_hh,
+            output_sizes,
+            src_layer,
+            src_iter,
+            src_iter_c,
+            bias,
+            reverse);
+    const auto& weight = is_weight_ih ? weight_ih : weight_hh;
+    const auto& packed_desc = is_weight_ih ? packed_desc_ih : packed_desc_hh;
+    if (packed_desc == weight.get_desc()) {
+      return weight;
+    }
+    ideep::tensor packed_weight;
+    packed_weight.init(packed_desc);
+    packed_weight.feed_from(weight);
+    return packed_weight;
+  };
+  auto& variants = context.weight_variants_[index];
+  auto packed_weight_ih =
+      variants->get({seq_length, mini_batch, 0}, [&]() { return pack(true); });
+  auto packed_weight_hh = variants->get(
+      {seq_length, mini_batch, 1}, [&]() { return pack(false); });
+  return std::make_tuple(packed_weight_ih, packed_weight_hh);
+}
+
+// Get the [weight_ih, weight_hh] of the layer and direction index, i.e. the
+// weight [4 * hidden_size, input_size + hidden_size] of the gates of [x, h],
+// packed for the inner product of mini_batch. It is reordered from the packed
+// LSTM weights once per batch size.
+ideep::tensor get_fused_cell_weight(
+    const ContextLstm& context,
+    int64_t index,
+    int64_t input_size,
+    int64_t mini_batch) {
+  auto pack = [&]() {
+    int64_t hidden_size = context.hidden_size_;
+    auto options = at::TensorOptions().dtype(at::kFloat);
+    // the plain ldgoi weights are the [4 * hidden_size, size] matrices
+    auto to_plain = [&](const ideep::tensor& packed_weight, int64_t size) {
+      auto plain = at::empty({kNumGates * hidden_size, size}, options);
+      auto w = itensor_view_from_dense(
+          plain, weights_desc(size, hidden_size, dtype::f32));
+      w.feed_from(packed_weight);
+      return plain;
+    };
+    auto weight = at::cat(
+        {to_plain(context.weights_ih_packed_[index], input_size),
+         to_plain(context.weights_hh_packed_[index], hidden_size)},
+        1);
+    auto w = itensor_view_from_dense(weight);
+    ideep::tensor packed_weight;
+    packed_weight.init(ideep::inner_product_forward::expected_weights_desc(
+        w.get_dims(),
+        {mini_batch, input_size + hidden_size},
+        dtype::f32,
+        dtype::f32));
+    packed_weight.feed_from(w);
+    return packed_weight;
+  };
+  return context.weight_variants_[index]->get({1, mini_batch, 2}, pack);
+}
+
+inline float sigmoid(float x) {
+  return 1.f / (1.f + std::exp(-x));
+}
+
+// The cell update of one step from the gates [mini_batch, 4 * hidden_size] of
+// i, f, g and o, in registers:
+//   cy = sigmoid(f) * cx + sigmoid(i) * tanh(g)
+//   hy = sigmoid(o) * tanh(cy)
+// hy is written to both output and hy.
+void lstm_cell_kernel(
+    const float* gates,
+    const float* cx,
+    float* output,
+    float* hy,
+    float* cy,
+    int64_t mini_batch,
+    int64_t hidden_size) {
+  using Vec = at::vec::Vectorized<float>;
+  auto grain_size = std::max<int64_t>(
+      1, at::internal::GRAIN_SIZE / (kNumGates * hidden_size));
+  at::parallel_for(0, mini_batch, grain_size, [&](int64_t begin, int64_t end) {
+    for (int64_t n = begin; n < end; n++) {
+      const float* g_i = gates + n * kNumGates * hidden_size;
+      const float* g_f = g_i + hidden_size;
+      const float* g_g = g_f + hidden_size;
+      const float* g_o = g_g + hidden_size;
+      int64_t offset = n * hidden_size;
+      int64_t d = 0;
+      for (; d <= hidden_size - Vec::size(); d += Vec::size()) {
+        auto c = vec_math::sigmoid(Vec::loadu(g_f + d)) *
+                Vec::loadu(cx + offset + d) +
+            vec_math::sigmoid(Vec::loadu(g_i + d)) *
+                vec_math::tanh(Vec::loadu(g_g + d));
+        auto h = vec_math::sigmoid(Vec::loadu(g_o + d)) * vec_math::tanh(c);
+        c.store(cy + offset + d);
+        h.store(hy + offset + d);
+        h.store(output + offset + d);
+      }
+      for (; d < hidden_size; d++) {
+        float c = sigmoid(g_f[d]) * cx[offset + d] +
+            sigmoid(g_i[d]) * std::tanh(g_g[d]);
+        float h = sigmoid(g_o[d]) * std::tanh(c);
+        cy[offset + d] = c;
+        hy[offset + d] = h;
+        output[offset + d] = h;
+      }
+    }
+  });
+}
+
+// Whether the layer runs the fused cell rather than the LSTM primitive, i.e.
+// one fp32 step of a small batch.
+bool use_fused_cell(
+    const ContextLstm& context,
+    int64_t index,
+    const at::Tensor& input,
+    const at::Tensor& hx,
+    const at::Tensor& cx) {
+  return input.size(0) == 1 && input.size(1) <= kMaxFusedCellBatch &&
+      input.scalar_type() == at::kFloat && hx.scalar_type() == at::kFloat &&
+      cx.scalar_type() == at::kFloat &&
+      context.biases_[index].scalar_type() == at::kFloat &&
+      context.weights_ih_packed_[index].get_data_type() == dtype::f32 &&
+      context.weights_hh_packed_[index].get_data_type() == dtype::f32;
+}
+
+// One step of the layer by a single inner product of [x, h] and
+// [weight_ih, weight_hh] for the gates, followed by the fused cell update.
+std::vector<at::Tensor> run_fused_cell(
+    const ContextLstm& context,
+    int64_t index,
+    const at::Tensor& input,
+    const at::Tensor& hx_,
+    const at::Tensor& cx_) {
+  int64_t mini_batch = input.size(1);
+  int64_t input_size = input.size(2);
+  int64_t hidden_size = context.hidden_size_;
+  auto xh = at::cat({input[0], hx_}, 1);
+  auto gates = at::empty({mini_batch, kNumGates * hidden_size}, xh.options());
+  auto src = itensor_view_from_dense(xh);
+  auto b = itensor_view_from_dense(context.biases_[index]);
+  auto dst = itensor_view_from_dense(gates);
+  ideep::inner_product_forward::compute(
+      src,
+      get_fused_cell_weight(context, index, input_size, mini_batch),
+      b,
+      dst);
+
+  auto output = at::empty({1, mini_batch, hidden_size}, input.options());
+  auto hy_ = at::empty(hx_.sizes(), hx_.options());
+  auto cy_ = at::empty(cx_.sizes(), cx_.options());
+  lstm_cell_kernel(
+      gates.data_ptr<float>(),
+      cx_.data_ptr<float>(),
+      output.data_ptr<float>(),
+      hy_.data_ptr<float>(),
+      cy_.data_ptr<float>(),
+      mini_batch,
+      hidden_size);
+  return {output, hy_, cy_};
+}
+
+std::vector<at::Tensor> run_layer(
+    const ContextLstm& context,
+    int64_t index,
+    const at::Tensor& input,
+    const at::Tensor& hx_,
+    const at::Tensor& cx_,
+    bool reverse) {
+  if (use_fused_cell(context, index, input, hx_, cx_)) {
+    // the single step is the same in both directions
+    return run_fused_cell(context, index, input, hx_, cx_);
+  }
+  int64_t seq_length = input.size(0);
+  int64_t mini_batch = input.size(1);
+  int64_t input_size = input.size(2);
+  int64_t hidden_size = context.hidden_size_;
+  auto output =
+      at::empty({seq_length, mini_batch, hidden_size}, input.options());
+  auto hy_ = at::empty(hx_.sizes(), hx_.options());
+  auto cy_ = at::empty(cx_.sizes(), cx_.options());
+  const auto& bias = context.biases_[index];
+
+  auto x = itensor_view_from_dense(
+      input,
+      src_layer_desc(
+          seq_length,
+          mini_batch,
+          input_size,
+          get_mkldnn_dtype(input.scalar_type())));
+  auto hx = itensor_view_from_dense(
+      hx_,
+      iter_desc(mini_batch, hidden_size, get_mkldnn_dtype(hx_.scalar_type())));
+  auto cx = itensor_view_from_dense(
+      cx_,
+      iter_desc(mini_batch, hidden_size, get_mkldnn_dtype(cx_.scalar_type())));
+  auto b = itensor_view_from_dense(
+      bias, bias_desc(hidden_size, get_mkldnn_dtype(bias.scalar_type())));
+  auto y = itensor_view_from_dense(
+      output,
+      src_layer_desc(
+          seq_length,
+          mini_batch,
+          hidden_size,
+          get_mkldnn_dtype(output.scalar_type())));
+  auto hy = itensor_view_from_dense(
+      hy_,
+      iter_desc(mini_batch, hidden_size, get_mkldnn_dtype(hy_.scalar_type())));
+  auto cy = itensor_view_from_dense(
+      cy_,
+      iter_desc(mini_batch, hidden_size, get_mkldnn_dtype(cy_.scalar_type())));
+
+  ideep::tensor w1, w2;
+  std::tie(w1, w2) = get_packed_weights(
+      context,
+      index,
+      {seq_length, mini_batch, hidden_size},
+      x,
+      hx,
+      cx,
+      b,
+      reverse);
+  ideep::lstm_forward_inference::compute(
+      x, hx, cx, w1, w2, b, y, hy, cy, reverse);
+  return {output, hy_, cy_};
+}
+
+} // namespace
+
+c10::intrusive_ptr<LstmOpContext> createLstmPrePackOpContext(
+    std::vector<at::Tensor>&& params,
+    bool has_biases,
+    int64_t num_layers,
+    int64_t hidden_size,
+    bool bidirectional,
+    bool batch_first,
+    std::vector<int64_t>&& input_size) {
+  IPEX_RECORD_FUNCTION(
+      "ipex_prepack::createLstmPrePackOpContext", std::vector<c10::IValue>({}));
+  return IpexLstmOpContext::create_context(
+      std::move(params),
+      has_biases,
+      num_layers,
+      hidden_size,
+      bidirectional,
+      batch_first,
+      std::move(input_size));
+}
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor> lstm_run(
+    const at::Tensor& input,
+    const std::vector<at::Tensor>& hx,
+    const c10::intrusive_ptr<LstmOpContext>& op_context) {
+  IPEX_RECORD_FUNCTION("ipex_prepack::lstm_run", std::vector<c10::IValue>({}));
+  return op_context->run(input, hx);
+}
+
+ContextLstm create(
+    const std::vector<at::Tensor>& params,
+    const bool has_biases,
+    const int64_t num_layers,
+    const int64_t hidden_size,
+    const bool bidirectional,
+    const bool batch_first,
+    const at::IntArrayRef input_size) {
+  TORCH_CHECK(
+      input_size.size() == 3,
+      "ipex_prepack::lstm_prepack expects the 3-D input size");
+  int64_t num_directions = bidirectional ? 2 : 1;
+  int64_t stride = has_biases ? 4 : 2;
+  TORCH_CHECK(
+      static_cast<int64_t>(params.size()) ==
+          num_layers * num_directions * stride,
+      "ipex_prepack::lstm_prepack expects ",
+      num_layers * num_directions * stride,
+      " params, but got ",
+      params.size());
+  int64_t seq_length = batch_first ? input_size[1] : input_size[0];
+  int64_t mini_batch = batch_first ? input_size[0] : input_size[1];
+
+  std::vector<ideep::tensor> weights_ih_packed, weights_hh_packed;
+  std::vector<at::Tensor> biases;
+  for (int64_t layer = 0; layer < num_layers; layer++) {
+    int64_t layer_input_size =
+        layer == 0 ? input_size[2] : hidden_size * num_directions;
+    for (int64_t direction = 0; direction < num_directions; direction++) {
+      auto index = (layer * num_directions + direction) * stride;
+      const auto& weight_ih = params[index];
+      const auto& weight_hh = params[index + 1];
+      auto weight_dtype = get_weight_dtype(weight_ih);
+      auto bias = has_biases
+          ? (params[index + 2] + params[index + 3]).contiguous()
+          : at::zeros(
+                {kNumGates * hidden_size},
+                weight_dtype == dtype::bf16 ? at::kBFloat16 : at::kFloat);
+
+      auto w1 = desc_only_tensor(
+          weights_desc(layer_input_size, hidden_size, weight_dtype));
+      auto w2 = desc_only_tensor(
+          weights_desc(hidden_size, hidden_size, weight_dtype));
+      auto x = desc_only_tensor(src_layer_desc(
+          seq_length, mini_batch, layer_input_size, weight_dtype));
+      auto hx =
+          desc_only_tensor(iter_desc(mini_batch, hidden_size, weight_dtype));
+      auto b = desc_only_tensor(
+          bias_desc(hidden_size, get_mkldnn_dtype(bias.scalar_type())));
+      desc packed_desc_ih, packed_desc_hh;
+      std::tie(packed_desc_ih, packed_desc_hh) =
+          get_lstm_inference_packed_weight_desc(
+              w1,
+              w2,
+              {seq_length, mini_batch, hidden_size},
+              x,
+              hx,
+              hx,
+              b,
+              /* reverse */ direction > 0);
+      weights_ih_packed.push_back(
+          pack_weight(weight_ih, w1.get_desc(), packed_desc_ih));
+      weights_hh_packed.push_back(
+          pack_weight(weight_hh, w2.get_desc(), packed_desc_hh));
+      biases.push_back(std::move(bias));
+    }
+  }
+  return ContextLstm{
+      std::move(weights_ih_packed),
+      std::move(weights_hh_packed),
+      std::move(biases),
+      seq_length,
+      mini_batch,
+      hidden_size,
+      num_layers,
+      bidirectional,
+      batch_first,
+  };
+}
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor> run(
+    const ContextLstm& context,
+    const at::Tensor& input,
+    const std::vector<at::Tensor>& hx) {
+  TORCH_CHECK(
+      hx.size() == 2, "ipex_prepack::lstm_run expects the hidden states h, c");
+  auto layer_input =
+      (context.batch_first_ ? input.transpose(0, 1) : input).contiguous();
+  auto hx_ = hx[0].contiguous();
+  auto cx_ = hx[1].contiguous();
+
+  int64_t num_directions = context.bidirectional_ ? 2 : 1;
+  std::vector<at::Tensor> layer_output(num_directions);
+  std::vector<at::Tensor> layer_hy(context.num_layers_ * num_directions);
+  std::vector<at::Tensor> layer_cy(context.num_layers_ * num_directions);
+  for (int64_t layer = 0; layer < context.num_layers_; layer++) {
+    for (int64_t direction = 0; direction < num_directions; direction++) {
+      auto index = layer * num_directions + direction;
+      auto outputs = run_layer(
+          context,
+          index,
+          layer_input,
+          hx_[index],
+          cx_[index],
+          /* reverse */ direction > 0);
+      layer_output[direction] = outputs[0];
+      layer_hy[index] = outputs[1];
+      layer_cy[index] = outputs[2];
+    }
+    layer_input = num_directions == 1
+        ? layer_output[0]
+        : at::cat(layer_output, /*output_channels*/ -1);
+  }
+  auto output =
+      context.batch_first_ ? layer_input.transpose(0, 1) : layer_input;
+  return std::make_tuple(
+      output, at::stack(layer_hy, 0), at::stack(layer_cy, 0));
+}
+
+} // namespace lstm
+} // namespace detail
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+#include "ContextLstm.h"
+#include "OpContext.h"
+
+namespace torch_ipex {
+namespace cpu {
+namespace detail {
+namespace lstm {
+
+c10::intrusive_ptr<LstmOpContext> createLstmPrePackOpContext(
+    std::vector<at::Tensor>&& params,
+    bool has_biases,
+    int64_t num_layers,
+    int64_t hidden_size,
+    bool bidirectional,
+    bool batch_first,
+    std::vector<int64_t>&& input_size);
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor> lstm_run(
+    const at::Tensor& input,
+    const std::vector<at::Tensor>& hx,
+    const c10::intrusive_ptr<LstmOpContext>& op_context);
+
+ContextLstm create(
+    const std::vector<at::Tensor>& params,
+    const bool has_biases,
+    const int64_t num_layers,
+    const int64_t hidden_size,
+    const bool bidirectional,
+    const bool batch_first,
+    const at::IntArrayRef input_size);
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor> run(
+    const ContextLstm& context,
+    const at::Tensor& input,
+    const std::vector<at::Tensor>& hx);
+
+} // namespace lstm
+} // namespace detail
+} // namespace cpu
+} // namespace torch_ipex
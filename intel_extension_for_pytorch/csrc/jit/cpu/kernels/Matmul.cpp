@@ -11,6 +11,7 @@
 #include <limits>
 
 #include "csrc/cpu/ideep/ideep.hpp"
+#include "csrc/utils/op_trace.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -32,9 +33,7 @@ at::Tensor dil_matmul_div(
     const at::Tensor& tensor2,
     at::Tensor out,
     const at::Tensor& div_input) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("dil_matmul_div_fallback", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("dil_matmul_div_fallback", std::vector<c10::IValue>({}));
   if (out.defined()) {
     at::matmul_out(out, tensor1, tensor2);
     return out.div(div_input);
@@ -62,9 +61,7 @@ at::Tensor dil_matmul_div(
     const at::Tensor& tensor2,
     at::Tensor out,
     const c10::Scalar& div_input) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("dil_matmul_div_scalar", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("dil_matmul_div_scalar", std::vector<c10::IValue>({}));
   auto dim_tensor1 = tensor1.dim();
   auto dim_tensor2 = tensor2.dim();
   if (dim_tensor1 == dim_tensor2 && dim_tensor1 >= 3) {
@@ -11,6 +11,7 @@
 #include <limits>
 
 #include "csrc/cpu/ideep/ideep.hpp"
+#include "csrc/utils/op_trace.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -22,9 +23,7 @@ at::Tensor dil_max_pool2d(
     at::IntArrayRef padding,
     at::IntArrayRef dilation,
     bool ceil_mode) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("dil_max_pool2d", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("dil_max_pool2d", std::vector<c10::IValue>({}));
   TORCH_CHECK(
       std::all_of(
           dilation.cbegin(), dilation.cend(), [](int64_t i) { return 1 == i; }),
@@ -36,7 +35,35 @@ at::Tensor dil_max_pool2d(
       padding,
       dilation,
       ceil_mode,
-      ideep::algorithm::pooling_max);
+      ideep::algorithm::pooling_max,
+      /* is_inference */ true);
+}
+
+at::Tensor dil_max_pool2d_relu(
+    const at::Tensor& input,
+    at::IntArrayRef kernel_size,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef dilation,
+    bool ceil_mode) {
+  IPEX_RECORD_FUNCTION("dil_max_pool2d_relu", std::vector<c10::IValue>({}));
+  TORCH_CHECK(
+      std::all_of(
+          dilation.cbegin(), dilation.cend(), [](int64_t i) { return 1 == i; }),
+      "dil_max_pool2d_relu does not support dilation case");
+  auto output = pooling_impl(
+      input,
+      kernel_size,
+      stride,
+      padding,
+      dilation,
+      ceil_mode,
+      ideep::algorithm::pooling_max,
+      /* is_inference */ true);
+  // relu and max commute, so relu(max_pool(x)) == max_pool(relu(x)), and the
+  // relu, whichever side it was on, is applied to the pooled output, which is
+  // kernel_size times smaller than the input.
+  return at::relu_(output);
 }
 
 } // namespace cpu
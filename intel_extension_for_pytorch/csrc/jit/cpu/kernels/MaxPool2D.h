@@ -15,6 +15,7 @@ namespace jit {
 // So we fake some op namespaces to workaround that.
 namespace ipex {
 static auto max_pool2d = Symbol::fromQualString("ipex::max_pool2d");
+static auto max_pool2d_relu = Symbol::fromQualString("ipex::max_pool2d_relu");
 
 } // namespace ipex
 
@@ -33,5 +34,13 @@ at::Tensor dil_max_pool2d(
     at::IntArrayRef dilation,
     bool ceil_mode);
 
+at::Tensor dil_max_pool2d_relu(
+    const at::Tensor& input,
+    at::IntArrayRef kernel_size,
+    at::IntArrayRef stride,
+    at::IntArrayRef padding,
+    at::IntArrayRef dilation,
+    bool ceil_mode);
+
 } // namespace cpu
 } // namespace torch_ipex
@@ -0,0 +1,128 @@
+#include "MemoryPlan.h"
+#include "csrc/utils/huge_pages.h"
+#include "csrc/utils/op_trace.h"
+
+#include <ATen/ATen.h>
+#include <ATen/record_function.h>
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+std::mutex& plansMutex() {
+  static std::mutex mutex;
+  return mutex;
+}
+
+std::vector<std::shared_ptr<const MemoryPlan>>& plans() {
+  static std::vector<std::shared_ptr<const MemoryPlan>> plans;
+  return plans;
+}
+
+// The arena of a plan on the calling thread. It only grows, and the buffers
+// of the last run are dead once the next run of the same graph begins.
+struct PlanState {
+  std::shared_ptr<const MemoryPlan> plan;
+  at::DataPtr arena;
+  size_t arena_size = 0;
+  bool active = false;
+};
+
+thread_local std::unordered_map<int64_t, PlanState> plan_states;
+
+bool inputsMatch(
+    const MemoryPlan& plan,
+    const std::vector<at::Tensor>& inputs) {
+  if (inputs.size() != plan.input_sizes.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < inputs.size(); i++) {
+    if (inputs[i].sizes() != at::IntArrayRef(plan.input_sizes[i]) ||
+        inputs[i].scalar_type() != plan.input_dtypes[i] ||
+        !inputs[i].device().is_cpu()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int64_t register_memory_plan(MemoryPlan plan) {
+  std::lock_guard<std::mutex> guard(plansMutex());
+  plans().push_back(std::make_shared<const MemoryPlan>(std::move(plan)));
+  return plans().size() - 1;
+}
+
+void memory_plan_begin(int64_t plan_id, const std::vector<at::Tensor>& inputs) {
+  auto& state = plan_states[plan_id];
+  if (!state.plan) {
+    std::lock_guard<std::mutex> guard(plansMutex());
+    TORCH_CHECK(
+        plan_id >= 0 && plan_id < static_cast<int64_t>(plans().size()),
+        "unknown memory plan ",
+        plan_id);
+    state.plan = plans()[plan_id];
+  }
+  state.active = inputsMatch(*state.plan, inputs);
+  if (state.active && state.arena_size < state.plan->arena_size) {
+    // drop the old arena first, so that the peak is not the sum of both.
+    state.arena.clear();
+    state.arena = huge_pages::allocate(state.plan->arena_size);
+    state.arena_size = state.plan->arena_size;
+  }
+}
+
+at::Tensor planned_buffer(int64_t plan_id, int64_t index) {
+  auto it = plan_states.find(plan_id);
+  TORCH_CHECK(
+      it != plan_states.end(),
+      "the memory plan ",
+      plan_id,
+      " is not started on this thread");
+  const auto& state = it->second;
+  const auto& buffer = state.plan->buffers.at(index);
+  auto options = at::TensorOptions().dtype(buffer.dtype);
+  if (!state.active) {
+    return at::empty({0}, options);
+  }
+  return at::from_blob(
+      static_cast<char*>(state.arena.get()) + buffer.offset,
+      buffer.sizes,
+      buffer.strides,
+      options);
+}
+
+at::Tensor convolution_run_out(
+    const at::Tensor& input,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context,
+    at::Tensor& out,
+    const ideep::attr_t& attr) {
+  IPEX_RECORD_FUNCTION(
+      "ipex_prepack::convolution_run_out", std::vector<c10::IValue>({}));
+  if (out.numel() == 0) {
+    return op_context->run(input, attr);
+  }
+  return op_context->run(input, out, attr);
+}
+
+at::Tensor linear_run_out(
+    const at::Tensor& input,
+    const c10::intrusive_ptr<LinearOpContext>& op_context,
+    at::Tensor& out,
+    const ideep::attr_t& attr) {
+  IPEX_RECORD_FUNCTION(
+      "ipex_prepack::linear_run_out", std::vector<c10::IValue>({}));
+  if (out.numel() == 0) {
+    return op_context->run(input, attr);
+  }
+  return op_context->run(input, out, attr);
+}
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "OpContext.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+// An intermediate tensor of the graph placed in the arena.
+struct PlannedBuffer {
+  size_t offset;
+  std::vector<int64_t> sizes;
+  std::vector<int64_t> strides;
+  at::ScalarType dtype;
+};
+
+// The static memory plan of a graph for the input shapes it was profiled
+// with. All the planned intermediates live in one arena of arena_size bytes,
+// at offsets chosen so that the buffers alive at the same time never overlap.
+struct MemoryPlan {
+  std::vector<std::vector<int64_t>> input_sizes;
+  std::vector<at::ScalarType> input_dtypes;
+  size_t arena_size = 0;
+  std::vector<PlannedBuffer> buffers;
+};
+
+// Keep the plan for the lifetime of the process, return its id.
+int64_t register_memory_plan(MemoryPlan plan);
+
+// Start a run of the graph of plan_id on the calling thread. The planned
+// buffers of the run are backed by the arena of this thread if the inputs
+// match the planned shapes, otherwise they are empty, so that the out
+// variants writing into them allocate their outputs as usual.
+void memory_plan_begin(int64_t plan_id, const std::vector<at::Tensor>& inputs);
+
+// Return the index-th buffer of plan_id for the current run.
+at::Tensor planned_buffer(int64_t plan_id, int64_t index);
+
+// The out variants of the prepacked convolution and linear, which write into
+// out if it is not empty.
+at::Tensor convolution_run_out(
+    const at::Tensor& input,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context,
+    at::Tensor& out,
+    const ideep::attr_t& attr);
+
+at::Tensor linear_run_out(
+    const at::Tensor& input,
+    const c10::intrusive_ptr<LinearOpContext>& op_context,
+    at::Tensor& out,
+    const ideep::attr_t& attr);
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -5,18 +5,335 @@
 #include "csrc/utils/utils.h"
 
 #include <ATen/Context.h>
+#include <ATen/Dispatch.h>
+#include <ATen/ExpandUtils.h>
 #include <ATen/InferSize.h>
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/functional.h>
+#include <ATen/cpu/vec/vec.h>
 #include <c10/util/Exception.h>
 #include <c10/util/Logging.h>
 #include <torch/csrc/autograd/function.h>
+#include <torch/library.h>
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
+#include <vector>
 
 #include "csrc/cpu/ideep/ideep.hpp"
+#include "csrc/utils/fast_path_stats.h"
+#include "csrc/utils/op_trace.h"
 
 namespace torch_ipex {
 namespace cpu {
 
+namespace {
+
+// The rows of a query block and the columns of a key block the blocked
+// attention computes the scores of at a time.
+constexpr int64_t kQueryBlock = 32;
+constexpr int64_t kKeyBlock = 64;
+
+inline float dot(const float* a, const float* b, int64_t n) {
+  using Vec = at::vec::Vectorized<float>;
+  auto acc = Vec(0.f);
+  int64_t i = 0;
+  for (; i <= n - Vec::size(); i += Vec::size()) {
+    acc = at::vec::fmadd(Vec::loadu(a + i), Vec::loadu(b + i), acc);
+  }
+  float sum = at::vec::vec_reduce_all<float>(
+      [](Vec& x, Vec& y) { return x + y; }, acc, Vec::size());
+  for (; i < n; i++) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+// y = y * scale + alpha * x
+inline void scale_axpy(
+    float* y,
+    float scale,
+    float alpha,
+    const float* x,
+    int64_t n) {
+  using Vec = at::vec::Vectorized<float>;
+  auto scale_vec = Vec(scale);
+  auto alpha_vec = Vec(alpha);
+  int64_t i = 0;
+  for (; i <= n - Vec::size(); i += Vec::size()) {
+    auto y_vec = Vec::loadu(y + i) * scale_vec;
+    at::vec::fmadd(Vec::loadu(x + i), alpha_vec, y_vec).store(y + i);
+  }
+  for (; i < n; i++) {
+    y[i] = y[i] * scale + alpha * x[i];
+  }
+}
+
+// Copies the rows [row, row + rows) of the 2D view src of strides
+// (row_stride, col_stride) to the dense float buffer dst.
+template <typename scalar_t>
+inline void pack_rows(
+    float* dst,
+    const scalar_t* src,
+    int64_t row,
+    int64_t rows,
+    int64_t cols,
+    int64_t row_stride,
+    int64_t col_stride) {
+  for (int64_t r = 0; r < rows; r++) {
+    auto src_row = src + (row + r) * row_stride;
+    for (int64_t c = 0; c < cols; c++) {
+      dst[r * cols + c] = static_cast<float>(src_row[c * col_stride]);
+    }
+  }
+}
+
+// The tiles of q_block x k_block of rel_qk of -inf only, i.e. of the scores
+// taking no part in the softmax, e.g. of the banded, the local or the padding
+// masks, as the uint8 [tile_batch, tile_head, q_blocks, k_blocks] of 0 for the
+// masked tiles, of which the dims of the batch and the head are of rel_qk
+// broadcast. Undefined if none of the tiles is masked.
+template <typename scalar_t>
+at::Tensor masked_tiles(
+    const at::Tensor& rel_qk,
+    int64_t q_len,
+    int64_t k_len,
+    int64_t q_block,
+    int64_t k_block) {
+  auto rel = rel_qk;
+  while (rel.dim() < 4) {
+    rel = rel.unsqueeze(0);
+  }
+  auto tile_batch = rel.size(0);
+  auto tile_head = rel.size(1);
+  auto q_blocks = (q_len + q_block - 1) / q_block;
+  auto k_blocks = (k_len + k_block - 1) / k_block;
+  // the rows and the columns of rel, of 1 if broadcast
+  auto rel_rows = rel.size(2);
+  auto rel_cols = rel.size(3);
+  auto rel_ptr = rel.data_ptr<scalar_t>();
+  auto tiles =
+      at::empty({tile_batch, tile_head, q_blocks, k_blocks}, at::kByte);
+  auto tiles_ptr = tiles.data_ptr<uint8_t>();
+  const auto neg_inf = -std::numeric_limits<float>::infinity();
+  at::parallel_for(
+      0, tile_batch * tile_head * q_blocks, 1, [&](int64_t begin, int64_t end) {
+        for (auto task = begin; task < end; task++) {
+          auto b = task / (tile_head * q_blocks);
+          auto h = task / q_blocks % tile_head;
+          auto q_start = rel_rows == 1 ? 0 : task % q_blocks * q_block;
+          auto q_end = rel_rows == 1 ? 1 : std::min(q_start + q_block, q_len);
+          auto rel_head = rel_ptr + b * rel.stride(0) + h * rel.stride(1);
+          for (int64_t kb = 0; kb < k_blocks; kb++) {
+            auto k_start = rel_cols == 1 ? 0 : kb * k_block;
+            auto k_end =
+                rel_cols == 1 ? 1 : std::min(k_start + k_block, k_len);
+            bool masked = true;
+            for (auto i = q_start; masked && i < q_end; i++) {
+              auto rel_row = rel_head + i * rel.stride(2);
+              for (auto j = k_start; j < k_end; j++) {
+                if (static_cast<float>(rel_row[j * rel.stride(3)]) !=
+                    neg_inf) {
+                  masked = false;
+                  break;
+                }
+              }
+            }
+            tiles_ptr[task * k_blocks + kb] = masked ? 0 : 1;
+          }
+        }
+      });
+  if (tiles.all().item<bool>()) {
+    return at::Tensor();
+  }
+  return tiles;
+}
+
+/**
+ * softmax(q * k / dim_per_head + alpha * rel_qk) * v over the last dim of the
+ * 4D q of [batch, head, q_len, head_size], k of [batch, head, head_size,
+ * k_len] and v of [batch, head, k_len, v_head_size]. Each task computes a
+ * block of query rows of a head, walking through the keys by blocks with the
+ * online softmax: the running max and sum of the rows are updated by each key
+ * block, and the partial output is rescaled to the new max before the block's
+ * probabilities times v are added. Only a q_block x k_block tile of the
+ * scores is alive at a time, the full score matrix is never written.
+ *
+ * The tiles of 0 in the uint8 tiles of [tile_batch, tile_head, q_blocks,
+ * k_blocks], if defined, are taken as masked out and skipped in both q * k
+ * and * v, the dims of the batch and the head of 1 broadcast. rel_qk may be
+ * undefined for 0.
+ **/
+template <typename scalar_t>
+void blocked_mha_kernel(
+    at::Tensor& output,
+    const at::Tensor& q,
+    const at::Tensor& k,
+    const at::Tensor& v,
+    const at::Tensor& rel_qk,
+    float alpha,
+    float dim_per_head,
+    int64_t q_block,
+    int64_t k_block,
+    const at::Tensor& tiles) {
+  auto batch = q.size(0);
+  auto head = q.size(1);
+  auto q_len = q.size(2);
+  auto head_size = q.size(3);
+  auto k_len = k.size(3);
+  auto v_head_size = v.size(3);
+  // broadcast to the scores, the broadcast dims are of stride 0
+  auto rel = rel_qk.defined() ? rel_qk.expand({batch, head, q_len, k_len})
+                              : at::Tensor();
+
+  auto q_ptr = q.data_ptr<scalar_t>();
+  auto k_ptr = k.data_ptr<scalar_t>();
+  auto v_ptr = v.data_ptr<scalar_t>();
+  auto rel_ptr = rel.defined() ? rel.data_ptr<scalar_t>() : nullptr;
+  auto out_ptr = output.data_ptr<scalar_t>();
+  auto scale = 1.f / dim_per_head;
+  auto q_blocks = (q_len + q_block - 1) / q_block;
+  auto k_blocks = (k_len + k_block - 1) / k_block;
+  auto tiles_ptr = tiles.defined() ? tiles.data_ptr<uint8_t>() : nullptr;
+  auto tile_batch = tiles.defined() ? tiles.size(0) : 1;
+  auto tile_head = tiles.defined() ? tiles.size(1) : 1;
+
+  at::parallel_for(
+      0, batch * head * q_blocks, 1, [&](int64_t begin, int64_t end) {
+        std::vector<float> q_buf(q_block * head_size);
+        std::vector<float> k_buf(k_block * head_size);
+        std::vector<float> v_buf(k_block * v_head_size);
+        std::vector<float> scores(q_block * k_block);
+        std::vector<float> acc(q_block * v_head_size);
+        std::vector<float> row_max(q_block);
+        std::vector<float> row_sum(q_block);
+        for (auto task = begin; task < end; task++) {
+          auto b = task / (head * q_blocks);
+          auto h = task / q_blocks % head;
+          auto q_start = task % q_blocks * q_block;
+          auto q_rows = std::min(q_block, q_len - q_start);
+          auto q_head = q_ptr + b * q.stride(0) + h * q.stride(1);
+          auto k_head = k_ptr + b * k.stride(0) + h * k.stride(1);
+          auto v_head = v_ptr + b * v.stride(0) + h * v.stride(1);
+          auto rel_head = rel_ptr
+              ? rel_ptr + b * rel.stride(0) + h * rel.stride(1)
+              : nullptr;
+          // the key tiles of the query block, nullptr if all of them are kept
+          auto tile_row = tiles_ptr
+              ? tiles_ptr +
+                  (((tile_batch == 1 ? 0 : b) * tile_head +
+                    (tile_head == 1 ? 0 : h)) *
+                       q_blocks +
+                   task % q_blocks) *
+                      k_blocks
+              : nullptr;
+
+          pack_rows(
+              q_buf.data(),
+              q_head,
+              q_start,
+              q_rows,
+              head_size,
+              q.stride(2),
+              q.stride(3));
+          std::fill(
+              row_max.begin(),
+              row_max.end(),
+              -std::numeric_limits<float>::infinity());
+          std::fill(row_sum.begin(), row_sum.end(), 0.f);
+          std::fill(acc.begin(), acc.end(), 0.f);
+
+          for (int64_t k_start = 0; k_start < k_len; k_start += k_block) {
+            if (tile_row && !tile_row[k_start / k_block]) {
+              continue;
+            }
+            auto k_cols = std::min(k_block, k_len - k_start);
+            // the key block as the rows of k transposed
+            pack_rows(
+                k_buf.data(),
+                k_head,
+                k_start,
+                k_cols,
+                head_size,
+                k.stride(3),
+                k.stride(2));
+            pack_rows(
+                v_buf.data(),
+                v_head,
+                k_start,
+                k_cols,
+                v_head_size,
+                v.stride(2),
+                v.stride(3));
+            for (int64_t i = 0; i < q_rows; i++) {
+              auto s = scores.data() + i * k_block;
+              auto rel_row = rel_head
+                  ? rel_head + (q_start + i) * rel.stride(2) +
+                      k_start * rel.stride(3)
+                  : nullptr;
+              auto block_max = -std::numeric_limits<float>::infinity();
+              for (int64_t j = 0; j < k_cols; j++) {
+                s[j] = dot(
+                           q_buf.data() + i * head_size,
+                           k_buf.data() + j * head_size,
+                           head_size) *
+                    scale;
+                if (rel_row) {
+                  s[j] +=
+                      alpha * static_cast<float>(rel_row[j * rel.stride(3)]);
+                }
+                block_max = std::max(block_max, s[j]);
+              }
+              auto new_max = std::max(row_max[i], block_max);
+              if (new_max == -std::numeric_limits<float>::infinity()) {
+                // all the scores so far are masked out
+                continue;
+              }
+              auto correction = std::exp(row_max[i] - new_max);
+              auto out_row = acc.data() + i * v_head_size;
+              auto block_sum = 0.f;
+              for (int64_t j = 0; j < k_cols; j++) {
+                auto p = std::exp(s[j] - new_max);
+                block_sum += p;
+                scale_axpy(
+                    out_row,
+                    j == 0 ? correction : 1.f,
+                    p,
+                    v_buf.data() + j * v_head_size,
+                    v_head_size);
+              }
+              row_sum[i] = row_sum[i] * correction + block_sum;
+              row_max[i] = new_max;
+            }
+          }
+
+          auto out_head = out_ptr + b * output.stride(0) + h * output.stride(1);
+          for (int64_t i = 0; i < q_rows; i++) {
+            auto out_row = out_head + (q_start + i) * output.stride(2);
+            auto inv_sum = 1.f / row_sum[i];
+            for (int64_t c = 0; c < v_head_size; c++) {
+              out_row[c] =
+                  static_cast<scalar_t>(acc[i * v_head_size + c] * inv_sum);
+            }
+          }
+        }
+      });
+}
+
+// the reasons are in the order of the conditions of dil_mha_scores_calc
+fast_path::FastPathCounter mha_scores_counter(
+    "mha_scores_calc",
+    {"not_last_dim",
+     "last_dim_broadcast",
+     "one_dim",
+     "unaligned",
+     "not_contiguous",
+     "dtype",
+     "alpha"});
+
+} // namespace
+
 /**
  * We tried to fuse Div+Matmul+Add+Softmax as a signel operator. But
  * the oneDNN matmul performance with binary postop is poor, then we splited
@@ -32,9 +349,7 @@ at::Tensor dil_mha_scores_calc(
     const at::Scalar& dim_per_head,
     const int64_t& softmax_dim,
     const at::IValue& dtype) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("dil_mha_scores_calc", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("dil_mha_scores_calc", std::vector<c10::IValue>({}));
   auto _dim_per_head = dim_per_head.to<float>();
   auto _alpha = alpha.to<float>();
   auto qk = at::Tensor();
@@ -53,8 +368,14 @@ at::Tensor dil_mha_scores_calc(
   bool aligned_64_bytes = rel_kv.size(rel_kv.ndimension() - 1) % 16 == 0;
   // Only support contiguous tensor
   bool is_contiguous = rel_kv.is_contiguous() && qk.is_contiguous();
-  if (is_last_dim && not_last_dim_broadcast && not_one_dim &&
-      aligned_64_bytes && is_contiguous && dtype.isNone() && _alpha == 1.0f) {
+  if (mha_scores_counter.check(
+          {is_last_dim,
+           not_last_dim_broadcast,
+           not_one_dim,
+           aligned_64_bytes,
+           is_contiguous,
+           dtype.isNone(),
+           _alpha == 1.0f})) {
     return jit::cpu::kernels::DivAddSoftmax(qk, rel_kv, _dim_per_head);
   } else {
     qk = at::div(qk, dim_per_head);
@@ -63,5 +384,146 @@ at::Tensor dil_mha_scores_calc(
   }
 }
 
+at::Tensor dil_mha(
+    const at::Tensor& q,
+    const at::Tensor& k,
+    const at::Tensor& v,
+    const at::Tensor& rel_qk,
+    const at::Scalar& alpha,
+    const at::Scalar& dim_per_head,
+    const int64_t& softmax_dim,
+    const at::IValue& dtype) {
+  IPEX_RECORD_FUNCTION("dil_mha", std::vector<c10::IValue>({}));
+  auto scalar_type = q.scalar_type();
+  // Only support the 4D q, k and v of the same batch and head
+  bool is_4d = q.dim() == 4 && k.dim() == 4 && v.dim() == 4 &&
+      rel_qk.dim() <= 4 && k.size(0) == q.size(0) && v.size(0) == q.size(0) &&
+      k.size(1) == q.size(1) && v.size(1) == q.size(1) &&
+      k.size(2) == q.size(3) && v.size(2) == k.size(3);
+  // Only support last dimension
+  bool is_last_dim = softmax_dim == -1 || softmax_dim == 3;
+  // Only support float and bfloat16 of the same dtype
+  bool is_supported_dtype =
+      (scalar_type == at::kFloat || scalar_type == at::kBFloat16) &&
+      k.scalar_type() == scalar_type && v.scalar_type() == scalar_type &&
+      rel_qk.scalar_type() == scalar_type && dtype.isNone();
+  if (!(is_4d && is_last_dim && is_supported_dtype) ||
+      !at::is_expandable_to(
+          rel_qk.sizes(),
+          std::vector<int64_t>{q.size(0), q.size(1), q.size(2), k.size(3)})) {
+    return at::matmul(
+        dil_mha_scores_calc(
+            q, k, rel_qk, alpha, dim_per_head, softmax_dim, dtype),
+        v);
+  }
+
+  auto output = at::empty(
+      {q.size(0), q.size(1), q.size(2), v.size(3)}, q.options());
+  AT_DISPATCH_FLOATING_TYPES_AND(
+      at::ScalarType::BFloat16, scalar_type, "dil_mha", [&] {
+        // the tiles of -inf of the rel_qk of the positive alpha are skipped
+        auto tiles = alpha.to<float>() > 0.f
+            ? masked_tiles<scalar_t>(
+                  rel_qk, q.size(2), k.size(3), kQueryBlock, kKeyBlock)
+            : at::Tensor();
+        blocked_mha_kernel<scalar_t>(
+            output,
+            q,
+            k,
+            v,
+            rel_qk,
+            alpha.to<float>(),
+            dim_per_head.to<float>(),
+            kQueryBlock,
+            kKeyBlock,
+            tiles);
+      });
+  return output;
+}
+
+at::Tensor block_sparse_mha(
+    const at::Tensor& q,
+    const at::Tensor& k,
+    const at::Tensor& v,
+    const at::Tensor& layout,
+    int64_t block_size,
+    double scale,
+    const c10::optional<at::Tensor>& attn_mask) {
+  IPEX_RECORD_FUNCTION("block_sparse_mha", std::vector<c10::IValue>({}));
+  auto scalar_type = q.scalar_type();
+  TORCH_CHECK(
+      q.dim() == 4 && k.dim() == 4 && v.dim() == 4 &&
+          k.size(0) == q.size(0) && v.size(0) == q.size(0) &&
+          k.size(1) == q.size(1) && v.size(1) == q.size(1) &&
+          k.size(3) == q.size(3) && v.size(2) == k.size(2),
+      "block_sparse_mha: expect the 4D q, k and v of the same batch and head");
+  TORCH_CHECK(
+      (scalar_type == at::kFloat || scalar_type == at::kBFloat16) &&
+          k.scalar_type() == scalar_type && v.scalar_type() == scalar_type,
+      "block_sparse_mha: only support the float and the bfloat16 q, k and v ",
+      "of the same dtype");
+  TORCH_CHECK(block_size > 0, "block_sparse_mha: expect a positive block_size");
+  auto batch = q.size(0);
+  auto head = q.size(1);
+  auto q_len = q.size(2);
+  auto k_len = k.size(2);
+  auto q_blocks = (q_len + block_size - 1) / block_size;
+  auto k_blocks = (k_len + block_size - 1) / block_size;
+  auto tiles = layout.dim() == 3 ? layout.unsqueeze(0) : layout;
+  TORCH_CHECK(
+      tiles.dim() == 4 && (tiles.size(0) == 1 || tiles.size(0) == batch) &&
+          (tiles.size(1) == 1 || tiles.size(1) == head) &&
+          tiles.size(2) == q_blocks && tiles.size(3) == k_blocks,
+      "block_sparse_mha: expect the layout of [head or 1, ",
+      q_blocks,
+      ", ",
+      k_blocks,
+      "] or [batch or 1, head or 1, ",
+      q_blocks,
+      ", ",
+      k_blocks,
+      "], but got ",
+      layout.sizes());
+  tiles = tiles.ne(0).to(at::kByte).contiguous();
+  at::Tensor rel;
+  if (attn_mask.has_value() && attn_mask.value().defined()) {
+    rel = attn_mask.value().to(scalar_type);
+    TORCH_CHECK(
+        rel.dim() <= 4 &&
+            at::is_expandable_to(
+                rel.sizes(),
+                std::vector<int64_t>{batch, head, q_len, k_len}),
+        "block_sparse_mha: expect the attn_mask broadcast to the scores");
+  }
+
+  auto output = at::empty({batch, head, q_len, v.size(3)}, q.options());
+  AT_DISPATCH_FLOATING_TYPES_AND(
+      at::ScalarType::BFloat16, scalar_type, "block_sparse_mha", [&] {
+        blocked_mha_kernel<scalar_t>(
+            output,
+            q,
+            k.transpose(2, 3),
+            v,
+            rel,
+            1.f,
+            static_cast<float>(1.0 / scale),
+            block_size,
+            block_size,
+            tiles);
+      });
+  return output;
+}
+
 } // namespace cpu
 } // namespace torch_ipex
+
+namespace {
+
+TORCH_LIBRARY_FRAGMENT(torch_ipex, m) {
+  m.def(
+      "block_sparse_mha(Tensor q, Tensor k, Tensor v, Tensor layout, "
+      "int block_size, float scale, Tensor? attn_mask=None) -> Tensor",
+      torch_ipex::cpu::block_sparse_mha);
+}
+
+} // namespace
@@ -19,5 +19,33 @@ at::Tensor dil_mha_scores_calc(
     const int64_t& softmax_dim,
     const at::IValue& dtype);
 
+// softmax(q * k / dim_per_head + alpha * rel_qk, softmax_dim) * v, without
+// materializing the scores for the 4D inputs of the last softmax dim.
+at::Tensor dil_mha(
+    const at::Tensor& q,
+    const at::Tensor& k,
+    const at::Tensor& v,
+    const at::Tensor& rel_qk,
+    const at::Scalar& alpha,
+    const at::Scalar& dim_per_head,
+    const int64_t& softmax_dim,
+    const at::IValue& dtype);
+
+// softmax(q * k^T * scale + attn_mask) * v of the block-sparse attention of
+// the 4D q of [batch, head, q_len, head_size], k of [batch, head, k_len,
+// head_size] and v of [batch, head, k_len, v_head_size], e.g. of the local,
+// the banded or the BigBird attention of the long documents. The blocks of
+// block_size x block_size of the scores of 0 in the layout of [head or 1,
+// q_blocks, k_blocks] or [batch or 1, head or 1, q_blocks, k_blocks] are
+// masked out, and skipped in both q * k^T and * v.
+at::Tensor block_sparse_mha(
+    const at::Tensor& q,
+    const at::Tensor& k,
+    const at::Tensor& v,
+    const at::Tensor& layout,
+    int64_t block_size,
+    double scale,
+    const c10::optional<at::Tensor>& attn_mask);
+
 } // namespace cpu
 } // namespace torch_ipex
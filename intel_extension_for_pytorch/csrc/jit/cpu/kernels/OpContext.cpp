@@ -2,10 +2,39 @@
 #include "ConvPacked.h"
 #include "ConvTransposePacked.h"
 #include "LinearPacked.h"
+#include "LstmPacked.h"
+
+#include <ATen/ATen.h>
+
+#include <functional>
+#include <numeric>
 
 namespace torch_ipex {
 namespace cpu {
 
+at::Tensor ConvolutionOpContext::get_depthwise_weight() {
+  std::call_once(depthwise_weight_once_, [this]() {
+    const ideep::tensor& packed_weight = get_packed_weight();
+    int64_t kernel = std::accumulate(
+        kernel_size_.begin(),
+        kernel_size_.end(),
+        int64_t(1),
+        std::multiplies<int64_t>());
+    // a group of an input channel each
+    if (groups_ != output_channel_ ||
+        packed_weight.get_nelems() != output_channel_ * kernel ||
+        packed_weight.get_data_type() != ideep::data_type::f32) {
+      return;
+    }
+    // [C, 1, kh, kw] of the public format, transposed to the channels of each
+    // tap of the kernel
+    auto weight = at::empty({output_channel_, kernel}, at::kFloat);
+    packed_weight.to_public(weight.data_ptr<float>(), ideep::data_type::f32);
+    depthwise_weight_ = weight.t().contiguous();
+  });
+  return depthwise_weight_;
+}
+
 c10::intrusive_ptr<ConvolutionOpContext> IpexConvolutionOpContext::
     create_context(
         at::Tensor&& weight,
@@ -92,6 +121,16 @@ at::Tensor& IpexLinearOpContext::run(
   return torch_ipex::cpu::detail::linear::run(op_context_, input, accumu, attr);
 }
 
+at::Tensor IpexLinearOpContext::get_packed_weight_qparams() {
+  // the scales and the compensation of the packed s8 weight of the dynamic
+  // quantized linear
+  if (!op_context_.is_dynamic_quantized()) {
+    return at::Tensor();
+  }
+  return at::stack(
+      {op_context_.weight_scales_, op_context_.weight_compensation_});
+}
+
 c10::intrusive_ptr<ConvTransposeOpContext> IpexConvTransposeOpContext::
     create_context(
         at::Tensor&& weight,
@@ -142,5 +181,38 @@ at::Tensor IpexConvTransposeOpContext::run(
       op_context_, input, attr);
 }
 
+c10::intrusive_ptr<LstmOpContext> IpexLstmOpContext::create_context(
+    std::vector<at::Tensor>&& params,
+    bool has_biases,
+    int64_t num_layers,
+    int64_t hidden_size,
+    bool bidirectional,
+    bool batch_first,
+    std::vector<int64_t>&& input_size) {
+  auto op_context = torch_ipex::cpu::detail::lstm::create(
+      params,
+      has_biases,
+      num_layers,
+      hidden_size,
+      bidirectional,
+      batch_first,
+      input_size);
+  return c10::make_intrusive<IpexLstmOpContext>(
+      std::move(params),
+      has_biases,
+      num_layers,
+      hidden_size,
+      bidirectional,
+      batch_first,
+      std::move(input_size),
+      std::move(op_context));
+}
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor> IpexLstmOpContext::run(
+    const at::Tensor& input,
+    const std::vector<at::Tensor>& hx) {
+  return torch_ipex::cpu::detail::lstm::run(op_context_, input, hx);
+}
+
 } // namespace cpu
 } // namespace torch_ipex
@@ -7,8 +7,12 @@
 #include "ContextConvTranspose.h"
 #include "ContextConvolution.h"
 #include "ContextLinear.h"
+#include "ContextLstm.h"
+#include "csrc/aten/cpu/PackedWeightSerialization.h"
 #include "csrc/cpu/ideep/ideep.hpp"
 
+#include <mutex>
+
 namespace torch_ipex {
 namespace cpu {
 
@@ -38,11 +42,14 @@ class ConvolutionOpContext : public torch::jit::CustomClassHolder {
   int64_t output_channel_;
   bool weight_is_channels_last_;
   bool weight_is_packed_;
+  // the weight of get_depthwise_weight, reordered on its first call
+  std::once_flag depthwise_weight_once_;
+  at::Tensor depthwise_weight_;
 
  public:
   SerializationTypeConvolutionPrePack unpack() {
     return std::make_tuple(
-        orig_weight_,
+        get_serialized_weight(),
         orig_bias_,
         stride_,
         padding_,
@@ -62,6 +69,43 @@ class ConvolutionOpContext : public torch::jit::CustomClassHolder {
       const at::Tensor& input,
       at::Tensor& accumu,
       const ideep::attr_t& attr) = 0;
+
+  // the parameters of the convolution, e.g. of the direct kernels fused with
+  // it
+  const std::vector<int64_t>& get_stride() const {
+    return stride_;
+  }
+  const std::vector<int64_t>& get_padding() const {
+    return padding_;
+  }
+  const std::vector<int64_t>& get_dilation() const {
+    return dilation_;
+  }
+  const std::vector<int64_t>& get_kernel_size() const {
+    return kernel_size_;
+  }
+  int64_t get_groups() const {
+    return groups_;
+  }
+  int64_t get_output_channel() const {
+    return output_channel_;
+  }
+  const c10::optional<at::Tensor>& get_bias() const {
+    return orig_bias_;
+  }
+
+  // The float weight [kh * kw, C] of the depthwise convolution, i.e. of C
+  // groups of C output channels, of the direct depthwise kernel. It is
+  // reordered from the packed weight on the first call, and undefined if the
+  // convolution is not a depthwise one of float.
+  at::Tensor get_depthwise_weight();
+
+ protected:
+  at::Tensor get_serialized_weight() {
+    return serialize_weight(orig_weight_, get_packed_weight());
+  }
+
+  virtual const ideep::tensor& get_packed_weight() = 0;
 };
 
 class IpexConvolutionOpContext final : public ConvolutionOpContext {
@@ -92,7 +136,9 @@ class IpexConvolutionOpContext final : public ConvolutionOpContext {
     input_size_ = std::move(input_size);
     groups_ = groups;
     output_channel_ = output_channel;
-    weight_is_channels_last_ = weight_is_channels_last;
+    // The memory format actually used by the op context, which is saved
+    // together with the serialized packed weight.
+    weight_is_channels_last_ = op_context_.weight_is_channels_last_;
     weight_is_packed_ = weight_is_packed;
   }
 
@@ -116,6 +162,11 @@ class IpexConvolutionOpContext final : public ConvolutionOpContext {
       bool weight_is_channels_last,
       bool weight_is_packed,
       std::vector<int64_t>&& input_size);
+
+ protected:
+  virtual const ideep::tensor& get_packed_weight() override {
+    return op_context_.weight_packed_;
+  }
 };
 
 // linear op
@@ -139,7 +190,7 @@ class LinearOpContext : public torch::jit::CustomClassHolder {
  public:
   SerializationTypeLinearPrePack unpack() {
     return std::make_tuple(
-        orig_weight_,
+        get_serialized_weight(),
         orig_bias_,
         out_features_,
         in_features_,
@@ -147,6 +198,10 @@ class LinearOpContext : public torch::jit::CustomClassHolder {
         weight_is_packed_);
   }
 
+  int64_t get_out_features() const {
+    return out_features_;
+  }
+
   virtual at::Tensor run(
       const at::Tensor& input,
       const ideep::attr_t& attr) = 0;
@@ -155,6 +210,17 @@ class LinearOpContext : public torch::jit::CustomClassHolder {
       const at::Tensor& input,
       at::Tensor& accumu,
       const ideep::attr_t& attr) = 0;
+
+ protected:
+  at::Tensor get_serialized_weight() {
+    return serialize_weight(
+        orig_weight_, get_packed_weight(), get_packed_weight_qparams());
+  }
+
+  virtual const ideep::tensor& get_packed_weight() = 0;
+
+  // The qparams saved with the packed weight if it is quantized.
+  virtual at::Tensor get_packed_weight_qparams() = 0;
 };
 
 class IpexLinearOpContext final : public LinearOpContext {
@@ -194,6 +260,13 @@ class IpexLinearOpContext final : public LinearOpContext {
       int64_t in_features,
       int64_t batch_size,
       bool weight_is_packed);
+
+ protected:
+  virtual const ideep::tensor& get_packed_weight() override {
+    return op_context_.weight_packed_;
+  }
+
+  virtual at::Tensor get_packed_weight_qparams() override;
 };
 
 // deconv op
@@ -229,7 +302,7 @@ class ConvTransposeOpContext : public torch::jit::CustomClassHolder {
  public:
   SerializationTypeConvTransposePrePack unpack() {
     return std::make_tuple(
-        orig_weight_,
+        get_serialized_weight(),
         orig_bias_,
         stride_,
         padding_,
@@ -246,6 +319,13 @@ class ConvTransposeOpContext : public torch::jit::CustomClassHolder {
   virtual at::Tensor run(
       const at::Tensor& input,
       const ideep::attr_t& attr) = 0;
+
+ protected:
+  at::Tensor get_serialized_weight() {
+    return serialize_weight(orig_weight_, get_packed_weight());
+  }
+
+  virtual const ideep::tensor& get_packed_weight() = 0;
 };
 
 class IpexConvTransposeOpContext final : public ConvTransposeOpContext {
@@ -278,7 +358,9 @@ class IpexConvTransposeOpContext final : public ConvTransposeOpContext {
     input_size_ = std::move(input_size);
     groups_ = groups;
     output_channel_ = output_channel;
-    weight_is_channels_last_ = weight_is_channels_last;
+    // The memory format actually used by the op context, which is saved
+    // together with the serialized packed weight.
+    weight_is_channels_last_ = op_context_.weight_is_channels_last_;
     weight_is_packed_ = weight_is_packed;
   }
 
@@ -298,6 +380,124 @@ class IpexConvTransposeOpContext final : public ConvTransposeOpContext {
       bool weight_is_channels_last,
       bool weight_is_packed,
       std::vector<int64_t>&& input_size);
+
+ protected:
+  virtual const ideep::tensor& get_packed_weight() override {
+    return op_context_.weight_packed_;
+  }
+};
+
+// lstm op
+using SerializationTypeLstmPrePack = std::tuple<
+    std::vector<at::Tensor>,
+    bool,
+    int64_t,
+    int64_t,
+    bool,
+    bool,
+    std::vector<int64_t>>;
+
+class LstmOpContext : public torch::jit::CustomClassHolder {
+ protected:
+  // weight_ih, weight_hh, bias_ih and bias_hh (only if has_biases_) of each
+  // layer and direction
+  std::vector<at::Tensor> orig_params_;
+  bool has_biases_;
+  int64_t num_layers_;
+  int64_t hidden_size_;
+  bool bidirectional_;
+  bool batch_first_;
+  std::vector<int64_t> input_size_;
+
+ public:
+  SerializationTypeLstmPrePack unpack() {
+    return std::make_tuple(
+        get_serialized_params(),
+        has_biases_,
+        num_layers_,
+        hidden_size_,
+        bidirectional_,
+        batch_first_,
+        input_size_);
+  }
+
+  virtual std::tuple<at::Tensor, at::Tensor, at::Tensor> run(
+      const at::Tensor& input,
+      const std::vector<at::Tensor>& hx) = 0;
+
+  // The sizes of the hidden states h and c of mini_batch, i.e.
+  // [num_layers * num_directions, mini_batch, hidden_size].
+  std::vector<int64_t> get_hidden_state_sizes(int64_t mini_batch) {
+    return {
+        num_layers_ * (bidirectional_ ? 2 : 1), mini_batch, hidden_size_};
+  }
+
+  bool get_batch_first() {
+    return batch_first_;
+  }
+
+ protected:
+  std::vector<at::Tensor> get_serialized_params() {
+    std::vector<at::Tensor> params(orig_params_);
+    size_t stride = has_biases_ ? 4 : 2;
+    for (size_t i = 0; i * stride < params.size(); i++) {
+      params[i * stride] =
+          serialize_weight(params[i * stride], get_packed_weight_ih(i));
+      params[i * stride + 1] =
+          serialize_weight(params[i * stride + 1], get_packed_weight_hh(i));
+    }
+    return params;
+  }
+
+  virtual const ideep::tensor& get_packed_weight_ih(int64_t index) = 0;
+  virtual const ideep::tensor& get_packed_weight_hh(int64_t index) = 0;
+};
+
+class IpexLstmOpContext final : public LstmOpContext {
+ private:
+  detail::ContextLstm op_context_;
+
+ public:
+  IpexLstmOpContext(
+      std::vector<at::Tensor>&& params,
+      bool has_biases,
+      int64_t num_layers,
+      int64_t hidden_size,
+      bool bidirectional,
+      bool batch_first,
+      std::vector<int64_t>&& input_size,
+      detail::ContextLstm&& op_context)
+      : op_context_(std::move(op_context)) {
+    orig_params_ = std::move(params);
+    has_biases_ = has_biases;
+    num_layers_ = num_layers;
+    hidden_size_ = hidden_size;
+    bidirectional_ = bidirectional;
+    batch_first_ = batch_first;
+    input_size_ = std::move(input_size);
+  }
+
+  virtual std::tuple<at::Tensor, at::Tensor, at::Tensor> run(
+      const at::Tensor& input,
+      const std::vector<at::Tensor>& hx) override;
+
+  static c10::intrusive_ptr<LstmOpContext> create_context(
+      std::vector<at::Tensor>&& params,
+      bool has_biases,
+      int64_t num_layers,
+      int64_t hidden_size,
+      bool bidirectional,
+      bool batch_first,
+      std::vector<int64_t>&& input_size);
+
+ protected:
+  virtual const ideep::tensor& get_packed_weight_ih(int64_t index) override {
+    return op_context_.weights_ih_packed_[index];
+  }
+
+  virtual const ideep::tensor& get_packed_weight_hh(int64_t index) override {
+    return op_context_.weights_hh_packed_[index];
+  }
 };
 
 } // namespace cpu
@@ -0,0 +1,63 @@
+#include "PackedWeightVariants.h"
+
+#include <utility>
+
+namespace torch_ipex {
+namespace cpu {
+namespace detail {
+
+constexpr size_t PackedWeightVariants::kDefaultCapacity;
+
+PackedWeightVariants::PackedWeightVariants(size_t capacity)
+    : capacity(capacity) {}
+
+bool PackedWeightVariants::find(
+    const std::vector<int64_t>& key,
+    ideep::tensor& packed_weight) {
+  for (auto it = this->variants.begin(); it != this->variants.end(); ++it) {
+    if (it->key == key) {
+      // Move the variant to the front.
+      this->variants.splice(this->variants.begin(), this->variants, it);
+      packed_weight = it->packed_weight;
+      return true;
+    }
+  }
+  return false;
+}
+
+ideep::tensor PackedWeightVariants::get(
+    const std::vector<int64_t>& key,
+    const std::function<ideep::tensor()>& pack) {
+  ideep::tensor packed_weight;
+  {
+    std::lock_guard<std::mutex> lock(this->variants_mutex);
+    if (this->find(key, packed_weight)) {
+      return packed_weight;
+    }
+  }
+  // Pack without the lock, so that the other shapes are not blocked.
+  packed_weight = pack();
+  std::lock_guard<std::mutex> lock(this->variants_mutex);
+  ideep::tensor cached_weight;
+  if (this->find(key, cached_weight)) {
+    // Another thread packed the same shape first, share its variant.
+    return cached_weight;
+  }
+  if (this->capacity == 0) {
+    return packed_weight;
+  }
+  this->variants.push_front(Entry{key, packed_weight});
+  while (this->variants.size() > this->capacity) {
+    this->variants.pop_back();
+  }
+  return packed_weight;
+}
+
+size_t PackedWeightVariants::size() {
+  std::lock_guard<std::mutex> lock(this->variants_mutex);
+  return this->variants.size();
+}
+
+} // namespace detail
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,58 @@
+#pragma once
+
+#include "csrc/cpu/ideep/ideep.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <vector>
+
+namespace torch_ipex {
+namespace cpu {
+namespace detail {
+
+/*PackedWeightVariants keeps the weight of one op context packed for the
+ * recent input shapes other than the one seen at prepack time, e.g. the
+ * recurring image resolutions of a detection model, so that these shapes run
+ * with the weight in their preferred format instead of reordering it on every
+ * call. The least recently used variant is dropped once there are more than
+ * capacity variants. It is shared by all the threads running the op context.*/
+class PackedWeightVariants {
+ public:
+  static constexpr size_t kDefaultCapacity = 8;
+
+  explicit PackedWeightVariants(size_t capacity = kDefaultCapacity);
+
+  // Returns the packed weight of the input shape key, which is created by pack
+  // on the first use of key.
+  ideep::tensor get(
+      const std::vector<int64_t>& key,
+      const std::function<ideep::tensor()>& pack);
+  size_t size();
+
+ private:
+  struct Entry {
+    std::vector<int64_t> key;
+    ideep::tensor packed_weight;
+  };
+
+  // Must be called with variants_mutex held.
+  bool find(const std::vector<int64_t>& key, ideep::tensor& packed_weight);
+
+  // The most recently used variant is at the front. There are only a few
+  // variants, so they are searched linearly.
+  std::list<Entry> variants;
+  size_t capacity;
+  std::mutex variants_mutex;
+
+  PackedWeightVariants(const PackedWeightVariants& packed_weight_variants) =
+      delete;
+  PackedWeightVariants& operator=(
+      const PackedWeightVariants& packed_weight_variants) = delete;
+};
+
+} // namespace detail
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,69 @@
+#include "ParallelBranch.h"
+
+#include <omp.h>
+#include <algorithm>
+
+#include "csrc/cpu/runtime/CPUPool.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+// The [begin, end) range of the branch_id-th slice when splitting size items
+// into num_branches slices. The branches share the items round robin if
+// there are more branches than items.
+std::pair<int64_t, int64_t> get_branch_range(
+    int64_t size,
+    int64_t branch_id,
+    int64_t num_branches) {
+  if (size < num_branches) {
+    int64_t begin = branch_id % size;
+    return {begin, begin + 1};
+  }
+  return {branch_id * size / num_branches,
+          (branch_id + 1) * size / num_branches};
+}
+
+} // namespace
+
+std::tuple<std::vector<int64_t>, int64_t> get_branch_cores() {
+  const auto& pinned_cpu_core_list = runtime::_get_pinned_cpu_core_list();
+  return std::make_tuple(
+      std::vector<int64_t>(
+          pinned_cpu_core_list.begin(), pinned_cpu_core_list.end()),
+      static_cast<int64_t>(omp_get_max_threads()));
+}
+
+void set_branch_cores(
+    const std::vector<int64_t>& cpu_core_list,
+    int64_t num_threads,
+    int64_t branch_id,
+    int64_t num_branches) {
+  if (num_branches <= 1 || omp_in_parallel()) {
+    return;
+  }
+  if (cpu_core_list.empty()) {
+    auto range = get_branch_range(
+        std::max<int64_t>(num_threads, 1), branch_id, num_branches);
+    int32_t branch_num_threads = range.second - range.first;
+    if (omp_get_max_threads() != branch_num_threads) {
+      omp_set_num_threads(branch_num_threads);
+    }
+    return;
+  }
+  auto range =
+      get_branch_range(cpu_core_list.size(), branch_id, num_branches);
+  std::vector<int32_t> branch_core_list(
+      cpu_core_list.begin() + range.first,
+      cpu_core_list.begin() + range.second);
+  // The forked branches run on the threads of the inter-op thread pool, which
+  // keep their pinned OMP team across the runs of the same slice.
+  if (branch_core_list != runtime::_get_pinned_cpu_core_list() ||
+      omp_get_max_threads() != static_cast<int32_t>(branch_core_list.size())) {
+    runtime::_pin_cpu_cores(branch_core_list);
+  }
+}
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <tuple>
+#include <vector>
+
+namespace torch_ipex {
+namespace cpu {
+
+// Return the cores pinned on the current thread by the runtime API (empty if
+// not pinned) and its number of OMP threads, which are shared by the branches
+// forked by ParallelizeIndependentBranches.
+std::tuple<std::vector<int64_t>, int64_t> get_branch_cores();
+
+// Run the OMP parallel regions of the current branch on its own slice of
+// cpu_core_list, or on its own share of num_threads if cpu_core_list is empty.
+void set_branch_cores(
+    const std::vector<int64_t>& cpu_core_list,
+    int64_t num_threads,
+    int64_t branch_id,
+    int64_t num_branches);
+
+} // namespace cpu
+} // namespace torch_ipex
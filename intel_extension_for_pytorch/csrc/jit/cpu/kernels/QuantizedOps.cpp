@@ -0,0 +1,262 @@
+#include "QuantizedOps.h"
+#include "csrc/utils/op_trace.h"
+
+#include <ATen/ATen.h>
+#include <ATen/Dispatch.h>
+#include <ATen/Parallel.h>
+#include <ATen/WrapDimUtils.h>
+#include <ATen/cpu/vec/vec.h>
+#include <ATen/native/quantized/affine_quantizer_base.h>
+#include <c10/util/Exception.h>
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+namespace torch_ipex {
+namespace cpu {
+
+namespace {
+
+using fVec = at::vec::Vectorized<float>;
+
+struct QParams {
+  double scale;
+  int64_t zero_point;
+};
+
+bool is_byte_qtype(at::ScalarType dtype) {
+  return dtype == at::kQInt8 || dtype == at::kQUInt8;
+}
+
+bool is_per_tensor_quantized(const at::Tensor& t, at::ScalarType dtype) {
+  return t.is_quantized() && t.qscheme() == at::kPerTensorAffine &&
+      t.scalar_type() == dtype;
+}
+
+QParams get_qparams(const at::Tensor& qt) {
+  return {qt.q_scale(), qt.q_zero_point()};
+}
+
+// The vectors dequantizing a vector of scalar_t of qparams q by
+// scale * (x - zero_point), folded into one fma of scale_neg_zp_premul.
+struct DequantizeVecs {
+  fVec scale;
+  fVec zero_point;
+  fVec scale_neg_zp_premul;
+
+  explicit DequantizeVecs(QParams q)
+      : scale(static_cast<float>(q.scale)),
+        zero_point(static_cast<float>(q.zero_point)),
+        scale_neg_zp_premul(static_cast<float>(-q.scale * q.zero_point)) {}
+};
+
+// out = quantize(dequantize(in)) from the qparams of in to out_q
+template <typename scalar_t>
+void requantize_kernel(
+    const scalar_t* in,
+    QParams in_q,
+    scalar_t* out,
+    QParams out_q,
+    int64_t len) {
+  using qVec = at::vec::Vectorized<scalar_t>;
+  const DequantizeVecs in_vecs(in_q);
+  const float inverse_scale = 1.f / out_q.scale;
+  int64_t i = 0;
+  for (; i <= len - qVec::size(); i += qVec::size()) {
+    auto values = qVec::loadu(in + i).dequantize(
+        in_vecs.scale, in_vecs.zero_point, in_vecs.scale_neg_zp_premul);
+    qVec::quantize(values, out_q.scale, out_q.zero_point, inverse_scale)
+        .store(out + i);
+  }
+  for (; i < len; i++) {
+    out[i] = at::native::quantize_val<scalar_t>(
+        out_q.scale,
+        out_q.zero_point,
+        at::native::dequantize_val(in_q.scale, in_q.zero_point, in[i]));
+  }
+}
+
+// out = quantize(dequantize(a) + dequantize(b)), of which the alpha of the
+// add is folded into the scale of b
+template <typename scalar_t>
+void add_kernel(
+    const scalar_t* a,
+    QParams a_q,
+    const scalar_t* b,
+    QParams b_q,
+    scalar_t* out,
+    QParams out_q,
+    int64_t len) {
+  using qVec = at::vec::Vectorized<scalar_t>;
+  const DequantizeVecs a_vecs(a_q);
+  const DequantizeVecs b_vecs(b_q);
+  const float inverse_scale = 1.f / out_q.scale;
+  int64_t i = 0;
+  for (; i <= len - qVec::size(); i += qVec::size()) {
+    auto a_values = qVec::loadu(a + i).dequantize(
+        a_vecs.scale, a_vecs.zero_point, a_vecs.scale_neg_zp_premul);
+    auto b_values = qVec::loadu(b + i).dequantize(
+        b_vecs.scale, b_vecs.zero_point, b_vecs.scale_neg_zp_premul);
+    for (size_t j = 0; j < a_values.size(); j++) {
+      a_values[j] = a_values[j] + b_values[j];
+    }
+    qVec::quantize(a_values, out_q.scale, out_q.zero_point, inverse_scale)
+        .store(out + i);
+  }
+  for (; i < len; i++) {
+    out[i] = at::native::quantize_val<scalar_t>(
+        out_q.scale,
+        out_q.zero_point,
+        at::native::dequantize_val(a_q.scale, a_q.zero_point, a[i]) +
+            at::native::dequantize_val(b_q.scale, b_q.zero_point, b[i]));
+  }
+}
+
+} // namespace
+
+at::Tensor dil_qadd(
+    const at::Tensor& qa,
+    const at::Tensor& qb,
+    const at::Scalar& alpha,
+    double o_scale,
+    int64_t o_zp,
+    at::ScalarType o_dtype) {
+  IPEX_RECORD_FUNCTION("ipex::qadd", std::vector<c10::IValue>({}));
+  if (!is_byte_qtype(o_dtype) || !is_per_tensor_quantized(qa, o_dtype) ||
+      !is_per_tensor_quantized(qb, o_dtype) || qa.sizes() != qb.sizes()) {
+    // e.g. the broadcast add
+    return at::quantize_per_tensor(
+        at::add(qa.dequantize(), qb.dequantize(), alpha),
+        o_scale,
+        o_zp,
+        o_dtype);
+  }
+  auto memory_format = qa.suggest_memory_format();
+  auto a = qa.contiguous(memory_format);
+  auto b = qb.contiguous(memory_format);
+  auto output = at::_empty_affine_quantized(
+      a.sizes(),
+      a.options().memory_format(memory_format),
+      o_scale,
+      o_zp,
+      c10::nullopt);
+  auto a_q = get_qparams(a);
+  auto b_q = get_qparams(b);
+  auto alpha_ = alpha.to<double>();
+  b_q.scale *= alpha_;
+  QParams out_q{o_scale, o_zp};
+  AT_DISPATCH_QINT_BYTE_TYPES(o_dtype, "qadd", [&] {
+    auto a_data = a.data_ptr<scalar_t>();
+    auto b_data = b.data_ptr<scalar_t>();
+    auto out_data = output.data_ptr<scalar_t>();
+    auto grain_size = at::internal::GRAIN_SIZE;
+    at::parallel_for(0, a.numel(), grain_size, [&](int64_t begin, int64_t end) {
+      add_kernel(
+          a_data + begin,
+          a_q,
+          b_data + begin,
+          b_q,
+          out_data + begin,
+          out_q,
+          end - begin);
+    });
+  });
+  return output;
+}
+
+at::Tensor dil_qcat(
+    const std::vector<at::Tensor>& qtensors,
+    int64_t dim,
+    double o_scale,
+    int64_t o_zp,
+    at::ScalarType o_dtype) {
+  IPEX_RECORD_FUNCTION("ipex::qcat", std::vector<c10::IValue>({}));
+  TORCH_CHECK(!qtensors.empty(), "qcat expects a non-empty list of tensors");
+  auto ndim = qtensors[0].dim();
+  dim = at::maybe_wrap_dim(dim, ndim);
+  bool quantized = is_byte_qtype(o_dtype);
+  for (auto& t : qtensors) {
+    quantized = quantized && is_per_tensor_quantized(t, o_dtype) &&
+        t.dim() == ndim;
+    for (int64_t d = 0; quantized && d < ndim; d++) {
+      quantized = d == dim || t.size(d) == qtensors[0].size(d);
+    }
+  }
+  if (!quantized) {
+    std::vector<at::Tensor> tensors;
+    for (auto& t : qtensors) {
+      tensors.push_back(t.is_quantized() ? t.dequantize() : t);
+    }
+    return at::quantize_per_tensor(
+        at::cat(tensors, dim), o_scale, o_zp, o_dtype);
+  }
+
+  // The dims from the outermost to the innermost in memory. The output is
+  // [outer, out_chunk] in memory, of which each input writes a sub-chunk,
+  // e.g. the channels of a pixel of the channels last tensors.
+  auto memory_format = qtensors[0].suggest_memory_format();
+  std::vector<int64_t> order(ndim);
+  std::iota(order.begin(), order.end(), 0);
+  if (memory_format == at::MemoryFormat::ChannelsLast) {
+    order = {0, 2, 3, 1};
+  } else if (memory_format == at::MemoryFormat::ChannelsLast3d) {
+    order = {0, 2, 3, 4, 1};
+  }
+  auto pos = std::find(order.begin(), order.end(), dim) - order.begin();
+  int64_t outer = 1;
+  for (int64_t k = 0; k < pos; k++) {
+    outer *= qtensors[0].size(order[k]);
+  }
+  std::vector<at::Tensor> inputs;
+  std::vector<int64_t> chunks;
+  std::vector<QParams> qparams;
+  int64_t out_chunk = 0;
+  auto out_sizes = qtensors[0].sizes().vec();
+  out_sizes[dim] = 0;
+  for (auto& t : qtensors) {
+    inputs.push_back(t.contiguous(memory_format));
+    int64_t chunk = 1;
+    for (int64_t k = pos; k < ndim; k++) {
+      chunk *= t.size(order[k]);
+    }
+    chunks.push_back(chunk);
+    qparams.push_back(get_qparams(t));
+    out_chunk += chunk;
+    out_sizes[dim] += t.size(dim);
+  }
+  auto output = at::_empty_affine_quantized(
+      out_sizes,
+      qtensors[0].options().memory_format(memory_format),
+      o_scale,
+      o_zp,
+      c10::nullopt);
+  QParams out_q{o_scale, o_zp};
+  AT_DISPATCH_QINT_BYTE_TYPES(o_dtype, "qcat", [&] {
+    std::vector<const scalar_t*> input_data;
+    for (auto& input : inputs) {
+      input_data.push_back(input.data_ptr<scalar_t>());
+    }
+    auto out_data = output.data_ptr<scalar_t>();
+    auto grain_size = std::max<int64_t>(
+        1, at::internal::GRAIN_SIZE / std::max<int64_t>(out_chunk, 1));
+    at::parallel_for(0, outer, grain_size, [&](int64_t begin, int64_t end) {
+      for (int64_t o = begin; o < end; o++) {
+        auto dst = out_data + o * out_chunk;
+        for (size_t i = 0; i < inputs.size(); i++) {
+          auto src = input_data[i] + o * chunks[i];
+          if (qparams[i].scale == o_scale && qparams[i].zero_point == o_zp) {
+            std::memcpy(dst, src, chunks[i] * sizeof(scalar_t));
+          } else {
+            requantize_kernel(src, qparams[i], dst, out_q, chunks[i]);
+          }
+          dst += chunks[i];
+        }
+      }
+    });
+  });
+  return output;
+}
+
+} // namespace cpu
+} // namespace torch_ipex
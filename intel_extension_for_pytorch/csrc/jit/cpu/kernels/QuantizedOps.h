@@ -0,0 +1,36 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+
+#include <c10/core/Scalar.h>
+#include <torch/csrc/jit/runtime/custom_operator.h>
+
+namespace torch_ipex {
+namespace cpu {
+
+// The int8 kernels of the ops gluing the int8 partitions, so that the
+// subgraph between them stays quantized. The inputs are per-tensor quantized
+// tensors of o_dtype (qint8 or quint8), which are requantized from their own
+// scales to o_scale and o_zp in registers. The other inputs are dequantized,
+// computed in fp32, and quantized.
+
+// o = quantize(dequantize(qa) + alpha * dequantize(qb)) of the same shape.
+at::Tensor dil_qadd(
+    const at::Tensor& qa,
+    const at::Tensor& qb,
+    const at::Scalar& alpha,
+    double o_scale,
+    int64_t o_zp,
+    at::ScalarType o_dtype);
+
+// o = quantize(cat([dequantize(q) for q in qtensors], dim)), the inputs of
+// the same scale and zero point as the output are copied as they are.
+at::Tensor dil_qcat(
+    const std::vector<at::Tensor>& qtensors,
+    int64_t dim,
+    double o_scale,
+    int64_t o_zp,
+    at::ScalarType o_dtype);
+
+} // namespace cpu
+} // namespace torch_ipex
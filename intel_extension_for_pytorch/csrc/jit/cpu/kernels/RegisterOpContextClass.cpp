@@ -4,6 +4,7 @@
 #include "ConvPacked.h"
 #include "ConvTransposePacked.h"
 #include "LinearPacked.h"
+#include "LstmPacked.h"
 #include "OpContext.h"
 
 namespace torch_ipex {
@@ -11,6 +12,7 @@ namespace cpu {
 using detail::conv_transpose2d::createConvTransposePrePackOpContext;
 using detail::convolution::createConvolutionPrePackOpContext;
 using detail::linear::createLinearPrePackOpContext;
+using detail::lstm::createLstmPrePackOpContext;
 
 TORCH_LIBRARY(ipex_prepack, m) {
   m.class_<ConvolutionOpContext>("ConvolutionOpContext")
@@ -72,6 +74,23 @@ TORCH_LIBRARY(ipex_prepack, m) {
                 std::move(std::get<10>(state)),
                 std::move(std::get<11>(state)));
           });
+  m.class_<LstmOpContext>("LstmOpContext")
+      .def_pickle(
+          [](const c10::intrusive_ptr<LstmOpContext>& op_context)
+              -> SerializationTypeLstmPrePack { // __getstate__
+            return op_context->unpack();
+          },
+          [](SerializationTypeLstmPrePack state)
+              -> c10::intrusive_ptr<LstmOpContext> { // __setstate__
+            return createLstmPrePackOpContext(
+                std::move(std::get<0>(state)),
+                std::move(std::get<1>(state)),
+                std::move(std::get<2>(state)),
+                std::move(std::get<3>(state)),
+                std::move(std::get<4>(state)),
+                std::move(std::get<5>(state)),
+                std::move(std::get<6>(state)));
+          });
   m.def(
       "convolution_prepack(Tensor W, Tensor? B, int[2] stride, "
       "int[2] padding, int[2] dilation, int[2] kernel_size, int groups, int "
@@ -90,6 +109,18 @@ TORCH_LIBRARY(ipex_prepack, m) {
       "bool input_is_channels_last, bool weight_is_prepacked, int[4] "
       "input_sizes) "
       "-> __torch__.torch.classes.ipex_prepack.ConvTransposeOpContext");
+  m.def(
+      "conv_transpose3d_prepack(Tensor W, Tensor? B, int[3] stride, "
+      "int[3] padding, int[3] output_padding, int groups, int[3] dilation, "
+      "int[3] kernel_size, int output_channel, "
+      "bool input_is_channels_last, bool weight_is_prepacked, int[5] "
+      "input_sizes) "
+      "-> __torch__.torch.classes.ipex_prepack.ConvTransposeOpContext");
+  m.def(
+      "lstm_prepack(Tensor[] params, bool has_biases, int num_layers, "
+      "int hidden_size, bool bidirectional, bool batch_first, "
+      "int[3] input_size) "
+      "-> __torch__.torch.classes.ipex_prepack.LstmOpContext");
 }
 
 TORCH_LIBRARY_IMPL(ipex_prepack, AutogradCPU, m) {
@@ -98,6 +129,10 @@ TORCH_LIBRARY_IMPL(ipex_prepack, AutogradCPU, m) {
   m.impl(
       "conv_transpose2d_prepack",
       TORCH_FN(createConvTransposePrePackOpContext));
+  m.impl(
+      "conv_transpose3d_prepack",
+      TORCH_FN(createConvTransposePrePackOpContext));
+  m.impl("lstm_prepack", TORCH_FN(createLstmPrePackOpContext));
 }
 
 } // namespace cpu
@@ -0,0 +1,48 @@
+#include "ScratchpadArena.h"
+
+#include <c10/core/CPUAllocator.h>
+
+#include "csrc/utils/memory_stats.h"
+
+namespace torch_ipex {
+namespace cpu {
+namespace detail {
+
+namespace {
+
+// the arenas are in use by their threads, so they are accounted only, and
+// are freed when their threads exit
+memory_stats::CacheAccount scratchpads_account("scratchpad_arenas");
+
+struct Arena {
+  at::DataPtr buffer;
+  size_t size = 0;
+
+  ~Arena() {
+    if (size > 0) {
+      scratchpads_account.update(-static_cast<int64_t>(size), -1);
+    }
+  }
+};
+
+thread_local Arena arena;
+
+} // namespace
+
+ideep::tensor ScratchpadArena::get(const ideep::tensor::desc& desc) {
+  size_t size = desc.get_size();
+  if (size > arena.size) {
+    // drop the old buffer first, so that the peak is not the sum of both.
+    arena.buffer.clear();
+    arena.buffer = c10::GetCPUAllocator()->allocate(size);
+    scratchpads_account.update(
+        static_cast<int64_t>(size - arena.size), arena.size == 0 ? 1 : 0);
+    arena.size = size;
+    memory_stats::enforce_memory_budget();
+  }
+  return ideep::tensor(desc, arena.buffer.get());
+}
+
+} // namespace detail
+} // namespace cpu
+} // namespace torch_ipex
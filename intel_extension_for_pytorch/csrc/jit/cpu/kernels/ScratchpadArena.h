@@ -0,0 +1,25 @@
+#pragma once
+
+#include "csrc/cpu/ideep/ideep.hpp"
+
+namespace torch_ipex {
+namespace cpu {
+namespace detail {
+
+/*ScratchpadArena is the buffer of the calling thread which backs the
+ * scratchpads of the primitives run by the op contexts. It only grows, so
+ * once the model has run it is of the size of the largest scratchpad, and the
+ * primitives of the model run on one thread share it instead of each holding
+ * its own. The threads running the same model, e.g. the streams of the
+ * Runtime Extension, each have their own arena.*/
+class ScratchpadArena {
+ public:
+  // Returns the scratchpad of desc backed by the arena of the calling thread.
+  // It is valid until the next call on the same thread, so it must be used by
+  // one primitive execution only.
+  static ideep::tensor get(const ideep::tensor::desc& desc);
+};
+
+} // namespace detail
+} // namespace cpu
+} // namespace torch_ipex
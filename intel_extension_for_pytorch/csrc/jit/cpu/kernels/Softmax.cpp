@@ -12,6 +12,7 @@
 #include <limits>
 
 #include "csrc/cpu/ideep/ideep.hpp"
+#include "csrc/utils/op_trace.h"
 
 namespace torch_ipex {
 namespace cpu {
@@ -21,9 +22,7 @@ at::Tensor dil_softmax(
     const at::Tensor& input,
     const int64_t dim,
     const at::IValue& dtype) {
-#if defined(IPEX_PROFILE_OP)
-  RECORD_FUNCTION("dil_softmax", std::vector<c10::IValue>({}));
-#endif
+  IPEX_RECORD_FUNCTION("dil_softmax", std::vector<c10::IValue>({}));
   auto half_to_float = false;
   if (!dtype.isNone()) {
     auto outtype = dtype.toScalarType();
@@ -0,0 +1,86 @@
+#include "UpsampleCat.h"
+#include "csrc/aten/cpu/UpSample.h"
+#include "csrc/utils/op_trace.h"
+
+#include <ATen/ATen.h>
+#include <ATen/native/UpSample.h>
+#include <ATen/record_function.h>
+
+namespace torch_ipex {
+namespace cpu {
+
+at::Tensor convolution_upsample_cat_run(
+    const at::Tensor& input,
+    const at::Tensor& skip,
+    bool skip_first,
+    const std::string& mode,
+    const c10::optional<std::vector<int64_t>>& output_size,
+    bool align_corners,
+    const c10::optional<std::vector<double>>& scale_factors,
+    bool fuse_relu,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context) {
+  IPEX_RECORD_FUNCTION(
+      "ipex_prepack::convolution_upsample_cat_run",
+      std::vector<c10::IValue>({}));
+  TORCH_CHECK(
+      mode == "nearest" || mode == "bilinear",
+      "unsupported upsample mode: ",
+      mode);
+  bool is_nearest = mode == "nearest";
+  auto attr = fuse_relu ? ideep::attr_t::fuse_relu() : ideep::attr_t();
+  c10::optional<at::IntArrayRef> osize = output_size.has_value()
+      ? c10::make_optional<at::IntArrayRef>(output_size.value())
+      : c10::nullopt;
+  c10::optional<at::ArrayRef<double>> scales = scale_factors.has_value()
+      ? c10::make_optional<at::ArrayRef<double>>(scale_factors.value())
+      : c10::nullopt;
+
+  // the concat buffer is channels last, of which the channel slices are
+  // written in place. Go the unfused way for the plain format, so as to
+  // keep the format of the output, and for the inputs aten::cat rejects.
+  bool is_fusible = input.dim() == 4 && skip.dim() == 4 &&
+      input.scalar_type() == skip.scalar_type() &&
+      input.suggest_memory_format() == at::MemoryFormat::ChannelsLast &&
+      skip.suggest_memory_format() == at::MemoryFormat::ChannelsLast;
+  std::vector<int64_t> upsampled_size;
+  if (is_fusible) {
+    auto hw = at::native::upsample::compute_output_size(
+        input.sizes(), osize, scales);
+    upsampled_size = {input.size(0), input.size(1), hw[0], hw[1]};
+    is_fusible = skip.size(0) == upsampled_size[0] &&
+        skip.size(2) == upsampled_size[2] && skip.size(3) == upsampled_size[3];
+  }
+  if (!is_fusible) {
+    auto upsampled = is_nearest
+        ? at::upsample_nearest2d(input, osize, scales)
+        : at::upsample_bilinear2d(input, osize, align_corners, scales);
+    auto cat = skip_first ? at::cat({skip, upsampled}, 1)
+                          : at::cat({upsampled, skip}, 1);
+    return op_context->run(cat, attr);
+  }
+
+  int64_t upsampled_channels = upsampled_size[1];
+  int64_t skip_channels = skip.size(1);
+  auto cat = at::empty(
+      {upsampled_size[0],
+       upsampled_channels + skip_channels,
+       upsampled_size[2],
+       upsampled_size[3]},
+      input.options().memory_format(at::MemoryFormat::ChannelsLast));
+  auto upsampled =
+      cat.narrow(1, skip_first ? skip_channels : 0, upsampled_channels);
+  auto scale_h = at::native::upsample::get_scale_value(scales, 0);
+  auto scale_w = at::native::upsample::get_scale_value(scales, 1);
+  if (is_nearest) {
+    upsample_nearest2d_kernel_impl(upsampled, input, scale_h, scale_w);
+  } else {
+    upsample_bilinear2d_kernel_impl(
+        upsampled, input, align_corners, scale_h, scale_w);
+  }
+  cat.narrow(1, skip_first ? 0 : upsampled_channels, skip_channels)
+      .copy_(skip);
+  return op_context->run(cat, attr);
+}
+
+} // namespace cpu
+} // namespace torch_ipex
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+#include <c10/util/Optional.h>
+
+#include <string>
+#include <vector>
+
+#include "OpContext.h"
+
+namespace torch_ipex {
+namespace cpu {
+
+// The convolution of the concat of the upsampled input and skip along the
+// channels, i.e. the decoder block of U-Net and FPN. The input is upsampled
+// by mode, "nearest" or "bilinear", straight into its channel slice of the
+// channels last concat buffer, which is the input of the convolution. So the
+// upsampled input and the concat are not materialized apart. The relu of the
+// convolution is fused if fuse_relu.
+at::Tensor convolution_upsample_cat_run(
+    const at::Tensor& input,
+    const at::Tensor& skip,
+    bool skip_first,
+    const std::string& mode,
+    const c10::optional<std::vector<int64_t>>& output_size,
+    bool align_corners,
+    const c10::optional<std::vector<double>>& scale_factors,
+    bool fuse_relu,
+    const c10::intrusive_ptr<ConvolutionOpContext>& op_context);
+
+} // namespace cpu
+} // namespace torch_ipex
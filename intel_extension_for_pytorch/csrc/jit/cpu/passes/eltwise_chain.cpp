@@ -0,0 +1,247 @@
+#include "eltwise_chain.h"
+
+#include <torch/csrc/jit/ir/alias_analysis.h>
+#include <torch/csrc/jit/jit_log.h>
+
+#include "csrc/jit/cpu/kernels/EltwiseChain.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace torch {
+namespace jit {
+namespace {
+
+using torch_ipex::cpu::EltwiseChainOp;
+using torch_ipex::cpu::eltwise_chain_scalar;
+
+const Symbol kEltwiseChain = Symbol::fromQualString("ipex::eltwise_chain");
+
+// The chain op of a node kind, and its number of inputs.
+struct ChainOp {
+  EltwiseChainOp op;
+  size_t num_inputs;
+};
+
+const std::unordered_map<Symbol, ChainOp>& chainOps() {
+  static const std::unordered_map<Symbol, ChainOp> ops = {
+      {aten::add, {EltwiseChainOp::Add, 3}},
+      {aten::sub, {EltwiseChainOp::Sub, 3}},
+      {aten::mul, {EltwiseChainOp::Mul, 2}},
+      {aten::div, {EltwiseChainOp::Div, 2}},
+      {aten::relu, {EltwiseChainOp::Relu, 1}},
+      {aten::sigmoid, {EltwiseChainOp::Sigmoid, 1}},
+      {aten::tanh, {EltwiseChainOp::Tanh, 1}},
+      {aten::exp, {EltwiseChainOp::Exp, 1}},
+      {Symbol::aten("gelu"), {EltwiseChainOp::Gelu, 1}},
+      {Symbol::aten("silu"), {EltwiseChainOp::Silu, 1}},
+  };
+  return ops;
+}
+
+c10::optional<double> toNumber(Value* v) {
+  auto ivalue = toIValue(v);
+  if (!ivalue) {
+    return c10::nullopt;
+  }
+  if (ivalue->isDouble()) {
+    return ivalue->toDouble();
+  }
+  if (ivalue->isInt()) {
+    return static_cast<double>(ivalue->toInt());
+  }
+  return c10::nullopt;
+}
+
+class ElementwiseChainFuser {
+ public:
+  explicit ElementwiseChainFuser(std::shared_ptr<Graph> graph)
+      : graph_(std::move(graph)), aliasDb_(graph_) {}
+
+  bool run(Block* block) {
+    bool changed = false;
+    std::vector<Node*> nodes(block->nodes().begin(), block->nodes().end());
+    for (Node* node : nodes) {
+      for (Block* sub : node->blocks()) {
+        changed |= run(sub);
+      }
+    }
+    // From the last node, so that each chain is collected from its tail.
+    for (auto it = nodes.rbegin(); it != nodes.rend(); it++) {
+      Node* root = *it;
+      if (fused_.count(root) || !isFusible(root)) {
+        continue;
+      }
+      auto group = collectGroup(root);
+      if (group.size() < 2) {
+        continue;
+      }
+      fuseGroup(root, group);
+      changed = true;
+    }
+    return changed;
+  }
+
+ private:
+  // An element-wise op on tensors of the same complete sizes and dtype,
+  // float or bfloat16, whose other operands are constant numbers.
+  bool isFusible(Node* node) {
+    auto it = chainOps().find(node->kind());
+    if (it == chainOps().end() ||
+        node->inputs().size() != it->second.num_inputs ||
+        node->outputs().size() != 1) {
+      return false;
+    }
+    auto type = node->output()->type()->cast<TensorType>();
+    if (!type || !type->scalarType() ||
+        (*type->scalarType() != at::kFloat &&
+         *type->scalarType() != at::kBFloat16)) {
+      return false;
+    }
+    auto sizes = type->sizes().concrete_sizes();
+    if (!sizes) {
+      return false;
+    }
+    for (size_t i = 0; i < node->inputs().size(); i++) {
+      Value* input = node->inputs()[i];
+      auto input_type = input->type()->cast<TensorType>();
+      if (!input_type) {
+        // the first operand is the tensor self
+        if (i == 0 || !toNumber(input)) {
+          return false;
+        }
+        continue;
+      }
+      // the alpha of add and sub is a scalar
+      if (i == 2 || input_type->scalarType() != type->scalarType() ||
+          input_type->sizes().concrete_sizes() != sizes) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // The nodes computing the chain ending at root, whose intermediates are
+  // only used inside the chain.
+  std::vector<Node*> collectGroup(Node* root) {
+    std::vector<Node*> group = {root};
+    std::unordered_set<Node*> in_group = {root};
+    for (size_t i = 0; i < group.size(); i++) {
+      for (Value* input : group[i]->inputs()) {
+        Node* producer = input->node();
+        if (in_group.count(producer) || fused_.count(producer) ||
+            producer->owningBlock() != root->owningBlock() ||
+            !isFusible(producer)) {
+          continue;
+        }
+        bool used_outside = std::any_of(
+            input->uses().begin(), input->uses().end(), [&](const Use& use) {
+              return !in_group.count(use.user);
+            });
+        // the producer is computed at the root, its inputs must not be
+        // written in between
+        bool inputs_written = std::any_of(
+            producer->inputs().begin(),
+            producer->inputs().end(),
+            [&](Value* v) { return aliasDb_.hasWriters(v); });
+        if (used_outside || inputs_written) {
+          continue;
+        }
+        group.push_back(producer);
+        in_group.insert(producer);
+      }
+    }
+    return group;
+  }
+
+  void fuseGroup(Node* root, std::vector<Node*>& group) {
+    std::sort(group.begin(), group.end(), [](Node* a, Node* b) {
+      return a->isBefore(b);
+    });
+    std::unordered_set<Node*> in_group(group.begin(), group.end());
+
+    // the tensors from outside of the chain are its inputs
+    std::vector<Value*> inputs;
+    std::unordered_map<Value*, int64_t> registers;
+    for (Node* node : group) {
+      for (Value* input : node->inputs()) {
+        if (input->type()->cast<TensorType>() &&
+            !in_group.count(input->node()) && !registers.count(input)) {
+          registers[input] = inputs.size();
+          inputs.push_back(input);
+        }
+      }
+    }
+
+    std::vector<double> scalars;
+    std::vector<int64_t> program;
+    int64_t next_register = inputs.size();
+    auto operandOf = [&](Value* v) -> int64_t {
+      if (v->type()->cast<TensorType>()) {
+        return registers.at(v);
+      }
+      scalars.push_back(*toNumber(v));
+      return eltwise_chain_scalar(scalars.size() - 1);
+    };
+    auto emit = [&](EltwiseChainOp op, int64_t a, int64_t b) {
+      program.insert(program.end(), {static_cast<int64_t>(op), a, b});
+      return next_register++;
+    };
+    for (Node* node : group) {
+      auto op = chainOps().at(node->kind()).op;
+      auto a = operandOf(node->inputs()[0]);
+      int64_t b = 0;
+      if (node->inputs().size() > 1) {
+        b = operandOf(node->inputs()[1]);
+      }
+      if (op == EltwiseChainOp::Add || op == EltwiseChainOp::Sub) {
+        auto alpha = *toNumber(node->inputs()[2]);
+        if (alpha != 1) {
+          if (b < 0) {
+            scalars[-b - 1] *= alpha;
+          } else {
+            b = emit(EltwiseChainOp::Mul, b, operandOf(node->inputs()[2]));
+          }
+        }
+      }
+      registers[node->output()] = emit(op, a, b);
+    }
+
+    WithInsertPoint guard(root);
+    auto list = graph_->insertNode(graph_->createList(
+        TensorType::get(), at::ArrayRef<Value*>(inputs)));
+    auto chain = graph_->insertNode(graph_->create(
+        kEltwiseChain,
+        {list->output(),
+         graph_->insertConstant(scalars),
+         graph_->insertConstant(program)},
+        1));
+    chain->output()->setType(root->output()->type());
+    root->output()->replaceAllUsesWith(chain->output());
+    GRAPH_DEBUG("Fused a chain of ", group.size(), " element-wise ops");
+    for (auto it = group.rbegin(); it != group.rend(); it++) {
+      fused_.insert(*it);
+      (*it)->destroy();
+    }
+  }
+
+  std::shared_ptr<Graph> graph_;
+  AliasDb aliasDb_;
+  // the destroyed nodes, which must not be visited again
+  std::unordered_set<Node*> fused_;
+};
+
+} // namespace
+
+bool FuseElementwiseChains(std::shared_ptr<Graph>& graph) {
+  bool changed = ElementwiseChainFuser(graph).run(graph->block());
+  if (changed) {
+    GRAPH_DUMP("After FuseElementwiseChains", graph);
+  }
+  return changed;
+}
+
+} // namespace jit
+} // namespace torch
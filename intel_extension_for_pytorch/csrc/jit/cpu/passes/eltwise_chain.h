@@ -0,0 +1,15 @@
+#pragma once
+
+#include <torch/csrc/jit/ir/ir.h>
+
+namespace torch {
+namespace jit {
+
+// Fuse the chains of element-wise ops left after the IPEX fusion, e.g. the
+// mul + sigmoid + mul of swish or the bias add + residual add following a
+// matmul or an ipex::batch_norm, into one ipex::eltwise_chain reading each
+// tensor once.
+bool FuseElementwiseChains(std::shared_ptr<Graph>& graph);
+
+} // namespace jit
+} // namespace torch
@@ -1,6 +1,9 @@
 
 #include "graph_rewrite.h"
 
+#include <torch/csrc/jit/frontend/code_template.h>
+#include <torch/csrc/jit/passes/frozen_conv_folding.h>
+
 namespace torch {
 namespace jit {
 namespace graph_rewrite {
@@ -130,6 +133,20 @@ void replaceConvolutionWithAtenConv(std::shared_ptr<Graph>& graph) {
         %r = aten::conv_transpose2d(%a, %w, %b, %stride, %padding, %output_padding, %groups, %dilation)
         return (%r) )";
 
+  std::string conv_transpose3d_for_deprecated_conv = R"(
+      graph(%a, %w, %b, %stride:int[], %padding:int[], %dilation:int[],
+          %transposed:bool, %output_padding:int[], %groups:int, %benchmark:bool,
+          %deterministic:bool, %cudnn_enabled:bool):
+        %r = aten::conv_transpose3d(%a, %w, %b, %stride, %padding, %output_padding, %groups, %dilation)
+        return (%r) )";
+
+  std::string conv_transpose3d = R"(
+      graph(%a, %w, %b, %stride:int[], %padding:int[], %dilation:int[],
+          %transposed:bool, %output_padding:int[], %groups:int, %benchmark:bool,
+          %deterministic:bool, %cudnn_enabled:bool, %allow_tf32:bool):
+        %r = aten::conv_transpose3d(%a, %w, %b, %stride, %padding, %output_padding, %groups, %dilation)
+        return (%r) )";
+
   // Filter the unsupported case
   auto filter_conv1d = [](const Match& match,
                           const std::unordered_map<std::string, Value*>& vmap) {
@@ -188,6 +205,18 @@ void replaceConvolutionWithAtenConv(std::shared_ptr<Graph>& graph) {
         }
         return calc_value_map["transposed"].toBool();
       };
+  auto filter_conv_transpose3d =
+      [](const Match& match,
+         const std::unordered_map<std::string, Value*>& vmap) {
+        auto calc_value_map = getConvParams(match, vmap);
+        if (calc_value_map["output_padding"].toIntList().size() != 3 ||
+            calc_value_map["stride"].toIntList().size() != 3 ||
+            calc_value_map["padding"].toIntList().size() != 3 ||
+            calc_value_map["dilation"].toIntList().size() != 3) {
+          return false;
+        }
+        return calc_value_map["transposed"].toBool();
+      };
 
   IpexSubgraphRewriter rewriter_conv1d;
   rewriter_conv1d.RegisterRewritePattern(convolution, conv1d);
@@ -218,6 +247,13 @@ void replaceConvolutionWithAtenConv(std::shared_ptr<Graph>& graph) {
   rewriter_conv_transpose2d.RegisterRewritePattern(
       convolution_deprecated, conv_transpose2d_for_deprecated_conv);
   rewriter_conv_transpose2d.runOnGraph(graph, filter_conv_transpose2d);
+
+  IpexSubgraphRewriter rewriter_conv_transpose3d;
+  rewriter_conv_transpose3d.RegisterRewritePattern(
+      convolution, conv_transpose3d);
+  rewriter_conv_transpose3d.RegisterRewritePattern(
+      convolution_deprecated, conv_transpose3d_for_deprecated_conv);
+  rewriter_conv_transpose3d.runOnGraph(graph, filter_conv_transpose3d);
 }
 
 void FuseShuffle(std::shared_ptr<Graph>& graph) {
@@ -314,6 +350,118 @@ void FuseShuffle(std::shared_ptr<Graph>& graph) {
   rewriter_shuffle_2d.runOnGraph(graph);
 }
 
+namespace {
+
+// Returns the input and the number of groups of a channel shuffle, i.e. of
+// aten::channel_shuffle or, with constant shapes, of its decomposition
+// view [n, g, c / g, h, w] => transpose(1, 2) => contiguous => view
+// [n, c, h, w], which moves the channel j * g + i to i * (c / g) + j.
+c10::optional<std::pair<Value*, int64_t>> getChannelShuffle(Value* v) {
+  auto n = v->node();
+  if (n->kind() == Symbol::aten("channel_shuffle")) {
+    auto groups = toIValue(n->input(1));
+    if (!groups.has_value() || !groups->isInt()) {
+      return c10::nullopt;
+    }
+    return std::make_pair(n->input(0), groups->toInt());
+  }
+  if (n->kind() != aten::view) {
+    return c10::nullopt;
+  }
+  auto contiguous = n->input(0)->node();
+  if (contiguous->kind() != aten::contiguous ||
+      contiguous->output()->uses().size() != 1) {
+    return c10::nullopt;
+  }
+  auto transpose = contiguous->input(0)->node();
+  if (transpose->kind() != aten::transpose ||
+      transpose->output()->uses().size() != 1) {
+    return c10::nullopt;
+  }
+  auto dim0 = toIValue(transpose->input(1));
+  auto dim1 = toIValue(transpose->input(2));
+  if (!dim0.has_value() || !dim1.has_value() ||
+      std::min(dim0->toInt(), dim1->toInt()) != 1 ||
+      std::max(dim0->toInt(), dim1->toInt()) != 2) {
+    return c10::nullopt;
+  }
+  auto view = transpose->input(0)->node();
+  if (view->kind() != aten::view || view->output()->uses().size() != 1) {
+    return c10::nullopt;
+  }
+  auto view_shape = toIValue(view->input(1));
+  auto flatten_shape = toIValue(n->input(1));
+  if (!view_shape.has_value() || !flatten_shape.has_value()) {
+    return c10::nullopt;
+  }
+  auto view_shape_val = view_shape->toIntVector();
+  auto flatten_shape_val = flatten_shape->toIntVector();
+  // the spatial dims have to be kept, or the shuffle is not a permutation of
+  // the channels
+  if (view_shape_val.size() != 5 || flatten_shape_val.size() != 4 ||
+      view_shape_val[1] <= 0 || view_shape_val[3] != flatten_shape_val[2] ||
+      view_shape_val[4] != flatten_shape_val[3] ||
+      (flatten_shape_val[1] != -1 &&
+       flatten_shape_val[1] != view_shape_val[1] * view_shape_val[2])) {
+    return c10::nullopt;
+  }
+  return std::make_pair(view->input(0), view_shape_val[1]);
+}
+
+} // namespace
+
+// Absorb a channel shuffle into the aten::conv2d reading it:
+// conv(shuffle(x), W) == conv(x, W'), where W' has the input channels of W
+// in the order of the shuffled ones, so that the frozen weight is permuted
+// once and the shuffle is not materialized at all. Only the convolutions
+// without groups are rewritten, as a grouped one would also need its
+// output channels permuted.
+void fuseShuffleWithConv(std::shared_ptr<Graph>& graph) {
+  std::vector<Node*> convs;
+  for (auto* n : graph->block()->nodes()) {
+    if (n->kind() == aten::conv2d) {
+      convs.push_back(n);
+    }
+  }
+
+  bool changed = false;
+  for (auto* conv : convs) {
+    auto shuffle = getChannelShuffle(conv->input(0));
+    auto weight = toIValue(conv->input(1));
+    auto groups = toIValue(conv->input(6));
+    if (!shuffle.has_value() || !weight.has_value() || !weight->isTensor() ||
+        !groups.has_value() || groups->toInt() != 1) {
+      continue;
+    }
+    auto weight_val = weight->toTensor();
+    int64_t channels = weight_val.size(1);
+    int64_t g = shuffle->second;
+    if (channels % g != 0) {
+      continue;
+    }
+    // the shuffled channel j * g + i is the input channel i * (c / g) + j
+    int64_t channels_per_group = channels / g;
+    auto index = at::empty({channels}, at::kLong);
+    auto index_data = index.data_ptr<int64_t>();
+    for (int64_t i = 0; i < g; i++) {
+      for (int64_t j = 0; j < channels_per_group; j++) {
+        index_data[i * channels_per_group + j] = j * g + i;
+      }
+    }
+    auto permuted_weight = weight_val.index_select(1, index).contiguous(
+        weight_val.suggest_memory_format());
+
+    WithInsertPoint guard(conv);
+    conv->replaceInput(1, graph->insertConstant(permuted_weight));
+    conv->replaceInput(0, shuffle->first);
+    changed = true;
+  }
+  if (changed) {
+    // the shuffles without any other consumer are gone
+    EliminateDeadCode(graph);
+  }
+}
+
 void FuseAddLayerNorm(std::shared_ptr<Graph>& graph) {
   std::string aten_add_layernorm = R"(
       graph(%add_a, %add_b, %alpha, %shape:int[], %w, %b, %eps:float, %cudnn_enable:bool):
@@ -329,6 +477,146 @@ void FuseAddLayerNorm(std::shared_ptr<Graph>& graph) {
   rewriter_aten.runOnGraph(graph);
 }
 
+void FuseRMSNorm(std::shared_ptr<Graph>& graph) {
+  // x * rsqrt(mean(x^2, -1, keepdim) + eps) * weight, of the weight on either
+  // side, and the one of the sum of the residual add ahead of it which is
+  // kept as the second output
+  auto rms_norm_template = CodeTemplate(R"(
+      graph(%x, %exponent, %dims, %keepdim, %dtype, %eps, %alpha, %weight):
+        %p = aten::pow(%x, %exponent)
+        %v = aten::mean(%p, %dims, %keepdim, %dtype)
+        %a = aten::add(%v, %eps, %alpha)
+        %r = aten::rsqrt(%a)
+        %h = aten::mul(%x, %r)
+        %o = ${weight_mul}
+        return (%o) )");
+  auto add_rms_norm_template = CodeTemplate(R"(
+      graph(%in, %res, %alpha2, %exponent, %dims, %keepdim, %dtype, %eps, %alpha, %weight):
+        %x = aten::add(%in, %res, %alpha2)
+        %p = aten::pow(%x, %exponent)
+        %v = aten::mean(%p, %dims, %keepdim, %dtype)
+        %a = aten::add(%v, %eps, %alpha)
+        %r = aten::rsqrt(%a)
+        %h = aten::mul(%x, %r)
+        %o = ${weight_mul}
+        return (%o, %x) )");
+  std::string fused_rms_norm = R"(
+      graph(%x, %exponent, %dims, %keepdim, %dtype, %eps, %alpha, %weight):
+        %o = ipex::rms_norm(%x, %weight, %eps)
+        return (%o) )";
+  std::string fused_add_rms_norm = R"(
+      graph(%in, %res, %alpha2, %exponent, %dims, %keepdim, %dtype, %eps, %alpha, %weight):
+        %o, %x = ipex::add_rms_norm(%in, %res, %weight, %eps)
+        return (%o, %x) )";
+
+  auto filter = [](const Match& match,
+                   const std::unordered_map<std::string, Value*>& vmap) {
+    const auto& match_vmap = match.values_map;
+    auto exponent = getIValue("exponent", match_vmap, vmap);
+    auto dims = getIValue("dims", match_vmap, vmap);
+    auto keepdim = getIValue("keepdim", match_vmap, vmap);
+    auto dtype = getIValue("dtype", match_vmap, vmap);
+    auto eps = getIValue("eps", match_vmap, vmap);
+    auto alpha = getIValue("alpha", match_vmap, vmap);
+    auto weight = getIValue("weight", match_vmap, vmap);
+    if (!exponent.has_value() || !dims.has_value() || !keepdim.has_value() ||
+        !dtype.has_value() || !eps.has_value() || !alpha.has_value() ||
+        !weight.has_value()) {
+      return false;
+    }
+    if (!(exponent->isInt() && exponent->toInt() == 2) &&
+        !(exponent->isDouble() && exponent->toDouble() == 2.0)) {
+      return false;
+    }
+    auto dims_value = dims->toIntVector();
+    if (dims_value.size() != 1 || dims_value[0] != -1 || !keepdim->toBool() ||
+        !dtype->isNone() || !eps->isDouble() || !alpha->isInt() ||
+        alpha->toInt() != 1) {
+      return false;
+    }
+    // the weight broadcast on the last dim only
+    if (!weight->isTensor() || weight->toTensor().dim() != 1 ||
+        weight->toTensor().size(0) == 1) {
+      return false;
+    }
+    if (vmap.find("alpha2") != vmap.end()) {
+      auto alpha2 = getIValue("alpha2", match_vmap, vmap);
+      if (!alpha2.has_value() || !alpha2->isInt() || alpha2->toInt() != 1) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  IpexSubgraphRewriter rewriter;
+  for (const auto& weight_mul :
+       {"aten::mul(%weight, %h)", "aten::mul(%h, %weight)"}) {
+    TemplateEnv env;
+    env.s("weight_mul", weight_mul);
+    rewriter.RegisterRewritePattern(
+        add_rms_norm_template.format(env), fused_add_rms_norm);
+    rewriter.RegisterRewritePattern(
+        rms_norm_template.format(env), fused_rms_norm);
+  }
+  rewriter.runOnGraph(graph, filter);
+}
+
+void FuseGroupNorm(std::shared_ptr<Graph>& graph) {
+  // instance_norm of the input stats, i.e. not of the running stats, is the
+  // group_norm of a group per channel
+  std::string instance_norm = R"(
+      graph(%input, %weight, %bias, %running_mean, %running_var, %use_input_stats, %momentum, %eps, %cudnn_enabled):
+        %o = aten::instance_norm(%input, %weight, %bias, %running_mean, %running_var, %use_input_stats, %momentum, %eps, %cudnn_enabled)
+        return (%o) )";
+  std::string instance_norm_to_group_norm = R"(
+      graph(%input, %weight, %bias, %running_mean, %running_var, %use_input_stats, %momentum, %eps, %cudnn_enabled):
+        %dim : int = prim::Constant[value=1]()
+        %num_groups : int = aten::size(%input, %dim)
+        %o = aten::group_norm(%input, %num_groups, %weight, %bias, %eps, %cudnn_enabled)
+        return (%o) )";
+  auto instance_norm_filter =
+      [](const Match& match,
+         const std::unordered_map<std::string, Value*>& vmap) {
+        const auto& match_vmap = match.values_map;
+        auto running_mean = getIValue("running_mean", match_vmap, vmap);
+        auto running_var = getIValue("running_var", match_vmap, vmap);
+        auto use_input_stats =
+            getIValue("use_input_stats", match_vmap, vmap);
+        return running_mean.has_value() && running_mean->isNone() &&
+            running_var.has_value() && running_var->isNone() &&
+            use_input_stats.has_value() && use_input_stats->toBool();
+      };
+  IpexSubgraphRewriter instance_norm_rewriter;
+  instance_norm_rewriter.RegisterRewritePattern(
+      instance_norm, instance_norm_to_group_norm);
+  instance_norm_rewriter.runOnGraph(graph, instance_norm_filter);
+
+  // group_norm + silu of the ResBlocks of the U-Nets, with the silu applied
+  // while the output of the group_norm is stored
+  auto group_norm_silu_template = CodeTemplate(R"(
+      graph(%input, %num_groups, %weight, %bias, %eps, %cudnn_enabled):
+        %n = aten::group_norm(%input, %num_groups, %weight, %bias, %eps, %cudnn_enabled)
+        ${silu}
+        return (%o) )");
+  std::string fused_group_norm_silu = R"(
+      graph(%input, %num_groups, %weight, %bias, %eps, %cudnn_enabled):
+        %o = ipex::group_norm_silu(%input, %num_groups, %weight, %bias, %eps)
+        return (%o) )";
+
+  IpexSubgraphRewriter rewriter;
+  for (const auto& silu :
+       {"%o = aten::silu(%n)",
+        "%o = aten::silu_(%n)",
+        "%s = aten::sigmoid(%n)\n        %o = aten::mul(%n, %s)",
+        "%s = aten::sigmoid(%n)\n        %o = aten::mul(%s, %n)"}) {
+    TemplateEnv env;
+    env.s("silu", silu);
+    rewriter.RegisterRewritePattern(
+        group_norm_silu_template.format(env), fused_group_norm_silu);
+  }
+  rewriter.runOnGraph(graph);
+}
+
 void FuseMHAScoreCalc(std::shared_ptr<Graph>& graph) {
   std::string div_matmul_add_softmax = R"(
       graph(%q:Tensor, %k: Tensor, %relative_qk: Tensor, %alpha:int, %dim_per_head:int, %softmax_dim:int, %dtype):
@@ -350,6 +638,37 @@ void FuseMHAScoreCalc(std::shared_ptr<Graph>& graph) {
         %scores = ipex::mha_scores_calc(%q, %k, %relative_qk, %alpha, %dim_per_head, %softmax_dim, %dtype)
         return (%scores) )";
 
+  // the whole attention of BERT, whose scores are only used by the matmul
+  // with v, is fused into a kernel not materializing the scores
+  std::string div_matmul_add_softmax_matmul = R"(
+      graph(%q:Tensor, %k: Tensor, %v: Tensor, %relative_qk: Tensor, %alpha:int, %dim_per_head:int, %softmax_dim:int, %dtype):
+        %_q = aten::div(%q, %dim_per_head)
+        %qk = aten::matmul(%_q, %k)
+        %_scores = aten::add(%qk, %relative_qk, %alpha)
+        %scores = aten::softmax(%_scores, %softmax_dim, %dtype)
+        %context = aten::matmul(%scores, %v)
+        return (%context) )";
+
+  std::string matmul_div_add_softmax_matmul = R"(
+      graph(%q:Tensor, %k: Tensor, %v: Tensor, %relative_qk: Tensor, %alpha:int, %dim_per_head:int, %softmax_dim:int, %dtype):
+        %qk = aten::matmul(%q, %k)
+        %_qk = aten::div(%qk, %dim_per_head)
+        %_scores = aten::add(%_qk, %relative_qk, %alpha)
+        %scores = aten::softmax(%_scores, %softmax_dim, %dtype)
+        %context = aten::matmul(%scores, %v)
+        return (%context) )";
+  std::string div_matmul_add_softmax_matmul_fusion = R"(
+      graph(%q:Tensor, %k: Tensor, %v: Tensor, %relative_qk: Tensor, %alpha:int, %dim_per_head:int, %softmax_dim:int, %dtype):
+        %context = ipex::mha(%q, %k, %v, %relative_qk, %alpha, %dim_per_head, %softmax_dim, %dtype)
+        return (%context) )";
+
+  IpexSubgraphRewriter attention_fusion;
+  attention_fusion.RegisterRewritePattern(
+      div_matmul_add_softmax_matmul, div_matmul_add_softmax_matmul_fusion);
+  attention_fusion.RegisterRewritePattern(
+      matmul_div_add_softmax_matmul, div_matmul_add_softmax_matmul_fusion);
+  attention_fusion.runOnGraph(graph);
+
   IpexSubgraphRewriter mha_fusion;
   mha_fusion.RegisterRewritePattern(
       div_matmul_add_softmax, div_matmul_add_softmax_fusion);
@@ -367,9 +686,44 @@ void replaceAtenMaxPool2dWithIpexMaxPool2d(std::shared_ptr<Graph>& graph) {
       graph(%a, %kernel_size:int[], %stride:int[], %padding:int[], %dilation:int[], %ceil_mode:bool):
         %r = ipex::max_pool2d(%a, %kernel_size, %stride, %padding, %dilation, %ceil_mode)
         return (%r) )";
+  // relu and max commute, so a relu on either side of the max_pool2d is
+  // folded into ipex::max_pool2d_relu, which applies it to the pooled output.
+  auto max_pool2d_relu = CodeTemplate(R"(
+      graph(%a, %kernel_size:int[], %stride:int[], %padding:int[], %dilation:int[], %ceil_mode:bool):
+        %x = aten::max_pool2d(%a, %kernel_size, %stride, %padding, %dilation, %ceil_mode)
+        %r = aten::${relu}(%x)
+        return (%r) )");
+  auto relu_max_pool2d = CodeTemplate(R"(
+      graph(%a, %kernel_size:int[], %stride:int[], %padding:int[], %dilation:int[], %ceil_mode:bool):
+        %x = aten::${relu}(%a)
+        %r = aten::max_pool2d(%x, %kernel_size, %stride, %padding, %dilation, %ceil_mode)
+        return (%r) )");
+  std::string ipex_max_pool2d_relu = R"(
+      graph(%a, %kernel_size:int[], %stride:int[], %padding:int[], %dilation:int[], %ceil_mode:bool):
+        %r = ipex::max_pool2d_relu(%a, %kernel_size, %stride, %padding, %dilation, %ceil_mode)
+        return (%r) )";
+  std::array<std::string, 2> relu_operators = {"relu", "relu_"};
   IpexSubgraphRewriter rewriter_max_pool2d;
+  for (const auto& relu : relu_operators) {
+    TemplateEnv env;
+    env.s("relu", relu);
+    rewriter_max_pool2d.RegisterRewritePattern(
+        max_pool2d_relu.format(env), ipex_max_pool2d_relu);
+    rewriter_max_pool2d.RegisterRewritePattern(
+        relu_max_pool2d.format(env), ipex_max_pool2d_relu);
+  }
   rewriter_max_pool2d.RegisterRewritePattern(max_pool2d, ipex_max_pool2d);
-  rewriter_max_pool2d.runOnGraph(graph);
+  // an in-place relu ahead of the max_pool2d writes its input, so it is only
+  // folded when nothing else reads that input.
+  auto filter = [](const Match& match,
+                   const std::unordered_map<std::string, Value*>& vmap) {
+    if (vmap.find("x") == vmap.end()) {
+      return true;
+    }
+    auto relu = match.values_map.at(vmap.at("x"))->node();
+    return relu->kind() != aten::relu_ || relu->input(0)->uses().size() == 1;
+  };
+  rewriter_max_pool2d.runOnGraph(graph, filter);
 }
 
 // replace aten::softmax to ipex::softmax during jit pass
@@ -403,6 +757,32 @@ void replaceAtenBatchNormWithIpexBatchNorm(std::shared_ptr<Graph>& graph) {
   rewriter_batch_norm.runOnGraph(graph);
 }
 
+// the frozen batch norm of e.g. the Detectron backbones, of which the stats
+// and the affine params are fixed, is the inference batch norm of eps 0, and
+// is folded into the weight and the bias of the conv ahead of it if any
+void foldConvWithFrozenBatchNorm(std::shared_ptr<Graph>& graph) {
+  std::string frozen_batch_norm = R"(
+      graph(%a, %weight, %bias, %running_mean, %running_var):
+        %r = torch_ipex::frozen_batch_norm(%a, %weight, %bias, %running_mean, %running_var)
+        return (%r) )";
+  std::string aten_batch_norm = R"(
+      graph(%a, %weight, %bias, %running_mean, %running_var):
+        %training : bool = prim::Constant[value=0]()
+        %momentum : float = prim::Constant[value=0.]()
+        %eps : float = prim::Constant[value=0.]()
+        %cudnn_enabled : bool = prim::Constant[value=0]()
+        %r = aten::batch_norm(%a, %weight, %bias, %running_mean, %running_var, %training, %momentum, %eps, %cudnn_enabled)
+        return (%r) )";
+
+  IpexSubgraphRewriter rewriter_frozen_batch_norm;
+  rewriter_frozen_batch_norm.RegisterRewritePattern(
+      frozen_batch_norm, aten_batch_norm);
+  rewriter_frozen_batch_norm.runOnGraph(graph);
+  // the ones not after a conv, or of the non constant params, are left to
+  // ipex::batch_norm
+  FoldFrozenConvBatchnorm(graph);
+}
+
 void replaceEmbeddingBagWithQEmbeddingBag(std::shared_ptr<Graph>& graph) {
   std::string qembedingbag = R"(
      graph(%weight, %input, %offsets, %sparse, %include_last_offset, %o_scale, %o_zp, %o_dtype):
@@ -492,6 +872,192 @@ void replaceInteractionWithQInteraction(std::shared_ptr<Graph>& graph) {
   }
 }
 
+namespace {
+
+// The quantized tensor dequantized by v, nullptr if v isn't dequantized.
+Value* getDequantizedInput(Value* v) {
+  Node* n = v->node();
+  if (n->kind() != Symbol::aten("dequantize") ||
+      !n->input(0)->type()->cast<TensorType>()) {
+    return nullptr;
+  }
+  return n->input(0);
+}
+
+// The quantize_per_tensor nodes of graph whose input is computed by kind.
+std::vector<Node*> getQuantizeOf(
+    std::shared_ptr<Graph>& graph,
+    const Symbol& kind) {
+  std::vector<Node*> quants;
+  for (auto* n : graph->block()->nodes()) {
+    if (n->kind() == Symbol::aten("quantize_per_tensor") &&
+        n->inputs().size() == 4 && n->input(0)->node()->kind() == kind &&
+        n->input(0)->uses().size() == 1) {
+      quants.push_back(n);
+    }
+  }
+  return quants;
+}
+
+} // namespace
+
+// From:
+// %a = aten::dequantize(%qa)
+// %b = aten::dequantize(%qb)
+// %r = aten::add(%a, %b, %alpha)
+// %qr = aten::quantize_per_tensor(%r, %o_scale, %o_zp, %o_dtype)
+// To:
+// %qr = ipex::qadd(%qa, %qb, %alpha, %o_scale, %o_zp, %o_dtype)
+// The dequantize nodes are kept if they have other uses.
+void replaceAddWithQAdd(std::shared_ptr<Graph>& graph) {
+  for (auto* quant : getQuantizeOf(graph, aten::add)) {
+    Node* add = quant->input(0)->node();
+    if (add->inputs().size() != 3 ||
+        !add->input(1)->type()->cast<TensorType>()) {
+      continue;
+    }
+    Value* qa = getDequantizedInput(add->input(0));
+    Value* qb = getDequantizedInput(add->input(1));
+    if (qa == nullptr || qb == nullptr) {
+      continue;
+    }
+    WithInsertPoint guard(quant);
+    Node* qadd = graph->insertNode(graph->create(
+        Symbol::fromQualString("ipex::qadd"),
+        {qa,
+         qb,
+         add->input(2),
+         quant->input(1),
+         quant->input(2),
+         quant->input(3)}));
+    qadd->output()->setType(quant->output()->type());
+    quant->output()->replaceAllUsesWith(qadd->output());
+    quant->destroy();
+  }
+  EliminateDeadCode(graph);
+}
+
+// From:
+// %dq0 = aten::dequantize(%q0)
+// ...
+// %input : Tensor[] = prim::ListConstruct(%dq0, ...)
+// %r = aten::cat(%input, %dim)
+// %qr = aten::quantize_per_tensor(%r, %o_scale, %o_zp, %o_dtype)
+// To:
+// %qinput : Tensor[] = prim::ListConstruct(%q0, ...)
+// %qr = ipex::qcat(%qinput, %dim, %o_scale, %o_zp, %o_dtype)
+void replaceCatWithQCat(std::shared_ptr<Graph>& graph) {
+  for (auto* quant : getQuantizeOf(graph, aten::cat)) {
+    Node* cat = quant->input(0)->node();
+    Node* list = cat->input(0)->node();
+    if (list->kind() != prim::ListConstruct ||
+        list->output()->uses().size() != 1) {
+      continue;
+    }
+    std::vector<Value*> qinputs;
+    for (auto* v : list->inputs()) {
+      Value* qinput = getDequantizedInput(v);
+      if (qinput == nullptr) {
+        break;
+      }
+      qinputs.push_back(qinput);
+    }
+    if (qinputs.size() != list->inputs().size()) {
+      continue;
+    }
+    WithInsertPoint guard(quant);
+    Value* qlist =
+        graph->insertNode(graph->createList(TensorType::get(), qinputs))
+            ->output();
+    Node* qcat = graph->insertNode(graph->create(
+        Symbol::fromQualString("ipex::qcat"),
+        {qlist,
+         cat->input(1),
+         quant->input(1),
+         quant->input(2),
+         quant->input(3)}));
+    qcat->output()->setType(quant->output()->type());
+    quant->output()->replaceAllUsesWith(qcat->output());
+    quant->destroy();
+  }
+  EliminateDeadCode(graph);
+}
+
+// From:
+// %e0 = torch_ipex::embedding_bag(%w0, %i0, %o0, %sparse, %include_last_offset)
+// ...
+// %input : Tensor[] = prim::ListConstruct(%dense, %e0, ...)
+// %out = torch_ipex::interaction_forward(%input)
+// To:
+// %out = ipex::embedding_bag_interaction(%dense, [%w0, ...], [%i0, ...],
+//            [%o0, ...], %include_last_offset)
+// so that the pooled bags are written to the interaction input directly.
+void fuseEmbeddingBagWithInteraction(std::shared_ptr<Graph>& graph) {
+  auto embedding_bag_kind = Symbol::fromQualString("torch_ipex::embedding_bag");
+  std::vector<Node*> interactions;
+  for (auto* n : graph->block()->nodes()) {
+    if (n->kind() ==
+        Symbol::fromQualString("torch_ipex::interaction_forward")) {
+      interactions.push_back(n);
+    }
+  }
+
+  for (auto* n : interactions) {
+    auto list_construct = n->input(0)->node();
+    if (list_construct->kind() != prim::ListConstruct ||
+        n->input(0)->uses().size() != 1 ||
+        list_construct->inputs().size() < 2) {
+      continue;
+    }
+    std::vector<Node*> bags;
+    c10::optional<bool> include_last_offset;
+    bool fusible = true;
+    for (size_t i = 1; fusible && i < list_construct->inputs().size(); i++) {
+      auto bag = list_construct->input(i)->node();
+      if (bag->kind() != embedding_bag_kind ||
+          bag->output()->uses().size() != 1) {
+        fusible = false;
+        break;
+      }
+      auto last_offset = toIValue(bag->input(4));
+      fusible = last_offset.has_value() && last_offset->isBool() &&
+          (!include_last_offset ||
+           *include_last_offset == last_offset->toBool());
+      if (fusible) {
+        include_last_offset = last_offset->toBool();
+        bags.push_back(bag);
+      }
+    }
+    if (!fusible) {
+      continue;
+    }
+
+    WithInsertPoint guard(n);
+    std::vector<std::vector<Value*>> bag_inputs(3);
+    for (auto* bag : bags) {
+      for (size_t j = 0; j < 3; j++) {
+        bag_inputs[j].push_back(bag->input(j));
+      }
+    }
+    std::vector<Value*> inputs = {list_construct->input(0)};
+    for (const auto& values : bag_inputs) {
+      inputs.push_back(
+          graph->insertNode(graph->createList(TensorType::get(), values))
+              ->output());
+    }
+    inputs.push_back(graph->insertConstant(*include_last_offset));
+    auto fused = graph->insertNode(graph->create(
+        Symbol::fromQualString("ipex::embedding_bag_interaction"), inputs));
+    fused->output()->setType(n->output()->type());
+    n->output()->replaceAllUsesWith(fused->output());
+    n->destroy();
+    list_construct->destroy();
+    for (auto* bag : bags) {
+      bag->destroy();
+    }
+  }
+}
+
 } // namespace graph_rewrite
 } // namespace jit
 } // namespace torch
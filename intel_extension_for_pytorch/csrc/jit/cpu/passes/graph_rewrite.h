@@ -25,26 +25,43 @@ c10::optional<IValue> getIValue(
 
 void replaceConvolutionWithAtenConv(std::shared_ptr<Graph>& graph);
 void FuseShuffle(std::shared_ptr<Graph>& graph);
+void fuseShuffleWithConv(std::shared_ptr<Graph>& graph);
 void FuseMHAScoreCalc(std::shared_ptr<Graph>& graph);
 void replaceAtenMaxPool2dWithIpexMaxPool2d(std::shared_ptr<Graph>& graph);
 
 void replaceAtenSoftmaxWithIpexSoftmax(std::shared_ptr<Graph>& graph);
+void foldConvWithFrozenBatchNorm(std::shared_ptr<Graph>& graph);
 void replaceAtenBatchNormWithIpexBatchNorm(std::shared_ptr<Graph>& graph);
 void replaceAtenLayerNormWithIpexLayerNorm(std::shared_ptr<Graph>& graph);
 void replaceEmbeddingBagWithQEmbeddingBag(std::shared_ptr<Graph>& graph);
 void replaceInteractionWithQInteraction(std::shared_ptr<Graph>& graph);
+void replaceAddWithQAdd(std::shared_ptr<Graph>& graph);
+void replaceCatWithQCat(std::shared_ptr<Graph>& graph);
+void fuseEmbeddingBagWithInteraction(std::shared_ptr<Graph>& graph);
 
 void insertPrePackedConv2dOp(std::shared_ptr<Graph>& graph);
 void fuseConvWithEltwise(std::shared_ptr<Graph>& graph);
 void fuseConvAddRelu(std::shared_ptr<Graph>& graph);
+void fuseConvWithUpsampleCat(std::shared_ptr<Graph>& graph);
+void fuseDepthwisePointwiseConv(std::shared_ptr<Graph>& graph);
 
 void insertPrePackedLinearOp(std::shared_ptr<Graph>& graph);
 void fuseLinearWithEltwise(std::shared_ptr<Graph>& graph);
 void fuseLinearAddRelu(std::shared_ptr<Graph>& graph);
+void fuseLinearGeluLinear(std::shared_ptr<Graph>& graph);
+void fuseAdaptiveAvgPoolLinear(std::shared_ptr<Graph>& graph);
 
 void FuseAddLayerNorm(std::shared_ptr<Graph>& graph);
+void FuseRMSNorm(std::shared_ptr<Graph>& graph);
+void FuseGroupNorm(std::shared_ptr<Graph>& graph);
 
-void insertPrePackedConvTranspose2dOp(std::shared_ptr<Graph>& graph);
+void insertPrePackedConvTransposeOp(std::shared_ptr<Graph>& graph);
+
+// fuse the eltwise ops left after conv, conv3d, deconv and linear as their
+// oneDNN post ops
+void fuseWithEltwisePostOps(std::shared_ptr<Graph>& graph);
+
+void insertPrePackedLstmOp(std::shared_ptr<Graph>& graph);
 
 } // namespace graph_rewrite
 } // namespace jit
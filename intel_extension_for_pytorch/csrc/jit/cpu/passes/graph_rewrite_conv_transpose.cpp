@@ -7,18 +7,25 @@ namespace torch {
 namespace jit {
 namespace graph_rewrite {
 
-void insertPrePackedConvTranspose2dOp(Block* b) {
+void insertPrePackedConvTransposeOp(Block* b) {
   for (Node* n : b->nodes()) {
     for (Block* block : n->blocks()) {
-      insertPrePackedConvTranspose2dOp(block);
+      insertPrePackedConvTransposeOp(block);
     }
-    // TODO: add conv_transpose3d
+    bool is_conv_transpose3d =
+        n->kind() == Symbol::fromQualString("aten::conv_transpose3d");
     if (n->kind() == Symbol::fromQualString("aten::conv_transpose2d") ||
-        n->kind() == Symbol::fromQualString("torch_ipex::conv_transpose2d")) {
+        n->kind() == Symbol::fromQualString("torch_ipex::conv_transpose2d") ||
+        is_conv_transpose3d) {
       WithInsertPoint guard(n);
       auto graph = n->owningGraph();
+      // the dims of the input and weight, of 2 or 3 spatial dims
+      size_t dim = is_conv_transpose3d ? 5 : 4;
       auto prepack_node = graph->create(
-          Symbol::fromQualString("ipex_prepack::conv_transpose2d_prepack"), 1);
+          Symbol::fromQualString(
+              is_conv_transpose3d ? "ipex_prepack::conv_transpose3d_prepack"
+                                  : "ipex_prepack::conv_transpose2d_prepack"),
+          1);
       auto input_size_option = n->inputs()
                                    .at(0)
                                    ->type()
@@ -27,12 +34,12 @@ void insertPrePackedConvTranspose2dOp(Block* b) {
                                    .concrete_sizes();
       // if can't get input shape info, will not do weight prepack.
       if (!(input_size_option.has_value() &&
-            input_size_option.value().size() == 4)) {
+            input_size_option.value().size() == dim)) {
         continue;
       }
       IValue input_size_value(input_size_option.value());
 
-      if (n->kind() == Symbol::fromQualString("aten::conv_transpose2d")) {
+      if (n->kind() != Symbol::fromQualString("torch_ipex::conv_transpose2d")) {
         auto weight_size_option = n->inputs()
                                       .at(1)
                                       ->type()
@@ -41,11 +48,11 @@ void insertPrePackedConvTranspose2dOp(Block* b) {
                                       .concrete_sizes();
         // weight has not shape info, will not do weight prapacked.
         if (!(weight_size_option.has_value() &&
-              weight_size_option.value().size() == 4)) {
+              weight_size_option.value().size() == dim)) {
           continue;
         }
         auto weight_size = weight_size_option.value();
-        std::vector<int64_t> k_size = {weight_size[2], weight_size[3]};
+        std::vector<int64_t> k_size(weight_size.begin() + 2, weight_size.end());
         // w_is_channels_last is invaild, there will has a check the memory
         // format at convolution kernel side.
         bool w_is_channels_last = false;
@@ -82,7 +89,10 @@ void insertPrePackedConvTranspose2dOp(Block* b) {
 
       graph->insertNode(prepack_node);
       auto prepack_conv_transpose = graph->insertNode(graph->create(
-          Symbol::fromQualString("ipex_prepack::conv_transpose2d_run"), 1));
+          Symbol::fromQualString(
+              is_conv_transpose3d ? "ipex_prepack::conv_transpose3d_run"
+                                  : "ipex_prepack::conv_transpose2d_run"),
+          1));
       prepack_conv_transpose->addInput(n->inputs().at(0));
       prepack_conv_transpose->addInput(prepack_node->output());
       prepack_conv_transpose->output()->setType(
@@ -94,8 +104,8 @@ void insertPrePackedConvTranspose2dOp(Block* b) {
   EliminateDeadCode(b);
 }
 
-void insertPrePackedConvTranspose2dOp(std::shared_ptr<Graph>& graph) {
-  insertPrePackedConvTranspose2dOp(graph->block());
+void insertPrePackedConvTransposeOp(std::shared_ptr<Graph>& graph) {
+  insertPrePackedConvTransposeOp(graph->block());
 }
 
 } // namespace graph_rewrite
@@ -0,0 +1,251 @@
+#include "graph_rewrite.h"
+#include "graph_rewrite_utils.h"
+
+#include <torch/csrc/jit/frontend/code_template.h>
+
+#include <string>
+#include <vector>
+
+namespace torch {
+namespace jit {
+namespace graph_rewrite {
+
+namespace {
+
+// An op producing %x in a pattern, and its fused op taking the eltwise post
+// op arguments in place of ${post_op}.
+struct BasePattern {
+  std::string inputs;
+  std::string run;
+  std::string fused_run;
+  // whether the fused op writes the post op result inplace to %accumu
+  bool writes_accumu;
+  // whether a dedicated fusion already takes the relu, e.g. ipex::conv3d_relu
+  // of OpFuser
+  bool skip_relu;
+};
+
+// An eltwise op consuming %x in a pattern. post_alpha, post_beta and
+// post_scale are either the values of the pattern or constant literals.
+struct EltwisePattern {
+  std::string name;
+  std::string inputs;
+  std::vector<std::string> bodies;
+  std::string post_alpha;
+  std::string post_beta;
+  std::string post_scale;
+  MatchFilter filter;
+};
+
+const std::vector<BasePattern>& basePatterns() {
+  static const std::vector<BasePattern> patterns = {
+      {"%input, %packed_weight",
+       "%x = ipex_prepack::convolution_run(%input, %packed_weight)",
+       "ipex_prepack::convolution_eltwise_run(%input, ${post_op}, %packed_weight)",
+       false,
+       false},
+      // the post-sum chains of conv + add + eltwise
+      {"%input, %accumu, %alpha, %packed_weight",
+       "%x = ipex_prepack::convolution_add_run(%input, %accumu, %alpha, %packed_weight)",
+       "ipex_prepack::convolution_add_eltwise_run(%input, %accumu, %alpha, ${post_op}, %packed_weight)",
+       true,
+       false},
+      {"%input, %packed_weight",
+       "%x = ipex_prepack::linear_run(%input, %packed_weight)",
+       "ipex_prepack::linear_eltwise_run(%input, ${post_op}, %packed_weight)",
+       false,
+       false},
+      {"%input, %accumu, %alpha, %packed_weight",
+       "%x = ipex_prepack::linear_add_run(%input, %accumu, %alpha, %packed_weight)",
+       "ipex_prepack::linear_add_eltwise_run(%input, %accumu, %alpha, ${post_op}, %packed_weight)",
+       true,
+       false},
+      {"%input, %packed_weight",
+       "%x = ipex_prepack::conv_transpose2d_run(%input, %packed_weight)",
+       "ipex_prepack::conv_transpose2d_eltwise_run(%input, ${post_op}, %packed_weight)",
+       false,
+       false},
+      {"%input, %packed_weight",
+       "%x = ipex_prepack::conv_transpose3d_run(%input, %packed_weight)",
+       "ipex_prepack::conv_transpose3d_eltwise_run(%input, ${post_op}, %packed_weight)",
+       false,
+       false},
+      {"%input, %weight, %bias, %stride:int[], %padding:int[], %dilation:int[], %groups:int",
+       "%x = aten::conv3d(%input, %weight, %bias, %stride, %padding, %dilation, %groups)",
+       "ipex::conv3d_eltwise(%input, %weight, %bias, %stride, %padding, %dilation, %groups, ${post_op})",
+       false,
+       true},
+  };
+  return patterns;
+}
+
+// The bodies of the out-of-place and inplace variants of aten::op.
+std::vector<std::string> eltwiseBodies(
+    const std::string& op,
+    const std::string& args = "") {
+  return {
+      "%res = aten::" + op + "(%x" + args + ")",
+      "%res = aten::" + op + "_(%x" + args + ")"};
+}
+
+MatchFilter noFilter() {
+  return [](const Match&, const std::unordered_map<std::string, Value*>&) {
+    return true;
+  };
+}
+
+const std::vector<EltwisePattern>& eltwisePatterns() {
+  // x * sigmoid(x) must be matched before its sigmoid alone
+  static const std::vector<EltwisePattern> patterns = {
+      {"swish",
+       "",
+       {"%y = aten::sigmoid(%x)\n        %res = aten::mul(%x, %y)",
+        "%y = aten::sigmoid(%x)\n        %res = aten::mul_(%x, %y)",
+        "%y = aten::sigmoid_(%x)\n        %res = aten::mul(%x, %y)",
+        "%y = aten::sigmoid_(%x)\n        %res = aten::mul_(%x, %y)"},
+       "1.0",
+       "0.0",
+       "1.0",
+       noFilter()},
+      {"swish", "", eltwiseBodies("silu"), "1.0", "0.0", "1.0", noFilter()},
+      {"relu", "", eltwiseBodies("relu"), "0.0", "0.0", "1.0", noFilter()},
+      {"leaky_relu",
+       ", %negative_slope",
+       eltwiseBodies("leaky_relu", ", %negative_slope"),
+       "%negative_slope",
+       "0.0",
+       "1.0",
+       noFilter()},
+      {"sigmoid",
+       "",
+       eltwiseBodies("sigmoid"),
+       "0.0",
+       "0.0",
+       "1.0",
+       noFilter()},
+      {"tanh", "", eltwiseBodies("tanh"), "0.0", "0.0", "1.0", noFilter()},
+      {"clamp",
+       ", %min_val, %max_val",
+       eltwiseBodies("hardtanh", ", %min_val, %max_val"),
+       "%min_val",
+       "%max_val",
+       "1.0",
+       noFilter()},
+      {"clamp",
+       ", %min_val, %max_val",
+       eltwiseBodies("clamp", ", %min_val, %max_val"),
+       "%min_val",
+       "%max_val",
+       "1.0",
+       // oneDNN clips between two bounds
+       [](const Match& match,
+          const std::unordered_map<std::string, Value*>& vmap) {
+         const auto& match_vmap = match.values_map;
+         auto min_val = getIValue("min_val", match_vmap, vmap);
+         auto max_val = getIValue("max_val", match_vmap, vmap);
+         return min_val.has_value() && !min_val->isNone() &&
+             max_val.has_value() && !max_val->isNone();
+       }},
+      {"elu",
+       ", %elu_alpha, %elu_scale, %elu_input_scale",
+       eltwiseBodies("elu", ", %elu_alpha, %elu_scale, %elu_input_scale"),
+       "%elu_alpha",
+       "0.0",
+       "%elu_scale",
+       // oneDNN elu has no input scale
+       [](const Match& match,
+          const std::unordered_map<std::string, Value*>& vmap) {
+         auto input_scale =
+             getIValue("elu_input_scale", match.values_map, vmap);
+         return input_scale.has_value() && input_scale->isScalar() &&
+             input_scale->toScalar().to<double>() == 1.0;
+       }},
+      {"hardswish",
+       "",
+       eltwiseBodies("hardswish"),
+       "0.0",
+       "0.0",
+       "1.0",
+       noFilter()},
+      {"mish", "", eltwiseBodies("mish"), "0.0", "0.0", "1.0", noFilter()},
+      {"gelu", "", eltwiseBodies("gelu"), "0.0", "0.0", "1.0", noFilter()},
+  };
+  return patterns;
+}
+
+// The value name of a post op argument, defining the constant first if it
+// is a literal.
+std::string postOpArg(
+    const std::string& name,
+    const std::string& arg,
+    std::string& constants) {
+  if (arg[0] == '%') {
+    return arg;
+  }
+  constants += "%" + name + " : float = prim::Constant[value=" + arg +
+      "]()\n        ";
+  return "%" + name;
+}
+
+// The accumu written by the fused op must not be read after the post op.
+bool accumuUnusedAfter(
+    const Match& match,
+    const std::unordered_map<std::string, Value*>& vmap) {
+  auto accumu = match.values_map.at(vmap.at("accumu"));
+  auto res_node = match.values_map.at(vmap.at("res"))->node();
+  return !accumu_use_check(res_node, accumu);
+}
+
+} // namespace
+
+void fuseWithEltwisePostOps(std::shared_ptr<Graph>& graph) {
+  auto pattern_template = CodeTemplate(R"(
+    graph(${inputs}):
+        ${run}
+        ${body}
+        return (%res))");
+  auto fused_template = CodeTemplate(R"(
+    graph(${inputs}):
+        ${constants}%res = ${fused_run}
+        return (%res))");
+
+  for (const auto& base : basePatterns()) {
+    for (const auto& eltwise : eltwisePatterns()) {
+      if (base.skip_relu && eltwise.name == "relu") {
+        continue;
+      }
+      std::string constants = "%eltwise : str = prim::Constant[value=\"" +
+          eltwise.name + "\"]()\n        ";
+      auto post_alpha = postOpArg("post_alpha", eltwise.post_alpha, constants);
+      auto post_beta = postOpArg("post_beta", eltwise.post_beta, constants);
+      auto post_scale = postOpArg("post_scale", eltwise.post_scale, constants);
+      TemplateEnv run_env;
+      run_env.s(
+          "post_op",
+          "%eltwise, " + post_alpha + ", " + post_beta + ", " + post_scale);
+      TemplateEnv fused_env;
+      fused_env.s("inputs", base.inputs + eltwise.inputs);
+      fused_env.s("constants", constants);
+      fused_env.s("fused_run", CodeTemplate(base.fused_run).format(run_env));
+      auto fused = fused_template.format(fused_env);
+
+      IpexSubgraphRewriter rewriter;
+      for (const auto& body : eltwise.bodies) {
+        TemplateEnv env;
+        env.s("inputs", base.inputs + eltwise.inputs);
+        env.s("run", base.run);
+        env.s("body", body);
+        rewriter.RegisterRewritePattern(pattern_template.format(env), fused);
+      }
+      std::vector<MatchFilter> filters = {eltwise.filter};
+      if (base.writes_accumu) {
+        filters.push_back(accumuUnusedAfter);
+      }
+      rewriter.runOnGraph(graph, filters);
+    }
+  }
+}
+
+} // namespace graph_rewrite
+} // namespace jit
+} // namespace torch
@@ -1,5 +1,8 @@
 #include "graph_rewrite.h"
 #include "graph_rewrite_utils.h"
+#include "csrc/aten/cpu/WeightOnlyQuantizedLinear.h"
+#include "csrc/aten/cpu/WeightPack.h"
+#include "csrc/quantization/auto_opt_config.hpp"
 
 #include <torch/csrc/jit/frontend/code_template.h>
 
@@ -7,7 +10,64 @@ namespace torch {
 namespace jit {
 namespace graph_rewrite {
 
+// Insert the per-channel qint8 weight of the weight-only quantized linear, or
+// the group-wise 4-bit weight of quantize_linear_weight_int4 if the dtype of
+// the weight-only quantization is int4 or nf4. The weight must be a constant,
+// e.g. of a frozen model, and packed_features are the out_features and
+// in_features of the weight packed by ipex.optimize.
+// Returns nullptr if the weight can't be quantized.
+static Value* insertQuantizedLinearWeight(
+    Graph* graph,
+    Value* weight,
+    Value* out_features = nullptr,
+    Value* in_features = nullptr) {
+  auto weight_ivalue = toIValue(weight);
+  if (!(weight_ivalue.has_value() && weight_ivalue->isTensor())) {
+    return nullptr;
+  }
+  auto weight_tensor = weight_ivalue->toTensor();
+  if (weight_tensor.scalar_type() != at::ScalarType::Float &&
+      weight_tensor.scalar_type() != at::ScalarType::BFloat16) {
+    return nullptr;
+  }
+  if (out_features != nullptr) {
+    auto out_features_ivalue = toIValue(out_features);
+    auto in_features_ivalue = toIValue(in_features);
+    if (!(out_features_ivalue.has_value() && in_features_ivalue.has_value())) {
+      return nullptr;
+    }
+    weight_tensor = torch_ipex::cpu::linear_weight_unpack(
+        weight_tensor,
+        out_features_ivalue->toInt(),
+        in_features_ivalue->toInt(),
+        /* original_weight_transposed */ false,
+        c10::nullopt);
+  }
+  if (weight_tensor.dim() != 2) {
+    return nullptr;
+  }
+  // the dynamic quantized linear only takes the int8 weight
+  auto& config = torch_ipex::AutoOptConfig::singleton();
+  torch_ipex::cpu::Int4Format format;
+  if (config.get_jit_weight_only_quantization() &&
+      !config.get_jit_dynamic_quantization() &&
+      torch_ipex::cpu::get_woq_int4_format(
+          config.get_jit_weight_only_quantization_dtype(), format)) {
+    return graph->insertConstant(torch_ipex::cpu::quantize_linear_weight_int4(
+        weight_tensor,
+        format,
+        config.get_jit_weight_only_quantization_group_size()));
+  }
+  return graph->insertConstant(
+      torch_ipex::cpu::quantize_linear_weight_per_channel(weight_tensor));
+}
+
 void insertPrePackedLinearOp(Block* b) {
+  // the dynamic quantized linear takes the same quantized weight
+  bool quantize_weight =
+      torch_ipex::AutoOptConfig::singleton()
+          .get_jit_weight_only_quantization() ||
+      torch_ipex::AutoOptConfig::singleton().get_jit_dynamic_quantization();
   for (Node* n : b->nodes()) {
     for (Block* block : n->blocks()) {
       insertPrePackedLinearOp(block);
@@ -45,8 +105,12 @@ void insertPrePackedLinearOp(Block* b) {
           continue;
         }
         auto weight_dtype_option = tt->scalarType();
+        Value* quantized_weight = quantize_weight
+            ? insertQuantizedLinearWeight(graph, n->inputs().at(1))
+            : nullptr;
         if (!(weight_dtype_option.has_value() &&
-              weight_dtype_option.value() == at::ScalarType::BFloat16)) {
+              weight_dtype_option.value() == at::ScalarType::BFloat16) &&
+            quantized_weight == nullptr) {
           continue;
         }
         auto weight_size = weight_size_option.value();
@@ -58,7 +122,9 @@ void insertPrePackedLinearOp(Block* b) {
         auto input_channel = graph->insertConstant(input_channel_value);
         auto weight_is_prepacked =
             graph->insertConstant(weight_is_prepacked_value);
-        for (auto i = 1; i < n->inputs().size(); ++i) {
+        prepack_node->addInput(
+            quantized_weight != nullptr ? quantized_weight : n->inputs().at(1));
+        for (auto i = 2; i < n->inputs().size(); ++i) {
           Value* v = n->inputs().at(i);
           prepack_node->addInput(v);
         }
@@ -67,12 +133,20 @@ void insertPrePackedLinearOp(Block* b) {
         prepack_node->addInput(batch_size);
         prepack_node->addInput(weight_is_prepacked);
       } else {
-        prepack_node->addInput(n->inputs().at(1));
+        Value* quantized_weight = quantize_weight
+            ? insertQuantizedLinearWeight(
+                  graph,
+                  n->inputs().at(1),
+                  n->inputs().at(2),
+                  n->inputs().at(3))
+            : nullptr;
+        prepack_node->addInput(
+            quantized_weight != nullptr ? quantized_weight : n->inputs().at(1));
         prepack_node->addInput(n->inputs().at(4));
         prepack_node->addInput(n->inputs().at(2));
         prepack_node->addInput(n->inputs().at(3));
         prepack_node->addInput(batch_size);
-        IValue weight_is_prepacked_value(true);
+        IValue weight_is_prepacked_value(quantized_weight == nullptr);
         auto weight_is_prepacked =
             graph->insertConstant(weight_is_prepacked_value);
         prepack_node->addInput(weight_is_prepacked);
@@ -186,6 +260,77 @@ void fuseLinearAddRelu(std::shared_ptr<Graph>& graph) {
   rewriter_add_v2.runOnGraph(graph, fuse_add_filter_v2);
 }
 
+void fuseLinearGeluLinear(std::shared_ptr<Graph>& graph) {
+  IpexSubgraphRewriter rewriter_ffn, rewriter_ffn_add;
+
+  std::string linear_gelu_linear = R"(
+    graph(%input, %packed_weight, %packed_weight2):
+        %x = ipex_prepack::linear_gelu_run(%input, %packed_weight)
+        %res = ipex_prepack::linear_run(%x, %packed_weight2)
+        return (%res))";
+
+  std::string linear_gelu_linear_fused = R"(
+    graph(%input, %packed_weight, %packed_weight2):
+        %res = ipex_prepack::linear_gelu_linear_run(%input, %packed_weight, %packed_weight2)
+        return (%res))";
+
+  // the second linear fused with the residual add
+  std::string linear_gelu_linear_add = R"(
+    graph(%input, %accumu, %alpha, %packed_weight, %packed_weight2):
+        %x = ipex_prepack::linear_gelu_run(%input, %packed_weight)
+        %res = ipex_prepack::linear_add_run(%x, %accumu, %alpha, %packed_weight2)
+        return (%res))";
+
+  std::string linear_gelu_linear_add_fused = R"(
+    graph(%input, %accumu, %alpha, %packed_weight, %packed_weight2):
+        %res = ipex_prepack::linear_gelu_linear_add_run(%input, %accumu, %alpha, %packed_weight, %packed_weight2)
+        return (%res))";
+
+  rewriter_ffn.RegisterRewritePattern(
+      linear_gelu_linear, linear_gelu_linear_fused);
+  rewriter_ffn_add.RegisterRewritePattern(
+      linear_gelu_linear_add, linear_gelu_linear_add_fused);
+
+  rewriter_ffn.runOnGraph(graph);
+  rewriter_ffn_add.runOnGraph(graph);
+}
+
+// The classifier head of the CNNs, of which the global average pooling of
+// channels last is pooled straight into the input of the linear.
+void fuseAdaptiveAvgPoolLinear(std::shared_ptr<Graph>& graph) {
+  IpexSubgraphRewriter rewriter;
+
+  std::string pool_flatten_linear = R"(
+    graph(%input, %output_size:int[], %start_dim:int, %end_dim:int, %packed_weight):
+        %x = aten::adaptive_avg_pool2d(%input, %output_size)
+        %y = aten::flatten(%x, %start_dim, %end_dim)
+        %res = ipex_prepack::linear_run(%y, %packed_weight)
+        return (%res))";
+
+  std::string pool_flatten_linear_fused = R"(
+    graph(%input, %output_size:int[], %start_dim:int, %end_dim:int, %packed_weight):
+        %res = ipex_prepack::adaptive_avg_pool_linear_run(%input, %output_size, %packed_weight)
+        return (%res))";
+
+  // flatten all the dims but the batch
+  auto filter_flatten_batch =
+      [](const Match& match,
+         const std::unordered_map<std::string, Value*>& vmap) {
+        const auto& match_vmap = match.values_map;
+        auto start_dim = getIValue("start_dim", match_vmap, vmap);
+        auto end_dim = getIValue("end_dim", match_vmap, vmap);
+        if (!start_dim.has_value() || !end_dim.has_value()) {
+          return false;
+        }
+        return start_dim.value().toInt() == 1 &&
+            (end_dim.value().toInt() == -1 || end_dim.value().toInt() == 3);
+      };
+
+  rewriter.RegisterRewritePattern(
+      pool_flatten_linear, pool_flatten_linear_fused);
+  rewriter.runOnGraph(graph, filter_flatten_batch);
+}
+
 } // namespace graph_rewrite
 } // namespace jit
 } // namespace torch
@@ -0,0 +1,105 @@
+#include "graph_rewrite.h"
+#include "graph_rewrite_utils.h"
+
+namespace torch {
+namespace jit {
+namespace graph_rewrite {
+
+// Returns the tensors of the list params if they are all constants, e.g. the
+// LSTM weights of a frozen model, otherwise nullopt.
+static c10::optional<std::vector<at::Tensor>> getConstantTensors(
+    Value* params) {
+  auto params_ivalue = toIValue(params);
+  if (params_ivalue.has_value()) {
+    if (!params_ivalue->isTensorList()) {
+      return c10::nullopt;
+    }
+    return params_ivalue->toTensorVector();
+  }
+  if (params->node()->kind() != prim::ListConstruct) {
+    return c10::nullopt;
+  }
+  std::vector<at::Tensor> tensors;
+  for (Value* v : params->node()->inputs()) {
+    auto v_ivalue = toIValue(v);
+    if (!(v_ivalue.has_value() && v_ivalue->isTensor())) {
+      return c10::nullopt;
+    }
+    tensors.push_back(v_ivalue->toTensor());
+  }
+  return tensors;
+}
+
+void insertPrePackedLstmOp(Block* b) {
+  for (Node* n : b->nodes()) {
+    for (Block* block : n->blocks()) {
+      insertPrePackedLstmOp(block);
+    }
+    if (n->kind() != Symbol::fromQualString("torch_ipex::ipex_lstm")) {
+      continue;
+    }
+    // ipex_lstm(input, hx, params, has_biases, num_layers, dropout_p, train,
+    // bidirectional, batch_first), only the inference is prepacked.
+    auto train_ivalue = toIValue(n->inputs().at(6));
+    if (!(train_ivalue.has_value() && !train_ivalue->toBool())) {
+      continue;
+    }
+    // the weights must be constants, e.g. of a frozen model.
+    auto params = getConstantTensors(n->inputs().at(2));
+    if (!(params.has_value() && params.value().size() >= 2 &&
+          params.value()[1].dim() == 2)) {
+      continue;
+    }
+    auto input_size_option = n->inputs()
+                                 .at(0)
+                                 ->type()
+                                 ->cast<TensorType>()
+                                 ->sizes()
+                                 .concrete_sizes();
+    // if can't get input shape info, will not do weight prepack.
+    if (!(input_size_option.has_value() &&
+          input_size_option.value().size() == 3)) {
+      continue;
+    }
+    WithInsertPoint guard(n);
+    auto graph = n->owningGraph();
+    // weight_hh of the first layer is of (4 * hidden_size, hidden_size)
+    IValue hidden_size_value(params.value()[1].size(1)),
+        input_size_value(input_size_option.value());
+    auto hidden_size = graph->insertConstant(hidden_size_value);
+    auto input_size = graph->insertConstant(input_size_value);
+    auto prepack_node = graph->create(
+        Symbol::fromQualString("ipex_prepack::lstm_prepack"), 1);
+    // params, has_biases, num_layers
+    for (auto i = 2; i < 5; ++i) {
+      prepack_node->addInput(n->inputs().at(i));
+    }
+    prepack_node->addInput(hidden_size);
+    // bidirectional, batch_first
+    prepack_node->addInput(n->inputs().at(7));
+    prepack_node->addInput(n->inputs().at(8));
+    prepack_node->addInput(input_size);
+    prepack_node->output()->setType(getCustomClass(
+        "__torch__.torch.classes.ipex_prepack.LstmOpContext"));
+    graph->insertNode(prepack_node);
+
+    auto prepack_lstm = graph->insertNode(
+        graph->create(Symbol::fromQualString("ipex_prepack::lstm_run"), 3));
+    prepack_lstm->addInput(n->inputs().at(0));
+    prepack_lstm->addInput(n->inputs().at(1));
+    prepack_lstm->addInput(prepack_node->output());
+    for (auto i = 0; i < 3; ++i) {
+      prepack_lstm->outputs().at(i)->setType(n->outputs().at(i)->type());
+      n->outputs().at(i)->replaceAllUsesWith(prepack_lstm->outputs().at(i));
+    }
+  }
+  EliminateDeadCode(b);
+}
+
+void insertPrePackedLstmOp(std::shared_ptr<Graph>& graph) {
+  insertPrePackedLstmOp(graph->block());
+}
+
+} // namespace graph_rewrite
+} // namespace jit
+} // namespace torch
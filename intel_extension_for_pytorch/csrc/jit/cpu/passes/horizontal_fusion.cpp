@@ -0,0 +1,497 @@
+//[This file is from https://github.com/pytorch/pytorch/pull/63198/files and
+// change it to adapt to CPU and IPEX]
+#include "horizontal_fusion.h"
+#include <torch/csrc/jit/ir/alias_analysis.h>
+#include <torch/csrc/jit/ir/ir.h>
+#include <torch/csrc/jit/jit_log.h>
+#include <unordered_set>
+#include <vector>
+
+#include "csrc/aten/cpu/WeightPack.h"
+
+namespace torch {
+namespace jit {
+namespace {
+
+using Tensor = at::Tensor;
+
+const Symbol& ipexLinear() {
+  static const Symbol symbol =
+      Symbol::fromQualString("torch_ipex::ipex_linear");
+  return symbol;
+}
+
+// The eltwise ops hoisted to the concatenated output when they follow all the
+// siblings alike.
+bool isHoistableEltwise(Node* n) {
+  static const std::unordered_set<Symbol> eltwise_ops = {
+      aten::relu,
+      Symbol::fromQualString("aten::relu_"),
+      aten::gelu,
+      aten::sigmoid,
+      aten::tanh,
+      aten::silu,
+  };
+  return eltwise_ops.count(n->kind()) != 0;
+}
+
+class HorizontalFusion {
+ public:
+  explicit HorizontalFusion(std::shared_ptr<Graph> graph)
+      : graph_(std::move(graph)) {}
+
+  bool run() {
+    handleBlockAndSubblocks(graph_->block());
+    return graph_modified;
+  }
+
+  AliasDb* getAliasDb() {
+    if (!aliasDb_) {
+      aliasDb_ = std::make_unique<AliasDb>(graph_);
+    }
+    return aliasDb_.get();
+  }
+
+  // torch/csrc/jit/passes/utils/optimization_utils.h is not in the current
+  // torch, so add "nonConstantParameters" here ToDo will remove it when there
+  // optimization_utils.h for torch
+  bool nonConstantParameters(Node* n) {
+    // Checks if the parameters, not including the
+    // first param are all constants.
+    for (size_t i = 1; i < n->inputs().size(); i++) {
+      if (n->inputs().at(i)->node()->kind() != prim::Constant) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  static bool isLinear(Node* n) {
+    return n->kind() == aten::linear || n->kind() == ipexLinear();
+  }
+
+  // The weight in the layout it is concatenated in, i.e. the unpacked weight
+  // of torch_ipex::ipex_linear.
+  static Tensor getWeight(Node* n) {
+    auto weight = constant_as<Tensor>(n->inputs().at(1)).value();
+    if (n->kind() != ipexLinear()) {
+      return weight;
+    }
+    // always unpack to contiguous tensor with no transposed, and the origin
+    // weight dtype is same as packed weight.
+    return torch_ipex::cpu::linear_weight_unpack(
+        weight,
+        constant_as<int64_t>(n->inputs().at(2)).value(),
+        constant_as<int64_t>(n->inputs().at(3)).value(),
+        false,
+        c10::nullopt);
+  }
+
+  static c10::optional<Tensor> getBias(Node* n) {
+    if (n->kind() == aten::matmul) {
+      return c10::nullopt;
+    }
+    auto bias = toIValue(n->namedInput("bias"));
+    if (!(bias.has_value() && bias->isTensor())) {
+      return c10::nullopt;
+    }
+    return bias->toTensor();
+  }
+
+  // The dim of the weight the siblings are concatenated along, which is also
+  // the dim of the output they are split along, see getOutputSplitDim.
+  static int64_t getWeightConcatDim(Node* n) {
+    return n->kind() == aten::matmul ? 1 : 0;
+  }
+
+  static int64_t getOutputSplitDim(Node* n) {
+    return n->kind() == aten::conv2d ? 1 : -1;
+  }
+
+  // The size of the output of n along the split dim
+  static int64_t getOutputChannels(Node* n) {
+    if (n->kind() == ipexLinear()) {
+      return constant_as<int64_t>(n->inputs().at(2)).value();
+    }
+    auto weight = constant_as<Tensor>(n->inputs().at(1)).value();
+    return weight.size(getWeightConcatDim(n));
+  }
+
+  bool isCandidate(Node* n) {
+    if (!isLinear(n) && n->kind() != aten::conv2d &&
+        n->kind() != aten::matmul) {
+      return false;
+    }
+    if (nonConstantParameters(n)) {
+      return false;
+    }
+    auto weight = toIValue(n->inputs().at(1));
+    if (!(weight.has_value() && weight->isTensor())) {
+      return false;
+    }
+    if (n->kind() == aten::conv2d) {
+      // the grouped convs would need the weights of the groups interleaved
+      return weight->toTensor().dim() == 4 &&
+          constant_as<int64_t>(n->namedInput("groups")).value() == 1;
+    }
+    if (n->kind() == aten::matmul) {
+      return weight->toTensor().dim() == 2;
+    }
+    return true;
+  }
+
+  void collectConstantLayers(
+      Block* b,
+      std::unordered_map<Value*, std::vector<Node*>>& grouped_layers,
+      std::vector<Value*>& ordered_tensor_inputs) {
+    // We are using an ordered list so that we only have to
+    // check if moving items forward is a valid move, not
+    // backwards. Otherwise we need to rebuild the aliasDb when we add values.
+
+    for (Node* n : b->nodes()) {
+      // Grouping together all layers that use the same Tensor for input
+      if (!isCandidate(n)) {
+        continue;
+      }
+
+      Value* layer_input = n->inputs().at(0);
+      if (grouped_layers.find(layer_input) == grouped_layers.cend()) {
+        grouped_layers.insert({layer_input, std::vector<Node*>()});
+        ordered_tensor_inputs.push_back(layer_input);
+      }
+      grouped_layers.find(layer_input)->second.push_back(n);
+    }
+  }
+
+  // The concatenated bias, the missing biases of the siblings are zeros.
+  // Returns nullopt if none of them has a bias.
+  c10::optional<Tensor> concatBiases(std::vector<Node*>& compatible_layers) {
+    c10::optional<Tensor> any_bias;
+    for (Node* n : compatible_layers) {
+      auto bias = getBias(n);
+      if (bias.has_value()) {
+        any_bias = bias;
+      }
+    }
+    if (!any_bias.has_value()) {
+      return c10::nullopt;
+    }
+    auto bias_list = c10::fmap(compatible_layers, [&](Node* n) {
+      auto bias = getBias(n);
+      return bias.has_value()
+          ? bias.value()
+          : at::zeros({getOutputChannels(n)}, any_bias->options());
+    });
+    return at::cat(bias_list, /*dim=*/0);
+  }
+
+  Node* createConcatenatedNode(std::vector<Node*>& compatible_layers) {
+    Node* base_node = compatible_layers[0];
+    auto weight_list = c10::fmap(compatible_layers, getWeight);
+    Tensor cat_weight =
+        at::cat(weight_list, /*dim=*/getWeightConcatDim(base_node));
+    Value* cat_bias_value = nullptr;
+    if (base_node->kind() != aten::matmul) {
+      auto cat_bias = concatBiases(compatible_layers);
+      cat_bias_value = cat_bias.has_value()
+          ? graph_->insertConstant(cat_bias.value())
+          : graph_->insertConstant(IValue());
+    }
+
+    auto tensor_input = base_node->inputs().at(0);
+    Node* node = nullptr;
+    if (base_node->kind() == ipexLinear()) {
+      auto packed_cat_weight =
+          torch_ipex::cpu::linear_weight_pack(cat_weight, c10::nullopt);
+      Value* cat_weight_value = graph_->insertConstant(packed_cat_weight);
+      Value* out_features_value = graph_->insertConstant(cat_weight.size(0));
+      Value* in_features_value = graph_->insertConstant(cat_weight.size(1));
+      std::vector<Value*> linear_in = {
+          tensor_input,
+          cat_weight_value,
+          out_features_value,
+          in_features_value,
+          cat_bias_value};
+      node = graph_->create(ipexLinear(), linear_in);
+    } else {
+      // the same op of the concatenated weight and bias, the other
+      // parameters are those of the base node
+      std::vector<Value*> inputs = {
+          tensor_input, graph_->insertConstant(cat_weight)};
+      if (cat_bias_value != nullptr) {
+        inputs.push_back(cat_bias_value);
+      }
+      for (size_t i = inputs.size(); i < base_node->inputs().size(); i++) {
+        inputs.push_back(base_node->inputs().at(i));
+      }
+      node = graph_->create(base_node->kind(), inputs);
+    }
+
+    // set output sizes
+    auto output_type = base_node->output()->type()->expect<TensorType>();
+    auto output_size_option = output_type->sizes().concrete_sizes();
+    if (output_size_option.has_value()) {
+      auto output_size = output_size_option.value();
+      auto split_dim = getOutputSplitDim(base_node);
+      if (split_dim < 0) {
+        split_dim += output_size.size();
+      }
+      output_size[split_dim] = cat_weight.size(getWeightConcatDim(base_node));
+      node->output()->setType(output_type->withSizes(output_size));
+    } else {
+      node->output()->setType(output_type->dimensionedOnly());
+    }
+    return node;
+  }
+
+  void mergeLayers(std::vector<Node*>& compatible_layers) {
+    graph_modified = true;
+    assert(!compatible_layers.empty());
+    Node* base_node = compatible_layers[0];
+
+    // Scope needed to make sure we free the WithInsertPoint guard
+    // and reset the insert point before we delete `base_node`
+    Node* merged_node = nullptr;
+    {
+      WithInsertPoint guard(base_node);
+      merged_node = createConcatenatedNode(compatible_layers);
+      merged_node->insertBefore(base_node);
+    }
+
+    // Update the outputs of the nodes
+    WithInsertPoint guard2(merged_node);
+    Value* split_dim = graph_->insertConstant(getOutputSplitDim(base_node));
+    Value* one = graph_->insertConstant(1);
+
+    int64_t slice_start = 0;
+    Value* slice_start_val = graph_->insertConstant(0);
+
+    std::vector<Node*> slices;
+    for (Node* orig_node : compatible_layers) {
+      // for each node in the compatible_layers list,
+      // slide the output of the combined layer
+      // and use it instead of the output of the original node.
+      // The slices are views of the combined output, nothing is copied.
+      int64_t slice_end = slice_start + getOutputChannels(orig_node);
+
+      Value* slice_end_val = graph_->insertConstant(slice_end);
+
+      Node* slice = graph_->create(
+          aten::slice,
+          {merged_node->output(),
+           split_dim,
+           slice_start_val,
+           slice_end_val,
+           one});
+      slice->output(0)->setType(
+          orig_node->output(0)->type()->expect<TensorType>());
+      slice->insertAfter(merged_node);
+      orig_node->replaceAllUsesWith(slice);
+      orig_node->destroy();
+      slices.push_back(slice);
+
+      slice_start = slice_end;
+      slice_start_val = slice_end_val;
+    }
+    hoistCommonEltwise(merged_node, slices);
+  }
+
+  // If the only use of each slice is the same eltwise op, e.g. the relus of
+  // the Inception branches, applies the op to the merged output before it is
+  // sliced, which leaves the merged op followed by the eltwise op for the
+  // post op fusions.
+  void hoistCommonEltwise(Node* merged_node, std::vector<Node*>& slices) {
+    Node* base_user = nullptr;
+    for (Node* slice : slices) {
+      auto& uses = slice->output()->uses();
+      if (uses.size() != 1 || uses[0].offset != 0) {
+        return;
+      }
+      Node* user = uses[0].user;
+      if (!isHoistableEltwise(user) ||
+          user->owningBlock() != slice->owningBlock()) {
+        return;
+      }
+      if (base_user == nullptr) {
+        base_user = user;
+        continue;
+      }
+      if (user->kind() != base_user->kind() ||
+          user->inputs().size() != base_user->inputs().size()) {
+        return;
+      }
+      for (size_t i = 1; i < user->inputs().size(); i++) {
+        auto value = toIValue(user->inputs().at(i));
+        auto base_value = toIValue(base_user->inputs().at(i));
+        if (!(value.has_value() && base_value.has_value() &&
+              *value == *base_value)) {
+          return;
+        }
+      }
+    }
+    if (base_user == nullptr) {
+      return;
+    }
+
+    Node* eltwise = nullptr;
+    {
+      WithInsertPoint guard(merged_node->next());
+      std::vector<Value*> inputs = {merged_node->output()};
+      for (size_t i = 1; i < base_user->inputs().size(); i++) {
+        inputs.push_back(graph_->insertConstant(
+            toIValue(base_user->inputs().at(i)).value()));
+      }
+      eltwise = graph_->insertNode(graph_->create(base_user->kind(), inputs));
+      eltwise->output()->setType(merged_node->output()->type());
+    }
+    for (Node* slice : slices) {
+      Node* user = slice->output()->uses()[0].user;
+      slice->replaceInput(0, eltwise->output());
+      user->output()->replaceAllUsesWith(slice->output());
+      user->destroy();
+    }
+  }
+
+  bool isNonZeroDimEqual(Tensor& tensor_a, Tensor& tensor_b) {
+    if (tensor_a.dim() != tensor_b.dim()) {
+      return false;
+    }
+    for (int64_t i = 1; i < tensor_a.dim(); i++) {
+      if (tensor_a.size(i) != tensor_b.size(i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Whether node can be concatenated with base_node, i.e. the same op of the
+  // same parameters but the output channels of the weight and bias.
+  bool isCompatible(Node* base_node, Node* node) {
+    // Only support all nodes of the same kind
+    if (node->kind() != base_node->kind()) {
+      return false;
+    }
+    auto base_weight =
+        constant_as<Tensor>(base_node->inputs().at(1)).value();
+    auto weight = constant_as<Tensor>(node->inputs().at(1)).value();
+    auto base_bias = getBias(base_node);
+    auto bias = getBias(node);
+
+    // For now we will just keep it simple and require matching types
+    // Type promotion might cause performance to actually decrease.
+    if (base_weight.dtype() != weight.dtype() ||
+        base_weight.device() != weight.device()) {
+      return false;
+    }
+    if (base_bias.has_value() && bias.has_value() &&
+        (base_bias->dtype() != bias->dtype() ||
+         base_bias->device() != bias->device())) {
+      return false;
+    }
+
+    if (node->kind() == ipexLinear()) {
+      // for torch_ipex::ipex_linear, we only need to check the in_features
+      // are same size between two nodes.
+      return constant_as<int64_t>(base_node->inputs().at(3)).value() ==
+          constant_as<int64_t>(node->inputs().at(3)).value();
+    }
+    if (node->kind() == aten::matmul) {
+      return base_weight.size(0) == weight.size(0);
+    }
+    if (!isNonZeroDimEqual(base_weight, weight)) {
+      return false;
+    }
+    // stride, padding, dilation and groups of conv2d
+    for (size_t i = 3; i < node->inputs().size(); i++) {
+      if (toIValue(node->inputs().at(i)) !=
+          toIValue(base_node->inputs().at(i))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Check the layer_group of a tensor to find ones that can be
+  // combined
+  void collectAndMergeLayers(std::vector<Node*>& layer_group) {
+    std::unordered_set<Node*> checked_nodes;
+
+    for (size_t i = 0; i < layer_group.size(); i++) {
+      Node* base_node = layer_group[i];
+      if (checked_nodes.count(base_node) != 0) {
+        continue;
+      }
+
+      std::vector<Node*> compatible_layers;
+      compatible_layers.push_back(base_node);
+
+      // Now iterate over the rest of the users of the set to
+      // see if there is anything that we can coaleasce `base_node` with.
+      for (size_t j = i + 1; j < layer_group.size(); j++) {
+        auto node = layer_group[j];
+        if (checked_nodes.count(node) != 0) {
+          continue;
+        }
+        if (!isCompatible(base_node, node)) {
+          continue;
+        }
+        bool can_move_before_all = true;
+        for (auto n : compatible_layers) {
+          can_move_before_all &=
+              getAliasDb()->moveBeforeTopologicallyValid(node, n);
+        }
+        if (!can_move_before_all) {
+          continue;
+        }
+
+        // Found a node that is eligible for combination
+        compatible_layers.push_back(node);
+        checked_nodes.insert(node);
+      }
+      if (compatible_layers.size() == 1) {
+        continue; // No other layers to merge
+      }
+      mergeLayers(compatible_layers);
+    }
+  }
+
+  void handleBlockAndSubblocks(Block* block) {
+    for (auto node : block->nodes()) {
+      for (Block* subblock : node->blocks()) {
+        handleBlockAndSubblocks(subblock);
+      }
+    }
+
+    // Processing for the block itself
+    std::unordered_map<Value*, std::vector<Node*>> grouped_layers;
+    std::vector<Value*> ordered_tensor_inputs;
+    collectConstantLayers(block, grouped_layers, ordered_tensor_inputs);
+
+    // Reverse topological ordering is used to prevent the need to
+    // update the aliasDB
+    for (auto tensor_it = ordered_tensor_inputs.rbegin();
+         tensor_it != ordered_tensor_inputs.rend();
+         ++tensor_it) {
+      collectAndMergeLayers(grouped_layers.at(*tensor_it));
+    }
+  }
+
+ private:
+  std::shared_ptr<Graph> graph_;
+  bool graph_modified = false;
+  std::unique_ptr<AliasDb> aliasDb_ = nullptr;
+};
+} // namespace
+
+TORCH_API bool FrozenHorizontalFusion(std::shared_ptr<Graph>& graph) {
+  HorizontalFusion horizontalFusion(graph);
+  GRAPH_DUMP("Before FrozenHorizontalFusion", graph);
+  bool changed = horizontalFusion.run();
+  if (changed) {
+    GRAPH_DUMP("After FrozenHorizontalFusion", graph);
+  }
+  return changed;
+}
+
+} // namespace jit
+} // namespace torch
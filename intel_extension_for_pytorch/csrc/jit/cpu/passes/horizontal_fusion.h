@@ -0,0 +1,17 @@
+//[this file is from https://github.com/pytorch/pytorch/pull/63198/files]
+#pragma once
+
+#include <torch/csrc/jit/ir/ir.h>
+
+namespace torch {
+namespace jit {
+
+// Concats the sibling linear, conv2d and matmul ops with the same Tensor input
+// and constant weights into a single op of the concatenated weights. The
+// outputs of the siblings are slices of the output of the concatenated op,
+// and the eltwise op following all the siblings alike is applied once to the
+// concatenated output, so that it can still be fused as a post op.
+TORCH_API bool FrozenHorizontalFusion(std::shared_ptr<Graph>& graph);
+
+} // namespace jit
+} // namespace torch
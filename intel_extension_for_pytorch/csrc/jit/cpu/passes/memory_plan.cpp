@@ -0,0 +1,335 @@
+#include "memory_plan.h"
+
+#include <torch/csrc/jit/ir/alias_analysis.h>
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/runtime/operator.h>
+
+#include "csrc/jit/cpu/kernels/MemoryPlan.h"
+
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace torch {
+namespace jit {
+namespace {
+
+using torch_ipex::cpu::MemoryPlan;
+using torch_ipex::cpu::PlannedBuffer;
+
+const Symbol kMemoryPlanBegin =
+    Symbol::fromQualString("ipex::memory_plan_begin");
+const Symbol kPlannedBuffer = Symbol::fromQualString("ipex::planned_buffer");
+
+// The offsets in the arena are aligned to the cache line.
+constexpr size_t kAlignment = 64;
+
+size_t alignUp(size_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+// The ops with an out variant taking the out tensor after all the other
+// inputs.
+bool isOutVariantCandidate(Node* node) {
+  static const std::unordered_set<Symbol> ops = {
+      aten::add,
+      aten::sub,
+      aten::mul,
+      aten::div,
+      aten::cat,
+      aten::matmul,
+      aten::mm,
+      aten::bmm,
+      aten::addmm,
+      aten::sigmoid,
+      aten::tanh,
+      aten::exp,
+      Symbol::aten("gelu"),
+      Symbol::aten("silu"),
+      Symbol::fromQualString("ipex_prepack::convolution_run"),
+      Symbol::fromQualString("ipex_prepack::convolution_relu_run"),
+      Symbol::fromQualString("ipex_prepack::linear_run"),
+      Symbol::fromQualString("ipex_prepack::linear_relu_run"),
+  };
+  return ops.count(node->kind()) > 0;
+}
+
+// Whether node has an "out" overload accepting its inputs followed by the
+// out tensor.
+bool hasOutOverload(Node* node) {
+  for (const auto& op : getAllOperatorsFor(node->kind())) {
+    const auto& schema = op->schema();
+    if (schema.overload_name() != "out" ||
+        schema.arguments().size() != node->inputs().size() + 1) {
+      continue;
+    }
+    bool matches = true;
+    for (size_t i = 0; i < node->inputs().size(); i++) {
+      if (!node->inputs()[i]->type()->isSubtypeOf(
+              schema.arguments()[i].type())) {
+        matches = false;
+        break;
+      }
+    }
+    if (matches) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// The sizes, strides and dtype of a CPU tensor of complete type, which does
+// not require grad.
+c10::optional<PlannedBuffer> completeTensorBuffer(Value* v) {
+  auto type = v->type()->cast<TensorType>();
+  if (!type || !type->scalarType() || !type->device() ||
+      !type->device()->is_cpu() || type->requiresGrad().value_or(true)) {
+    return c10::nullopt;
+  }
+  auto sizes = type->sizes().concrete_sizes();
+  auto strides = type->strides().concrete_sizes();
+  if (!sizes || !strides) {
+    return c10::nullopt;
+  }
+  return PlannedBuffer{0, *sizes, *strides, *type->scalarType()};
+}
+
+size_t storageBytes(const PlannedBuffer& buffer) {
+  size_t numel = 1;
+  for (size_t i = 0; i < buffer.sizes.size(); i++) {
+    if (buffer.sizes[i] == 0) {
+      return 0;
+    }
+    numel += (buffer.sizes[i] - 1) * buffer.strides[i];
+  }
+  return numel * c10::elementSize(buffer.dtype);
+}
+
+// Whether any node of block, or of its nested blocks, uses a value of values.
+bool usesAny(Block* block, const std::unordered_set<Value*>& values) {
+  for (Node* node : block->nodes()) {
+    for (Value* input : node->inputs()) {
+      if (values.count(input)) {
+        return true;
+      }
+    }
+    for (Block* sub : node->blocks()) {
+      if (usesAny(sub, values)) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+struct Candidate {
+  Node* node;
+  // the first and the last top level node the buffer is alive at
+  size_t begin;
+  size_t end;
+  size_t bytes;
+  PlannedBuffer buffer;
+};
+
+class MemoryPlanner {
+ public:
+  explicit MemoryPlanner(std::shared_ptr<Graph> graph)
+      : graph_(std::move(graph)), aliasDb_(graph_) {}
+
+  bool run() {
+    MemoryPlan plan;
+    std::vector<Value*> inputs;
+    if (!collectInputs(plan, inputs)) {
+      return false;
+    }
+    nodes_.assign(graph_->nodes().begin(), graph_->nodes().end());
+    for (Node* node : nodes_) {
+      if (node->kind() == kMemoryPlanBegin) {
+        return false;
+      }
+    }
+
+    std::vector<Candidate> candidates;
+    for (size_t pos = 0; pos < nodes_.size(); pos++) {
+      auto candidate = collectCandidate(pos);
+      if (candidate) {
+        candidates.push_back(std::move(*candidate));
+      }
+    }
+    if (candidates.empty()) {
+      return false;
+    }
+    plan.arena_size = assignOffsets(candidates);
+    for (const auto& candidate : candidates) {
+      plan.buffers.push_back(candidate.buffer);
+    }
+    GRAPH_DEBUG(
+        "Planned ",
+        candidates.size(),
+        " intermediates in an arena of ",
+        plan.arena_size,
+        " bytes");
+    auto plan_id = torch_ipex::cpu::register_memory_plan(std::move(plan));
+    rewrite(plan_id, inputs, candidates);
+    return true;
+  }
+
+ private:
+  // The tensor inputs of the graph, whose shapes are checked before using the
+  // plan.
+  bool collectInputs(MemoryPlan& plan, std::vector<Value*>& inputs) {
+    for (Value* input : graph_->inputs()) {
+      auto type = input->type()->cast<TensorType>();
+      if (!type) {
+        continue;
+      }
+      auto sizes = type->sizes().concrete_sizes();
+      if (!sizes || !type->scalarType()) {
+        return false;
+      }
+      plan.input_sizes.push_back(*sizes);
+      plan.input_dtypes.push_back(*type->scalarType());
+      inputs.push_back(input);
+    }
+    return true;
+  }
+
+  c10::optional<Candidate> collectCandidate(size_t pos) {
+    Node* node = nodes_[pos];
+    if (!isOutVariantCandidate(node) || node->outputs().size() != 1 ||
+        !hasOutOverload(node)) {
+      return c10::nullopt;
+    }
+    Value* output = node->output();
+    auto buffer = completeTensorBuffer(output);
+    if (!buffer) {
+      return c10::nullopt;
+    }
+    auto bytes = storageBytes(*buffer);
+    if (bytes == 0 || aliasDb_.mayContainAlias(output, graph_->outputs())) {
+      return c10::nullopt;
+    }
+    auto end = lastUse(output, pos);
+    if (!end) {
+      return c10::nullopt;
+    }
+    return Candidate{node, pos, *end, alignUp(bytes), std::move(*buffer)};
+  }
+
+  // The last top level node using v or a value which may contain an alias
+  // of v, e.g. a view of it or a list holding it. None if an alias of v may
+  // escape the graph through a node with side effects.
+  c10::optional<size_t> lastUse(Value* v, size_t def) {
+    std::unordered_set<Value*> aliases = {v};
+    size_t last = def;
+    for (size_t pos = def + 1; pos < nodes_.size(); pos++) {
+      Node* node = nodes_[pos];
+      bool uses = false;
+      for (Value* input : node->inputs()) {
+        uses = uses || aliases.count(input);
+      }
+      for (Block* sub : node->blocks()) {
+        uses = uses || usesAny(sub, aliases);
+      }
+      if (!uses) {
+        continue;
+      }
+      if (node->hasSideEffects()) {
+        return c10::nullopt;
+      }
+      last = pos;
+      for (Value* output : node->outputs()) {
+        if (aliasDb_.mayContainAlias(output, v)) {
+          aliases.insert(output);
+        }
+      }
+    }
+    return last;
+  }
+
+  // Place the buffers greedily from the largest one, each at the lowest
+  // offset not overlapping the buffers placed before it with an overlapping
+  // lifetime. Return the size of the arena.
+  size_t assignOffsets(std::vector<Candidate>& candidates) {
+    std::vector<size_t> order(candidates.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return candidates[a].bytes > candidates[b].bytes;
+    });
+    size_t arena_size = 0;
+    std::vector<size_t> placed;
+    for (size_t i : order) {
+      auto& candidate = candidates[i];
+      std::vector<std::pair<size_t, size_t>> occupied;
+      for (size_t j : placed) {
+        const auto& other = candidates[j];
+        if (other.begin <= candidate.end && candidate.begin <= other.end) {
+          occupied.emplace_back(
+              other.buffer.offset, other.buffer.offset + other.bytes);
+        }
+      }
+      std::sort(occupied.begin(), occupied.end());
+      size_t offset = 0;
+      for (const auto& range : occupied) {
+        if (offset + candidate.bytes <= range.first) {
+          break;
+        }
+        offset = std::max(offset, range.second);
+      }
+      candidate.buffer.offset = offset;
+      arena_size = std::max(arena_size, offset + candidate.bytes);
+      placed.push_back(i);
+    }
+    return arena_size;
+  }
+
+  void rewrite(
+      int64_t plan_id,
+      const std::vector<Value*>& inputs,
+      const std::vector<Candidate>& candidates) {
+    {
+      WithInsertPoint guard(graph_->nodes().front());
+      auto list = graph_->insertNode(graph_->createList(
+          TensorType::get(), at::ArrayRef<Value*>(inputs)));
+      auto id = graph_->insertConstant(plan_id);
+      graph_->insertNode(
+          graph_->create(kMemoryPlanBegin, {id, list->output()}, 0));
+    }
+    for (size_t index = 0; index < candidates.size(); index++) {
+      Node* node = candidates[index].node;
+      WithInsertPoint guard(node);
+      auto id = graph_->insertConstant(plan_id);
+      auto buffer_index = graph_->insertConstant(static_cast<int64_t>(index));
+      auto buffer = graph_->insertNode(
+          graph_->create(kPlannedBuffer, {id, buffer_index}, 1));
+      buffer->output()->setType(TensorType::get());
+      std::vector<Value*> out_inputs(
+          node->inputs().begin(), node->inputs().end());
+      out_inputs.push_back(buffer->output());
+      auto out_node = graph_->insertNode(
+          graph_->create(node->kind(), out_inputs, 1));
+      out_node->output()->setType(node->output()->type());
+      node->output()->replaceAllUsesWith(out_node->output());
+      node->destroy();
+    }
+  }
+
+  std::shared_ptr<Graph> graph_;
+  AliasDb aliasDb_;
+  std::vector<Node*> nodes_;
+};
+
+} // namespace
+
+bool PlanGraphMemory(std::shared_ptr<Graph>& graph) {
+  bool changed = MemoryPlanner(graph).run();
+  if (changed) {
+    GRAPH_DUMP("After PlanGraphMemory", graph);
+  }
+  return changed;
+}
+
+} // namespace jit
+} // namespace torch
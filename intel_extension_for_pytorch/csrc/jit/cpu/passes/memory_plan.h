@@ -0,0 +1,15 @@
+#pragma once
+
+#include <torch/csrc/jit/ir/ir.h>
+
+namespace torch {
+namespace jit {
+
+// Place the intermediate tensors of the graph, for the input shapes it was
+// profiled with, at static offsets of one arena, reusing the space of a
+// tensor right after its last use. The ops producing them are replaced by
+// their out variants writing into the arena.
+bool PlanGraphMemory(std::shared_ptr<Graph>& graph);
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,242 @@
+#include "parallel_branches.h"
+
+#include <torch/csrc/jit/ir/alias_analysis.h>
+#include <torch/csrc/jit/jit_log.h>
+
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace torch {
+namespace jit {
+namespace {
+
+const Symbol kGetBranchCores = Symbol::fromQualString("ipex::get_branch_cores");
+const Symbol kSetBranchCores = Symbol::fromQualString("ipex::set_branch_cores");
+
+// Only fork the branches with enough compute to amortize the fork and the
+// wait.
+bool isComputeIntensive(Node* node) {
+  if (node->kind().is_prim()) {
+    return false;
+  }
+  const std::string name = node->kind().toUnqualString();
+  for (const char* op : {"embedding_bag", "conv", "linear", "matmul", "mm"}) {
+    if (name.find(op) != std::string::npos) {
+      return true;
+    }
+  }
+  return false;
+}
+
+class BranchParallelizer {
+ public:
+  explicit BranchParallelizer(std::shared_ptr<Graph> graph)
+      : graph_(std::move(graph)) {}
+
+  bool run() {
+    Block* block = graph_->block();
+    for (Node* node : block->nodes()) {
+      if (node->kind() == kSetBranchCores) {
+        // The subgraph of a forked branch, don't fork it again.
+        return false;
+      }
+    }
+    std::vector<Node*> join_nodes;
+    for (Node* node : block->nodes()) {
+      if (node->inputs().size() > 1) {
+        join_nodes.push_back(node);
+      }
+    }
+    bool changed = false;
+    for (Node* join_node : join_nodes) {
+      if (parallelizeInputs(join_node)) {
+        changed = true;
+        // The forked nodes are removed from the graph.
+        aliasDb_.reset();
+      }
+    }
+    return changed;
+  }
+
+ private:
+  AliasDb* getAliasDb() {
+    if (!aliasDb_) {
+      aliasDb_ = std::make_unique<AliasDb>(graph_);
+    }
+    return aliasDb_.get();
+  }
+
+  bool canFork(Node* node) {
+    if (node->kind() == prim::Constant || node->kind() == prim::Param ||
+        node->kind() == kGetBranchCores || node->hasSideEffects() ||
+        !node->blocks().empty() || node->outputs().empty()) {
+      return false;
+    }
+    // The forked node runs at the wait point, it must neither mutate any
+    // value nor read the value mutated by others.
+    if (getAliasDb()->isMutable(node)) {
+      return false;
+    }
+    for (Value* input : node->inputs()) {
+      if (getAliasDb()->hasWriters(input)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool usedOnlyBy(Node* node, const std::unordered_set<Node*>& users) {
+    for (Value* output : node->outputs()) {
+      if (output->uses().empty()) {
+        return false;
+      }
+      for (const Use& use : output->uses()) {
+        if (users.count(use.user) == 0) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+
+  // Collect the nodes computing output and used by nothing else than
+  // join_node, in topological order.
+  std::vector<Node*> collectBranch(Value* output, Node* join_node) {
+    Node* head = output->node();
+    if (head->owningBlock() != join_node->owningBlock() ||
+        head->outputs().size() != 1 || !canFork(head) ||
+        !usedOnlyBy(head, {join_node})) {
+      return {};
+    }
+    std::unordered_set<Node*> branch_nodes{head};
+    std::vector<Node*> branch{head};
+    Block* block = head->owningBlock();
+    for (Node* node = head->prev(); node != block->param_node();
+         node = node->prev()) {
+      if (canFork(node) && usedOnlyBy(node, branch_nodes)) {
+        branch_nodes.insert(node);
+        branch.push_back(node);
+      }
+    }
+    std::reverse(branch.begin(), branch.end());
+    return branch;
+  }
+
+  bool parallelizeInputs(Node* join_node) {
+    std::vector<std::vector<Node*>> branches;
+    std::vector<Value*> branch_outputs;
+    std::unordered_set<Value*> visited;
+    for (Value* input : join_node->inputs()) {
+      if (!visited.insert(input).second) {
+        continue;
+      }
+      auto branch = collectBranch(input, join_node);
+      if (std::any_of(branch.begin(), branch.end(), isComputeIntensive)) {
+        branches.emplace_back(std::move(branch));
+        branch_outputs.push_back(input);
+      }
+    }
+    if (branches.size() < 2) {
+      return false;
+    }
+
+    WithInsertPoint guard(join_node);
+    Node* branch_cores = graph_->insertNode(graph_->create(kGetBranchCores, 2));
+    branch_cores->output(0)->setType(ListType::ofInts());
+    branch_cores->output(1)->setType(IntType::get());
+    std::vector<Node*> fork_nodes;
+    for (size_t i = 0; i < branches.size(); i++) {
+      fork_nodes.push_back(
+          forkBranch(branches[i], branch_outputs[i], branch_cores, i,
+                     branches.size()));
+    }
+    // Wait after all the forks, so that the branches run concurrently.
+    for (size_t i = 0; i < branches.size(); i++) {
+      Node* wait_node = graph_->insertNode(
+          graph_->create(aten::wait, {fork_nodes[i]->output()}, 1));
+      wait_node->output()->copyMetadata(branch_outputs[i]);
+      branch_outputs[i]->replaceAllUsesWith(wait_node->output());
+      for (auto it = branches[i].rbegin(); it != branches[i].rend(); it++) {
+        (*it)->destroy();
+      }
+    }
+    GRAPH_UPDATE(
+        "Forked ", branches.size(), " branches of ", getHeader(join_node));
+    return true;
+  }
+
+  Node* forkBranch(
+      const std::vector<Node*>& branch,
+      Value* output,
+      Node* branch_cores,
+      int64_t branch_id,
+      int64_t num_branches) {
+    auto subgraph = std::make_shared<Graph>();
+    std::vector<Value*> fork_inputs;
+    std::unordered_map<Value*, Value*> value_map;
+    auto add_input = [&](Value* v) {
+      Value* input = subgraph->addInput()->copyMetadata(v);
+      fork_inputs.push_back(v);
+      value_map[v] = input;
+      return input;
+    };
+    Value* cpu_core_list = add_input(branch_cores->output(0));
+    Value* num_threads = add_input(branch_cores->output(1));
+    subgraph->insertNode(subgraph->create(
+        kSetBranchCores,
+        {cpu_core_list,
+         num_threads,
+         subgraph->insertConstant(branch_id),
+         subgraph->insertConstant(num_branches)},
+        0));
+
+    auto value_mapper = [&](Value* v) -> Value* {
+      auto it = value_map.find(v);
+      if (it != value_map.end()) {
+        return it->second;
+      }
+      if (v->node()->kind() == prim::Constant) {
+        // Keep the constants, e.g. the prepacked op contexts, inside the
+        // subgraph.
+        Node* constant = subgraph->insertNode(
+            subgraph->createClone(v->node(), [](Value* v) { return v; }));
+        value_map[v] = constant->output();
+        return constant->output();
+      }
+      return add_input(v);
+    };
+    for (Node* node : branch) {
+      Node* cloned =
+          subgraph->insertNode(subgraph->createClone(node, value_mapper));
+      for (size_t i = 0; i < node->outputs().size(); i++) {
+        value_map[node->output(i)] = cloned->output(i);
+      }
+    }
+    subgraph->registerOutput(value_map.at(output));
+
+    Node* fork_node =
+        graph_->insertNode(graph_->create(prim::fork, fork_inputs, 1));
+    fork_node->g_(attr::Subgraph, subgraph);
+    fork_node->output()->setType(FutureType::create(output->type()));
+    return fork_node;
+  }
+
+  std::shared_ptr<Graph> graph_;
+  std::unique_ptr<AliasDb> aliasDb_ = nullptr;
+};
+
+} // namespace
+
+bool ParallelizeIndependentBranches(std::shared_ptr<Graph>& graph) {
+  bool changed = BranchParallelizer(graph).run();
+  if (changed) {
+    GRAPH_DUMP("After ParallelizeIndependentBranches", graph);
+  }
+  return changed;
+}
+
+} // namespace jit
+} // namespace torch
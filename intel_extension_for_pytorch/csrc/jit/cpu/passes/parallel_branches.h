@@ -0,0 +1,14 @@
+#pragma once
+
+#include <torch/csrc/jit/ir/ir.h>
+
+namespace torch {
+namespace jit {
+
+// Fork the independent branches feeding the same node, e.g. the embedding
+// bags before the interaction of DLRM, into prim::fork subgraphs running
+// concurrently on disjoint slices of the cores of the current thread.
+bool ParallelizeIndependentBranches(std::shared_ptr<Graph>& graph);
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,99 @@
+#include "prepack_folding.h"
+
+#include <torch/csrc/jit/jit_log.h>
+#include <torch/csrc/jit/passes/constant_propagation.h>
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+namespace torch {
+namespace jit {
+namespace {
+
+bool isPrePackingOp(Node* node) {
+  static const std::unordered_set<Symbol> prepacking_ops = {
+      Symbol::fromQualString("ipex_prepack::convolution_prepack"),
+      Symbol::fromQualString("ipex_prepack::linear_prepack"),
+      Symbol::fromQualString("ipex_prepack::conv_transpose2d_prepack"),
+      Symbol::fromQualString("ipex_prepack::conv_transpose3d_prepack"),
+      Symbol::fromQualString("ipex_prepack::lstm_prepack"),
+  };
+  return prepacking_ops.count(node->kind());
+}
+
+void collectPrePackingOps(Block* block, std::vector<Node*>& nodes) {
+  for (Node* node : block->nodes()) {
+    for (Block* sub : node->blocks()) {
+      collectPrePackingOps(sub, nodes);
+    }
+    if (isPrePackingOp(node)) {
+      nodes.push_back(node);
+    }
+  }
+}
+
+// Where the first non-constant input of a prepacking op comes from.
+std::string describeNonConstantInput(Node* node) {
+  for (size_t i = 0; i < node->inputs().size(); i++) {
+    Value* input = node->input(i);
+    if (toIValue(input)) {
+      continue;
+    }
+    std::string name = node->schema().arguments()[i].name();
+    Node* producer = input->node();
+    if (producer->kind() == prim::GetAttr) {
+      return "its " + name + " is the attribute " + producer->s(attr::name) +
+          " of an unfrozen module";
+    }
+    if (producer->kind() == prim::Param) {
+      return "its " + name + " is a graph input";
+    }
+    return "its " + name + " is computed by " +
+        std::string(producer->kind().toQualString());
+  }
+  return "its inputs are not constant";
+}
+
+} // namespace
+
+bool FoldPrePackingOps(std::shared_ptr<Graph>& graph) {
+  std::vector<Node*> nodes;
+  collectPrePackingOps(graph->block(), nodes);
+
+  bool changed = false;
+  std::vector<Node*> unfolded;
+  for (Node* node : nodes) {
+    // the op contexts are custom class objects, which are graph constants
+    auto outputs = runNodeIfInputsAreConstant(node);
+    if (!outputs) {
+      unfolded.push_back(node);
+      continue;
+    }
+    WithInsertPoint guard(node);
+    auto packed = graph->insertConstant(outputs->at(0));
+    packed->setType(node->output()->type());
+    node->output()->replaceAllUsesWith(packed);
+    node->destroy();
+    changed = true;
+  }
+  if (changed) {
+    GRAPH_DUMP("After FoldPrePackingOps", graph);
+  }
+
+  if (!unfolded.empty()) {
+    Node* node = unfolded.front();
+    TORCH_WARN(
+        unfolded.size(),
+        " weight prepacking op(s) could not be folded into constants, e.g. ",
+        node->kind().toQualString(),
+        " since ",
+        describeNonConstantInput(node),
+        ". They pack the weights again on every call; freeze the traced ",
+        "module with torch.jit.freeze before running it.");
+  }
+  return changed;
+}
+
+} // namespace jit
+} // namespace torch
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <torch/csrc/jit/ir/ir.h>
+
+namespace torch {
+namespace jit {
+
+// Run the ipex_prepack::*_prepack ops of constant inputs and fold their op
+// contexts into the graph constants, so that the weights are packed once.
+// Warn about the ones left, e.g. the packing of the weights of an unfrozen
+// module, which runs again on every call.
+bool FoldPrePackingOps(std::shared_ptr<Graph>& graph);
+
+} // namespace jit
+} // namespace torch
@@ -3,21 +3,34 @@
 #include <torch/csrc/jit/runtime/custom_operator.h>
 #include <torch/csrc/jit/runtime/operator.h>
 
+#include "csrc/jit/cpu/kernels/AdaptivePoolLinear.h"
 #include "csrc/jit/cpu/kernels/AddLayerNorm.h"
 #include "csrc/jit/cpu/kernels/ConvPacked.h"
 #include "csrc/jit/cpu/kernels/ConvTransposePacked.h"
 #include "csrc/jit/cpu/kernels/Convolution.h"
+#include "csrc/jit/cpu/kernels/DepthwisePointwise.h"
+#include "csrc/jit/cpu/kernels/EltwiseChain.h"
+#include "csrc/jit/cpu/kernels/EltwisePostOp.h"
 #include "csrc/jit/cpu/kernels/Embeddingbag.h"
 #include "csrc/jit/cpu/kernels/Interaction.h"
 #include "csrc/jit/cpu/kernels/LinearPacked.h"
+#include "csrc/jit/cpu/kernels/LstmPacked.h"
 #include "csrc/jit/cpu/kernels/Matmul.h"
 #include "csrc/jit/cpu/kernels/MaxPool2D.h"
+#include "csrc/jit/cpu/kernels/MemoryPlan.h"
 #include "csrc/jit/cpu/kernels/Mha.h"
 #include "csrc/jit/cpu/kernels/OpContext.h"
+#include "csrc/jit/cpu/kernels/ParallelBranch.h"
+#include "csrc/jit/cpu/kernels/QuantizedOps.h"
 #include "csrc/jit/cpu/kernels/Shuffle.h"
 #include "csrc/jit/cpu/kernels/Softmax.h"
+#include "csrc/jit/cpu/kernels/UpsampleCat.h"
 
 #include "csrc/aten/cpu/Pooling.h"
+#include "csrc/aten/cpu/GroupNorm.h"
+#include "csrc/aten/cpu/RMSNorm.h"
+#include "csrc/aten/cpu/Rnnt.h"
+#include "csrc/aten/cpu/interaction.h"
 #include "csrc/utils/utils.h"
 
 namespace torch {
@@ -27,6 +40,12 @@ c10::AliasAnalysisKind aliasAnalysisFromSchema() {
   return c10::AliasAnalysisKind::FROM_SCHEMA;
 }
 
+// The ops depending on the state of the current thread must be neither
+// constant folded nor removed by the dead code elimination.
+c10::AliasAnalysisKind aliasAnalysisConservative() {
+  return c10::AliasAnalysisKind::CONSERVATIVE;
+}
+
 at::Tensor toOptionalTensor(const IValue& v) {
   return v.isNone() ? at::Tensor() : v.toTensor();
 }
@@ -35,6 +54,7 @@ using namespace torch_ipex::cpu;
 using namespace torch_ipex::cpu::detail::convolution;
 using namespace torch_ipex::cpu::detail::linear;
 using namespace torch_ipex::cpu::detail::conv_transpose2d;
+using namespace torch_ipex::cpu::detail::lstm;
 // Convolution Fusion Ops
 
 #define CONV_ARGS                               \
@@ -253,6 +273,274 @@ RegisterOperators op({
           };
         },
         aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::conv_transpose3d_run(Tensor input, "
+        "__torch__.torch.classes.ipex_prepack.ConvTransposeOpContext "
+        "W_prepack) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = conv_transpose3d_run(
+                (std::move(peek(stack, 0, 2))).toTensor(),
+                (std::move(peek(stack, 1, 2)))
+                    .toCustomClass<ConvTransposeOpContext>());
+            drop(stack, 2);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::convolution_eltwise_run(Tensor input, str eltwise, "
+        "Scalar? post_alpha, Scalar? post_beta, Scalar post_scale, "
+        "__torch__.torch.classes.ipex_prepack.ConvolutionOpContext "
+        "W_prepack) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = convolution_eltwise_run(
+                (std::move(peek(stack, 0, 6))).toTensor(),
+                (std::move(peek(stack, 1, 6))).toStringRef(),
+                (std::move(peek(stack, 2, 6))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 3, 6))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 4, 6))).toScalar(),
+                (std::move(peek(stack, 5, 6)))
+                    .toCustomClass<ConvolutionOpContext>());
+            drop(stack, 6);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::convolution_add_eltwise_run(Tensor input, Tensor(a!) "
+        "accumu, *, Scalar? alpha, str eltwise, Scalar? post_alpha, "
+        "Scalar? post_beta, Scalar post_scale, "
+        "__torch__.torch.classes.ipex_prepack.ConvolutionOpContext "
+        "W_prepack) -> Tensor(a!)",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto output = (std::move(peek(stack, 1, 8))).toTensor();
+            auto result = convolution_add_eltwise_run(
+                (std::move(peek(stack, 0, 8))).toTensor(),
+                output,
+                (std::move(peek(stack, 2, 8))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 3, 8))).toStringRef(),
+                (std::move(peek(stack, 4, 8))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 5, 8))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 6, 8))).toScalar(),
+                (std::move(peek(stack, 7, 8)))
+                    .toCustomClass<ConvolutionOpContext>());
+            drop(stack, 8);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::convolution_upsample_cat_run(Tensor input, "
+        "Tensor skip, bool skip_first, str mode, int[]? output_size, "
+        "bool align_corners, float[]? scale_factors, bool fuse_relu, "
+        "__torch__.torch.classes.ipex_prepack.ConvolutionOpContext "
+        "W_prepack) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = convolution_upsample_cat_run(
+                (std::move(peek(stack, 0, 9))).toTensor(),
+                (std::move(peek(stack, 1, 9))).toTensor(),
+                (std::move(peek(stack, 2, 9))).toBool(),
+                (std::move(peek(stack, 3, 9))).toStringRef(),
+                (std::move(peek(stack, 4, 9)))
+                    .toOptional<std::vector<int64_t>>(),
+                (std::move(peek(stack, 5, 9))).toBool(),
+                (std::move(peek(stack, 6, 9)))
+                    .toOptional<std::vector<double>>(),
+                (std::move(peek(stack, 7, 9))).toBool(),
+                (std::move(peek(stack, 8, 9)))
+                    .toCustomClass<ConvolutionOpContext>());
+            drop(stack, 9);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::convolution_depthwise_pointwise_run(Tensor input, "
+        "str eltwise, Scalar? post_alpha, Scalar? post_beta, "
+        "__torch__.torch.classes.ipex_prepack.ConvolutionOpContext "
+        "W_prepack, "
+        "__torch__.torch.classes.ipex_prepack.ConvolutionOpContext "
+        "W_prepack2) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = convolution_depthwise_pointwise_run(
+                (std::move(peek(stack, 0, 6))).toTensor(),
+                (std::move(peek(stack, 1, 6))).toStringRef(),
+                (std::move(peek(stack, 2, 6))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 3, 6))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 4, 6)))
+                    .toCustomClass<ConvolutionOpContext>(),
+                (std::move(peek(stack, 5, 6)))
+                    .toCustomClass<ConvolutionOpContext>());
+            drop(stack, 6);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::convolution_depthwise_pointwise_add_run(Tensor input, "
+        "Tensor(a!) accumu, *, Scalar? alpha, str eltwise, "
+        "Scalar? post_alpha, Scalar? post_beta, "
+        "__torch__.torch.classes.ipex_prepack.ConvolutionOpContext "
+        "W_prepack, "
+        "__torch__.torch.classes.ipex_prepack.ConvolutionOpContext "
+        "W_prepack2) -> Tensor(a!)",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto output = (std::move(peek(stack, 1, 8))).toTensor();
+            auto result = convolution_depthwise_pointwise_add_run(
+                (std::move(peek(stack, 0, 8))).toTensor(),
+                output,
+                (std::move(peek(stack, 2, 8))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 3, 8))).toStringRef(),
+                (std::move(peek(stack, 4, 8))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 5, 8))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 6, 8)))
+                    .toCustomClass<ConvolutionOpContext>(),
+                (std::move(peek(stack, 7, 8)))
+                    .toCustomClass<ConvolutionOpContext>());
+            drop(stack, 8);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::linear_eltwise_run(Tensor input, str eltwise, "
+        "Scalar? post_alpha, Scalar? post_beta, Scalar post_scale, "
+        "__torch__.torch.classes.ipex_prepack.LinearOpContext "
+        "W_prepack) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = linear_eltwise_run(
+                (std::move(peek(stack, 0, 6))).toTensor(),
+                (std::move(peek(stack, 1, 6))).toStringRef(),
+                (std::move(peek(stack, 2, 6))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 3, 6))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 4, 6))).toScalar(),
+                (std::move(peek(stack, 5, 6)))
+                    .toCustomClass<LinearOpContext>());
+            drop(stack, 6);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::linear_add_eltwise_run(Tensor input, Tensor(a!) "
+        "accumu, *, Scalar? alpha, str eltwise, Scalar? post_alpha, "
+        "Scalar? post_beta, Scalar post_scale, "
+        "__torch__.torch.classes.ipex_prepack.LinearOpContext "
+        "W_prepack) -> Tensor(a!)",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto output = (std::move(peek(stack, 1, 8))).toTensor();
+            auto result = linear_add_eltwise_run(
+                (std::move(peek(stack, 0, 8))).toTensor(),
+                output,
+                (std::move(peek(stack, 2, 8))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 3, 8))).toStringRef(),
+                (std::move(peek(stack, 4, 8))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 5, 8))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 6, 8))).toScalar(),
+                (std::move(peek(stack, 7, 8)))
+                    .toCustomClass<LinearOpContext>());
+            drop(stack, 8);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::conv_transpose2d_eltwise_run(Tensor input, str eltwise, "
+        "Scalar? post_alpha, Scalar? post_beta, Scalar post_scale, "
+        "__torch__.torch.classes.ipex_prepack.ConvTransposeOpContext "
+        "W_prepack) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = conv_transpose2d_eltwise_run(
+                (std::move(peek(stack, 0, 6))).toTensor(),
+                (std::move(peek(stack, 1, 6))).toStringRef(),
+                (std::move(peek(stack, 2, 6))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 3, 6))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 4, 6))).toScalar(),
+                (std::move(peek(stack, 5, 6)))
+                    .toCustomClass<ConvTransposeOpContext>());
+            drop(stack, 6);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::conv_transpose3d_eltwise_run(Tensor input, str eltwise, "
+        "Scalar? post_alpha, Scalar? post_beta, Scalar post_scale, "
+        "__torch__.torch.classes.ipex_prepack.ConvTransposeOpContext "
+        "W_prepack) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = conv_transpose3d_eltwise_run(
+                (std::move(peek(stack, 0, 6))).toTensor(),
+                (std::move(peek(stack, 1, 6))).toStringRef(),
+                (std::move(peek(stack, 2, 6))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 3, 6))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 4, 6))).toScalar(),
+                (std::move(peek(stack, 5, 6)))
+                    .toCustomClass<ConvTransposeOpContext>());
+            drop(stack, 6);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex::conv3d_eltwise(" CONV_ARGS ", str eltwise, Scalar? post_alpha, "
+        "Scalar? post_beta, Scalar post_scale) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = dil_convolution_eltwise(
+                (std::move(peek(stack, 0, 11))).toTensor(),
+                (std::move(peek(stack, 1, 11))).toTensor(),
+                toOptionalTensor(std::move(peek(stack, 2, 11))),
+                (std::move(peek(stack, 3, 11))).toIntVector(),
+                (std::move(peek(stack, 4, 11))).toIntVector(),
+                (std::move(peek(stack, 5, 11))).toIntVector(),
+                (std::move(peek(stack, 6, 11))).toInt(),
+                (std::move(peek(stack, 7, 11))).toStringRef(),
+                (std::move(peek(stack, 8, 11))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 9, 11))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 10, 11))).toScalar());
+            drop(stack, 11);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::lstm_run(Tensor input, Tensor[] hx, "
+        "__torch__.torch.classes.ipex_prepack.LstmOpContext W_prepack) "
+        "-> (Tensor, Tensor, Tensor)",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = lstm_run(
+                (std::move(peek(stack, 0, 3))).toTensor(),
+                (std::move(peek(stack, 1, 3))).toTensorVector(),
+                (std::move(peek(stack, 2, 3))).toCustomClass<LstmOpContext>());
+            drop(stack, 3);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
     Operator(
         "ipex_prepack::linear_run(Tensor input, "
         "__torch__.torch.classes.ipex_prepack.LinearOpContext W_prepack) "
@@ -321,6 +609,66 @@ RegisterOperators op({
           };
         },
         aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::adaptive_avg_pool_linear_run(Tensor input, "
+        "int[] output_size, "
+        "__torch__.torch.classes.ipex_prepack.LinearOpContext W_prepack) "
+        "-> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = adaptive_avg_pool_linear_run(
+                (std::move(peek(stack, 0, 3))).toTensor(),
+                (std::move(peek(stack, 1, 3))).toIntVector(),
+                (std::move(peek(stack, 2, 3)))
+                    .toCustomClass<LinearOpContext>());
+            drop(stack, 3);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::linear_gelu_linear_run(Tensor input, "
+        "__torch__.torch.classes.ipex_prepack.LinearOpContext W_prepack, "
+        "__torch__.torch.classes.ipex_prepack.LinearOpContext W_prepack2) "
+        "-> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = linear_gelu_linear_run(
+                (std::move(peek(stack, 0, 3))).toTensor(),
+                (std::move(peek(stack, 1, 3)))
+                    .toCustomClass<LinearOpContext>(),
+                (std::move(peek(stack, 2, 3)))
+                    .toCustomClass<LinearOpContext>());
+            drop(stack, 3);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::linear_gelu_linear_add_run(Tensor input, "
+        "Tensor(a!) accumu, *, Scalar? alpha, "
+        "__torch__.torch.classes.ipex_prepack.LinearOpContext W_prepack, "
+        "__torch__.torch.classes.ipex_prepack.LinearOpContext W_prepack2) "
+        "-> Tensor(a!)",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto output = (std::move(peek(stack, 1, 5))).toTensor();
+            auto result = linear_gelu_linear_add_run(
+                (std::move(peek(stack, 0, 5))).toTensor(),
+                output,
+                (std::move(peek(stack, 2, 5))).toOptional<at::Scalar>(),
+                (std::move(peek(stack, 3, 5)))
+                    .toCustomClass<LinearOpContext>(),
+                (std::move(peek(stack, 4, 5)))
+                    .toCustomClass<LinearOpContext>());
+            drop(stack, 5);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
     Operator(
         "ipex::max_pool2d(Tensor input, int[2] kernel_size, int[2] stride, "
         "int[2] padding, int[2] dilation, bool ceil_mode) -> Tensor",
@@ -339,6 +687,24 @@ RegisterOperators op({
           };
         },
         aliasAnalysisFromSchema()),
+    Operator(
+        "ipex::max_pool2d_relu(Tensor input, int[2] kernel_size, int[2] "
+        "stride, int[2] padding, int[2] dilation, bool ceil_mode) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = dil_max_pool2d_relu(
+                (std::move(peek(stack, 0, 6))).toTensor(),
+                (std::move(peek(stack, 1, 6))).toIntVector(),
+                (std::move(peek(stack, 2, 6))).toIntVector(),
+                (std::move(peek(stack, 3, 6))).toIntVector(),
+                (std::move(peek(stack, 4, 6))).toIntVector(),
+                (std::move(peek(stack, 5, 6))).toBool());
+            drop(stack, 6);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
     Operator(
         "ipex::matmul_div(Tensor left, Tensor right, Tensor? out_opt, Tensor "
         "div_input) -> Tensor",
@@ -425,6 +791,24 @@ RegisterOperators op({
         },
         aliasAnalysisFromSchema()),
 
+    Operator(
+        "ipex::mha(Tensor q, Tensor k, Tensor v, Tensor rel_qk, Scalar alpha, "
+        "Scalar dim_per_head, int softmax_dim, ScalarType ? dtype) -> Tensor",
+        [](Stack& stack) {
+          auto result = dil_mha(
+              peek(stack, 0, 8).toTensor(),
+              peek(stack, 1, 8).toTensor(),
+              peek(stack, 2, 8).toTensor(),
+              peek(stack, 3, 8).toTensor(),
+              peek(stack, 4, 8).toScalar(),
+              peek(stack, 5, 8).toScalar(),
+              peek(stack, 6, 8).toInt(),
+              peek(stack, 7, 8));
+          drop(stack, 8);
+          pack(stack, std::move(result));
+        },
+        aliasAnalysisFromSchema()),
+
     Operator(
         "ipex::softmax(Tensor self, int dim, ScalarType ? dtype) -> Tensor",
         [](const Node* node) -> Operation {
@@ -500,6 +884,119 @@ RegisterOperators op({
         },
         aliasAnalysisFromSchema()),
 
+    Operator(
+        "ipex::qadd(Tensor qa, Tensor qb, Scalar alpha, float o_scale, "
+        "int o_zp, ScalarType o_dtype) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = dil_qadd(
+                (std::move(peek(stack, 0, 6))).toTensor(),
+                (std::move(peek(stack, 1, 6))).toTensor(),
+                (std::move(peek(stack, 2, 6))).toScalar(),
+                (std::move(peek(stack, 3, 6))).toDouble(),
+                (std::move(peek(stack, 4, 6))).toInt(),
+                (std::move(peek(stack, 5, 6))).toScalarType());
+            drop(stack, 6);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+
+    Operator(
+        "ipex::qcat(Tensor[] tensors, int dim, float o_scale, int o_zp, "
+        "ScalarType o_dtype) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = dil_qcat(
+                (std::move(peek(stack, 0, 5))).toTensorVector(),
+                (std::move(peek(stack, 1, 5))).toInt(),
+                (std::move(peek(stack, 2, 5))).toDouble(),
+                (std::move(peek(stack, 3, 5))).toInt(),
+                (std::move(peek(stack, 4, 5))).toScalarType());
+            drop(stack, 5);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+
+    Operator(
+        "ipex::rnnt_greedy_decode(Tensor x, Tensor out_lens, "
+        "Tensor embedding_table, "
+        "__torch__.torch.classes.ipex_prepack.LstmOpContext lstm, "
+        "Tensor joint_weight1, Tensor joint_bias1, Tensor joint_weight2, "
+        "Tensor joint_bias2, int max_symbols, int blank_id, int _SOS) "
+        "-> (Tensor, Tensor)",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = torch_ipex::kernel::rnnt_greedy_decode(
+                (std::move(peek(stack, 0, 11))).toTensor(),
+                (std::move(peek(stack, 1, 11))).toTensor(),
+                (std::move(peek(stack, 2, 11))).toTensor(),
+                (std::move(peek(stack, 3, 11))).toCustomClass<LstmOpContext>(),
+                (std::move(peek(stack, 4, 11))).toTensor(),
+                (std::move(peek(stack, 5, 11))).toTensor(),
+                (std::move(peek(stack, 6, 11))).toTensor(),
+                (std::move(peek(stack, 7, 11))).toTensor(),
+                (std::move(peek(stack, 8, 11))).toInt(),
+                (std::move(peek(stack, 9, 11))).toInt(),
+                (std::move(peek(stack, 10, 11))).toInt());
+            drop(stack, 11);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+
+    Operator(
+        "ipex::rnnt_beam_search_decode(Tensor x, Tensor out_lens, "
+        "Tensor embedding_table, "
+        "__torch__.torch.classes.ipex_prepack.LstmOpContext lstm, "
+        "Tensor joint_weight1, Tensor joint_bias1, Tensor joint_weight2, "
+        "Tensor joint_bias2, int beam_size, int max_symbols, int blank_id, "
+        "int _SOS) -> (Tensor, Tensor)",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = torch_ipex::kernel::rnnt_beam_search_decode(
+                (std::move(peek(stack, 0, 12))).toTensor(),
+                (std::move(peek(stack, 1, 12))).toTensor(),
+                (std::move(peek(stack, 2, 12))).toTensor(),
+                (std::move(peek(stack, 3, 12))).toCustomClass<LstmOpContext>(),
+                (std::move(peek(stack, 4, 12))).toTensor(),
+                (std::move(peek(stack, 5, 12))).toTensor(),
+                (std::move(peek(stack, 6, 12))).toTensor(),
+                (std::move(peek(stack, 7, 12))).toTensor(),
+                (std::move(peek(stack, 8, 12))).toInt(),
+                (std::move(peek(stack, 9, 12))).toInt(),
+                (std::move(peek(stack, 10, 12))).toInt(),
+                (std::move(peek(stack, 11, 12))).toInt());
+            drop(stack, 12);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+
+    Operator(
+        "ipex::embedding_bag_interaction(Tensor dense, Tensor[] weights, "
+        "Tensor[] indices, Tensor[] offsets, bool include_last_offset) -> "
+        "Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = embedding_bag_interaction_forward(
+                (std::move(peek(stack, 0, 5))).toTensor(),
+                (std::move(peek(stack, 1, 5))).toTensorVector(),
+                (std::move(peek(stack, 2, 5))).toTensorVector(),
+                (std::move(peek(stack, 3, 5))).toTensorVector(),
+                (std::move(peek(stack, 4, 5))).toBool());
+            drop(stack, 5);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+
     Operator(
         "ipex::shuffle_2d("
         "  Tensor input,"
@@ -541,6 +1038,194 @@ RegisterOperators op({
           };
         },
         aliasAnalysisFromSchema()),
+    Operator(
+        "ipex::rms_norm(Tensor input, Tensor? weight, float eps) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = torch_ipex::cpu::rms_norm(
+                (std::move(peek(stack, 0, 3))).toTensor(),
+                toOptionalTensor(std::move(peek(stack, 1, 3))),
+                (std::move(peek(stack, 2, 3))).toDouble());
+            drop(stack, 3);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex::add_rms_norm(Tensor input, Tensor residual, Tensor? weight, "
+        "float eps) -> (Tensor, Tensor)",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = torch_ipex::cpu::add_rms_norm(
+                (std::move(peek(stack, 0, 4))).toTensor(),
+                (std::move(peek(stack, 1, 4))).toTensor(),
+                toOptionalTensor(std::move(peek(stack, 2, 4))),
+                (std::move(peek(stack, 3, 4))).toDouble());
+            drop(stack, 4);
+            push(stack, std::move(std::get<0>(result)), std::get<1>(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex::group_norm_silu(Tensor input, int num_groups, Tensor? weight, "
+        "Tensor? bias, float eps) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = torch_ipex::cpu::group_norm_silu(
+                (std::move(peek(stack, 0, 5))).toTensor(),
+                (std::move(peek(stack, 1, 5))).toInt(),
+                toOptionalTensor(std::move(peek(stack, 2, 5))),
+                toOptionalTensor(std::move(peek(stack, 3, 5))),
+                (std::move(peek(stack, 4, 5))).toDouble());
+            drop(stack, 5);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex::eltwise_chain(Tensor[] inputs, float[] scalars, int[] "
+        "program) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = eltwise_chain(
+                (std::move(peek(stack, 0, 3))).toTensorVector(),
+                (std::move(peek(stack, 1, 3))).toDoubleVector(),
+                (std::move(peek(stack, 2, 3))).toIntVector());
+            drop(stack, 3);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex::get_branch_cores() -> (int[], int)",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = get_branch_cores();
+            push(stack, std::move(std::get<0>(result)), std::get<1>(result));
+            return 0;
+          };
+        },
+        aliasAnalysisConservative()),
+    Operator(
+        "ipex::set_branch_cores(int[] cpu_core_list, int num_threads, "
+        "int branch_id, int num_branches) -> ()",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            set_branch_cores(
+                (std::move(peek(stack, 0, 4))).toIntVector(),
+                (std::move(peek(stack, 1, 4))).toInt(),
+                (std::move(peek(stack, 2, 4))).toInt(),
+                (std::move(peek(stack, 3, 4))).toInt());
+            drop(stack, 4);
+            return 0;
+          };
+        },
+        aliasAnalysisConservative()),
+    Operator(
+        "ipex::memory_plan_begin(int plan_id, Tensor[] inputs) -> ()",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            memory_plan_begin(
+                (std::move(peek(stack, 0, 2))).toInt(),
+                (std::move(peek(stack, 1, 2))).toTensorVector());
+            drop(stack, 2);
+            return 0;
+          };
+        },
+        aliasAnalysisConservative()),
+    Operator(
+        "ipex::planned_buffer(int plan_id, int index) -> Tensor",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto result = planned_buffer(
+                (std::move(peek(stack, 0, 2))).toInt(),
+                (std::move(peek(stack, 1, 2))).toInt());
+            drop(stack, 2);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisConservative()),
+    Operator(
+        "ipex_prepack::convolution_run.out(Tensor input, "
+        "__torch__.torch.classes.ipex_prepack.ConvolutionOpContext "
+        "W_prepack, *, Tensor(a!) out) -> Tensor(a!)",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto out = (std::move(peek(stack, 2, 3))).toTensor();
+            auto result = convolution_run_out(
+                (std::move(peek(stack, 0, 3))).toTensor(),
+                (std::move(peek(stack, 1, 3)))
+                    .toCustomClass<ConvolutionOpContext>(),
+                out,
+                ideep::attr_t());
+            drop(stack, 3);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::convolution_relu_run.out(Tensor input, "
+        "__torch__.torch.classes.ipex_prepack.ConvolutionOpContext "
+        "W_prepack, *, Tensor(a!) out) -> Tensor(a!)",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto out = (std::move(peek(stack, 2, 3))).toTensor();
+            auto result = convolution_run_out(
+                (std::move(peek(stack, 0, 3))).toTensor(),
+                (std::move(peek(stack, 1, 3)))
+                    .toCustomClass<ConvolutionOpContext>(),
+                out,
+                ideep::attr_t::fuse_relu());
+            drop(stack, 3);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::linear_run.out(Tensor input, "
+        "__torch__.torch.classes.ipex_prepack.LinearOpContext "
+        "W_prepack, *, Tensor(a!) out) -> Tensor(a!)",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto out = (std::move(peek(stack, 2, 3))).toTensor();
+            auto result = linear_run_out(
+                (std::move(peek(stack, 0, 3))).toTensor(),
+                (std::move(peek(stack, 1, 3)))
+                    .toCustomClass<LinearOpContext>(),
+                out,
+                ideep::attr_t());
+            drop(stack, 3);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
+    Operator(
+        "ipex_prepack::linear_relu_run.out(Tensor input, "
+        "__torch__.torch.classes.ipex_prepack.LinearOpContext "
+        "W_prepack, *, Tensor(a!) out) -> Tensor(a!)",
+        [](const Node* node) -> Operation {
+          return [](Stack* stack) {
+            auto out = (std::move(peek(stack, 2, 3))).toTensor();
+            auto result = linear_run_out(
+                (std::move(peek(stack, 0, 3))).toTensor(),
+                (std::move(peek(stack, 1, 3)))
+                    .toCustomClass<LinearOpContext>(),
+                out,
+                ideep::attr_t::fuse_relu());
+            drop(stack, 3);
+            pack(stack, std::move(result));
+            return 0;
+          };
+        },
+        aliasAnalysisFromSchema()),
 
 });
 } // namespace jit
@@ -2,12 +2,18 @@
 #include <string>
 #include "autocast/autocast_mode.h"
 #include "codegen/onednn/interface.h"
+#include "codegen/onednn/lowering_selection.h"
 #include "cpu/passes/graph_rewrite.h"
 
 #include "aten/cpu/Pooling.h"
 #include "cpu/kernels/Convolution.h"
 #include "cpu/kernels/Matmul.h"
-#include "cpu/passes/concat_linear.h"
+#include "cpu/passes/eltwise_chain.h"
+#include "cpu/passes/horizontal_fusion.h"
+#include "cpu/passes/memory_plan.h"
+#include "cpu/passes/parallel_branches.h"
+#include "cpu/passes/prepack_folding.h"
+#include "quantization/auto_opt_config.hpp"
 
 #include <c10/util/hash.h>
 #include <torch/csrc/jit/frontend/error_report.h>
@@ -307,34 +313,59 @@ void IPEXFusionPass(std::shared_ptr<Graph>& graph) {
   // remove dropout;
   torch::jit::removeDropout(graph);
 
-  // concat multi-linear with same input
-  FrozenConcatLinear(graph);
-
-  // Fuse the scores calculation(dim + matmul + (add)? + softmax) for
-  // Multi-Head-Attention
+  // Fuse the scores calculation(dim + matmul + (add)? + softmax), together
+  // with the following matmul if any, for Multi-Head-Attention
   graph_rewrite::FuseMHAScoreCalc(graph);
 
   // Replace _convolution with conv2d or conv3d
   graph_rewrite::replaceConvolutionWithAtenConv(graph);
   // graph_rewrite_helper::replaceConvolutionWithAtenConv(graph);
+  // fold the frozen batch norm into the conv ahead of it
+  graph_rewrite::foldConvWithFrozenBatchNorm(graph);
+
+  // permute the weights of the convolutions reading a channel shuffle
+  graph_rewrite::fuseShuffleWithConv(graph);
+
+  // concat the sibling linear, conv2d and matmul ops with the same input
+  FrozenHorizontalFusion(graph);
 
   // convolution fusion
   graph_rewrite::insertPrePackedConv2dOp(graph);
   graph_rewrite::fuseConvWithEltwise(graph);
   graph_rewrite::fuseConvAddRelu(graph);
+  // upsample + cat + conv of the decoder blocks
+  graph_rewrite::fuseConvWithUpsampleCat(graph);
 
   // linear fusion
   graph_rewrite::insertPrePackedLinearOp(graph);
   graph_rewrite::fuseLinearWithEltwise(graph);
   graph_rewrite::fuseLinearAddRelu(graph);
+  // the transformer FFN of linear + gelu + linear (+ add)
+  graph_rewrite::fuseLinearGeluLinear(graph);
+  // the classifier head of adaptive_avg_pool2d + flatten + linear
+  graph_rewrite::fuseAdaptiveAvgPoolLinear(graph);
 
   // fuse add+layernorm
   graph_rewrite::FuseAddLayerNorm(graph);
+  // the RMSNorm of LLaMA or T5, with the residual add ahead of it
+  graph_rewrite::FuseRMSNorm(graph);
+  // group_norm, and instance_norm as the one of a group per channel, + silu
+  graph_rewrite::FuseGroupNorm(graph);
   // deconvolution fusion
-  graph_rewrite::insertPrePackedConvTranspose2dOp(graph);
+  graph_rewrite::insertPrePackedConvTransposeOp(graph);
+  // the remaining eltwise ops after conv, conv3d, deconv and linear, e.g.
+  // hardswish, mish or the post-sum sigmoid, as oneDNN post ops
+  graph_rewrite::fuseWithEltwisePostOps(graph);
+  // the depthwise conv + activation + pointwise conv of the inverted
+  // residual blocks, of all the activations fused above
+  graph_rewrite::fuseDepthwisePointwiseConv(graph);
+  // lstm weight prepack
+  graph_rewrite::insertPrePackedLstmOp(graph);
 
   // Fuse operators as shuffle
   graph_rewrite::FuseShuffle(graph);
+  // pool the DLRM embedding bags straight into the interaction input
+  graph_rewrite::fuseEmbeddingBagWithInteraction(graph);
   // Pattern based fusion was lack of alias analysis
   // ??? It may either be too conservative or too aggressive ???
   // getSubgraphRewriter().runOnGraph(graph);
@@ -348,8 +379,14 @@ void IPEXFusionPass(std::shared_ptr<Graph>& graph) {
   // replace aten::batch_norm with ipex::batch_norm, it will be removed
   // after TensorExprs fix the performance issue(IPB-808).
   graph_rewrite::replaceAtenBatchNormWithIpexBatchNorm(graph);
+
+  // fuse the remaining element-wise chains, e.g. the ones following the
+  // batch norm, into one vectorized loop
+  FuseElementwiseChains(graph);
   // TODO: Some post processing?? ECS/EDC/Peephole???
   ConstantPropagation(graph);
+  // make sure the weights are packed once, or tell why they are not
+  FoldPrePackingOps(graph);
 }
 
 bool checkQuantization(Block* block) {
@@ -378,11 +415,13 @@ void FusionPass(std::shared_ptr<Graph>& graph) {
       graph);
   RemoveProfileNodesAndSpecializeTypes(graph);
 
-  // LLGA fusion pass for int8
+  // LLGA fusion pass for int8, and for the fp32 and bf16 partitions of which
+  // the lowering selection picks LLGA over the IPEX fusion pass below
   GRAPH_DUMP(
       "After RemoveProfileNodesAndSpecializeTypes. Before LLGA fusion pass",
       graph);
-  if (isQuantized(graph) || torch_ipex::autocast::is_llga_fp32_bf16_enabled()) {
+  if (isQuantized(graph) || torch_ipex::autocast::is_llga_fp32_bf16_enabled() ||
+      fuser::onednn::lowering_selection::isEnabled()) {
     fuser::onednn::fuseGraph(graph);
   }
   GRAPH_DUMP("After LLGA fusion pass. Before IPEXFusionPass", graph);
@@ -392,6 +431,11 @@ void FusionPass(std::shared_ptr<Graph>& graph) {
   GRAPH_DUMP(
       "After IPEXFusionPass. Before RemoveTensorTypeSpecializations", graph);
 
+  // Run the independent branches of the fused graph concurrently
+  if (torch_ipex::AutoOptConfig::singleton().get_jit_branch_parallel()) {
+    ParallelizeIndependentBranches(graph);
+  }
+
   // TODO: workaround here to go throughput the TE fuser pass before
   // RemoveTensorTypeSpecializations since TE fuser needs the type
   // specializations
@@ -399,6 +443,12 @@ void FusionPass(std::shared_ptr<Graph>& graph) {
   BatchMM(graph);
   FuseTensorExprs(graph, getFusionGroupInlining() ? 2 : 1);
 
+  // Place the intermediates in one arena, while the types are still
+  // specialized to the profiled shapes
+  if (torch_ipex::AutoOptConfig::singleton().get_jit_memory_plan()) {
+    PlanGraphMemory(graph);
+  }
+
   RemoveTensorTypeSpecializations(graph);
   GRAPH_DUMP(
       "After RemoveTensorTypeSpecializations. End of optimization pass", graph);
@@ -0,0 +1,219 @@
+#include "MicroBatchScheduler.h"
+
+#include <ATen/ATen.h>
+
+namespace torch_ipex {
+namespace runtime {
+
+namespace {
+
+// Split the output of one micro-batch back to the output of each request.
+// Support Tensor output and Tuple/List of Tensor output.
+std::vector<c10::IValue> split_micro_batch_output(
+    const c10::IValue& output,
+    const std::vector<int64_t>& split_sizes) {
+  std::vector<c10::IValue> results;
+  results.reserve(split_sizes.size());
+  if (output.isTensor()) {
+    auto outputs = output.toTensor().split_with_sizes(split_sizes, 0);
+    for (auto& o : outputs) {
+      results.emplace_back(std::move(o));
+    }
+    return results;
+  }
+
+  TORCH_CHECK(
+      output.isTuple() || output.isTensorList() || output.isList(),
+      "MicroBatchScheduler only supports the module which returns a Tensor or a Tuple/List of Tensors");
+  std::vector<c10::IValue> elements = output.isTuple()
+      ? output.toTuple()->elements().vec()
+      : output.toList().vec();
+  std::vector<std::vector<at::Tensor>> element_splits;
+  for (auto& element : elements) {
+    TORCH_CHECK(
+        element.isTensor(),
+        "MicroBatchScheduler only supports the module which returns a Tensor or a Tuple/List of Tensors");
+    element_splits.emplace_back(
+        element.toTensor().split_with_sizes(split_sizes, 0));
+  }
+  for (size_t i = 0; i < split_sizes.size(); i++) {
+    std::vector<c10::IValue> request_elements;
+    for (auto& element_split : element_splits) {
+      request_elements.emplace_back(element_split[i]);
+    }
+    if (output.isTuple()) {
+      results.emplace_back(c10::ivalue::Tuple::create(request_elements));
+    } else {
+      std::vector<at::Tensor> request_tensors;
+      for (auto& e : request_elements) {
+        request_tensors.emplace_back(e.toTensor());
+      }
+      results.emplace_back(request_tensors);
+    }
+  }
+  return results;
+}
+
+} // namespace
+
+MicroBatchScheduler::MicroBatchScheduler(
+    const torch::jit::Module& module,
+    const std::vector<std::vector<int32_t>>& stream_core_lists,
+    int64_t max_batch_size,
+    int64_t max_latency_us)
+    : script_module_(module),
+      max_batch_size_(max_batch_size),
+      max_latency_(std::chrono::microseconds(max_latency_us)) {
+  TORCH_CHECK(
+      !stream_core_lists.empty(),
+      "MicroBatchScheduler requires at least one stream");
+  TORCH_CHECK(
+      max_batch_size > 0, "max_batch_size of MicroBatchScheduler must be > 0");
+  TORCH_CHECK(
+      max_latency_us >= 0, "max_latency of MicroBatchScheduler must be >= 0");
+  for (auto& cpu_core_list : stream_core_lists) {
+    this->streams.emplace_back(std::make_shared<TaskExecutor>(cpu_core_list));
+  }
+  this->in_flight.reset(new std::atomic<int64_t>[this->streams.size()]);
+  for (size_t i = 0; i < this->streams.size(); i++) {
+    this->in_flight[i] = 0;
+  }
+  this->dispatcher = std::thread([this] { this->dispatch_loop(); });
+}
+
+MicroBatchScheduler::~MicroBatchScheduler() {
+  this->stop_scheduler();
+}
+
+std::unique_ptr<FutureTensor> MicroBatchScheduler::submit(
+    const at::Tensor& input) {
+  TORCH_CHECK(
+      input.dim() >= 1,
+      "The input of MicroBatchScheduler must have the batch dim");
+  std::unique_ptr<FutureTensor> future_tensor_result =
+      std::make_unique<FutureTensor>();
+  Request request;
+  request.input = input;
+  request.completion = future_tensor_result->completion;
+  request.grad_mode = at::GradMode::is_enabled();
+  request.arrival = std::chrono::steady_clock::now();
+  future_tensor_result->script_module_initialized_ = true;
+  future_tensor_result->future_script_tensor = request.promise.get_future();
+  {
+    std::unique_lock<std::mutex> lock(this->scheduler_mutex);
+    // submit request to a stopping scheduler is not allowed
+    if (this->stop)
+      throw std::runtime_error("submit request on stopped MicroBatchScheduler");
+    this->pending_batch_size += input.size(0);
+    this->requests.emplace_back(std::move(request));
+  }
+  this->scheduler_condition.notify_one();
+  return future_tensor_result;
+}
+
+size_t MicroBatchScheduler::get_least_loaded_stream() {
+  size_t stream_id = 0;
+  int64_t least_in_flight = this->in_flight[0].load();
+  for (size_t i = 1; i < this->streams.size(); i++) {
+    int64_t current_in_flight = this->in_flight[i].load();
+    if (current_in_flight < least_in_flight) {
+      least_in_flight = current_in_flight;
+      stream_id = i;
+    }
+  }
+  return stream_id;
+}
+
+void MicroBatchScheduler::dispatch_loop() {
+  while (true) {
+    auto micro_batch = std::make_shared<std::vector<Request>>();
+    {
+      std::unique_lock<std::mutex> lock(this->scheduler_mutex);
+      this->scheduler_condition.wait(
+          lock, [this] { return this->stop || !this->requests.empty(); });
+      if (this->stop && this->requests.empty())
+        return;
+
+      // Wait until the micro-batch is full or the oldest request expires.
+      auto deadline = this->requests.front().arrival + this->max_latency_;
+      this->scheduler_condition.wait_until(lock, deadline, [this] {
+        return this->stop || this->pending_batch_size >= this->max_batch_size_;
+      });
+
+      int64_t batch_size = 0;
+      while (!this->requests.empty()) {
+        int64_t request_batch_size = this->requests.front().input.size(0);
+        // A request larger than max_batch_size is dispatched alone.
+        if (!micro_batch->empty() &&
+            batch_size + request_batch_size > this->max_batch_size_)
+          break;
+        batch_size += request_batch_size;
+        this->pending_batch_size -= request_batch_size;
+        micro_batch->emplace_back(std::move(this->requests.front()));
+        this->requests.pop_front();
+      }
+    }
+
+    size_t stream_id = this->get_least_loaded_stream();
+    this->in_flight[stream_id]++;
+    this->streams[stream_id]->submit([this, micro_batch, stream_id]() {
+      this->run_micro_batch(micro_batch, stream_id);
+    });
+  }
+}
+
+void MicroBatchScheduler::run_micro_batch(
+    std::shared_ptr<std::vector<Request>> micro_batch,
+    size_t stream_id) {
+  std::vector<at::Tensor> inputs;
+  std::vector<int64_t> split_sizes;
+  inputs.reserve(micro_batch->size());
+  split_sizes.reserve(micro_batch->size());
+  for (auto& request : *micro_batch) {
+    inputs.emplace_back(request.input);
+    split_sizes.emplace_back(request.input.size(0));
+  }
+  std::vector<c10::IValue> results;
+  try {
+    // set the thread local status, such as the grad mode before execuating
+    // the micro-batch
+    at::GradMode::set_enabled(micro_batch->front().grad_mode);
+    at::Tensor batched_input = inputs.size() == 1 ? inputs[0] : at::cat(inputs);
+    c10::IValue output = this->script_module_.forward({batched_input});
+    results = split_micro_batch_output(output, split_sizes);
+  } catch (...) {
+    for (auto& request : *micro_batch) {
+      request.promise.set_exception(std::current_exception());
+      request.completion->mark_done();
+    }
+    this->in_flight[stream_id]--;
+    return;
+  }
+  for (size_t i = 0; i < micro_batch->size(); i++) {
+    (*micro_batch)[i].promise.set_value(std::move(results[i]));
+    (*micro_batch)[i].completion->mark_done();
+  }
+  this->in_flight[stream_id]--;
+}
+
+void MicroBatchScheduler::stop_scheduler() {
+  bool should_wait_dispatcher_join = false;
+  {
+    std::unique_lock<std::mutex> lock(this->scheduler_mutex);
+    if (this->stop == false) {
+      should_wait_dispatcher_join = true;
+      this->stop = true;
+    }
+  }
+  if (should_wait_dispatcher_join) {
+    // The dispatcher flushes the pending requests before exiting.
+    this->scheduler_condition.notify_all();
+    this->dispatcher.join();
+    for (auto& stream : this->streams) {
+      stream->stop_executor();
+    }
+  }
+}
+
+} // namespace runtime
+} // namespace torch_ipex
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <ATen/core/ivalue.h>
+#include <torch/csrc/jit/api/module.h>
+#include "TaskModule.h"
+#include "cpu/runtime/TaskExecutor.h"
+
+namespace torch_ipex {
+namespace runtime {
+
+/*MicroBatchScheduler collects the single requests of a script module into
+ * micro-batches. A micro-batch is dispatched once it reaches max_batch_size or
+ * once the oldest request in it has waited for max_latency_us. Each
+ * micro-batch is sent to the stream with the least in-flight micro-batches,
+ * and the output is split back to the FutureTensor of each request along the
+ * batch dim (dim 0).*/
+class TORCH_API MicroBatchScheduler {
+ public:
+  explicit MicroBatchScheduler(
+      const torch::jit::Module& module,
+      const std::vector<std::vector<int32_t>>& stream_core_lists,
+      int64_t max_batch_size,
+      int64_t max_latency_us);
+  ~MicroBatchScheduler();
+  std::unique_ptr<FutureTensor> submit(const at::Tensor& input);
+  void stop_scheduler();
+
+ private:
+  struct Request {
+    at::Tensor input;
+    std::promise<c10::IValue> promise;
+    std::shared_ptr<TaskCompletion> completion;
+    bool grad_mode;
+    std::chrono::steady_clock::time_point arrival;
+  };
+
+  void dispatch_loop();
+  void run_micro_batch(
+      std::shared_ptr<std::vector<Request>> micro_batch,
+      size_t stream_id);
+  size_t get_least_loaded_stream();
+
+  torch::jit::Module script_module_;
+  int64_t max_batch_size_;
+  std::chrono::microseconds max_latency_;
+
+  // Streams and the number of in-flight micro-batches of each stream
+  std::vector<std::shared_ptr<TaskExecutor>> streams;
+  std::unique_ptr<std::atomic<int64_t>[]> in_flight;
+
+  // Pending requests which are not batched yet
+  std::deque<Request> requests;
+  int64_t pending_batch_size{0};
+  bool stop{false};
+  std::mutex scheduler_mutex;
+  std::condition_variable scheduler_condition;
+  std::thread dispatcher;
+
+  MicroBatchScheduler(const MicroBatchScheduler& scheduler) = delete;
+  MicroBatchScheduler& operator=(const MicroBatchScheduler& scheduler) =
+      delete;
+};
+
+} // namespace runtime
+} // namespace torch_ipex
@@ -0,0 +1,140 @@
+#include "PipelineScheduler.h"
+
+namespace torch_ipex {
+namespace runtime {
+
+PipelineScheduler::PipelineScheduler(
+    const std::vector<torch::jit::Module>& stage_modules,
+    const std::vector<std::shared_ptr<CPUPool>>& stage_cpu_pools,
+    int64_t max_queue_size)
+    : max_queue_size_(max_queue_size) {
+  TORCH_CHECK(
+      !stage_modules.empty(), "PipelineScheduler requires at least one stage");
+  TORCH_CHECK(
+      stage_modules.size() == stage_cpu_pools.size(),
+      "PipelineScheduler requires one CPUPool for each stage");
+  TORCH_CHECK(
+      max_queue_size > 0, "max_queue_size of PipelineScheduler must be > 0");
+  for (size_t i = 0; i < stage_modules.size(); i++) {
+    auto stage = std::make_unique<Stage>();
+    stage->module = stage_modules[i];
+    stage->task_executor = std::make_shared<TaskExecutor>(*stage_cpu_pools[i]);
+    this->stages.emplace_back(std::move(stage));
+  }
+}
+
+PipelineScheduler::~PipelineScheduler() {
+  this->stop_scheduler();
+}
+
+void PipelineScheduler::acquire_slot(size_t stage_id) {
+  auto& stage = this->stages[stage_id];
+  std::unique_lock<std::mutex> lock(stage->stage_mutex);
+  stage->stage_condition.wait(
+      lock, [&] { return stage->in_flight < this->max_queue_size_; });
+  stage->in_flight++;
+}
+
+void PipelineScheduler::release_slot(size_t stage_id) {
+  auto& stage = this->stages[stage_id];
+  {
+    std::unique_lock<std::mutex> lock(stage->stage_mutex);
+    stage->in_flight--;
+  }
+  stage->stage_condition.notify_one();
+}
+
+std::unique_ptr<FutureTensor> PipelineScheduler::submit(
+    std::vector<c10::IValue>&& inputs) {
+  {
+    std::unique_lock<std::mutex> lock(this->scheduler_mutex);
+    // submit request to a stopping scheduler is not allowed
+    if (this->stop)
+      throw std::runtime_error("submit request on stopped PipelineScheduler");
+  }
+  std::unique_ptr<FutureTensor> future_tensor_result =
+      std::make_unique<FutureTensor>();
+  auto request = std::make_shared<Request>();
+  request->completion = future_tensor_result->completion;
+  request->grad_mode = at::GradMode::is_enabled();
+  future_tensor_result->script_module_initialized_ = true;
+  future_tensor_result->future_script_tensor = request->promise.get_future();
+  this->submit_to_stage(0, request, std::move(inputs));
+  return future_tensor_result;
+}
+
+void PipelineScheduler::submit_to_stage(
+    size_t stage_id,
+    std::shared_ptr<Request> request,
+    std::vector<c10::IValue>&& inputs) {
+  // Back pressure: wait until the stage has a free slot.
+  this->acquire_slot(stage_id);
+  auto stage_inputs =
+      std::make_shared<std::vector<c10::IValue>>(std::move(inputs));
+  try {
+    this->stages[stage_id]->task_executor->submit(
+        [this, stage_id, request, stage_inputs]() {
+          this->run_stage(stage_id, request, *stage_inputs);
+        });
+  } catch (...) {
+    this->release_slot(stage_id);
+    throw;
+  }
+}
+
+void PipelineScheduler::run_stage(
+    size_t stage_id,
+    std::shared_ptr<Request> request,
+    std::vector<c10::IValue>& inputs) {
+  c10::IValue output;
+  try {
+    // set the thread local status, such as the grad mode before execuating
+    // the stage
+    at::GradMode::set_enabled(request->grad_mode);
+    output = this->stages[stage_id]->module.forward(std::move(inputs));
+  } catch (...) {
+    // The following stages are skipped.
+    request->promise.set_exception(std::current_exception());
+    request->completion->mark_done();
+    this->release_slot(stage_id);
+    return;
+  }
+
+  if (stage_id + 1 == this->stages.size()) {
+    request->promise.set_value(std::move(output));
+    request->completion->mark_done();
+  } else {
+    std::vector<c10::IValue> next_inputs;
+    if (output.isTuple()) {
+      next_inputs = output.toTuple()->elements().vec();
+    } else {
+      next_inputs.emplace_back(std::move(output));
+    }
+    try {
+      // Keep the slot of this stage until the next stage accepts the
+      // request, so that a slow stage throttles all the stages before it.
+      this->submit_to_stage(stage_id + 1, request, std::move(next_inputs));
+    } catch (...) {
+      request->promise.set_exception(std::current_exception());
+      request->completion->mark_done();
+    }
+  }
+  this->release_slot(stage_id);
+}
+
+void PipelineScheduler::stop_scheduler() {
+  {
+    std::unique_lock<std::mutex> lock(this->scheduler_mutex);
+    if (this->stop)
+      return;
+    this->stop = true;
+  }
+  // Stop the stages in order, each stage flushes its queued requests into the
+  // next stage, which is still running, before exiting.
+  for (auto& stage : this->stages) {
+    stage->task_executor->stop_executor();
+  }
+}
+
+} // namespace runtime
+} // namespace torch_ipex
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <ATen/core/ivalue.h>
+#include <torch/csrc/jit/api/module.h>
+#include "TaskModule.h"
+#include "cpu/runtime/CPUPool.h"
+#include "cpu/runtime/TaskExecutor.h"
+
+namespace torch_ipex {
+namespace runtime {
+
+/*PipelineScheduler runs a model split into several script module stages in
+ * the pipeline-parallel way. Each stage is executed by its own TaskExecutor
+ * pinned on its own CPUPool, and the output of one stage is the input of the
+ * next stage (a Tuple output is unpacked into several inputs). Consecutive
+ * requests overlap on different stages.
+ * Each stage accepts at most max_queue_size requests (queued or running). The
+ * producer of a full stage, which is the submitter for the first stage and the
+ * previous stage for the others, blocks until one request leaves it.*/
+class TORCH_API PipelineScheduler {
+ public:
+  explicit PipelineScheduler(
+      const std::vector<torch::jit::Module>& stage_modules,
+      const std::vector<std::shared_ptr<CPUPool>>& stage_cpu_pools,
+      int64_t max_queue_size);
+  ~PipelineScheduler();
+  std::unique_ptr<FutureTensor> submit(std::vector<c10::IValue>&& inputs);
+  void stop_scheduler();
+
+ private:
+  struct Stage {
+    torch::jit::Module module;
+    std::shared_ptr<TaskExecutor> task_executor;
+    // Number of requests queued or running in this stage
+    int64_t in_flight{0};
+    std::mutex stage_mutex;
+    std::condition_variable stage_condition;
+  };
+
+  struct Request {
+    std::promise<c10::IValue> promise;
+    std::shared_ptr<TaskCompletion> completion;
+    bool grad_mode;
+  };
+
+  void acquire_slot(size_t stage_id);
+  void release_slot(size_t stage_id);
+  void submit_to_stage(
+      size_t stage_id,
+      std::shared_ptr<Request> request,
+      std::vector<c10::IValue>&& inputs);
+  void run_stage(
+      size_t stage_id,
+      std::shared_ptr<Request> request,
+      std::vector<c10::IValue>& inputs);
+
+  std::vector<std::unique_ptr<Stage>> stages;
+  int64_t max_queue_size_;
+  bool stop{false};
+  std::mutex scheduler_mutex;
+
+  PipelineScheduler(const PipelineScheduler& scheduler) = delete;
+  PipelineScheduler& operator=(const PipelineScheduler& scheduler) = delete;
+};
+
+} // namespace runtime
+} // namespace torch_ipex
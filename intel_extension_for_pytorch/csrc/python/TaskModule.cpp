@@ -1,70 +1,251 @@
 #include "TaskModule.h"
 
+#include <ATen/ATen.h>
+
 namespace torch_ipex {
 namespace runtime {
 
+void TaskCompletion::mark_done() {
+  std::vector<std::function<void()>> callbacks_to_run;
+  {
+    std::unique_lock<std::mutex> lock(this->completion_mutex);
+    this->done = true;
+    callbacks_to_run.swap(this->callbacks);
+  }
+  this->completion_condition.notify_all();
+  for (auto& callback : callbacks_to_run) {
+    callback();
+  }
+}
+
+bool TaskCompletion::is_done() {
+  std::unique_lock<std::mutex> lock(this->completion_mutex);
+  return this->done;
+}
+
+void TaskCompletion::wait() {
+  std::unique_lock<std::mutex> lock(this->completion_mutex);
+  this->completion_condition.wait(lock, [this] { return this->done; });
+}
+
+void TaskCompletion::add_callback(std::function<void()>&& callback) {
+  {
+    std::unique_lock<std::mutex> lock(this->completion_mutex);
+    if (!this->done) {
+      this->callbacks.emplace_back(std::move(callback));
+      return;
+    }
+  }
+  callback();
+}
+
+TaskCompletionGuard::~TaskCompletionGuard() {
+  this->mark_done();
+}
+
+void TaskCompletionGuard::mark_done() {
+  if (this->completion) {
+    this->completion->mark_done();
+    this->completion.reset();
+  }
+}
+
+TaskInflightGuard::TaskInflightGuard(TaskModule* task_module)
+    : task_module(task_module) {
+  if (this->task_module) {
+    std::unique_lock<std::mutex> lock(this->task_module->inflight_mutex_);
+    this->task_module->inflight_tasks_++;
+  }
+}
+
+TaskInflightGuard::~TaskInflightGuard() {
+  if (this->task_module) {
+    {
+      std::unique_lock<std::mutex> lock(this->task_module->inflight_mutex_);
+      this->task_module->inflight_tasks_--;
+    }
+    this->task_module->inflight_condition_.notify_all();
+  }
+}
+
+void FutureTensor::wait() {
+  pybind11::gil_scoped_release no_gil_guard;
+  this->completion->wait();
+}
+
+bool FutureTensor::done() {
+  return this->completion->is_done();
+}
+
+void FutureTensor::add_done_callback(const py::function& callback) {
+  // The py::function must be copied and destroyed with GIL, while the
+  // std::function may be destroyed on the worker thread without GIL.
+  std::shared_ptr<py::function> py_callback(
+      new py::function(callback), [](py::function* f) {
+        pybind11::gil_scoped_acquire gil_guard;
+        delete f;
+      });
+  this->completion->add_callback([py_callback]() {
+    pybind11::gil_scoped_acquire gil_guard;
+    try {
+      (*py_callback)();
+    } catch (py::error_already_set& e) {
+      // Callback errors can't be propagated to the worker thread.
+      e.restore();
+      PyErr_Print();
+    }
+  });
+}
+
+py::list wait_all(const std::vector<FutureTensor*>& futures) {
+  {
+    pybind11::gil_scoped_release no_gil_guard;
+    for (auto future : futures) {
+      future->completion->wait();
+    }
+  }
+  py::list results;
+  for (auto future : futures) {
+    results.append(future->get());
+  }
+  return results;
+}
+
+int64_t wait_any(const std::vector<FutureTensor*>& futures) {
+  TORCH_CHECK(!futures.empty(), "wait_any requires at least one future");
+  struct AnyCompletion {
+    std::mutex any_mutex;
+    std::condition_variable any_condition;
+    int64_t index{-1};
+  };
+  auto any_completion = std::make_shared<AnyCompletion>();
+  pybind11::gil_scoped_release no_gil_guard;
+  for (size_t i = 0; i < futures.size(); i++) {
+    int64_t index = i;
+    futures[i]->completion->add_callback([any_completion, index]() {
+      {
+        std::unique_lock<std::mutex> lock(any_completion->any_mutex);
+        if (any_completion->index == -1) {
+          any_completion->index = index;
+        }
+      }
+      any_completion->any_condition.notify_all();
+    });
+  }
+  std::unique_lock<std::mutex> lock(any_completion->any_mutex);
+  any_completion->any_condition.wait(
+      lock, [&any_completion] { return any_completion->index != -1; });
+  return any_completion->index;
+}
+
 py::object FutureTensor::get() {
   CHECK(this->script_module_initialized_ ^ this->module_initialized_);
-  if (this->script_module_initialized_) {
-    c10::IValue res;
-    {
-      pybind11::gil_scoped_release no_gil_guard;
-      res = this->future_script_tensor.get();
+  try {
+    if (this->script_module_initialized_) {
+      c10::IValue res;
+      {
+        pybind11::gil_scoped_release no_gil_guard;
+        res = this->future_script_tensor.get();
+      }
+      return torch::jit::toPyObject(std::move(res));
+    } else {
+      CHECK(this->module_initialized_);
+      {
+        pybind11::gil_scoped_release no_gil_guard;
+        return this->future_tensor.get();
+      }
     }
-    return torch::jit::toPyObject(std::move(res));
-  } else {
-    CHECK(this->module_initialized_);
-    {
-      pybind11::gil_scoped_release no_gil_guard;
-      return this->future_tensor.get();
+  } catch (const std::future_error& e) {
+    if (e.code() != std::future_errc::broken_promise) {
+      throw;
     }
+    // The packaged_task is destroyed without running.
+    throw TaskDroppedError(
+        "The input is dropped from the full queue of the Task before running");
   }
 }
 
 TaskModule::TaskModule(
     const torch::jit::Module& script_module,
     const std::vector<int32_t>& cpu_core_list,
-    bool traced_module)
+    bool traced_module,
+    std::shared_ptr<TaskExecutorGroup> task_executor_group)
     : script_module_(script_module) {
-  this->task_executor = std::make_shared<TaskExecutor>(cpu_core_list);
+  this->task_executor =
+      std::make_shared<TaskExecutor>(cpu_core_list, task_executor_group);
   this->script_module_initialized_ = true;
 }
 
 TaskModule::TaskModule(
     const py::object& module,
-    const std::vector<int32_t>& cpu_core_list)
+    const std::vector<int32_t>& cpu_core_list,
+    std::shared_ptr<TaskExecutorGroup> task_executor_group)
     : module_(module) {
-  this->task_executor = std::make_shared<TaskExecutor>(cpu_core_list);
+  this->task_executor =
+      std::make_shared<TaskExecutor>(cpu_core_list, task_executor_group);
   this->module_initialized_ = true;
 }
 
 TaskModule::TaskModule(
     const torch::jit::Module& script_module,
     const torch_ipex::runtime::CPUPool& cpu_pool,
-    bool traced_module)
+    bool traced_module,
+    std::shared_ptr<TaskExecutorGroup> task_executor_group)
     : script_module_(script_module) {
   this->task_executor =
-      std::make_shared<TaskExecutor>(cpu_pool.get_cpu_core_list());
+      std::make_shared<TaskExecutor>(cpu_pool, task_executor_group);
   this->script_module_initialized_ = true;
 }
 
 TaskModule::TaskModule(
     const py::object& module,
-    const torch_ipex::runtime::CPUPool& cpu_pool)
+    const torch_ipex::runtime::CPUPool& cpu_pool,
+    std::shared_ptr<TaskExecutorGroup> task_executor_group)
     : module_(module) {
   this->task_executor =
-      std::make_shared<TaskExecutor>(cpu_pool.get_cpu_core_list());
+      std::make_shared<TaskExecutor>(cpu_pool, task_executor_group);
+  this->module_initialized_ = true;
+}
+
+TaskModule::TaskModule(
+    const torch::jit::Module& script_module,
+    std::shared_ptr<TaskExecutor> task_executor,
+    bool traced_module)
+    : script_module_(script_module),
+      task_executor(std::move(task_executor)),
+      shared_task_executor_(true) {
+  this->script_module_initialized_ = true;
+}
+
+TaskModule::TaskModule(
+    const py::object& module,
+    std::shared_ptr<TaskExecutor> task_executor)
+    : module_(module),
+      task_executor(std::move(task_executor)),
+      shared_task_executor_(true) {
   this->module_initialized_ = true;
 }
 
 TaskModule::~TaskModule() {
   pybind11::gil_scoped_release no_gil_guard;
-  this->task_executor->stop_executor();
+  if (!this->shared_task_executor_) {
+    this->task_executor->stop_executor();
+    return;
+  }
+  // The worker of an nn.Module task takes the GIL released above.
+  std::unique_lock<std::mutex> lock(this->inflight_mutex_);
+  this->inflight_condition_.wait(
+      lock, [this] { return this->inflight_tasks_ == 0; });
+}
+
+TaskModule* TaskModule::inflight_owner() {
+  return this->shared_task_executor_ ? this : nullptr;
 }
 
 std::unique_ptr<FutureTensor> TaskModule::run_async(
     py::args&& args,
-    py::kwargs&& kwargs) {
+    py::kwargs&& kwargs,
+    TaskPriority priority) {
   CHECK(this->script_module_initialized_ ^ this->module_initialized_);
   // FutureTensor is going to return
   std::unique_ptr<FutureTensor> future_tensor_result =
@@ -84,71 +265,146 @@ std::unique_ptr<FutureTensor> TaskModule::run_async(
           std::move(kwargs),
           script_module_._ivalue());
 
-      typedef std::function<c10::IValue(std::vector<at::IValue>)>
-          SubmitFunctionType;
-      using return_type = typename std::result_of<SubmitFunctionType(
-          std::vector<at::IValue>)>::type;
-      auto task = std::make_shared<std::packaged_task<return_type()>>(std::bind(
-          std::forward<SubmitFunctionType>(
-              [&](std::vector<at::IValue> stack) -> c10::IValue {
-                return function(std::move(stack));
-              }),
-          std::forward<std::vector<at::IValue>>(stack)));
+      auto task = std::make_shared<std::packaged_task<c10::IValue()>>(
+          [&function, stack = std::move(stack)]() mutable -> c10::IValue {
+            return function(std::move(stack));
+          });
 
       future_tensor_result->script_module_initialized_ = true;
       future_tensor_result->future_script_tensor = task->get_future();
 
-      {
-        std::unique_lock<std::mutex> lock(this->task_executor->get_mutex());
-        // submit task to a stopping the pool is not allowed
-        if (this->task_executor->is_stop())
-          throw std::runtime_error(
-              "submit TaskModule(py::object) on stopped ThreadPool");
-        this->task_executor->get_tasks().emplace([task, grad_mode]() {
-          // set the thread local status, such as the grad mode before
-          // execuating the status
-          at::GradMode::set_enabled(grad_mode);
-          // execuate the task
-          (*task)();
-        });
-      }
-      this->task_executor->get_condition().notify_one();
+      this->task_executor->submit(
+          [task,
+           grad_mode,
+           completion =
+               TaskCompletionGuard(future_tensor_result->completion),
+           inflight = TaskInflightGuard(this->inflight_owner())]() mutable {
+            // set the thread local status, such as the grad mode before
+            // execuating the status
+            at::GradMode::set_enabled(grad_mode);
+            // execuate the task
+            (*task)();
+            completion.mark_done();
+          },
+          priority);
     }
   } else {
     CHECK(this->module_initialized_);
-    this->args = args;
-    this->kwargs = kwargs;
+    // Each submission keeps its own inputs, the queued ones would run with
+    // the inputs of the latest submission otherwise. They are released with
+    // the GIL, e.g. on the worker thread after the task runs.
+    std::shared_ptr<std::pair<py::args, py::kwargs>> inputs(
+        new std::pair<py::args, py::kwargs>(std::move(args), std::move(kwargs)),
+        [](std::pair<py::args, py::kwargs>* p) {
+          pybind11::gil_scoped_acquire gil_guard;
+          delete p;
+        });
 
-    typedef std::function<py::object()> SubmitFunctionType;
-    using return_type = typename std::result_of<SubmitFunctionType()>::type;
-    auto task = std::make_shared<std::packaged_task<return_type()>>(
-        [&, this]() -> py::object {
+    auto task = std::make_shared<std::packaged_task<py::object()>>(
+        [this, inputs]() -> py::object {
           {
             pybind11::gil_scoped_acquire gil_guard;
-            return this->module_(*(this->args), **(this->kwargs));
+            return this->module_(*(inputs->first), **(inputs->second));
           }
         });
 
     future_tensor_result->module_initialized_ = true;
     future_tensor_result->future_tensor = task->get_future();
 
-    {
-      std::unique_lock<std::mutex> lock(this->task_executor->get_mutex());
-      // submit task to a stopping the pool is not allowed
-      if (this->task_executor->is_stop())
-        throw std::runtime_error(
-            "submit TaskModule(py::object) on stopped ThreadPool");
-      this->task_executor->get_tasks().emplace([task, grad_mode]() {
-        // set the thread local status, such as the grad mode before execuating
-        // the status
+    // Release the GIL, since the submit may block on the full queue while
+    // the worker needs the GIL to run the module.
+    pybind11::gil_scoped_release no_gil_guard;
+    this->task_executor->submit(
+        [task,
+         grad_mode,
+         completion = TaskCompletionGuard(future_tensor_result->completion),
+         inflight = TaskInflightGuard(this->inflight_owner())]() mutable {
+          // set the thread local status, such as the grad mode before
+          // execuating the status
+          at::GradMode::set_enabled(grad_mode);
+          // execuate the task
+          (*task)();
+          completion.mark_done();
+        },
+        priority);
+  }
+  return future_tensor_result;
+}
+
+at::Tensor OutputGather::get_rows(const at::Tensor& result, int64_t offset) {
+  TORCH_CHECK(
+      result.dim() >= 1,
+      "The output of each stream must have the batch dim to be gathered");
+  {
+    std::unique_lock<std::mutex> lock(this->gather_mutex);
+    if (!this->output.defined()) {
+      auto sizes = result.sizes().vec();
+      sizes[0] = this->total_batch_size;
+      this->output = at::empty(
+          sizes,
+          result.options().memory_format(result.suggest_memory_format()));
+    }
+  }
+  TORCH_CHECK(
+      this->output.sizes().slice(1) == result.sizes().slice(1) &&
+          this->output.scalar_type() == result.scalar_type(),
+      "The outputs of streams can't be concatenated");
+  return this->output.narrow(0, offset, result.size(0));
+}
+
+bool TaskModule::is_script_module() const {
+  return this->script_module_initialized_;
+}
+
+void TaskModule::resize(const CPUPool& cpu_pool) {
+  this->task_executor->repin(cpu_pool);
+}
+
+std::vector<int32_t> TaskModule::get_cpu_core_list() {
+  return this->task_executor->get_cpu_core_list();
+}
+
+void TaskModule::set_queue_limit(
+    int64_t max_queued_tasks,
+    QueueFullPolicy policy) {
+  this->task_executor->set_queue_limit(max_queued_tasks, policy);
+}
+
+TaskQueueStats TaskModule::get_queue_stats() {
+  return this->task_executor->get_queue_stats();
+}
+
+std::future<void> TaskModule::run_async_gather(
+    const at::Tensor& input,
+    std::shared_ptr<OutputGather> gather,
+    int64_t offset) {
+  TORCH_CHECK(
+      this->script_module_initialized_,
+      "run_async_gather only supports script module");
+  auto grad_mode = at::GradMode::is_enabled();
+  auto task = std::make_shared<std::packaged_task<void()>>(
+      [this, input, gather, offset]() {
+        auto& function = this->script_module_.get_method("forward").function();
+        std::vector<at::IValue> stack({this->script_module_._ivalue(), input});
+        at::Tensor result = function(std::move(stack)).toTensor();
+        TORCH_CHECK(
+            result.size(0) == input.size(0),
+            "The output batch size of each stream must equal to its input batch size");
+        // Write the result into its own rows of the output.
+        gather->get_rows(result, offset).copy_(result);
+      });
+  std::future<void> res = task->get_future();
+  this->task_executor->submit(
+      [task,
+       grad_mode,
+       inflight = TaskInflightGuard(this->inflight_owner())]() {
+        // set the thread local status, such as the grad mode before
+        // execuating the status
         at::GradMode::set_enabled(grad_mode);
         // execuate the task
         (*task)();
       });
-    }
-    this->task_executor->get_condition().notify_one();
-  }
-  return future_tensor_result;
+  return res;
 }
 
 py::object TaskModule::run_sync(py::args&& args, py::kwargs&& kwargs) {
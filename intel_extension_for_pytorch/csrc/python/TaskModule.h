@@ -1,10 +1,12 @@
 #pragma once
 
 #include <cassert>
+#include <condition_variable>
 #include <functional>
 #include <future>
 #include <iostream>
 #include <memory>
+#include <mutex>
 #include <stdexcept>
 #include <vector>
 
@@ -13,9 +15,78 @@
 #include <torch/csrc/jit/python/pybind_utils.h>
 #include <torch/csrc/utils/pybind.h>
 #include "cpu/runtime/TaskExecutor.h"
+#include "cpu/runtime/TaskFuture.h"
 
 namespace torch_ipex {
 namespace runtime {
+
+/*TaskCompletion is marked as done by the worker thread right after the result
+ * of the task is set. It's used to wait for several tasks without GIL and to
+ * run the completion callbacks on the worker thread.*/
+class TaskCompletion {
+ public:
+  TaskCompletion() = default;
+  void mark_done();
+  bool is_done();
+  void wait();
+  // Run the callback on the thread marking the completion, or run it
+  // immediately on the current thread if the task is already done.
+  void add_callback(std::function<void()>&& callback);
+
+ private:
+  bool done{false};
+  std::vector<std::function<void()>> callbacks;
+  std::mutex completion_mutex;
+  std::condition_variable completion_condition;
+
+  TaskCompletion(const TaskCompletion& task_completion) = delete;
+  TaskCompletion& operator=(const TaskCompletion& task_completion) = delete;
+};
+
+/*TaskCompletionGuard is owned by the submitted task and marks the completion
+ * as done once the task runs, or once the task is destroyed without running,
+ * e.g. dropped from the full queue of the TaskExecutor, so that the waiters
+ * are always woken up.*/
+class TaskCompletionGuard {
+ public:
+  explicit TaskCompletionGuard(std::shared_ptr<TaskCompletion> completion)
+      : completion(std::move(completion)) {}
+  TaskCompletionGuard(TaskCompletionGuard&& completion_guard) = default;
+  ~TaskCompletionGuard();
+  void mark_done();
+
+ private:
+  std::shared_ptr<TaskCompletion> completion;
+
+  TaskCompletionGuard(const TaskCompletionGuard& completion_guard) = delete;
+  TaskCompletionGuard& operator=(const TaskCompletionGuard& completion_guard) =
+      delete;
+};
+
+class TaskModule;
+
+/*TaskInflightGuard is owned by a task of a TaskModule sharing its TaskExecutor
+ * with the other TaskModules, from the submission until the task is destroyed,
+ * i.e. after it runs or is dropped. The destructor of the TaskModule waits for
+ * its inflight tasks, which refer to its module, instead of stopping the
+ * shared TaskExecutor. It does nothing of a nullptr TaskModule.*/
+class TaskInflightGuard {
+ public:
+  explicit TaskInflightGuard(TaskModule* task_module);
+  TaskInflightGuard(TaskInflightGuard&& inflight_guard)
+      : task_module(inflight_guard.task_module) {
+    inflight_guard.task_module = nullptr;
+  }
+  ~TaskInflightGuard();
+
+ private:
+  TaskModule* task_module;
+
+  TaskInflightGuard(const TaskInflightGuard& inflight_guard) = delete;
+  TaskInflightGuard& operator=(const TaskInflightGuard& inflight_guard) =
+      delete;
+};
+
 struct FutureTensor {
   // script module
   std::future<c10::IValue> future_script_tensor;
@@ -23,8 +94,36 @@ struct FutureTensor {
   // nn module
   std::future<py::object> future_tensor;
   bool module_initialized_{false};
+  // completion status of the task
+  std::shared_ptr<TaskCompletion> completion =
+      std::make_shared<TaskCompletion>();
   // get the result
   py::object get();
+  // block until the result is ready without GIL
+  void wait();
+  bool done();
+  // callback(FutureTensor is done) runs on the worker thread with GIL
+  void add_done_callback(const py::function& callback);
+};
+
+// Block without GIL until all the futures are done, and return their results.
+py::list wait_all(const std::vector<FutureTensor*>& futures);
+// Block without GIL until any of the futures is done, and return its index.
+int64_t wait_any(const std::vector<FutureTensor*>& futures);
+
+/*OutputGather is the preallocated output shared by the streams of one
+ * multi-stream execution. Each stream writes its result directly into its own
+ * rows of the output instead of concatenating the results afterwards.*/
+struct OutputGather {
+  explicit OutputGather(int64_t total_batch_size)
+      : total_batch_size(total_batch_size) {}
+  // Return the rows [offset, offset + length) of the output, allocate the
+  // output with the shape of the first finished stream if necessary.
+  at::Tensor get_rows(const at::Tensor& result, int64_t offset);
+
+  at::Tensor output;
+  int64_t total_batch_size;
+  std::mutex gather_mutex;
 };
 
 /*TaskModule is used to handle Python input of nn.module or script module*/
@@ -33,22 +132,52 @@ class TORCH_API TaskModule {
   explicit TaskModule(
       const torch::jit::Module& module,
       const std::vector<int32_t>& cpu_core_list,
-      bool traced_module);
+      bool traced_module,
+      std::shared_ptr<TaskExecutorGroup> task_executor_group = nullptr);
   explicit TaskModule(
       const py::object& module,
-      const std::vector<int32_t>& cpu_core_list);
+      const std::vector<int32_t>& cpu_core_list,
+      std::shared_ptr<TaskExecutorGroup> task_executor_group = nullptr);
   explicit TaskModule(
       const torch::jit::Module& module,
       const torch_ipex::runtime::CPUPool& cpu_pool,
+      bool traced_module,
+      std::shared_ptr<TaskExecutorGroup> task_executor_group = nullptr);
+  explicit TaskModule(
+      const py::object& module,
+      const torch_ipex::runtime::CPUPool& cpu_pool,
+      std::shared_ptr<TaskExecutorGroup> task_executor_group = nullptr);
+  /*run on the TaskExecutor shared with the other TaskModules, e.g. of the
+   * other models of a scheduler, which is not stopped by this TaskModule*/
+  explicit TaskModule(
+      const torch::jit::Module& module,
+      std::shared_ptr<TaskExecutor> task_executor,
       bool traced_module);
   explicit TaskModule(
       const py::object& module,
-      const torch_ipex::runtime::CPUPool& cpu_pool);
+      std::shared_ptr<TaskExecutor> task_executor);
   ~TaskModule();
   py::object run_sync(py::args&& args, py::kwargs&& kwargs); /*sync execution*/
   std::unique_ptr<FutureTensor> run_async(
       py::args&& args,
-      py::kwargs&& kwargs); /*async execution in threadpool*/
+      py::kwargs&& kwargs,
+      TaskPriority priority =
+          TaskPriority::Normal); /*async execution in threadpool*/
+  /*async execution of script module with one tensor input, the result is
+   * written into rows starting from offset of the output of gather*/
+  std::future<void> run_async_gather(
+      const at::Tensor& input,
+      std::shared_ptr<OutputGather> gather,
+      int64_t offset);
+  bool is_script_module() const;
+  /*move the TaskExecutor onto the cores of cpu_pool at its next task boundary,
+   * the module and the queued inputs are kept*/
+  void resize(const CPUPool& cpu_pool);
+  std::vector<int32_t> get_cpu_core_list();
+  /*bound the queue of the normal priority inputs, 0 means unbounded*/
+  void set_queue_limit(int64_t max_queued_tasks, QueueFullPolicy policy);
+  TaskQueueStats get_queue_stats();
+
  private:
   // Script module input
   torch::jit::Module script_module_;
@@ -59,8 +188,17 @@ class TORCH_API TaskModule {
 
   // TaskExecutor
   std::shared_ptr<TaskExecutor> task_executor;
-  py::args args;
-  py::kwargs kwargs;
+  // The TaskExecutor is shared with the other TaskModules
+  bool shared_task_executor_{false};
+  // The tasks of the shared TaskExecutor not destroyed yet
+  int64_t inflight_tasks_{0};
+  std::mutex inflight_mutex_;
+  std::condition_variable inflight_condition_;
+
+  // nullptr if the TaskExecutor is owned by this TaskModule
+  TaskModule* inflight_owner();
+
+  friend class TaskInflightGuard;
 };
 
 } // namespace runtime
@@ -1,6 +1,8 @@
 #include "init_python_bindings.h"
 
+#include "intel_extension_for_pytorch/csrc/jit/codegen/onednn/coverage_report.h"
 #include "intel_extension_for_pytorch/csrc/jit/codegen/onednn/interface.h"
+#include "intel_extension_for_pytorch/csrc/jit/codegen/onednn/lowering_selection.h"
 #include "intel_extension_for_pytorch/csrc/version.h"
 
 #include <ATen/native/quantized/cpu/quant_utils.h>
@@ -23,8 +25,15 @@
 
 #include "intel_extension_for_pytorch/csrc/quantization/AutoCast.hpp"
 #include "intel_extension_for_pytorch/csrc/quantization/Config.hpp"
+#include "intel_extension_for_pytorch/csrc/quantization/IndicatorsFile.hpp"
 #include "intel_extension_for_pytorch/csrc/quantization/Observer.hpp"
 #include "intel_extension_for_pytorch/csrc/quantization/auto_opt_config.hpp"
+#include "intel_extension_for_pytorch/csrc/utils/fast_path_stats.h"
+#include "intel_extension_for_pytorch/csrc/utils/huge_pages.h"
+#include "intel_extension_for_pytorch/csrc/utils/memory_stats.h"
+#include "intel_extension_for_pytorch/csrc/utils/op_trace.h"
+#include "intel_extension_for_pytorch/csrc/utils/parallel_trace.h"
+#include "intel_extension_for_pytorch/csrc/utils/perf_counters.h"
 #include "intel_extension_for_pytorch/csrc/utils/rw_lock.h"
 #include "intel_extension_for_pytorch/csrc/utils/utils.h"
 #include "intel_extension_for_pytorch/csrc/utils/verbose.hpp"
@@ -35,15 +44,49 @@
 #include <torch/csrc/jit/passes/pass_manager.h>
 #include "intel_extension_for_pytorch/csrc/autocast/autocast_mode.h"
 
+#include "MicroBatchScheduler.h"
+#include "PipelineScheduler.h"
 #include "TaskModule.h"
+#include "intel_extension_for_pytorch/csrc/aten/cpu/PackedWeightCache.h"
+#include "intel_extension_for_pytorch/csrc/aten/cpu/PackedWeightSerialization.h"
 #include "intel_extension_for_pytorch/csrc/aten/cpu/embeddingbag.h"
+#include "intel_extension_for_pytorch/csrc/aten/cpu/utils/op_thread_policy.h"
+#include "intel_extension_for_pytorch/csrc/cpu/dispatch/DispatchStub.h"
 #include "intel_extension_for_pytorch/csrc/cpu/runtime/CPUPool.h"
+#include "intel_extension_for_pytorch/csrc/cpu/isa/cpu_info.hpp"
 #include "intel_extension_for_pytorch/csrc/cpu/runtime/TaskExecutor.h"
-#include "intel_extension_for_pytorch/csrc/cpu/utils/CPUISA.h"
 
 namespace torch_ipex {
 namespace {
 
+// the counted hardware counters by their names
+py::dict perf_counters_to_dict(
+    const torch_ipex::perf_counters::Counts& counters) {
+  py::dict d;
+  for (int i = 0; i < torch_ipex::perf_counters::kNumCounters; i++) {
+    if (counters[i] >= 0) {
+      d[torch_ipex::perf_counters::name(i)] = counters[i];
+    }
+  }
+  return d;
+}
+
+py::dict verbose_record_to_dict(
+    const torch_ipex::verbose::VerboseRecord& record) {
+  py::dict d;
+  d["stage"] = record.stage;
+  d["engine"] = record.engine;
+  d["kind"] = record.kind;
+  d["impl"] = record.impl;
+  d["prop_kind"] = record.prop_kind;
+  d["memory_descs"] = record.memory_descs;
+  d["attrs"] = record.attrs;
+  d["aux"] = record.aux;
+  d["problem"] = record.problem;
+  d["time_ms"] = record.time_ms;
+  return d;
+}
+
 py::object GetBinaryInfo() {
   auto py_dict = py::dict();
   py_dict["__version__"] = std::string(__version__);
@@ -59,15 +102,179 @@ void InitIpexModuleBindings(py::module m) {
 
   // Check CPU ISA
   m.def("_does_support_avx2", []() {
-    using namespace torch_ipex::cpu::utils;
-    return CPUISA::info().does_support_avx2();
+    auto& cpu_feature = torch_ipex::cpu::CPUFeature::get_instance();
+    return cpu_feature.os_avx2() && cpu_feature.cpuid_avx2();
   });
   m.def("_does_support_avx512", []() {
-    using namespace torch_ipex::cpu::utils;
-    return CPUISA::info().does_support_avx512();
+    auto& cpu_feature = torch_ipex::cpu::CPUFeature::get_instance();
+    return cpu_feature.os_avx512() && cpu_feature.cpuid_avx512_f() &&
+        cpu_feature.cpuid_avx512_dq() && cpu_feature.cpuid_avx512_bw() &&
+        cpu_feature.cpuid_avx512_vl();
+  });
+  // the caches, the SMT layout and the kernel tuning of the CPU
+  m.def("_get_cpu_info", []() {
+    const auto& cpu_info = torch_ipex::cpu::CPUInfo::get_instance();
+    const auto& tuning = cpu_info.tuning();
+    auto py_dict = py::dict();
+    py_dict["micro_arch"] = std::string(cpu_info.micro_arch_name());
+    py_dict["family"] = cpu_info.family();
+    py_dict["model"] = cpu_info.model();
+    py_dict["stepping"] = cpu_info.stepping();
+    py_dict["l1d_size"] = cpu_info.l1d().size;
+    py_dict["l2_size"] = cpu_info.l2().size;
+    py_dict["l3_size"] = cpu_info.l3().size;
+    py_dict["cache_line_size"] = cpu_info.l1d().line_size;
+    py_dict["threads_per_core"] = cpu_info.threads_per_core();
+    py_dict["cores_per_l3"] = cpu_info.cores_per_l3();
+    py_dict["avx512_fma_units"] = cpu_info.avx512_fma_units();
+    py_dict["emb_prefetch_lines"] = tuning.emb_prefetch_lines;
+    py_dict["emb_max_prefetch_distance"] = tuning.emb_max_prefetch_distance;
+    py_dict["interaction_block_size"] = tuning.interaction_block_size;
+    py_dict["cumsum_chunk_bytes"] = tuning.cumsum_chunk_bytes;
+    py_dict["online_softmax_min_size"] = tuning.online_softmax_min_size;
+    py_dict["op_min_work_per_thread"] = tuning.op_min_work_per_thread;
+    py_dict["stream_store_min_bytes"] = tuning.stream_store_min_bytes;
+    return std::move(py_dict);
+  });
+  // the ISA features of the CPU, of which the fingerprint keys the baselines
+  // of the benchmarks
+  m.def("_get_cpu_features", []() {
+    return torch_ipex::cpu::CPUFeature::get_instance().features();
+  });
+  m.def("_get_cpu_feature_fingerprint", []() {
+    return torch_ipex::cpu::CPUFeature::get_instance().fingerprint();
+  });
+  // the ISA level of which the multi-versioned kernels are dispatched
+  m.def("_get_current_isa_level", []() {
+    using namespace torch_ipex::cpu;
+    return std::string(get_cpu_capability_name(get_cpu_capability()));
   });
 
   m.def("mkldnn_set_verbose", &torch_ipex::verbose::_mkldnn_set_verbose);
+  m.def("_start_verbose_capture", []() {
+    return torch_ipex::verbose::start_verbose_capture();
+  });
+  m.def("_stop_verbose_capture", []() {
+    py::list records;
+    for (auto& record : torch_ipex::verbose::stop_verbose_capture()) {
+      records.append(verbose_record_to_dict(record));
+    }
+    return records;
+  });
+  m.def("_mark_verbose_capture", [](const std::string& text) {
+    torch_ipex::verbose::mark_verbose_capture(text);
+  });
+  m.def("_parse_verbose_line", [](const std::string& line) -> py::object {
+    torch_ipex::verbose::VerboseRecord record;
+    if (!torch_ipex::verbose::parse_verbose_line(line, record)) {
+      return py::none();
+    }
+    return verbose_record_to_dict(record);
+  });
+  // the calls of the fast paths of the kernels and of their fallbacks
+  m.def("get_fallback_stats", []() {
+    py::dict stats;
+    for (auto& path_stats : torch_ipex::fast_path::get_fast_path_stats()) {
+      py::dict fallbacks;
+      for (auto& fallback : path_stats.fallbacks) {
+        fallbacks[py::str(fallback.first)] = fallback.second;
+      }
+      py::dict d;
+      d["fast_path"] = path_stats.hits;
+      d["fallbacks"] = fallbacks;
+      stats[py::str(path_stats.name)] = d;
+    }
+    return stats;
+  });
+  m.def("reset_fallback_stats", []() {
+    torch_ipex::fast_path::reset_fast_path_stats();
+  });
+  m.def(
+      "_count_fast_path",
+      [](const std::string& name, const std::string& reason) {
+        torch_ipex::fast_path::count_fast_path(name, reason);
+      });
+  // runtime trace of the ops
+  m.def(
+      "_enable_op_trace",
+      [](double sample_rate, int64_t buffer_size, bool perf) {
+        return torch_ipex::op_trace::enable(sample_rate, buffer_size, perf);
+      });
+  m.def("_disable_op_trace", []() { torch_ipex::op_trace::disable(); });
+  m.def("_is_op_trace_enabled", []() {
+    return torch_ipex::op_trace::is_enabled();
+  });
+  m.def("_get_op_trace_records", []() {
+    py::list records;
+    for (auto& record : torch_ipex::op_trace::get_records()) {
+      py::dict d;
+      d["op"] = record.op;
+      d["shapes"] = record.shapes;
+      d["dtype"] = record.dtype;
+      d["kernel"] = record.kernel;
+      d["duration_ns"] = record.duration_ns;
+      d["counters"] = perf_counters_to_dict(record.counters);
+      records.append(d);
+    }
+    return records;
+  });
+  m.def("_get_op_trace_stats", []() {
+    py::dict stats;
+    for (auto& op_stats : torch_ipex::op_trace::get_stats()) {
+      py::dict d;
+      d["count"] = op_stats.count;
+      d["total_ns"] = op_stats.total_ns;
+      d["min_ns"] = op_stats.min_ns;
+      d["max_ns"] = op_stats.max_ns;
+      d["histogram"] = std::vector<int64_t>(
+          op_stats.histogram.begin(), op_stats.histogram.end());
+      d["counters"] = perf_counters_to_dict(op_stats.counters);
+      stats[py::str(op_stats.op)] = d;
+    }
+    return stats;
+  });
+  // the imbalance of the threads of the parallel regions of the kernels
+  m.def("_enable_parallel_trace", []() {
+    torch_ipex::parallel_trace::enable();
+  });
+  m.def("_disable_parallel_trace", []() {
+    torch_ipex::parallel_trace::disable();
+  });
+  m.def("_get_parallel_trace_stats", []() {
+    py::dict stats;
+    for (auto& region_stats : torch_ipex::parallel_trace::get_stats()) {
+      py::dict d;
+      d["count"] = region_stats.count;
+      d["num_threads"] = region_stats.num_threads;
+      d["total_active_threads"] = region_stats.total_active_threads;
+      d["total_wall_ns"] = region_stats.total_wall_ns;
+      d["total_busy_ns"] = region_stats.total_busy_ns;
+      d["total_max_busy_ns"] = region_stats.total_max_busy_ns;
+      d["total_mean_busy_ns"] = region_stats.total_mean_busy_ns;
+      d["max_imbalance"] = region_stats.max_imbalance;
+      stats[py::str(region_stats.region)] = d;
+    }
+    return stats;
+  });
+  // intra-op thread count policy of the small ops
+  m.def(
+      "_set_op_min_work_per_thread",
+      [](const std::string& op_name, int64_t min_work_per_thread) {
+        auto op = torch_ipex::cpu::get_thread_policy_op(op_name);
+        TORCH_CHECK(
+            op != torch_ipex::cpu::ThreadPolicyOp::NumOps,
+            "Unknown op of the thread policy: ",
+            op_name);
+        torch_ipex::cpu::set_op_min_work_per_thread(op, min_work_per_thread);
+      });
+  m.def("_get_op_min_work_per_thread", [](const std::string& op_name) {
+    auto op = torch_ipex::cpu::get_thread_policy_op(op_name);
+    TORCH_CHECK(
+        op != torch_ipex::cpu::ThreadPolicyOp::NumOps,
+        "Unknown op of the thread policy: ",
+        op_name);
+    return torch_ipex::cpu::get_op_min_work_per_thread(op);
+  });
   // ipex amp autocast
   m.def("get_autocast_dtype", []() {
     at::ScalarType current_dtype = torch_ipex::autocast::get_autocast_dtype();
@@ -80,6 +287,15 @@ void InitIpexModuleBindings(py::module m) {
         torch::python::detail::py_object_to_dtype(dtype);
     torch_ipex::autocast::set_autocast_dtype(target_dtype);
   });
+  m.def(
+      "is_autocast_lower_precision_enabled",
+      &torch_ipex::autocast::is_lower_precision_enabled);
+  m.def(
+      "set_autocast_lower_precision_enabled",
+      &torch_ipex::autocast::set_lower_precision_enabled);
+  m.def(
+      "get_autocast_lower_precision_ops",
+      &torch_ipex::autocast::get_lower_precision_ops);
   m.def(
       "is_quantization_enabled",
       &torch_ipex::autocast::is_quantization_enabled);
@@ -100,6 +316,9 @@ void InitIpexModuleBindings(py::module m) {
       "autocast_decrement_nesting",
       &torch_ipex::autocast::autocast_decrement_nesting);
   m.def("clear_autocast_cache", &torch_ipex::autocast::clear_autocast_cache);
+  m.def(
+      "_get_autocast_cache_size",
+      &torch_ipex::autocast::get_autocast_cache_size);
 
   // llga path
   m.def(
@@ -108,6 +327,72 @@ void InitIpexModuleBindings(py::module m) {
   m.def(
       "_jit_llga_weight_cache_enabled",
       &torch::jit::fuser::onednn::getLlgaWeightCacheEnabled);
+  m.def(
+      "_jit_set_llga_compiled_partition_cache_capacity",
+      &torch::jit::fuser::onednn::setLlgaCompiledPartitionCacheCapacity);
+  m.def(
+      "_jit_llga_compiled_partition_cache_capacity",
+      &torch::jit::fuser::onednn::getLlgaCompiledPartitionCacheCapacity);
+  m.def(
+      "_jit_set_llga_partition_record_dir",
+      &torch::jit::fuser::onednn::setLlgaPartitionRecordDir);
+  m.def(
+      "_jit_llga_partition_record_dir",
+      &torch::jit::fuser::onednn::getLlgaPartitionRecordDir);
+  m.def(
+      "_jit_set_llga_symbolic_dims",
+      &torch::jit::fuser::onednn::setLlgaSymbolicDims);
+  m.def(
+      "_jit_llga_symbolic_dims",
+      &torch::jit::fuser::onednn::getLlgaSymbolicDims);
+  m.def(
+      "_jit_set_llga_coverage_report_enabled",
+      &torch::jit::fuser::onednn::coverage_report::setEnabled);
+  m.def(
+      "_jit_llga_coverage_report_enabled",
+      &torch::jit::fuser::onednn::coverage_report::isEnabled);
+  m.def(
+      "_jit_clear_llga_coverage_report",
+      &torch::jit::fuser::onednn::coverage_report::clear);
+  m.def(
+      "_jit_set_llga_lowering_selection_enabled",
+      &torch::jit::fuser::onednn::lowering_selection::setEnabled);
+  m.def(
+      "_jit_llga_lowering_selection_enabled",
+      &torch::jit::fuser::onednn::lowering_selection::isEnabled);
+  m.def(
+      "_jit_llga_lowering_plan",
+      &torch::jit::fuser::onednn::lowering_selection::getPlan);
+  m.def(
+      "_jit_set_llga_lowering_plan",
+      &torch::jit::fuser::onednn::lowering_selection::setPlan);
+  m.def(
+      "_jit_clear_llga_lowering_plan",
+      &torch::jit::fuser::onednn::lowering_selection::clearPlan);
+  m.def("_jit_llga_coverage_report", []() {
+    auto report = torch::jit::fuser::onednn::coverage_report::getReport();
+    py::list partitions;
+    for (auto& kernel : report.kernels) {
+      py::dict d;
+      d["name"] = kernel->name;
+      d["ops"] = kernel->ops;
+      d["calls"] = kernel->calls.load();
+      d["total_time_us"] = kernel->totalNs.load() / 1000.0;
+      partitions.append(d);
+    }
+    py::list unsupported;
+    for (auto& node : report.unsupported) {
+      py::dict d;
+      d["kind"] = node.kind;
+      d["node"] = node.node;
+      d["reason"] = node.reason;
+      unsupported.append(d);
+    }
+    py::dict d;
+    d["partitions"] = partitions;
+    d["unsupported"] = unsupported;
+    return d;
+  });
 
   m.def("enable_jit_opt", []() {
     AutoOptConfig::singleton().set_jit_fuse(true);
@@ -118,6 +403,69 @@ void InitIpexModuleBindings(py::module m) {
   m.def("get_jit_opt", []() {
     return AutoOptConfig::singleton().get_jit_fuse();
   });
+  m.def("enable_jit_branch_parallel", []() {
+    AutoOptConfig::singleton().set_jit_branch_parallel(true);
+  });
+  m.def("disable_jit_branch_parallel", []() {
+    AutoOptConfig::singleton().set_jit_branch_parallel(false);
+  });
+  m.def("get_jit_branch_parallel", []() {
+    return AutoOptConfig::singleton().get_jit_branch_parallel();
+  });
+  m.def("enable_jit_memory_plan", []() {
+    AutoOptConfig::singleton().set_jit_memory_plan(true);
+  });
+  m.def("disable_jit_memory_plan", []() {
+    AutoOptConfig::singleton().set_jit_memory_plan(false);
+  });
+  m.def("get_jit_memory_plan", []() {
+    return AutoOptConfig::singleton().get_jit_memory_plan();
+  });
+  m.def("enable_conv_algorithm_selection", []() {
+    AutoOptConfig::singleton().set_conv_algorithm_selection(true);
+  });
+  m.def("disable_conv_algorithm_selection", []() {
+    AutoOptConfig::singleton().set_conv_algorithm_selection(false);
+  });
+  m.def("get_conv_algorithm_selection", []() {
+    return AutoOptConfig::singleton().get_conv_algorithm_selection();
+  });
+  m.def("enable_sparse_linear", []() {
+    AutoOptConfig::singleton().set_sparse_linear(true);
+  });
+  m.def("disable_sparse_linear", []() {
+    AutoOptConfig::singleton().set_sparse_linear(false);
+  });
+  m.def("get_sparse_linear", []() {
+    return AutoOptConfig::singleton().get_sparse_linear();
+  });
+  m.def("enable_jit_weight_only_quantization", []() {
+    AutoOptConfig::singleton().set_jit_weight_only_quantization(true);
+  });
+  m.def("disable_jit_weight_only_quantization", []() {
+    AutoOptConfig::singleton().set_jit_weight_only_quantization(false);
+  });
+  m.def("get_jit_weight_only_quantization", []() {
+    return AutoOptConfig::singleton().get_jit_weight_only_quantization();
+  });
+  m.def(
+      "set_jit_weight_only_quantization_dtype",
+      [](const std::string& dtype, int64_t group_size) {
+        AutoOptConfig::singleton().set_jit_weight_only_quantization_dtype(
+            dtype, group_size);
+      });
+  m.def("get_jit_weight_only_quantization_dtype", []() {
+    return AutoOptConfig::singleton().get_jit_weight_only_quantization_dtype();
+  });
+  m.def("enable_jit_dynamic_quantization", []() {
+    AutoOptConfig::singleton().set_jit_dynamic_quantization(true);
+  });
+  m.def("disable_jit_dynamic_quantization", []() {
+    AutoOptConfig::singleton().set_jit_dynamic_quantization(false);
+  });
+  m.def("get_jit_dynamic_quantization", []() {
+    return AutoOptConfig::singleton().get_jit_dynamic_quantization();
+  });
 
   // int8 path
   m.def(
@@ -139,6 +487,12 @@ void InitIpexModuleBindings(py::module m) {
   m.def("get_int8_qscheme", []() {
     return static_cast<int>(AutoOptConfig::singleton().get_int8_qscheme());
   });
+  m.def("set_int8_observer_algorithm", [](const std::string& algorithm) {
+    AutoOptConfig::singleton().set_int8_observer_algorithm(algorithm);
+  });
+  m.def("get_int8_observer_algorithm", []() {
+    return AutoOptConfig::singleton().get_int8_observer_algorithm();
+  });
 
   m.def(
       "add_indicators", []() { Int8OptConfig::get_config().add_indicators(); });
@@ -255,14 +609,106 @@ void InitIpexModuleBindings(py::module m) {
     }
     Int8OptConfig::get_config().set_indicators(indicators);
   });
+  m.def("is_indicators_binary_file", &int8::is_indicators_binary_file);
+  m.def("save_indicators_binary_file", &int8::save_indicators_binary_file);
+  m.def("load_indicators_binary_file", &int8::load_indicators_binary_file);
 
   // extend OPs
-  m.def(
-      "embedding_bag_fast_path_sum", &torch_ipex::embedding_bag_fast_path_sum);
+  m.def("embedding_bag_fast_path", &torch_ipex::embedding_bag_fast_path);
+
+  // cache of the packed weights
+  m.def("_get_packed_weight_cache_stats", []() {
+    auto stats = torch_ipex::cpu::PackedWeightCache::get_instance().get_stats();
+    py::dict d;
+    d["entries"] = stats.entries;
+    d["cached_bytes"] = stats.cached_bytes;
+    d["capacity_bytes"] = stats.capacity_bytes;
+    d["hits"] = stats.hits;
+    d["misses"] = stats.misses;
+    d["evictions"] = stats.evictions;
+    d["invalidations"] = stats.invalidations;
+    return d;
+  });
+  m.def("_set_packed_weight_cache_capacity", [](int64_t capacity_bytes) {
+    torch_ipex::cpu::PackedWeightCache::get_instance().set_capacity_bytes(
+        capacity_bytes);
+  });
+  m.def("_invalidate_packed_weight", [](const at::Tensor& weight) {
+    torch_ipex::cpu::PackedWeightCache::get_instance().invalidate(weight);
+  });
+  m.def("_clear_packed_weight_cache", []() {
+    torch_ipex::cpu::PackedWeightCache::get_instance().clear();
+  });
+
+  // memory of the caches
+  m.def("_get_memory_stats", []() {
+    auto stats = torch_ipex::memory_stats::get_memory_stats();
+    py::dict caches;
+    for (auto& cache : stats.caches) {
+      py::dict d;
+      d["bytes"] = cache.bytes;
+      d["entries"] = cache.entries;
+      d["peak_bytes"] = cache.peak_bytes;
+      d["evicted_bytes"] = cache.evicted_bytes;
+      d["evictable"] = cache.evictable;
+      caches[py::str(cache.name)] = d;
+    }
+    py::dict d;
+    d["bytes"] = stats.bytes;
+    d["peak_bytes"] = stats.peak_bytes;
+    d["budget_bytes"] = stats.budget_bytes;
+    d["caches"] = caches;
+    return d;
+  });
+  m.def("_reset_peak_memory_stats", []() {
+    torch_ipex::memory_stats::reset_peak_memory_stats();
+  });
+  m.def("_set_memory_budget", [](int64_t bytes) {
+    torch_ipex::memory_stats::set_memory_budget(bytes);
+  });
+
+  // huge pages of the packed weights, the embedding tables and the arenas
+  m.def("_set_huge_pages_enabled", [](bool enabled) {
+    torch_ipex::huge_pages::set_enabled(enabled);
+  });
+  m.def("_is_huge_pages_enabled", []() {
+    return torch_ipex::huge_pages::is_enabled();
+  });
+  m.def("_is_huge_pages_available", []() {
+    return torch_ipex::huge_pages::is_available();
+  });
+  m.def("_to_huge_pages", [](const at::Tensor& tensor) {
+    return torch_ipex::huge_pages::to_huge_pages(tensor);
+  });
+
+  // serialization of the packed weights
+  m.def("_set_packed_weight_serialization_enabled", [](bool enabled) {
+    torch_ipex::cpu::set_packed_weight_serialization_enabled(enabled);
+  });
+  m.def("_is_packed_weight_serialization_enabled", []() {
+    return torch_ipex::cpu::is_packed_weight_serialization_enabled();
+  });
 
   // runtime
+  py::register_exception<torch_ipex::runtime::TaskQueueFullError>(
+      m, "TaskQueueFullError", PyExc_RuntimeError);
+  py::register_exception<torch_ipex::runtime::TaskDroppedError>(
+      m, "TaskDroppedError", PyExc_RuntimeError);
   py::class_<torch_ipex::runtime::FutureTensor>(m, "FutureTensor")
-      .def("get", &torch_ipex::runtime::FutureTensor::get);
+      .def("get", &torch_ipex::runtime::FutureTensor::get)
+      .def("wait", &torch_ipex::runtime::FutureTensor::wait)
+      .def("done", &torch_ipex::runtime::FutureTensor::done)
+      .def(
+          "add_done_callback",
+          &torch_ipex::runtime::FutureTensor::add_done_callback);
+  m.def("wait_all", [](const py::list& futures) {
+    return torch_ipex::runtime::wait_all(
+        py::cast<std::vector<torch_ipex::runtime::FutureTensor*>>(futures));
+  });
+  m.def("wait_any", [](const py::list& futures) {
+    return torch_ipex::runtime::wait_any(
+        py::cast<std::vector<torch_ipex::runtime::FutureTensor*>>(futures));
+  });
 
   // The holder type is std::shared_ptr<torch_ipex::runtime::CPUPool>.
   // Please use std::shared_ptr<torch_ipex::runtime::CPUPool> as funtion
@@ -274,10 +720,90 @@ void InitIpexModuleBindings(py::module m) {
         return std::make_shared<torch_ipex::runtime::CPUPool>(
             py::cast<std::vector<int32_t>>(core_list));
       }))
-      .def("get_core_list", [](torch_ipex::runtime::CPUPool& self) {
-        return self.get_cpu_core_list();
+      .def(py::init([](const py::list& core_list, int32_t numa_node_id) {
+        return std::make_shared<torch_ipex::runtime::CPUPool>(
+            py::cast<std::vector<int32_t>>(core_list), numa_node_id);
+      }))
+      .def(
+          "get_core_list",
+          [](torch_ipex::runtime::CPUPool& self) {
+            return self.get_cpu_core_list();
+          })
+      .def(
+          "get_numa_node_id",
+          [](torch_ipex::runtime::CPUPool& self) {
+            return self.get_numa_node_id();
+          })
+      .def(
+          "set_spin_time_us",
+          [](torch_ipex::runtime::CPUPool& self, int64_t spin_time_us) {
+            self.set_spin_time_us(spin_time_us);
+          })
+      .def(
+          "get_spin_time_us",
+          [](torch_ipex::runtime::CPUPool& self) {
+            return self.get_spin_time_us();
+          })
+      .def(
+          "enable_memory_arena",
+          [](torch_ipex::runtime::CPUPool& self) {
+            self.enable_memory_arena();
+          })
+      .def(
+          "reset_memory_arena",
+          [](torch_ipex::runtime::CPUPool& self) {
+            auto memory_arena = self.get_memory_arena();
+            TORCH_CHECK(memory_arena, "Memory arena of CPUPool is not enabled");
+            memory_arena->reset();
+          })
+      .def("memory_arena_stats", [](torch_ipex::runtime::CPUPool& self) {
+        auto memory_arena = self.get_memory_arena();
+        TORCH_CHECK(memory_arena, "Memory arena of CPUPool is not enabled");
+        auto stats = memory_arena->get_stats();
+        py::dict d;
+        d["allocated_bytes"] = stats.allocated_bytes;
+        d["cached_bytes"] = stats.cached_bytes;
+        d["hits"] = stats.hits;
+        d["misses"] = stats.misses;
+        return d;
       });
 
+  // TaskModules created with the same TaskExecutorGroup steal the pending
+  // tasks from each other when their own queue is empty.
+  py::class_<
+      torch_ipex::runtime::TaskExecutorGroup,
+      std::shared_ptr<torch_ipex::runtime::TaskExecutorGroup>>(
+      m, "TaskExecutorGroup")
+      .def(py::init([]() {
+        return std::make_shared<torch_ipex::runtime::TaskExecutorGroup>();
+      }));
+
+  // A TaskExecutor shared by the TaskModules of several models, e.g. of a
+  // scheduler, which stops it by stop or on its destruction.
+  py::class_<
+      torch_ipex::runtime::TaskExecutor,
+      std::shared_ptr<torch_ipex::runtime::TaskExecutor>>(m, "TaskExecutor")
+      .def(py::init(
+          [](std::shared_ptr<torch_ipex::runtime::CPUPool> cpu_pool,
+             std::shared_ptr<torch_ipex::runtime::TaskExecutorGroup>
+                 task_executor_group) {
+            return std::make_shared<torch_ipex::runtime::TaskExecutor>(
+                *cpu_pool, task_executor_group);
+          }))
+      .def(
+          "get_queued_tasks",
+          [](torch_ipex::runtime::TaskExecutor& self) {
+            auto stats = self.get_queue_stats();
+            return stats.queued_tasks + stats.high_priority_queued_tasks;
+          })
+      .def(
+          "get_cpu_core_list",
+          &torch_ipex::runtime::TaskExecutor::get_cpu_core_list)
+      .def(
+          "stop",
+          &torch_ipex::runtime::TaskExecutor::stop_executor,
+          py::call_guard<py::gil_scoped_release>());
+
   py::class_<
       torch_ipex::runtime::TaskModule,
       std::shared_ptr<torch_ipex::runtime::TaskModule>>(m, "TaskModule")
@@ -291,6 +817,58 @@ void InitIpexModuleBindings(py::module m) {
         return std::make_shared<torch_ipex::runtime::TaskModule>(
             module, py::cast<std::vector<int32_t>>(core_list), traced_module);
       }))
+      .def(py::init(
+          [](const py::object& module,
+             std::shared_ptr<torch_ipex::runtime::CPUPool> cpu_pool,
+             std::shared_ptr<torch_ipex::runtime::TaskExecutorGroup>
+                 task_executor_group) {
+            return std::make_shared<torch_ipex::runtime::TaskModule>(
+                module, *cpu_pool, task_executor_group);
+          }))
+      .def(py::init(
+          [](const torch::jit::Module& module,
+             std::shared_ptr<torch_ipex::runtime::CPUPool> cpu_pool,
+             bool traced_module,
+             std::shared_ptr<torch_ipex::runtime::TaskExecutorGroup>
+                 task_executor_group) {
+            return std::make_shared<torch_ipex::runtime::TaskModule>(
+                module, *cpu_pool, traced_module, task_executor_group);
+          }))
+      .def(py::init(
+          [](const py::object& module,
+             std::shared_ptr<torch_ipex::runtime::TaskExecutor> task_executor) {
+            return std::make_shared<torch_ipex::runtime::TaskModule>(
+                module, task_executor);
+          }))
+      .def(py::init(
+          [](const torch::jit::Module& module,
+             std::shared_ptr<torch_ipex::runtime::TaskExecutor> task_executor,
+             bool traced_module) {
+            return std::make_shared<torch_ipex::runtime::TaskModule>(
+                module, task_executor, traced_module);
+          }))
+      .def(py::init(
+          [](const py::object& module,
+             const py::list& core_list,
+             std::shared_ptr<torch_ipex::runtime::TaskExecutorGroup>
+                 task_executor_group) {
+            return std::make_shared<torch_ipex::runtime::TaskModule>(
+                module,
+                py::cast<std::vector<int32_t>>(core_list),
+                task_executor_group);
+          }))
+      .def(py::init(
+          [](const torch::jit::Module& module,
+             const py::list& core_list,
+             bool traced_module,
+             std::shared_ptr<torch_ipex::runtime::TaskExecutorGroup>
+                 task_executor_group) {
+            return std::make_shared<torch_ipex::runtime::TaskModule>(
+                module,
+                py::cast<std::vector<int32_t>>(core_list),
+                traced_module,
+                task_executor_group);
+          }))
       .def(
           "run_sync",
           [](torch_ipex::runtime::TaskModule& self,
@@ -308,8 +886,173 @@ void InitIpexModuleBindings(py::module m) {
             // Depending on this being ScriptModule of nn.Module we will release
             // the GIL or not further down in the stack
             return self.run_async(std::move(args), std::move(kwargs));
+          })
+      .def(
+          "run_async_high_priority",
+          [](torch_ipex::runtime::TaskModule& self,
+             py::args& args,
+             py::kwargs& kwargs) {
+            return self.run_async(
+                std::move(args),
+                std::move(kwargs),
+                torch_ipex::runtime::TaskPriority::High);
+          })
+      .def(
+          "is_script_module",
+          &torch_ipex::runtime::TaskModule::is_script_module)
+      .def(
+          "resize",
+          &torch_ipex::runtime::TaskModule::resize,
+          py::call_guard<py::gil_scoped_release>())
+      .def(
+          "get_cpu_core_list",
+          &torch_ipex::runtime::TaskModule::get_cpu_core_list)
+      .def(
+          "set_queue_limit",
+          [](torch_ipex::runtime::TaskModule& self,
+             int64_t max_queued_tasks,
+             int32_t policy) {
+            TORCH_CHECK(
+                policy >= 0 && policy <= 2,
+                "Unknown queue full policy ",
+                policy);
+            self.set_queue_limit(
+                max_queued_tasks,
+                static_cast<torch_ipex::runtime::QueueFullPolicy>(policy));
+          })
+      .def(
+          "get_queue_stats",
+          [](torch_ipex::runtime::TaskModule& self) {
+            auto stats = self.get_queue_stats();
+            py::dict d;
+            d["queued_tasks"] = stats.queued_tasks;
+            d["high_priority_queued_tasks"] = stats.high_priority_queued_tasks;
+            d["peak_queued_tasks"] = stats.peak_queued_tasks;
+            d["rejected_tasks"] = stats.rejected_tasks;
+            d["dropped_tasks"] = stats.dropped_tasks;
+            d["blocked_submissions"] = stats.blocked_submissions;
+            return d;
           });
 
+  // Split the input along the batch dim into views, run each split on one
+  // TaskModule and gather the results into one preallocated output. The whole
+  // execution runs without GIL.
+  m.def(
+      "_multi_stream_forward",
+      [](const std::vector<std::shared_ptr<torch_ipex::runtime::TaskModule>>&
+             tasks,
+         const at::Tensor& input,
+         const std::vector<int64_t>& split_sizes) {
+        TORCH_CHECK(
+            split_sizes.size() <= tasks.size(),
+            "The number of splits must be less than or equal to the number of streams");
+        pybind11::gil_scoped_release no_gil_guard;
+        auto gather = std::make_shared<torch_ipex::runtime::OutputGather>(
+            input.size(0));
+        std::vector<std::future<void>> futures;
+        int64_t offset = 0;
+        for (size_t i = 0; i < split_sizes.size(); i++) {
+          futures.emplace_back(tasks[i]->run_async_gather(
+              input.narrow(0, offset, split_sizes[i]), gather, offset));
+          offset += split_sizes[i];
+        }
+        // Wait for all the streams before rethrowing any error, since the
+        // streams are still writing into the shared output.
+        std::exception_ptr error = nullptr;
+        for (auto& future : futures) {
+          try {
+            future.get();
+          } catch (...) {
+            if (!error) {
+              error = std::current_exception();
+            }
+          }
+        }
+        if (error) {
+          std::rethrow_exception(error);
+        }
+        return gather->output;
+      });
+
+  py::class_<
+      torch_ipex::runtime::MicroBatchScheduler,
+      std::shared_ptr<torch_ipex::runtime::MicroBatchScheduler>>(
+      m, "MicroBatchScheduler")
+      .def(py::init([](const torch::jit::Module& module,
+                       const py::list& stream_core_lists,
+                       int64_t max_batch_size,
+                       int64_t max_latency_us) {
+        return std::make_shared<torch_ipex::runtime::MicroBatchScheduler>(
+            module,
+            py::cast<std::vector<std::vector<int32_t>>>(stream_core_lists),
+            max_batch_size,
+            max_latency_us);
+      }))
+      .def(
+          "submit",
+          [](torch_ipex::runtime::MicroBatchScheduler& self,
+             const at::Tensor& input) { return self.submit(input); })
+      .def("stop", [](torch_ipex::runtime::MicroBatchScheduler& self) {
+        pybind11::gil_scoped_release no_gil_guard;
+        self.stop_scheduler();
+      });
+
+  py::class_<
+      torch_ipex::runtime::PipelineScheduler,
+      std::shared_ptr<torch_ipex::runtime::PipelineScheduler>>(
+      m, "PipelineScheduler")
+      .def(py::init([](const py::list& stage_modules,
+                       const py::list& stage_cpu_pools,
+                       int64_t max_queue_size) {
+        return std::make_shared<torch_ipex::runtime::PipelineScheduler>(
+            py::cast<std::vector<torch::jit::Module>>(stage_modules),
+            py::cast<
+                std::vector<std::shared_ptr<torch_ipex::runtime::CPUPool>>>(
+                stage_cpu_pools),
+            max_queue_size);
+      }))
+      .def(
+          "submit",
+          [](torch_ipex::runtime::PipelineScheduler& self, py::args& args) {
+            std::vector<c10::IValue> inputs;
+            for (auto& arg : args) {
+              inputs.emplace_back(py::cast<at::Tensor>(arg));
+            }
+            // Release the GIL, since the submit blocks when the first stage
+            // is full.
+            pybind11::gil_scoped_release no_gil_guard;
+            return self.submit(std::move(inputs));
+          })
+      .def("stop", [](torch_ipex::runtime::PipelineScheduler& self) {
+        pybind11::gil_scoped_release no_gil_guard;
+        self.stop_scheduler();
+      });
+
+  m.def(
+      "_set_task_tracing_enabled",
+      &torch_ipex::runtime::set_task_tracing_enabled);
+  m.def(
+      "_is_task_tracing_enabled",
+      &torch_ipex::runtime::is_task_tracing_enabled);
+  m.def("_get_task_traces", []() {
+    py::list traces;
+    for (const auto& record : torch_ipex::runtime::get_task_traces()) {
+      traces.append(py::make_tuple(
+          record.request_id,
+          record.executor_id,
+          record.submit_time_us,
+          record.start_time_us,
+          record.end_time_us));
+    }
+    return traces;
+  });
+  m.def("_clear_task_traces", &torch_ipex::runtime::clear_task_traces);
+  m.def(
+      "_get_current_request_id",
+      &torch_ipex::runtime::get_current_request_id);
+  m.def(
+      "_set_current_request_id",
+      &torch_ipex::runtime::set_current_request_id);
   m.def("is_runtime_ext_enabled", &torch_ipex::runtime::is_runtime_ext_enabled);
   m.def("init_runtime_ext", &torch_ipex::runtime::init_runtime_ext);
   m.def("pin_cpu_cores", [](const py::list& core_list) {
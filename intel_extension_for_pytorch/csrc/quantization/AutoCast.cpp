@@ -7,6 +7,7 @@
 #include "AutoCast_utils.hpp"
 #include "Common.hpp"
 #include "Config.hpp"
+#include "csrc/aten/cpu/RNN.h"
 #include "csrc/autocast/autocast_mode.h"
 
 namespace torch_ipex {
@@ -479,7 +480,41 @@ std::tuple<Tensor, Tensor, Tensor> lstm(
   }
   params p = get_params(op_id);
   auto lstm_x = input;
-  if (p.inputs_quantized[0]) {
+  if (p.inputs_quantized[0] && !train && input.scalar_type() == at::kFloat) {
+    // run the int8 LSTM primitive with the calibrated range of the input.
+    int64_t q_min = 0, q_max = 255;
+    if (p.input_quantized_dtypes[0] == at::kQInt8) {
+      q_min = -128;
+      q_max = 127;
+    }
+    double input_min =
+        (q_min - p.qparams[0][0].zero_point) * p.qparams[0][0].scale;
+    double input_max =
+        (q_max - p.qparams[0][0].zero_point) * p.qparams[0][0].scale;
+    std::vector<at::Tensor> weight_scales;
+    if (torch_ipex::get_int8_weight_granularity(op_id) == "per_channel") {
+      weight_scales = torch_ipex::get_int8_weight_tensor_scale(op_id);
+    } else {
+      for (auto w_scale : torch_ipex::get_int8_weight_scale(op_id)) {
+        weight_scales.push_back(
+            at::full({1}, w_scale, at::dtype(at::kDouble)));
+      }
+    }
+    static auto op = torch::Dispatcher::singleton()
+                         .findSchemaOrThrow("torch_ipex::quantized_lstm", "")
+                         .typed<decltype(torch_ipex::cpu::quantized_lstm)>();
+    std::tie(output, hy, cy) = op.call(
+        input,
+        hx,
+        _params,
+        has_biases,
+        num_layers,
+        bidirectional,
+        batch_first,
+        input_min,
+        input_max,
+        weight_scales);
+  } else if (p.inputs_quantized[0]) {
     // add quantize and dequantize for input and weight.
     auto input_q = at::quantize_per_tensor(
         input,
@@ -662,7 +697,7 @@ at::Tensor matmul(const at::Tensor& mat1, const at::Tensor& mat2) {
   auto output = at::matmul(r_inputs[0], r_inputs[1]);
   auto outputs = insert_q_dq_outputs(
       {output}, p.qparams[1], p.output_quantized_dtypes, p.outputs_quantized);
-  return output;
+  return outputs[0];
 }
 
 } // namespace int8
@@ -25,13 +25,11 @@ void insert_or_updata_observer(
   std::vector<std::vector<float>> inputs_min_max_values, outputs_min_max_values;
   std::vector<std::vector<std::vector<float>>> weights_min_max_values;
   for (auto i = 0; i < inputs.size(); i++) {
-    inputs_min_max_values.push_back(
-        {inputs[i].min().item<float>(), inputs[i].max().item<float>()});
+    inputs_min_max_values.push_back(compute_min_max(inputs[i]));
   }
 
   for (auto j = 0; j < outputs.size(); j++) {
-    outputs_min_max_values.push_back(
-        {outputs[j].min().item<float>(), outputs[j].max().item<float>()});
+    outputs_min_max_values.push_back(compute_min_max(outputs[j]));
   }
   if (weights.size() > 0) {
     auto weight_granularity =
@@ -42,20 +40,12 @@ void insert_or_updata_observer(
     }
     if (weight_granularity == "per_channel") {
       for (auto k = 0; k < weights.size(); k++) {
-        auto w = weights[k];
-        std::vector<std::vector<float>> min_max_values;
-        for (int l = 0; l < w.size(0); l++) {
-          min_max_values.push_back(
-              {w[l].min().item<float>(), w[l].max().item<float>()});
-        }
-        weights_min_max_values.push_back(min_max_values);
+        weights_min_max_values.push_back(
+            compute_min_max_per_channel(weights[k]));
       }
     } else {
       for (auto k = 0; k < weights.size(); k++) {
-        std::vector<std::vector<float>> min_max_values;
-        min_max_values.push_back(
-            {weights[k].min().item<float>(), weights[k].max().item<float>()});
-        weights_min_max_values.push_back(min_max_values);
+        weights_min_max_values.push_back({compute_min_max(weights[k])});
       }
     }
   }
@@ -67,6 +57,8 @@ void insert_or_updata_observer(
       ops_id,
       op_inputs,
       op_outputs);
+  Int8OptConfig::get_config().update_observer_histograms(
+      ops_id, inputs, outputs);
 }
 
 std::vector<std::vector<quant_utils::TensorQuantizationParams>> get_int8_scales(
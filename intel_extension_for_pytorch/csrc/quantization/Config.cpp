@@ -2,6 +2,10 @@
 #include <ATen/native/quantized/cpu/quant_utils.h>
 #include <torch/csrc/autograd/function.h>
 
+#include <cmath>
+#include <limits>
+#include <numeric>
+
 #include "auto_opt_config.hpp"
 #include "csrc/utils/utils.h"
 
@@ -43,6 +47,198 @@ std::vector<quant_utils::TensorQuantizationParams> ComputeQuantizationParams(
   return QParams;
 }
 
+const int64_t histogram_bins = 2048;
+
+bool is_histogram_algorithm(const std::string& algorithm) {
+  return algorithm == "percentile" || algorithm == "kl_divergence" ||
+      algorithm == "mse";
+}
+
+// Merge the bins of a histogram into the wider bins of a new range.
+void rebin_histogram(Histogram& histogram, float range) {
+  if (histogram.bins.empty()) {
+    histogram.bins.assign(histogram_bins, 0.f);
+  }
+  if (range <= histogram.range) {
+    return;
+  }
+  std::vector<float> bins(histogram_bins, 0.f);
+  auto ratio = histogram.range / range;
+  for (auto i = 0; i < histogram_bins; i++) {
+    auto j = std::min(
+        static_cast<int64_t>((i + 0.5f) * ratio), histogram_bins - 1);
+    bins[j] += histogram.bins[i];
+  }
+  histogram.bins = std::move(bins);
+  histogram.range = range;
+}
+
+// Accumulate the absolute values of a tensor, which are not greater than
+// range, the max absolute value observed so far, into a histogram.
+void update_histogram(
+    Histogram& histogram,
+    const at::Tensor& tensor,
+    float range) {
+  rebin_histogram(histogram, range);
+  accumulate_histogram(tensor, histogram.range, histogram.bins);
+}
+
+void merge_histogram(Histogram& histogram, const Histogram& other) {
+  if (other.bins.empty()) {
+    return;
+  }
+  auto src = other;
+  rebin_histogram(histogram, src.range);
+  rebin_histogram(src, histogram.range);
+  for (auto i = 0; i < histogram_bins; i++) {
+    histogram.bins[i] += src.bins[i];
+  }
+}
+
+// Merge the min/max values of an op collected by two threads.
+void merge_min_max_values(
+    const std::string& algorithm,
+    int64_t count,
+    std::vector<std::vector<float>>& min_max_values,
+    const std::vector<std::vector<float>>& other) {
+  for (auto i = 0; i < min_max_values.size(); i++) {
+    if (algorithm == "moving_averager_min_max") {
+      // the mean of the moving averages of all the threads
+      for (auto k = 0; k < 2; k++) {
+        min_max_values[i][k] +=
+            (other[i][k] - min_max_values[i][k]) / (count + 1);
+      }
+    } else {
+      min_max_values[i][0] = std::min(min_max_values[i][0], other[i][0]);
+      min_max_values[i][1] = std::max(min_max_values[i][1], other[i][1]);
+    }
+  }
+}
+
+// The smallest threshold below which the percentile of the values are.
+float percentile_threshold(const Histogram& histogram, float percentile) {
+  const auto& bins = histogram.bins;
+  auto total = std::accumulate(bins.begin(), bins.end(), 0.);
+  auto target = total * percentile / 100;
+  double sum = 0;
+  for (auto i = 0; i < histogram_bins; i++) {
+    sum += bins[i];
+    if (sum >= target) {
+      return histogram.range * (i + 1) / histogram_bins;
+    }
+  }
+  return histogram.range;
+}
+
+// The threshold of which the distribution quantized into num_levels levels,
+// with the values above it clipped, has the smallest KL divergence from the
+// distribution of the values.
+float kl_divergence_threshold(const Histogram& histogram, int num_levels) {
+  const auto& bins = histogram.bins;
+  std::vector<double> p(histogram_bins), q(histogram_bins);
+  double best_divergence = std::numeric_limits<double>::max();
+  int64_t best_bins = histogram_bins;
+  auto outliers = std::accumulate(bins.begin(), bins.end(), 0.);
+  for (auto i = 0; i < num_levels; i++) {
+    outliers -= bins[i];
+  }
+  for (int64_t num_bins = num_levels; num_bins <= histogram_bins;
+       num_bins++) {
+    // the clipped distribution, with the outliers in its last bin
+    std::copy(bins.begin(), bins.begin() + num_bins, p.begin());
+    p[num_bins - 1] += outliers;
+    if (num_bins < histogram_bins) {
+      outliers -= bins[num_bins];
+    }
+    // spread each level evenly over its nonzero bins
+    for (auto level = 0; level < num_levels; level++) {
+      auto begin = level * num_bins / num_levels;
+      auto end = (level + 1) * num_bins / num_levels;
+      double sum = 0;
+      int64_t nonzeros = 0;
+      for (auto j = begin; j < end; j++) {
+        sum += p[j];
+        nonzeros += p[j] > 0;
+      }
+      for (auto j = begin; j < end; j++) {
+        q[j] = p[j] > 0 ? sum / nonzeros : 0;
+      }
+    }
+    auto p_sum = std::accumulate(p.begin(), p.begin() + num_bins, 0.);
+    if (p_sum == 0) {
+      continue;
+    }
+    // q sums to p_sum as well
+    double divergence = 0;
+    for (auto j = 0; j < num_bins; j++) {
+      if (p[j] > 0) {
+        divergence += p[j] / p_sum * std::log(p[j] / q[j]);
+      }
+    }
+    if (divergence < best_divergence) {
+      best_divergence = divergence;
+      best_bins = num_bins;
+    }
+  }
+  return histogram.range * best_bins / histogram_bins;
+}
+
+// The threshold of the smallest expected squared error of quantizing the
+// values into num_levels levels below it and clipping the values above it.
+float mse_threshold(const Histogram& histogram, int num_levels) {
+  const auto& bins = histogram.bins;
+  auto bin_width = static_cast<double>(histogram.range) / histogram_bins;
+  // the count, sum and squared sum of the values above each bin
+  double count = 0, sum = 0, squared_sum = 0;
+  for (auto i = 0; i < histogram_bins; i++) {
+    auto center = (i + 0.5) * bin_width;
+    count += bins[i];
+    sum += bins[i] * center;
+    squared_sum += bins[i] * center * center;
+  }
+  double below = 0;
+  double best_error = std::numeric_limits<double>::max();
+  int64_t best_bins = histogram_bins;
+  for (auto num_bins = 1; num_bins <= histogram_bins; num_bins++) {
+    auto center = (num_bins - 0.5) * bin_width;
+    below += bins[num_bins - 1];
+    count -= bins[num_bins - 1];
+    sum -= bins[num_bins - 1] * center;
+    squared_sum -= bins[num_bins - 1] * center * center;
+    auto threshold = num_bins * bin_width;
+    auto step = threshold / num_levels;
+    auto error = below * step * step / 12 + squared_sum -
+        2 * threshold * sum + threshold * threshold * count;
+    if (error < best_error) {
+      best_error = error;
+      best_bins = num_bins;
+    }
+  }
+  return histogram.range * best_bins / histogram_bins;
+}
+
+// Clip the min/max of the values observed by a histogram based method.
+void clip_min_max_values(
+    const Observer& observer,
+    const std::vector<Histogram>& histograms,
+    std::vector<std::vector<float>>& min_max_values) {
+  for (auto j = 0; j < min_max_values.size(); j++) {
+    auto& min_max = min_max_values[j];
+    // a non-negative tensor is quantized into the full range
+    const int num_levels = min_max[0] >= 0 ? 256 : 128;
+    float threshold;
+    if (observer.algorithm == "percentile") {
+      threshold = percentile_threshold(histograms[j], observer.percentile);
+    } else if (observer.algorithm == "kl_divergence") {
+      threshold = kl_divergence_threshold(histograms[j], num_levels);
+    } else {
+      threshold = mse_threshold(histograms[j], num_levels);
+    }
+    min_max[0] = std::max(min_max[0], -threshold);
+    min_max[1] = std::min(min_max[1], threshold);
+  }
+}
+
 void Int8OptConfig::insert_or_updata_observer(
     std::string op_name,
     std::vector<std::vector<float>> i_min_max_values,
@@ -51,10 +247,13 @@ void Int8OptConfig::insert_or_updata_observer(
     int64_t ops_id,
     std::vector<std::string> inputs_flow,
     std::vector<std::string> outputs_flow) {
-  if (observers_.size() <= ops_id) {
+  // each thread updates its own observers without locks
+  auto& observers = thread_observers();
+  if (observers.size() <= ops_id) {
     // this path is that to set int8 op's configure, using default configures if
     // user not set it. Note: weight's value only set onece.
-    std::string observer_algorithm = "min_max";
+    std::string observer_algorithm =
+        AutoOptConfig::singleton().get_int8_observer_algorithm();
     float averaging_constant =
         0.01; // will be enabled for moving_averager_min_max
     std::string weight_granularity = "per_channel";
@@ -112,42 +311,123 @@ void Int8OptConfig::insert_or_updata_observer(
         outputs_quantized,
         inputs_flow,
         outputs_flow};
-    observers_.push_back(new_observer);
+    new_observer.inputs_histograms.resize(nums_input);
+    new_observer.outputs_histograms.resize(nums_output);
+    observers.push_back(new_observer);
   } else {
     // user has set configure or have run one interation
-    auto inputs_pre = observers_[ops_id].inputs_min_max_values;
-    auto outputs_pre = observers_[ops_id].outputs_min_max_values;
-    if (observers_[ops_id].algorithm == "min_max") {
+    auto inputs_pre = observers[ops_id].inputs_min_max_values;
+    auto outputs_pre = observers[ops_id].outputs_min_max_values;
+    if (observers[ops_id].algorithm == "min_max" ||
+        is_histogram_algorithm(observers[ops_id].algorithm)) {
       for (auto i = 0; i < i_min_max_values.size(); i++) {
-        observers_[ops_id].inputs_min_max_values[i][0] =
+        observers[ops_id].inputs_min_max_values[i][0] =
             std::min(inputs_pre[i][0], i_min_max_values[i][0]);
-        observers_[ops_id].inputs_min_max_values[i][1] =
+        observers[ops_id].inputs_min_max_values[i][1] =
             std::max(inputs_pre[i][1], i_min_max_values[i][1]);
       }
       for (auto j = 0; j < o_min_max_values.size(); j++) {
-        observers_[ops_id].outputs_min_max_values[j][0] =
+        observers[ops_id].outputs_min_max_values[j][0] =
             std::min(outputs_pre[j][0], o_min_max_values[j][0]);
-        observers_[ops_id].outputs_min_max_values[j][1] =
+        observers[ops_id].outputs_min_max_values[j][1] =
             std::max(outputs_pre[j][1], o_min_max_values[j][1]);
       }
-    } else if (observers_[ops_id].algorithm == "moving_averager_min_max") {
-      auto c = observers_[ops_id].averaging_constant;
+    } else if (observers[ops_id].algorithm == "moving_averager_min_max") {
+      auto c = observers[ops_id].averaging_constant;
       for (auto i = 0; i < i_min_max_values.size(); i++) {
-        observers_[ops_id].inputs_min_max_values[i][0] =
+        observers[ops_id].inputs_min_max_values[i][0] =
             (1 - c) * inputs_pre[i][0] + c * i_min_max_values[i][0];
-        observers_[ops_id].inputs_min_max_values[i][1] =
+        observers[ops_id].inputs_min_max_values[i][1] =
             (1 - c) * inputs_pre[i][1] + c * i_min_max_values[i][1];
       }
       for (auto j = 0; j < o_min_max_values.size(); j++) {
-        observers_[ops_id].outputs_min_max_values[j][0] =
+        observers[ops_id].outputs_min_max_values[j][0] =
             (1 - c) * outputs_pre[j][0] + c * o_min_max_values[j][0];
-        observers_[ops_id].outputs_min_max_values[j][1] =
+        observers[ops_id].outputs_min_max_values[j][1] =
             (1 - c) * outputs_pre[j][1] + c * o_min_max_values[j][1];
       }
     }
   }
 }
 
+void Int8OptConfig::update_observer_histograms(
+    const int64_t ops_id,
+    const at::TensorList& inputs,
+    const at::TensorList& outputs) {
+  auto& observer = thread_observers()[ops_id];
+  if (!is_histogram_algorithm(observer.algorithm)) {
+    return;
+  }
+  auto abs_max = [](const std::vector<float>& min_max) {
+    return std::max(std::abs(min_max[0]), std::abs(min_max[1]));
+  };
+  for (auto i = 0; i < inputs.size(); i++) {
+    update_histogram(
+        observer.inputs_histograms[i],
+        inputs[i],
+        abs_max(observer.inputs_min_max_values[i]));
+  }
+  for (auto j = 0; j < outputs.size(); j++) {
+    update_histogram(
+        observer.outputs_histograms[j],
+        outputs[j],
+        abs_max(observer.outputs_min_max_values[j]));
+  }
+}
+
+std::vector<Observer>& Int8OptConfig::thread_observers() {
+  // the shard of this thread is dropped once merged by add_indicators
+  thread_local std::shared_ptr<std::vector<Observer>> shard;
+  thread_local int64_t shard_generation = -1;
+  if (shard_generation != observer_shards_generation_.load()) {
+    std::lock_guard<std::mutex> lock(observer_shards_mutex_);
+    shard = std::make_shared<std::vector<Observer>>();
+    observer_shards_.push_back(shard);
+    shard_generation = observer_shards_generation_.load();
+  }
+  return *shard;
+}
+
+std::vector<Observer> Int8OptConfig::merge_observers() {
+  std::lock_guard<std::mutex> lock(observer_shards_mutex_);
+  std::vector<Observer> observers;
+  // the number of the threads which have observed each op
+  std::vector<int64_t> counts;
+  for (const auto& shard : observer_shards_) {
+    for (auto i = 0; i < shard->size(); i++) {
+      const auto& other = (*shard)[i];
+      if (observers.size() <= i) {
+        observers.push_back(other);
+        counts.push_back(1);
+        continue;
+      }
+      auto& observer = observers[i];
+      merge_min_max_values(
+          observer.algorithm,
+          counts[i],
+          observer.inputs_min_max_values,
+          other.inputs_min_max_values);
+      merge_min_max_values(
+          observer.algorithm,
+          counts[i],
+          observer.outputs_min_max_values,
+          other.outputs_min_max_values);
+      for (auto j = 0; j < observer.inputs_histograms.size(); j++) {
+        merge_histogram(
+            observer.inputs_histograms[j], other.inputs_histograms[j]);
+      }
+      for (auto j = 0; j < observer.outputs_histograms.size(); j++) {
+        merge_histogram(
+            observer.outputs_histograms[j], other.outputs_histograms[j]);
+      }
+      counts[i]++;
+    }
+  }
+  observer_shards_.clear();
+  observer_shards_generation_++;
+  return observers;
+}
+
 void Int8OptConfig::clear_indicators() {
   indicators_.clear();
   weights_scales_.clear();
@@ -155,18 +435,25 @@ void Int8OptConfig::clear_indicators() {
 
 void Int8OptConfig::add_indicators() {
   indicators_.clear();
+  auto observers = merge_observers();
   // default used is u8
   const int precision = 8;
-  for (auto i = 0; i < observers_.size(); i++) {
+  for (auto i = 0; i < observers.size(); i++) {
     std::vector<quant_utils::TensorQuantizationParams> input_params,
         output_params;
     std::vector<std::vector<float>> weights_scales;
 
-    auto input_values = observers_[i].inputs_min_max_values;
-    auto output_values = observers_[i].outputs_min_max_values;
-    auto weights_values = observers_[i].weights_min_max_values;
-    auto x_quantized_types = observers_[i].input_quantized_dtypes;
-    auto y_quantized_types = observers_[i].output_quantized_dtypes;
+    auto input_values = observers[i].inputs_min_max_values;
+    auto output_values = observers[i].outputs_min_max_values;
+    auto weights_values = observers[i].weights_min_max_values;
+    if (is_histogram_algorithm(observers[i].algorithm)) {
+      clip_min_max_values(
+          observers[i], observers[i].inputs_histograms, input_values);
+      clip_min_max_values(
+          observers[i], observers[i].outputs_histograms, output_values);
+    }
+    auto x_quantized_types = observers[i].input_quantized_dtypes;
+    auto y_quantized_types = observers[i].output_quantized_dtypes;
     // for symmetric: s = 2max(|x_min|, x_max) / (Q_max - Q_min),
     // z = 0 for qint8 and z = 128 for quint8;
     // otherwise: s = (x_max - x_min) / (Q_max - Q_min),
@@ -204,22 +491,21 @@ void Int8OptConfig::add_indicators() {
       weights_scales.push_back(w_scales);
     }
     Indicator new_indicator(
-        observers_[i].id,
-        observers_[i].name,
-        observers_[i].algorithm,
-        observers_[i].weight_granularity,
+        observers[i].id,
+        observers[i].name,
+        observers[i].algorithm,
+        observers[i].weight_granularity,
         input_params,
         weights_scales,
         output_params,
-        observers_[i].input_quantized_dtypes,
-        observers_[i].output_quantized_dtypes,
-        observers_[i].inputs_quantized,
-        observers_[i].outputs_quantized,
-        observers_[i].inputs_flow,
-        observers_[i].outputs_flow);
+        observers[i].input_quantized_dtypes,
+        observers[i].output_quantized_dtypes,
+        observers[i].inputs_quantized,
+        observers[i].outputs_quantized,
+        observers[i].inputs_flow,
+        observers[i].outputs_flow);
     indicators_.push_back(new_indicator);
   }
-  observers_.clear();
 }
 
 std::vector<std::vector<quant_utils::TensorQuantizationParams>> Int8OptConfig::
@@ -276,14 +562,20 @@ std::tuple<std::vector<std::string>, std::vector<std::string>> Int8OptConfig::
   return indicators_[ops_id].get_indicator_quantized_dtypes();
 }
 
-void Int8OptConfig::set_indicators(std::vector<Indicator> indicators) {
+void Int8OptConfig::set_indicators(
+    std::vector<Indicator> indicators,
+    std::unordered_map<int64_t, std::vector<at::Tensor>> weights_scales) {
   // avoid to use copy assignment since the copy assignment for indicator with
   // rw_mutex have not been handdled properly
   indicators_.reserve(indicators.size());
   for (auto i : indicators) {
     // if weight_granularity is per_channle, first cache the scales tensor for
     // trace.
-    if (i.get_indicator_weight_granularity() == "per_channel") {
+    auto loaded_scales = weights_scales.find(i.get_indicator_id());
+    if (loaded_scales != weights_scales.end()) {
+      weights_scales_.emplace(
+          loaded_scales->first, std::move(loaded_scales->second));
+    } else if (i.get_indicator_weight_granularity() == "per_channel") {
       auto id = i.get_indicator_id();
       auto w_scales = i.get_indicator_weight_scales();
       std::vector<at::Tensor> casted_scales;
@@ -307,9 +599,15 @@ int64_t Int8OptConfig::get_indicators_size() {
 
 void Int8OptConfig::calibration_reset() {
   current_ops_id = 0;
+  // the other calibrating threads reset their ops ids at their next ops
+  calibration_generation++;
 }
 
 int64_t Int8OptConfig::fetch_and_add_ops_id() {
+  if (current_calibration_generation != calibration_generation.load()) {
+    current_ops_id = 0;
+    current_calibration_generation = calibration_generation.load();
+  }
   int64_t ops_id = current_ops_id++;
   int64_t indicator_size = Int8OptConfig::get_config().get_indicators_size();
   if (current_ops_id == indicator_size)
@@ -318,5 +616,7 @@ int64_t Int8OptConfig::fetch_and_add_ops_id() {
 }
 
 thread_local int64_t Int8OptConfig::current_ops_id = 0;
+thread_local int64_t Int8OptConfig::current_calibration_generation = 0;
+std::atomic<int64_t> Int8OptConfig::calibration_generation{0};
 
 } // namespace torch_ipex
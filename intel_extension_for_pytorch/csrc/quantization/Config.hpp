@@ -8,6 +8,10 @@
 
 #include "Observer.hpp"
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 namespace torch_ipex {
 
 using namespace int8;
@@ -29,6 +33,11 @@ class Int8OptConfig {
       std::vector<std::string> inputs_flow,
       std::vector<std::string> output_flow);
 
+  void update_observer_histograms(
+      const int64_t ops_id,
+      const at::TensorList& inputs,
+      const at::TensorList& outputs);
+
   void clear_indicators();
 
   void add_indicators();
@@ -49,7 +58,12 @@ class Int8OptConfig {
   std::tuple<std::vector<std::string>, std::vector<std::string>>
   get_indicator_quantized_dtypes(const int64_t ops_id);
 
-  void set_indicators(std::vector<Indicator> indicators);
+  // weights_scales are the per-channel weight scale tensors of the indicators
+  // if they are loaded already, which are cast from the indicators otherwise.
+  void set_indicators(
+      std::vector<Indicator> indicators,
+      std::unordered_map<int64_t, std::vector<at::Tensor>> weights_scales =
+          {});
 
   std::vector<Indicator> get_indicators();
 
@@ -60,16 +74,27 @@ class Int8OptConfig {
   static int64_t fetch_and_add_ops_id();
 
  private:
-  Int8OptConfig() : observers_{}, indicators_{} {}
+  // the observers of the calling thread.
+  std::vector<Observer>& thread_observers();
+
+  std::vector<Observer> merge_observers();
+
+  Int8OptConfig() : observer_shards_{}, indicators_{} {}
   ~Int8OptConfig() = default;
   Int8OptConfig(const Int8OptConfig&) = default;
   Int8OptConfig& operator=(const Int8OptConfig&) = default;
 
  private:
-  std::vector<Observer> observers_;
+  // the observers collected by each calibrating thread, e.g. by each stream of
+  // ipex.cpu.runtime.MultiStreamModule, which are merged by add_indicators.
+  std::vector<std::shared_ptr<std::vector<Observer>>> observer_shards_;
+  std::atomic<int64_t> observer_shards_generation_{0};
+  std::mutex observer_shards_mutex_;
   std::vector<Indicator> indicators_;
   std::unordered_map<int64_t, std::vector<at::Tensor>> weights_scales_;
   thread_local static int64_t current_ops_id;
+  thread_local static int64_t current_calibration_generation;
+  static std::atomic<int64_t> calibration_generation;
 };
 
 } // namespace torch_ipex
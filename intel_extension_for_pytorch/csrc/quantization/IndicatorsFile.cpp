@@ -0,0 +1,291 @@
+#include "IndicatorsFile.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+#include "Config.hpp"
+
+namespace torch_ipex {
+namespace int8 {
+
+namespace {
+
+constexpr char kMagic[8] = "IPEXIND";
+constexpr int64_t kVersion = 1;
+constexpr size_t kAlignment = sizeof(int64_t);
+
+size_t align_size(size_t size) {
+  return (size + kAlignment - 1) / kAlignment * kAlignment;
+}
+
+class IndicatorsWriter {
+ public:
+  explicit IndicatorsWriter(const std::string& file_name)
+      : stream_(file_name, std::ios::binary | std::ios::trunc) {
+    TORCH_CHECK(stream_.good(), "Can not open ", file_name, " to write");
+  }
+
+  void write_bytes(const void* data, size_t size) {
+    static const char padding[kAlignment] = {};
+    stream_.write(static_cast<const char*>(data), size);
+    stream_.write(padding, align_size(size) - size);
+  }
+
+  void write_int(int64_t value) {
+    write_bytes(&value, sizeof(value));
+  }
+
+  void write_string(const std::string& value) {
+    write_int(value.size());
+    write_bytes(value.data(), value.size());
+  }
+
+  void write_strings(const std::vector<std::string>& values) {
+    write_int(values.size());
+    for (auto& value : values) {
+      write_string(value);
+    }
+  }
+
+  void write_bools(const std::vector<bool>& values) {
+    std::vector<uint8_t> bytes(values.begin(), values.end());
+    write_int(bytes.size());
+    write_bytes(bytes.data(), bytes.size());
+  }
+
+  void write_params(const std::vector<TensorQuantizationParams>& params) {
+    write_int(params.size());
+    for (auto& param : params) {
+      write_bytes(&param.scale, sizeof(param.scale));
+      write_int(param.zero_point);
+    }
+  }
+
+  void write_scales(const std::vector<float>& scales) {
+    std::vector<double> values(scales.begin(), scales.end());
+    write_int(values.size());
+    write_bytes(values.data(), values.size() * sizeof(double));
+  }
+
+  void close() {
+    stream_.close();
+    TORCH_CHECK(!stream_.fail(), "Failed to write the indicators file");
+  }
+
+ private:
+  std::ofstream stream_;
+};
+
+// The content of a file privately mapped into memory, which is unmapped when
+// the last tensor viewing it is released.
+struct MappedFile {
+  void* data = MAP_FAILED;
+  size_t size = 0;
+
+  explicit MappedFile(const std::string& file_name) {
+    int fd = open(file_name.c_str(), O_RDONLY);
+    TORCH_CHECK(fd >= 0, "Can not open ", file_name);
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+      size = st.st_size;
+      // private writable pages, so that the scales are never written back
+      data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    }
+    ::close(fd);
+    TORCH_CHECK(data != MAP_FAILED, "Can not map ", file_name);
+  }
+
+  ~MappedFile() {
+    munmap(data, size);
+  }
+};
+
+class IndicatorsReader {
+ public:
+  explicit IndicatorsReader(std::shared_ptr<MappedFile> file)
+      : file_(std::move(file)) {}
+
+  const char* read_bytes(size_t size) {
+    TORCH_CHECK(
+        offset_ + align_size(size) <= file_->size,
+        "The indicators file is truncated");
+    auto data = static_cast<const char*>(file_->data) + offset_;
+    offset_ += align_size(size);
+    return data;
+  }
+
+  int64_t read_int() {
+    int64_t value;
+    std::memcpy(&value, read_bytes(sizeof(value)), sizeof(value));
+    return value;
+  }
+
+  size_t read_size() {
+    auto size = read_int();
+    TORCH_CHECK(
+        size >= 0 && static_cast<size_t>(size) <= file_->size,
+        "The indicators file is corrupted");
+    return size;
+  }
+
+  std::string read_string() {
+    auto size = read_size();
+    return std::string(read_bytes(size), size);
+  }
+
+  std::vector<std::string> read_strings() {
+    std::vector<std::string> values(read_size());
+    for (auto& value : values) {
+      value = read_string();
+    }
+    return values;
+  }
+
+  std::vector<bool> read_bools() {
+    auto size = read_size();
+    auto bytes = reinterpret_cast<const uint8_t*>(read_bytes(size));
+    return std::vector<bool>(bytes, bytes + size);
+  }
+
+  std::vector<TensorQuantizationParams> read_params() {
+    std::vector<TensorQuantizationParams> params(read_size());
+    for (auto& param : params) {
+      std::memcpy(
+          &param.scale, read_bytes(sizeof(param.scale)), sizeof(param.scale));
+      param.zero_point = read_int();
+    }
+    return params;
+  }
+
+  // The scales as a double tensor viewing the mapped file.
+  at::Tensor read_scales() {
+    auto size = read_size();
+    auto data = read_bytes(size * sizeof(double));
+    auto file = file_;
+    return at::from_blob(
+        const_cast<char*>(data),
+        {static_cast<int64_t>(size)},
+        [file](void*) {},
+        at::device(at::kCPU).dtype(at::kDouble));
+  }
+
+ private:
+  std::shared_ptr<MappedFile> file_;
+  size_t offset_ = 0;
+};
+
+} // namespace
+
+bool is_indicators_binary_file(const std::string& file_name) {
+  std::ifstream stream(file_name, std::ios::binary);
+  char magic[sizeof(kMagic)] = {};
+  stream.read(magic, sizeof(magic));
+  return stream.good() && std::memcmp(magic, kMagic, sizeof(kMagic)) == 0;
+}
+
+void save_indicators_binary_file(const std::string& file_name) {
+  auto indicators = Int8OptConfig::get_config().get_indicators();
+  IndicatorsWriter writer(file_name);
+  writer.write_bytes(kMagic, sizeof(kMagic));
+  writer.write_int(kVersion);
+  writer.write_int(indicators.size());
+  for (auto& indicator : indicators) {
+    writer.write_int(indicator.get_indicator_id());
+    writer.write_string(indicator.get_indicator_name());
+    writer.write_string(indicator.get_indicator_algorithm());
+    writer.write_string(indicator.get_indicator_weight_granularity());
+    std::vector<TensorQuantizationParams> x_params, y_params;
+    std::tie(x_params, y_params) = indicator.get_indicator_scales();
+    writer.write_params(x_params);
+    writer.write_params(y_params);
+    auto w_scales = indicator.get_indicator_weight_scales();
+    writer.write_int(w_scales.size());
+    for (auto& scales : w_scales) {
+      writer.write_scales(scales);
+    }
+    std::vector<std::string> i_quantized_dtypes, o_quantized_dtypes;
+    std::tie(i_quantized_dtypes, o_quantized_dtypes) =
+        indicator.get_indicator_quantized_dtypes();
+    writer.write_strings(i_quantized_dtypes);
+    writer.write_strings(o_quantized_dtypes);
+    std::vector<bool> inputs_quantized, outputs_quantized;
+    std::tie(inputs_quantized, outputs_quantized) =
+        indicator.get_indicator_insert_quantized_status();
+    writer.write_bools(inputs_quantized);
+    writer.write_bools(outputs_quantized);
+    std::vector<std::string> inputs_flow, outputs_flow;
+    std::tie(inputs_flow, outputs_flow) =
+        indicator.get_indicator_quantized_flow();
+    writer.write_strings(inputs_flow);
+    writer.write_strings(outputs_flow);
+  }
+  writer.close();
+}
+
+void load_indicators_binary_file(const std::string& file_name) {
+  IndicatorsReader reader(std::make_shared<MappedFile>(file_name));
+  TORCH_CHECK(
+      std::memcmp(reader.read_bytes(sizeof(kMagic)), kMagic, sizeof(kMagic)) ==
+          0,
+      file_name,
+      " is not a binary indicators file");
+  auto version = reader.read_int();
+  TORCH_CHECK(
+      version == kVersion,
+      "Unsupported version ",
+      version,
+      " of the binary indicators file");
+  std::vector<Indicator> indicators;
+  std::unordered_map<int64_t, std::vector<at::Tensor>> weights_scales;
+  auto num_indicators = reader.read_size();
+  indicators.reserve(num_indicators);
+  for (size_t i = 0; i < num_indicators; i++) {
+    auto id = reader.read_int();
+    auto op_name = reader.read_string();
+    auto algorithm = reader.read_string();
+    auto weight_granularity = reader.read_string();
+    auto x_params = reader.read_params();
+    auto y_params = reader.read_params();
+    std::vector<at::Tensor> w_scale_tensors(reader.read_size());
+    std::vector<std::vector<float>> w_scales;
+    for (auto& scales : w_scale_tensors) {
+      scales = reader.read_scales();
+      auto data = scales.data_ptr<double>();
+      w_scales.emplace_back(data, data + scales.numel());
+    }
+    auto i_quantized_dtypes = reader.read_strings();
+    auto o_quantized_dtypes = reader.read_strings();
+    auto inputs_quantized = reader.read_bools();
+    auto outputs_quantized = reader.read_bools();
+    auto inputs_flow = reader.read_strings();
+    auto outputs_flow = reader.read_strings();
+    if (weight_granularity == "per_channel") {
+      weights_scales.emplace(id, std::move(w_scale_tensors));
+    }
+    indicators.emplace_back(
+        id,
+        op_name,
+        algorithm,
+        weight_granularity,
+        x_params,
+        std::move(w_scales),
+        y_params,
+        i_quantized_dtypes,
+        o_quantized_dtypes,
+        inputs_quantized,
+        outputs_quantized,
+        inputs_flow,
+        outputs_flow);
+  }
+  Int8OptConfig::get_config().set_indicators(
+      std::move(indicators), std::move(weights_scales));
+}
+
+} // namespace int8
+} // namespace torch_ipex
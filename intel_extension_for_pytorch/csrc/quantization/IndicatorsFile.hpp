@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+
+namespace torch_ipex {
+namespace int8 {
+
+// The indicators of the int8 config can be saved in a compact binary file
+// rather than the json file, which is loaded in C++ without being parsed in
+// python. The file is mapped into memory on loading, and the per-channel
+// weight scales are kept as tensors viewing the mapped file.
+//
+// The file starts with the magic "IPEXIND", the version and the number of the
+// indicators, followed by the fields of each indicator. All the integers,
+// doubles and the sizes of the strings and the vectors are 8 bytes, and each
+// field is padded to 8 bytes, so that the weight scales are aligned doubles.
+
+// Returns whether the file starts with the magic of the binary indicators.
+bool is_indicators_binary_file(const std::string& file_name);
+
+// Save the indicators of the int8 config to a binary file.
+void save_indicators_binary_file(const std::string& file_name);
+
+// Load the indicators of the int8 config from a binary file.
+void load_indicators_binary_file(const std::string& file_name);
+
+} // namespace int8
+} // namespace torch_ipex
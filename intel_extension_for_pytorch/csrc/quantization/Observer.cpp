@@ -0,0 +1,185 @@
+#include "Observer.hpp"
+
+#include <ATen/Parallel.h>
+#include <ATen/cpu/vec/vec.h>
+
+#include <algorithm>
+#include <limits>
+
+namespace torch_ipex {
+namespace int8 {
+
+using namespace at::vec;
+using fVec = Vectorized<float>;
+
+namespace {
+
+// Load fVec::size() elements of a float or bfloat16 buffer as float.
+inline fVec load_float(const float* data) {
+  return fVec::loadu(data);
+}
+
+inline fVec load_float(const at::BFloat16* data) {
+  fVec data_fvec, unused;
+  std::tie(data_fvec, unused) = convert_bfloat16_float(
+      Vectorized<at::BFloat16>::loadu(data, fVec::size()));
+  return data_fvec;
+}
+
+template <typename scalar_t>
+void min_max_kernel(
+    const scalar_t* data,
+    int64_t size,
+    float& min_value,
+    float& max_value) {
+  fVec min_fvec(std::numeric_limits<float>::infinity());
+  fVec max_fvec(-std::numeric_limits<float>::infinity());
+  int64_t d = 0;
+  for (; d < size - (size % fVec::size()); d += fVec::size()) {
+    auto data_fvec = load_float(data + d);
+    min_fvec = minimum(min_fvec, data_fvec);
+    max_fvec = maximum(max_fvec, data_fvec);
+  }
+  float min_values[fVec::size()], max_values[fVec::size()];
+  min_fvec.store(min_values);
+  max_fvec.store(max_values);
+  for (auto i = 0; i < fVec::size(); i++) {
+    min_value = std::min(min_value, min_values[i]);
+    max_value = std::max(max_value, max_values[i]);
+  }
+  for (; d < size; d++) {
+    min_value = std::min(min_value, float(data[d]));
+    max_value = std::max(max_value, float(data[d]));
+  }
+}
+
+template <typename scalar_t>
+std::vector<float> compute_min_max_kernel(const at::Tensor& tensor) {
+  const scalar_t* data = tensor.data_ptr<scalar_t>();
+  // the min/max of the chunks of each thread
+  std::vector<float> min_values(
+      at::get_num_threads(), std::numeric_limits<float>::infinity());
+  std::vector<float> max_values(
+      at::get_num_threads(), -std::numeric_limits<float>::infinity());
+  at::parallel_for(0, tensor.numel(), 2048, [&](int64_t begin, int64_t end) {
+    auto tid = at::get_thread_num();
+    min_max_kernel<scalar_t>(
+        data + begin, end - begin, min_values[tid], max_values[tid]);
+  });
+  return {
+      *std::min_element(min_values.begin(), min_values.end()),
+      *std::max_element(max_values.begin(), max_values.end())};
+}
+
+template <typename scalar_t>
+std::vector<std::vector<float>> compute_min_max_per_channel_kernel(
+    const at::Tensor& weight) {
+  const scalar_t* data = weight.data_ptr<scalar_t>();
+  const int64_t channels = weight.size(0);
+  const int64_t channel_size = weight.numel() / channels;
+  std::vector<std::vector<float>> min_max_values(
+      channels,
+      {std::numeric_limits<float>::infinity(),
+       -std::numeric_limits<float>::infinity()});
+  at::parallel_for(0, channels, 1, [&](int64_t begin, int64_t end) {
+    for (auto c = begin; c < end; c++) {
+      min_max_kernel<scalar_t>(
+          data + c * channel_size,
+          channel_size,
+          min_max_values[c][0],
+          min_max_values[c][1]);
+    }
+  });
+  return min_max_values;
+}
+
+template <typename scalar_t>
+void accumulate_histogram_kernel(
+    const at::Tensor& tensor,
+    float range,
+    std::vector<float>& bins) {
+  const scalar_t* data = tensor.data_ptr<scalar_t>();
+  const int64_t num_bins = bins.size();
+  const float bins_per_value = num_bins / range;
+  // the bins of the chunks of each thread
+  std::vector<std::vector<float>> thread_bins(at::get_num_threads());
+  at::parallel_for(0, tensor.numel(), 2048, [&](int64_t begin, int64_t end) {
+    auto& local_bins = thread_bins[at::get_thread_num()];
+    local_bins.resize(num_bins, 0.f);
+    const scalar_t* ptr = data + begin;
+    const int64_t size = end - begin;
+    const fVec scale_fvec(bins_per_value);
+    const fVec last_fvec(num_bins - 1);
+    float indices[fVec::size()];
+    int64_t d = 0;
+    for (; d < size - (size % fVec::size()); d += fVec::size()) {
+      auto index_fvec =
+          minimum(load_float(ptr + d).abs() * scale_fvec, last_fvec);
+      index_fvec.store(indices);
+      for (auto i = 0; i < fVec::size(); i++) {
+        local_bins[static_cast<int64_t>(indices[i])] += 1;
+      }
+    }
+    for (; d < size; d++) {
+      auto index = std::min(
+          std::abs(float(ptr[d])) * bins_per_value,
+          static_cast<float>(num_bins - 1));
+      local_bins[static_cast<int64_t>(index)] += 1;
+    }
+  });
+  for (const auto& local_bins : thread_bins) {
+    for (auto i = 0; i < local_bins.size(); i++) {
+      bins[i] += local_bins[i];
+    }
+  }
+}
+
+} // namespace
+
+std::vector<float> compute_min_max(const at::Tensor& tensor) {
+  auto input = tensor.detach().contiguous();
+  if (input.numel() == 0) {
+    return {0.f, 0.f};
+  }
+  if (input.scalar_type() == at::kFloat) {
+    return compute_min_max_kernel<float>(input);
+  } else if (input.scalar_type() == at::kBFloat16) {
+    return compute_min_max_kernel<at::BFloat16>(input);
+  }
+  return {input.min().item<float>(), input.max().item<float>()};
+}
+
+std::vector<std::vector<float>> compute_min_max_per_channel(
+    const at::Tensor& weight) {
+  auto input = weight.detach().contiguous();
+  if (input.numel() > 0 && input.scalar_type() == at::kFloat) {
+    return compute_min_max_per_channel_kernel<float>(input);
+  } else if (input.numel() > 0 && input.scalar_type() == at::kBFloat16) {
+    return compute_min_max_per_channel_kernel<at::BFloat16>(input);
+  }
+  std::vector<std::vector<float>> min_max_values;
+  for (int l = 0; l < input.size(0); l++) {
+    min_max_values.push_back(
+        {input[l].min().item<float>(), input[l].max().item<float>()});
+  }
+  return min_max_values;
+}
+
+void accumulate_histogram(
+    const at::Tensor& tensor,
+    float range,
+    std::vector<float>& bins) {
+  auto input = tensor.detach().contiguous();
+  if (range == 0) {
+    bins[0] += input.numel();
+    return;
+  }
+  if (input.scalar_type() == at::kBFloat16) {
+    accumulate_histogram_kernel<at::BFloat16>(input, range, bins);
+  } else {
+    accumulate_histogram_kernel<float>(input.to(at::kFloat), range, bins);
+  }
+}
+
+} // namespace int8
+} // namespace torch_ipex
@@ -7,6 +7,13 @@ namespace int8 {
 
 using namespace quant_utils;
 
+// The histogram of the absolute values of the tensors observed by a
+// histogram based method, of which the bins evenly divide [0, range].
+struct Histogram {
+  float range = 0;
+  std::vector<float> bins;
+};
+
 struct Observer {
   int64_t id;
   std::string name;
@@ -15,10 +22,12 @@ struct Observer {
       weights_min_max_values; // per_channel or per_tensor
   std::vector<std::vector<float>> outputs_min_max_values;
   // default uising min/max to compute the quantization parameters,
-  // only support min_max, MovingAverageMinMax and other none per_channel
-  // merthod
+  // support min_max, MovingAverageMinMax and the histogram based percentile,
+  // kl_divergence and mse methods, which clip the min/max of the activations
+  // by a threshold chosen from the histograms of their absolute values.
   std::string algorithm = "min_max";
   float averaging_constant = 0.01; // for MovingAverage method
+  float percentile = 99.99; // for percentile method
   // only useful for conv, onednn only support per_channel foo conv's weight,
   // default is per_channel
   std::string weight_granularity = "per_channel";
@@ -30,8 +39,26 @@ struct Observer {
   std::vector<bool> outputs_quantized;
   std::vector<std::string> inputs_flow;
   std::vector<std::string> outputs_flow;
+  // only used by the histogram based methods.
+  std::vector<Histogram> inputs_histograms;
+  std::vector<Histogram> outputs_histograms;
 };
 
+// The min/max of a tensor, computed in one vectorized pass.
+std::vector<float> compute_min_max(const at::Tensor& tensor);
+
+// The min/max of each output channel, i.e. of each slice along the first dim,
+// of a weight, computed in one vectorized pass.
+std::vector<std::vector<float>> compute_min_max_per_channel(
+    const at::Tensor& weight);
+
+// Accumulate the absolute values of a tensor, which are not greater than
+// range, into the bins which evenly divide [0, range].
+void accumulate_histogram(
+    const at::Tensor& tensor,
+    float range,
+    std::vector<float>& bins);
+
 class Indicator {
  public:
   Indicator(
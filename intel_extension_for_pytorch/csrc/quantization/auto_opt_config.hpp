@@ -17,6 +17,70 @@ class AutoOptConfig {
     return jit_fuse_;
   }
 
+  inline void set_jit_branch_parallel(bool jit_branch_parallel) {
+    jit_branch_parallel_ = jit_branch_parallel;
+  }
+
+  inline bool get_jit_branch_parallel() {
+    return jit_branch_parallel_;
+  }
+
+  inline void set_jit_memory_plan(bool jit_memory_plan) {
+    jit_memory_plan_ = jit_memory_plan;
+  }
+
+  inline bool get_jit_memory_plan() {
+    return jit_memory_plan_;
+  }
+
+  inline void set_conv_algorithm_selection(bool conv_algorithm_selection) {
+    conv_algorithm_selection_ = conv_algorithm_selection;
+  }
+
+  inline bool get_conv_algorithm_selection() {
+    return conv_algorithm_selection_;
+  }
+
+  inline void set_sparse_linear(bool sparse_linear) {
+    sparse_linear_ = sparse_linear;
+  }
+
+  inline bool get_sparse_linear() {
+    return sparse_linear_;
+  }
+
+  inline void set_jit_weight_only_quantization(
+      bool jit_weight_only_quantization) {
+    jit_weight_only_quantization_ = jit_weight_only_quantization;
+  }
+
+  inline bool get_jit_weight_only_quantization() {
+    return jit_weight_only_quantization_;
+  }
+
+  inline void set_jit_weight_only_quantization_dtype(
+      const std::string& dtype,
+      int64_t group_size) {
+    jit_weight_only_quantization_dtype_ = dtype;
+    jit_weight_only_quantization_group_size_ = group_size;
+  }
+
+  inline std::string get_jit_weight_only_quantization_dtype() {
+    return jit_weight_only_quantization_dtype_;
+  }
+
+  inline int64_t get_jit_weight_only_quantization_group_size() {
+    return jit_weight_only_quantization_group_size_;
+  }
+
+  inline void set_jit_dynamic_quantization(bool jit_dynamic_quantization) {
+    jit_dynamic_quantization_ = jit_dynamic_quantization;
+  }
+
+  inline bool get_jit_dynamic_quantization() {
+    return jit_dynamic_quantization_;
+  }
+
   // int8
   inline void set_int8_calibration(bool value) {
     calibration_step_ = value;
@@ -48,21 +112,60 @@ class AutoOptConfig {
   inline at::QScheme get_int8_qscheme() {
     return qscheme_;
   }
+  inline void set_int8_observer_algorithm(const std::string& algorithm) {
+    observer_algorithm_ = algorithm;
+  }
+  inline std::string get_int8_observer_algorithm() {
+    return observer_algorithm_;
+  }
 
  private:
   AutoOptConfig()
       : jit_fuse_(true),
+        jit_branch_parallel_(false),
+        jit_memory_plan_(false),
+        conv_algorithm_selection_(false),
+        sparse_linear_(true),
+        jit_weight_only_quantization_(false),
+        jit_weight_only_quantization_dtype_("int8"),
+        jit_weight_only_quantization_group_size_(128),
+        jit_dynamic_quantization_(false),
         calibration_step_(false),
-        qscheme_(at::QScheme::PER_TENSOR_AFFINE) {}
+        qscheme_(at::QScheme::PER_TENSOR_AFFINE),
+        observer_algorithm_("min_max") {}
 
   ~AutoOptConfig() = default;
   AutoOptConfig(const AutoOptConfig&) = default;
   AutoOptConfig& operator=(const AutoOptConfig&) = default;
 
   bool jit_fuse_;
+  // run the independent branches of the fused graph concurrently.
+  bool jit_branch_parallel_;
+  // place the intermediate tensors of the fused graph in a planned arena.
+  bool jit_memory_plan_;
+  // time the winograd algorithm against the direct one of the prepacked 3x3
+  // convolutions, and keep the faster.
+  bool conv_algorithm_selection_;
+  // prepack the fp32 linear weights of enough zero blocks, e.g. of the pruned
+  // models, into the block-sparse format of SparseLinear.h.
+  bool sparse_linear_;
+  // quantize the constant linear weights to int8 while keeping the
+  // activations in fp32/bf16.
+  bool jit_weight_only_quantization_;
+  // the dtype of the weight-only quantized weights, int8 of one scale per
+  // output channel, or the 4-bit int4 / nf4 of one scale per group of
+  // group_size input features.
+  std::string jit_weight_only_quantization_dtype_;
+  int64_t jit_weight_only_quantization_group_size_;
+  // quantize the constant linear weights to int8, and the activations to u8
+  // with their ranges computed on each call.
+  bool jit_dynamic_quantization_;
   // the flag for one iteration of calibration step whether end or not.
   bool calibration_step_;
   at::QScheme qscheme_;
+  // the observer of the activations of the ops of which the algorithm is not
+  // set by a loaded configure.
+  std::string observer_algorithm_;
 };
 
 } // namespace torch_ipex
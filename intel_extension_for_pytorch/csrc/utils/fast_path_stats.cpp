@@ -0,0 +1,102 @@
+#include "fast_path_stats.h"
+
+#include <map>
+#include <mutex>
+
+namespace torch_ipex {
+namespace fast_path {
+
+namespace {
+
+struct DynamicCounter {
+  int64_t hits = 0;
+  std::map<std::string, int64_t> fallbacks;
+};
+
+// the counters of the kernels are defined at the namespace scope, of which
+// the registration may precede any other static initialization
+struct Registry {
+  std::mutex mutex;
+  std::vector<FastPathCounter*> counters;
+  std::map<std::string, DynamicCounter> dynamic_counters;
+};
+
+Registry& get_registry() {
+  static Registry registry;
+  return registry;
+}
+
+} // namespace
+
+FastPathCounter::FastPathCounter(
+    const char* name,
+    std::initializer_list<const char*> reasons)
+    : name_(name),
+      reasons_(reasons),
+      fallbacks_(new std::atomic<int64_t>[reasons.size()]) {
+  for (size_t i = 0; i < reasons_.size(); i++) {
+    fallbacks_[i].store(0, std::memory_order_relaxed);
+  }
+  auto& registry = get_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.counters.push_back(this);
+}
+
+void FastPathCounter::reset() {
+  hits_.store(0, std::memory_order_relaxed);
+  for (size_t i = 0; i < reasons_.size(); i++) {
+    fallbacks_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void count_fast_path(const std::string& name, const std::string& reason) {
+  auto& registry = get_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto& counter = registry.dynamic_counters[name];
+  if (reason.empty()) {
+    counter.hits++;
+  } else {
+    counter.fallbacks[reason]++;
+  }
+}
+
+std::vector<FastPathStats> get_fast_path_stats() {
+  std::map<std::string, FastPathStats> merged;
+  auto& registry = get_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (auto counter : registry.counters) {
+    auto& stats = merged[counter->name()];
+    stats.hits += counter->hits();
+    for (size_t i = 0; i < counter->reasons().size(); i++) {
+      auto fallbacks = counter->fallbacks(i);
+      if (fallbacks > 0) {
+        stats.fallbacks.emplace_back(counter->reasons()[i], fallbacks);
+      }
+    }
+  }
+  for (auto& item : registry.dynamic_counters) {
+    auto& stats = merged[item.first];
+    stats.hits += item.second.hits;
+    for (auto& fallback : item.second.fallbacks) {
+      stats.fallbacks.emplace_back(fallback.first, fallback.second);
+    }
+  }
+  std::vector<FastPathStats> all_stats;
+  for (auto& item : merged) {
+    item.second.name = item.first;
+    all_stats.push_back(std::move(item.second));
+  }
+  return all_stats;
+}
+
+void reset_fast_path_stats() {
+  auto& registry = get_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (auto counter : registry.counters) {
+    counter->reset();
+  }
+  registry.dynamic_counters.clear();
+}
+
+} // namespace fast_path
+} // namespace torch_ipex
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <initializer_list>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// The registry of the counters of the fast paths of the kernels, of which
+// each counts the calls taking the fast path and the calls falling back to
+// the ATen or the generic path by the reason of falling back, so that the
+// regressions of the missed fast paths can be told from the stats.
+//
+// A kernel defines a counter at the namespace scope along with the enum of
+// its reasons, of which the names are in the same order:
+//
+//   enum CumsumFallback { kNotContiguous, kScalar, ... };
+//   static FastPathCounter cumsum_counter(
+//       "cumsum", {"not_contiguous", "scalar", ...});
+//
+// and counts each call by cumsum_counter.hit() or
+// cumsum_counter.fallback(kNotContiguous), which return whether the fast path
+// is taken, or by cumsum_counter.check() of all the conditions. The counts are
+// relaxed atomic adds, which are always on.
+
+namespace torch_ipex {
+namespace fast_path {
+
+class FastPathCounter {
+ public:
+  // name and reasons are static strings
+  FastPathCounter(const char* name, std::initializer_list<const char*> reasons);
+
+  // returns true, i.e. return counter.hit() from the check of the fast path
+  bool hit() {
+    hits_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // returns false, i.e. return counter.fallback(reason)
+  bool fallback(int reason) {
+    fallbacks_[reason].fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  // counts the fast path of the conditions, which are in the order of the
+  // reasons, i.e. the failed condition i falls back by the reason i
+  bool check(std::initializer_list<bool> conditions) {
+    int reason = 0;
+    for (bool condition : conditions) {
+      if (!condition) {
+        return fallback(reason);
+      }
+      reason++;
+    }
+    return hit();
+  }
+
+  const char* name() const {
+    return name_;
+  }
+
+  int64_t hits() const {
+    return hits_.load(std::memory_order_relaxed);
+  }
+
+  const std::vector<const char*>& reasons() const {
+    return reasons_;
+  }
+
+  int64_t fallbacks(int reason) const {
+    return fallbacks_[reason].load(std::memory_order_relaxed);
+  }
+
+  void reset();
+
+ private:
+  FastPathCounter(const FastPathCounter&) = delete;
+  FastPathCounter& operator=(const FastPathCounter&) = delete;
+
+  const char* name_;
+  std::vector<const char*> reasons_;
+  std::atomic<int64_t> hits_{0};
+  std::unique_ptr<std::atomic<int64_t>[]> fallbacks_;
+};
+
+struct FastPathStats {
+  std::string name;
+  int64_t hits = 0;
+  // the calls of each reason, of the ones counted at least once
+  std::vector<std::pair<std::string, int64_t>> fallbacks;
+};
+
+// Counts a call of the fast path of name by the reason of its fallback, or
+// of the fast path itself if reason is empty. It is of the fast paths
+// decided out of the kernels, e.g. by the frontend, of which the counters
+// are created on the first call and looked up by a lock.
+void count_fast_path(const std::string& name, const std::string& reason);
+
+// The stats of all the fast paths, ordered by name.
+std::vector<FastPathStats> get_fast_path_stats();
+
+void reset_fast_path_stats();
+
+} // namespace fast_path
+} // namespace torch_ipex
@@ -0,0 +1,102 @@
+#include "huge_pages.h"
+
+#include <ATen/ATen.h>
+#include <c10/core/CPUAllocator.h>
+
+#include <sys/mman.h>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+namespace torch_ipex {
+namespace huge_pages {
+
+namespace {
+
+bool enabled_by_env() {
+  const char* env = std::getenv("IPEX_HUGE_PAGES");
+  return env != nullptr && std::string(env) != "0";
+}
+
+std::atomic<bool> enabled{enabled_by_env()};
+
+bool read_available() {
+  // e.g. "always [madvise] never" of the selected mode
+  std::ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+  std::string modes;
+  if (!std::getline(file, modes)) {
+    return false;
+  }
+  return modes.find("[never]") == std::string::npos;
+}
+
+void free_huge_pages(void* data) {
+  c10::free_cpu(data);
+}
+
+} // namespace
+
+void set_enabled(bool value) {
+  enabled.store(value, std::memory_order_relaxed);
+}
+
+bool is_enabled() {
+  return enabled.load(std::memory_order_relaxed);
+}
+
+bool is_available() {
+  static const bool available = read_available();
+  return available;
+}
+
+bool is_placed(size_t nbytes) {
+  return nbytes >= kHugePageSize &&
+      enabled.load(std::memory_order_relaxed) && is_available();
+}
+
+void* alloc_cpu(size_t nbytes) {
+  if (!is_placed(nbytes)) {
+    return c10::alloc_cpu(nbytes);
+  }
+  // the whole huge pages, so that no other allocation shares them
+  size_t size = (nbytes + kHugePageSize - 1) / kHugePageSize * kHugePageSize;
+  void* data = nullptr;
+  if (posix_memalign(&data, kHugePageSize, size) != 0) {
+    return c10::alloc_cpu(nbytes);
+  }
+  // the advice is best effort, the memory is usable on the 4 KB pages if it
+  // fails
+  madvise(data, size, MADV_HUGEPAGE);
+  return data;
+}
+
+c10::DataPtr allocate(size_t nbytes) {
+  void* data = alloc_cpu(nbytes);
+  return {data, data, &free_huge_pages, c10::Device(c10::kCPU)};
+}
+
+at::Tensor empty(at::IntArrayRef sizes, const at::TensorOptions& options) {
+  size_t nbytes = options.dtype().itemsize();
+  for (auto size : sizes) {
+    nbytes *= size;
+  }
+  if (!is_placed(nbytes)) {
+    return at::empty(sizes, options);
+  }
+  return at::from_blob(alloc_cpu(nbytes), sizes, &free_huge_pages, options);
+}
+
+at::Tensor to_huge_pages(const at::Tensor& tensor) {
+  if (!tensor.device().is_cpu() || tensor.layout() != at::kStrided ||
+      !tensor.is_contiguous() || !is_placed(tensor.nbytes())) {
+    return tensor;
+  }
+  auto result = empty(tensor.sizes(), tensor.options());
+  // copied in parallel, so that the pages are first touched by the threads
+  result.copy_(tensor);
+  return result;
+}
+
+} // namespace huge_pages
+} // namespace torch_ipex
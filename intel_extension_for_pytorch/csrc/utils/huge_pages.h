@@ -0,0 +1,51 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+#include <c10/core/Allocator.h>
+
+#include <cstddef>
+
+// The placement of the large, long-lived buffers of IPEX on the transparent
+// huge pages, i.e. the packed weights, the embedding tables and the arenas
+// of the activations, of which the random accesses and the weight streams
+// of the GEMMs would otherwise miss the TLB on every 4 KB page. It is off by
+// default, and is enabled by IPEX_HUGE_PAGES=1, e.g. of
+// `ipex.cpu.launch --enable_huge_pages`, or by set_enabled. The buffers of
+// kHugePageSize at least are aligned to it and advised of MADV_HUGEPAGE, so
+// that their first touch faults in the huge pages. It falls back to the
+// default CPU allocator if the transparent huge pages are disabled by the
+// system.
+
+namespace torch_ipex {
+namespace huge_pages {
+
+constexpr size_t kHugePageSize = 2 << 20;
+
+void set_enabled(bool enabled);
+
+bool is_enabled();
+
+// Whether the transparent huge pages of the system can be advised, i.e.
+// /sys/kernel/mm/transparent_hugepage/enabled is "always" or "madvise".
+bool is_available();
+
+// Whether a buffer of nbytes is placed on the huge pages, i.e. they are
+// enabled and available, and nbytes is kHugePageSize at least.
+bool is_placed(size_t nbytes);
+
+// The memory of nbytes, which is on the huge pages if is_placed(nbytes), and
+// is freed by c10::free_cpu.
+void* alloc_cpu(size_t nbytes);
+
+// The DataPtr of the memory of alloc_cpu.
+c10::DataPtr allocate(size_t nbytes);
+
+// The empty contiguous CPU tensor of the memory of alloc_cpu.
+at::Tensor empty(at::IntArrayRef sizes, const at::TensorOptions& options);
+
+// The copy of the contiguous CPU tensor on the huge pages, or tensor itself
+// if it would not be placed on them.
+at::Tensor to_huge_pages(const at::Tensor& tensor);
+
+} // namespace huge_pages
+} // namespace torch_ipex
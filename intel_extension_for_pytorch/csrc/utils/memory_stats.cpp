@@ -0,0 +1,173 @@
+#include "memory_stats.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace torch_ipex {
+namespace memory_stats {
+
+namespace {
+
+// the accounts of the caches are defined at the namespace scope, of which
+// the registration may precede any other static initialization
+struct Registry {
+  std::mutex mutex;
+  std::vector<CacheAccount*> accounts;
+};
+
+Registry& get_registry() {
+  static Registry registry;
+  return registry;
+}
+
+// constant initialized, so they are usable by the static initialization
+std::atomic<int64_t> total_bytes{0};
+std::atomic<int64_t> peak_total_bytes{0};
+std::atomic<int64_t> budget_bytes{-1};
+
+// serializes the evictions, of which the caches growing at once by many
+// threads need only one at a time
+std::mutex eviction_mutex;
+
+void update_peak(std::atomic<int64_t>& peak, int64_t value) {
+  auto current = peak.load(std::memory_order_relaxed);
+  while (value > current &&
+         !peak.compare_exchange_weak(
+             current, value, std::memory_order_relaxed)) {
+  }
+}
+
+} // namespace
+
+CacheAccount::CacheAccount(
+    const char* name,
+    int eviction_order,
+    Evictor evictor)
+    : name_(name),
+      eviction_order_(eviction_order),
+      evictor_(std::move(evictor)) {
+  auto& registry = get_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  registry.accounts.push_back(this);
+}
+
+void CacheAccount::update(int64_t bytes, int64_t entries) {
+  if (entries != 0) {
+    entries_.fetch_add(entries, std::memory_order_relaxed);
+  }
+  if (bytes == 0) {
+    return;
+  }
+  auto cache_bytes = bytes_.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+  auto all_bytes = total_bytes.fetch_add(bytes, std::memory_order_relaxed) +
+      bytes;
+  if (bytes > 0) {
+    update_peak(peak_bytes_, cache_bytes);
+    update_peak(peak_total_bytes, all_bytes);
+  }
+}
+
+int64_t CacheAccount::evict(int64_t bytes) {
+  if (!evictor_ || bytes <= 0) {
+    return 0;
+  }
+  auto freed = evictor_(bytes);
+  evicted_bytes_.fetch_add(freed, std::memory_order_relaxed);
+  return freed;
+}
+
+MemoryStats get_memory_stats() {
+  MemoryStats stats;
+  stats.bytes = total_bytes.load(std::memory_order_relaxed);
+  stats.peak_bytes = peak_total_bytes.load(std::memory_order_relaxed);
+  stats.budget_bytes = get_memory_budget();
+  auto& registry = get_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (auto account : registry.accounts) {
+    CacheMemoryStats cache;
+    cache.name = account->name();
+    cache.bytes = account->bytes();
+    cache.entries = account->entries();
+    cache.peak_bytes = account->peak_bytes();
+    cache.evicted_bytes = account->evicted_bytes();
+    cache.evictable = account->evictable();
+    stats.caches.push_back(std::move(cache));
+  }
+  std::sort(
+      stats.caches.begin(),
+      stats.caches.end(),
+      [](const CacheMemoryStats& a, const CacheMemoryStats& b) {
+        return a.name < b.name;
+      });
+  return stats;
+}
+
+void reset_peak_memory_stats() {
+  auto& registry = get_registry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (auto account : registry.accounts) {
+    account->reset_peak();
+  }
+  peak_total_bytes.store(
+      total_bytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void set_memory_budget(int64_t bytes) {
+  budget_bytes.store(bytes < 0 ? -1 : bytes, std::memory_order_relaxed);
+  enforce_memory_budget();
+}
+
+int64_t get_memory_budget() {
+  return budget_bytes.load(std::memory_order_relaxed);
+}
+
+void enforce_memory_budget() {
+  auto budget = get_memory_budget();
+  if (budget < 0 || total_bytes.load(std::memory_order_relaxed) <= budget) {
+    return;
+  }
+  // an evictor may grow another cache, e.g. by freeing the buffers of a
+  // pool, which must not evict again within the eviction
+  static thread_local bool evicting = false;
+  if (evicting) {
+    return;
+  }
+  std::unique_lock<std::mutex> eviction_lock(eviction_mutex, std::try_to_lock);
+  if (!eviction_lock.owns_lock()) {
+    return;
+  }
+  struct EvictingGuard {
+    EvictingGuard() {
+      evicting = true;
+    }
+    ~EvictingGuard() {
+      evicting = false;
+    }
+  } evicting_guard;
+  std::vector<CacheAccount*> accounts;
+  {
+    auto& registry = get_registry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto account : registry.accounts) {
+      if (account->evictable()) {
+        accounts.push_back(account);
+      }
+    }
+  }
+  std::stable_sort(
+      accounts.begin(),
+      accounts.end(),
+      [](const CacheAccount* a, const CacheAccount* b) {
+        return a->eviction_order() < b->eviction_order();
+      });
+  for (auto account : accounts) {
+    auto excess = total_bytes.load(std::memory_order_relaxed) - budget;
+    if (excess <= 0) {
+      break;
+    }
+    account->evict(excess);
+  }
+}
+
+} // namespace memory_stats
+} // namespace torch_ipex
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// The accounting of the memory held by the caches of IPEX, e.g. the packed
+// weights, the casts of autocast, the primitive descs of ideep and the
+// compiled partitions of LLGA, each of which may grow with the shapes and the
+// threads of a long-running process. Each cache defines an account at the
+// namespace scope, and updates it by the bytes and the entries it adds or
+// drops:
+//
+//   static CacheAccount casts_account("autocast_casts", 1, evict_casts);
+//   casts_account.update(tensor.nbytes(), 1);
+//
+// If a memory budget is set, the caches growing beyond it call
+// enforce_memory_budget() out of their locks, which evicts the caches of an
+// evictor in their eviction order until the total is within the budget.
+
+namespace torch_ipex {
+namespace memory_stats {
+
+// Evicts at least bytes of the cache if it can, and returns the bytes freed.
+// It is called without any lock of the accounting held.
+using Evictor = std::function<int64_t(int64_t bytes)>;
+
+class CacheAccount {
+ public:
+  // name is a static string. The caches of the lower eviction_order are
+  // evicted first, e.g. the ones the cheapest to refill, and the ones without
+  // an evictor are only accounted.
+  CacheAccount(
+      const char* name,
+      int eviction_order = 0,
+      Evictor evictor = nullptr);
+
+  // the bytes and the entries added to the cache, negative if dropped
+  void update(int64_t bytes, int64_t entries);
+
+  const char* name() const {
+    return name_;
+  }
+
+  int eviction_order() const {
+    return eviction_order_;
+  }
+
+  bool evictable() const {
+    return static_cast<bool>(evictor_);
+  }
+
+  int64_t bytes() const {
+    return bytes_.load(std::memory_order_relaxed);
+  }
+
+  int64_t entries() const {
+    return entries_.load(std::memory_order_relaxed);
+  }
+
+  int64_t peak_bytes() const {
+    return peak_bytes_.load(std::memory_order_relaxed);
+  }
+
+  int64_t evicted_bytes() const {
+    return evicted_bytes_.load(std::memory_order_relaxed);
+  }
+
+  // evicts at least bytes by the evictor, returns the bytes freed
+  int64_t evict(int64_t bytes);
+
+  void reset_peak() {
+    peak_bytes_.store(bytes(), std::memory_order_relaxed);
+  }
+
+ private:
+  CacheAccount(const CacheAccount&) = delete;
+  CacheAccount& operator=(const CacheAccount&) = delete;
+
+  const char* name_;
+  int eviction_order_;
+  Evictor evictor_;
+  std::atomic<int64_t> bytes_{0};
+  std::atomic<int64_t> entries_{0};
+  std::atomic<int64_t> peak_bytes_{0};
+  // the bytes freed by the memory budget
+  std::atomic<int64_t> evicted_bytes_{0};
+};
+
+struct CacheMemoryStats {
+  std::string name;
+  int64_t bytes = 0;
+  int64_t entries = 0;
+  int64_t peak_bytes = 0;
+  int64_t evicted_bytes = 0;
+  bool evictable = false;
+};
+
+struct MemoryStats {
+  // the bytes of all the caches, and their high-water mark
+  int64_t bytes = 0;
+  int64_t peak_bytes = 0;
+  // -1 if unlimited
+  int64_t budget_bytes = -1;
+  // ordered by name
+  std::vector<CacheMemoryStats> caches;
+};
+
+MemoryStats get_memory_stats();
+
+// resets the high-water marks to the current bytes
+void reset_peak_memory_stats();
+
+// Sets the budget of the bytes of all the caches, -1 means unlimited. The
+// caches are evicted to the budget at once if they exceed it.
+void set_memory_budget(int64_t bytes);
+
+int64_t get_memory_budget();
+
+// Evicts the caches until the bytes of all of them are within the budget.
+// It is called by the caches after they grow, out of their locks, and is a
+// relaxed load if there is no budget or the caches are within it.
+void enforce_memory_budget();
+
+} // namespace memory_stats
+} // namespace torch_ipex
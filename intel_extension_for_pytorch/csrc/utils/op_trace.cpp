@@ -0,0 +1,250 @@
+#include "op_trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <unordered_map>
+
+namespace torch_ipex {
+namespace op_trace {
+
+std::atomic<int64_t> sample_period_{0};
+std::atomic<bool> count_perf_{false};
+
+namespace {
+
+std::atomic<int64_t> buffer_size_{4096};
+
+// The records and the histograms of a thread. The mutex is only contended by
+// the readers of the trace, and only taken by the thread on a sampled call.
+struct ThreadBuffer {
+  std::mutex mutex;
+  std::vector<OpRecord> records;
+  // the next record to overwrite once the buffer is full
+  size_t next = 0;
+  std::unordered_map<std::string, OpStats> stats;
+};
+
+std::mutex registry_mutex;
+// the buffers outlive their threads, so that the records of the threads of a
+// finished parallel region are kept
+std::vector<std::shared_ptr<ThreadBuffer>> registry;
+
+ThreadBuffer& get_thread_buffer() {
+  static thread_local std::shared_ptr<ThreadBuffer> buffer = [] {
+    auto buffer = std::make_shared<ThreadBuffer>();
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    registry.push_back(buffer);
+    return buffer;
+  }();
+  return *buffer;
+}
+
+int histogram_bucket(int64_t duration_ns) {
+  int bucket = 0;
+  int64_t us = duration_ns / 1000;
+  while (us > 0 && bucket < kHistogramBuckets - 1) {
+    us >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+// the increments of the counters of which both are counted, -1 otherwise
+void add_counters(
+    perf_counters::Counts& to,
+    const perf_counters::Counts& from) {
+  for (int i = 0; i < perf_counters::kNumCounters; i++) {
+    to[i] = to[i] < 0 || from[i] < 0 ? -1 : to[i] + from[i];
+  }
+}
+
+void merge_stats(OpStats& to, const OpStats& from) {
+  if (to.count == 0) {
+    to.counters = from.counters;
+  } else {
+    add_counters(to.counters, from.counters);
+  }
+  to.min_ns = to.count == 0 ? from.min_ns : std::min(to.min_ns, from.min_ns);
+  to.max_ns = std::max(to.max_ns, from.max_ns);
+  to.count += from.count;
+  to.total_ns += from.total_ns;
+  for (int i = 0; i < kHistogramBuckets; i++) {
+    to.histogram[i] += from.histogram[i];
+  }
+}
+
+} // namespace
+
+bool enable(double sample_rate, int64_t buffer_size, bool perf) {
+  TORCH_CHECK(
+      sample_rate > 0 && sample_rate <= 1,
+      "The sample rate of the op trace must be in (0, 1]");
+  TORCH_CHECK(
+      buffer_size > 0, "The buffer size of the op trace must be positive");
+  clear();
+  bool counting = perf && perf_counters::open();
+  count_perf_.store(counting, std::memory_order_relaxed);
+  buffer_size_.store(buffer_size, std::memory_order_relaxed);
+  sample_period_.store(
+      std::max<int64_t>(1, std::llround(1 / sample_rate)),
+      std::memory_order_relaxed);
+  return counting || !perf;
+}
+
+void disable() {
+  sample_period_.store(0, std::memory_order_relaxed);
+  // the calls sampled before may still read the counters, which are closed
+  // under the lock of perf_counters
+  count_perf_.store(false, std::memory_order_relaxed);
+  perf_counters::close();
+}
+
+void clear() {
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  for (auto& buffer : registry) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    buffer->records.clear();
+    buffer->next = 0;
+    buffer->stats.clear();
+  }
+}
+
+std::vector<OpRecord> get_records() {
+  std::vector<OpRecord> records;
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  for (auto& buffer : registry) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    // the oldest record is the next one to overwrite
+    auto& thread_records = buffer->records;
+    records.insert(
+        records.end(),
+        thread_records.begin() + buffer->next,
+        thread_records.end());
+    records.insert(
+        records.end(),
+        thread_records.begin(),
+        thread_records.begin() + buffer->next);
+  }
+  return records;
+}
+
+std::vector<OpStats> get_stats() {
+  std::map<std::string, OpStats> merged;
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    for (auto& buffer : registry) {
+      std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+      for (auto& item : buffer->stats) {
+        auto& stats = merged[item.first];
+        stats.op = item.first;
+        merge_stats(stats, item.second);
+      }
+    }
+  }
+  std::vector<OpStats> stats;
+  for (auto& item : merged) {
+    stats.push_back(std::move(item.second));
+  }
+  return stats;
+}
+
+void OpTraceGuard::begin(const char* op) {
+  // of a xorshift of each thread rather than a counter of the calls, of which
+  // the sampled calls would alias with the calls of the ops of each iteration
+  static thread_local uint64_t state =
+      0x9E3779B97F4A7C15ull ^ reinterpret_cast<uintptr_t>(&state);
+  state ^= state << 13;
+  state ^= state >> 7;
+  state ^= state << 17;
+  int64_t period = sample_period_.load(std::memory_order_relaxed);
+  if (period == 0 || state % period != 0) {
+    return;
+  }
+  sampled_ = true;
+  op_ = op;
+  parent_ = current();
+  current() = this;
+  if (count_perf_.load(std::memory_order_relaxed)) {
+    perf_counters::count_this_thread();
+    start_counters_ = perf_counters::read();
+  } else {
+    start_counters_.fill(-1);
+  }
+  // after the counters, so that the duration is not of their reads
+  start_ = std::chrono::steady_clock::now();
+}
+
+void OpTraceGuard::set_inputs(std::initializer_list<at::Tensor> inputs) {
+  std::ostringstream shapes;
+  bool first = true;
+  for (auto& input : inputs) {
+    if (!input.defined()) {
+      continue;
+    }
+    if (!first) {
+      shapes << ", ";
+    }
+    shapes << input.sizes();
+    if (first) {
+      dtype_ = c10::toString(input.scalar_type());
+    }
+    first = false;
+  }
+  shapes_ = shapes.str();
+}
+
+void OpTraceGuard::end() {
+  int64_t duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start_)
+                            .count();
+  perf_counters::Counts counters;
+  counters.fill(-1);
+  if (start_counters_[perf_counters::kCycles] >= 0 ||
+      start_counters_[perf_counters::kInstructions] >= 0) {
+    auto end_counters = perf_counters::read();
+    for (int i = 0; i < perf_counters::kNumCounters; i++) {
+      // the counters are closed by disable() during the call
+      if (start_counters_[i] >= 0 && end_counters[i] >= start_counters_[i]) {
+        counters[i] = end_counters[i] - start_counters_[i];
+      }
+    }
+  }
+  current() = parent_;
+  auto& buffer = get_thread_buffer();
+  size_t buffer_size = buffer_size_.load(std::memory_order_relaxed);
+  OpRecord record{
+      op_,
+      std::move(shapes_),
+      std::move(dtype_),
+      kernel_ != nullptr ? kernel_ : "",
+      duration_ns,
+      counters};
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  if (buffer.records.size() < buffer_size) {
+    buffer.records.push_back(std::move(record));
+  } else {
+    buffer.records[buffer.next] = std::move(record);
+    buffer.next = (buffer.next + 1) % buffer.records.size();
+  }
+  auto& stats = buffer.stats[op_];
+  if (stats.count == 0) {
+    stats.op = op_;
+    stats.min_ns = duration_ns;
+    stats.counters = counters;
+  } else {
+    add_counters(stats.counters, counters);
+  }
+  stats.count++;
+  stats.total_ns += duration_ns;
+  stats.min_ns = std::min(stats.min_ns, duration_ns);
+  stats.max_ns = std::max(stats.max_ns, duration_ns);
+  stats.histogram[histogram_bucket(duration_ns)]++;
+}
+
+} // namespace op_trace
+} // namespace torch_ipex
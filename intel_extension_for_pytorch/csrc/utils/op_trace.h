@@ -0,0 +1,169 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+#include <ATen/record_function.h>
+#include <c10/macros/Macros.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "perf_counters.h"
+
+// The runtime tracer of the IPEX ops. Each op records itself by
+// IPEX_RECORD_FUNCTION, which also feeds the PyTorch profiler if the build
+// sets IPEX_PROFILE_OP. The tracer is off by default, of which an op pays a
+// relaxed atomic load. If on, it samples the calls of the ops of each thread
+// at random by the sample rate, and keeps the op, the shapes and dtype of its
+// inputs, the kernel path it chose and its duration in a ring buffer of the
+// thread, along with the histograms of the durations of each op.
+//
+// The ops annotate the sampled record by IPEX_TRACE_OP_INPUTS and
+// IPEX_TRACE_OP_KERNEL, which do nothing unless the op is sampled.
+//
+// The tracer may also sample the hardware counters of perf_counters around
+// each sampled call, e.g. the cycles, the instructions and the LLC misses,
+// which are of all the threads of the process, so that they are of the
+// OpenMP workers of the op too, but also of the ops run by the other threads
+// at the same time.
+
+namespace torch_ipex {
+namespace op_trace {
+
+// bucket 0 of the histograms is of the durations below 1 us, and bucket i of
+// the others is of [2^(i - 1), 2^i) us, the last one of all the longer ones
+constexpr int kHistogramBuckets = 24;
+
+struct OpRecord {
+  std::string op;
+  // the sizes of the traced inputs, e.g. "[2, 64], [32, 64]"
+  std::string shapes;
+  // the dtype of the first traced input
+  std::string dtype;
+  // the kernel path chosen by the op, empty if it doesn't annotate one
+  std::string kernel;
+  int64_t duration_ns;
+  // the increments of the hardware counters over the call, -1 of the ones
+  // not counted
+  perf_counters::Counts counters;
+};
+
+struct OpStats {
+  std::string op;
+  int64_t count = 0;
+  int64_t total_ns = 0;
+  int64_t min_ns = 0;
+  int64_t max_ns = 0;
+  std::array<int64_t, kHistogramBuckets> histogram{};
+  // the sums of the hardware counters of the calls, -1 of the ones not
+  // counted
+  perf_counters::Counts counters;
+};
+
+// 0 if the tracer is off, otherwise the calls of which one is sampled on
+// average
+extern std::atomic<int64_t> sample_period_;
+// if the sampled calls read the hardware counters
+extern std::atomic<bool> count_perf_;
+
+inline bool is_enabled() {
+  return sample_period_.load(std::memory_order_relaxed) > 0;
+}
+
+// Turns the tracer on, of which sample_rate of the calls in (0, 1] are
+// sampled, and each thread keeps its last buffer_size records. It clears the
+// records and the histograms of the last trace. If perf is set, the sampled
+// calls also read the hardware counters, and it returns false if perf_event
+// is not available, of which the tracer is on without the counters.
+bool enable(double sample_rate, int64_t buffer_size, bool perf = false);
+
+void disable();
+
+void clear();
+
+// The records of all the threads, in the order of each thread.
+std::vector<OpRecord> get_records();
+
+// The histograms of the ops of all the threads, of all the sampled calls
+// including the ones of which the records are overwritten.
+std::vector<OpStats> get_stats();
+
+class OpTraceGuard {
+ public:
+  explicit OpTraceGuard(const char* op) {
+    if (C10_UNLIKELY(is_enabled())) {
+      begin(op);
+    }
+  }
+
+  explicit OpTraceGuard(const std::string& op) : OpTraceGuard(op.c_str()) {}
+
+  ~OpTraceGuard() {
+    if (C10_UNLIKELY(sampled_)) {
+      end();
+    }
+  }
+
+  // the innermost sampled op of the thread, nullptr if none
+  static OpTraceGuard*& current() {
+    static thread_local OpTraceGuard* guard = nullptr;
+    return guard;
+  }
+
+  void set_inputs(std::initializer_list<at::Tensor> inputs);
+
+  void set_kernel(const char* kernel) {
+    kernel_ = kernel;
+  }
+
+ private:
+  void begin(const char* op);
+  void end();
+
+  OpTraceGuard(const OpTraceGuard&) = delete;
+  OpTraceGuard& operator=(const OpTraceGuard&) = delete;
+
+  bool sampled_ = false;
+  // copied if the call is sampled, of which the name may be a temporary
+  std::string op_;
+  const char* kernel_ = nullptr;
+  OpTraceGuard* parent_ = nullptr;
+  std::string shapes_;
+  std::string dtype_;
+  std::chrono::steady_clock::time_point start_;
+  perf_counters::Counts start_counters_;
+};
+
+} // namespace op_trace
+} // namespace torch_ipex
+
+#if defined(IPEX_PROFILE_OP)
+#define IPEX_RECORD_FUNCTION(name, inputs) \
+  RECORD_FUNCTION(name, inputs);           \
+  ::torch_ipex::op_trace::OpTraceGuard _ipex_op_trace_guard(name)
+#else
+#define IPEX_RECORD_FUNCTION(name, inputs) \
+  ::torch_ipex::op_trace::OpTraceGuard _ipex_op_trace_guard(name)
+#endif
+
+// the tensor inputs of the innermost sampled op of the thread, which are not
+// evaluated unless there is one
+#define IPEX_TRACE_OP_INPUTS(...)                                           \
+  do {                                                                      \
+    auto _ipex_op_trace = ::torch_ipex::op_trace::OpTraceGuard::current(); \
+    if (C10_UNLIKELY(_ipex_op_trace != nullptr)) {                          \
+      _ipex_op_trace->set_inputs({__VA_ARGS__});                            \
+    }                                                                       \
+  } while (0)
+
+// the kernel path, a string literal, of the innermost sampled op
+#define IPEX_TRACE_OP_KERNEL(kernel)                                        \
+  do {                                                                      \
+    auto _ipex_op_trace = ::torch_ipex::op_trace::OpTraceGuard::current(); \
+    if (C10_UNLIKELY(_ipex_op_trace != nullptr)) {                          \
+      _ipex_op_trace->set_kernel(kernel);                                   \
+    }                                                                       \
+  } while (0)
@@ -0,0 +1,121 @@
+#include "parallel_trace.h"
+
+#include <ATen/Parallel.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+
+namespace torch_ipex {
+namespace parallel_trace {
+
+std::atomic<bool> enabled_{false};
+
+namespace {
+
+std::mutex stats_mutex;
+std::map<std::string, RegionStats> region_stats;
+
+int thread_num() {
+#ifdef _OPENMP
+  return omp_get_thread_num();
+#else
+  return at::get_thread_num();
+#endif
+}
+
+int max_threads() {
+#ifdef _OPENMP
+  return omp_get_max_threads();
+#else
+  return at::get_num_threads();
+#endif
+}
+
+} // namespace
+
+void enable() {
+  clear();
+  enabled_.store(true, std::memory_order_relaxed);
+}
+
+void disable() {
+  enabled_.store(false, std::memory_order_relaxed);
+}
+
+void clear() {
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  region_stats.clear();
+}
+
+std::vector<RegionStats> get_stats() {
+  std::vector<RegionStats> stats;
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  for (auto& item : region_stats) {
+    stats.push_back(item.second);
+  }
+  return stats;
+}
+
+void ParallelRegion::begin(const char* name) {
+  // the regions nested in a parallel region run on one thread each, which
+  // are of the chunks of the outer one
+  if (at::in_parallel_region()) {
+    return;
+  }
+  active_ = true;
+  name_ = name;
+  busy_.resize(max_threads());
+  start_ = std::chrono::steady_clock::now();
+}
+
+void ParallelRegion::add_busy(std::chrono::steady_clock::time_point start) {
+  int64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - start)
+                   .count();
+  size_t thread = thread_num();
+  // each thread only writes its own slot
+  if (thread < busy_.size()) {
+    busy_[thread].ns += ns;
+  }
+}
+
+void ParallelRegion::end() {
+  int64_t wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start_)
+                        .count();
+  int64_t active_threads = 0;
+  int64_t busy_ns = 0;
+  int64_t max_busy_ns = 0;
+  for (auto& busy : busy_) {
+    if (busy.ns > 0) {
+      active_threads++;
+      busy_ns += busy.ns;
+      max_busy_ns = std::max(max_busy_ns, busy.ns);
+    }
+  }
+  if (active_threads == 0) {
+    return;
+  }
+  double imbalance =
+      static_cast<double>(max_busy_ns) * active_threads / busy_ns;
+  std::lock_guard<std::mutex> lock(stats_mutex);
+  auto& stats = region_stats[name_];
+  stats.region = name_;
+  stats.count++;
+  stats.num_threads =
+      std::max<int64_t>(stats.num_threads, static_cast<int64_t>(busy_.size()));
+  stats.total_active_threads += active_threads;
+  stats.total_wall_ns += wall_ns;
+  stats.total_busy_ns += busy_ns;
+  stats.total_max_busy_ns += max_busy_ns;
+  stats.total_mean_busy_ns += busy_ns / active_threads;
+  stats.max_imbalance = std::max(stats.max_imbalance, imbalance);
+}
+
+} // namespace parallel_trace
+} // namespace torch_ipex
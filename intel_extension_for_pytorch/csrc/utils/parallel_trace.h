@@ -0,0 +1,142 @@
+#pragma once
+
+#include <c10/macros/Macros.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The profiler of the imbalance of the threads of the parallel regions of the
+// IPEX kernels. A region is an at::parallel_for or an OpenMP loop, of which
+// the body is timed as a chunk of the region by IPEX_PARALLEL_CHUNK:
+//
+//   parallel_trace::ParallelRegion region("roi_align_forward");
+//   at::parallel_for(0, n, 1, [&](int64_t begin, int64_t end) {
+//     IPEX_PARALLEL_CHUNK(region);
+//     ...
+//   });
+//
+//   parallel_trace::ParallelRegion region("batch_score_nms");
+//   #pragma omp parallel for schedule(static)
+//   for (int64_t i = 0; i < n; i++) {
+//     IPEX_PARALLEL_CHUNK(region);
+//     ...
+//   }
+//
+// The regions nested in a parallel region, which run on one thread, are not
+// profiled.
+//
+// The profiler is off by default, of which a region pays a relaxed atomic
+// load, and a chunk a branch on the region. If on, each region sums the busy
+// time of the chunks of each thread, and keeps the stats of its name on exit,
+// i.e. the wall time and the busy time of the slowest and of the average
+// thread. The imbalance factor of a region is the max over the mean of the
+// busy times of its threads, 1 of a perfectly balanced one.
+
+namespace torch_ipex {
+namespace parallel_trace {
+
+struct RegionStats {
+  std::string region;
+  int64_t count = 0;
+  // the max number of threads of the region
+  int64_t num_threads = 0;
+  // the number of the threads which ran chunks, summed over the calls
+  int64_t total_active_threads = 0;
+  int64_t total_wall_ns = 0;
+  // the busy time of all the threads, summed over the calls
+  int64_t total_busy_ns = 0;
+  // the busy time of the slowest thread and the mean busy time of the active
+  // threads, summed over the calls, of which the difference is the time a
+  // balanced schedule would save at most
+  int64_t total_max_busy_ns = 0;
+  int64_t total_mean_busy_ns = 0;
+  // the max imbalance factor of a call
+  double max_imbalance = 0;
+};
+
+extern std::atomic<bool> enabled_;
+
+inline bool is_enabled() {
+  return enabled_.load(std::memory_order_relaxed);
+}
+
+// Turns the profiler on and clears the stats of the last profile.
+void enable();
+
+void disable();
+
+void clear();
+
+// The stats of the regions, sorted by name.
+std::vector<RegionStats> get_stats();
+
+class ParallelRegion {
+ public:
+  explicit ParallelRegion(const char* name) {
+    if (C10_UNLIKELY(is_enabled())) {
+      begin(name);
+    }
+  }
+
+  ~ParallelRegion() {
+    if (C10_UNLIKELY(active_)) {
+      end();
+    }
+  }
+
+  // Times a chunk of the work of the region on the calling thread.
+  class Chunk {
+   public:
+    explicit Chunk(ParallelRegion& region)
+        : region_(region.active_ ? &region : nullptr) {
+      if (C10_UNLIKELY(region_ != nullptr)) {
+        start_ = std::chrono::steady_clock::now();
+      }
+    }
+
+    ~Chunk() {
+      if (C10_UNLIKELY(region_ != nullptr)) {
+        region_->add_busy(start_);
+      }
+    }
+
+   private:
+    Chunk(const Chunk&) = delete;
+    Chunk& operator=(const Chunk&) = delete;
+
+    ParallelRegion* region_;
+    std::chrono::steady_clock::time_point start_;
+  };
+
+ private:
+  // the busy time of a thread, padded to a cache line so that the threads
+  // don't share the lines they write
+  struct ThreadBusy {
+    int64_t ns = 0;
+    char padding[56];
+  };
+
+  void begin(const char* name);
+  void end();
+  void add_busy(std::chrono::steady_clock::time_point start);
+
+  ParallelRegion(const ParallelRegion&) = delete;
+  ParallelRegion& operator=(const ParallelRegion&) = delete;
+
+  bool active_ = false;
+  const char* name_ = nullptr;
+  std::vector<ThreadBusy> busy_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace parallel_trace
+} // namespace torch_ipex
+
+// times the rest of the scope, e.g. the body of an OpenMP loop, as a chunk of
+// the region
+#define IPEX_PARALLEL_CHUNK(region)                  \
+  ::torch_ipex::parallel_trace::ParallelRegion::Chunk \
+      _ipex_parallel_chunk(region)
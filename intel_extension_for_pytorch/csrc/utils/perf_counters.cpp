@@ -0,0 +1,262 @@
+#include "perf_counters.h"
+
+#include "csrc/cpu/isa/cpu_info.hpp"
+#include "rw_lock.h"
+
+#include <dirent.h>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace torch_ipex {
+namespace perf_counters {
+
+namespace {
+
+struct Event {
+  int counter;
+  uint32_t type;
+  uint64_t config;
+};
+
+// the events of a group are scheduled on the PMU at once, so that their
+// ratios, e.g. the instructions per cycle, are of the same intervals. The
+// license events are of a group of their own, so that the core events are
+// still counted where they are not supported.
+const std::vector<Event>& core_events() {
+  static const std::vector<Event> events{
+      {kCycles, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+      {kInstructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+      {kLlcMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES}};
+  return events;
+}
+
+// CORE_POWER.LVL{0,1,2}_TURBO_LICENSE, event 0x28 of the umasks 0x07, 0x18
+// and 0x20
+const std::vector<Event>& license_events() {
+  static const std::vector<Event> events{
+      {kLicense0Cycles, PERF_TYPE_RAW, 0x0728},
+      {kLicense1Cycles, PERF_TYPE_RAW, 0x1828},
+      {kLicense2Cycles, PERF_TYPE_RAW, 0x2028}};
+  return events;
+}
+
+bool has_license_events() {
+  auto micro_arch = cpu::CPUInfo::get_instance().micro_arch();
+  return micro_arch == cpu::CPUMicroArch::SKYLAKE_X ||
+      micro_arch == cpu::CPUMicroArch::COOPER_LAKE ||
+      micro_arch == cpu::CPUMicroArch::ICELAKE_X;
+}
+
+struct EventGroup {
+  std::vector<int> fds;
+  std::vector<int> counters;
+
+  int leader() const {
+    return fds.empty() ? -1 : fds[0];
+  }
+
+  void close() {
+    for (auto fd : fds) {
+      ::close(fd);
+    }
+    fds.clear();
+    counters.clear();
+  }
+};
+
+struct ThreadCounters {
+  pid_t tid;
+  EventGroup core;
+  EventGroup license;
+};
+
+ReadWriteMutex rwmutex;
+std::vector<ThreadCounters> threads;
+std::array<bool, kNumCounters> available{};
+std::atomic<bool> opened{false};
+// bumped by each open(), of which the threads check if they are counted
+std::atomic<uint64_t> generation{0};
+
+pid_t get_tid() {
+  return static_cast<pid_t>(syscall(SYS_gettid));
+}
+
+int perf_event_open(const Event& event, pid_t tid, int group_fd) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = event.type;
+  attr.config = event.config;
+  // the user space only, which the default perf_event_paranoid of 2 allows
+  // for the threads of the own process
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+      PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return static_cast<int>(syscall(
+      SYS_perf_event_open, &attr, tid, -1, group_fd, PERF_FLAG_FD_CLOEXEC));
+}
+
+bool open_group(
+    pid_t tid,
+    const std::vector<Event>& events,
+    EventGroup& group) {
+  for (auto& event : events) {
+    int fd = perf_event_open(event, tid, group.leader());
+    if (fd < 0) {
+      int error = errno;
+      group.close();
+      errno = error;
+      return false;
+    }
+    group.fds.push_back(fd);
+    group.counters.push_back(event.counter);
+  }
+  return true;
+}
+
+// must be called with the write lock held, returns false if the thread has
+// exited or perf_event is not available
+bool open_thread(pid_t tid) {
+  ThreadCounters counters{tid, {}, {}};
+  if (!open_group(tid, core_events(), counters.core)) {
+    return false;
+  }
+  if (has_license_events()) {
+    open_group(tid, license_events(), counters.license);
+  }
+  for (auto counter : counters.core.counters) {
+    available[counter] = true;
+  }
+  for (auto counter : counters.license.counters) {
+    available[counter] = true;
+  }
+  threads.push_back(std::move(counters));
+  return true;
+}
+
+void read_group(const EventGroup& group, Counts& counts) {
+  if (group.fds.empty()) {
+    return;
+  }
+  // nr, time_enabled, time_running and the values of the group
+  std::array<uint64_t, 3 + kNumCounters> buffer{};
+  if (::read(group.leader(), buffer.data(), sizeof(buffer)) <= 0) {
+    return;
+  }
+  uint64_t nr = buffer[0];
+  uint64_t enabled = buffer[1];
+  uint64_t running = buffer[2];
+  if (running == 0) {
+    return;
+  }
+  double scale = static_cast<double>(enabled) / running;
+  for (uint64_t i = 0; i < nr && i < group.counters.size(); i++) {
+    counts[group.counters[i]] +=
+        static_cast<int64_t>(static_cast<double>(buffer[3 + i]) * scale);
+  }
+}
+
+void close_all() {
+  for (auto& thread : threads) {
+    thread.core.close();
+    thread.license.close();
+  }
+  threads.clear();
+  available.fill(false);
+}
+
+} // namespace
+
+const char* name(int counter) {
+  static const char* names[kNumCounters] = {
+      "cycles",
+      "instructions",
+      "llc_misses",
+      "license0_cycles",
+      "license1_cycles",
+      "license2_cycles"};
+  return names[counter];
+}
+
+bool open() {
+  UniqueWriteLock<ReadWriteMutex> lock(rwmutex);
+  close_all();
+  generation.fetch_add(1, std::memory_order_relaxed);
+  DIR* dir = opendir("/proc/self/task");
+  if (dir == nullptr) {
+    return false;
+  }
+  bool any = false;
+  bool denied = false;
+  while (auto entry = readdir(dir)) {
+    auto tid = static_cast<pid_t>(std::atoi(entry->d_name));
+    if (tid <= 0) {
+      continue;
+    }
+    if (open_thread(tid)) {
+      any = true;
+    } else if (errno != ESRCH) {
+      // not of a thread which has just exited
+      denied = true;
+      break;
+    }
+  }
+  closedir(dir);
+  if (denied || !any) {
+    close_all();
+    return false;
+  }
+  opened.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+void close() {
+  UniqueWriteLock<ReadWriteMutex> lock(rwmutex);
+  opened.store(false, std::memory_order_relaxed);
+  close_all();
+}
+
+bool is_open() {
+  return opened.load(std::memory_order_relaxed);
+}
+
+void count_this_thread() {
+  static thread_local uint64_t counted_generation = 0;
+  auto current = generation.load(std::memory_order_relaxed);
+  if (counted_generation == current || !is_open()) {
+    return;
+  }
+  counted_generation = current;
+  auto tid = get_tid();
+  UniqueWriteLock<ReadWriteMutex> lock(rwmutex);
+  for (auto& thread : threads) {
+    if (thread.tid == tid) {
+      return;
+    }
+  }
+  open_thread(tid);
+}
+
+Counts read() {
+  Counts counts;
+  UniqueReadLock<ReadWriteMutex> lock(rwmutex);
+  for (int i = 0; i < kNumCounters; i++) {
+    counts[i] = available[i] ? 0 : -1;
+  }
+  for (auto& thread : threads) {
+    read_group(thread.core, counts);
+    read_group(thread.license, counts);
+  }
+  return counts;
+}
+
+} // namespace perf_counters
+} // namespace torch_ipex
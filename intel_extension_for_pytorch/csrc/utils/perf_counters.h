@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+// The hardware performance counters of the process by perf_event, which the
+// op tracer samples around the IPEX ops. The counters are opened for each
+// thread of the process, and the counts are of all the threads, which are
+// the calling thread of an op and the OpenMP workers running it. The threads
+// created later are counted once they run a sampled op.
+//
+// The frequency license counters are of the Xeons of AVX-512 which count
+// CORE_POWER.LVL{0,1,2}_TURBO_LICENSE, i.e. Skylake-SP to Ice Lake-SP, of
+// which the cycles of license 1 and 2 are the ones at the reduced frequency
+// of the heavy AVX2, light AVX-512 and heavy AVX-512 instructions.
+
+namespace torch_ipex {
+namespace perf_counters {
+
+enum Counter {
+  kCycles = 0,
+  kInstructions,
+  // the demand misses of the last level cache, of which each reads a cache
+  // line from the memory
+  kLlcMisses,
+  kLicense0Cycles,
+  kLicense1Cycles,
+  kLicense2Cycles,
+  kNumCounters
+};
+
+// the counts of all the counted threads, -1 of the counters not available
+using Counts = std::array<int64_t, kNumCounters>;
+
+// the name of a counter, e.g. "llc_misses"
+const char* name(int counter);
+
+// Opens the counters of the threads of the process. Returns false if
+// perf_event is not available, e.g. under the perf_event_paranoid of the
+// kernel or the seccomp of a container.
+bool open();
+
+void close();
+
+bool is_open();
+
+// Counts the calling thread if it is not yet, e.g. of a thread created after
+// open().
+void count_this_thread();
+
+// the counts of all the counted threads since open(), scaled by the time
+// enabled over the time running if the kernel multiplexes the counters
+Counts read();
+
+} // namespace perf_counters
+} // namespace torch_ipex
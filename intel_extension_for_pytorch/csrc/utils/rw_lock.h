@@ -1,7 +1,6 @@
 #pragma once
 
-#include <condition_variable>
-#include <mutex>
+#include <shared_mutex>
 
 /*
 
@@ -32,44 +31,27 @@ class ReadWriteMutex {
   ReadWriteMutex(const ReadWriteMutex&&) = delete;
   ReadWriteMutex& operator=(const ReadWriteMutex&&) = delete;
 
+  // The readers only take the shared lock of the underlying rwlock, which is
+  // an atomic update in the uncontended case, rather than a mutex and a
+  // condition variable.
   void lock_read() {
-    std::unique_lock<std::mutex> lock(m_mutex);
-    m_cond_read.wait(lock, [this]() -> bool { return m_write_count == 0; });
-    ++m_read_count;
+    m_mutex.lock_shared();
   }
 
   void unlock_read() {
-    std::unique_lock<std::mutex> lock(m_mutex);
-    if (--m_read_count == 0 && m_write_count > 0) {
-      m_cond_write.notify_one();
-    }
+    m_mutex.unlock_shared();
   }
 
   void lock_write() {
-    std::unique_lock<std::mutex> lock(m_mutex);
-    ++m_write_count;
-    m_cond_write.wait(
-        lock, [this]() -> bool { return m_read_count == 0 && !m_writing; });
-    m_writing = true;
+    m_mutex.lock();
   }
 
   void unlock_write() {
-    std::unique_lock<std::mutex> lock(m_mutex);
-    if (--m_write_count == 0) {
-      m_cond_read.notify_all();
-    } else {
-      m_cond_write.notify_one();
-    }
-    m_writing = false;
+    m_mutex.unlock();
   }
 
  private:
-  volatile size_t m_read_count = 0;
-  volatile size_t m_write_count = 0;
-  volatile bool m_writing = false;
-  std::mutex m_mutex;
-  std::condition_variable m_cond_read;
-  std::condition_variable m_cond_write;
+  std::shared_timed_mutex m_mutex;
 };
 
 template <typename _ReadWriteLock>
@@ -2,6 +2,14 @@
 
 #include "csrc/cpu/ideep/IDeepConversions.h"
 
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <thread>
+
 namespace torch_ipex {
 namespace verbose {
 
@@ -9,5 +17,194 @@ int _mkldnn_set_verbose(int level) {
   return torch_ipex::cpu::mkldnn_set_verbose(level);
 }
 
+namespace {
+
+const char kMarkPrefix[] = "ipex_verbose_mark,";
+
+std::vector<std::string> split(const std::string& line, char delimiter) {
+  std::vector<std::string> fields;
+  size_t begin = 0;
+  while (true) {
+    auto end = line.find(delimiter, begin);
+    if (end == std::string::npos) {
+      fields.push_back(line.substr(begin));
+      return fields;
+    }
+    fields.push_back(line.substr(begin, end - begin));
+    begin = end + 1;
+  }
+}
+
+bool is_number(const std::string& field) {
+  if (field.empty()) {
+    return false;
+  }
+  char* end = nullptr;
+  std::strtod(field.c_str(), &end);
+  return end == field.c_str() + field.size();
+}
+
+void write_all(int fd, const char* data, size_t size) {
+  while (size > 0) {
+    auto written = ::write(fd, data, size);
+    if (written <= 0) {
+      return;
+    }
+    data += written;
+    size -= written;
+  }
+}
+
+struct Capture {
+  std::mutex mutex;
+  bool capturing = false;
+  int saved_stdout = -1;
+  int pipe_read = -1;
+  std::thread reader;
+  std::vector<VerboseRecord> records;
+};
+
+Capture& get_capture() {
+  static Capture capture;
+  return capture;
+}
+
+// reads the captured stdout until the write end is closed by the stop
+void read_captured(Capture& capture) {
+  std::string pending;
+  char buffer[4096];
+  while (true) {
+    auto size = ::read(capture.pipe_read, buffer, sizeof(buffer));
+    if (size <= 0) {
+      break;
+    }
+    pending.append(buffer, size);
+    size_t begin = 0;
+    size_t end;
+    while ((end = pending.find('\n', begin)) != std::string::npos) {
+      std::string line = pending.substr(begin, end - begin);
+      VerboseRecord record;
+      if (line.compare(0, sizeof(kMarkPrefix) - 1, kMarkPrefix) == 0) {
+        record.stage = "mark";
+        record.problem = line.substr(sizeof(kMarkPrefix) - 1);
+        capture.records.push_back(std::move(record));
+      } else if (parse_verbose_line(line, record)) {
+        capture.records.push_back(std::move(record));
+      } else if (
+          line.compare(0, 12, "dnnl_verbose") != 0 &&
+          line.compare(0, 14, "onednn_verbose") != 0) {
+        // the other output of the process, e.g. of print()
+        write_all(
+            capture.saved_stdout, pending.data() + begin, end - begin + 1);
+      }
+      begin = end + 1;
+    }
+    pending.erase(0, begin);
+  }
+  if (!pending.empty()) {
+    write_all(capture.saved_stdout, pending.data(), pending.size());
+  }
+}
+
+} // namespace
+
+bool parse_verbose_line(const std::string& line, VerboseRecord& record) {
+  auto fields = split(line, ',');
+  size_t i = 0;
+  if (fields.empty() ||
+      (fields[0] != "dnnl_verbose" && fields[0] != "onednn_verbose")) {
+    return false;
+  }
+  i++;
+  // the timestamp of DNNL_VERBOSE_TIMESTAMP, and the component of oneDNN 3.x
+  if (i < fields.size() && is_number(fields[i])) {
+    i++;
+  }
+  if (i < fields.size() && fields[i] == "primitive") {
+    i++;
+  }
+  // stage, engine, kind, impl, prop_kind, memory descs, attrs, aux, problem
+  // and time
+  if (fields.size() < i + 9) {
+    return false;
+  }
+  const std::string& stage = fields[i];
+  if (stage != "exec" && stage.compare(0, 6, "create") != 0) {
+    return false;
+  }
+  record.stage = stage;
+  record.engine = fields[i + 1];
+  record.kind = fields[i + 2];
+  record.impl = fields[i + 3];
+  record.prop_kind = fields[i + 4];
+  record.memory_descs = fields[i + 5];
+  record.attrs = fields[i + 6];
+  record.aux = fields[i + 7];
+  record.problem = fields[i + 8];
+  record.time_ms = -1;
+  if (fields.size() > i + 9 && is_number(fields[i + 9])) {
+    record.time_ms = std::strtod(fields[i + 9].c_str(), nullptr);
+  }
+  return true;
+}
+
+bool start_verbose_capture() {
+  auto& capture = get_capture();
+  std::lock_guard<std::mutex> lock(capture.mutex);
+  if (capture.capturing) {
+    return false;
+  }
+  int fds[2];
+  if (pipe(fds) != 0) {
+    return false;
+  }
+  fflush(stdout);
+  capture.saved_stdout = dup(STDOUT_FILENO);
+  if (capture.saved_stdout < 0 || dup2(fds[1], STDOUT_FILENO) < 0) {
+    if (capture.saved_stdout >= 0) {
+      close(capture.saved_stdout);
+    }
+    close(fds[0]);
+    close(fds[1]);
+    return false;
+  }
+  // stdout is the only write end, so that the reader ends on its restore
+  close(fds[1]);
+  capture.pipe_read = fds[0];
+  capture.records.clear();
+  capture.capturing = true;
+  capture.reader = std::thread(read_captured, std::ref(capture));
+  return true;
+}
+
+void mark_verbose_capture(const std::string& text) {
+  auto& capture = get_capture();
+  std::lock_guard<std::mutex> lock(capture.mutex);
+  if (!capture.capturing) {
+    return;
+  }
+  // after the verbose lines buffered by printf before it
+  fflush(stdout);
+  std::string line = kMarkPrefix + text + "\n";
+  write_all(STDOUT_FILENO, line.data(), line.size());
+}
+
+std::vector<VerboseRecord> stop_verbose_capture() {
+  auto& capture = get_capture();
+  std::lock_guard<std::mutex> lock(capture.mutex);
+  if (!capture.capturing) {
+    return {};
+  }
+  fflush(stdout);
+  dup2(capture.saved_stdout, STDOUT_FILENO);
+  capture.reader.join();
+  close(capture.pipe_read);
+  close(capture.saved_stdout);
+  capture.pipe_read = -1;
+  capture.saved_stdout = -1;
+  capture.capturing = false;
+  return std::move(capture.records);
+}
+
 } // namespace verbose
 } // namespace torch_ipex
@@ -1,7 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
 namespace torch_ipex {
 namespace verbose {
 
 int _mkldnn_set_verbose(int level);
 
+// A line of the oneDNN verbose, or a mark of mark_verbose_capture(), e.g.
+//   dnnl_verbose,exec,cpu,reorder,jit:uni,undef,src_f32::blocked:abcd:f0
+//   dst_f32::blocked:aBcd16b:f0,,,2x16x7x7,0.0129395
+// of which the fields are empty if the line doesn't have them.
+struct VerboseRecord {
+  // "exec", or "create:cache_miss" and the like of VERBOSE_ON_CREATION, or
+  // "mark" of a mark, of which only the problem is set to its text
+  std::string stage;
+  std::string engine;
+  // the primitive kind, e.g. "convolution" or "reorder"
+  std::string kind;
+  // the implementation, e.g. "jit:avx512_core_amx" or "ref:any"
+  std::string impl;
+  std::string prop_kind;
+  // the memory descs of the arguments, separated by spaces
+  std::string memory_descs;
+  std::string attrs;
+  std::string aux;
+  // the problem desc, e.g. "mb2_ic16oc16_ih7oh7kh3sh1dh0ph1_iw7ow7kw3sw1dw0pw1"
+  std::string problem;
+  // -1 if the line has no time, e.g. of a cache hit of the creation
+  double time_ms = -1;
+};
+
+// Parses a line of the verbose of oneDNN 2.x or 3.x, of the marker
+// "dnnl_verbose" or "onednn_verbose" and maybe a timestamp. Returns false if
+// the line is not of a primitive, e.g. of the info of the version.
+bool parse_verbose_line(const std::string& line, VerboseRecord& record);
+
+// Captures the stdout of the process, to which oneDNN prints its verbose, and
+// keeps the parsed records of the verbose lines. The other lines are written
+// to the original stdout as they are. Returns false if a capture is already
+// started or stdout can't be redirected.
+bool start_verbose_capture();
+
+// Writes a mark to the captured stdout, which is a record in the order of
+// the verbose lines, e.g. of the module running the primitives after it.
+// Does nothing if not capturing.
+void mark_verbose_capture(const std::string& text);
+
+// Stops the capture and returns the records captured, in the order of their
+// lines.
+std::vector<VerboseRecord> stop_verbose_capture();
+
 } // namespace verbose
 } // namespace torch_ipex
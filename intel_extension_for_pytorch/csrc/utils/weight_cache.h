@@ -0,0 +1,194 @@
+#pragma once
+
+#include <ATen/Tensor.h>
+#include <c10/core/UndefinedTensorImpl.h>
+#include <c10/util/intrusive_ptr.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#include "memory_stats.h"
+#include "rw_lock.h"
+
+namespace torch_ipex {
+
+/*WeightCache is a process-wide, read-mostly cache of the data derived from a
+ * weight tensor, e.g. its bf16 copy, keyed by the weight and the target format.
+ * It is shared by all threads, so that the streams running the same module
+ * share one copy of the derived data instead of one copy per thread.
+ * The lookups only take the read lock. An entry is dropped at the next lookup
+ * once its weight is freed or modified in place.
+ * A cache of the static storage duration may account its bytes in
+ * memory_stats by the name and the nbytes of its values, and then is evicted
+ * by the memory budget of all the caches.*/
+template <typename Value>
+class WeightCache {
+ public:
+  using NBytes = std::function<int64_t(const Value&)>;
+
+  WeightCache() = default;
+  WeightCache(const char* name, int eviction_order, NBytes nbytes)
+      : nbytes(std::move(nbytes)),
+        account(new memory_stats::CacheAccount(
+            name,
+            eviction_order,
+            [this](int64_t bytes) { return this->evict(bytes); })) {}
+  ~WeightCache() = default;
+
+  // Returns true and sets value if the cache has a valid entry for weight.
+  bool find(const at::Tensor& tensor, int64_t format, Value& value) {
+    auto weight = tensor.unsafeGetTensorImpl();
+    {
+      UniqueReadLock<ReadWriteMutex> lock(this->rwmutex);
+      auto it = this->entries.find(Key{weight, format});
+      if (it == this->entries.end()) {
+        return false;
+      }
+      if (this->is_valid(weight, it->second)) {
+        value = it->second.value;
+        return true;
+      }
+    }
+    // The TensorImpl is freed (and its address maybe reused) or the weight is
+    // modified, drop the stale entry.
+    UniqueWriteLock<ReadWriteMutex> lock(this->rwmutex);
+    auto it = this->entries.find(Key{weight, format});
+    if (it != this->entries.end() && !this->is_valid(weight, it->second)) {
+      this->erase(it);
+    }
+    return false;
+  }
+
+  // Insert the derived value of weight. If another thread inserted the value
+  // first, value is replaced by the cached one, so that all threads end up
+  // sharing the same copy.
+  void insert(const at::Tensor& tensor, int64_t format, Value& value) {
+    auto weight = tensor.unsafeGetTensorImpl();
+    {
+      UniqueWriteLock<ReadWriteMutex> lock(this->rwmutex);
+      Key key{weight, format};
+      auto it = this->entries.find(key);
+      if (it != this->entries.end() && this->is_valid(weight, it->second)) {
+        value = it->second.value;
+        return;
+      }
+      if (it != this->entries.end()) {
+        this->erase(it);
+      }
+      Entry entry{
+          WeakRef(tensor.getIntrusivePtr()),
+          weight->version_counter().current_version(),
+          value,
+          this->nbytes ? this->nbytes(value) : 0};
+      if (this->account) {
+        this->account->update(entry.nbytes, 1);
+      }
+      this->entries.emplace(key, std::move(entry));
+    }
+    if (this->account) {
+      memory_stats::enforce_memory_budget();
+    }
+  }
+
+  // Drop the entries whose weight is freed or modified.
+  void prune() {
+    UniqueWriteLock<ReadWriteMutex> lock(this->rwmutex);
+    for (auto it = this->entries.begin(); it != this->entries.end();) {
+      if (!this->is_valid(it->first.weight, it->second)) {
+        it = this->erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+  void clear() {
+    UniqueWriteLock<ReadWriteMutex> lock(this->rwmutex);
+    for (auto it = this->entries.begin(); it != this->entries.end();) {
+      it = this->erase(it);
+    }
+  }
+
+  // Drop the stale entries, then the others until at least bytes are
+  // dropped, returns the bytes dropped. The entries are in no order of use,
+  // and are cheap to derive again from their weights.
+  int64_t evict(int64_t bytes) {
+    UniqueWriteLock<ReadWriteMutex> lock(this->rwmutex);
+    int64_t evicted = 0;
+    for (auto it = this->entries.begin(); it != this->entries.end();) {
+      if (!this->is_valid(it->first.weight, it->second)) {
+        evicted += it->second.nbytes;
+        it = this->erase(it);
+      } else {
+        ++it;
+      }
+    }
+    for (auto it = this->entries.begin();
+         evicted < bytes && it != this->entries.end();) {
+      evicted += it->second.nbytes;
+      it = this->erase(it);
+    }
+    return evicted;
+  }
+
+  size_t size() {
+    UniqueReadLock<ReadWriteMutex> lock(this->rwmutex);
+    return this->entries.size();
+  }
+
+ private:
+  using WeakRef =
+      c10::weak_intrusive_ptr<c10::TensorImpl, c10::UndefinedTensorImpl>;
+
+  struct Key {
+    c10::TensorImpl* weight;
+    int64_t format;
+
+    bool operator==(const Key& other) const {
+      return this->weight == other.weight && this->format == other.format;
+    }
+  };
+
+  struct KeyHash {
+    size_t operator()(const Key& key) const {
+      return std::hash<c10::TensorImpl*>()(key.weight) ^
+          (std::hash<int64_t>()(key.format) << 1);
+    }
+  };
+
+  struct Entry {
+    WeakRef weak_weight;
+    uint32_t version;
+    Value value;
+    int64_t nbytes;
+  };
+
+  using EntryMap = std::unordered_map<Key, Entry, KeyHash>;
+
+  // must be called with the write lock held
+  typename EntryMap::iterator erase(typename EntryMap::iterator it) {
+    if (this->account) {
+      this->account->update(-it->second.nbytes, -1);
+    }
+    return this->entries.erase(it);
+  }
+
+  bool is_valid(c10::TensorImpl* weight, const Entry& entry) {
+    return !entry.weak_weight.expired() &&
+        entry.version == weight->version_counter().current_version();
+  }
+
+  EntryMap entries;
+  ReadWriteMutex rwmutex;
+  NBytes nbytes;
+  std::unique_ptr<memory_stats::CacheAccount> account;
+
+  WeightCache(const WeightCache& weight_cache) = delete;
+  WeightCache& operator=(const WeightCache& weight_cache) = delete;
+};
+
+} // namespace torch_ipex
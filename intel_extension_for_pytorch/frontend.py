@@ -6,6 +6,7 @@ import warnings
 
 from .nn import utils
 from .optim._optimizer_utils import optimizer_fusion, IPEX_FUSED_OPTIMIZER_LIST
+from .utils.huge_pages import enable_huge_pages, is_huge_pages_available, _embedding_tables_to_huge_pages
 import intel_extension_for_pytorch._C as core
 
 
@@ -35,6 +36,7 @@ class _Properties(object):
         self.opt_level = None
         self.conv_bn_folding = None
         self.weights_prepack = None
+        self.lazy_weights_prepack = None
         self.remove_dropout = None
         # optimizer opt conig
         self.split_master_weight_for_bf16 = None
@@ -47,8 +49,10 @@ class _O0:
         properties.opt_level = "O0"
         properties.conv_bn_folding = False
         properties.weights_prepack = False
+        properties.lazy_weights_prepack = False
         properties.replace_dropout_with_identity = False
         properties.optimize_lstm = False
+        properties.optimize_dropout = False
         properties.split_master_weight_for_bf16 = False
         properties.fuse_update_step = False
         properties.auto_kernel_selection = False
@@ -61,8 +65,10 @@ class _O1:
         properties.opt_level = "O1"
         properties.conv_bn_folding = True
         properties.weights_prepack = True
+        properties.lazy_weights_prepack = False
         properties.replace_dropout_with_identity = True
         properties.optimize_lstm = True
+        properties.optimize_dropout = True
         properties.split_master_weight_for_bf16 = True
         properties.fuse_update_step = True
         properties.auto_kernel_selection = False
@@ -83,7 +89,13 @@ def optimize(
     optimize_lstm=None,
     split_master_weight_for_bf16=None,
     fuse_update_step=None,
-    auto_kernel_selection=None):
+    auto_kernel_selection=None,
+    lazy_weights_prepack=None,
+    sample_input=None,
+    kernel_selection_recipe=None,
+    analyze_reorders=False,
+    memory_format=None,
+    huge_pages=None):
     r"""
     Apply optimizations at Python frontend to the given model (nn.Module), as
     well as the given optimizer (optional). If the optimizer is given,
@@ -114,23 +126,27 @@ def optimize(
             Note: Data type conversion is only applied to ``nn.Conv2d``, ``nn.Linear``
             and ``nn.ConvTranspose2d`` for both training and inference cases. For
             inference mode, additional data type conversion is applied to the weights
-            of ``nn.Embedding`` and ``nn.LSTM``.
+            of ``nn.Embedding``, ``nn.LSTM``, ``nn.GRU`` and ``nn.RNN``.
         optimizer (torch.optim.Optimizer): User optimizer to apply optimizations
             on, such as SGD. The default value is ``None``, meaning inference case.
         level (string): ``"O0"`` or ``"O1"``. No optimizations are applied with
             ``"O0"``. The optimizer function just returns the original model and
             optimizer. With ``"O1"``, the following optimizations are applied:
             conv+bn folding, weights prepack, dropout removal (inferenc model),
-            master weight split and fused optimizer update step (training model).
+            the dropout of the 1-bit masks, master weight split and fused
+            optimizer update step (training model).
             The optimization options can be further overridden by setting the
             following options explicitly. The default value is ``"O1"``.
         inplace (bool): Whether to perform inplace optimization. Default value is
             ``False``.
-        conv_bn_folding (bool): Whether to perform ``conv_bn`` folding. It only
+        conv_bn_folding (bool): Whether to perform ``conv_bn`` folding, of both
+            the ``BatchNorm2d`` and the ``FrozenBatchNorm2d``. It only
             works for inference model. The default value is ``None``. Explicitly
             setting this knob overwrites the configuration set by ``level`` knob.
         weights_prepack (bool): Whether to perform weight prepack for convolution
-            and linear to avoid oneDNN weights reorder. The default value is
+            and linear to avoid oneDNN weights reorder. For inference model, the
+            prepacked ``Linear`` followed by a ``GELU`` in an ``nn.Sequential``
+            is also replaced by a linear with the fused gelu. The default value is
             ``None``. Explicitly setting this knob overwrites the configuration
             set by ``level`` knob.
         replace_dropout_with_identity (bool): Whether to replace ``nn.Dropout``
@@ -141,6 +157,9 @@ def optimize(
             set by ``level`` knob.
         optimize_lstm (bool): Whether to replace ``nn.LSTM`` with ``IPEX LSTM``
             which takes advantage of oneDNN kernels to get better performance.
+            In inference, the ``PackedSequence`` input runs without padding.
+            ``nn.GRU`` and ``nn.RNN`` are replaced as well, except for their
+            ``PackedSequence`` input.
             The default value is ``None``. Explicitly setting this knob
             overwrites the configuration set by ``level`` knob.
         split_master_weight_for_bf16 (bool): Whether to split master weights
@@ -160,6 +179,52 @@ def optimize(
             ``True``. There might be regressions at current stage. The default
             value is ``None``. Explicitly setting this knob overwrites the
             configuration set by ``level`` knob.
+        lazy_weights_prepack (bool): Whether to defer the weight prepack of each
+            convolution and linear to its first forward instead of packing all
+            of them in ``optimize``, so that the model is ready to serve earlier.
+            It only works for inference model and the first call of each layer
+            is slower. Otherwise, the weights are packed in parallel across the
+            cores. The default value is ``None``. Explicitly setting this knob
+            overwrites the configuration set by ``level`` knob.
+        sample_input (tensor or tuple of tensors) [experimental]: A
+            representative input of the inference model. With
+            ``auto_kernel_selection``, the model runs with it once to record the
+            input shape of each convolution and linear, and the ATen and oneDNN
+            kernels of each of them (with the weight in both the contiguous and
+            the channels last blocked formats for the convolutions) are timed on
+            that shape to keep the faster one. The default value is ``None``,
+            meaning the kernels are chosen by the static heuristics.
+        kernel_selection_recipe (str) [experimental]: The path of a JSON file
+            recording the kernels chosen with ``sample_input``. The layers found
+            in an existing recipe take the recorded kernels without being timed
+            again, and the recipe is updated with the newly timed layers. With
+            a recipe and without ``sample_input``, only the recorded kernels
+            are applied. The default value is ``None``.
+        analyze_reorders (bool) [experimental]: Whether to run the optimized
+            inference model with ``sample_input`` once and report the oneDNN
+            reorders between its layers by
+            :func:`~intel_extension_for_pytorch.analyze_reorders`, along with
+            the suggested fixes. The report is kept as ``reorder_report`` of
+            the optimized model, and warned if there are reorders of the
+            activations. The default value is ``False``.
+        memory_format (str) [experimental]: ``"auto"`` converts the model to
+            channels last, and registers a forward pre hook on it converting
+            its 4-D and 5-D tensor inputs to channels last, so that the
+            convolutions and the IPEX kernels after them, e.g. pooling,
+            upsample, batch norm, ROIAlign and pixel or channel shuffle, keep
+            the nhwc layout end to end instead of reordering the plain tensors
+            at every layer boundary. With ``sample_input`` of an inference
+            model, it runs once to find the layers turning a channels last
+            input into a plain output, which are kept as
+            ``memory_format_report`` of the optimized model, a list of the
+            module name and type, and warned. The default value is ``None``,
+            meaning the memory formats of the model and its inputs are kept.
+        huge_pages (bool) [experimental]: Whether to place the packed weights
+            and the embedding tables of the model on the transparent huge
+            pages, see :func:`enable_huge_pages`, which is enabled for the
+            weights packed afterwards, e.g. of the TorchScript op contexts,
+            too. The default value is ``None``, meaning the setting of
+            :func:`enable_huge_pages` is kept.
 
     Returns:
         Model and optimizer (if given) modified according to the ``level`` knob
@@ -225,6 +290,25 @@ def optimize(
         opt_properties.fuse_update_step = fuse_update_step
     if auto_kernel_selection is not None:
         opt_properties.auto_kernel_selection = auto_kernel_selection
+    if lazy_weights_prepack is not None:
+        opt_properties.lazy_weights_prepack = lazy_weights_prepack
+    if memory_format not in (None, "auto"):
+        raise RuntimeError(
+            "Unexpected memory_format {}. ".format(memory_format) +
+            "Options are None, 'auto'.")
+
+    # The input shapes are recorded on the model as given, since optimize
+    # may convert its dtype and modules below.
+    input_shapes = None
+    if opt_properties.auto_kernel_selection and not model.training and \
+            (sample_input is not None or kernel_selection_recipe is not None):
+        input_shapes = {}
+        if sample_input is not None:
+            input_shapes = utils._kernel_selection.record_input_shapes(model, sample_input)
+    elif (sample_input is not None and not analyze_reorders and memory_format is None) or \
+            kernel_selection_recipe is not None:
+        warnings.warn("sample_input and kernel_selection_recipe only work for the inference model " +
+                      "with auto_kernel_selection, will choose the kernels by the default heuristics")
 
     if inplace:
         optimized_model = model
@@ -238,13 +322,20 @@ def optimize(
                 optimized_model = optimization.fuse(optimized_model, inplace=inplace)
             except:
                 warnings.warn("Conv BatchNorm folding failed during the optimize process.")
+            try:
+                optimized_model = utils._model_convert.fold_conv_frozen_bn(optimized_model)
+            except:
+                warnings.warn("Conv FrozenBatchNorm folding failed during the optimize process.")
         if opt_properties.replace_dropout_with_identity:
             utils._model_convert.replace_dropout_with_identity(optimized_model)
         if dtype == torch.bfloat16:
             optimized_model = utils._model_convert.convert_module_data_type(optimized_model, torch.bfloat16)
 
+    if model.training and opt_properties.optimize_dropout:
+        utils._model_convert.replace_dropout_with_ipex_dropout(optimized_model)
     if opt_properties.optimize_lstm:
         utils._model_convert.replace_lstm_with_ipex_lstm(optimized_model)
+        utils._model_convert.replace_rnn_with_ipex_rnn(optimized_model)
     if model.training and opt_properties.split_master_weight_for_bf16 and dtype is torch.bfloat16:
         if not opt_properties.fuse_update_step:
             opt_properties.split_master_weight_for_bf16 = False
@@ -260,14 +351,45 @@ def optimize(
                 "IPEX does not support fused/fused split update for" + str(type(optimizer)) +
                 "will use non-fused master weight update for bf16 training")
 
+    if memory_format == "auto":
+        utils._model_convert.convert_to_channels_last(optimized_model)
+    if huge_pages is not None:
+        enable_huge_pages(huge_pages)
+        if huge_pages:
+            if not is_huge_pages_available():
+                warnings.warn("The transparent huge pages are disabled by the system, " +
+                              "the weights stay on the 4 KB pages")
+            _embedding_tables_to_huge_pages(optimized_model)
+
     # convert optimizer for training case.
     params_attr = {}
     if dtype == torch.bfloat16 and model.training:
         optimized_model, optimized_optimizer, params_attr = utils._weight_cast.weight_dtype_convert_with_ipex(
             optimized_model, optimized_optimizer, params_attr, opt_properties.split_master_weight_for_bf16)
     if opt_properties.weights_prepack:
+        kernel_selection = None
+        if input_shapes is not None:
+            kernel_selection = utils._kernel_selection.select_kernels(
+                optimized_model, input_shapes, kernel_selection_recipe)
         optimized_model, optimized_optimizer, params_attr = utils._weight_prepack.weight_prepack_with_ipex(
-          optimized_model, optimized_optimizer, params_attr, opt_properties.auto_kernel_selection)
+          optimized_model, optimized_optimizer, params_attr, opt_properties.auto_kernel_selection,
+          opt_properties.lazy_weights_prepack, kernel_selection)
+        if not model.training:
+            utils._model_convert.fuse_linear_gelu(optimized_model)
+    if memory_format == "auto" and sample_input is not None and not model.training:
+        islands = utils._model_convert.find_plain_format_islands(optimized_model, sample_input)
+        optimized_model.memory_format_report = islands
+        if islands:
+            warnings.warn("The layers below give the plain outputs of the channels last inputs:\n" +
+                          "\n".join("  {} ({})".format(name, type_name) for name, type_name in islands))
+    if analyze_reorders:
+        if model.training or sample_input is None:
+            warnings.warn("analyze_reorders only works for the inference model with sample_input")
+        else:
+            report = utils._reorder_analysis.analyze_reorders(optimized_model, sample_input)
+            optimized_model.reorder_report = report
+            if any(e['direction'] != utils._reorder_analysis.WEIGHT for e in report.edges):
+                warnings.warn("The model has the reorders of the activations between its layers:\n" + str(report))
     # TODO: model list, optimizer list.
     if optimizer is None:
         return optimized_model
@@ -302,3 +424,199 @@ def enable_onednn_fusion(enabled):
         core.enable_jit_opt()
     else:
         core.disable_jit_opt()
+
+def enable_branch_parallel(enabled):
+    r"""
+    Enables or disables the inter-op parallel execution of the independent
+    branches in the TorchScript graph, e.g. the embedding bags before the
+    interaction of DLRM or the parallel towers of Inception.
+
+    If enabled, the independent branches feeding the same operator are
+    forked after the IPEX fusion pass, and run concurrently on the inter-op
+    threads of PyTorch. If the calling thread is pinned by the runtime
+    extension, e.g. inside :class:`intel_extension_for_pytorch.cpu.runtime.pin`
+    or a :class:`intel_extension_for_pytorch.cpu.runtime.Task`, each branch
+    is pinned to a disjoint slice of its cores. Otherwise each branch uses its
+    share of the OMP threads. It only takes effect on the graphs optimized
+    afterwards.
+
+    Args:
+        enabled (bool): Whether to run the independent branches concurrently
+            or not. Default value is ``False``.
+
+    Examples:
+
+        >>> import intel_extension_for_pytorch as ipex
+        >>> ipex.enable_branch_parallel(True)
+        >>> traced_model = torch.jit.freeze(torch.jit.trace(model, x))
+        >>> with ipex.cpu.runtime.pin(ipex.cpu.runtime.CPUPool(node_id=0)):
+        ...     y = traced_model(x)
+    """
+
+    if enabled:
+        core.enable_jit_branch_parallel()
+    else:
+        core.disable_jit_branch_parallel()
+
+def enable_memory_planning(enabled):
+    r"""
+    Enables or disables the static memory planning of the TorchScript
+    inference graph. If enabled, the intermediate tensors of the optimized
+    graph are placed in one preallocated arena for the input shapes the graph
+    is profiled with, and the space of each tensor is reused right after its
+    last use. The operators producing them, e.g. the prepacked convolution and
+    linear, the element-wise ops and matmul, write into the arena through
+    their out variants, so that no allocation happens for them in the
+    following runs. Each thread running the graph keeps its own arena. The
+    runs with other input shapes allocate as usual. It only takes effect on
+    the graphs optimized afterwards.
+
+    Args:
+        enabled (bool): Whether to plan the memory of the intermediates or
+            not. Default value is ``False``.
+
+    Examples:
+
+        >>> import intel_extension_for_pytorch as ipex
+        >>> ipex.enable_memory_planning(True)
+        >>> traced_model = torch.jit.freeze(torch.jit.trace(model, x))
+        >>> with torch.no_grad():
+        ...     y = traced_model(x)
+    """
+
+    if enabled:
+        core.enable_jit_memory_plan()
+    else:
+        core.disable_jit_memory_plan()
+
+def enable_conv_algorithm_selection(enabled):
+    r"""
+    Enables or disables the selection of the algorithm of the prepacked fp32 3x3
+    convolutions of stride 1 in inference. If enabled, the op context of such
+    a convolution of a large input, e.g. of super-resolution or segmentation
+    models, times the winograd algorithm of oneDNN against the direct one on
+    the input shape it is prepacked for, and keeps the faster, with the weight
+    prepacked in the format of that algorithm. The winograd convolution takes
+    fewer FLOPs but rounds differently from the direct one. It only takes
+    effect on the convolutions prepacked afterwards, and the other input shapes
+    of a convolution run with the direct algorithm.
+
+    Args:
+        enabled (bool): Whether to select the algorithm of the convolutions or
+            not. Default value is ``False``.
+
+    Examples:
+
+        >>> import intel_extension_for_pytorch as ipex
+        >>> ipex.enable_conv_algorithm_selection(True)
+        >>> model = ipex.optimize(model.eval())
+        >>> with torch.no_grad():
+        ...     traced_model = torch.jit.freeze(torch.jit.trace(model, x))
+        ...     y = traced_model(x)
+    """
+
+    if enabled:
+        core.enable_conv_algorithm_selection()
+    else:
+        core.disable_conv_algorithm_selection()
+
+def enable_sparse_linear(enabled):
+    r"""
+    Enables or disables the block-sparse linear of the prepacked fp32 linear
+    layers. If enabled, the op context of a linear measures the zero blocks of
+    its weight at prepack time, of which a block is 16 consecutive output
+    channels of an input feature, and packs the weight of at least 75% zero
+    blocks, e.g. of the models pruned in those blocks, into the nonzero blocks
+    only. The block-sparse linear skips the zero blocks, of which the FLOPs
+    and the weight bytes are saved. It's enabled by default.
+
+    Args:
+        enabled (bool): Whether to pack the sparse linear weights into the
+            block-sparse format.
+
+    Examples:
+
+        >>> import intel_extension_for_pytorch as ipex
+        >>> ipex.enable_sparse_linear(False)
+        >>> model = ipex.optimize(model.eval())
+        >>> with torch.no_grad():
+        ...     traced_model = torch.jit.freeze(torch.jit.trace(model, x))
+        ...     y = traced_model(x)
+    """
+
+    if enabled:
+        core.enable_sparse_linear()
+    else:
+        core.disable_sparse_linear()
+
+def enable_weight_only_quantization(enabled, dtype='int8', group_size=128):
+    r"""
+    Enables or disables the weight-only quantization of the linear layers in
+    the TorchScript graph. If enabled, the constant weight of each linear
+    layer, e.g. of a frozen model, is quantized to int8 with one scale per
+    output channel, or to 4 bits with one scale per group of input features,
+    while the activations stay in fp32 or bf16. The quantized weight is
+    dequantized on the fly while computing the linear, so that the memory
+    bandwidth bound linear layers, e.g. of the decoder of a transformer with a
+    small batch, read 4x (fp32) or 2x (bf16) less weight bytes of int8, and 8x
+    or 4x less of 4 bits. It trades accuracy for speed, and only takes effect
+    on the graphs optimized afterwards.
+
+    Args:
+        enabled (bool): Whether to quantize the linear weights or not.
+            Default value is ``False``.
+        dtype (str): The dtype of the quantized weights, ``'int8'``,
+            ``'int4'`` of the signed [-8, 7] levels, or ``'nf4'`` of the 16
+            NormalFloat levels of QLoRA, which suits the normally distributed
+            weights better. Default value is ``'int8'``.
+        group_size (int): The input features of which each 4-bit scale is,
+            i.e. the absmax of them. The weight is quantized per output
+            channel if it is not an even divisor of the input features.
+            Ignored by int8. Default value is ``128``.
+
+    Examples:
+
+        >>> import intel_extension_for_pytorch as ipex
+        >>> ipex.enable_weight_only_quantization(True, dtype='nf4')
+        >>> traced_model = torch.jit.freeze(torch.jit.trace(model, x))
+        >>> y = traced_model(x)
+    """
+
+    assert dtype in ['int8', 'int4', 'nf4'], \
+        "The weight-only quantization dtype must be int8, int4 or nf4"
+    core.set_jit_weight_only_quantization_dtype(dtype, group_size)
+    if enabled:
+        core.enable_jit_weight_only_quantization()
+    else:
+        core.disable_jit_weight_only_quantization()
+
+def enable_dynamic_quantization(enabled):
+    r"""
+    Enables or disables the dynamic quantization of the linear layers in the
+    TorchScript graph. If enabled, the constant weight of each linear layer,
+    e.g. of a frozen model, is quantized to int8 with one scale per output
+    channel and packed once, while the input of the linear layer is quantized
+    to uint8 on each call with the range of the input, and the linear layer
+    is computed by the int8 GEMM of oneDNN. Since the ranges of the inputs are
+    computed on the fly, it needs no calibration, and suits the models of
+    which the ranges of the activations vary too much for static scales, e.g.
+    transformers. It trades accuracy for speed, takes precedence over the
+    weight-only quantization, and only takes effect on the graphs optimized
+    or loaded afterwards.
+
+    Args:
+        enabled (bool): Whether to quantize the linear layers dynamically or
+            not. Default value is ``False``.
+
+    Examples:
+
+        >>> import intel_extension_for_pytorch as ipex
+        >>> ipex.enable_dynamic_quantization(True)
+        >>> traced_model = torch.jit.freeze(torch.jit.trace(model, x))
+        >>> y = traced_model(x)
+    """
+
+    if enabled:
+        core.enable_jit_dynamic_quantization()
+    else:
+        core.disable_jit_dynamic_quantization()
@@ -1,2 +1,9 @@
 from .interaction import interaction, InteractionFunc
 from . import _embeddingbag, _tensor_method, _roi_align
+from .bias_dropout_add_layer_norm import bias_dropout_add_layer_norm
+from .dropout import dropout
+from .batched_nms import batched_nms
+from .rms_norm import rms_norm, add_rms_norm
+from .softmax_cross_entropy import softmax_cross_entropy
+from .decode_attention import decode_attention
+from .block_sparse_attention import block_sparse_attention
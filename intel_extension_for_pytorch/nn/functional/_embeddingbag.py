@@ -5,8 +5,14 @@ import warnings
 torch_embedding_bag = torch.embedding_bag
 
 def _embeddingbag(weights, indices, offsets, scale_grad_by_freq, mode, sparse, per_sample_weights, include_last_offset, padding_idx):
-    if core.embedding_bag_fast_path_sum(weights, per_sample_weights, mode, padding_idx):
-        ret = torch.ops.torch_ipex.embedding_bag(weights, indices, offsets, sparse, include_last_offset)
+    if core.embedding_bag_fast_path(weights, per_sample_weights, mode, scale_grad_by_freq, sparse):
+        if mode == 0 and per_sample_weights is None and padding_idx is None:
+            ret = torch.ops.torch_ipex.embedding_bag(weights, indices, offsets, sparse, include_last_offset)
+        else:
+            # the mean, the max and the per sample weighted sum, of which -1 is no padding_idx
+            ret = torch.ops.torch_ipex.embedding_bag_pooling(
+                weights, indices, offsets, per_sample_weights, mode,
+                -1 if padding_idx is None else padding_idx, sparse, include_last_offset)
         # torch.embedding_bag expected 4 Tensor returned
         # here we only return 1 tensor since the other three tensors are not needed in our fast path
         ret = [ret, torch.Tensor(), torch.Tensor(), torch.Tensor()]
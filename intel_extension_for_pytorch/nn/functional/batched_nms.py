@@ -0,0 +1,27 @@
+import torch
+from torch import Tensor
+
+def batched_nms(boxes: Tensor, scores: Tensor, idxs: Tensor, iou_threshold: float) -> Tensor:
+    r"""
+    Get ``torchvision.ops.batched_nms(boxes, scores, idxs, iou_threshold)`` in
+    one op, i.e. the non-maximum suppression of the boxes of each group of
+    ``idxs``, e.g. of each image and class of a detection batch, of which the
+    groups run in parallel across the threads, each with the vectorized IoU
+    of the IPEX NMS, instead of the Python loop over the groups or the NMS of
+    all the offset boxes at once. It can be called in eager mode and in
+    TorchScript.
+
+    Args:
+        boxes (Tensor): the boxes in ``(x1, y1, x2, y2)`` format, of shape
+            :math:`(N, 4)`
+        scores (Tensor): the score of each box, of shape :math:`(N)`
+        idxs (Tensor): the group of each box, of shape :math:`(N)`, of which
+            the boxes of different groups don't suppress each other
+        iou_threshold (float): the boxes of IoU > iou_threshold with a box of a
+            higher score of the same group are suppressed
+
+    Returns:
+        Tensor: the int64 indices of the kept boxes, in the descending order
+        of the scores
+    """
+    return torch.ops.torch_ipex.batched_nms(boxes, scores, idxs, iou_threshold)
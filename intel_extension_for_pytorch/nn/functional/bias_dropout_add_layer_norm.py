@@ -0,0 +1,32 @@
+from typing import List, Optional
+
+import torch
+from torch import Tensor
+
+def bias_dropout_add_layer_norm(input: Tensor, bias: Optional[Tensor], residual: Tensor, p: float,
+                                training: bool, normalized_shape: List[int], weight: Optional[Tensor],
+                                ln_bias: Optional[Tensor], eps: float = 1e-5) -> Tensor:
+    r"""
+    Get ``layer_norm(residual + dropout(input + bias, p, training))`` in one op,
+    e.g. the output projection of the attention or of the FFN of BERT, of which
+    the linear is run without its bias.
+
+    The mean and the variance of the rows are collected in the same pass over
+    the input and the residual as the bias, the dropout and the add, and the
+    backward, if any, gives the grads of all the inputs and params in one op
+    as well. It can be called in eager mode and in TorchScript.
+
+    Args:
+        input (Tensor): the output of the linear, of shape :math:`(*, N)`
+        bias (Tensor, optional): the bias of the linear, of :math:`N` elements
+        residual (Tensor): the residual, of the shape of input
+        p (float): the probability of an element to be zeroed by the dropout
+        training (bool): apply the dropout if ``True``
+        normalized_shape (List[int]): the trailing dims of input normalized
+        weight (Tensor, optional): the scale of the layer_norm
+        ln_bias (Tensor, optional): the shift of the layer_norm
+        eps (float): a value added to the variance for numerical stability.
+            Default: 1e-5
+    """
+    return torch.ops.torch_ipex.bias_dropout_add_layer_norm(
+        input, bias, residual, p, training, normalized_shape, weight, ln_bias, eps)
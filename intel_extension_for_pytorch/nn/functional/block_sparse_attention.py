@@ -0,0 +1,33 @@
+import math
+from typing import Optional
+
+import torch
+from torch import Tensor
+
+def block_sparse_attention(query: Tensor, key: Tensor, value: Tensor, layout: Tensor, block_size: int,
+                           scale: Optional[float] = None, attn_mask: Optional[Tensor] = None) -> Tensor:
+    r"""
+    Get ``softmax(query @ key.transpose(-2, -1) * scale + attn_mask) @ value``
+    of the block-sparse attention, e.g. the local, the banded or the BigBird
+    attention of the long documents, for inference.
+
+    The scores are in blocks of ``block_size x block_size``, of which the ones
+    of 0 in ``layout`` are masked out. They are skipped in both the
+    ``query @ key`` and the ``@ value``, instead of computed and masked.
+
+    Args:
+        query (Tensor): the query, of shape :math:`(B, H, L_q, D)`
+        key (Tensor): the key, of shape :math:`(B, H, L_k, D)`
+        value (Tensor): the value, of shape :math:`(B, H, L_k, D_v)`
+        layout (Tensor): the blocks kept, of shape
+            :math:`(H, \lceil L_q / block\_size \rceil, \lceil L_k / block\_size \rceil)`,
+            or with a leading dim of :math:`B`, the dims of 1 broadcast
+        block_size (int): the size of the blocks
+        scale (float, optional): the scale of the scores, :math:`1 / \sqrt{D}`
+            if not given
+        attn_mask (Tensor, optional): the additive mask broadcast to the
+            scores, e.g. of the padding
+    """
+    if scale is None:
+        scale = 1.0 / math.sqrt(query.size(-1))
+    return torch.ops.torch_ipex.block_sparse_mha(query, key, value, layout, block_size, scale, attn_mask)
@@ -0,0 +1,35 @@
+import torch
+from torch import Tensor
+
+def decode_attention(query: Tensor, key: Tensor, value: Tensor, key_cache: Tensor, value_cache: Tensor,
+                     block_table: Tensor, seq_lens: Tensor, scale: float, key_scale: Tensor,
+                     value_scale: Tensor) -> Tensor:
+    r"""
+    Get the attention of a decode step of the autoregressive generation, of
+    the single query token of each sequence over its paged KV cache, see
+    :class:`intel_extension_for_pytorch.nn.modules.PagedKVCache` for the cache.
+
+    The key and the value of the new token are written in place to the cache
+    at ``seq_lens``, and the query attends to the ``seq_lens + 1`` cached
+    tokens block by block by the online softmax, so that nothing is
+    concatenated or reallocated per step. ``seq_lens`` is not updated.
+
+    Args:
+        query (Tensor): the query of the new token, of shape :math:`(B, H, D)`
+        key (Tensor): the key of the new token, of the shape of query
+        value (Tensor): the value of the new token, of the shape of query
+        key_cache (Tensor): the keys of float, bfloat16 or int8 of shape
+            :math:`(num\_blocks, H, block\_size, D)`
+        value_cache (Tensor): the values of the shape and dtype of key_cache
+        block_table (Tensor): the blocks of each sequence, of shape
+            :math:`(B, max\_blocks\_per\_seq)`
+        seq_lens (Tensor): the cached tokens of each sequence before the step,
+            of shape :math:`(B)`
+        scale (float): the scale of the scores, e.g. :math:`1 / \sqrt{D}`
+        key_scale (Tensor): the float scales of the int8 keys per token and
+            head, of shape :math:`(num\_blocks, H, block\_size)`, unused for
+            the other dtypes
+        value_scale (Tensor): the scales of the int8 values as key_scale
+    """
+    return torch.ops.torch_ipex.decode_attention(
+        query, key, value, key_cache, value_cache, block_table, seq_lens, scale, key_scale, value_scale)
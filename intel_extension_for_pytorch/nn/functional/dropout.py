@@ -0,0 +1,20 @@
+import torch
+from torch import Tensor
+
+def dropout(input: Tensor, p: float = 0.5, training: bool = True) -> Tensor:
+    r"""
+    Get ``torch.nn.functional.dropout(input, p, training)`` of the 1 bit per
+    element mask, of which the bits are generated by the counter-based Philox
+    of the vectors of the kernel and are the only thing saved for the
+    backward, instead of the float mask of the input dtype of
+    ``aten::dropout``. The mask of each call is of a seed drawn from the
+    default CPU generator, so that ``torch.manual_seed`` reproduces it. It can
+    be called in eager mode and in TorchScript.
+
+    Args:
+        input (Tensor): the input, of which the fp32 and the bf16 ones run the
+            IPEX kernel and the others ``aten::dropout``
+        p (float): the probability of an element to be zeroed. Default: 0.5
+        training (bool): apply the dropout if ``True``. Default: ``True``
+    """
+    return torch.ops.torch_ipex.dropout(input, p, training)
@@ -0,0 +1,36 @@
+from typing import Optional, Tuple
+
+import torch
+from torch import Tensor
+
+def rms_norm(input: Tensor, weight: Optional[Tensor], eps: float = 1e-6) -> Tensor:
+    r"""
+    Get ``input * rsqrt(mean(input^2, -1, keepdim=True) + eps) * weight``, the
+    RMSNorm of the last dim of e.g. LLaMA and T5, in one op.
+
+    The bfloat16 rows are accumulated in float, and the output is of the dtype
+    of input. It can be called in eager mode and in TorchScript.
+
+    Args:
+        input (Tensor): the input, of shape :math:`(*, N)`
+        weight (Tensor, optional): the scale, of :math:`N` elements
+        eps (float): a value added to the mean square for numerical stability.
+            Default: 1e-6
+    """
+    return torch.ops.torch_ipex.rms_norm(input, weight, eps)
+
+def add_rms_norm(input: Tensor, residual: Tensor, weight: Optional[Tensor],
+                 eps: float = 1e-6) -> Tuple[Tensor, Tensor]:
+    r"""
+    Get ``(rms_norm(input + residual, weight, eps), input + residual)`` in one
+    op, the residual add and the norm of the pre-norm transformer blocks, of
+    which the sum is the residual of the next block.
+
+    Args:
+        input (Tensor): the input, of shape :math:`(*, N)`
+        residual (Tensor): the residual, of the shape of input
+        weight (Tensor, optional): the scale, of :math:`N` elements
+        eps (float): a value added to the mean square for numerical stability.
+            Default: 1e-6
+    """
+    return torch.ops.torch_ipex.add_rms_norm(input, residual, weight, eps)
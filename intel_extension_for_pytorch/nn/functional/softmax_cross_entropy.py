@@ -0,0 +1,26 @@
+import torch
+from torch import Tensor
+from torch.nn import _reduction as _Reduction
+
+def softmax_cross_entropy(input: Tensor, target: Tensor, reduction: str = 'mean',
+                          ignore_index: int = -100) -> Tensor:
+    r"""
+    Get ``cross_entropy(input, target, reduction=reduction, ignore_index=ignore_index)``
+    in one op, e.g. the loss of the classifier or of the LM head of a large
+    vocabulary.
+
+    The logsumexp of each row of the logits is found by the online softmax in
+    a single read of the row, and it is the only activation saved for the
+    backward, which recomputes ``softmax(input) - one_hot(target)`` on the fly
+    instead of keeping the softmax of the logits. The logits of other shapes
+    or dtypes fall back to ``torch.nn.functional.cross_entropy``.
+
+    Args:
+        input (Tensor): the logits, of shape :math:`(M, C)`
+        target (Tensor): the class indices, of shape :math:`(M)`
+        reduction (str): ``'none'``, ``'mean'`` or ``'sum'``. Default: ``'mean'``
+        ignore_index (int): the target ignored, not counted by the mean.
+            Default: -100
+    """
+    return torch.ops.torch_ipex.softmax_cross_entropy(
+        input, target, _Reduction.get_enum(reduction), ignore_index)
@@ -1,4 +1,8 @@
 from .frozen_batch_norm import FrozenBatchNorm2d
 from . import _roi_align
-from .merged_embeddingbag import MergedEmbeddingBagWithSGD
+from .merged_embeddingbag import MergedEmbeddingBagWithSGD, MergedEmbeddingBagWithRowwiseAdagrad, \
+    MergedEmbeddingBagWithAdam, MergedEmbeddingBagWithLAMB
+from .distributed_merged_embeddingbag import DistributedMergedEmbeddingBagWithSGD
 from .linear_fuse_eltwise import IPEXLinearEltwise
+from .conv_bn_relu import IPEXConvBatchNormReLU
+from .paged_kv_cache import PagedKVCache
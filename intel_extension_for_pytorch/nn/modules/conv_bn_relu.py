@@ -0,0 +1,48 @@
+import torch
+import intel_extension_for_pytorch as ipex  # noqa F401
+from ..utils._weight_prepack import _IPEXConv2d as _IPEXConv2d
+
+class IPEXConvBatchNormReLU(torch.nn.Module):
+    r"""
+    relu(bn(conv(x))) of an ipex optimized Conv2d and a BatchNorm2d, the
+    batch stats and the normalization are computed in the same op as the
+    convolution, also in training.
+    """
+
+    def __init__(self, ipex_conv_module, bn_module):
+        super(IPEXConvBatchNormReLU, self).__init__()
+        assert isinstance(ipex_conv_module, _IPEXConv2d)
+        assert isinstance(bn_module, torch.nn.BatchNorm2d)
+        assert bn_module.affine and bn_module.track_running_stats
+        self.m = ipex_conv_module
+        self.bn = bn_module
+
+    def forward(self, x):
+        if not self.m.weight_packed:
+            self.m._pack_weight_lazily()
+        bn = self.bn
+        momentum = 0.0 if bn.momentum is None else bn.momentum
+        if self.training:
+            bn.num_batches_tracked.add_(1)
+            if bn.momentum is None:
+                # the cumulative moving average, as torch.nn.BatchNorm2d
+                momentum = 1.0 / float(bn.num_batches_tracked)
+        return torch.ops.torch_ipex.conv_bn_relu_forward(
+            x,
+            self.m.weight,
+            self.m.bias,
+            self.m.stride,
+            self.m.padding,
+            self.m.dilation,
+            self.m.kernel_size,
+            self.m.groups,
+            self.m.out_channels,
+            self.m.weight_channels_last,
+            self.m.weight_packed,
+            bn.weight,
+            bn.bias,
+            bn.running_mean,
+            bn.running_var,
+            self.training,
+            momentum,
+            bn.eps)
@@ -0,0 +1,220 @@
+import torch
+import torch.distributed as dist
+from torch import Tensor, nn
+from torch.autograd import Function
+from typing import List, Optional
+from .merged_embeddingbag import EmbeddingSpec, MergedEmbeddingBagWithSGD
+
+def shard_tables(embedding_specs: List[EmbeddingSpec], world_size: int):
+    r"""
+    Assign each table to a rank, the largest tables first to the rank of the fewest bytes so far, so that
+    the ranks hold about the same bytes. Return the tables of each rank in the ascending order.
+    """
+    def table_bytes(emb):
+        return emb.num_of_features * emb.feature_size * torch.empty(0, dtype=emb.dtype).element_size()
+
+    rank_bytes = [0] * world_size
+    shards = [[] for r in range(world_size)]
+    for i in sorted(range(len(embedding_specs)), key=lambda i: (-table_bytes(embedding_specs[i]), i)):
+        rank = min(range(world_size), key=lambda r: (rank_bytes[r], r))
+        shards[rank].append(i)
+        rank_bytes[rank] += table_bytes(embedding_specs[i])
+    return [sorted(shard) for shard in shards]
+
+def _bag_lengths(indice, offset, include_last_offset):
+    r"""
+    The flattened indices and the number of indices of each bag of a table in the EmbeddingBag input format.
+    """
+    if indice.dim() == 2:
+        assert offset is None, "offset should be None if indice is 2-D tensor, https://github.com/pytorch/pytorch/blob/master/torch/nn/modules/sparse.py#L355-L382"
+        return indice.reshape(-1), torch.full((indice.shape[0],), indice.shape[1], dtype=torch.int64)
+    if not include_last_offset:
+        offset = torch.cat([offset, torch.tensor([indice.numel()], dtype=offset.dtype)])
+    return indice, (offset[1:] - offset[:-1]).to(torch.int64)
+
+class _AllToAllPooledFunc(Function):
+    r"""
+    The pooled outputs of the bags of this rank received by the request. The backward sends the grads of
+    the outputs back to the ranks of the tables.
+    """
+    @staticmethod
+    def forward(ctx, request, *local_outputs):
+        ctx.request = request
+        return request.recv_buffer
+
+    @staticmethod
+    def backward(ctx, grad_recv):
+        request = ctx.request
+        grad_send = grad_recv.new_empty(sum(request.send_splits))
+        dist.all_to_all_single(
+            grad_send, grad_recv.contiguous(), request.send_splits, request.recv_splits, group=request.group)
+        grads = request.split_send_buffer(grad_send)
+        return (None, *grads)
+
+class PooledOutputsRequest(object):
+    r"""
+    The all-to-all in flight of the pooled outputs of a DistributedMergedEmbeddingBagWithSGD, from the
+    ranks of the tables to the ranks of the bags. wait() returns the outputs of all the tables for the bags of
+    this rank.
+    """
+    def __init__(self, module, local_outputs, batch_size):
+        self.module = module
+        self.group = module.group
+        self.local_outputs = local_outputs
+        self.batch_size = batch_size
+        world_size = module.world_size
+        dtype = module.output_dtype
+        local_feature_size = sum(module.feature_sizes[i] for i in module.shards[module.rank])
+        self.send_splits = [batch_size * local_feature_size] * world_size
+        self.recv_splits = [
+            batch_size * sum(module.feature_sizes[i] for i in module.shards[r]) for r in range(world_size)]
+        # the rows of the bags of each rank, of the tables of this rank
+        with torch.no_grad():
+            send_buffer = torch.cat([
+                out[r * batch_size:(r + 1) * batch_size].to(dtype).reshape(-1)
+                for r in range(world_size) for out in local_outputs]) if local_outputs else \
+                torch.empty(0, dtype=dtype)
+        self.recv_buffer = torch.empty(sum(self.recv_splits), dtype=dtype)
+        self.work = dist.all_to_all_single(
+            self.recv_buffer, send_buffer, self.recv_splits, self.send_splits, group=self.group, async_op=True)
+
+    def split_send_buffer(self, buffer):
+        r"""
+        The grads of the local outputs of the tables of this rank from the layout of the send buffer.
+        """
+        world_size = self.module.world_size
+        chunks = buffer.split([
+            self.batch_size * out.shape[1] for r in range(world_size) for out in self.local_outputs])
+        n_local = len(self.local_outputs)
+        return [
+            torch.cat([chunks[r * n_local + t].view(self.batch_size, -1) for r in range(world_size)]).to(out.dtype)
+            for t, out in enumerate(self.local_outputs)]
+
+    def wait(self):
+        self.work.wait()
+        module = self.module
+        recv = _AllToAllPooledFunc.apply(self, *self.local_outputs)
+        chunks = recv.split([
+            self.batch_size * module.feature_sizes[i] for r in range(module.world_size) for i in module.shards[r]])
+        outputs = [None] * module.n_tables
+        tables = [i for r in range(module.world_size) for i in module.shards[r]]
+        for chunk, i in zip(chunks, tables):
+            outputs[i] = chunk.view(self.batch_size, -1).to(module.dtypes[i])
+        return outputs
+
+class DistributedMergedEmbeddingBagWithSGD(nn.Module):
+    r"""
+    MergedEmbeddingBagWithSGD of which the tables are sharded across the ranks of a process group, e.g. of
+    the ccl backend set up by launch.py --distributed, so that a rank only holds its shard of the tables
+    (model parallel) while the dense layers are replicated (data parallel).
+    Each rank feeds the bags of its own part of the batch, of all the tables:
+        >>> merged_emb = DistributedMergedEmbeddingBagWithSGD.from_embeddingbag_list(tables)
+        >>> request = merged_emb.forward_async((indices, offsets, include_last_offsets))
+        >>> dense_out = bottom_mlp(dense_input)  # overlaps with the all-to-all of the pooled outputs
+        >>> emb_outputs = request.wait()
+    The indices are exchanged with an all-to-all to the ranks of their tables, each rank pools the bags of
+    the whole batch of its tables with MergedEmbeddingBagWithSGD, and the pooled outputs return with
+    another all-to-all, of which the backward sends the grads back for the fused update. The tables are
+    sharded as a whole, each rank must own at least one table, and the ranks must feed the same batch size.
+    """
+    def __init__(
+        self,
+        embedding_specs: List[EmbeddingSpec],
+        lr: float = 0.01,
+        weight_decay: float = 0,
+        group: Optional[dist.ProcessGroup] = None
+    ):
+        super(DistributedMergedEmbeddingBagWithSGD, self).__init__()
+        self.group = group
+        self.rank = dist.get_rank(group)
+        self.world_size = dist.get_world_size(group)
+        self.n_tables = len(embedding_specs)
+        assert self.n_tables >= self.world_size, \
+            r"DistributedMergedEmbeddingBagWithSGD expects at least one table for each rank"
+        self.feature_sizes = [emb.feature_size for emb in embedding_specs]
+        self.dtypes = [emb.dtype for emb in embedding_specs]
+        # the pooled outputs of all the tables are exchanged in one buffer
+        self.output_dtype = self.dtypes[0]
+        for dtype in self.dtypes[1:]:
+            self.output_dtype = torch.promote_types(self.output_dtype, dtype)
+        self.shards = shard_tables(embedding_specs, self.world_size)
+        self.local_tables = self.shards[self.rank]
+        self.merged_emb = MergedEmbeddingBagWithSGD(
+            [embedding_specs[i] for i in self.local_tables], lr, weight_decay)
+
+    def exchange_indices(self, input):
+        r"""
+        Send the indices of the bags of this rank to the ranks of their tables, and return the indices of the
+        tables of this rank for the bags of all the ranks, in the order of the ranks, in the input format of
+        MergedEmbeddingBag, with the batch size of this rank.
+        """
+        indices, offsets, include_last_offsets = input
+        assert self.n_tables == len(indices), "expected {} but got {} indices".format(self.n_tables, len(indices))
+        flat = [_bag_lengths(idx, offset, include_last) for idx, offset, include_last in zip(indices, offsets, include_last_offsets)]
+        batch_size = flat[0][1].numel()
+        assert all(lengths.numel() == batch_size for _, lengths in flat), \
+            r"MergedEmbeddingBag only support input with same batch size"
+
+        # the number of indices of each bag first, then the indices
+        send_lengths = torch.cat([flat[i][1] for r in range(self.world_size) for i in self.shards[r]])
+        send_length_splits = [len(self.shards[r]) * batch_size for r in range(self.world_size)]
+        recv_length_splits = [len(self.local_tables) * batch_size] * self.world_size
+        recv_lengths = torch.empty(sum(recv_length_splits), dtype=torch.int64)
+        dist.all_to_all_single(recv_lengths, send_lengths, recv_length_splits, send_length_splits, group=self.group)
+
+        send_indices = torch.cat([flat[i][0].to(torch.int64) for r in range(self.world_size) for i in self.shards[r]])
+        send_splits = [sum(int(flat[i][1].sum()) for i in self.shards[r]) for r in range(self.world_size)]
+        recv_lengths = recv_lengths.view(self.world_size, len(self.local_tables), batch_size)
+        table_lengths = recv_lengths.sum(dim=2)
+        recv_splits = table_lengths.sum(dim=1).tolist()
+        recv_indices = torch.empty(sum(recv_splits), dtype=torch.int64)
+        dist.all_to_all_single(recv_indices, send_indices, recv_splits, send_splits, group=self.group)
+
+        # from the order of the ranks and then the tables to the order of the tables and then the ranks
+        chunks = recv_indices.split(table_lengths.view(-1).tolist())
+        n_local = len(self.local_tables)
+        local_indices = [
+            torch.cat([chunks[r * n_local + t] for r in range(self.world_size)]) for t in range(n_local)]
+        local_offsets = [
+            torch.ops.torch_ipex.lengths_to_offsets(recv_lengths[:, t].reshape(-1)) for t in range(n_local)]
+        return (local_indices, local_offsets, [True] * n_local), batch_size
+
+    def forward_async(self, input):
+        r"""
+        Args:
+            input (Tuple[List[Tensor]]): (indices, offsets, include_last_offsets) of the bags of this rank of
+            all the tables, in the format of MergedEmbeddingBag.linearize_indices_and_offsets.
+        Returns:
+            PooledOutputsRequest of which wait() returns the List[Tensor] outputs of shape
+            `(batch_size, feature_size)` of all the tables.
+        """
+        local_input, batch_size = self.exchange_indices(input)
+        local_outputs = self.merged_emb(local_input)
+        return PooledOutputsRequest(self, local_outputs, batch_size)
+
+    def forward(self, input):
+        return self.forward_async(input).wait()
+
+    @classmethod
+    def from_embeddingbag_list(
+        cls,
+        tables: List[torch.nn.EmbeddingBag],
+        lr: float = 0.01,
+        weight_decay: float = 0,
+        group: Optional[dist.ProcessGroup] = None
+    ):
+        embedding_specs = []
+        for emb in tables:
+            emb_shape = emb.weight.shape
+            embedding_specs.append(
+                EmbeddingSpec(
+                    num_of_features=emb_shape[0],
+                    feature_size=emb_shape[1],
+                    pooling_modes=emb.mode,
+                    dtype=emb.weight.dtype,
+                    weight=emb.weight.detach()
+                ))
+        return cls(embedding_specs, lr, weight_decay, group)
+
+    def extra_repr(self) -> str:
+        return 'rank={}, world size={}, tables of this rank={}'.format(self.rank, self.world_size, self.local_tables)
@@ -1,3 +1,4 @@
+import math
 import torch
 import intel_extension_for_pytorch as ipex  # noqa F401
 from ..utils._weight_prepack import _IPEXLinear as _IPEXLinear
@@ -7,6 +8,8 @@ class EltwiseType(enum.IntEnum):
     NotFused = 0
     ReLU = 1
     Sigmoid = 2
+    GeluErf = 3
+    GeluTanh = 4
 
 class IPEXLinearEltwise(torch.nn.Module):
 
@@ -16,11 +19,39 @@ class IPEXLinearEltwise(torch.nn.Module):
         self.m = ipex_linear_module
         if eltwise == 'relu':
             self.eltwise = EltwiseType.ReLU
+        elif eltwise == 'gelu':
+            self.eltwise = EltwiseType.GeluErf
+        elif eltwise == 'gelu_tanh':
+            self.eltwise = EltwiseType.GeluTanh
         else:
             assert eltwise == 'sigmoid'
             self.eltwise = EltwiseType.Sigmoid
 
     def forward(self, x):
+        if not self.m.weight_packed:
+            self.m._pack_weight_lazily()
         return torch.ops.torch_ipex.ipex_linear_eltwise(
             x, self.m.weight, self.m.out_features, self.m.in_features, self.m.bias, self.eltwise
         )
+
+class _IPEXLinearGelu(IPEXLinearEltwise):
+    r"""
+    The linear + gelu of the FFN of the transformers in eager mode, swapped in
+    by ``ipex.optimize`` for the ``Linear`` followed by a ``GELU`` of the
+    inference models. ``approximate`` is 'none' for the erf gelu or 'tanh' for
+    the tanh approximation of it.
+    """
+    def __init__(self, ipex_linear_module, approximate='none'):
+        assert approximate in ('none', 'tanh')
+        super(_IPEXLinearGelu, self).__init__(
+            ipex_linear_module, 'gelu' if approximate == 'none' else 'gelu_tanh')
+
+    def forward(self, x):
+        # the traced graph keeps the linear and the gelu so that they are
+        # fused with their neighbours by the JIT passes, e.g. as the FFN
+        if torch.jit.is_tracing():
+            y = self.m(x)
+            if self.eltwise == EltwiseType.GeluErf:
+                return torch.nn.functional.gelu(y)
+            return 0.5 * y * (1.0 + torch.tanh(math.sqrt(2.0 / math.pi) * (y + 0.044715 * torch.pow(y, 3.0))))
+        return super(_IPEXLinearGelu, self).forward(x)
@@ -14,6 +14,23 @@ class SGDArgs(NamedTuple):
     weight_decay: float
     lr: float
 
+class RowwiseAdagradArgs(NamedTuple):
+    bf16_trail: List[Optional[torch.Tensor]]
+    momentum: List[torch.Tensor]
+    weight_decay: float
+    lr: float
+    eps: float
+
+class AdamArgs(NamedTuple):
+    bf16_trail: List[Optional[torch.Tensor]]
+    exp_avg: List[torch.Tensor]
+    exp_avg_sq: List[torch.Tensor]
+    beta1: float
+    beta2: float
+    eps: float
+    weight_decay: float
+    lr: float
+
 class EmbeddingSpec(NamedTuple):
     num_of_features: int
     feature_size: int
@@ -27,14 +44,15 @@ def merged_embeddingbag_sgd(
     indices_with_row_offsets,
     row_offsets,
     pooling_modes,
+    dedup,
     sgd_args,
     *weights
 ):
     if torch.is_grad_enabled():
         return MergedEmbeddingBagSGDFunc.apply(
-            indices, offsets, indices_with_row_offsets, row_offsets, pooling_modes, sgd_args, *weights
+            indices, offsets, indices_with_row_offsets, row_offsets, pooling_modes, dedup, sgd_args, *weights
         )
-    return torch.ops.torch_ipex.merged_embeddingbag_forward(indices, offsets, weights, pooling_modes)
+    return torch.ops.torch_ipex.merged_embeddingbag_forward(indices, offsets, weights, pooling_modes, dedup=dedup)
 
 class MergedEmbeddingBagSGDFunc(Function):
     @staticmethod
@@ -42,9 +60,9 @@ class MergedEmbeddingBagSGDFunc(Function):
         return args
 
     @staticmethod
-    def forward(ctx, indices, offsets, indices_with_row_offsets, row_offsets, pooling_modes, sgd_args, *weights):
+    def forward(ctx, indices, offsets, indices_with_row_offsets, row_offsets, pooling_modes, dedup, sgd_args, *weights):
         output = torch.ops.torch_ipex.merged_embeddingbag_forward(
-            indices, offsets, weights, pooling_modes
+            indices, offsets, weights, pooling_modes, dedup=dedup
         )
         ctx.indices = indices
         ctx.offsets = offsets
@@ -72,9 +90,57 @@ class MergedEmbeddingBagSGDFunc(Function):
             row_offsets, pooling_modes,
             bf16_trail, weight_decay, lr)
         n_tables = len(weights)
-        output = [None for i in range(n_tables + 6)]
+        output = [None for i in range(n_tables + 7)]
         return MergedEmbeddingBagSGDFunc.unpack(*output)
 
+def merged_embeddingbag_fused_optimizer(
+    indices,
+    offsets,
+    indices_with_row_offsets,
+    row_offsets,
+    pooling_modes,
+    dedup,
+    optimizer,
+    *weights
+):
+    if torch.is_grad_enabled():
+        return MergedEmbeddingBagFusedOptimizerFunc.apply(
+            indices, offsets, indices_with_row_offsets, row_offsets, pooling_modes, dedup, optimizer, *weights
+        )
+    return torch.ops.torch_ipex.merged_embeddingbag_forward(indices, offsets, weights, pooling_modes, dedup=dedup)
+
+class MergedEmbeddingBagFusedOptimizerFunc(Function):
+    r"""
+    The forward of MergedEmbeddingBag, of which the backward calls optimizer.fused_backward to update
+    the weights without the grads of the weights.
+    """
+    @staticmethod
+    def unpack(*args):
+        return args
+
+    @staticmethod
+    def forward(ctx, indices, offsets, indices_with_row_offsets, row_offsets, pooling_modes, dedup, optimizer, *weights):
+        output = torch.ops.torch_ipex.merged_embeddingbag_forward(
+            indices, offsets, weights, pooling_modes, dedup=dedup
+        )
+        ctx.indices = indices
+        ctx.offsets = offsets
+        ctx.weights = weights
+        ctx.indices_with_row_offsets = indices_with_row_offsets
+        ctx.row_offsets = row_offsets
+        ctx.pooling_modes = pooling_modes
+        ctx.optimizer = optimizer
+        return MergedEmbeddingBagFusedOptimizerFunc.unpack(*output)
+
+    @staticmethod
+    def backward(ctx, *grad_out):
+        ctx.optimizer.fused_backward(
+            grad_out, ctx.indices, ctx.offsets, ctx.weights, ctx.indices_with_row_offsets,
+            ctx.row_offsets, ctx.pooling_modes)
+        n_tables = len(ctx.weights)
+        output = [None for i in range(n_tables + 7)]
+        return MergedEmbeddingBagFusedOptimizerFunc.unpack(*output)
+
 class MergedEmbeddingBag(nn.Module):
     r"""
     Merge multiple Pytorch EmbeddingBag (https://github.com/pytorch/pytorch/blob/master/torch/nn/modules/sparse.py#L221) 
@@ -115,6 +181,15 @@ class MergedEmbeddingBag(nn.Module):
         self.dtypes = []
         dtype = None
         self.weights = torch.nn.ParameterList([nn.Parameter(torch.Tensor()) for i in range(len(embedding_specs))])
+        # the bits of the row-wise quantized tables, None if not quantized
+        self.weight_bits = None
+        # the hot row cache of each table, None if not enabled
+        self.num_hot_rows = 0
+        self.access_counts = None
+        self.hot_weights = None
+        self.hot_slots = None
+        # whether the forward reads each row repeated in a batch once
+        self.dedup = False
         for i, emb in enumerate(embedding_specs):
             num_of_features, feature_size, mode, dtype, weight = emb
             row_offsets.append(num_of_features)
@@ -132,6 +207,104 @@ class MergedEmbeddingBag(nn.Module):
             torch.tensor([0] + list(accumulate(row_offsets)), dtype=torch.int64),
         )
 
+    def to_rowwise_quantized(self, bits=8):
+        r"""
+        Quantize each table row by row to uint8 for inference, each row with its own scale and bias, in
+        the layout of quantized::embedding_bag_byte_prepack (bits=8) or quantized::embedding_bag_4bit_prepack
+        (bits=4). The pooling dequantizes the rows on the fly and outputs float, which cuts the memory and
+        bandwidth of the tables by 4x (8x for 4 bits). The quantized module can not be trained.
+        """
+        assert bits in [8, 4], r"MergedEmbeddingBag only support row-wise quantization with 8 or 4 bits"
+        prepack = torch.ops.quantized.embedding_bag_byte_prepack if bits == 8 \
+            else torch.ops.quantized.embedding_bag_4bit_prepack
+        for i in range(self.n_tables):
+            qweight = prepack(self.weights[i].detach().float().contiguous())
+            self.weights[i] = nn.Parameter(qweight, requires_grad=False)
+        self.weight_bits = [bits] * self.n_tables
+        return self
+
+    @staticmethod
+    def mmap_weight(path, num_of_features, feature_size, dtype=torch.float):
+        r"""
+        Map a table larger than the DRAM from the file of its rows in the row major order. The rows are read
+        on demand, and prefetch starts reading the rows of a batch ahead of its forward.
+        """
+        weight = torch.from_file(path, shared=False, size=num_of_features * feature_size, dtype=dtype)
+        return weight.view(num_of_features, feature_size)
+
+    def prefetch(self, input, need_linearize_indices_and_offsets=torch.BoolTensor([True])):
+        r"""
+        Start reading the rows of the input of a coming forward, e.g. of the batch N+1 before the dense
+        compute of the batch N, so that the reads of the tables mapped from the files overlap with the
+        compute. It returns once the reads are started.
+        """
+        if need_linearize_indices_and_offsets.item():
+            indices, offsets, include_last_offsets = input
+            indices, offsets, _ = self.linearize_indices_and_offsets(indices, offsets, include_last_offsets)
+        else:
+            indices, offsets, _ = input
+        torch.ops.torch_ipex.merged_embeddingbag_prefetch(indices, offsets, list(self.weights), self.hot_slots)
+
+    def enable_dedup(self, dedup=True):
+        r"""
+        Gather the unique rows of each batch into a compact buffer before the pooling, so that a row
+        repeated in the batch, e.g. a popular item, is read from its table once instead of once for each of
+        its lookups. The tables of the same weight share the unique rows. It pays off for the batches with
+        many repeated indices, and it is not applied with the hot row cache, which already keeps the
+        popular rows compact.
+        """
+        self.dedup = dedup
+        return self
+
+    def enable_hot_row_cache(self, num_hot_rows):
+        r"""
+        Keep a compact, cache line aligned copy of the num_hot_rows most frequently accessed rows of each
+        table for inference. The lookups of the hot rows read the copy, so the rest of a table, e.g. a
+        weight from torch.from_file mapping a file on NVMe, PMem or CXL memory, is only read for the long
+        tail. The accesses are counted in forward, and the copy is built by refresh_hot_row_cache, which
+        should also be called again after the weights are updated.
+        """
+        assert num_hot_rows > 0, r"MergedEmbeddingBag expects a positive number of hot rows"
+        self.num_hot_rows = num_hot_rows
+        self.access_counts = [torch.zeros(w.shape[0], dtype=torch.int64) for w in self.weights]
+        self.hot_weights = [torch.empty(0, dtype=w.dtype) for w in self.weights]
+        self.hot_slots = [torch.empty(0, dtype=torch.int32) for w in self.weights]
+        return self
+
+    def record_access(self, indices, offsets):
+        batch_size = (offsets.numel() - 1) // self.n_tables
+        for i in range(self.n_tables):
+            begin = offsets[i * batch_size]
+            end = offsets[(i + 1) * batch_size]
+            table_indices = indices[begin:end]
+            self.access_counts[i].index_add_(0, table_indices, torch.ones_like(table_indices))
+
+    def refresh_hot_row_cache(self):
+        r"""
+        Copy the most frequently accessed rows of each floating point table since the last refresh into its
+        hot row cache. The counts are halved afterwards, so that the cache follows the drift of the traffic.
+        """
+        assert self.hot_slots is not None, r"Please enable the hot row cache first"
+        for i in range(self.n_tables):
+            weight = self.weights[i].detach()
+            counts = self.access_counts[i]
+            num_hot_rows = min(self.num_hot_rows, int((counts > 0).sum()))
+            if num_hot_rows == 0 or not weight.is_floating_point():
+                self.hot_weights[i] = torch.empty(0, dtype=weight.dtype)
+                self.hot_slots[i] = torch.empty(0, dtype=torch.int32)
+                continue
+            hot_rows = counts.topk(num_hot_rows).indices
+            slots = torch.full((weight.shape[0],), -1, dtype=torch.int32)
+            slots[hot_rows] = torch.arange(num_hot_rows, dtype=torch.int32)
+            # pad the hot rows to whole cache lines
+            line_elements = 64 // weight.element_size()
+            padded_size = (weight.shape[1] + line_elements - 1) // line_elements * line_elements
+            hot = torch.empty(num_hot_rows, padded_size, dtype=weight.dtype)[:, :weight.shape[1]]
+            hot.copy_(weight[hot_rows])
+            self.hot_weights[i] = hot
+            self.hot_slots[i] = slots
+            counts.div_(2, rounding_mode='floor')
+
     def extra_repr(self) -> str:
         s = 'number of tables={}\n'.format(self.n_tables)
         for i in range(self.n_tables):
@@ -201,8 +374,27 @@ class MergedEmbeddingBag(nn.Module):
         merged_offsets[-1] = n_indices
         return (merged_indices, merged_offsets, merged_indices_with_row_offsets)
 
+    def _forward(self, input, need_linearize_indices_and_offsets, train_forward):
+        r"""
+        The forward of MergedEmbeddingBagWith[Optimizer], where train_forward(indices, offsets, indices_with_row_offsets)
+        runs the forward of which the backward updates the weights by the optimizer.
+        """
+        if need_linearize_indices_and_offsets.item():
+            indices, offsets, include_last_offsets = input
+            indices, offsets, indices_with_row_offsets = self.linearize_indices_and_offsets(indices, offsets, include_last_offsets)
+        else:
+            indices, offsets, indices_with_row_offsets = input
+        if self.hot_slots is not None:
+            self.record_access(indices, offsets)
+        if self.weight_bits is not None or (self.hot_slots is not None and not torch.is_grad_enabled()):
+            # inference only on the row-wise quantized tables or with the hot row cache
+            return torch.ops.torch_ipex.merged_embeddingbag_forward(
+                indices, offsets, list(self.weights), self.pooling_modes, self.weight_bits,
+                self.hot_weights, self.hot_slots, self.dedup and self.hot_slots is None)
+        return train_forward(indices, offsets, indices_with_row_offsets)
+
     def forward(self, input, need_linearize_indices_and_offsets=torch.BoolTensor([True])):
-        assert False, "Please use MergedEmbeddingBagWith[Optimizer]. We only support SGD now, so please create module MergedEmbeddingBagWithSGD instead"
+        assert False, "Please use MergedEmbeddingBagWith[Optimizer], i.e. MergedEmbeddingBagWithSGD, MergedEmbeddingBagWithRowwiseAdagrad, MergedEmbeddingBagWithAdam or MergedEmbeddingBagWithLAMB"
 
 
 class MergedEmbeddingBagWithSGD(MergedEmbeddingBag):
@@ -296,15 +488,12 @@ class MergedEmbeddingBagWithSGD(MergedEmbeddingBag):
         Returns:
             List[Tensor] output shape of `(batch_size, feature_size)` which length = num of tables.
         """
-        if need_linearize_indices_and_offsets.item():
-            indices, offsets, include_last_offsets = input
-            indices, offsets, indices_with_row_offsets = self.linearize_indices_and_offsets(indices, offsets, include_last_offsets)
-        else:
-            indices, offsets, indices_with_row_offsets = input
-        return merged_embeddingbag_sgd(
-            indices, offsets, indices_with_row_offsets, self.row_offsets,
-            self.pooling_modes, self.sgd_args, *self.weights
-        )
+        return self._forward(
+            input, need_linearize_indices_and_offsets,
+            lambda indices, offsets, indices_with_row_offsets: merged_embeddingbag_sgd(
+                indices, offsets, indices_with_row_offsets, self.row_offsets,
+                self.pooling_modes, self.dedup, self.sgd_args, *self.weights
+            ))
 
     @classmethod
     def from_embeddingbag_list(
@@ -325,3 +514,150 @@ class MergedEmbeddingBagWithSGD(MergedEmbeddingBag):
                     weight=emb.weight.detach()
                 ))
         return cls(embedding_specs, lr, weight_decay)
+
+
+def _bf16_trails(weights):
+    return [
+        torch.zeros_like(w, dtype=torch.bfloat16) if w.dtype == torch.bfloat16 else torch.empty(0, dtype=torch.bfloat16)
+        for w in weights]
+
+def _optimizer_state_dtype(weight):
+    # the states are of the accumulation type of the table
+    return torch.double if weight.dtype == torch.double else torch.float
+
+class _MergedEmbeddingBagWithFusedOptimizer(MergedEmbeddingBag):
+    r"""
+    MergedEmbeddingBag of which the backward fuses the update of an optimizer as MergedEmbeddingBagWithSGD,
+    so that the sparse grads of the weights are never materialized. The subclasses implement fused_backward.
+    """
+    def forward(self, input, need_linearize_indices_and_offsets=torch.BoolTensor([True])):
+        return self._forward(
+            input, need_linearize_indices_and_offsets,
+            lambda indices, offsets, indices_with_row_offsets: merged_embeddingbag_fused_optimizer(
+                indices, offsets, indices_with_row_offsets, self.row_offsets,
+                self.pooling_modes, self.dedup, self, *self.weights
+            ))
+
+    def fused_backward(self, grad_out, indices, offsets, weights, indices_with_row_offsets, row_offsets, pooling_modes):
+        raise NotImplementedError
+
+    @classmethod
+    def from_embeddingbag_list(cls, tables: List[torch.nn.EmbeddingBag], **kwargs):
+        embedding_specs = [
+            EmbeddingSpec(
+                num_of_features=emb.weight.shape[0],
+                feature_size=emb.weight.shape[1],
+                pooling_modes=emb.mode,
+                dtype=emb.weight.dtype,
+                weight=emb.weight.detach()
+            ) for emb in tables]
+        return cls(embedding_specs, **kwargs)
+
+
+class MergedEmbeddingBagWithRowwiseAdagrad(_MergedEmbeddingBagWithFusedOptimizer):
+    r"""
+    MergedEmbeddingBag with the row-wise Adagrad fused into its backward. Each row has one momentum, the sum
+    of the mean squared grads of the row, and is updated by weight -= lr / (sqrt(momentum) + eps) * grad.
+    """
+    def __init__(
+        self,
+        embedding_specs: List[EmbeddingSpec],
+        lr: float = 0.01,
+        weight_decay: float = 0,
+        eps: float = 1e-10
+    ):
+        super(MergedEmbeddingBagWithRowwiseAdagrad, self).__init__(embedding_specs)
+        if lr < 0.0:
+            raise ValueError("Invalid learning rate: {}".format(lr))
+        if weight_decay < 0.0:
+            raise ValueError("Invalid weight_decay value: {}".format(weight_decay))
+        self.optimizer_args = RowwiseAdagradArgs(
+            bf16_trail=_bf16_trails(self.weights),
+            momentum=[torch.zeros(w.shape[0], dtype=_optimizer_state_dtype(w)) for w in self.weights],
+            weight_decay=weight_decay,
+            lr=lr,
+            eps=eps
+        )
+
+    def fused_backward(self, grad_out, indices, offsets, weights, indices_with_row_offsets, row_offsets, pooling_modes):
+        args = self.optimizer_args
+        torch.ops.torch_ipex.merged_embeddingbag_backward_rowwise_adagrad(
+            grad_out, indices, offsets, weights, indices_with_row_offsets,
+            row_offsets, pooling_modes,
+            args.bf16_trail, args.momentum, args.weight_decay, args.lr, args.eps)
+
+
+class _MergedEmbeddingBagWithAdamMoments(_MergedEmbeddingBagWithFusedOptimizer):
+    def __init__(
+        self,
+        embedding_specs: List[EmbeddingSpec],
+        lr: float,
+        betas,
+        eps: float,
+        weight_decay: float
+    ):
+        super(_MergedEmbeddingBagWithAdamMoments, self).__init__(embedding_specs)
+        if lr < 0.0:
+            raise ValueError("Invalid learning rate: {}".format(lr))
+        if not 0.0 <= betas[0] < 1.0 or not 0.0 <= betas[1] < 1.0:
+            raise ValueError("Invalid beta parameters: {}".format(betas))
+        if weight_decay < 0.0:
+            raise ValueError("Invalid weight_decay value: {}".format(weight_decay))
+        self.optimizer_args = AdamArgs(
+            bf16_trail=_bf16_trails(self.weights),
+            exp_avg=[torch.zeros(w.shape, dtype=_optimizer_state_dtype(w)) for w in self.weights],
+            exp_avg_sq=[torch.zeros(w.shape, dtype=_optimizer_state_dtype(w)) for w in self.weights],
+            beta1=betas[0],
+            beta2=betas[1],
+            eps=eps,
+            weight_decay=weight_decay,
+            lr=lr
+        )
+        self.step = 0
+
+    def _fused_backward(self, op, grad_out, indices, offsets, weights, indices_with_row_offsets, row_offsets, pooling_modes):
+        self.step += 1
+        args = self.optimizer_args
+        op(grad_out, indices, offsets, weights, indices_with_row_offsets,
+           row_offsets, pooling_modes,
+           args.bf16_trail, args.exp_avg, args.exp_avg_sq,
+           args.beta1, args.beta2, args.eps, args.weight_decay, args.lr, self.step)
+
+
+class MergedEmbeddingBagWithAdam(_MergedEmbeddingBagWithAdamMoments):
+    r"""
+    MergedEmbeddingBag with Adam fused into its backward. As torch.optim.SparseAdam, only the moments of the
+    rows in the batch are updated, with the bias corrections of the global step. weight_decay is the L2
+    penalty added to the grads as torch.optim.Adam.
+    """
+    def __init__(
+        self,
+        embedding_specs: List[EmbeddingSpec],
+        lr: float = 1e-3,
+        betas=(0.9, 0.999),
+        eps: float = 1e-8,
+        weight_decay: float = 0
+    ):
+        super(MergedEmbeddingBagWithAdam, self).__init__(embedding_specs, lr, betas, eps, weight_decay)
+
+    def fused_backward(self, *args):
+        self._fused_backward(torch.ops.torch_ipex.merged_embeddingbag_backward_adam, *args)
+
+
+class MergedEmbeddingBagWithLAMB(_MergedEmbeddingBagWithAdamMoments):
+    r"""
+    MergedEmbeddingBag with LAMB fused into its backward. The Adam step of each row plus the decoupled weight
+    decay is scaled by the trust ratio of the row, ||weight|| / ||step||.
+    """
+    def __init__(
+        self,
+        embedding_specs: List[EmbeddingSpec],
+        lr: float = 1e-3,
+        betas=(0.9, 0.999),
+        eps: float = 1e-6,
+        weight_decay: float = 0
+    ):
+        super(MergedEmbeddingBagWithLAMB, self).__init__(embedding_specs, lr, betas, eps, weight_decay)
+
+    def fused_backward(self, *args):
+        self._fused_backward(torch.ops.torch_ipex.merged_embeddingbag_backward_lamb, *args)
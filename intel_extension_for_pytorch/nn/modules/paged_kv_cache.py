@@ -0,0 +1,80 @@
+import math
+import torch
+
+class PagedKVCache(object):
+    r"""
+    The preallocated KV cache of an attention layer for the autoregressive
+    decoding, in blocks of ``block_size`` tokens allocated to the sequences by
+    ``block_table``. The key and the value of each decode step are appended in
+    place by :meth:`decode`, which attends to the cached tokens by
+    ``torch.ops.torch_ipex.decode_attention``, so that a step costs linear in
+    the context length instead of the ``torch.cat`` of the whole cache.
+
+    The cache is of float, bfloat16, or int8 quantized per token and head.
+
+    Args:
+        batch_size (int): the number of the sequences
+        num_heads (int): the number of the heads
+        head_dim (int): the size of each head
+        max_seq_len (int): the max tokens of each sequence
+        block_size (int): the tokens of each block. Default: 16
+        dtype (torch.dtype): the dtype of the cache, ``torch.float``,
+            ``torch.bfloat16`` or ``torch.int8``. Default: ``torch.float``
+    """
+
+    def __init__(self, batch_size, num_heads, head_dim, max_seq_len, block_size=16, dtype=torch.float):
+        assert dtype in (torch.float, torch.bfloat16, torch.int8)
+        self.block_size = block_size
+        blocks_per_seq = (max_seq_len + block_size - 1) // block_size
+        num_blocks = batch_size * blocks_per_seq
+        self.key_cache = torch.zeros(num_blocks, num_heads, block_size, head_dim, dtype=dtype)
+        self.value_cache = torch.zeros_like(self.key_cache)
+        if dtype == torch.int8:
+            self.key_scale = torch.zeros(num_blocks, num_heads, block_size)
+            self.value_scale = torch.zeros_like(self.key_scale)
+        else:
+            self.key_scale = torch.empty(0)
+            self.value_scale = torch.empty(0)
+        self.block_table = torch.arange(num_blocks).view(batch_size, blocks_per_seq)
+        self.seq_lens = torch.zeros(batch_size, dtype=torch.long)
+
+    def _quantize(self, x):
+        scale = x.abs().amax(-1) / 127.
+        q = torch.round(x / scale.clamp(min=torch.finfo(torch.float).tiny).unsqueeze(-1))
+        return q.clamp(-127, 127).to(torch.int8), scale
+
+    def prefill(self, key, value):
+        r"""
+        Write the keys and the values of the prompts of shape :math:`(B, H, L, D)`
+        to the empty cache.
+        """
+        assert bool((self.seq_lens == 0).all()), "the cache is not empty"
+        seq_len = key.size(2)
+        pos = torch.arange(seq_len)
+        blocks = self.block_table[:, pos // self.block_size]
+        offsets = (pos % self.block_size).expand_as(blocks)
+        # the advanced indices of dim 0 and 2 put the [B, L] dims first
+        key = key.transpose(1, 2)
+        value = value.transpose(1, 2)
+        if self.key_cache.dtype == torch.int8:
+            key, key_scale = self._quantize(key.float())
+            value, value_scale = self._quantize(value.float())
+            self.key_scale[blocks, :, offsets] = key_scale
+            self.value_scale[blocks, :, offsets] = value_scale
+        self.key_cache[blocks, :, offsets] = key.to(self.key_cache.dtype)
+        self.value_cache[blocks, :, offsets] = value.to(self.value_cache.dtype)
+        self.seq_lens.fill_(seq_len)
+
+    def decode(self, query, key, value, scale=None):
+        r"""
+        Append the key and the value of the new token of shape :math:`(B, H, D)`
+        and return the attention of query over the cached tokens, of the shape
+        and dtype of query. ``scale`` is :math:`1 / \sqrt{D}` if not given.
+        """
+        if scale is None:
+            scale = 1.0 / math.sqrt(query.size(-1))
+        output = torch.ops.torch_ipex.decode_attention(
+            query, key, value, self.key_cache, self.value_cache, self.block_table, self.seq_lens, scale,
+            self.key_scale, self.value_scale)
+        self.seq_lens += 1
+        return output
@@ -1 +1 @@
-from . import _model_convert, _weight_cast, _weight_prepack
+from . import _model_convert, _weight_cast, _weight_prepack, _kernel_selection, _reorder_analysis
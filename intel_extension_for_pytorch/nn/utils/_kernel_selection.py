@@ -0,0 +1,166 @@
+import copy
+import json
+import os
+import time
+import warnings
+
+import torch
+
+from ._weight_prepack import IPEX_WEIGHT_PREPACK_MODULE, _IPEXConv2d, _IPEXLinear, _IPEXConvTranspose2d
+
+# The kernels a layer can run with: the ATen module itself, the prepacked
+# oneDNN module, and for the convolutions the prepacked oneDNN module with the
+# weight in channels last, which makes oneDNN pick the blocked format for the
+# nhwc input.
+ATEN = "aten"
+ONEDNN = "onednn"
+ONEDNN_CHANNELS_LAST = "onednn_channels_last"
+
+_RECIPE_VERSION = 1
+_WARMUP_ITERS = 3
+_MEASURE_ITERS = 10
+
+_PREPACKED_MODULE = {
+    torch.nn.Conv2d: _IPEXConv2d,
+    torch.nn.Linear: _IPEXLinear,
+    torch.nn.ConvTranspose2d: _IPEXConvTranspose2d,
+}
+
+def record_input_shapes(model, sample_input):
+    r"""
+    Runs model with sample_input once and returns a dict from the qualified name
+    of each prepackable layer to (shape, channels_last) of its first input. The
+    names are looked up again on the optimized model, so the record is taken
+    before ``optimize`` converts the model.
+    """
+    shapes = {}
+    handles = []
+
+    def hook(name):
+        def record(m, inputs):
+            x = inputs[0]
+            if name not in shapes and isinstance(x, torch.Tensor):
+                shapes[name] = (list(x.shape), x.dim() == 4 and x.is_contiguous(memory_format=torch.channels_last))
+        return record
+
+    for name, m in model.named_modules():
+        if type(m) in IPEX_WEIGHT_PREPACK_MODULE:
+            handles.append(m.register_forward_pre_hook(hook(name)))
+    try:
+        with torch.no_grad():
+            if isinstance(sample_input, (tuple, list)):
+                model(*sample_input)
+            elif isinstance(sample_input, dict):
+                model(**sample_input)
+            else:
+                model(sample_input)
+    finally:
+        for h in handles:
+            h.remove()
+    return shapes
+
+def _candidates(m):
+    candidates = [ATEN, ONEDNN]
+    if not isinstance(m, torch.nn.Linear) and not m.weight.is_contiguous(memory_format=torch.channels_last):
+        candidates.append(ONEDNN_CHANNELS_LAST)
+    return candidates
+
+def _candidate_module(m, kernel):
+    m = copy.deepcopy(m)
+    if kernel == ATEN:
+        return m
+    if kernel == ONEDNN_CHANNELS_LAST:
+        m = m.to(memory_format=torch.channels_last)
+    return _PREPACKED_MODULE[type(m)](m)
+
+def _time_forward(m, x):
+    with torch.no_grad():
+        for _ in range(_WARMUP_ITERS):
+            m(x)
+        start = time.perf_counter()
+        for _ in range(_MEASURE_ITERS):
+            m(x)
+        return (time.perf_counter() - start) / _MEASURE_ITERS
+
+def _benchmark_layer(m, shape, channels_last):
+    r"""
+    Returns the fastest kernel of m for the input of shape.
+    """
+    x = torch.randn(shape).to(m.weight.dtype)
+    if channels_last:
+        x = x.to(memory_format=torch.channels_last)
+    best, best_time = None, None
+    for kernel in _candidates(m):
+        try:
+            t = _time_forward(_candidate_module(m, kernel), x)
+        except RuntimeError:
+            # e.g. the weight of the linear can't be packed.
+            continue
+        if best_time is None or t < best_time:
+            best, best_time = kernel, t
+    return best
+
+def _layer_entry(m, input_shape):
+    entry = {
+        'op': type(m).__name__,
+        'weight_shape': list(m.weight.shape),
+        'dtype': str(m.weight.dtype),
+    }
+    if input_shape is not None:
+        entry['input_shape'], entry['channels_last_input'] = input_shape
+    return entry
+
+def _load_recipe(path):
+    with open(path, 'r') as f:
+        recipe = json.load(f)
+    if recipe.get('version') != _RECIPE_VERSION:
+        warnings.warn("Ignoring the kernel selection recipe " + path + " of an unsupported version")
+        return {}
+    return recipe.get('layers', {})
+
+def _save_recipe(path, layers):
+    with open(path, 'w') as f:
+        json.dump({'version': _RECIPE_VERSION, 'layers': layers}, f, indent=2, sort_keys=True)
+
+def select_kernels(model, input_shapes, recipe=None):
+    r"""
+    Chooses between the ATen and the oneDNN kernels of each prepackable layer of
+    model by timing them on the input shapes recorded by record_input_shapes.
+    Returns a dict from the layer to its kernel, which weight_prepack_with_ipex
+    takes instead of the static heuristics. The layers chosen to run with the
+    channels last weight are converted here.
+
+    If recipe is the path of an existing recipe file, the layers whose op,
+    weight shape, dtype and input shape match its entries take the stored
+    kernels without being timed. The recipe is written back with the decisions
+    of all the layers if any of them was timed.
+    """
+    layers = {}
+    if recipe is not None and os.path.exists(recipe):
+        layers = _load_recipe(recipe)
+    selection = {}
+    updated = False
+    for name, m in model.named_modules():
+        if type(m) not in IPEX_WEIGHT_PREPACK_MODULE or m.weight.dtype not in (torch.float32, torch.bfloat16):
+            continue
+        input_shape = input_shapes.get(name)
+        entry = _layer_entry(m, input_shape)
+        saved = layers.get(name)
+        if saved is not None and all(saved.get(k) == v for k, v in entry.items()):
+            kernel = saved['kernel']
+        elif input_shape is not None:
+            kernel = _benchmark_layer(m, *input_shape)
+            if kernel is None:
+                continue
+            entry['kernel'] = kernel
+            layers[name] = entry
+            updated = True
+        else:
+            # neither recorded nor in the recipe, left to the heuristics.
+            continue
+        if kernel == ONEDNN_CHANNELS_LAST:
+            m.to(memory_format=torch.channels_last)
+        selection[m] = kernel
+    if recipe is not None and updated:
+        _save_recipe(recipe, layers)
+    return selection
@@ -14,12 +14,17 @@ class _LSTM(torch.nn.LSTM):
 
     # port from torch/nn/modules/rnn.py
     # replace the _VF.lstm with torch.ops.torch_ipex.lstm when the input is not PackedSequence
+    # and with torch.ops.torch_ipex.ipex_lstm_packed for the inference on PackedSequence
     def forward(self, input, hx=None):  # noqa: F811
         orig_input = input
         # xxx: isinstance check needs to be in conditional for TorchScript to compile
         if isinstance(orig_input, PackedSequence):
-            # fallback to PyTorch LSTM since PackedSequence unsupported in oneDNN
-            return super(LSTM, self).forward(input, hx)
+            if self.training or self.proj_size > 0:
+                # fallback to PyTorch LSTM, the packed sequences are only supported in inference
+                return super(_LSTM, self).forward(input, hx)
+            input, batch_sizes, sorted_indices, unsorted_indices = input
+            max_batch_size = batch_sizes[0]
+            max_batch_size = int(max_batch_size)
         else:
             batch_sizes = None
             max_batch_size = input.size(0) if self.batch_first else input.size(1)
@@ -42,11 +47,19 @@ class _LSTM(torch.nn.LSTM):
             hx = self.permute_hidden(hx, sorted_indices)
 
         self.check_forward_args(input, hx, batch_sizes)
-        result = torch.ops.torch_ipex.ipex_lstm(input, hx, self._flat_weights, self.bias, self.num_layers,
-                        self.dropout, self.training, self.bidirectional, self.batch_first)
+        if batch_sizes is None:
+            result = torch.ops.torch_ipex.ipex_lstm(input, hx, self._flat_weights, self.bias, self.num_layers,
+                            self.dropout, self.training, self.bidirectional, self.batch_first)
+        else:
+            # the batch of each time step shrinks as the shorter sequences finish, nothing is padded
+            result = torch.ops.torch_ipex.ipex_lstm_packed(input, batch_sizes, hx, self._flat_weights, self.bias,
+                            self.num_layers, self.bidirectional)
         output = result[0]
         hidden = result[1:]
 
+        if isinstance(orig_input, PackedSequence):
+            output_packed = PackedSequence(output, batch_sizes, sorted_indices, unsorted_indices)
+            return output_packed, self.permute_hidden(hidden, unsorted_indices)
         return output, self.permute_hidden(hidden, unsorted_indices)
 
 def replace_lstm_with_ipex_lstm(model):
@@ -64,6 +77,54 @@ def replace_lstm_with_ipex_lstm(model):
         else:
             replace_lstm_with_ipex_lstm(child)
 
+# the ideep::rnn_kind of the modes of torch.nn.RNNBase
+_IPEX_RNN_MODES = {'RNN_RELU': 0, 'RNN_TANH': 1, 'GRU': 3}
+
+def _ipex_rnn_forward(self, input, hx=None):
+    # port from torch/nn/modules/rnn.py
+    # replace the _VF.gru, _VF.rnn_tanh and _VF.rnn_relu with torch.ops.torch_ipex.ipex_rnn
+    # when the input is not PackedSequence
+    if isinstance(input, PackedSequence) or input.dim() != 3:
+        # fallback to PyTorch, the packed sequences are only supported by ipex LSTM
+        return super(type(self), self).forward(input, hx)
+    max_batch_size = input.size(0) if self.batch_first else input.size(1)
+    if hx is None:
+        num_directions = 2 if self.bidirectional else 1
+        hx = torch.zeros(self.num_layers * num_directions,
+                         max_batch_size, self.hidden_size,
+                         dtype=input.dtype, device=input.device)
+    self.check_forward_args(input, hx, None)
+    output, hidden = torch.ops.torch_ipex.ipex_rnn(input, hx, self._flat_weights, _IPEX_RNN_MODES[self.mode],
+                        self.bias, self.num_layers, self.dropout, self.training, self.bidirectional,
+                        self.batch_first)
+    return output, hidden
+
+class _GRU(torch.nn.GRU):
+    # The GRU of oneDNN is linear-before-reset as PyTorch's, it shares the weight
+    # packing and the layer kernels with the ipex LSTM.
+    def forward(self, input, hx=None):  # noqa: F811
+        return _ipex_rnn_forward(self, input, hx)
+
+class _RNN(torch.nn.RNN):
+    def forward(self, input, hx=None):  # noqa: F811
+        return _ipex_rnn_forward(self, input, hx)
+
+def replace_rnn_with_ipex_rnn(model):
+    # replace gru and vanilla rnn with the ipex counterparts
+    # does not support the case where model itself is torch.nn.GRU or torch.nn.RNN
+    for child_name, child in model.named_children():
+        if type(child) in (torch.nn.GRU, torch.nn.RNN):
+            assert hasattr(child, "weight_ih_l0"), "{} should have weight_ih_l0".format(type(child))
+            ipex_rnn = _GRU if isinstance(child, torch.nn.GRU) else _RNN
+            ipex_rnn = ipex_rnn(child.input_size, child.hidden_size,
+                num_layers=child.num_layers, bias=child.bias, batch_first=child.batch_first,
+                dropout=child.dropout, bidirectional=child.bidirectional,
+                device=child.weight_ih_l0.device, dtype=child.weight_ih_l0.dtype)
+            ipex_rnn.__dict__ = copy.deepcopy(child.__dict__)
+            setattr(model, child_name, ipex_rnn)
+        else:
+            replace_rnn_with_ipex_rnn(child)
+
 def replace_dropout_with_identity(model):
     # replace dropout with identity during inference, so that aten::dropout won't be on the JIT graph.
     # This optimization may provide more fusion opportunites on the graph.
@@ -74,16 +135,85 @@ def replace_dropout_with_identity(model):
             else:
                 replace_dropout_with_identity(child)
 
+class _Dropout(torch.nn.Dropout):
+    # The dropout of the training of torch.ops.torch_ipex.dropout, of which the mask is saved by 1 bit
+    # per element for the backward instead of the float mask of aten::dropout.
+    def forward(self, input):
+        return torch.ops.torch_ipex.dropout(input, self.p, self.training)
+
+def replace_dropout_with_ipex_dropout(model):
+    # replace dropout with ipex dropout during training
+    # does not support the case where model itself is torch.nn.Dropout
+    for child_name, child in model.named_children():
+        if type(child) is torch.nn.Dropout:
+            ipex_dropout = _Dropout(child.p, child.inplace)
+            ipex_dropout.__dict__ = copy.deepcopy(child.__dict__)
+            setattr(model, child_name, ipex_dropout)
+        else:
+            replace_dropout_with_ipex_dropout(child)
+
+def fold_conv_frozen_bn(model):
+    # fold the FrozenBatchNorm2d reading a Conv2d into the weight and the bias of the conv, by the
+    # torch.fx graph of the model as torch.fx.experimental.optimization.fuse does, so that the
+    # frozen batch norm does not read the output of the conv once more during inference
+    from torch.fx.experimental import optimization
+    from torch.nn.utils.fusion import fuse_conv_bn_weights
+    from ..modules import FrozenBatchNorm2d
+    if not any(isinstance(m, FrozenBatchNorm2d) for m in model.modules()):
+        return model
+    fx_model = torch.fx.symbolic_trace(model)
+    modules = dict(fx_model.named_modules())
+    new_graph = copy.deepcopy(fx_model.graph)
+    for node in new_graph.nodes:
+        if not optimization.matches_module_pattern((torch.nn.Conv2d, FrozenBatchNorm2d), node, modules):
+            continue
+        # the output of the conv is used by others
+        if len(node.args[0].users) > 1:
+            continue
+        conv = modules[node.args[0].target]
+        bn = modules[node.target]
+        fused_conv = copy.deepcopy(conv)
+        # torch_ipex::frozen_batch_norm is the inference batch norm of eps 0
+        fused_conv.weight, fused_conv.bias = fuse_conv_bn_weights(
+            fused_conv.weight, fused_conv.bias, bn.running_mean, bn.running_var, 0., bn.weight, bn.bias)
+        optimization.replace_node_module(node.args[0], modules, fused_conv)
+        node.replace_all_uses_with(node.args[0])
+        new_graph.erase_node(node)
+    return torch.fx.GraphModule(fx_model, new_graph)
+
+def fuse_linear_gelu(model):
+    # replace the prepacked Linear + GELU of the nn.Sequential, e.g. the FFN of the transformers, with the eager
+    # linear of the fused gelu post op during inference, so that the output of the linear is not read again by gelu
+    from ..modules.linear_fuse_eltwise import _IPEXLinearGelu
+    from ._weight_prepack import _IPEXLinear
+    for child in model.children():
+        fuse_linear_gelu(child)
+    if model.training or not isinstance(model, torch.nn.Sequential):
+        return
+    names = list(model._modules.keys())
+    for name, next_name in zip(names, names[1:]):
+        linear, gelu = model._modules[name], model._modules[next_name]
+        if not isinstance(linear, _IPEXLinear) or not isinstance(gelu, torch.nn.GELU):
+            continue
+        # nn.GELU has no approximate before PyTorch 1.12
+        approximate = getattr(gelu, 'approximate', 'none')
+        if approximate not in ('none', 'tanh'):
+            continue
+        model._modules[name] = _IPEXLinearGelu(linear, approximate)
+        model._modules[next_name] = torch.nn.Identity()
+
 def convert_module_data_type(module, dtype):
     # convert weights(bias) of module to dtype to reduce dtype reorder
     module_convert_list = [torch.nn.Conv2d,
                            torch.nn.ConvTranspose2d,
                            torch.nn.Linear,
                            torch.nn.Embedding,
-                           torch.nn.LSTM]
+                           torch.nn.LSTM,
+                           torch.nn.GRU,
+                           torch.nn.RNN]
     for module_cls in module_convert_list:
         if isinstance(module, module_cls):
-            if module_cls is torch.nn.LSTM:
+            if module_cls in (torch.nn.LSTM, torch.nn.GRU, torch.nn.RNN):
                 for name, param in module.named_parameters():
                     ori_data = getattr(getattr(module, name), "data")
                     ori_data_dtype = ori_data.dtype
@@ -109,3 +239,63 @@ def convert_module_data_type(module, dtype):
         convert_module_data_type(child, dtype)
     return module
 
+
+def _channels_last_format(t):
+    if isinstance(t, torch.Tensor) and t.dim() == 4:
+        return torch.channels_last
+    if isinstance(t, torch.Tensor) and t.dim() == 5:
+        return torch.channels_last_3d
+    return None
+
+def _is_channels_last(t):
+    memory_format = _channels_last_format(t)
+    return memory_format is not None and t.is_contiguous(memory_format=memory_format)
+
+def _is_plain_only(t):
+    # of the plain format and not of channels_last, e.g. a n x c x 1 x 1 tensor is both
+    return _channels_last_format(t) is not None and not _is_channels_last(t) and t.is_contiguous()
+
+def _to_channels_last(t):
+    memory_format = _channels_last_format(t)
+    return t if memory_format is None else t.contiguous(memory_format=memory_format)
+
+def _inputs_to_channels_last(module, inputs):
+    return tuple(_to_channels_last(x) for x in inputs)
+
+def convert_to_channels_last(model):
+    # convert the parameters and the buffers of the model, and the 4-D and 5-D tensor inputs of each forward of it
+    # to channels_last, so that the convolutions and the IPEX kernels after them keep the nhwc layout end to end
+    # instead of reordering the plain tensors at the layer boundaries
+    # Module.to(memory_format=torch.channels_last) raises on the 5-D parameters, e.g. of the Conv3d
+    model._apply(_to_channels_last)
+    model._channels_last_input_hook = model.register_forward_pre_hook(_inputs_to_channels_last)
+    return model
+
+def find_plain_format_islands(model, sample_input):
+    # the leaf modules of which a channels_last input gives a plain output in a run of sample_input, i.e. where
+    # the layout falls back to the plain format and the following layers reorder it again
+    islands = []
+    handles = []
+
+    def check(name):
+        def hook(m, inputs, outputs):
+            outputs = outputs if isinstance(outputs, (tuple, list)) else (outputs,)
+            if any(_is_channels_last(x) for x in inputs) and any(_is_plain_only(y) for y in outputs):
+                islands.append((name, type(m).__name__))
+        return hook
+
+    for name, m in model.named_modules():
+        if name and not any(True for _ in m.children()):
+            handles.append(m.register_forward_hook(check(name)))
+    try:
+        with torch.no_grad():
+            if isinstance(sample_input, (tuple, list)):
+                model(*sample_input)
+            elif isinstance(sample_input, dict):
+                model(**sample_input)
+            else:
+                model(sample_input)
+    finally:
+        for h in handles:
+            h.remove()
+    return islands
@@ -0,0 +1,269 @@
+import collections
+
+import torch
+
+import intel_extension_for_pytorch._C as core
+from ...utils.verbose import verbose, VERBOSE_ON
+from ._weight_prepack import IPEX_WEIGHT_PREPACK_MODULE
+
+# the bytes of the elements of the dtypes in the memory descs of the verbose
+_DTYPE_BYTES = {'f32': 4, 'bf16': 2, 'f16': 2, 's32': 4, 's8': 1, 'u8': 1}
+
+_INPUT = '<input>'
+
+PLAIN_TO_BLOCKED = 'plain->blocked'
+BLOCKED_TO_PLAIN = 'blocked->plain'
+BLOCKED_TO_BLOCKED = 'blocked->blocked'
+PLAIN_TO_PLAIN = 'plain->plain'
+WEIGHT = 'weight'
+
+def _parse_memory_desc(desc):
+    # e.g. src_f32::blocked:aBcd16b::f0 of oneDNN 3.x, or
+    # src_f32::blocked:aBcd16b:f0 of 2.x
+    parts = desc.split(':')
+    arg, _, dtype = parts[0].partition('_')
+    tag = parts[3] if len(parts) > 3 else ''
+    return arg, dtype, tag
+
+def _is_plain(tag):
+    # the blocked tags have the blocks of the dims, e.g. aBcd16b
+    return tag.isalpha() and tag.islower()
+
+def _reorder_bytes(memory_descs, problem):
+    numel = 1
+    for dim in problem.split('x'):
+        if not dim.isdigit():
+            return 0, (None, None)
+        numel *= int(dim)
+    src = dst = None
+    for desc in memory_descs.split():
+        arg, dtype, tag = _parse_memory_desc(desc)
+        if arg == 'src':
+            src = (dtype, tag)
+        elif arg == 'dst':
+            dst = (dtype, tag)
+    if src is None or dst is None:
+        return 0, (None, None)
+    # a reorder reads the source and writes the destination once
+    nbytes = numel * (_DTYPE_BYTES.get(src[0], 4) + _DTYPE_BYTES.get(dst[0], 4))
+    return nbytes, (src[1], dst[1])
+
+def _direction(src_tag, dst_tag):
+    src_plain = _is_plain(src_tag)
+    dst_plain = _is_plain(dst_tag)
+    if src_plain and dst_plain:
+        return PLAIN_TO_PLAIN
+    if src_plain:
+        return PLAIN_TO_BLOCKED
+    if dst_plain:
+        return BLOCKED_TO_PLAIN
+    return BLOCKED_TO_BLOCKED
+
+def _is_weight(module, problem):
+    weight = getattr(module, 'weight', None) if module is not None else None
+    if not isinstance(weight, torch.Tensor):
+        return False
+    numel = 1
+    for dim in problem.split('x'):
+        numel *= int(dim)
+    return numel == weight.numel()
+
+def _suggestion(direction, producer, producer_module, consumer_module):
+    consumer_type = type(consumer_module).__name__ if consumer_module is not None else 'the functional ops'
+    if direction == WEIGHT:
+        if consumer_module is not None and type(consumer_module) in IPEX_WEIGHT_PREPACK_MODULE:
+            return 'prepack the weight of the {} by ipex.optimize(weights_prepack=True)'.format(consumer_type)
+        return 'the weight of the {} is packed again for the format of its input, ' \
+               'run the model and its input in channels_last'.format(consumer_type)
+    if direction == PLAIN_TO_BLOCKED and producer == _INPUT:
+        return 'feed the input in channels_last, i.e. x.to(memory_format=torch.channels_last)'
+    if direction == PLAIN_TO_PLAIN:
+        return 'the memory formats are mixed between the {} and the {}, ' \
+               'convert the model and its input to channels_last'.format(
+                   type(producer_module).__name__ if producer_module is not None else 'input', consumer_type)
+    if consumer_module is not None and type(consumer_module) in IPEX_WEIGHT_PREPACK_MODULE:
+        return 'switch the {} to its IPEX version by ipex.optimize'.format(consumer_type)
+    if direction == BLOCKED_TO_PLAIN:
+        return 'the {} runs on the plain layout, convert the model to channels_last ' \
+               'so that the blocked output of the IPEX layers is kept in nhwc'.format(consumer_type)
+    return 'convert the model to channels_last so that the {} keeps the layout'.format(consumer_type)
+
+class ReorderReport(object):
+    r"""
+    The reorders of an iteration of a model by :func:`analyze_reorders`.
+
+    Attributes:
+        edges (list): The reorders grouped by the edge of the model, the most
+            bytes first, of which each is a dict of ``producer``, the module
+            whose output is reordered, ``<input>`` of the model input,
+            ``consumer``, the module running the reorder, ``consumer_type``,
+            ``direction``, one of ``plain->blocked``, ``blocked->plain``,
+            ``blocked->blocked``, ``plain->plain``, e.g. of nchw to nhwc, or
+            ``weight``, ``count``, ``bytes``, the bytes read and written by
+            the reorders, ``time_ms`` and ``suggestion``.
+        num_reorders (int): The reorders of the iteration.
+        total_bytes (int): The bytes of all the reorders.
+        applied (list): The fixes applied by ``apply_fixes``.
+        before (ReorderReport): The report before the fixes, None if no fix
+            is applied.
+    """
+    def __init__(self, edges, applied=None, before=None):
+        self.edges = sorted(edges, key=lambda e: e['bytes'], reverse=True)
+        self.num_reorders = sum(e['count'] for e in edges)
+        self.total_bytes = sum(e['bytes'] for e in edges)
+        self.applied = applied or []
+        self.before = before
+
+    def to_dict(self):
+        d = {
+            'num_reorders': self.num_reorders,
+            'total_bytes': self.total_bytes,
+            'edges': self.edges,
+            'applied': self.applied,
+        }
+        if self.before is not None:
+            d['before'] = self.before.to_dict()
+        return d
+
+    def __str__(self):
+        lines = ['{} reorders of {:.2f} MB per iteration'.format(self.num_reorders, self.total_bytes / 1e6)]
+        for e in self.edges:
+            lines.append('  {} -> {} ({}): {} x {}, {:.2f} MB, {:.3f} ms; {}'.format(
+                e['producer'], e['consumer'], e['consumer_type'], e['count'], e['direction'],
+                e['bytes'] / 1e6, e['time_ms'], e['suggestion']))
+        if self.applied:
+            lines.append('applied: ' + ', '.join(self.applied))
+        return '\n'.join(lines)
+
+def _run(model, sample_input):
+    if isinstance(sample_input, (tuple, list)):
+        return model(*sample_input)
+    if isinstance(sample_input, dict):
+        return model(**sample_input)
+    return model(sample_input)
+
+def _to_channels_last(sample_input):
+    def convert(x):
+        if isinstance(x, torch.Tensor) and x.dim() == 4:
+            return x.to(memory_format=torch.channels_last)
+        return x
+    if isinstance(sample_input, (tuple, list)):
+        return type(sample_input)(convert(x) for x in sample_input)
+    if isinstance(sample_input, dict):
+        return {k: convert(v) for k, v in sample_input.items()}
+    return convert(sample_input)
+
+def _trace_reorders(model, sample_input):
+    modules = dict(model.named_modules())
+    handles = []
+
+    def pre_hook(name):
+        def mark(m, inputs):
+            core._mark_verbose_capture('enter,' + name)
+        return mark
+
+    def post_hook(name):
+        def mark(m, inputs, outputs):
+            core._mark_verbose_capture('exit,' + name)
+        return mark
+
+    for name, m in modules.items():
+        if name:
+            handles.append(m.register_forward_pre_hook(pre_hook(name)))
+            handles.append(m.register_forward_hook(post_hook(name)))
+    try:
+        with torch.no_grad():
+            # one iteration to create the primitives, then the traced one
+            _run(model, sample_input)
+            with verbose(VERBOSE_ON, capture=True) as v:
+                _run(model, sample_input)
+    finally:
+        for h in handles:
+            h.remove()
+
+    edges = collections.OrderedDict()
+    stack = []
+    producer = _INPUT
+    for r in v.records(stage=None):
+        if r['stage'] == 'mark':
+            event, _, name = r['problem'].partition(',')
+            if event == 'enter':
+                stack.append(name)
+            elif stack:
+                stack.pop()
+                # the output of a leaf module is the input of the next one
+                if not any(True for _ in modules[name].children()):
+                    producer = name
+            continue
+        if r['stage'] != 'exec' or r['kind'] != 'reorder':
+            continue
+        nbytes, (src_tag, dst_tag) = _reorder_bytes(r['memory_descs'], r['problem'])
+        if src_tag is None:
+            continue
+        consumer = stack[-1] if stack else ''
+        consumer_module = modules.get(consumer) if consumer else None
+        if _is_weight(consumer_module, r['problem']):
+            direction = WEIGHT
+        else:
+            direction = _direction(src_tag, dst_tag)
+        key = (producer, consumer, direction)
+        if key not in edges:
+            edges[key] = {
+                'producer': producer,
+                'consumer': consumer or '<model>',
+                'consumer_type': type(consumer_module).__name__ if consumer_module is not None else '',
+                'direction': direction,
+                'count': 0,
+                'bytes': 0,
+                'time_ms': 0.,
+                'suggestion': _suggestion(direction, producer, modules.get(producer), consumer_module),
+            }
+        edge = edges[key]
+        edge['count'] += 1
+        edge['bytes'] += nbytes
+        edge['time_ms'] += max(r['time_ms'], 0.)
+    return list(edges.values())
+
+def analyze_reorders(model, sample_input, apply_fixes=False):
+    r"""
+    Runs an iteration of an eager inference model, e.g. of
+    :func:`~intel_extension_for_pytorch.optimize`, with ``sample_input``,
+    and reports the reorders of oneDNN between the plain and the blocked
+    layouts by the edges of the model, i.e. the module producing the
+    reordered tensor and the module consuming it, along with their bytes and
+    the suggested fixes, e.g. converting the model to channels_last or
+    switching the consumer to its IPEX version. It finds the reorders by the
+    oneDNN verbose, so the iteration runs with ``ipex.verbose`` captured, and
+    the modules by their forward hooks.
+
+    .. highlight:: python
+    .. code-block:: python
+
+        model = ipex.optimize(model.eval())
+        report = ipex.analyze_reorders(model, x)
+        print(report)
+
+    Args:
+        model (torch.nn.Module): The inference model.
+        sample_input (tensor or tuple of tensors): A representative input.
+        apply_fixes (bool): Convert the model to channels_last in place if
+            it has reorders of the activations, and report the reorders of
+            the fixed model run with the input in channels_last, of which
+            the report of the original one is ``before``. Default value is
+            ``False``.
+
+    Returns:
+        ReorderReport: The reorders of the iteration.
+    """
+
+    assert not model.training, "The reorders are analyzed on the inference model"
+    report = ReorderReport(_trace_reorders(model, sample_input))
+    if not apply_fixes:
+        return report
+    activations = [e for e in report.edges if e['direction'] != WEIGHT]
+    if not activations:
+        return report
+    model.to(memory_format=torch.channels_last)
+    fixed = ReorderReport(_trace_reorders(model, _to_channels_last(sample_input)),
+                          applied=['channels_last'], before=report)
+    return fixed
@@ -36,20 +36,30 @@ def _save_to_state_dict(self, destination, prefix, keep_vars):
     if hasattr(self, 'bias') and self.bias is not None:
         self.bias = temp_bias
 
-def weight_dtype_convert_with_ipex(module, optimizer, params_attr, master_weight_split):
+# The bytes of the fp32 params cast by one cast_to_bfloat16_batch, of which the
+# fp32 originals are released before the next batch is cast, for the peak
+# memory of the large models
+_CAST_BATCH_BYTES = 256 * 1024 * 1024
 
-    def cast_attr(m, attr, master_weight_split, params_attr, optimizer):
+def weight_dtype_convert_with_ipex(module, optimizer, params_attr, master_weight_split, numa_node_id=-1):
+    r"""
+    Cast the params of the IPEX_WEIGHT_CAST_MODULE modules to bf16, in the batches of all the params of
+    _CAST_BATCH_BYTES cast in parallel. The casted params are allocated on ``numa_node_id``, e.g. the
+    ``numa_node_id`` of the CPUPool the model runs on, or by the first touch of the casting threads for -1.
+    """
+
+    def cast_attr(m, attr, casted, master_weight_split, params_attr, optimizer):
         # cast weight/bias for BF16 dtype
         float_param = getattr(m, attr)
         params_attr[float_param] = {}
         if master_weight_split:
-            top_half, bot_half = torch.ops.torch_ipex.split_float_bfloat16(float_param.data)
+            top_half, bot_half = casted
             setattr(m, attr + '_trail', bot_half)
             setattr(m, attr, nn.Parameter(top_half.detach()))
             params_attr[float_param]['trail'] = getattr(m, attr + '_trail')
         else:
             setattr(m, 'master_' + attr, float_param.data)
-            setattr(m, attr, nn.Parameter(float_param.detach().bfloat16()))
+            setattr(m, attr, nn.Parameter(casted.detach()))
             params_attr[float_param]['bf16_param'] = getattr(m, attr)
         # update attr entry, always use params in optimzer as "key"
         # while master weight split, key is m.weight/bias, if not split, key is m.master_weight/master_bias
@@ -57,26 +67,33 @@ def weight_dtype_convert_with_ipex(module, optimizer, params_attr, master_weight
         params_attr[getattr(m, attr_name)] = params_attr.pop(float_param)
         _optimizer_utils.refresh_optimizer_params_after_cast(m, attr, float_param, master_weight_split, optimizer)
 
-    def convert(m):
+    def cast_batch(batch):
+        top_halves, bot_halves = torch.ops.torch_ipex.cast_to_bfloat16_batch(
+            [getattr(m, attr).data for m, attr in batch], master_weight_split, numa_node_id)
+        for i, (m, attr) in enumerate(batch):
+            casted = (top_halves[i], bot_halves[i]) if master_weight_split else top_halves[i]
+            cast_attr(m, attr, casted, master_weight_split, params_attr, optimizer)
+
+    batch, batch_bytes = [], 0
+    for m in module.modules():
         if type(m) in IPEX_WEIGHT_CAST_MODULE:
             setattr(m, 'master_weight_split', master_weight_split)
-            # replace weight
-            cast_attr(m, 'weight', master_weight_split, params_attr, optimizer)
-            if hasattr(m, 'bias') and m.bias is not None:
-                # replace bias
-                cast_attr(m, 'bias', master_weight_split, params_attr, optimizer)
+            # replace weight and bias
+            attrs = ['weight'] + (['bias'] if hasattr(m, 'bias') and m.bias is not None else [])
+            for attr in attrs:
+                param = getattr(m, attr)
+                batch.append((m, attr))
+                batch_bytes += param.numel() * param.element_size()
+                if batch_bytes >= _CAST_BATCH_BYTES:
+                    cast_batch(batch)
+                    batch, batch_bytes = [], 0
             # for resume training reason, we always save float tensors
             # replace module method to ensure return float params while call "state_dict()"
             setattr(m, '_save_to_state_dict', types.MethodType(_save_to_state_dict, m))
-        return m
-
-    def convert_rec(m):
-        new_m = convert(m)
-        for name, sub_m in m.named_children():
-            setattr(new_m, name, convert_rec(sub_m))
-        return new_m
+    if batch:
+        cast_batch(batch)
 
-    casted_model, casted_optimizer, params_attr = convert_rec(module), optimizer, params_attr
+    casted_model, casted_optimizer, params_attr = module, optimizer, params_attr
 
     if optimizer is not None:
         _optimizer_utils.patch_load_state_dict(casted_optimizer)
@@ -1,10 +1,138 @@
+import threading
 import torch
 import torch.nn as nn
 import warnings
 
 from intel_extension_for_pytorch import optim
+import intel_extension_for_pytorch._C as core
 
-class _IPEXConvNd(nn.Module):
+# Guards the lazy weight packing at the first forward of the prepacked
+# modules, so that concurrent first calls pack each weight only once.
+_lazy_prepack_lock = threading.Lock()
+
+# Allocates the 1-D buffer of (numel, dtype) to unpack a weight into when
+# saving the state dict of the prepacked modules, e.g. a tensor mapped from a
+# file, see intel_extension_for_pytorch.save_unpacked_state_dict. None means
+# the unpacked weights are newly allocated.
+_unpacked_weight_allocator = None
+
+class _IPEXPrepackedModule(nn.Module):
+    r"""
+    Base of the prepacked modules. ``self.weight`` holds the packed weight if
+    ``self.weight_packed`` is True, otherwise the plain weight, which is packed
+    by ``_pack`` at the first forward (lazy prepack).
+    """
+    def _pack(self, weight, dtype=None):
+        raise NotImplementedError
+
+    def _pack_out(self, weight, out, out_trail=None, dtype=None):
+        # Pack the plain weight into the existing packed weight out, and
+        # out_trail if it is split into bfloat16 halves.
+        raise NotImplementedError
+
+    def _unpack(self, weight, dtype):
+        raise NotImplementedError
+
+    def _unpack_out(self, weight, weight_trail, out, dtype):
+        raise NotImplementedError
+
+    def _plain_weight_size(self):
+        raise NotImplementedError
+
+    def _plain_weight_view(self, buffer):
+        # View the 1-D buffer as the plain weight in its original layout
+        return buffer.view(self._plain_weight_size())
+
+    def _unpack_weight(self):
+        if not self.weight_packed:
+            return self.weight.detach()
+        unpack_dtype = self.weight.dtype
+        weight_trail = None
+        if hasattr(self, 'master_weight'):
+            weight = self.master_weight.detach()
+        elif hasattr(self, 'weight_trail'):
+            weight, weight_trail = self.weight.detach(), self.weight_trail.detach()
+        else:
+            weight = self.weight.detach()
+        if _unpacked_weight_allocator is None:
+            if weight_trail is not None:
+                weight = torch.ops.torch_ipex.cat_bfloat16_float(weight, weight_trail)
+            return self._unpack(weight, unpack_dtype)
+        # Unpack straight into the allocated buffer, the top and trail halves
+        # of the split weight are joined by the unpacking.
+        out_dtype = torch.float32 if weight_trail is not None else weight.dtype
+        numel = 1
+        for size in self._plain_weight_size():
+            numel *= size
+        out = self._plain_weight_view(_unpacked_weight_allocator(numel, out_dtype))
+        return self._unpack_out(weight, weight_trail, out, unpack_dtype)
+
+    def _save_to_state_dict(self, destination, prefix, keep_vars):
+        assert not keep_vars, "can not using keep_vars true when to save {}'s parameters".format(type(self).__name__)
+        if self.bias is not None:
+            if hasattr(self, 'master_bias'):
+                bias = self.master_bias
+            elif hasattr(self, 'bias_trail'):
+                bias = torch.ops.torch_ipex.cat_bfloat16_float(self.bias, self.bias_trail)
+            else:
+                bias = self.bias
+            destination[prefix + 'bias'] = bias.detach()
+        destination[prefix + 'weight'] = self._unpack_weight()
+
+    def _load_weight(self, weight):
+        if not self.weight_packed:
+            self.weight.copy_(weight)
+        elif hasattr(self, 'master_weight'):
+            self._pack_out(weight.to(self.master_weight.dtype), self.master_weight, dtype=self.weight.dtype)
+            torch.ops.torch_ipex.sync_master_weight_to_bf16(self.master_weight, self.weight)
+        elif hasattr(self, 'weight_trail'):
+            self._pack_out(weight.float(), self.weight, self.weight_trail)
+        else:
+            self._pack_out(weight.to(self.weight.dtype), self.weight)
+
+    def _load_bias(self, bias):
+        if hasattr(self, 'master_bias'):
+            self.master_bias.copy_(bias)
+            self.bias.copy_(bias)
+        elif hasattr(self, 'bias_trail'):
+            torch.ops.torch_ipex.split_float_bfloat16_out(bias.float(), self.bias, self.bias_trail)
+        else:
+            self.bias.copy_(bias)
+
+    def _load_from_state_dict(self, state_dict, prefix, local_metadata, strict,
+                              missing_keys, unexpected_keys, error_msgs):
+        # Write the plain weight and bias into the existing (packed)
+        # parameters in place, so that the optimizer still refers to them.
+        local_state = {'weight': (self._plain_weight_size(), self._load_weight)}
+        if self.bias is not None:
+            local_state['bias'] = (self.bias.size(), self._load_bias)
+        for name, (size, load) in local_state.items():
+            key = prefix + name
+            if key not in state_dict:
+                missing_keys.append(key)
+                continue
+            value = state_dict[key]
+            if value.size() != torch.Size(size):
+                error_msgs.append('size mismatch for {}: copying a param with shape {} from checkpoint, '
+                                  'the shape in current model is {}.'.format(key, value.size(), torch.Size(size)))
+                continue
+            with torch.no_grad():
+                load(value)
+        if strict:
+            for key in state_dict.keys():
+                if key.startswith(prefix) and key[len(prefix):].split('.', 1)[0] not in local_state:
+                    unexpected_keys.append(key)
+
+    @torch.jit.unused
+    def _pack_weight_lazily(self):
+        with _lazy_prepack_lock:
+            if not self.weight_packed:
+                # Replace the data in place, so that the parameter seen by
+                # torch.jit.trace is the one holding the packed weight.
+                self.weight.data = self._pack(self.weight.detach())
+                self.weight_packed = True
+
+class _IPEXConvNd(_IPEXPrepackedModule):
     __constants__ = ['stride', 'padding', 'dilation', 'groups',
                      'out_channels', 'kernel_size']
 
@@ -19,6 +147,8 @@ class _IPEXConvNd(nn.Module):
         self.groups = dense_module.groups
 
     def forward(self, x):
+        if not self.weight_packed:
+            self._pack_weight_lazily()
         return torch.ops.torch_ipex.convolution_forward(
             x,
             self.weight,
@@ -33,34 +163,25 @@ class _IPEXConvNd(nn.Module):
             self.weight_packed)
 
 class _IPEXConv2d(_IPEXConvNd):
-    def __init__(self, dense_module):
+    def __init__(self, dense_module, packed_weight=None, lazy=False):
         super(_IPEXConv2d, self).__init__(dense_module)
         self.weight_channels_last = dense_module.weight.is_contiguous(memory_format=torch.channels_last)
-        self.weight_packed = True
+        self.weight_packed = not lazy
 
         # TODO: ".clone()" will make weight shared by multiple module not shared anymore
         # related issues: https://github.com/intel-innersource/frameworks.ai.pytorch.ipex-cpu/issues/65
-        self.weight = nn.Parameter(torch.ops.torch_ipex.conv2d_weight_pack(
-            dense_module.weight.detach().clone(),
-            self.padding,
-            self.stride,
-            self.dilation,
-            self.groups))
+        if lazy:
+            self.weight = nn.Parameter(dense_module.weight.detach().clone())
+        elif packed_weight is not None:
+            self.weight = nn.Parameter(packed_weight)
+        else:
+            self.weight = nn.Parameter(self._pack(dense_module.weight.detach().clone()))
         if hasattr(dense_module, 'master_weight'):
-            self.master_weight = torch.ops.torch_ipex.conv2d_weight_pack(
+            self.master_weight = self._pack(
                 dense_module.master_weight.detach().clone(),
-                self.padding,
-                self.stride,
-                self.dilation,
-                self.groups,
                 self.weight.dtype)
         elif hasattr(dense_module, 'weight_trail'):
-            self.weight_trail = torch.ops.torch_ipex.conv2d_weight_pack(
-                dense_module.weight_trail.detach().clone(),
-                self.padding,
-                self.stride,
-                self.dilation,
-                self.groups)
+            self.weight_trail = self._pack(dense_module.weight_trail.detach().clone())
         if dense_module.bias is not None:
             self.bias = nn.Parameter(dense_module.bias.detach().clone())
             if hasattr(dense_module, 'master_bias'):
@@ -70,25 +191,30 @@ class _IPEXConv2d(_IPEXConvNd):
         else:
             self.register_parameter('bias', None)
 
-    def _save_to_state_dict(self, destination, prefix, keep_vars):
-        unpack_dtype = self.weight.dtype
-        assert not keep_vars, "can not using keep_vars true when to save _IPEXConv2d's parameters"
-        if self.bias is not None:
-            if hasattr(self, 'master_bias'):
-                bias = self.master_bias
-            elif hasattr(self, 'bias_trail'):
-                bias = torch.ops.torch_ipex.cat_bfloat16_float(self.bias, self.bias_trail)
-            else:
-                bias = self.bias
-            destination[prefix + 'bias'] = bias.detach()
-        if hasattr(self, 'master_weight'):
-            weight = self.master_weight
-        elif hasattr(self, 'weight_trail'):
-            weight = torch.ops.torch_ipex.cat_bfloat16_float(self.weight, self.weight_trail)
-        else:
-            weight = self.weight
-        destination[prefix + 'weight'] = torch.ops.torch_ipex.conv2d_weight_unpack(
-            weight.detach(),
+    def _pack(self, weight, dtype=None):
+        return torch.ops.torch_ipex.conv2d_weight_pack(
+            weight,
+            self.padding,
+            self.stride,
+            self.dilation,
+            self.groups,
+            dtype)
+
+    def _pack_out(self, weight, out, out_trail=None, dtype=None):
+        memory_format = torch.channels_last if self.weight_channels_last else torch.contiguous_format
+        return torch.ops.torch_ipex.conv2d_weight_pack_out(
+            weight.contiguous(memory_format=memory_format),
+            self.padding,
+            self.stride,
+            self.dilation,
+            self.groups,
+            out,
+            out_trail,
+            dtype)
+
+    def _unpack(self, weight, dtype):
+        return torch.ops.torch_ipex.conv2d_weight_unpack(
+            weight,
             self.padding,
             self.stride,
             self.dilation,
@@ -97,14 +223,34 @@ class _IPEXConv2d(_IPEXConvNd):
             self.out_channels,
             self.in_channels,
             self.weight_channels_last,
-            unpack_dtype)
+            dtype)
 
-    def _load_from_state_dict(self, state_dict, prefix, local_metadata, strict,
-                              missing_keys, unexpected_keys, error_msgs):
-        assert False, "_IPEXConv2d does not support _load_from_state_dict method"
+    def _unpack_out(self, weight, weight_trail, out, dtype):
+        return torch.ops.torch_ipex.conv2d_weight_unpack_out(
+            weight,
+            weight_trail,
+            self.padding,
+            self.stride,
+            self.dilation,
+            self.kernel_size,
+            self.groups,
+            self.out_channels,
+            self.in_channels,
+            self.weight_channels_last,
+            out,
+            dtype)
 
-class _IPEXLinear(torch.nn.Module):
-    def __init__(self, dense_module):
+    def _plain_weight_size(self):
+        return [self.out_channels, self.in_channels // self.groups] + list(self.kernel_size)
+
+    def _plain_weight_view(self, buffer):
+        if not self.weight_channels_last:
+            return super(_IPEXConv2d, self)._plain_weight_view(buffer)
+        o, i, h, w = self._plain_weight_size()
+        return buffer.view(o, h, w, i).permute(0, 3, 1, 2)
+
+class _IPEXLinear(_IPEXPrepackedModule):
+    def __init__(self, dense_module, packed_weight=None, lazy=False):
         super(_IPEXLinear, self).__init__()
         # use in_features, out features and weight_transposed to restore origin 2D weight
         self.out_features = dense_module.out_features
@@ -114,18 +260,25 @@ class _IPEXLinear(torch.nn.Module):
             dense_module.weight.stride()[1] == dense_module.weight.size()[0]
         )
 
+        self.weight_packed = not lazy
+
         # TODO:".clone()" will make weight shared by multiple module not shared anymore
         # related issues: https://github.com/intel-innersource/frameworks.ai.pytorch.ipex-cpu/issues/65
-        self.weight = torch.nn.Parameter(
-            torch.ops.torch_ipex.linear_weight_pack(dense_module.weight.detach().clone())
-        )
+        if lazy:
+            # fail here as the eager packing does, rather than at the first forward
+            if not _is_linear_weight_packable(dense_module.weight):
+                raise RuntimeError("ipex linear pack only support contiguous or transposed weight")
+            self.weight = torch.nn.Parameter(dense_module.weight.detach().clone())
+        elif packed_weight is not None:
+            self.weight = torch.nn.Parameter(packed_weight)
+        else:
+            self.weight = torch.nn.Parameter(self._pack(dense_module.weight.detach().clone()))
         if hasattr(dense_module, 'master_weight'):
-            self.master_weight = torch.ops.torch_ipex.linear_weight_pack(
+            self.master_weight = self._pack(
                 dense_module.master_weight.detach().clone(),
                 self.weight.dtype)
         elif hasattr(dense_module, 'weight_trail'):
-            self.weight_trail = torch.ops.torch_ipex.linear_weight_pack(
-                dense_module.weight_trail.detach().clone())
+            self.weight_trail = self._pack(dense_module.weight_trail.detach().clone())
 
         if dense_module.bias is not None:
             self.bias = nn.Parameter(dense_module.bias.detach().clone())
@@ -136,41 +289,49 @@ class _IPEXLinear(torch.nn.Module):
         else:
             self.register_parameter('bias', None)
 
+    def _pack(self, weight, dtype=None):
+        return torch.ops.torch_ipex.linear_weight_pack(weight, dtype)
+
     def forward(self, x):
+        if not self.weight_packed:
+            self._pack_weight_lazily()
         return torch.ops.torch_ipex.ipex_linear(
             x, self.weight, self.out_features, self.in_features, self.bias
         )
 
-    def _save_to_state_dict(self, destination, prefix, keep_vars):
-        assert not keep_vars, "can not using keep_vars true when to save _IPEXLinear's parameters"
-        unpack_dtype = self.weight.dtype
-        if self.bias is not None:
-            if hasattr(self, 'master_bias'):
-                bias = self.master_bias
-            elif hasattr(self, 'bias_trail'):
-                bias = torch.ops.torch_ipex.cat_bfloat16_float(self.bias, self.bias_trail)
-            else:
-                bias = self.bias
-            destination[prefix + 'bias'] = bias.detach()
-
-        if hasattr(self, 'master_weight'):
-            weight = self.master_weight
-        elif hasattr(self, 'weight_trail'):
-            weight = torch.ops.torch_ipex.cat_bfloat16_float(self.weight, self.weight_trail)
+    def _pack_out(self, weight, out, out_trail=None, dtype=None):
+        if self.weight_transposed:
+            weight = weight.t().contiguous().t()
         else:
-            weight = self.weight
-        destination[prefix + 'weight'] = torch.ops.torch_ipex.linear_weight_unpack(
-            weight.detach(),
+            weight = weight.contiguous()
+        return torch.ops.torch_ipex.linear_weight_pack_out(weight, out, out_trail, dtype)
+
+    def _unpack(self, weight, dtype):
+        return torch.ops.torch_ipex.linear_weight_unpack(
+            weight,
             self.out_features,
             self.in_features,
             self.weight_transposed,
-            unpack_dtype)
+            dtype)
 
-    def _load_from_state_dict(self, state_dict, prefix, local_metadata, strict,
-                              missing_keys, unexpected_keys, error_msgs):
-        assert False, "_IPEXLinear does not support _load_from_state_dict method"
+    def _unpack_out(self, weight, weight_trail, out, dtype):
+        return torch.ops.torch_ipex.linear_weight_unpack_out(
+            weight,
+            weight_trail,
+            self.out_features,
+            self.in_features,
+            out,
+            dtype)
+
+    def _plain_weight_size(self):
+        return [self.out_features, self.in_features]
 
-class _IPEXConvTransposeNd(nn.Module):
+    def _plain_weight_view(self, buffer):
+        if not self.weight_transposed:
+            return super(_IPEXLinear, self)._plain_weight_view(buffer)
+        return buffer.view(self.in_features, self.out_features).t()
+
+class _IPEXConvTransposeNd(_IPEXPrepackedModule):
     __constants__ = ['stride', 'padding', 'dilation', 'groups',
                      'out_channels', 'kernel_size', 'output_padding']
 
@@ -186,6 +347,8 @@ class _IPEXConvTransposeNd(nn.Module):
         self.output_padding = dense_module.output_padding
 
     def forward(self, x):
+        if not self.weight_packed:
+            self._pack_weight_lazily()
         return torch.ops.torch_ipex.conv_transpose2d(
             x,
             self.weight,
@@ -201,35 +364,23 @@ class _IPEXConvTransposeNd(nn.Module):
             self.weight_packed)
 
 class _IPEXConvTranspose2d(_IPEXConvTransposeNd):
-    def __init__(self, dense_module):
+    def __init__(self, dense_module, packed_weight=None, lazy=False):
         super(_IPEXConvTranspose2d, self).__init__(dense_module)
         self.weight_channels_last = dense_module.weight.is_contiguous(memory_format=torch.channels_last)
-        self.weight_packed = True
+        self.weight_packed = not lazy
 
-        self.weight = nn.Parameter(torch.ops.torch_ipex.conv_transpose2d_weight_pack(
-            dense_module.weight.detach().clone(),
-            self.stride,
-            self.padding,
-            self.output_padding,
-            self.groups,
-            self.dilation))
+        if lazy:
+            self.weight = nn.Parameter(dense_module.weight.detach().clone())
+        elif packed_weight is not None:
+            self.weight = nn.Parameter(packed_weight)
+        else:
+            self.weight = nn.Parameter(self._pack(dense_module.weight.detach().clone()))
         if hasattr(dense_module, 'master_weight'):
-            self.master_weight = torch.ops.torch_ipex.conv_transpose2d_weight_pack(
+            self.master_weight = self._pack(
                 dense_module.master_weight.detach().clone(),
-                self.stride,
-                self.padding,
-                self.output_padding,
-                self.groups,
-                self.dilation,
                 self.weight.dtype)
         elif hasattr(dense_module, 'weight_trail'):
-            self.weight_trail = torch.ops.torch_ipex.conv_transpose2d_weight_pack(
-                dense_module.weight_trail.detach().clone(),
-                self.stride,
-                self.padding,
-                self.output_padding,
-                self.groups,
-                self.dilation)
+            self.weight_trail = self._pack(dense_module.weight_trail.detach().clone())
         if dense_module.bias is not None:
             self.bias = nn.Parameter(dense_module.bias.detach().clone())
             if hasattr(dense_module, 'master_bias'):
@@ -239,25 +390,32 @@ class _IPEXConvTranspose2d(_IPEXConvTransposeNd):
         else:
             self.register_parameter('bias', None)
 
-    def _save_to_state_dict(self, destination, prefix, keep_vars):
-        unpack_dtype = self.weight.dtype
-        assert not keep_vars, "can not using keep_vars true when to save _IPEXConvTranspose2d's parameters"
-        if self.bias is not None:
-            if hasattr(self, 'master_bias'):
-                bias = self.master_bias
-            elif hasattr(self, 'bias_trail'):
-                bias = torch.ops.torch_ipex.cat_bfloat16_float(self.bias, self.bias_trail)
-            else:
-                bias = self.bias
-            destination[prefix + 'bias'] = bias.detach()
-        if hasattr(self, 'master_weight'):
-            weight = self.master_weight
-        elif hasattr(self, 'weight_trail'):
-            weight = torch.ops.torch_ipex.cat_bfloat16_float(self.weight, self.weight_trail)
-        else:
-            weight = self.weight
-        destination[prefix + 'weight'] = torch.ops.torch_ipex.conv_transpose2d_weight_unpack(
-            weight.detach(),
+    def _pack(self, weight, dtype=None):
+        return torch.ops.torch_ipex.conv_transpose2d_weight_pack(
+            weight,
+            self.stride,
+            self.padding,
+            self.output_padding,
+            self.groups,
+            self.dilation,
+            dtype)
+
+    def _pack_out(self, weight, out, out_trail=None, dtype=None):
+        memory_format = torch.channels_last if self.weight_channels_last else torch.contiguous_format
+        return torch.ops.torch_ipex.conv_transpose2d_weight_pack_out(
+            weight.contiguous(memory_format=memory_format),
+            self.stride,
+            self.padding,
+            self.output_padding,
+            self.groups,
+            self.dilation,
+            out,
+            out_trail,
+            dtype)
+
+    def _unpack(self, weight, dtype):
+        return torch.ops.torch_ipex.conv_transpose2d_weight_unpack(
+            weight,
             self.stride,
             self.padding,
             self.output_padding,
@@ -267,11 +425,32 @@ class _IPEXConvTranspose2d(_IPEXConvTransposeNd):
             self.out_channels,
             self.in_channels,
             self.weight_channels_last,
-            unpack_dtype)
+            dtype)
 
-    def _load_from_state_dict(self, state_dict, prefix, local_metadata, strict,
-                              missing_keys, unexpected_keys, error_msgs):
-        assert False, "_IPEXConvTranspose2d does not support _load_from_state_dict method"
+    def _unpack_out(self, weight, weight_trail, out, dtype):
+        return torch.ops.torch_ipex.conv_transpose2d_weight_unpack_out(
+            weight,
+            weight_trail,
+            self.stride,
+            self.padding,
+            self.output_padding,
+            self.groups,
+            self.dilation,
+            self.kernel_size,
+            self.out_channels,
+            self.in_channels,
+            self.weight_channels_last,
+            out,
+            dtype)
+
+    def _plain_weight_size(self):
+        return [self.in_channels, self.out_channels // self.groups] + list(self.kernel_size)
+
+    def _plain_weight_view(self, buffer):
+        if not self.weight_channels_last:
+            return super(_IPEXConvTranspose2d, self)._plain_weight_view(buffer)
+        i, o, h, w = self._plain_weight_size()
+        return buffer.view(i, h, w, o).permute(0, 3, 1, 2)
 
 IPEX_WEIGHT_PREPACK_MODULE = {
     torch.nn.Linear,
@@ -279,23 +458,96 @@ IPEX_WEIGHT_PREPACK_MODULE = {
     torch.nn.ConvTranspose2d,
 }
 
-def _should_prepack(module, auto_kernel_selection):
+def _should_prepack(module, auto_kernel_selection, kernel_selection=None):
     if type(module) not in IPEX_WEIGHT_PREPACK_MODULE:
         return False
+    elif kernel_selection is not None and module in kernel_selection:
+        # measured by _kernel_selection.select_kernels
+        return kernel_selection[module] != "aten"
     elif isinstance(module, torch.nn.Linear) and not auto_kernel_selection and module.weight.dtype is torch.float:
         # For now we simply distinguish "mkl" and "mkldnn" backend by "weight prepack"
         # Does not prepack Linear for FP32 to choose "mkl" backend
         return False
     return True
 
-def weight_prepack_with_ipex(module, optimizer, params_attr, auto_kernel_selection):
+def _count_weight_prepack(module, auto_kernel_selection, kernel_selection=None):
+    # counts the prepackable layer in the fallback stats, by the reason of the
+    # check of _should_prepack or of the dtype it is left to aten by
+    if type(module) not in IPEX_WEIGHT_PREPACK_MODULE:
+        return
+    if kernel_selection is not None and module in kernel_selection and kernel_selection[module] == "aten":
+        reason = "aten_kernel_selected"
+    elif isinstance(module, torch.nn.Linear) and not auto_kernel_selection and module.weight.dtype is torch.float:
+        reason = "fp32_linear_mkl"
+    elif module.weight.dtype not in (torch.float32, torch.bfloat16):
+        reason = "unsupported_dtype"
+    else:
+        reason = ""
+    core._count_fast_path("weight_prepack", reason)
+
+def _is_linear_weight_packable(weight):
+    return weight.is_contiguous() or (
+        weight.stride()[0] == 1 and weight.stride()[1] == weight.size()[0])
+
+def _pack_weights_in_parallel(module, auto_kernel_selection, kernel_selection=None):
+    r"""
+    Packs the weights of the prepackable layers of module by one batched call
+    for each layer type, so that the layers are packed in parallel across the
+    cores instead of one after another. Returns a dict from the layer to its
+    packed weight. The layers not in the dict are packed by the constructors
+    of the prepacked modules.
+    """
+    convs, linears, deconvs = [], [], []
+    for m in module.modules():
+        if not _should_prepack(m, auto_kernel_selection, kernel_selection) or m.weight.dtype not in (torch.float32, torch.bfloat16):
+            continue
+        if isinstance(m, torch.nn.Conv2d):
+            convs.append(m)
+        elif isinstance(m, torch.nn.Linear):
+            # the unpackable weights are left to _IPEXLinear to warn about
+            if _is_linear_weight_packable(m.weight):
+                linears.append(m)
+        elif isinstance(m, torch.nn.ConvTranspose2d):
+            deconvs.append(m)
+
+    packed_weights = {}
+    if convs:
+        packed_weights.update(zip(convs, torch.ops.torch_ipex.conv2d_weight_pack_batch(
+            [m.weight.detach() for m in convs],
+            [p for m in convs for p in m.padding],
+            [s for m in convs for s in m.stride],
+            [d for m in convs for d in m.dilation],
+            [m.groups for m in convs])))
+    if linears:
+        # linear_weight_pack may return the weight itself if it is already in
+        # the expected format.
+        packed_weights.update(zip(linears, torch.ops.torch_ipex.linear_weight_pack_batch(
+            [m.weight.detach().clone() for m in linears])))
+    if deconvs:
+        packed_weights.update(zip(deconvs, torch.ops.torch_ipex.conv_transpose2d_weight_pack_batch(
+            [m.weight.detach() for m in deconvs],
+            [s for m in deconvs for s in m.stride],
+            [p for m in deconvs for p in m.padding],
+            [p for m in deconvs for p in m.output_padding],
+            [m.groups for m in deconvs],
+            [d for m in deconvs for d in m.dilation])))
+    return packed_weights
+
+def weight_prepack_with_ipex(module, optimizer, params_attr, auto_kernel_selection, lazy=False, kernel_selection=None):
+    if lazy and optimizer is not None:
+        warnings.warn("IPEX does not support lazy weight prepack for training, will prepack the weights eagerly")
+        lazy = False
+    # With lazy prepack, each layer packs its weight at its first forward.
+    packed_weights = {} if lazy else _pack_weights_in_parallel(module, auto_kernel_selection, kernel_selection)
+
     def convert(m, auto_kernel_selection):
-        if _should_prepack(m, auto_kernel_selection) and (m.weight.dtype == torch.float32 or m.weight.dtype == torch.bfloat16):
+        _count_weight_prepack(m, auto_kernel_selection, kernel_selection)
+        if _should_prepack(m, auto_kernel_selection, kernel_selection) and (m.weight.dtype == torch.float32 or m.weight.dtype == torch.bfloat16):
             weight = m.master_weight if hasattr(m, "master_weight") else m.weight
             if weight not in params_attr:
                 params_attr[weight] = {}
             if isinstance(m, torch.nn.Conv2d):
-                new_m = _IPEXConv2d(m)
+                new_m = _IPEXConv2d(m, packed_weights.get(m), lazy)
                 params_attr[weight].update({
                     'op': torch.nn.Conv2d, 'padding': new_m.padding,
                     'dilation': new_m.dilation, 'stride': new_m.stride,
@@ -304,7 +556,7 @@ def weight_prepack_with_ipex(module, optimizer, params_attr, auto_kernel_selecti
                     'weight_channels_last': new_m.weight_channels_last})
             elif isinstance(m, torch.nn.Linear):
                 try:
-                    new_m = _IPEXLinear(m)
+                    new_m = _IPEXLinear(m, packed_weights.get(m), lazy)
                     params_attr[weight].update({
                         'op': torch.nn.Linear,
                         'out_features': new_m.out_features,
@@ -314,7 +566,7 @@ def weight_prepack_with_ipex(module, optimizer, params_attr, auto_kernel_selecti
                     warnings.warn(m.__str__() + " not be packed because weight is not transposed or contiguous")
                     new_m = m
             elif isinstance(m, torch.nn.ConvTranspose2d):
-                new_m = _IPEXConvTranspose2d(m)
+                new_m = _IPEXConvTranspose2d(m, packed_weights.get(m), lazy)
                 params_attr[weight].update({'op': torch.nn.ConvTranspose2d, \
                                               'padding': new_m.padding, 'stride': new_m.stride, \
                                               'dilation': new_m.dilation, 'kernel_size': new_m.kernel_size, \
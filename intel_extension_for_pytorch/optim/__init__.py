@@ -1 +1,4 @@
-
+from ._optimizer_utils import fuse_clip_grad_norm, enable_stochastic_rounding, overlap_step_with_backward
+from ._sharded_states import shard_optimizer_states
+from ._grad_accumulation import fuse_grad_accumulation
+from ._bucketed_allreduce import bucketed_allreduce
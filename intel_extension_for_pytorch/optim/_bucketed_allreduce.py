@@ -0,0 +1,140 @@
+import torch
+import torch.distributed as dist
+import types
+from torch._utils import _flatten_dense_tensors, _unflatten_dense_tensors
+
+_COMPRESSIONS = ('none', 'bf16')
+
+class _Bucket(object):
+    def __init__(self, leaves, compression, error_feedback):
+        self.leaves = leaves
+        self.numel = sum(leaf.numel() for leaf in leaves)
+        # the grads of the float leaves are sent in bf16, the bf16 ones, e.g. of the split master weights, as is
+        self.compressed = compression == 'bf16' and leaves[0].dtype is torch.float
+        # the rounding error of the bf16 of the last allreduce, which is added to the grads of the next one
+        self.residual = torch.zeros(self.numel, dtype=torch.float) if self.compressed and error_feedback else None
+        self.reset()
+
+    def reset(self):
+        self.ready = 0
+        self.work = None
+        self.flat = None
+
+def _grad_leaf(optimizer, p):
+    # the bf16 param of the model of a float master weight holds the grad, see fuse_grad_accumulation
+    return getattr(optimizer, 'params_attr', {}).get(p, {}).get('bf16_param', p)
+
+def bucketed_allreduce(optimizer, bucket_cap_mb=25, compression='bf16', error_feedback=True, group=None):
+    r"""
+    Average the grads of the params of the optimizer across the ranks of the process group by the
+    allreduces of the buckets of about ``bucket_cap_mb``, each issued asynchronously as soon as the
+    backward has produced all the grads of its bucket, so that the communication overlaps the rest of the
+    backward, instead of wrapping the model by DistributedDataParallel. The buckets group the params in the
+    reverse order of the optimizer, roughly the order of the backward, and are issued in the same order on
+    all the ranks. The step waits for them, writes the averaged grads back into the grads the fused steps
+    of ipex.optimize read, e.g. the bf16 grads of the split master weights, and runs the original step.
+
+    With ``compression='bf16'``, the float grads are sent in bf16, which halves the bytes of the
+    allreduce, and with ``error_feedback`` the rounding error of each bucket is added to its grads of the
+    next iteration, so that it isn't lost across the steps. The bf16 grads are sent as is.
+
+    Each backward issues the allreduces, so the grads of several micro-batches are accumulated by one
+    backward of the summed loss. The cores of the communication are the ones reserved by ``launch.py
+    --distributed --ccl_worker_count``.
+
+    Examples:
+
+        >>> model, optimizer = ipex.optimize(model, dtype=torch.bfloat16, optimizer=optimizer)
+        >>> ipex.optim.bucketed_allreduce(optimizer, compression='bf16')
+        >>> loss.backward()
+        >>> optimizer.step()
+
+    Args:
+        optimizer (torch.optim.Optimizer): The optimizer, e.g. of ipex.optimize.
+        bucket_cap_mb (float): The max MB of the grads of a bucket. The default value is ``25``.
+        compression (str): ``'none'`` or ``'bf16'``. The default value is ``'bf16'``.
+        error_feedback (bool): Whether to carry the rounding error of the bf16 compression to the next
+            iteration. The default value is ``True``.
+        group (ProcessGroup): The process group. The default value is ``None``, the default group.
+    """
+    assert compression in _COMPRESSIONS, "compression should be one of {}".format(_COMPRESSIONS)
+    world_size = dist.get_world_size(group)
+    params = [p for param_group in optimizer.param_groups for p in param_group['params'] if p.requires_grad]
+    leaves = [_grad_leaf(optimizer, p) for p in reversed(params)]
+    cap_bytes = bucket_cap_mb * 1024 * 1024
+
+    buckets = []
+    bucket_of = {}
+    current = {}
+    current_bytes = {}
+    for leaf in leaves:
+        assert not leaf.is_sparse, "bucketed_allreduce doesn't support the sparse grads"
+        current.setdefault(leaf.dtype, []).append(leaf)
+        current_bytes[leaf.dtype] = current_bytes.get(leaf.dtype, 0) + leaf.numel() * leaf.element_size()
+        if current_bytes[leaf.dtype] >= cap_bytes:
+            buckets.append(_Bucket(current.pop(leaf.dtype), compression, error_feedback))
+            current_bytes[leaf.dtype] = 0
+    buckets += [_Bucket(bucket_leaves, compression, error_feedback) for bucket_leaves in current.values()]
+    for i, bucket in enumerate(buckets):
+        for leaf in bucket.leaves:
+            bucket_of[leaf] = i
+    state = {'next': 0}
+
+    def launch(bucket):
+        for leaf in bucket.leaves:
+            if leaf.grad is None:
+                # all the ranks send every bucket, of which the grads not produced are zeros
+                leaf.grad = torch.zeros_like(leaf)
+        flat = _flatten_dense_tensors([leaf.grad for leaf in bucket.leaves])
+        if bucket.compressed:
+            if bucket.residual is not None:
+                flat.add_(bucket.residual)
+            flat.div_(world_size)
+            sent = flat.to(torch.bfloat16)
+            if bucket.residual is not None:
+                torch.sub(flat, sent.float(), out=bucket.residual)
+                bucket.residual.mul_(world_size)
+        else:
+            sent = flat.div_(world_size)
+        bucket.flat = sent
+        bucket.work = dist.all_reduce(sent, group=group, async_op=True)
+
+    def launch_ready():
+        # the buckets are issued in their order, the collectives have the same order on all the ranks
+        while state['next'] < len(buckets) and buckets[state['next']].ready == len(buckets[state['next']].leaves):
+            launch(buckets[state['next']])
+            state['next'] += 1
+
+    def make_hook(leaf):
+        def hook(*unused):
+            buckets[bucket_of[leaf]].ready += 1
+            launch_ready()
+        return hook
+
+    # the AccumulateGrad nodes are kept, or the nodes with the hooks are released with the graph
+    grad_accs = []
+    for leaf in leaves:
+        grad_acc = leaf.expand_as(leaf).grad_fn.next_functions[0][0]
+        grad_acc.register_hook(make_hook(leaf))
+        grad_accs.append(grad_acc)
+
+    original_step = optimizer.step
+
+    def step(self, *args, **kwargs):
+        with torch.no_grad():
+            while state['next'] < len(buckets):
+                launch(buckets[state['next']])
+                state['next'] += 1
+            for bucket in buckets:
+                bucket.work.wait()
+                grads = [leaf.grad for leaf in bucket.leaves]
+                flat = bucket.flat.float() if bucket.compressed else bucket.flat
+                for grad, synced in zip(grads, _unflatten_dense_tensors(flat, grads)):
+                    grad.copy_(synced)
+                bucket.reset()
+            state['next'] = 0
+        return original_step(*args, **kwargs)
+
+    setattr(optimizer, '_bucketed_allreduce_grad_accs', grad_accs)
+    setattr(optimizer, 'step', types.MethodType(step, optimizer))
+    return optimizer
@@ -1,4 +1,5 @@
 r"""Functional interface, port from torch/optim/_function.py"""
+import math
 import torch
 from torch import Tensor
 from typing import List, Optional
@@ -9,6 +10,23 @@ def _make_sparse(grad, grad_indices, values):
         return torch.empty_like(grad)
     return torch.sparse_coo_tensor(grad_indices, values, size)
 
+def _fused_grad_scale(optimizer):
+    r"""
+    The coefficient to clip the grads of all the params of the optimizer by their global L2 norm, as
+    torch.nn.utils.clip_grad_norm_, if the max norm is set by fuse_clip_grad_norm. The steps apply it in
+    the update of each param rather than scaling the grads first. The norm is kept in last_grad_norm.
+    """
+    max_norm = getattr(optimizer, 'max_grad_norm', None)
+    if max_norm is None:
+        return 1.
+    grads = [p.grad for group in optimizer.param_groups for p in group['params'] if p.grad is not None]
+    sum_of_squares = torch.ops.torch_ipex.grad_norm_list([g for g in grads if not g.is_sparse]) ** 2
+    for g in grads:
+        if g.is_sparse:
+            sum_of_squares += float(g.coalesce()._values().double().pow(2).sum())
+    optimizer.last_grad_norm = math.sqrt(sum_of_squares)
+    return min(1., max_norm / (optimizer.last_grad_norm + 1e-6))
+
 def _adagrad_impl(
     params: List[Tensor],
     grads: List[Tensor],
@@ -19,12 +37,17 @@ def _adagrad_impl(
     weight_decay: float,
     lr_decay: float,
     eps: float,
-    fused: bool):
+    fused: bool,
+    grad_scale: float = 1.,
+    stochastic_rounding: bool = False):
     r"""Functional API that performs Adagrad algorithm computation.
 
-    See :class:`~torch.optim.Adagrad` for details.
+    See :class:`~torch.optim.Adagrad` for details. The grads are scaled by grad_scale to clip them, and the
+    pure bf16 params are rounded stochastically if stochastic_rounding.
     """
 
+    # the params of the fused step, updated by one call
+    fused_params, fused_grads, fused_state_sums, fused_params2, fused_steps = [], [], [], [], []
     for (param, grad, state_sum, step) in zip(params, grads, state_sums, state_steps):
         param2 = torch.Tensor()
         if param in attr:
@@ -35,18 +58,15 @@ def _adagrad_impl(
                 assert param.dtype is torch.float
                 param2 = attr[param][bf16_param]
         if fused and not param.is_sparse:
-            torch.ops.torch_ipex.adagrad_fused_step(
-                param,
-                grad,
-                state_sum,
-                param2,
-                step,
-                lr,
-                weight_decay,
-                lr_decay,
-                eps)
+            fused_params.append(param)
+            fused_grads.append(grad)
+            fused_state_sums.append(state_sum)
+            fused_params2.append(param2)
+            fused_steps.append(step)
             continue
 
+        if grad_scale != 1:
+            grad = grad.mul(grad_scale)
         if weight_decay != 0:
             if grad.is_sparse:
                 raise RuntimeError("weight_decay option is not compatible with sparse gradients")
@@ -69,6 +89,55 @@ def _adagrad_impl(
             std = state_sum.sqrt().add_(eps)
             param.addcdiv_(grad, std, value=-clr)
 
+    if fused_params:
+        torch.ops.torch_ipex.adagrad_fused_step_list(
+            fused_params,
+            fused_grads,
+            fused_state_sums,
+            fused_params2,
+            fused_steps,
+            lr,
+            weight_decay,
+            lr_decay,
+            eps,
+            grad_scale,
+            stochastic_rounding)
+
+def _adagrad_group_step(self, group, params, grad_scale=1.):
+    r"""The fused Adagrad step of the params of a param group, e.g. of a bucket of the params."""
+    params_with_grad = []
+    grads = []
+    state_sums = []
+    state_steps = []
+
+    for p in params:
+        if p.grad is not None:
+            params_with_grad.append(p)
+            grads.append(p.grad)
+            state = self.state[p]
+            # the fused step keeps the state sum of a bf16 param in float
+            if self.fused and p.dtype is torch.bfloat16 and state['sum'].dtype is torch.bfloat16:
+                state['sum'] = state['sum'].float()
+            state_sums.append(state['sum'])
+            # update the steps for each param group update
+            state['step'] += 1
+            # record the step after step update
+            state_steps.append(state['step'])
+
+    _adagrad_impl(
+        params_with_grad,
+        grads,
+        state_sums,
+        state_steps,
+        self.params_attr,
+        group['lr'],
+        group['weight_decay'],
+        group['lr_decay'],
+        group['eps'],
+        self.fused,
+        grad_scale,
+        getattr(self, 'stochastic_rounding', False))
+
 @torch.no_grad()
 def adagrad_step(self, closure=None):
     """Performs a single optimization step.
@@ -82,34 +151,9 @@ def adagrad_step(self, closure=None):
         with torch.enable_grad():
             loss = closure()
 
+    grad_scale = _fused_grad_scale(self)
     for group in self.param_groups:
-        params_with_grad = []
-        grads = []
-        state_sums = []
-        state_steps = []
-
-        for p in group['params']:
-            if p.grad is not None:
-                params_with_grad.append(p)
-                grads.append(p.grad)
-                state = self.state[p]
-                state_sums.append(state['sum'])
-                # update the steps for each param group update
-                state['step'] += 1
-                # record the step after step update
-                state_steps.append(state['step'])
-
-        _adagrad_impl(
-            params_with_grad,
-            grads,
-            state_sums,
-            state_steps,
-            self.params_attr,
-            group['lr'],
-            group['weight_decay'],
-            group['lr_decay'],
-            group['eps'],
-            self.fused)
+        _adagrad_group_step(self, group, group['params'], grad_scale)
 
     return loss
 
@@ -124,12 +168,19 @@ def _sgd_impl(
     lr: float,
     dampening: float,
     nesterov: bool,
-    fused: bool):
+    fused: bool,
+    grad_scale: float = 1.,
+    stochastic_rounding: bool = False):
     r"""Functional API that performs SGD algorithm computation.
 
-    See :class:`~torch.optim.SGD` for details.
+    See :class:`~torch.optim.SGD` for details. The grads are scaled by grad_scale to clip them, and the
+    pure bf16 params are rounded stochastically if stochastic_rounding.
     """
 
+    # the params of the fused step, updated by one call
+    fused_params, fused_d_p_list, fused_momentum_buffers, fused_params2 = [], [], [], []
+    # the params of the first fused step, of which the momentum buffers are initialized
+    init_params, init_d_p_list, init_momentum_buffers, init_params2 = [], [], [], []
     for i, param in enumerate(params):
         d_p = d_p_list[i]
         param2 = torch.Tensor()
@@ -141,24 +192,36 @@ def _sgd_impl(
                 assert param.dtype is torch.float
                 param2 = attr[param][bf16_param]
 
-        # first iter will init momentum_buffer, not fused on 1st iter
-        if fused and not param.is_sparse and momentum_buffer_list[i] is not None:
-            torch.ops.torch_ipex.sgd_fused_step(
-                param,
-                d_p,
-                momentum_buffer_list[i],
-                param2,
-                momentum,
-                lr,
-                weight_decay,
-                dampening,
-                nesterov)
+        if fused and not d_p.is_sparse:
+            if momentum == 0:
+                fused_params.append(param)
+                fused_d_p_list.append(d_p)
+                fused_momentum_buffers.append(torch.Tensor())
+                fused_params2.append(param2)
+            elif momentum_buffer_list[i] is None:
+                # the buffer of the first step is the grad, in the layout of the param, e.g. the blocked
+                # layout of a packed weight, of the fused step of a zero buffer without dampening
+                buffer_dtype = param.dtype if param.dtype is torch.float64 else torch.float
+                momentum_buffer_list[i] = torch.zeros_like(param, dtype=buffer_dtype)
+                init_params.append(param)
+                init_d_p_list.append(d_p)
+                init_momentum_buffers.append(momentum_buffer_list[i])
+                init_params2.append(param2)
+            else:
+                fused_params.append(param)
+                fused_d_p_list.append(d_p)
+                fused_momentum_buffers.append(momentum_buffer_list[i])
+                fused_params2.append(param2)
             continue
 
+        if grad_scale != 1:
+            d_p = d_p.mul(grad_scale)
+        # the pure bf16 params without the trail are updated as the float params
+        split_bf16 = param.dtype is torch.bfloat16 and param2.numel() > 0
         float_d_p, float_param = None, None
         if weight_decay != 0 or momentum != 0:
             float_d_p = d_p.float()
-            if param.dtype == torch.bfloat16:
+            if split_bf16:
                 float_param = torch.ops.torch_ipex.cat_bfloat16_float(param, param2)
             else:
                 float_param = param.float()
@@ -175,16 +238,14 @@ def _sgd_impl(
                 buf.mul_(momentum).add_(float_d_p, alpha=1 - dampening)
 
             if nesterov:
-                float_d_p = d_p.add(buf, alpha=momentum)
+                float_d_p = float_d_p.add(buf, alpha=momentum)
             else:
                 float_d_p = buf
 
-        if param.dtype is torch.bfloat16:
+        if split_bf16:
             if float_d_p is not None and float_param is not None:
                 float_param.add_(float_d_p, alpha=-lr)
-                top_half, bot_half = torch.ops.torch_ipex.split_float_bfloat16(float_param)
-                param.copy_(top_half)
-                param2.copy_(bot_half)
+                torch.ops.torch_ipex.split_float_bfloat16_out(float_param, param, param2)
             else:
                 torch.ops.torch_ipex.packed_add(param, param2, d_p, alpha=-lr)
         else:
@@ -193,6 +254,74 @@ def _sgd_impl(
             else:
                 param.add_(d_p, alpha=-lr)
 
+    if fused_params:
+        torch.ops.torch_ipex.sgd_fused_step_list(
+            fused_params,
+            fused_d_p_list,
+            fused_momentum_buffers,
+            fused_params2,
+            momentum,
+            lr,
+            weight_decay,
+            dampening,
+            nesterov,
+            grad_scale,
+            stochastic_rounding)
+    if init_params:
+        torch.ops.torch_ipex.sgd_fused_step_list(
+            init_params,
+            init_d_p_list,
+            init_momentum_buffers,
+            init_params2,
+            momentum,
+            lr,
+            weight_decay,
+            0.,
+            nesterov,
+            grad_scale,
+            stochastic_rounding)
+
+def _sgd_group_step(self, group, params, grad_scale=1.):
+    r"""The fused SGD step of the params of a param group, e.g. of a bucket of the params."""
+    params_with_grad = []
+    d_p_list = []
+    momentum_buffer_list = []
+    weight_decay = group['weight_decay']
+    momentum = group['momentum']
+    dampening = group['dampening']
+    nesterov = group['nesterov']
+    lr = group['lr']
+
+    for p in params:
+        if p.grad is not None:
+            params_with_grad.append(p)
+            d_p_list.append(p.grad)
+
+            state = self.state[p]
+            if 'momentum_buffer' not in state:
+                momentum_buffer_list.append(None)
+            else:
+                momentum_buffer_list.append(state['momentum_buffer'])
+
+    _sgd_impl(
+        params_with_grad,
+        d_p_list,
+        self.params_attr,
+        momentum_buffer_list,
+        weight_decay=weight_decay,
+        momentum=momentum,
+        lr=lr,
+        dampening=dampening,
+        nesterov=nesterov,
+        fused=self.fused,
+        grad_scale=grad_scale,
+        stochastic_rounding=getattr(self, 'stochastic_rounding', False))
+
+    # update momentum_buffers in state
+    for p, momentum_buffer in zip(params_with_grad, momentum_buffer_list):
+        state = self.state[p]
+        state['momentum_buffer'] = momentum_buffer
+
 @torch.no_grad()
 def sgd_step(self, closure=None):
     """Performs a single optimization step.
@@ -206,43 +335,180 @@ def sgd_step(self, closure=None):
         with torch.enable_grad():
             loss = closure()
 
+    grad_scale = _fused_grad_scale(self)
     for group in self.param_groups:
-        params_with_grad = []
-        d_p_list = []
-        momentum_buffer_list = []
-        weight_decay = group['weight_decay']
-        momentum = group['momentum']
-        dampening = group['dampening']
-        nesterov = group['nesterov']
-        lr = group['lr']
-
-        for p in group['params']:
-            if p.grad is not None:
-                params_with_grad.append(p)
-                d_p_list.append(p.grad)
-
-                state = self.state[p]
-                if 'momentum_buffer' not in state:
-                    momentum_buffer_list.append(None)
-                else:
-                    momentum_buffer_list.append(state['momentum_buffer'])
-
-        _sgd_impl(
-            params_with_grad,
-            d_p_list,
-            self.params_attr,
-            momentum_buffer_list,
-            weight_decay=weight_decay,
-            momentum=momentum,
-            lr=lr,
-            dampening=dampening,
-            nesterov=nesterov,
-            fused=self.fused)
-
-        # update momentum_buffers in state
-        for p, momentum_buffer in zip(params_with_grad, momentum_buffer_list):
+        _sgd_group_step(self, group, group['params'], grad_scale)
+
+    return loss
+
+def _adam_impl(
+    params: List[Tensor],
+    grads: List[Tensor],
+    exp_avgs: List[Tensor],
+    exp_avg_sqs: List[Tensor],
+    max_exp_avg_sqs: List[Tensor],
+    state_steps: List[int],
+    attr: dict,
+    amsgrad: bool,
+    adamw: bool,
+    beta1: float,
+    beta2: float,
+    lr: float,
+    weight_decay: float,
+    eps: float,
+    maximize: bool,
+    fused: bool,
+    grad_scale: float = 1.,
+    stochastic_rounding: bool = False):
+    r"""Functional API that performs Adam or AdamW algorithm computation.
+
+    See :class:`~torch.optim.Adam` and :class:`~torch.optim.AdamW` for details. The grads are scaled by
+    grad_scale to clip them, and the pure bf16 params are rounded stochastically if stochastic_rounding.
+    """
+
+    # the params of the fused step, updated by one call
+    fused_params, fused_exp_avgs, fused_exp_avg_sqs, fused_max_exp_avg_sqs = [], [], [], []
+    fused_grads, fused_params2, fused_steps = [], [], []
+    for i, param in enumerate(params):
+        grad = grads[i] if not maximize else -grads[i]
+        exp_avg = exp_avgs[i]
+        exp_avg_sq = exp_avg_sqs[i]
+        max_exp_avg_sq = max_exp_avg_sqs[i] if amsgrad else torch.Tensor()
+        step = state_steps[i]
+        param2 = torch.Tensor()
+        if param in attr:
+            if 'trail' in attr[param]:
+                assert param.dtype is torch.bfloat16
+                param2 = attr[param]['trail']
+            if 'bf16_param' in attr[param]:
+                assert param.dtype is torch.float
+                param2 = attr[param]['bf16_param']
+        if fused and not grad.is_sparse:
+            fused_params.append(param)
+            fused_exp_avgs.append(exp_avg)
+            fused_exp_avg_sqs.append(exp_avg_sq)
+            fused_max_exp_avg_sqs.append(max_exp_avg_sq)
+            fused_grads.append(grad)
+            fused_params2.append(param2)
+            fused_steps.append(step)
+            continue
+
+        if grad_scale != 1:
+            grad = grad.mul(grad_scale)
+        if adamw:
+            param.mul_(1 - lr * weight_decay)
+        elif weight_decay != 0:
+            grad = grad.add(param, alpha=weight_decay)
+
+        bias_correction1 = 1 - beta1 ** step
+        bias_correction2 = 1 - beta2 ** step
+
+        exp_avg.mul_(beta1).add_(grad, alpha=1 - beta1)
+        exp_avg_sq.mul_(beta2).addcmul_(grad, grad, value=1 - beta2)
+        if amsgrad:
+            torch.maximum(max_exp_avg_sq, exp_avg_sq, out=max_exp_avg_sq)
+            denom = (max_exp_avg_sq.sqrt() / math.sqrt(bias_correction2)).add_(eps)
+        else:
+            denom = (exp_avg_sq.sqrt() / math.sqrt(bias_correction2)).add_(eps)
+        param.addcdiv_(exp_avg, denom, value=-lr / bias_correction1)
+
+    if fused_params:
+        torch.ops.torch_ipex.adam_fused_step_list(
+            fused_params,
+            fused_exp_avgs,
+            fused_exp_avg_sqs,
+            fused_max_exp_avg_sqs,
+            fused_grads,
+            fused_params2,
+            fused_steps,
+            amsgrad,
+            adamw,
+            beta1,
+            beta2,
+            lr,
+            weight_decay,
+            eps,
+            grad_scale,
+            stochastic_rounding)
+
+def _adam_group_step(self, group, params, grad_scale=1.):
+    r"""The fused Adam or AdamW step of the params of a param group, e.g. of a bucket of the params."""
+    params_with_grad = []
+    grads = []
+    exp_avgs = []
+    exp_avg_sqs = []
+    max_exp_avg_sqs = []
+    state_steps = []
+    amsgrad = group['amsgrad']
+    beta1, beta2 = group['betas']
+
+    for p in params:
+        if p.grad is not None:
+            if p.grad.is_sparse:
+                raise RuntimeError('Adam does not support sparse gradients, please consider SparseAdam instead')
+            params_with_grad.append(p)
+            grads.append(p.grad)
+
             state = self.state[p]
-            state['momentum_buffer'] = momentum_buffer
+            # Lazy state initialization, the states of a bf16 param are of float
+            if len(state) == 0:
+                state['step'] = 0
+                buffer_dtype = p.dtype if p.dtype is torch.float64 else torch.float
+                state['exp_avg'] = torch.zeros(p.shape, dtype=buffer_dtype)
+                state['exp_avg_sq'] = torch.zeros(p.shape, dtype=buffer_dtype)
+                if amsgrad:
+                    state['max_exp_avg_sq'] = torch.zeros(p.shape, dtype=buffer_dtype)
+
+            exp_avgs.append(state['exp_avg'])
+            exp_avg_sqs.append(state['exp_avg_sq'])
+            if amsgrad:
+                max_exp_avg_sqs.append(state['max_exp_avg_sq'])
+            else:
+                max_exp_avg_sqs.append(None)
+
+            # update the steps for each param group update
+            state['step'] = int(state['step']) + 1
+            # record the step after step update
+            state_steps.append(state['step'])
+
+    _adam_impl(
+        params_with_grad,
+        grads,
+        exp_avgs,
+        exp_avg_sqs,
+        max_exp_avg_sqs,
+        state_steps,
+        self.params_attr,
+        amsgrad,
+        isinstance(self, torch.optim.AdamW),
+        beta1,
+        beta2,
+        group['lr'],
+        group['weight_decay'],
+        group['eps'],
+        group.get('maximize', False),
+        self.fused,
+        grad_scale,
+        getattr(self, 'stochastic_rounding', False))
+
+@torch.no_grad()
+def adam_step(self, closure=None):
+    """Performs a single optimization step of Adam or AdamW, of which the
+    update of each parameter is one fused pass over the parameter, its grad
+    and its states.
+
+    Args:
+        closure (callable, optional): A closure that reevaluates the model
+            and returns the loss.
+    """
+    loss = None
+    if closure is not None:
+        with torch.enable_grad():
+            loss = closure()
+
+    grad_scale = _fused_grad_scale(self)
+    for group in self.param_groups:
+        _adam_group_step(self, group, group['params'], grad_scale)
 
     return loss
 
@@ -258,12 +524,17 @@ def lamb_impl(
     lr: float,
     weight_decay: float,
     eps: float,
-    fused: bool):
+    fused: bool,
+    grad_scale: float = 1.,
+    stochastic_rounding: bool = False):
 
     r"""Functional API that performs Lamb algorithm computation.
-    See :class:`~torch.optim.Lamb` for details.
+    See :class:`~torch.optim.Lamb` for details. The grads are scaled by grad_scale to clip them, and the
+    pure bf16 params are rounded stochastically if stochastic_rounding.
     """
 
+    # the params of the fused step, updated by one call
+    fused_params, fused_exp_avgs, fused_exp_avg_sqs, fused_grads, fused_params2, fused_steps = [], [], [], [], [], []
     for i, param in enumerate(params):
 
         grad = grads[i]
@@ -279,20 +550,16 @@ def lamb_impl(
                 assert param.dtype is torch.float
                 param2 = attr[param][bf16_param]
         if fused:
-            torch.ops.torch_ipex.lamb_fused_step(
-                param,
-                exp_avg,
-                exp_avg_sq,
-                grad,
-                param2,
-                step,
-                beta1,
-                beta2,
-                lr,
-                weight_decay,
-                eps)
+            fused_params.append(param)
+            fused_exp_avgs.append(exp_avg)
+            fused_exp_avg_sqs.append(exp_avg_sq)
+            fused_grads.append(grad)
+            fused_params2.append(param2)
+            fused_steps.append(step)
             continue
 
+        if grad_scale != 1:
+            grad = grad.mul(grad_scale)
         bias_correction1 = 1 - beta1 ** step
         bias_correction2 = 1 - beta2 ** step
 
@@ -310,3 +577,70 @@ def lamb_impl(
         true_ratio = weight_norm / rtw_norm
 
         param.add_(adam_step, alpha=-lr * true_ratio)
+
+    if fused_params:
+        torch.ops.torch_ipex.lamb_fused_step_list(
+            fused_params,
+            fused_exp_avgs,
+            fused_exp_avg_sqs,
+            fused_grads,
+            fused_params2,
+            fused_steps,
+            beta1,
+            beta2,
+            lr,
+            weight_decay,
+            eps,
+            grad_scale,
+            stochastic_rounding)
+
+def rowwise_adagrad_impl(
+    params: List[Tensor],
+    grads: List[Tensor],
+    state_sums: List[Tensor],
+    attr: dict,
+    lr: float,
+    weight_decay: float,
+    eps: float,
+    fused: bool,
+    grad_scale: float = 1.,
+    stochastic_rounding: bool = False):
+    r"""Functional API that performs row-wise Adagrad algorithm computation.
+    See :class:`~intel_extension_for_pytorch.optim._rowwise_adagrad.RowwiseAdagrad` for details. Each
+    row of the first dim of a param keeps one state sum, and only the rows of a sparse grad are updated.
+    """
+
+    for i, param in enumerate(params):
+        grad = grads[i]
+        state_sum = state_sums[i]
+        param2 = torch.Tensor()
+        if param in attr and 'trail' in attr[param]:
+            assert param.dtype is torch.bfloat16
+            param2 = attr[param]['trail']
+        if fused:
+            torch.ops.torch_ipex.rowwise_adagrad_fused_step(
+                param,
+                grad,
+                state_sum,
+                param2,
+                lr,
+                weight_decay,
+                eps,
+                grad_scale,
+                stochastic_rounding)
+            continue
+
+        if grad.is_sparse:
+            grad = grad.coalesce()
+            rows = grad._indices()[0]
+            values = grad._values()
+        else:
+            rows = torch.arange(param.size(0))
+            values = grad
+        if grad_scale != 1:
+            values = values.mul(grad_scale)
+        if weight_decay != 0:
+            values = values.add(param.index_select(0, rows), alpha=weight_decay)
+        state_sum.index_add_(0, rows, values.reshape(values.size(0), -1).pow(2).mean(1))
+        multiplier = lr / (state_sum.index_select(0, rows).sqrt() + eps)
+        param.index_add_(0, rows, -multiplier.reshape([-1] + [1] * (values.dim() - 1)) * values)
@@ -0,0 +1,68 @@
+import torch
+import types
+
+def fuse_grad_accumulation(optimizer):
+    r"""
+    Accumulate the grads of the params of the optimizer into one flat and contiguous float buffer,
+    optimizer.grad_buffer, of which the grad of each param is a view. The grad of a float param is
+    accumulated into its view by the backward, and the bf16 grad of the bf16 param of a float master
+    weight, i.e. of ipex.optimize with dtype=torch.bfloat16 and split_master_weight_for_bf16=False, is
+    converted and accumulated in one fused pass from the hook of its AccumulateGrad node, rather than
+    cast to float by the step. Then the grads of the micro-batches are accumulated without the casts,
+    optimizer.zero_grad() zeros the buffer at once, and the buffer can be reduced across the ranks by one
+    torch.distributed.all_reduce. The params of the split bf16 master weight, of which the fused steps
+    expect the bf16 grads, are not supported.
+
+    Examples:
+
+        >>> model, optimizer = ipex.optimize(model, dtype=torch.bfloat16, optimizer=optimizer,
+        ...                                  split_master_weight_for_bf16=False)
+        >>> ipex.optim.fuse_grad_accumulation(optimizer)
+        >>> for micro_batch in micro_batches:
+        ...     model(micro_batch).sum().backward()
+        >>> torch.distributed.all_reduce(optimizer.grad_buffer)
+        >>> optimizer.step()
+        >>> optimizer.zero_grad()
+    """
+    params_attr = getattr(optimizer, 'params_attr', {})
+    params = [p for group in optimizer.param_groups for p in group['params'] if p.requires_grad]
+    for p in params:
+        assert p.dtype is torch.float and not p.is_sparse, \
+            "fuse_grad_accumulation expects the float params or the float master weights"
+    grad_buffer = torch.zeros(sum(p.numel() for p in params), dtype=torch.float)
+    # the AccumulateGrad nodes are kept, or the nodes with the hooks are released with the graph
+    grad_accs = []
+    views = []
+
+    def make_hook(p, leaf, view):
+        def hook(*unused):
+            grad = leaf.grad
+            if grad is None or grad.data_ptr() == view.data_ptr():
+                return
+            torch.ops.torch_ipex.grad_accumulate_(view, grad)
+            # the grad of a float param is accumulated into the view by the next backwards
+            leaf.grad = view if leaf is p else None
+        return hook
+
+    offset = 0
+    for p in params:
+        view = grad_buffer[offset:offset + p.numel()].view(p.shape)
+        offset += p.numel()
+        attr = params_attr.get(p, {})
+        # the bf16 param of the model of a float master weight
+        leaf = attr.get('bf16_param', p)
+        p.grad = view
+        views.append((p, view))
+        grad_acc = leaf.expand_as(leaf).grad_fn.next_functions[0][0]
+        grad_acc.register_hook(make_hook(p, leaf, view))
+        grad_accs.append(grad_acc)
+
+    def zero_grad(self, set_to_none=False):
+        grad_buffer.zero_()
+        for p, view in views:
+            p.grad = view
+
+    setattr(optimizer, 'grad_buffer', grad_buffer)
+    setattr(optimizer, '_grad_accumulation_grad_accs', grad_accs)
+    setattr(optimizer, 'zero_grad', types.MethodType(zero_grad, optimizer))
+    return optimizer
@@ -1,5 +1,5 @@
 import torch
-from ._functional import lamb_impl
+from ._functional import lamb_impl, _fused_grad_scale
 
 
 class Lamb(torch.optim.Optimizer):
@@ -42,6 +42,57 @@ class Lamb(torch.optim.Optimizer):
     def __setstate__(self, state):
         super(Lamb, self).__setstate__(state)
 
+    def _group_step(self, group, params, grad_scale=1.):
+        r"""The step of the params of a param group, e.g. of a bucket of the params."""
+        params_with_grad = []
+        grads = []
+        exp_avgs = []
+        exp_avg_sqs = []
+        trails = []
+        state_steps = []
+
+        for p in params:
+            if p.grad is not None:
+                params_with_grad.append(p)
+                if p.grad.is_sparse:
+                    raise RuntimeError('Lamb does not support sparse gradients')
+                if p.grad.device != torch.device('cpu'):
+                    raise RuntimeError('Lamb supports only CPU device')
+                grads.append(p.grad)
+
+                state = self.state[p]
+                # Lazy state initialization
+                if len(state) == 0:
+                    state['step'] = 0
+                    buffer_dtype = p.dtype if p.dtype is torch.float64 else torch.float
+                    state['exp_avg'] = torch.zeros(p.shape, dtype=buffer_dtype)
+                    state['exp_avg_sq'] = torch.zeros(p.shape, dtype=buffer_dtype)
+
+                exp_avgs.append(state['exp_avg'])
+                exp_avg_sqs.append(state['exp_avg_sq'])
+
+                # update the steps for each param group update
+                state['step'] += 1
+                # record the step after step update
+                state_steps.append(state['step'])
+
+        beta1, beta2 = group['betas']
+        lamb_impl(
+            params_with_grad,
+            grads,
+            exp_avgs,
+            exp_avg_sqs,
+            self.params_attr,
+            state_steps,
+            beta1,
+            beta2,
+            group['lr'],
+            group['weight_decay'],
+            group['eps'],
+            self.fused,
+            grad_scale,
+            getattr(self, 'stochastic_rounding', False))
+
     @torch.no_grad()
     def step(self, closure=None):
         """Performs a single optimization step.
@@ -54,51 +105,7 @@ class Lamb(torch.optim.Optimizer):
             with torch.enable_grad():
                 loss = closure()
 
+        grad_scale = _fused_grad_scale(self)
         for group in self.param_groups:
-            params_with_grad = []
-            grads = []
-            exp_avgs = []
-            exp_avg_sqs = []
-            trails = []
-            state_steps = []
-
-            for p in group['params']:
-                if p.grad is not None:
-                    params_with_grad.append(p)
-                    if p.grad.is_sparse:
-                        raise RuntimeError('Lamb does not support sparse gradients')
-                    if p.grad.device != torch.device('cpu'):
-                        raise RuntimeError('Lamb supports only CPU device')
-                    grads.append(p.grad)
-
-                    state = self.state[p]
-                    # Lazy state initialization
-                    if len(state) == 0:
-                        state['step'] = 0
-                        buffer_dtype = p.dtype if p.dtype is torch.float64 else torch.float
-                        state['exp_avg'] = torch.zeros(p.shape, dtype=buffer_dtype)
-                        state['exp_avg_sq'] = torch.zeros(p.shape, dtype=buffer_dtype)
-
-                    exp_avgs.append(state['exp_avg'])
-                    exp_avg_sqs.append(state['exp_avg_sq'])
-
-                    # update the steps for each param group update
-                    state['step'] += 1
-                    # record the step after step update
-                    state_steps.append(state['step'])
-
-            beta1, beta2 = group['betas']
-            lamb_impl(
-                params_with_grad,
-                grads,
-                exp_avgs,
-                exp_avg_sqs,
-                self.params_attr,
-                state_steps,
-                beta1,
-                beta2,
-                group['lr'],
-                group['weight_decay'],
-                group['eps'],
-                self.fused)
+            self._group_step(group, group['params'], grad_scale)
         return loss
@@ -1,19 +1,38 @@
 import torch
+import collections
 import copy
+import functools
 import types
 import warnings
-from ._functional import sgd_step, adagrad_step
+from ._functional import sgd_step, adagrad_step, adam_step
+from ._functional import _sgd_group_step, _adagrad_group_step, _adam_group_step
 from ._lamb import Lamb
+from ._rowwise_adagrad import RowwiseAdagrad
 
 IPEX_FUSED_OPTIMIZER_LIST = [
     torch.optim.SGD,
     torch.optim.Adagrad,
+    torch.optim.Adam,
+    torch.optim.AdamW,
     Lamb,
+    RowwiseAdagrad,
 ]
 
+# the ipex customized optimizers, of which the step is fused if fused
+IPEX_CUSTOMIZED_OPTIMIZERS = (Lamb, RowwiseAdagrad)
+
 OPTIMIZER_FUSED_STEP_MAPPING = {
     torch.optim.SGD: sgd_step,
     torch.optim.Adagrad: adagrad_step,
+    torch.optim.Adam: adam_step,
+    torch.optim.AdamW: adam_step,
+}
+
+OPTIMIZER_GROUP_STEP_MAPPING = {
+    torch.optim.SGD: _sgd_group_step,
+    torch.optim.Adagrad: _adagrad_group_step,
+    torch.optim.Adam: _adam_group_step,
+    torch.optim.AdamW: _adam_group_step,
 }
 
 def patch_step_for_master_weight_training(optimizer):
@@ -24,9 +43,10 @@ def patch_step_for_master_weight_training(optimizer):
     3.Sync FP32 master weight back to BF16 weight
     """
     def master_param_non_fused_step(self, closure=None):
-        # convert bf16 weight'grad to float.
-        for k, value in self.params_attr.items():
-            k.grad = value['bf16_param'].grad.detach().float()
+        # convert bf16 weight'grad to float, unless fuse_grad_accumulation accumulates them in float.
+        if not hasattr(self, 'grad_buffer'):
+            for k, value in self.params_attr.items():
+                k.grad = value['bf16_param'].grad.detach().float()
         loss = self._original_step(closure)
         # sync mater weight to model's paramerter
         for k, value in self.params_attr.items():
@@ -170,7 +190,7 @@ def optimizer_fusion(optimizer, master_weight_split):
     setattr(optimizer, 'fused', True)
     if not hasattr(optimizer, 'params_attr'):
         setattr(optimizer, 'params_attr', {})
-    if isinstance(optimizer, Lamb):
+    if isinstance(optimizer, IPEX_CUSTOMIZED_OPTIMIZERS):
         # lamb is ipex customized optimizer, does not to patch "step" method
         return optimizer
     try:
@@ -181,3 +201,146 @@ def optimizer_fusion(optimizer, master_weight_split):
     except KeyError:
         warnings.warn("Does not suport fused step for " + str(type(optimizer)) + ", will use non-fused step")
     return optimizer
+
+def fuse_clip_grad_norm(optimizer, max_norm):
+    r"""
+    Clip the grads of all the params of the optimizer by their global L2 norm in each step, as
+    torch.nn.utils.clip_grad_norm_(params, max_norm) before the step does. The norm is computed in one
+    pass over the grads, and the fused steps apply the clip coefficient while updating each param, so
+    that the grads are not scaled in another pass. The norm of the last step is kept in
+    optimizer.last_grad_norm. It works with the fused optimizers returned by ipex.optimize and with Lamb,
+    and max_norm of None disables it.
+
+    Examples:
+
+        >>> model, optimizer = ipex.optimize(model, dtype=torch.bfloat16, optimizer=optimizer)
+        >>> ipex.optim.fuse_clip_grad_norm(optimizer, max_norm=1.0)
+        >>> loss.backward()
+        >>> optimizer.step()
+    """
+    fused_step = OPTIMIZER_FUSED_STEP_MAPPING.get(type(optimizer))
+    assert isinstance(optimizer, IPEX_CUSTOMIZED_OPTIMIZERS) or \
+        (fused_step is not None and getattr(optimizer.step, '__func__', None) is fused_step), \
+        "fuse_clip_grad_norm expects an optimizer of the fused step returned by ipex.optimize or Lamb"
+    setattr(optimizer, 'max_grad_norm', None if max_norm is None else float(max_norm))
+    return optimizer
+
+def enable_stochastic_rounding(optimizer, enabled=True):
+    r"""
+    Round the updated pure bf16 params, i.e. of the bf16 model without the split master weight or the
+    float master weight, stochastically in the fused steps rather than to the nearest bf16. A param is
+    rounded up with the probability of the low 16 bits of its float update dropped, so that the updates
+    smaller than the precision of bf16 are not lost in expectation, and the model converges without the
+    memory of the master weight. The random bits are drawn from the default CPU generator, so that
+    torch.manual_seed reproduces them. It works with the fused optimizers returned by ipex.optimize and
+    with Lamb.
+
+    Examples:
+
+        >>> model = model.bfloat16()
+        >>> model, optimizer = ipex.optimize(model, optimizer=optimizer)
+        >>> ipex.optim.enable_stochastic_rounding(optimizer)
+    """
+    assert getattr(optimizer, 'fused', False), \
+        "enable_stochastic_rounding expects an optimizer of the fused step returned by ipex.optimize or Lamb"
+    setattr(optimizer, 'stochastic_rounding', enabled)
+    return optimizer
+
+def fused_group_step(optimizer, api_name):
+    r"""
+    The step of the params of a param group of the optimizer of the fused step returned by ipex.optimize
+    or Lamb, called as group_step(group, params, grad_scale=1.).
+    """
+    if isinstance(optimizer, IPEX_CUSTOMIZED_OPTIMIZERS):
+        return optimizer._group_step
+    fused_step = OPTIMIZER_FUSED_STEP_MAPPING.get(type(optimizer))
+    assert fused_step is not None and getattr(optimizer.step, '__func__', None) is fused_step, \
+        api_name + " expects an optimizer of the fused step returned by ipex.optimize or Lamb"
+    return functools.partial(OPTIMIZER_GROUP_STEP_MAPPING[type(optimizer)], optimizer)
+
+class _OverlappedStep(torch.nn.Module):
+    r"""
+    The module of the Task of the overlapped steps. Each run steps the next bucket of the queue of the
+    ready buckets, so that the runs share no inputs, and they run in the order of the submissions.
+    """
+    def __init__(self, group_step):
+        super(_OverlappedStep, self).__init__()
+        self.group_step = group_step
+        self.ready = collections.deque()
+
+    def forward(self):
+        group, params = self.ready.popleft()
+        with torch.no_grad():
+            self.group_step(group, params)
+
+def overlap_step_with_backward(optimizer, cpu_pool, bucket_size_mb=4):
+    r"""
+    Overlap the fused step of the optimizer with the backward. The params of each param group are packed
+    in the reverse order, i.e. about the order of their grads in the backward, into the buckets of about
+    bucket_size_mb MB, and the step of a bucket is submitted to a Task on the cores of cpu_pool as soon
+    as the grads of all its params are accumulated, from the hooks of their AccumulateGrad nodes. Then
+    optimizer.step() waits for the steps of the buckets, and steps the params of the buckets of which
+    only some params got grads in the backward. The cores of cpu_pool are best spared from the backward,
+    e.g. of a model, of which the intra op threads run on the other cores. It works with the fused
+    optimizers returned by ipex.optimize and with Lamb, and not with fuse_clip_grad_norm, of which the
+    norm needs all the grads, nor with the accumulation of the grads of several backwards in one step.
+
+    Examples:
+
+        >>> model, optimizer = ipex.optimize(model, dtype=torch.bfloat16, optimizer=optimizer)
+        >>> cpu_pool = ipex.cpu.runtime.CPUPool(core_ids=[26, 27])
+        >>> ipex.optim.overlap_step_with_backward(optimizer, cpu_pool)
+        >>> loss.backward()
+        >>> optimizer.step()
+    """
+    from ..cpu.runtime import Task
+    from .. import _C
+    group_step = fused_group_step(optimizer, 'overlap_step_with_backward')
+    assert getattr(optimizer, 'max_grad_norm', None) is None, \
+        "overlap_step_with_backward does not support fuse_clip_grad_norm"
+
+    overlapped = _OverlappedStep(group_step)
+    task = Task(overlapped, cpu_pool)
+    bucket_size = bucket_size_mb * 1024 * 1024
+    # the params and the ready params of each bucket
+    buckets = []
+    futures = []
+    # the AccumulateGrad nodes are kept, or the nodes with the hooks are released with the graph
+    grad_accs = []
+
+    def make_hook(group, params, ready, p):
+        def hook(*unused):
+            ready.append(p)
+            if len(ready) == len(params):
+                overlapped.ready.append((group, list(ready)))
+                ready.clear()
+                futures.append(task())
+        return hook
+
+    for group in optimizer.param_groups:
+        params = [p for p in reversed(group['params']) if p.requires_grad]
+        begin, nbytes = 0, 0
+        for i, p in enumerate(params):
+            nbytes += p.numel() * p.element_size()
+            if nbytes >= bucket_size or i == len(params) - 1:
+                buckets.append((group, params[begin:i + 1], []))
+                begin, nbytes = i + 1, 0
+    for group, params, ready in buckets:
+        for p in params:
+            grad_acc = p.expand_as(p).grad_fn.next_functions[0][0]
+            grad_acc.register_hook(make_hook(group, params, ready, p))
+            grad_accs.append(grad_acc)
+
+    def overlapped_step(self, closure=None):
+        assert closure is None, "overlap_step_with_backward does not support the closure of step"
+        _C.wait_all(futures)
+        futures.clear()
+        for group, params, ready in buckets:
+            if len(ready) > 0:
+                with torch.no_grad():
+                    group_step(group, list(ready))
+                ready.clear()
+
+    setattr(optimizer, '_overlap_grad_accs', grad_accs)
+    setattr(optimizer, 'step', types.MethodType(overlapped_step, optimizer))
+    return optimizer
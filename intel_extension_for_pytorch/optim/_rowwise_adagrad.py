@@ -0,0 +1,92 @@
+import torch
+from ._functional import rowwise_adagrad_impl, _fused_grad_scale
+
+
+class RowwiseAdagrad(torch.optim.Optimizer):
+    r"""Implements row-wise Adagrad algorithm, e.g. for the embedding tables.
+    Each row of the first dim of a param keeps one state sum, the sum of the mean squared grads of the
+    row, and is updated by param -= lr / (sqrt(state_sum) + eps) * grad, so that the state is
+    feature_size times smaller than of Adagrad. Only the rows of a sparse grad, e.g. of
+    nn.EmbeddingBag(sparse=True), are read and updated. It is the update of
+    MergedEmbeddingBagWithRowwiseAdagrad, for the tables out of a MergedEmbeddingBag.
+    Args:
+        params (iterable): iterable of parameters to optimize or dicts defining
+            parameter groups
+        lr (float, optional): learning rate (default: 1e-2)
+        weight_decay (float, optional): weight decay (L2 penalty) (default: 0)
+        eps (float, optional): term added to the denominator to improve
+            numerical stability (default: 1e-10)
+        initial_accumulator_value (float, optional): the initial state sum of
+            each row (default: 0)
+        fused (boolean, optional): whether to use fused kernel to accelerate
+            (default: False)
+    """
+
+    def __init__(self, params, lr=1e-2, weight_decay=0, eps=1e-10,
+                 initial_accumulator_value=0, fused=False):
+        if not 0.0 <= lr:
+            raise ValueError("Invalid learning rate: {}".format(lr))
+        if not 0.0 <= eps:
+            raise ValueError("Invalid epsilon value: {}".format(eps))
+        if not 0.0 <= weight_decay:
+            raise ValueError("Invalid weight_decay value: {}".format(weight_decay))
+        if not 0.0 <= initial_accumulator_value:
+            raise ValueError("Invalid initial_accumulator_value value: {}".format(initial_accumulator_value))
+        defaults = dict(lr=lr, weight_decay=weight_decay, eps=eps,
+                        initial_accumulator_value=initial_accumulator_value, fused=fused)
+        super(RowwiseAdagrad, self).__init__(params, defaults)
+        self.params_attr = {}
+        self.fused = fused
+
+    def __setstate__(self, state):
+        super(RowwiseAdagrad, self).__setstate__(state)
+
+    def _group_step(self, group, params, grad_scale=1.):
+        r"""The step of the params of a param group, e.g. of a bucket of the params."""
+        params_with_grad = []
+        grads = []
+        state_sums = []
+
+        for p in params:
+            if p.grad is not None:
+                if p.dim() == 0:
+                    raise RuntimeError('RowwiseAdagrad expects the params of at least 1 dim')
+                params_with_grad.append(p)
+                grads.append(p.grad)
+
+                state = self.state[p]
+                # Lazy state initialization, the state sums of a bf16 param are of float
+                if len(state) == 0:
+                    buffer_dtype = p.dtype if p.dtype is torch.float64 else torch.float
+                    state['sum'] = torch.full(
+                        (p.size(0),), group['initial_accumulator_value'], dtype=buffer_dtype)
+                state_sums.append(state['sum'])
+
+        rowwise_adagrad_impl(
+            params_with_grad,
+            grads,
+            state_sums,
+            self.params_attr,
+            group['lr'],
+            group['weight_decay'],
+            group['eps'],
+            self.fused,
+            grad_scale,
+            getattr(self, 'stochastic_rounding', False))
+
+    @torch.no_grad()
+    def step(self, closure=None):
+        """Performs a single optimization step.
+        Args:
+            closure (callable, optional): A closure that reevaluates the model
+                and returns the loss.
+        """
+        loss = None
+        if closure is not None:
+            with torch.enable_grad():
+                loss = closure()
+
+        grad_scale = _fused_grad_scale(self)
+        for group in self.param_groups:
+            self._group_step(group, group['params'], grad_scale)
+        return loss
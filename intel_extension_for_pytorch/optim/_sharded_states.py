@@ -0,0 +1,94 @@
+import torch
+import torch.distributed as dist
+import types
+from torch._utils import _flatten_dense_tensors, _unflatten_dense_tensors
+from typing import List
+from ._functional import _fused_grad_scale
+from ._optimizer_utils import fused_group_step
+
+def shard_params(params: List[torch.Tensor], world_size: int):
+    r"""
+    Assign each param to a rank, the largest params first to the rank of the fewest bytes so far, so that
+    the ranks hold about the same optimizer states. Return the rank of each param.
+    """
+    def param_bytes(p):
+        return p.numel() * p.element_size()
+
+    rank_bytes = [0] * world_size
+    owners = [0] * len(params)
+    for i in sorted(range(len(params)), key=lambda i: (-param_bytes(params[i]), i)):
+        rank = min(range(world_size), key=lambda r: (rank_bytes[r], r))
+        owners[i] = rank
+        rank_bytes[rank] += param_bytes(params[i])
+    return owners
+
+def shard_optimizer_states(optimizer, group=None):
+    r"""
+    Shard the states and the fused step of the optimizer across the ranks of the process group, as ZeRO
+    stage 1. Each param is owned by one rank, of which the optimizer keeps the states of the param, e.g.
+    exp_avg and exp_avg_sq of Adam and Lamb, and updates the param with the fused kernels in the step.
+    Then the updated params, and the trails of the split bf16 master weights, are broadcast from their
+    ranks in one flattened buffer of each rank and dtype. The whole params are sharded rather than their
+    elements, so that the trust ratio of Lamb is of the whole param. The grads are expected to be reduced
+    across the ranks before the step, e.g. by DistributedDataParallel, and the state_dict of the optimizer
+    of each rank holds the states of its params. It works with the fused optimizers returned by
+    ipex.optimize and with Lamb, and fuse_clip_grad_norm is called before it.
+
+    Examples:
+
+        >>> model, optimizer = ipex.optimize(model, dtype=torch.bfloat16, optimizer=optimizer)
+        >>> model = torch.nn.parallel.DistributedDataParallel(model)
+        >>> ipex.optim.shard_optimizer_states(optimizer)
+        >>> loss.backward()
+        >>> optimizer.step()
+    """
+    group_step = fused_group_step(optimizer, 'shard_optimizer_states')
+    rank = dist.get_rank(group)
+    world_size = dist.get_world_size(group)
+    params = [p for param_group in optimizer.param_groups for p in param_group['params']]
+    owners = shard_params(params, world_size)
+    owner_of = {p: owner for p, owner in zip(params, owners)}
+
+    local_groups = []
+    # the tensors broadcast from each rank, of each dtype
+    buckets = {}
+    for param_group in optimizer.param_groups:
+        local_groups.append((param_group, [p for p in param_group['params'] if owner_of[p] == rank]))
+        for p in param_group['params']:
+            owner = owner_of[p]
+            if owner != rank:
+                # the states of the params of the other ranks, e.g. of Adagrad, are initialized eagerly
+                optimizer.state.pop(p, None)
+            tensors = [p]
+            attr = optimizer.params_attr.get(p, {})
+            if 'trail' in attr:
+                tensors.append(attr['trail'])
+            for t in tensors:
+                buckets.setdefault((owner, t.dtype), []).append(t)
+    # the global ranks of the broadcasts
+    src_of = [r if group is None else dist.distributed_c10d._get_global_rank(group, r) for r in range(world_size)]
+
+    def sharded_step(self, closure=None):
+        loss = None
+        if closure is not None:
+            with torch.enable_grad():
+                loss = closure()
+
+        with torch.no_grad():
+            grad_scale = _fused_grad_scale(self)
+            for param_group, local_params in local_groups:
+                group_step(param_group, local_params, grad_scale)
+            works = []
+            for (owner, _), tensors in buckets.items():
+                flat = _flatten_dense_tensors(tensors)
+                work = dist.broadcast(flat, src_of[owner], group=group, async_op=True)
+                works.append((work, owner, flat, tensors))
+            for work, owner, flat, tensors in works:
+                work.wait()
+                if owner != rank:
+                    for t, synced in zip(tensors, _unflatten_dense_tensors(flat, tensors)):
+                        t.copy_(synced)
+        return loss
+
+    setattr(optimizer, 'step', types.MethodType(sharded_step, optimizer))
+    return optimizer
@@ -1,4 +1,5 @@
 from .quantization_utils import calibrate, convert
 from .conf import QuantConf
+from ._autotune import autotune
 from . import _autocast_mode
 
@@ -0,0 +1,120 @@
+import copy
+import time
+import warnings
+import torch
+import intel_extension_for_pytorch._C as core
+from .conf import QuantConf
+from .quantization_utils import calibrate, convert
+
+def _flatten(outputs):
+    if isinstance(outputs, torch.Tensor):
+        return [outputs]
+    if isinstance(outputs, (list, tuple)):
+        return [t for output in outputs for t in _flatten(output)]
+    if isinstance(outputs, dict):
+        return [t for output in outputs.values() for t in _flatten(output)]
+    return []
+
+def _relative_error(ref_outputs, outputs):
+    # the max relative L2 error of the floating point outputs
+    error = 0.
+    for ref, output in zip(_flatten(ref_outputs), _flatten(outputs)):
+        if not ref.is_floating_point():
+            continue
+        ref, output = ref.float(), output.float()
+        error = max(error, ((output - ref).norm() / ref.norm().clamp(min=1e-12)).item())
+    return error
+
+def _fallback(configures, ops):
+    # run the ops in the higher precision, i.e. without their quantizers
+    configures = copy.deepcopy(configures)
+    for i in ops:
+        configures[i]['inputs_quantized'] = [False] * len(configures[i]['inputs_quantized'])
+        configures[i]['outputs_quantized'] = [False] * len(configures[i]['outputs_quantized'])
+    return configures
+
+def _evaluate(model, conf, inputs, ref_outputs, configures, metric, iterations):
+    core.clear_indicators()
+    core.load_indicators_file(configures)
+    trace_model = convert(model, conf, inputs[0])
+    with torch.no_grad():
+        # the graph is fused by the first runs
+        for x in inputs[:2]:
+            trace_model(*x)
+        outputs = [trace_model(*x) for x in inputs]
+        start = time.time()
+        for _ in range(iterations):
+            for x in inputs:
+                trace_model(*x)
+        latency = (time.time() - start) / iterations
+    error = max(metric(ref, output) for ref, output in zip(ref_outputs, outputs))
+    return error, latency
+
+def autotune(model, inputs, conf=None, tolerance=0.01, metric=None, iterations=10):
+    r"""
+    Search the precision of each quantized op of a model, so that the int8 model is as fast as
+    possible while its outputs stay within an error tolerance of the outputs of the FP32 model.
+
+    The model is calibrated with the inputs, and the int8 model of the calibrated recipe is
+    evaluated. If its error exceeds the tolerance, the sensitivity of each op is measured by the
+    error and the latency of the model of which only this op runs in the higher precision, i.e.
+    without its quantizers, then the ops are greedily run in the higher precision, in the order of
+    the error recovered per the latency lost, until the error is within the tolerance. The higher
+    precision is FP32, or BF16 if the model is converted under ``torch.cpu.amp.autocast()``.
+
+    Args:
+        model (torch.nn.Module): The FP32 model to be quantized.
+        inputs (list): The inputs of the model, each a tuple of the args or a torch.Tensor, used
+            for the calibration, the error and the latency.
+        conf (quantization.QuantConf): Quantization's setting, a default one if it is None.
+        tolerance (float): The max error of the outputs. The default value is ``0.01``.
+        metric (callable): ``metric(fp32_outputs, int8_outputs)`` returns the error of the outputs
+            of one input, the max relative L2 error of the floating point outputs by default.
+        iterations (int): The number of the runs over the inputs to measure the latency.
+
+    Returns:
+        quantization.QuantConf, of which the recipe is loaded, and can be saved by its ``save``.
+
+    Examples:
+
+        >>> conf = ipex.quantization.autotune(model, calibration_inputs, tolerance=0.01)
+        >>> conf.save('configure.json')
+    """
+    assert isinstance(model, torch.nn.Module), "Only support nn.Module autotune for quantization path"
+    if conf is None:
+        conf = QuantConf()
+    if metric is None:
+        metric = _relative_error
+    inputs = [x if isinstance(x, tuple) else (x,) for x in inputs]
+    model.eval()
+    with torch.no_grad():
+        ref_outputs = [model(*x) for x in inputs]
+        with calibrate(conf):
+            for x in inputs:
+                model(*x)
+    configures = core.get_int8_configures()
+    candidates = [i for i, c in enumerate(configures) if any(c['inputs_quantized']) or any(c['outputs_quantized'])]
+
+    def evaluate(recipe):
+        return _evaluate(model, conf, inputs, ref_outputs, recipe, metric, iterations)
+
+    recipe = configures
+    error, latency = evaluate(configures)
+    if error > tolerance:
+        gains = {}
+        for i in candidates:
+            error_i, latency_i = evaluate(_fallback(configures, [i]))
+            gains[i] = (error - error_i) / max(latency_i - latency, 1e-9)
+        fallback_ops = []
+        for i in sorted(candidates, key=lambda i: gains[i], reverse=True):
+            fallback_ops.append(i)
+            recipe = _fallback(configures, fallback_ops)
+            error, _ = evaluate(recipe)
+            if error <= tolerance:
+                break
+        if error > tolerance:
+            warnings.warn("autotune: the error {} exceeds the tolerance {} with all the ops in the higher precision"
+                          .format(error, tolerance))
+    core.clear_indicators()
+    core.load_indicators_file(recipe)
+    return conf
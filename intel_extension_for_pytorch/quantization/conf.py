@@ -9,20 +9,27 @@ qscheme_dict ={torch.per_tensor_affine:0,
                torch.per_channel_symmetric:3,
                torch.torch.per_channel_affine_float_qparams:4}
 
+observer_algorithms = ['min_max', 'moving_averager_min_max', 'percentile', 'kl_divergence', 'mse']
+
 class QuantConf(object):
     r"""
     Configure setting for INT8 quantization flow.
 
     Args:
-        configure_file (string): The INT8 configure file(.json file) to be
-            loaded or saved.
+        configure_file (string): The INT8 configure file(.json file, or the binary
+            file saved by ``save(configure_file, binary=True)``) to be loaded or saved.
         qscheme (torch.qscheme): quantization scheme to be used(activation)
+        algorithm (string): observe method for activation tensors during calibration,
+            can be min_max, moving_averager_min_max, percentile, kl_divergence or mse.
+            The histogram based percentile, kl_divergence and mse methods clip the
+            outliers of the activations rather than quantize their full ranges. It is
+            used if the configure_file does not set it. The default value is min_max.
 
     Available configurations in the *configure_file* are:
 
         * id (int): The number of quantized ops in the model running flow.  Note: only limited ops are reordered, such as convolution, linear or other ops.
         * name (string): Quantized OP's name.
-        * algorithm (string): observe method for activation tensors during calibration. Only support min-max now, more methods will be support in future.
+        * algorithm (string): observe method for activation tensors during calibration. Can be min_max, moving_averager_min_max, percentile (clip at the 99.99th percentile of the absolute values), kl_divergence (clip at the threshold of which the quantized distribution has the smallest KL divergence) or mse (clip at the threshold of the smallest expected quantization error).
         * weight_granularity (Qscheme): Qscheme for weight quantizer for convolution and linear, can be per_channel or per_tesor, user can manually set it before load existed configure file. The default value is uint8.
         * input_scales: Scales for inputs.
         * input_zero_points: Zero points for inputs.
@@ -95,26 +102,47 @@ class QuantConf(object):
 
     """
 
-    def __init__(self, configure_file=None, qscheme=torch.per_tensor_affine):
+    def __init__(self, configure_file=None, qscheme=torch.per_tensor_affine, algorithm='min_max'):
         self.configure_file = configure_file
 
         core.clear_indicators()
         assert qscheme in [torch.per_tensor_affine, torch.per_tensor_symmetric], \
             "qscheme is only support torch.per_tensor_affine and torch.per_tensor_symmetric now"
         core.set_int8_qscheme(qscheme_dict[qscheme])
+        assert algorithm in observer_algorithms, \
+            "algorithm is only support {} now".format(", ".join(observer_algorithms))
+        core.set_int8_observer_algorithm(algorithm)
 
         # if user provides an existing configuration file, load it
         if self.configure_file != None:
             if os.path.exists(self.configure_file) and os.stat(self.configure_file).st_size != 0:
-                with open(self.configure_file, 'r') as f:
-                    configures = json.load(f)
-                    core.load_indicators_file(configures)
+                if core.is_indicators_binary_file(self.configure_file):
+                    core.load_indicators_binary_file(self.configure_file)
+                else:
+                    with open(self.configure_file, 'r') as f:
+                        configures = json.load(f)
+                        core.load_indicators_file(configures)
             else:
                 assert False, 'Can not load a empty file or none existed file, plese first do calibartion step'
 
-    def save(self, configure_file):
-        configures = core.get_int8_configures()
-        with open(configure_file, 'w') as fp:
-            json.dump(configures, fp, indent = 4)
+    def save(self, configure_file, binary=None):
+        r"""
+        Save the configures to a file.
+
+        Args:
+            configure_file (string): The file to be saved.
+            binary (bool): Whether to save the configures in the compact binary format, which
+                is loaded in C++ much faster than the json file for the models with many
+                quantized ops, but can not be edited by hand. If it is None, the binary format
+                is used if the configure_file ends with ``.bin``.
+        """
+        if binary is None:
+            binary = configure_file.endswith('.bin')
+        if binary:
+            core.save_indicators_binary_file(configure_file)
+        else:
+            configures = core.get_int8_configures()
+            with open(configure_file, 'w') as fp:
+                json.dump(configures, fp, indent = 4)
         # clear indicators after saved
         core.clear_indicators()
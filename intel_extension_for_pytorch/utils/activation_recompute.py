@@ -0,0 +1,121 @@
+import functools
+import weakref
+
+import torch
+
+# The bandwidth-bound layers of which the outputs are recomputed, of the
+# inputs kept by the graph anyway: the input of the layer_norm is saved by its
+# own backward, the one of the gelu by the gelu backward, and the one of the
+# dropout by the op before it, e.g. the softmax of the attention.
+_RECOMPUTED_MODULES = (torch.nn.LayerNorm, torch.nn.GELU, torch.nn.Dropout)
+
+class _Recompute(object):
+    # The saved output of a layer, recomputed by the layer of its inputs and,
+    # of a dropout, of the RNG state of its forward, so that the dropout draws
+    # the same mask. The inputs which are the outputs of the recomputed layers
+    # themselves, e.g. the gelu reading a layer_norm, are kept by their
+    # recomputations, so that a chain of the layers keeps the input of its
+    # first layer only.
+    def __init__(self, module, inputs, rng_state):
+        self.module = module
+        self.inputs = [_pack(t) if isinstance(t, torch.Tensor) else t for t in inputs]
+        self.versions = [t._version for t in self.inputs if isinstance(t, torch.Tensor)]
+        self.rng_state = rng_state
+        self.output = None
+
+    def recompute(self):
+        # the output saved by several backward nodes is recomputed once
+        output = self.output() if self.output is not None else None
+        if output is not None:
+            return output
+        versions = [t._version for t in self.inputs if isinstance(t, torch.Tensor)]
+        if versions != self.versions:
+            raise RuntimeError("activation_recompute: the input of the {} of which the output is recomputed "
+                               "has been modified by an inplace operation".format(type(self.module).__name__))
+        inputs = [_unpack(x) for x in self.inputs]
+        with torch.no_grad():
+            if self.rng_state is not None:
+                with torch.random.fork_rng(devices=[]):
+                    torch.set_rng_state(self.rng_state)
+                    output = self.module(*inputs)
+            else:
+                output = self.module(*inputs)
+        self.output = weakref.ref(output)
+        return output
+
+def _pack(t):
+    recompute = getattr(t, '_ipex_recompute', None)
+    return recompute if recompute is not None else t
+
+def _unpack(saved):
+    return saved.recompute() if isinstance(saved, _Recompute) else saved
+
+def _record_rng_state(module, inputs):
+    if module.training and torch.is_grad_enabled():
+        module._ipex_rng_state = torch.get_rng_state()
+
+def _tag_output(module, inputs, output):
+    rng_state = module.__dict__.pop('_ipex_rng_state', None)
+    if not torch.is_grad_enabled() or not isinstance(output, torch.Tensor) or \
+            any(output is t for t in inputs):
+        # nothing is saved without the grad, and the inplace dropout has no input to recompute of
+        return
+    output._ipex_recompute = _Recompute(module, inputs, rng_state)
+
+def enable_activation_recompute(model, module_types=None):
+    r"""
+    Recomputes the outputs of the cheap, bandwidth-bound layers of a training
+    model in the backward instead of saving them, e.g. of ``nn.LayerNorm``,
+    ``nn.GELU`` and ``nn.Dropout``, of which the output is mostly saved by the
+    backward of the next layer, e.g. the linear reading it, while their inputs
+    are kept by the graph anyway. The outputs of the linears, the convolutions
+    and the matmuls are saved as before. The peak memory of the activations of
+    the transformer blocks drops by the outputs of their layer_norms, of the
+    gelu of their FFN and of the dropouts of the attention probabilities, for
+    the cost of running these layers twice.
+
+    A dropout draws its mask of the same RNG state in the recomputation, of
+    ``torch.get_rng_state()`` kept per call, including the dropout of the
+    1-bit masks of ``ipex.optimize``. The recomputed output is of the inputs
+    of the layer, which are expected not to be modified in place before the
+    backward, or the backward raises.
+
+    The outputs of the layers are tagged in the forward of the model, of which
+    the saved tensors are then replaced by the recomputations by
+    ``torch.autograd.graph.saved_tensors_hooks``.
+
+    .. highlight:: python
+    .. code-block:: python
+
+        model, optimizer = ipex.optimize(model.train(), optimizer=optimizer)
+        ipex.enable_activation_recompute(model)
+        loss = criterion(model(x), y)
+        loss.backward()
+
+    Args:
+        model (torch.nn.Module): The training model, converted in place.
+        module_types (tuple): The types of the layers of which the outputs are
+            recomputed, e.g. the activation modules of the model. The default
+            value is ``None``, i.e. ``nn.LayerNorm``, ``nn.GELU`` and
+            ``nn.Dropout``.
+
+    Returns:
+        torch.nn.Module: The model.
+    """
+
+    module_types = tuple(module_types) if module_types is not None else _RECOMPUTED_MODULES
+    for module in model.modules():
+        if isinstance(module, module_types):
+            if isinstance(module, torch.nn.Dropout):
+                module.register_forward_pre_hook(_record_rng_state)
+            module.register_forward_hook(_tag_output)
+
+    forward = model.forward
+
+    @functools.wraps(forward)
+    def recompute_forward(*args, **kwargs):
+        with torch.autograd.graph.saved_tensors_hooks(_pack, _unpack):
+            return forward(*args, **kwargs)
+
+    model.forward = recompute_forward
+    return model
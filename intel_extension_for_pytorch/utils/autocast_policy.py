@@ -0,0 +1,84 @@
+import torch
+import intel_extension_for_pytorch._C as core
+
+def set_autocast_policy(op_type, lower_precision):
+    r"""
+    Set whether the ops of ``op_type`` of the lower_precision_fp category of
+    autocast, e.g. ``conv2d`` or ``linear``, run in bfloat16 or in float32.
+    The default is chosen by the bfloat16 ISA of the CPU: the ops run in
+    float32 on the CPUs without AVX-512, of which the bfloat16 kernels of
+    oneDNN are slower.
+
+    Args:
+        op_type (str): The op type, one of ``get_autocast_policy()``.
+        lower_precision (bool): Run the ops in the autocast dtype if True, or
+            in float32 if False.
+    """
+
+    assert op_type in core.get_autocast_lower_precision_ops(), \
+        "{} is not an op of the lower_precision_fp category".format(op_type)
+    core.set_autocast_lower_precision_enabled(op_type, lower_precision)
+
+def get_autocast_policy():
+    r"""
+    Returns:
+        dict: Whether each op type of the lower_precision_fp category runs in
+        the autocast dtype.
+    """
+
+    return {op: core.is_autocast_lower_precision_enabled(op) for op in core.get_autocast_lower_precision_ops()}
+
+def calibrate_autocast_policy(model, example_inputs, iterations=10):
+    r"""
+    Time each op type of the lower_precision_fp category of the inference of
+    ``model`` under ``torch.cpu.amp.autocast`` in bfloat16 and in float32,
+    including the casts of its inputs, and keep the faster policy of each op
+    type, so that autocast does not make the model slower on this CPU. The op
+    types that the model does not run keep their policies.
+
+    Args:
+        model (torch.nn.Module): The model to calibrate with.
+        example_inputs (tuple): The inputs of the model.
+        iterations (int): The timed iterations of each policy. The default
+            value is 10.
+
+    Returns:
+        dict: The policy of each op type, as ``get_autocast_policy()``.
+
+    Examples:
+
+        >>> ipex.calibrate_autocast_policy(model, (data,))
+        >>> with torch.cpu.amp.autocast(), torch.no_grad():
+        ...     model(data)
+    """
+
+    if isinstance(example_inputs, torch.Tensor):
+        example_inputs = (example_inputs,)
+    ops = core.get_autocast_lower_precision_ops()
+
+    def profile(lower_precision):
+        for op in ops:
+            core.set_autocast_lower_precision_enabled(op, lower_precision)
+        with torch.no_grad(), torch.cpu.amp.autocast():
+            # warm up, e.g. the oneDNN primitives and the cached casts of the weights
+            model(*example_inputs)
+            with torch.autograd.profiler.profile() as prof:
+                for _ in range(iterations):
+                    model(*example_inputs)
+        times = {}
+        for event in prof.key_averages():
+            op = event.key.split('::')[-1]
+            if op in ops:
+                times[op] = times.get(op, 0) + event.cpu_time_total
+        return times
+
+    policy = get_autocast_policy()
+    try:
+        bf16_times = profile(True)
+        fp32_times = profile(False)
+    finally:
+        for op, lower_precision in policy.items():
+            core.set_autocast_lower_precision_enabled(op, lower_precision)
+    for op in bf16_times.keys() & fp32_times.keys():
+        set_autocast_policy(op, bf16_times[op] <= fp32_times[op])
+    return get_autocast_policy()
@@ -0,0 +1,280 @@
+import json
+import platform
+import resource
+import time
+import numpy as np
+import torch
+import intel_extension_for_pytorch as ipex
+from ..cpu.runtime.cpupool import CPUPool
+from ..cpu.runtime.multi_stream import _get_stream_core_lists
+from ..cpu.runtime.task import Task, _warmup
+from ..cpu.runtime.tracing import trace_tasks, request_scope
+
+# The same buckets as the histograms of ipex.op_trace: bucket 0 counts the
+# latencies below 1 us, and bucket i the ones of [2^(i - 1), 2^i) us.
+_HISTOGRAM_BUCKETS = 24
+
+def _latency_histogram(latencies_us):
+    buckets = np.floor(np.log2(np.maximum(latencies_us, 1))) + 1
+    buckets[latencies_us < 1] = 0
+    buckets = np.minimum(buckets, _HISTOGRAM_BUCKETS - 1).astype(np.int64)
+    return np.bincount(buckets, minlength=_HISTOGRAM_BUCKETS).tolist()
+
+def _latency_stats(latencies_us):
+    latencies_ms = np.asarray(latencies_us) / 1000.
+    if latencies_ms.size == 0:
+        return {}
+    return {
+        'mean': float(latencies_ms.mean()),
+        'p50': float(np.percentile(latencies_ms, 50)),
+        'p90': float(np.percentile(latencies_ms, 90)),
+        'p99': float(np.percentile(latencies_ms, 99)),
+        'max': float(latencies_ms.max()),
+    }
+
+def _cpu_seconds():
+    usage = resource.getrusage(resource.RUSAGE_SELF)
+    return usage.ru_utime + usage.ru_stime
+
+def _as_tuple(inputs):
+    return inputs if isinstance(inputs, tuple) else (inputs,)
+
+def _run_closed_loop(tasks, inputs, duration, num_iters, first_request_id):
+    # Each stream runs one input at a time and gets the next one as soon as
+    # its last one is done, until the duration or the iterations are over.
+    num_streams = len(tasks)
+    request_id = first_request_id
+
+    def submit(stream):
+        nonlocal request_id
+        # the request id encodes the stream of the input
+        with request_scope(request_id * num_streams + stream):
+            future = tasks[stream](*inputs)
+        request_id += 1
+        return future
+
+    start = time.perf_counter()
+    futures = [submit(stream) for stream in range(num_streams)]
+    submitted = num_streams
+    while True:
+        stream = ipex._C.wait_any(futures)
+        futures[stream].get()
+        if num_iters is None:
+            done = time.perf_counter() - start >= duration
+        else:
+            done = submitted >= num_iters
+        if done:
+            break
+        futures[stream] = submit(stream)
+        submitted += 1
+    # drain the inputs in flight of the other streams
+    ipex._C.wait_all(futures[:stream] + futures[stream + 1:])
+    return time.perf_counter() - start, request_id
+
+def run_benchmark(model,
+                  inputs,
+                  num_streams=1,
+                  cpu_pool=None,
+                  warmup_runs=None,
+                  warmup_duration=1.0,
+                  duration=10.0,
+                  num_iters=None):
+    r"""
+    Measure the steady-state throughput and latency of the inference of a
+    model on ``num_streams`` streams, of which each is a
+    :class:`~intel_extension_for_pytorch.cpu.runtime.Task` on its share of
+    the cores of ``cpu_pool``, split as by
+    :class:`~intel_extension_for_pytorch.cpu.runtime.MultiStreamModule`.
+    Each stream runs ``inputs`` in a closed loop, i.e. it gets the next input
+    once its last one is done. The latency of each input is from its
+    submission to the end of its execution, taken by
+    :class:`~intel_extension_for_pytorch.cpu.runtime.trace_tasks`.
+
+    The streams first run the JIT warmup of
+    :meth:`~intel_extension_for_pytorch.cpu.runtime.Task.warmup`, then
+    ``warmup_duration`` seconds of the closed loop, which are not measured,
+    so that the caches, the memory arenas and the core frequencies settle.
+
+    Args:
+        model (torch.jit.ScriptModule or torch.nn.Module): The model, e.g.
+            optimized by :func:`~intel_extension_for_pytorch.optimize` and
+            traced for the dtype to measure.
+        inputs (torch.Tensor or tuple): The inputs of one stream, whose batch
+            size is the batch size of each stream.
+        num_streams (int): Number of streams. The default value is 1.
+        cpu_pool (intel_extension_for_pytorch.cpu.runtime.CPUPool): The cores
+            of all the streams. The default value is None, which means the
+            cores of numa node 0.
+        warmup_runs (int): Number of the JIT warmup runs of each stream. The
+            default value is None, which means the number of JIT profiled
+            runs plus one.
+        warmup_duration (float): Seconds of the closed loop before the
+            measurement. The default value is 1.0.
+        duration (float): Seconds of the measurement. The default value is
+            10.0.
+        num_iters (int): Number of the measured inputs of all the streams,
+            which overrides ``duration`` if set. The default value is None.
+
+    Returns:
+        dict: ``num_streams``, ``cores_per_stream``, ``iterations``,
+        ``duration_s``, ``throughput`` in inputs per second,
+        ``cpu_utilization``, i.e. the CPU time of the process over the time of
+        all the cores of ``cpu_pool``, ``latency_ms`` of the ``mean``,
+        ``p50``, ``p90``, ``p99`` and ``max`` latencies, and ``streams``, of
+        which each has its ``iterations``, ``latency_ms`` and ``histogram``
+        of the latencies, bucket 0 of which counts the ones below 1 us, and
+        bucket i the ones of [2^(i - 1), 2^i) us.
+    """
+
+    assert ipex.cpu.runtime.is_runtime_ext_enabled(), \
+        "The benchmark runs on the Tasks of the runtime extension, which needs the preload of the Intel OpenMP library"
+    assert num_streams >= 1
+    assert duration > 0 or num_iters is not None
+    if cpu_pool is None:
+        cpu_pool = CPUPool(node_id=0)
+    assert type(cpu_pool) is CPUPool
+    assert len(cpu_pool.core_ids) >= num_streams, "Each stream needs one core at least"
+    inputs = _as_tuple(inputs)
+    stream_core_lists = _get_stream_core_lists(cpu_pool.core_ids, num_streams)
+    tasks = [Task(model, CPUPool(core_list)) for core_list in stream_core_lists]
+
+    with torch.no_grad():
+        _warmup(tasks, [inputs], None, warmup_runs)
+        _, next_request_id = _run_closed_loop(tasks, inputs, warmup_duration, None, 0)
+        cpu_start = _cpu_seconds()
+        with trace_tasks() as trace:
+            wall, _ = _run_closed_loop(tasks, inputs, duration, num_iters, next_request_id)
+        cpu_time = _cpu_seconds() - cpu_start
+
+    stream_latencies = [[] for _ in range(num_streams)]
+    for record in trace.records:
+        # the inputs submitted without request_scope are not of the loop
+        if record['request_id'] >= 0:
+            stream_latencies[record['request_id'] % num_streams].append(
+                record['end_time_us'] - record['submit_time_us'])
+    streams = []
+    for stream, latencies in enumerate(stream_latencies):
+        latencies = np.asarray(latencies, dtype=np.float64)
+        streams.append({
+            'cores': stream_core_lists[stream],
+            'iterations': int(latencies.size),
+            'latency_ms': _latency_stats(latencies),
+            'histogram': _latency_histogram(latencies),
+        })
+    all_latencies = np.concatenate([np.asarray(latencies, dtype=np.float64) for latencies in stream_latencies])
+    return {
+        'num_streams': num_streams,
+        'cores_per_stream': len(cpu_pool.core_ids) // num_streams,
+        'iterations': int(all_latencies.size),
+        'duration_s': wall,
+        'throughput': all_latencies.size / wall,
+        'cpu_utilization': cpu_time / (wall * len(cpu_pool.core_ids)),
+        'latency_ms': _latency_stats(all_latencies),
+        'streams': streams,
+    }
+
+def get_environment():
+    r"""
+    Returns:
+        dict: The versions of IPEX and PyTorch, the ISA level of the kernels
+        and the CPU of the machine along with the fingerprint of its ISA
+        features, which identify the release and the SKU of the results of
+        :func:`sweep`.
+    """
+
+    return {
+        'ipex_version': ipex.__version__,
+        'torch_version': torch.__version__,
+        'isa_level': ipex._C._get_current_isa_level(),
+        'cpu': ipex._C._get_cpu_info(),
+        'cpu_features': ipex._C._get_cpu_features(),
+        # keys the baselines of perf_regression
+        'cpu_fingerprint': ipex._C._get_cpu_feature_fingerprint(),
+        'hostname': platform.node(),
+        'num_threads': torch.get_num_threads(),
+    }
+
+def sweep(name,
+          model_fn,
+          input_fn,
+          dtypes=(torch.float32,),
+          num_streams=(1,),
+          batch_sizes=(1,),
+          cpu_pool=None,
+          output=None,
+          **kwargs):
+    r"""
+    Run :func:`run_benchmark` over the dtypes, the numbers of streams and
+    the batch sizes of a model.
+
+    .. highlight:: python
+    .. code-block:: python
+
+        import intel_extension_for_pytorch as ipex
+
+        def model_fn(dtype):
+            model = ipex.optimize(models.resnet50().eval(), dtype=dtype)
+            with torch.no_grad(), torch.cpu.amp.autocast(enabled=dtype is torch.bfloat16):
+                model = torch.jit.freeze(torch.jit.trace(model, torch.rand(1, 3, 224, 224)))
+            return model
+
+        def input_fn(batch_size, dtype):
+            return torch.rand(batch_size, 3, 224, 224)
+
+        results = ipex.benchmark.sweep('resnet50', model_fn, input_fn,
+                                       dtypes=[torch.float32, torch.bfloat16],
+                                       num_streams=[1, 4, 14], batch_sizes=[1, 16],
+                                       output='resnet50.json')
+
+    Args:
+        name (str): The name of the model in the results.
+        model_fn (callable): Returns the model to measure of a dtype, which is
+            created once per dtype.
+        input_fn (callable): Returns the inputs of one stream of a batch size
+            and a dtype.
+        dtypes (list): The dtypes. The default value is ``[torch.float32]``.
+        num_streams (list): The numbers of streams. The default value is
+            ``[1]``.
+        batch_sizes (list): The batch sizes of each stream. The default value
+            is ``[1]``.
+        cpu_pool (intel_extension_for_pytorch.cpu.runtime.CPUPool): The cores
+            of all the streams. The default value is None, which means the
+            cores of numa node 0.
+        output (str): The path of the JSON file of the results. The default
+            value is None, which doesn't save them.
+        kwargs: The other arguments of :func:`run_benchmark`.
+
+    Returns:
+        dict: ``environment`` of :func:`get_environment`, and ``results``, of
+        which each is the result of :func:`run_benchmark` along with its
+        ``model``, ``dtype``, ``batch_size`` and ``samples_per_second``.
+    """
+
+    if cpu_pool is None:
+        cpu_pool = CPUPool(node_id=0)
+    results = []
+    for dtype in dtypes:
+        model = model_fn(dtype)
+        for batch_size in batch_sizes:
+            inputs = input_fn(batch_size, dtype)
+            for streams in num_streams:
+                result = {'model': name, 'dtype': str(dtype).replace('torch.', ''), 'batch_size': batch_size}
+                result.update(run_benchmark(model, inputs, num_streams=streams, cpu_pool=cpu_pool, **kwargs))
+                result['samples_per_second'] = result['throughput'] * batch_size
+                results.append(result)
+    report = {'environment': get_environment(), 'results': results}
+    if output is not None:
+        save_results(report, output)
+    return report
+
+def save_results(report, path):
+    r"""
+    Save the results of :func:`sweep` to a JSON file.
+
+    Args:
+        report (dict): The results of :func:`sweep`.
+        path (str): The path of the JSON file.
+    """
+
+    with open(path, 'w') as f:
+        json.dump(report, f, indent=2)
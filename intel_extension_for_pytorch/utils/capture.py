@@ -0,0 +1,122 @@
+import warnings
+
+import torch
+
+def _signature(inputs):
+    # The guard of a plan: the sizes, the strides and the dtype of the tensor
+    # inputs, and the values of the other ones, which the trace bakes in.
+    signature = []
+    for x in inputs:
+        if isinstance(x, torch.Tensor):
+            signature.append((tuple(x.size()), x.stride(), x.dtype, x.device.type, x.requires_grad))
+        elif isinstance(x, (bool, int, float, str, type(None))):
+            signature.append((type(x), x))
+        else:
+            return None
+    return tuple(signature)
+
+class CapturedModule(torch.nn.Module):
+    r"""
+    The inference model wrapped by :func:`capture`, which replays the captured
+    plan of an input signature and runs the eager model otherwise.
+    """
+    def __init__(self, model, warmup, max_plans):
+        super(CapturedModule, self).__init__()
+        self.model = model
+        self.warmup = warmup
+        self.max_plans = max_plans
+        # signature -> the frozen TorchScript module, or None if it can't
+        # be captured and runs eagerly
+        self._plans = {}
+        self._calls = {}
+        self._replays = 0
+        self._fallbacks = 0
+
+    def _capture(self, signature, inputs):
+        try:
+            with torch.no_grad():
+                traced = torch.jit.trace(self.model, inputs, check_trace=False, strict=False)
+                plan = torch.jit.freeze(traced)
+                # the first runs of the frozen graph run the IPEX fusion pass
+                # and create the primitives of the op contexts
+                plan(*inputs)
+                plan(*inputs)
+        except Exception as e:
+            warnings.warn("capture: the model of the input signature {} runs eagerly, "
+                          "since it can't be traced: {}".format(signature, e))
+            plan = None
+        self._plans[signature] = plan
+
+    def forward(self, *inputs):
+        signature = _signature(inputs)
+        if signature is not None and signature in self._plans:
+            plan = self._plans[signature]
+            if plan is not None:
+                self._replays += 1
+                return plan(*inputs)
+        elif signature is not None and len(self._plans) < self.max_plans:
+            calls = self._calls.get(signature, 0) + 1
+            self._calls[signature] = calls
+            if calls > self.warmup:
+                del self._calls[signature]
+                self._capture(signature, inputs)
+                if self._plans[signature] is not None:
+                    self._replays += 1
+                    return self._plans[signature](*inputs)
+        self._fallbacks += 1
+        return self.model(*inputs)
+
+    def stats(self):
+        r"""
+        Returns a dict of ``replays``, the calls of the captured plans,
+        ``fallbacks``, the calls of the eager model, including the warmup
+        ones, and ``plans``, the input signatures captured.
+        """
+        return {
+            'replays': self._replays,
+            'fallbacks': self._fallbacks,
+            'plans': sum(1 for plan in self._plans.values() if plan is not None),
+        }
+
+def capture(model, warmup=1, max_plans=4):
+    r"""
+    Wraps an eager inference model, e.g. of
+    :func:`~intel_extension_for_pytorch.optimize`, so that the calls of an
+    input signature after ``warmup`` eager ones replay a captured plan of the
+    model instead of running its Python forward. The plan is the frozen
+    TorchScript of the model traced with that input, of which the sequence of
+    the IPEX kernels with their prepacked op contexts runs in the C++
+    interpreter without the Python and the per-module dispatch overhead of
+    ``_IPEXConv2d`` and ``_IPEXLinear``, which dominate the small-batch
+    inference.
+
+    A plan is guarded by the signature of its inputs: the sizes, the strides
+    and the dtypes of the tensors, and the values of the other positional
+    inputs. A call of another signature runs the eager model, and is captured
+    in turn until there are ``max_plans`` plans. The model is expected to run
+    the same operators for the same signature, since the trace doesn't keep
+    the data-dependent control flow. A signature the model can't be traced of
+    is warned and keeps running eagerly.
+
+    .. highlight:: python
+    .. code-block:: python
+
+        model = ipex.capture(ipex.optimize(model.eval()))
+        with torch.no_grad():
+            y = model(x)  # eager warmup
+            y = model(x)  # captured and replayed from here on
+
+    Args:
+        model (torch.nn.Module): The inference model.
+        warmup (int): The eager calls of a signature before it is captured.
+            Default value is ``1``.
+        max_plans (int): The most signatures captured. Default value is
+            ``4``.
+
+    Returns:
+        CapturedModule: The model wrapped, of which ``stats()`` returns the
+        counts of the replays and the eager calls.
+    """
+
+    assert not model.training, "Only the inference model is captured"
+    return CapturedModule(model, warmup, max_plans)
@@ -0,0 +1,63 @@
+import torch
+
+import intel_extension_for_pytorch._C as core
+
+def enable_huge_pages(enabled):
+    r"""
+    Enables or disables the placement of the large buffers of IPEX on the
+    transparent huge pages of 2 MB, i.e. the weights packed afterwards, the
+    buffers of oneDNN, e.g. of the prepacked weights of the TorchScript op
+    contexts, the arenas of the static memory planning and of the runtime
+    extension, and the embedding tables moved by
+    ``ipex.optimize(huge_pages=True)``. The buffers of 2 MB at least are
+    aligned to the huge pages and advised of ``MADV_HUGEPAGE``, so that the
+    random accesses of the embedding lookups and the weight streams of the
+    GEMMs don't thrash the TLB on the 4 KB pages. It is also enabled by
+    ``IPEX_HUGE_PAGES=1``, e.g. of
+    ``ipex.cpu.launch --enable_huge_pages``. The buffers stay on the 4 KB pages
+    if the transparent huge pages are disabled by the system, see
+    :func:`is_huge_pages_available`.
+
+    Args:
+        enabled (bool): Whether to place the large buffers on the huge pages
+            or not. Default value is ``False``.
+
+    Examples:
+
+        >>> import intel_extension_for_pytorch as ipex
+        >>> ipex.enable_huge_pages(True)
+        >>> model = ipex.optimize(model.eval())
+    """
+
+    core._set_huge_pages_enabled(enabled)
+
+def is_huge_pages_enabled():
+    r"""
+    Returns whether the large buffers of IPEX are placed on the huge pages,
+    see :func:`enable_huge_pages`.
+    """
+
+    return core._is_huge_pages_enabled()
+
+def is_huge_pages_available():
+    r"""
+    Returns whether the transparent huge pages of the system can be advised,
+    i.e. ``/sys/kernel/mm/transparent_hugepage/enabled`` is ``always`` or
+    ``madvise``.
+    """
+
+    return core._is_huge_pages_available()
+
+def _embedding_tables_to_huge_pages(model):
+    # moves the tables of the embeddings to the huge pages, the parameters keep their identity for the optimizer
+    from ..nn.modules.merged_embeddingbag import MergedEmbeddingBag
+    moved = 0
+    for m in model.modules():
+        if not isinstance(m, (torch.nn.Embedding, torch.nn.EmbeddingBag, MergedEmbeddingBag)):
+            continue
+        for param in m.parameters(recurse=False):
+            placed = core._to_huge_pages(param.data)
+            if placed.data_ptr() != param.data_ptr():
+                param.data = placed
+                moved += 1
+    return moved
@@ -0,0 +1,53 @@
+import intel_extension_for_pytorch._C as core
+
+def memory_stats():
+    r"""
+    Returns the memory held by the caches of IPEX, which may grow with the
+    shapes and the threads of a long-running process: ``packed_weights``,
+    the weights packed into the oneDNN blocked format, ``autocast_casts``,
+    the low precision casts of the weights by autocast,
+    ``ideep_primitive_descs``, the primitive descs cached by ideep on each
+    thread, of which the bytes are of the cache entries only,
+    ``scratchpad_arenas``, the scratchpads of the op contexts of each thread,
+    ``llga_compiled_partitions``, the partitions compiled by oneDNN graph for
+    each input signature, of which only the entries are counted since their
+    memory is not queryable, and ``lstm_workspaces``, the workspaces of the
+    LSTM training kept for the next iterations.
+
+    Returns:
+        dict: ``bytes`` of all the caches, ``peak_bytes``, the high-water mark
+        of ``bytes``, ``budget_bytes`` of :func:`set_memory_budget`, -1 if
+        unlimited, and ``caches``, of which each has its ``bytes``,
+        ``entries``, ``peak_bytes``, ``evicted_bytes``, the bytes evicted by
+        the memory budget, and ``evictable``.
+    """
+
+    return core._get_memory_stats()
+
+def reset_peak_memory_stats():
+    r"""
+    Reset the ``peak_bytes`` of :func:`memory_stats` to the current bytes.
+    """
+
+    core._reset_peak_memory_stats()
+
+def set_memory_budget(budget_bytes):
+    r"""
+    Set the memory budget of all the caches of :func:`memory_stats`. Once
+    the caches exceed it, they are evicted in the order of the cost to fill
+    them again, i.e. ``lstm_workspaces``, ``autocast_casts``,
+    ``ideep_primitive_descs``, ``llga_compiled_partitions``, which keep the
+    partition of the most recent signature of each fusion group, and
+    ``packed_weights``, until the caches are within the budget. The
+    ``scratchpad_arenas`` are in use by their threads, and are only
+    accounted.
+
+    Args:
+        budget_bytes (int): The memory budget in bytes, None or -1 means
+            unlimited, which is the default.
+    """
+
+    if budget_bytes is None:
+        budget_bytes = -1
+    assert budget_bytes >= -1
+    core._set_memory_budget(budget_bytes)
@@ -0,0 +1,111 @@
+import warnings
+import intel_extension_for_pytorch._C as core
+
+# the bytes read from the memory by each LLC miss
+_CACHE_LINE_BYTES = 64
+
+def _perf_metrics(counters, duration_ns):
+    # the metrics of the counters telling the compute bound calls, of the high
+    # IPC, from the memory bound ones, of the high bandwidth of the LLC misses
+    metrics = {}
+    cycles = counters.get('cycles', 0)
+    if cycles > 0 and 'instructions' in counters:
+        metrics['ipc'] = counters['instructions'] / cycles
+    if duration_ns > 0 and 'llc_misses' in counters:
+        metrics['llc_miss_gbps'] = counters['llc_misses'] * _CACHE_LINE_BYTES / duration_ns
+    licenses = [counters.get('license%d_cycles' % i, -1) for i in range(3)]
+    if min(licenses) >= 0 and sum(licenses) > 0:
+        metrics['license_ratios'] = [cycles / sum(licenses) for cycles in licenses]
+    return metrics
+
+class op_trace(object):
+    """
+    On-demand runtime tracing of the IPEX ops
+
+    While tracing, the IPEX ops sample ``sample_rate`` of their calls on each
+    thread, and record the op, the shapes and dtype of its inputs, the kernel
+    path it chose, e.g. ``onednn`` or ``woq_int8`` of a prepacked linear, and
+    its duration, along with the histograms of the durations of each op. The
+    ops pay a relaxed atomic load if not tracing, so that it suits sampling a
+    small part of the production traffic without a build of
+    ``IPEX_PROFILE_OP``. The records and the histograms are kept after the
+    scope until the next trace starts.
+
+    With ``perf_counters``, the sampled calls also read the hardware counters
+    of perf_event: ``cycles``, ``instructions``, ``llc_misses`` and, on the
+    Xeons from Skylake-SP to Ice Lake-SP, the cycles at the frequency
+    licenses 0, 1 and 2 of the AVX-512 instructions. They are counted on all
+    the threads of the process, which include the OpenMP workers of the op,
+    but also the ops of the other threads running at the same time, so trace
+    one stream at a time for the attribution. The perf_event of the user
+    space needs ``/proc/sys/kernel/perf_event_paranoid`` of 2 or below, and a
+    container allowing ``perf_event_open``; otherwise the trace warns and runs
+    without the counters. The threads created after the trace starts are
+    counted once they run a sampled op.
+
+    .. highlight:: python
+    .. code-block:: python
+
+        import intel_extension_for_pytorch as ipex
+        with ipex.op_trace(sample_rate=0.01) as trace:
+            for data in requests:
+                model(data)
+        print(trace.stats())
+
+    Args:
+        sample_rate (float): The part of the calls sampled, in (0, 1].
+            Default value is ``1.0``.
+        buffer_size (int): The last records each thread keeps. Default value
+            is ``4096``.
+        perf_counters (bool): Read the hardware counters around the sampled
+            calls. Default value is ``False``.
+
+    :meta public:
+    """
+    def __init__(self, sample_rate=1.0, buffer_size=4096, perf_counters=False):
+        assert 0 < sample_rate <= 1, "The sample rate must be in (0, 1]"
+        assert buffer_size > 0, "The buffer size must be positive"
+        self.sample_rate = sample_rate
+        self.buffer_size = buffer_size
+        self.perf_counters = perf_counters
+
+    def __enter__(self):
+        if not core._enable_op_trace(self.sample_rate, self.buffer_size, self.perf_counters):
+            warnings.warn("The hardware counters are not available to perf_event, "
+                          "the op trace runs without them")
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        core._disable_op_trace()
+        return False
+
+    def records(self):
+        r"""
+        Returns:
+            list: The sampled calls, of which each is a dict of ``op``,
+            ``shapes``, ``dtype``, ``kernel``, ``duration_ns`` and
+            ``counters``, the increments of the hardware counters over the
+            call, empty if not counted. The ``shapes``, ``dtype`` and
+            ``kernel`` are empty if the op doesn't record them.
+        """
+
+        return core._get_op_trace_records()
+
+    def stats(self):
+        r"""
+        Returns:
+            dict: The stats of each op of all the sampled calls: ``count``,
+            ``total_ns``, ``min_ns``, ``max_ns``, ``histogram``, of which
+            bucket 0 counts the calls below 1 us, and bucket i the calls of
+            [2^(i - 1), 2^i) us, ``counters``, the sums of the hardware
+            counters, and ``metrics`` of them: ``ipc``, the instructions per
+            cycle, ``llc_miss_gbps``, the bandwidth of the cache lines read
+            by the LLC misses, which excludes the prefetches and the
+            writebacks, and ``license_ratios``, the ratios of the cycles at
+            the frequency licenses 0, 1 and 2.
+        """
+
+        stats = core._get_op_trace_stats()
+        for op_stats in stats.values():
+            op_stats['metrics'] = _perf_metrics(op_stats['counters'], op_stats['total_ns'])
+        return stats
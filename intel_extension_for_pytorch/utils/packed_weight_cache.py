@@ -0,0 +1,43 @@
+import intel_extension_for_pytorch._C as core
+
+def set_packed_weight_cache_capacity(capacity_bytes):
+    r"""
+    Set the memory budget of the cache of the packed weights, e.g. of the
+    LSTM weights packed into the oneDNN blocked format. Once the cached bytes
+    exceed the budget, the least recently used packed weights are evicted and
+    packed again on their next use.
+
+    Args:
+        capacity_bytes (int): The memory budget in bytes, -1 means unlimited,
+            which is the default.
+    """
+
+    assert capacity_bytes >= -1
+    core._set_packed_weight_cache_capacity(capacity_bytes)
+
+def get_packed_weight_cache_stats():
+    r"""
+    Returns:
+        dict: The stats of the cache of the packed weights: ``entries``,
+        ``cached_bytes``, ``capacity_bytes``, ``hits``, ``misses``,
+        ``evictions`` and ``invalidations``.
+    """
+
+    return core._get_packed_weight_cache_stats()
+
+def release_packed_weights(model=None):
+    r"""
+    Release the cached packed weights of ``model``, e.g. before swapping it
+    out of a long-running server, or all the cached packed weights if
+    ``model`` is None.
+
+    Args:
+        model (torch.nn.Module): The model whose packed weights are released.
+            The default value is None.
+    """
+
+    if model is None:
+        core._clear_packed_weight_cache()
+        return
+    for parameter in model.parameters():
+        core._invalidate_packed_weight(parameter)
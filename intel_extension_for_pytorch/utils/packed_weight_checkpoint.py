@@ -0,0 +1,65 @@
+import contextlib
+import os
+import tempfile
+
+import torch
+
+from ..nn.utils import _weight_prepack
+
+@contextlib.contextmanager
+def _unpack_weights_into_mapped_files(tmp_dir):
+    def allocate(numel, dtype):
+        fd, path = tempfile.mkstemp(dir=tmp_dir)
+        os.close(fd)
+        try:
+            return torch.from_file(path, shared=True, size=numel, dtype=dtype)
+        finally:
+            # The mapping stays valid after the file is removed.
+            os.unlink(path)
+
+    previous_allocator = _weight_prepack._unpacked_weight_allocator
+    _weight_prepack._unpacked_weight_allocator = allocate
+    try:
+        yield
+    finally:
+        _weight_prepack._unpacked_weight_allocator = previous_allocator
+
+def save_unpacked_state_dict(model, f, tmp_dir=None):
+    r"""
+    Saves the state dict of ``model`` optimized by
+    :func:`intel_extension_for_pytorch.optimize` into ``f``, the same as
+    ``torch.save(model.state_dict(), f)``, so that it can be loaded by
+    ``torch.load`` into the original model.
+
+    ``model.state_dict()`` unpacks every prepacked weight of the convolution,
+    linear and deconvolution layers into a new plain tensor, so that the
+    checkpoint of a large model holds a second full-size copy of the weights
+    in memory while saving. This function unpacks the weights one layer at a
+    time straight into temporary files mapped into memory instead, the
+    split bfloat16 master weights included, and ``torch.save`` then streams
+    them into ``f`` one by one. The mapped pages are backed by the files and
+    can be written back and evicted by the operating system, rather than
+    held in the process memory.
+
+    Args:
+        model (torch.nn.Module): The model returned by
+            :func:`intel_extension_for_pytorch.optimize`.
+        f: A file-like object or a string containing a file name, as ``f``
+            of ``torch.save``.
+        tmp_dir (str): The directory of the temporary files, which should be
+            on a disk rather than a memory backed file system. The default
+            value is ``None``, meaning the default directory of
+            ``tempfile``.
+
+    Examples:
+
+        >>> model, optimizer = ipex.optimize(model, dtype=torch.bfloat16, optimizer=optimizer)
+        >>> # training steps
+        >>> ipex.save_unpacked_state_dict(model, "checkpoint.pt", tmp_dir="/data/tmp")
+        >>> # The prepacked weights are updated in place
+        >>> model.load_state_dict(torch.load("checkpoint.pt"))
+    """
+
+    with _unpack_weights_into_mapped_files(tmp_dir):
+        state_dict = model.state_dict()
+    torch.save(state_dict, f)
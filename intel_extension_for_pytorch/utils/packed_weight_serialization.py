@@ -0,0 +1,42 @@
+import intel_extension_for_pytorch._C as core
+
+def enable_packed_weight_serialization(enabled):
+    r"""
+    Enables or disables saving the packed weights of the convolution, linear,
+    deconvolution and LSTM ops of a model optimized by TorchScript. If enabled,
+    ``torch.jit.save`` stores the weights in the oneDNN blocked format
+    together with their oneDNN memory descriptors instead of the plain
+    weights, so that ``torch.jit.load`` uses the stored bytes in place
+    instead of reordering every weight again. If oneDNN prefers another
+    blocked format on the loading CPU, e.g. one with another ISA, the stored
+    weights are reordered into it on load. The int8 weights of the dynamic
+    quantized linear are saved packed along with their scales, so that the
+    loaded model does no FP32 to int8 weight quantization.
+
+    A model saved with this option can only be loaded by the Intel Extension
+    for PyTorch built with the same oneDNN version. The option only affects
+    saving, models saved either way can always be loaded. Default value is
+    ``False``.
+
+    Args:
+        enabled (bool): Whether to save the packed weights or not.
+
+    Examples:
+
+        >>> import intel_extension_for_pytorch as ipex
+        >>> ipex.enable_packed_weight_serialization(True)
+        >>> traced_model = torch.jit.freeze(torch.jit.trace(model, x))
+        >>> traced_model(x)
+        >>> torch.jit.save(traced_model, "model.pt")
+    """
+
+    core._set_packed_weight_serialization_enabled(enabled)
+
+def is_packed_weight_serialization_enabled():
+    r"""
+    Returns:
+        bool: Whether the packed weights are saved or not, see
+        :func:`enable_packed_weight_serialization`.
+    """
+
+    return core._is_packed_weight_serialization_enabled()
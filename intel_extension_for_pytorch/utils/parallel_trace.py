@@ -0,0 +1,61 @@
+import intel_extension_for_pytorch._C as core
+
+class parallel_trace(object):
+    """
+    Profiling of the imbalance of the threads of the parallel regions of the
+    IPEX kernels
+
+    While profiling, each parallel region of the instrumented kernels, e.g.
+    the pooling of ``merged_embeddingbag_forward``, ``roi_align_forward``
+    and ``batch_score_nms``, sums the busy time of the chunks of the work of
+    each thread, of which the statically partitioned regions with uneven
+    chunks, e.g. the bags of the different pooling factors or the classes of
+    the different numbers of boxes, have threads waiting for the slowest one
+    at the barrier. A region pays a relaxed atomic load if not profiling.
+
+    .. highlight:: python
+    .. code-block:: python
+
+        import intel_extension_for_pytorch as ipex
+        with ipex.parallel_trace() as trace:
+            model(data)
+        for region, stats in trace.stats().items():
+            print(region, stats['imbalance'], stats['imbalance_ns'])
+
+    :meta public:
+    """
+    def __enter__(self):
+        core._enable_parallel_trace()
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        core._disable_parallel_trace()
+        return False
+
+    def stats(self):
+        r"""
+        Returns:
+            dict: The stats of each parallel region, the most ``imbalance_ns``
+            first: ``count``, ``num_threads``, ``active_threads``, the mean
+            number of the threads which got work, ``wall_ns``, ``busy_ns``,
+            the busy time of all the threads, ``imbalance``, the busy time of
+            the slowest thread over the mean busy time of the active threads,
+            weighted by the time of the calls, 1 of a balanced region,
+            ``max_imbalance`` of a call, and ``imbalance_ns``, the time of
+            the slowest threads beyond the mean ones, which a balanced
+            schedule of the region would save at most.
+        """
+
+        stats = {}
+        for region, s in core._get_parallel_trace_stats().items():
+            stats[region] = {
+                'count': s['count'],
+                'num_threads': s['num_threads'],
+                'active_threads': s['total_active_threads'] / s['count'],
+                'wall_ns': s['total_wall_ns'],
+                'busy_ns': s['total_busy_ns'],
+                'imbalance': s['total_max_busy_ns'] / max(s['total_mean_busy_ns'], 1),
+                'max_imbalance': s['max_imbalance'],
+                'imbalance_ns': s['total_max_busy_ns'] - s['total_mean_busy_ns'],
+            }
+        return dict(sorted(stats.items(), key=lambda item: item[1]['imbalance_ns'], reverse=True))
@@ -0,0 +1,266 @@
+import argparse
+import json
+import sys
+
+# The version of the schema of the results and the baselines, which is bumped
+# on any change of the fields of a result
+SCHEMA_VERSION = 1
+
+_TIME_UNITS_US = {'ns': 1e-3, 'us': 1., 'ms': 1e3, 's': 1e6}
+
+def _result(op, shape, dtype, isa, latency_us, gbps=None, throughput=None, cv=0., source='cpp_bench'):
+    return {
+        'source': source,
+        'op': op,
+        'shape': shape,
+        'dtype': dtype,
+        'isa': isa,
+        'latency_us': latency_us,
+        'gbps': gbps,
+        'throughput': throughput,
+        # the coefficient of variation of the latency of the repetitions
+        'cv': cv,
+    }
+
+def _parse_benchmark_name(name):
+    # e.g. BM_embedding_bag/fp32/batch:1024/dim:64/pooling:1/real_time of
+    # IPEX_BENCHMARK_DTYPES of tests/cpu/cpp_bench
+    parts = [p for p in name.split('/') if p != 'real_time']
+    op = parts[0][3:] if parts[0].startswith('BM_') else parts[0]
+    dtype = parts[1] if len(parts) > 1 else ''
+    shape = ','.join(parts[2:])
+    return op, shape, dtype
+
+def _from_cpp_bench(report):
+    context = report.get('context', {})
+    isa = context.get('ipex_isa', '')
+    # of the repetitions, the median and the stddev of them, otherwise the
+    # iterations themselves
+    medians = {}
+    stddevs = {}
+    iterations = {}
+    for bench in report.get('benchmarks', []):
+        if bench.get('error_occurred'):
+            continue
+        run_name = bench.get('run_name', bench['name'])
+        if bench.get('run_type') == 'aggregate':
+            if bench.get('aggregate_name') == 'median':
+                medians[run_name] = bench
+            elif bench.get('aggregate_name') == 'stddev':
+                stddevs[run_name] = bench
+        else:
+            iterations.setdefault(run_name, bench)
+    results = []
+    for run_name, bench in iterations.items():
+        bench = medians.get(run_name, bench)
+        op, shape, dtype = _parse_benchmark_name(run_name)
+        latency_us = bench['real_time'] * _TIME_UNITS_US[bench.get('time_unit', 'ns')]
+        cv = 0.
+        if run_name in stddevs and bench['real_time'] > 0:
+            cv = stddevs[run_name]['real_time'] / bench['real_time']
+        results.append(_result(op, shape, dtype, isa, latency_us, gbps=bench.get('GB/s'), cv=cv))
+    return {
+        'fingerprint': context.get('cpu_fingerprint', ''),
+        'environment': {
+            'isa_level': isa,
+            'micro_arch': context.get('cpu_micro_arch', ''),
+            'host_name': context.get('host_name', ''),
+            'date': context.get('date', ''),
+        },
+        'results': results,
+    }
+
+def _from_sweep(report):
+    environment = report.get('environment', {})
+    isa = environment.get('isa_level', '')
+    results = []
+    for r in report.get('results', []):
+        shape = 'batch_size:{},num_streams:{}'.format(r['batch_size'], r['num_streams'])
+        latency_us = r['latency_ms'].get('p50', 0.) * 1e3
+        results.append(_result(r['model'], shape, r['dtype'], isa, latency_us,
+                               throughput=r['samples_per_second'], source='model'))
+    return {
+        'fingerprint': environment.get('cpu_fingerprint', ''),
+        'environment': environment,
+        'results': results,
+    }
+
+def load_results(report):
+    r"""
+    Convert the results of the benchmarks to the schema of the regression
+    tracking, of which each result has ``source``, ``cpp_bench`` or
+    ``model``, ``op``, i.e. the op or the model, ``shape``, ``dtype``,
+    ``isa``, ``latency_us``, ``gbps``, ``throughput`` in samples per second,
+    and ``cv``, the coefficient of variation of the latency.
+
+    Args:
+        report (str or dict): The JSON report, or its path, of
+            ``ipex_cpp_bench --benchmark_out_format=json`` of
+            tests/cpu/cpp_bench, of :func:`~intel_extension_for_pytorch.benchmark.sweep`,
+            or of this function.
+
+    Returns:
+        dict: ``schema_version``, ``fingerprint``, the hash of the ISA
+        features of the CPU of the results, ``environment`` and ``results``.
+    """
+
+    if isinstance(report, str):
+        with open(report) as f:
+            report = json.load(f)
+    if 'schema_version' in report:
+        assert report['schema_version'] == SCHEMA_VERSION, \
+            "The results are of the schema version {}".format(report['schema_version'])
+        return report
+    if 'benchmarks' in report:
+        results = _from_cpp_bench(report)
+    else:
+        results = _from_sweep(report)
+    results['schema_version'] = SCHEMA_VERSION
+    return results
+
+def _key(result):
+    return (result['source'], result['op'], result['shape'], result['dtype'], result['isa'])
+
+def update_baseline(results, path):
+    r"""
+    Save the results as the baseline of their CPU fingerprint to a baseline
+    file, which keeps the baselines of the other fingerprints in it.
+
+    Args:
+        results (str or dict): The results of :func:`load_results`, or the
+            report of the benchmarks.
+        path (str): The path of the JSON file of the baselines.
+    """
+
+    results = load_results(results)
+    assert results['fingerprint'], "The results have no CPU fingerprint to key the baseline"
+    try:
+        with open(path) as f:
+            baselines = json.load(f)
+    except FileNotFoundError:
+        baselines = {'schema_version': SCHEMA_VERSION, 'baselines': {}}
+    baseline = baselines['baselines'].setdefault(
+        results['fingerprint'], {'environment': results['environment'], 'results': []})
+    # the results of the other ops, e.g. of another suite, are kept
+    merged = {_key(r): r for r in baseline['results']}
+    merged.update({_key(r): r for r in results['results']})
+    baseline['environment'] = results['environment']
+    baseline['results'] = list(merged.values())
+    with open(path, 'w') as f:
+        json.dump(baselines, f, indent=2)
+
+def compare(results, baseline, threshold=0.05):
+    r"""
+    Compare the results of the benchmarks against the baseline of the same
+    CPU fingerprint, so that the results of the different SKUs or ISAs are
+    never compared.
+
+    A result regresses if its latency is longer than its baseline by more
+    than the noise threshold, which is ``threshold`` or three times the
+    coefficient of variation of the repetitions of either of them, whichever
+    is larger.
+
+    .. highlight:: python
+    .. code-block:: python
+
+        report = compare('report.json', 'baseline.json', threshold=0.05)
+        for r in report['regressions']:
+            print(r['op'], r['shape'], r['dtype'], r['change'])
+
+    Args:
+        results (str or dict): The results of :func:`load_results`, or the
+            report of the benchmarks.
+        baseline (str or dict): The path or the content of the baseline file
+            of :func:`update_baseline`.
+        threshold (float): The relative change of the latency within the
+            noise. The default value is 0.05.
+
+    Returns:
+        dict: ``fingerprint``, ``has_baseline``, False if the baseline has no
+        results of the fingerprint, ``regressions`` and ``improvements``, of
+        which each has the fields of the result along with its
+        ``baseline_latency_us``, ``change``, the relative change of the
+        latency, and ``threshold``, ``unchanged``, the number of the results
+        within the noise, ``missing``, the baselines without a result, and
+        ``new``, the results without a baseline.
+    """
+
+    results = load_results(results)
+    if isinstance(baseline, str):
+        with open(baseline) as f:
+            baseline = json.load(f)
+    base = baseline.get('baselines', {}).get(results['fingerprint'])
+    report = {
+        'fingerprint': results['fingerprint'],
+        'has_baseline': base is not None,
+        'regressions': [],
+        'improvements': [],
+        'unchanged': 0,
+        'missing': [],
+        'new': [],
+    }
+    if base is None:
+        report['new'] = results['results']
+        return report
+    base_results = {_key(r): r for r in base['results']}
+    for r in results['results']:
+        b = base_results.pop(_key(r), None)
+        if b is None or b['latency_us'] <= 0:
+            report['new'].append(r)
+            continue
+        change = r['latency_us'] / b['latency_us'] - 1
+        noise = max(threshold, 3 * max(r.get('cv', 0.), b.get('cv', 0.)))
+        entry = dict(r, baseline_latency_us=b['latency_us'], change=change, threshold=noise)
+        if change > noise:
+            report['regressions'].append(entry)
+        elif change < -noise:
+            report['improvements'].append(entry)
+        else:
+            report['unchanged'] += 1
+    report['missing'] = list(base_results.values())
+    report['regressions'].sort(key=lambda e: e['change'], reverse=True)
+    report['improvements'].sort(key=lambda e: e['change'])
+    return report
+
+def _format_entry(e):
+    return '  {} {} {} [{}]: {:.2f} us -> {:.2f} us ({:+.1%}, threshold {:.1%})'.format(
+        e['op'], e['shape'], e['dtype'], e['isa'], e['baseline_latency_us'], e['latency_us'],
+        e['change'], e['threshold'])
+
+def _main(argv=None):
+    parser = argparse.ArgumentParser(
+        description="Track the regressions of the IPEX kernels and models against a baseline "
+                    "keyed by the CPU fingerprint")
+    subparsers = parser.add_subparsers(dest='command')
+    compare_parser = subparsers.add_parser('compare', help="Compare the results against the baseline")
+    compare_parser.add_argument('results', help="The JSON report of the benchmarks")
+    compare_parser.add_argument('--baseline', required=True, help="The JSON file of the baselines")
+    compare_parser.add_argument('--threshold', type=float, default=0.05,
+                                help="The relative change of the latency within the noise")
+    update_parser = subparsers.add_parser('update', help="Save the results as the baseline")
+    update_parser.add_argument('results', help="The JSON report of the benchmarks")
+    update_parser.add_argument('--baseline', required=True, help="The JSON file of the baselines")
+    args = parser.parse_args(argv)
+
+    if args.command == 'update':
+        update_baseline(args.results, args.baseline)
+        return 0
+    if args.command != 'compare':
+        parser.print_help()
+        return 2
+    report = compare(args.results, args.baseline, args.threshold)
+    if not report['has_baseline']:
+        print('No baseline of the CPU fingerprint {}'.format(report['fingerprint']))
+        return 0
+    print('{} regressions, {} improvements, {} unchanged, {} missing, {} new'.format(
+        len(report['regressions']), len(report['improvements']), report['unchanged'],
+        len(report['missing']), len(report['new'])))
+    for title in ('regressions', 'improvements'):
+        if report[title]:
+            print(title + ':')
+            for e in report[title]:
+                print(_format_entry(e))
+    return 1 if report['regressions'] else 0
+
+if __name__ == '__main__':
+    sys.exit(_main())
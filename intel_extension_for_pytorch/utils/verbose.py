@@ -1,3 +1,5 @@
+import fnmatch
+import sys
 import torch
 import intel_extension_for_pytorch._C as core
 
@@ -28,21 +30,42 @@ class verbose(object):
         with ipex.verbose(ipex.VERBOSE_ON):
             model(data)
 
+    With ``capture``, the verbose messages are parsed into records instead of
+    printed, e.g. to find the reorders and the reference implementations of a
+    model in CI. The other output of the process is printed as it is.
+
+    .. highlight:: python
+    .. code-block:: python
+
+        with ipex.verbose(ipex.VERBOSE_ON, capture=True) as v:
+            model(data)
+        slow = v.records(impl='ref:*') + v.records(kind='reorder', min_time_ms=0.1)
+
     Args:
         level: Verbose level
 
             - ``VERBOSE_OFF``: Disable verbosing
             - ``VERBOSE_ON``:  Enable verbosing
             - ``VERBOSE_ON_CREATION``: Enable verbosing, including oneDNN kernel creation
+        capture (bool): Capture the verbose messages of the scope as the
+            records of :meth:`records` instead of printing them. Default
+            value is ``False``.
 
     :meta public:
     """
-    def __init__(self, level):
+    def __init__(self, level, capture=False):
         self.level = level
+        self.capture = capture
+        self._records = []
 
     def __enter__(self):
         if self.level == VERBOSE_OFF:
-            return
+            return self
+        if self.capture:
+            # oneDNN prints to the stdout of the process, which is redirected
+            # to the parser after the buffered output of Python is flushed
+            sys.stdout.flush()
+            assert core._start_verbose_capture(), "Failed to capture the verbose, which is captured by another scope"
         try:
             st = torch._C._verbose.mkldnn_set_verbose(self.level)
             assert bool(st), "Failed to set Verbose mode of MKLDNN in PyTorch. Please consider to disable this verbose scope."
@@ -53,13 +76,49 @@ class verbose(object):
         return self
 
     def __exit__(self, exc_type, exc_val, exc_tb):
+        if self.level == VERBOSE_OFF:
+            return False
         core.mkldnn_set_verbose(VERBOSE_OFF)
         try:
             torch._C._verbose.mkldnn_set_verbose(VERBOSE_OFF)
         except:
             pass
+        if self.capture:
+            sys.stdout.flush()
+            self._records = core._stop_verbose_capture()
         return False
 
+    def records(self, kind=None, impl=None, stage='exec', min_time_ms=None):
+        r"""
+        Returns the captured records of the scope which match all of the
+        filters.
+
+        Args:
+            kind (str): The glob of the primitive kind, e.g. ``reorder``.
+                Default value is None, which matches all.
+            impl (str): The glob of the implementation, e.g. ``ref:*`` or
+                ``jit:avx512_core_amx*``. Default value is None, which
+                matches all.
+            stage (str): The glob of the stage, ``exec``, or ``create*`` of
+                ``VERBOSE_ON_CREATION``. Default value is ``exec``. None
+                matches all.
+            min_time_ms (float): The least time of the records. Default value
+                is None, which matches all.
+
+        Returns:
+            list: The records in the order of their execution, of which each
+            is a dict of ``stage``, ``engine``, ``kind``, ``impl``,
+            ``prop_kind``, ``memory_descs``, ``attrs``, ``aux``, ``problem``,
+            i.e. the shapes, and ``time_ms``, -1 if the message has no time.
+        """
+
+        def matches(value, pattern):
+            return pattern is None or fnmatch.fnmatchcase(value, pattern)
+
+        return [r for r in self._records
+                if matches(r['kind'], kind) and matches(r['impl'], impl) and matches(r['stage'], stage)
+                and (min_time_ms is None or r['time_ms'] >= min_time_ms)]
+
 try:
     verbose_torch = torch.backends.mkldnn.verbose
     torch.backends.mkldnn.verbose = verbose
@@ -0,0 +1,133 @@
+import fcntl
+import json
+import os
+
+import torch
+
+# Each tensor in the weight store starts at a multiple of this alignment,
+# which is also a multiple of the element size of all the dtypes.
+_ALIGNMENT = 64
+
+def _align(nbytes):
+    return (nbytes + _ALIGNMENT - 1) // _ALIGNMENT * _ALIGNMENT
+
+def _collect_tensors(model):
+    # Returns [(name, tensor, [(module, key, is_parameter)])]. A tensor shared
+    # by several modules is stored once and mapped back to all of them.
+    tensors = []
+    tensor_index = {}
+    for module_name, module in model.named_modules():
+        for is_parameter, attrs in ((True, module._parameters), (False, module._buffers)):
+            for key, tensor in attrs.items():
+                if tensor is None:
+                    continue
+                if tensor.device.type != 'cpu' or tensor.layout != torch.strided or not tensor.is_contiguous():
+                    # Keep the private copy, e.g. the mkldnn tensors.
+                    continue
+                if id(tensor) not in tensor_index:
+                    tensor_index[id(tensor)] = len(tensors)
+                    name = module_name + '.' + key if module_name else key
+                    tensors.append((name, tensor, []))
+                tensors[tensor_index[id(tensor)]][2].append((module, key, is_parameter))
+    return tensors
+
+def _build_metadata(tensors):
+    metadata = []
+    offset = 0
+    for name, tensor, _ in tensors:
+        metadata.append({
+            'name': name,
+            'dtype': str(tensor.dtype).split('.')[-1],
+            'sizes': list(tensor.size()),
+            'offset': offset})
+        offset += _align(tensor.numel() * tensor.element_size())
+    return metadata, max(offset, _ALIGNMENT)
+
+def _map_tensor(path, total_bytes, mapped_storages, entry):
+    dtype = getattr(torch, entry['dtype'])
+    if dtype not in mapped_storages:
+        element_size = torch.empty((), dtype=dtype).element_size()
+        # shared=True maps the file with MAP_SHARED, so all the processes
+        # mapping the same file share the same physical pages.
+        mapped_storages[dtype] = (torch.from_file(path, shared=True, size=total_bytes // element_size, dtype=dtype), element_size)
+    storage, element_size = mapped_storages[dtype]
+    numel = 1
+    for size in entry['sizes']:
+        numel *= size
+    begin = entry['offset'] // element_size
+    return storage[begin:begin + numel].view(entry['sizes'])
+
+def _write_store(path, tensors, metadata, total_bytes):
+    tmp_path = path + '.tmp.' + str(os.getpid())
+    with open(tmp_path, 'wb') as f:
+        f.truncate(total_bytes)
+    mapped_storages = {}
+    with torch.no_grad():
+        for (_, tensor, _), entry in zip(tensors, metadata):
+            _map_tensor(tmp_path, total_bytes, mapped_storages, entry).copy_(tensor)
+    del mapped_storages
+    os.rename(tmp_path, path)
+    # The metadata is written last, its existence means the store is complete.
+    with open(path + '.json', 'w') as f:
+        json.dump({'total_bytes': total_bytes, 'tensors': metadata}, f)
+
+def share_weights(model, path):
+    r"""
+    Share the read-only weights of ``model`` between processes through a
+    memory-mapped weight store, e.g. between the instances started by
+    ``intel_extension_for_pytorch.cpu.launch --ninstances N``.
+
+    The first process calling this function writes all parameters and buffers
+    of ``model``, including the weights prepacked by
+    :func:`intel_extension_for_pytorch.optimize`, into the file ``path``. All
+    the processes, including the first one, then replace the parameters and
+    buffers of ``model`` by tensors mapped from this file, so that the
+    processes on one machine share one physical copy of the weights. Use a
+    path on ``/dev/shm`` to keep the store in memory.
+
+    Args:
+        model (torch.nn.Module): The model for inference. It must be created
+            (and optimized) the same way in all processes, before running
+            any input.
+        path (str): The file of the weight store.
+
+    Returns:
+        torch.nn.Module: ``model`` with the shared weights.
+
+    .. warning::
+
+        The shared weights must not be modified, e.g. by training, since the
+        change is visible to all the processes.
+    """
+
+    tensors = _collect_tensors(model)
+    metadata, total_bytes = _build_metadata(tensors)
+    with open(path + '.lock', 'w') as lock_file:
+        fcntl.flock(lock_file, fcntl.LOCK_EX)
+        try:
+            if not os.path.exists(path + '.json'):
+                _write_store(path, tensors, metadata, total_bytes)
+            with open(path + '.json') as f:
+                store = json.load(f)
+        finally:
+            fcntl.flock(lock_file, fcntl.LOCK_UN)
+
+    stored_metadata = store['tensors']
+    if stored_metadata != metadata:
+        raise RuntimeError("The weight store {} doesn't match the model. "
+                           "Please make sure the model is created and optimized the same way in all processes, "
+                           "or remove the stale store".format(path))
+
+    mapped_storages = {}
+    for (_, tensor, owners), entry in zip(tensors, stored_metadata):
+        shared_tensor = _map_tensor(path, store['total_bytes'], mapped_storages, entry)
+        if isinstance(tensor, torch.nn.Parameter):
+            # Create a new Parameter instead of changing its data, so that the
+            # ideep tensors cached for the original weight are never reused.
+            shared_tensor = torch.nn.Parameter(shared_tensor, requires_grad=tensor.requires_grad)
+        for module, key, is_parameter in owners:
+            if is_parameter:
+                module._parameters[key] = shared_tensor
+            else:
+                module._buffers[key] = shared_tensor
+    return model
@@ -37,7 +37,12 @@
 #     output the extension operators name for debug purpose
 #
 #   IPEX_PROFILE_OP=1
-#     Record the extension operators for profiling
+#     Record the extension operators for the PyTorch profiler. The runtime
+#     trace of ipex.op_trace doesn't depend on it
+#
+#   BUILD_CPP_BENCH=1
+#     build the C++ microbenchmarks of tests/cpu/cpp_bench, which need Google
+#     Benchmark
 #
 # Environment variables we respect (these environment variables are
 # conventional and are often understood/set by other software.)
@@ -358,6 +363,13 @@ def get_cpp_test_dir():
 def get_cpp_test_build_dir():
     return os.path.join(get_build_type_dir(), 'tests', 'cpu', 'cpp')
 
+def get_cpp_bench_dir():
+    project_root_dir = os.path.abspath(os.path.dirname(__file__))
+    return os.path.join(project_root_dir, 'tests', 'cpu', 'cpp_bench')
+
+def get_cpp_bench_build_dir():
+    return os.path.join(get_build_type_dir(), 'tests', 'cpu', 'cpp_bench')
+
 def get_src_py_and_dst():
     ret = []
     generated_python_files = glob.glob(
@@ -512,6 +524,19 @@ class IPEXCPPLibBuild(build_clib, object):
         else:
             check_call(['make'] + build_args, cwd=cpp_test_build_dir, env=env)
 
+        # Build the CPP microbenchmarks, which need Google Benchmark
+        if _check_env_flag("BUILD_CPP_BENCH"):
+            cpp_bench_dir = get_cpp_bench_dir()
+            cpp_bench_build_dir = get_cpp_bench_build_dir()
+            if not os.path.exists(cpp_bench_build_dir):
+                Path(cpp_bench_build_dir).mkdir(parents=True, exist_ok=True)
+            bench_cmake_args = cmake_args + ['-DCPP_BENCH_BUILD_DIR=' + cpp_bench_build_dir]
+            check_call([self.cmake, cpp_bench_dir] + bench_cmake_args, cwd=cpp_bench_build_dir, env=env)
+            if use_ninja:
+                check_call(['ninja'] + build_args, cwd=cpp_bench_build_dir, env=env)
+            else:
+                check_call(['make'] + build_args, cwd=cpp_bench_build_dir, env=env)
+
 if torch_python:
     class IPEXExtBuild(BuildExtension):
         def run(self):
@@ -545,7 +570,9 @@ def pyi_module():
     if torch_python:
         main_libraries = ['intel-ext-pt-cpu']
         main_sources = [os.path.join(package_name, "csrc", "python", "init_python_bindings.cpp"),
-                        os.path.join(package_name, "csrc", "python", "TaskModule.cpp")]
+                        os.path.join(package_name, "csrc", "python", "TaskModule.cpp"),
+                        os.path.join(package_name, "csrc", "python", "MicroBatchScheduler.cpp"),
+                        os.path.join(package_name, "csrc", "python", "PipelineScheduler.cpp")]
 
         include_dirs = [
             os.path.realpath("."),
@@ -40,6 +40,22 @@ def non_fused_lamb(param, exp_avg, exp_avg_sq, grad, step, beta1, beta2, lr, wei
     true_ratio = weight_norm / rtw_norm
     param.add_(adam_step, alpha=-lr * true_ratio)
 
+def non_fused_adam(param, exp_avg, exp_avg_sq, max_exp_avg_sq, grad, step, amsgrad, adamw, beta1, beta2, lr, weight_decay, eps):
+    if adamw:
+        param.mul_(1 - lr * weight_decay)
+    elif weight_decay != 0:
+        grad = grad.add(param, alpha=weight_decay)
+    bias_correction1 = 1 - beta1 ** step
+    bias_correction2 = 1 - beta2 ** step
+    exp_avg.mul_(beta1).add_(grad, alpha=1 - beta1)
+    exp_avg_sq.mul_(beta2).addcmul_(grad, grad, value=1 - beta2)
+    if amsgrad:
+        torch.maximum(max_exp_avg_sq, exp_avg_sq, out=max_exp_avg_sq)
+        denom = (max_exp_avg_sq.sqrt() / (bias_correction2 ** 0.5)).add_(eps)
+    else:
+        denom = (exp_avg_sq.sqrt() / (bias_correction2 ** 0.5)).add_(eps)
+    param.addcdiv_(exp_avg, denom, value=-lr / bias_correction1)
+
 def non_fused_adagrad(param, grad, state_sum, step, lr, weight_decay, lr_decay, eps):
     if weight_decay != 0:
         grad = grad.add(param, alpha=weight_decay)
@@ -135,17 +151,44 @@ def adagrad_bench():
         run_bench("fused split adagrad", fused, param.bfloat16(), grad.bfloat16(), state_sum, trail, step, learning_rate, weight_decay, lr_decay, eps)
         run_bench("non fused adagrad", non_fused, param, grad, state_sum, step, learning_rate, weight_decay, lr_decay, eps)
 
+def adam_bench():
+    print("Running benchmark for AdamW update step")
+    fused = torch.ops.torch_ipex.adam_fused_step
+    non_fused = non_fused_adam
+
+    step = 10
+    beta1 = 0.9
+    beta2 = 0.999
+    learning_rate = 0.1
+    weight_decay = 0.01
+    eps = 1e-8
+
+    for param_size in [1024, 512*1024, 8*1024*1024]:
+        param = torch.randn(param_size)
+        grad = torch.randn(param_size)
+        exp_avg = torch.randn(param_size).abs()
+        exp_avg_sq = torch.randn(param_size).abs()
+        dummy = torch.Tensor()
+        trail = torch.randn(param_size).bfloat16()
+
+        print("For parameter size", param_size)
+        run_bench("fused adamw", fused, param, exp_avg, exp_avg_sq, dummy, grad, dummy, step, False, True, beta1, beta2, learning_rate, weight_decay, eps)
+        run_bench("fused split adamw", fused, param.bfloat16(), exp_avg, exp_avg_sq, dummy, grad.bfloat16(), trail, step, False, True, beta1, beta2, learning_rate, weight_decay, eps)
+        run_bench("non fused adamw", non_fused, param, exp_avg, exp_avg_sq, dummy, grad, step, False, True, beta1, beta2, learning_rate, weight_decay, eps)
+
 def run():
     import argparse
     parser = argparse.ArgumentParser(
         description="benchmark for ipex optimizer"
     )
-    parser.add_argument("--optimizer", type=str, choices=["sgd", "lamb", "adagrad"], default="sgd")
+    parser.add_argument("--optimizer", type=str, choices=["sgd", "lamb", "adagrad", "adam"], default="sgd")
     args = parser.parse_args()
     if args.optimizer == "sgd":
         sgd_bench()
     elif args.optimizer == "lamb":
         lamb_bench()
+    elif args.optimizer == "adam":
+        adam_bench()
     else:
         adagrad_bench()
 
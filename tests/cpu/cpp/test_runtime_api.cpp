@@ -114,3 +114,165 @@ TEST(TestRuntimeTaskAPI, TestCPPFunction) {
   // Assert the result
   ASSERT_VARIABLE_EQ(res, res_ref);
 }
+
+TEST(TestRuntimeTaskAPI, TestTaskExecutorGroupWorkStealing) {
+  if (!torch_ipex::runtime::is_runtime_ext_enabled()) {
+    GTEST_SKIP() << "Skip TestRuntimeTaskAPI::TestTaskExecutorGroupWorkStealing."
+                    " Didn't preload IOMP.";
+  }
+  std::shared_ptr<torch_ipex::runtime::TaskExecutorGroup> task_executor_group =
+      std::make_shared<torch_ipex::runtime::TaskExecutorGroup>();
+  std::shared_ptr<torch_ipex::runtime::TaskExecutor> task_executor =
+      std::make_shared<torch_ipex::runtime::TaskExecutor>(
+          std::vector<int32_t>({0}), task_executor_group);
+  // The idle executor steals the pending tasks of task_executor.
+  std::shared_ptr<torch_ipex::runtime::TaskExecutor> idle_task_executor =
+      std::make_shared<torch_ipex::runtime::TaskExecutor>(
+          std::vector<int32_t>({1}), task_executor_group);
+  at::Tensor input_tensor = at::rand({100, 8276});
+  // Get the reference result
+  auto res_ref = taskfunction(input_tensor);
+  // Create the task
+  torch_ipex::runtime::Task<at::Tensor (*)(const at::Tensor&), at::Tensor> task(
+      taskfunction, task_executor);
+  std::vector<std::future<at::Tensor>> res_futures;
+  for (int i = 0; i < 8; i++) {
+    at::Tensor input = input_tensor.clone();
+    res_futures.emplace_back(task(std::move(input)));
+  }
+  // Assert the result
+  for (auto& res_future : res_futures) {
+    auto res = res_future.get();
+    ASSERT_VARIABLE_EQ(res, res_ref);
+  }
+}
+
+TEST(TestRuntimeTaskAPI, TestTaskPriorityLanes) {
+  if (!torch_ipex::runtime::is_runtime_ext_enabled()) {
+    GTEST_SKIP() << "Skip TestRuntimeTaskAPI::TestTaskPriorityLanes."
+                    " Didn't preload IOMP.";
+  }
+  std::shared_ptr<torch_ipex::runtime::TaskExecutor> task_executor =
+      std::make_shared<torch_ipex::runtime::TaskExecutor>(
+          std::vector<int32_t>({0}));
+  // Block the worker, so that the following tasks are all queued.
+  std::promise<void> blocker;
+  std::shared_future<void> blocker_future = blocker.get_future().share();
+  task_executor->submit([blocker_future]() { blocker_future.wait(); });
+
+  std::mutex order_mutex;
+  std::vector<int32_t> order;
+  auto record = [&order_mutex, &order](int32_t id) {
+    std::unique_lock<std::mutex> lock(order_mutex);
+    order.emplace_back(id);
+  };
+  task_executor->submit([&record]() { record(0); });
+  task_executor->submit([&record]() { record(1); });
+  task_executor->submit(
+      [&record]() { record(2); }, torch_ipex::runtime::TaskPriority::High);
+  // The Task submits into the High lane too.
+  torch_ipex::runtime::Task<std::function<void()>> task(
+      [&record]() { record(3); }, task_executor);
+  task.set_priority(torch_ipex::runtime::TaskPriority::High);
+  auto res_future = task();
+  blocker.set_value();
+  res_future.get();
+  task_executor->stop_executor();
+  // The High lane is executed first in FIFO order.
+  ASSERT_EQ(order, std::vector<int32_t>({2, 3, 0, 1}));
+}
+
+at::Tensor move_only_taskfunction(std::unique_ptr<at::Tensor> input) {
+  return at::softmax(*input, -1);
+}
+
+TEST(TestRuntimeTaskAPI, TestRunAsyncMoveOnlyArgument) {
+  if (!torch_ipex::runtime::is_runtime_ext_enabled()) {
+    GTEST_SKIP() << "Skip TestRuntimeTaskAPI::TestRunAsyncMoveOnlyArgument."
+                    " Didn't preload IOMP.";
+  }
+  std::shared_ptr<torch_ipex::runtime::TaskExecutor> task_executor =
+      std::make_shared<torch_ipex::runtime::TaskExecutor>(
+          std::vector<int32_t>({0}));
+  at::Tensor input_tensor = at::rand({100, 8276});
+  // Get the reference result
+  auto res_ref = at::softmax(input_tensor, -1);
+  // Create the task
+  torch_ipex::runtime::Task<
+      at::Tensor (*)(std::unique_ptr<at::Tensor>),
+      std::unique_ptr<at::Tensor>>
+      task(move_only_taskfunction, task_executor);
+  std::vector<torch_ipex::runtime::TaskFuture<at::Tensor>> res_futures;
+  for (int i = 0; i < 4; i++) {
+    res_futures.emplace_back(task.run_async(
+        std::unique_ptr<at::Tensor>(new at::Tensor(input_tensor.clone()))));
+  }
+  // Assert the result
+  for (auto& res_future : res_futures) {
+    auto res = res_future.get();
+    ASSERT_VARIABLE_EQ(res, res_ref);
+    ASSERT_FALSE(res_future.valid());
+  }
+}
+
+TEST(TestRuntimeTaskAPI, TestRunAsyncException) {
+  if (!torch_ipex::runtime::is_runtime_ext_enabled()) {
+    GTEST_SKIP() << "Skip TestRuntimeTaskAPI::TestRunAsyncException."
+                    " Didn't preload IOMP.";
+  }
+  std::shared_ptr<torch_ipex::runtime::TaskExecutor> task_executor =
+      std::make_shared<torch_ipex::runtime::TaskExecutor>(
+          std::vector<int32_t>({0}));
+  torch_ipex::runtime::Task<std::function<void()>> task(
+      []() { throw std::runtime_error("task failure"); }, task_executor);
+  auto res_future = task.run_async();
+  // The exception of the task is rethrown by get.
+  ASSERT_THROW(res_future.get(), std::runtime_error);
+  // The TaskExecutor keeps running after the failed task.
+  torch_ipex::runtime::Task<std::function<int()>> next_task(
+      []() { return 1; }, task_executor);
+  ASSERT_EQ(next_task.run_async().get(), 1);
+}
+
+TEST(TestRuntimeTaskAPI, TestTaskQueueLimit) {
+  if (!torch_ipex::runtime::is_runtime_ext_enabled()) {
+    GTEST_SKIP() << "Skip TestRuntimeTaskAPI::TestTaskQueueLimit."
+                    " Didn't preload IOMP.";
+  }
+  std::shared_ptr<torch_ipex::runtime::TaskExecutor> task_executor =
+      std::make_shared<torch_ipex::runtime::TaskExecutor>(
+          std::vector<int32_t>({0}));
+  // Block the worker inside the first task, so that the following tasks are
+  // all queued.
+  std::promise<void> started;
+  std::promise<void> blocker;
+  std::shared_future<void> blocker_future = blocker.get_future().share();
+  task_executor->submit([&started, blocker_future]() {
+    started.set_value();
+    blocker_future.wait();
+  });
+  started.get_future().wait();
+
+  task_executor->set_queue_limit(
+      2, torch_ipex::runtime::QueueFullPolicy::Reject);
+  torch_ipex::runtime::Task<std::function<int()>> task(
+      []() { return 1; }, task_executor);
+  auto oldest_future = task.run_async();
+  auto queued_future = task.run_async();
+  ASSERT_THROW(task.run_async(), torch_ipex::runtime::TaskQueueFullError);
+
+  task_executor->set_queue_limit(
+      2, torch_ipex::runtime::QueueFullPolicy::DropOldest);
+  auto newest_future = task.run_async();
+  auto stats = task_executor->get_queue_stats();
+  ASSERT_EQ(stats.queued_tasks, 2);
+  ASSERT_EQ(stats.peak_queued_tasks, 2);
+  ASSERT_EQ(stats.rejected_tasks, 1);
+  ASSERT_EQ(stats.dropped_tasks, 1);
+  // The dropped task fails its future instead of hanging.
+  ASSERT_THROW(oldest_future.get(), torch_ipex::runtime::TaskDroppedError);
+
+  blocker.set_value();
+  ASSERT_EQ(queued_future.get(), 1);
+  ASSERT_EQ(newest_future.get(), 1);
+}
@@ -0,0 +1,128 @@
+#include "bench_utils.h"
+
+namespace {
+
+using ipex_bench::JitOp;
+
+// {batch, heads, seq_len}, of the head size 64 of BERT
+void mha_shapes(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"batch", "heads", "seq_len"});
+  for (int64_t batch : {1, 16}) {
+    for (int64_t seq_len : {128, 384, 512}) {
+      b->Args({batch, 16, seq_len});
+    }
+  }
+}
+
+// softmax(q * k / dim_per_head + rel_qk) * v of the k of [batch, heads,
+// head_size, seq_len], of the fused ipex::mha of the BERT pattern
+void BM_mha(benchmark::State& state, at::ScalarType dtype) {
+  torch::NoGradGuard no_grad;
+  constexpr int64_t kHeadSize = 64;
+  int64_t batch = state.range(0);
+  int64_t heads = state.range(1);
+  int64_t seq_len = state.range(2);
+  static JitOp op("ipex::mha", 8);
+  auto q = at::randn({batch, heads, seq_len, kHeadSize}).to(dtype);
+  auto k = at::randn({batch, heads, kHeadSize, seq_len}).to(dtype);
+  auto v = at::randn({batch, heads, seq_len, kHeadSize}).to(dtype);
+  auto rel_qk = at::zeros({batch, 1, 1, seq_len}).to(dtype);
+  for (auto _ : state) {
+    torch::jit::Stack stack{
+        q, k, v, rel_qk, 1.0, 8.0, int64_t(-1), c10::IValue()};
+    op.call(stack);
+    benchmark::DoNotOptimize(stack);
+  }
+  int64_t elem = ipex_bench::element_size(dtype);
+  ipex_bench::set_roofline(
+      state,
+      dtype,
+      (4.0 * batch * heads * seq_len * kHeadSize + batch * seq_len) * elem,
+      4.0 * batch * heads * seq_len * seq_len * kHeadSize);
+}
+IPEX_BENCHMARK_DTYPES(BM_mha, mha_shapes);
+
+// {rows, cols}, of the scores of the attention and of the vocabularies
+void softmax_shapes(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"rows", "cols"});
+  for (int64_t cols : {128, 512, 4096, 32768}) {
+    b->Args({16384 * 128 / cols, cols});
+  }
+}
+
+void BM_softmax(benchmark::State& state, at::ScalarType dtype) {
+  torch::NoGradGuard no_grad;
+  int64_t rows = state.range(0);
+  int64_t cols = state.range(1);
+  static JitOp op("ipex::softmax", 3);
+  auto input = at::randn({rows, cols}).to(dtype);
+  for (auto _ : state) {
+    torch::jit::Stack stack{input, int64_t(-1), c10::IValue()};
+    op.call(stack);
+    benchmark::DoNotOptimize(stack);
+  }
+  ipex_bench::set_roofline(
+      state, dtype, 2.0 * rows * cols * ipex_bench::element_size(dtype));
+}
+IPEX_BENCHMARK_DTYPES(BM_softmax, softmax_shapes);
+
+// {rows, hidden}, of the tokens of the batches of BERT and of GPT
+void layernorm_shapes(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"rows", "hidden"});
+  for (int64_t rows : {512, 8192}) {
+    for (int64_t hidden : {768, 1024, 4096}) {
+      b->Args({rows, hidden});
+    }
+  }
+}
+
+// of aten::layer_norm, of which IPEX registers the CPU kernel
+void BM_layer_norm(benchmark::State& state, at::ScalarType dtype) {
+  torch::NoGradGuard no_grad;
+  int64_t rows = state.range(0);
+  int64_t hidden = state.range(1);
+  auto input = at::randn({rows, hidden}).to(dtype);
+  auto weight = at::randn({hidden}).to(dtype);
+  auto bias = at::randn({hidden}).to(dtype);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        at::layer_norm(input, {hidden}, weight, bias, 1e-5));
+  }
+  ipex_bench::set_roofline(
+      state,
+      dtype,
+      (2.0 * rows + 2) * hidden * ipex_bench::element_size(dtype));
+}
+IPEX_BENCHMARK_DTYPES(BM_layer_norm, layernorm_shapes);
+
+// layer_norm(a + b) of the fused ipex::add_layernorm
+void BM_add_layernorm(benchmark::State& state, at::ScalarType dtype) {
+  torch::NoGradGuard no_grad;
+  int64_t rows = state.range(0);
+  int64_t hidden = state.range(1);
+  static JitOp op("ipex::add_layernorm", 8);
+  auto a = at::randn({rows, hidden}).to(dtype);
+  auto b = at::randn({rows, hidden}).to(dtype);
+  auto weight = at::randn({hidden}).to(dtype);
+  auto bias = at::randn({hidden}).to(dtype);
+  for (auto _ : state) {
+    torch::jit::Stack stack{
+        a,
+        b,
+        int64_t(1),
+        std::vector<int64_t>{hidden},
+        weight,
+        bias,
+        1e-5,
+        false};
+    op.call(stack);
+    benchmark::DoNotOptimize(stack);
+  }
+  ipex_bench::set_roofline(
+      state,
+      dtype,
+      (3.0 * rows + 2) * hidden * ipex_bench::element_size(dtype));
+}
+IPEX_BENCHMARK_DTYPES(BM_add_layernorm, layernorm_shapes);
+
+} // namespace
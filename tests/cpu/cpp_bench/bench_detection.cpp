@@ -0,0 +1,137 @@
+#include "bench_utils.h"
+
+#include <algorithm>
+
+namespace {
+
+using ipex_bench::DispatcherOp;
+
+// the random boxes of [x1, y1, x2, y2] of the sides in [1, 64] in the image
+// of size x size
+at::Tensor random_boxes(int64_t num_boxes, double size) {
+  auto xy = at::rand({num_boxes, 2}) * size;
+  auto wh = at::rand({num_boxes, 2}) * 63 + 1;
+  return at::cat({xy, xy + wh}, 1);
+}
+
+void nms_shapes(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"boxes"});
+  for (int64_t boxes : {1000, 5000, 20000}) {
+    b->Args({boxes});
+  }
+}
+
+// The kept boxes depend on the data, so only the boxes per second and the
+// bytes of the inputs are reported.
+void BM_nms(benchmark::State& state) {
+  torch::NoGradGuard no_grad;
+  int64_t num_boxes = state.range(0);
+  static DispatcherOp op("torch_ipex::nms");
+  auto dets = random_boxes(num_boxes, 800);
+  auto scores = at::rand({num_boxes});
+  for (auto _ : state) {
+    torch::jit::Stack stack{dets, scores, 0.5, false};
+    op.call(stack);
+    benchmark::DoNotOptimize(stack);
+  }
+  state.SetItemsProcessed(state.iterations() * num_boxes);
+  ipex_bench::set_roofline(state, at::kFloat, num_boxes * 5.0 * 4);
+}
+BENCHMARK(BM_nms)
+    ->Apply(nms_shapes)
+    ->UseRealTime()
+    ->Unit(benchmark::kMicrosecond);
+
+// {rois, channels}, of the 7 x 7 bins of the FPN level of stride 4 of Mask
+// R-CNN
+void roi_align_shapes(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"rois", "channels"});
+  for (int64_t rois : {512, 1000}) {
+    for (int64_t channels : {64, 256}) {
+      b->Args({rois, channels});
+    }
+  }
+}
+
+void BM_roi_align(benchmark::State& state, at::ScalarType dtype) {
+  torch::NoGradGuard no_grad;
+  constexpr int64_t kPooled = 7;
+  constexpr int64_t kSamplingRatio = 2;
+  int64_t num_rois = state.range(0);
+  int64_t channels = state.range(1);
+  static DispatcherOp op("torch_ipex::ROIAlign_forward");
+  auto input = at::randn({2, channels, 200, 272})
+                   .to(dtype)
+                   .contiguous(at::MemoryFormat::ChannelsLast);
+  auto batch_index = at::randint(2, {num_rois, 1}).to(at::kFloat);
+  auto rois = at::cat({batch_index, random_boxes(num_rois, 800)}, 1).to(dtype);
+  for (auto _ : state) {
+    torch::jit::Stack stack{
+        input, rois, 0.25, kPooled, kPooled, kSamplingRatio, true};
+    op.call(stack);
+    benchmark::DoNotOptimize(stack);
+  }
+  // each bin averages the samples of the 4 bilinear neighbours, of which the
+  // reads are of the input at most
+  double bins = (double)num_rois * channels * kPooled * kPooled;
+  double samples = bins * kSamplingRatio * kSamplingRatio;
+  int64_t elem = ipex_bench::element_size(dtype);
+  ipex_bench::set_roofline(
+      state,
+      dtype,
+      std::min<double>(4 * samples, input.numel()) * elem + bins * elem,
+      samples * 8);
+}
+IPEX_BENCHMARK_DTYPES(BM_roi_align, roi_align_shapes);
+
+// {channels, size}, of the 2x upsampling of the batch 8 of the decoders and
+// of the FPN
+void upsample_shapes(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"channels", "size"});
+  for (int64_t channels : {64, 256}) {
+    for (int64_t size : {32, 128}) {
+      b->Args({channels, size});
+    }
+  }
+}
+
+at::Tensor upsample_input(benchmark::State& state, at::ScalarType dtype) {
+  int64_t channels = state.range(0);
+  int64_t size = state.range(1);
+  return at::randn({8, channels, size, size})
+      .to(dtype)
+      .contiguous(at::MemoryFormat::ChannelsLast);
+}
+
+// of the input and the 4x output of the 2x upsampling
+double upsample_bytes(const at::Tensor& input) {
+  return 5.0 * input.numel() * input.element_size();
+}
+
+// of aten::upsample_nearest2d, of which IPEX registers the CPU kernel
+void BM_upsample_nearest2d(benchmark::State& state, at::ScalarType dtype) {
+  torch::NoGradGuard no_grad;
+  auto input = upsample_input(state, dtype);
+  int64_t size = 2 * input.size(2);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(at::upsample_nearest2d(input, {size, size}));
+  }
+  ipex_bench::set_roofline(state, dtype, upsample_bytes(input));
+}
+IPEX_BENCHMARK_DTYPES(BM_upsample_nearest2d, upsample_shapes);
+
+void BM_upsample_bilinear2d(benchmark::State& state, at::ScalarType dtype) {
+  torch::NoGradGuard no_grad;
+  auto input = upsample_input(state, dtype);
+  int64_t size = 2 * input.size(2);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        at::upsample_bilinear2d(input, {size, size}, false));
+  }
+  // the 4 weighted neighbours of each output
+  ipex_bench::set_roofline(
+      state, dtype, upsample_bytes(input), 4.0 * input.numel() * 7);
+}
+IPEX_BENCHMARK_DTYPES(BM_upsample_bilinear2d, upsample_shapes);
+
+} // namespace
@@ -0,0 +1,125 @@
+#include "bench_utils.h"
+
+namespace {
+
+using ipex_bench::DispatcherOp;
+
+constexpr int64_t kNumRows = 200000;
+
+// {batch, dim, pooling}, i.e. the one-hot and the multi-hot bags of DLRM
+void embedding_shapes(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"batch", "dim", "pooling"});
+  for (int64_t batch : {1024, 8192}) {
+    for (int64_t dim : {64, 128}) {
+      for (int64_t pooling : {1, 32}) {
+        b->Args({batch, dim, pooling});
+      }
+    }
+  }
+}
+
+// the rows gathered, the indices and the sums written
+double embedding_bag_bytes(
+    int64_t bags,
+    int64_t dim,
+    int64_t pooling,
+    at::ScalarType dtype) {
+  int64_t elem = ipex_bench::element_size(dtype);
+  return bags * pooling * (dim * elem + 8.0) + bags * dim * elem;
+}
+
+void BM_embedding_bag(benchmark::State& state, at::ScalarType dtype) {
+  torch::NoGradGuard no_grad;
+  int64_t batch = state.range(0);
+  int64_t dim = state.range(1);
+  int64_t pooling = state.range(2);
+  static DispatcherOp op("torch_ipex::embedding_bag");
+  auto weight = at::randn({kNumRows, dim}).to(dtype);
+  auto indices = at::randint(kNumRows, {batch * pooling}, at::kLong);
+  auto offsets = at::arange(0, batch * pooling, pooling, at::kLong);
+  for (auto _ : state) {
+    torch::jit::Stack stack{weight, indices, offsets, false, false};
+    op.call(stack);
+    benchmark::DoNotOptimize(stack);
+  }
+  ipex_bench::set_roofline(
+      state, dtype, embedding_bag_bytes(batch, dim, pooling, dtype));
+}
+IPEX_BENCHMARK_DTYPES(BM_embedding_bag, embedding_shapes);
+
+// the 26 sparse features of DLRM merged into one call
+void BM_merged_embeddingbag(benchmark::State& state, at::ScalarType dtype) {
+  torch::NoGradGuard no_grad;
+  constexpr int64_t kNumTables = 26;
+  int64_t batch = state.range(0);
+  int64_t dim = state.range(1);
+  int64_t pooling = state.range(2);
+  static DispatcherOp op("torch_ipex::merged_embeddingbag_forward");
+  std::vector<at::Tensor> weights;
+  for (int64_t i = 0; i < kNumTables; i++) {
+    weights.push_back(at::randn({kNumRows, dim}).to(dtype));
+  }
+  auto indices =
+      at::randint(kNumRows, {kNumTables * batch * pooling}, at::kLong);
+  auto offsets = at::arange(
+      0, kNumTables * batch * pooling + 1, pooling, at::kLong);
+  // sum pooling
+  std::vector<int64_t> pooling_modes(kNumTables, 0);
+  for (auto _ : state) {
+    torch::jit::Stack stack{
+        indices,
+        offsets,
+        weights,
+        pooling_modes,
+        c10::IValue(),
+        c10::IValue(),
+        c10::IValue(),
+        false};
+    op.call(stack);
+    benchmark::DoNotOptimize(stack);
+  }
+  ipex_bench::set_roofline(
+      state,
+      dtype,
+      kNumTables * embedding_bag_bytes(batch, dim, pooling, dtype));
+}
+IPEX_BENCHMARK_DTYPES(BM_merged_embeddingbag, embedding_shapes);
+
+// {batch, dim}, of the 1 dense and the 26 sparse features of DLRM
+void interaction_shapes(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"batch", "dim"});
+  for (int64_t batch : {256, 2048, 32768}) {
+    for (int64_t dim : {64, 128}) {
+      b->Args({batch, dim});
+    }
+  }
+}
+
+void BM_interaction_forward(benchmark::State& state, at::ScalarType dtype) {
+  torch::NoGradGuard no_grad;
+  constexpr int64_t kNumFeatures = 27;
+  int64_t batch = state.range(0);
+  int64_t dim = state.range(1);
+  static DispatcherOp op("torch_ipex::interaction_forward");
+  std::vector<at::Tensor> input;
+  for (int64_t i = 0; i < kNumFeatures; i++) {
+    input.push_back(at::randn({batch, dim}).to(dtype));
+  }
+  for (auto _ : state) {
+    torch::jit::Stack stack{input};
+    op.call(stack);
+    benchmark::DoNotOptimize(stack);
+  }
+  // the dot products of the strictly lower triangle, and the dense feature
+  // concatenated with them
+  int64_t pairs = kNumFeatures * (kNumFeatures - 1) / 2;
+  int64_t elem = ipex_bench::element_size(dtype);
+  ipex_bench::set_roofline(
+      state,
+      dtype,
+      (double)batch * (kNumFeatures * dim + dim + pairs) * elem,
+      2.0 * batch * pairs * dim);
+}
+IPEX_BENCHMARK_DTYPES(BM_interaction_forward, interaction_shapes);
+
+} // namespace
@@ -0,0 +1,55 @@
+#include "bench_utils.h"
+
+namespace {
+
+using ipex_bench::DispatcherOp;
+
+// {seq_len, batch, hidden}, of the input size of the hidden size, e.g. the
+// encoders of RNN-T and GNMT
+void lstm_shapes(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"seq_len", "batch", "hidden"});
+  for (int64_t batch : {1, 64, 256}) {
+    for (int64_t hidden : {512, 1024}) {
+      b->Args({50, batch, hidden});
+    }
+  }
+}
+
+// the inference of an LSTM of 2 layers by the ipex_lstm of nn.LSTM
+void BM_ipex_lstm(benchmark::State& state, at::ScalarType dtype) {
+  torch::NoGradGuard no_grad;
+  constexpr int64_t kNumLayers = 2;
+  int64_t seq_len = state.range(0);
+  int64_t batch = state.range(1);
+  int64_t hidden = state.range(2);
+  static DispatcherOp op("torch_ipex::ipex_lstm");
+  auto input = at::randn({seq_len, batch, hidden}).to(dtype);
+  std::vector<at::Tensor> hx{
+      at::zeros({kNumLayers, batch, hidden}).to(dtype),
+      at::zeros({kNumLayers, batch, hidden}).to(dtype)};
+  // w_ih, w_hh, b_ih and b_hh of each layer
+  std::vector<at::Tensor> params;
+  for (int64_t layer = 0; layer < kNumLayers; layer++) {
+    params.push_back(at::randn({4 * hidden, hidden}).to(dtype));
+    params.push_back(at::randn({4 * hidden, hidden}).to(dtype));
+    params.push_back(at::randn({4 * hidden}).to(dtype));
+    params.push_back(at::randn({4 * hidden}).to(dtype));
+  }
+  for (auto _ : state) {
+    torch::jit::Stack stack{
+        input, hx, params, true, kNumLayers, 0.0, false, false, false};
+    op.call(stack);
+    benchmark::DoNotOptimize(stack);
+  }
+  // the gates of the input and of the hidden state of each step, and the
+  // weights, the input and the output of each layer moved once
+  int64_t elem = ipex_bench::element_size(dtype);
+  double gate_flops = 2.0 * seq_len * batch * 4 * hidden * (2 * hidden);
+  double layer_bytes =
+      (8.0 * hidden * hidden + 2.0 * seq_len * batch * hidden) * elem;
+  ipex_bench::set_roofline(
+      state, dtype, kNumLayers * layer_bytes, kNumLayers * gate_flops);
+}
+IPEX_BENCHMARK_DTYPES(BM_ipex_lstm, lstm_shapes);
+
+} // namespace
@@ -0,0 +1,32 @@
+#include "bench_utils.h"
+
+#include "intel_extension_for_pytorch/csrc/cpu/dispatch/DispatchStub.h"
+#include "intel_extension_for_pytorch/csrc/cpu/isa/cpu_info.hpp"
+
+#include <string>
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  // measured before the benchmarks, of which the context reports the peaks
+  const auto& peak = ipex_bench::machine_peak();
+  benchmark::AddCustomContext("peak_GB/s", std::to_string(peak.gbps));
+  benchmark::AddCustomContext(
+      "peak_fp32_GFLOP/s", std::to_string(peak.fp32_gflops));
+  benchmark::AddCustomContext(
+      "peak_bf16_GFLOP/s", std::to_string(peak.bf16_gflops));
+  // the ISA of the kernels and the CPU, of which the results are compared by
+  // intel_extension_for_pytorch.utils.perf_regression against the baseline of
+  // the same fingerprint only
+  using namespace torch_ipex::cpu;
+  benchmark::AddCustomContext(
+      "ipex_isa", get_cpu_capability_name(get_cpu_capability()));
+  benchmark::AddCustomContext(
+      "cpu_micro_arch", CPUInfo::get_instance().micro_arch_name());
+  benchmark::AddCustomContext(
+      "cpu_fingerprint", CPUFeature::get_instance().fingerprint());
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,130 @@
+#include "bench_utils.h"
+
+namespace {
+
+using ipex_bench::DispatcherOp;
+
+// The fused steps of the params of numel elements. The fp32 ones update the
+// float params, and the bf16 ones the split bf16 params of which the trail
+// keeps the low 16 bits of the float params, of the bf16 grads.
+void optimizer_shapes(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"numel"});
+  for (int64_t numel : {1 << 16, 1 << 20, 1 << 24}) {
+    b->Args({numel});
+  }
+}
+
+struct Params {
+  at::Tensor param;
+  at::Tensor trail;
+  at::Tensor grad;
+  // the bytes of the param, the trail and the grad of an element
+  int64_t bytes;
+};
+
+Params make_params(int64_t numel, at::ScalarType dtype) {
+  auto param = at::randn({numel});
+  if (dtype == at::kBFloat16) {
+    return Params{
+        param.to(at::kBFloat16),
+        at::zeros({numel}, at::kBFloat16),
+        at::randn({numel}).to(at::kBFloat16),
+        // the param and the trail read and written, the grad read
+        2 * 2 + 2 * 2 + 2};
+  }
+  return Params{param, at::Tensor(), at::randn({numel}), 4 * 2 + 4};
+}
+
+void BM_sgd_fused_step(benchmark::State& state, at::ScalarType dtype) {
+  torch::NoGradGuard no_grad;
+  int64_t numel = state.range(0);
+  static DispatcherOp op("torch_ipex::sgd_fused_step");
+  auto params = make_params(numel, dtype);
+  auto momentum_buf = at::zeros({numel});
+  for (auto _ : state) {
+    torch::jit::Stack stack{
+        params.param,
+        params.grad,
+        momentum_buf,
+        params.trail,
+        0.9,
+        0.01,
+        1e-4,
+        0.0,
+        false,
+        1.0,
+        false};
+    op.call(stack);
+  }
+  // the float momentum read and written
+  ipex_bench::set_roofline(
+      state, dtype, (double)numel * (params.bytes + 4 * 2));
+}
+IPEX_BENCHMARK_DTYPES(BM_sgd_fused_step, optimizer_shapes);
+
+void BM_adam_fused_step(benchmark::State& state, at::ScalarType dtype) {
+  torch::NoGradGuard no_grad;
+  int64_t numel = state.range(0);
+  static DispatcherOp op("torch_ipex::adam_fused_step");
+  auto params = make_params(numel, dtype);
+  auto exp_avg = at::zeros({numel});
+  auto exp_avg_sq = at::zeros({numel});
+  for (auto _ : state) {
+    torch::jit::Stack stack{
+        params.param,
+        exp_avg,
+        exp_avg_sq,
+        at::Tensor(),
+        params.grad,
+        params.trail,
+        int64_t(1),
+        false,
+        true,
+        0.9,
+        0.999,
+        1e-3,
+        0.01,
+        1e-8,
+        1.0,
+        false};
+    op.call(stack);
+  }
+  // the float moments read and written
+  ipex_bench::set_roofline(
+      state, dtype, (double)numel * (params.bytes + 2 * 4 * 2));
+}
+IPEX_BENCHMARK_DTYPES(BM_adam_fused_step, optimizer_shapes);
+
+// the update of LAMB is scaled by the trust ratio of the norms of the param
+// and the update, of which the bytes are still of one pass, the least the
+// step must move
+void BM_lamb_fused_step(benchmark::State& state, at::ScalarType dtype) {
+  torch::NoGradGuard no_grad;
+  int64_t numel = state.range(0);
+  static DispatcherOp op("torch_ipex::lamb_fused_step");
+  auto params = make_params(numel, dtype);
+  auto exp_avg = at::zeros({numel});
+  auto exp_avg_sq = at::zeros({numel});
+  for (auto _ : state) {
+    torch::jit::Stack stack{
+        params.param,
+        exp_avg,
+        exp_avg_sq,
+        params.grad,
+        params.trail,
+        int64_t(1),
+        0.9,
+        0.999,
+        1e-3,
+        0.01,
+        1e-6,
+        1.0,
+        false};
+    op.call(stack);
+  }
+  ipex_bench::set_roofline(
+      state, dtype, (double)numel * (params.bytes + 2 * 4 * 2));
+}
+IPEX_BENCHMARK_DTYPES(BM_lamb_fused_step, optimizer_shapes);
+
+} // namespace
@@ -0,0 +1,111 @@
+#include "bench_utils.h"
+
+#include "intel_extension_for_pytorch/csrc/cpu/isa/cpu_info.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+
+namespace ipex_bench {
+
+namespace {
+
+// the best of the runs after a warm-up, in seconds
+double best_seconds(const std::function<void()>& fn, int runs) {
+  fn();
+  double best = 0;
+  for (int i = 0; i < runs; i++) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    best = i == 0 ? seconds : std::min(best, seconds);
+  }
+  return best;
+}
+
+double env_double(const char* name, double default_value) {
+  const char* value = std::getenv(name);
+  return value != nullptr ? std::atof(value) : default_value;
+}
+
+double measure_gbps() {
+  const auto& cpu_info = torch_ipex::cpu::CPUInfo::get_instance();
+  int64_t bytes = std::max<int64_t>(4 * cpu_info.l3().size, 256 << 20);
+  auto src = at::ones({bytes / 4});
+  auto dst = at::empty_like(src);
+  double seconds = best_seconds([&] { dst.copy_(src); }, 5);
+  return 2.0 * bytes / seconds / 1e9;
+}
+
+double measure_gflops(at::ScalarType dtype) {
+  constexpr int64_t n = 4096;
+  auto a = at::randn({n, n}).to(dtype);
+  auto b = at::randn({n, n}).to(dtype);
+  auto c = at::empty({n, n}, a.options());
+  double seconds = best_seconds([&] { at::mm_out(c, a, b); }, 3);
+  return 2.0 * n * n * n / seconds / 1e9;
+}
+
+MachinePeak measure_machine_peak() {
+  torch::NoGradGuard no_grad;
+  MachinePeak peak;
+  peak.gbps = env_double("IPEX_BENCH_PEAK_GBPS", 0);
+  if (peak.gbps <= 0) {
+    peak.gbps = measure_gbps();
+  }
+  peak.fp32_gflops = env_double("IPEX_BENCH_PEAK_FP32_GFLOPS", 0);
+  if (peak.fp32_gflops <= 0) {
+    peak.fp32_gflops = measure_gflops(at::kFloat);
+  }
+  peak.bf16_gflops = env_double("IPEX_BENCH_PEAK_BF16_GFLOPS", 0);
+  if (peak.bf16_gflops <= 0) {
+    peak.bf16_gflops = measure_gflops(at::kBFloat16);
+  }
+  return peak;
+}
+
+torch::jit::Operation find_jit_operation(
+    const char* name,
+    size_t num_arguments) {
+  for (const auto& op :
+       torch::jit::getAllOperatorsFor(c10::Symbol::fromQualString(name))) {
+    if (op->schema().arguments().size() == num_arguments) {
+      return op->getOperation();
+    }
+  }
+  TORCH_CHECK(false, "No JIT op ", name, " of ", num_arguments, " arguments");
+}
+
+} // namespace
+
+const MachinePeak& machine_peak() {
+  static MachinePeak peak = measure_machine_peak();
+  return peak;
+}
+
+void set_roofline(
+    benchmark::State& state,
+    at::ScalarType dtype,
+    double bytes,
+    double flops) {
+  const auto& peak = machine_peak();
+  // of the value of one iteration, i.e. value * iterations / seconds
+  auto rate = benchmark::Counter::kIsIterationInvariantRate;
+  state.counters["GB/s"] = benchmark::Counter(bytes / 1e9, rate);
+  state.counters["BW%"] = benchmark::Counter(bytes / 1e7 / peak.gbps, rate);
+  if (flops > 0) {
+    double peak_gflops =
+        dtype == at::kBFloat16 ? peak.bf16_gflops : peak.fp32_gflops;
+    state.counters["GFLOP/s"] = benchmark::Counter(flops / 1e9, rate);
+    state.counters["FLOP%"] =
+        benchmark::Counter(flops / 1e7 / peak_gflops, rate);
+  }
+}
+
+JitOp::JitOp(const char* name, size_t num_arguments)
+    : op_(find_jit_operation(name, num_arguments)) {}
+
+} // namespace ipex_bench
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+#include <torch/csrc/jit/runtime/operator.h>
+#include <torch/torch.h>
+
+#include <string>
+
+// The helpers of the microbenchmarks of the IPEX ops. Each benchmark calls an
+// op by the dispatcher, or by the JIT registry for the ipex:: ops of the
+// fusion passes, from C++ so that the time is of the kernel and the dispatch
+// only, and reports its minimal memory traffic and FLOPs against the peaks of
+// the machine:
+//   GB/s, BW%:       the bytes the op must read and write per call
+//   GFLOP/s, FLOP%:  the FLOPs of the compute bound ops, of which the peak is
+//                    of a large GEMM of the same dtype
+// The peaks are measured once on start, or taken from IPEX_BENCH_PEAK_GBPS,
+// IPEX_BENCH_PEAK_FP32_GFLOPS and IPEX_BENCH_PEAK_BF16_GFLOPS if set.
+
+namespace ipex_bench {
+
+struct MachinePeak {
+  // of a STREAM copy of the buffers of 4x the LLC, of its read and write
+  double gbps = 0;
+  // of the GEMM of 4096 x 4096 x 4096
+  double fp32_gflops = 0;
+  double bf16_gflops = 0;
+};
+
+const MachinePeak& machine_peak();
+
+// Sets the GB/s and the GFLOP/s counters of the bytes and the FLOPs of one
+// iteration, of which the GFLOP/s ones are omitted if flops is 0. The
+// benchmarks use the real time, of which the kernels are multi-threaded.
+void set_roofline(
+    benchmark::State& state,
+    at::ScalarType dtype,
+    double bytes,
+    double flops = 0);
+
+inline int64_t element_size(at::ScalarType dtype) {
+  return c10::elementSize(dtype);
+}
+
+inline const char* dtype_name(at::ScalarType dtype) {
+  return dtype == at::kBFloat16 ? "bf16" : "fp32";
+}
+
+// The op of the dispatcher, called with all its arguments on the stack
+class DispatcherOp {
+ public:
+  explicit DispatcherOp(const char* name, const char* overload = "")
+      : op_(c10::Dispatcher::singleton().findSchemaOrThrow(name, overload)) {}
+
+  void call(torch::jit::Stack& stack) const {
+    op_.callBoxed(&stack);
+  }
+
+ private:
+  c10::OperatorHandle op_;
+};
+
+// The op of the JIT registry of the argument count, e.g. ipex::mha
+class JitOp {
+ public:
+  JitOp(const char* name, size_t num_arguments);
+
+  void call(torch::jit::Stack& stack) {
+    op_(stack);
+  }
+
+ private:
+  torch::jit::Operation op_;
+};
+
+} // namespace ipex_bench
+
+// the dtypes of the benchmarks of a function of (state, dtype)
+#define IPEX_BENCHMARK_DTYPES(func, shapes)     \
+  BENCHMARK_CAPTURE(func, fp32, at::kFloat)     \
+      ->Apply(shapes)                           \
+      ->UseRealTime()                           \
+      ->Unit(benchmark::kMicrosecond);          \
+  BENCHMARK_CAPTURE(func, bf16, at::kBFloat16)  \
+      ->Apply(shapes)                           \
+      ->UseRealTime()                           \
+      ->Unit(benchmark::kMicrosecond)
@@ -0,0 +1,36 @@
+import math
+import torch
+import torch.nn as nn
+import intel_extension_for_pytorch as ipex
+
+class MHAScoresCalculation(nn.Module):
+    def __init__(self, dim_per_head):
+        super(MHAScoresCalculation, self).__init__()
+        self.softmax = nn.Softmax(dim=-1)
+        self.dim_per_head = dim_per_head
+
+    def forward(self, mat1, mat2, bias):
+        mat1 = mat1 / math.sqrt(self.dim_per_head)
+        qk = torch.matmul(mat1, mat2.transpose(2, 3))
+        scores = qk + bias
+        return self.softmax(scores)
+
+def run_model():
+    mha = MHAScoresCalculation(4)
+    max_diff = 0.
+    # the rows of the vector size and of the tails, with the broadcasted bias
+    for k_len, bias_q_len in [(64, 12), (48, 1), (80, 12)]:
+        mat1 = torch.randn(2, 3, 12, 8)
+        mat2 = torch.randn(2, 3, k_len, 8)
+        bias = torch.randn(2, 1, bias_q_len, k_len)
+        with torch.no_grad():
+            mha_jit = torch.jit.freeze(torch.jit.trace(mha.eval(), (mat1, mat2, bias)))
+            for _ in range(2):
+                res_jit = mha_jit(mat1, mat2, bias)
+            res_ref = mha(mat1, mat2, bias)
+        max_diff = max(max_diff, (res_jit - res_ref).abs().max().item())
+    print("isa_level: {}".format(ipex._C._get_current_isa_level()))
+    print("max_diff: {}".format(max_diff))
+
+if __name__ == '__main__':
+    run_model()
@@ -0,0 +1,77 @@
+import unittest
+import gc
+import weakref
+import copy
+import torch
+import intel_extension_for_pytorch as ipex
+from torch.testing._internal.common_utils import TestCase
+
+class Block(torch.nn.Module):
+    def __init__(self):
+        super(Block, self).__init__()
+        self.ln = torch.nn.LayerNorm(32)
+        self.fc1 = torch.nn.Linear(32, 64)
+        self.gelu = torch.nn.GELU()
+        self.dropout = torch.nn.Dropout(0.2)
+        self.fc2 = torch.nn.Linear(64, 32)
+
+    def forward(self, x):
+        return x + self.fc2(self.dropout(self.gelu(self.fc1(self.ln(x)))))
+
+class TestActivationRecompute(TestCase):
+
+    def _grads(self, model, x):
+        torch.manual_seed(0)
+        model(x).sum().backward()
+        return [p.grad for p in model.parameters()]
+
+    def test_activation_recompute(self):
+        model = Block().train()
+        recompute_model = ipex.enable_activation_recompute(copy.deepcopy(model))
+        x = torch.randn(8, 32)
+        for grad, ref_grad in zip(self._grads(recompute_model, x), self._grads(model, x)):
+            self.assertEqual(grad, ref_grad, atol=1e-5, rtol=1e-5)
+
+    def test_activation_recompute_ipex_dropout(self):
+        model = Block().train()
+        optimizer = torch.optim.SGD(model.parameters(), lr=0.1)
+        model, _ = ipex.optimize(model, optimizer=optimizer)
+        recompute_model = ipex.enable_activation_recompute(copy.deepcopy(model))
+        x = torch.randn(8, 32)
+        for grad, ref_grad in zip(self._grads(recompute_model, x), self._grads(model, x)):
+            self.assertEqual(grad, ref_grad, atol=1e-5, rtol=1e-5)
+
+    def test_activation_recompute_not_saved(self):
+        # the outputs of the layer_norm, the gelu and the dropout are freed after the forward
+        for recompute in [False, True]:
+            model = Block().train()
+            if recompute:
+                ipex.enable_activation_recompute(model)
+            outputs = []
+            for module in [model.ln, model.gelu, model.dropout]:
+                module.register_forward_hook(lambda m, i, o: outputs.append(weakref.ref(o)))
+            y = model(torch.randn(8, 32)).sum()
+            gc.collect()
+            self.assertEqual(all(o() is None for o in outputs), recompute)
+            y.backward()
+
+    def test_activation_recompute_inplace(self):
+        class Model(torch.nn.Module):
+            def __init__(self):
+                super(Model, self).__init__()
+                self.fc = torch.nn.Linear(16, 16)
+                self.gelu = torch.nn.GELU()
+
+            def forward(self, x):
+                h = self.fc(x)
+                y = self.fc(self.gelu(h))
+                h.mul_(2)
+                return y
+
+        model = ipex.enable_activation_recompute(Model().train())
+        y = model(torch.randn(4, 16))
+        with self.assertRaises(RuntimeError):
+            y.sum().backward()
+
+if __name__ == '__main__':
+    test = unittest.main()
@@ -56,6 +56,110 @@ class TestFunction(TestCase):
                 out_autocast = _conv(_in_cpu)
             self.assertEqual(out_autocast.dtype, torch.float)
 
+    def test_cast_cache_shared_between_threads(self):
+        import threading
+        _in_cpu = torch.rand((1, 1, 7, 7))
+        _conv = torch.nn.Conv2d(1, 1, (3, 3), bias=False)
+        cache_size = ipex._C._get_autocast_cache_size()
+
+        def run_conv():
+            with torch.no_grad(), torch.cpu.amp.autocast(enabled=True, dtype=torch.bfloat16):
+                _conv(_in_cpu)
+
+        threads = [threading.Thread(target=run_conv) for _ in range(2)]
+        for thread in threads:
+            thread.start()
+        for thread in threads:
+            thread.join()
+        # All threads share one bf16 copy of the weight
+        self.assertEqual(ipex._C._get_autocast_cache_size(), cache_size + 1)
+
+        # Only the cast of the modified weight is released by clearing the cache
+        with torch.no_grad():
+            _conv.weight.add_(1)
+        ipex._C.clear_autocast_cache()
+        self.assertEqual(ipex._C._get_autocast_cache_size(), cache_size)
+
+    def test_cast_cache_in_training(self):
+        _in_cpu = torch.rand((1, 1, 7, 7))
+        _conv = torch.nn.Conv2d(1, 1, (3, 3), bias=False)
+        ref_conv = copy.deepcopy(_conv)
+        cache_size = ipex._C._get_autocast_cache_size()
+        for _ in range(3):
+            with torch.cpu.amp.autocast(enabled=True, dtype=torch.bfloat16):
+                y = _conv(_in_cpu)
+            # the cast of the weight is kept across the iterations
+            self.assertEqual(ipex._C._get_autocast_cache_size(), cache_size + 1)
+            y.sum().backward()
+            ref_y = torch.nn.functional.conv2d(_in_cpu.bfloat16(), ref_conv.weight.bfloat16())
+            ref_y.sum().backward()
+            self.assertEqual(y, ref_y)
+            self.assertEqual(_conv.weight.grad, ref_conv.weight.grad)
+            # the cast is refreshed after the weight is updated
+            with torch.no_grad():
+                _conv.weight.sub_(_conv.weight.grad, alpha=0.1)
+                ref_conv.weight.sub_(ref_conv.weight.grad, alpha=0.1)
+            _conv.weight.grad = None
+            ref_conv.weight.grad = None
+        ipex._C.clear_autocast_cache()
+        self.assertEqual(ipex._C._get_autocast_cache_size(), cache_size)
+
+    def test_cast_cache_weight_update(self):
+        _in_cpu = torch.rand((1, 1, 7, 7))
+        _conv = torch.nn.Conv2d(1, 1, (3, 3), bias=False)
+        with torch.no_grad():
+            for _ in range(3):
+                with torch.cpu.amp.autocast(enabled=True, dtype=torch.bfloat16):
+                    y = _conv(_in_cpu)
+                ref_y = torch.nn.functional.conv2d(_in_cpu.bfloat16(), _conv.weight.bfloat16())
+                self.assertEqual(y, ref_y)
+                # the casts looked up by the thread are refreshed after the weight is updated
+                _conv.weight.mul_(0.5)
+        ipex._C.clear_autocast_cache()
+
+    def test_no_cast_args(self):
+        _in_cpu = torch.rand((2, 8)).bfloat16()
+        _linear = torch.nn.Linear(8, 4).bfloat16()
+        with torch.no_grad(), torch.cpu.amp.autocast(enabled=True, dtype=torch.bfloat16):
+            cache_size = ipex._C._get_autocast_cache_size()
+            y = _linear(_in_cpu)
+            # the args of the target dtype are passed to the op as they are
+            self.assertEqual(ipex._C._get_autocast_cache_size(), cache_size)
+        self.assertEqual(y.dtype, torch.bfloat16)
+        self.assertEqual(y, torch.nn.functional.linear(_in_cpu, _linear.weight, _linear.bias))
+
+    def test_autocast_policy(self):
+        _in_cpu = torch.rand((1, 1, 7, 7))
+        _conv = torch.nn.Conv2d(1, 1, (3, 3))
+        policy = ipex.get_autocast_policy()
+        try:
+            ipex.set_autocast_policy('conv2d', False)
+            with torch.no_grad(), torch.cpu.amp.autocast(enabled=True, dtype=torch.bfloat16):
+                self.assertEqual(_conv(_in_cpu).dtype, torch.float)
+            ipex.set_autocast_policy('conv2d', True)
+            with torch.no_grad(), torch.cpu.amp.autocast(enabled=True, dtype=torch.bfloat16):
+                self.assertEqual(_conv(_in_cpu).dtype, torch.bfloat16)
+
+            calibrated = ipex.calibrate_autocast_policy(_conv, (_in_cpu,), iterations=2)
+            self.assertEqual(calibrated, ipex.get_autocast_policy())
+            with torch.no_grad(), torch.cpu.amp.autocast(enabled=True, dtype=torch.bfloat16):
+                y = _conv(_in_cpu)
+            self.assertEqual(y.dtype, torch.bfloat16 if calibrated['conv2d'] else torch.float)
+        finally:
+            for op, lower_precision in policy.items():
+                ipex.set_autocast_policy(op, lower_precision)
+
+    def test_fp16_autocast_dtype(self):
+        a = torch.randn(8, 16)
+        b = torch.randn(16, 4)
+        with torch.cpu.amp.autocast(enabled=True, dtype=torch.float16):
+            self.assertTrue(torch.is_autocast_cpu_enabled())
+            self.assertEqual(ipex._C.get_autocast_dtype(), torch.float16)
+            # mm has no float16 kernel on CPU and runs in float32
+            y = torch.mm(a, b)
+        self.assertEqual(y.dtype, torch.float)
+        self.assertEqual(y, torch.mm(a, b))
+
 class TestAutocastWithJit(TestCase):
     def setUp(self):
         super(TestAutocastWithJit, self).setUp()
@@ -456,6 +560,27 @@ class TestLSTM(TestCase):
         self.assertEqual(hidden_out[0], hidden_out_ipex[0])
         self.assertEqual(hidden_out[1], hidden_out_ipex[1])
 
+    def test_lstm_bf16_training_weight_grad(self):
+        # the weight gradients of the bf16 training are kept in fp32
+        model = M(input_size=16, hidden_size=32, num_layers=2, bidirectional=True, bias=True, dropout=0, batch_first=False)
+        model_ipex = copy.deepcopy(model)
+        ipex.nn.utils._model_convert.replace_lstm_with_ipex_lstm(model_ipex)
+        input = torch.randn(7, 3, 16)
+        y_ref, _ = model(input)
+        y_ref.sum().backward()
+        for _ in range(2):
+            # the second iteration runs on the pooled workspaces
+            model_ipex.zero_grad()
+            with torch.cpu.amp.autocast(enabled=True, dtype=torch.bfloat16):
+                y, _ = model_ipex(input)
+            y.float().sum().backward()
+            for param, param_ref in zip(model_ipex.parameters(), model.parameters()):
+                self.assertEqual(param.grad.dtype, torch.float)
+                self.assertLess(((param.grad - param_ref.grad).norm() / param_ref.grad.norm()).item(), 5e-2)
+        # the fp32 gradients are not rounded to bf16
+        grad = model_ipex.lstm.weight_ih_l0.grad
+        self.assertFalse(torch.equal(grad, grad.bfloat16().float()))
+
     def test_lstm_op(self):
         self._test_lstm(training=False, bf16=False)
 
@@ -468,6 +593,94 @@ class TestLSTM(TestCase):
     def test_lstm_pack_padded_sequence(self):
         self._test_lstm_pack_padded_sequence()
 
+class RnnM(nn.Module):
+    def __init__(self, rnn_cls, **kwargs):
+        super(RnnM, self).__init__()
+        self.rnn = rnn_cls(**kwargs)
+
+    def forward(self, x, h=None):
+        x, h = self.rnn(x, h)
+        return x, h
+
+class TestGRUAndRNN(TestCase):
+    def _rnn_modules(self):
+        return [(nn.GRU, {}), (nn.RNN, {"nonlinearity": "tanh"}), (nn.RNN, {"nonlinearity": "relu"})]
+
+    def _test_rnn(self, training, bf16, prec=1e-5):
+        rand_seed = int(get_rand_seed())
+        print("{} rand sed: {}".format(sys._getframe().f_code.co_name, rand_seed))
+        torch.manual_seed(rand_seed)
+
+        for (rnn_cls, kwargs), num_layers, bidirectional, bias, empty_state, batch_first in itertools.product(
+                self._rnn_modules(), [1, 2], [False, True], [False, True], [False, True], [False, True]):
+            input_size, hidden_size, batch_size, seq_len = 3, 5, 2, 4
+            num_directions = 2 if bidirectional else 1
+            if batch_first:
+                input = torch.randn(batch_size, seq_len, input_size)
+            else:
+                input = torch.randn(seq_len, batch_size, input_size)
+            h = torch.randn(num_layers * num_directions, batch_size, hidden_size)
+
+            model_cpu = RnnM(rnn_cls, input_size=input_size, hidden_size=hidden_size, num_layers=num_layers,
+                             bidirectional=bidirectional, bias=bias, batch_first=batch_first, **kwargs)
+            model_cpu.train() if training else model_cpu.eval()
+            model_ipex = copy.deepcopy(model_cpu)
+            ipex.nn.utils._model_convert.replace_rnn_with_ipex_rnn(model_ipex)
+            self.assertTrue(type(model_ipex.rnn) is not rnn_cls)
+
+            input_cpu = input.clone().requires_grad_(training)
+            h_cpu = h.clone().requires_grad_(training)
+            input_ipex = input.clone().requires_grad_(training)
+            h_ipex = h.clone().requires_grad_(training)
+            with torch.cpu.amp.autocast(enabled=bf16, dtype=torch.bfloat16):
+                if empty_state:
+                    y_cpu, hy_cpu = self._cast_dtype(model_cpu, bf16)(self._cast_dtype(input_cpu, bf16))
+                    y_ipex, hy_ipex = model_ipex(input_ipex)
+                else:
+                    y_cpu, hy_cpu = self._cast_dtype(model_cpu, bf16)(self._cast_dtype(input_cpu, bf16), self._cast_dtype(h_cpu, bf16))
+                    y_ipex, hy_ipex = model_ipex(input_ipex, h_ipex)
+            self.assertEqual(y_cpu, y_ipex, prec=prec)
+            self.assertEqual(hy_cpu, hy_ipex, prec=prec)
+
+            if training:
+                (y_cpu.float().sum() + hy_cpu.float().sum()).backward()
+                (y_ipex.float().sum() + hy_ipex.float().sum()).backward()
+                self.assertEqual(input_ipex.grad, input_cpu.grad, prec=prec)
+                if not empty_state:
+                    self.assertEqual(h_ipex.grad, h_cpu.grad, prec=prec)
+                for param, param_ref in zip(model_ipex.parameters(), model_cpu.parameters()):
+                    # the weight gradients of the bf16 training are kept in fp32
+                    self.assertEqual(param.grad.dtype, torch.float)
+                    self.assertEqual(param.grad, param_ref.grad.float(), prec=prec)
+
+    def _cast_dtype(self, input, bf16):
+        if bf16:
+            input = input.to(torch.bfloat16)
+        return input
+
+    def test_rnn_op(self):
+        self._test_rnn(training=False, bf16=False)
+
+        self._test_rnn(training=False, bf16=True, prec=2e-2)
+
+        self._test_rnn(training=True, bf16=False)
+
+    def test_rnn_bf16_training(self):
+        for rnn_cls, kwargs in self._rnn_modules():
+            model = RnnM(rnn_cls, input_size=16, hidden_size=32, num_layers=2, bidirectional=True, **kwargs)
+            model_ipex = copy.deepcopy(model)
+            ipex.nn.utils._model_convert.replace_rnn_with_ipex_rnn(model_ipex)
+            input = torch.randn(7, 3, 16)
+            y_ref, _ = model(input)
+            y_ref.sum().backward()
+            with torch.cpu.amp.autocast(enabled=True, dtype=torch.bfloat16):
+                y, _ = model_ipex(input)
+            self.assertEqual(y.dtype, torch.bfloat16)
+            y.float().sum().backward()
+            for param, param_ref in zip(model_ipex.parameters(), model.parameters()):
+                self.assertEqual(param.grad.dtype, torch.float)
+                self.assertLess(((param.grad - param_ref.grad).norm() / param_ref.grad.norm()).item(), 5e-2)
+
 class TestAutocastOperations(TestCase):
     def setUp(self):
         super(TestAutocastOperations, self).setUp()
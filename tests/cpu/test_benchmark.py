@@ -0,0 +1,62 @@
+import unittest
+import json
+import os
+import tempfile
+import torch
+import intel_extension_for_pytorch as ipex
+from common_utils import TestCase
+
+class SimpleNet(torch.nn.Module):
+    def __init__(self):
+        super(SimpleNet, self).__init__()
+        self.linear = torch.nn.Linear(64, 32)
+
+    def forward(self, x):
+        return torch.relu(self.linear(x))
+
+def _traced_model(dtype=torch.float32):
+    model = ipex.optimize(SimpleNet().eval(), dtype=dtype)
+    with torch.no_grad():
+        return torch.jit.freeze(torch.jit.trace(model, torch.rand(2, 64).to(dtype)))
+
+class TestBenchmark(TestCase):
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_run_benchmark(self):
+        cpu_pool = ipex.cpu.runtime.CPUPool(core_ids=[0, 1])
+        result = ipex.benchmark.run_benchmark(
+            _traced_model(), torch.rand(2, 64), num_streams=2, cpu_pool=cpu_pool, warmup_duration=0.1, num_iters=20)
+        self.assertEqual(result['num_streams'], 2)
+        self.assertEqual(result['iterations'], 20)
+        self.assertEqual(sum(stream['iterations'] for stream in result['streams']), 20)
+        self.assertEqual([stream['cores'] for stream in result['streams']], [[0], [1]])
+        for stream in result['streams']:
+            self.assertEqual(sum(stream['histogram']), stream['iterations'])
+        latency = result['latency_ms']
+        self.assertTrue(0 < latency['p50'] <= latency['p99'] <= latency['max'])
+        self.assertGreater(result['throughput'], 0)
+        self.assertGreater(result['cpu_utilization'], 0)
+
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_sweep(self):
+        cpu_pool = ipex.cpu.runtime.CPUPool(core_ids=[0, 1])
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, 'results.json')
+            report = ipex.benchmark.sweep(
+                'simple_net', _traced_model, lambda batch_size, dtype: torch.rand(batch_size, 64).to(dtype),
+                num_streams=[1, 2], batch_sizes=[1, 4], cpu_pool=cpu_pool, output=path,
+                warmup_duration=0.1, num_iters=8)
+            with open(path) as f:
+                saved = json.load(f)
+        self.assertEqual(saved['environment']['ipex_version'], ipex.__version__)
+        self.assertEqual(len(saved['results']), 4)
+        self.assertEqual(
+            [(r['batch_size'], r['num_streams']) for r in saved['results']],
+            [(1, 1), (1, 2), (4, 1), (4, 2)])
+        for r in saved['results']:
+            self.assertEqual(r['model'], 'simple_net')
+            self.assertEqual(r['dtype'], 'float32')
+            self.assertAlmostEqual(r['samples_per_second'], r['throughput'] * r['batch_size'])
+        self.assertEqual(len(report['results']), 4)
+
+if __name__ == '__main__':
+    test = unittest.main()
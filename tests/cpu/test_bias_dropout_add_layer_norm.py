@@ -0,0 +1,71 @@
+import unittest
+import torch
+import torch.nn.functional as F
+import intel_extension_for_pytorch as ipex
+from torch.testing._internal.common_utils import TestCase
+import itertools
+
+class TestBiasDropoutAddLayerNorm(TestCase):
+
+    def _inputs(self, dtype, shape, hidden):
+        x = torch.randn(*shape, hidden).to(dtype)
+        residual = torch.randn(*shape, hidden).to(dtype)
+        bias = torch.randn(hidden)
+        weight = torch.randn(hidden)
+        ln_bias = torch.randn(hidden)
+        return [t.requires_grad_() for t in [x, bias, residual, weight, ln_bias]]
+
+    def _test_bias_dropout_add_layer_norm(self, dtype, hidden, p, train):
+        shape = (2, 5)
+        ref_inputs = self._inputs(dtype, shape, hidden)
+        inputs = [t.detach().clone().requires_grad_() for t in ref_inputs]
+
+        x, bias, residual, weight, ln_bias = ref_inputs
+        h = x.float() + bias
+        # the dropout of p = 1 drops all, the one of p = 0 keeps all
+        if train and p == 1:
+            h = h * 0
+        ref_out = F.layer_norm(h + residual.float(), [hidden], weight, ln_bias, 1e-5)
+
+        x, bias, residual, weight, ln_bias = inputs
+        out = ipex.nn.functional.bias_dropout_add_layer_norm(
+            x, bias, residual, p, train, [hidden], weight, ln_bias, 1e-5)
+        self.assertEqual(out.dtype, dtype)
+
+        grad = torch.randn(*shape, hidden)
+        ref_out.backward(grad)
+        out.backward(grad.to(dtype))
+        prec = 2e-2 if dtype == torch.bfloat16 else 1e-4
+        self.assertEqual(out.float(), ref_out, atol=prec, rtol=prec)
+        for t, ref_t in zip(inputs, ref_inputs):
+            self.assertEqual(t.grad.float(), ref_t.grad.float(), atol=prec * 5, rtol=prec)
+
+    def test_bias_dropout_add_layer_norm(self):
+        # both of the vectorized rows and the ones with a tail
+        for dtype, hidden, (p, train) in itertools.product(
+                [torch.float, torch.bfloat16], [64, 70], [(0.0, True), (1.0, True), (0.5, False)]):
+            self._test_bias_dropout_add_layer_norm(dtype, hidden, p, train)
+
+    def test_bias_dropout_add_layer_norm_dropout(self):
+        x = torch.randn(64, 256)
+        residual = torch.zeros(64, 256)
+        p = 0.3
+        out = torch.ops.torch_ipex.bias_dropout_add_layer_norm(
+            x, None, residual, p, True, [256], None, None, 1e-5)
+        # the rows of the dropped and the scaled elements are still normalized
+        self.assertTrue(out.isfinite().all())
+        self.assertEqual(out.mean(1), torch.zeros(64), atol=1e-4, rtol=1e-4)
+        self.assertEqual(out.var(1, unbiased=False), torch.ones(64), atol=1e-2, rtol=1e-2)
+
+    def test_bias_dropout_add_layer_norm_jit(self):
+        def fn(x, bias, residual, weight, ln_bias):
+            return torch.ops.torch_ipex.bias_dropout_add_layer_norm(
+                x, bias, residual, 0.1, False, [32], weight, ln_bias, 1e-5)
+        x, bias, residual, weight, ln_bias = [t.detach() for t in self._inputs(torch.float, (4,), 32)]
+        scripted = torch.jit.script(fn)
+        ref_out = F.layer_norm(x + bias + residual, [32], weight, ln_bias, 1e-5)
+        with torch.no_grad():
+            self.assertEqual(scripted(x, bias, residual, weight, ln_bias), ref_out, atol=1e-4, rtol=1e-4)
+
+if __name__ == '__main__':
+    test = unittest.main()
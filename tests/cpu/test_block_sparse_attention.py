@@ -0,0 +1,66 @@
+import unittest
+import math
+import torch
+import intel_extension_for_pytorch as ipex
+from torch.testing._internal.common_utils import TestCase
+import itertools
+
+def _ref_attention(query, key, value, mask):
+    scores = query.float() @ key.float().transpose(-2, -1) / math.sqrt(query.size(-1)) + mask.float()
+    return scores.softmax(-1) @ value.float()
+
+def _local_layout(num_heads, q_blocks, k_blocks, window):
+    # the blocks of the band of the window, and the first one of the global tokens
+    q = torch.arange(q_blocks).unsqueeze(1)
+    k = torch.arange(k_blocks).unsqueeze(0)
+    layout = ((q - k).abs() <= window) | (k == 0)
+    return layout.unsqueeze(0).expand(num_heads, q_blocks, k_blocks).contiguous()
+
+def _layout_mask(layout, block_size, q_len, k_len):
+    mask = layout.repeat_interleave(block_size, -2).repeat_interleave(block_size, -1)
+    mask = mask[..., :q_len, :k_len]
+    return torch.zeros(mask.shape).masked_fill(mask.logical_not(), float('-inf'))
+
+class TestBlockSparseAttention(TestCase):
+
+    def test_block_sparse_attention(self):
+        # the blocks filled or not at the end of the sequences
+        for dtype, seq_len, block_size in itertools.product(
+                [torch.float, torch.bfloat16], [128, 100], [16, 32]):
+            query, key, value = torch.randn(3, 2, 4, seq_len, 64).to(dtype).unbind(0)
+            blocks = (seq_len + block_size - 1) // block_size
+            layout = _local_layout(4, blocks, blocks, 1)
+            # the heads of different layouts
+            layout[1] = torch.rand(blocks, blocks) > 0.5
+            layout[1, :, 0] = True
+            padding = torch.zeros(2, 1, 1, seq_len)
+            padding[1, :, :, seq_len - 10:] = -10000.
+            with torch.no_grad():
+                out = ipex.nn.functional.block_sparse_attention(
+                    query, key, value, layout, block_size, attn_mask=padding.to(dtype))
+            ref_out = _ref_attention(
+                query, key, value, _layout_mask(layout, block_size, seq_len, seq_len) + padding)
+            self.assertEqual(out.dtype, dtype)
+            prec = 3e-2 if dtype == torch.bfloat16 else 1e-5
+            self.assertEqual(out.float(), ref_out, atol=prec, rtol=prec)
+
+    def test_mha_masked_tiles(self):
+        # the -inf tiles of the mask of ipex::mha are skipped
+        seq_len = 200
+        query, key, value = torch.randn(3, 2, 4, seq_len, 64).unbind(0)
+        layout = _local_layout(1, (seq_len + 63) // 64, (seq_len + 63) // 64, 0)
+        mask = _layout_mask(layout, 64, seq_len, seq_len).unsqueeze(0)
+
+        class MHA(torch.nn.Module):
+            def forward(self, q, k, v, mask):
+                scores = torch.matmul(q, k.transpose(-1, -2)) / 8.0 + mask
+                return torch.matmul(torch.softmax(scores, -1), v)
+
+        with torch.no_grad():
+            mha_jit = torch.jit.trace(MHA(), (query, key, value, mask))
+            trace_graph = mha_jit.graph_for(query, key, value, mask)
+            self.assertTrue(any(n.kind() == "ipex::mha" for n in trace_graph.nodes()))
+            self.assertEqual(mha_jit(query, key, value, mask), _ref_attention(query, key, value, mask))
+
+if __name__ == '__main__':
+    test = unittest.main()
@@ -0,0 +1,65 @@
+import torch
+import torch.distributed as dist
+import torch.multiprocessing as mp
+import intel_extension_for_pytorch as ipex  # flake8: noqa
+import unittest
+import os
+import tempfile
+from torch.testing._internal.common_utils import TestCase
+
+WORLD_SIZE = 2
+BATCH_SIZE = 8
+
+class MLP(torch.nn.Module):
+    def __init__(self):
+        super(MLP, self).__init__()
+        self.fc1 = torch.nn.Linear(64, 128)
+        self.fc2 = torch.nn.Linear(128, 128)
+        self.fc3 = torch.nn.Linear(128, 4)
+
+    def forward(self, x):
+        return self.fc3(torch.relu(self.fc2(torch.relu(self.fc1(x)))))
+
+def _data():
+    torch.manual_seed(1)
+    return torch.randn(BATCH_SIZE * WORLD_SIZE, 64), torch.randn(BATCH_SIZE * WORLD_SIZE, 4)
+
+def _train(rank, bucketed):
+    torch.manual_seed(0)
+    model = MLP()
+    model, optimizer = ipex.optimize(model, optimizer=torch.optim.SGD(model.parameters(), lr=0.1))
+    if bucketed:
+        # the buckets of a few params each, issued along the backward
+        ipex.optim.bucketed_allreduce(optimizer, bucket_cap_mb=0.05, compression='none')
+    x, y = _data()
+    if rank is not None:
+        x, y = x[rank * BATCH_SIZE:(rank + 1) * BATCH_SIZE], y[rank * BATCH_SIZE:(rank + 1) * BATCH_SIZE]
+    for _ in range(2):
+        optimizer.zero_grad()
+        torch.nn.functional.mse_loss(model(x), y).backward()
+        optimizer.step()
+    return model
+
+def _run_rank(rank, init_file, result_file):
+    dist.init_process_group(
+        "gloo", init_method="file://" + init_file, rank=rank, world_size=WORLD_SIZE)
+    model = _train(rank, bucketed=True)
+    torch.save(model.state_dict(), "{}.{}".format(result_file, rank))
+    dist.destroy_process_group()
+
+class TestBucketedAllreduce(TestCase):
+    @unittest.skipIf(not dist.is_available(), "torch.distributed is not available")
+    def test_training(self):
+        with tempfile.TemporaryDirectory() as path:
+            result_file = os.path.join(path, "result")
+            mp.spawn(_run_rank, args=(os.path.join(path, "init"), result_file), nprocs=WORLD_SIZE)
+            results = [torch.load("{}.{}".format(result_file, rank)) for rank in range(WORLD_SIZE)]
+
+        # the averaged grads of the halves of the batch are the grads of the whole batch
+        ref_state = _train(None, bucketed=False).state_dict()
+        for result in results:
+            for var_name in ref_state:
+                self.assertEqual(ref_state[var_name], result[var_name], rtol=1e-5, atol=1e-5)
+
+if __name__ == '__main__':
+    test = unittest.main()
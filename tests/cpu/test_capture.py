@@ -0,0 +1,45 @@
+import unittest
+
+import torch
+import intel_extension_for_pytorch as ipex
+from torch.testing._internal.common_utils import TestCase
+
+class ConvLinear(torch.nn.Module):
+    def __init__(self):
+        super(ConvLinear, self).__init__()
+        self.conv = torch.nn.Conv2d(3, 8, kernel_size=3, padding=1)
+        self.linear = torch.nn.Linear(8 * 8 * 8, 10)
+
+    def forward(self, x):
+        return self.linear(torch.relu(self.conv(x)).flatten(1))
+
+class TestCapture(TestCase):
+    def test_capture_replay(self):
+        model = ipex.optimize(ConvLinear().eval())
+        captured = ipex.capture(model, warmup=1, max_plans=1)
+        with torch.no_grad():
+            for _ in range(4):
+                x = torch.randn(2, 3, 8, 8)
+                self.assertEqual(model(x), captured(x))
+            # the first call is the eager warmup, the others replay the plan
+            self.assertEqual(captured.stats(), {'replays': 3, 'fallbacks': 1, 'plans': 1})
+            # the shape guard falls back to the eager model
+            x = torch.randn(1, 3, 8, 8)
+            for _ in range(2):
+                self.assertEqual(model(x), captured(x))
+            self.assertEqual(captured.stats(), {'replays': 3, 'fallbacks': 3, 'plans': 1})
+
+    def test_capture_untraceable(self):
+        class DataDependent(torch.nn.Module):
+            def forward(self, x):
+                return {'y': x.tolist()}
+
+        captured = ipex.capture(DataDependent().eval(), warmup=0)
+        x = torch.randn(2)
+        with self.assertWarns(UserWarning):
+            y = captured(x)
+        self.assertEqual(y['y'], x.tolist())
+        self.assertEqual(captured.stats()['plans'], 0)
+
+if __name__ == '__main__':
+    test = unittest.main()
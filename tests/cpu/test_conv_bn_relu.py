@@ -0,0 +1,54 @@
+import unittest
+import torch
+import intel_extension_for_pytorch as ipex
+from torch.testing._internal.common_utils import TestCase
+import copy
+
+class ConvBatchNormReLU(torch.nn.Module):
+
+    def __init__(self):
+        super(ConvBatchNormReLU, self).__init__()
+        self.conv = torch.nn.Conv2d(3, 16, kernel_size=3, padding=1)
+        self.bn = torch.nn.BatchNorm2d(16)
+        self.relu = torch.nn.ReLU()
+
+    def forward(self, x):
+        return self.relu(self.bn(self.conv(x)))
+
+class TestConvBatchNormReLU(TestCase):
+
+    def _test_conv_bn_relu(self, memory_format, dtype, train):
+        x1 = torch.randn(4, 3, 14, 14).to(memory_format=memory_format).requires_grad_()
+        x2 = copy.deepcopy(x1)
+        model = ConvBatchNormReLU().to(memory_format=memory_format).train(train)
+        opt = torch.optim.SGD(model.parameters(), lr=0.01)
+        model, opt = ipex.optimize(model, optimizer=opt, dtype=torch.float)
+
+        fused_model = copy.deepcopy(model)
+        fused_model.conv = ipex.nn.modules.IPEXConvBatchNormReLU(fused_model.conv, fused_model.bn)
+        fused_model.bn = torch.nn.Identity()
+        fused_model.relu = torch.nn.Identity()
+
+        with torch.cpu.amp.autocast(enabled=(dtype == torch.bfloat16)):
+            ref_out = model(x1)
+            out = fused_model(x2)
+        ref_out.sum().backward()
+        out.sum().backward()
+        prec = 1e-2 if dtype == torch.bfloat16 else 1e-5
+        self.assertEqual(out, ref_out, atol=prec, rtol=prec)
+        self.assertEqual(x2.grad, x1.grad, atol=prec, rtol=prec)
+        fused_bn = fused_model.conv.bn
+        self.assertEqual(fused_bn.weight.grad, model.bn.weight.grad, atol=prec, rtol=prec)
+        self.assertEqual(fused_bn.bias.grad, model.bn.bias.grad, atol=prec, rtol=prec)
+        self.assertEqual(fused_model.conv.m.bias.grad, model.conv.bias.grad, atol=prec, rtol=prec)
+        self.assertEqual(fused_bn.running_mean, model.bn.running_mean, atol=prec, rtol=prec)
+        self.assertEqual(fused_bn.running_var, model.bn.running_var, atol=prec, rtol=prec)
+
+    def test_conv_bn_relu(self):
+        for memory_format in [torch.contiguous_format, torch.channels_last]:
+            for dtype in [torch.float, torch.bfloat16]:
+                for train in [True, False]:
+                    self._test_conv_bn_relu(memory_format, dtype, train)
+
+if __name__ == '__main__':
+    test = unittest.main()
@@ -166,6 +166,25 @@ class CPUOPsTester(TestCase):
         self.assertTrue(x3.grad.dtype == torch.bfloat16)
         self.assertEqual(x1.grad, x3.grad)
 
+        # test bfloat16 channels last
+        x5 = x.clone().detach().bfloat16().to(memory_format=torch.channels_last).requires_grad_()
+        y5 = m(x5)
+        y5.mean().backward()
+        self.assertTrue(y5.dtype == torch.bfloat16)
+        self.assertTrue(y5.is_contiguous(memory_format=torch.channels_last))
+        self.assertEqual(y1, y5, prec=0.1)
+        self.assertTrue(x5.grad.is_contiguous(memory_format=torch.channels_last))
+        self.assertEqual(x1.grad, x5.grad)
+
+        # test the running stats of the channels last input of a large mean
+        m1 = nn.BatchNorm2d(100)
+        m2 = copy.deepcopy(m1)
+        x6 = x * 0.1 + 1000
+        m1(x6)
+        m2(x6.to(memory_format=torch.channels_last))
+        self.assertEqual(m1.running_mean, m2.running_mean)
+        self.assertEqual(m1.running_var, m2.running_var, prec=1e-4)
+
         # test autocast
         with torch.cpu.amp.autocast():
             for datatype in (torch.bfloat16, torch.float32):
@@ -209,6 +228,20 @@ class CPUOPsTester(TestCase):
                 self.assertTrue(y4.dtype == datatype)
                 self.assertTrue(x4.grad.dtype == datatype)
 
+    def test_adaptive_avg_pool2d_channels_last(self):
+        # the global pooling, with the channels not of the vector size, and
+        # the 7x7 pooling of the bins not of the same size
+        for output_size, input_size in [((1, 1), (7, 7)), ((7, 7), (15, 10))]:
+            for batch_size, channels in [(1, 67), (4, 2048)]:
+                x = torch.randn(batch_size, channels, *input_size)
+                y = torch.ops.aten._adaptive_avg_pool2d(x, output_size)
+                for datatype, prec in [(torch.float32, 1e-5), (torch.bfloat16, 0.02)]:
+                    x1 = x.clone().to(datatype).to(memory_format=torch.channels_last)
+                    y1 = torch.ops.aten._adaptive_avg_pool2d(x1, output_size)
+                    self.assertTrue(y1.is_contiguous(memory_format=torch.channels_last))
+                    self.assertEqual(y1.dtype, datatype)
+                    self.assertEqual(y, y1.float(), prec=prec)
+
     def test_copy(self):
         x = torch.randn(3, 64, 8, 9)
         y = torch.empty(3, 64, 8, 9)
@@ -227,6 +260,43 @@ class CPUOPsTester(TestCase):
         self.assertTrue(y2.dtype == torch.bfloat16)
         self.assertEqual(x, y2, prec=0.01)
 
+    def test_permute_copy(self):
+        # the NCHW <-> NHWC copies and the other copies of which the innermost
+        # dimension of src is not the one of self, of the blocks and of the
+        # remainders of them
+        x = torch.randn(2, 67, 9, 13)
+        for dtype in [torch.float, torch.bfloat16, torch.int8, torch.uint8, torch.int32, torch.double]:
+            src = (x * 10).to(dtype)
+            for y in [src.contiguous(memory_format=torch.channels_last),
+                      src.permute(0, 2, 3, 1).contiguous(),
+                      src.transpose(1, 3).contiguous(),
+                      src.permute(3, 1, 0, 2).contiguous()]:
+                self.assertEqual(y.to(torch.double), src.to(torch.double), prec=0)
+                self.assertEqual(y.contiguous(), src.contiguous(), prec=0)
+                out = torch.empty_like(src, memory_format=torch.channels_last)
+                out.copy_(y)
+                self.assertEqual(out, src, prec=0)
+        # the 2D transpose of the non-temporal stores
+        z = torch.randn(2900, 2900)
+        self.assertEqual(z.t().contiguous(), z.t(), prec=0)
+
+    def test_stream_store(self):
+        # the outputs beyond half of the LLC are written by the non-temporal
+        # stores, of the heads and the tails not aligned to the cache lines
+        numel = ipex._C._get_cpu_info()['stream_store_min_bytes'] // 4 + 1000
+        x = torch.randn(numel + 7)
+        for offset in [0, 3]:
+            src = x[offset:offset + numel]
+            y = torch.empty(numel + 7)[7 - offset:7 - offset + numel]
+            y.copy_(src)
+            self.assertEqual(y, src, prec=0)
+        # the channels last upsample nearest
+        c = 67
+        x = torch.randn(1, c, 4, numel // (c * 16) + 1).to(memory_format=torch.channels_last)
+        y = F.interpolate(x, scale_factor=2, mode='nearest')
+        self.assertTrue(y.is_contiguous(memory_format=torch.channels_last))
+        self.assertEqual(y, F.interpolate(x.contiguous(), scale_factor=2, mode='nearest'), prec=0)
+
     def test_max_pool2d(self):
         m = nn.MaxPool2d((3, 2), stride=(2, 1))
         x = torch.randn(20, 16, 50, 32)
@@ -399,6 +469,40 @@ class CPUOPsTester(TestCase):
                 self.assertTrue(y4.dtype == datatype)
                 self.assertTrue(x4.grad.dtype == datatype)
 
+    def test_upsample_bicubic2d(self):
+        x = torch.randn(2, 20, 12, 12)
+        for align_corners in [True, False]:
+            for output_size in [(30, 25), (7, 9)]:
+                y1 = F.interpolate(x, size=output_size, mode='bicubic', align_corners=align_corners)
+
+                # test channels last
+                x2 = x.clone().detach().to(memory_format=torch.channels_last)
+                y2 = F.interpolate(x2, size=output_size, mode='bicubic', align_corners=align_corners)
+                self.assertTrue(y2.is_contiguous(memory_format=torch.channels_last))
+                self.assertEqual(y1, y2)
+
+                # test bfloat16 channels last
+                x3 = x2.bfloat16()
+                y3 = F.interpolate(x3, size=output_size, mode='bicubic', align_corners=align_corners)
+                self.assertTrue(y3.dtype == torch.bfloat16)
+                self.assertTrue(y3.is_contiguous(memory_format=torch.channels_last))
+                self.assertEqual(y1, y3, prec=0.05)
+
+    def test_upsample_bilinear2d_channels_last_large(self):
+        # more output rows than a tile of the separable kernel, and channels
+        # not a multiple of the vector size
+        x = torch.randn(2, 67, 40, 60)
+        for align_corners in [True, False]:
+            for scale_factor in [4, 0.5]:
+                y1 = F.interpolate(x, scale_factor=scale_factor, mode='bilinear', align_corners=align_corners)
+                x2 = x.to(memory_format=torch.channels_last)
+                y2 = F.interpolate(x2, scale_factor=scale_factor, mode='bilinear', align_corners=align_corners)
+                self.assertTrue(y2.is_contiguous(memory_format=torch.channels_last))
+                self.assertEqual(y1, y2)
+                y3 = F.interpolate(x2.bfloat16(), scale_factor=scale_factor, mode='bilinear', align_corners=align_corners)
+                self.assertTrue(y3.is_contiguous(memory_format=torch.channels_last))
+                self.assertEqual(y1, y3, prec=0.05)
+
     def test_upsample_trilinear3d(self):
         x = torch.randn(2, 2, 2, 4, 4)
         x1 = x.clone().detach().requires_grad_()
@@ -502,6 +606,21 @@ class CPUOPsTester(TestCase):
             y2 = torchvision.ops.nms(boxes.bfloat16(), scores.bfloat16(), 0.5)
             self.assertEqual(y1, y2)
 
+    @skipIfNoTorchVision
+    def test_batched_nms(self):
+        # the groups of several images and classes, of the sizes of a single and of several mask blocks
+        for num_boxes, num_groups in [(200, 8), (3000, 3), (50, 1)]:
+            boxes = torch.rand(num_boxes, 4) * 100
+            boxes[:, 2:] += boxes[:, :2]
+            scores = torch.rand(num_boxes)
+            idxs = torch.randint(0, num_groups, (num_boxes,))
+            for iou_threshold in [0.5, 0.7]:
+                ref = torchvision.ops.batched_nms(boxes, scores, idxs, iou_threshold)
+                y = ipex.nn.functional.batched_nms(boxes, scores, idxs, iou_threshold)
+                self.assertEqual(y, ref)
+        empty = torch.empty(0, 4)
+        self.assertEqual(ipex.nn.functional.batched_nms(empty, torch.empty(0), torch.empty(0).long(), 0.5).numel(), 0)
+
 
 if __name__ == '__main__':
     test = unittest.main()
@@ -55,5 +55,38 @@ class TestCumSum(TestCase):
         # Check that output maintained correct shape
         self.assertEqual(raw_tensor.shape, raw_tensor.grad.shape)
 
+    def test_cumsum_dims(self):
+        # the non-last dims of the outer parallel and of the chunks of the
+        # scanned dim, and the small rows of the last dim
+        for shape in [[3, 5, 7], [100000, 3], [2, 50000, 2], [50000, 6], [1, 40000, 1]]:
+            for dtype in [torch.float, torch.double, torch.int32, torch.int64]:
+                x = (torch.rand(shape) * 10).to(dtype)
+                for dim in range(len(shape)):
+                    res = torch.ops.torch_ipex.cumsum(x, dim, dtype=dtype)
+                    ref = torch.cumsum(x.double(), dim).to(dtype)
+                    prec = 0 if dtype in [torch.int32, torch.int64] else 1e-3 * shape[dim]
+                    self.assertEqual(res, ref, prec=prec)
+                    y = x.clone()
+                    torch.ops.torch_ipex.cumsum_(y, dim, dtype=dtype)
+                    self.assertEqual(y, res, prec=0)
+
+    def test_lengths_to_offsets(self):
+        for n in [0, 1, 10, 300000]:
+            for dtype in [torch.int32, torch.int64]:
+                lengths = torch.randint(0, 5, (n,), dtype=dtype)
+                ref = torch.cat([torch.zeros(1, dtype=torch.int64), lengths.cumsum(0)])
+                offsets = torch.ops.torch_ipex.lengths_to_offsets(lengths)
+                self.assertEqual(offsets.dtype, dtype)
+                self.assertEqual(offsets, ref.to(dtype), prec=0)
+                offsets = torch.ops.torch_ipex.lengths_to_offsets(lengths, False, dtype=torch.int64)
+                self.assertEqual(offsets.dtype, torch.int64)
+                self.assertEqual(offsets, ref[:-1], prec=0)
+        # the non-contiguous lengths
+        lengths = torch.randint(0, 5, (4, 100), dtype=torch.int64)
+        self.assertEqual(
+            torch.ops.torch_ipex.lengths_to_offsets(lengths[:, 3]),
+            torch.cat([torch.zeros(1, dtype=torch.int64), lengths[:, 3].cumsum(0)]),
+            prec=0)
+
 if __name__ == '__main__':
     test = unittest.main()
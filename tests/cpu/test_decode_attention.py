@@ -0,0 +1,63 @@
+import unittest
+import math
+import torch
+import intel_extension_for_pytorch as ipex
+from torch.testing._internal.common_utils import TestCase
+import itertools
+
+def _ref_attention(query, keys, values, scale):
+    # query [B, H, D] over keys and values [B, H, L, D]
+    scores = torch.einsum('bhd,bhld->bhl', query.float(), keys.float()) * scale
+    return torch.einsum('bhl,bhld->bhd', scores.softmax(-1), values.float())
+
+class TestDecodeAttention(TestCase):
+
+    def _test_decode_attention(self, dtype, cache_dtype, head_dim, block_size):
+        batch_size, num_heads, prompt_len, steps = 2, 3, 5, 20
+        cache = ipex.nn.modules.PagedKVCache(
+            batch_size, num_heads, head_dim, prompt_len + steps, block_size, cache_dtype)
+        keys = torch.randn(batch_size, num_heads, prompt_len, head_dim).to(dtype)
+        values = torch.randn(batch_size, num_heads, prompt_len, head_dim).to(dtype)
+        cache.prefill(keys, values)
+        if cache_dtype == torch.int8:
+            prec = 5e-2
+        elif dtype == torch.bfloat16 or cache_dtype == torch.bfloat16:
+            prec = 2e-2
+        else:
+            prec = 1e-5
+        for _ in range(steps):
+            query = torch.randn(batch_size, num_heads, head_dim).to(dtype)
+            key = torch.randn(batch_size, num_heads, head_dim).to(dtype)
+            value = torch.randn(batch_size, num_heads, head_dim).to(dtype)
+            keys = torch.cat([keys, key.unsqueeze(2)], 2)
+            values = torch.cat([values, value.unsqueeze(2)], 2)
+            out = cache.decode(query, key, value)
+            self.assertEqual(out.dtype, dtype)
+            ref_out = _ref_attention(query, keys, values, 1.0 / math.sqrt(head_dim))
+            self.assertEqual(out.float(), ref_out, atol=prec, rtol=prec)
+        self.assertEqual(cache.seq_lens, torch.full([batch_size], prompt_len + steps, dtype=torch.long))
+
+    def test_decode_attention(self):
+        # the vectorized heads and the ones with a tail, and the blocks filled
+        # or not at the end of the sequences
+        for dtype, cache_dtype, head_dim, block_size in itertools.product(
+                [torch.float, torch.bfloat16], [torch.float, torch.bfloat16, torch.int8], [64, 40], [16, 7]):
+            self._test_decode_attention(dtype, cache_dtype, head_dim, block_size)
+
+    def test_decode_attention_block_table(self):
+        # the blocks of the sequences in any order of the shared caches
+        cache = ipex.nn.modules.PagedKVCache(2, 2, 32, 16, 4)
+        cache.block_table = cache.block_table.flip(0).flip(1).contiguous()
+        keys = torch.empty(2, 2, 0, 32)
+        values = torch.empty(2, 2, 0, 32)
+        for _ in range(16):
+            query, key, value = torch.randn(3, 2, 2, 32).unbind(0)
+            keys = torch.cat([keys, key.unsqueeze(2)], 2)
+            values = torch.cat([values, value.unsqueeze(2)], 2)
+            out = cache.decode(query, key, value)
+            self.assertEqual(out, _ref_attention(query, keys, values, 1.0 / math.sqrt(32)), atol=1e-5, rtol=1e-5)
+        with self.assertRaises(RuntimeError):
+            cache.decode(query, key, value)
+
+if __name__ == '__main__':
+    test = unittest.main()
@@ -0,0 +1,79 @@
+import torch
+import torch.nn as nn
+import torch.distributed as dist
+import torch.multiprocessing as mp
+import unittest
+import copy
+import os
+import tempfile
+from torch.testing._internal.common_utils import TestCase
+from intel_extension_for_pytorch.nn.modules import MergedEmbeddingBagWithSGD, DistributedMergedEmbeddingBagWithSGD
+from intel_extension_for_pytorch.nn.modules.distributed_merged_embeddingbag import shard_tables
+
+WORLD_SIZE = 2
+BATCH_SIZE = 3
+
+def _tables():
+    torch.manual_seed(0)
+    return [
+        nn.EmbeddingBag(100, 16, mode='mean'),
+        nn.EmbeddingBag(50, 32, mode='sum'),
+        nn.EmbeddingBag(200, 8, mode='sum', include_last_offset=True),
+    ]
+
+def _input(rank):
+    # the bags of each rank differ, the last table of 2-D indices
+    generator = torch.Generator().manual_seed(rank + 1)
+    indices = [
+        torch.randint(100, (7,), generator=generator),
+        torch.randint(50, (BATCH_SIZE, 2), generator=generator),
+        torch.randint(200, (5,), generator=generator),
+    ]
+    offsets = [torch.LongTensor([0, 2, 2]), None, torch.LongTensor([0, 1, 4, 5])]
+    return (indices, offsets, [False, False, True])
+
+def _run_rank(rank, init_file, result_file):
+    dist.init_process_group(
+        "gloo", init_method="file://" + init_file, rank=rank, world_size=WORLD_SIZE)
+    model = DistributedMergedEmbeddingBagWithSGD.from_embeddingbag_list(_tables(), lr=0.1)
+    request = model.forward_async(_input(rank))
+    outputs = request.wait()
+    loss = sum([out.sum() * (i + 1) for i, out in enumerate(outputs)])
+    loss.backward()
+    torch.save({
+        "outputs": [out.detach() for out in outputs],
+        "tables": model.local_tables,
+        "weights": [w.detach() for w in model.merged_emb.weights],
+    }, "{}.{}".format(result_file, rank))
+    dist.destroy_process_group()
+
+class TestDistributedMergedEmbeddingBag(TestCase):
+    def test_shard_tables(self):
+        specs = [(100, 16, 'sum', torch.float, None), (1000, 16, 'sum', torch.float, None),
+                 (100, 64, 'sum', torch.bfloat16, None), (10, 8, 'sum', torch.float, None)]
+        self.assertEqual(shard_tables(specs, 2), [[1], [0, 2, 3]])
+        self.assertEqual(shard_tables(specs, 1), [[0, 1, 2, 3]])
+
+    @unittest.skipIf(not dist.is_available(), "torch.distributed is not available")
+    def test_training(self):
+        with tempfile.TemporaryDirectory() as path:
+            result_file = os.path.join(path, "result")
+            mp.spawn(_run_rank, args=(os.path.join(path, "init"), result_file), nprocs=WORLD_SIZE)
+            results = [torch.load("{}.{}".format(result_file, rank)) for rank in range(WORLD_SIZE)]
+
+        # the reference holds all the tables and pools the bags of all the ranks
+        ref = MergedEmbeddingBagWithSGD.from_embeddingbag_list(_tables(), lr=0.1)
+        inputs = [_input(rank) for rank in range(WORLD_SIZE)]
+        for rank in range(WORLD_SIZE):
+            ref_outputs = ref(copy.deepcopy(inputs[rank]))
+            for output, ref_output in zip(results[rank]["outputs"], ref_outputs):
+                self.assertEqual(output, ref_output)
+        ref_outputs = [ref(input) for input in inputs]
+        loss = sum([out.sum() * (i + 1) for outputs in ref_outputs for i, out in enumerate(outputs)])
+        loss.backward()
+        for result in results:
+            for table, weight in zip(result["tables"], result["weights"]):
+                self.assertEqual(weight, ref.weights[table])
+
+if __name__ == '__main__':
+    test = unittest.main()
@@ -1,49 +1,63 @@
-import math
-import random
-import unittest
-from functools import reduce
-import warnings
-
-import torch
-import torch.nn as nn
-from torch.fx import GraphModule
-import copy
-
-import intel_extension_for_pytorch as ipex
-
-from common_utils import TestCase
-from torch.testing import FileCheck
-
-class Net(nn.Module):
-    def __init__(self):
-        super(Net, self).__init__()
-        self.dropout = nn.Dropout(0.5)
-
-    def forward(self, x):
-        return self.dropout(x)
-
-class DropoutTester(TestCase):
-    def test_remove_dropout_jit(self):
-        model = Net().eval()
-        x = torch.randn(2, 3)
-        with torch.no_grad():
-            trace_model = torch.jit.trace(model, x).eval()
-            frozen_mod = torch.jit.freeze(trace_model)
-            y = trace_model(x)
-            self.assertEqual(x, y)
-            FileCheck().check_not("aten::dropout").run(trace_model.graph)
-
-    def test_replace_dropout_with_identity(self):
-        model = Net().eval()
-        optimized_model = ipex.optimize(model)
-        x = torch.randn(2, 3)
-        named_children = dict(optimized_model.named_children())
-        self.assertTrue(isinstance(named_children['dropout'], torch.nn.Identity))
-
-        optimized_model = ipex.optimize(model, replace_dropout_with_identity=False)
-        named_children = dict(optimized_model.named_children())
-        self.assertTrue(isinstance(named_children['dropout'], torch.nn.Dropout))
-
-
-if __name__ == '__main__':
-    test = unittest.main()
+import unittest
+import torch
+import torch.nn.functional as F
+import intel_extension_for_pytorch as ipex
+from torch.testing._internal.common_utils import TestCase
+import itertools
+
+class TestDropout(TestCase):
+
+    def test_dropout(self):
+        # both of the whole vectors and a tail
+        for dtype, numel, p in itertools.product([torch.float, torch.bfloat16], [64 * 1024, 4099], [0.1, 0.5]):
+            x = torch.randn(numel).to(dtype).requires_grad_()
+            out = ipex.nn.functional.dropout(x, p, True)
+            self.assertEqual(out.dtype, dtype)
+            kept = out != 0
+            scale = 1 / (1 - p)
+            prec = 2e-2 if dtype == torch.bfloat16 else 1e-5
+            self.assertEqual(out[kept].float(), x[kept].float() * scale, atol=prec, rtol=prec)
+            # the kept elements are of the probability 1 - p
+            self.assertEqual(kept.float().mean().item(), 1 - p, atol=3e-2, rtol=0)
+
+            grad = torch.randn(numel).to(dtype)
+            out.backward(grad)
+            self.assertEqual(x.grad.float(), grad.float() * kept.float() * scale, atol=prec, rtol=prec)
+
+    def test_dropout_seed(self):
+        x = torch.randn(8, 1000)
+        torch.manual_seed(0)
+        out = ipex.nn.functional.dropout(x, 0.3, True)
+        torch.manual_seed(0)
+        self.assertEqual(ipex.nn.functional.dropout(x, 0.3, True), out)
+        # the rows are not of the same mask
+        self.assertNotEqual(out[0] != 0, out[1] != 0)
+
+    def test_dropout_no_op(self):
+        x = torch.randn(4, 100)
+        self.assertEqual(ipex.nn.functional.dropout(x, 0.5, False), x)
+        self.assertEqual(ipex.nn.functional.dropout(x, 0.0, True), x)
+        self.assertEqual(ipex.nn.functional.dropout(x, 1.0, True), torch.zeros(4, 100))
+
+    def test_bias_dropout_add_layer_norm_mask(self):
+        # the fused op draws the same mask of the seed as the dropout
+        x = torch.randn(16, 96)
+        residual = torch.randn(16, 96)
+        torch.manual_seed(0)
+        out = torch.ops.torch_ipex.bias_dropout_add_layer_norm(
+            x, None, residual, 0.2, True, [96], None, None, 1e-5)
+        torch.manual_seed(0)
+        ref_out = F.layer_norm(ipex.nn.functional.dropout(x, 0.2, True) + residual, [96])
+        self.assertEqual(out, ref_out, atol=1e-4, rtol=1e-4)
+
+    def test_optimize_dropout(self):
+        model = torch.nn.Sequential(torch.nn.Linear(16, 16), torch.nn.Dropout(0.1)).train()
+        optimizer = torch.optim.SGD(model.parameters(), lr=0.1)
+        ipex_model, _ = ipex.optimize(model, optimizer=optimizer)
+        self.assertTrue(isinstance(ipex_model[1], ipex.nn.utils._model_convert._Dropout))
+        ipex_model(torch.randn(4, 16)).sum().backward()
+        traced = torch.jit.trace(ipex_model.eval(), torch.randn(4, 16))
+        self.assertEqual(traced(torch.ones(4, 16)), ipex_model(torch.ones(4, 16)))
+
+if __name__ == '__main__':
+    test = unittest.main()
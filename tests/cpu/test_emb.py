@@ -4,6 +4,29 @@ import unittest
 import copy
 from common_utils import TestCase
 
+def torch_embedding_bag_ref(emb, input, offsets, per_sample_weights):
+    # the aten embedding bag of the module, of the bags pooled one by one
+    ends = offsets.tolist()[1:] + [input.numel()]
+    outs = []
+    for begin, end in zip(offsets.tolist(), ends):
+        bag = [i for i in range(begin, end) if input[i] != emb.padding_idx]
+        if not bag:
+            outs.append(emb.weight.sum(0) * 0)
+            continue
+        rows = emb.weight[input[bag]]
+        if per_sample_weights is not None:
+            rows = rows * per_sample_weights[bag].unsqueeze(1)
+        if emb.mode == 'sum':
+            outs.append(rows.sum(0))
+        elif emb.mode == 'mean':
+            outs.append(rows.mean(0))
+        else:
+            outs.append(rows.max(0)[0])
+    return torch.stack(outs)
+
+def to_dense(grad):
+    return grad.to_dense() if grad.is_sparse else grad
+
 class TestEMB(TestCase):
     def _test_emb(self, mode):
         #E = nn.EmbeddingBag(10, 5, mode="sum", sparse=True)
@@ -44,5 +67,64 @@ class TestEMB(TestCase):
     def test_emb_fast_path(self):
         self._test_emb(mode='sum')
 
+    def test_emb_dense_backward(self):
+        # the rows of the repeated indices, of the bags split across the
+        # chunks of the threads, of a table larger than the batch
+        import intel_extension_for_pytorch
+        for dtype in [torch.float, torch.bfloat16]:
+            aten_emb = nn.EmbeddingBag(100000, 17, mode='sum')
+            ipex_emb = copy.deepcopy(aten_emb).to(dtype)
+            input = torch.cat([torch.zeros(300, dtype=torch.long), torch.randint(0, 100000, (700,))])
+            input = input[torch.randperm(input.numel())]
+            offsets = torch.arange(0, 1000, 4)
+            aten_emb(input, offsets).sum().backward()
+            ipex_emb(input, offsets).sum().backward()
+            self.assertEqual(ipex_emb.weight.grad.dtype, dtype)
+            self.assertEqual(aten_emb.weight.grad, ipex_emb.weight.grad.float(), 0.1 if dtype == torch.bfloat16 else 1e-5)
+
+    def test_emb_pooling_modes(self):
+        # mean, max and the per sample weighted sum with padding_idx, of the
+        # bags of the padding only as well, against aten of fp32
+        import intel_extension_for_pytorch
+        input = torch.LongTensor([1, 2, 4, 5, 4, 3, 2, 9, 0, 0, 7])
+        offsets = torch.LongTensor([0, 2, 4, 4, 8, 10])
+        cases = [('mean', False, None), ('mean', True, 0), ('max', False, 0),
+                 ('sum', False, 0), ('sum', True, None)]
+        for dtype in [torch.float, torch.bfloat16]:
+            prec = 0.05 if dtype == torch.bfloat16 else 1e-5
+            for mode, weighted, padding_idx in cases:
+                for sparse in [False, True] if mode != 'max' else [False]:
+                    ref = nn.EmbeddingBag(10, 5, mode=mode, sparse=sparse, padding_idx=padding_idx)
+                    ipex_emb = copy.deepcopy(ref).to(dtype)
+                    psw = torch.rand(input.numel()) if weighted else None
+                    ref_psw = psw.clone().requires_grad_() if weighted else None
+                    ipex_psw = psw.to(dtype).requires_grad_() if weighted else None
+                    with torch.no_grad():
+                        ipex_emb.weight.copy_(ref.weight)
+                    ref_out = torch_embedding_bag_ref(ref, input, offsets, ref_psw)
+                    ipex_out = ipex_emb(input, offsets, per_sample_weights=ipex_psw)
+                    self.assertEqual(ipex_out.dtype, dtype)
+                    self.assertEqual(ref_out, ipex_out.float(), prec)
+                    ref_out.sum().backward()
+                    ipex_out.sum().backward()
+                    self.assertEqual(ref.weight.grad, to_dense(ipex_emb.weight.grad).float(), prec)
+                    if weighted:
+                        self.assertEqual(ref_psw.grad, ipex_psw.grad.float(), prec)
+
+    def test_emb_fast_path_stream_output(self):
+        # the output beyond half of the LLC is written by the non-temporal
+        # stores, of the rows not aligned to the cache lines as well
+        import intel_extension_for_pytorch as ipex
+        ddim = 33
+        bags = ipex._C._get_cpu_info()['stream_store_min_bytes'] // (ddim * 4) + 1
+        with torch.no_grad():
+            for dtype in [torch.float, torch.bfloat16]:
+                emb = nn.EmbeddingBag(100, ddim, mode='sum').to(dtype)
+                input = torch.randint(0, 100, (bags * 2,))
+                offsets = torch.arange(0, bags * 2, 2)
+                out = emb(input, offsets)
+                ref = emb.weight.float().index_select(0, input).view(bags, 2, ddim).sum(1)
+                self.assertEqual(out.float(), ref, 0.01 if dtype == torch.bfloat16 else 1e-5)
+
 if __name__ == '__main__':
     test = unittest.main()
@@ -0,0 +1,44 @@
+import unittest
+import torch
+import torch.nn as nn
+import intel_extension_for_pytorch as ipex
+from common_utils import TestCase
+
+class TestFallbackStats(TestCase):
+    def setUp(self):
+        ipex._C.reset_fallback_stats()
+
+    def test_cumsum(self):
+        x = torch.rand(16, 16)
+        torch.ops.torch_ipex.cumsum(x, 1)
+        torch.ops.torch_ipex.cumsum(x, 0)
+        torch.ops.torch_ipex.cumsum(x.t(), 1)
+        stats = ipex._C.get_fallback_stats()['cumsum']
+        self.assertEqual(stats['fast_path'], 2)
+        self.assertEqual(stats['fallbacks'], {'not_contiguous': 1})
+
+    def test_embedding_bag(self):
+        indices = torch.LongTensor([1, 2, 4, 5, 4, 3, 2, 9])
+        offsets = torch.LongTensor([0, 2, 4, 6])
+        for mode in ['sum', 'mean', 'max']:
+            nn.EmbeddingBag(10, 3, mode=mode)(indices, offsets)
+        nn.EmbeddingBag(10, 3).double()(indices, offsets)
+        stats = ipex._C.get_fallback_stats()['embedding_bag']
+        self.assertEqual(stats['fast_path'], 3)
+        self.assertEqual(stats['fallbacks'], {'unsupported_dtype': 1})
+
+    def test_weight_prepack(self):
+        model = nn.Sequential(nn.Conv2d(3, 8, 3), nn.Flatten(), nn.Linear(8, 4)).eval()
+        ipex.optimize(model, dtype=torch.float32)
+        stats = ipex._C.get_fallback_stats()['weight_prepack']
+        self.assertEqual(stats['fast_path'], 1)
+        self.assertEqual(stats['fallbacks'], {'fp32_linear_mkl': 1})
+
+    def test_reset(self):
+        torch.ops.torch_ipex.cumsum(torch.rand(4, 4), 1)
+        self.assertEqual(ipex._C.get_fallback_stats()['cumsum']['fast_path'], 1)
+        ipex._C.reset_fallback_stats()
+        self.assertEqual(ipex._C.get_fallback_stats()['cumsum']['fast_path'], 0)
+
+if __name__ == '__main__':
+    test = unittest.main()
@@ -3,6 +3,7 @@ import torch
 from torch import nn
 import unittest, copy
 from common_utils import TestCase
+import intel_extension_for_pytorch as ipex
 from intel_extension_for_pytorch.nn import FrozenBatchNorm2d
 
 class FrozenBN2d(nn.Module):
@@ -32,6 +33,19 @@ class FrozenBN2d(nn.Module):
         bias = bias.reshape(1, -1, 1, 1)
         return x * scale + bias
 
+class ConvFrozenBN(nn.Module):
+    def __init__(self, in_channels, out_channels):
+        super(ConvFrozenBN, self).__init__()
+        self.conv = nn.Conv2d(in_channels, out_channels, 3, padding=1)
+        self.bn = FrozenBatchNorm2d(out_channels)
+        self.bn.weight = torch.randn(out_channels)
+        self.bn.bias = torch.randn(out_channels)
+        self.bn.running_mean = torch.randn(out_channels)
+        self.bn.running_var = torch.rand(out_channels) + 0.5
+
+    def forward(self, x):
+        return self.bn(self.conv(x)).relu()
+
 class FrozenBNTester(TestCase):
 
     def test_frozen_batch_norm(self):
@@ -104,6 +118,23 @@ class FrozenBNTester(TestCase):
         self.assertTrue(x2.grad.is_contiguous(memory_format=torch.channels_last))
         self.assertEqual(x2.grad, x1.grad)
 
+    def test_conv_frozen_batch_norm_folding(self):
+        model = ConvFrozenBN(16, 32).eval()
+        x = torch.randn(2, 16, 14, 14)
+        with torch.no_grad():
+            ref = model(x)
+            # eager
+            opt_model = ipex.optimize(model, dtype=torch.float32, level='O1')
+            self.assertFalse(any(isinstance(m, FrozenBatchNorm2d) for m in opt_model.modules()))
+            self.assertEqual(opt_model(x), ref, prec=1e-4)
+            # jit
+            traced_model = torch.jit.freeze(torch.jit.trace(model, x))
+            for _ in range(2):
+                y = traced_model(x)
+            self.assertEqual(y, ref, prec=1e-4)
+            graph = traced_model.graph_for(x)
+            self.assertFalse(any(n.kind() == "torch_ipex::frozen_batch_norm" for n in graph.nodes()))
+            self.assertFalse(any(n.kind() == "ipex::batch_norm" for n in graph.nodes()))
 
 if __name__ == '__main__':
     test = unittest.main()
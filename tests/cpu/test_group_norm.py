@@ -0,0 +1,75 @@
+import unittest
+import torch
+import torch.nn.functional as F
+import intel_extension_for_pytorch as ipex
+from torch.testing._internal.common_utils import TestCase
+import itertools
+
+def _ref_group_norm(x, num_groups, weight, bias, eps):
+    # aten::group_norm is replaced by ipex, so the reference is composed
+    n, c = x.shape[:2]
+    shape = [1, c] + [1] * (x.dim() - 2)
+    y = x.double().reshape(n, num_groups, -1)
+    y = (y - y.mean(-1, keepdim=True)) / torch.sqrt(y.var(-1, unbiased=False, keepdim=True) + eps)
+    y = y.reshape(x.shape)
+    return y * weight.double().reshape(shape) + bias.double().reshape(shape)
+
+class TestGroupNorm(TestCase):
+
+    def _test_group_norm(self, dtype, shape, num_groups, memory_format):
+        x = torch.randn(shape).to(dtype).to(memory_format=memory_format).requires_grad_()
+        weight = torch.randn(shape[1]).requires_grad_()
+        bias = torch.randn(shape[1]).requires_grad_()
+        ref_inputs = [x, weight, bias]
+        inputs = [t.detach().clone().requires_grad_() for t in ref_inputs]
+
+        x, weight, bias = ref_inputs
+        ref_out = _ref_group_norm(x, num_groups, weight, bias, 1e-5)
+        x, weight, bias = inputs
+        out = F.group_norm(x, num_groups, weight, bias, 1e-5)
+        self.assertEqual(out.dtype, dtype)
+        self.assertTrue(out.is_contiguous(memory_format=memory_format))
+
+        grad = torch.randn(shape)
+        ref_out.backward(grad.double())
+        out.backward(grad.to(dtype))
+        prec = 2e-2 if dtype == torch.bfloat16 else 1e-4
+        self.assertEqual(out.double(), ref_out, atol=prec, rtol=prec)
+        self.assertEqual(x.grad.double(), ref_inputs[0].grad.double(), atol=prec * 5, rtol=prec)
+        self.assertEqual(weight.grad.double(), ref_inputs[1].grad.double(), atol=prec * 10, rtol=prec)
+        self.assertEqual(bias.grad.double(), ref_inputs[2].grad.double(), atol=prec * 10, rtol=prec)
+
+    def test_group_norm(self):
+        # the vectorized planes and channels and the ones with a tail
+        for dtype, (shape, num_groups), memory_format in itertools.product(
+                [torch.float, torch.bfloat16],
+                [((2, 64, 8, 8), 32), ((2, 70, 5, 7), 7)],
+                [torch.contiguous_format, torch.channels_last]):
+            self._test_group_norm(dtype, shape, num_groups, memory_format)
+
+    def test_group_norm_3d(self):
+        for memory_format in [torch.contiguous_format, torch.channels_last_3d]:
+            self._test_group_norm(torch.float, (2, 40, 3, 4, 5), 8, memory_format)
+
+    def test_instance_norm(self):
+        x = torch.randn(2, 48, 9, 9).to(memory_format=torch.channels_last)
+        m = torch.nn.InstanceNorm2d(48, affine=True)
+        with torch.no_grad():
+            ref_out = m(x)
+            out = F.group_norm(x, 48, m.weight, m.bias, m.eps)
+        self.assertEqual(out, ref_out, atol=1e-4, rtol=1e-4)
+
+    def test_group_norm_silu(self):
+        x = torch.randn(2, 64, 8, 8).to(memory_format=torch.channels_last)
+        weight = torch.randn(64)
+        bias = torch.randn(64)
+        for dtype in [torch.float, torch.bfloat16]:
+            with torch.no_grad():
+                out = torch.ops.torch_ipex.group_norm_silu(x.to(dtype), 32, weight, bias, 1e-5)
+            ref_out = F.silu(_ref_group_norm(x.to(dtype), 32, weight, bias, 1e-5))
+            prec = 2e-2 if dtype == torch.bfloat16 else 1e-4
+            self.assertEqual(out.dtype, dtype)
+            self.assertEqual(out.double(), ref_out, atol=prec, rtol=prec)
+
+if __name__ == '__main__':
+    test = unittest.main()
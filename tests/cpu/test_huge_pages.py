@@ -0,0 +1,56 @@
+import unittest
+
+import torch
+import intel_extension_for_pytorch as ipex
+import intel_extension_for_pytorch._C as core
+from torch.testing._internal.common_utils import TestCase
+
+HUGE_PAGE_SIZE = 2 << 20
+
+class EmbeddingLinear(torch.nn.Module):
+    def __init__(self):
+        super(EmbeddingLinear, self).__init__()
+        self.embedding = torch.nn.EmbeddingBag(4096, 256, mode='sum')
+        self.linear = torch.nn.Linear(256, 4096)
+
+    def forward(self, indices, offsets):
+        return self.linear(self.embedding(indices, offsets))
+
+class TestHugePages(TestCase):
+    def test_to_huge_pages(self):
+        enabled = ipex.is_huge_pages_enabled()
+        try:
+            ipex.enable_huge_pages(True)
+            t = torch.randn(1024, 1024)
+            placed = core._to_huge_pages(t)
+            self.assertEqual(t, placed)
+            if ipex.is_huge_pages_available():
+                self.assertEqual(placed.data_ptr() % HUGE_PAGE_SIZE, 0)
+            # the small tensors are kept
+            small = torch.randn(16)
+            self.assertEqual(core._to_huge_pages(small).data_ptr(), small.data_ptr())
+            ipex.enable_huge_pages(False)
+            self.assertEqual(core._to_huge_pages(t).data_ptr(), t.data_ptr())
+        finally:
+            ipex.enable_huge_pages(enabled)
+
+    def test_optimize_huge_pages(self):
+        enabled = ipex.is_huge_pages_enabled()
+        try:
+            model = EmbeddingLinear().eval()
+            indices = torch.randint(0, 4096, (64,))
+            offsets = torch.arange(0, 64, 8)
+            opt_M = ipex.optimize(model, huge_pages=True)
+            self.assertTrue(ipex.is_huge_pages_enabled())
+            if ipex.is_huge_pages_available():
+                self.assertEqual(opt_M.embedding.weight.data_ptr() % HUGE_PAGE_SIZE, 0)
+            with torch.no_grad():
+                self.assertEqual(model(indices, offsets), opt_M(indices, offsets))
+                traced = torch.jit.freeze(torch.jit.trace(opt_M, (indices, offsets)))
+                for _ in range(2):
+                    self.assertEqual(model(indices, offsets), traced(indices, offsets))
+        finally:
+            ipex.enable_huge_pages(enabled)
+
+if __name__ == '__main__':
+    test = unittest.main()
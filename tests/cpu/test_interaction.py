@@ -1,3 +1,4 @@
+import itertools
 import math
 import random
 import unittest
@@ -42,13 +43,15 @@ class TestInteractionCases(TestCase):
             return R
 
         dtypes=[torch.float32, torch.bfloat16]
-        for dtype in dtypes:
-            x1 = torch.randn([2048, 128]).to(dtype).clone().detach().requires_grad_()
+        # the batch of 37 ends with a partial block of the batched matmul, and
+        # the 40 vectors span more than a block of 32 x 32 of the AMX tiles
+        for dtype, (batch_size, vector_size, num_sparse) in itertools.product(dtypes, [(2048, 128, 26), (37, 48, 26), (37, 64, 39)]):
+            x1 = torch.randn([batch_size, vector_size]).to(dtype).clone().detach().requires_grad_()
             x2 = x1.clone().detach().requires_grad_()
             ly1 = []
             ly2 = []
-            for i in range(0, 26):
-                V = torch.randn([2048, 128]).to(dtype).clone().detach().requires_grad_()
+            for i in range(0, num_sparse):
+                V = torch.randn([batch_size, vector_size]).to(dtype).clone().detach().requires_grad_()
                 ly1.append(V)
                 ly2.append(V.clone().detach().requires_grad_())
 
@@ -59,7 +62,7 @@ class TestInteractionCases(TestCase):
             A.sum().backward()
             B.sum().backward()
             torch.testing.assert_allclose(x1.grad, x2.grad, rtol=0.005, atol=0.1)
-            for i in range(0, 26):
+            for i in range(0, num_sparse):
                 torch.testing.assert_allclose(ly1[i].grad, ly2[i].grad, rtol=0.005, atol=0.1)
 
 if __name__ == '__main__':
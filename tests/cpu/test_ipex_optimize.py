@@ -5,6 +5,9 @@ from torch.testing._internal.common_utils import TestCase
 import unittest
 import itertools
 import copy
+import json
+import os
+import tempfile
 from common_utils import TestModule
 
 class ConvBatchNorm(torch.nn.Module):
@@ -135,6 +138,48 @@ class TestOptimizeCases(TestCase):
         tensor = torch.rand(128, 256, 1, 1).to(memory_format=torch.channels_last)
         self._test_tensor_convert(tensor, tensor.bfloat16())
 
+    def test_tensor_convert_out(self):
+        # the halves and the float tensor are written in place of the given ones, of the dense layouts
+        # without the contiguous copies and of the strided ones through them
+        tensor = torch.rand(100, 100)
+        for t in [tensor, tensor.t(), tensor[2:5, 2:5], torch.rand(8, 16, 3, 3).to(memory_format=torch.channels_last)]:
+            top_half = torch.empty_like(t, dtype=torch.bfloat16)
+            bot_half = torch.empty_like(t, dtype=torch.bfloat16)
+            top_ptr, bot_ptr = top_half.data_ptr(), bot_half.data_ptr()
+            torch.ops.torch_ipex.split_float_bfloat16_out(t, top_half, bot_half)
+            ref_top, ref_bot = torch.ops.torch_ipex.split_float_bfloat16(t)
+            self.assertEqual(top_half, ref_top)
+            self.assertEqual(bot_half, ref_bot)
+            self.assertEqual(top_ptr, top_half.data_ptr())
+            self.assertEqual(bot_ptr, bot_half.data_ptr())
+            out = torch.empty_like(t)
+            out_ptr = out.data_ptr()
+            res = torch.ops.torch_ipex.cat_bfloat16_float_out(top_half, bot_half, out)
+            self.assertEqual(out, t, prec=0)
+            self.assertEqual(out_ptr, res.data_ptr())
+        # the halves of another layout than the float tensor
+        top_half = torch.empty(100, 100, dtype=torch.bfloat16).t()
+        bot_half = torch.empty(100, 100, dtype=torch.bfloat16)
+        torch.ops.torch_ipex.split_float_bfloat16_out(tensor, top_half, bot_half)
+        self.assertEqual(torch.ops.torch_ipex.cat_bfloat16_float(top_half, bot_half), tensor, prec=0)
+
+    def test_cast_to_bfloat16_batch(self):
+        tensors = [torch.rand(100, 100), torch.rand(0), torch.rand(3),
+                   torch.rand(8, 16, 3, 3).to(memory_format=torch.channels_last), torch.rand(64, 64).t()[::2]]
+        for numa_node_id in [-1, 0]:
+            top_halves, bot_halves = torch.ops.torch_ipex.cast_to_bfloat16_batch(tensors, True, numa_node_id)
+            for t, top_half, bot_half in zip(tensors, top_halves, bot_halves):
+                ref_top, ref_bot = torch.ops.torch_ipex.split_float_bfloat16(t.contiguous())
+                self.assertEqual(top_half, ref_top, prec=0)
+                self.assertEqual(bot_half, ref_bot, prec=0)
+                if t.is_contiguous(memory_format=torch.channels_last):
+                    self.assertEqual(top_half.stride(), t.stride())
+            bf16_tensors, trails = torch.ops.torch_ipex.cast_to_bfloat16_batch(tensors, False, numa_node_id)
+            self.assertEqual(len(trails), 0)
+            for t, bf16_tensor in zip(tensors, bf16_tensors):
+                self.assertEqual(bf16_tensor.dtype, torch.bfloat16)
+                self.assertEqual(bf16_tensor, t.bfloat16(), prec=0)
+
     def test_module_conversion(self):
         M_ori = TestModule()
         options = itertools.product([torch.bfloat16, torch.float32], ["O0", "O1"], [True, False])
@@ -151,5 +196,56 @@ class TestOptimizeCases(TestCase):
               self.assertTrue(isinstance(opt_M.linear, _IPEXLinear))
               self.assertTrue(isinstance(opt_M.conv, _IPEXConv2d))
 
+    def test_auto_kernel_selection_with_sample_input(self):
+        M = TestModule().eval()
+        with tempfile.TemporaryDirectory() as tmp:
+            recipe = os.path.join(tmp, 'kernels.json')
+            opt_M = ipex.optimize(M, dtype=torch.float32, auto_kernel_selection=True,
+                                  sample_input=M.input, kernel_selection_recipe=recipe)
+            with open(recipe) as f:
+                layers = json.load(f)['layers']
+            self.assertEqual(set(layers.keys()), {'conv', 'linear'})
+            self.assertEqual(layers['conv']['input_shape'], [10, 1, 5, 5])
+            self.assertEqual(layers['linear']['input_shape'], [10, 5])
+            for name, m in [('conv', opt_M.conv), ('linear', opt_M.linear)]:
+                self.assertEqual(layers[name]['kernel'] == 'aten', type(m) in (torch.nn.Conv2d, torch.nn.Linear))
+            with torch.no_grad():
+                self.assertEqual(M(*M.input), opt_M(*M.input))
+
+            # The recorded kernels are applied without timing the layers again.
+            for name in layers:
+                layers[name]['kernel'] = 'aten'
+            with open(recipe, 'w') as f:
+                json.dump({'version': 1, 'layers': layers}, f)
+            opt_M = ipex.optimize(M, dtype=torch.float32, auto_kernel_selection=True,
+                                  sample_input=M.input, kernel_selection_recipe=recipe)
+            self.assertTrue(type(opt_M.conv) is torch.nn.Conv2d)
+            self.assertTrue(type(opt_M.linear) is torch.nn.Linear)
+
+    def test_optimize_memory_format_auto(self):
+        class ConvPoolFlatten(torch.nn.Module):
+            def __init__(self):
+                super(ConvPoolFlatten, self).__init__()
+                self.conv = torch.nn.Conv2d(3, 16, kernel_size=3, padding=1)
+                self.pool = torch.nn.MaxPool2d(2)
+                self.conv1 = torch.nn.Conv2d(16, 16, kernel_size=3, padding=1)
+
+            def forward(self, x):
+                return self.conv1(self.pool(self.conv(x)))
+
+        model = ConvPoolFlatten().eval()
+        x = torch.randn(2, 3, 16, 16)
+        opt_M = ipex.optimize(model, memory_format="auto", sample_input=x)
+        # the model runs in channels_last end to end with the plain input
+        self.assertEqual(opt_M.memory_format_report, [])
+        with torch.no_grad():
+            y = opt_M(x)
+            self.assertTrue(y.is_contiguous(memory_format=torch.channels_last))
+            self.assertEqual(model(x), y, rtol=1e-4, atol=1e-4)
+        # the original model is kept
+        self.assertTrue(model.conv.weight.is_contiguous())
+        with self.assertRaises(RuntimeError):
+            ipex.optimize(model, memory_format="channels_first")
+
 if __name__ == '__main__':
     test = unittest.main()
@@ -0,0 +1,53 @@
+import unittest
+from common_utils import TestCase
+import os
+import subprocess
+import intel_extension_for_pytorch as ipex
+
+class TestISADispatch(TestCase):
+    def _run_with_isa(self, isa):
+        loc = os.path.dirname(os.path.abspath(__file__))
+        env = dict(os.environ, IPEX_CPU_CAPABILITY=isa)
+        level, max_diff = None, None
+        with subprocess.Popen('python -u {}/isa_dispatch.py'.format(loc), shell=True, env=env, stdout=subprocess.PIPE, stderr=subprocess.STDOUT) as p:
+            for line in p.stdout.readlines():
+                line = str(line, 'utf-8').strip()
+                if line.startswith("isa_level:"):
+                    level = line.split(":")[1].strip()
+                if line.startswith("max_diff:"):
+                    max_diff = float(line.split(":")[1])
+        return level, max_diff
+
+    def test_isa_levels(self):
+        # the kernels of each level give the same result, of which the level is
+        # capped by IPEX_CPU_CAPABILITY but never raised above the CPU
+        expected = {'default': 'DEFAULT'}
+        if ipex._C._does_support_avx2():
+            expected['avx2'] = 'AVX2'
+        if ipex._C._does_support_avx512():
+            expected['avx512'] = 'AVX512'
+        for isa, level in expected.items():
+            actual_level, max_diff = self._run_with_isa(isa)
+            self.assertEqual(actual_level, level)
+            self.assertTrue(max_diff is not None and max_diff < 1e-5)
+
+    def test_current_isa_level(self):
+        level = ipex._C._get_current_isa_level()
+        self.assertTrue(level in ['DEFAULT', 'AVX2', 'AVX512', 'AVX512_BF16', 'AMX'])
+        if ipex._C._does_support_avx512():
+            self.assertTrue(level not in ['DEFAULT', 'AVX2'])
+
+    def test_cpu_info(self):
+        info = ipex._C._get_cpu_info()
+        self.assertTrue(info['micro_arch'] in ['generic', 'skylake_x', 'cooper_lake', 'icelake_x', 'sapphire_rapids', 'emerald_rapids'])
+        self.assertTrue(info['threads_per_core'] >= 1)
+        self.assertTrue(info['l1d_size'] >= 0 and info['l2_size'] >= 0)
+        for key in ['emb_prefetch_lines', 'emb_max_prefetch_distance', 'interaction_block_size', 'cumsum_chunk_bytes', 'online_softmax_min_size', 'op_min_work_per_thread', 'stream_store_min_bytes']:
+            self.assertTrue(info[key] > 0)
+        if not ipex._C._does_support_avx512():
+            self.assertEqual(info['avx512_fma_units'], 0)
+        # the thread policy defaults to the tuning of the CPU
+        self.assertEqual(ipex.cpu.runtime.get_op_min_work_per_thread('softmax'), info['op_min_work_per_thread'])
+
+if __name__ == '__main__':
+    test = unittest.main()
@@ -49,10 +49,11 @@ All rights reserved.
 
 """Tests for rn50."""
 
+import io
 import math
 import random
 import unittest
-from functools import reduce
+from functools import reduce, partial
 import warnings
 import itertools
 
@@ -144,6 +145,37 @@ class Conv_Conv_Concat(nn.Module):
     def forward(self, x):
         return torch.cat((self.conv1(x),self.conv2(x)))
 
+class BatchNorm_Eltwise_Chain(nn.Module):
+    def __init__(self, channels):
+        super(BatchNorm_Eltwise_Chain, self).__init__()
+        self.bn = nn.BatchNorm2d(channels)
+
+    def forward(self, x, residual):
+        x = self.bn(x) + residual
+        # swish, then scaled
+        return x * torch.sigmoid(x) * 0.5
+
+class Transcendental_Eltwise_Chain(nn.Module):
+    def __init__(self):
+        super(Transcendental_Eltwise_Chain, self).__init__()
+
+    def forward(self, x, y):
+        return F.gelu(x + y) * torch.tanh(x) + F.silu(y) * torch.exp(x * 0.1)
+
+class ConvRelu_Chain(nn.Module):
+    def __init__(self, dim, in_channels, out_channels, **kwargs):
+        super(ConvRelu_Chain, self).__init__()
+        seed = 2018
+        torch.manual_seed(seed)
+        self.conv1 = conv_module[dim](in_channels, out_channels, **kwargs)
+        self.conv2 = conv_module[dim](out_channels, out_channels, **kwargs)
+        self.conv3 = conv_module[dim](out_channels, out_channels, **kwargs)
+
+    def forward(self, x):
+        x = F.relu(self.conv1(x))
+        x = F.relu(self.conv2(x))
+        return F.relu(self.conv3(x))
+
 class ConvRelu_Fixed(nn.Module):
     def __init__(self, dim, in_channels, out_channels, **kwargs):
         super(ConvRelu_Fixed, self).__init__()
@@ -280,6 +312,19 @@ class LinearGelu(nn.Module):
     def forward(self, x):
         return F.gelu(self.linear(x))
 
+class LinearGeluLinear(nn.Module):
+    def __init__(self, in_channels, hidden_channels, residual=False, **kwargs):
+        super(LinearGeluLinear, self).__init__()
+        seed = 2018
+        torch.manual_seed(seed)
+        self.linear = nn.Linear(in_channels, hidden_channels, **kwargs)
+        self.linear1 = nn.Linear(hidden_channels, in_channels, **kwargs)
+        self.residual = residual
+
+    def forward(self, x):
+        y = self.linear1(F.gelu(self.linear(x)))
+        return y + x if self.residual else y
+
 class LinearAdd(nn.Module):
     def __init__(self, in_channels, out_channels, **kwargs):
         super(LinearAdd, self).__init__()
@@ -313,6 +358,17 @@ class LinearSigmoid(nn.Module):
     def forward(self, x):
         return torch.sigmoid(self.linear(x))
 
+class LinearEltwise(nn.Module):
+    def __init__(self, in_channels, out_channels, eltwise, **kwargs):
+        super(LinearEltwise, self).__init__()
+        seed = 2018
+        torch.manual_seed(seed)
+        self.linear = nn.Linear(in_channels, out_channels, **kwargs)
+        self.eltwise = eltwise
+
+    def forward(self, x):
+        return self.eltwise(self.linear(x))
+
 class LinearBn(nn.Module):
     def __init__(self,dim,in_channels, out_channels, **kwargs):
         super(LinearBn, self).__init__()
@@ -336,6 +392,26 @@ class Linear_Reshape_Bn(nn.Module):
     def forward(self, x):
         return self.bn(torch.reshape(self.linear(x),self.dest_shape))
 
+class Lstm(nn.Module):
+    def __init__(self, input_size, hidden_size, num_layers, **kwargs):
+        super(Lstm, self).__init__()
+        seed = 2018
+        torch.manual_seed(seed)
+        self.lstm = nn.LSTM(input_size, hidden_size, num_layers, **kwargs)
+
+    def forward(self, x):
+        return self.lstm(x)
+
+class LstmStep(nn.Module):
+    def __init__(self, input_size, hidden_size, num_layers, **kwargs):
+        super(LstmStep, self).__init__()
+        seed = 2018
+        torch.manual_seed(seed)
+        self.lstm = nn.LSTM(input_size, hidden_size, num_layers, **kwargs)
+
+    def forward(self, x, hx, cx):
+        return self.lstm(x, (hx, cx))
+
 class ConvSumInDiffBlock(nn.Module):
     def __init__(self, dim, in_channels, out_channels, **kwargs):
         super(ConvSumInDiffBlock, self).__init__()
@@ -443,6 +519,90 @@ class ConvElu(nn.Module):
         c = torch.add(b, b)
         return c
 
+class ConvEltwise(nn.Module):
+    def __init__(self, dim, in_channels, out_channels, eltwise, **kwargs):
+        super(ConvEltwise, self).__init__()
+        seed = 2018
+        torch.manual_seed(seed)
+        self.conv = conv_module[dim](in_channels, out_channels, **kwargs)
+        self.eltwise = eltwise
+
+    def forward(self, x):
+        return self.eltwise(self.conv(x))
+
+class ConvSumEltwise(nn.Module):
+    def __init__(self, dim, in_channels, out_channels, eltwise, **kwargs):
+        super(ConvSumEltwise, self).__init__()
+        seed = 2018
+        torch.manual_seed(seed)
+        self.conv = conv_module[dim](in_channels, out_channels, bias=False, **kwargs)
+        self.conv1 = conv_module[dim](in_channels, out_channels, bias=False, **kwargs)
+        self.eltwise = eltwise
+
+    def forward(self, x):
+        return self.eltwise(self.conv(x) + self.conv1(x))
+
+class ConvPoolLinear(nn.Module):
+    def __init__(self, in_channels, out_channels, num_classes, output_size):
+        super(ConvPoolLinear, self).__init__()
+        seed = 2018
+        torch.manual_seed(seed)
+        self.conv = nn.Conv2d(in_channels, out_channels, kernel_size=3, padding=1)
+        self.avgpool = nn.AdaptiveAvgPool2d(output_size)
+        self.fc = nn.Linear(out_channels * output_size[0] * output_size[1], num_classes)
+
+    def forward(self, x):
+        x = self.avgpool(self.conv(x))
+        return self.fc(torch.flatten(x, 1))
+
+class ConvUpsampleCat(nn.Module):
+    def __init__(self, in_channels, out_channels, mode, skip_first, relu):
+        super(ConvUpsampleCat, self).__init__()
+        seed = 2018
+        torch.manual_seed(seed)
+        self.down = nn.Conv2d(in_channels, out_channels, kernel_size=3, stride=2, padding=1)
+        self.skip = nn.Conv2d(in_channels, out_channels // 2, kernel_size=3, padding=1)
+        self.conv = nn.Conv2d(out_channels + out_channels // 2, out_channels, kernel_size=3, padding=1)
+        self.mode = mode
+        self.skip_first = skip_first
+        self.relu = relu
+
+    def forward(self, x):
+        align_corners = None if self.mode == 'nearest' else False
+        up = F.interpolate(self.down(x), scale_factor=2, mode=self.mode, align_corners=align_corners)
+        skip = self.skip(x)
+        x = torch.cat([skip, up] if self.skip_first else [up, skip], dim=1)
+        x = self.conv(x)
+        return F.relu(x) if self.relu else x
+
+class DepthwisePointwiseConv(nn.Module):
+    def __init__(self, channels, out_channels, kernel_size, stride, activation, residual):
+        super(DepthwisePointwiseConv, self).__init__()
+        seed = 2018
+        torch.manual_seed(seed)
+        self.dw = nn.Conv2d(channels, channels, kernel_size, stride=stride, padding=kernel_size // 2,
+                            groups=channels, bias=False)
+        self.bn = nn.BatchNorm2d(channels)
+        self.activation = activation
+        self.pw = nn.Conv2d(channels, out_channels, kernel_size=1)
+        self.residual = residual
+
+    def forward(self, x):
+        y = self.pw(self.activation(self.bn(self.dw(x))))
+        return y + x if self.residual else y
+
+class MaxPoolRelu(nn.Module):
+    def __init__(self, relu_first, inplace):
+        super(MaxPoolRelu, self).__init__()
+        self.pool = nn.MaxPool2d(kernel_size=3, stride=2, padding=1)
+        self.relu = nn.ReLU(inplace=inplace)
+        self.relu_first = relu_first
+
+    def forward(self, x):
+        if self.relu_first:
+            return self.pool(self.relu(x))
+        return self.relu(self.pool(x))
+
 class ConvTranspose2d(nn.Module):
     def __init__(self, in_channels, out_channels, kernel_size, stride=1, padding=0, output_padding=0, groups=1, bias=True, dilation=1):
         super(ConvTranspose2d, self).__init__()
@@ -452,6 +612,23 @@ class ConvTranspose2d(nn.Module):
         x = self.conv_transpose2d(x)
         return x
 
+class ConvTranspose3d(nn.Module):
+    def __init__(self, in_channels, out_channels, kernel_size, stride=1, padding=0, output_padding=0, groups=1, bias=True, dilation=1):
+        super(ConvTranspose3d, self).__init__()
+        self.conv_transpose3d = nn.ConvTranspose3d(in_channels, out_channels, kernel_size, stride, padding, output_padding, groups, bias, dilation)
+
+    def forward(self, x):
+        x = self.conv_transpose3d(x)
+        return x
+
+class ConvTranspose3dRelu(nn.Module):
+    def __init__(self, in_channels, out_channels, kernel_size, stride=1, padding=0, bias=True):
+        super(ConvTranspose3dRelu, self).__init__()
+        self.conv_transpose3d = nn.ConvTranspose3d(in_channels, out_channels, kernel_size, stride, padding, bias=bias)
+
+    def forward(self, x):
+        return F.relu(self.conv_transpose3d(x))
+
 class ChannelShuffle(nn.Module):
     def __init__(self, batchsize, num_channels, height, width, groups):
         super(ChannelShuffle, self).__init__()
@@ -468,6 +645,23 @@ class ChannelShuffle(nn.Module):
         x = x.view(self.batchsize, -1, self.height, self.width)
         return x
 
+class ChannelShuffleConv(nn.Module):
+    def __init__(self, batchsize, num_channels, height, width, groups, use_op):
+        super(ChannelShuffleConv, self).__init__()
+        seed = 2018
+        torch.manual_seed(seed)
+        self.shuffle = ChannelShuffle(batchsize, num_channels, height, width, groups)
+        self.conv = nn.Conv2d(num_channels, num_channels * 2, kernel_size=3, padding=1)
+        self.groups = groups
+        self.use_op = use_op
+
+    def forward(self, x):
+        if self.use_op:
+            x = torch.channel_shuffle(x, self.groups)
+        else:
+            x = self.shuffle(x)
+        return self.conv(x)
+
 class MatmulDiv(nn.Module):
     def __init__(self, div_scalar=False, with_out=False):
         super(MatmulDiv, self).__init__()
@@ -500,6 +694,18 @@ class MHAScoresCalculation(nn.Module):
         scores = qk + bias
         return self.softmax(scores)
 
+class MHA(nn.Module):
+    def __init__(self, dim_per_head):
+        super(MHA, self).__init__()
+        self.softmax = nn.Softmax(dim=-1)
+        self.dim_per_head = dim_per_head
+
+    def forward(self, mat1, mat2, mat3, bias):
+        mat1 = mat1 / math.sqrt(self.dim_per_head)
+        qk = torch.matmul(mat1, mat2.transpose(2, 3))
+        scores = self.softmax(qk + bias)
+        return torch.matmul(scores, mat3)
+
 class AtenSoftmaxRepalce(nn.Module):
     def __init__(self, dim=-1):
         super(AtenSoftmaxRepalce, self).__init__()
@@ -532,6 +738,28 @@ class AddLayerNorm_v1(torch.nn.Module):
         x = x + y + z
         return self.layernorm(x)
 
+class RMSNorm(torch.nn.Module):
+    def __init__(self, dim=32, eps=1e-6, add_residual=False):
+        super(RMSNorm, self).__init__()
+        self.weight = torch.nn.Parameter(torch.randn(dim))
+        self.eps = eps
+        self.add_residual = add_residual
+    def forward(self, x):
+        if self.add_residual:
+            x = x + x.relu()
+        variance = x.pow(2).mean(-1, keepdim=True)
+        return self.weight * (x * torch.rsqrt(variance + self.eps))
+
+class GroupNormSiLU(torch.nn.Module):
+    def __init__(self, channels, num_groups, instance_norm=False):
+        super(GroupNormSiLU, self).__init__()
+        if instance_norm:
+            self.norm = torch.nn.InstanceNorm2d(channels, affine=True)
+        else:
+            self.norm = torch.nn.GroupNorm(num_groups, channels)
+    def forward(self, x):
+        return F.silu(self.norm(x))
+
 class ModMultLinear(nn.Module):
     def __init__(self, w1_dim, w2_dim):
          super(ModMultLinear, self).__init__()
@@ -547,6 +775,38 @@ class ModMultLinear(nn.Module):
          res4 = self.linear4(res1)
          return res1, res2, res3, res4
 
+class ModSiblingConvRelu(nn.Module):
+    def __init__(self, in_channels):
+         super(ModSiblingConvRelu, self).__init__()
+         self.conv1 = nn.Conv2d(in_channels, 16, kernel_size=1)
+         self.conv2 = nn.Conv2d(in_channels, 24, kernel_size=1, bias=False)
+         self.conv3 = nn.Conv2d(in_channels, 8, kernel_size=1)
+
+    def forward(self, x):
+         return F.relu(self.conv1(x)), F.relu(self.conv2(x)), F.relu(self.conv3(x))
+
+class ModSiblingMatmul(nn.Module):
+    def __init__(self, dim):
+         super(ModSiblingMatmul, self).__init__()
+         self.w1 = nn.Parameter(torch.rand(dim, 32))
+         self.w2 = nn.Parameter(torch.rand(dim, 16))
+
+    def forward(self, x):
+         return torch.matmul(x, self.w1), torch.matmul(x, self.w2)
+
+class EmbeddingBagInteraction(nn.Module):
+    def __init__(self, num_tables, num_embeddings, dim, include_last_offset=False):
+        super(EmbeddingBagInteraction, self).__init__()
+        self.emb = nn.ModuleList([
+            nn.EmbeddingBag(num_embeddings, dim, mode='sum', include_last_offset=include_last_offset)
+            for _ in range(num_tables)])
+
+    def forward(self, dense, indices, offsets):
+        x = [dense]
+        for i, emb in enumerate(self.emb):
+            x.append(emb(indices[i], offsets[i]))
+        return ipex.nn.functional.interaction(*x)
+
 class Tester(TestCase):
 
     def _test_output(self, model, x, kind_in_graph=None, kind_not_in_graph=None, levels=['O0','O1'], use_channels_last=[True, False]):
@@ -659,6 +919,29 @@ class Tester(TestCase):
         #  prepack op need note in none freeze model
         self.assertTrue(any(n.kind() == node for n in trace_graph.nodes()))
 
+    def test_prepack_folding_warning(self):
+        model = ConvBatchNorm_Fixed(2, 3, 32, kernel_size=3, stride=1).eval()
+        x = torch.randn(32, 3, 64, 64)
+        model = ipex.optimize(model, dtype=torch.float32)
+
+        with torch.no_grad():
+            trace_model = torch.jit.trace(model, x).eval()
+        freeze_model = torch.jit.freeze(trace_model)
+
+        def prepack_warnings(m):
+            with warnings.catch_warnings(record=True) as w, torch.no_grad():
+                warnings.simplefilter("always")
+                for _ in range(3):
+                    m(x)
+            return [str(r.message) for r in w if "could not be folded" in str(r.message)]
+
+        # the weights of the unfrozen module are packed on every call
+        messages = prepack_warnings(trace_model)
+        self.assertTrue(len(messages) > 0)
+        self.assertTrue("torch.jit.freeze" in messages[0])
+        # and are folded into constants once frozen
+        self.assertEqual(prepack_warnings(freeze_model), [])
+
     def test_concat_linear(self):
         def check_op_count(graph_str, op_names=[]):
             count = 0
@@ -714,6 +997,163 @@ class Tester(TestCase):
             linear_count_ori = check_op_count(graph_opt, ["ipex_prepack::linear_run"])
             self.assertEqual(linear_count_ori, 2)
 
+    def test_horizontal_fusion(self):
+        def count(graph, kind):
+            return sum(n.kind() == kind for n in graph.nodes())
+
+        # the sibling convs of the same input, with the relu hoisted and fused
+        model = ModSiblingConvRelu(8).eval()
+        x = torch.rand(2, 8, 14, 14)
+        with torch.no_grad():
+            ref = model(x)
+            model_jit = torch.jit.freeze(torch.jit.trace(model, x))
+            model_jit(x)
+            res = model_jit(x)
+            graph = model_jit.graph_for(x)
+        self.assertEqual(count(graph, "ipex_prepack::convolution_relu_run"), 1)
+        self.assertEqual(res, ref)
+
+        model = ModSiblingMatmul(64).eval()
+        x = torch.rand(4, 10, 64)
+        with torch.no_grad():
+            ref = model(x)
+            model_jit = torch.jit.freeze(torch.jit.trace(model, x))
+            model_jit(x)
+            res = model_jit(x)
+            graph = model_jit.graph_for(x)
+        self.assertEqual(count(graph, "aten::matmul"), 1)
+        self.assertEqual(res, ref)
+
+    def test_branch_parallel(self):
+        model = Conv_Conv_Concat(2, 3, 32, kernel_size=3, stride=1).eval()
+        x = torch.randn(4, 3, 32, 32)
+        model = ipex.optimize(model, dtype=torch.float32)
+        with torch.no_grad():
+            ref = model(x)
+            ipex.enable_branch_parallel(True)
+            try:
+                trace_model = torch.jit.freeze(torch.jit.trace(model, x))
+                trace_model(x)
+                y = trace_model(x)
+                trace_graph = trace_model.graph_for(x)
+            finally:
+                ipex.enable_branch_parallel(False)
+        self.assertEqual(ref, y)
+        # Both convolutions are forked before the concat.
+        self.assertEqual(sum(n.kind() == "prim::fork" for n in trace_graph.nodes()), 2)
+        self.assertTrue(any(n.kind() == "ipex::get_branch_cores" for n in trace_graph.nodes()))
+
+    def test_eltwise_chain(self):
+        model = BatchNorm_Eltwise_Chain(8).eval()
+        for dtype in [torch.float, torch.bfloat16]:
+            for memory_format in [torch.contiguous_format, torch.channels_last]:
+                x = torch.randn(2, 8, 10, 10).to(dtype=dtype, memory_format=memory_format)
+                residual = torch.randn(2, 8, 10, 10).to(dtype=dtype, memory_format=memory_format)
+                m = copy.deepcopy(model).to(dtype)
+                with torch.no_grad():
+                    ref = m(x, residual)
+                    trace_model = torch.jit.trace(m, (x, residual))
+                    trace_model(x, residual)
+                    y = trace_model(x, residual)
+                    trace_graph = trace_model.graph_for(x, residual)
+                    # broadcast inputs go through the reference path
+                    residual_broadcast = residual[:1]
+                    y_broadcast = trace_model(x, residual_broadcast)
+                prec = 2e-2 if dtype == torch.bfloat16 else 1e-5
+                self.assertEqual(ref, y, prec=prec)
+                self.assertEqual(m(x, residual_broadcast), y_broadcast, prec=prec)
+                self.assertTrue(any(n.kind() == "ipex::eltwise_chain" for n in trace_graph.nodes()))
+                self.assertFalse(any(n.kind() == "aten::sigmoid" for n in trace_graph.nodes()))
+
+    def test_eltwise_chain_transcendental(self):
+        # the vectorized exp, tanh, erf and sigmoid of the chain are of fp32
+        # accuracy over the range of the activations
+        model = Transcendental_Eltwise_Chain().eval()
+        x = torch.randn(4, 1000) * 6
+        y = torch.randn(4, 1000) * 6
+        x[0, :4] = torch.tensor([0., 1e-6, -1e-6, 50.])
+        y[0, :4] = torch.tensor([-50., 1e-6, 0., 20.])
+        with torch.no_grad():
+            ref = model(x, y)
+            trace_model = torch.jit.trace(model, (x, y))
+            trace_model(x, y)
+            out = trace_model(x, y)
+            trace_graph = trace_model.graph_for(x, y)
+        self.assertEqual(ref, out, prec=1e-4)
+        self.assertTrue(any(n.kind() == "ipex::eltwise_chain" for n in trace_graph.nodes()))
+
+    def test_memory_planning(self):
+        model = ConvRelu_Chain(2, 3, 16, kernel_size=3, padding=1).eval()
+        x = torch.randn(2, 3, 16, 16)
+        x_other = torch.randn(1, 3, 20, 20)
+        model = ipex.optimize(model, dtype=torch.float32)
+        with torch.no_grad():
+            ref = model(x)
+            ref_other = model(x_other)
+            ipex.enable_memory_planning(True)
+            try:
+                trace_model = torch.jit.freeze(torch.jit.trace(model, x))
+                trace_model(x)
+                y = trace_model(x)
+                trace_graph = trace_model.graph_for(x)
+                # the inputs of other shapes don't use the arena
+                y_other = trace_model(x_other)
+            finally:
+                ipex.enable_memory_planning(False)
+        self.assertEqual(ref, y)
+        self.assertEqual(ref_other, y_other)
+        # The outputs of the first two convolutions are planned, the graph
+        # output is not.
+        self.assertTrue(any(n.kind() == "ipex::memory_plan_begin" for n in trace_graph.nodes()))
+        self.assertEqual(sum(n.kind() == "ipex::planned_buffer" for n in trace_graph.nodes()), 2)
+
+    def test_conv_algorithm_selection(self):
+        model = ConvRelu_Chain(2, 16, 16, kernel_size=3, padding=1).eval()
+        x = torch.randn(1, 16, 64, 64)
+        # runs with the direct algorithm, of another shape than the selected one
+        x_other = torch.randn(1, 16, 40, 40)
+        model = ipex.optimize(model, dtype=torch.float32)
+        with torch.no_grad():
+            ref = model(x)
+            ref_other = model(x_other)
+            ipex.enable_conv_algorithm_selection(True)
+            try:
+                trace_model = torch.jit.freeze(torch.jit.trace(model, x))
+                trace_model(x)
+                y = trace_model(x)
+                y_other = trace_model(x_other)
+            finally:
+                ipex.enable_conv_algorithm_selection(False)
+        # the winograd algorithm rounds differently from the direct one
+        self.assertEqual(ref, y, prec=1e-3)
+        self.assertEqual(ref_other, y_other, prec=1e-3)
+
+    def test_rms_norm(self):
+        x = torch.randn(2, 5, 70)
+        self._test_output(
+            RMSNorm(70),
+            x,
+            kind_in_graph="ipex::rms_norm",
+            kind_not_in_graph="aten::rsqrt")
+        self._test_output(
+            RMSNorm(70, add_residual=True),
+            x,
+            kind_in_graph="ipex::add_rms_norm",
+            kind_not_in_graph="aten::rsqrt")
+
+    def test_group_norm_silu(self):
+        x = torch.randn(2, 64, 8, 8).to(memory_format=torch.channels_last)
+        self._test_output(
+            GroupNormSiLU(64, 32),
+            x,
+            kind_in_graph="ipex::group_norm_silu",
+            kind_not_in_graph="aten::group_norm")
+        self._test_output(
+            GroupNormSiLU(64, 64, instance_norm=True),
+            x,
+            kind_in_graph="ipex::group_norm_silu",
+            kind_not_in_graph="aten::instance_norm")
+
     def test_add_layernorm(self):
         bs = 56
         seq_len = 384
@@ -831,6 +1271,30 @@ class Tester(TestCase):
                 self.assertEqual(mha(mat1, mat2, bias), mha_jit(mat1, mat2, bias))
                 _test_pure_bf16(mha, mha_jit, mat1, mat2, bias)
 
+    def test_mha(self):
+        mha = MHA(64)
+        # the BERT shapes, the mask is broadcast over the heads and the queries
+        for seq_len in [2, 64, 97]:
+            mat1 = torch.randn(2, 4, seq_len, 64)
+            mat2 = torch.randn(2, 4, seq_len, 64)
+            mat3 = torch.randn(2, 4, seq_len, 64)
+            bias = torch.randn(2, 1, 1, seq_len)
+            bias[0, :, :, seq_len // 2:] = -10000.0
+            with torch.no_grad():
+                mha_jit = torch.jit.trace(mha, (mat1, mat2, mat3, bias))
+                trace_graph = mha_jit.graph_for(mat1, mat2, mat3, bias)
+                self.assertTrue(any(n.kind() == "ipex::mha" for n in trace_graph.nodes()))
+                res_ref = mha(mat1, mat2, mat3, bias)
+                res_jit = mha_jit(mat1, mat2, mat3, bias)
+                self.assertEqual(res_ref, res_jit)
+
+                inputs_bf16 = [t.to(torch.bfloat16) for t in (mat1, mat2, mat3, bias)]
+                self.assertEqual(mha(*inputs_bf16), mha_jit(*inputs_bf16), prec=3e-2)
+
+                # not all of the same batch and head, fall back to the composite ops
+                mat3 = torch.randn(1, 4, seq_len, 64)
+                self.assertEqual(mha(mat1, mat2, mat3, bias), mha_jit(mat1, mat2, mat3, bias))
+
     def test_conv2d_fusion(self):
         batch_size = 32
         out_channels = 64
@@ -1108,6 +1572,100 @@ class Tester(TestCase):
             kind_not_in_graph="ipex::batch_norm",
             prec=0.02)
 
+    def test_output_conv_eltwise_post_ops(self):
+        eltwise_list = [
+            nn.Hardswish(),
+            nn.Mish(),
+            nn.Tanh(),
+            nn.LeakyReLU(0.1),
+            partial(torch.clamp, min=-0.5, max=0.5)]
+        for eltwise in eltwise_list:
+            self._test_output(
+                ConvEltwise(2, 3, 32, eltwise, kernel_size=3, stride=1),
+                torch.randn(32, 3, 64, 64),
+                kind_in_graph="ipex_prepack::convolution_eltwise_run")
+            self._test_output_bf16(
+                ConvEltwise(2, 3, 32, eltwise, kernel_size=3, stride=1),
+                torch.randn(32, 3, 64, 64),
+                kind_in_graph="ipex_prepack::convolution_eltwise_run",
+                prec=0.02)
+            self._test_output(
+                ConvEltwise(3, 3, 32, eltwise, kernel_size=3, stride=1),
+                torch.randn(32, 3, 32, 32, 32),
+                kind_in_graph="ipex::conv3d_eltwise")
+            # the post-sum chain of conv + add + eltwise
+            self._test_output(
+                ConvSumEltwise(2, 3, 32, eltwise, kernel_size=3, stride=1),
+                torch.randn(32, 3, 64, 64),
+                kind_in_graph="ipex_prepack::convolution_add_eltwise_run")
+        # conv3d + relu stays with ipex::conv3d_relu
+        self._test_output(
+            ConvEltwise(3, 3, 32, nn.ReLU(), kernel_size=3, stride=1),
+            torch.randn(32, 3, 32, 32, 32),
+            kind_in_graph="ipex::conv3d_relu",
+            kind_not_in_graph="ipex::conv3d_eltwise")
+
+    def test_output_adaptive_avg_pool_linear(self):
+        for output_size in [(1, 1), (2, 2)]:
+            self._test_output(
+                ConvPoolLinear(3, 64, 10, output_size),
+                torch.randn(2, 3, 14, 14),
+                kind_in_graph="ipex_prepack::adaptive_avg_pool_linear_run",
+                kind_not_in_graph="aten::flatten")
+            self._test_output_bf16(
+                ConvPoolLinear(3, 64, 10, output_size),
+                torch.randn(2, 3, 14, 14),
+                kind_in_graph="ipex_prepack::adaptive_avg_pool_linear_run",
+                kind_not_in_graph="aten::flatten",
+                prec=0.02)
+
+    def test_output_conv_upsample_cat(self):
+        for mode, skip_first, relu in itertools.product(['nearest', 'bilinear'], [False, True], [False, True]):
+            self._test_output(
+                ConvUpsampleCat(3, 16, mode, skip_first, relu),
+                torch.randn(2, 3, 32, 32),
+                kind_in_graph="ipex_prepack::convolution_upsample_cat_run",
+                kind_not_in_graph="aten::cat")
+            self._test_output_bf16(
+                ConvUpsampleCat(3, 16, mode, skip_first, relu),
+                torch.randn(2, 3, 32, 32),
+                kind_in_graph="ipex_prepack::convolution_upsample_cat_run",
+                kind_not_in_graph="aten::cat",
+                prec=0.02)
+
+    def test_output_conv_depthwise_pointwise(self):
+        # the tails of the channels, the strided 5x5 kernel, and the blocks of
+        # the output rows of the image larger than the cache
+        shapes = [(32, 16, 3, 1, (2, 32, 14, 14)),
+                  (40, 24, 5, 2, (1, 40, 15, 15)),
+                  (24, 24, 3, 1, (1, 24, 160, 160))]
+        activations = [nn.ReLU(), nn.ReLU6(), nn.SiLU(), nn.Hardswish()]
+        for (channels, out_channels, kernel_size, stride, x_shape), activation in itertools.product(shapes, activations):
+            self._test_output(
+                DepthwisePointwiseConv(channels, out_channels, kernel_size, stride, activation, residual=False),
+                torch.randn(x_shape),
+                kind_in_graph="ipex_prepack::convolution_depthwise_pointwise_run")
+            if channels == out_channels and stride == 1:
+                self._test_output(
+                    DepthwisePointwiseConv(channels, out_channels, kernel_size, stride, activation, residual=True),
+                    torch.randn(x_shape),
+                    kind_in_graph="ipex_prepack::convolution_depthwise_pointwise_add_run")
+
+    def test_output_max_pool2d_relu(self):
+        for relu_first, inplace in itertools.product([False, True], [False, True]):
+            relu_kind = "aten::relu_" if inplace else "aten::relu"
+            self._test_output(
+                MaxPoolRelu(relu_first, inplace),
+                torch.randn(2, 16, 15, 15),
+                kind_in_graph="ipex::max_pool2d_relu",
+                kind_not_in_graph=relu_kind)
+            self._test_output_bf16(
+                MaxPoolRelu(relu_first, inplace),
+                torch.randn(2, 16, 15, 15),
+                kind_in_graph="ipex::max_pool2d_relu",
+                kind_not_in_graph=relu_kind,
+                prec=0.02)
+
     def test_output_conv_transpose2d(self):
         def _deconv_params_list():
             params_dict = {
@@ -1172,6 +1730,44 @@ class Tester(TestCase):
                     levels=["O1"],
                     prec=0.02)
 
+    def test_output_conv_transpose3d(self):
+        for bias, stride, padding, groups in itertools.product([True, False], [1, 2], [0, 1], [1, 2]):
+            ic = 4 * groups
+            oc = 3 * groups
+            x = torch.randn(2, ic, 6, 6, 6)
+            model = ConvTranspose3d(ic, oc, 3, stride, padding, groups=groups, bias=bias)
+            self._test_output(
+                model,
+                x,
+                kind_in_graph="ipex_prepack::conv_transpose3d_run",
+                kind_not_in_graph="aten::conv_transpose3d",
+                levels=["O0"])
+            self._test_output_bf16(
+                model,
+                x,
+                kind_in_graph="ipex_prepack::conv_transpose3d_run",
+                kind_not_in_graph="aten::conv_transpose3d",
+                levels=["O0"],
+                prec=0.02)
+
+    def test_output_conv_transpose3d_relu(self):
+        for bias, stride in itertools.product([True, False], [1, 2]):
+            x = torch.randn(2, 4, 6, 6, 6)
+            model = ConvTranspose3dRelu(4, 8, 3, stride, 1, bias=bias)
+            self._test_output(
+                model,
+                x,
+                kind_in_graph="ipex_prepack::conv_transpose3d_eltwise_run",
+                kind_not_in_graph="ipex_prepack::conv_transpose3d_run",
+                levels=["O0"])
+            self._test_output_bf16(
+                model,
+                x,
+                kind_in_graph="ipex_prepack::conv_transpose3d_eltwise_run",
+                kind_not_in_graph="ipex_prepack::conv_transpose3d_run",
+                levels=["O0"],
+                prec=0.02)
+
     def test_linear_auto_kernel_selection_fp32(self):
         x = torch.rand(32, 3)
         options = itertools.product(['O0', 'O1'], [True, False])
@@ -1206,6 +1802,269 @@ class Tester(TestCase):
                 # for bfloat16 path, we will use ipex linear for 'O0' and 'O1'
                 self.assertTrue(any(n.kind() == 'ipex_prepack::linear_relu_run' for n in trace_graph.nodes()))
 
+    def test_linear_gemv(self):
+        for model_class, rows, dtype in itertools.product([LinearRelu, LinearGelu, LinearAdd], [1, 3, 4, 8], [torch.float32, torch.bfloat16]):
+            model = model_class(67, 40, bias=True).eval()
+            x = torch.rand(rows, 67)
+            with torch.no_grad():
+                traced_model = torch.jit.freeze(torch.jit.trace(
+                    ipex.optimize(copy.deepcopy(model).to(dtype), dtype=dtype, auto_kernel_selection=True), x.to(dtype)))
+                traced_model(x.to(dtype))
+                with ipex.op_trace() as trace:
+                    y = traced_model(x.to(dtype))
+                y_ref = model(x)
+            self.assertEqual(y.float(), y_ref, prec=1e-4 if dtype == torch.float32 else 0.05)
+            kernels = [r['kernel'] for r in trace.records() if r['op'].startswith('ipex_prepack::linear')]
+            self.assertTrue(len(kernels) > 0)
+            # the weight prepacked for a few rows only is plain for the GEMV
+            self.assertTrue(all(k == ('gemv' if rows <= 4 else 'onednn') for k in kernels))
+            # the other rows of the plain weight run oneDNN
+            with torch.no_grad():
+                x2 = torch.rand(16, 67)
+                self.assertEqual(traced_model(x2.to(dtype)).float(), model(x2), prec=1e-4 if dtype == torch.float32 else 0.05)
+
+    def test_linear_block_sparse(self):
+        x = torch.rand(10, 64)
+        for model_class, out_features in itertools.product([LinearRelu, LinearGelu, LinearAdd], [32, 40]):
+            model = model_class(64, out_features, bias=True).eval()
+            # pruned in the blocks of 16 output channels of an input feature,
+            # of which the last are padded
+            with torch.no_grad():
+                for m in model.modules():
+                    if isinstance(m, nn.Linear):
+                        blocks = (m.weight.size(0) + 15) // 16
+                        mask = (torch.rand(blocks, m.weight.size(1)) < 0.1).float()
+                        m.weight.mul_(mask.repeat_interleave(16, 0)[:m.weight.size(0)])
+                y_ref = model(x)
+            for enabled in [True, False]:
+                ipex.enable_sparse_linear(enabled)
+                try:
+                    with torch.no_grad():
+                        traced_model = torch.jit.freeze(torch.jit.trace(
+                            ipex.optimize(copy.deepcopy(model), dtype=torch.float32, auto_kernel_selection=True), x))
+                        traced_model(x)
+                        with ipex.op_trace() as trace:
+                            y = traced_model(x)
+                finally:
+                    ipex.enable_sparse_linear(True)
+                self.assertEqual(y, y_ref, prec=1e-4)
+                kernels = [r['kernel'] for r in trace.records() if r['op'].startswith('ipex_prepack::linear')]
+                self.assertTrue(len(kernels) > 0)
+                self.assertTrue(all(k == ('block_sparse' if enabled else 'onednn') for k in kernels))
+
+    def test_linear_weight_only_quantization(self):
+        x = torch.rand(2, 64)
+        for model_class in [LinearRelu, LinearGelu, LinearAdd]:
+            model = model_class(64, 32, bias=True).eval()
+            # The reference runs with the weights quantized and dequantized
+            # in advance.
+            ref_model = copy.deepcopy(model)
+            with torch.no_grad():
+                for m in ref_model.modules():
+                    if isinstance(m, nn.Linear):
+                        scales = m.weight.abs().amax(1) / 127
+                        zero_points = torch.zeros(m.weight.size(0), dtype=torch.long)
+                        m.weight.copy_(torch.quantize_per_channel(
+                            m.weight, scales.double(), zero_points, 0, torch.qint8).dequantize())
+                y_ref = ref_model(x)
+            for use_ipex_optimize in [True, False]:
+                model_ = ipex.optimize(copy.deepcopy(model), dtype=torch.float32, auto_kernel_selection=True) \
+                    if use_ipex_optimize else model
+                ipex.enable_weight_only_quantization(True)
+                try:
+                    with torch.no_grad():
+                        traced_model = torch.jit.freeze(torch.jit.trace(model_, x))
+                        traced_model(x)
+                        y = traced_model(x)
+                        trace_graph = traced_model.graph_for(x)
+                finally:
+                    ipex.enable_weight_only_quantization(False)
+                self.assertEqual(y, y_ref, prec=1e-4)
+                self.assertTrue(all(n.kind() != 'aten::linear' for n in trace_graph.nodes()))
+
+    def test_linear_weight_only_quantization_4bit(self):
+        nf4_levels = torch.tensor([
+            -1.0, -0.6961928009986877, -0.5250730514526367, -0.39491748809814453,
+            -0.28444138169288635, -0.18477343022823334, -0.09105003625154495, 0.0,
+            0.07958029955625534, 0.16093020141124725, 0.24611230194568634, 0.33791524171829224,
+            0.44070982933044434, 0.5626170039176941, 0.7229568362236023, 1.0])
+
+        def quantize_dequantize(weight, dtype, group_size):
+            w = weight.reshape(weight.size(0), -1, group_size)
+            absmax = w.abs().amax(-1, keepdim=True)
+            if dtype == 'nf4':
+                x = w / absmax
+                q = (x.unsqueeze(-1) - nf4_levels).abs().argmin(-1)
+                return (nf4_levels[q] * absmax).reshape(weight.shape)
+            scales = absmax / 7
+            return (torch.clamp(torch.round(w / scales), -8, 7) * scales).reshape(weight.shape)
+
+        x = torch.rand(2, 64)
+        # 64 input features of 4 groups, and of a single group of 48
+        for dtype, group_size, ref_group_size in [('int4', 16, 16), ('nf4', 16, 16), ('nf4', 48, 64)]:
+            for model_class in [LinearRelu, LinearGelu, LinearAdd]:
+                model = model_class(64, 32, bias=True).eval()
+                # The reference runs with the weights quantized and dequantized
+                # in advance.
+                ref_model = copy.deepcopy(model)
+                with torch.no_grad():
+                    for m in ref_model.modules():
+                        if isinstance(m, nn.Linear):
+                            m.weight.copy_(quantize_dequantize(m.weight, dtype, ref_group_size))
+                    y_ref = ref_model(x)
+                for use_ipex_optimize in [True, False]:
+                    model_ = ipex.optimize(copy.deepcopy(model), dtype=torch.float32, auto_kernel_selection=True) \
+                        if use_ipex_optimize else model
+                    ipex.enable_weight_only_quantization(True, dtype=dtype, group_size=group_size)
+                    try:
+                        with torch.no_grad():
+                            traced_model = torch.jit.freeze(torch.jit.trace(model_, x))
+                            traced_model(x)
+                            y = traced_model(x)
+                            trace_graph = traced_model.graph_for(x)
+                    finally:
+                        ipex.enable_weight_only_quantization(False)
+                    self.assertEqual(y, y_ref, prec=1e-4)
+                    self.assertTrue(all(n.kind() != 'aten::linear' for n in trace_graph.nodes()))
+
+    def test_linear_dynamic_quantization(self):
+        def quantize_input(m, inputs):
+            scale, zero_point = torch._choose_qparams_per_tensor(inputs[0], False)
+            return torch.quantize_per_tensor(inputs[0], scale, zero_point, torch.quint8).dequantize()
+
+        x = torch.randn(2, 64)
+        for model_class in [LinearRelu, LinearGelu, LinearAdd]:
+            model = model_class(64, 32, bias=True).eval()
+            # The reference runs with the weights quantized and dequantized in
+            # advance, and the inputs quantized and dequantized by their ranges.
+            ref_model = copy.deepcopy(model)
+            with torch.no_grad():
+                for m in ref_model.modules():
+                    if isinstance(m, nn.Linear):
+                        scales = m.weight.abs().amax(1) / 127
+                        zero_points = torch.zeros(m.weight.size(0), dtype=torch.long)
+                        m.weight.copy_(torch.quantize_per_channel(
+                            m.weight, scales.double(), zero_points, 0, torch.qint8).dequantize())
+                        m.register_forward_pre_hook(quantize_input)
+                y_ref = ref_model(x)
+            for use_ipex_optimize in [True, False]:
+                model_ = ipex.optimize(copy.deepcopy(model), dtype=torch.float32, auto_kernel_selection=True) \
+                    if use_ipex_optimize else model
+                ipex.enable_dynamic_quantization(True)
+                try:
+                    with torch.no_grad():
+                        traced_model = torch.jit.freeze(torch.jit.trace(model_, x))
+                        traced_model(x)
+                        y = traced_model(x)
+                        # the ranges of the other inputs are computed on the fly
+                        y_scaled = traced_model(x * 4)
+                        trace_graph = traced_model.graph_for(x)
+                finally:
+                    ipex.enable_dynamic_quantization(False)
+                self.assertEqual(y, y_ref, prec=1e-3)
+                self.assertEqual(y_scaled, ref_model(x * 4), prec=4e-3)
+                self.assertTrue(all(n.kind() != 'aten::linear' for n in trace_graph.nodes()))
+
+    def test_dynamic_quantized_linear_serialization(self):
+        class M(torch.nn.Module):
+            def __init__(self, ctx):
+                super(M, self).__init__()
+                self.ctx = ctx
+
+            def forward(self, x):
+                return torch.ops.ipex_prepack.linear_run(x, self.ctx)
+
+        x = torch.randn(2, 64)
+        weight = torch.randn(32, 64)
+        bias = torch.randn(32)
+        scales = weight.abs().amax(1).double() / 127
+        zero_points = torch.zeros(32, dtype=torch.long)
+        weight_q = torch.quantize_per_channel(weight, scales, zero_points, 0, torch.qint8)
+        ipex.enable_dynamic_quantization(True)
+        try:
+            ctx = torch.ops.ipex_prepack.linear_prepack(weight_q, bias, 32, 64, 2, False)
+        finally:
+            ipex.enable_dynamic_quantization(False)
+        model = torch.jit.script(M(ctx))
+        with torch.no_grad():
+            y_ref = model(x)
+        buffer = io.BytesIO()
+        ipex.enable_packed_weight_serialization(True)
+        try:
+            torch.jit.save(model, buffer)
+        finally:
+            ipex.enable_packed_weight_serialization(False)
+        # The packed s8 weight is loaded with its scales and compensation, so
+        # the dynamic quantized linear is restored without the option enabled
+        # and without quantizing the weight again.
+        buffer.seek(0)
+        loaded_model = torch.jit.load(buffer)
+        with torch.no_grad():
+            self.assertEqual(loaded_model(x), y_ref)
+
+        # the loaded model keeps the packed int8 weight when saved again
+        buffer = io.BytesIO()
+        torch.jit.save(loaded_model, buffer)
+        buffer.seek(0)
+        loaded_model = torch.jit.load(buffer)
+        with torch.no_grad():
+            self.assertEqual(loaded_model(x), y_ref)
+
+    def test_lstm_prepack(self):
+        options = itertools.product([1, 2], [True, False], [True, False], [True, False])
+        for num_layers, bidirectional, batch_first, bias in options:
+            model = Lstm(16, 32, num_layers, bidirectional=bidirectional, batch_first=batch_first, bias=bias).eval()
+            model = ipex.optimize(model, dtype=torch.float32)
+            x = torch.randn(4, 6, 16)
+            # another sequence length and batch size than the traced one
+            x2 = torch.randn(5, 3, 16)
+            with torch.no_grad():
+                y_ref, y2_ref = model(x), model(x2)
+                traced_model = torch.jit.freeze(torch.jit.trace(model, x))
+                traced_model(x)
+                y = traced_model(x)
+                trace_graph = traced_model.graph_for(x)
+                self.assertEqual(y, y_ref)
+                self.assertEqual(traced_model(x2), y2_ref)
+                self.assertTrue(any(n.kind() == 'ipex_prepack::lstm_run' for n in trace_graph.nodes()))
+
+                buffer = io.BytesIO()
+                ipex.enable_packed_weight_serialization(True)
+                try:
+                    torch.jit.save(traced_model, buffer)
+                finally:
+                    ipex.enable_packed_weight_serialization(False)
+                buffer.seek(0)
+                loaded_model = torch.jit.load(buffer)
+                self.assertEqual(loaded_model(x), y_ref)
+                self.assertEqual(loaded_model(x2), y2_ref)
+
+    def test_lstm_prepack_fused_cell(self):
+        # one step of a small batch fed with its own state, as the prediction
+        # network of the RNN-T greedy decoding
+        options = itertools.product([1, 2], [True, False], [1, 4, 32])
+        for num_layers, bidirectional, batch in options:
+            num_directions = 2 if bidirectional else 1
+            model = LstmStep(20, 36, num_layers, bidirectional=bidirectional).eval()
+            model = ipex.optimize(model, dtype=torch.float32)
+            x = torch.randn(1, batch, 20)
+            hx = torch.randn(num_layers * num_directions, batch, 36)
+            cx = torch.randn(num_layers * num_directions, batch, 36)
+            with torch.no_grad():
+                traced_model = torch.jit.freeze(torch.jit.trace(model, (x, hx, cx)))
+                traced_model(x, hx, cx)
+                trace_graph = traced_model.graph_for(x, hx, cx)
+                self.assertTrue(any(n.kind() == 'ipex_prepack::lstm_run' for n in trace_graph.nodes()))
+                state, state_ref = (hx, cx), (hx, cx)
+                for _ in range(3):
+                    y_ref, state_ref = model(x, *state_ref)
+                    y, state = traced_model(x, *state)
+                    self.assertEqual(y, y_ref)
+                    self.assertEqual(state, state_ref)
+                # the sequence still runs the LSTM primitive
+                x2 = torch.randn(5, batch, 20)
+                self.assertEqual(traced_model(x2, hx, cx), model(x2, hx, cx))
+
     def test_output_linear_relu(self):
         self._test_output(
             LinearRelu(3, 32, bias=True),
@@ -1246,9 +2105,41 @@ class Tester(TestCase):
         self._test_output_bf16(
             LinearSigmoid(3, 32, bias=True),
             torch.rand(32, 3),
-            kind_in_graph="ipex_prepack::linear_run",
+            kind_in_graph="ipex_prepack::linear_eltwise_run",
             prec=0.02)
 
+    def test_output_linear_eltwise_post_ops(self):
+        eltwise_list = [nn.Hardswish(), nn.Mish(), nn.Tanh(), nn.ELU(0.5)]
+        for eltwise in eltwise_list:
+            self._test_output_bf16(
+                LinearEltwise(3, 32, eltwise, bias=True),
+                torch.rand(32, 3),
+                kind_in_graph="ipex_prepack::linear_eltwise_run",
+                kind_not_in_graph="ipex_prepack::linear_run",
+                prec=0.02)
+
+    def test_embedding_bag_interaction(self):
+        batch_size, num_embeddings, dim = 8, 20, 16
+        for include_last_offset in [False, True]:
+            model = EmbeddingBagInteraction(3, num_embeddings, dim, include_last_offset).eval()
+            dense = torch.rand(batch_size, dim)
+            indices = [torch.randint(num_embeddings, (24,)) for _ in range(3)]
+            offsets = [torch.arange(0, 24, 3) for _ in range(3)]
+            if include_last_offset:
+                offsets = [torch.cat([o, torch.tensor([24])]) for o in offsets]
+            for dtype, prec in [(torch.float32, None), (torch.bfloat16, 0.02)]:
+                m = copy.deepcopy(model).to(dtype)
+                x_ = (dense.to(dtype), indices, offsets)
+                with torch.no_grad():
+                    result = m(*x_)
+                    trace_model = torch.jit.freeze(torch.jit.trace(m, x_).eval())
+                    trace_model(*x_)
+                    tresult = trace_model(*x_)
+                    trace_graph = trace_model.graph_for(*x_)
+                self.assertEqual(result, tresult, prec=prec)
+                self.assertTrue(any(n.kind() == "ipex::embedding_bag_interaction" for n in trace_graph.nodes()))
+                self.assertTrue(all(n.kind() != "torch_ipex::embedding_bag" for n in trace_graph.nodes()))
+
     def test_output_linear_bn(self):
         self._test_output(
             LinearBn(2 ,32, 32, bias=True),
@@ -1281,12 +2172,41 @@ class Tester(TestCase):
             kind_in_graph="ipex_prepack::linear_gelu_run",
             prec=5e-3)
 
+    def test_output_linear_gelu_linear(self):
+        # the larger input is run by row blocks unless there are many threads
+        for tokens in [32, 4096]:
+            self._test_output_bf16(
+                LinearGeluLinear(64, 256, bias=True),
+                torch.rand(2, tokens, 64),
+                kind_in_graph="ipex_prepack::linear_gelu_linear_run",
+                prec=0.02)
+            self._test_output_bf16(
+                LinearGeluLinear(64, 256, residual=True, bias=True),
+                torch.rand(2, tokens, 64),
+                kind_in_graph="ipex_prepack::linear_gelu_linear_add_run",
+                prec=0.02)
+
     def test_channel_shuffle(self):
         self._test_output(
             ChannelShuffle(10, 16, 50, 50, 4),
             torch.rand(10, 16, 50, 50),
             kind_in_graph="ipex::shuffle_2d")
 
+    def test_channel_shuffle_conv(self):
+        for use_op in [False, True]:
+            shuffle_kind = "aten::channel_shuffle" if use_op else "aten::transpose"
+            self._test_output(
+                ChannelShuffleConv(2, 16, 14, 14, 4, use_op),
+                torch.rand(2, 16, 14, 14),
+                kind_in_graph="ipex_prepack::convolution_run",
+                kind_not_in_graph=shuffle_kind)
+            self._test_output_bf16(
+                ChannelShuffleConv(2, 16, 14, 14, 4, use_op),
+                torch.rand(2, 16, 14, 14),
+                kind_in_graph="ipex_prepack::convolution_run",
+                kind_not_in_graph=shuffle_kind,
+                prec=0.02)
+
     def test_jit_function(self):
         # test hool trace and script can works for function
         def fn(input, weight, bias):
@@ -1360,6 +2280,18 @@ class Tester(TestCase):
             kind_not_in_graph=None,
             prec=5e-3)
 
+    def test_matmul_div_small_gemm(self):
+        # the specialized K of the batched small GEMM, the tails of the rows
+        # and the columns, and a matrix too large for it
+        for x in [torch.randn(24, 13, 64), torch.randn(8, 37, 128), torch.randn(3, 19, 7),
+                  torch.randn(2, 130, 20)]:
+            for div_scalar, with_out in itertools.product([True, False], repeat=2):
+                self._test_output(
+                    MatmulDiv(div_scalar=div_scalar, with_out=with_out),
+                    x,
+                    kind_in_graph="ipex::matmul_div",
+                    kind_not_in_graph=None)
+
     def test_ipex_softmax(self):
         self._test_output(
             AtenSoftmaxRepalce(),
@@ -1371,6 +2303,20 @@ class Tester(TestCase):
             kind_in_graph="ipex::softmax",
             prec=5e-3)
 
+    def test_ipex_softmax_long_rows(self):
+        # the rows of 1024 elements at least are computed by the online softmax,
+        # with and without a tail, and with the large values of the logits
+        for hidden in [1024, 1030]:
+            self._test_output(
+                AtenSoftmaxRepalce(),
+                torch.randn(3, 4, hidden) * 50,
+                kind_in_graph="ipex::softmax")
+            self._test_output_bf16(
+                AtenSoftmaxRepalce(),
+                torch.randn(3, 4, hidden, dtype=torch.bfloat16),
+                kind_in_graph="ipex::softmax",
+                prec=5e-3)
+
     def test_ipex_batch_norm(self):
         self._test_output(
             AtenBatchNormRepalce(),
@@ -1,5 +1,7 @@
 import unittest
 import itertools
+import os
+import tempfile
 import torch
 import torch.nn as nn
 import torch.nn.functional as F
@@ -28,6 +30,96 @@ class TestIpexOps(JitLlgaTestCase):
             self.assertGraphContainsExactly(graph, LLGA_FUSION_GROUP, 0)
 
 
+    def test_calibration_min_max(self):
+        m = nn.Linear(67, 35).eval()
+        # an odd number of elements to cover the tails of the vectorized kernels
+        x = torch.randn(33, 67)
+        conf = ipex.quantization.QuantConf()
+        with torch.no_grad(), ipex.quantization.calibrate(conf):
+            m(x)
+            m(x * 2)
+        configures = ipex._C.get_int8_configures()
+        x_min, x_max = min(x.min().item() * 2, 0), max(x.max().item() * 2, 0)
+        self.assertEqual(configures[0]['input_scales'][0], (x_max - x_min) / 255, rtol=1e-5, atol=0)
+        w_max = m.weight.abs().max(dim=1)[0]
+        self.assertEqual(torch.tensor(configures[0]['weight_scales'][0]), w_max / 127, rtol=1e-5, atol=0)
+
+    def test_binary_configure_file(self):
+        class M(nn.Module):
+            def __init__(self):
+                super(M, self).__init__()
+                self.conv = nn.Conv2d(3, 8, 3)
+                self.linear = nn.Linear(8 * 6 * 6, 4)
+
+            def forward(self, x):
+                return self.linear(self.conv(x).flatten(1))
+
+        m = M().eval()
+        x = torch.rand(2, 3, 8, 8)
+        conf = ipex.quantization.QuantConf()
+        with torch.no_grad(), ipex.quantization.calibrate(conf):
+            m(x)
+        configures = ipex._C.get_int8_configures()
+        with tempfile.TemporaryDirectory() as path:
+            json_file = os.path.join(path, 'configure.json')
+            binary_file = os.path.join(path, 'configure.bin')
+            conf.save(json_file)
+            ipex._C.load_indicators_file(configures)
+            conf.save(binary_file)
+            self.assertTrue(ipex._C.is_indicators_binary_file(binary_file))
+            self.assertFalse(ipex._C.is_indicators_binary_file(json_file))
+            results = []
+            for configure_file in [json_file, binary_file]:
+                conf = ipex.quantization.QuantConf(configure_file)
+                self.assertEqual(ipex._C.get_int8_configures(), configures)
+                with torch.no_grad():
+                    trace_model = ipex.quantization.convert(m, conf, x)
+                    trace_model(x)
+                    results.append(trace_model(x))
+            self.assertEqual(results[0], results[1])
+
+    def test_histogram_observers(self):
+        m = nn.Linear(64, 64).eval()
+        x = torch.randn(256, 64)
+        # one outlier of the input
+        x[0][0] = 1000.
+        input_scales = {}
+        for algorithm in ['min_max', 'percentile', 'kl_divergence', 'mse']:
+            conf = ipex.quantization.QuantConf(algorithm=algorithm)
+            with torch.no_grad(), ipex.quantization.calibrate(conf):
+                m(x)
+            configures = ipex._C.get_int8_configures()
+            self.assertEqual(configures[0]['algorithm'], algorithm)
+            input_scales[algorithm] = configures[0]['input_scales'][0]
+        # the outlier is clipped
+        self.assertLess(input_scales['percentile'], input_scales['min_max'])
+        self.assertLess(input_scales['kl_divergence'], input_scales['min_max'])
+        self.assertLessEqual(input_scales['mse'], input_scales['min_max'])
+
+    def test_autotune(self):
+        class M(nn.Module):
+            def __init__(self):
+                super(M, self).__init__()
+                self.conv = nn.Conv2d(3, 8, 3)
+                self.linear = nn.Linear(8 * 6 * 6, 4)
+
+            def forward(self, x):
+                return self.linear(self.conv(x).flatten(1))
+
+        m = M().eval()
+        inputs = [torch.rand(2, 3, 8, 8) for _ in range(2)]
+        conf = ipex.quantization.autotune(m, inputs, tolerance=float('inf'), iterations=1)
+        configures = ipex._C.get_int8_configures()
+        self.assertTrue(any(any(c['inputs_quantized']) for c in configures))
+        # no model is within a negative tolerance, all the ops are kept in fp32
+        with self.assertWarnsRegex(UserWarning, "exceeds the tolerance"):
+            conf = ipex.quantization.autotune(m, inputs, tolerance=-1., iterations=1)
+        configures = ipex._C.get_int8_configures()
+        self.assertFalse(any(any(c['inputs_quantized']) or any(c['outputs_quantized']) for c in configures))
+        with torch.no_grad():
+            trace_model = ipex.quantization.convert(m, conf, inputs[0])
+            self.assertEqual(trace_model(inputs[0]), m(inputs[0]), atol=1e-5, rtol=1e-5)
+
     def test_flatten_int8(self):
         class M(nn.Module):
             def __init__(self):
@@ -76,6 +168,57 @@ class TestIpexOps(JitLlgaTestCase):
                 .check("aten::flatten") \
                 .run(graph)
 
+    def test_propagate_quantized_tensors(self):
+        class M(nn.Module):
+            def __init__(self):
+                super(M, self).__init__()
+                self.conv1 = nn.Conv2d(3, 3, 2, padding=1, bias=True)
+                self.linear = nn.Linear(675, 32)
+
+            def forward(self, x):
+                x = self.conv1(x)
+                x = x.permute(0, 2, 3, 1).contiguous()
+                x = x.reshape(x.size(0), -1)
+                x = self.linear(x)
+                return x
+
+        m = M()
+        x = torch.rand(1, 3, 14, 14)
+        for qscheme in [torch.per_tensor_affine, torch.per_tensor_symmetric]:
+            graph = self.checkQuantizeTrace(m, [x], atol=2e-1, config_name="propagate_quant", qscheme=qscheme)
+            # the invariant ops left out of the partitions run on the
+            # quantized tensor
+            for node in graph.nodes():
+                if node.kind() in ["aten::contiguous", "aten::reshape"]:
+                    self.assertNotEqual(node.inputsAt(0).node().kind(), "aten::dequantize")
+
+    def test_int8_glue_ops(self):
+        class M(nn.Module):
+            def __init__(self):
+                super(M, self).__init__()
+                self.conv1 = nn.Conv2d(3, 8, 3, padding=1)
+                self.conv2 = nn.Conv2d(3, 8, 3, padding=1)
+                self.conv3 = nn.Conv2d(16, 8, 1)
+
+            def forward(self, x):
+                a = self.conv1(x)
+                b = self.conv2(x)
+                y = torch.cat([a, b], dim=1)
+                y = F.interpolate(y, scale_factor=2, mode='nearest')
+                y = self.conv3(y)
+                return y + F.interpolate(a, scale_factor=2, mode='nearest')
+
+        m = M()
+        x = torch.rand(2, 3, 13, 13)
+        for qscheme in [torch.per_tensor_affine, torch.per_tensor_symmetric]:
+            graph = self.checkQuantizeTrace(m, [x], atol=2e-1, config_name="glue_ops", qscheme=qscheme)
+            # the concat, upsample and add between the partitions run on the
+            # quantized tensors rather than between a dequantize and a quantize
+            for node in graph.nodes():
+                if node.kind() in ["aten::cat", "aten::upsample_nearest2d", "aten::add"]:
+                    for use in node.outputsAt(0).uses():
+                        self.assertNotEqual(use.user.kind(), "aten::quantize_per_tensor")
+
     def test_embeddingbag_int8(self):
         m = nn.EmbeddingBag(10, 3, mode='sum', sparse=True)
         input = torch.LongTensor([1,2,4,5,4,3,2,9])
@@ -95,12 +238,31 @@ class TestIpexOps(JitLlgaTestCase):
                 return x
 
         m = M()
-        inputs = []
-        for i in range(0, 27):
-            inputs.append(torch.randn([128, 128]) * 0.1)
-        for qscheme in [torch.per_tensor_symmetric]:
-            graph = self.checkQuantizeTrace(m, inputs, atol=1e-2, config_name="interaction", qscheme=qscheme)
-            self.assertGraphContainsExactly(graph, 'ipex::qinteraction', 1)
+        # the feature size of 128 of the AVX-512 kernel, and any other
+        for batch_size, vector_size in [(128, 128), (33, 80)]:
+            inputs = []
+            for i in range(0, 27):
+                inputs.append(torch.randn([batch_size, vector_size]) * 0.1)
+            for qscheme in [torch.per_tensor_symmetric]:
+                graph = self.checkQuantizeTrace(m, inputs, atol=1e-2, config_name="interaction", qscheme=qscheme)
+                self.assertGraphContainsExactly(graph, 'ipex::qinteraction', 1)
+
+    def test_lstm_int8(self):
+        class M(nn.Module):
+            def __init__(self, bidirectional, bias):
+                super(M, self).__init__()
+                self.lstm = nn.LSTM(16, 32, num_layers=2, bidirectional=bidirectional, bias=bias, batch_first=True)
+
+            def forward(self, x):
+                x, _ = self.lstm(x)
+                return x
+
+        x = torch.rand(3, 5, 16)
+        for bidirectional, bias in itertools.product([False, True], [False, True]):
+            m = M(bidirectional, bias)
+            for qscheme in [torch.per_tensor_affine, torch.per_tensor_symmetric]:
+                graph = self.checkQuantizeTrace(m, [x], atol=5e-2, config_name="lstm", qscheme=qscheme)
+                self.assertGraphContainsExactly(graph, 'torch_ipex::quantized_lstm', 1)
 
 if __name__ == '__main__':
     run_tests()
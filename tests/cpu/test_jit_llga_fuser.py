@@ -1,8 +1,11 @@
 import unittest
 import itertools
+import os
+import tempfile
 import torch
 import torch.nn as nn
 import torch.nn.functional as F
+import intel_extension_for_pytorch as ipex
 from test_jit_llga_utils import JitLlgaTestCase, run_tests, LLGA_FUSION_GROUP, llga_fp32_bf16_test_env
 from torch.testing._internal.common_utils import TEST_SCIPY
 
@@ -227,10 +230,11 @@ class TestOp(JitLlgaTestCase):
     @llga_fp32_bf16_test_env
     def test_layer_norm(self):
         # TODO: support more normalized_shape
-        m = torch.nn.LayerNorm(10)
-        x = torch.randn(2, 5, 10, 10)
-        graph, _ = self.checkTrace(m, [x])
-        self.assertGraphContainsExactly(graph, LLGA_FUSION_GROUP, 1)
+        for elementwise_affine in [True, False]:
+            m = torch.nn.LayerNorm(10, elementwise_affine=elementwise_affine)
+            x = torch.randn(2, 5, 10, 10)
+            graph, _ = self.checkTrace(m, [x])
+            self.assertGraphContainsExactly(graph, LLGA_FUSION_GROUP, 1)
 
     @llga_fp32_bf16_test_env
     @unittest.skipIf(True, 'Enable once cat is supported')
@@ -453,6 +457,28 @@ class TestFusionPattern(JitLlgaTestCase):
             self.assertGraphContainsExactly(graph, LLGA_FUSION_GROUP, 1)
             self.assertFused(graph, ['aten::' + eltwise])
 
+    @llga_fp32_bf16_test_env
+    def test_bert_ffn(self):
+        # The intermediate and output blocks of a BERT layer:
+        # linear -> gelu -> linear -> residual add -> layer_norm
+        class M(nn.Module):
+            def __init__(self):
+                super(M, self).__init__()
+                self.intermediate = nn.Linear(64, 256)
+                self.output = nn.Linear(256, 64)
+                self.layer_norm = nn.LayerNorm(64)
+
+            def forward(self, x):
+                y = F.gelu(self.intermediate(x))
+                y = self.output(y)
+                return self.layer_norm(y + x)
+
+        m = M().eval()
+        x = torch.rand(2, 16, 64)
+        graph, _ = self.checkTrace(m, [x])
+        self.assertFused(graph, ['aten::linear', 'aten::gelu', 'aten::add',
+                                 'aten::layer_norm'])
+
     @llga_fp32_bf16_test_env
     def test_conv2d_sum(self):
         class M(nn.Module):
@@ -512,6 +538,201 @@ class TestFusionPattern(JitLlgaTestCase):
         self.assertFused(graph, ['aten::_convolution', 'aten::relu'])
 
 
+    @llga_fp32_bf16_test_env
+    def test_linear_eltwise_variable_sequence_length(self):
+        class M(nn.Module):
+            def __init__(self):
+                super(M, self).__init__()
+                self.linear = nn.Linear(32, 64)
+
+            def forward(self, x):
+                return F.gelu(self.linear(x))
+
+        m = M().eval()
+        capacity = ipex._C._jit_llga_compiled_partition_cache_capacity()
+        # A small capacity makes the sequence lengths evict each other.
+        ipex._C._jit_set_llga_compiled_partition_cache_capacity(2)
+        try:
+            with torch.no_grad():
+                traced = torch.jit.freeze(torch.jit.trace(m, torch.rand(2, 8, 32)))
+                # Profile with different sequence lengths, so that the length
+                # is not specialized by the guard of the fusion group.
+                for seq_len in [8, 16]:
+                    traced(torch.rand(2, seq_len, 32))
+                graph = traced.graph_for(torch.rand(2, 8, 32))
+                self.assertGraphContainsExactly(graph, LLGA_FUSION_GROUP, 1)
+                for seq_len in [8, 16, 24, 16, 8, 24, 24]:
+                    x = torch.rand(2, seq_len, 32)
+                    self.assertEqual(m(x), traced(x))
+        finally:
+            ipex._C._jit_set_llga_compiled_partition_cache_capacity(capacity)
+
+
+    @llga_fp32_bf16_test_env
+    def test_linear_eltwise_partition_record(self):
+        class M(nn.Module):
+            def __init__(self):
+                super(M, self).__init__()
+                self.linear = nn.Linear(32, 64)
+
+            def forward(self, x):
+                return F.relu(self.linear(x))
+
+        m = M().eval()
+        x = torch.rand(4, 32)
+        with tempfile.TemporaryDirectory() as tmp:
+            ipex._C._jit_set_llga_partition_record_dir(tmp)
+            try:
+                _, traced = self.checkTrace(m, [x])
+                records = os.listdir(tmp)
+                self.assertEqual(len(records), 1)
+                with open(os.path.join(tmp, records[0])) as f:
+                    self.assertEqual(len(f.readlines()), 1)
+
+                # Another kernel of the same partition compiles the recorded
+                # signature when it is created, and doesn't record it again.
+                graph, _ = self.checkTrace(m, [x])
+                self.assertGraphContainsExactly(graph, LLGA_FUSION_GROUP, 1)
+                with open(os.path.join(tmp, records[0])) as f:
+                    self.assertEqual(len(f.readlines()), 1)
+            finally:
+                ipex._C._jit_set_llga_partition_record_dir("")
+
+    @llga_fp32_bf16_test_env
+    def test_linear_eltwise_symbolic_batch(self):
+        class M(nn.Module):
+            def __init__(self):
+                super(M, self).__init__()
+                self.linear = nn.Linear(32, 64)
+
+            def forward(self, x):
+                return F.gelu(self.linear(x))
+
+        m = M().eval()
+        ipex._C._jit_set_llga_symbolic_dims([0])
+        ipex._C._jit_clear_llga_coverage_report()
+        ipex._C._jit_set_llga_coverage_report_enabled(True)
+        try:
+            self.assertEqual(ipex._C._jit_llga_symbolic_dims(), [0])
+            with torch.no_grad():
+                traced = torch.jit.freeze(torch.jit.trace(m, torch.rand(4, 8, 32)))
+                # profiled with a single batch size only
+                for _ in range(2):
+                    traced(torch.rand(4, 8, 32))
+                graph = traced.graph_for(torch.rand(4, 8, 32))
+                self.assertGraphContainsExactly(graph, LLGA_FUSION_GROUP, 1)
+
+                def fused_calls():
+                    report = ipex._C._jit_llga_coverage_report()
+                    return sum(p['calls'] for p in report['partitions'])
+
+                calls = fused_calls()
+                batch_sizes = [7, 1, 16]
+                for bs in batch_sizes:
+                    x = torch.rand(bs, 8, 32)
+                    self.assertEqual(m(x), traced(x))
+                # the other batch sizes pass the guard and run the partition
+                self.assertEqual(fused_calls(), calls + len(batch_sizes))
+        finally:
+            ipex._C._jit_set_llga_symbolic_dims([])
+            ipex._C._jit_set_llga_coverage_report_enabled(False)
+            ipex._C._jit_clear_llga_coverage_report()
+
+    @llga_fp32_bf16_test_env
+    def test_coverage_report(self):
+        class M(nn.Module):
+            def __init__(self):
+                super(M, self).__init__()
+                self.linear = nn.Linear(32, 64)
+
+            def forward(self, x):
+                # aten::cumsum is not mapped to a oneDNN graph op
+                return F.gelu(self.linear(x)).cumsum(1)
+
+        m = M().eval()
+        x = torch.rand(4, 32)
+        ipex._C._jit_clear_llga_coverage_report()
+        ipex._C._jit_set_llga_coverage_report_enabled(True)
+        try:
+            graph, _ = self.checkTrace(m, [x])
+            self.assertGraphContainsExactly(graph, LLGA_FUSION_GROUP, 1)
+            report = ipex._C._jit_llga_coverage_report()
+        finally:
+            ipex._C._jit_set_llga_coverage_report_enabled(False)
+            ipex._C._jit_clear_llga_coverage_report()
+
+        self.assertEqual(len(report['partitions']), 1)
+        partition = report['partitions'][0]
+        self.assertEqual(partition['ops'], ['linear', 'gelu'])
+        self.assertGreater(partition['calls'], 0)
+        self.assertGreater(partition['total_time_us'], 0)
+        kinds = [node['kind'] for node in report['unsupported']]
+        self.assertIn('aten::cumsum', kinds)
+        for node in report['unsupported']:
+            self.assertTrue(node['reason'])
+
+    def test_linear_eltwise_lowering_selection(self):
+        class M(nn.Module):
+            def __init__(self):
+                super(M, self).__init__()
+                self.linear = nn.Linear(32, 64)
+
+            def forward(self, x):
+                return F.gelu(self.linear(x))
+
+        m = M().eval()
+        x = torch.rand(4, 32)
+        torch._C._jit_set_profiling_mode(True)
+        torch._C._jit_set_profiling_executor(True)
+        ipex._C._jit_clear_llga_lowering_plan()
+        ipex._C._jit_set_llga_lowering_selection_enabled(True)
+        try:
+            # linear + gelu is one kernel of the IPEX fusion pass, cheaper
+            # than the LLGA partition by the cost model
+            graph, _ = self.checkTrace(m, [x])
+            self.assertGraphContainsExactly(graph, LLGA_FUSION_GROUP, 0)
+            plan = ipex._C._jit_llga_lowering_plan()
+            self.assertEqual(list(plan.values()), ['ipex'])
+
+            # the plan loaded, e.g. with the model, overrides the cost model
+            plan = {key: 'llga' for key in plan}
+            ipex._C._jit_clear_llga_lowering_plan()
+            ipex._C._jit_set_llga_lowering_plan(plan)
+            graph, _ = self.checkTrace(m, [x])
+            self.assertGraphContainsExactly(graph, LLGA_FUSION_GROUP, 1)
+            self.assertEqual(ipex._C._jit_llga_lowering_plan(), plan)
+
+            with self.assertRaises(RuntimeError):
+                ipex._C._jit_set_llga_lowering_plan({'0': 'aten'})
+        finally:
+            ipex._C._jit_set_llga_lowering_selection_enabled(False)
+            ipex._C._jit_clear_llga_lowering_plan()
+
+    @llga_fp32_bf16_test_env
+    def test_linear_eltwise_output_reuse(self):
+        class M(nn.Module):
+            def __init__(self):
+                super(M, self).__init__()
+                self.linear = nn.Linear(32, 64)
+
+            def forward(self, x):
+                return F.gelu(self.linear(x))
+
+        m = M().eval()
+        x = torch.rand(4, 32)
+        graph, traced = self.checkTrace(m, [x])
+        self.assertGraphContainsExactly(graph, LLGA_FUSION_GROUP, 1)
+        with torch.no_grad():
+            # The output still held must not be overwritten by the next run,
+            # while the dropped one may be reused.
+            held = traced(x)
+            expected = held.clone()
+            for _ in range(3):
+                y = torch.rand(4, 32)
+                self.assertEqual(m(y), traced(y))
+                self.assertEqual(held, expected)
+
+
 class TestModel(JitLlgaTestCase):
     @skipIfNoTorchVision
     @llga_fp32_bf16_test_env
@@ -83,6 +83,20 @@ class TestOp(JitLlgaTestCase):
                 self.assertFused(graph, ['aten::linear', 'aten::dequantize'])
                 self.checkPatterns(graph, patterns)
 
+    def test_linear_int8_weight_cache(self):
+        self.assertTrue(ipex._C._jit_llga_weight_cache_enabled())
+        x = torch.rand(32, 28)
+        m = torch.nn.Linear(in_features=28, out_features=64)
+        for enabled in [True, False]:
+            ipex._C._jit_set_llga_weight_cache_enabled(enabled)
+            try:
+                # checkQuantizeTrace runs the compiled partition several
+                # times, the later runs take the cached weight if enabled.
+                graph = self.checkQuantizeTrace(m, [x], atol=1e-1, config_name="linear")
+                self.assertGraphContainsExactly(graph, LLGA_FUSION_GROUP, 1)
+            finally:
+                ipex._C._jit_set_llga_weight_cache_enabled(True)
+
     def test_linear_int8_in_int8_out(self):
         class M(nn.Module):
             def __init__(self, bias):
@@ -833,6 +847,41 @@ class TestFusionPattern(JitLlgaTestCase):
         self.assertFused(graph, ['aten::matmul', 'aten::dequantize', 'aten::quantize_per_tensor', 'aten::div', 'aten::add'])
         self.checkPatterns(graph, patterns)
 
+    def test_mha_int8_bf16(self):
+        class M(nn.Module):
+            def __init__(self):
+                super(M, self).__init__()
+                self.num_attention_heads = 16
+                self.attention_head_size = 4
+
+            def transpose_for_scores(self, x):
+                new_x_shape = x.size()[:-1] + (self.num_attention_heads, self.attention_head_size)
+                x = x.view(*new_x_shape)
+                return x.permute(0, 2, 1, 3)
+
+            def forward(self, q, k, v, mask):
+                q = self.transpose_for_scores(q)
+                k = self.transpose_for_scores(k)
+                v = self.transpose_for_scores(v)
+                s = torch.matmul(q, k.transpose(-1, -2)) / 0.4
+                s = s + mask.to(s.dtype)
+                p = nn.functional.softmax(s, dim=-1)
+                # the attention probs are quantized as the input of the
+                # second matmul
+                return torch.matmul(p, v)
+
+        m = M()
+        q = torch.randn(2, 3, 64)
+        k = torch.randn(2, 3, 64)
+        v = torch.randn(2, 3, 64)
+        mask = torch.randn(2, 1, 1, 3)
+
+        graph = self.checkQuantizeTrace(m, [q, k, v, mask], atol=2e-1, config_name="mha_int8_bf16", qscheme=torch.per_tensor_affine, int8_bf16=True)
+        # Both matmuls of the attention run in int8 partitions, instead of
+        # the fp32 scores calculation of ipex::mha_scores_calc.
+        self.assertGraphContainsExactly(graph, "ipex::mha_scores_calc", 0)
+        self.assertFused(graph, ['aten::matmul', 'aten::dequantize', 'aten::div', 'aten::add'])
+
     def test_split_dequant_to(self):
         class M(nn.Module):
             def __init__(self):
@@ -5,6 +5,15 @@ import time, sys
 from intel_extension_for_pytorch.cpu.launch import *
 import os
 import glob
+import tempfile
+
+def parse_args_for_test(argv):
+    sys_argv = sys.argv
+    sys.argv = ["launch.py"] + argv
+    try:
+        return parse_args()
+    finally:
+        sys.argv = sys_argv
 
 class TestLauncher(TestCase):
     def del_env(self, env_name):
@@ -68,6 +77,38 @@ class TestLauncher(TestCase):
        expect_ccl_worker_affinity = "0,1,2,3,28,29,30,31"
        self.assertEqual(ccl_worker_affinity, expect_ccl_worker_affinity)
 
+    def test_autotune_candidates_and_metrics(self):
+       launcher = MultiInstanceLauncher()
+       args = parse_args_for_test(["--autotune", "test.py"])
+       self.assertEqual(launcher.autotune_candidates(args, 28), [1, 2, 4, 7, 14, 28])
+       args = parse_args_for_test(["--autotune", "--autotune_candidates", "2,4", "test.py"])
+       self.assertEqual(launcher.autotune_candidates(args, 28), [2, 4])
+       # 2 instances, 10 samples/s each
+       records = [[(0.1, 1)] * 100, [(0.2, 2)] * 100]
+       throughput, p99 = launcher.autotune_metrics(records, 2, 30.0)
+       self.assertAlmostEqual(throughput, 20.0)
+       self.assertAlmostEqual(p99, 0.2)
+       # Fall back to the wall time if nothing is recorded
+       throughput, p99 = launcher.autotune_metrics([[], []], 2, 4.0)
+       self.assertAlmostEqual(throughput, 0.5)
+       self.assertAlmostEqual(p99, 4.0)
+
+    def test_autotune_record(self):
+       with tempfile.TemporaryDirectory() as tmp_dir:
+           path = os.path.join(tmp_dir, "records.txt")
+           os.environ["IPEX_AUTOTUNE_RECORD_FILE"] = path
+           try:
+               ipex.cpu.autotune.record(0.5, batch_size=4)
+               ipex.cpu.autotune._record_file.flush()
+           finally:
+               del os.environ["IPEX_AUTOTUNE_RECORD_FILE"]
+               ipex.cpu.autotune._record_file.close()
+               ipex.cpu.autotune._record_file = None
+           self.assertEqual(ipex.cpu.autotune.read_records(path), [(0.5, 4)])
+       # No-op outside the autotune runs
+       ipex.cpu.autotune.record(0.5)
+       self.assertIsNone(ipex.cpu.autotune._record_file)
+
 
 if __name__ == '__main__':
     test = unittest.main()
@@ -1,52 +1,76 @@
-import unittest
-
-import torch
-import intel_extension_for_pytorch as ipex
-from common_utils import TestCase
-
-
-class M1(torch.nn.Module):
-    def __init__(self):
-        super(M1, self).__init__()
-        self.conv = torch.nn.Conv2d(5, 5, 1, stride=1, bias=False)
-        self.layer_norm = torch.nn.LayerNorm(10)
-
-    def forward(self, x):
-        x = self.conv(x)
-        x = self.layer_norm(x)
-        return x
-
-class M2(torch.nn.Module):
-    def __init__(self):
-        super(M2, self).__init__()
-        self.layer_norm = torch.nn.LayerNorm(10)
-
-    def forward(self, x):
-        x = self.layer_norm(x)
-        return x
-
-class LayerNormTester(TestCase):
-    def test_layer_norm(self):
-        # autocast inference path. layer_norm is fallthrough.
-        with torch.cpu.amp.autocast(), torch.no_grad():
-            x = torch.randn(20, 5, 10, 10)
-            # layernorm input is bfloat16
-            model = M1().eval()
-            trace_model = torch.jit.trace(model, x)
-            y1_bf16 = model(x)
-            y2_bf16 = trace_model(x)
-            self.assertEqual(y1_bf16.dtype, torch.bfloat16)
-            self.assertEqual(y2_bf16.dtype, torch.bfloat16)
-            self.assertEqual(y1_bf16, y2_bf16)
-
-            # layernorm input is fp32
-            model = M2().eval()
-            trace_model = torch.jit.trace(model, x)
-            y1_fp32 = model(x)
-            y2_fp32 = trace_model(x)
-            self.assertEqual(y1_fp32.dtype, torch.float32)
-            self.assertEqual(y2_fp32.dtype, torch.float32)
-            self.assertEqual(y1_fp32, y2_fp32)
-
-if __name__ == '__main__':
-    test = unittest.main()
+import unittest
+
+import torch
+import intel_extension_for_pytorch as ipex
+from common_utils import TestCase
+
+
+class M1(torch.nn.Module):
+    def __init__(self):
+        super(M1, self).__init__()
+        self.conv = torch.nn.Conv2d(5, 5, 1, stride=1, bias=False)
+        self.layer_norm = torch.nn.LayerNorm(10)
+
+    def forward(self, x):
+        x = self.conv(x)
+        x = self.layer_norm(x)
+        return x
+
+class M2(torch.nn.Module):
+    def __init__(self):
+        super(M2, self).__init__()
+        self.layer_norm = torch.nn.LayerNorm(10)
+
+    def forward(self, x):
+        x = self.layer_norm(x)
+        return x
+
+class LayerNormTester(TestCase):
+    def test_layer_norm(self):
+        # autocast inference path. layer_norm is fallthrough.
+        with torch.cpu.amp.autocast(), torch.no_grad():
+            x = torch.randn(20, 5, 10, 10)
+            # layernorm input is bfloat16
+            model = M1().eval()
+            trace_model = torch.jit.trace(model, x)
+            y1_bf16 = model(x)
+            y2_bf16 = trace_model(x)
+            self.assertEqual(y1_bf16.dtype, torch.bfloat16)
+            self.assertEqual(y2_bf16.dtype, torch.bfloat16)
+            self.assertEqual(y1_bf16, y2_bf16)
+
+            # layernorm input is fp32
+            model = M2().eval()
+            trace_model = torch.jit.trace(model, x)
+            y1_fp32 = model(x)
+            y2_fp32 = trace_model(x)
+            self.assertEqual(y1_fp32.dtype, torch.float32)
+            self.assertEqual(y2_fp32.dtype, torch.float32)
+            self.assertEqual(y1_fp32, y2_fp32)
+
+    def test_layer_norm_bf16_input_training(self):
+        # the bf16 input of the fp32 weight and bias is converted in the kernel
+        for shape in [(20, 5, 10), (4, 3, 37)]:
+            x = torch.randn(shape).bfloat16().requires_grad_()
+            ref_x = x.detach().float().requires_grad_()
+            layer_norm = torch.nn.LayerNorm(shape[-1])
+            ref_layer_norm = torch.nn.LayerNorm(shape[-1])
+            with torch.no_grad():
+                layer_norm.weight.uniform_()
+                layer_norm.bias.uniform_()
+                ref_layer_norm.weight.copy_(layer_norm.weight)
+                ref_layer_norm.bias.copy_(layer_norm.bias)
+            y = layer_norm(x)
+            ref_y = ref_layer_norm(ref_x)
+            self.assertEqual(y.dtype, torch.bfloat16)
+            self.assertEqual(y, ref_y.bfloat16(), rtol=1e-2, atol=1e-2)
+            grad = torch.randn(shape)
+            y.backward(grad.bfloat16())
+            ref_y.backward(grad.bfloat16().float())
+            self.assertEqual(x.grad.dtype, torch.bfloat16)
+            self.assertEqual(x.grad, ref_x.grad.bfloat16(), rtol=1e-2, atol=1e-2)
+            self.assertEqual(layer_norm.weight.grad, ref_layer_norm.weight.grad, rtol=1e-2, atol=1e-2)
+            self.assertEqual(layer_norm.bias.grad, ref_layer_norm.bias.grad, rtol=1e-2, atol=1e-2)
+
+if __name__ == '__main__':
+    test = unittest.main()
@@ -3,6 +3,7 @@ import torch
 import intel_extension_for_pytorch as ipex
 from torch.testing._internal.common_utils import TestCase
 import copy
+import math
 
 class MLP(torch.nn.Module):
 
@@ -44,5 +45,45 @@ class TestLinearFuseEltwise(TestCase):
             self.assertEqual(out, ref_out)
             self.assertEqual(x1.grad, x2.grad)
 
+    def test_linear_fuse_gelu(self):
+        x1 = torch.rand(5, 10).requires_grad_()
+        x2 = copy.deepcopy(x1)
+        model = torch.nn.Sequential(torch.nn.Linear(10, 32), torch.nn.GELU())
+        opt = torch.optim.SGD(model.parameters(), lr=0.01)
+        model, opt = ipex.optimize(model, optimizer=opt, dtype=torch.float, auto_kernel_selection=True)
+        for eltwise in ['gelu', 'gelu_tanh']:
+            x1.grad = None
+            x2.grad = None
+            y = model[0](x1)
+            if eltwise == 'gelu':
+                ref_out = model[1](y)
+            else:
+                ref_out = 0.5 * y * (1.0 + torch.tanh(math.sqrt(2.0 / math.pi) * (y + 0.044715 * torch.pow(y, 3.0))))
+            ref_out.sum().backward()
+            fused = ipex.nn.modules.IPEXLinearEltwise(copy.deepcopy(model[0]), eltwise)
+            out = fused(x2)
+            out.sum().backward()
+            self.assertEqual(out, ref_out)
+            self.assertEqual(x1.grad, x2.grad)
+            with torch.no_grad():
+                self.assertEqual(fused(x2), ref_out, atol=1e-5, rtol=1e-5)
+
+    def test_optimize_linear_gelu(self):
+        model = torch.nn.Sequential(torch.nn.Linear(10, 32), torch.nn.GELU(), torch.nn.Linear(32, 10)).eval()
+        x = torch.rand(5, 10)
+        for dtype in [torch.float, torch.bfloat16]:
+            optimized_model = ipex.optimize(model, dtype=dtype, auto_kernel_selection=True)
+            self.assertTrue(isinstance(optimized_model[0], ipex.nn.modules.linear_fuse_eltwise._IPEXLinearGelu))
+            self.assertTrue(isinstance(optimized_model[1], torch.nn.Identity))
+            with torch.no_grad(), torch.cpu.amp.autocast(enabled=(dtype == torch.bfloat16)):
+                ref_out = model(x)
+                out = optimized_model(x)
+            prec = 2e-2 if dtype == torch.bfloat16 else 1e-5
+            self.assertEqual(out.float(), ref_out.float(), atol=prec, rtol=prec)
+            # the traced graph keeps aten::gelu for the JIT fusions
+            with torch.no_grad():
+                traced = torch.jit.trace(optimized_model, x.to(dtype))
+            self.assertTrue(any(n.kind() == 'aten::gelu' for n in traced.graph.nodes()))
+
 if __name__ == '__main__':
     test = unittest.main()
@@ -0,0 +1,66 @@
+import copy
+import unittest
+import torch
+import torch.nn as nn
+import intel_extension_for_pytorch as ipex
+from common_utils import TestCase
+
+class TestMemoryStats(TestCase):
+    def tearDown(self):
+        ipex.set_memory_budget(None)
+
+    def test_caches(self):
+        stats = ipex.memory_stats()
+        self.assertEqual(stats['budget_bytes'], -1)
+        for name in ['packed_weights', 'autocast_casts', 'ideep_primitive_descs',
+                     'scratchpad_arenas', 'llga_compiled_partitions', 'lstm_workspaces']:
+            self.assertIn(name, stats['caches'])
+        self.assertEqual(stats['bytes'], sum(cache['bytes'] for cache in stats['caches'].values()))
+        self.assertGreaterEqual(stats['peak_bytes'], stats['bytes'])
+        self.assertFalse(stats['caches']['scratchpad_arenas']['evictable'])
+
+    def test_autocast_casts(self):
+        model = nn.Linear(64, 32)
+        x = torch.randn(4, 64)
+        with torch.cpu.amp.autocast():
+            model(x).sum().backward()
+        cache = ipex.memory_stats()['caches']['autocast_casts']
+        self.assertGreaterEqual(cache['entries'], 1)
+        self.assertGreaterEqual(cache['bytes'], model.weight.numel() * 2)
+
+        # the budget evicts the casts, which are cast again on the next use
+        ipex.set_memory_budget(0)
+        cache = ipex.memory_stats()['caches']['autocast_casts']
+        self.assertEqual(cache['entries'], 0)
+        self.assertGreater(cache['evicted_bytes'], 0)
+        with torch.cpu.amp.autocast():
+            y = model(x)
+        self.assertEqual(y.dtype, torch.bfloat16)
+
+    def test_packed_weights(self):
+        model = nn.LSTM(16, 32, num_layers=2).eval()
+        x = torch.randn(5, 3, 16)
+        with torch.no_grad():
+            y_ref = model(x)[0]
+        ipex_model = ipex.optimize(copy.deepcopy(model), dtype=torch.float32, optimize_lstm=True)
+        ipex.release_packed_weights()
+        with torch.no_grad():
+            ipex_model(x)
+        cache = ipex.memory_stats()['caches']['packed_weights']
+        if cache['entries'] == 0:
+            self.skipTest("The LSTM weights are not packed on this ISA")
+        self.assertEqual(cache['bytes'], ipex.get_packed_weight_cache_stats()['cached_bytes'])
+
+        ipex.set_memory_budget(0)
+        self.assertEqual(ipex.memory_stats()['caches']['packed_weights']['entries'], 0)
+        with torch.no_grad():
+            y = ipex_model(x)[0]
+        self.assertEqual(y_ref, y)
+
+    def test_reset_peak(self):
+        ipex.reset_peak_memory_stats()
+        stats = ipex.memory_stats()
+        self.assertEqual(stats['peak_bytes'], stats['bytes'])
+
+if __name__ == '__main__':
+    test = unittest.main()
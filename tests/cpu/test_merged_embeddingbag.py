@@ -4,6 +4,8 @@ import unittest
 import copy
 from torch.testing._internal.common_utils import TestCase
 from intel_extension_for_pytorch.nn.modules import MergedEmbeddingBagWithSGD as MergedEmbeddingBagWithSGD
+from intel_extension_for_pytorch.nn.modules import MergedEmbeddingBagWithRowwiseAdagrad, MergedEmbeddingBagWithAdam, \
+    MergedEmbeddingBagWithLAMB
 
 class TestMergedEmbeddingBagWithSGD(TestCase):
 
@@ -65,6 +67,109 @@ class TestMergedEmbeddingBagWithSGD(TestCase):
             trace_model = torch.jit.trace(model, [self.expected_input, torch.BoolTensor([False])])
         self._test_inference_only(trace_model)
 
+    def test_inference_skewed_pooling(self):
+        # tables of pooling factor 1 and 100, of the same batch size
+        batch_size = 64
+        tables = [nn.EmbeddingBag(1000, 16, mode='sum'), nn.EmbeddingBag(1000, 64, mode='mean'), nn.EmbeddingBag(1000, 16, mode='sum')]
+        pooling_factors = [1, 100, 3]
+        indices, offsets, ref_outputs = [], [], []
+        offset = 0
+        for table, pooling_factor in zip(tables, pooling_factors):
+            lengths = torch.randint(1, pooling_factor + 1, (batch_size,))
+            table_offsets = torch.cat([torch.zeros(1, dtype=torch.long), torch.cumsum(lengths, 0)[:-1]])
+            table_indices = torch.randint(1000, (int(lengths.sum()),))
+            with torch.no_grad():
+                ref_outputs.append(table(table_indices, table_offsets))
+            indices.append(table_indices)
+            offsets.append(table_offsets + offset)
+            offset += table_indices.numel()
+        offsets.append(torch.LongTensor([offset]))
+        outputs = torch.ops.torch_ipex.merged_embeddingbag_forward(
+            torch.cat(indices), torch.cat(offsets), [t.weight.detach() for t in tables], [0, 1, 0])
+        for output, ref_output in zip(outputs, ref_outputs):
+            self.assertEqual(output, ref_output)
+
+    def test_inference_rowwise_quantized(self):
+        tables = [nn.EmbeddingBag(100, 16, mode='mean'), nn.EmbeddingBag(50, 32, mode='sum'), nn.EmbeddingBag(200, 64, mode='sum')]
+        indices = [torch.randint(100, (12,)), torch.randint(50, (6,)), torch.randint(200, (9,))]
+        offsets = [torch.LongTensor([0, 5, 12]), torch.LongTensor([0, 1, 3]), torch.LongTensor([0, 0, 4])]
+        unpacks = {
+            8: torch.ops.quantized.embedding_bag_byte_unpack,
+            4: torch.ops.quantized.embedding_bag_4bit_unpack
+        }
+        for bits in [8, 4]:
+            model = MergedEmbeddingBagWithSGD.from_embeddingbag_list(copy.deepcopy(tables)).to_rowwise_quantized(bits)
+            self.assertTrue(all(w.dtype == torch.uint8 for w in model.weights))
+            with torch.no_grad():
+                outputs = model((indices, offsets, [False, False, False]))
+            for i, table in enumerate(tables):
+                dequantized = unpacks[bits](model.weights[i])
+                ref_output = torch.nn.functional.embedding_bag(indices[i], dequantized, offsets[i], mode=table.mode)
+                self.assertEqual(outputs[i].dtype, torch.float)
+                self.assertEqual(outputs[i], ref_output, rtol=1e-5, atol=1e-5)
+
+    def test_inference_hot_row_cache(self):
+        tables = [nn.EmbeddingBag(100, 16, mode='mean'), nn.EmbeddingBag(50, 40, mode='sum').bfloat16()]
+        # skewed to the first rows of each table
+        indices = [torch.LongTensor([0, 1, 0, 2, 0, 77, 1, 0]), torch.LongTensor([3, 3, 49, 3, 3, 7])]
+        offsets = [torch.LongTensor([0, 3, 6]), torch.LongTensor([0, 2, 3])]
+        include_last_offsets = [False, False]
+        with torch.no_grad():
+            ref_outputs = [table(idx, offset) for table, idx, offset in zip(tables, indices, offsets)]
+        model = MergedEmbeddingBagWithSGD.from_embeddingbag_list(copy.deepcopy(tables)).enable_hot_row_cache(2)
+        with torch.no_grad():
+            model((indices, offsets, include_last_offsets))
+            model.refresh_hot_row_cache()
+            outputs = model((indices, offsets, include_last_offsets))
+        self.assertEqual(model.hot_weights[0].shape, torch.Size([2, 16]))
+        self.assertEqual(model.hot_weights[1].stride(0), 64)
+        self.assertEqual(model.hot_slots[0][0], 0)
+        self.assertEqual(model.hot_slots[1][3], 0)
+        self.assertEqual(model.hot_slots[0][77], -1)
+        for output, ref_output in zip(outputs, ref_outputs):
+            self.assertEqual(output, ref_output)
+
+    def test_inference_dedup(self):
+        shared = nn.EmbeddingBag(100, 16, mode='sum')
+        tables = [shared, nn.EmbeddingBag(50, 40, mode='mean').bfloat16(), shared]
+        # repeated within and across the tables of the same weight
+        indices = [torch.LongTensor([5, 1, 5, 5, 9, 1]), torch.LongTensor([3, 3, 3, 7]), torch.LongTensor([1, 5, 2])]
+        offsets = [torch.LongTensor([0, 3, 4]), torch.LongTensor([0, 0, 2]), torch.LongTensor([0, 1, 3])]
+        include_last_offsets = [False, False, False]
+        with torch.no_grad():
+            ref_outputs = [table(idx, offset) for table, idx, offset in zip(tables, indices, offsets)]
+        model = MergedEmbeddingBagWithSGD.from_embeddingbag_list(tables).enable_dedup()
+        model.weights[2] = model.weights[0]
+        with torch.no_grad():
+            outputs = model((indices, offsets, include_last_offsets))
+        for output, ref_output in zip(outputs, ref_outputs):
+            self.assertEqual(output, ref_output)
+        model.to_rowwise_quantized(8)
+        ref_outputs = model.enable_dedup(False)((indices, offsets, include_last_offsets))
+        outputs = model.enable_dedup()((indices, offsets, include_last_offsets))
+        for output, ref_output in zip(outputs, ref_outputs):
+            self.assertEqual(output, ref_output)
+
+    def test_inference_mmap_weight(self):
+        import tempfile
+        tables = [nn.EmbeddingBag(1000, 16, mode='sum'), nn.EmbeddingBag(300, 64, mode='mean')]
+        indices = [torch.randint(1000, (10,)), torch.randint(300, (7,))]
+        offsets = [torch.LongTensor([0, 4, 9]), torch.LongTensor([0, 2, 5])]
+        input = (indices, offsets, [False, False])
+        with tempfile.TemporaryDirectory() as path:
+            weights = []
+            for i, table in enumerate(tables):
+                file_name = "{}/table{}.bin".format(path, i)
+                table.weight.detach().numpy().tofile(file_name)
+                weights.append(MergedEmbeddingBagWithSGD.mmap_weight(file_name, *table.weight.shape))
+            model = MergedEmbeddingBagWithSGD([
+                (t.weight.shape[0], t.weight.shape[1], t.mode, torch.float, w) for t, w in zip(tables, weights)])
+            with torch.no_grad():
+                model.prefetch(input)
+                outputs = model(input)
+                for output, table, idx, offset in zip(outputs, tables, indices, offsets):
+                    self.assertEqual(output, table(idx, offset))
+
     def get_local_indice(self, indice):
         table_id = 0
         while (indice >= self.merged.row_offsets[table_id + 1]):
@@ -118,6 +223,59 @@ class TestMergedEmbeddingBagWithSGD(TestCase):
             )
             self.assertEqual(updated_weights[table_id][logical_indice], ref_updated_weight, rtol=0.01, atol=0.01)
 
+    def _fused_optimizer_inputs(self):
+        tables = [nn.EmbeddingBag(20, 8, mode='sum', sparse=True), nn.EmbeddingBag(30, 16, mode='mean', sparse=True)]
+        indices = [torch.LongTensor([1, 2, 1, 5, 7]), torch.LongTensor([0, 29, 3, 3])]
+        offsets = [torch.LongTensor([0, 2]), torch.LongTensor([0, 1])]
+        return tables, (indices, offsets, [False, False])
+
+    def test_training_adam(self):
+        tables, input = self._fused_optimizer_inputs()
+        model = MergedEmbeddingBagWithAdam.from_embeddingbag_list(copy.deepcopy(tables), lr=0.1)
+        ref_optimizer = torch.optim.SparseAdam(
+            [p for t in tables for p in t.parameters()], lr=0.1)
+        for _ in range(2):
+            outputs = model(input)
+            sum(o.sum() for o in outputs).backward()
+            ref_optimizer.zero_grad()
+            sum(t(idx, offset).sum() for t, idx, offset in zip(tables, input[0], input[1])).backward()
+            ref_optimizer.step()
+        for weight, table in zip(model.weights, tables):
+            self.assertEqual(weight, table.weight, rtol=1e-5, atol=1e-5)
+
+    def test_training_rowwise_adagrad(self):
+        tables, input = self._fused_optimizer_inputs()
+        lr, eps = 0.1, 1e-10
+        model = MergedEmbeddingBagWithRowwiseAdagrad.from_embeddingbag_list(copy.deepcopy(tables), lr=lr, eps=eps)
+        outputs = model(input)
+        sum(o.sum() for o in outputs).backward()
+        for i, table in enumerate(tables):
+            table(input[0][i], input[1][i]).sum().backward()
+            grad = table.weight.grad.to_dense()
+            momentum = grad.pow(2).mean(dim=1)
+            ref_weight = table.weight - (lr / (momentum.sqrt() + eps)).unsqueeze(1) * grad
+            self.assertEqual(model.weights[i], ref_weight, rtol=1e-5, atol=1e-5)
+            self.assertEqual(model.optimizer_args.momentum[i], momentum)
+
+    def test_training_lamb(self):
+        tables, input = self._fused_optimizer_inputs()
+        lr, eps, weight_decay = 0.1, 1e-6, 0.01
+        model = MergedEmbeddingBagWithLAMB.from_embeddingbag_list(
+            copy.deepcopy(tables), lr=lr, eps=eps, weight_decay=weight_decay)
+        outputs = model(input)
+        sum(o.sum() for o in outputs).backward()
+        for i, table in enumerate(tables):
+            table(input[0][i], input[1][i]).sum().backward()
+            grad = table.weight.grad.to_dense()
+            rows = grad.abs().sum(dim=1) > 0
+            weight = table.weight.detach()
+            # the first step of the bias corrected moments is grad / (|grad| + eps)
+            update = grad / (grad.abs() + eps) + weight_decay * weight
+            trust_ratio = weight.norm(dim=1) / update.norm(dim=1)
+            ref_weight = weight - lr * trust_ratio.unsqueeze(1) * update
+            ref_weight[~rows] = weight[~rows]
+            self.assertEqual(model.weights[i], ref_weight, rtol=1e-5, atol=1e-5)
+
     def test_cast_bfloat16(self):
         model = copy.deepcopy(self.merged)
         model.to_bfloat16_train()
@@ -13,6 +13,7 @@ batch_score_nms = torch.ops.torch_ipex.batch_score_nms
 parallel_scale_back_batch = torch.ops.torch_ipex.parallel_scale_back_batch
 rpn_nms = torch.ops.torch_ipex.rpn_nms
 box_head_nms = torch.ops.torch_ipex.box_head_nms
+detection_postprocess = torch.ops.torch_ipex.detection_postprocess
 
 def get_rand_seed():
     return int(time.time() * 1000000000)
@@ -208,6 +209,26 @@ class TestNMS(TestCase):
             self.assertEqual(label, label2)
             self.assertTrue(torch.allclose(prob, prob2, rtol=1e-4, atol=1e-4))
 
+    def test_detection_postprocess_result(self):
+        scale_xy = 0.1
+        scale_wh = 0.2
+        criteria = 0.50
+        max_output = 200
+        predicted_loc = torch.load(os.path.join(os.path.dirname(__file__), "data/nms_ploc.pt")) # sizes: [1, 15130, 4]
+        predicted_score = torch.load(os.path.join(os.path.dirname(__file__), "data/nms_plabel.pt")) # sizes: [1, 15130, 81]
+        dboxes_xywh = torch.load(os.path.join(os.path.dirname(__file__), "data/nms_dboxes_xywh.pt"))
+        # two images to cover the output of each image
+        predicted_loc = torch.cat([predicted_loc, predicted_loc.flip(1)])
+        predicted_score = torch.cat([predicted_score, predicted_score.flip(1)])
+        bboxes, probs = parallel_scale_back_batch(predicted_loc, predicted_score, dboxes_xywh, scale_xy, scale_wh)
+        output_ref = batch_score_nms(bboxes, probs, criteria, max_output)
+        output = detection_postprocess(predicted_loc, predicted_score, dboxes_xywh, scale_xy, scale_wh, criteria, max_output)
+
+        self.assertEqual(output[3], output_ref[3])
+        self.assertTrue(torch.allclose(output[0], output_ref[0], rtol=1e-4, atol=1e-4))
+        self.assertEqual(output[1], output_ref[1])
+        self.assertTrue(torch.allclose(output[2], output_ref[2], rtol=1e-4, atol=1e-4))
+
     def test_nms_kernel_result(self):
         batch_size = 1
         class_number = 81
@@ -249,6 +270,38 @@ class TestNMS(TestCase):
                 self.assertTrue(torch.allclose(bbox_keep, bbox_keep_ref2, rtol=1e-4, atol=1e-4))
                 self.assertTrue(torch.allclose(score_keep, score_keep_ref2, rtol=1e-4, atol=1e-4))
 
+    def _nms_org(self, dets, scores, threshold):
+        order = scores.argsort(descending=True)
+        areas = (dets[:, 2] - dets[:, 0] + 1) * (dets[:, 3] - dets[:, 1] + 1)
+        suppressed = torch.zeros(dets.size(0), dtype=torch.bool)
+        for _i in range(order.size(0)):
+            i = order[_i]
+            if suppressed[i]:
+                continue
+            j = order[_i + 1:]
+            w = (torch.min(dets[i, 2], dets[j, 2]) - torch.max(dets[i, 0], dets[j, 0]) + 1).clamp(min=0)
+            h = (torch.min(dets[i, 3], dets[j, 3]) - torch.max(dets[i, 1], dets[j, 1]) + 1).clamp(min=0)
+            inter = w * h
+            suppressed[j[inter / (areas[i] + areas[j] - inter) >= threshold]] = True
+        return (~suppressed).nonzero().squeeze(1)
+
+    def test_nms_kernel_blocks(self):
+        # more boxes than a block of the suppression masks, with a tail of the
+        # 64-box masks
+        torch.manual_seed(0)
+        for ndets in [1, 63, 2500]:
+            xy = torch.rand(ndets, 2) * 200
+            wh = torch.rand(ndets, 2) * 40
+            dets = torch.cat([xy, xy + wh], 1)
+            scores = torch.rand(ndets)
+            result_ref = self._nms_org(dets, scores, 0.5)
+            for dtype in [torch.float32, torch.float64]:
+                result = nms(dets.to(dtype), scores.to(dtype), 0.5)
+                self.assertEqual(result, result_ref)
+                score_sorted, indices = torch.sort(scores, descending=True)
+                result_sorted = nms(dets.index_select(0, indices).to(dtype), score_sorted.to(dtype), 0.5, True)
+                self.assertEqual(indices[result_sorted].sort()[0], result_ref)
+
     def test_rpn_nms_result(self):
         image_shapes = [(800, 824), (800, 1199)]
         min_size = 0
@@ -0,0 +1,79 @@
+import unittest
+import copy
+import warnings
+import torch
+import torch.nn as nn
+import intel_extension_for_pytorch as ipex
+from common_utils import TestCase
+
+class TestOpTrace(TestCase):
+    def test_op_trace(self):
+        model = nn.Linear(64, 32).eval()
+        x = torch.randn(16, 64)
+        with torch.no_grad():
+            traced_model = torch.jit.freeze(torch.jit.trace(ipex.optimize(model, dtype=torch.float32), x))
+            traced_model(x)
+            # not traced out of the scope
+            traced_model(x)
+            with ipex.op_trace() as trace:
+                for _ in range(4):
+                    traced_model(x)
+            traced_model(x)
+        records = [r for r in trace.records() if r['op'] == 'ipex_prepack::linear_run']
+        self.assertEqual(len(records), 4)
+        for r in records:
+            self.assertEqual(r['shapes'], '[16, 64]')
+            self.assertEqual(r['dtype'], 'Float')
+            self.assertEqual(r['kernel'], 'onednn')
+            self.assertGreater(r['duration_ns'], 0)
+        stats = trace.stats()['ipex_prepack::linear_run']
+        self.assertEqual(stats['count'], 4)
+        self.assertEqual(sum(stats['histogram']), 4)
+        self.assertTrue(stats['min_ns'] <= stats['max_ns'] <= stats['total_ns'])
+
+    def test_op_trace_sample_rate(self):
+        emb = nn.EmbeddingBag(100, 16, mode='sum')
+        model = ipex.optimize(copy.deepcopy(emb).eval(), dtype=torch.float32)
+        indices = torch.randint(0, 100, (20,))
+        offsets = torch.arange(0, 20, 2)
+        with torch.no_grad():
+            with ipex.op_trace(sample_rate=0.25, buffer_size=2) as trace:
+                for _ in range(400):
+                    model(indices, offsets)
+        # the calls are sampled at random
+        count = trace.stats()['IPEXEmbeddingBagOp::_forward']['count']
+        self.assertTrue(50 < count < 200)
+        # only the last records of the buffer are kept
+        self.assertEqual(len(trace.records()), 2)
+        # cleared by the next trace
+        with ipex.op_trace():
+            pass
+        self.assertEqual(trace.records(), [])
+
+    def test_op_trace_perf_counters(self):
+        model = nn.Linear(256, 256).eval()
+        x = torch.randn(64, 256)
+        with torch.no_grad():
+            traced_model = torch.jit.freeze(torch.jit.trace(ipex.optimize(model, dtype=torch.float32), x))
+            traced_model(x)
+            with warnings.catch_warnings(record=True) as caught:
+                warnings.simplefilter('always')
+                with ipex.op_trace(perf_counters=True) as trace:
+                    for _ in range(4):
+                        traced_model(x)
+        if caught:
+            self.skipTest("perf_event is not available")
+        stats = trace.stats()['ipex_prepack::linear_run']
+        self.assertGreater(stats['counters']['cycles'], 0)
+        self.assertGreater(stats['counters']['instructions'], 0)
+        self.assertGreater(stats['metrics']['ipc'], 0)
+        for r in trace.records():
+            self.assertGreaterEqual(r['counters']['cycles'], 0)
+        # not counted without the option
+        with torch.no_grad():
+            with ipex.op_trace() as trace:
+                traced_model(x)
+        self.assertEqual(trace.stats()['ipex_prepack::linear_run']['counters'], {})
+
+if __name__ == '__main__':
+    test = unittest.main()
@@ -1,5 +1,6 @@
 import torch
 import intel_extension_for_pytorch as ipex  # flake8: noqa
+import copy
 import itertools
 import unittest
 from torch.testing._internal.common_utils import TestCase
@@ -38,6 +39,28 @@ class TestOptimizers(TestCase):
                 dampening=dampening, nesterov=nesterov)
             self._test_update(M, sgd, dtype)
 
+    def test_sgd_momentum_packed_weights(self):
+        for dtype, nesterov in itertools.product([torch.float, torch.bfloat16], [False, True]):
+            M = TestModule()
+            sgd = torch.optim.SGD(M.parameters(), lr=0.01, momentum=0.9, weight_decay=0.1, nesterov=nesterov)
+            ipex_module, ipex_optimizer = ipex.optimize(
+                M, dtype=dtype,
+                optimizer=torch.optim.SGD(M.parameters(), lr=0.01, momentum=0.9, weight_decay=0.1, nesterov=nesterov))
+            for _ in range(2):
+                with torch.cpu.amp.autocast(enabled=True, dtype=dtype):
+                    M.attach_grad()
+                    sgd.step()
+                    ipex_module.attach_grad(dtype)
+                    ipex_optimizer.step()
+            # the momentum buffers of the packed weights are in the blocked layout of the weights
+            for p, state in ipex_optimizer.state.items():
+                self.assertEqual(state['momentum_buffer'].size(), p.size())
+            origin_model_state = M.state_dict()
+            ipex_model_state = ipex_module.state_dict()
+            for var_name in origin_model_state:
+                self.assertEqual(origin_model_state[var_name], ipex_model_state[var_name], rtol=1e-2, atol=1e-2)
+            self.assertEqual(sgd.state_dict()['state'], ipex_optimizer.state_dict()['state'], rtol=1e-2, atol=1e-2)
+
     def test_adagrad(self):
         M = TestModule()
         options = itertools.product([torch.float, torch.bfloat16], [0.1, 0], [0.1, 0], [0.1, 0], [1e-5, 0])
@@ -47,6 +70,14 @@ class TestOptimizers(TestCase):
                 initial_accumulator_value=initial_accumulator_value, eps=eps)
             self._test_update(M, adagrad, dtype)
 
+    def test_adam(self):
+        M = TestModule()
+        options = itertools.product(
+            [torch.float, torch.bfloat16], [torch.optim.Adam, torch.optim.AdamW], [0, 0.1], [False, True])
+        for dtype, optimizer, weight_decay, amsgrad in options:
+            adam = optimizer(M.parameters(), lr=0.001, weight_decay=weight_decay, amsgrad=amsgrad)
+            self._test_update(M, adam, dtype)
+
     def test_lamb(self):
         M = TestModule()
         options = itertools.product([torch.bfloat16], [(0.1, 0.111), (0.9, 0.999)], [0, 1e-8], [0, 0.1], [False])
@@ -56,6 +87,94 @@ class TestOptimizers(TestCase):
                 weight_decay=weight_decay, fused=fused)
             self._test_update(M, lamb, dtype)
 
+    def test_fuse_clip_grad_norm(self):
+        max_norm = 0.5
+        optimizers = [
+            lambda params: torch.optim.SGD(params, lr=0.1, momentum=0.9, weight_decay=0.1),
+            lambda params: torch.optim.Adagrad(params, lr=0.1, weight_decay=0.1),
+            lambda params: torch.optim.Adam(params, lr=0.1, weight_decay=0.1),
+            lambda params: ipex.optim._lamb.Lamb(params, lr=0.1, weight_decay=0.1, fused=True),
+        ]
+        for dtype, make_optimizer in itertools.product([torch.float, torch.bfloat16], optimizers):
+            M = TestModule()
+            optimizer = make_optimizer(M.parameters())
+            ipex_module, ipex_optimizer = ipex.optimize(
+                M, dtype=dtype, optimizer=make_optimizer(M.parameters()), weights_prepack=False)
+            ipex.optim.fuse_clip_grad_norm(ipex_optimizer, max_norm)
+            # the first step of SGD initializes the momentum buffers
+            for _ in range(2):
+                with torch.cpu.amp.autocast(enabled=True, dtype=dtype):
+                    M.attach_grad()
+                    norm = torch.nn.utils.clip_grad_norm_(M.parameters(), max_norm)
+                    optimizer.step()
+                    ipex_module.attach_grad(dtype)
+                    ipex_optimizer.step()
+                self.assertEqual(norm.item(), ipex_optimizer.last_grad_norm, rtol=1e-3, atol=1e-3)
+            origin_model_state = M.state_dict()
+            ipex_model_state = ipex_module.state_dict()
+            for var_name in origin_model_state:
+                self.assertEqual(origin_model_state[var_name], ipex_model_state[var_name], rtol=1e-2, atol=1e-2)
+
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_overlap_step_with_backward(self):
+        optimizers = [
+            lambda params: torch.optim.SGD(params, lr=0.1, momentum=0.9, weight_decay=0.1),
+            lambda params: torch.optim.Adam(params, lr=0.1, weight_decay=0.1),
+            lambda params: ipex.optim._lamb.Lamb(params, lr=0.1, weight_decay=0.1, fused=True),
+        ]
+        cpu_pool = ipex.cpu.runtime.CPUPool([1, 2])
+        for make_optimizer in optimizers:
+            M = TestModule()
+            M2 = copy.deepcopy(M)
+            ipex_module, ipex_optimizer = ipex.optimize(
+                M, optimizer=make_optimizer(M.parameters()), weights_prepack=False)
+            ipex_module2, ipex_optimizer2 = ipex.optimize(
+                M2, optimizer=make_optimizer(M2.parameters()), weights_prepack=False)
+            # the small buckets of one or two params
+            ipex.optim.overlap_step_with_backward(ipex_optimizer2, cpu_pool, bucket_size_mb=0.001)
+            for _ in range(2):
+                for module, optimizer in [(ipex_module, ipex_optimizer), (ipex_module2, ipex_optimizer2)]:
+                    optimizer.zero_grad()
+                    module(*M.input).sum().backward()
+                    optimizer.step()
+            origin_model_state = ipex_module.state_dict()
+            overlapped_model_state = ipex_module2.state_dict()
+            for var_name in origin_model_state:
+                self.assertEqual(origin_model_state[var_name], overlapped_model_state[var_name])
+
+    def test_fuse_grad_accumulation(self):
+        # the fused step of the float model, and the float master weight step of the bf16 model
+        for dtype in [torch.float, torch.bfloat16]:
+            M = TestModule()
+            M2 = copy.deepcopy(M)
+            ipex_module, ipex_optimizer = ipex.optimize(
+                M, dtype=dtype, optimizer=torch.optim.SGD(M.parameters(), lr=0.1),
+                split_master_weight_for_bf16=False, fuse_update_step=dtype is torch.float, weights_prepack=False)
+            ipex_module2, ipex_optimizer2 = ipex.optimize(
+                M2, dtype=dtype, optimizer=torch.optim.SGD(M2.parameters(), lr=0.1),
+                split_master_weight_for_bf16=False, fuse_update_step=dtype is torch.float, weights_prepack=False)
+            ipex.optim.fuse_grad_accumulation(ipex_optimizer2)
+            # the grads of two micro-batches
+            for _ in range(2):
+                for module in [ipex_module, ipex_module2]:
+                    with torch.cpu.amp.autocast(enabled=dtype is torch.bfloat16, dtype=torch.bfloat16):
+                        module(*M.input).sum().backward()
+            params = [p for group in ipex_optimizer.param_groups for p in group['params']]
+            params2 = [p for group in ipex_optimizer2.param_groups for p in group['params']]
+            offset = 0
+            for p, p2 in zip(params, params2):
+                grad = ipex_optimizer.params_attr.get(p, {}).get('bf16_param', p).grad
+                self.assertEqual(grad.float(), p2.grad, rtol=1e-2, atol=1e-2)
+                # the grads are the views of the buffer
+                self.assertEqual(p2.grad.data_ptr(), ipex_optimizer2.grad_buffer[offset:].data_ptr())
+                offset += p2.numel()
+            ipex_optimizer.step()
+            ipex_optimizer2.step()
+            for p, p2 in zip(params, params2):
+                self.assertEqual(p, p2, rtol=1e-2, atol=1e-2)
+            ipex_optimizer2.zero_grad()
+            self.assertEqual(ipex_optimizer2.grad_buffer.abs().sum().item(), 0)
+
 class TestFusedSteps(TestCase):
 
     def test_lamb_step(self):
@@ -115,6 +234,101 @@ class TestFusedSteps(TestCase):
         # make sure bf16_param are updated
         self.assertEqual(bf16_param, param3.bfloat16())
 
+    def test_lamb_step_grad_unchanged(self):
+        fused = torch.ops.torch_ipex.lamb_fused_step
+        non_fused = bench.custom_op_bench.optimizer.non_fused_lamb
+        # the adam steps of the chunks of the threads are cached between the two phases,
+        # or recomputed from the moments if the chunks exceed the size of the cache
+        for numel in [1000 + 3, 131072 * torch.get_num_threads() + 3]:
+            param = torch.randn(numel)
+            grad = torch.randn(numel)
+            exp_avg = torch.randn(numel).abs()
+            exp_avg_sq = torch.randn(numel).abs()
+            param2, trail2 = torch.ops.torch_ipex.split_float_bfloat16(param)
+            grad2 = grad.bfloat16()
+            exp_avg2 = exp_avg.clone()
+            exp_avg_sq2 = exp_avg_sq.clone()
+            param4 = param.clone()
+            grad4 = grad.clone()
+            exp_avg4 = exp_avg.clone()
+            exp_avg_sq4 = exp_avg_sq.clone()
+            ref_grad = grad.clone()
+            ref_grad2 = grad2.clone()
+
+            args = (10, 0.8, 0.9, 0.1, 0.3, 0.001)
+            fused(param, exp_avg, exp_avg_sq, grad, torch.Tensor(), *args)
+            fused(param2, exp_avg2, exp_avg_sq2, grad2, trail2, *args)
+            non_fused(param4, exp_avg4, exp_avg_sq4, grad4, *args)
+
+            self.assertEqual(grad, ref_grad)
+            self.assertEqual(grad2, ref_grad2)
+            self.assertEqual(param, param4)
+            self.assertEqual(exp_avg, exp_avg4)
+            self.assertEqual(exp_avg_sq, exp_avg_sq4)
+            self.assertEqual(param, param2.float(), rtol=1e-4, atol=1e-1)
+
+    def test_adam_step(self):
+        fused = torch.ops.torch_ipex.adam_fused_step
+        non_fused = bench.custom_op_bench.optimizer.non_fused_adam
+
+        step = 10
+        beta1 = 0.8
+        beta2 = 0.9
+        learning_rate = 0.1
+        weight_decay = 0.3
+        eps = 0.001
+
+        for amsgrad, adamw in itertools.product([False, True], [False, True]):
+            # fused fp32 args
+            param = torch.randn(80, 100)
+            grad = torch.randn(80, 100)
+            exp_avg = torch.randn(80, 100).abs()
+            exp_avg_sq = torch.randn(80, 100).abs()
+            max_exp_avg_sq = exp_avg_sq + torch.randn(80, 100).abs() if amsgrad else torch.Tensor()
+            trail = torch.Tensor()
+
+            # fused bf16 args ( master weight split )
+            param2, trail2 = torch.ops.torch_ipex.split_float_bfloat16(param)
+            grad2 = grad.bfloat16()
+            exp_avg2 = exp_avg.clone()
+            exp_avg_sq2 = exp_avg_sq.clone()
+            max_exp_avg_sq2 = max_exp_avg_sq.clone()
+
+            # fused bf16 args ( master weight )
+            param3 = param.clone()
+            grad3 = grad.bfloat16()
+            exp_avg3 = exp_avg.clone()
+            exp_avg_sq3 = exp_avg_sq.clone()
+            max_exp_avg_sq3 = max_exp_avg_sq.clone()
+            bf16_param = param3.bfloat16()
+
+            # non-fused fp32 args
+            param4 = param.clone()
+            grad4 = grad.clone()
+            exp_avg4 = exp_avg.clone()
+            exp_avg_sq4 = exp_avg_sq.clone()
+            max_exp_avg_sq4 = max_exp_avg_sq.clone()
+
+            args = (step, amsgrad, adamw, beta1, beta2, learning_rate, weight_decay, eps)
+            fused(param, exp_avg, exp_avg_sq, max_exp_avg_sq, grad, trail, *args)
+            fused(param2, exp_avg2, exp_avg_sq2, max_exp_avg_sq2, grad2, trail2, *args)
+            fused(param3, exp_avg3, exp_avg_sq3, max_exp_avg_sq3, grad3, bf16_param, *args)
+            non_fused(param4, exp_avg4, exp_avg_sq4, max_exp_avg_sq4, grad4, *args)
+
+            # compare fused and non-fused
+            self.assertEqual(param, param4)
+            self.assertEqual(exp_avg, exp_avg4)
+            self.assertEqual(exp_avg_sq, exp_avg_sq4)
+            self.assertEqual(max_exp_avg_sq, max_exp_avg_sq4)
+            # compare fused fp32 and fused bf16
+            self.assertEqual(param, param2.float(), rtol=1e-4, atol=1e-1)
+            self.assertEqual(exp_avg, exp_avg2, rtol=1e-4, atol=1e-1)
+            # compare split vs non-split
+            self.assertEqual(param3, param2.float(), rtol=1e-4, atol=1e-1)
+            self.assertEqual(exp_avg_sq3, exp_avg_sq2, rtol=1e-4, atol=1e-1)
+            # make sure bf16_param are updated
+            self.assertEqual(bf16_param, param3.bfloat16())
+
     def test_adagrad_step(self):
         fused = torch.ops.torch_ipex.adagrad_fused_step
         non_fused = bench.custom_op_bench.optimizer.non_fused_adagrad
@@ -164,6 +378,49 @@ class TestFusedSteps(TestCase):
         # make sure bf16_param are updated
         self.assertEqual(bf16_param, param3.bfloat16())
 
+    def test_rowwise_adagrad_step(self):
+        fused = torch.ops.torch_ipex.rowwise_adagrad_fused_step
+        non_fused = ipex.optim._functional.rowwise_adagrad_impl
+        learning_rate = 0.1
+        weight_decay = 0.3
+        eps = 0.001
+
+        # the sparse grad of the repeated rows of an embedding table, and the dense grad of a table
+        indices = torch.LongTensor([[3, 7, 3, 60, 79]])
+        values = torch.randn(5, 100)
+        for grad in [torch.sparse_coo_tensor(indices, values, (80, 100)), torch.randn(80, 100)]:
+            # fused fp32 args
+            param = torch.randn(80, 100)
+            state_sum = torch.randn(80).abs()
+            trail = torch.Tensor()
+
+            # fused bf16 args (master weight split)
+            param2, trail2 = torch.ops.torch_ipex.split_float_bfloat16(param)
+            grad2 = grad.bfloat16()
+            state_sum2 = state_sum.clone()
+
+            # non-fused fp32 args
+            param3 = param.clone()
+            state_sum3 = state_sum.clone()
+
+            fused(param, grad, state_sum, trail, learning_rate, weight_decay, eps)
+            fused(param2, grad2, state_sum2, trail2, learning_rate, weight_decay, eps)
+            non_fused([param3], [grad], [state_sum3], {}, learning_rate, weight_decay, eps, fused=False)
+
+            # compare fused fp32 vs non-fused fp32
+            self.assertEqual(param, param3, rtol=1e-5, atol=1e-5)
+            self.assertEqual(state_sum, state_sum3, rtol=1e-5, atol=1e-5)
+            # compare fused fp32 vs fused bf16
+            self.assertEqual(param, torch.ops.torch_ipex.cat_bfloat16_float(param2, trail2), rtol=1e-4, atol=1e-3)
+            self.assertEqual(state_sum, state_sum2, rtol=1e-4, atol=1e-3)
+
+    def test_grad_accumulate(self):
+        acc = torch.randn(1000)
+        for grad in [torch.randn(10, 100), torch.randn(10, 100).bfloat16(), torch.randn(100, 10).t()]:
+            ref = acc + grad.contiguous().float().reshape(-1)
+            torch.ops.torch_ipex.grad_accumulate_(acc, grad)
+            self.assertEqual(acc, ref)
+
     def test_sgd_step(self):
         fused = torch.ops.torch_ipex.sgd_fused_step
         non_fused = bench.custom_op_bench.optimizer.non_fused_sgd
@@ -213,6 +470,94 @@ class TestFusedSteps(TestCase):
         # make sure bf16_param are updated
         self.assertEqual(bf16_param, param3.bfloat16())
 
+    def test_fused_step_list(self):
+        # small params packed into the chunks, and a large param updated alone
+        shapes = [(3,), (80, 100), (7, 5), (300, 300), (1,), (64,)]
+        ops = [
+            ('sgd', lambda n: [torch.randn(n)], (0.5, 0.1, 0.3, 0.5, True)),
+            ('adagrad', lambda n: [torch.randn(n).abs()], (0.1, 0.3, 0.01, 0.001)),
+            ('lamb', lambda n: [torch.randn(n).abs(), torch.randn(n).abs()], (0.8, 0.9, 0.1, 0.3, 0.001)),
+            ('adam', lambda n: [torch.randn(n).abs(), torch.randn(n).abs(), torch.randn(n).abs()],
+                (True, True, 0.8, 0.9, 0.1, 0.3, 0.001)),
+        ]
+        for name, states_of, args in ops:
+            fused = getattr(torch.ops.torch_ipex, name + '_fused_step')
+            fused_list = getattr(torch.ops.torch_ipex, name + '_fused_step_list')
+            steps = list(range(1, len(shapes) + 1))
+            # the params of bf16 of the split master weight, except for the first two
+            params, grads, states, trails = [], [], [], []
+            for i, shape in enumerate(shapes):
+                param, grad = torch.randn(shape), torch.randn(shape)
+                trail = torch.Tensor()
+                if i >= 2:
+                    param, trail = torch.ops.torch_ipex.split_float_bfloat16(param)
+                    grad = grad.bfloat16()
+                params.append(param)
+                grads.append(grad)
+                states.append([s.view(shape) for s in states_of(param.numel())])
+                trails.append(trail)
+            params2 = [p.clone() for p in params]
+            grads2 = [g.clone() for g in grads]
+            states2 = [[s.clone() for s in state] for state in states]
+            trails2 = [t.clone() for t in trails]
+
+            for i in range(len(shapes)):
+                if name == 'sgd':
+                    fused(params[i], grads[i], *states[i], trails[i], *args)
+                elif name == 'adagrad':
+                    fused(params[i], grads[i], *states[i], trails[i], steps[i], *args)
+                else:
+                    fused(params[i], *states[i], grads[i], trails[i], steps[i], *args)
+            state_lists = [list(s) for s in zip(*states2)]
+            if name == 'sgd':
+                fused_list(params2, grads2, *state_lists, trails2, *args)
+            elif name == 'adagrad':
+                fused_list(params2, grads2, *state_lists, trails2, steps, *args)
+            else:
+                fused_list(params2, *state_lists, grads2, trails2, steps, *args)
+
+            self.assertEqual(params, params2)
+            self.assertEqual(states, states2)
+            self.assertEqual(trails, trails2)
+
+    def test_stochastic_rounding(self):
+        # the updates of 1e-3 are smaller than the half ulp of bf16 around 1
+        numel = 100003
+        grad = torch.ones(numel).bfloat16()
+        learning_rate = 1e-3
+        for stochastic_rounding in [False, True]:
+            param = torch.ones(numel).bfloat16()
+            momentum_buf = torch.zeros(numel)
+            torch.ops.torch_ipex.sgd_fused_step(
+                param, grad, momentum_buf, torch.Tensor(), 0, learning_rate, 0, 0, False, 1., stochastic_rounding)
+            if stochastic_rounding:
+                # the tail of the scalar loop as well
+                self.assertEqual(param.float().mean().item(), 1 - learning_rate, rtol=0, atol=1e-4)
+                self.assertTrue(((param == 1) | (param == torch.tensor(1 - 2 ** -8).bfloat16())).all())
+            else:
+                self.assertEqual(param, torch.ones(numel).bfloat16())
+
+        # pure bf16 params of the fused steps are rounded to nearest without stochastic rounding
+        torch.manual_seed(0)
+        param = torch.randn(80, 100)
+        grad = torch.randn(80, 100)
+        exp_avg = torch.randn(80, 100).abs()
+        exp_avg_sq = torch.randn(80, 100).abs()
+        param2, grad2 = param.bfloat16(), grad.bfloat16()
+        exp_avg2, exp_avg_sq2 = exp_avg.clone(), exp_avg_sq.clone()
+        args = (10, False, True, 0.8, 0.9, 0.1, 0.3, 0.001)
+        torch.ops.torch_ipex.adam_fused_step(param, exp_avg, exp_avg_sq, torch.Tensor(), grad2.float(), torch.Tensor(), *args)
+        torch.ops.torch_ipex.adam_fused_step(param2, exp_avg2, exp_avg_sq2, torch.Tensor(), grad2, torch.Tensor(), *args)
+        self.assertEqual(param2, param.bfloat16(), rtol=1e-2, atol=1e-2)
+        self.assertEqual(exp_avg2, exp_avg, rtol=1e-4, atol=1e-4)
+
+    def test_grad_norm_list(self):
+        grads = [torch.randn(shape) for shape in [(3,), (80, 100), (7, 5), (300, 300)]]
+        grads += [torch.randn(10, 33).bfloat16(), torch.randn(17).double()]
+        norm = torch.cat([g.double().reshape(-1) for g in grads]).norm()
+        self.assertEqual(torch.ops.torch_ipex.grad_norm_list(grads), norm.item(), rtol=1e-5, atol=1e-5)
+        self.assertEqual(torch.ops.torch_ipex.grad_norm_list([]), 0)
+
     def _test_packed_add(self, param, grad, param2, trail, grad2):
         packed_add = torch.ops.torch_ipex.packed_add
         learning_rate = 0.1
@@ -0,0 +1,32 @@
+import unittest
+import torch
+import intel_extension_for_pytorch as ipex
+from common_utils import TestCase
+
+roi_align = torch.ops.torch_ipex.ROIAlign_forward
+
+class TestParallelTrace(TestCase):
+    def test_parallel_trace(self):
+        x = torch.randn(2, 16, 32, 32)
+        rois = torch.tensor([[0, 0, 0, 31, 31], [1, 0, 0, 4, 4], [0, 8, 8, 16, 16], [1, 0, 0, 31, 31]] * 8,
+                            dtype=torch.float)
+        roi_align(x, rois, 1.0, 7, 7, 2, True)
+        # not profiled out of the scope
+        with ipex.parallel_trace() as trace:
+            for _ in range(4):
+                roi_align(x, rois, 1.0, 7, 7, 2, True)
+        roi_align(x, rois, 1.0, 7, 7, 2, True)
+        stats = trace.stats()['roi_align_forward']
+        self.assertEqual(stats['count'], 4)
+        self.assertGreaterEqual(stats['num_threads'], stats['active_threads'])
+        self.assertGreater(stats['busy_ns'], 0)
+        self.assertGreaterEqual(stats['imbalance'], 1.0)
+        self.assertGreaterEqual(stats['max_imbalance'], 1.0)
+        self.assertGreaterEqual(stats['imbalance_ns'], 0)
+        # cleared by the next trace
+        with ipex.parallel_trace():
+            pass
+        self.assertEqual(trace.stats(), {})
+
+if __name__ == '__main__':
+    test = unittest.main()
@@ -0,0 +1,64 @@
+import unittest
+import os
+import tempfile
+from common_utils import TestCase
+from intel_extension_for_pytorch.utils import perf_regression
+
+def cpp_bench_report(fingerprint, nms_us, embedding_us):
+    return {
+        'context': {'ipex_isa': 'avx512', 'cpu_micro_arch': 'icelake_x', 'cpu_fingerprint': fingerprint},
+        'benchmarks': [
+            {'name': 'BM_nms/fp32/boxes:1000/real_time', 'run_name': 'BM_nms/fp32/boxes:1000/real_time',
+             'run_type': 'iteration', 'real_time': nms_us, 'time_unit': 'us', 'GB/s': 1.0},
+            {'name': 'BM_embedding_bag/bf16/batch:1024/dim:64/pooling:1/real_time',
+             'run_name': 'BM_embedding_bag/bf16/batch:1024/dim:64/pooling:1/real_time',
+             'run_type': 'iteration', 'real_time': embedding_us * 1000, 'time_unit': 'ns', 'GB/s': 20.0},
+        ],
+    }
+
+class TestPerfRegression(TestCase):
+    def test_load_cpp_bench_results(self):
+        results = perf_regression.load_results(cpp_bench_report('f0', 100., 50.))
+        self.assertEqual(results['fingerprint'], 'f0')
+        self.assertEqual(results['schema_version'], perf_regression.SCHEMA_VERSION)
+        embedding = [r for r in results['results'] if r['op'] == 'embedding_bag'][0]
+        self.assertEqual(embedding['shape'], 'batch:1024,dim:64,pooling:1')
+        self.assertEqual(embedding['dtype'], 'bf16')
+        self.assertEqual(embedding['isa'], 'avx512')
+        self.assertAlmostEqual(embedding['latency_us'], 50.)
+        self.assertEqual(embedding['gbps'], 20.0)
+
+    def test_load_sweep_results(self):
+        report = {
+            'environment': {'isa_level': 'amx', 'cpu_fingerprint': 'f1'},
+            'results': [{'model': 'resnet50', 'dtype': 'bfloat16', 'batch_size': 16, 'num_streams': 4,
+                         'latency_ms': {'p50': 12.5}, 'samples_per_second': 1000.}],
+        }
+        results = perf_regression.load_results(report)
+        self.assertEqual(results['fingerprint'], 'f1')
+        r = results['results'][0]
+        self.assertEqual((r['source'], r['op'], r['shape']), ('model', 'resnet50', 'batch_size:16,num_streams:4'))
+        self.assertAlmostEqual(r['latency_us'], 12500.)
+
+    def test_compare(self):
+        with tempfile.TemporaryDirectory() as tmp:
+            baseline = os.path.join(tmp, 'baseline.json')
+            perf_regression.update_baseline(cpp_bench_report('f0', 100., 50.), baseline)
+            # a 20% slowdown of nms and the noise of embedding_bag
+            report = perf_regression.compare(cpp_bench_report('f0', 120., 51.), baseline, threshold=0.05)
+            self.assertTrue(report['has_baseline'])
+            self.assertEqual([r['op'] for r in report['regressions']], ['nms'])
+            self.assertAlmostEqual(report['regressions'][0]['change'], 0.2)
+            self.assertEqual(report['unchanged'], 1)
+            # the results of another SKU are not compared
+            report = perf_regression.compare(cpp_bench_report('f1', 200., 100.), baseline)
+            self.assertFalse(report['has_baseline'])
+            self.assertEqual(report['regressions'], [])
+            self.assertEqual(len(report['new']), 2)
+            # the baselines of the other fingerprints are kept on update
+            perf_regression.update_baseline(cpp_bench_report('f1', 200., 100.), baseline)
+            report = perf_regression.compare(cpp_bench_report('f0', 120., 51.), baseline)
+            self.assertEqual(len(report['regressions']), 1)
+
+if __name__ == '__main__':
+    test = unittest.main()
@@ -0,0 +1,57 @@
+import unittest
+import warnings
+import torch
+import intel_extension_for_pytorch as ipex
+from common_utils import TestCase
+
+class ConvReLUConv(torch.nn.Module):
+    def __init__(self):
+        super(ConvReLUConv, self).__init__()
+        self.conv1 = torch.nn.Conv2d(3, 16, kernel_size=3, padding=1)
+        self.relu = torch.nn.ReLU()
+        self.conv2 = torch.nn.Conv2d(16, 16, kernel_size=3, padding=1)
+
+    def forward(self, x):
+        return self.conv2(self.relu(self.conv1(x)))
+
+class TestReorderAnalysis(TestCase):
+    def test_analyze_reorders(self):
+        model = ipex.optimize(ConvReLUConv().eval())
+        x = torch.randn(2, 3, 14, 14)
+        report = ipex.analyze_reorders(model, x)
+        self.assertEqual(report.num_reorders, sum(e['count'] for e in report.edges))
+        self.assertEqual(report.total_bytes, sum(e['bytes'] for e in report.edges))
+        for e in report.edges:
+            self.assertIn(e['direction'], ('plain->blocked', 'blocked->plain', 'blocked->blocked', 'plain->plain', 'weight'))
+            self.assertGreater(e['count'], 0)
+            self.assertTrue(e['suggestion'])
+        bytes_per_edge = [e['bytes'] for e in report.edges]
+        self.assertEqual(bytes_per_edge, sorted(bytes_per_edge, reverse=True))
+        self.assertIn('reorders of', str(report))
+        self.assertEqual(report.to_dict()['num_reorders'], report.num_reorders)
+
+    def test_analyze_reorders_apply_fixes(self):
+        model = ipex.optimize(ConvReLUConv().eval())
+        x = torch.randn(2, 3, 14, 14)
+        report = ipex.analyze_reorders(model, x, apply_fixes=True)
+        if report.before is None:
+            # no reorder of the activations to fix
+            self.assertEqual(report.applied, [])
+            return
+        self.assertEqual(report.applied, ['channels_last'])
+        before = sum(e['bytes'] for e in report.before.edges if e['direction'] != 'weight')
+        after = sum(e['bytes'] for e in report.edges if e['direction'] != 'weight')
+        self.assertLessEqual(after, before)
+        # the model still runs after the fixes
+        with torch.no_grad():
+            model(x.to(memory_format=torch.channels_last))
+
+    def test_optimize_analyze_reorders(self):
+        x = torch.randn(2, 3, 14, 14)
+        with warnings.catch_warnings():
+            warnings.simplefilter("ignore")
+            model = ipex.optimize(ConvReLUConv().eval(), sample_input=x, analyze_reorders=True)
+        self.assertIsInstance(model.reorder_report, ipex.ReorderReport)
+
+if __name__ == '__main__':
+    test = unittest.main()
@@ -0,0 +1,63 @@
+import unittest
+import torch
+import intel_extension_for_pytorch as ipex
+from torch.testing._internal.common_utils import TestCase
+import itertools
+
+def _ref_rms_norm(x, weight, eps):
+    x = x.float()
+    return x * torch.rsqrt(x.pow(2).mean(-1, keepdim=True) + eps) * weight.float()
+
+class TestRMSNorm(TestCase):
+
+    def _test_rms_norm(self, dtype, hidden, with_residual):
+        shape = (2, 5, hidden)
+        x = torch.randn(shape).to(dtype).requires_grad_()
+        residual = torch.randn(shape).to(dtype).requires_grad_()
+        weight = torch.randn(hidden).requires_grad_()
+        ref_inputs = [x, residual, weight]
+        inputs = [t.detach().clone().requires_grad_() for t in ref_inputs]
+
+        x, residual, weight = ref_inputs
+        ref_sum = x.float() + residual.float() if with_residual else x.float()
+        ref_out = _ref_rms_norm(ref_sum, weight, 1e-6)
+
+        x, residual, weight = inputs
+        if with_residual:
+            out, s = ipex.nn.functional.add_rms_norm(x, residual, weight, 1e-6)
+            self.assertEqual(s.dtype, dtype)
+        else:
+            out = ipex.nn.functional.rms_norm(x, weight, 1e-6)
+        self.assertEqual(out.dtype, dtype)
+
+        grad = torch.randn(shape)
+        ref_out.backward(grad)
+        out.backward(grad.to(dtype))
+        prec = 2e-2 if dtype == torch.bfloat16 else 1e-4
+        self.assertEqual(out.float(), ref_out, atol=prec, rtol=prec)
+        if with_residual:
+            self.assertEqual(s.float(), ref_sum, atol=prec, rtol=prec)
+            self.assertEqual(residual.grad.float(), ref_inputs[1].grad.float(), atol=prec * 5, rtol=prec)
+        self.assertEqual(x.grad.float(), ref_inputs[0].grad.float(), atol=prec * 5, rtol=prec)
+        self.assertEqual(weight.grad, ref_inputs[2].grad, atol=prec * 5, rtol=prec)
+
+    def test_rms_norm(self):
+        # both of the vectorized rows and the ones with a tail
+        for dtype, hidden, with_residual in itertools.product(
+                [torch.float, torch.bfloat16], [64, 70], [False, True]):
+            self._test_rms_norm(dtype, hidden, with_residual)
+
+    def test_rms_norm_inference(self):
+        x = torch.randn(8, 70).bfloat16()
+        residual = torch.randn(8, 70).bfloat16()
+        weight = torch.randn(70).bfloat16()
+        with torch.no_grad():
+            out = torch.ops.torch_ipex.rms_norm(x, weight, 1e-6)
+            self.assertEqual(out.float(), _ref_rms_norm(x, weight, 1e-6), atol=2e-2, rtol=2e-2)
+            out, s = torch.ops.torch_ipex.add_rms_norm(x, residual, None, 1e-6)
+            ref_sum = x.float() + residual.float()
+            self.assertEqual(s.float(), ref_sum, atol=2e-2, rtol=2e-2)
+            self.assertEqual(out.float(), _ref_rms_norm(ref_sum, torch.ones(70), 1e-6), atol=2e-2, rtol=2e-2)
+
+if __name__ == '__main__':
+    test = unittest.main()
@@ -1,4 +1,5 @@
 import unittest, copy
+import math
 from itertools import product
 
 import torch
@@ -172,5 +173,143 @@ class TestRNNTEmbedding(TestCase):
 
             self.assertEqual(y_embed_org, y_embed)
 
+class TestRNNTGreedyDecode(TestCase):
+    def _test_org(self, x, out_lens, embedding, lstm, joint, max_symbol, blank_id):
+        # decode each sample alone
+        labels = []
+        for b in range(x.size(0)):
+            hidden = None
+            label, t, symbols_added, sample_labels = self._SOS, 0, 0, []
+            while t < out_lens[b]:
+                if label == self._SOS:
+                    y = torch.zeros(1, 1, embedding.weight.size(1))
+                else:
+                    y = embedding(torch.tensor([[label]]))
+                g, hidden_prime = lstm(y.transpose(0, 1), hidden)
+                k = joint(torch.cat([x[b, t], g[0, 0]], -1)).argmax().item()
+                if k == blank_id:
+                    t, symbols_added = t + 1, 0
+                    continue
+                sample_labels.append(k)
+                hidden, label = hidden_prime, k
+                symbols_added += 1
+                if symbols_added >= max_symbol:
+                    t, symbols_added = t + 1, 0
+            labels.append(sample_labels)
+        return labels
+
+    def test_rnnt_greedy_decode(self):
+        self._SOS = -1
+        vocab_size, enc_n_hidden, pred_n_hidden, joint_n_hidden = 29, 24, 32, 40
+        blank_id = vocab_size - 1
+        torch.manual_seed(2018)
+        embedding = torch.nn.Embedding(vocab_size - 1, pred_n_hidden)
+        lstm = torch.nn.LSTM(pred_n_hidden, pred_n_hidden, 2).eval()
+        joint = torch.nn.Sequential(
+            torch.nn.Linear(enc_n_hidden + pred_n_hidden, joint_n_hidden),
+            torch.nn.ReLU(),
+            torch.nn.Linear(joint_n_hidden, vocab_size))
+        for batch_size, max_symbol in product([1, 7], [1, 3]):
+            x = torch.randn(batch_size, 10, enc_n_hidden)
+            out_lens = torch.randint(0, 11, (batch_size,), dtype=torch.int)
+            lstm_context = torch.ops.ipex_prepack.lstm_prepack(
+                lstm._flat_weights, True, 2, pred_n_hidden, False, False,
+                [1, batch_size, pred_n_hidden])
+            with torch.no_grad():
+                labels_ref = self._test_org(x, out_lens, embedding, lstm, joint, max_symbol, blank_id)
+                label_tensor, label_col = torch.ops.ipex.rnnt_greedy_decode(
+                    x,
+                    out_lens,
+                    embedding.weight,
+                    lstm_context,
+                    joint[0].weight,
+                    joint[0].bias,
+                    joint[2].weight,
+                    joint[2].bias,
+                    max_symbol,
+                    blank_id,
+                    self._SOS)
+            labels = [label_tensor[b, 1:label_col[b] + 1].tolist() for b in range(batch_size)]
+            self.assertEqual(labels, labels_ref)
+
+    def _test_beam_search_org(self, x, out_lens, embedding, lstm, joint, beam_size, max_symbol, blank_id):
+        def pred(label, hidden):
+            if label == self._SOS:
+                y = torch.zeros(1, 1, embedding.embedding_dim)
+            else:
+                y = embedding(torch.tensor([[label]]))
+            g, hidden = lstm(y, hidden)
+            return g[0, 0], hidden
+
+        def push(hyps, labels, score, state):
+            for hyp in hyps:
+                if hyp[0] == labels:
+                    hyp[1] = max(hyp[1], score) + math.log1p(math.exp(-abs(hyp[1] - score)))
+                    return
+            if len(hyps) < beam_size:
+                hyps.append([labels, score, state])
+                return
+            worst = min(range(len(hyps)), key=lambda j: hyps[j][1])
+            if score > hyps[worst][1]:
+                hyps[worst] = [labels, score, state]
+
+        labels = []
+        for b in range(x.size(0)):
+            final = [[(), 0.0, pred(self._SOS, None)]]
+            for t in range(out_lens[b]):
+                hyps, final = final, []
+                for s in range(max_symbol):
+                    candidates = []
+                    for i, (hyp_labels, score, (g, hidden)) in enumerate(hyps):
+                        logp = joint(torch.cat([x[b, t], g])).log_softmax(0).tolist()
+                        push(final, hyp_labels, score + logp[blank_id], (g, hidden))
+                        candidates += [(score + p, i, k) for k, p in enumerate(logp) if k != blank_id]
+                    candidates.sort(key=lambda c: (-c[0], c[1], c[2]))
+                    threshold = min(hyp[1] for hyp in final) if len(final) == beam_size else -math.inf
+                    hyps = [[hyps[i][0] + (k,), score, pred(k, hyps[i][2][1])]
+                            for score, i, k in candidates[:beam_size] if score > threshold]
+                    if not hyps:
+                        break
+                for hyp in hyps:
+                    push(final, *hyp)
+            labels.append(list(max(final, key=lambda hyp: hyp[1])[0]))
+        return labels
+
+    def test_rnnt_beam_search_decode(self):
+        self._SOS = -1
+        vocab_size, enc_n_hidden, pred_n_hidden, joint_n_hidden = 29, 24, 32, 40
+        blank_id = vocab_size - 1
+        torch.manual_seed(2018)
+        embedding = torch.nn.Embedding(vocab_size - 1, pred_n_hidden)
+        lstm = torch.nn.LSTM(pred_n_hidden, pred_n_hidden, 2).eval()
+        joint = torch.nn.Sequential(
+            torch.nn.Linear(enc_n_hidden + pred_n_hidden, joint_n_hidden),
+            torch.nn.ReLU(),
+            torch.nn.Linear(joint_n_hidden, vocab_size))
+        for batch_size, beam_size, max_symbol in product([1, 5], [1, 4], [1, 3]):
+            x = torch.randn(batch_size, 6, enc_n_hidden)
+            out_lens = torch.randint(0, 7, (batch_size,), dtype=torch.int)
+            lstm_context = torch.ops.ipex_prepack.lstm_prepack(
+                lstm._flat_weights, True, 2, pred_n_hidden, False, False,
+                [1, batch_size, pred_n_hidden])
+            with torch.no_grad():
+                labels_ref = self._test_beam_search_org(
+                    x, out_lens, embedding, lstm, joint, beam_size, max_symbol, blank_id)
+                label_tensor, label_col = torch.ops.ipex.rnnt_beam_search_decode(
+                    x,
+                    out_lens,
+                    embedding.weight,
+                    lstm_context,
+                    joint[0].weight,
+                    joint[0].bias,
+                    joint[2].weight,
+                    joint[2].bias,
+                    beam_size,
+                    max_symbol,
+                    blank_id,
+                    self._SOS)
+            labels = [label_tensor[b, 1:label_col[b] + 1].tolist() for b in range(batch_size)]
+            self.assertEqual(labels, labels_ref)
+
 if __name__ == '__main__':
     test = unittest.main()
@@ -140,6 +140,54 @@ class RoIAlignTester(TestCase):
             self.assertTrue(x3.grad.dtype == torch.bfloat16)
             self.assertTrue(torch.allclose(gt_x.grad.to(x3.dtype), x3.grad, rtol=1e-5, atol=1e-5))
 
+    def test_roialign_backward_bf16(self):
+        pool_size = 7
+        # more channels than a vector, more ROIs than threads
+        n_channels = 80
+        x = torch.rand(2, n_channels, 50, 50)
+        xy = torch.rand(200, 2) * 40
+        wh = torch.rand(200, 2) * 30
+        rois = torch.cat([torch.randint(0, 2, (200, 1)).float(), xy, (xy + wh).clamp(max=49)], 1)
+        for memory_format in [torch.contiguous_format, torch.channels_last]:
+            x1 = x.clone().to(memory_format=memory_format).requires_grad_()
+            x2 = x.clone().bfloat16().to(memory_format=memory_format).requires_grad_()
+            y1 = fn(x1, rois, pool_size, pool_size, spatial_scale=1, sampling_ratio=-1, aligned=True)
+            y2 = fn(x2, rois, pool_size, pool_size, spatial_scale=1, sampling_ratio=-1, aligned=True)
+            grad = torch.rand_like(y1)
+            y1.backward(grad)
+            y2.backward(grad.bfloat16())
+            self.assertTrue(x2.grad.dtype == torch.bfloat16)
+            self.assertTrue(x2.grad.is_contiguous(memory_format=memory_format))
+            # the gradients are accumulated in float
+            self.assertTrue(torch.allclose(x1.grad, x2.grad.float(), rtol=1e-2, atol=1e-2))
+
+    def test_multilevel_roialign(self):
+        pool_size = 7
+        n_channels = 16
+        # the levels 2 to 5 of an FPN of a 512x512 image
+        spatial_scales = [1 / 4, 1 / 8, 1 / 16, 1 / 32]
+        x = [torch.rand(2, n_channels, int(512 * scale), int(512 * scale)) for scale in spatial_scales]
+        xy = torch.rand(300, 2) * 400
+        wh = torch.rand(300, 2) * 500
+        boxes = torch.cat([xy, (xy + wh).clamp(max=511)], 1)
+        rois = torch.cat([torch.randint(0, 2, (300, 1)).float(), boxes], 1)
+
+        # the LevelMapper of torchvision
+        s = torch.sqrt((boxes[:, 2] - boxes[:, 0]) * (boxes[:, 3] - boxes[:, 1]))
+        levels = (torch.floor(4 + torch.log2(s / 224) + 1e-6).clamp(min=2, max=5) - 2).to(torch.int64)
+        for sampling_ratio in [-1, 2]:
+            for memory_format in [torch.contiguous_format, torch.channels_last]:
+                features = [feature.contiguous(memory_format=memory_format) for feature in x]
+                y_ref = torch.zeros(rois.size(0), n_channels, pool_size, pool_size)
+                for level, (feature, scale) in enumerate(zip(features, spatial_scales)):
+                    idx = (levels == level).nonzero().squeeze(1)
+                    y_ref[idx] = fn(feature, rois[idx], pool_size, pool_size, spatial_scale=scale,
+                                    sampling_ratio=sampling_ratio, aligned=True)
+                y = torch.ops.torch_ipex.multilevel_roi_align(features, rois, spatial_scales, pool_size, pool_size,
+                                                              sampling_ratio, True)
+                self.assertTrue(y.is_contiguous(memory_format=memory_format))
+                self.assertTrue(torch.allclose(y_ref, y, rtol=1e-5, atol=1e-5))
+
     @skipIfNoTorchVision
     def test_torchvision_roialign(self):
         pool_size = 5
@@ -5,6 +5,7 @@ import intel_extension_for_pytorch as ipex
 from common_utils import TestCase
 from torch.testing._internal.jit_utils import JitTestCase
 import time, sys
+import json, os, tempfile
 from test_jit_llga_utils import JitLlgaTestCase, run_tests, LLGA_FUSION_GROUP
 import torch.fx.experimental.optimization as optimization
 
@@ -30,6 +31,15 @@ class SimpleNet_v2(torch.nn.Module):
         y = torch.flatten(x1, start_dim=1)
         return y
 
+class SlowNet(torch.nn.Module):
+    def __init__(self, seconds):
+        super(SlowNet, self).__init__()
+        self.seconds = seconds
+
+    def forward(self, x):
+        time.sleep(self.seconds)
+        return x + 1
+
 class TestCoreBinding(TestCase):
     @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
     def test_decorator_function_result(self):
@@ -71,6 +81,56 @@ class TestCoreBinding(TestCase):
         self.assertEqual(y, y_runtime)
 
 class TestRuntimeAPI(TestCase):
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_cpu_pool_numa_node(self):
+        cpu_pool = ipex.cpu.runtime.CPUPool(node_id=0)
+        self.assertEqual(cpu_pool.numa_node_id, 0)
+        self.assertEqual(cpu_pool.cpu_pool.get_numa_node_id(), 0)
+        cpu_pool = ipex.cpu.runtime.CPUPool(ipex.cpu.runtime.get_core_list_of_node_id(0))
+        self.assertEqual(cpu_pool.numa_node_id, 0)
+        cpu_pool = ipex.cpu.runtime.CPUPool(node_id=0, bind_memory=False)
+        self.assertEqual(cpu_pool.cpu_pool.get_numa_node_id(), -1)
+
+        # Task on the numa aware CPUPool
+        model = SimpleNet()
+        model.eval()
+        x = torch.rand(64, 64, 3, 3)
+        y = model(x)
+        task = ipex.cpu.runtime.Task(model, ipex.cpu.runtime.CPUPool(node_id=0))
+        self.assertEqual(y, task.run_sync(x))
+
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_create_cpu_pools(self):
+        core_siblings = ipex.cpu.runtime.get_physical_core_siblings(node_id=0)
+        physical_core_of = {core: siblings[0] for siblings in core_siblings for core in siblings}
+        num_pools = min(2, len(core_siblings))
+
+        def check_disjoint(core_lists):
+            physical_cores = [set(physical_core_of[core] for core in core_list) for core_list in core_lists]
+            self.assertEqual(len(set.union(*physical_cores)), sum(len(cores) for cores in physical_cores))
+
+        cpu_pools = ipex.cpu.runtime.create_cpu_pools(num_pools, node_id=0, policy="physical_only")
+        self.assertEqual(len(cpu_pools), num_pools)
+        check_disjoint([cpu_pool.core_ids for cpu_pool in cpu_pools])
+        for cpu_pool in cpu_pools:
+            self.assertTrue(all(physical_core_of[core] == core for core in cpu_pool.core_ids))
+            self.assertEqual(cpu_pool.numa_node_id, 0)
+
+        cpu_pools = ipex.cpu.runtime.create_cpu_pools(num_pools, node_id=0, policy="pair_siblings")
+        check_disjoint([cpu_pool.core_ids for cpu_pool in cpu_pools])
+        # All the logical cores of the node are used.
+        self.assertEqual(sum(len(cpu_pool.core_ids) for cpu_pool in cpu_pools), sum(len(siblings) for siblings in core_siblings))
+
+        cpu_pools = ipex.cpu.runtime.create_cpu_pools(num_pools, node_id=0, policy="siblings_for_helpers")
+        check_disjoint([cpu_pool.core_ids for cpu_pool, _ in cpu_pools])
+        for cpu_pool, helper_cpu_pool in cpu_pools:
+            if helper_cpu_pool is not None:
+                # The helper threads run on the siblings of the same physical cores.
+                self.assertEqual(set(physical_core_of[core] for core in helper_cpu_pool.core_ids), set(cpu_pool.core_ids))
+
+        with self.assertRaises(AssertionError):
+            ipex.cpu.runtime.create_cpu_pools(num_pools, node_id=0, policy="unknown")
+
     @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
     def test_module_result(self):
         model = SimpleNet()
@@ -124,6 +184,75 @@ class TestRuntimeAPI(TestCase):
         y_runtime = y_runtime_future.get()
         self.assertEqual(y, y_runtime)
 
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_task_memory_arena(self):
+        model = SimpleNet()
+        model.eval()
+        x = torch.rand(64, 64, 3, 3)
+        # Calculate the reference result
+        y = model(x)
+
+        cpu_pool = ipex.cpu.runtime.CPUPool([0], memory_arena=True)
+        task = ipex.cpu.runtime.Task(model, cpu_pool)
+        with torch.no_grad():
+            for _ in range(3):
+                self.assertEqual(y, task.run_sync(x))
+        stats = cpu_pool.memory_arena_stats()
+        # Same shape inference reuses the cached buffers
+        self.assertTrue(stats["hits"] > 0)
+        cpu_pool.reset_memory_arena()
+        self.assertEqual(cpu_pool.memory_arena_stats()["cached_bytes"], 0)
+
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_batched_wait_and_callback(self):
+        model = SimpleNet()
+        model.eval()
+        x = torch.rand(64, 64, 3, 3)
+        # Calculate the reference result
+        y = model(x)
+        traced_model = torch.jit.trace(model, x)
+
+        task = ipex.cpu.runtime.Task(traced_model, ipex.cpu.runtime.CPUPool([0]))
+        task2 = ipex.cpu.runtime.Task(model, ipex.cpu.runtime.CPUPool([1]))
+        done_flags = []
+        y_runtime_futures = [task(x), task2(x), task(x)]
+        for y_runtime_future in y_runtime_futures:
+            y_runtime_future.add_done_callback(lambda: done_flags.append(True))
+
+        self.assertTrue(ipex.cpu.runtime.wait_any(y_runtime_futures) in range(3))
+        y_runtimes = ipex.cpu.runtime.wait_all(y_runtime_futures)
+        for y_runtime_future in y_runtime_futures:
+            self.assertTrue(y_runtime_future.done())
+        for y_runtime in y_runtimes:
+            self.assertEqual(y, y_runtime)
+        self.assertEqual(len(done_flags), 3)
+
+        # Callback on a done future runs immediately
+        y_runtime_future = task(x)
+        y_runtime_future.wait()
+        y_runtime_future.add_done_callback(lambda: done_flags.append(True))
+        self.assertEqual(len(done_flags), 4)
+
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_task_warmup(self):
+        model = SimpleNet()
+        model.eval()
+        x = torch.rand(4, 64, 3, 3)
+        # Calculate the reference result
+        y = model(x)
+        traced_model = torch.jit.trace(model, x)
+
+        with torch.no_grad():
+            task = ipex.cpu.runtime.Task(traced_model, ipex.cpu.runtime.CPUPool([0]))
+            # Sizes and example tensors are both accepted
+            task.warmup([(4, 64, 3, 3), torch.rand(2, 64, 3, 3)])
+            self.assertEqual(y, task.run_sync(x))
+
+            cpu_pool = ipex.cpu.runtime.CPUPool(node_id=0)
+            multi_stream_model = ipex.cpu.runtime.MultiStreamModule(traced_model, num_streams=2, cpu_pool=cpu_pool)
+            multi_stream_model.warmup([(2, 64, 3, 3)], num_runs=2)
+            self.assertEqual(y, multi_stream_model(x))
+
     @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
     def test_multi_stream_module(self):
         model = SimpleNet()
@@ -141,5 +270,299 @@ class TestRuntimeAPI(TestCase):
         y_runtime = multi_stream_model(x)
         self.assertEqual(y, y_runtime)
 
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_multi_stream_script_module_gather(self):
+        model = SimpleNet()
+        model.eval()
+        x = torch.rand(7, 64, 3, 3)
+        # Calculate the reference result
+        y = model(x)
+        traced_model = torch.jit.trace(model, x)
+
+        # Script module goes through the native split and gather path
+        cpu_pool = ipex.cpu.runtime.CPUPool(node_id=0)
+        multi_stream_model = ipex.cpu.runtime.MultiStreamModule(traced_model, num_streams=2, cpu_pool=cpu_pool)
+        with torch.no_grad():
+            y_runtime = multi_stream_model(x)
+        self.assertEqual(y, y_runtime)
+
+        # Input batch size less than num_streams
+        multi_stream_model = ipex.cpu.runtime.MultiStreamModule(traced_model, num_streams=4, cpu_pool=cpu_pool)
+        with torch.no_grad():
+            y_runtime = multi_stream_model(x[:2])
+        self.assertEqual(y[:2], y_runtime)
+
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_multi_stream_module_work_stealing(self):
+        model = SimpleNet()
+        model.eval()
+        batch_size = ipex.cpu.runtime.get_core_list_of_node_id(0).__len__()
+        x = torch.rand(batch_size, 64, 3, 3)
+
+        # Calculate the reference result
+        y = model(x)
+
+        # Create MultiStreamModule with work stealing between streams
+        cpu_pool = ipex.cpu.runtime.CPUPool(node_id=0)
+        multi_stream_model = ipex.cpu.runtime.MultiStreamModule(model, num_streams=2, cpu_pool=cpu_pool, work_stealing=True)
+
+        for _ in range(4):
+            y_runtime = multi_stream_model(x)
+            self.assertEqual(y, y_runtime)
+
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_task_work_stealing(self):
+        model = SimpleNet()
+        model.eval()
+        x = torch.rand(64, 64, 3, 3)
+        # Calculate the reference result
+        y = model(x)
+
+        # Two tasks in the same work stealing group; only the first one is fed.
+        executor_group = ipex._C.TaskExecutorGroup()
+        task = ipex.cpu.runtime.Task(model, ipex.cpu.runtime.CPUPool([0]), executor_group)
+        idle_task = ipex.cpu.runtime.Task(model, ipex.cpu.runtime.CPUPool([1]), executor_group)
+
+        y_runtime_futures = [task(x) for _ in range(8)]
+        for y_runtime_future in y_runtime_futures:
+            self.assertEqual(y, y_runtime_future.get())
+
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_model_scheduler(self):
+        model = SimpleNet()
+        model.eval()
+        x = torch.rand(64, 64, 3, 3)
+        # Calculate the reference result
+        y = model(x)
+        traced_model = torch.jit.trace(model, x)
+
+        scheduler = ipex.cpu.runtime.ModelScheduler(cpu_pools=[ipex.cpu.runtime.CPUPool([0]), ipex.cpu.runtime.CPUPool([1])])
+        # The models of the least weight land on different executors
+        heavy = scheduler.register(traced_model, weight=2)
+        light = scheduler.register(SlowNet(0.1), weight=1, slo_ms=50, service_ms=100)
+        self.assertNotEqual(heavy.home_executors, light.home_executors)
+        with torch.no_grad():
+            heavy.warmup([(64, 64, 3, 3)])
+        self.assertIsNotNone(heavy.get_stats()["service_ms"])
+
+        heavy_futures = [heavy(x) for _ in range(4)]
+        # The inputs of the SLO which can't be met run in the high priority lane
+        light_futures = [light(x) for _ in range(2)]
+        for future in heavy_futures:
+            self.assertEqual(y, future.get())
+        for future in light_futures:
+            self.assertEqual(x + 1, future.get())
+        self.assertEqual(heavy.get_stats()["submitted"], 4)
+        self.assertGreaterEqual(light.get_stats()["high_priority"], 1)
+        self.assertEqual([stats["weight"] for stats in scheduler.get_stats()], [2, 1])
+
+        scheduler.unregister(light)
+        self.assertEqual([stats["weight"] for stats in scheduler.get_stats()], [2, 0])
+        scheduler.shutdown()
+
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_micro_batch_module(self):
+        model = SimpleNet()
+        model.eval()
+        x = torch.rand(8, 64, 3, 3)
+        # Calculate the reference result
+        y = model(x)
+        traced_model = torch.jit.trace(model, x)
+
+        # Submit single-sample requests and gather them into micro-batches
+        cpu_pool = ipex.cpu.runtime.CPUPool(node_id=0)
+        micro_batch_model = ipex.cpu.runtime.MicroBatchModule(traced_model, num_streams=2, cpu_pool=cpu_pool, max_batch_size=4, max_latency_ms=10)
+        y_runtime_futures = [micro_batch_model(x[i:i + 1]) for i in range(x.size(0))]
+        y_runtime = torch.cat([y_runtime_future.get() for y_runtime_future in y_runtime_futures])
+        self.assertEqual(y, y_runtime)
+
+        # Request larger than max_batch_size is dispatched alone
+        self.assertEqual(y, micro_batch_model.run_sync(x))
+        micro_batch_model.stop()
+
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_task_resize(self):
+        model = SimpleNet()
+        model.eval()
+        x = torch.rand(64, 64, 3, 3)
+        # Calculate the reference result
+        y = model(x)
+        traced_model = torch.jit.trace(model, x)
+
+        task = ipex.cpu.runtime.Task(traced_model, ipex.cpu.runtime.CPUPool([0]))
+        y_runtime_futures = [task(x) for _ in range(4)]
+        # Resize while inputs are still queued, they finish on either pool.
+        task.resize(ipex.cpu.runtime.CPUPool([0, 1]))
+        self.assertEqual(task.get_core_ids(), [0, 1])
+        for y_runtime_future in y_runtime_futures:
+            self.assertEqual(y, y_runtime_future.get())
+        self.assertEqual(y, task.run_sync(x))
+
+        # Shrink back
+        task.resize(ipex.cpu.runtime.CPUPool([1]))
+        self.assertEqual(y, task(x).get())
+        self.assertEqual(task.get_core_ids(), [1])
+
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_task_high_priority(self):
+        model = SimpleNet()
+        model.eval()
+        x = torch.rand(64, 64, 3, 3)
+        # Calculate the reference result
+        y = model(x)
+        traced_model = torch.jit.trace(model, x)
+
+        task = ipex.cpu.runtime.Task(traced_model, ipex.cpu.runtime.CPUPool([0]))
+        y_runtime_futures = [task(x) for _ in range(4)]
+        y_runtime_high_priority_future = task.run_high_priority(x)
+        self.assertEqual(y, y_runtime_high_priority_future.get())
+        for y_runtime_future in y_runtime_futures:
+            self.assertEqual(y, y_runtime_future.get())
+
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_task_queue_limit(self):
+        x = torch.rand(2, 3)
+        task = ipex.cpu.runtime.Task(SlowNet(0.5), ipex.cpu.runtime.CPUPool([0]))
+        task.set_queue_limit(1, "reject")
+        running_future = task(x)
+        # Wait for the first input to start
+        while task.get_queue_stats()["queued_tasks"] != 0:
+            time.sleep(0.01)
+        oldest_future = task(x)
+        with self.assertRaises(ipex.cpu.runtime.TaskQueueFullError):
+            task(x)
+
+        task.set_queue_limit(1, "drop_oldest")
+        newest_future = task(x)
+        with self.assertRaises(ipex.cpu.runtime.TaskDroppedError):
+            oldest_future.get()
+
+        stats = task.get_queue_stats()
+        self.assertEqual(stats["rejected_tasks"], 1)
+        self.assertEqual(stats["dropped_tasks"], 1)
+        self.assertEqual(stats["peak_queued_tasks"], 1)
+        self.assertEqual(x + 1, running_future.get())
+        self.assertEqual(x + 1, newest_future.get())
+
+        # The blocked caller continues once the queued input starts
+        task.set_queue_limit(1, "block")
+        futures = [task(x) for _ in range(3)]
+        self.assertGreaterEqual(task.get_queue_stats()["blocked_submissions"], 1)
+        for future in futures:
+            self.assertEqual(x + 1, future.get())
+
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_task_tracing(self):
+        model = SimpleNet()
+        model.eval()
+        x = torch.rand(64, 64, 3, 3)
+        traced_model = torch.jit.trace(model, x)
+        task = ipex.cpu.runtime.Task(traced_model, ipex.cpu.runtime.CPUPool([0]))
+        with ipex.cpu.runtime.trace_tasks() as trace:
+            y_runtime_futures = []
+            for request_id in range(4):
+                with ipex.cpu.runtime.request_scope(request_id):
+                    y_runtime_futures.append(task(x))
+            for y_runtime_future in y_runtime_futures:
+                y_runtime_future.get()
+        # Not traced
+        task(x).get()
+
+        # The record is appended right after the result is ready.
+        deadline = time.time() + 10
+        while len(trace.records) < 4 and time.time() < deadline:
+            time.sleep(0.01)
+        records = trace.records
+        self.assertEqual(sorted(record['request_id'] for record in records), [0, 1, 2, 3])
+        for record in records:
+            self.assertGreaterEqual(record['queue_time_us'], 0)
+            self.assertGreaterEqual(record['execution_time_us'], 0)
+        self.assertEqual(len(set(record['executor_id'] for record in records)), 1)
+
+        with tempfile.TemporaryDirectory() as tmp_dir:
+            trace_file = os.path.join(tmp_dir, 'trace.json')
+            trace.export_chrome_trace(trace_file)
+            with open(trace_file) as f:
+                events = json.load(f)['traceEvents']
+        self.assertEqual(sum(event['ph'] == 'X' for event in events), 4)
+
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_task_spin_idle_policy(self):
+        model = SimpleNet()
+        model.eval()
+        x = torch.rand(64, 64, 3, 3)
+        # Calculate the reference result
+        y = model(x)
+        traced_model = torch.jit.trace(model, x)
+
+        cpu_pool = ipex.cpu.runtime.CPUPool([0, 1], spin_time_us=1000)
+        self.assertEqual(cpu_pool.cpu_pool.get_spin_time_us(), 1000)
+        task = ipex.cpu.runtime.Task(traced_model, cpu_pool)
+        for _ in range(4):
+            self.assertEqual(y, task(x).get())
+        # The Task sleeps after spinning, and still wakes up for the next input.
+        time.sleep(0.01)
+        self.assertEqual(y, task(x).get())
+
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_pipeline_module(self):
+        model = SimpleNet()
+        model.eval()
+        x = torch.rand(8, 64, 3, 3)
+        # Calculate the reference result
+        y = model(x)
+
+        # Two stages: the conv and the flatten
+        stage0 = torch.jit.trace(model.conv, x)
+        stage1 = torch.jit.trace(torch.nn.Flatten(start_dim=1), stage0(x))
+        cpu_pools = [ipex.cpu.runtime.CPUPool([0]), ipex.cpu.runtime.CPUPool([1])]
+        pipeline_model = ipex.cpu.runtime.PipelineModule([stage0, stage1], cpu_pools, max_queue_size=1)
+
+        # Micro-batches stream through the stages
+        self.assertEqual(y, pipeline_model.run_sync(x, num_micro_batches=4))
+        y_runtime_futures = [pipeline_model(x[i:i + 1]) for i in range(x.size(0))]
+        y_runtime = torch.cat(ipex.cpu.runtime.wait_all(y_runtime_futures))
+        self.assertEqual(y, y_runtime)
+        pipeline_model.stop()
+
+    @unittest.skipIf(not ipex.cpu.runtime.is_runtime_ext_enabled(), "Skip when IPEX Runtime extension is not enabled")
+    def test_input_pipeline(self):
+        model = SimpleNet()
+        model.eval()
+        traced_model = torch.jit.trace(model, torch.rand(2, 64, 3, 3))
+
+        def preprocess(offset, scale):
+            return torch.arange(2 * 64 * 3 * 3).view(2, 64, 3, 3) / 1000. * scale + offset
+
+        pipeline = ipex.cpu.runtime.InputPipeline(preprocess, ipex.cpu.runtime.CPUPool([0, 1]), num_workers=2, prefetch=3)
+        self.assertEqual(pipeline.get_core_ids(), [[0], [1]])
+        multi_stream_model = ipex.cpu.runtime.MultiStreamModule(traced_model, num_streams=2, cpu_pool=ipex.cpu.runtime.CPUPool([2, 3]))
+        # the queued items keep their own inputs, and are yielded in order
+        items = [(i, float(i + 1)) for i in range(8)]
+        with torch.no_grad():
+            for (offset, scale), batch in zip(items, pipeline.map(items)):
+                self.assertEqual(batch, preprocess(offset, scale))
+                self.assertEqual(model(batch), multi_stream_model(batch))
+
+    def test_op_thread_policy(self):
+        for op_name in ["layer_norm", "softmax", "embedding_bag"]:
+            default_min_work = ipex.cpu.runtime.get_op_min_work_per_thread(op_name)
+            self.assertEqual(default_min_work, 4096)
+            ipex.cpu.runtime.set_op_min_work_per_thread(op_name, 1)
+            self.assertEqual(ipex.cpu.runtime.get_op_min_work_per_thread(op_name), 1)
+            ipex.cpu.runtime.set_op_min_work_per_thread(op_name, default_min_work)
+        with self.assertRaisesRegex(RuntimeError, "Unknown op of the thread policy"):
+            ipex.cpu.runtime.set_op_min_work_per_thread("conv", 1)
+
+        # The result doesn't depend on the thread count
+        model = torch.nn.LayerNorm(64).eval()
+        x = torch.rand(2, 64)
+        traced_model = torch.jit.freeze(torch.jit.trace(model, x))
+        with torch.no_grad():
+            y = traced_model(x)
+            ipex.cpu.runtime.set_op_min_work_per_thread("layer_norm", 0)
+            self.assertEqual(y, traced_model(x))
+            ipex.cpu.runtime.set_op_min_work_per_thread("layer_norm", 4096)
+
 if __name__ == '__main__':
     test = unittest.main()
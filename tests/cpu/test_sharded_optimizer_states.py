@@ -0,0 +1,68 @@
+import torch
+import torch.distributed as dist
+import torch.multiprocessing as mp
+import intel_extension_for_pytorch as ipex  # flake8: noqa
+import unittest
+import os
+import tempfile
+from torch.testing._internal.common_utils import TestCase
+from common_utils import TestModule
+from intel_extension_for_pytorch.optim._sharded_states import shard_params
+
+WORLD_SIZE = 2
+
+def _make_optimizers():
+    return [
+        lambda params: torch.optim.SGD(params, lr=0.1, momentum=0.9, weight_decay=0.1),
+        lambda params: torch.optim.Adagrad(params, lr=0.1, weight_decay=0.1),
+        lambda params: torch.optim.Adam(params, lr=0.1, weight_decay=0.1),
+        lambda params: ipex.optim._lamb.Lamb(params, lr=0.1, weight_decay=0.1, fused=True),
+    ]
+
+def _train(make_optimizer, sharded):
+    torch.manual_seed(0)
+    M = TestModule()
+    ipex_module, ipex_optimizer = ipex.optimize(
+        M, dtype=torch.bfloat16, optimizer=make_optimizer(M.parameters()), weights_prepack=False)
+    if sharded:
+        ipex.optim.shard_optimizer_states(ipex_optimizer)
+    # the first step of SGD initializes the momentum buffers
+    for _ in range(2):
+        ipex_module.attach_grad(torch.bfloat16)
+        ipex_optimizer.step()
+    return ipex_module, ipex_optimizer
+
+def _run_rank(rank, init_file, result_file):
+    dist.init_process_group(
+        "gloo", init_method="file://" + init_file, rank=rank, world_size=WORLD_SIZE)
+    results = []
+    for make_optimizer in _make_optimizers():
+        module, optimizer = _train(make_optimizer, sharded=True)
+        results.append({"model": module.state_dict(), "num_states": len(optimizer.state)})
+    torch.save(results, "{}.{}".format(result_file, rank))
+    dist.destroy_process_group()
+
+class TestShardedOptimizerStates(TestCase):
+    def test_shard_params(self):
+        params = [torch.empty(100), torch.empty(1000), torch.empty(100, dtype=torch.bfloat16), torch.empty(10)]
+        self.assertEqual(shard_params(params, 2), [1, 0, 1, 1])
+        self.assertEqual(shard_params(params, 1), [0, 0, 0, 0])
+
+    @unittest.skipIf(not dist.is_available(), "torch.distributed is not available")
+    def test_training(self):
+        with tempfile.TemporaryDirectory() as path:
+            result_file = os.path.join(path, "result")
+            mp.spawn(_run_rank, args=(os.path.join(path, "init"), result_file), nprocs=WORLD_SIZE)
+            results = [torch.load("{}.{}".format(result_file, rank)) for rank in range(WORLD_SIZE)]
+
+        for i, make_optimizer in enumerate(_make_optimizers()):
+            ref_module, ref_optimizer = _train(make_optimizer, sharded=False)
+            ref_model_state = ref_module.state_dict()
+            # each param is updated by one rank, and all the ranks hold the updated params
+            self.assertEqual(sum(result[i]["num_states"] for result in results), len(ref_optimizer.state))
+            for result in results:
+                for var_name in ref_model_state:
+                    self.assertEqual(ref_model_state[var_name], result[i]["model"][var_name])
+
+if __name__ == '__main__':
+    test = unittest.main()
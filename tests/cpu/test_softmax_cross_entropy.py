@@ -0,0 +1,42 @@
+import unittest
+import torch
+import torch.nn.functional as F
+import intel_extension_for_pytorch as ipex
+from torch.testing._internal.common_utils import TestCase
+import itertools
+
+class TestSoftmaxCrossEntropy(TestCase):
+
+    def _test_softmax_cross_entropy(self, dtype, classes, reduction):
+        x = (torch.randn(16, classes) * 10).to(dtype).requires_grad_()
+        target = torch.randint(classes, (16,))
+        # the ignored rows are not counted by the mean
+        target[3] = -100
+        ref_x = x.detach().clone().requires_grad_()
+
+        ref_out = F.cross_entropy(ref_x.float(), target, reduction=reduction)
+        out = ipex.nn.functional.softmax_cross_entropy(x, target, reduction)
+        self.assertEqual(out.dtype, dtype)
+
+        grad = torch.randn(ref_out.shape)
+        ref_out.backward(grad)
+        out.backward(grad.to(dtype))
+        prec = 2e-2 if dtype == torch.bfloat16 else 1e-4
+        self.assertEqual(out.float(), ref_out, atol=prec, rtol=prec)
+        self.assertEqual(x.grad.float(), ref_x.grad.float(), atol=prec, rtol=prec)
+
+    def test_softmax_cross_entropy(self):
+        # both of the vectorized rows and the ones with a tail
+        for dtype, classes, reduction in itertools.product(
+                [torch.float, torch.bfloat16], [64, 1000, 32003], ['mean', 'sum', 'none']):
+            self._test_softmax_cross_entropy(dtype, classes, reduction)
+
+    def test_softmax_cross_entropy_fallback(self):
+        # the class dim 1 of the N-d logits goes to cross_entropy
+        x = torch.randn(2, 10, 5)
+        target = torch.randint(10, (2, 5))
+        out = ipex.nn.functional.softmax_cross_entropy(x, target)
+        self.assertEqual(out, F.cross_entropy(x, target))
+
+if __name__ == '__main__':
+    test = unittest.main()
@@ -2,6 +2,8 @@ import unittest
 from common_utils import TestCase
 import os
 import subprocess
+import torch
+import intel_extension_for_pytorch as ipex
 
 class TestVerbose(TestCase):
     def test_verbose_on(self):
@@ -24,5 +26,43 @@ class TestVerbose(TestCase):
                     num = num + 1
         assert num == 0, 'unexpected oneDNN verbose messages found.'
 
+    def test_verbose_capture(self):
+        m = torch.nn.Conv2d(1, 10, 5, 1).eval()
+        m = ipex.optimize(m, dtype=torch.float32, level="O1")
+        d = torch.rand(1, 1, 112, 112)
+        with torch.no_grad():
+            m(d)
+            with ipex.verbose(ipex.VERBOSE_ON, capture=True) as v:
+                m(d)
+        records = v.records(kind='convolution')
+        self.assertGreater(len(records), 0)
+        for r in records:
+            self.assertEqual(r['stage'], 'exec')
+            self.assertEqual(r['engine'], 'cpu')
+            self.assertTrue(r['impl'])
+            self.assertGreaterEqual(r['time_ms'], 0)
+        self.assertEqual(v.records(kind='convolution', min_time_ms=1e9), [])
+        # not captured out of the scope
+        m(d)
+        self.assertEqual(v.records(kind='convolution'), records)
+
+    def test_parse_verbose_line(self):
+        line = ('onednn_verbose,primitive,exec,cpu,reorder,jit:uni,undef,'
+                'src_f32::blocked:abcd::f0 dst_f32::blocked:aBcd16b::f0,,,2x16x7x7,0.0129')
+        r = ipex._C._parse_verbose_line(line)
+        self.assertEqual(r['stage'], 'exec')
+        self.assertEqual(r['kind'], 'reorder')
+        self.assertEqual(r['impl'], 'jit:uni')
+        self.assertEqual(r['problem'], '2x16x7x7')
+        self.assertAlmostEqual(r['time_ms'], 0.0129)
+        # of oneDNN 2.x, and of a timestamp
+        r = ipex._C._parse_verbose_line(
+            'dnnl_verbose,1690000000000.1,exec,cpu,convolution,jit:avx512_core,forward_inference,'
+            'src_f32::blocked:aBcd16b:f0,,alg:convolution_direct,mb1_ic16oc16_ih7oh7kh3sh1dh0ph1_iw7ow7kw3sw1dw0pw1,0.05')
+        self.assertEqual(r['kind'], 'convolution')
+        self.assertEqual(r['aux'], 'alg:convolution_direct')
+        self.assertIsNone(ipex._C._parse_verbose_line('onednn_verbose,info,oneDNN v3.0.0'))
+        self.assertIsNone(ipex._C._parse_verbose_line('hello'))
+
 if __name__ == '__main__':
     test = unittest.main()
@@ -1,7 +1,10 @@
 import unittest
 import itertools
 import copy
+import io
 import os
+import tempfile
+import threading
 
 try:
     import torchvision
@@ -167,6 +170,44 @@ class TestPrepackCases(TestCase):
                     self.assertEqual(origin_optimizer_state[var_name], ipex_optimizer_state1[var_name], rtol=1e-2, atol=5e-02)
                     self.assertEqual(origin_optimizer_state[var_name], ipex_optimizer_state2[var_name], rtol=1e-2, atol=5e-02)
 
+    def test_conv2d_1x1_backward_weights(self):
+        # the pointwise convolutions of few pixels and many channels, of which
+        # the weight gradient is reduced over the pixels by the threads, with
+        # the tails of the tiles of the channels
+        options = itertools.product([torch.float, torch.bfloat16],
+                                    [(2, 256, 130, 7), (32, 96, 64, 14), (1, 64, 64, 1)],
+                                    [True, False])
+        for dtype, (N, C, M, H), bias in options:
+            model = torch.nn.Conv2d(C, M, kernel_size=1, stride=1, padding=0, bias=bias)
+            model = model.to(memory_format=torch.channels_last).train()
+            x = torch.randn(N, C, H, H).to(memory_format=torch.channels_last)
+            origin_model = copy.deepcopy(model).train()
+            origin_optimizer = SGD(origin_model.parameters(), lr=0.01, momentum=0.9)
+            ipex_model = copy.deepcopy(model).train()
+            ipex_optimizer = SGD(ipex_model.parameters(), lr=0.01, momentum=0.9)
+            ipex_model, ipex_optimizer = ipex.optimize(ipex_model, dtype=dtype, optimizer=ipex_optimizer, level='O1')
+            x1 = x.clone().requires_grad_()
+            x2 = x.clone().requires_grad_()
+            with torch.cpu.amp.autocast(enabled=True, dtype=dtype):
+                y1 = origin_model(x1)
+                origin_optimizer.zero_grad()
+                y1.sum().backward()
+                origin_optimizer.step()
+                y2 = ipex_model(x2)
+                ipex_optimizer.zero_grad()
+                y2.sum().backward()
+                ipex_optimizer.step()
+            self.assertEqual(x1.grad, x2.grad, rtol=1e-4, atol=5e-02)
+            if bias:
+                self.assertEqual(origin_model.bias.grad, ipex_model.bias.grad.float(), rtol=1e-2, atol=5e-02)
+            # the momentum buffers of the first step are the gradients
+            self.assertEqual(origin_optimizer.state_dict()['state'], ipex_optimizer.state_dict()['state'],
+                             rtol=1e-2, atol=5e-02)
+            origin_model_state = origin_model.state_dict()
+            ipex_model_state = ipex_model.state_dict()
+            for var_name in origin_model_state:
+                self.assertEqual(origin_model_state[var_name], ipex_model_state[var_name], rtol=1e-2, atol=5e-02)
+
     def test_model_serialization(self):
         model = torch.nn.Conv2d(3, 64, kernel_size=(7, 7), stride=(2, 2), padding=(3, 3), bias=False)
         model = model.to(memory_format=torch.channels_last).train()
@@ -314,6 +355,262 @@ class TestPrepackCases(TestCase):
         model = torchvision.models.resnet.resnext50_32x4d(pretrained=False)
         self._test_imagenet_model(model)
 
+    def test_packed_weight_cache(self):
+        model = torch.nn.LSTM(16, 32, num_layers=2).eval()
+        x = torch.randn(5, 3, 16)
+        with torch.no_grad():
+            y_ref = model(x)[0]
+        ipex_model = ipex.optimize(copy.deepcopy(model), dtype=torch.float32, optimize_lstm=True)
+        ipex.release_packed_weights()
+        with torch.no_grad():
+            ipex_model(x)
+            y = ipex_model(x)[0]
+        self.assertEqual(y_ref, y)
+        stats = ipex.get_packed_weight_cache_stats()
+        if stats["entries"] == 0:
+            self.skipTest("The LSTM weights are not packed on this ISA")
+        self.assertGreater(stats["hits"], 0)
+
+        # The packed weights are released with the model
+        ipex.release_packed_weights(ipex_model)
+        self.assertEqual(ipex.get_packed_weight_cache_stats()["entries"], 0)
+
+        # The packed weights evicted by the memory budget are packed again
+        ipex.set_packed_weight_cache_capacity(0)
+        try:
+            with torch.no_grad():
+                y = ipex_model(x)[0]
+            self.assertEqual(y_ref, y)
+            stats = ipex.get_packed_weight_cache_stats()
+            self.assertEqual(stats["entries"], 0)
+            self.assertGreater(stats["evictions"], 0)
+        finally:
+            ipex.set_packed_weight_cache_capacity(-1)
+
+    def test_lstm_packed_sequence(self):
+        options = itertools.product([1, 2], [True, False], [True, False], [True, False])
+        for num_layers, bidirectional, batch_first, bias in options:
+            model = torch.nn.LSTM(16, 32, num_layers=num_layers, bidirectional=bidirectional,
+                                  batch_first=batch_first, bias=bias).eval()
+            ipex_model = ipex.optimize(copy.deepcopy(model), dtype=torch.float32, optimize_lstm=True)
+            num_directions = 2 if bidirectional else 1
+            x = torch.randn(6, 5, 16) if batch_first else torch.randn(5, 6, 16)
+            hx = torch.randn(num_layers * num_directions, 6, 32)
+            cx = torch.randn(num_layers * num_directions, 6, 32)
+            # unsorted lengths with ties, of which the batch of each time step shrinks
+            lengths = torch.tensor([3, 5, 1, 3, 4, 5])
+            packed = torch.nn.utils.rnn.pack_padded_sequence(
+                x, lengths, batch_first=batch_first, enforce_sorted=False)
+            with torch.no_grad():
+                y_ref, (hy_ref, cy_ref) = model(packed, (hx, cx))
+                y, (hy, cy) = ipex_model(packed, (hx, cx))
+            self.assertTrue(isinstance(y, torch.nn.utils.rnn.PackedSequence))
+            self.assertEqual(y.batch_sizes, y_ref.batch_sizes)
+            self.assertEqual(y.data, y_ref.data)
+            self.assertEqual(hy, hy_ref)
+            self.assertEqual(cy, cy_ref)
+
+    def test_packed_weight_serialization(self):
+        class M(torch.nn.Module):
+            def __init__(self):
+                super(M, self).__init__()
+                self.conv = torch.nn.Conv2d(4, 8, kernel_size=3, padding=1, groups=2)
+                self.deconv = torch.nn.ConvTranspose2d(8, 4, kernel_size=3, stride=2)
+                self.linear = torch.nn.Linear(15, 6)
+
+            def forward(self, x):
+                return self.linear(self.deconv(self.conv(x)))
+
+        x = torch.randn(2, 4, 7, 7)
+        for use_ipex_optimize in [True, False]:
+            model = M().eval()
+            if use_ipex_optimize:
+                model = ipex.optimize(model, dtype=torch.float32)
+            with torch.no_grad():
+                traced_model = torch.jit.freeze(torch.jit.trace(model, x))
+                traced_model(x)
+                y_ref = traced_model(x)
+            with tempfile.TemporaryDirectory() as tmp:
+                path = os.path.join(tmp, "model.pt")
+                self.assertFalse(ipex.is_packed_weight_serialization_enabled())
+                ipex.enable_packed_weight_serialization(True)
+                try:
+                    torch.jit.save(traced_model, path)
+                finally:
+                    ipex.enable_packed_weight_serialization(False)
+                loaded_model = torch.jit.load(path)
+                with torch.no_grad():
+                    self.assertEqual(y_ref, loaded_model(x))
+
+                # The loaded model keeps the packed weights when saved again
+                torch.jit.save(loaded_model, path)
+                loaded_model = torch.jit.load(path)
+                with torch.no_grad():
+                    self.assertEqual(y_ref, loaded_model(x))
+
+    def test_conv_prepack_multiple_input_shapes(self):
+        model = torch.nn.Sequential(
+            torch.nn.Conv2d(16, 32, kernel_size=3, padding=1),
+            torch.nn.ReLU(),
+            torch.nn.Conv2d(32, 32, kernel_size=3, groups=2)).eval()
+        with torch.no_grad():
+            traced_model = torch.jit.freeze(torch.jit.trace(model, torch.randn(1, 16, 32, 32)))
+            # Run the recurring resolutions more than once, so that both the
+            # first use and the reuse of the variant packed for each of them
+            # are checked.
+            for shape in [(1, 16, 32, 32), (1, 16, 48, 48), (2, 16, 64, 40), (1, 16, 48, 48), (2, 16, 64, 40)]:
+                for memory_format in [torch.contiguous_format, torch.channels_last]:
+                    x = torch.randn(shape).to(memory_format=memory_format)
+                    self.assertEqual(model(x), traced_model(x))
+
+    def test_weight_pack_batch(self):
+        convs = [torch.nn.Conv2d(8, 16, kernel_size=3, padding=1), torch.nn.Conv2d(16, 8, kernel_size=1, groups=2, stride=2)]
+        packed = torch.ops.torch_ipex.conv2d_weight_pack_batch(
+            [m.weight for m in convs],
+            [p for m in convs for p in m.padding],
+            [s for m in convs for s in m.stride],
+            [d for m in convs for d in m.dilation],
+            [m.groups for m in convs])
+        for m, w in zip(convs, packed):
+            self.assertEqual(torch.ops.torch_ipex.conv2d_weight_pack(m.weight, m.padding, m.stride, m.dilation, m.groups), w)
+
+        linears = [torch.nn.Linear(32, 64), torch.nn.Linear(64, 10)]
+        packed = torch.ops.torch_ipex.linear_weight_pack_batch([m.weight for m in linears])
+        for m, w in zip(linears, packed):
+            self.assertEqual(torch.ops.torch_ipex.linear_weight_pack(m.weight), w)
+
+        deconvs = [torch.nn.ConvTranspose2d(8, 4, kernel_size=3, stride=2, output_padding=1), torch.nn.ConvTranspose2d(4, 4, kernel_size=2, groups=2)]
+        packed = torch.ops.torch_ipex.conv_transpose2d_weight_pack_batch(
+            [m.weight for m in deconvs],
+            [s for m in deconvs for s in m.stride],
+            [p for m in deconvs for p in m.padding],
+            [p for m in deconvs for p in m.output_padding],
+            [m.groups for m in deconvs],
+            [d for m in deconvs for d in m.dilation])
+        for m, w in zip(deconvs, packed):
+            self.assertEqual(torch.ops.torch_ipex.conv_transpose2d_weight_pack(
+                m.weight, m.stride, m.padding, m.output_padding, m.groups, m.dilation), w)
+
+        with self.assertRaises(RuntimeError):
+            torch.ops.torch_ipex.conv2d_weight_pack_batch([convs[0].weight], [1], [1, 1], [1, 1], [1])
+
+    def test_lazy_weight_prepack(self):
+        class M(torch.nn.Module):
+            def __init__(self):
+                super(M, self).__init__()
+                self.conv = torch.nn.Conv2d(4, 8, kernel_size=3, padding=1)
+                self.deconv = torch.nn.ConvTranspose2d(8, 4, kernel_size=3, stride=2)
+                self.linear = torch.nn.Linear(15, 6)
+
+            def forward(self, x):
+                return self.linear(self.deconv(self.conv(x)))
+
+        model = M().eval()
+        x = torch.randn(2, 4, 7, 7)
+        with torch.no_grad():
+            y_ref = model(x)
+        for trace in [False, True]:
+            lazy_model = ipex.optimize(model, dtype=torch.float32, auto_kernel_selection=True, lazy_weights_prepack=True)
+            prepacked = [lazy_model.conv, lazy_model.deconv, lazy_model.linear]
+            self.assertTrue(all(not m.weight_packed for m in prepacked))
+            # The plain weights are saved before the first forward
+            self.assertEqual(model.state_dict(), lazy_model.state_dict())
+            with torch.no_grad():
+                if trace:
+                    lazy_model = torch.jit.freeze(torch.jit.trace(lazy_model, x))
+                self.assertEqual(y_ref, lazy_model(x))
+                self.assertEqual(y_ref, lazy_model(x))
+            self.assertTrue(all(m.weight_packed for m in prepacked))
+            if not trace:
+                self.assertEqual(model.state_dict(), lazy_model.state_dict())
+
+    def test_unpacked_state_dict_and_in_place_load(self):
+        class M(torch.nn.Module):
+            def __init__(self):
+                super(M, self).__init__()
+                self.conv = torch.nn.Conv2d(4, 8, kernel_size=3, padding=1)
+                self.deconv = torch.nn.ConvTranspose2d(8, 4, kernel_size=3, stride=2)
+                self.linear = torch.nn.Linear(15, 6)
+
+            def forward(self, x):
+                return self.linear(self.deconv(self.conv(x)))
+
+        x = torch.randn(2, 4, 7, 7)
+        # SGD has the split master weight for bfloat16, Adadelta the master weight
+        for dtype, optimizer, channels_last in itertools.product(
+                [torch.float, torch.bfloat16], [SGD, Adadelta], [False, True]):
+            model = M().train()
+            if channels_last:
+                model = model.to(memory_format=torch.channels_last)
+            ipex_model, ipex_optimizer = ipex.optimize(
+                model, dtype=dtype, optimizer=optimizer(model.parameters(), lr=0.01), auto_kernel_selection=True)
+            with torch.cpu.amp.autocast(enabled=True, dtype=dtype):
+                ipex_model(x).sum().backward()
+            ipex_optimizer.step()
+
+            state_dict = ipex_model.state_dict()
+            with tempfile.TemporaryDirectory() as tmp:
+                f = io.BytesIO()
+                ipex.save_unpacked_state_dict(ipex_model, f, tmp_dir=tmp)
+                self.assertEqual(os.listdir(tmp), [])
+            f.seek(0)
+            self.assertEqual(state_dict, torch.load(f))
+
+            # Write the updated weights into the packed parameters in place
+            new_state_dict = {k: v + 1 for k, v in state_dict.items()}
+            data_ptrs = [p.data_ptr() for p in ipex_model.parameters()]
+            ipex_model.load_state_dict(new_state_dict)
+            self.assertEqual(data_ptrs, [p.data_ptr() for p in ipex_model.parameters()])
+            self.assertEqual(new_state_dict, ipex_model.state_dict())
+
+            with self.assertRaises(RuntimeError):
+                ipex_model.load_state_dict({k: v for k, v in new_state_dict.items() if k != 'conv.weight'})
+
+    def test_conv_prepack_cached_primitive(self):
+        class ConvSum(torch.nn.Module):
+            def __init__(self):
+                super(ConvSum, self).__init__()
+                self.conv = torch.nn.Conv2d(16, 16, kernel_size=3, padding=1)
+                self.conv1 = torch.nn.Conv2d(16, 16, kernel_size=3, padding=1)
+
+            def forward(self, x):
+                return self.conv1(torch.relu(self.conv(x))) + x
+
+        model = ConvSum().eval()
+        with torch.no_grad():
+            traced_model = torch.jit.freeze(torch.jit.trace(model, torch.randn(1, 16, 32, 32)))
+            # The repeated shape reuses the primitive of the previous run, the
+            # other ones replace it.
+            for shape in [(1, 16, 32, 32), (1, 16, 32, 32), (2, 16, 24, 24), (1, 16, 32, 32)]:
+                for memory_format in [torch.contiguous_format, torch.channels_last, torch.channels_last]:
+                    x = torch.randn(shape).to(memory_format=memory_format)
+                    self.assertEqual(model(x), traced_model(x))
+
+            # The runs of the finalized primitive only rebind the input and
+            # output buffers, of which each run has new ones.
+            conv = torch.nn.Conv2d(16, 16, kernel_size=1, bias=False).eval()
+            traced_conv = torch.jit.freeze(torch.jit.trace(conv, torch.randn(1, 16, 8, 8)))
+            for _ in range(3):
+                x = torch.randn(1, 16, 8, 8).to(memory_format=torch.channels_last)
+                self.assertEqual(conv(x), traced_conv(x))
+
+            # The threads sharing the op contexts fall back to the ideep path
+            # while the cached primitive is in use.
+            inputs = [torch.randn(1, 16, 32, 32) for _ in range(8)]
+            results = [None] * len(inputs)
+
+            def run(i):
+                for _ in range(4):
+                    results[i] = traced_model(inputs[i])
+
+            threads = [threading.Thread(target=run, args=(i,)) for i in range(len(inputs))]
+            for t in threads:
+                t.start()
+            for t in threads:
+                t.join()
+            for x, y in zip(inputs, results):
+                self.assertEqual(model(x), y)
+
     def test_linear_inference(self):
         class L(torch.nn.Module):
             def __init__(self, in_f, out_f, bias):
@@ -0,0 +1,51 @@
+import unittest
+import copy
+import os
+import tempfile
+
+import torch
+import intel_extension_for_pytorch as ipex
+from torch.testing._internal.common_utils import TestCase
+
+class Net(torch.nn.Module):
+    def __init__(self):
+        super(Net, self).__init__()
+        self.conv = torch.nn.Conv2d(3, 16, kernel_size=3, padding=1)
+        self.bn = torch.nn.BatchNorm2d(16)
+        self.linear = torch.nn.Linear(16 * 8 * 8, 10)
+
+    def forward(self, x):
+        x = self.bn(self.conv(x))
+        return self.linear(x.flatten(1))
+
+class TestWeightSharing(TestCase):
+    def test_share_weights(self):
+        x = torch.rand(2, 3, 8, 8)
+        model = Net().eval()
+        with tempfile.TemporaryDirectory() as tmp_dir:
+            path = os.path.join(tmp_dir, 'weights')
+            for dtype in [torch.float32, torch.bfloat16]:
+                if os.path.exists(path + '.json'):
+                    os.remove(path + '.json')
+                ipex_model = ipex.optimize(copy.deepcopy(model), dtype=dtype)
+                with torch.no_grad(), torch.cpu.amp.autocast(enabled=dtype == torch.bfloat16):
+                    y_ref = ipex_model(x)
+                # The first model writes the store, the second one only maps it.
+                shared_models = [ipex.share_weights(ipex.optimize(copy.deepcopy(model), dtype=dtype), path) for _ in range(2)]
+                for shared_model in shared_models:
+                    with torch.no_grad(), torch.cpu.amp.autocast(enabled=dtype == torch.bfloat16):
+                        self.assertEqual(y_ref, shared_model(x))
+                # Both models map the same file.
+                with torch.no_grad():
+                    shared_models[0].linear.bias.add_(1)
+                self.assertEqual(shared_models[0].linear.bias, shared_models[1].linear.bias)
+
+    def test_share_weights_mismatch(self):
+        with tempfile.TemporaryDirectory() as tmp_dir:
+            path = os.path.join(tmp_dir, 'weights')
+            ipex.share_weights(torch.nn.Linear(4, 4).eval(), path)
+            with self.assertRaisesRegex(RuntimeError, "doesn't match the model"):
+                ipex.share_weights(torch.nn.Linear(4, 8).eval(), path)
+
+if __name__ == '__main__':
+    test = unittest.main()